@@ -107,7 +107,7 @@ int uzlib_flash_read_cb(struct uzlib_uncomp *m)
 }
 
 unsigned char gzip_dict[32768];
-uint8_t buffer2[FLASH_SECTOR_SIZE]; // no room for this on the stack
+uint8_t __attribute__((aligned(4))) buffer2[FLASH_SECTOR_SIZE]; // no room for this on the stack
 
 int copy_raw(const uint32_t src_addr,
              const uint32_t dst_addr,
@@ -121,10 +121,11 @@ int copy_raw(const uint32_t src_addr,
     }
 
     const uint32_t buffer_size = FLASH_SECTOR_SIZE;
-    uint8_t buffer[buffer_size];
+    uint8_t __attribute__((aligned(4))) buffer[buffer_size];
     int32_t left = ((size+buffer_size-1) & ~(buffer_size-1));
     uint32_t saddr = src_addr;
     uint32_t daddr = dst_addr;
+    uint32_t erased_until = 0; // [daddr, erased_until) was erased with its block
     struct uzlib_uncomp m_uncomp;
     bool gzip = false;
 
@@ -178,26 +179,48 @@ int copy_raw(const uint32_t src_addr,
                 return 9;
             }
         } else {
-            // Special treatment for address 0 (bootloader).  Only erase and
-            // rewrite if the data is different (i.e. very rarely).
-            bool skip = false;
-            if (daddr == 0) {
+            // A sector already holding the data (as the bootloader at address
+            // 0, nearly always) is skipped, and one where the data only clears
+            // bits (an erased one) is written without an erase.
+            bool erase = false;
+            bool write = true;
+            if (daddr >= erased_until) {
                 if (SPIRead(daddr, buffer2, buffer_size)) {
                     return 4;
                 }
-                if (!memcmp(buffer2, buffer, buffer_size)) {
+                write = false;
+                const uint32_t* src = (const uint32_t*)buffer;
+                const uint32_t* dst = (const uint32_t*)buffer2;
+                for (uint32_t i = 0; i < buffer_size / 4; i++) {
+                    if (dst[i] != src[i]) {
+                        write = true;
+                        if ((dst[i] & src[i]) != src[i]) {
+                            erase = true;
+                            break;
+                        }
+                    }
+                }
+                if (!write && daddr == 0) {
                     ets_putc('B'); // Note we skipped the bootloader in output
-                    skip = true;   // And skip erase/write
                 }
             }
-            if (!skip) {
-                if (SPIEraseSector(daddr/buffer_size)) {
-                   return 2;
-                }
-                if (SPIWrite(daddr, buffer, buffer_size)) {
-                    return 4;
+            if (erase) {
+                // The image changes from here on: a whole block is erased at
+                // once when its source was read (never the bootloader's).
+                uint32_t unread = gzip ? uzlib_flash_read_cb_addr : saddr + buffer_size;
+                if (daddr != 0 && (daddr & (FLASH_BLOCK_SIZE - 1)) == 0 &&
+                    left >= FLASH_BLOCK_SIZE && daddr + FLASH_BLOCK_SIZE <= unread) {
+                    if (SPIEraseBlock(daddr / FLASH_BLOCK_SIZE)) {
+                        return 2;
+                    }
+                    erased_until = daddr + FLASH_BLOCK_SIZE;
+                } else if (SPIEraseSector(daddr/buffer_size)) {
+                    return 2;
                 }
             }
+            if (write && SPIWrite(daddr, buffer, buffer_size)) {
+                return 4;
+            }
         }
         saddr += buffer_size;
         daddr += buffer_size;
@@ -0,0 +1,115 @@
+/*
+ AdcSampler.cpp - buffered ADC sampling at a measured rate
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <Arduino.h>
+#include "AdcSampler.h"
+#include "user_interface.h"
+
+// ADC_MODE(), mangled as declared in Esp.h
+extern int __get_adc_mode();
+
+// conversions per system_adc_read_fast() call: interrupts are held off
+// while they run, a few ms at the slowest divider
+static constexpr size_t burst = 256;
+
+uint32_t AdcSampler::_rate = 0;
+
+void AdcSampler::measured(size_t samples, uint32_t startUs)
+{
+    uint32_t us = micros() - startUs;
+    _rate = us ? (uint32_t)((uint64_t)samples * 1000000 / us) : 0;
+}
+
+size_t AdcSampler::read(uint16_t* buffer, size_t count, uint8_t decimation, uint8_t clkDiv)
+{
+    _rate = 0;
+    if (!buffer || !count || wifi_get_opmode() != NULL_MODE || __get_adc_mode() == ADC_VCC)
+    {
+        return 0;
+    }
+    decimation = std::max(decimation, (uint8_t)1);
+    clkDiv = constrain(clkDiv, 8, 32);
+
+    uint32_t start = micros();
+    if (decimation == 1)
+    {
+        // straight into the buffer
+        for (size_t done = 0; done < count; done += burst)
+        {
+            system_adc_read_fast(buffer + done, std::min(burst, count - done), clkDiv);
+        }
+    }
+    else
+    {
+        uint16_t raw[burst];
+        const size_t perBurst = burst / decimation;
+        for (size_t done = 0; done < count;)
+        {
+            size_t samples = std::min(perBurst, count - done);
+            system_adc_read_fast(raw, samples * decimation, clkDiv);
+            for (size_t i = 0; i < samples; ++i)
+            {
+                uint32_t sum = 0;
+                for (size_t j = 0; j < decimation; ++j)
+                {
+                    sum += raw[i * decimation + j];
+                }
+                buffer[done++] = (sum + decimation / 2) / decimation;
+            }
+        }
+    }
+    measured(count, start);
+    return count;
+}
+
+size_t AdcSampler::readTimed(uint16_t* buffer, size_t count, uint32_t intervalUs, uint8_t decimation)
+{
+    _rate = 0;
+    if (!buffer || !count || __get_adc_mode() == ADC_VCC)
+    {
+        return 0;
+    }
+    decimation = std::max(decimation, (uint8_t)1);
+
+    uint32_t start = micros();
+    uint32_t next = start;
+    for (size_t done = 0; done < count; ++done)
+    {
+        uint32_t sum = 0;
+        for (size_t j = 0; j < decimation; ++j)
+        {
+            while ((int32_t)(micros() - next) < 0)
+            {
+            }
+            sum += system_adc_read();
+            next += intervalUs;
+            if ((int32_t)(micros() - next) > (int32_t)intervalUs)
+            {
+                // too late, the next ones are from now on
+                next = micros();
+            }
+        }
+        buffer[done] = (sum + decimation / 2) / decimation;
+        optimistic_yield(10000);
+    }
+    measured(count, start);
+    return count;
+}
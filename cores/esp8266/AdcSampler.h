@@ -0,0 +1,66 @@
+/*
+ AdcSampler.h - buffered ADC sampling at a measured rate
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __ADCSAMPLER_H
+#define __ADCSAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// AdcSampler fills a buffer with ADC samples of the A0 pin, instead of one
+// analogRead() per sample, and measures the rate it achieved.  Each sample
+// may be the average of several conversions (decimation), which lowers the
+// noise and the rate by the same factor.
+//
+// read() uses system_adc_read_fast(), which converts back to back, tens
+// of thousands of samples per second with the default divider, and is only
+// allowed by the SDK while WiFi is off (WiFi.mode(WIFI_OFF) or
+// forceSleepBegin()): it returns 0 otherwise, and with ADC_MODE(ADC_VCC).
+// Interrupts are held off while converting, so read() splits long
+// captures in bursts and handles the interrupts in between.
+//
+// readTimed() works with WiFi on, one system_adc_read() per conversion
+// spaced by intervalUs, for rates up to a few kHz.  The SDK then keeps the
+// ADC to itself now and then, and late conversions shift the samples
+// after them: rate() tells the rate eventually achieved.
+//
+//    WiFi.mode(WIFI_OFF);
+//    uint16_t samples[512];
+//    size_t got = AdcSampler::read(samples, 512, 4);   // 4 conversions each
+//    Serial.printf("%u samples at %u Hz\n", got, AdcSampler::rate());
+
+class AdcSampler
+{
+public:
+    // clkDiv 8..32 sets the conversion clock of system_adc_read_fast()
+    static size_t read(uint16_t* buffer, size_t count, uint8_t decimation = 1, uint8_t clkDiv = 8);
+    static size_t readTimed(uint16_t* buffer, size_t count, uint32_t intervalUs, uint8_t decimation = 1);
+
+    // samples per second achieved by the last read() or readTimed()
+    static uint32_t rate() { return _rate; }
+
+protected:
+    static void measured(size_t samples, uint32_t startUs);
+
+    static uint32_t _rate;
+};
+
+#endif // __ADCSAMPLER_H
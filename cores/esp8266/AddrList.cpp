@@ -0,0 +1,76 @@
+/*
+ AddrList.cpp - cache of lwIP netif's ip addresses
+ Copyright (c) 2020 esp8266/Arduino.  All right reserved.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <string.h>
+#include <AddrList.h>
+
+esp8266::AddressListImplementation::AddressCache addrCache;
+
+namespace esp8266
+{
+
+namespace AddressListImplementation
+{
+
+void AddressCache::_refresh ()
+{
+    // the status may change again meanwhile, then refreshed once more
+    _changes = LwipIntf::statusChangeCount();
+    _addresses.clear();
+    for (auto a: addrList)
+        _addresses.push_back({ a.addr(), a.isLegacy()? a.netmask(): IPAddress(), a.interface() });
+    _valid = true;
+}
+
+const netif* AddressCache::interfaceOf (const IPAddress& local)
+{
+    for (const auto& a: *this)
+        if (a.addr == local)
+            return a.interface;
+    return nullptr;
+}
+
+const netif* AddressCache::interfaceFor (const IPAddress& peer)
+{
+    for (const auto& a: *this)
+    {
+        if (peer.isV4())
+        {
+            if (a.addr.isV4() && a.netmask.v4() && ((peer.v4() ^ a.addr.v4()) & a.netmask.v4()) == 0)
+                return a.interface;
+        }
+#if LWIP_IPV6
+        else if (a.addr.isV6() && memcmp(peer.raw6(), a.addr.raw6(), 8) == 0)
+        {
+#if LWIP_IPV6_SCOPES
+            // a link-local peer is on the interface of its zone
+            const ip6_addr_t* peer6 = ip_2_ip6((const ip_addr_t*)peer);
+            if (ip6_addr_has_zone(peer6) && !ip6_addr_test_zone(peer6, a.interface))
+                continue;
+#endif
+            return a.interface;
+        }
+#endif
+    }
+    return nullptr;
+}
+
+} // AddressListImplementation
+
+} // esp8266
@@ -70,13 +70,23 @@
           Serial.print('.');
           delay(500);
       }
+
+  addrCache holds a copy of the same addresses, made again on first use
+  after a netif status change (see LwipIntf::statusChangeCount()), to find
+  the interface of a local address or the one a peer is directly on
+  without walking through the netifs each time, e.g. for each request:
+
+      const netif* intf = addrCache.interfaceFor(client.remoteIP());
+      if (intf && netif_get_index(intf) == ...)
 */
 
 #ifndef __ADDRLIST_H
 #define __ADDRLIST_H
 
 #include <IPAddress.h>
+#include <LwipIntf.h>
 #include <lwip/netif.h>
+#include <vector>
 
 #if LWIP_IPV6
 #define IF_NUM_ADDRESSES (1 + LWIP_IPV6_NUM_ADDRESSES)
@@ -211,11 +221,51 @@ inline AddressList::const_iterator begin (const AddressList& a) { return a.begin
 inline AddressList::const_iterator   end (const AddressList& a) { return a.end(); }
 
 
+struct CachedAddress
+{
+    IPAddress addr;
+    IPAddress netmask;          // IPv4, IPv6 subnets are /64
+    const netif* interface;
+};
+
+class AddressCache
+{
+public:
+    using const_iterator = const CachedAddress*;
+
+    const_iterator begin ()     { _check(); return _addresses.data(); }
+    const_iterator   end ()     { _check(); return _addresses.data() + _addresses.size(); }
+    size_t size ()              { _check(); return _addresses.size(); }
+
+    // interface holding local, nullptr if none
+    const netif* interfaceOf (const IPAddress& local);
+    // interface with peer on its subnet, nullptr if peer is routed
+    const netif* interfaceFor (const IPAddress& peer);
+    bool onLink (const IPAddress& peer) { return interfaceFor(peer) != nullptr; }
+
+    // for changes not notified by a netif status callback
+    void invalidate ()          { _valid = false; }
+
+protected:
+    void _check ()
+    {
+        if (!_valid || _changes != LwipIntf::statusChangeCount())
+            _refresh();
+    }
+    void _refresh ();
+
+    std::vector<CachedAddress> _addresses;
+    uint32_t _changes = 0;
+    bool _valid = false;
+};
+
+
 } // AddressListImplementation
 
 } // esp8266
 
 extern esp8266::AddressListImplementation::AddressList addrList;
+extern esp8266::AddressListImplementation::AddressCache addrCache;
 
 
 #endif
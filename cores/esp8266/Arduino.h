@@ -173,7 +173,9 @@ int analogRead(uint8_t pin);
 void analogReference(uint8_t mode);
 void analogWrite(uint8_t pin, int val);
 void analogWriteMode(uint8_t pin, int val, bool openDrain);
+void analogWriteMulti(const uint8_t* pins, const int* vals, size_t count);
 void analogWriteFreq(uint32_t freq);
+void analogWriteStagger(bool stagger);
 void analogWriteResolution(int res);
 void analogWriteRange(uint32_t range);
 
@@ -186,6 +188,13 @@ uint8_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder);
 void attachInterrupt(uint8_t pin, void (*)(void), int mode);
 void detachInterrupt(uint8_t pin);
 void attachInterruptArg(uint8_t pin, void (*)(void*), void* arg, int mode);
+// Lower latency: called first and directly from the GPIO interrupt, with other
+// interrupts enabled and without filtering the edges on the pin level
+void attachInterruptFast(uint8_t pin, void (*)(void*), void* arg, int mode);
+// hook(pin, cycles) is called from the GPIO interrupt before each handler, with
+// the CPU cycles elapsed since the interrupt was entered. Must be IRAM_ATTR.
+typedef void (*interruptLatencyHook_t)(uint8_t pin, uint32_t cycles);
+void setInterruptLatencyHook(interruptLatencyHook_t hook);
 
 #if FLASH_MAP_SUPPORT
 #include "flash_hal.h"
@@ -288,6 +297,15 @@ inline void configTzTime(const char* tz, const char* server1,
 
 bool getLocalTime(struct tm * info, uint32_t ms = 5000);
 
+// localtime_r() for timestamps of logs and the like: times in the local day
+// and DST period of the previous conversion are found from it, without
+// going through the TZ rules again.  TZ is to be set with setTZ() or
+// configTime().  Not reentrant.
+struct tm* localtime_cached(const time_t* t, struct tm* result);
+
+// "2020-09-30T17:04:05", ISO 8601 without UTC offset, in buf of 20 chars
+char* isotime_r(const struct tm* tm, char* buf);
+
 // Everything we expect to be implicitly loaded for the sketch
 #include <pgmspace.h>
 
@@ -78,6 +78,59 @@ public:
     }
 };
 
+// Fixed capacity variant, for callbacks run on hot paths (per packet...):
+// handlers are a function and a context pointer kept in an array, so that
+// add() and remove() don't allocate and execute() is a walk over it.
+// Handlers are removed explicitly, a handler removing itself from execute()
+// has the one after it skipped that time.
+template<size_t capacity, typename... Args>
+class FixedCallBackList
+{
+public:
+    using Function = void (*)(void* context, Args... params);
+
+    // false when full
+    bool add(Function function, void* context) {
+        if (_count == capacity) {
+            return false;
+        }
+        _handlers[_count++] = { function, context };
+        return true;
+    }
+
+    bool remove(Function function, void* context) {
+        for (size_t i = 0; i < _count; ++i) {
+            if (_handlers[i].function == function && _handlers[i].context == context) {
+                for (--_count; i < _count; ++i) {
+                    _handlers[i] = _handlers[i + 1];
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // the number of handlers called
+    size_t execute(Args... params) const {
+        for (size_t i = 0; i < _count; ++i) {
+            _handlers[i].function(_handlers[i].context, params...);
+        }
+        return _count;
+    }
+
+    size_t size() const {
+        return _count;
+    }
+
+protected:
+    struct Handler {
+        Function function;
+        void*    context;
+    };
+    Handler _handlers[capacity] = { };
+    size_t  _count = 0;
+};
+
 } //CBListImplementation
 }//experimental
 
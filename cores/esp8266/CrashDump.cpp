@@ -0,0 +1,467 @@
+/*
+ CrashDump.cpp - compact binary postmortem dumps kept in a flash sector
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <Arduino.h>
+#include <user_interface.h>
+#include <spi_flash_geometry.h>
+#include "CrashDump.h"
+#include "coredecls.h"
+#include "flash_hal.h"
+
+// Layout, in words from the start of the sector:
+//   0        magic
+//   1        version << 16 | bytes of records
+//   2        crc32() of the records
+//   3        crashes since clear()
+//   4...     records, each a word tag << 24 | bytes, then the bytes padded
+//            to a word: the message, the registers (Info), the stack as its
+//            address then its words, the profiler_print() text
+// The header is written last, a dump cut by a reset reads as missing.
+
+CrashDumpClass CrashDump;
+
+// Linked with the sketches using PROFILE_SCOPE()
+extern "C" void profiler_print(void (*putc)(char)) __attribute__((weak));
+
+namespace
+{
+
+constexpr uint32_t magic = 0x504d4443;    // "CDMP"
+constexpr uint32_t version = 1;
+constexpr size_t headerSize = 4 * 4;
+constexpr size_t messageSize = 160;
+
+// REASON_USER_STACK_SMASH of the postmortem report
+constexpr uint32_t reasonStackSmash = 253;
+
+enum : uint32_t
+{
+    tagMessage = 1,
+    tagInfo,
+    tagStack,
+    tagProfiler
+};
+
+struct Info
+{
+    uint32_t reason;
+    uint32_t exccause;
+    uint32_t epc1;
+    uint32_t epc2;
+    uint32_t epc3;
+    uint32_t excvaddr;
+    uint32_t depc;
+    uint32_t sp;
+    uint32_t offset;
+    uint32_t ctx;
+    uint32_t uptimeMs;
+    uint32_t freeHeap;
+    uint32_t lastFailAllocAddr;
+    int32_t lastFailAllocSize;
+};
+
+// Records written through a small buffer, allocating nothing
+class Writer
+{
+public:
+    Writer(uint32_t address, size_t capacity) : _address(address), _capacity(capacity)
+    {
+    }
+
+    // bytes which still fit in a record
+    size_t room() const
+    {
+        size_t used = _written + _fill + 4;
+        return used < _capacity ? (_capacity - used) & ~3 : 0;
+    }
+
+    void begin(uint32_t tag, size_t bytes)
+    {
+        uint32_t word = (tag << 24) | bytes;
+        put(&word, 4);
+    }
+
+    void put(const void* data, size_t bytes)
+    {
+        const uint8_t* from = (const uint8_t*)data;
+        while (bytes--)
+        {
+            ((uint8_t*)_buf)[_fill++] = *from++;
+            if (_fill == sizeof(_buf))
+            {
+                _flush();
+            }
+        }
+    }
+
+    void end()
+    {
+        while (_fill % 4)
+        {
+            ((uint8_t*)_buf)[_fill++] = 0;
+        }
+    }
+
+    bool finish()
+    {
+        end();
+        _flush();
+        return _ok;
+    }
+
+    size_t written() const
+    {
+        return _written;
+    }
+
+    uint32_t crc() const
+    {
+        return _crc.value();
+    }
+
+protected:
+    void _flush()
+    {
+        if (_fill)
+        {
+            _ok = ESP.flashWrite(_address + _written, _buf, _fill) && _ok;
+            _crc.add(_buf, _fill);
+            _written += _fill;
+            _fill = 0;
+        }
+    }
+
+    uint32_t _address;
+    size_t _capacity;
+    size_t _written = 0;
+    size_t _fill = 0;
+    uint32_t _buf[16];
+    Crc32 _crc;
+    bool _ok = true;
+};
+
+// profiler_print() output, counted and then written
+Writer* profilerWriter;
+size_t profilerLeft;
+
+void profilerCount(char)
+{
+    profilerLeft++;
+}
+
+void profilerPut(char c)
+{
+    if (profilerLeft)
+    {
+        profilerWriter->put(&c, 1);
+        profilerLeft--;
+    }
+}
+
+bool isException(uint32_t reason)
+{
+    return reason == REASON_EXCEPTION_RST || reason == REASON_SOFT_WDT_RST || reason == reasonStackSmash;
+}
+
+} // namespace
+
+bool CrashDumpClass::begin(uint32_t address, bool printStack)
+{
+    if (address == eepromSector)
+    {
+        address = EEPROM_start - 0x40200000;
+    }
+    if (address % FLASH_SECTOR_SIZE || address + FLASH_SECTOR_SIZE > ESP.getFlashChipRealSize())
+    {
+        return false;
+    }
+    _address = address;
+    _printStack = printStack;
+    _enabled = true;
+    return true;
+}
+
+void CrashDumpClass::end()
+{
+    _enabled = false;
+}
+
+bool CrashDumpClass::_readHeader(uint32_t* header)
+{
+    return _enabled && ESP.flashRead(_address, header, headerSize) && header[0] == magic
+           && (header[1] >> 16) == version && (header[1] & 0xffff) <= FLASH_SECTOR_SIZE - headerSize;
+}
+
+bool CrashDumpClass::available()
+{
+    uint32_t header[headerSize / 4];
+    if (!_readHeader(header))
+    {
+        return false;
+    }
+    size_t bytes = header[1] & 0xffff;
+    uint32_t buf[16];
+    Crc32 crc;
+    for (size_t at = 0; at < bytes; at += sizeof(buf))
+    {
+        size_t count = std::min(bytes - at, sizeof(buf));
+        if (!ESP.flashRead(_address + headerSize + at, buf, count))
+        {
+            return false;
+        }
+        crc.add(buf, count);
+    }
+    return crc.value() == header[2];
+}
+
+uint32_t CrashDumpClass::count()
+{
+    uint32_t header[headerSize / 4];
+    return available() && _readHeader(header) ? header[3] : 0;
+}
+
+size_t CrashDumpClass::size()
+{
+    uint32_t header[headerSize / 4];
+    return available() && _readHeader(header) ? headerSize + (header[1] & 0xffff) : 0;
+}
+
+bool CrashDumpClass::read(size_t offset, void* data, size_t size)
+{
+    size_t total = this->size();
+    return offset <= total && size <= total - offset && ESP.flashRead(_address + offset, (uint8_t*)data, size);
+}
+
+bool CrashDumpClass::clear()
+{
+    return _enabled && ESP.flashEraseSector(_address / FLASH_SECTOR_SIZE);
+}
+
+bool CrashDumpClass::write(const crashdump_context_t& context)
+{
+    if (!_enabled)
+    {
+        return false;
+    }
+    uint32_t header[headerSize / 4];
+    uint32_t crashes = _readHeader(header) ? header[3] + 1 : 1;
+    if (!ESP.flashEraseSector(_address / FLASH_SECTOR_SIZE))
+    {
+        return false;
+    }
+
+    Writer out(_address + headerSize, FLASH_SECTOR_SIZE - headerSize);
+    const rst_info* rst = context.rst_info;
+
+    char message[messageSize];
+    int len;
+    if (context.panic_line)
+    {
+        len = snprintf_P(message, sizeof(message), PSTR("Panic %S:%d %S"), context.panic_file, context.panic_line,
+                         context.panic_func);
+        if (context.panic_what && len > 0 && (size_t)len < sizeof(message))
+        {
+            len += snprintf_P(message + len, sizeof(message) - len, PSTR(": Assertion '%S' failed."),
+                              context.panic_what);
+        }
+    }
+    else if (context.panic_file)
+    {
+        len = snprintf_P(message, sizeof(message), PSTR("Panic %S"), context.panic_file);
+    }
+    else if (context.unhandled_exception)
+    {
+        len = snprintf_P(message, sizeof(message), PSTR("Unhandled C++ exception: %S"), context.unhandled_exception);
+    }
+    else if (context.abort_called)
+    {
+        len = snprintf_P(message, sizeof(message), PSTR("Abort called"));
+    }
+    else if (rst->reason == REASON_EXCEPTION_RST)
+    {
+        len = snprintf_P(message, sizeof(message), PSTR("Exception"));
+    }
+    else if (rst->reason == REASON_SOFT_WDT_RST)
+    {
+        len = snprintf_P(message, sizeof(message), PSTR("Soft WDT reset"));
+    }
+    else if (rst->reason == reasonStackSmash)
+    {
+        len = snprintf_P(message, sizeof(message), PSTR("Stack smashing detected."));
+    }
+    else
+    {
+        len = snprintf_P(message, sizeof(message), PSTR("Generic Reset"));
+    }
+    len = std::max(0, std::min(len, (int)sizeof(message) - 1));
+    out.begin(tagMessage, len);
+    out.put(message, len);
+    out.end();
+
+    Info info = {
+        rst->reason,
+        rst->exccause,
+        rst->epc1,
+        rst->epc2,
+        rst->epc3,
+        rst->excvaddr,
+        rst->depc,
+        context.sp,
+        context.offset,
+        (uint32_t)context.ctx,
+        (uint32_t)millis(),
+        ESP.getFreeHeap(),
+        (uint32_t)context.last_fail_alloc_addr,
+        context.last_fail_alloc_size,
+    };
+    out.begin(tagInfo, sizeof(info));
+    out.put(&info, sizeof(info));
+
+    // the innermost frames, as much as fits
+    uint32_t start = context.sp + context.offset;
+    uint32_t end = context.stack_end;
+    if (start < end && out.room() > 4)
+    {
+        size_t bytes = std::min((size_t)(end - start) & ~3, (size_t)CRASHDUMP_STACK_MAX);
+        bytes = std::min(bytes, out.room() - 4);
+        out.begin(tagStack, 4 + bytes);
+        out.put(&start, 4);
+        out.put((const void*)start, bytes);
+    }
+
+    if (profiler_print && out.room())
+    {
+        profilerLeft = 0;
+        profiler_print(profilerCount);
+        profilerLeft = std::min(profilerLeft, out.room());
+        out.begin(tagProfiler, profilerLeft);
+        profilerWriter = &out;
+        profiler_print(profilerPut);
+        // in case it printed less the second time
+        while (profilerLeft)
+        {
+            profilerPut('\n');
+        }
+        out.end();
+    }
+
+    if (!out.finish())
+    {
+        return false;
+    }
+    header[0] = magic;
+    header[1] = (version << 16) | out.written();
+    header[2] = out.crc();
+    header[3] = crashes;
+    return ESP.flashWrite(_address, header, headerSize) && !_printStack;
+}
+
+size_t CrashDumpClass::printTo(Print& out)
+{
+    size_t bytes = size();
+    if (!bytes)
+    {
+        return 0;
+    }
+    size_t n = out.printf_P(PSTR("\ncrash dump, %u crashes since cleared\n"), count());
+    // checked once by size()
+    auto read = [this](uint32_t at, void* data, size_t size) {
+        return ESP.flashRead(_address + at, (uint8_t*)data, size);
+    };
+    Info info = { };
+    uint32_t at = headerSize;
+    while (at + 4 <= bytes)
+    {
+        uint32_t record;
+        if (!read(at, &record, 4))
+        {
+            break;
+        }
+        uint32_t tag = record >> 24;
+        size_t len = record & 0xffffff;
+        at += 4;
+        if (len > bytes - at)
+        {
+            break;
+        }
+        if (tag == tagMessage)
+        {
+            char message[messageSize];
+            len = std::min(len, sizeof(message) - 1);
+            read(at, message, len);
+            message[len] = 0;
+            n += out.printf_P(PSTR("\n%s\n"), message);
+        }
+        else if (tag == tagInfo)
+        {
+            read(at, &info, std::min(len, sizeof(info)));
+            if (isException(info.reason))
+            {
+                n += out.printf_P(PSTR("\nException (%d):\nepc1=0x%08x epc2=0x%08x epc3=0x%08x excvaddr=0x%08x depc=0x%08x\n"),
+                                  info.exccause, info.epc1, info.epc2, info.epc3, info.excvaddr, info.depc);
+            }
+            n += out.printf_P(PSTR("\nuptime %u ms, free heap %u\n"), info.uptimeMs, info.freeHeap);
+            if (info.lastFailAllocAddr)
+            {
+                n += out.printf_P(PSTR("last failed alloc call: %08X(%d)\n"), info.lastFailAllocAddr,
+                                  info.lastFailAllocSize);
+            }
+        }
+        else if (tag == tagStack && len >= 4)
+        {
+            uint32_t start;
+            read(at, &start, 4);
+            uint32_t end = start + len - 4;
+            static const char* const ctx[] = { "cont", "sys", "bearssl" };
+            n += out.printf_P(PSTR("\n>>>stack>>>\n\nctx: %s\nsp: %08x end: %08x offset: %04x\n"),
+                              info.ctx < 3 ? ctx[info.ctx] : "?", info.sp, end, info.offset);
+            for (uint32_t pos = start; pos < end; pos += 0x10)
+            {
+                uint32_t values[4] = { };
+                read(at + 4 + pos - start, values, std::min((uint32_t)sizeof(values), end - pos));
+                // rough indicator: stack frames usually have SP saved as the second word
+                bool looksLikeStackFrame = (values[2] == pos + 0x10);
+                n += out.printf_P(PSTR("%08x:  %08x %08x %08x %08x %c\n"), pos, values[0], values[1], values[2],
+                                  values[3], looksLikeStackFrame ? '<' : ' ');
+            }
+            n += out.printf_P(PSTR("<<<stack<<<\n"));
+        }
+        else if (tag == tagProfiler)
+        {
+            n += out.printf_P(PSTR("\n>>>profiler>>>\n"));
+            char buf[64];
+            for (size_t done = 0; done < len; done += sizeof(buf))
+            {
+                size_t count = std::min(len - done, sizeof(buf));
+                read(at + done, buf, count);
+                n += out.write((const uint8_t*)buf, count);
+            }
+            n += out.printf_P(PSTR("<<<profiler<<<\n"));
+        }
+        at += (len + 3) & ~3;
+    }
+    return n;
+}
+
+extern "C" bool crashdump_write(const crashdump_context_t* context)
+{
+    return CrashDump.write(*context);
+}
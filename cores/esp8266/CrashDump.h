@@ -0,0 +1,126 @@
+/*
+ CrashDump.h - compact binary postmortem dumps kept in a flash sector
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __CRASHDUMP_H
+#define __CRASHDUMP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Once CrashDump.begin() is called, the postmortem report also writes the
+// crash into a flash sector: the exception registers, the innermost
+// CRASHDUMP_STACK_MAX bytes of the stack, the heap figures and the
+// profiler regions and ring when the sketch uses PROFILE_SCOPE(), as
+// binary records in one sector.  The stack is then not printed over serial,
+// which at 115200 baud takes about 0.3s per KB of stack.  On the next
+// boot the dump is found and sent somewhere, as is or as text for the
+// exception decoder:
+//
+//    CrashDump.begin();               // the EEPROM sector, unused here
+//    if (CrashDump.available()) {
+//        CrashDump.printTo(Serial);
+//        // or CrashDump.read() its size() bytes, upload them, and then
+//        CrashDump.clear();
+//    }
+//
+// count() tells the number of crashes since the last clear(): only the
+// last one is kept.
+
+#ifndef CRASHDUMP_STACK_MAX
+#define CRASHDUMP_STACK_MAX 2048
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct rst_info;
+
+enum crashdump_ctx
+{
+    CRASHDUMP_CTX_CONT,
+    CRASHDUMP_CTX_SYS,
+    CRASHDUMP_CTX_BEARSSL
+};
+
+// What the postmortem report found, given to crashdump_write()
+typedef struct
+{
+    const struct rst_info* rst_info;    // exccause and epc1 as printed
+    uint32_t sp;
+    uint32_t offset;                    // of the stack dumped from sp
+    uint32_t stack_end;
+    int ctx;                            // crashdump_ctx
+    const char* panic_file;             // PROGMEM, as the ones below
+    int panic_line;
+    const char* panic_func;
+    const char* panic_what;
+    const char* unhandled_exception;
+    bool abort_called;
+    void* last_fail_alloc_addr;
+    int last_fail_alloc_size;
+} crashdump_context_t;
+
+// Linked with CrashDump: true when the crash was written, the stack then
+// needn't be printed
+bool crashdump_write(const crashdump_context_t* context);
+
+#ifdef __cplusplus
+}
+
+class Print;
+
+class CrashDumpClass
+{
+public:
+    // address in flash of a sector used by nothing else, by default the
+    // EEPROM one, with the stack still printed over serial if printStack
+    static constexpr uint32_t eepromSector = UINT32_MAX;
+    bool begin(uint32_t address = eepromSector, bool printStack = false);
+    void end();
+
+    // a valid dump is in the sector
+    bool available();
+    // crashes since clear(), the last one dumped
+    uint32_t count();
+    // bytes of the dump, headers included, 0 without
+    size_t size();
+    // raw bytes of the dump, to be uploaded as they are
+    bool read(size_t offset, void* data, size_t size);
+    // postmortem-like text, for the exception decoder
+    size_t printTo(Print& out);
+    bool clear();
+
+    bool write(const crashdump_context_t& context);
+
+protected:
+    bool _readHeader(uint32_t* header);
+
+    uint32_t _address = 0;
+    bool _enabled = false;
+    bool _printStack = false;
+};
+
+extern CrashDumpClass CrashDump;
+
+#endif // __cplusplus
+
+#endif // __CRASHDUMP_H
@@ -32,6 +32,14 @@ namespace TypeCast = experimental::TypeConversion;
 
 namespace
 {
+#if CRYPTO_OPTIMIZED_KERNELS
+const br_hash_class *const _sha256Class = &experimental::crypto::sha256Vtable;
+const br_chacha20_run _chacha20Run = experimental::crypto::chacha20Run;
+#else
+const br_hash_class *const _sha256Class = &br_sha256_vtable;
+const br_chacha20_run _chacha20Run = br_chacha20_ct_run;
+#endif
+
 size_t _ctMinDataLength = 0;
 size_t _ctMaxDataLength = 1024;
 
@@ -56,10 +64,45 @@ uint8_t *defaultNonceGenerator(uint8_t *nonceArray, const size_t nonceLength)
 
         It is possible that yield() must be called on the ESP8266 to properly feed the hardware random number generator new bits, since there is only one processor core available.
         However, no feeding requirements are mentioned in the ESP32 documentation, and using yield() could possibly cause extended delays during nonce generation.
-        Thus only delayMicroseconds() is used below.
+        Thus only delayMicroseconds() is used in ESP.random().
+
+        The nonces are taken from drbgRandom(), keyed from ESP.random(), so that each is a copy from its buffer.
     */
 
-    return ESP.random(nonceArray, nonceLength);
+    return experimental::crypto::drbgRandom(nonceArray, nonceLength);
+}
+
+// The ChaCha20 key stream of _drbgKey, from which each refill takes the next key.
+// The bytes handed out are cleared, so that the state doesn't tell past output.
+constexpr size_t _drbgBlockLength = 128;
+constexpr uint32_t _drbgReseedRefills = 64;
+uint8_t _drbgKey[32];
+uint8_t _drbgBlock[_drbgBlockLength];
+size_t _drbgPosition = _drbgBlockLength;
+uint32_t _drbgRefills = _drbgReseedRefills;
+
+void drbgRefill()
+{
+    if (_drbgRefills >= _drbgReseedRefills)
+    {
+        // mixed in, the key never loses entropy
+        uint8_t seed[sizeof(_drbgKey)];
+        ESP.random(seed, sizeof(seed));
+        for (size_t i = 0; i < sizeof(_drbgKey); ++i)
+        {
+            _drbgKey[i] ^= seed[i];
+        }
+        memset(seed, 0, sizeof(seed));
+        _drbgRefills = 0;
+    }
+
+    static const uint8_t iv[12] = { };
+    memset(_drbgBlock, 0, sizeof(_drbgBlock));
+    _chacha20Run(_drbgKey, iv, 0, _drbgBlock, sizeof(_drbgBlock));
+    memcpy(_drbgKey, _drbgBlock, sizeof(_drbgKey));
+    memset(_drbgBlock, 0, sizeof(_drbgKey));
+    _drbgPosition = sizeof(_drbgKey);
+    ++_drbgRefills;
 }
 
 experimental::crypto::nonceGeneratorType _nonceGenerator = defaultNonceGenerator;
@@ -216,6 +259,36 @@ nonceGeneratorType getNonceGenerator()
     return _nonceGenerator;
 }
 
+uint8_t *drbgRandom(uint8_t *resultArray, const size_t outputSizeBytes)
+{
+    for (size_t done = 0; done < outputSizeBytes;)
+    {
+        if (_drbgPosition == _drbgBlockLength)
+        {
+            drbgRefill();
+        }
+        size_t length = std::min(outputSizeBytes - done, _drbgBlockLength - _drbgPosition);
+        memcpy(resultArray + done, _drbgBlock + _drbgPosition, length);
+        memset(_drbgBlock + _drbgPosition, 0, length);
+        _drbgPosition += length;
+        done += length;
+    }
+    return resultArray;
+}
+
+uint32_t drbgRandom()
+{
+    uint32_t result;
+    drbgRandom(reinterpret_cast<uint8_t *>(&result), sizeof(result));
+    return result;
+}
+
+void drbgReseed()
+{
+    _drbgRefills = _drbgReseedRefills;
+    _drbgPosition = _drbgBlockLength;
+}
+
 
 // #################### MD5 ####################
 
@@ -335,9 +408,9 @@ String SHA224::hmacCT(const String &message, const void *hashKey, const size_t h
 void *SHA256::hash(const void *data, const size_t dataLength, void *resultArray)
 {
     br_sha256_context context;
-    br_sha256_init(&context);
-    br_sha256_update(&context, data, dataLength);
-    br_sha256_out(&context, resultArray);
+    _sha256Class->init(&context.vtable);
+    context.vtable->update(&context.vtable, data, dataLength);
+    context.vtable->out(&context.vtable, resultArray);
     return resultArray;
 }
 
@@ -350,12 +423,12 @@ String SHA256::hash(const String &message)
 
 void *SHA256::hmac(const void *data, const size_t dataLength, const void *hashKey, const size_t hashKeyLength, void *resultArray, const size_t outputLength)
 {
-    return createBearsslHmac(&br_sha256_vtable, data, dataLength, hashKey, hashKeyLength, resultArray, outputLength);
+    return createBearsslHmac(_sha256Class, data, dataLength, hashKey, hashKeyLength, resultArray, outputLength);
 }
 
 String SHA256::hmac(const String &message, const void *hashKey, const size_t hashKeyLength, const size_t hmacLength)
 {
-    return createBearsslHmac(&br_sha256_vtable, NATURAL_LENGTH, message, hashKey, hashKeyLength, hmacLength);
+    return createBearsslHmac(_sha256Class, NATURAL_LENGTH, message, hashKey, hashKeyLength, hmacLength);
 }
 
 void *SHA256::hmacCT(const void *data, const size_t dataLength, const void *hashKey, const size_t hashKeyLength, void *resultArray, const size_t outputLength)
@@ -481,7 +554,7 @@ void HKDF::init(const void *keyMaterial, const size_t keyMaterialLength, const v
     // Comments mainly from https://www.bearssl.org/apidoc/bearssl__kdf_8h.html
 
     // Initialize an HKDF context, with a hash function, and the salt. This starts the HKDF-Extract process.
-    br_hkdf_init(&hkdfContext, &br_sha256_vtable, salt, saltLength);
+    br_hkdf_init(&hkdfContext, _sha256Class, salt, saltLength);
 
     // Inject more input bytes. This function may be called repeatedly if the input data is provided by chunks, after br_hkdf_init() but before br_hkdf_flip().
     br_hkdf_inject(&hkdfContext, keyMaterial, keyMaterialLength);
@@ -511,14 +584,14 @@ void chacha20Poly1305Kernel(const int encrypt, void *data, const size_t dataLeng
 {
     if (keySalt == nullptr)
     {
-        br_poly1305_ctmul32_run(key, nonce, data, dataLength, aad, aadLength, tag, br_chacha20_ct_run, encrypt);
+        br_poly1305_ctmul32_run(key, nonce, data, dataLength, aad, aadLength, tag, _chacha20Run, encrypt);
     }
     else
     {
         HKDF hkdfInstance(key, ENCRYPTION_KEY_LENGTH, keySalt, keySaltLength);
         uint8_t derivedEncryptionKey[ENCRYPTION_KEY_LENGTH] {0};
         hkdfInstance.produce(derivedEncryptionKey, ENCRYPTION_KEY_LENGTH);
-        br_poly1305_ctmul32_run(derivedEncryptionKey, nonce, data, dataLength, aad, aadLength, tag, br_chacha20_ct_run, encrypt);
+        br_poly1305_ctmul32_run(derivedEncryptionKey, nonce, data, dataLength, aad, aadLength, tag, _chacha20Run, encrypt);
     }
 }
 
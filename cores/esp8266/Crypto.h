@@ -97,6 +97,74 @@ size_t getCtMaxDataLength();
 void setNonceGenerator(nonceGeneratorType nonceGenerator);
 nonceGeneratorType getNonceGenerator();
 
+/**
+    Random bytes from a ChaCha20 generator keyed from the hardware random number generator (ESP.random()), also the default
+    nonce generator. The key stream is generated 128 bytes at a time, so that small requests (nonces, session ids, ...) are
+    a copy from a buffer instead of ESP.random() reading the hardware register with a cooldown for each word.
+    After each refill the key is replaced by the first 32 bytes of the key stream, and the bytes handed out are cleared,
+    so that the generator state does not reveal past output. Fresh hardware random bits are mixed into the key every
+    64 refills (6 kB of output), or at the next refill after drbgReseed().
+
+    The output is only as unpredictable as the hardware bits the key is made of, which are pseudo-random while WiFi is off:
+    call drbgReseed() once it is on when that matters.
+
+    @param resultArray The array to fill.
+    @param outputSizeBytes The number of random bytes to write.
+
+    @return A pointer to resultArray.
+*/
+uint8_t *drbgRandom(uint8_t *resultArray, const size_t outputSizeBytes);
+uint32_t drbgRandom();
+void drbgReseed();
+
+
+// #################### Optimized kernels ####################
+
+/**
+    SHA-256 and ChaCha20 kernels tuned for the Xtensa LX106: the working variables are kept in registers, rounds are unrolled
+    and message words are assembled byte-wise so that unaligned input never traps.
+    When CRYPTO_OPTIMIZED_KERNELS is 1 (default), SHA256, HKDF and ChaCha20Poly1305 use them instead of the generic BearSSL code.
+    Define CRYPTO_KERNELS_IN_IRAM to 1 to place the inner loops in IRAM, which is faster but costs about 3 kB of IRAM.
+
+    The output is bit-identical to BearSSL, so data produced with either implementation can be processed by the other.
+    The constant-time HMAC functions (hmacCT) always use BearSSL.
+*/
+#ifndef CRYPTO_OPTIMIZED_KERNELS
+#define CRYPTO_OPTIMIZED_KERNELS 1
+#endif
+
+#ifndef CRYPTO_KERNELS_IN_IRAM
+#define CRYPTO_KERNELS_IN_IRAM 0
+#endif
+
+/**
+    A BearSSL hash class using the optimized SHA-256 kernel. The context type is br_sha256_context,
+    so it can be used wherever br_sha256_vtable is accepted (br_hmac_key_init, br_hkdf_init, ...).
+*/
+extern const br_hash_class sha256Vtable;
+
+/**
+    Initialize a br_sha256_context for use with the optimized SHA-256 kernel.
+    br_sha256_update and br_sha256_out must not be called on the context, use its vtable (or sha256Update/sha256Out) instead.
+*/
+void sha256Init(br_sha256_context *context);
+void sha256Update(br_sha256_context *context, const void *data, size_t dataLength);
+void sha256Out(const br_sha256_context *context, void *resultArray);
+
+/**
+    Optimized ChaCha20 with the same semantics as br_chacha20_ct_run (it can be passed as a br_chacha20_run),
+    so it can be used directly by br_poly1305_ctmul32_run.
+
+    @param key The 32 byte key.
+    @param iv The 12 byte IV (nonce).
+    @param cc The initial block counter.
+    @param data The data to encrypt or decrypt in place.
+    @param dataLength The length of the data array in bytes.
+
+    @return The block counter after the last (possibly partial) block.
+*/
+uint32_t chacha20Run(const void *key, const void *iv, uint32_t cc, void *data, size_t dataLength);
+
 
 // #################### MD5 ####################
 
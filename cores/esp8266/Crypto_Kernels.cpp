@@ -0,0 +1,391 @@
+/*
+    SHA-256 and ChaCha20 kernels for experimental::crypto
+
+    License (MIT license):
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "Crypto.h"
+#include <bearssl/bearssl.h>
+#include <string.h>
+
+#if CRYPTO_KERNELS_IN_IRAM
+#define CRYPTO_KERNEL IRAM_ATTR
+#else
+#define CRYPTO_KERNEL
+#endif
+
+namespace
+{
+// The LX106 has no rotate instruction, but GCC turns this into a funnel shift (ssai + src)
+inline uint32_t ror32(const uint32_t x, const unsigned n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+inline uint32_t rol32(const uint32_t x, const unsigned n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+// Byte-wise accesses, data pointers handed to the kernels are not necessarily aligned
+inline uint32_t load32be(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+inline void store32be(uint8_t *p, const uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+inline uint32_t load32le(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline void store32le(uint8_t *p, const uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+
+// #################### SHA-256 ####################
+
+const uint32_t sha256K[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define SHA256_S0(x) (ror32((x), 2) ^ ror32((x), 13) ^ ror32((x), 22))
+#define SHA256_S1(x) (ror32((x), 6) ^ ror32((x), 11) ^ ror32((x), 25))
+#define SHA256_s0(x) (ror32((x), 7) ^ ror32((x), 18) ^ ((x) >> 3))
+#define SHA256_s1(x) (ror32((x), 17) ^ ror32((x), 19) ^ ((x) >> 10))
+
+// The message schedule is a 16 word window, W(i) with i >= 16 is computed in place from the words it replaces
+#define SHA256_W(i) w[(i) & 15]
+#define SHA256_SCHEDULE(i) (SHA256_W(i) += SHA256_s1(SHA256_W((i) - 2)) + SHA256_W((i) - 7) + SHA256_s0(SHA256_W((i) - 15)))
+
+// The working variables are never moved, each round renames them instead
+#define SHA256_ROUND(a, b, c, d, e, f, g, h, k, x) \
+    do \
+    { \
+        uint32_t t1 = h + SHA256_S1(e) + (g ^ (e & (f ^ g))) + (k) + (x); \
+        d += t1; \
+        h = t1 + SHA256_S0(a) + ((a & b) | (c & (a | b))); \
+    } while (0)
+
+#define SHA256_ROUNDS8(i, X) \
+    SHA256_ROUND(a, b, c, d, e, f, g, h, k[(i) + 0], X((i) + 0)); \
+    SHA256_ROUND(h, a, b, c, d, e, f, g, k[(i) + 1], X((i) + 1)); \
+    SHA256_ROUND(g, h, a, b, c, d, e, f, k[(i) + 2], X((i) + 2)); \
+    SHA256_ROUND(f, g, h, a, b, c, d, e, k[(i) + 3], X((i) + 3)); \
+    SHA256_ROUND(e, f, g, h, a, b, c, d, k[(i) + 4], X((i) + 4)); \
+    SHA256_ROUND(d, e, f, g, h, a, b, c, k[(i) + 5], X((i) + 5)); \
+    SHA256_ROUND(c, d, e, f, g, h, a, b, k[(i) + 6], X((i) + 6)); \
+    SHA256_ROUND(b, c, d, e, f, g, h, a, k[(i) + 7], X((i) + 7))
+
+CRYPTO_KERNEL void sha256Compress(uint32_t *val, const uint8_t *block, size_t blockCount)
+{
+    uint32_t w[16];
+
+    while (blockCount--)
+    {
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            w[i] = load32be(block + 4 * i);
+        }
+
+        uint32_t a = val[0], b = val[1], c = val[2], d = val[3];
+        uint32_t e = val[4], f = val[5], g = val[6], h = val[7];
+
+        // Unrolled by 16 so that every schedule index is a constant, the inner loop runs three times
+        const uint32_t *k = sha256K;
+        SHA256_ROUNDS8(0, SHA256_W);
+        SHA256_ROUNDS8(8, SHA256_W);
+        for (unsigned round = 16; round < 64; round += 16)
+        {
+            k = sha256K + round - 16;
+            SHA256_ROUNDS8(16, SHA256_SCHEDULE);
+            SHA256_ROUNDS8(24, SHA256_SCHEDULE);
+        }
+
+        val[0] += a;
+        val[1] += b;
+        val[2] += c;
+        val[3] += d;
+        val[4] += e;
+        val[5] += f;
+        val[6] += g;
+        val[7] += h;
+
+        block += 64;
+    }
+}
+
+#undef SHA256_ROUNDS8
+#undef SHA256_ROUND
+#undef SHA256_SCHEDULE
+#undef SHA256_W
+#undef SHA256_s1
+#undef SHA256_s0
+#undef SHA256_S1
+#undef SHA256_S0
+
+void sha256VtableInit(const br_hash_class **context)
+{
+    experimental::crypto::sha256Init((br_sha256_context *)context);
+}
+
+void sha256VtableUpdate(const br_hash_class **context, const void *data, size_t dataLength)
+{
+    experimental::crypto::sha256Update((br_sha256_context *)context, data, dataLength);
+}
+
+void sha256VtableOut(const br_hash_class *const *context, void *resultArray)
+{
+    experimental::crypto::sha256Out((const br_sha256_context *)context, resultArray);
+}
+
+uint64_t sha256VtableState(const br_hash_class *const *context, void *state)
+{
+    return br_sha256_state((const br_sha256_context *)context, state);
+}
+
+void sha256VtableSetState(const br_hash_class **context, const void *state, uint64_t count)
+{
+    br_sha256_set_state((br_sha256_context *)context, state, count);
+}
+
+
+// #################### ChaCha20 ####################
+
+#define CHACHA20_QUARTERROUND(a, b, c, d) \
+    do \
+    { \
+        a += b; d = rol32(d ^ a, 16); \
+        c += d; b = rol32(b ^ c, 12); \
+        a += b; d = rol32(d ^ a, 8); \
+        c += d; b = rol32(b ^ c, 7); \
+    } while (0)
+
+CRYPTO_KERNEL void chacha20Block(const uint32_t *input, uint32_t *output)
+{
+    uint32_t x0 = input[0], x1 = input[1], x2 = input[2], x3 = input[3];
+    uint32_t x4 = input[4], x5 = input[5], x6 = input[6], x7 = input[7];
+    uint32_t x8 = input[8], x9 = input[9], x10 = input[10], x11 = input[11];
+    uint32_t x12 = input[12], x13 = input[13], x14 = input[14], x15 = input[15];
+
+    // Two double rounds per iteration
+    for (unsigned i = 0; i < 5; ++i)
+    {
+        CHACHA20_QUARTERROUND(x0, x4, x8, x12);
+        CHACHA20_QUARTERROUND(x1, x5, x9, x13);
+        CHACHA20_QUARTERROUND(x2, x6, x10, x14);
+        CHACHA20_QUARTERROUND(x3, x7, x11, x15);
+        CHACHA20_QUARTERROUND(x0, x5, x10, x15);
+        CHACHA20_QUARTERROUND(x1, x6, x11, x12);
+        CHACHA20_QUARTERROUND(x2, x7, x8, x13);
+        CHACHA20_QUARTERROUND(x3, x4, x9, x14);
+
+        CHACHA20_QUARTERROUND(x0, x4, x8, x12);
+        CHACHA20_QUARTERROUND(x1, x5, x9, x13);
+        CHACHA20_QUARTERROUND(x2, x6, x10, x14);
+        CHACHA20_QUARTERROUND(x3, x7, x11, x15);
+        CHACHA20_QUARTERROUND(x0, x5, x10, x15);
+        CHACHA20_QUARTERROUND(x1, x6, x11, x12);
+        CHACHA20_QUARTERROUND(x2, x7, x8, x13);
+        CHACHA20_QUARTERROUND(x3, x4, x9, x14);
+    }
+
+    output[0] = x0 + input[0];
+    output[1] = x1 + input[1];
+    output[2] = x2 + input[2];
+    output[3] = x3 + input[3];
+    output[4] = x4 + input[4];
+    output[5] = x5 + input[5];
+    output[6] = x6 + input[6];
+    output[7] = x7 + input[7];
+    output[8] = x8 + input[8];
+    output[9] = x9 + input[9];
+    output[10] = x10 + input[10];
+    output[11] = x11 + input[11];
+    output[12] = x12 + input[12];
+    output[13] = x13 + input[13];
+    output[14] = x14 + input[14];
+    output[15] = x15 + input[15];
+}
+
+#undef CHACHA20_QUARTERROUND
+}
+
+namespace experimental
+{
+namespace crypto
+{
+const br_hash_class sha256Vtable =
+{
+    sizeof(br_sha256_context),
+    BR_HASHDESC_ID(br_sha256_ID) | BR_HASHDESC_OUT(32) | BR_HASHDESC_STATE(32) | BR_HASHDESC_LBLEN(6) | BR_HASHDESC_MD_PADDING | BR_HASHDESC_MD_PADDING_BE,
+    sha256VtableInit,
+    sha256VtableUpdate,
+    sha256VtableOut,
+    sha256VtableState,
+    sha256VtableSetState
+};
+
+void sha256Init(br_sha256_context *context)
+{
+    static const uint32_t initialValue[8] =
+    {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    context->vtable = &sha256Vtable;
+    memcpy(context->val, initialValue, sizeof initialValue);
+    context->count = 0;
+}
+
+void sha256Update(br_sha256_context *context, const void *data, size_t dataLength)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    size_t bufferFill = (size_t)context->count & 63;
+
+    context->count += dataLength;
+
+    if (bufferFill)
+    {
+        size_t take = 64 - bufferFill;
+        if (take > dataLength)
+        {
+            take = dataLength;
+        }
+
+        memcpy(context->buf + bufferFill, bytes, take);
+        bytes += take;
+        dataLength -= take;
+        bufferFill += take;
+
+        if (bufferFill < 64)
+        {
+            return;
+        }
+
+        sha256Compress(context->val, context->buf, 1);
+    }
+
+    // Whole blocks are hashed straight from the caller's buffer
+    if (dataLength >= 64)
+    {
+        const size_t blockCount = dataLength / 64;
+        sha256Compress(context->val, bytes, blockCount);
+        bytes += blockCount * 64;
+        dataLength -= blockCount * 64;
+    }
+
+    memcpy(context->buf, bytes, dataLength);
+}
+
+void sha256Out(const br_sha256_context *context, void *resultArray)
+{
+    uint8_t block[128];
+    uint32_t val[8];
+    const size_t bufferFill = (size_t)context->count & 63;
+    // The length goes into the last 8 bytes, a second block is needed when they're already taken
+    const size_t paddedLength = bufferFill < 56 ? 64 : 128;
+    const uint64_t bitCount = context->count << 3;
+
+    memcpy(val, context->val, sizeof val);
+    memcpy(block, context->buf, bufferFill);
+    block[bufferFill] = 0x80;
+    memset(block + bufferFill + 1, 0, paddedLength - 8 - bufferFill - 1);
+    store32be(block + paddedLength - 8, (uint32_t)(bitCount >> 32));
+    store32be(block + paddedLength - 4, (uint32_t)bitCount);
+
+    sha256Compress(val, block, paddedLength / 64);
+
+    uint8_t *result = (uint8_t *)resultArray;
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        store32be(result + 4 * i, val[i]);
+    }
+}
+
+CRYPTO_KERNEL uint32_t chacha20Run(const void *key, const void *iv, uint32_t cc, void *data, size_t dataLength)
+{
+    const uint8_t *keyBytes = (const uint8_t *)key;
+    const uint8_t *ivBytes = (const uint8_t *)iv;
+    uint8_t *bytes = (uint8_t *)data;
+
+    uint32_t state[16] = { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574 };
+    uint32_t keyStream[16];
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        state[4 + i] = load32le(keyBytes + 4 * i);
+    }
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        state[13 + i] = load32le(ivBytes + 4 * i);
+    }
+
+    while (dataLength > 0)
+    {
+        state[12] = cc;
+        chacha20Block(state, keyStream);
+
+        const size_t blockLength = dataLength < 64 ? dataLength : 64;
+        if (blockLength == 64)
+        {
+            for (unsigned i = 0; i < 16; ++i)
+            {
+                store32le(bytes + 4 * i, load32le(bytes + 4 * i) ^ keyStream[i]);
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < blockLength; ++i)
+            {
+                bytes[i] ^= (uint8_t)(keyStream[i >> 2] >> ((i & 3) << 3));
+            }
+        }
+
+        bytes += blockLength;
+        dataLength -= blockLength;
+        ++cc;
+    }
+
+    return cc;
+}
+}
+}
@@ -239,6 +239,70 @@ void EspClass::resetFreeContStack()
     cont_repaint_stack(g_pcont);
 }
 
+uint32_t EspClass::getContStackSize()
+{
+    return sizeof(g_pcont->stack);
+}
+
+void EspClass::setContStackProfiling(bool enable)
+{
+    cont_stack_profiling(enable);
+}
+
+uint32_t EspClass::getFreeContStackLastLoop()
+{
+    return cont_stack_profile_last();
+}
+
+uint32_t EspClass::getFreeContStackMinLoop()
+{
+    return cont_stack_profile_min();
+}
+
+void EspClass::requestRfCalibration()
+{
+    rf_cal_cache_invalidate();
+}
+
+void EspClass::printBootTimeline(Print& out)
+{
+    static const char names[BOOT_STAGE_COUNT][12] PROGMEM = {
+        "app_entry", "phy_init", "rf_pre_init", "user_init", "preinit",
+        "init_done", "ctors_done", "setup", "loop", "loop_end",
+    };
+
+    // in the order they were reached, which depends on the SDK version
+    uint8_t order[BOOT_STAGE_COUNT];
+    size_t count = 0;
+    for (int stage = 0; stage < BOOT_STAGE_COUNT; ++stage) {
+        uint32_t cycles = boot_timeline_cycles((boot_stage_t)stage);
+        if (!cycles) {
+            continue;
+        }
+        size_t i = count++;
+        for (; i && boot_timeline_cycles((boot_stage_t)order[i - 1]) > cycles; --i) {
+            order[i] = order[i - 1];
+        }
+        order[i] = stage;
+    }
+
+    // The ROM boots at 52MHz, the SDK starts at 80MHz, and the sketch's
+    // CPU frequency is set just before setup().
+    uint32_t previous = 0;
+    uint32_t us = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t cycles = boot_timeline_cycles((boot_stage_t)order[i]);
+        uint32_t mhz = (order[i] == BOOT_STAGE_APP_ENTRY) ? 52 :
+                       (order[i] >= BOOT_STAGE_SETUP) ? esp_get_cpu_freq_mhz() : 80;
+        uint32_t step = (cycles - previous) / mhz;
+        us += step;
+        previous = cycles;
+        char name[sizeof(names[0])];
+        strncpy_P(name, names[order[i]], sizeof(name));
+        out.printf_P(PSTR("%-12s %8u us  +%u us\n"), name, us, step);
+    }
+}
+
 uint32_t EspClass::getChipId(void)
 {
     return system_get_chip_id();
@@ -670,9 +734,56 @@ bool EspClass::updateSketch(Stream& in, uint32_t size, bool restartOnFail, bool
 
 static const int FLASH_INT_MASK = ((B10 << 8) | B00111010);
 
+// Accounts a flash operation to flash_stats_record() (FLASH_STATS), returns
+// are wrapped in done().  Only the outermost call is recorded, the variants
+// below call each other.
+class FlashStatsScope {
+public:
+#if FLASH_STATS
+    FlashStatsScope(int op, uint32_t bytes) : _op(op), _bytes(bytes), _start(micros()), _outer(!_depth++) { }
+    ~FlashStatsScope() {
+        _depth--;
+        if (_outer) {
+            flash_stats_record(_op, _bytes, micros() - _start, _ok);
+        }
+    }
+    bool done(bool ok) {
+        _ok = ok;
+        return ok;
+    }
+    template <typename T>
+    T done(T written, T size) {
+        _ok = (written == size);
+        return written;
+    }
+
+private:
+    static int _depth;
+    int _op;
+    uint32_t _bytes;
+    uint32_t _start;
+    bool _outer;
+    bool _ok = false;
+#else
+    FlashStatsScope(int, uint32_t) { }
+    bool done(bool ok) {
+        return ok;
+    }
+    template <typename T>
+    T done(T written, T) {
+        return written;
+    }
+#endif
+};
+
+#if FLASH_STATS
+int FlashStatsScope::_depth = 0;
+#endif
+
 bool EspClass::flashEraseSector(uint32_t sector) {
+    FlashStatsScope stats(FLASH_STATS_ERASE, SPI_FLASH_SEC_SIZE);
     int rc = spi_flash_erase_sector(sector);
-    return rc == 0;
+    return stats.done(rc == 0);
 }
 
 // Adapted from the old version of `flash_hal_write()` (before 3.0.0), which was used for SPIFFS to allow
@@ -788,6 +899,9 @@ static bool isAlignedPointer(const uint8_t *ptr) {
 
 
 size_t EspClass::flashWriteUnalignedMemory(uint32_t address, const uint8_t *data, size_t size) {
+    FlashStatsScope stats(FLASH_STATS_WRITE, size);
+    const size_t requested = size;
+
     auto flash_write = [](uint32_t address, uint8_t *data, size_t size) {
         return spi_flash_write(address, reinterpret_cast<uint32_t *>(data), size) == SPI_FLASH_RESULT_OK;
     };
@@ -807,7 +921,7 @@ size_t EspClass::flashWriteUnalignedMemory(uint32_t address, const uint8_t *data
         auto wlen = std::min(Alignment - offset, size);
 
         if (!flash_read(before_address, &buf[0], Alignment)) {
-            return 0;
+            return stats.done<size_t>(0, requested);
         }
 
 #if PUYA_SUPPORT
@@ -823,7 +937,7 @@ size_t EspClass::flashWriteUnalignedMemory(uint32_t address, const uint8_t *data
 #endif
 
         if (!flash_write(before_address, &buf[0], Alignment)) {
-            return 0;
+            return stats.done<size_t>(0, requested);
         }
 
         address += wlen;
@@ -839,13 +953,13 @@ size_t EspClass::flashWriteUnalignedMemory(uint32_t address, const uint8_t *data
         if (wlen != len) {
             auto partial = wlen - Alignment;
             if (!flash_read(address + partial, &buf[partial], Alignment)) {
-                return written;
+                return stats.done(written, requested);
             }
         }
 
         memcpy(&buf[0], data, len);
         if (!flashWrite(address, reinterpret_cast<const uint32_t *>(&buf[0]), wlen)) {
-            return written;
+            return stats.done(written, requested);
         }
 
         address += len;
@@ -854,10 +968,11 @@ size_t EspClass::flashWriteUnalignedMemory(uint32_t address, const uint8_t *data
         size -= len;
     }
 
-    return written;
+    return stats.done(written, requested);
 }
 
 bool EspClass::flashWrite(uint32_t address, const uint32_t *data, size_t size) {
+    FlashStatsScope stats(FLASH_STATS_WRITE, size);
     SpiFlashOpResult result;
 #if PUYA_SUPPORT
     if (getFlashChipVendorId() == SPI_FLASH_VENDOR_PUYA) {
@@ -868,25 +983,27 @@ bool EspClass::flashWrite(uint32_t address, const uint32_t *data, size_t size) {
     {
         result = spi_flash_write_page_break(address, const_cast<uint32_t *>(data), size);
     }
-    return result == SPI_FLASH_RESULT_OK;
+    return stats.done(result == SPI_FLASH_RESULT_OK);
 }
 
 bool EspClass::flashWrite(uint32_t address, const uint8_t *data, size_t size) {
+    FlashStatsScope stats(FLASH_STATS_WRITE, size);
     if (data && size) {
         if (!isAlignedAddress(address)
          || !isAlignedPointer(data)
          || !isAlignedSize(size))
         {
-            return flashWriteUnalignedMemory(address, data, size) == size;
+            return stats.done(flashWriteUnalignedMemory(address, data, size) == size);
         }
 
-        return flashWrite(address, reinterpret_cast<const uint32_t *>(data), size);
+        return stats.done(flashWrite(address, reinterpret_cast<const uint32_t *>(data), size));
     }
 
-    return false;
+    return stats.done(false);
 }
 
 bool EspClass::flashRead(uint32_t address, uint8_t *data, size_t size) {
+    FlashStatsScope stats(FLASH_STATS_READ, size);
     size_t sizeAligned = size & ~3;
     size_t currentOffset = 0;
 
@@ -900,7 +1017,7 @@ bool EspClass::flashRead(uint32_t address, uint8_t *data, size_t size) {
             // We read to our aligned buffer and then copy to data
             if (!flashRead(address + currentOffset, &buf[0], willCopy))
             {
-                return false;
+                return stats.done(false);
             }
             memcpy(data + currentOffset, &buf[0], willCopy);
             sizeLeft -= willCopy;
@@ -909,7 +1026,7 @@ bool EspClass::flashRead(uint32_t address, uint8_t *data, size_t size) {
     } else {
         // Pointer is properly aligned, so use aligned read
         if (!flashRead(address, reinterpret_cast<uint32_t *>(data), sizeAligned)) {
-            return false;
+            return stats.done(false);
         }
         currentOffset = sizeAligned;
     }
@@ -917,19 +1034,20 @@ bool EspClass::flashRead(uint32_t address, uint8_t *data, size_t size) {
     if (currentOffset < size) {
         uint32_t tempData;
         if (spi_flash_read(address + currentOffset, &tempData, sizeof(tempData)) != SPI_FLASH_RESULT_OK) {
-            return false;
+            return stats.done(false);
         }
         memcpy(data + currentOffset, &tempData, size - currentOffset);
     }
 
-    return true;
+    return stats.done(true);
 }
 
 bool EspClass::flashRead(uint32_t address, uint32_t *data, size_t size) {
+    FlashStatsScope stats(FLASH_STATS_READ, size);
     if ((uintptr_t)data % 4 != 0 || size % 4 != 0) {
-        return false;
+        return stats.done(false);
     }
-    return (spi_flash_read(address, data, size) == SPI_FLASH_RESULT_OK);
+    return stats.done(spi_flash_read(address, data, size) == SPI_FLASH_RESULT_OK);
 }
 
 String EspClass::getSketchMD5()
@@ -59,6 +59,11 @@ enum RFMode {
 
 #define RF_MODE(mode) int __get_rf_mode() { return mode; }
 #define RF_PRE_INIT() void __run_user_rf_pre_init()
+// Fully calibrate RF at power up and every 'boots' boots (1 to 255) only,
+// and at the next boot when VDD33 moved more than 'vdd_drift_mv' since, with
+// ADC_MODE(ADC_VCC) (0: not checked).  Other boots reuse the calibration
+// saved in flash.  Uses RTC user memory blocks 126 and 127 (RTC_USER_BLOCK_RF_CAL).
+#define RF_CAL_CACHE(boots, vdd_drift_mv) uint32_t __get_rf_cal_cache() { return ((uint32_t)(vdd_drift_mv) << 16) | (uint8_t)(boots); }
 
 // compatibility definitions
 #define WakeMode RFMode
@@ -122,6 +127,19 @@ class EspClass {
 #endif
         static uint32_t getFreeContStack();
         static void resetFreeContStack();
+        static uint32_t getContStackSize();
+        // After each loop(), measure then repaint the free stack, to profile
+        // each iteration on its own.  Costs a pass over the free stack.
+        static void setContStackProfiling(bool enable);
+        static uint32_t getFreeContStackLastLoop();
+        static uint32_t getFreeContStackMinLoop(); // since profiling was enabled
+        // When each stage of the boot was reached, from reset to the end of
+        // the first loop(), in us since reset and since the previous stage.
+        // See boot_timeline_cycles() for the raw cycle counts.
+        static void printBootTimeline(Print& out);
+        // With RF_CAL_CACHE(), have the next boot fully calibrate RF,
+        // after a change of temperature for instance
+        static void requestRfCalibration();
 
         static const char * getSdkVersion();
         static String getCoreVersion();
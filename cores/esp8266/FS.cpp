@@ -29,6 +29,8 @@ size_t File::write(uint8_t c) {
     if (!_p)
         return 0;
 
+    if (_baseFS)
+        _baseFS->_statChanged(*this);
     return _p->write(&c, 1);
 }
 
@@ -36,6 +38,8 @@ size_t File::write(const uint8_t *buf, size_t size) {
     if (!_p)
         return 0;
 
+    if (_baseFS)
+        _baseFS->_statChanged(*this);
     return _p->write(buf, size);
 }
 
@@ -113,6 +117,9 @@ size_t File::size() const {
 
 void File::close() {
     if (_p) {
+        // Files get their final size and time when closed
+        if (_baseFS)
+            _baseFS->_statChanged(*this);
         _p->close();
         _p = nullptr;
     }
@@ -126,9 +133,19 @@ bool File::truncate(uint32_t size) {
     if (!_p)
         return false;
 
+    if (_baseFS)
+        _baseFS->_statChanged(*this);
     return _p->truncate(size);
 }
 
+const uint8_t* File::mappedData(size_t& len) {
+    len = 0;
+    if (!_p)
+        return nullptr;
+
+    return _p->mappedData(len);
+}
+
 const char* File::name() const {
     if (!_p)
         return nullptr;
@@ -303,6 +320,7 @@ bool FS::begin() {
         return false;
     }
     _impl->setTimeCallback(_timeCallback);
+    _impl->changed();
     bool ret = _impl->begin();
     DEBUGV("%s\n", ret? "": "#error: FS could not start");
     return ret;
@@ -310,6 +328,7 @@ bool FS::begin() {
 
 void FS::end() {
     if (_impl) {
+        _impl->changed();
         _impl->end();
     }
 }
@@ -332,6 +351,7 @@ bool FS::format() {
     if (!_impl) {
         return false;
     }
+    _impl->changed();
     return _impl->format();
 }
 
@@ -364,6 +384,15 @@ File FS::open(const char* path, const char* mode) {
         DEBUGV("FS::open: invalid mode `%s`\r\n", mode);
         return File();
     }
+    if (am & AM_WRITE) {
+        _impl->changed(path);
+    } else if (_impl->_statCache) {
+        // Known to be missing, spare the filesystem the lookup
+        const FSStat* st = _impl->_statCache->find(path, false);
+        if (st && !st->exists) {
+            return File();
+        }
+    }
     File f(_impl->open(path, om, am), this);
     f.setTimeCallback(_timeCallback);
     return f;
@@ -373,7 +402,17 @@ bool FS::exists(const char* path) {
     if (!_impl) {
         return false;
     }
-    return _impl->exists(path);
+    if (!_impl->_statCache || !path) {
+        return _impl->exists(path);
+    }
+    const FSStat* cached = _impl->_statCache->find(path, false);
+    if (cached) {
+        return cached->exists;
+    }
+    FSStat st;
+    st.exists = _impl->exists(path);
+    _impl->_statCache->insert(path, st, !st.exists);
+    return st.exists;
 }
 
 bool FS::exists(const String& path) {
@@ -398,6 +437,7 @@ bool FS::remove(const char* path) {
     if (!_impl) {
         return false;
     }
+    _impl->changed();
     return _impl->remove(path);
 }
 
@@ -409,6 +449,7 @@ bool FS::rmdir(const char* path) {
     if (!_impl) {
         return false;
     }
+    _impl->changed();
     return _impl->rmdir(path);
 }
 
@@ -420,6 +461,7 @@ bool FS::mkdir(const char* path) {
     if (!_impl) {
         return false;
     }
+    _impl->changed();
     return _impl->mkdir(path);
 }
 
@@ -431,6 +473,7 @@ bool FS::rename(const char* pathFrom, const char* pathTo) {
     if (!_impl) {
         return false;
     }
+    _impl->changed();
     return _impl->rename(pathFrom, pathTo);
 }
 
@@ -438,6 +481,156 @@ bool FS::rename(const String& pathFrom, const String& pathTo) {
     return rename(pathFrom.c_str(), pathTo.c_str());
 }
 
+uint32_t FS::generation() const {
+    return _impl ? _impl->generation() : 0;
+}
+
+bool FS::setStatCache(size_t entries) {
+    if (!_impl) {
+        return false;
+    }
+    _impl->_statCache.reset();
+    if (!entries) {
+        return true;
+    }
+    std::unique_ptr<FSStatCache> cache(new (std::nothrow) FSStatCache(entries));
+    if (!cache || !cache->ok()) {
+        return false;
+    }
+    _impl->_statCache = std::move(cache);
+    return true;
+}
+
+bool FS::stat(const char* path, FSStat& st) {
+    st = FSStat();
+    if (!_impl || !path) {
+        return false;
+    }
+    FSStatCache* cache = _impl->_statCache.get();
+    if (cache) {
+        const FSStat* cached = cache->find(path, true);
+        if (cached) {
+            st = *cached;
+            return st.exists;
+        }
+    }
+    FileImplPtr f = _impl->open(path, OM_DEFAULT, AM_READ);
+    if (f) {
+        st.exists = true;
+        st.isDir = f->isDirectory();
+        st.size = st.isDir ? 0 : f->size();
+        st.lastWrite = f->getLastWrite();
+        f->close();
+    } else if (_impl->exists(path)) {
+        // A directory the filesystem does not open (SPIFFS has none)
+        st.exists = true;
+        st.isDir = true;
+    }
+    if (cache) {
+        cache->insert(path, st, true);
+    }
+    return st.exists;
+}
+
+bool FS::stat(const String& path, FSStat& st) {
+    return stat(path.c_str(), st);
+}
+
+void FS::_statChanged(const File& f) {
+    if (_impl && _impl->_statCache) {
+        const char* path = f.fullName();
+        if (path) {
+            _impl->_statCache->drop(path);
+        }
+    }
+}
+
+FSStatCache::FSStatCache(size_t entries)
+    : _entries(new (std::nothrow) Entry[entries]), _count(_entries ? entries : 0), _clock(0) {
+    clear();
+}
+
+uint32_t FSStatCache::_hash(const char* path) {
+    while (*path == '/') {
+        path++;
+    }
+    // FNV-1a, never 0 which marks unused entries
+    uint32_t h = 2166136261u;
+    while (*path) {
+        h = (h ^ (uint8_t)*path++) * 16777619u;
+    }
+    return h ? h : 1;
+}
+
+const FSStat* FSStatCache::find(const char* path, bool complete) {
+    uint32_t h = _hash(path);
+    for (size_t i = 0; i < _count; i++) {
+        Entry& e = _entries[i];
+        if ((e.hash == h) && (e.path == path)) {
+            if (complete && !e.complete) {
+                return nullptr;
+            }
+            e.used = ++_clock;
+            return &e.st;
+        }
+    }
+    return nullptr;
+}
+
+void FSStatCache::insert(const char* path, const FSStat& st, bool complete) {
+    uint32_t h = _hash(path);
+    Entry* slot = nullptr;
+    for (size_t i = 0; i < _count; i++) {
+        Entry& e = _entries[i];
+        if ((e.hash == h) && (e.path == path)) {
+            slot = &e;
+            break;
+        }
+        // Unused entries have used == 0 so they go first
+        if (!slot || (e.used < slot->used)) {
+            slot = &e;
+        }
+    }
+    if (!slot) {
+        return;
+    }
+    slot->path = path;
+    slot->hash = h;
+    slot->used = ++_clock;
+    slot->complete = complete;
+    slot->st = st;
+}
+
+void FSStatCache::drop(const char* path) {
+    uint32_t h = _hash(path);
+    while (*path == '/') {
+        path++;
+    }
+    for (size_t i = 0; i < _count; i++) {
+        Entry& e = _entries[i];
+        if (e.hash != h) {
+            continue;
+        }
+        const char* p = e.path.c_str();
+        while (*p == '/') {
+            p++;
+        }
+        if (!strcmp(p, path)) {
+            e.hash = 0;
+            e.used = 0;
+            e.path = String();
+        }
+    }
+}
+
+void FSStatCache::clear() {
+    for (size_t i = 0; i < _count; i++) {
+        _entries[i].hash = 0;
+        _entries[i].used = 0;
+        _entries[i].path = String();
+    }
+}
+
 time_t FS::getCreationTime() {
     if (!_impl) {
         return 0;
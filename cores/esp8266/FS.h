@@ -81,6 +81,12 @@ public:
     const char* fullName() const; // Includes path
     bool truncate(uint32_t size);
 
+    // Where the data at position() can be read in place like PROGMEM
+    // (memcpy_P, pgm_read_*, write_P), len is set to how many bytes follow
+    // it contiguously.  nullptr when the filesystem (or the part of flash it
+    // is in) is not mapped, and for files open for writing
+    const uint8_t* mappedData(size_t& len);
+
     bool isFile() const;
     bool isDirectory() const;
 
@@ -182,6 +188,14 @@ struct FSInfo64 {
     size_t maxPathLength;
 };
 
+// What FS::stat() knows about a path
+struct FSStat {
+    bool exists = false;
+    bool isDir = false;
+    size_t size = 0;
+    time_t lastWrite = 0;
+};
+
 
 class FSConfig
 {
@@ -252,8 +266,28 @@ public:
 
     void setTimeCallback(time_t (*cb)(void));
 
+    // Changes on each begin(), end(), format(), open() for writing, remove(),
+    // rename(), mkdir() and rmdir(), so that caches of file metadata can tell
+    // when to drop their entries. Shared by the copies of this FS object.
+    // Writes through an already opened File do not change it.
+    uint32_t generation() const;
+
+    // Keep what exists() and stat() found for the last (at most) entries
+    // paths, including those that do not exist, until something changes
+    // them.  0, the default, disables the cache.  Shared by the copies of
+    // this FS object.  Returns false when out of memory
+    bool setStatCache(size_t entries);
+
+    // Whether path exists, and if so its type, size and last write time
+    bool stat(const char* path, FSStat& st);
+    bool stat(const String& path, FSStat& st);
+
     friend class ::SDClass; // More of a frenemy, but SD needs internal implementation to get private FAT bits
+    friend class File;
 protected:
+    // f was written to, forget what the stat cache had about it
+    void _statChanged(const File& f);
+
     FSImplPtr _impl;
     FSImplPtr getImpl() { return _impl; }
     time_t (*_timeCallback)(void) = nullptr;
@@ -278,6 +312,7 @@ using fs::SeekSet;
 using fs::SeekCur;
 using fs::SeekEnd;
 using fs::FSInfo;
+using fs::FSStat;
 using fs::FSConfig;
 using fs::SPIFFSConfig;
 #endif //FS_NO_GLOBALS
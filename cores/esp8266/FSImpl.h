@@ -43,6 +43,10 @@ public:
     virtual bool isFile() const = 0;
     virtual bool isDirectory() const = 0;
 
+    // Filesystems *may* read files in place from the flash mapping: the address
+    // of the data at position() and in len how many bytes follow it there
+    virtual const uint8_t* mappedData(size_t& len) { len = 0; return nullptr; }
+
     // Filesystems *may* support a timestamp per-file, so allow the user to override with
     // their own callback for *this specific* file (as opposed to the FSImpl call of the
     // same name.  The default implementation simply returns time(null)
@@ -97,6 +101,37 @@ protected:
     time_t (*_timeCallback)(void) = nullptr;
 };
 
+// LRU of FS::exists()/FS::stat() results, see FS::setStatCache()
+class FSStatCache {
+public:
+    explicit FSStatCache(size_t entries);
+
+    // Entry for path, nullptr when there is none or when complete
+    // is asked for and only the existence of path is known
+    const FSStat* find(const char* path, bool complete);
+    void insert(const char* path, const FSStat& st, bool complete);
+    // Forget path, with or without leading '/'
+    void drop(const char* path);
+    void clear();
+
+    bool ok() const { return !!_entries; }
+
+protected:
+    struct Entry {
+        String   path;
+        uint32_t hash;     // of path without leading '/', 0 when unused
+        uint32_t used;     // _clock when last found
+        bool     complete; // st holds more than exists
+        FSStat   st;
+    };
+
+    static uint32_t _hash(const char* path);
+
+    std::unique_ptr<Entry[]> _entries;
+    size_t                   _count;
+    uint32_t                 _clock;
+};
+
 class FSImpl {
 public:
     virtual ~FSImpl () { }
@@ -122,8 +157,26 @@ public:
     // returns the present time as reported by time(null)
     virtual void setTimeCallback(time_t (*cb)(void)) { _timeCallback = cb; }
 
+    // Counts the operations that may have changed the content (see FS::generation())
+    // and empties the stat cache, or only forgets path when that's all that changed
+    void changed(const char* path = nullptr) {
+        ++_generation;
+        if (!_statCache) {
+            return;
+        }
+        if (path) {
+            _statCache->drop(path);
+        } else {
+            _statCache->clear();
+        }
+    }
+    uint32_t generation() const { return _generation; }
+
+    std::unique_ptr<FSStatCache> _statCache;
+
 protected:
     time_t (*_timeCallback)(void) = nullptr;
+    uint32_t _generation = 0;
 };
 
 } // namespace fs
@@ -0,0 +1,146 @@
+/*
+ GPIOPort.h - several GPIO pins in one register access
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __GPIOPORT_H
+#define __GPIOPORT_H
+
+#include <stdint.h>
+#include <esp8266_peri.h>
+
+// GPIO0..15 are the bits of one port: a mask with bit n set selects GPIOn,
+// and the pins of a mask are set, cleared or read in a single register
+// access, e.g. to clock a parallel bus or several HX711s at once.
+//
+// Unlike digitalWrite(), nothing is checked or stopped: the pins must have
+// been configured with pinMode() and must not run a waveform or PWM.
+// GPIO16 is not part of the port, Pin<16> handles it.
+
+namespace esp8266
+{
+
+namespace gpio
+{
+
+constexpr uint32_t portMask = 0xffff;
+
+constexpr uint32_t mask(uint8_t pin)
+{
+    return (pin < 16) ? (1u << pin) : 0;
+}
+
+template <typename... Pins>
+constexpr uint32_t mask(uint8_t pin, Pins... pins)
+{
+    return mask(pin) | mask(pins...);
+}
+
+inline __attribute__((always_inline)) void set(uint32_t pins)
+{
+    GPOS = pins & portMask;
+}
+
+inline __attribute__((always_inline)) void clear(uint32_t pins)
+{
+    GPOC = pins & portMask;
+}
+
+// The pins of mask take the levels of the matching bits of values
+inline __attribute__((always_inline)) void write(uint32_t pins, uint32_t values)
+{
+    GPOS = values & pins & portMask;
+    GPOC = ~values & pins & portMask;
+}
+
+inline __attribute__((always_inline)) void toggle(uint32_t pins)
+{
+    uint32_t levels = GPO;
+    GPOS = ~levels & pins & portMask;
+    GPOC = levels & pins & portMask;
+}
+
+inline __attribute__((always_inline)) uint32_t read(uint32_t pins = portMask)
+{
+    return GPI & pins & portMask;
+}
+
+// Switch pins already in GPIO mode between output and input
+inline __attribute__((always_inline)) void output(uint32_t pins)
+{
+    GPES = pins & portMask;
+}
+
+inline __attribute__((always_inline)) void input(uint32_t pins)
+{
+    GPEC = pins & portMask;
+}
+
+// A pin known at compile time, each call compiles to a single register
+// access:  using Led = esp8266::gpio::Pin<2>;  Led::high();
+template <uint8_t pin>
+struct Pin
+{
+    static_assert(pin <= 16, "GPIO0..16 only");
+
+    static inline __attribute__((always_inline)) void high()
+    {
+        if (pin < 16)
+        {
+            GPOS = mask(pin);
+        }
+        else
+        {
+            GP16O |= 1;
+        }
+    }
+
+    static inline __attribute__((always_inline)) void low()
+    {
+        if (pin < 16)
+        {
+            GPOC = mask(pin);
+        }
+        else
+        {
+            GP16O &= ~1;
+        }
+    }
+
+    static inline __attribute__((always_inline)) void write(bool value)
+    {
+        value ? high() : low();
+    }
+
+    static inline __attribute__((always_inline)) void toggle()
+    {
+        write(!(pin < 16 ? (GPO & mask(pin)) : (GP16O & 1)));
+    }
+
+    static inline __attribute__((always_inline)) bool read()
+    {
+        return (pin < 16) ? GPIP(pin) : (GP16I & 1);
+    }
+};
+
+}; // namespace gpio
+
+}; // namespace esp8266
+
+#endif // __GPIOPORT_H
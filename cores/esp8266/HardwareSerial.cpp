@@ -45,6 +45,12 @@ void HardwareSerial::begin(unsigned long baud, SerialConfig config, SerialMode m
 {
     end();
     _uart = uart_init(_uart_nr, baud, (int) config, (int) mode, tx_pin, _rx_size, invert);
+    if(_tx_size) {
+        uart_resize_tx_buffer(_uart, _tx_size);
+    }
+    if(_rxFrameSymbols) {
+        uart_set_rx_frame_callback(_uart, _rxFrameSymbols, _rxFrame, this);
+    }
 #if defined(DEBUG_ESP_PORT) && !defined(NDEBUG)
     if (static_cast<void*>(this) == static_cast<void*>(&DEBUG_ESP_PORT))
     {
@@ -83,6 +89,30 @@ size_t HardwareSerial::setRxBufferSize(size_t size){
     return _rx_size;
 }
 
+size_t HardwareSerial::setTxBufferSize(size_t size){
+    if(_uart) {
+        _tx_size = uart_resize_tx_buffer(_uart, size);
+    } else {
+        _tx_size = size;
+    }
+    return _tx_size;
+}
+
+bool HardwareSerial::onReceiveFrame(RxFrameFunction cb, uint8_t symbols)
+{
+    _rxFrameCb = std::move(cb);
+    _rxFrameSymbols = _rxFrameCb? symbols: 0;
+    if(!_uart) {
+        return true; // applied by begin()
+    }
+    return uart_set_rx_frame_callback(_uart, _rxFrameSymbols, _rxFrameSymbols? _rxFrame: nullptr, this);
+}
+
+void HardwareSerial::_rxFrame(void* arg, const char* frame, size_t size)
+{
+    static_cast<HardwareSerial*>(arg)->_rxFrameCb(frame, size);
+}
+
 void HardwareSerial::setDebugOutput(bool en)
 {
     if(!_uart) {
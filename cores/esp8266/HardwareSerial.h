@@ -28,6 +28,7 @@
 #define HardwareSerial_h
 
 #include <inttypes.h>
+#include <functional>
 #include <../include/time.h> // See issue #6714
 #include "Stream.h"
 #include "uart.h"
@@ -101,6 +102,21 @@ public:
         return uart_get_rx_buffer_size(_uart);
     }
 
+    // 0 (default): write() waits for room in the 128 bytes hw fifo
+    // otherwise: write() returns once data is copied to a buffer of this size,
+    // sent from the uart interrupt (debug output from os_printf() bypasses it)
+    size_t setTxBufferSize(size_t size);
+    size_t getTxBufferSize()
+    {
+        return uart_get_tx_buffer_size(_uart);
+    }
+
+    // packet protocols (Modbus RTU...): cb is called from the loop with each frame,
+    // the bytes received before the rx line stays idle for `symbols` character times
+    // (1..127), the frame is consumed when cb returns. nullptr disables (unavailable with GDB)
+    using RxFrameFunction = std::function<void(const char* frame, size_t size)>;
+    bool onReceiveFrame(RxFrameFunction cb, uint8_t symbols = 4);
+
     bool swap()
     {
         return swap(1);
@@ -192,6 +208,13 @@ public:
     {
         return uart_write(_uart, (const char*)buffer, size);
     }
+    size_t write(const iovec *iov, size_t iovcnt) override
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < iovcnt; i++)
+            n += uart_write(_uart, (const char*)iov[i].iov_base, iov[i].iov_len);
+        return n;
+    }
     using Print::write; // Import other write() methods to support things like write(0) properly
     operator bool() const
     {
@@ -211,6 +234,8 @@ public:
         return uart_get_baudrate(_uart);
     }
 
+    // true when received bytes were dropped since last call, the newest ones
+    // are dropped while the rx buffer is full
     bool hasOverrun(void)
     {
         return uart_has_overrun(_uart);
@@ -231,6 +256,11 @@ protected:
     int _uart_nr;
     uart_t* _uart = nullptr;
     size_t _rx_size;
+    size_t _tx_size = 0;
+    RxFrameFunction _rxFrameCb;
+    uint8_t _rxFrameSymbols = 0;
+
+    static void _rxFrame(void* arg, const char* frame, size_t size);
 };
 
 #if defined(HAVE_KFC_FIRMWARE_VERSION)
@@ -0,0 +1,259 @@
+/*
+ IPAccessList.cpp - IPv4/IPv6 prefixes matched by a radix tree
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "IPAccessList.h"
+
+namespace esp8266
+{
+
+namespace IPAccessListImplementation
+{
+
+// leading bits a and b have in common, up to max
+template<size_t Bytes>
+static uint8_t commonBits(const uint8_t* a, const uint8_t* b, uint8_t max)
+{
+    uint8_t common = 0;
+    for (size_t i = 0; i < Bytes && common < max; i++)
+    {
+        uint8_t diff = a[i] ^ b[i];
+        if (diff)
+        {
+            common += __builtin_clz(diff) - 24;
+            break;
+        }
+        common += 8;
+    }
+    return std::min(common, max);
+}
+
+static int bitAt(const uint8_t* key, uint8_t bit)
+{
+    return (key[bit / 8] >> (7 - bit % 8)) & 1;
+}
+
+template<size_t Bytes>
+uint16_t PrefixTree<Bytes>::_node(const uint8_t* key, uint8_t length, int8_t value)
+{
+    if (_nodes.size() >= none)
+    {
+        return none;
+    }
+    Node node;
+    for (size_t i = 0; i < Bytes; i++)
+    {
+        size_t bit = i * 8;
+        node.key[i] = bit + 8 <= length ? key[i] : bit < length ? key[i] & (0xff << (8 - (length - bit))) : 0;
+    }
+    node.length = length;
+    node.value = value;
+    node.child[0] = node.child[1] = none;
+    _nodes.push_back(node);
+    return _nodes.size() - 1;
+}
+
+template<size_t Bytes>
+bool PrefixTree<Bytes>::insert(const uint8_t* key, uint8_t length, bool value)
+{
+    uint16_t parent = none;
+    int side = 0;
+    uint16_t at = _root;
+    while (at != none)
+    {
+        // by index, _node() moves the nodes
+        uint8_t atLength = _nodes[at].length;
+        uint8_t common = commonBits<Bytes>(_nodes[at].key, key, std::min(atLength, length));
+        if (common == atLength)
+        {
+            if (atLength == length)
+            {
+                _nodes[at].value = value;
+                return true;
+            }
+            parent = at;
+            side = bitAt(key, atLength);
+            at = _nodes[at].child[side];
+            continue;
+        }
+
+        // at isn't a prefix of key: a node for their common prefix, then both below
+        uint16_t split = _node(key, common, common == length ? value : -1);
+        if (split == none)
+        {
+            return false;
+        }
+        _nodes[split].child[bitAt(_nodes[at].key, common)] = at;
+        if (common < length)
+        {
+            uint16_t leaf = _node(key, length, value);
+            if (leaf == none)
+            {
+                _nodes.pop_back();
+                return false;
+            }
+            _nodes[split].child[bitAt(key, common)] = leaf;
+        }
+        at = split;
+        break;
+    }
+
+    if (at == none && (at = _node(key, length, value)) == none)
+    {
+        return false;
+    }
+    if (parent == none)
+    {
+        _root = at;
+    }
+    else
+    {
+        _nodes[parent].child[side] = at;
+    }
+    return true;
+}
+
+template<size_t Bytes>
+int PrefixTree<Bytes>::lookup(const uint8_t* key) const
+{
+    int value = -1;
+    for (uint16_t at = _root; at != none;)
+    {
+        const Node& node = _nodes[at];
+        if (commonBits<Bytes>(node.key, key, node.length) < node.length)
+        {
+            break;
+        }
+        if (node.value >= 0)
+        {
+            value = node.value;
+        }
+        if (node.length == bits)
+        {
+            break;
+        }
+        at = node.child[bitAt(key, node.length)];
+    }
+    return value;
+}
+
+template<size_t Bytes>
+size_t PrefixTree<Bytes>::prefixes() const
+{
+    return std::count_if(_nodes.begin(), _nodes.end(), [](const Node& node) { return node.value >= 0; });
+}
+
+template class PrefixTree<4>;
+template class PrefixTree<16>;
+
+} // namespace IPAccessListImplementation
+
+} // namespace esp8266
+
+bool IPAccessList::add(const char* prefix, bool allowed)
+{
+    const char* slash = strchr(prefix, '/');
+    size_t textLength = slash ? (size_t)(slash - prefix) : strlen(prefix);
+    char text[48];
+    if (textLength >= sizeof(text))
+    {
+        return false;
+    }
+    memcpy(text, prefix, textLength);
+    text[textLength] = 0;
+    IPAddress address;
+    if (!address.fromString(text))
+    {
+        return false;
+    }
+    unsigned long length = address.isV4() ? 32 : 128;
+    if (slash)
+    {
+        char* end;
+        unsigned long parsed = strtoul(slash + 1, &end, 10);
+        if (end == slash + 1 || *end || parsed > length)
+        {
+            return false;
+        }
+        length = parsed;
+    }
+    return add(address, length, allowed);
+}
+
+bool IPAccessList::add(const IPAddress& address, uint8_t prefixLength, bool allowed)
+{
+    if (address.isV4())
+    {
+        return prefixLength <= 32 && _v4.insert(reinterpret_cast<const uint8_t*>(&address.v4()), prefixLength, allowed);
+    }
+#if LWIP_IPV6
+    return prefixLength <= 128 && _v6.insert(reinterpret_cast<const uint8_t*>(address.raw6()), prefixLength, allowed);
+#else
+    return false;
+#endif
+}
+
+void IPAccessList::clear()
+{
+    _v4.clear();
+#if LWIP_IPV6
+    _v6.clear();
+#endif
+}
+
+bool IPAccessList::match(const IPAddress& address, bool& allowed) const
+{
+    int value = -1;
+    if (address.isV4())
+    {
+        value = _v4.lookup(reinterpret_cast<const uint8_t*>(&address.v4()));
+    }
+#if LWIP_IPV6
+    else
+    {
+        value = _v6.lookup(reinterpret_cast<const uint8_t*>(address.raw6()));
+    }
+#endif
+    if (value < 0)
+    {
+        return false;
+    }
+    allowed = value;
+    return true;
+}
+
+bool IPAccessList::allowed(const IPAddress& address) const
+{
+    bool allowed = _default;
+    match(address, allowed);
+    return allowed;
+}
+
+size_t IPAccessList::size() const
+{
+#if LWIP_IPV6
+    return _v4.prefixes() + _v6.prefixes();
+#else
+    return _v4.prefixes();
+#endif
+}
@@ -0,0 +1,128 @@
+/*
+ IPAccessList.h - IPv4/IPv6 prefixes matched by a radix tree
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __IPACCESSLIST_H
+#define __IPACCESSLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <IPAddress.h>
+
+// Allowed and denied prefixes, the longest one containing an address
+// deciding, the default otherwise:
+//
+//    IPAccessList acl;                  // denied by default
+//    acl.allow("192.168.1.0/24");
+//    acl.deny("192.168.1.13");
+//    acl.allow("fe80::/10");
+//    ...
+//    if (!acl.allowed(server.client().remoteIP())) ...
+//
+// Each family is a path compressed binary tree of the prefixes: a lookup
+// compares at most one node per differing bit, whatever the number of
+// prefixes, instead of each prefix in turn.
+
+namespace esp8266
+{
+
+namespace IPAccessListImplementation
+{
+
+// Prefixes of Bytes bytes long addresses, in network order
+template<size_t Bytes>
+class PrefixTree
+{
+public:
+    static constexpr uint8_t bits = Bytes * 8;
+
+    // false when full
+    bool insert(const uint8_t* key, uint8_t length, bool value);
+    // value of the longest prefix of key, -1 if none
+    int lookup(const uint8_t* key) const;
+    void clear()
+    {
+        _nodes.clear();
+        _root = none;
+    }
+    size_t prefixes() const;
+
+protected:
+    static constexpr uint16_t none = UINT16_MAX;
+
+    struct Node
+    {
+        uint8_t key[Bytes];    // bits past length are 0
+        uint8_t length;
+        int8_t value;          // -1 between prefixes
+        uint16_t child[2];
+    };
+
+    uint16_t _node(const uint8_t* key, uint8_t length, int8_t value);
+
+    std::vector<Node> _nodes;
+    uint16_t _root = none;
+};
+
+} // namespace IPAccessListImplementation
+
+} // namespace esp8266
+
+class IPAccessList
+{
+public:
+    explicit IPAccessList(bool allowByDefault = false) : _default(allowByDefault)
+    {
+    }
+
+    // "10.0.0.0/8", "2001:db8::/32", or an address on its own;
+    // false when not parsed
+    bool allow(const char* prefix)
+    {
+        return add(prefix, true);
+    }
+    bool deny(const char* prefix)
+    {
+        return add(prefix, false);
+    }
+    bool add(const char* prefix, bool allowed);
+    bool add(const IPAddress& address, uint8_t prefixLength, bool allowed);
+    void clear();
+
+    bool allowed(const IPAddress& address) const;
+    // false when no prefix contains address, else allowed set
+    bool match(const IPAddress& address, bool& allowed) const;
+
+    void setDefault(bool allowed)
+    {
+        _default = allowed;
+    }
+    size_t size() const;
+
+protected:
+    esp8266::IPAccessListImplementation::PrefixTree<4> _v4;
+#if LWIP_IPV6
+    esp8266::IPAccessListImplementation::PrefixTree<16> _v6;
+#endif
+    bool _default;
+};
+
+#endif // __IPACCESSLIST_H
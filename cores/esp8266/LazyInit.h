@@ -0,0 +1,112 @@
+/*
+ LazyInit.h - globals constructed on first use instead of before setup()
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __LAZYINIT_H
+#define __LAZYINIT_H
+
+#include <new>
+#include <stdint.h>
+#include <type_traits>
+#include <Schedule.h>
+
+namespace esp8266
+{
+
+// Every global with a constructor is constructed by do_global_ctors(),
+// before setup(), and its destructor registered, whether the sketch uses it
+// or not.  A Lazy<T> global instead is in .bss, without any code run at
+// boot: its T is constructed the first time it is used, default constructed
+// or returned by make():
+//
+//    static esp8266::Lazy<std::list<Item>> items;
+//    static esp8266::Lazy<std::shared_ptr<bool>> flag([] { return std::make_shared<bool>(false); });
+//    items->push_back(item);
+//
+// constructWhenIdle() has it constructed after the current loop(), from the
+// scheduled functions, when it is first used in a time critical place.
+//
+// T is never destroyed, as globals never are on the ESP8266.  get() is not
+// meant to be called from an ISR.
+
+template <typename T>
+class Lazy
+{
+public:
+    constexpr Lazy() = default;
+    constexpr explicit Lazy(T (*make)()) : _make(make) { }
+
+    Lazy(const Lazy&) = delete;
+    Lazy& operator=(const Lazy&) = delete;
+
+    T& get()
+    {
+        if (!_constructed)
+        {
+            construct();
+        }
+        return *std::launder(reinterpret_cast<T*>(_storage));
+    }
+
+    T& operator*()
+    {
+        return get();
+    }
+
+    T* operator->()
+    {
+        return &get();
+    }
+
+    bool constructed() const
+    {
+        return _constructed;
+    }
+
+    bool constructWhenIdle()
+    {
+        return _constructed || schedule_function([this]() { get(); });
+    }
+
+protected:
+    void construct()
+    {
+        if (_make)
+        {
+            new (_storage) T(_make());
+        }
+        else
+        {
+            if constexpr (std::is_default_constructible_v<T>)
+            {
+                new (_storage) T();
+            }
+        }
+        _constructed = true;
+    }
+
+    alignas(T) uint8_t _storage[sizeof(T)] = { };
+    T (*_make)() = nullptr;
+    bool _constructed = false;
+};
+
+} // namespace esp8266
+
+#endif // __LAZYINIT_H
@@ -52,6 +52,7 @@
 
 #include <cstring>
 #include <sys/pgmspace.h>
+#include <coredecls.h>  // crc32
 
 typedef struct dhcps_state
 {
@@ -95,15 +96,6 @@ typedef enum
     DHCPS_STATE_OFFLINE
 } dhcps_state_t;
 
-struct dhcps_pool
-{
-    struct ipv4_addr ip;
-    uint8            mac[6];
-    uint32           lease_timer;
-    dhcps_type_t     type;
-    dhcps_state_t    state;
-};
-
 #define DHCPS_MAX_LEASE 0x64
 #define BOOTP_BROADCAST 0x8000
 
@@ -135,6 +127,7 @@ static constexpr uint8_t DHCPRELEASE  = 7;
 #define DHCP_OPTION_PERFORM_ROUTER_DISCOVERY 31
 #define DHCP_OPTION_BROADCAST_ADDRESS 28
 #define DHCP_OPTION_REQ_LIST 55
+#define DHCP_OPTION_RAPID_COMMIT 80  // RFC 4039
 #define DHCP_OPTION_END 255
 
 //#define USE_CLASS_B_NET 1
@@ -198,88 +191,203 @@ DhcpServer::DhcpServer(netif* netif) : _netif(netif) { }
 // wifi_softap_set_station_info is missing in user_interface.h:
 extern "C" void wifi_softap_set_station_info(uint8_t* mac, struct ipv4_addr*);
 
-/******************************************************************************
-    FunctionName : node_insert_to_list
-    Description  : insert the node to the list
-    Parameters   : arg -- Additional argument to pass to the callback function
-    Returns      : none
-*******************************************************************************/
-void DhcpServer::node_insert_to_list(list_node** phead, list_node* pinsert)
+////////////////////////////////////////////////////////////////////////////////////
+// Lease table: open addressing by MAC (linear probing, a removed lease is filled
+// by shifting back the following ones), full when all entries are used
+
+size_t DhcpServer::lease_home(const uint8_t* mac)
 {
-    list_node*         plist       = nullptr;
-    struct dhcps_pool* pdhcps_pool = nullptr;
-    struct dhcps_pool* pdhcps_node = nullptr;
-    if (*phead == nullptr)
+    uint32_t hash = 2166136261u;  // FNV-1a
+    for (size_t i = 0; i < 6; i++)
     {
-        *phead = pinsert;
+        hash = (hash ^ mac[i]) * 16777619u;
     }
-    else
+    return (hash ^ (hash >> 16)) & (LeaseTableSize - 1);
+}
+
+DhcpServer::Lease* DhcpServer::find_lease(const uint8_t* mac)
+{
+    size_t pos = lease_home(mac);
+    for (size_t n = 0; n < LeaseTableSize && leases[pos].ip.addr != IPADDR_ANY; n++)
     {
-        plist       = *phead;
-        pdhcps_node = (struct dhcps_pool*)pinsert->pnode;
-        pdhcps_pool = (struct dhcps_pool*)plist->pnode;
+        if (memcmp(leases[pos].mac, mac, sizeof(leases[pos].mac)) == 0)
+        {
+            return &leases[pos];
+        }
+        pos = (pos + 1) & (LeaseTableSize - 1);
+    }
+    return nullptr;
+}
 
-        if (pdhcps_node->ip.addr < pdhcps_pool->ip.addr)
+DhcpServer::Lease* DhcpServer::find_lease_ip(uint32 ip)
+{
+    for (auto& entry : leases)
+    {
+        if (entry.ip.addr != IPADDR_ANY && entry.ip.addr == ip)
         {
-            pinsert->pnext = plist;
-            *phead         = pinsert;
+            return &entry;
         }
-        else
+    }
+    return nullptr;
+}
+
+// the least recently updated lease is replaced when the table is full
+DhcpServer::Lease* DhcpServer::insert_lease(const uint8_t* mac, uint32 ip)
+{
+    if (lease_count == LeaseTableSize)
+    {
+        Lease* oldest = nullptr;
+        for (auto& entry : leases)
         {
-            while (plist->pnext != nullptr)
+            if (!oldest || (uint32_t)(sys_now() - entry.stamp) > (uint32_t)(sys_now() - oldest->stamp))
             {
-                pdhcps_pool = (struct dhcps_pool*)plist->pnext->pnode;
-                if (pdhcps_node->ip.addr < pdhcps_pool->ip.addr)
-                {
-                    pinsert->pnext = plist->pnext;
-                    plist->pnext   = pinsert;
-                    break;
-                }
-                plist = plist->pnext;
+                oldest = &entry;
             }
+        }
+        remove_lease(oldest);
+    }
 
-            if (plist->pnext == nullptr)
-            {
-                plist->pnext = pinsert;
-            }
+    size_t pos = lease_home(mac);
+    while (leases[pos].ip.addr != IPADDR_ANY)
+    {
+        pos = (pos + 1) & (LeaseTableSize - 1);
+    }
+
+    Lease& entry = leases[pos];
+    entry.ip.addr = ip;
+    memcpy(entry.mac, mac, sizeof(entry.mac));
+    entry.type  = DHCPS_TYPE_DYNAMIC;
+    entry.state = DHCPS_STATE_ONLINE;
+    entry.stamp = sys_now();
+    lease_count++;
+    return &entry;
+}
+
+void DhcpServer::remove_lease(Lease* lease)
+{
+    size_t empty = lease - leases;
+    for (size_t pos = (empty + 1) & (LeaseTableSize - 1); leases[pos].ip.addr != IPADDR_ANY && pos != empty;
+         pos      = (pos + 1) & (LeaseTableSize - 1))
+    {
+        size_t home = lease_home(leases[pos].mac);
+        // may move to `empty` if home is not cyclically in (empty, pos]
+        if (((pos - home) & (LeaseTableSize - 1)) >= ((pos - empty) & (LeaseTableSize - 1)))
+        {
+            leases[empty] = leases[pos];
+            empty         = pos;
         }
     }
-    //  pinsert->pnext = nullptr;
+    leases[empty] = Lease {};
+    lease_count--;
 }
 
-/******************************************************************************
-    FunctionName : node_delete_from_list
-    Description  : remove the node from list
-    Parameters   : arg -- Additional argument to pass to the callback function
-    Returns      : none
-*******************************************************************************/
-void DhcpServer::node_remove_from_list(list_node** phead, list_node* pdelete)
+// first address of the range no lease has, IPADDR_ANY when there is none
+uint32 DhcpServer::free_lease_ip(uint32 preferred)
 {
-    list_node* plist = nullptr;
+    const uint32 start = ntohl(lease.start_ip.addr);
+    const uint32 end   = ntohl(lease.end_ip.addr);
 
-    plist = *phead;
-    if (plist == nullptr)
+    // the range holds at most DHCPS_MAX_LEASE + 1 addresses
+    uint32_t used[(DHCPS_MAX_LEASE + 32) / 32] = {};
+    for (const auto& entry : leases)
     {
-        *phead = nullptr;
+        uint32 offset = ntohl(entry.ip.addr) - start;
+        if (entry.ip.addr != IPADDR_ANY && offset <= end - start)
+        {
+            used[offset / 32] |= 1u << (offset % 32);
+        }
     }
-    else
+
+    uint32 offset = ntohl(preferred) - start;
+    if (preferred != IPADDR_ANY && offset <= end - start && !(used[offset / 32] & (1u << (offset % 32))))
+    {
+        return preferred;
+    }
+
+    for (offset = 0; start <= end && offset <= end - start; offset++)
     {
-        if (plist == pdelete)
+        if (!(used[offset / 32] & (1u << (offset % 32))))
         {
-            *phead         = plist->pnext;
-            pdelete->pnext = nullptr;
+            return htonl(start + offset);
         }
-        else
+    }
+    return IPADDR_ANY;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+// Leases kept in the RTC user memory, they survive a reset or deep sleep
+
+namespace
+{
+struct StoredLeases
+{
+    uint32_t crc;
+    uint32_t server;  // the leases are only restored for the same server address
+    uint8_t  count;
+    uint8_t  reserved[3];
+    struct
+    {
+        uint8_t mac[6];
+        uint8_t host;  // last byte of the address, the range is within a /24
+        uint8_t type;
+    } leases[DhcpServer::LeaseTableSize];
+};
+}
+
+bool DhcpServer::setLeasesRTCOffset(int32_t offset)
+{
+    if (offset >= 0 && offset * 4 + sizeof(StoredLeases) > 512)
+    {
+        return false;
+    }
+    rtc_offset = offset;
+    save_leases();
+    return true;
+}
+
+void DhcpServer::save_leases()
+{
+    if (rtc_offset < 0 || !isRunning())
+    {
+        return;
+    }
+
+    StoredLeases stored {};
+    stored.server = server_address.addr;
+    for (const auto& entry : leases)
+    {
+        if (entry.ip.addr != IPADDR_ANY)
         {
-            while (plist != nullptr)
-            {
-                if (plist->pnext == pdelete)
-                {
-                    plist->pnext   = pdelete->pnext;
-                    pdelete->pnext = nullptr;
-                }
-                plist = plist->pnext;
-            }
+            auto& dst = stored.leases[stored.count++];
+            memcpy(dst.mac, entry.mac, sizeof(dst.mac));
+            dst.host = ntohl(entry.ip.addr) & 0xff;
+            dst.type = entry.type;
+        }
+    }
+    stored.crc = crc32(&stored.server, sizeof(stored) - sizeof(stored.crc));
+    system_rtc_mem_write(64 + rtc_offset, &stored, sizeof(stored));
+}
+
+void DhcpServer::restore_leases()
+{
+    StoredLeases stored;
+    if (rtc_offset < 0 || !system_rtc_mem_read(64 + rtc_offset, &stored, sizeof(stored))
+        || stored.crc != crc32(&stored.server, sizeof(stored) - sizeof(stored.crc))
+        || stored.server != server_address.addr || stored.count > LeaseTableSize)
+    {
+        return;
+    }
+
+    const uint32 net = ntohl(server_address.addr) & 0xffffff00;
+    for (size_t i = 0; i < stored.count; i++)
+    {
+        const auto& src = stored.leases[i];
+        const uint32 ip = htonl(net | src.host);
+        if (!find_lease(src.mac) && !find_lease_ip(ip) && ip == free_lease_ip(ip))
+        {
+            Lease* entry = insert_lease(src.mac, ip);
+            entry->type  = src.type;
+            entry->state = DHCPS_STATE_OFFLINE;  // until the station comes back
         }
     }
 }
@@ -292,29 +400,16 @@ void DhcpServer::node_remove_from_list(list_node** phead, list_node* pdelete)
 *******************************************************************************/
 bool DhcpServer::add_dhcps_lease(uint8* macaddr)
 {
-    struct dhcps_pool* pdhcps_pool = nullptr;
-    list_node*         pback_node  = nullptr;
-
-    uint32 start_ip = lease.start_ip.addr;
-    uint32 end_ip   = lease.end_ip.addr;
-
-    for (pback_node = plist; pback_node != nullptr; pback_node = pback_node->pnext)
+    if (find_lease(macaddr))
     {
-        pdhcps_pool = (dhcps_pool*)pback_node->pnode;
-        if (memcmp(pdhcps_pool->mac, macaddr, sizeof(pdhcps_pool->mac)) == 0)
-        {
 #if DHCPS_DEBUG
-            os_printf("this mac already exist");
+        os_printf("this mac already exist");
 #endif
-            return false;
-        }
-        else
-        {
-            start_ip = htonl((ntohl(start_ip) + 1));
-        }
+        return false;
     }
 
-    if (start_ip > end_ip)
+    uint32 ip = free_lease_ip(IPADDR_ANY);
+    if (ip == IPADDR_ANY || lease_count == LeaseTableSize)
     {
 #if DHCPS_DEBUG
         os_printf("no more ip available");
@@ -322,16 +417,8 @@ bool DhcpServer::add_dhcps_lease(uint8* macaddr)
         return false;
     }
 
-    pdhcps_pool          = (struct dhcps_pool*)zalloc(sizeof(struct dhcps_pool));
-    pdhcps_pool->ip.addr = start_ip;
-    memcpy(pdhcps_pool->mac, macaddr, sizeof(pdhcps_pool->mac));
-    pdhcps_pool->lease_timer = this->lease_time;
-    pdhcps_pool->type        = DHCPS_TYPE_STATIC;
-    pdhcps_pool->state       = DHCPS_STATE_ONLINE;
-    pback_node               = (list_node*)zalloc(sizeof(list_node));
-    pback_node->pnode        = pdhcps_pool;
-    pback_node->pnext        = nullptr;
-    node_insert_to_list(&plist, pback_node);
+    insert_lease(macaddr, ip)->type = DHCPS_TYPE_STATIC;
+    save_leases();
 
     return true;
 }
@@ -518,6 +605,10 @@ void DhcpServer::send_ack(struct dhcps_msg* m)
 
     auto options = create_msg(m);
     options.add(DHCP_OPTION_MSG_TYPE, DHCPACK);
+    if (rapid_commit)
+    {
+        options.add(DHCP_OPTION_RAPID_COMMIT, std::initializer_list<uint8_t> {});
+    }
 
     add_offer_options(options);
     if (custom_offer_options)
@@ -585,6 +676,7 @@ uint8_t DhcpServer::parse_options(uint8_t* optptr, sint16_t len)
     u16_t type = 0;
 
     s.state = DHCPS_STATE_IDLE;
+    bool rapid_commit_asked = false;
 
     while (optptr < end)
     {
@@ -614,6 +706,9 @@ uint8_t DhcpServer::parse_options(uint8_t* optptr, sint16_t len)
                 s.state = DHCPS_STATE_NAK;
             }
             break;
+        case DHCP_OPTION_RAPID_COMMIT:  // 80
+            rapid_commit_asked = true;
+            break;
         case DHCP_OPTION_END:
         {
             is_dhcp_parse_end = true;
@@ -633,6 +728,12 @@ uint8_t DhcpServer::parse_options(uint8_t* optptr, sint16_t len)
     {
     case DHCPDISCOVER:  // 1
         s.state = DHCPS_STATE_OFFER;
+        // a station coming back to its lease is acknowledged at once when it allows it
+        if (rapid_commit_asked && known_client && client_address.addr != IPADDR_ANY)
+        {
+            rapid_commit = true;
+            s.state      = DHCPS_STATE_ACK;
+        }
 #if DHCPS_DEBUG
         os_printf("dhcps: DHCPD_STATE_OFFER\n");
 #endif
@@ -675,6 +776,22 @@ uint8_t DhcpServer::parse_options(uint8_t* optptr, sint16_t len)
     return s.state;
 }
 ///////////////////////////////////////////////////////////////////////////////////
+// address asked for by the requested IP address option, IPADDR_ANY when none
+uint32 DhcpServer::requested_ip(const uint8_t* optptr, sint16_t len)
+{
+    const uint8_t* end = optptr + len;
+    while (optptr + 1 < end && *optptr != DHCP_OPTION_END)
+    {
+        if (*optptr == DHCP_OPTION_REQ_IPADDR && optptr[1] == 4 && optptr + 6 <= end)
+        {
+            uint32 ip;
+            memcpy(&ip, optptr + 2, sizeof(ip));
+            return ip;
+        }
+        optptr += optptr[1] + 2;
+    }
+    return IPADDR_ANY;
+}
 ///////////////////////////////////////////////////////////////////////////////////
 sint16_t DhcpServer::parse_msg(struct dhcps_msg* m, u16_t len)
 {
@@ -682,6 +799,8 @@ sint16_t DhcpServer::parse_msg(struct dhcps_msg* m, u16_t len)
     {
         struct ipv4_addr ip;
         memcpy(&ip.addr, m->ciaddr, sizeof(ip.addr));
+        rapid_commit        = false;
+        requested_address   = requested_ip(&m->options[4], len);
         client_address.addr = dhcps_client_update(m->chaddr, &ip);
 
         sint16_t ret = parse_options(&m->options[4], len);
@@ -891,6 +1010,7 @@ bool DhcpServer::begin()
 
     server_address = *ip_2_ip4(&_netif->ip_addr);
     init_dhcps_lease(server_address.addr);
+    restore_leases();
 
     udp_bind(pcb_dhcps, IP_ADDR_ANY, DHCPS_SERVER_PORT);
     udp_recv(pcb_dhcps, S_handle_dhcp, this);
@@ -918,30 +1038,17 @@ void DhcpServer::end()
     udp_remove(pcb_dhcps);
     pcb_dhcps = nullptr;
 
-    // udp_remove(pcb_dhcps);
-    list_node*         pnode      = nullptr;
-    list_node*         pback_node = nullptr;
-    struct dhcps_pool* dhcp_node  = nullptr;
-    struct ipv4_addr   ip_zero;
-
+    struct ipv4_addr ip_zero;
     memset(&ip_zero, 0x0, sizeof(ip_zero));
-    pnode = plist;
-    while (pnode != nullptr)
-    {
-        pback_node = pnode;
-        pnode      = pback_node->pnext;
-        node_remove_from_list(&plist, pback_node);
-        dhcp_node = (struct dhcps_pool*)pback_node->pnode;
-        // dhcps_client_leave(dhcp_node->mac,&dhcp_node->ip,true); // force to delete
-        if (_netif->num == SOFTAP_IF)
+    for (auto& entry : leases)
+    {
+        if (entry.ip.addr != IPADDR_ANY && _netif->num == SOFTAP_IF)
         {
-            wifi_softap_set_station_info(dhcp_node->mac, &ip_zero);
+            wifi_softap_set_station_info(entry.mac, &ip_zero);
         }
-        free(pback_node->pnode);
-        pback_node->pnode = nullptr;
-        free(pback_node);
-        pback_node = nullptr;
+        entry = Lease {};
     }
+    lease_count = 0;
 }
 
 bool DhcpServer::isRunning() const
@@ -1063,131 +1170,99 @@ bool DhcpServer::get_dhcps_lease(struct dhcps_lease* please)
     return true;
 }
 
+bool DhcpServer::get_dhcps_lease_ip(const uint8_t* mac, ip4_addr_t* ip) const
+{
+    const Lease* entry = const_cast<DhcpServer*>(this)->find_lease(mac);
+    if (!entry)
+    {
+        return false;
+    }
+    ip->addr = entry->ip.addr;
+    return true;
+}
+
 void DhcpServer::kill_oldest_dhcps_pool(void)
 {
-    list_node *        pre = nullptr, *p = nullptr;
-    list_node *        minpre = nullptr, *minp = nullptr;
-    struct dhcps_pool *pdhcps_pool = nullptr, *pmin_pool = nullptr;
-    pre    = plist;
-    p      = pre->pnext;
-    minpre = pre;
-    minp   = p;
-    while (p != nullptr)
-    {
-        pdhcps_pool = (struct dhcps_pool*)p->pnode;
-        pmin_pool   = (struct dhcps_pool*)minp->pnode;
-        if (pdhcps_pool->lease_timer < pmin_pool->lease_timer)
+    Lease* oldest = nullptr;
+    for (auto& entry : leases)
+    {
+        if (entry.ip.addr != IPADDR_ANY
+            && (!oldest || (uint32_t)(sys_now() - entry.stamp) > (uint32_t)(sys_now() - oldest->stamp)))
         {
-            minp   = p;
-            minpre = pre;
+            oldest = &entry;
         }
-        pre = p;
-        p   = p->pnext;
-    }
-    minpre->pnext      = minp->pnext;
-    pdhcps_pool->state = DHCPS_STATE_OFFLINE;
-    free(minp->pnode);
-    minp->pnode = nullptr;
-    free(minp);
-    minp = nullptr;
+    }
+    if (oldest)
+    {
+        remove_lease(oldest);
+    }
 }
 
 void DhcpServer::dhcps_coarse_tmr(void)
 {
-    uint8              num_dhcps_pool = 0;
-    list_node*         pback_node     = nullptr;
-    list_node*         pnode          = nullptr;
-    struct dhcps_pool* pdhcps_pool    = nullptr;
-    pnode                             = plist;
-    while (pnode != nullptr)
-    {
-        pdhcps_pool = (struct dhcps_pool*)pnode->pnode;
-        if (pdhcps_pool->type == DHCPS_TYPE_DYNAMIC)
-        {
-            pdhcps_pool->lease_timer--;
-        }
-        if (pdhcps_pool->lease_timer == 0)
+    bool changed = false;
+    for (size_t pos = 0; pos < LeaseTableSize;)
+    {
+        Lease& entry = leases[pos];
+        if (entry.ip.addr != IPADDR_ANY && entry.type == DHCPS_TYPE_DYNAMIC
+            && (uint32_t)(sys_now() - entry.stamp) >= lease_time * 60000)
         {
-            pback_node = pnode;
-            pnode      = pback_node->pnext;
-            node_remove_from_list(&plist, pback_node);
-            free(pback_node->pnode);
-            pback_node->pnode = nullptr;
-            free(pback_node);
-            pback_node = nullptr;
+            // a following lease may be shifted back here, look again
+            remove_lease(&entry);
+            changed = true;
         }
         else
         {
-            pnode = pnode->pnext;
-            num_dhcps_pool++;
+            pos++;
         }
     }
 
-    if (num_dhcps_pool >= MAX_STATION_NUM)
+    if (lease_count >= MAX_STATION_NUM)
     {
         kill_oldest_dhcps_pool();
+        changed = true;
+    }
+    if (changed)
+    {
+        save_leases();
     }
 }
 
 void DhcpServer::dhcps_client_leave(u8* bssid, struct ipv4_addr* ip, bool force)
 {
-    struct dhcps_pool* pdhcps_pool = nullptr;
-    list_node*         pback_node  = nullptr;
-
     if ((bssid == nullptr) || (ip == nullptr))
     {
         return;
     }
 
-    for (pback_node = plist; pback_node != nullptr; pback_node = pback_node->pnext)
+    Lease* entry = find_lease(bssid);
+    if (entry == nullptr || entry->ip.addr != ip->addr)
     {
-        pdhcps_pool = (struct dhcps_pool*)pback_node->pnode;
-        if (memcmp(pdhcps_pool->mac, bssid, sizeof(pdhcps_pool->mac)) == 0)
-        {
-            if (memcmp(&pdhcps_pool->ip.addr, &ip->addr, sizeof(pdhcps_pool->ip.addr)) == 0)
-            {
-                if ((pdhcps_pool->type == DHCPS_TYPE_STATIC) || (force))
-                {
-                    if (pback_node != nullptr)
-                    {
-                        node_remove_from_list(&plist, pback_node);
-                        free(pback_node);
-                        pback_node = nullptr;
-                    }
-
-                    if (pdhcps_pool != nullptr)
-                    {
-                        free(pdhcps_pool);
-                        pdhcps_pool = nullptr;
-                    }
-                }
-                else
-                {
-                    pdhcps_pool->state = DHCPS_STATE_OFFLINE;
-                }
-
-                struct ipv4_addr ip_zero;
-                memset(&ip_zero, 0x0, sizeof(ip_zero));
-                if (_netif->num == SOFTAP_IF)
-                {
-                    wifi_softap_set_station_info(bssid, &ip_zero);
-                }
-                break;
-            }
-        }
+        return;
+    }
+
+    if ((entry->type == DHCPS_TYPE_STATIC) || (force))
+    {
+        remove_lease(entry);
+        save_leases();
+    }
+    else
+    {
+        entry->state = DHCPS_STATE_OFFLINE;
+    }
+
+    struct ipv4_addr ip_zero;
+    memset(&ip_zero, 0x0, sizeof(ip_zero));
+    if (_netif->num == SOFTAP_IF)
+    {
+        wifi_softap_set_station_info(bssid, &ip_zero);
     }
 }
 
 uint32 DhcpServer::dhcps_client_update(u8* bssid, struct ipv4_addr* ip)
 {
-    struct dhcps_pool* pdhcps_pool = nullptr;
-    list_node*         pback_node  = nullptr;
-    list_node*         pmac_node   = nullptr;
-    list_node*         pip_node    = nullptr;
-    bool               flag        = false;
-    uint32             start_ip    = lease.start_ip.addr;
-    uint32             end_ip      = lease.end_ip.addr;
-    dhcps_type_t       type        = DHCPS_TYPE_DYNAMIC;
+    dhcps_type_t type = DHCPS_TYPE_DYNAMIC;
+    known_client      = false;
     if (bssid == nullptr)
     {
         return IPADDR_ANY;
@@ -1210,162 +1285,80 @@ uint32 DhcpServer::dhcps_client_update(u8* bssid, struct ipv4_addr* ip)
     }
 
     renew = false;
-    for (pback_node = plist; pback_node != nullptr; pback_node = pback_node->pnext)
-    {
-        pdhcps_pool = (struct dhcps_pool*)pback_node->pnode;
-        // os_printf("mac:"MACSTR"bssid:"MACSTR"\r\n",MAC2STR(pdhcps_pool->mac),MAC2STR(bssid));
-        if (memcmp(pdhcps_pool->mac, bssid, sizeof(pdhcps_pool->mac)) == 0)
-        {
-            pmac_node = pback_node;
-            if (ip == nullptr)
-            {
-                flag = true;
-                break;
-            }
-        }
-        if (ip != nullptr)
-        {
-            if (memcmp(&pdhcps_pool->ip.addr, &ip->addr, sizeof(pdhcps_pool->ip.addr)) == 0)
-            {
-                pip_node = pback_node;
-            }
-        }
-        else if (flag == false)
-        {
-            if (memcmp(&pdhcps_pool->ip.addr, &start_ip, sizeof(pdhcps_pool->ip.addr)) != 0)
-            {
-                flag = true;
-            }
-            else
-            {
-                start_ip = htonl((ntohl(start_ip) + 1));
-            }
-        }
-    }
 
-    if ((ip == nullptr) && (flag == false))
+    Lease* mac_lease = find_lease(bssid);
+    Lease* ip_lease  = ip ? find_lease_ip(ip->addr) : nullptr;
+    known_client     = mac_lease != nullptr;
+    Lease* entry     = nullptr;
+    // the lease pointers move when a lease is removed
+    const uint32  known_ip   = known_client ? mac_lease->ip.addr : IPADDR_ANY;
+    const uint8_t known_type = known_client ? mac_lease->type : (uint8_t)DHCPS_TYPE_DYNAMIC;
+
+    if (mac_lease != nullptr)  // update new ip
     {
-        if (plist == nullptr)
+        if (ip_lease == mac_lease)
         {
-            if (start_ip <= end_ip)
-            {
-                flag = true;
-            }
-            else
-            {
-                return IPADDR_ANY;
-            }
+            renew = true;
+            type  = DHCPS_TYPE_DYNAMIC;
+            entry = mac_lease;
         }
-        else
+        else if (ip_lease != nullptr)
         {
-            if (start_ip > end_ip)
+            if (ip_lease->state != DHCPS_STATE_OFFLINE)  // ip is used
             {
                 return IPADDR_ANY;
             }
-            // start_ip = htonl((ntohl(start_ip) + 1));
-            flag = true;
-        }
-    }
-
-    if (pmac_node != nullptr)  // update new ip
-    {
-        if (pip_node != nullptr)
-        {
-            pdhcps_pool = (struct dhcps_pool*)pip_node->pnode;
-
-            if (pip_node != pmac_node)
-            {
-                if (pdhcps_pool->state != DHCPS_STATE_OFFLINE)  // ip is used
-                {
-                    return IPADDR_ANY;
-                }
-
-                // mac exists and ip exists in other node,delete mac
-                node_remove_from_list(&plist, pmac_node);
-                free(pmac_node->pnode);
-                pmac_node->pnode = nullptr;
-                free(pmac_node);
-                pmac_node = pip_node;
-                memcpy(pdhcps_pool->mac, bssid, sizeof(pdhcps_pool->mac));
-            }
-            else
-            {
-                renew = true;
-                type  = DHCPS_TYPE_DYNAMIC;
-            }
 
-            pdhcps_pool->lease_timer = this->lease_time;
-            pdhcps_pool->type        = type;
-            pdhcps_pool->state       = DHCPS_STATE_ONLINE;
+            // mac exists and ip exists in other lease, the mac takes that lease
+            uint32 taken = ip_lease->ip.addr;
+            remove_lease(ip_lease);
+            entry          = find_lease(bssid);
+            entry->ip.addr = taken;
         }
         else
         {
-            pdhcps_pool = (struct dhcps_pool*)pmac_node->pnode;
+            entry = mac_lease;
             if (ip != nullptr)
             {
-                pdhcps_pool->ip.addr = ip->addr;
-            }
-            else if (flag == true)
-            {
-                pdhcps_pool->ip.addr = start_ip;
-            }
-            else  // no ip to distribute
-            {
-                return IPADDR_ANY;
+                entry->ip.addr = ip->addr;
             }
-
-            node_remove_from_list(&plist, pmac_node);
-            pdhcps_pool->lease_timer = this->lease_time;
-            pdhcps_pool->type        = type;
-            pdhcps_pool->state       = DHCPS_STATE_ONLINE;
-            node_insert_to_list(&plist, pmac_node);
         }
     }
     else  // new station
     {
-        if (pip_node != nullptr)  // maybe ip has used
+        uint32 addr;
+        if (ip_lease != nullptr)  // maybe ip has used
         {
-            pdhcps_pool = (struct dhcps_pool*)pip_node->pnode;
-            if (pdhcps_pool->state != DHCPS_STATE_OFFLINE)
+            if (ip_lease->state != DHCPS_STATE_OFFLINE)
             {
                 return IPADDR_ANY;
             }
-            memcpy(pdhcps_pool->mac, bssid, sizeof(pdhcps_pool->mac));
-            pdhcps_pool->lease_timer = this->lease_time;
-            pdhcps_pool->type        = type;
-            pdhcps_pool->state       = DHCPS_STATE_ONLINE;
+            addr = ip_lease->ip.addr;
+            remove_lease(ip_lease);
+        }
+        else if (ip != nullptr)
+        {
+            addr = ip->addr;
         }
         else
         {
-            pdhcps_pool = (struct dhcps_pool*)zalloc(sizeof(struct dhcps_pool));
-            if (ip != nullptr)
-            {
-                pdhcps_pool->ip.addr = ip->addr;
-            }
-            else if (flag == true)
-            {
-                pdhcps_pool->ip.addr = start_ip;
-            }
-            else  // no ip to distribute
+            // the address asked for, e.g. by a station which had it before we restarted, is given when free
+            addr = free_lease_ip(requested_address);
+            if (addr == IPADDR_ANY)  // no ip to distribute
             {
-                free(pdhcps_pool);
                 return IPADDR_ANY;
             }
-            if (pdhcps_pool->ip.addr > end_ip)
-            {
-                free(pdhcps_pool);
-                return IPADDR_ANY;
-            }
-            memcpy(pdhcps_pool->mac, bssid, sizeof(pdhcps_pool->mac));
-            pdhcps_pool->lease_timer = this->lease_time;
-            pdhcps_pool->type        = type;
-            pdhcps_pool->state       = DHCPS_STATE_ONLINE;
-            pback_node               = (list_node*)zalloc(sizeof(list_node));
-            pback_node->pnode        = pdhcps_pool;
-            pback_node->pnext        = nullptr;
-            node_insert_to_list(&plist, pback_node);
         }
+        entry = insert_lease(bssid, addr);
+    }
+
+    entry->type  = type;
+    entry->state = DHCPS_STATE_ONLINE;
+    entry->stamp = sys_now();
+    if (!known_client || known_type != type || known_ip != entry->ip.addr)
+    {
+        save_leases();
     }
 
-    return pdhcps_pool->ip.addr;
+    return entry->ip.addr;
 }
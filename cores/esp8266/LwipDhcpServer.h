@@ -43,6 +43,7 @@ class DhcpServer
 {
 public:
     static constexpr int    DefaultLeaseTime = 720;         // minutes
+    static constexpr size_t LeaseTableSize   = 16;          // power of two
     static constexpr uint32 MagicCookie      = 0x63538263;  // https://tools.ietf.org/html/rfc1497
                                                             //
     struct OptionsBuffer
@@ -182,21 +183,41 @@ public:
     bool get_dhcps_lease(struct dhcps_lease* please);
     bool add_dhcps_lease(uint8* macaddr);
 
+    // address leased to the station with this MAC, false when there is none
+    bool get_dhcps_lease_ip(const uint8_t* mac, ip4_addr_t* ip) const;
+
+    // Keep the leases in the RTC user memory from this offset (in 4 byte
+    // blocks, like ESP.rtcUserMemoryWrite(), 136 bytes are used), so that the
+    // stations keep their address over a reset or deep sleep.  They are
+    // restored by begin() while the server address is the same.  -1, the
+    // default, does not keep them.  false when the offset is out of range
+    bool setLeasesRTCOffset(int32_t offset);
+
     void offers();
 
 protected:
     void add_offer_options(OptionsBuffer&);
 
-    // legacy C structure and API to eventually turn into C++
-
-    typedef struct _list_node
+    // leases, found by MAC address
+    struct Lease
     {
-        void*              pnode;
-        struct _list_node* pnext;
-    } list_node;
+        ip4_addr_t ip;  // IPADDR_ANY when the entry is free
+        uint8_t    mac[6];
+        uint8_t    type;   // dhcps_type_t
+        uint8_t    state;  // dhcps_state_t
+        uint32_t   stamp;  // sys_now() of the last update, the oldest is replaced when full
+    };
+
+    static size_t lease_home(const uint8_t* mac);
+    Lease*        find_lease(const uint8_t* mac);
+    Lease*        find_lease_ip(uint32 ip);
+    Lease*        insert_lease(const uint8_t* mac, uint32 ip);
+    void          remove_lease(Lease* lease);
+    uint32        free_lease_ip(uint32 preferred);
+    void          save_leases();
+    void          restore_leases();
 
-    void node_insert_to_list(list_node** phead, list_node* pinsert);
-    void node_remove_from_list(list_node** phead, list_node* pdelete);
+    static uint32 requested_ip(const uint8_t* optptr, sint16_t len);
 
     OptionsBuffer create_msg(struct dhcps_msg* m);
 
@@ -227,8 +248,13 @@ protected:
 
     dhcps_lease lease {};
 
-    list_node* plist = nullptr;
-    bool       renew = false;
+    Lease   leases[LeaseTableSize] {};
+    size_t  lease_count       = 0;
+    int32_t rtc_offset        = -1;
+    uint32  requested_address = 0;      // of the message being answered
+    bool    known_client      = false;  // its station had a lease
+    bool    rapid_commit      = false;  // its ACK answers a DISCOVER
+    bool    renew             = false;
 
     OptionsBufferHandler custom_offer_options = nullptr;
 
@@ -70,6 +70,11 @@ public:
 
     static bool stateUpCB(LwipIntf::CBType);
     static bool stateDownCB(LwipIntf::CBType);
+
+    // netif status changes so far, which caches of the addresses compare
+    // (see addrCache), counted by netifs with their own status callback too
+    static uint32_t statusChangeCount();
+    static void     countStatusChange();
 };
 
 #endif  // _LWIPINTF_H
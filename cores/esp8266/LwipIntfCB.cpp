@@ -28,11 +28,13 @@
 static constexpr size_t LwipIntfCallbacks = 3;
 
 static LwipIntf::CBType callbacks[LwipIntfCallbacks];
-static size_t           size = 0;
+static size_t           size          = 0;
+static uint32_t         statusChanges = 0;
 
 // override empty weak function from glue-lwip
 extern "C" void netif_status_changed(struct netif* netif)
 {
+    ++statusChanges;
     for (size_t index = 0; index < size; ++index)
     {
         callbacks[index](netif);
@@ -53,6 +55,16 @@ bool LwipIntf::statusChangeCB(LwipIntf::CBType cb)
     return false;
 }
 
+uint32_t LwipIntf::statusChangeCount()
+{
+    return statusChanges;
+}
+
+void LwipIntf::countStatusChange()
+{
+    ++statusChanges;
+}
+
 bool LwipIntf::stateUpCB(LwipIntf::CBType cb)
 {
     return statusChangeCB(
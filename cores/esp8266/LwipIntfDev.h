@@ -24,9 +24,6 @@
 #ifndef _LWIPINTFDEV_H
 #define _LWIPINTFDEV_H
 
-// TODO:
-// unchain pbufs
-
 #include <netif/ethernet.h>
 #include <lwip/init.h>
 #include <lwip/netif.h>
@@ -46,6 +43,13 @@
 #define DEFAULT_MTU 1500
 #endif
 
+// With an interrupt pin, frames are read on the next yield() or loop()
+// after the interrupt, and the device is also polled at this period in case
+// an interrupt was missed.  Without, the device is polled every 100us.
+#ifndef LWIPINTFDEV_INTR_POLL_MS
+#define LWIPINTFDEV_INTR_POLL_MS 100
+#endif
+
 enum EthernetLinkStatus
 {
     Unknown,
@@ -53,14 +57,36 @@ enum EthernetLinkStatus
     LinkOFF
 };
 
+// Counters since begin() or resetStats().  Cycles are CPU cycles spent
+// talking to the device, mostly over SPI: rxCycles / rxFrames is the cost of
+// reading a frame.
+struct EthernetStats
+{
+    uint32_t rxFrames;
+    uint64_t rxBytes;
+    uint32_t rxDropped;   // no memory for the frame, left in the device
+    uint32_t rxErrors;    // short read, or refused by lwIP
+    uint64_t rxCycles;
+    uint32_t txFrames;
+    uint64_t txBytes;
+    uint32_t txErrors;
+    uint64_t txCycles;
+    uint32_t polls;       // reads of the frames, polled or on interrupt
+    uint32_t idlePolls;   // which found none
+    uint64_t idleCycles;  // spent on them
+    uint32_t interrupts;
+};
+
 template<class RawDev>
 class LwipIntfDev: public LwipIntf, public RawDev
 {
 public:
     LwipIntfDev(int8_t cs = SS, SPIClass& spi = SPI, int8_t intr = -1) :
-        RawDev(cs, spi, intr), _mtu(DEFAULT_MTU), _intrPin(intr), _started(false), _default(false)
+        RawDev(cs, spi, intr), _mtu(DEFAULT_MTU), _intrPin(intr), _started(false), _default(false),
+        _intrPending(false)
     {
         memset(&_netif, 0, sizeof(_netif));
+        resetStats();
     }
 
     boolean config(const IPAddress& local_ip, const IPAddress& arg1, const IPAddress& arg2,
@@ -118,6 +144,16 @@ public:
     // Arduino Ethernet compatibility
     EthernetLinkStatus linkStatus();
 
+    const EthernetStats& stats() const
+    {
+        return _stats;
+    }
+
+    void resetStats()
+    {
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
 protected:
     err_t netif_init();
     void  check_route();
@@ -127,7 +163,11 @@ protected:
     static err_t linkoutput_s(netif* netif, struct pbuf* p);
     static void  netif_status_callback_s(netif* netif);
 
-    // called on a regular basis or on interrupt
+    bool attachIntr();
+    static void intr_s(void* arg);
+
+    // called on a regular basis or on interrupt,
+    // ERR_INPROGRESS when it stopped before reading all frames
     err_t handlePackets();
 
     // members
@@ -139,6 +179,10 @@ protected:
     uint8_t  _macAddress[6];
     bool     _started;
     bool     _default;
+
+    volatile bool _intrPending;
+
+    EthernetStats _stats;
 };
 
 template<class RawDev>
@@ -257,29 +301,48 @@ boolean LwipIntfDev<RawDev>::begin(const uint8_t* macAddress, const uint16_t mtu
     }
 
     _started = true;
+    resetStats();
 
-    if (_intrPin >= 0)
+    if (_intrPin >= 0 && !attachIntr())
     {
-        if (RawDev::interruptIsPossible())
-        {
-            // attachInterrupt(_intrPin, [&]() { this->handlePackets(); }, FALLING);
-        }
-        else
-        {
-            ::printf((PGM_P)F(
-                "lwIP_Intf: Interrupt not implemented yet, enabling transparent polling\r\n"));
-            _intrPin = -1;
-        }
+        // an INT pin was given to a driver which cannot raise interrupts
+        ::printf((PGM_P)F("lwIP_Intf: driver has no interrupt, INT pin unused, polling\r\n"));
+        _intrPin = -1;
     }
 
-    if (_intrPin < 0
-        && !schedule_recurrent_function_us(
-            [&]()
+    // The interrupt only raises a flag, the alarm of the recurrent function,
+    // so that any number of them lead to one read of the frames, from CONT
+    bool scheduled;
+    if (_intrPin >= 0)
+    {
+        scheduled = schedule_recurrent_function_us(
+            [this]()
+            {
+                _intrPending = false;
+                if constexpr (RawDev::interruptIsPossible())
+                {
+                    RawDev::interruptAcknowledge();
+                }
+                if (this->handlePackets() == ERR_INPROGRESS)
+                {
+                    // more frames than one call reads, without new interrupt
+                    _intrPending = true;
+                }
+                return true;
+            },
+            LWIPINTFDEV_INTR_POLL_MS * 1000, [this]() { return _intrPending; });
+    }
+    else
+    {
+        scheduled = schedule_recurrent_function_us(
+            [this]()
             {
                 this->handlePackets();
                 return true;
             },
-            100))
+            100);
+    }
+    if (!scheduled)
     {
         netif_remove(&_netif);
         return false;
@@ -288,6 +351,27 @@ boolean LwipIntfDev<RawDev>::begin(const uint8_t* macAddress, const uint16_t mtu
     return true;
 }
 
+template<class RawDev>
+bool LwipIntfDev<RawDev>::attachIntr()
+{
+    if constexpr (RawDev::interruptIsPossible())
+    {
+        RawDev::interruptEnable();
+        pinMode(_intrPin, INPUT);
+        attachInterruptArg(_intrPin, intr_s, this, FALLING);
+        return true;
+    }
+    return false;
+}
+
+template<class RawDev>
+void IRAM_ATTR LwipIntfDev<RawDev>::intr_s(void* arg)
+{
+    auto ths = static_cast<LwipIntfDev*>(arg);
+    ths->_intrPending = true;
+    ths->_stats.interrupts++;
+}
+
 template<class RawDev>
 wl_status_t LwipIntfDev<RawDev>::status()
 {
@@ -305,22 +389,38 @@ err_t LwipIntfDev<RawDev>::linkoutput_s(netif* netif, struct pbuf* pbuf)
 {
     LwipIntfDev* ths = (LwipIntfDev*)netif->state;
 
-    if (pbuf->len != pbuf->tot_len || pbuf->next)
+    // a chain is written part by part into the device's buffer,
+    // without copying it into one piece first
+    uint32_t start = esp_get_cycle_count();
+    uint16_t len = 0;
+    if (ths->sendFrameBegin(pbuf->tot_len))
+    {
+        for (struct pbuf* q = pbuf; q; q = q->next)
+        {
+            ths->sendFrameData((const uint8_t*)q->payload, q->len);
+        }
+        len = ths->sendFrameEnd();
+    }
+    ths->_stats.txCycles += esp_get_cycle_count() - start;
+    if (len == pbuf->tot_len)
     {
-        Serial.println("ERRTOT\r\n");
+        ths->_stats.txFrames++;
+        ths->_stats.txBytes += len;
+    }
+    else
+    {
+        ths->_stats.txErrors++;
     }
-
-    uint16_t len = ths->sendFrame((const uint8_t*)pbuf->payload, pbuf->len);
 
 #if PHY_HAS_CAPTURE
     if (phy_capture)
     {
         phy_capture(ths->_netif.num, (const char*)pbuf->payload, pbuf->len, /*out*/ 1,
-                    /*success*/ len == pbuf->len);
+                    /*success*/ len == pbuf->tot_len);
     }
 #endif
 
-    return len == pbuf->len ? ERR_OK : ERR_MEM;
+    return len == pbuf->tot_len ? ERR_OK : ERR_MEM;
 }
 
 template<class RawDev>
@@ -361,6 +461,7 @@ err_t LwipIntfDev<RawDev>::netif_init()
 template<class RawDev>
 void LwipIntfDev<RawDev>::netif_status_callback()
 {
+    LwipIntf::countStatusChange();
     check_route();
     if (connected())
     {
@@ -390,18 +491,25 @@ void LwipIntfDev<RawDev>::check_route()
 template<class RawDev>
 err_t LwipIntfDev<RawDev>::handlePackets()
 {
+    _stats.polls++;
     int pkt = 0;
     while (1)
     {
         if (++pkt == 10)
         // prevent starvation
         {
-            return ERR_OK;
+            return ERR_INPROGRESS;
         }
 
+        uint32_t start = esp_get_cycle_count();
         uint16_t tot_len = RawDev::readFrameSize();
         if (!tot_len)
         {
+            if (pkt == 1)
+            {
+                _stats.idlePolls++;
+                _stats.idleCycles += esp_get_cycle_count() - start;
+            }
             return ERR_OK;
         }
 
@@ -421,10 +529,13 @@ err_t LwipIntfDev<RawDev>::handlePackets()
                 pbuf_free(pbuf);
             }
             RawDev::discardFrame(tot_len);
+            _stats.rxDropped++;
+            _stats.rxCycles += esp_get_cycle_count() - start;
             return ERR_BUF;
         }
 
         uint16_t len = RawDev::readFrameData((uint8_t*)pbuf->payload, tot_len);
+        _stats.rxCycles += esp_get_cycle_count() - start;
         if (len != tot_len)
         {
             // tot_len is given by readFrameSize()
@@ -432,6 +543,7 @@ err_t LwipIntfDev<RawDev>::handlePackets()
             // todo: ensure this test is unneeded, remove the print
             Serial.println("read error?\r\n");
             pbuf_free(pbuf);
+            _stats.rxErrors++;
             return ERR_BUF;
         }
 
@@ -448,9 +560,12 @@ err_t LwipIntfDev<RawDev>::handlePackets()
         if (err != ERR_OK)
         {
             pbuf_free(pbuf);
+            _stats.rxErrors++;
             return err;
         }
         // (else) allocated pbuf is now lwIP's responsibility
+        _stats.rxFrames++;
+        _stats.rxBytes += tot_len;
     }
 }
 
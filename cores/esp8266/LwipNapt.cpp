@@ -0,0 +1,352 @@
+/*
+  LwipNapt.cpp
+
+  Arduino interface for the lwIP NAPT (IPv4 network address and port translation)
+
+  Original Copyright (c) 2020 esp8266 Arduino All rights reserved.
+  This file is part of the esp8266 Arduino core environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "LwipNapt.h"
+
+#if IP_FORWARD && IP_NAPT
+
+extern "C"
+{
+#include "lwip/netif.h"
+#include "lwip/prot/ethernet.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/ip.h"
+#include "lwip/prot/tcp.h"
+}
+
+#include <memory>
+#include <new>
+
+#include <Arduino.h>
+#include "debug.h"
+
+extern netif netif_git[2];
+
+// The translation itself is done in liblwip2 (ip4_forward() and the NAPT
+// table are not reachable from here), the flows are mirrored in a small table
+// fed by phy_capture, the tap every frame of the WiFi netifs goes through.
+// Its slots only hold a hash of the flow and the time it was last seen, and
+// expire with the same timeouts as the lwIP table.
+
+namespace
+{
+
+// low bits of the key, 0 is a free slot
+enum FlowClass : uint32_t
+{
+    FlowTCP     = 1,
+    FlowTCPDone = 2,  // FIN or RST seen
+    FlowOther   = 3,  // UDP, ICMP
+};
+
+struct Flow
+{
+    uint32_t key;
+    uint32_t lastMs;
+};
+
+constexpr uint16_t probeWindow = 8;
+
+struct NaptState
+{
+    uint16_t size = 0;
+    uint16_t portmaps = 0;
+    uint16_t last = 0;  // slot of the last forwarded packet, bulk transfers keep hitting it
+    bool chained = false;
+    uint8_t netifIdx = SOFTAP_IF;
+    void (*capture)(int netif_idx, const char* data, size_t len, int out, int success) = nullptr;
+    std::unique_ptr<Flow[]> flows;
+    LwipNapt::Stats stats { };
+};
+
+NaptState napt;
+
+}  // anonymous namespace
+
+static uint32_t _napt_timeout(uint32_t key)
+{
+    switch (key & 3)
+    {
+    case FlowTCP:
+        return IP_NAPT_TIMEOUT_MS_TCP;
+    case FlowTCPDone:
+        return IP_NAPT_TIMEOUT_MS_TCP_DISCON;
+    default:
+        return IP_NAPT_TIMEOUT_MS_UDP;
+    }
+}
+
+static bool _napt_expired(const Flow& flow, uint32_t now)
+{
+    return flow.key == 0 || now - flow.lastMs > _napt_timeout(flow.key);
+}
+
+// the tuple is always given from the client side
+static uint32_t _napt_hash(uint32_t client, uint32_t remote, uint32_t ports, uint8_t proto)
+{
+    uint32_t hash = 2166136261u;
+    for (uint32_t word : { client, remote, ports, (uint32_t)proto })
+    {
+        hash = (hash ^ word) * 16777619u;
+    }
+    return hash ^ (hash >> 15);
+}
+
+static void _napt_track(uint32_t hash, uint32_t flowClass, bool forward)
+{
+    Flow*    flows = napt.flows.get();
+    uint32_t now   = millis();
+    uint16_t home  = hash % napt.size;
+    uint32_t key   = (hash & ~3u) | flowClass;
+
+    Flow* found = nullptr;
+    if (((flows[napt.last].key ^ hash) & ~3u) == 0 && flows[napt.last].key)
+    {
+        found = &flows[napt.last];
+    }
+    else
+    {
+        for (uint16_t i = 0, slot = home; i < probeWindow && i < napt.size;
+             i++, slot = slot + 1 == napt.size ? 0 : slot + 1)
+        {
+            if (flows[slot].key && ((flows[slot].key ^ hash) & ~3u) == 0)
+            {
+                found = &flows[slot];
+                break;
+            }
+        }
+    }
+
+    if (found)
+    {
+        if (_napt_expired(*found, now))
+        {
+            // lwIP dropped it too, this is a new translation
+            if (forward)
+            {
+                napt.stats.misses++;
+            }
+        }
+        else if (forward)
+        {
+            napt.stats.hits++;
+        }
+        // a closed TCP flow stays closed until it times out
+        if ((found->key & 3) != FlowTCPDone || _napt_expired(*found, now))
+        {
+            found->key = key;
+        }
+        found->lastMs = now;
+        napt.last     = found - flows;
+        return;
+    }
+
+    // replies to unknown flows are not translated
+    if (!forward)
+    {
+        return;
+    }
+    napt.stats.misses++;
+
+    Flow* slot = nullptr;
+    for (uint16_t i = 0, s = home; i < probeWindow && i < napt.size;
+         i++, s = s + 1 == napt.size ? 0 : s + 1)
+    {
+        if (_napt_expired(flows[s], now))
+        {
+            slot = &flows[s];
+            break;
+        }
+        if (!slot || now - flows[s].lastMs > now - slot->lastMs)
+        {
+            slot = &flows[s];
+        }
+    }
+    if (!_napt_expired(*slot, now))
+    {
+        napt.stats.evictions++;
+    }
+    slot->key    = key;
+    slot->lastMs = now;
+    napt.last    = slot - flows;
+}
+
+static void _napt_capture(int netif_idx, const char* data, size_t len, int out, int success)
+{
+    if (napt.size && netif_idx == napt.netifIdx && (!out || success)
+        && len >= SIZEOF_ETH_HDR + IP_HLEN)
+    {
+        auto* eth = reinterpret_cast<const eth_hdr*>(data);
+        auto* ip  = reinterpret_cast<const ip_hdr*>(data + SIZEOF_ETH_HDR);
+        size_t ihl = IPH_HL_BYTES(ip);
+        const netif& clients = netif_git[napt.netifIdx];
+
+        if (eth->type == PP_HTONS(ETHTYPE_IP) && IPH_V(ip) == 4 && ihl >= IP_HLEN
+            && len >= SIZEOF_ETH_HDR + ihl + 8)
+        {
+            uint32_t src  = ip->src.addr;
+            uint32_t dest = ip->dest.addr;
+            // remote side of the flow: not on the clients network, nor broadcast or multicast
+            uint32_t remote = out ? src : dest;
+            uint32_t mask   = ip4_addr_get_u32(netif_ip4_netmask(&clients));
+            uint32_t local  = ip4_addr_get_u32(netif_ip4_addr(&clients));
+            if ((remote & mask) != (local & mask) && remote != IPADDR_BROADCAST
+                && !ip4_addr_ismulticast(reinterpret_cast<const ip4_addr_t*>(&remote)))
+            {
+                const uint8_t* l4 = reinterpret_cast<const uint8_t*>(ip) + ihl;
+                uint32_t ports = 0;
+                uint32_t flowClass = FlowOther;
+                switch (IPH_PROTO(ip))
+                {
+                case IP_PROTO_TCP:
+                    flowClass = (l4[13] & (TCP_FIN | TCP_RST)) ? FlowTCPDone : FlowTCP;
+                    // fall through
+                case IP_PROTO_UDP:
+                    // client port first
+                    memcpy(&ports, l4 + (out ? 2 : 0), 2);
+                    memcpy(reinterpret_cast<uint8_t*>(&ports) + 2, l4 + (out ? 0 : 2), 2);
+                    break;
+                case IP_PROTO_ICMP:
+                    memcpy(&ports, l4 + 4, 2);  // echo identifier
+                    break;
+                default:
+                    break;
+                }
+
+                if (out)
+                {
+                    napt.stats.returned++;
+                    _napt_track(_napt_hash(dest, src, ports, IPH_PROTO(ip)), flowClass, false);
+                }
+                else
+                {
+                    napt.stats.forwarded++;
+                    _napt_track(_napt_hash(src, dest, ports, IPH_PROTO(ip)), flowClass, true);
+                }
+            }
+        }
+    }
+    if (napt.capture)
+    {
+        napt.capture(netif_idx, data, len, out, success);
+    }
+}
+
+bool LwipNapt::begin(uint16_t entries, uint8_t portmaps, uint8_t netifIdx, size_t reserveHeap)
+{
+    if (netifIdx >= 2)
+    {
+        return false;
+    }
+
+    if (!napt.size)
+    {
+        constexpr size_t entrySize = sizeof(napt_table) + sizeof(Flow);
+        if (!entries)
+        {
+            size_t heap     = ESP.getFreeHeap();
+            size_t portHeap = portmaps * sizeof(portmap_table);
+            size_t fit = heap > reserveHeap + portHeap ? (heap - reserveHeap - portHeap) / entrySize : 0;
+            entries    = fit > 0xfffe ? 0xfffe : fit;
+        }
+        if (entries < probeWindow)
+        {
+            DEBUGV(":napt not enough heap for the table (%u entries)\n", entries);
+            return false;
+        }
+
+        napt.flows.reset(new (std::nothrow) Flow[entries]());
+        if (!napt.flows)
+        {
+            return false;
+        }
+        if (ip_napt_init(entries, portmaps) != ERR_OK)
+        {
+            napt.flows.reset();
+            return false;
+        }
+        napt.size     = entries;
+        napt.portmaps = portmaps;
+        DEBUGV(":napt %u entries %u portmaps\n", entries, portmaps);
+    }
+    else if (entries > napt.size || portmaps > napt.portmaps)
+    {
+        return false;
+    }
+
+    if (ip_napt_enable_no(netifIdx, 1) != ERR_OK)
+    {
+        return false;
+    }
+
+    napt.netifIdx = netifIdx;
+    if (!napt.chained)
+    {
+        napt.capture = phy_capture;
+        phy_capture  = _napt_capture;
+        napt.chained = true;
+    }
+    return true;
+}
+
+void LwipNapt::end(uint8_t netifIdx)
+{
+    if (napt.size && netifIdx < 2)
+    {
+        ip_napt_enable_no(netifIdx, 0);
+    }
+    // when another capture was chained after ours, ours stays in the chain
+    if (napt.netifIdx == netifIdx && phy_capture == _napt_capture)
+    {
+        phy_capture  = napt.capture;
+        napt.chained = false;
+    }
+}
+
+uint16_t LwipNapt::size()
+{
+    return napt.size;
+}
+
+LwipNapt::Stats LwipNapt::stats()
+{
+    Stats ret       = napt.stats;
+    ret.tableSize   = napt.size;
+    ret.activeFlows = 0;
+    uint32_t now    = millis();
+    for (uint16_t i = 0; i < napt.size; i++)
+    {
+        if (!_napt_expired(napt.flows[i], now))
+        {
+            ret.activeFlows++;
+        }
+    }
+    return ret;
+}
+
+void LwipNapt::resetStats()
+{
+    napt.stats = { };
+}
+
+#endif  // IP_FORWARD && IP_NAPT
@@ -0,0 +1,66 @@
+/*
+  LwipNapt.h
+
+  Arduino interface for the lwIP NAPT (IPv4 network address and port translation)
+
+  Original Copyright (c) 2020 esp8266 Arduino All rights reserved.
+  This file is part of the esp8266 Arduino core environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef _LWIPNAPT_H
+#define _LWIPNAPT_H
+
+#include <lwip/opt.h>
+#include <lwip/napt.h>
+#include <user_interface.h>  // SOFTAP_IF
+
+#if IP_FORWARD && IP_NAPT
+
+class LwipNapt
+{
+public:
+    struct Stats
+    {
+        uint32_t forwarded;    // packets from the clients to the other networks
+        uint32_t returned;     // packets from the other networks to the clients
+        uint32_t hits;         // forwarded packets of an already known flow
+        uint32_t misses;       // forwarded packets starting a new flow
+        uint32_t evictions;    // flows dropped before their timeout to make room for new ones
+        uint16_t activeFlows;  // flows not timed out yet
+        uint16_t tableSize;    // flows the table can hold
+    };
+
+    // Sizes the translation table and enables NAPT on the netif of the clients.
+    // entries = 0 sizes it from the free heap, keeping reserveHeap bytes for the
+    // sketch (each entry takes 32 bytes).
+    // lwIP allocates the table once: later calls only enable the netif, and fail
+    // when asking for a larger table.
+    static bool begin(uint16_t entries = 0, uint8_t portmaps = IP_PORTMAP_MAX,
+                      uint8_t netifIdx = SOFTAP_IF, size_t reserveHeap = 16384);
+    static void end(uint8_t netifIdx = SOFTAP_IF);
+
+    static uint16_t size();
+
+    // Counters of the flows lwIP translates, tracked from the frames of
+    // the clients netif
+    static Stats stats();
+    static void  resetStats();
+};
+
+#endif  // IP_FORWARD && IP_NAPT
+
+#endif  // _LWIPNAPT_H
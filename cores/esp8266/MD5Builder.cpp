@@ -1,5 +1,6 @@
 #include <Arduino.h>
 #include <MD5Builder.h>
+#include <TypeConversion.h>
 #include <memory>
 
 uint8_t hex_char_to_byte(uint8_t c) {
@@ -18,22 +19,38 @@ void MD5Builder::add(const uint8_t * data, const uint16_t len){
 }
 
 void MD5Builder::addHexString(const char * data){
-    uint16_t i, len = strlen(data);
-    auto tmp = std::unique_ptr<uint8_t[]>{new(std::nothrow) uint8_t[len / 2]};
-
-    if (!tmp) {
-        return;
-    }
-
-    for(i=0; i<len; i+=2) {
-        uint8_t high = hex_char_to_byte(data[i]);
-        uint8_t low = hex_char_to_byte(data[i+1]);
-        tmp[i/2] = (high & 0x0F) << 4 | (low & 0x0F);
+    // converted and hashed a block at a time on the stack
+    uint8_t tmp[32];
+    size_t len = strlen(data) & ~1;
+    for (size_t pos = 0; pos < len; pos += 2 * sizeof(tmp)) {
+        size_t chars = std::min(len - pos, 2 * sizeof(tmp));
+        if (experimental::TypeConversion::hexBufferToUint8Array(data + pos, chars, tmp) < 0) {
+            // not only HEX digits, the others count as 0
+            for (size_t i = 0; i < chars; i += 2) {
+                uint8_t high = hex_char_to_byte(data[pos + i]);
+                uint8_t low = hex_char_to_byte(data[pos + i + 1]);
+                tmp[i/2] = (high & 0x0F) << 4 | (low & 0x0F);
+            }
+        }
+        add(tmp, chars / 2);
     }
-    add(tmp.get(), len/2);
 }
 
 bool MD5Builder::addStream(Stream &stream, const size_t maxLen) {
+    if (stream.hasPeekBufferAPI()) {
+        // hash the stream's own buffer, no copy
+        size_t maxLengthLeft = maxLen;
+        size_t avail;
+        while (maxLengthLeft && (avail = stream.peekAvailable())) {
+            uint16_t readBytes = std::min({avail, maxLengthLeft, (size_t)0x8000});
+            MD5Update(&_ctx, (const uint8_t*)stream.peekBuffer(), readBytes);
+            stream.peekConsume(readBytes);
+            maxLengthLeft -= readBytes;
+            yield();      // time for network streams
+        }
+        return true;
+    }
+
     const int buf_size = 512;
     int maxLengthLeft = maxLen;
 
@@ -83,9 +100,7 @@ void MD5Builder::getBytes(uint8_t * output) const {
 }
 
 void MD5Builder::getChars(char * output) const {
-    for (uint8_t i=0; i<16; i++){
-        sprintf(output + (i * 2), "%02x", _buf[i]);
-    }
+    *experimental::TypeConversion::uint8ArrayToHexBuffer(_buf, sizeof(_buf), output, true) = 0;
 }
 
 String MD5Builder::toString(void) const {
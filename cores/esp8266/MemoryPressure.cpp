@@ -0,0 +1,103 @@
+/*
+ MemoryPressure.cpp - heap levels published to the libraries
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <Arduino.h>
+#include <Schedule.h>
+#include "MemoryPressure.h"
+
+MemoryPressureClass MemoryPressure;
+
+bool MemoryPressureClass::begin(uint32_t critical, uint32_t buffer, uint32_t minBlock, uint32_t periodMs)
+{
+    _critical = critical;
+    _buffer = buffer;
+    _minBlock = minBlock;
+    if (_enabled)
+        return true;
+
+    // a function left from before end() stops on its next call
+    uint16_t generation = ++_generation;
+    if (!schedule_recurrent_function_us([this, generation]()
+        {
+            if (!_enabled || generation != _generation)
+                return false;
+            update();
+            return true;
+        }, periodMs * 1000))
+        return false;
+
+    _enabled = true;
+    _minFree = UINT32_MAX;
+    _changes = 0;
+    update();
+    return true;
+}
+
+void MemoryPressureClass::end()
+{
+    _enabled = false;
+    _level = HeapLevel::Nominal;
+    _maxBlock = UINT32_MAX;
+}
+
+HeapLevel MemoryPressureClass::_levelOf(uint32_t free, uint32_t maxBlock) const
+{
+    if (free <= _critical)
+        return HeapLevel::Critical;
+    if (free <= _critical + _buffer || maxBlock < _minBlock)
+        return HeapLevel::Limited;
+    return HeapLevel::Nominal;
+}
+
+HeapLevel MemoryPressureClass::level() const
+{
+    if (!_enabled)
+        return HeapLevel::Nominal;
+    return _levelOf(ESP.getFreeHeap(), _maxBlock);
+}
+
+HeapLevel MemoryPressureClass::update()
+{
+    if (!_enabled)
+        return HeapLevel::Nominal;
+
+    ESP.getHeapStats(&_free, &_maxBlock, &_fragmentation);
+    if (_free < _minFree)
+        _minFree = _free;
+
+    HeapLevel level = _levelOf(_free, _maxBlock);
+    if (level != _level)
+    {
+        _level = level;
+        ++_changes;
+        for (size_t i = 0; i < _callbackCount; ++i)
+            _callbacks[i](level);
+    }
+    return level;
+}
+
+bool MemoryPressureClass::onChange(Callback cb)
+{
+    if (_callbackCount >= MEMORY_PRESSURE_CB_MAX)
+        return false;
+    _callbacks[_callbackCount++] = std::move(cb);
+    return true;
+}
@@ -0,0 +1,156 @@
+/*
+ MemoryPressure.h - heap levels published to the libraries
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __MEMORYPRESSURE_H
+#define __MEMORYPRESSURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+
+// Once MemoryPressure.begin() is called, the heap is sampled from the
+// scheduler and its level is known to the libraries, which then shed load
+// before an allocation fails:
+//
+//    Limited    free heap below critical + buffer, or largest free block
+//               below minBlock (fragmentation)
+//    Critical   free heap below critical
+//
+// While not Nominal, UdpContext queues fewer datagrams, ESP8266WebServer
+// serves fewer connections at once, WiFiClientSecure uses its smallest
+// buffers and ESP8266WiFiMesh clears its logs, as when below its own
+// thresholds.  Without begin(), the level is always Nominal.
+//
+//    MemoryPressure.begin();
+//    MemoryPressure.onChange([](HeapLevel level) {
+//        if (level == HeapLevel::Critical) ... // drop caches
+//    });
+
+#ifndef MEMORY_PRESSURE_CRITICAL
+#define MEMORY_PRESSURE_CRITICAL 6000
+#endif
+#ifndef MEMORY_PRESSURE_BUFFER
+#define MEMORY_PRESSURE_BUFFER 6000
+#endif
+#ifndef MEMORY_PRESSURE_MIN_BLOCK
+#define MEMORY_PRESSURE_MIN_BLOCK 2048
+#endif
+#ifndef MEMORY_PRESSURE_PERIOD_MS
+#define MEMORY_PRESSURE_PERIOD_MS 250
+#endif
+#ifndef MEMORY_PRESSURE_CB_MAX
+#define MEMORY_PRESSURE_CB_MAX 4
+#endif
+
+enum class HeapLevel : uint8_t
+{
+    Nominal,
+    Limited,
+    Critical
+};
+
+class MemoryPressureClass
+{
+public:
+    using Callback = std::function<void(HeapLevel level)>;
+
+    // thresholds in bytes, the largest free block is sampled every periodMs
+    // (as for ESP.getHeapStats(), the whole heap is walked); when already
+    // running, only the thresholds are changed
+    bool begin(uint32_t critical = MEMORY_PRESSURE_CRITICAL, uint32_t buffer = MEMORY_PRESSURE_BUFFER,
+               uint32_t minBlock = MEMORY_PRESSURE_MIN_BLOCK, uint32_t periodMs = MEMORY_PRESSURE_PERIOD_MS);
+    void end();
+    bool enabled() const
+    {
+        return _enabled;
+    }
+
+    // free heap now and largest block as last sampled, Nominal when not
+    // running; cheap, also from SYS context (lwIP callbacks)
+    HeapLevel level() const;
+    // samples the heap now, calling the subscribers on a level change
+    HeapLevel update();
+
+    // a count for the level: all of it when Nominal, half when Limited,
+    // at most one when Critical
+    template<typename T>
+    T scale(T nominal) const
+    {
+        switch (level())
+        {
+        case HeapLevel::Nominal:
+            return nominal;
+        case HeapLevel::Limited:
+            return nominal - nominal / 2;
+        default:
+            return nominal < 1 ? nominal : 1;
+        }
+    }
+
+    // as of the last sample
+    uint32_t freeHeap() const
+    {
+        return _free;
+    }
+    uint32_t maxFreeBlock() const
+    {
+        return _maxBlock;
+    }
+    uint8_t fragmentation() const
+    {
+        return _fragmentation;
+    }
+    // lowest sampled since begin()
+    uint32_t minFreeHeap() const
+    {
+        return _minFree;
+    }
+    // level changes since begin()
+    uint32_t changes() const
+    {
+        return _changes;
+    }
+
+    // called from the scheduler (CONT stack, as recurrent functions) when the
+    // level changes; false when MEMORY_PRESSURE_CB_MAX are already set
+    bool onChange(Callback cb);
+
+protected:
+    HeapLevel _levelOf(uint32_t free, uint32_t maxBlock) const;
+
+    Callback _callbacks[MEMORY_PRESSURE_CB_MAX];
+    size_t _callbackCount = 0;
+    uint32_t _critical = MEMORY_PRESSURE_CRITICAL;
+    uint32_t _buffer = MEMORY_PRESSURE_BUFFER;
+    uint32_t _minBlock = MEMORY_PRESSURE_MIN_BLOCK;
+    uint32_t _free = 0;
+    uint32_t _maxBlock = UINT32_MAX;
+    uint32_t _minFree = UINT32_MAX;
+    uint32_t _changes = 0;
+    uint16_t _generation = 0;    // of the sampling function
+    uint8_t _fragmentation = 0;
+    HeapLevel _level = HeapLevel::Nominal;
+    bool _enabled = false;
+};
+
+extern MemoryPressureClass MemoryPressure;
+
+#endif // __MEMORYPRESSURE_H
@@ -0,0 +1,177 @@
+/*
+ MovableBuffer.cpp - heap buffers that may be relocated by compaction
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdlib.h>
+#include <utility>
+
+#include "MovableBuffer.h"
+#include "umm_malloc/umm_malloc.h"
+
+namespace esp8266
+{
+
+MovableBuffer* MovableBuffer::_first = nullptr;
+size_t MovableBuffer::_count = 0;
+
+MovableBuffer::MovableBuffer(size_t size)
+{
+    resize(size);
+}
+
+MovableBuffer::~MovableBuffer()
+{
+    release();
+}
+
+MovableBuffer::MovableBuffer(MovableBuffer&& other)
+{
+    *this = std::move(other);
+}
+
+MovableBuffer& MovableBuffer::operator=(MovableBuffer&& other)
+{
+    if (this != &other)
+    {
+        release();
+        if (other._ptr)
+        {
+            _ptr = other._ptr;
+            _size = other._size;
+            _pins = other._pins;
+            other.unlink();
+            other._ptr = nullptr;
+            other._size = 0;
+            other._pins = 0;
+            link();
+        }
+    }
+    return *this;
+}
+
+bool MovableBuffer::resize(size_t size)
+{
+    if (!size)
+    {
+        release();
+        return true;
+    }
+
+    uint8_t* ptr = static_cast<uint8_t*>(realloc(_ptr, size));
+    if (!ptr)
+    {
+        return false;
+    }
+
+    if (!_ptr)
+    {
+        link();
+    }
+    _ptr = ptr;
+    _size = size;
+    return true;
+}
+
+void MovableBuffer::release()
+{
+    if (_ptr)
+    {
+        unlink();
+        free(_ptr);
+        _ptr = nullptr;
+        _size = 0;
+    }
+}
+
+void MovableBuffer::link()
+{
+    _prev = nullptr;
+    _next = _first;
+    if (_first)
+    {
+        _first->_prev = this;
+    }
+    _first = this;
+    ++_count;
+}
+
+void MovableBuffer::unlink()
+{
+    if (_prev)
+    {
+        _prev->_next = _next;
+    }
+    else
+    {
+        _first = _next;
+    }
+    if (_next)
+    {
+        _next->_prev = _prev;
+    }
+    _prev = _next = nullptr;
+    --_count;
+}
+
+size_t MovableBuffer::compact()
+{
+    size_t moved = 0;
+    uintptr_t last = 0;
+
+    // Visit the buffers in ascending address order, so each one can drop into
+    // the space freed by those below it. A buffer that moves lands below
+    // `last` and is not visited twice.
+    for (;;)
+    {
+        MovableBuffer* next = nullptr;
+        for (MovableBuffer* b = _first; b; b = b->_next)
+        {
+            uintptr_t addr = reinterpret_cast<uintptr_t>(b->_ptr);
+            if (addr > last && (!next || addr < reinterpret_cast<uintptr_t>(next->_ptr)))
+            {
+                next = b;
+            }
+        }
+        if (!next)
+        {
+            break;
+        }
+
+        last = reinterpret_cast<uintptr_t>(next->_ptr);
+        if (!next->pinned())
+        {
+            uint8_t* ptr = static_cast<uint8_t*>(umm_relocate_down(next->_ptr));
+            if (ptr != next->_ptr)
+            {
+                next->_ptr = ptr;
+                ++moved;
+            }
+        }
+    }
+
+    return moved;
+}
+
+size_t MovableBuffer::count()
+{
+    return _count;
+}
+
+} // namespace esp8266
@@ -0,0 +1,149 @@
+/*
+ MovableBuffer.h - heap buffers that may be relocated by compaction
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __MOVABLEBUFFER_H
+#define __MOVABLEBUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A MovableBuffer owns a heap allocation that MovableBuffer::compact() is
+// allowed to relocate. It is meant for long-lived buffers, which otherwise
+// pin their block and keep the free space around them fragmented.
+//
+// The buffer is a handle: its address must be fetched again with data() after
+// any call to compact() or resize(), including a compact() run by a scheduled
+// function while yielding. A pinned buffer is never moved, keep it pinned
+// while a pointer to it is held, or while its address has been handed to
+// somebody else (e.g. lwIP).
+//
+//{
+//    esp8266::MovableBuffer buf(1024);
+//    {
+//        esp8266::MovableBuffer::Pin pin(buf);
+//        memcpy(pin.data(), src, 1024);
+//    }
+//    esp8266::MovableBuffer::compact(); // at a safe point, e.g. from loop()
+//}
+//
+// MovableBuffers and compact() are for use from the user context only, never
+// from an ISR. ISRs may still allocate while compact() is running.
+
+namespace esp8266
+{
+
+class MovableBuffer
+{
+public:
+    MovableBuffer() = default;
+    explicit MovableBuffer(size_t size);
+    ~MovableBuffer();
+
+    MovableBuffer(const MovableBuffer&) = delete;
+    MovableBuffer& operator=(const MovableBuffer&) = delete;
+
+    MovableBuffer(MovableBuffer&& other);
+    MovableBuffer& operator=(MovableBuffer&& other);
+
+    // (re)allocate, content is preserved up to the smaller size
+    // returns false and keeps the current allocation when out of memory
+    bool resize(size_t size);
+    void release();
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    explicit operator bool() const
+    {
+        return _ptr != nullptr;
+    }
+
+    // current address, only valid until the next compact()
+    uint8_t* data()
+    {
+        return _ptr;
+    }
+    const uint8_t* data() const
+    {
+        return _ptr;
+    }
+
+    // pinned buffers are skipped by compact(), pins nest
+    void pin()
+    {
+        ++_pins;
+    }
+    void unpin()
+    {
+        --_pins;
+    }
+    bool pinned() const
+    {
+        return _pins != 0;
+    }
+
+    class Pin
+    {
+    public:
+        explicit Pin(MovableBuffer& buffer) : _buffer(buffer)
+        {
+            _buffer.pin();
+        }
+        ~Pin()
+        {
+            _buffer.unpin();
+        }
+        uint8_t* data()
+        {
+            return _buffer.data();
+        }
+
+    protected:
+        MovableBuffer& _buffer;
+    };
+
+    // Move all unpinned buffers, lowest address first, into the lowest free
+    // block that can hold them. Returns the number of buffers moved.
+    static size_t compact();
+
+    // number of live (allocated) buffers
+    static size_t count();
+
+protected:
+    void link();
+    void unlink();
+
+    uint8_t* _ptr = nullptr;
+    size_t _size = 0;
+    uint16_t _pins = 0;
+
+    MovableBuffer* _prev = nullptr;
+    MovableBuffer* _next = nullptr;
+
+    static MovableBuffer* _first;
+    static size_t _count;
+};
+
+} // namespace esp8266
+
+#endif // __MOVABLEBUFFER_H
@@ -0,0 +1,125 @@
+/*
+ PgmHash.cpp - word at a time flash string comparison and hashing
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdlib.h>
+#include <algorithm>
+#include "PgmHash.h"
+
+namespace
+{
+
+// an aligned word of flash, the first character in its low byte (both the
+// lx106 and the host are little endian); it may extend past either end of
+// the string, which is harmless as an aligned word never crosses a page
+__attribute__((no_sanitize_address))
+inline uint32_t flashWord(const char* aligned)
+{
+    return pgm_read_dword(aligned);
+}
+
+// 'A' to 'Z' or'ed with 0x20 in each byte of word
+inline uint32_t lowerCase(uint32_t word)
+{
+    // a byte x below 0x80 is within ['A', 'Z'] when x + 0x80 - 'A' has its
+    // high bit set and x + 0x7f - 'Z' has not, and no byte carries
+    uint32_t low = word & 0x7f7f7f7f;
+    uint32_t upper = (low + 0x3f3f3f3f) & ~(low + 0x25252525) & ~word & 0x80808080;
+    return word | (upper >> 2);
+}
+
+inline uint32_t ramWord(const uint8_t* ram)
+{
+    return ram[0] | ram[1] << 8 | ram[2] << 16 | (uint32_t)ram[3] << 24;
+}
+
+} // namespace
+
+int memcmp_PA(const void* ram, PGM_P flash, size_t len, bool ignoreCase)
+{
+    const uint8_t* r = static_cast<const uint8_t*>(ram);
+    // the whole aligned word around flash is readable, before and after
+    size_t skip = (uintptr_t)flash & 3;
+    const char* aligned = flash - skip;
+    while (len)
+    {
+        uint32_t f = flashWord(aligned) >> (8 * skip);
+        size_t count = std::min(len, 4 - skip);
+        uint32_t m = 0;
+        if (count == 4)
+        {
+            m = ramWord(r);
+        }
+        else
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                m |= (uint32_t)r[i] << (8 * i);
+            }
+        }
+        if (ignoreCase)
+        {
+            f = lowerCase(f);
+            m = lowerCase(m);
+        }
+        uint32_t diff = f ^ m;
+        uint32_t mask = count == 4 ? 0xffffffff : (1u << (8 * count)) - 1;
+        if (diff & mask)
+        {
+            // the first differing byte is the lowest one
+            int shift = 8 * (__builtin_ctz(diff & mask) / 8);
+            return (int)((m >> shift) & 0xff) - (int)((f >> shift) & 0xff);
+        }
+        r += count;
+        len -= count;
+        aligned += 4;
+        skip = 0;
+    }
+    return 0;
+}
+
+uint32_t pgm_hash_P(PGM_P str, size_t len, uint32_t seed, bool ignoreCase)
+{
+    uint32_t hash = 2166136261u ^ seed;
+    size_t skip = (uintptr_t)str & 3;
+    const char* aligned = str - skip;
+    while (len)
+    {
+        uint32_t word = flashWord(aligned) >> (8 * skip);
+        if (ignoreCase)
+        {
+            word = lowerCase(word);
+        }
+        size_t count = std::min(len, 4 - skip);
+        for (size_t i = 0; i < count; ++i, word >>= 8)
+        {
+            hash = (hash ^ (word & 0xff)) * 16777619u;
+        }
+        len -= count;
+        aligned += 4;
+        skip = 0;
+    }
+    return hash;
+}
+
+void pgmKeywordsDuplicate()
+{
+    abort();
+}
@@ -0,0 +1,193 @@
+/*
+ PgmHash.h - word at a time flash string comparison, hashing and
+             compile time perfect hash tables of keywords
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __PGMHASH_H
+#define __PGMHASH_H
+
+#ifdef __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <pgmspace.h>
+
+// Flash can only be read 32 bits at a time, so that each pgm_read_byte()
+// in strcmp_P() or strncasecmp_P() is a whole aligned word read and a
+// shift.  These read a word of flash once for four characters.
+
+// Compare len characters in RAM with len characters in flash, like memcmp()
+// or, with ignoreCase, like strncasecmp() for ASCII.  Both may be unaligned.
+int memcmp_PA(const void* ram, PGM_P flash, size_t len, bool ignoreCase = false);
+
+inline bool equals_PA(const char* ram, size_t ramLen, PGM_P flash, size_t flashLen, bool ignoreCase = false)
+{
+    return ramLen == flashLen && !memcmp_PA(ram, flash, ramLen, ignoreCase);
+}
+
+// FNV-1a of len characters, lower cased with ignoreCase.  pgm_hash() is
+// constexpr and gives the same value at compile time as pgm_hash_P() for
+// the same characters in flash.
+constexpr uint32_t pgm_hash(const char* str, size_t len, uint32_t seed = 0, bool ignoreCase = false)
+{
+    uint32_t hash = 2166136261u ^ seed;
+    for (size_t i = 0; i < len; ++i)
+    {
+        uint8_t c = str[i];
+        if (ignoreCase && c >= 'A' && c <= 'Z')
+        {
+            c += 'a' - 'A';
+        }
+        hash = (hash ^ c) * 16777619u;
+    }
+    return hash;
+}
+
+uint32_t pgm_hash_P(PGM_P str, size_t len, uint32_t seed = 0, bool ignoreCase = false);
+
+// A fixed set of keywords (HTTP methods, header names, file extensions...)
+// and, found at compile time, the seed for which pgm_hash() sends each of
+// them to a slot of its own: find() is one hash, one slot read and one
+// comparison, instead of a comparison per keyword.  All of it, the
+// keywords included, is meant to be in flash:
+//
+//    static constexpr auto methods PROGMEM = makePgmKeywords(false, "GET", "HEAD", "POST");
+//    int index = methods.find(line, len);   // 0 to 2, or -1
+//
+// Compilation fails when no seed is found, which only happens with
+// duplicate keywords.
+
+// not constexpr, so that reaching it fails the compilation
+void pgmKeywordsDuplicate();
+
+template <size_t N, size_t TextSize>
+class PgmKeywords
+{
+public:
+    static_assert(N > 0 && N < 255, "1 to 254 keywords");
+    static_assert(TextSize <= 0xffff, "keywords too long");
+
+    static constexpr size_t slotCount()
+    {
+        size_t count = 4;
+        while (count < 2 * N)
+        {
+            count *= 2;
+        }
+        return count;
+    }
+
+    constexpr PgmKeywords(bool ignoreCase, const char* const (&keys)[N], const size_t (&lengths)[N])
+        : _ignoreCase(ignoreCase)
+    {
+        size_t offset = 0;
+        for (size_t i = 0; i < N; ++i)
+        {
+            _offset[i] = offset;
+            for (size_t c = 0; c < lengths[i]; ++c)
+            {
+                _text[offset++] = keys[i][c];
+            }
+            _text[offset++] = 0;
+        }
+        _offset[N] = offset;
+
+        for (;; ++_seed)
+        {
+            if (_seed == 100000)
+            {
+                pgmKeywordsDuplicate();
+            }
+            for (auto& slot : _slots)
+            {
+                slot = 0;
+            }
+            size_t i = 0;
+            for (; i < N; ++i)
+            {
+                uint8_t& slot = _slots[_slot(pgm_hash(keys[i], lengths[i], _seed, ignoreCase))];
+                if (slot)
+                {
+                    break;
+                }
+                slot = i + 1;
+            }
+            if (i == N)
+            {
+                break;
+            }
+        }
+    }
+
+    static constexpr size_t size()
+    {
+        return N;
+    }
+
+    // index of the keyword equal to str, -1 when there is none
+    int find(const char* str, size_t len) const
+    {
+        bool ignoreCase = pgm_read_byte(&_ignoreCase);
+        uint8_t slot = pgm_read_byte(&_slots[_slot(pgm_hash(str, len, pgm_read_dword(&_seed), ignoreCase))]);
+        if (!slot)
+        {
+            return -1;
+        }
+        size_t index = slot - 1;
+        size_t offset = pgm_read_word(&_offset[index]);
+        size_t keyLen = pgm_read_word(&_offset[index + 1]) - offset - 1;
+        return equals_PA(str, len, &_text[offset], keyLen, ignoreCase) ? (int)index : -1;
+    }
+    int find(const char* str) const
+    {
+        return find(str, strlen(str));
+    }
+
+    // the keyword, nul terminated in flash
+    PGM_P keyword(size_t index) const
+    {
+        return &_text[pgm_read_word(&_offset[index])];
+    }
+
+protected:
+    static constexpr size_t _slot(uint32_t hash)
+    {
+        return (hash ^ (hash >> 16)) & (slotCount() - 1);
+    }
+
+    uint32_t _seed = 0;
+    uint16_t _offset[N + 1] = { };
+    uint8_t _slots[slotCount()] = { };
+    bool _ignoreCase;
+    char _text[TextSize] = { };
+};
+
+template <size_t... Sizes>
+constexpr PgmKeywords<sizeof...(Sizes), (Sizes + ...)> makePgmKeywords(bool ignoreCase, const char (&... keys)[Sizes])
+{
+    const char* const pointers[] = { keys... };
+    const size_t lengths[] = { (Sizes - 1)... };
+    return PgmKeywords<sizeof...(Sizes), (Sizes + ...)>(ignoreCase, pointers, lengths);
+}
+
+#endif // __cplusplus
+
+#endif // __PGMHASH_H
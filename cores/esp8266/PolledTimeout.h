@@ -224,6 +224,18 @@ public:
     return TimePolicyT::toUserUnit(_timeout);
   }
 
+  // Time left before expiration (in user unit), 0 when expired,
+  // neverExpires when it can't expire.
+  timeType remaining() const
+  {
+    if (!canWait())
+      return 0;
+    if (_neverExpires)
+      return neverExpires;
+    timeType elapsed = TimePolicyT::time() - _start;
+    return elapsed >= _timeout ? 0 : TimePolicyT::toUserUnit(_timeout - elapsed);
+  }
+
   static constexpr timeType timeMax()
   {
     return TimePolicyT::timeMax;
@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <type_traits>
 #include <Arduino.h>
 
 #include "Print.h"
@@ -47,49 +48,332 @@ size_t Print::write(const uint8_t *buffer, size_t size) {
     return n;
 }
 
-size_t Print::printf(const char *format, ...) {
-    va_list arg;
-    va_start(arg, format);
-    char temp[64];
-    char* buffer = temp;
-    size_t len = vsnprintf(temp, sizeof(temp), format, arg);
-    va_end(arg);
-    if (len > sizeof(temp) - 1) {
-        buffer = new (std::nothrow) char[len + 1];
-        if (!buffer) {
-            return 0;
+size_t Print::write(const iovec *iov, size_t iovcnt) {
+    size_t n = 0;
+    for (size_t i = 0; i < iovcnt; i++) {
+        size_t ret = write((const uint8_t *)iov[i].iov_base, iov[i].iov_len);
+        n += ret;
+        if (ret != iov[i].iov_len) {
+            break;
+        }
+    }
+    return n;
+}
+
+namespace {
+
+// printf() output, gathered in a small buffer written to the Print each
+// time it fills, so that nothing is allocated whatever the length
+class PrintfSink {
+public:
+    PrintfSink(Print& out) : _out(out) { }
+
+    // data may be in RAM or PROGMEM
+    void put(const char* data, size_t len) {
+        while (len && !_failed) {
+            size_t chunk = std::min(len, sizeof(_buf) - _used);
+            memcpy_P(_buf + _used, data, chunk);
+            _used += chunk;
+            data += chunk;
+            len -= chunk;
+            if (_used == sizeof(_buf)) {
+                flush();
+            }
+        }
+    }
+
+    void put(char c) {
+        put(&c, 1);
+    }
+
+    void pad(size_t count) {
+        while (count && !_failed) {
+            size_t chunk = std::min(count, sizeof(_buf) - _used);
+            memset(_buf + _used, ' ', chunk);
+            _used += chunk;
+            count -= chunk;
+            if (_used == sizeof(_buf)) {
+                flush();
+            }
+        }
+    }
+
+    // what was handed to put(), the Print may have taken less
+    size_t count() const {
+        return _count + _used;
+    }
+
+    size_t finish() {
+        flush();
+        return _written;
+    }
+
+private:
+    void flush() {
+        if (_used && !_failed) {
+            size_t ret = _out.write((const uint8_t*)_buf, _used);
+            _written += ret;
+            _failed = ret != _used;
         }
-        va_start(arg, format);
-        vsnprintf(buffer, len + 1, format, arg);
-        va_end(arg);
+        _count += _used;
+        _used = 0;
+    }
+
+    Print& _out;
+    char _buf[64];
+    size_t _used = 0;
+    size_t _count = 0;
+    size_t _written = 0;
+    bool _failed = false;
+};
+
+// One conversion with all its widths and precisions resolved, formatted by
+// snprintf() on the stack; only a conversion longer than the stack buffer,
+// such as "%.80f", needs the heap
+template <typename T>
+void printfConversion(PrintfSink& sink, const char* spec, T value) {
+    char temp[32];
+    int len = snprintf(temp, sizeof(temp), spec, value);
+    if (len < 0) {
+        return;
     }
-    len = write((const uint8_t*) buffer, len);
-    if (buffer != temp) {
+    if ((size_t)len < sizeof(temp)) {
+        sink.put(temp, len);
+        return;
+    }
+    char* buffer = new (std::nothrow) char[len + 1];
+    if (buffer) {
+        snprintf(buffer, len + 1, spec, value);
+        sink.put(buffer, len);
         delete[] buffer;
     }
+}
+
+// Plain %d, %ld, %u... are the most common and skip snprintf()
+template <typename T>
+void printfDecimal(PrintfSink& sink, T value) {
+    char digits[21];
+    char* end = digits + sizeof(digits);
+    char* first;
+    using U = typename std::make_unsigned<T>::type;
+    U magnitude = value;
+    if (std::is_signed<T>::value && value < 0) {
+        magnitude = 0 - magnitude;
+    }
+    if (sizeof(U) > sizeof(unsigned int)) {
+        first = ulltoa_dec(magnitude, end);
+    } else {
+        first = utoa_dec(magnitude, end);
+    }
+    if (std::is_signed<T>::value && value < 0) {
+        *--first = '-';
+    }
+    sink.put(first, end - first);
+}
+
+template <typename T>
+void printfInteger(PrintfSink& sink, const char* spec, bool plain, T value) {
+    if (plain) {
+        printfDecimal(sink, value);
+    } else {
+        printfConversion(sink, spec, value);
+    }
+}
+
+// Walks format (in RAM or PROGMEM) and writes the literal text and the %s
+// strings straight to the sink, the other conversions go one at a time
+// through snprintf() into a stack buffer
+size_t printfStream(Print& out, PGM_P format, va_list arg) {
+    PrintfSink sink(out);
+    PGM_P p = format;
+    for (;;) {
+        PGM_P literal = p;
+        char c;
+        while ((c = pgm_read_byte(p)) && c != '%') {
+            p++;
+        }
+        sink.put(literal, p - literal);
+        if (!c) {
+            break;
+        }
+        PGM_P conversion = p++;
+
+        // %[flags][width][.precision][length]type, '*' resolved to numbers
+        char spec[32] = "%";
+        size_t specLen = 1;
+        bool leftAlign = false;
+        while ((c = pgm_read_byte(p)) && strchr("-+ #0", c)) {
+            leftAlign |= c == '-';
+            if (specLen < 6) {
+                spec[specLen++] = c;
+            }
+            p++;
+        }
+        int width = -1;
+        if (c == '*') {
+            width = va_arg(arg, int);
+            if (width < 0) {
+                leftAlign = true;
+                spec[specLen++] = '-';
+                width = -width;
+            }
+            c = pgm_read_byte(++p);
+        } else if (isdigit(c)) {
+            width = 0;
+            while (isdigit(c = pgm_read_byte(p))) {
+                width = width * 10 + c - '0';
+                p++;
+            }
+        }
+        int precision = -1;
+        if (c == '.') {
+            precision = 0;
+            c = pgm_read_byte(++p);
+            if (c == '*') {
+                precision = std::max(va_arg(arg, int), -1);
+                c = pgm_read_byte(++p);
+            } else {
+                while (isdigit(c = pgm_read_byte(p))) {
+                    precision = precision * 10 + c - '0';
+                    p++;
+                }
+            }
+        }
+        if (width >= 0) {
+            specLen += snprintf(spec + specLen, sizeof(spec) - specLen, "%d", width);
+        }
+        if (precision >= 0) {
+            specLen += snprintf(spec + specLen, sizeof(spec) - specLen, ".%d", precision);
+        }
+        bool plain = specLen == 1;
+        char length = 0;   // 'H' for hh, 'q' for ll
+        while ((c = pgm_read_byte(p)) && strchr("hlLqjzt", c)) {
+            length = (length == c && (c == 'h' || c == 'l')) ? (c == 'h' ? 'H' : 'q') : c;
+            if (specLen < sizeof(spec) - 2) {
+                spec[specLen++] = c;
+            }
+            p++;
+        }
+        if (c) {
+            p++;
+        }
+        spec[specLen++] = c;
+        spec[specLen] = 0;
+        plain &= length != 'h' && length != 'H';
+
+        switch (c) {
+        case '%':
+            sink.put('%');
+            break;
+        case 'c':
+        case 's': {
+            char ch;
+            const char* str = &ch;
+            size_t len = 1;
+            if (c == 'c') {
+                ch = (char)va_arg(arg, int);
+            } else {
+                str = va_arg(arg, const char*);
+                if (!str) {
+                    str = "(null)";
+                }
+                // the string may be in PROGMEM too, and shorter than precision
+                for (len = 0; (precision < 0 || len < (size_t)precision) && pgm_read_byte(str + len); len++) {
+                }
+            }
+            size_t fill = width > 0 && (size_t)width > len ? width - len : 0;
+            if (!leftAlign) {
+                sink.pad(fill);
+            }
+            sink.put(str, len);
+            if (leftAlign) {
+                sink.pad(fill);
+            }
+            break;
+        }
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X': {
+            bool isSigned = c == 'd' || c == 'i';
+            plain &= c != 'o' && c != 'x' && c != 'X';
+            switch (length) {
+            case 'l':
+                isSigned ? printfInteger(sink, spec, plain, va_arg(arg, long)) : printfInteger(sink, spec, plain, va_arg(arg, unsigned long));
+                break;
+            case 'q':
+                isSigned ? printfInteger(sink, spec, plain, va_arg(arg, long long)) : printfInteger(sink, spec, plain, va_arg(arg, unsigned long long));
+                break;
+            case 'j':
+                isSigned ? printfInteger(sink, spec, plain, va_arg(arg, intmax_t)) : printfInteger(sink, spec, plain, va_arg(arg, uintmax_t));
+                break;
+            case 'z':
+                isSigned ? printfInteger(sink, spec, plain, va_arg(arg, ssize_t)) : printfInteger(sink, spec, plain, va_arg(arg, size_t));
+                break;
+            case 't':
+                printfInteger(sink, spec, plain, va_arg(arg, ptrdiff_t));
+                break;
+            default:
+                // char and short are promoted to int, snprintf() narrows them
+                isSigned ? printfInteger(sink, spec, plain, va_arg(arg, int)) : printfInteger(sink, spec, plain, va_arg(arg, unsigned int));
+                break;
+            }
+            break;
+        }
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if (length == 'L') {
+                printfConversion(sink, spec, va_arg(arg, long double));
+            } else {
+                printfConversion(sink, spec, va_arg(arg, double));
+            }
+            break;
+        case 'p':
+            printfConversion(sink, spec, va_arg(arg, void*));
+            break;
+        case 'n':
+            *va_arg(arg, int*) = sink.count();
+            break;
+        default:
+            // unknown, or the format ends within the conversion: as is
+            sink.put(conversion, p - conversion);
+            break;
+        }
+    }
+    return sink.finish();
+}
+
+} // namespace
+
+size_t Print::vprintf(const char *format, va_list arg) {
+    return printfStream(*this, format, arg);
+}
+
+size_t Print::vprintf_P(PGM_P format, va_list arg) {
+    return printfStream(*this, format, arg);
+}
+
+size_t Print::printf(const char *format, ...) {
+    va_list arg;
+    va_start(arg, format);
+    size_t len = printfStream(*this, format, arg);
+    va_end(arg);
     return len;
 }
 
 size_t Print::printf_P(PGM_P format, ...) {
     va_list arg;
     va_start(arg, format);
-    char temp[64];
-    char* buffer = temp;
-    size_t len = vsnprintf_P(temp, sizeof(temp), format, arg);
+    size_t len = printfStream(*this, format, arg);
     va_end(arg);
-    if (len > sizeof(temp) - 1) {
-        buffer = new (std::nothrow) char[len + 1];
-        if (!buffer) {
-            return 0;
-        }
-        va_start(arg, format);
-        vsnprintf_P(buffer, len + 1, format, arg);
-        va_end(arg);
-    }
-    len = write((const uint8_t*) buffer, len);
-    if (buffer != temp) {
-        delete[] buffer;
-    }
     return len;
 }
 
@@ -243,6 +527,18 @@ template<typename T, typename... P> inline size_t Print::_println(T v, P... args
 };
 
 template<typename T> size_t Print::printNumber(T n, uint8_t base) {
+    if (base == 10) {
+        char digits[20];
+        char* end = digits + sizeof(digits);
+        char* first;
+        if constexpr (sizeof(T) > sizeof(unsigned int)) {
+            first = ulltoa_dec(n, end);
+        } else {
+            first = utoa_dec(n, end);
+        }
+        return write(first, end - first);
+    }
+
     char buf[8 * sizeof(n) + 1]; // Assumes 8-bit chars plus zero byte.
     char* str = &buf[sizeof(buf) - 1];
 
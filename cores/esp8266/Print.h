@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdarg.h>
 
 #include "WString.h"
 #include "Printable.h"
@@ -62,6 +63,14 @@ class Print {
         size_t write(const char *buffer, size_t size) {
             return write((const uint8_t *) buffer, size);
         }
+        // scatter/gather write, fields named as POSIX's struct iovec
+        // buffers are written in order, stops at the first short write
+        // (overridden by network clients to emit all buffers with one push)
+        struct iovec {
+            const void *iov_base;
+            size_t iov_len;
+        };
+        virtual size_t write(const iovec *iov, size_t iovcnt);
         // These handle ambiguity for write(0) case, because (0) can be a pointer or an integer
         inline size_t write(short t) { return write((uint8_t)t); }
         inline size_t write(unsigned short t) { return write((uint8_t)t); }
@@ -79,8 +88,12 @@ class Print {
         // should be overridden by subclasses with buffering
         virtual int availableForWrite() { return 0; }
 
+        // formatted output is written in chunks as it is produced, without
+        // allocating whatever its length
         size_t printf(const char * format, ...)  __attribute__ ((format (printf, 2, 3)));
         size_t printf_P(PGM_P format, ...) __attribute__((format(printf, 2, 3)));
+        size_t vprintf(const char * format, va_list arg);
+        size_t vprintf_P(PGM_P format, va_list arg);
         size_t print(const __FlashStringHelper *);
         size_t print(const String &);
         size_t print(const char[]);
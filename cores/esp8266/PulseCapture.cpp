@@ -0,0 +1,210 @@
+/*
+ PulseCapture.cpp - interrupt driven pulse and frequency measurement
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <new>
+#include "PulseCapture.h"
+
+// Edges are stamped with the cycle count, its lowest bit replaced by the
+// pin level after the edge
+static constexpr uint32_t levelBit = 1;
+
+PulseCapture::PulseCapture(size_t edges)
+    : _size(edges + 1)
+{
+    setTimeout(1000000);
+}
+
+PulseCapture::~PulseCapture()
+{
+    end();
+    delete[] _buffer;
+}
+
+bool PulseCapture::begin(uint8_t pin, int mode)
+{
+    if (pin >= 16 || (mode != RISING && mode != FALLING && mode != CHANGE))
+    {
+        return false;
+    }
+    end();
+    if (!_buffer)
+    {
+        _buffer = new (std::nothrow) uint32_t[_size];
+        if (!_buffer)
+        {
+            return false;
+        }
+    }
+    _ring.init(_buffer, _size);
+    _pin = pin;
+    _mode = mode;
+    _edges = 0;
+    _lost = 0;
+    _lostSeen = 0;
+    _periodCcys = _highCcys = _lowCcys = 0;
+    _avgPeriods = 0;
+    _frequency = 0;
+    restart();
+    _lastCcy = esp_get_cycle_count();
+    attachInterruptArg(pin, onEdge, this, mode);
+    return true;
+}
+
+void PulseCapture::end()
+{
+    if (_pin >= 0)
+    {
+        detachInterrupt(_pin);
+        _pin = -1;
+    }
+}
+
+void PulseCapture::setTimeout(uint32_t timeoutUs)
+{
+    // keep timeouts within half the cycle counter wrap
+    const uint32_t maxTimeoutUs = clockCyclesToMicroseconds(UINT32_MAX / 2);
+    if (timeoutUs > maxTimeoutUs)
+    {
+        timeoutUs = maxTimeoutUs;
+    }
+    _timeoutCcys = microsecondsToClockCycles(timeoutUs);
+}
+
+void IRAM_ATTR PulseCapture::onEdge(void* arg)
+{
+    PulseCapture* self = static_cast<PulseCapture*>(arg);
+    uint32_t stamp = esp_get_cycle_count() & ~levelBit;
+    if (self->_mode == CHANGE ? GPIP(self->_pin) : self->_mode == RISING)
+    {
+        stamp |= levelBit;
+    }
+    self->_edges = self->_edges + 1;
+    if (!self->_ring.push(stamp))
+    {
+        self->_lost = self->_lost + 1;
+    }
+}
+
+void PulseCapture::restart()
+{
+    _hasStart = false;
+    _hasFall = false;
+    _avgPeriods = 0;
+}
+
+bool PulseCapture::update()
+{
+    uint32_t lost = _lost;
+    bool measured = false;
+    uint32_t stamp;
+    while (_ring.pop(stamp))
+    {
+        uint32_t ccy = stamp & ~levelBit;
+        if (_mode != CHANGE || (stamp & levelBit))
+        {
+            // Edge beginning a period: any edge in RISING or FALLING mode, the rising edge in CHANGE mode
+            if (_hasStart)
+            {
+                _periodCcys = ccy - _startCcy;
+                if (_hasFall)
+                {
+                    _lowCcys = ccy - _fallCcy;
+                }
+                if (!_avgPeriods)
+                {
+                    _avgStartCcy = _startCcy;
+                }
+                _avgPeriods++;
+                _avgEndCcy = ccy;
+                measured = true;
+            }
+            _hasStart = true;
+            _hasFall = false;
+            _startCcy = ccy;
+        }
+        else if (_hasStart && !_hasFall)
+        {
+            _hasFall = true;
+            _fallCcy = ccy;
+            _highCcys = ccy - _startCcy;
+        }
+        _lastCcy = ccy;
+    }
+    if (lost != _lostSeen)
+    {
+        // Edges were dropped after the ones just read, don't measure across the gap
+        _lostSeen = lost;
+        restart();
+    }
+    return measured;
+}
+
+bool PulseCapture::stopped()
+{
+    update();
+    if (esp_get_cycle_count() - _lastCcy > _timeoutCcys)
+    {
+        // Also keeps the next period from spanning a cycle counter wrap
+        restart();
+        _periodCcys = _highCcys = _lowCcys = 0;
+        _lastCcy = esp_get_cycle_count() - _timeoutCcys;
+        return true;
+    }
+    return false;
+}
+
+uint32_t PulseCapture::periodUs()
+{
+    return stopped() ? 0 : clockCyclesToMicroseconds(_periodCcys);
+}
+
+uint32_t PulseCapture::highUs()
+{
+    return stopped() ? 0 : clockCyclesToMicroseconds(_highCcys);
+}
+
+uint32_t PulseCapture::lowUs()
+{
+    return stopped() ? 0 : clockCyclesToMicroseconds(_lowCcys);
+}
+
+float PulseCapture::duty()
+{
+    if (stopped() || !_periodCcys)
+    {
+        return 0;
+    }
+    return (float)_highCcys / _periodCcys;
+}
+
+float PulseCapture::frequency()
+{
+    if (stopped())
+    {
+        _frequency = 0;
+    }
+    else if (_avgPeriods)
+    {
+        _frequency = (float)_avgPeriods * clockCyclesPerMicrosecond() * 1000000.0f / (_avgEndCcy - _avgStartCcy);
+        _avgPeriods = 0;
+    }
+    return _frequency;
+}
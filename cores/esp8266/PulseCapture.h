@@ -0,0 +1,102 @@
+/*
+ PulseCapture.h - interrupt driven pulse and frequency measurement
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __PULSECAPTURE_H
+#define __PULSECAPTURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <Arduino.h>
+#include "SpscRing.h"
+
+// PulseCapture measures the signal on an input pin without busy waiting
+// like pulseIn(): the pin interrupt stamps each edge with the CPU cycle
+// counter into a ring, and the period, pulse widths and frequency are
+// computed from the ring when read, in the loop. Each instance captures
+// one pin, several instances capture several pins at once.
+//
+// The ring must hold the edges coming in between two reads, the edges
+// that don't fit are counted by lost() and the measurement restarts after
+// them. Periods must be shorter than the cycle counter wrap (26s at 160MHz).
+
+class PulseCapture
+{
+public:
+    PulseCapture(size_t edges = 32);
+    ~PulseCapture();
+
+    // Capture the edges of pin 0..15 selected by mode: RISING or FALLING
+    // measure the period between those edges, CHANGE also measures the
+    // high and low pulse widths. Returns false for GPIO16 or without memory.
+    // The pin mode is left to the caller, as for attachInterrupt().
+    bool begin(uint8_t pin, int mode = CHANGE);
+    void end();
+
+    // Without an edge for this long, the signal is considered stopped and
+    // the measurements read 0. Default 1s.
+    void setTimeout(uint32_t timeoutUs);
+
+    // Process the captured edges, true when a new period was measured since
+    // the last call. The getters below call it too.
+    bool update();
+
+    uint32_t periodUs(); // Last period
+    uint32_t highUs();   // Last high pulse width, CHANGE only
+    uint32_t lowUs();    // Last low pulse width, CHANGE only
+    float duty();        // highUs() / periodUs(), CHANGE only
+    float frequency();   // In Hz, averaged over the periods since the last call
+
+    uint32_t edges() const { return _edges; } // Captured edges since begin(), e.g. flow meter ticks
+    uint32_t lost() const { return _lost; }   // Edges which didn't fit in the ring
+
+protected:
+    static void onEdge(void* arg);
+    bool stopped();
+    void restart();
+
+    esp8266::SpscRing<uint32_t> _ring;
+    uint32_t* _buffer = nullptr;
+    size_t _size;
+    int8_t _pin = -1;
+    int _mode = CHANGE;
+    uint32_t _timeoutCcys;
+
+    volatile uint32_t _edges = 0;
+    volatile uint32_t _lost = 0;
+    uint32_t _lostSeen = 0;
+
+    bool _hasStart = false; // _startCcy is the beginning of the current period
+    bool _hasFall = false;  // _fallCcy is the falling edge of the current period
+    uint32_t _startCcy = 0;
+    uint32_t _fallCcy = 0;
+    uint32_t _lastCcy = 0;  // Last edge, for the timeout
+
+    uint32_t _periodCcys = 0;
+    uint32_t _highCcys = 0;
+    uint32_t _lowCcys = 0;
+
+    uint32_t _avgPeriods = 0; // Periods measured since the last frequency()
+    uint32_t _avgStartCcy = 0;
+    uint32_t _avgEndCcy = 0;
+    float _frequency = 0;
+};
+
+#endif // __PULSECAPTURE_H
@@ -0,0 +1,217 @@
+/*
+ RtcStore.cpp - versioned records kept in RTC user memory over deep sleep
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <Arduino.h>
+#include "RtcStore.h"
+#include "coredecls.h"
+
+// Layout, in blocks from the store offset:
+//   0        magic << 16 | data blocks used
+//   1        crc32() of block 0 and the data blocks used
+//   2...     records, each a header (see _recordHeader()) and its value
+
+RtcStore::RtcStore(uint32_t offset, uint32_t blocks)
+    : _offset(offset), _blocks(blocks)
+{
+    if (_offset > 128 - _header - 1)
+    {
+        _offset = 128 - _header - 1;
+    }
+    _blocks = std::max(_header + 1, std::min(_blocks, 128 - _offset));
+}
+
+bool RtcStore::begin()
+{
+    _holding = 0;
+    uint32_t head[_header];
+    if (!_read(0, head, _header))
+    {
+        return false;
+    }
+    _used = head[0] & 0xffff;
+    if ((head[0] >> 16) != _magic || _header + _used > _blocks || _crc() != head[1])
+    {
+        clear();
+        return false;
+    }
+    // a valid CRC, still the records to walk through
+    uint32_t at = _header;
+    while (at < _header + _used)
+    {
+        uint32_t record;
+        if (!_read(at, &record, 1) || (record >> 24) != 0xa5)
+        {
+            break;
+        }
+        at += 1 + (record & 0xff);
+    }
+    if (at != _header + _used)
+    {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+void RtcStore::clear()
+{
+    _used = 0;
+    _written();
+}
+
+uint32_t RtcStore::_find(uint8_t id, uint32_t* header) const
+{
+    uint32_t end = _header + _used;
+    uint32_t at = _header;
+    while (at < end)
+    {
+        uint32_t record;
+        if (!_read(at, &record, 1))
+        {
+            break;
+        }
+        if (((record >> 16) & 0xff) == id)
+        {
+            if (header)
+            {
+                *header = record;
+            }
+            return at;
+        }
+        at += 1 + (record & 0xff);
+    }
+    return end;
+}
+
+bool RtcStore::contains(uint8_t id) const
+{
+    return _find(id) < _header + _used;
+}
+
+bool RtcStore::_get(uint8_t id, uint8_t version, uint32_t* words, size_t count) const
+{
+    uint32_t record = 0;
+    uint32_t at = _find(id, &record);
+    return at < _header + _used && record == _recordHeader(id, version, count) && _read(at + 1, words, count);
+}
+
+bool RtcStore::_put(uint8_t id, uint8_t version, const uint32_t* words, size_t count)
+{
+    uint32_t record = 0;
+    uint32_t at = _find(id, &record);
+    uint32_t header = _recordHeader(id, version, count);
+    bool found = at < _header + _used;
+    if (found && (record & 0xff) == count)
+    {
+        // in place
+        return _write(at, &header, 1) && _write(at + 1, words, count) && _written();
+    }
+    // a resized record must fit once the old one is gone, which is kept otherwise
+    uint32_t freed = found ? 1 + (record & 0xff) : 0;
+    if (_header + _used - freed + 1 + count > _blocks)
+    {
+        return false;
+    }
+    if (found)
+    {
+        _erase(at, freed);
+    }
+
+    at = _header + _used;
+    _used += 1 + count;
+    return _write(at, &header, 1) && _write(at + 1, words, count) && _written();
+}
+
+bool RtcStore::remove(uint8_t id)
+{
+    uint32_t record = 0;
+    uint32_t at = _find(id, &record);
+    if (at >= _header + _used)
+    {
+        return false;
+    }
+    _erase(at, 1 + (record & 0xff));
+    return _written();
+}
+
+void RtcStore::_erase(uint32_t at, uint32_t words)
+{
+    uint32_t end = _header + _used;
+    uint32_t buf[8];
+    for (uint32_t from = at + words; from < end;)
+    {
+        size_t count = std::min((size_t)(end - from), sizeof(buf) / 4);
+        _read(from, buf, count);
+        _write(at, buf, count);
+        from += count;
+        at += count;
+    }
+    _used -= words;
+}
+
+void RtcStore::beginUpdate()
+{
+    _holding++;
+}
+
+bool RtcStore::endUpdate()
+{
+    return _holding && !--_holding ? _written() : true;
+}
+
+// Recomputed over the whole store: the used count comes first and values
+// change in place or move, so no running CRC could be extended.  It is at
+// most 512 bytes of RTC memory, and beginUpdate() batches the writes.
+uint32_t RtcStore::_crc() const
+{
+    uint32_t head = (_magic << 16) | _used;
+    Crc32 crc;
+    crc.add(&head, sizeof(head));
+    uint32_t buf[8];
+    for (uint32_t at = _header; at < _header + _used;)
+    {
+        size_t count = std::min((size_t)(_header + _used - at), sizeof(buf) / 4);
+        _read(at, buf, count);
+        crc.add(buf, count * 4);
+        at += count;
+    }
+    return crc.value();
+}
+
+bool RtcStore::_written()
+{
+    if (_holding)
+    {
+        return true;
+    }
+    uint32_t head[_header] = { (_magic << 16) | _used, _crc() };
+    return _write(0, head, _header);
+}
+
+bool RtcStore::_read(uint32_t at, uint32_t* words, size_t count) const
+{
+    return !count || ESP.rtcUserMemoryRead(_offset + at, words, count * 4);
+}
+
+bool RtcStore::_write(uint32_t at, const uint32_t* words, size_t count)
+{
+    return !count || ESP.rtcUserMemoryWrite(_offset + at, const_cast<uint32_t*>(words), count * 4);
+}
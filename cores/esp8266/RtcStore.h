@@ -0,0 +1,128 @@
+/*
+ RtcStore.h - versioned records kept in RTC user memory over deep sleep
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __RTCSTORE_H
+#define __RTCSTORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+// Records kept in a range of the RTC user memory (see
+// ESP.rtcUserMemoryWrite()), over resets and deep sleep but not power
+// cycles, each a value of some trivially copyable type with an id and a
+// version number.  One CRC covers the whole store: begin() checks it, and
+// empties the store when it doesn't match (after power up), then each
+// put() updates it, or once for all the writes between beginUpdate() and
+// endUpdate():
+//
+//    RtcStore rtc(32, 32);          // blocks 32 to 63
+//    rtc.begin();
+//    uint32_t wakes = 0;
+//    rtc.get(1, wakes);             // stays 0 when not found
+//    rtc.beginUpdate();
+//    rtc.put(1, wakes + 1);
+//    rtc.put(2, reading, 3);        // version 3 of the record 2
+//    rtc.endUpdate();
+//
+// get() only succeeds for a record of the same id, version and size, so
+// a changed layout is found missing rather than misread.  The first 32
+// blocks are used by eboot commands when there is an OTA update.
+
+class RtcStore
+{
+public:
+    // offset and blocks in 4 byte blocks of the RTC user memory, 3 to 128
+    RtcStore(uint32_t offset, uint32_t blocks);
+
+    // false when the store was not valid and has been emptied
+    bool begin();
+    void clear();
+
+    template <typename T>
+    bool get(uint8_t id, T& value, uint8_t version = 0) const
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "stored as bytes");
+        uint32_t words[(sizeof(T) + 3) / 4];
+        if (!_get(id, version, words, sizeof(words) / 4))
+        {
+            return false;
+        }
+        memcpy(&value, words, sizeof(T));
+        return true;
+    }
+
+    // false when the store is full
+    template <typename T>
+    bool put(uint8_t id, const T& value, uint8_t version = 0)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "stored as bytes");
+        static_assert(sizeof(T) <= 125 * 4, "larger than the RTC memory");
+        uint32_t words[(sizeof(T) + 3) / 4] = { };
+        memcpy(words, &value, sizeof(T));
+        return _put(id, version, words, sizeof(words) / 4);
+    }
+
+    bool remove(uint8_t id);
+    bool contains(uint8_t id) const;
+
+    // the CRC is updated once, at endUpdate()
+    void beginUpdate();
+    bool endUpdate();
+
+    size_t used() const    // bytes, headers included
+    {
+        return (_header + _used) * 4;
+    }
+    size_t size() const
+    {
+        return _blocks * 4;
+    }
+
+protected:
+    static constexpr uint32_t _magic = 0x5254;     // "RT"
+    static constexpr uint32_t _header = 2;         // magic and used, CRC
+
+    // each record is a word, then its value: magic, id, version, words
+    static uint32_t _recordHeader(uint8_t id, uint8_t version, size_t words)
+    {
+        return 0xa5000000 | ((uint32_t)id << 16) | ((uint32_t)version << 8) | words;
+    }
+
+    bool _get(uint8_t id, uint8_t version, uint32_t* words, size_t count) const;
+    bool _put(uint8_t id, uint8_t version, const uint32_t* words, size_t count);
+    // offset of the record in the data words, _used if none
+    uint32_t _find(uint8_t id, uint32_t* header = nullptr) const;
+    void _erase(uint32_t at, uint32_t words);
+    uint32_t _crc() const;
+    bool _written();
+
+    bool _read(uint32_t at, uint32_t* words, size_t count) const;
+    bool _write(uint32_t at, const uint32_t* words, size_t count);
+
+    uint32_t _offset;
+    uint32_t _blocks;
+    uint32_t _used = 0;      // data words
+    uint8_t _holding = 0;
+};
+
+#endif // __RTCSTORE_H
@@ -23,6 +23,7 @@
 #include "PolledTimeout.h"
 #include "interrupts.h"
 #include "coredecls.h"
+#include "Print.h"
 
 typedef std::function<void(void)> mSchedFuncT;
 struct scheduled_fn_t
@@ -31,11 +32,33 @@ struct scheduled_fn_t
     mSchedFuncT mFunc;
 };
 
-static scheduled_fn_t* sFirst = nullptr;
-static scheduled_fn_t* sLast = nullptr;
+// all slots are reserved at build time, scheduling a function
+// (usually from lwIP or ISR context) never reaches the heap
+static scheduled_fn_t sPool[SCHEDULED_FN_MAX_COUNT];
+
+// one FIFO per priority class
+static scheduled_fn_t* sFirst[SCHEDULE_PRIORITY_COUNT] = { };
+static scheduled_fn_t* sLast[SCHEDULE_PRIORITY_COUNT] = { };
 static scheduled_fn_t* sUnused = nullptr;
 static int sCount = 0;
+static uint16_t sQueued = 0;
+static uint16_t sQueuedMax = 0;
+static uint32_t sOverflow = 0;
 static uint32_t recurrent_max_grain_mS = 0;
+static uint32_t budget_uS = 0; // 0: unlimited
+
+#if SCHEDULED_FN_PROFILING
+static scheduled_fn_profile_t sProfile[SCHEDULE_PRIORITY_COUNT];
+
+static inline void profile_account(scheduled_fn_profile_t& profile, uint32_t start)
+{
+    uint32_t cycles = esp_get_cycle_count() - start;
+    ++profile.calls;
+    profile.cycles += cycles;
+    if (cycles > profile.max_cycles)
+        profile.max_cycles = cycles;
+}
+#endif
 
 typedef std::function<bool(void)> mRecFuncT;
 struct recurrent_fn_t
@@ -44,14 +67,25 @@ struct recurrent_fn_t
     mRecFuncT mFunc;
     esp8266::polledTimeout::periodicFastUs callNow;
     std::function<bool(void)> alarm = nullptr;
+#if SCHEDULED_FN_PROFILING
+    scheduled_fn_profile_t profile = { };
+#endif
     recurrent_fn_t(esp8266::polledTimeout::periodicFastUs interval) : callNow(interval) { }
 };
 
-static recurrent_fn_t* rFirst = nullptr;
-static recurrent_fn_t* rLast = nullptr;
+static recurrent_fn_t* rFirst[SCHEDULE_PRIORITY_COUNT] = { };
+static recurrent_fn_t* rLast[SCHEDULE_PRIORITY_COUNT] = { };
+
+// recurrent functions are not limited in number, the first ones are
+// constructed in place in reserved slots and the others use the heap
+static_assert(SCHEDULED_RECURRENT_FN_POOL_COUNT <= 32, "rPoolUsed is a 32 bits mask");
+alignas(recurrent_fn_t) static uint8_t rPool[SCHEDULED_RECURRENT_FN_POOL_COUNT][sizeof(recurrent_fn_t)];
+static uint32_t rPoolUsed = 0;
+static uint16_t rCount = 0;
+static uint16_t rCountMax = 0;
+static uint32_t rOverflow = 0;
 
 // Returns a pointer to an unused sched_fn_t,
-// or if none are available allocates a new one,
 // or nullptr if limit is reached
 IRAM_ATTR // called from ISR
 static scheduled_fn_t* get_fn_unsafe()
@@ -63,12 +97,10 @@ static scheduled_fn_t* get_fn_unsafe()
         result = sUnused;
         sUnused = sUnused->mNext;
     }
-    // if no unused items, and count not too high, allocate a new one
+    // if no unused items, take the next never used slot
     else if (sCount < SCHEDULED_FN_MAX_COUNT)
     {
-        result = new (std::nothrow) scheduled_fn_t;
-        if (result)
-            ++sCount;
+        result = &sPool[sCount++];
     }
     return result;
 }
@@ -78,42 +110,86 @@ static void recycle_fn_unsafe(scheduled_fn_t* fn)
     fn->mFunc = nullptr; // special overload in c++ std lib
     fn->mNext = sUnused;
     sUnused = fn;
+    --sQueued;
+}
+
+static recurrent_fn_t* get_recurrent_fn(uint32_t repeat_us)
+{
+    recurrent_fn_t* result = nullptr;
+    {
+        esp8266::InterruptLock lockAllInterruptsInThisScope;
+        for (int i = 0; i < SCHEDULED_RECURRENT_FN_POOL_COUNT; ++i)
+        {
+            if (!(rPoolUsed & (1UL << i)))
+            {
+                rPoolUsed |= 1UL << i;
+                result = reinterpret_cast<recurrent_fn_t*>(rPool[i]);
+                break;
+            }
+        }
+        if (!result)
+            ++rOverflow;
+    }
+    if (result)
+        return new (result) recurrent_fn_t(repeat_us);
+    return new (std::nothrow) recurrent_fn_t(repeat_us);
+}
+
+static void recycle_recurrent_fn_unsafe(recurrent_fn_t* fn)
+{
+    const uint8_t* slot = reinterpret_cast<const uint8_t*>(fn);
+    if (slot >= rPool[0] && slot < rPool[SCHEDULED_RECURRENT_FN_POOL_COUNT])
+    {
+        fn->~recurrent_fn_t();
+        rPoolUsed &= ~(1UL << ((slot - rPool[0]) / sizeof(recurrent_fn_t)));
+    }
+    else
+    {
+        delete(fn);
+    }
+    --rCount;
 }
 
 IRAM_ATTR // (not only) called from ISR
-bool schedule_function(const std::function<void(void)>& fn)
+bool schedule_function(const std::function<void(void)>& fn, schedule_priority_e priority)
 {
-    if (!fn)
+    if (!fn || priority >= SCHEDULE_PRIORITY_COUNT)
         return false;
 
     esp8266::InterruptLock lockAllInterruptsInThisScope;
 
     scheduled_fn_t* item = get_fn_unsafe();
     if (!item)
+    {
+        ++sOverflow;
         return false;
+    }
 
     item->mFunc = fn;
     item->mNext = nullptr;
 
-    if (sFirst)
-        sLast->mNext = item;
+    if (++sQueued > sQueuedMax)
+        sQueuedMax = sQueued;
+
+    if (sFirst[priority])
+        sLast[priority]->mNext = item;
     else
-        sFirst = item;
-    sLast = item;
+        sFirst[priority] = item;
+    sLast[priority] = item;
 
     return true;
 }
 
 IRAM_ATTR // (not only) called from ISR
 bool schedule_recurrent_function_us(const std::function<bool(void)>& fn,
-    uint32_t repeat_us, const std::function<bool(void)>& alarm)
+    uint32_t repeat_us, const std::function<bool(void)>& alarm, schedule_priority_e priority)
 {
     assert(repeat_us < decltype(recurrent_fn_t::callNow)::neverExpires); //~26800000us (26.8s)
 
-    if (!fn)
+    if (!fn || priority >= SCHEDULE_PRIORITY_COUNT)
         return false;
 
-    recurrent_fn_t* item = new (std::nothrow) recurrent_fn_t(repeat_us);
+    recurrent_fn_t* item = get_recurrent_fn(repeat_us);
     if (!item)
         return false;
 
@@ -122,15 +198,18 @@ bool schedule_recurrent_function_us(const std::function<bool(void)>& fn,
 
     esp8266::InterruptLock lockAllInterruptsInThisScope;
 
-    if (rLast)
+    if (rLast[priority])
     {
-        rLast->mNext = item;
+        rLast[priority]->mNext = item;
     }
     else
     {
-        rFirst = item;
+        rFirst[priority] = item;
     }
-    rLast = item;
+    rLast[priority] = item;
+
+    if (++rCount > rCountMax)
+        rCountMax = rCount;
 
     // grain needs to be recomputed
     recurrent_max_grain_mS = 0;
@@ -138,19 +217,43 @@ bool schedule_recurrent_function_us(const std::function<bool(void)>& fn,
     return true;
 }
 
+void set_scheduled_functions_budget_us(uint32_t budget_us)
+{
+    budget_uS = budget_us;
+}
+
+uint32_t get_scheduled_functions_budget_us()
+{
+    return budget_uS;
+}
+
+void get_scheduled_functions_stats(scheduled_fn_stats_t& stats)
+{
+    esp8266::InterruptLock lockAllInterruptsInThisScope;
+    stats.count = sQueued;
+    stats.max_count = sQueuedMax;
+    stats.overflow = sOverflow;
+}
+
+void get_scheduled_recurrent_functions_stats(scheduled_fn_stats_t& stats)
+{
+    esp8266::InterruptLock lockAllInterruptsInThisScope;
+    stats.count = rCount;
+    stats.max_count = rCountMax;
+    stats.overflow = rOverflow;
+}
+
 uint32_t compute_scheduled_recurrent_grain ()
 {
     if (recurrent_max_grain_mS == 0)
     {
-        if (rFirst)
-        {
-            uint32_t recurrent_max_grain_uS = rFirst->callNow.getTimeout();
-            for (auto it = rFirst->mNext; it; it = it->mNext)
+        uint32_t recurrent_max_grain_uS = 0;
+        for (auto first : rFirst)
+            for (auto it = first; it; it = it->mNext)
                 recurrent_max_grain_uS = std::gcd(recurrent_max_grain_uS, it->callNow.getTimeout());
-            if (recurrent_max_grain_uS)
-                // round to the upper millis
-                recurrent_max_grain_mS = recurrent_max_grain_uS <= 1000? 1: (recurrent_max_grain_uS + 999) / 1000;
-        }
+        if (recurrent_max_grain_uS)
+            // round to the upper millis
+            recurrent_max_grain_mS = recurrent_max_grain_uS <= 1000? 1: (recurrent_max_grain_uS + 999) / 1000;
 
 #ifdef DEBUG_ESP_CORE
         static uint32_t last_grain = 0;
@@ -165,69 +268,78 @@ uint32_t compute_scheduled_recurrent_grain ()
     return recurrent_max_grain_mS;
 }
 
+// both drain loops below share the same time budget
+static esp8266::polledTimeout::oneShotFastUs::timeType drain_budget()
+{
+    return budget_uS ? budget_uS : esp8266::polledTimeout::oneShotFastUs::neverExpires;
+}
+
 void run_scheduled_functions()
 {
-    // prevent scheduling of new functions during this run
-    auto stop = sLast;
-    bool done = false;
-    while (sFirst && !done)
-    {
-        done = sFirst == stop;
+    esp8266::polledTimeout::oneShotFastUs budget(drain_budget());
 
-        sFirst->mFunc();
+    for (int priority = 0; priority < SCHEDULE_PRIORITY_COUNT; ++priority)
+    {
+        auto& first = sFirst[priority];
+        auto& last = sLast[priority];
 
+        // prevent scheduling of new functions during this run
+        auto stop = last;
+        bool done = false;
+        while (first && !done)
         {
-            // remove function from stack
-            esp8266::InterruptLock lockAllInterruptsInThisScope;
+            done = first == stop;
+
+#if SCHEDULED_FN_PROFILING
+            const uint32_t start = esp_get_cycle_count();
+            first->mFunc();
+            profile_account(sProfile[priority], start);
+#else
+            first->mFunc();
+#endif
 
-            auto to_recycle = sFirst;
+            {
+                // remove function from stack
+                esp8266::InterruptLock lockAllInterruptsInThisScope;
 
-            // removing rLast
-            if (sLast == sFirst)
-                sLast = nullptr;
+                auto to_recycle = first;
 
-            sFirst = sFirst->mNext;
+                // removing last
+                if (last == first)
+                    last = nullptr;
 
-            recycle_fn_unsafe(to_recycle);
-        }
+                first = first->mNext;
 
-        // scheduled functions might last too long for watchdog etc.
-        // yield() is allowed in scheduled functions, therefore
-        // recursion into run_scheduled_recurrent_functions() is permitted
-        optimistic_yield(100000);
+                recycle_fn_unsafe(to_recycle);
+            }
+
+            // remaining functions are run on next call
+            if (budget)
+                return;
+
+            // scheduled functions might last too long for watchdog etc.
+            // yield() is allowed in scheduled functions, therefore
+            // recursion into run_scheduled_recurrent_functions() is permitted
+            optimistic_yield(100000);
+        }
     }
 }
 
-void run_scheduled_recurrent_functions()
+// returns false when the time budget is exhausted
+static bool run_scheduled_recurrent_list(int priority,
+    esp8266::polledTimeout::periodicFastMs& yieldNow,
+    esp8266::polledTimeout::oneShotFastUs& budget)
 {
-    esp8266::polledTimeout::periodicFastMs yieldNow(100); // yield every 100ms
-
-    // Note to the reader:
-    // There is no exposed API to remove a scheduled function:
-    // Scheduled functions are removed only from this function, and
-    // its purpose is that it is never called from an interrupt
-    // (always on cont stack).
+    auto& first = rFirst[priority];
+    auto& last = rLast[priority];
 
-    auto current = rFirst;
+    auto current = first;
     if (!current)
-        return;
-
-    static bool fence = false;
-    {
-        // fence is like a mutex but as we are never called from ISR,
-        // locking is useless here. Leaving comment for reference.
-        //esp8266::InterruptLock lockAllInterruptsInThisScope;
-
-        if (fence)
-            // prevent recursive calls from yield()
-            // (even if they are not allowed)
-            return;
-        fence = true;
-    }
+        return true;
 
     recurrent_fn_t* prev = nullptr;
     // prevent scheduling of new functions during this run
-    auto stop = rLast;
+    auto stop = last;
 
     bool done;
     do
@@ -235,17 +347,30 @@ void run_scheduled_recurrent_functions()
         done = current == stop;
         const bool wakeup = current->alarm && current->alarm();
         bool callNow = current->callNow;
+        bool called = wakeup || callNow;
+        bool keep = true;
+
+        if (called)
+        {
+#if SCHEDULED_FN_PROFILING
+            const uint32_t start = esp_get_cycle_count();
+            keep = current->mFunc();
+            profile_account(current->profile, start);
+#else
+            keep = current->mFunc();
+#endif
+        }
 
-        if ((wakeup || callNow) && !current->mFunc())
+        if (!keep)
         {
             // remove function from stack
             esp8266::InterruptLock lockAllInterruptsInThisScope;
 
             auto to_ditch = current;
 
-            // removing rLast
-            if (rLast == current)
-                rLast = prev;
+            // removing last
+            if (last == current)
+                last = prev;
 
             current = current->mNext;
             if (prev)
@@ -254,10 +379,10 @@ void run_scheduled_recurrent_functions()
             }
             else
             {
-                rFirst = current;
+                first = current;
             }
 
-            delete(to_ditch);
+            recycle_recurrent_fn_unsafe(to_ditch);
 
             // grain needs to be recomputed
             recurrent_max_grain_mS = 0;
@@ -276,7 +401,79 @@ void run_scheduled_recurrent_functions()
             esp_schedule();
             cont_suspend(g_pcont);
         }
+
+        // functions which did not run yet keep their expired
+        // periodic timer and will be called on next yield()
+        if (called && budget)
+            return false;
     } while (current && !done);
 
+    return true;
+}
+
+void run_scheduled_recurrent_functions()
+{
+    esp8266::polledTimeout::periodicFastMs yieldNow(100); // yield every 100ms
+    esp8266::polledTimeout::oneShotFastUs budget(drain_budget());
+
+    // Note to the reader:
+    // There is no exposed API to remove a scheduled function:
+    // Scheduled functions are removed only from this function, and
+    // its purpose is that it is never called from an interrupt
+    // (always on cont stack).
+
+    static bool fence = false;
+    {
+        // fence is like a mutex but as we are never called from ISR,
+        // locking is useless here. Leaving comment for reference.
+        //esp8266::InterruptLock lockAllInterruptsInThisScope;
+
+        if (fence)
+            // prevent recursive calls from yield()
+            // (even if they are not allowed)
+            return;
+        fence = true;
+    }
+
+    for (int priority = 0; priority < SCHEDULE_PRIORITY_COUNT; ++priority)
+        if (!run_scheduled_recurrent_list(priority, yieldNow, budget))
+            break;
+
     fence = false;
 }
+
+void print_scheduled_functions_profile(Print& out)
+{
+#if SCHEDULED_FN_PROFILING
+    static const char* const names[SCHEDULE_PRIORITY_COUNT] = { "high", "normal", "low" };
+    auto print = [&out](const char* kind, int index, uint32_t period_us, const scheduled_fn_profile_t& profile)
+    {
+        out.printf_P(PSTR("%s %d period=%uus calls=%u cycles=%llu max=%u avg=%u\n"),
+            kind, index, period_us, profile.calls, (unsigned long long)profile.cycles, profile.max_cycles,
+            profile.calls ? (uint32_t)(profile.cycles / profile.calls) : 0);
+    };
+
+    for (int priority = 0; priority < SCHEDULE_PRIORITY_COUNT; ++priority)
+    {
+        out.printf_P(PSTR("scheduled %s:\n"), names[priority]);
+        print("once", 0, 0, sProfile[priority]);
+        int index = 0;
+        for (auto it = rFirst[priority]; it; it = it->mNext)
+            print("recurrent", index++, it->callNow.getTimeout(), it->profile);
+    }
+#else
+    (void)out;
+#endif
+}
+
+void reset_scheduled_functions_profile()
+{
+#if SCHEDULED_FN_PROFILING
+    esp8266::InterruptLock lockAllInterruptsInThisScope;
+    for (auto& profile : sProfile)
+        profile = { };
+    for (auto first : rFirst)
+        for (auto it = first; it; it = it->mNext)
+            it->profile = { };
+#endif
+}
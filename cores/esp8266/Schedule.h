@@ -22,7 +22,20 @@
 #include <functional>
 #include <stdint.h>
 
+#ifndef SCHEDULED_FN_MAX_COUNT
 #define SCHEDULED_FN_MAX_COUNT 32
+#endif
+
+// number of recurrent function slots reserved at build time,
+// further registrations fall back to the heap
+// enable per function call count and cpu cycles accounting
+#ifndef SCHEDULED_FN_PROFILING
+#define SCHEDULED_FN_PROFILING 0
+#endif
+
+#ifndef SCHEDULED_RECURRENT_FN_POOL_COUNT
+#define SCHEDULED_RECURRENT_FN_POOL_COUNT 8
+#endif
 
 // The purpose of scheduled functions is to trigger, from SYS stack (like in
 // an interrupt or a system event), registration of user code to be executed
@@ -39,6 +52,31 @@
 // scheduled function happen more often: every yield() (vs every loop()),
 // and time resolution is microsecond (vs millisecond). Details are below.
 
+// Priority classes:
+// Both kinds of scheduled functions are kept in one FIFO per priority
+// class.  Higher classes are always drained before lower ones, so a slow
+// low priority function can't delay latency sensitive ones behind it.
+// Functions scheduled without priority use SCHEDULE_PRIORITY_NORMAL,
+// which keeps the historical plain FIFO behaviour.
+
+enum schedule_priority_e : uint8_t
+{
+    SCHEDULE_PRIORITY_HIGH = 0,
+    SCHEDULE_PRIORITY_NORMAL,
+    SCHEDULE_PRIORITY_LOW,
+    SCHEDULE_PRIORITY_COUNT
+};
+
+// Time budget:
+// When set, run_scheduled_functions() and run_scheduled_recurrent_functions()
+// stop draining the queues once <budget_us> microseconds have elapsed (checked
+// after each call).  Remaining functions are kept and are run on the next
+// call, which is after next `loop()` for scheduled functions, and on next
+// `yield()` for recurrent ones.  A budget of 0 (default) means unlimited.
+
+void set_scheduled_functions_budget_us(uint32_t budget_us);
+uint32_t get_scheduled_functions_budget_us();
+
 // compute_scheduled_recurrent_grain() is used by delay() to give a chance to
 // all recurrent functions to run per their timing requirement.
 
@@ -46,7 +84,7 @@ uint32_t compute_scheduled_recurrent_grain ();
 
 // scheduled functions called once:
 //
-// * internal queue is FIFO.
+// * internal queue is FIFO (per priority class).
 // * Add the given lambda to a fifo list of lambdas, which is run when
 //   `loop` function returns.
 // * Use lambdas to pass arguments to a function, or call a class/static
@@ -56,11 +94,15 @@ uint32_t compute_scheduled_recurrent_grain ();
 // * There is no mechanism for cancelling scheduled functions.
 // * `yield` can be called from inside lambdas.
 // * Returns false if the number of scheduled functions exceeds
-//   SCHEDULED_FN_MAX_COUNT (or memory shortage).
+//   SCHEDULED_FN_MAX_COUNT.
+// * Slots are reserved at build time, scheduling itself never allocates.
+//   Lambdas capturing at most two pointer-sized trivially copyable values
+//   fit in std::function's inline storage and won't allocate either.
 // * Run the lambda only once next time.
 // * A scheduled function can schedule a function.
 
-bool schedule_function (const std::function<void(void)>& fn);
+bool schedule_function (const std::function<void(void)>& fn,
+    schedule_priority_e priority = SCHEDULE_PRIORITY_NORMAL);
 
 // Run all scheduled functions.
 // Use this function if your are not using `loop`,
@@ -70,7 +112,7 @@ void run_scheduled_functions();
 
 // recurrent scheduled function:
 //
-// * Internal queue is a FIFO.
+// * Internal queue is a FIFO (per priority class).
 // * Run the lambda periodically about every <repeat_us> microseconds until
 //   it returns false.
 // * Note that it may be more than <repeat_us> microseconds between calls if
@@ -86,11 +128,79 @@ void run_scheduled_functions();
 //   any remaining delay from repeat_us is disregarded, and fn is executed.
 
 bool schedule_recurrent_function_us(const std::function<bool(void)>& fn,
-    uint32_t repeat_us, const std::function<bool(void)>& alarm = nullptr);
+    uint32_t repeat_us, const std::function<bool(void)>& alarm = nullptr,
+    schedule_priority_e priority = SCHEDULE_PRIORITY_NORMAL);
 
 // Test recurrence and run recurrent scheduled functions.
 // (internally called at every `yield()` and `loop()`)
 
 void run_scheduled_recurrent_functions();
 
+// queue usage counters:
+//
+// * `count` is the number of functions currently waiting.
+// * `max_count` is the high-water mark since boot.
+// * `overflow` counts rejected schedule_function() calls (queue full).
+// * for recurrent functions, `overflow` counts registrations which did not
+//   fit in the reserved slots and had to be allocated from the heap.
+
+struct scheduled_fn_stats_t
+{
+    uint16_t count;
+    uint16_t max_count;
+    uint32_t overflow;
+};
+
+void get_scheduled_functions_stats(scheduled_fn_stats_t& stats);
+void get_scheduled_recurrent_functions_stats(scheduled_fn_stats_t& stats);
+
+// profiling (only when built with -DSCHEDULED_FN_PROFILING=1):
+//
+// * each recurrent function accounts its own calls, and also
+//   cumulative and maximum cpu cycles spent in one call.
+// * one-shot scheduled functions are accounted per priority class.
+// * `yield()` or `delay()` inside a scheduled function are accounted to it.
+// * print_scheduled_functions_profile() dumps one line per entry, recurrent
+//   functions are listed in registration order along with their period.
+// * the functions below are empty when profiling is not enabled.
+
+// periodic housekeeping functions:
+//
+// * Run the lambda about every <period_ms> milliseconds until it returns
+//   false or is cancelled.
+// * Meant for network housekeeping (keepalives, announcements, checks...)
+//   which don't need to be accurate: all these functions share a single
+//   os_timer, armed for the next one due.  When it fires, every function due,
+//   or due within an eighth of its period, is run, so that close deadlines
+//   are batched into one wakeup and functions with the same period end up
+//   in phase.  Unlike recurrent functions, they are not polled at every
+//   yield(), and the CPU can stay asleep between two batches.
+// * A batch is run in CONT stack, from the next yield() or loop() after the
+//   wakeup, with the same restrictions as recurrent functions.
+// * Slots are reserved at build time, returns 0 when they are all used,
+//   otherwise an id for cancel_periodic_function().
+// * Not to be called from ISR.
+
+#ifndef SCHEDULED_PERIODIC_FN_MAX_COUNT
+#define SCHEDULED_PERIODIC_FN_MAX_COUNT 8
+#endif
+
+uint32_t schedule_periodic_function_ms(const std::function<bool(void)>& fn, uint32_t period_ms);
+
+// returns false when the id is not running anymore,
+// a function may cancel itself
+bool cancel_periodic_function(uint32_t id);
+
+class Print;
+
+struct scheduled_fn_profile_t
+{
+    uint32_t calls;
+    uint32_t max_cycles;
+    uint64_t cycles;
+};
+
+void print_scheduled_functions_profile(Print& out);
+void reset_scheduled_functions_profile();
+
 #endif // ESP_SCHEDULE_H
@@ -0,0 +1,164 @@
+/*
+ SchedulePeriodic.cpp - Periodic housekeeping functions sharing one timer.
+ Copyright (c) 2020 esp8266/Arduino
+ 
+ This file is part of the esp8266 core for Arduino environment.
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <ets_sys.h>
+#include <osapi.h>
+
+#include "Schedule.h"
+#include "PolledTimeout.h"
+
+enum periodic_state_e : uint8_t
+{
+    PERIODIC_FREE = 0,
+    PERIODIC_ACTIVE,
+    PERIODIC_CANCELLED, // while running, freed after the call
+};
+
+struct periodic_fn_t
+{
+    std::function<bool(void)> mFunc;
+    esp8266::polledTimeout::oneShotMs due { 0 };
+    uint32_t period = 0;
+    uint16_t generation = 0;
+    periodic_state_e state = PERIODIC_FREE;
+};
+
+static periodic_fn_t pSlots[SCHEDULED_PERIODIC_FN_MAX_COUNT];
+static ETSTimer pTimer;
+static bool pTimerReady = false;
+static bool pBatchPending = false; // set from the timer, cleared by the batch
+static int pRunning = -1;
+
+static uint32_t periodic_id(int slot)
+{
+    return ((uint32_t)pSlots[slot].generation << 8) | (slot + 1);
+}
+
+static void periodic_free(periodic_fn_t& slot)
+{
+    slot.mFunc = nullptr;
+    slot.state = PERIODIC_FREE;
+    ++slot.generation;
+}
+
+static bool periodic_early(periodic_fn_t& slot)
+{
+    return slot.due.remaining() <= slot.period / 8;
+}
+
+static void periodic_arm();
+
+static bool periodic_run_batch()
+{
+    pBatchPending = false;
+
+    for (int i = 0; i < SCHEDULED_PERIODIC_FN_MAX_COUNT; ++i)
+    {
+        periodic_fn_t& slot = pSlots[i];
+        if (slot.state != PERIODIC_ACTIVE || !periodic_early(slot))
+            continue;
+
+        // next deadline is counted from this batch, this is what brings
+        // functions of the same period in phase
+        slot.due.reset(slot.period);
+
+        pRunning = i;
+        bool keep = slot.mFunc();
+        pRunning = -1;
+
+        if (!keep || slot.state == PERIODIC_CANCELLED)
+            periodic_free(slot);
+    }
+
+    periodic_arm();
+    return false;
+}
+
+static void periodic_wakeup(void*)
+{
+    if (!pBatchPending)
+        pBatchPending = schedule_recurrent_function_us(periodic_run_batch, 0);
+}
+
+static void periodic_arm()
+{
+    if (!pTimerReady)
+    {
+        os_timer_setfn(&pTimer, periodic_wakeup, nullptr);
+        pTimerReady = true;
+    }
+    os_timer_disarm(&pTimer);
+
+    if (pBatchPending)
+        // the batch will arm again
+        return;
+
+    using oneShotMs = esp8266::polledTimeout::oneShotMs;
+    oneShotMs::timeType next = oneShotMs::neverExpires;
+    for (auto& slot : pSlots)
+        if (slot.state == PERIODIC_ACTIVE)
+            next = std::min(next, slot.due.remaining());
+
+    if (next != oneShotMs::neverExpires)
+    {
+        // longest delay of os_timer_arm(), a longer period wakes up for nothing once
+        next = std::min(next, (oneShotMs::timeType)0x68D7A3);
+        os_timer_arm(&pTimer, next ? next : 1, false);
+    }
+}
+
+uint32_t schedule_periodic_function_ms(const std::function<bool(void)>& fn, uint32_t period_ms)
+{
+    if (!fn || !period_ms)
+        return 0;
+
+    for (int i = 0; i < SCHEDULED_PERIODIC_FN_MAX_COUNT; ++i)
+    {
+        periodic_fn_t& slot = pSlots[i];
+        if (slot.state != PERIODIC_FREE)
+            continue;
+
+        slot.mFunc = fn;
+        slot.period = period_ms;
+        slot.due.reset(period_ms);
+        slot.state = PERIODIC_ACTIVE;
+        periodic_arm();
+        return periodic_id(i);
+    }
+
+    return 0;
+}
+
+bool cancel_periodic_function(uint32_t id)
+{
+    int i = (int)(id & 0xff) - 1;
+    if (i < 0 || i >= SCHEDULED_PERIODIC_FN_MAX_COUNT)
+        return false;
+
+    periodic_fn_t& slot = pSlots[i];
+    if (slot.state != PERIODIC_ACTIVE || periodic_id(i) != id)
+        return false;
+
+    if (pRunning == i)
+        slot.state = PERIODIC_CANCELLED;
+    else
+        periodic_free(slot);
+
+    // the timer may fire for nothing, it is armed again then
+    return true;
+}
@@ -0,0 +1,196 @@
+/*
+ SpscRing.h - single producer / single consumer ring buffer
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SPSCRING_H
+#define __SPSCRING_H
+
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+
+// SpscRing hands data from one producer (typically an ISR) to one consumer
+// (typically the loop) without masking interrupts. The producer only writes
+// the write index, the consumer only writes the read index, and each side
+// publishes its index after the data it covers.
+//
+// Producer side methods are forced inline, so an IRAM_ATTR ISR using them
+// does not call into flash.
+//
+// One element is kept unused to tell full from empty, a ring of `size`
+// elements holds at most `size - 1` of them.
+//
+// The storage is supplied by the owner through init(), the ring itself has
+// no constructor and can live in malloc'ed C structs. init() and reset()
+// require both sides to be quiescent (e.g. the ISR disabled).
+
+#define SPSC_ALWAYS_INLINE inline __attribute__((always_inline))
+
+namespace esp8266
+{
+
+template <typename T>
+class SpscRing
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRing elements are copied with memcpy");
+
+public:
+    void init(T* buffer, size_t size, size_t used = 0)
+    {
+        _buffer = buffer;
+        _size = size;
+        _rpos = 0;
+        _wpos = used;
+    }
+
+    void reset()
+    {
+        _rpos = 0;
+        _wpos = 0;
+    }
+
+    T* buffer() const
+    {
+        return _buffer;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    ////////////////////////////////////////////// producer
+
+    SPSC_ALWAYS_INLINE bool push(const T& value)
+    {
+        size_t wpos = _wpos;
+        size_t next = wpos + 1;
+        if (next == _size)
+        {
+            next = 0;
+        }
+        if (next == _rpos)
+        {
+            return false;
+        }
+        _buffer[wpos] = value;
+        barrier();
+        _wpos = next;
+        return true;
+    }
+
+    SPSC_ALWAYS_INLINE bool full() const
+    {
+        size_t next = _wpos + 1;
+        return (next == _size ? 0 : next) == _rpos;
+    }
+
+    ////////////////////////////////////////////// consumer
+
+    size_t available() const
+    {
+        size_t wpos = _wpos;
+        size_t rpos = _rpos;
+        return wpos >= rpos ? wpos - rpos : _size - rpos + wpos;
+    }
+
+    bool empty() const
+    {
+        return _wpos == _rpos;
+    }
+
+    // contiguous readable elements at peekBuffer()
+    size_t peekAvailable() const
+    {
+        size_t wpos = _wpos;
+        size_t rpos = _rpos;
+        return wpos >= rpos ? wpos - rpos : _size - rpos;
+    }
+
+    const T* peekBuffer() const
+    {
+        return &_buffer[_rpos];
+    }
+
+    // only valid when !empty()
+    T peek() const
+    {
+        return _buffer[_rpos];
+    }
+
+    void consume(size_t count)
+    {
+        size_t rpos = _rpos + count;
+        if (rpos >= _size)
+        {
+            rpos -= _size;
+        }
+        barrier();
+        _rpos = rpos;
+    }
+
+    bool pop(T& value)
+    {
+        if (empty())
+        {
+            return false;
+        }
+        value = peek();
+        consume(1);
+        return true;
+    }
+
+    size_t read(T* dst, size_t count)
+    {
+        size_t done = 0;
+        while (done < count)
+        {
+            size_t chunk = peekAvailable();
+            if (!chunk)
+            {
+                break;
+            }
+            if (chunk > count - done)
+            {
+                chunk = count - done;
+            }
+            memcpy(dst + done, peekBuffer(), chunk * sizeof(T));
+            consume(chunk);
+            done += chunk;
+        }
+        return done;
+    }
+
+protected:
+    static SPSC_ALWAYS_INLINE void barrier()
+    {
+        // single core: ordering against the ISR only needs the compiler
+        __asm__ __volatile__("" ::: "memory");
+    }
+
+    T* _buffer;
+    size_t _size;
+    volatile size_t _rpos;
+    volatile size_t _wpos;
+};
+
+} // namespace esp8266
+
+#endif // __SPSCRING_H
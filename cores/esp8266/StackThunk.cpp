@@ -42,9 +42,19 @@ uint32_t *stack_thunk_save = NULL;  /* Saved A1 while in BearSSL */
 uint32_t stack_thunk_refcnt = 0;
 
 /* Largest stack usage seen in the wild at  6120 */
-#define _stackSize (6200/4)
+#ifndef STACK_THUNK_SIZE
+#define STACK_THUNK_SIZE 6200
+#endif
 #define _stackPaint 0xdeadbeef
 
+/* In words, may be changed while no stack is allocated */
+static uint32_t _stackSize = STACK_THUNK_SIZE / 4;
+
+/* Per-operation profiling, see stack_thunk_profile_begin() */
+static bool _profiling = false;
+static uint32_t _profiled_max = 0;
+static uint32_t _op_max_usage[STACK_THUNK_OP_COUNT];
+
 /* Add a reference, and allocate the stack if necessary */
 void stack_thunk_add_ref()
 {
@@ -87,9 +97,84 @@ void stack_thunk_del_ref()
 
 void stack_thunk_repaint()
 {
-  for (int i=0; i < _stackSize; i++) {
+  for (uint32_t i=0; i < _stackSize; i++) {
     stack_thunk_ptr[i] = _stackPaint;
   }
+  _profiled_max = 0;
+}
+
+/* Bytes used since the last repaint, full or by stack_thunk_profile_begin() */
+static uint32_t _painted_usage()
+{
+  uint32_t cnt = 0;
+
+  /* No stack == no usage by definition! */
+  if (!stack_thunk_ptr) {
+    return 0;
+  }
+
+  for (cnt=0; (cnt < _stackSize) && (stack_thunk_ptr[cnt] == _stackPaint); cnt++) {
+    /* Noop, all work done in for() */
+  }
+  return 4 * (_stackSize - cnt);
+}
+
+/* Change the size of the stack allocated by the next first reference */
+bool stack_thunk_set_size(uint32_t bytes)
+{
+  if (stack_thunk_ptr || (bytes < 1024)) {
+    return false;
+  }
+  _stackSize = bytes / 4;
+  return true;
+}
+
+uint32_t stack_thunk_get_size()
+{
+  return 4 * _stackSize;
+}
+
+void stack_thunk_profile(bool enable)
+{
+  _profiling = enable;
+  for (int i = 0; i < STACK_THUNK_OP_COUNT; i++) {
+    _op_max_usage[i] = 0;
+  }
+}
+
+/* Before an operation: repaint the part of the stack used so far, so that
+ * stack_thunk_profile_end() only sees the usage of this operation */
+void stack_thunk_profile_begin()
+{
+  if (!_profiling || !stack_thunk_ptr) {
+    return;
+  }
+  uint32_t used = _painted_usage();
+  if (used > _profiled_max) {
+    _profiled_max = used;
+  }
+  for (uint32_t i = _stackSize - used / 4; i < _stackSize; i++) {
+    stack_thunk_ptr[i] = _stackPaint;
+  }
+}
+
+void stack_thunk_profile_end(int op)
+{
+  if (!_profiling || !stack_thunk_ptr || (op < 0) || (op >= STACK_THUNK_OP_COUNT)) {
+    return;
+  }
+  uint32_t used = _painted_usage();
+  if (used > _op_max_usage[op]) {
+    _op_max_usage[op] = used;
+  }
+}
+
+uint32_t stack_thunk_get_op_max_usage(int op)
+{
+  if ((op < 0) || (op >= STACK_THUNK_OP_COUNT)) {
+    return 0;
+  }
+  return _op_max_usage[op];
 }
 
 /* Simple accessor functions used by postmortem */
@@ -112,17 +197,8 @@ uint32_t stack_thunk_get_cont_sp() {
 /* Return the number of bytes ever used since the stack was created */
 uint32_t stack_thunk_get_max_usage()
 {
-  uint32_t cnt = 0;
-
-  /* No stack == no usage by definition! */
-  if (!stack_thunk_ptr) {
-    return 0;
-  }
-
-  for (cnt=0; (cnt < _stackSize) && (stack_thunk_ptr[cnt] == _stackPaint); cnt++) {
-    /* Noop, all work done in for() */
-  }
-  return 4 * (_stackSize - cnt);
+  uint32_t used = _painted_usage();
+  return (used > _profiled_max) ? used : _profiled_max;
 }
 
 /* Print the stack from the first used 16-byte chunk to the top, decodable by the exception decoder */
@@ -27,6 +27,9 @@
 #ifndef _STACKTHUNK_H
 #define _STACKTHUNK_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -43,6 +46,25 @@ extern uint32_t stack_thunk_get_max_usage();
 extern void stack_thunk_dump_stack();
 extern void stack_thunk_fatal_smashing();
 
+// Size of the stack, STACK_THUNK_SIZE (6200) bytes by default.  Can only be
+// changed while no stack is allocated (before the first BearSSL object).
+extern bool stack_thunk_set_size(uint32_t bytes);
+extern uint32_t stack_thunk_get_size();
+
+// Per-operation stack profiling: when enabled, the stack is repainted before
+// each profiled operation and its usage recorded by kind of operation
+enum {
+  STACK_THUNK_OP_HANDSHAKE, // TLS records received before the handshake is done, including certificate validation
+  STACK_THUNK_OP_ENCRYPT,   // application data sent
+  STACK_THUNK_OP_DECRYPT,   // TLS records received after the handshake
+  STACK_THUNK_OP_VERIFY,    // signed update verification
+  STACK_THUNK_OP_COUNT
+};
+extern void stack_thunk_profile(bool enable); // Also clears the recorded usages
+extern void stack_thunk_profile_begin();
+extern void stack_thunk_profile_end(int op);
+extern uint32_t stack_thunk_get_op_max_usage(int op);
+
 // Globals required for thunking operation
 extern uint32_t *stack_thunk_ptr;
 extern uint32_t *stack_thunk_top;
@@ -23,6 +23,7 @@
 #include <limits>
 #include <esp_priv.h>
 #include <StreamString.h>
+#include <cbuf.h>
 
 ///////////////////////////////////////////////
 // /dev/null
@@ -234,6 +235,195 @@ public:
     }
 };
 
+///////////////////////////////////////////////
+// circular buffer
+// - output: writes into the cbuf, availableForWrite = room
+// - input: reads from the cbuf, peekBuffer API on its first segment
+// Stream::send*() drains a wrapped cbuf in two zero-copy steps.
+
+class StreamCbuf: public Stream
+{
+protected:
+    cbuf& _cbuf;
+
+public:
+    StreamCbuf(cbuf& buffer): _cbuf(buffer) { }
+
+    // Print
+    virtual size_t write(uint8_t c) override
+    {
+        return _cbuf.write((char)c);
+    }
+
+    virtual size_t write(const uint8_t* buffer, size_t size) override
+    {
+        return _cbuf.write((const char*)buffer, size);
+    }
+
+    virtual int availableForWrite() override
+    {
+        return _cbuf.room();
+    }
+
+    virtual bool outputCanTimeout() override
+    {
+        return false;
+    }
+
+    // Stream
+    virtual int available() override
+    {
+        return _cbuf.available();
+    }
+
+    virtual int read() override
+    {
+        return _cbuf.read();
+    }
+
+    virtual int peek() override
+    {
+        return _cbuf.peek();
+    }
+
+    virtual size_t readBytes(char* buffer, size_t len) override
+    {
+        return _cbuf.read(buffer, len);
+    }
+
+    virtual int read(uint8_t* buffer, size_t len) override
+    {
+        return _cbuf.read((char*)buffer, len);
+    }
+
+    virtual bool inputCanTimeout() override
+    {
+        return false;
+    }
+
+    virtual ssize_t streamRemaining() override
+    {
+        return _cbuf.available();
+    }
+
+    // peekBuffer
+    virtual bool hasPeekBufferAPI() const override
+    {
+        return true;
+    }
+
+    virtual size_t peekAvailable() override
+    {
+        return _cbuf.peekAvailable();
+    }
+
+    virtual const char* peekBuffer() override
+    {
+        return _cbuf.peekBuffer();
+    }
+
+    virtual void peekConsume(size_t consume) override
+    {
+        _cbuf.consume(consume);
+    }
+};
+
+///////////////////////////////////////////////
+// bounded pipe, from a producer to a consumer in constant memory
+// - output: writes what fits, availableForWrite = room, a writer with a
+//   timeout waits for the reader to make room (back-pressure), or produces
+//   in place through writeBuffer() then writeCommit()
+// - input: reads what was written, peekBuffer API, ends when the writer
+//   has called close() and everything is read
+// Both ends are usually driven from loop(), as in:
+//     file.sendAvailable(pipe);     // producer, as much as fits
+//     pipe.sendAvailable(client);   // consumer, straight from the pipe
+//     if (!file.available()) pipe.close();
+
+class StreamPipe: public StreamCbuf
+{
+protected:
+    cbuf _pipe;
+    bool _closed = false;
+
+public:
+    // one more byte is allocated, the cbuf keeps one free
+    StreamPipe(size_t capacity): StreamCbuf(_pipe), _pipe(capacity + 1) { }
+
+    // no more writes, the reader gets to the end of stream
+    void close()
+    {
+        _closed = true;
+    }
+
+    bool closed() const
+    {
+        return _closed;
+    }
+
+    // empty and open again
+    void reset()
+    {
+        _pipe.flush();
+        _closed = false;
+    }
+
+    // producing in place: the first free segment, write at most
+    // writeBufferAvailable() bytes at writeBuffer() then writeCommit() them
+    size_t writeBufferAvailable()
+    {
+        cbuf::span spans[2];
+        _pipe.writeSpans(spans);
+        return _closed ? 0 : spans[0].size;
+    }
+
+    char* writeBuffer()
+    {
+        cbuf::span spans[2];
+        _pipe.writeSpans(spans);
+        return spans[0].data;
+    }
+
+    void writeCommit(size_t size)
+    {
+        _pipe.commit(size);
+    }
+
+    // Print
+    virtual size_t write(uint8_t c) override
+    {
+        return _closed ? 0 : StreamCbuf::write(c);
+    }
+
+    virtual size_t write(const uint8_t* buffer, size_t size) override
+    {
+        return _closed ? 0 : StreamCbuf::write(buffer, size);
+    }
+
+    virtual int availableForWrite() override
+    {
+        return _closed ? 0 : StreamCbuf::availableForWrite();
+    }
+
+    virtual bool outputCanTimeout() override
+    {
+        // the reader frees room, until closed
+        return !_closed;
+    }
+
+    // Stream
+    virtual bool inputCanTimeout() override
+    {
+        // the writer brings more, until closed
+        return !_closed;
+    }
+
+    virtual ssize_t streamRemaining() override
+    {
+        return _closed ? _pipe.available() : -1;
+    }
+};
+
 ///////////////////////////////////////////////
 
 Stream& operator << (Stream& out, String& string);
@@ -0,0 +1,222 @@
+/*
+ StringBuilder.cpp - append-only text in a chain of chunks
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdlib.h>
+#include "StringBuilder.h"
+
+StringBuilder::StringBuilder(size_t chunkSize)
+    : _chunkSize(chunkSize ? chunkSize : 1)
+{
+}
+
+StringBuilder::~StringBuilder()
+{
+    clear();
+}
+
+void StringBuilder::clear()
+{
+    while (_head)
+    {
+        Chunk* next = _head->next;
+        free(_head);
+        _head = next;
+    }
+    _tail = _read = nullptr;
+    _readPos = _length = _consumed = 0;
+    _failed = false;
+}
+
+StringBuilder::Chunk* StringBuilder::_addChunk(size_t size)
+{
+    // a large append gets a chunk of its own, not a run of small ones
+    size = std::max(size, _chunkSize);
+    Chunk* chunk = (Chunk*)malloc(sizeof(Chunk) + size);
+    if (!chunk)
+    {
+        _failed = true;
+        return nullptr;
+    }
+    chunk->next = nullptr;
+    chunk->size = size;
+    chunk->used = 0;
+    if (_tail)
+    {
+        _tail->next = chunk;
+    }
+    else
+    {
+        _head = _read = chunk;
+    }
+    _tail = chunk;
+    return chunk;
+}
+
+size_t StringBuilder::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t StringBuilder::write(const uint8_t* buffer, size_t size)
+{
+    return append(StringView((const char*)buffer, size));
+}
+
+size_t StringBuilder::append(StringView view)
+{
+    size_t written = 0;
+    while (written < view.length())
+    {
+        Chunk* chunk = _tail;
+        if (!chunk || chunk->used == chunk->size)
+        {
+            chunk = _addChunk(view.length() - written);
+            if (!chunk)
+            {
+                break;
+            }
+        }
+        size_t len = std::min(view.length() - written, chunk->size - chunk->used);
+        if (view.isProgmem())
+        {
+            memcpy_P(chunk->data() + chunk->used, view.data() + written, len);
+        }
+        else
+        {
+            memcpy(chunk->data() + chunk->used, view.data() + written, len);
+        }
+        chunk->used += len;
+        written += len;
+    }
+    _length += written;
+    return written;
+}
+
+StringBuilder::Chunk* StringBuilder::_readChunk()
+{
+    while (_read && _readPos == _read->used && _read->next)
+    {
+        _read = _read->next;
+        _readPos = 0;
+    }
+    return _read;
+}
+
+size_t StringBuilder::peekAvailable()
+{
+    Chunk* chunk = _readChunk();
+    return chunk ? chunk->used - _readPos : 0;
+}
+
+const char* StringBuilder::peekBuffer()
+{
+    Chunk* chunk = _readChunk();
+    return chunk ? chunk->data() + _readPos : nullptr;
+}
+
+void StringBuilder::peekConsume(size_t consume)
+{
+    consume = std::min(consume, peekAvailable());
+    _readPos += consume;
+    _consumed += consume;
+}
+
+int StringBuilder::peek()
+{
+    return peekAvailable() ? (uint8_t)*peekBuffer() : -1;
+}
+
+int StringBuilder::read()
+{
+    int c = peek();
+    if (c >= 0)
+    {
+        peekConsume(1);
+    }
+    return c;
+}
+
+int StringBuilder::read(uint8_t* buffer, size_t len)
+{
+    size_t done = 0;
+    size_t avail;
+    while (done < len && (avail = peekAvailable()))
+    {
+        size_t chunk = std::min(len - done, avail);
+        memcpy(buffer + done, peekBuffer(), chunk);
+        peekConsume(chunk);
+        done += chunk;
+    }
+    return done;
+}
+
+String StringBuilder::toString() const
+{
+    String str;
+    if (!str.reserve(length()))
+    {
+        return str;
+    }
+    size_t pos = _readPos;
+    for (Chunk* chunk = _read; chunk; chunk = chunk->next, pos = 0)
+    {
+        str.concat(chunk->data() + pos, chunk->used - pos);
+    }
+    return str;
+}
+
+size_t StringBuilder::writeTo(Print& out)
+{
+    static constexpr size_t maxIov = 8;
+    Print::iovec iov[maxIov];
+    size_t sent = 0;
+    while (length())
+    {
+        size_t count = 0;
+        size_t total = 0;
+        Chunk* chunk = _readChunk();
+        for (size_t pos = _readPos; chunk && count < maxIov; chunk = chunk->next, pos = 0)
+        {
+            if (chunk->used > pos)
+            {
+                iov[count++] = { chunk->data() + pos, chunk->used - pos };
+                total += chunk->used - pos;
+            }
+        }
+        size_t written = out.write(iov, count);
+        sent += written;
+        for (size_t left = written; left; )
+        {
+            size_t len = std::min(left, peekAvailable());
+            if (!len)
+            {
+                break;
+            }
+            peekConsume(len);
+            left -= len;
+        }
+        if (written < total)
+        {
+            break;
+        }
+    }
+    return sent;
+}
@@ -0,0 +1,160 @@
+/*
+ StringBuilder.h - append-only text in a chain of chunks
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __STRINGBUILDER_H
+#define __STRINGBUILDER_H
+
+#include <limits>
+#include "Stream.h"
+#include "WString.h"
+
+///////////////////////////////////////////////////////////////
+// StringBuilder assembles a response (JSON, HTML...) without the
+// reallocations of a growing String: what is printed or appended goes
+// into chunks of chunkSize bytes chained together, a full chunk is never
+// moved or resized, and all the chunks are freed at once by clear() or
+// the destructor.
+//
+// It is read as a Stream with the peek buffer API, one chunk at a time,
+// so it is sent without a copy with ESP8266WebServer::send(code, type,
+// builder) or builder.sendAll(client).  writeTo() hands all the chunks to
+// Print::write(iovec) at once, which lets network clients emit them in a
+// single push.
+//
+//    StringBuilder json;
+//    json += F("{\"uptime\":");
+//    json += millis();
+//    json.printf(",\"heap\":%u}", ESP.getFreeHeap());
+//    server.send(200, "application/json", json);
+
+class StringBuilder: public Stream
+{
+public:
+    StringBuilder(size_t chunkSize = 256);
+    StringBuilder(const StringBuilder&) = delete;
+    StringBuilder& operator=(const StringBuilder&) = delete;
+    virtual ~StringBuilder();
+
+    // free all the chunks, the builder is empty and may be reused
+    void clear();
+
+    // characters not read yet, all of them until read
+    size_t length() const
+    {
+        return _length - _consumed;
+    }
+    // false once an allocation failed, the text is then truncated
+    explicit operator bool() const
+    {
+        return !_failed;
+    }
+
+    size_t append(StringView view);
+    template <typename T>
+    StringBuilder& operator+=(const T& value)
+    {
+        print(value);
+        return *this;
+    }
+    StringBuilder& operator+=(StringView view)
+    {
+        append(view);
+        return *this;
+    }
+
+    // a copy of what is left to read, in one String
+    String toString() const;
+
+    // send what is left to read with as few Print::write(iovec) calls as
+    // possible, and consume what was sent
+    size_t writeTo(Print& out);
+
+    // Print
+    virtual size_t write(uint8_t c) override;
+    virtual size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    virtual int availableForWrite() override
+    {
+        return std::numeric_limits<int16_t>::max();
+    }
+
+    // Stream
+    virtual int available() override
+    {
+        return std::min(length(), (size_t)std::numeric_limits<int>::max());
+    }
+    virtual int read() override;
+    virtual int peek() override;
+    virtual int read(uint8_t* buffer, size_t len) override;
+
+    virtual void flush() override { }
+
+    virtual bool inputCanTimeout() override
+    {
+        return false;
+    }
+    virtual bool outputCanTimeout() override
+    {
+        return false;
+    }
+    virtual ssize_t streamRemaining() override
+    {
+        return length();
+    }
+
+    // Stream's peekBufferAPI, the unread part of the current chunk
+    virtual bool hasPeekBufferAPI() const override
+    {
+        return true;
+    }
+    virtual size_t peekAvailable() override;
+    virtual const char* peekBuffer() override;
+    virtual void peekConsume(size_t consume) override;
+
+protected:
+    struct Chunk
+    {
+        Chunk* next;
+        size_t size;
+        size_t used;
+
+        char* data()
+        {
+            return reinterpret_cast<char*>(this + 1);
+        }
+    };
+
+    Chunk* _addChunk(size_t size);
+    // the chunk being read, after the fully read ones
+    Chunk* _readChunk();
+
+    size_t _chunkSize;
+    Chunk* _head = nullptr;
+    Chunk* _tail = nullptr;
+    Chunk* _read = nullptr;
+    size_t _readPos = 0;
+    size_t _length = 0;     // appended since clear()
+    size_t _consumed = 0;   // read since clear()
+    bool _failed = false;
+};
+
+#endif // __STRINGBUILDER_H
@@ -0,0 +1,216 @@
+/*
+ StringView.cpp - non-owning view of characters in RAM or PROGMEM
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdlib.h>
+#include "StringView.h"
+
+StringView StringView::substring(size_t beginIndex, size_t endIndex) const
+{
+    if (endIndex > _len) {
+        endIndex = _len;
+    }
+    if (beginIndex >= endIndex) {
+        return StringView(_ptr + endIndex, 0, _progmem);
+    }
+    return StringView(_ptr + beginIndex, endIndex - beginIndex, _progmem);
+}
+
+StringView StringView::trim() const
+{
+    size_t begin = 0;
+    size_t end = _len;
+    while (begin < end && isspace((unsigned char)charAt(begin))) {
+        begin++;
+    }
+    while (end > begin && isspace((unsigned char)charAt(end - 1))) {
+        end--;
+    }
+    return substring(begin, end);
+}
+
+int StringView::indexOf(char c, size_t fromIndex) const
+{
+    if (fromIndex >= _len) {
+        return -1;
+    }
+    if (!_progmem) {
+        const char* found = (const char*)memchr(_ptr + fromIndex, c, _len - fromIndex);
+        return found ? found - _ptr : -1;
+    }
+    for (size_t i = fromIndex; i < _len; i++) {
+        if (charAt(i) == c) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int StringView::indexOf(const StringView& str, size_t fromIndex) const
+{
+    if (fromIndex > _len || str._len > _len - fromIndex) {
+        return -1;
+    }
+    if (!str._len) {
+        return fromIndex;
+    }
+    const char first = str.charAt(0);
+    for (size_t i = fromIndex; i + str._len <= _len; i++) {
+        if (charAt(i) == first && !_compare(str, i, false)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int StringView::lastIndexOf(char c) const
+{
+    for (size_t i = _len; i--; ) {
+        if (charAt(i) == c) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Compare str with the characters of this view from offset, which must fit
+int StringView::_compare(const StringView& str, size_t offset, bool ignoreCase) const
+{
+    if (!_progmem && !str._progmem && !ignoreCase) {
+        return memcmp(_ptr + offset, str._ptr, str._len);
+    }
+    for (size_t i = 0; i < str._len; i++) {
+        int a = (unsigned char)charAt(offset + i);
+        int b = (unsigned char)str.charAt(i);
+        if (ignoreCase) {
+            a = tolower(a);
+            b = tolower(b);
+        }
+        if (a != b) {
+            return a - b;
+        }
+    }
+    return 0;
+}
+
+bool StringView::equals(const StringView& str) const
+{
+    return _len == str._len && !_compare(str, 0, false);
+}
+
+bool StringView::equalsIgnoreCase(const StringView& str) const
+{
+    return _len == str._len && !_compare(str, 0, true);
+}
+
+int StringView::compareTo(const StringView& str) const
+{
+    if (_len >= str._len) {
+        int cmp = _compare(str, 0, false);
+        return cmp ? cmp : (_len > str._len);
+    }
+    int cmp = str._compare(*this, 0, false);
+    return cmp ? -cmp : -1;
+}
+
+bool StringView::startsWith(const StringView& prefix) const
+{
+    return prefix._len <= _len && !_compare(prefix, 0, false);
+}
+
+bool StringView::endsWith(const StringView& suffix) const
+{
+    return suffix._len <= _len && !_compare(suffix, _len - suffix._len, false);
+}
+
+long StringView::toInt() const
+{
+    size_t i = 0;
+    while (i < _len && isspace((unsigned char)charAt(i))) {
+        i++;
+    }
+    bool negative = false;
+    if (i < _len && (charAt(i) == '-' || charAt(i) == '+')) {
+        negative = charAt(i++) == '-';
+    }
+    unsigned long value = 0;
+    while (i < _len && isdigit((unsigned char)charAt(i))) {
+        value = value * 10 + (charAt(i++) - '0');
+    }
+    return negative ? -(long)value : (long)value;
+}
+
+float StringView::toFloat() const
+{
+    // strtod() needs a nul, numbers longer than this are not sensible anyway
+    char buf[32];
+    copyTo(buf, sizeof(buf));
+    return strtod(buf, nullptr);
+}
+
+bool StringView::parseULong(unsigned long& value, int base) const
+{
+    if (!_len || base < 2 || base > 36) {
+        return false;
+    }
+    unsigned long result = 0;
+    for (size_t i = 0; i < _len; i++) {
+        int c = tolower((unsigned char)charAt(i));
+        int digit = isdigit(c) ? c - '0' : (c >= 'a' && c <= 'z') ? c - 'a' + 10 : base;
+        if (digit >= base || result > (ULONG_MAX - digit) / base) {
+            return false;
+        }
+        result = result * base + digit;
+    }
+    value = result;
+    return true;
+}
+
+bool StringView::parseLong(long& value, int base) const
+{
+    bool negative = _len && charAt(0) == '-';
+    size_t sign = (negative || (_len && charAt(0) == '+')) ? 1 : 0;
+    unsigned long magnitude;
+    if (!substring(sign).parseULong(magnitude, base)) {
+        return false;
+    }
+    if (magnitude > (negative ? (unsigned long)LONG_MAX + 1 : (unsigned long)LONG_MAX)) {
+        return false;
+    }
+    value = negative ? (long)(0 - magnitude) : (long)magnitude;
+    return true;
+}
+
+size_t StringView::copyTo(char* buf, size_t size) const
+{
+    if (!size) {
+        return 0;
+    }
+    size_t len = (_len < size - 1) ? _len : size - 1;
+    if (_progmem) {
+        memcpy_P(buf, _ptr, len);
+    } else {
+        memcpy(buf, _ptr, len);
+    }
+    buf[len] = 0;
+    return len;
+}
@@ -0,0 +1,112 @@
+/*
+ StringView.h - non-owning view of characters in RAM or PROGMEM
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __STRINGVIEW_H
+#define __STRINGVIEW_H
+
+#ifdef __cplusplus
+
+#include <stddef.h>
+#include <string.h>
+#include <pgmspace.h>
+
+class String;
+class __FlashStringHelper;
+
+// A StringView points to characters owned by someone else: a String, a C
+// string, a F() / PROGMEM string or part of any of them.  Taking a view,
+// a substring() of it, comparing or parsing it never allocates, so request
+// lines and headers can be picked apart in place.
+//
+// The view is only valid as long as what it points to is left unchanged,
+// and is not nul terminated: copy it to a String to keep it.
+
+class StringView
+{
+public:
+    static constexpr size_t npos = (size_t)-1;
+
+    constexpr StringView() : _ptr(""), _len(0), _progmem(false) { }
+    constexpr StringView(const char* ptr, size_t len, bool progmem = false)
+        : _ptr(ptr), _len(len), _progmem(progmem) { }
+    StringView(const char* cstr)
+        : _ptr(cstr ? cstr : ""), _len(cstr ? strlen(cstr) : 0), _progmem(false) { }
+    StringView(const __FlashStringHelper* fstr)
+        : _ptr(fstr ? reinterpret_cast<PGM_P>(fstr) : ""),
+          _len(fstr ? strlen_P(reinterpret_cast<PGM_P>(fstr)) : 0), _progmem(fstr != nullptr) { }
+    StringView(const String& str); // in WString.h
+
+    size_t length() const { return _len; }
+    bool isEmpty() const { return !_len; }
+    // when true, data() must be read with pgm_read_byte() or the _P functions
+    bool isProgmem() const { return _progmem; }
+    const char* data() const { return _ptr; }
+
+    char charAt(size_t index) const
+    {
+        if (index >= _len) {
+            return 0;
+        }
+        return _progmem ? (char)pgm_read_byte(_ptr + index) : _ptr[index];
+    }
+    char operator[](size_t index) const { return charAt(index); }
+
+    // [beginIndex, endIndex) clipped to the view, like String::substring()
+    StringView substring(size_t beginIndex, size_t endIndex = npos) const;
+    StringView trim() const;
+
+    // index of the first match at or after fromIndex, or -1 like String
+    int indexOf(char c, size_t fromIndex = 0) const;
+    int indexOf(const StringView& str, size_t fromIndex = 0) const;
+    int lastIndexOf(char c) const;
+
+    bool equals(const StringView& str) const;
+    bool equalsIgnoreCase(const StringView& str) const;
+    int compareTo(const StringView& str) const;
+    bool startsWith(const StringView& prefix) const;
+    bool endsWith(const StringView& suffix) const;
+
+    // like String::toInt(): leading spaces, an optional sign and the digits
+    // up to the first other character, 0 when there is none
+    long toInt() const;
+    float toFloat() const;
+    // the whole view is a number in base (2..36), false when it is not or
+    // overflows, value is then left unchanged
+    bool parseLong(long& value, int base = 10) const;
+    bool parseULong(unsigned long& value, int base = 10) const;
+
+    // copy at most size - 1 characters and a nul, returns the count copied
+    size_t copyTo(char* buf, size_t size) const;
+
+protected:
+    int _compare(const StringView& str, size_t offset, bool ignoreCase) const;
+
+    const char* _ptr;
+    size_t _len;
+    bool _progmem;
+};
+
+inline bool operator==(const StringView& lhs, const StringView& rhs) { return lhs.equals(rhs); }
+inline bool operator!=(const StringView& lhs, const StringView& rhs) { return !lhs.equals(rhs); }
+
+#endif // __cplusplus
+
+#endif // __STRINGVIEW_H
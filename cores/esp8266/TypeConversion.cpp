@@ -37,6 +37,117 @@ const uint8_t base36CharValues[75] PROGMEM {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 0,
 };
 
 
+namespace
+{
+// "00" to "FF", the first character in the low byte
+struct HexPairs
+{
+    uint16_t pairs[256];
+
+    constexpr HexPairs() : pairs()
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            pairs[i] = digit(i >> 4) | digit(i & 0xf) << 8;
+        }
+    }
+
+    static constexpr uint16_t digit(int value)
+    {
+        return value < 10 ? '0' + value : 'A' + value - 10;
+    }
+};
+
+constexpr HexPairs hexPairs PROGMEM;
+
+// 'A' | 0x20 is 'a' while digits already have that bit set
+constexpr uint32_t lowerCaseMask = 0x20202020;
+
+inline uint32_t hexPair(uint8_t value)
+{
+    return pgm_read_word(hexPairs.pairs + value);
+}
+
+inline void storeWord(char *out, uint32_t word)
+{
+    out[0] = word;
+    out[1] = word >> 8;
+    out[2] = word >> 16;
+    out[3] = word >> 24;
+}
+
+// The four characters of word (first in the low byte) as four nibbles, the
+// same byte for byte, or false when one of them is not a HEX digit
+inline bool hexNibbles(uint32_t word, uint32_t &nibbles)
+{
+    // a byte of x is within [lo, hi] when x + 0x80 - lo has its high bit
+    // set and x + 0x7f - hi has not, no byte carries into the next while
+    // all of them are below 0x80
+    uint32_t folded = word | 0x20202020;
+    uint32_t digits = (word + 0x50505050) & ~(word + 0x46464646);
+    uint32_t letters = (folded + 0x1f1f1f1f) & ~(folded + 0x19191919);
+    letters &= 0x80808080;
+    if ((word & 0x80808080) || ((digits | letters) & 0x80808080) != 0x80808080)
+    {
+        return false;
+    }
+    nibbles = (word & 0x0f0f0f0f) + (letters >> 7) * 9;
+    return true;
+}
+
+inline uint8_t hexCharValue(char c)
+{
+    return pgm_read_byte(base36CharValues + c - '0');
+}
+}
+
+char *uint8ArrayToHexBuffer(const uint8_t *uint8Array, const uint32_t arrayLength, char *hexBuffer, const bool lowerCase)
+{
+    const uint32_t mask = lowerCase ? lowerCaseMask : 0;
+    uint32_t i = 0;
+    for (; i + 2 <= arrayLength; i += 2, hexBuffer += 4)
+    {
+        storeWord(hexBuffer, (hexPair(uint8Array[i]) | hexPair(uint8Array[i + 1]) << 16) | mask);
+    }
+    if (i < arrayLength)
+    {
+        uint32_t pair = hexPair(uint8Array[i]) | mask;
+        *hexBuffer++ = pair;
+        *hexBuffer++ = pair >> 8;
+    }
+
+    return hexBuffer;
+}
+
+int32_t hexBufferToUint8Array(const char *hexBuffer, const uint32_t hexLength, uint8_t *uint8Array)
+{
+    const uint8_t *in = reinterpret_cast<const uint8_t *>(hexBuffer);
+    const uint32_t arrayLength = hexLength / 2;
+    uint32_t i = 0;
+    for (; i + 2 <= arrayLength; i += 2, in += 4)
+    {
+        uint32_t nibbles;
+        if (!hexNibbles(in[0] | in[1] << 8 | in[2] << 16 | (uint32_t)in[3] << 24, nibbles))
+        {
+            return -1;
+        }
+        uint8Array[i] = (nibbles & 0xf) << 4 | ((nibbles >> 8) & 0xf);
+        uint8Array[i + 1] = ((nibbles >> 16) & 0xf) << 4 | nibbles >> 24;
+    }
+    if (i < arrayLength)
+    {
+        uint32_t nibbles;
+        // the other two characters, '0', are valid
+        if (!hexNibbles(in[0] | in[1] << 8 | 0x30300000, nibbles))
+        {
+            return -1;
+        }
+        uint8Array[i] = (nibbles & 0xf) << 4 | ((nibbles >> 8) & 0xf);
+    }
+
+    return arrayLength;
+}
+
 String uint8ArrayToHexString(const uint8_t *uint8Array, const uint32_t arrayLength)
 {
     String hexString;
@@ -45,10 +156,11 @@ String uint8ArrayToHexString(const uint8_t *uint8Array, const uint32_t arrayLeng
         return emptyString;
     }
 
-    for (uint32_t i = 0; i < arrayLength; ++i)
+    char buffer[64];
+    for (uint32_t i = 0; i < arrayLength; i += sizeof buffer / 2)
     {
-        hexString += (char)pgm_read_byte(base36Chars + (uint8Array[i] >> 4));
-        hexString += (char)pgm_read_byte(base36Chars + uint8Array[i] % 16);
+        uint32_t length = std::min<uint32_t>(sizeof buffer / 2, arrayLength - i);
+        hexString.concat(buffer, uint8ArrayToHexBuffer(uint8Array + i, length, buffer) - buffer);
     }
 
     return hexString;
@@ -58,9 +170,13 @@ uint8_t *hexStringToUint8Array(const String &hexString, uint8_t *uint8Array, con
 {
     assert(hexString.length() >= arrayLength * 2); // Each array element can hold two hexString characters
 
-    for (uint32_t i = 0; i < arrayLength; ++i)
+    if (hexBufferToUint8Array(hexString.c_str(), arrayLength * 2, uint8Array) < 0)
     {
-        uint8Array[i] = (pgm_read_byte(base36CharValues + hexString.charAt(i * 2) - '0') << 4) + pgm_read_byte(base36CharValues + hexString.charAt(i * 2 + 1) - '0');
+        // not all HEX digits, what the base36 lookup gives for them
+        for (uint32_t i = 0; i < arrayLength; ++i)
+        {
+            uint8Array[i] = (hexCharValue(hexString.charAt(i * 2)) << 4) + hexCharValue(hexString.charAt(i * 2 + 1));
+        }
     }
 
     return uint8Array;
@@ -58,6 +58,28 @@ String uint8ArrayToHexString(const uint8_t *uint8Array, const uint32_t arrayLeng
 */
 uint8_t *hexStringToUint8Array(const String &hexString, uint8_t *uint8Array, const uint32_t arrayLength);
 
+/**
+    Write the HEX representation of a uint8_t array to a char buffer, two characters per array element starting from index 0 of the array.
+    No String is involved and no terminating null is written. The bytes are looked up in pairs, four characters at a time.
+
+    @param uint8Array The array to convert.
+    @param arrayLength The size of uint8Array, in bytes.
+    @param hexBuffer The buffer to write to. Must hold at least 2*arrayLength characters.
+    @param lowerCase Use a to f instead of A to F.
+    @return A pointer to the character following the last one written.
+*/
+char *uint8ArrayToHexBuffer(const uint8_t *uint8Array, const uint32_t arrayLength, char *hexBuffer, const bool lowerCase = false);
+
+/**
+    Convert HEX characters to a uint8_t array, four characters at a time. Both upper and lower case are accepted.
+
+    @param hexBuffer The characters to convert, two for each array element.
+    @param hexLength The number of characters in hexBuffer. An odd last character is ignored.
+    @param uint8Array The array to fill. Must hold at least hexLength/2 bytes.
+    @return The number of bytes written to uint8Array, or -1 if hexBuffer contains a character which is not a HEX digit.
+*/
+int32_t hexBufferToUint8Array(const char *hexBuffer, const uint32_t hexLength, uint8_t *uint8Array);
+
 /**
     Takes a uint64_t value and stores the bits in a uint8_t array. Assumes index 0 of the array should contain MSB (big endian).
 
@@ -1,5 +1,6 @@
 #include <Arduino.h>
 #include "Updater.h"
+#include "Updater_Inflate.h"
 #include "eboot_command.h"
 #include <esp8266_peri.h>
 #include <PolledTimeout.h>
@@ -29,6 +30,118 @@ extern "C" {
 
 #include <flash_hal.h> // not "flash_hal.h": can use hijacked MOCK version
 
+/*
+  Delta patch, integers little-endian:
+    header: "ESPD", u32 image size, u32 source size, source MD5 (16 bytes)
+    then records until the image is complete:
+      u32 copy length, u32 diff length, u32 extra length, i32 seek
+      (copy length source bytes are copied, no patch byte follows)
+      diff length bytes, added to the source bytes that follow
+      extra length bytes, copied as is
+    the source position moves on with the copied and diff bytes, then by seek.
+  The source is the running sketch, as ESP.getSketchMD5() hashes it.
+  This is bsdiff's control/diff/extra scheme, with the runs of unchanged
+  bytes bsdiff leaves to compression to squeeze taken out of the diff.
+*/
+struct UpdaterClass::DeltaState {
+  static constexpr uint32_t Magic = 'E' | ('S' << 8) | ('P' << 16) | ((uint32_t)'D' << 24);
+  static constexpr size_t HeaderSize = 28;
+  static constexpr size_t ControlSize = 16;
+
+  enum : uint8_t { HEADER, CONTROL, COPY, DIFF, EXTRA } state = HEADER;
+  uint8_t record[HeaderSize]; // header or control record being received
+  size_t recordLen = 0;
+  uint32_t copyLeft = 0;
+  uint32_t diffLeft = 0;
+  uint32_t extraLeft = 0;
+  int32_t seek = 0;
+  uint32_t sourcePos = 0;
+  uint32_t sourceSize = 0;
+};
+
+/*
+  Decompression of inflate() updates. The image goes through _buffer to the
+  flash as usual, back-references are read from _buffer or back from the
+  flash. Errors are kept in error for _writeInflate(): _setError() would
+  free this while it decompresses.
+*/
+struct UpdaterClass::InflateState : UpdaterInflate {
+  InflateState(UpdaterClass& updater): updater(updater) { }
+
+  UpdaterClass& updater;
+  uint8_t error = UPDATE_ERROR_OK;
+  uint32_t crc = 0; // of the image flushed so far
+  uint8_t head[4]; // first image bytes as decompressed, the flash mode may be changed in flash
+  uint32_t imageEnd = 0;
+  std::unique_ptr<uint8_t[]> trailer; // signature after the gzip stream
+  size_t trailerSize = 0;
+  size_t trailerLen = 0;
+
+  bool put(uint8_t c) override {
+    UpdaterClass& u = updater;
+    uint32_t pos = u._currentAddress + u._bufferLen;
+    if(pos >= imageEnd)
+      return _fail(UPDATE_ERROR_SPACE);
+    if(pos - u._startAddress < sizeof(head))
+      head[pos - u._startAddress] = c;
+    u._buffer[u._bufferLen++] = c;
+    return u._bufferLen < u._bufferSize || _flush();
+  }
+
+  bool copy(uint16_t distance, uint16_t length) override {
+    UpdaterClass& u = updater;
+    while(length) {
+      uint32_t pos = u._currentAddress + u._bufferLen;
+      if(distance > pos - u._startAddress)
+        return _fail(UPDATE_ERROR_INFLATE);
+      if(pos >= imageEnd)
+        return _fail(UPDATE_ERROR_SPACE);
+      // at most distance bytes at once, repeated ones are copied again
+      uint32_t from = pos - distance;
+      size_t n = std::min({ (size_t)length, (size_t)distance, u._bufferSize - u._bufferLen, (size_t)(imageEnd - pos) });
+      uint8_t *out = u._buffer + u._bufferLen;
+      if(from >= u._currentAddress) {
+        memcpy(out, u._buffer + (from - u._currentAddress), n);
+      } else {
+        n = std::min(n, (size_t)(u._currentAddress - from));
+        if(!u._readFlash(from, out, n))
+          return _fail(UPDATE_ERROR_READ);
+        uint32_t offset = from - u._startAddress;
+        for(uint32_t i = offset; i < sizeof(head) && i < offset + n; i++)
+          out[i - offset] = head[i];
+      }
+      u._bufferLen += n;
+      length -= n;
+      if(u._bufferLen == u._bufferSize && !_flush())
+        return false;
+    }
+    return true;
+  }
+
+  bool end(uint32_t streamCrc, uint32_t size) override {
+    UpdaterClass& u = updater;
+    if(u._bufferLen && !_flush())
+      return false;
+    if(streamCrc != crc || size != u._currentAddress - u._startAddress)
+      return _fail(UPDATE_ERROR_INFLATE);
+    return true;
+  }
+
+  bool _flush() {
+    uint8_t result = updater._flushBuffer();
+    return result == UPDATE_ERROR_OK || _fail(result);
+  }
+
+  bool _fail(uint8_t result) {
+    error = result;
+    return false;
+  }
+};
+
+static uint32_t readLE32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
 UpdaterClass::UpdaterClass()
 {
 #if ARDUINO_SIGNING
@@ -51,8 +164,13 @@ void UpdaterClass::_reset(bool callback) {
 
   _buffer = nullptr;
   _bufferLen = 0;
+  _delta.reset();
+  _inflate.reset();
+  _received = 0;
+  _hashed = 0;
   _startAddress = 0;
   _currentAddress = 0;
+  _erasedAddress = 0;
   _size = 0;
   _command = U_FLASH;
 
@@ -168,6 +286,7 @@ bool UpdaterClass::begin(size_t size, int command, int ledPin, uint8_t ledOn) {
   //initialize
   _startAddress = updateStartAddress;
   _currentAddress = _startAddress;
+  _erasedAddress = _startAddress;
   _size = size;
   if (ESP.getFreeHeap() > 2 * FLASH_SECTOR_SIZE) {
     _bufferSize = FLASH_SECTOR_SIZE;
@@ -191,6 +310,8 @@ bool UpdaterClass::begin(size_t size, int command, int ledPin, uint8_t ledOn) {
 
   if (!_verify) {
     _md5.begin();
+  } else {
+    _hash->begin();
   }
 
   if (_start_callback) {
@@ -231,14 +352,45 @@ bool UpdaterClass::end(bool evenIfRemaining){
     return false;
   }
 
-  if(evenIfRemaining) {
+  if(_inflate) {
+    // complete once the end of the gzip stream was decompressed
+    if(!_inflate->done()) {
+      _setError(UPDATE_ERROR_INFLATE);
+      _reset();
+      return false;
+    }
+    _size = _currentAddress - _startAddress;
+  } else if(evenIfRemaining) {
     if(_bufferLen > 0) {
       _writeBuffer();
     }
     _size = progress();
   }
 
-  if (_verify) {
+  if (_verify && _inflate) {
+    // The compressed data was hashed as it was written, the signature and
+    // its length followed it
+    static constexpr uint32_t SigSize = sizeof(uint32_t);
+    const uint32_t expectedSigLen = _verify->length();
+    uint32_t sigLen = 0;
+    if (expectedSigLen > 0 && _inflate->trailerLen == _inflate->trailerSize) {
+      memcpy(&sigLen, _inflate->trailer.get() + expectedSigLen, SigSize);
+    }
+    if (sigLen != expectedSigLen) {
+      _setError(UPDATE_ERROR_SIGN);
+      _reset();
+      return false;
+    }
+    _hash->end();
+    if (!_verify->verify(_hash, _inflate->trailer.get(), sigLen)) {
+      _setError(UPDATE_ERROR_SIGN);
+      _reset();
+      return false;
+    }
+#ifdef DEBUG_UPDATER
+    DEBUG_UPDATER.printf_P(PSTR("[Updater] Signature matches\n"));
+#endif
+  } else if (_verify) {
     // If expectedSigLen is non-zero, we expect the last four bytes of the buffer to
     // contain a matching length field, preceded by the bytes of the signature itself.
     // But if expectedSigLen is zero, we expect neither a signature nor a length field;
@@ -276,13 +428,21 @@ bool UpdaterClass::end(bool evenIfRemaining){
 #endif
     }
 
-    // Calculate hash of the payload, 128 bytes at a time
-    alignas(alignof(uint32_t)) uint8_t buff[128];
-
-    _hash->begin();
-    for (uint32_t offset = 0; offset < binSize; offset += sizeof(buff)) {
+    // The payload was hashed as it was written, up to where the signature
+    // was expected. Should the update have ended short of that, the
+    // signature was hashed too: start over from the flash.
+    if (_hashed > binSize) {
+      _hash->begin();
+      _hashed = 0;
+    }
+    uint8_t buff[128];
+    for (uint32_t offset = _hashed; offset < binSize; offset += sizeof(buff)) {
       auto len = std::min(sizeof(buff), binSize - offset);
-      ESP.flashRead(_startAddress + offset, reinterpret_cast<uint32_t *>(&buff[0]), len);
+      if (!_readFlash(_startAddress + offset, buff, len)) {
+        _setError(UPDATE_ERROR_READ);
+        _reset();
+        return false;
+      }
       _hash->add(buff, len);
     }
     _hash->end();
@@ -373,13 +533,25 @@ bool UpdaterClass::end(bool evenIfRemaining){
 }
 
 bool UpdaterClass::_writeBuffer(){
+  uint8_t error = _flushBuffer();
+  if (error != UPDATE_ERROR_OK) {
+    _currentAddress = (_startAddress + _size);
+    _setError(error);
+    return false;
+  }
+  return true;
+}
+
+// writes _buffer to the flash, returns the error to set when it fails
+uint8_t UpdaterClass::_flushBuffer(){
   #define FLASH_MODE_PAGE  0
   #define FLASH_MODE_OFFSET  2
 
   bool eraseResult = true, writeResult = true;
-  if (_currentAddress % FLASH_SECTOR_SIZE == 0) {
+  if (_currentAddress % FLASH_SECTOR_SIZE == 0 && _currentAddress >= _erasedAddress) {
     if(!_async) yield();
     eraseResult = ESP.flashEraseSector(_currentAddress/FLASH_SECTOR_SIZE);
+    _erasedAddress = _currentAddress + FLASH_SECTOR_SIZE;
   }
 
   // If the flash settings don't match what we already have, modify them.
@@ -409,9 +581,7 @@ bool UpdaterClass::_writeBuffer(){
     if(!_async) yield();
     writeResult = ESP.flashWrite(_currentAddress, _buffer, _bufferLen);
   } else { // if erase was unsuccessful
-    _currentAddress = (_startAddress + _size);
-    _setError(UPDATE_ERROR_ERASE);
-    return false;
+    return UPDATE_ERROR_ERASE;
   }
 
   // Restore the old flash mode, if we modified it.
@@ -421,22 +591,299 @@ bool UpdaterClass::_writeBuffer(){
   }
 
   if (!writeResult) {
-    _currentAddress = (_startAddress + _size);
-    _setError(UPDATE_ERROR_WRITE);
-    return false;
+    return UPDATE_ERROR_WRITE;
   }
-  if (!_verify) {
+  if (_inflate) {
+    _inflate->crc = UpdaterInflate::crc32(_buffer, _bufferLen, _inflate->crc);
+  } else if (_verify) {
+    // the payload is hashed up to the signature and its length
+    const uint32_t expectedSigLen = _verify->length();
+    const size_t sigSize = expectedSigLen ? expectedSigLen + sizeof(uint32_t) : 0;
+    const size_t payloadSize = (_size > sigSize)? _size - sigSize : 0;
+    const size_t offset = _currentAddress - _startAddress;
+    if (_hashed == offset && offset < payloadSize) {
+      const size_t len = std::min(_bufferLen, payloadSize - offset);
+      _hash->add(_buffer, len);
+      _hashed += len;
+    }
+  } else {
     _md5.add(_buffer, _bufferLen);
   }
   _currentAddress += _bufferLen;
   _bufferLen = 0;
+  return UPDATE_ERROR_OK;
+}
+
+bool UpdaterClass::preErase() {
+  if(hasError() || !isRunning())
+    return false;
+
+  // the sector being filled is erased already, unless nothing was written to it
+  uint32_t filling = (_currentAddress + FLASH_SECTOR_SIZE - 1) & (~(FLASH_SECTOR_SIZE - 1));
+  uint32_t next = std::max(_erasedAddress, filling);
+  uint32_t imageEnd = _inflate ? _inflate->imageEnd : _startAddress + _size;
+  uint32_t end = (imageEnd + FLASH_SECTOR_SIZE - 1) & (~(FLASH_SECTOR_SIZE - 1));
+  if(next >= end || next >= filling + _eraseAhead * FLASH_SECTOR_SIZE)
+    return false;
+
+  if(!ESP.flashEraseSector(next/FLASH_SECTOR_SIZE)) {
+    _currentAddress = (_startAddress + _size);
+    _setError(UPDATE_ERROR_ERASE);
+    return false;
+  }
+  _erasedAddress = next + FLASH_SECTOR_SIZE;
+  return true;
+}
+
+bool UpdaterClass::applyDelta() {
+  if(hasError() || !isRunning() || _command != U_FLASH || _inflate || progress() || _bufferLen)
+    return false;
+
+  _delta.reset(new (std::nothrow) DeltaState);
+  if(!_delta) {
+    _setError(UPDATE_ERROR_OOM);
+    return false;
+  }
   return true;
 }
 
+// patch bytes which can be written without going past the end of the patch
+size_t UpdaterClass::_deltaWant() {
+  if(!_delta)
+    return 0;
+  switch(_delta->state) {
+  case DeltaState::HEADER:
+    return DeltaState::HeaderSize - _delta->recordLen;
+  case DeltaState::CONTROL:
+    return (remaining() > _bufferLen)? DeltaState::ControlSize - _delta->recordLen : 0;
+  case DeltaState::DIFF:
+    return _delta->diffLeft;
+  case DeltaState::EXTRA:
+    return _delta->extraLeft;
+  default:
+    return 0;
+  }
+}
+
+size_t UpdaterClass::_writeDelta(const uint8_t *data, size_t len) {
+  size_t done = 0;
+  // copies take no patch byte, they are done before asking for more
+  while(done < len || _delta->state == DeltaState::COPY) {
+    DeltaState& delta = *_delta;
+    size_t left = len - done;
+
+    if(delta.state == DeltaState::HEADER || delta.state == DeltaState::CONTROL) {
+      size_t recordSize = (delta.state == DeltaState::HEADER)? DeltaState::HeaderSize : DeltaState::ControlSize;
+      size_t n = std::min(left, recordSize - delta.recordLen);
+      memcpy(delta.record + delta.recordLen, data + done, n);
+      delta.recordLen += n;
+      done += n;
+      if(delta.recordLen < recordSize)
+        continue;
+      delta.recordLen = 0;
+      if(!((delta.state == DeltaState::HEADER)? _deltaHeader() : _deltaControl()))
+        return done;
+      continue;
+    }
+
+    // copied, diff or extra bytes, straight into the flash buffer
+    uint32_t& phaseLeft = (delta.state == DeltaState::COPY)? delta.copyLeft :
+                          (delta.state == DeltaState::DIFF)? delta.diffLeft : delta.extraLeft;
+    size_t n = std::min((size_t)phaseLeft, _bufferSize - _bufferLen);
+    uint8_t *out = _buffer + _bufferLen;
+    if(delta.state == DeltaState::EXTRA) {
+      n = std::min(n, left);
+      memcpy(out, data + done, n);
+      done += n;
+    } else {
+      if(delta.state == DeltaState::DIFF)
+        n = std::min(n, left);
+      if(!_readFlash(delta.sourcePos, out, n)) {
+        _setError(UPDATE_ERROR_READ);
+        return done;
+      }
+      if(delta.state == DeltaState::DIFF) {
+        for(size_t i = 0; i < n; i++)
+          out[i] += data[done + i];
+        done += n;
+      }
+      delta.sourcePos += n;
+    }
+    _bufferLen += n;
+    phaseLeft -= n;
+    if(!phaseLeft)
+      _deltaNext();
+    if((_bufferLen == _bufferSize || _bufferLen == remaining()) && !_writeBuffer())
+      return done;
+    if(!_async) yield();
+  }
+  return done;
+}
+
+bool UpdaterClass::_deltaHeader() {
+  const uint8_t *header = _delta->record;
+  if(readLE32(header) != DeltaState::Magic || readLE32(header + 4) != _size) {
+    _setError(UPDATE_ERROR_DELTA);
+    return false;
+  }
+
+  // a patch only applies to the sketch it was made from
+  char md5[33];
+  for(size_t i = 0; i < 16; i++)
+    sprintf_P(md5 + 2 * i, PSTR("%02x"), header[12 + i]);
+  _delta->sourceSize = readLE32(header + 8);
+  if(_delta->sourceSize != ESP.getSketchSize() || strcmp(md5, ESP.getSketchMD5().c_str())) {
+    _setError(UPDATE_ERROR_DELTA_SOURCE);
+    return false;
+  }
+#ifdef DEBUG_UPDATER
+  DEBUG_UPDATER.printf_P(PSTR("[Updater] delta from %s\n"), md5);
+#endif
+
+  _delta->state = DeltaState::CONTROL;
+  return true;
+}
+
+bool UpdaterClass::_deltaControl() {
+  DeltaState& delta = *_delta;
+  delta.copyLeft = readLE32(delta.record);
+  delta.diffLeft = readLE32(delta.record + 4);
+  delta.extraLeft = readLE32(delta.record + 8);
+  delta.seek = (int32_t)readLE32(delta.record + 12);
+
+  // stay within the image and the source
+  int64_t diffEnd = (int64_t)delta.sourcePos + delta.copyLeft + delta.diffLeft;
+  int64_t sourcePos = diffEnd + delta.seek;
+  if((uint64_t)delta.copyLeft + delta.diffLeft + delta.extraLeft > remaining() - _bufferLen
+      || diffEnd > delta.sourceSize || sourcePos < 0 || sourcePos > delta.sourceSize) {
+    _setError(UPDATE_ERROR_DELTA);
+    return false;
+  }
+  _deltaNext();
+  return true;
+}
+
+void UpdaterClass::_deltaNext() {
+  DeltaState& delta = *_delta;
+  if(delta.copyLeft) {
+    delta.state = DeltaState::COPY;
+  } else if(delta.diffLeft) {
+    delta.state = DeltaState::DIFF;
+  } else if(delta.extraLeft) {
+    delta.state = DeltaState::EXTRA;
+  } else {
+    delta.sourcePos += delta.seek;
+    delta.state = DeltaState::CONTROL;
+  }
+}
+
+// flash reads must be aligned, data and address need not be
+bool UpdaterClass::_readFlash(uint32_t address, uint8_t *data, size_t len) {
+  alignas(alignof(uint32_t)) uint8_t buff[64];
+  while(len) {
+    uint32_t aligned = address & ~3;
+    size_t skip = address - aligned;
+    size_t chunk = std::min(len, sizeof(buff) - skip);
+    if(!ESP.flashRead(aligned, reinterpret_cast<uint32_t *>(&buff[0]), (skip + chunk + 3) & ~3))
+      return false;
+    memcpy(data, buff + skip, chunk);
+    address += chunk;
+    data += chunk;
+    len -= chunk;
+  }
+  return true;
+}
+
+bool UpdaterClass::inflate() {
+  if(hasError() || !isRunning() || _delta || _inflate || progress() || _bufferLen)
+    return false;
+
+  // The image size is only known at the end of the stream: the image goes
+  // from the end of the sketch to the end of the space it may use. eboot
+  // copies it sector by sector, so it may overlap where it is copied to.
+  uint32_t currentSketchSize = (ESP.getSketchSize() + FLASH_SECTOR_SIZE - 1) & (~(FLASH_SECTOR_SIZE - 1));
+  uint32_t imageStart = currentSketchSize;
+  uint32_t imageEnd = FS_start - 0x40200000;
+  if(_command == U_FS) {
+#ifdef ATOMIC_FS_UPDATE
+    imageEnd = std::min(imageEnd, imageStart + (uint32_t)(FS_end - FS_start));
+#else
+    imageStart = FS_start - 0x40200000;
+    imageEnd = FS_end - 0x40200000;
+#endif
+  }
+  if(imageEnd <= imageStart) {
+    _setError(UPDATE_ERROR_SPACE);
+    return false;
+  }
+
+  _inflate.reset(new (std::nothrow) InflateState(*this));
+  if(_inflate && _verify && _verify->length()) {
+    _inflate->trailerSize = _verify->length() + sizeof(uint32_t);
+    _inflate->trailer.reset(new (std::nothrow) uint8_t[_inflate->trailerSize]);
+  }
+  if(!_inflate || (_inflate->trailerSize && !_inflate->trailer)) {
+    _setError(UPDATE_ERROR_OOM);
+    return false;
+  }
+  _inflate->imageEnd = imageEnd;
+  _startAddress = imageStart;
+  _currentAddress = imageStart;
+  _erasedAddress = imageStart;
+  if(_verify) {
+    _hash->begin();
+  }
+#ifdef DEBUG_UPDATER
+  DEBUG_UPDATER.printf_P(PSTR("[Updater] inflate to 0x%08X..0x%08X\n"), imageStart, imageEnd);
+#endif
+  return true;
+}
+
+size_t UpdaterClass::_writeInflate(const uint8_t *data, size_t len) {
+  if(_received + len > _size) {
+    _setError(UPDATE_ERROR_SPACE);
+    return 0;
+  }
+
+  // in pieces MD5Builder::add() takes
+  for(size_t done = 0; done < len; ) {
+    InflateState& inflate = *_inflate;
+    size_t piece = std::min(len - done, (size_t)FLASH_SECTOR_SIZE);
+    size_t stream = inflate.done()? 0 : inflate.write(data + done, piece);
+    if(inflate.failed()) {
+      _setError(inflate.error != UPDATE_ERROR_OK ? inflate.error : UPDATE_ERROR_INFLATE);
+      return done;
+    }
+    // only a signature may follow the stream
+    size_t rest = piece - stream;
+    if(rest) {
+      if(rest > inflate.trailerSize - inflate.trailerLen) {
+        _setError(_verify ? UPDATE_ERROR_SIGN : UPDATE_ERROR_INFLATE);
+        return done;
+      }
+      memcpy(inflate.trailer.get() + inflate.trailerLen, data + done + stream, rest);
+      inflate.trailerLen += rest;
+    }
+    if(_verify) {
+      _hash->add(data + done, stream);
+    } else {
+      _md5.add(data + done, stream);
+    }
+    done += piece;
+    _received += piece;
+  }
+  return len;
+}
+
 size_t UpdaterClass::write(uint8_t *data, size_t len) {
   if(hasError() || !isRunning())
     return 0;
 
+  if(_delta)
+    return _writeDelta(data, len);
+  if(_inflate)
+    return _writeInflate(data, len);
+
   if(progress() + _bufferLen + len > _size) {
     _setError(UPDATE_ERROR_SPACE);
     return 0;
@@ -531,7 +978,7 @@ size_t UpdaterClass::writeStream(Stream &data, uint16_t streamTimeout) {
     if(hasError() || !isRunning())
         return 0;
 
-    if(!_verifyHeader(data.peek())) {
+    if(!_delta && !_verifyHeader(data.peek())) {
 #ifdef DEBUG_UPDATER
         printError(DEBUG_UPDATER);
 #endif
@@ -546,6 +993,14 @@ size_t UpdaterClass::writeStream(Stream &data, uint16_t streamTimeout) {
         pinMode(_ledPin, OUTPUT);
     }
 
+    std::unique_ptr<uint8_t[]> patch;
+    if(_delta || _inflate) {
+        patch.reset(new (std::nothrow) uint8_t[256]);
+        if(!patch) {
+            _setError(UPDATE_ERROR_OOM);
+            return 0;
+        }
+    }
     while(remaining()) {
         if(_ledPin != -1) {
             digitalWrite(_ledPin, _ledOn); // Switch LED on
@@ -554,7 +1009,17 @@ size_t UpdaterClass::writeStream(Stream &data, uint16_t streamTimeout) {
         if(bytesToRead > remaining()) {
             bytesToRead = remaining();
         }
-        toRead = data.readBytes(_buffer + _bufferLen,  bytesToRead);
+        uint8_t *target = _buffer + _bufferLen;
+        if(_delta || _inflate) {
+            // a patch is read up to its end, not further
+            bytesToRead = std::min((size_t)256, _filterWant());
+            target = patch.get();
+        }
+        // erase ahead rather than only wait for the data
+        if(!data.available()) {
+            preErase();
+        }
+        toRead = data.readBytes(target,  bytesToRead);
         if(toRead == 0) { //Timeout
           if (timeOut) {
             _currentAddress = (_startAddress + _size);
@@ -569,10 +1034,17 @@ size_t UpdaterClass::writeStream(Stream &data, uint16_t streamTimeout) {
         if(_ledPin != -1) {
             digitalWrite(_ledPin, !_ledOn); // Switch LED off
         }
-        _bufferLen += toRead;
-        if((_bufferLen == remaining() || _bufferLen == _bufferSize) && !_writeBuffer())
-            return written;
-        written += toRead;
+        if(_delta || _inflate) {
+            size_t done = write(patch.get(), toRead);
+            written += done;
+            if(done != toRead)
+                return written;
+        } else {
+            _bufferLen += toRead;
+            if((_bufferLen == remaining() || _bufferLen == _bufferSize) && !_writeBuffer())
+                return written;
+            written += toRead;
+        }
         if(_progress_callback) {
             _progress_callback(progress(), _size);
         }
@@ -649,6 +1121,15 @@ String UpdaterClass::getErrorString() const {
   case UPDATE_ERROR_OOM:
     out = F("Out of memory");
     break;
+  case UPDATE_ERROR_DELTA:
+    out = F("Invalid delta patch");
+    break;
+  case UPDATE_ERROR_DELTA_SOURCE:
+    out = F("Delta patch is for another sketch");
+    break;
+  case UPDATE_ERROR_INFLATE:
+    out = F("Decompression failed");
+    break;
   default:
     out = F("UNKNOWN");
     break;
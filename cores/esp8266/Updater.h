@@ -5,6 +5,7 @@
 #include <flash_utils.h>
 #include <MD5Builder.h>
 #include <functional>
+#include <memory>
 
 #define UPDATE_ERROR_OK                 (0)
 #define UPDATE_ERROR_WRITE              (1)
@@ -21,11 +22,18 @@
 #define UPDATE_ERROR_SIGN               (12)
 #define UPDATE_ERROR_NO_DATA            (13)
 #define UPDATE_ERROR_OOM                (14)
+#define UPDATE_ERROR_DELTA              (15)
+#define UPDATE_ERROR_DELTA_SOURCE       (16)
+#define UPDATE_ERROR_INFLATE            (17)
 
 #define U_FLASH   0
 #define U_FS      100
 #define U_AUTH    200
 
+#ifndef UPDATER_ERASE_AHEAD
+#define UPDATER_ERASE_AHEAD 2 // sectors preErase() may erase beyond the one being filled
+#endif
+
 #ifdef DEBUG_ESP_UPDATER
 #ifdef DEBUG_ESP_PORT
 #define DEBUG_UPDATER DEBUG_ESP_PORT
@@ -73,6 +81,33 @@ class UpdaterClass {
     */
     void runAsync(bool async){ _async = async; }
 
+    /*
+      Erases the next flash sector of the update ahead of time, so that
+      writing it later doesn't wait for the erase (~40ms per sector).
+      Call it while waiting for data, writeStream() and write(T&) do.
+      Up to eraseAhead() sectors beyond the one being filled are erased.
+      Returns false when there was nothing to erase
+    */
+    bool preErase();
+    void eraseAhead(size_t sectors){ _eraseAhead = sectors; }
+
+    /*
+      Call right after begin(size) to write a delta patch instead of the
+      image: the new image, of the size given to begin(), is built from the
+      running sketch and the patch as it is written (see tools/delta.py).
+      write() and writeStream() then count patch bytes, progress() and
+      remaining() image bytes
+    */
+    bool applyDelta();
+
+    /*
+      Call right after begin(size) to write a gzip compressed image
+      which is decompressed as it is written, instead of by eboot at
+      reboot: size is that of the compressed data, which setMD5() and
+      signatures are for, progress() and remaining() count its bytes
+    */
+    bool inflate();
+
     /*
       Writes a buffer to the flash and increments the address
       Returns the amount written
@@ -162,10 +197,10 @@ class UpdaterClass {
     void clearError(){ _error = UPDATE_ERROR_OK; }
     bool hasError(){ return _error != UPDATE_ERROR_OK; }
     bool isRunning(){ return _size > 0; }
-    bool isFinished(){ return _currentAddress == (_startAddress + _size); }
+    bool isFinished(){ return progress() == _size; }
     size_t size(){ return _size; }
-    size_t progress(){ return _currentAddress - _startAddress; }
-    size_t remaining(){ return _size - (_currentAddress - _startAddress); }
+    size_t progress(){ return _inflate ? _received : _currentAddress - _startAddress; }
+    size_t remaining(){ return _size - progress(); }
 
     /*
       Template to write from objects that expose
@@ -179,6 +214,19 @@ class UpdaterClass {
       if (hasError() || !isRunning())
         return 0;
 
+      if (_delta || _inflate) {
+        uint8_t patch[256];
+        size_t len;
+        while ((len = std::min({ (size_t)data.available(), _filterWant(), sizeof(patch) }))) {
+          len = data.read(patch, len);
+          size_t done = write(patch, len);
+          written += done;
+          if (done != len)
+            return written;
+        }
+        return written;
+      }
+
       size_t available = data.available();
       while(available) {
         if(_bufferLen + available > remaining()){
@@ -205,13 +253,30 @@ class UpdaterClass {
           return written;
         delay(1);
         available = data.available();
+        // nothing arrived, make use of the wait
+        if(!available && preErase())
+          available = data.available();
       }
       return written;
     }
 
   private:
+    struct DeltaState;
+    struct InflateState;
+
     void _reset(bool callback = true);
     bool _writeBuffer();
+    uint8_t _flushBuffer();
+    size_t _filterWant(){ return _delta ? _deltaWant() : remaining(); }
+
+    size_t _deltaWant();
+    size_t _writeDelta(const uint8_t *data, size_t len);
+    bool _deltaHeader();
+    bool _deltaControl();
+    void _deltaNext();
+    bool _readFlash(uint32_t address, uint8_t *data, size_t len);
+
+    size_t _writeInflate(const uint8_t *data, size_t len);
 
     bool _verifyHeader(uint8_t data);
     bool _verifyEnd();
@@ -226,6 +291,12 @@ class UpdaterClass {
     size_t _size = 0;
     uint32_t _startAddress = 0;
     uint32_t _currentAddress = 0;
+    uint32_t _erasedAddress = 0; // sectors from _currentAddress up to here are erased
+    size_t _eraseAhead = UPDATER_ERASE_AHEAD;
+    std::unique_ptr<DeltaState> _delta; // while applying a patch
+    std::unique_ptr<InflateState> _inflate; // while decompressing
+    size_t _received = 0; // compressed bytes written
+    size_t _hashed = 0; // payload bytes given to _hash, as they are written
     uint32_t _command = U_FLASH;
 
     String _target_md5;
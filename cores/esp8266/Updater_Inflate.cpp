@@ -0,0 +1,406 @@
+/*
+  Updater_Inflate.cpp - streaming gzip decompression for the Updater
+
+  Decoding follows RFC 1951/1952 and the canonical Huffman decoding of
+  zlib's puff.c. Each step (a header field, a code, a literal/length and
+  distance pair) only takes effect once its input is complete: when it is
+  not, the input is set back to the start of the step, which decodes again
+  when more data is written.
+*/
+
+#include <Arduino.h>
+#include "Updater_Inflate.h"
+
+namespace {
+
+constexpr int NEED_INPUT = -1;
+constexpr int INVALID = -2;
+constexpr int NO_ROOM = -3;
+constexpr size_t LONGEST_COPY = 258;
+
+const uint16_t lengthBase[29] PROGMEM = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const uint8_t lengthExtra[29] PROGMEM = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const uint16_t distanceBase[30] PROGMEM = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+  8193, 12289, 16385, 24577 };
+const uint8_t distanceExtra[30] PROGMEM = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+const uint8_t codeLengthOrder[19] PROGMEM = {
+  16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+const uint32_t crcTable[16] PROGMEM = {
+  0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+  0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c };
+
+} // namespace
+
+uint32_t UpdaterInflate::crc32(const uint8_t *data, size_t len, uint32_t crc) {
+  crc = ~crc;
+  while (len--) {
+    crc ^= *data++;
+    crc = (crc >> 4) ^ pgm_read_dword(&crcTable[crc & 15]);
+    crc = (crc >> 4) ^ pgm_read_dword(&crcTable[crc & 15]);
+  }
+  return ~crc;
+}
+
+size_t UpdaterInflate::write(const uint8_t *data, size_t len) {
+  size_t taken = 0;
+  // input of a pause
+  _paused = false;
+  if (_inPos < _inLen)
+    _run();
+  while (taken < len && _state != DONE && _state != FAILED && !_paused) {
+    if (_inPos) {
+      memmove(_in, _in + _inPos, _inLen - _inPos);
+      _inLen -= _inPos;
+      _inPos = 0;
+    }
+    size_t n = std::min(len - taken, sizeof(_in) - _inLen);
+    memcpy(_in + _inLen, data + taken, n);
+    _inLen += n;
+    taken += n;
+    _run();
+  }
+  // a step only ends past the input it was short of, so what follows the
+  // stream was written by this call
+  if (_state == DONE) {
+    taken -= std::min(taken, _inLen - _inPos);
+    _inLen = _inPos = 0;
+  }
+  return taken;
+}
+
+void UpdaterInflate::_run() {
+  for (;;) {
+    size_t inPos = _inPos;
+    uint32_t bitBuf = _bitBuf;
+    uint8_t bitCount = _bitCount;
+    int result = _step();
+    if (result > 0)
+      continue;
+    if (result == NEED_INPUT || result == NO_ROOM) {
+      _inPos = inPos;
+      _bitBuf = bitBuf;
+      _bitCount = bitCount;
+      _paused = result == NO_ROOM;
+    } else if (result == INVALID) {
+      _state = FAILED;
+    }
+    return;
+  }
+}
+
+bool UpdaterInflate::_need(uint8_t n) {
+  while (_bitCount < n) {
+    if (_inPos == _inLen)
+      return false;
+    _bitBuf |= (uint32_t)_in[_inPos++] << _bitCount;
+    _bitCount += 8;
+  }
+  return true;
+}
+
+bool UpdaterInflate::_bits(uint8_t n, uint32_t &value) {
+  if (!_need(n))
+    return false;
+  value = _bitBuf & ((1u << n) - 1);
+  _bitBuf >>= n;
+  _bitCount -= n;
+  return true;
+}
+
+int UpdaterInflate::_decode(const Huffman &h) {
+  int code = 0, first = 0, index = 0;
+  for (int len = 1; len < 16; len++) {
+    uint32_t bit;
+    if (!_bits(1, bit))
+      return NEED_INPUT;
+    code |= bit;
+    int count = h.count[len];
+    if (code - count < first)
+      return h.symbol[index + (code - first)];
+    index += count;
+    first += count;
+    first <<= 1;
+    code <<= 1;
+  }
+  return INVALID;
+}
+
+// returns 0 for a complete code, > 0 when incomplete, < 0 when over-subscribed
+int UpdaterInflate::_construct(Huffman &h, const uint8_t *length, int n) {
+  memset(h.count, 0, sizeof(h.count));
+  for (int symbol = 0; symbol < n; symbol++)
+    h.count[length[symbol]]++;
+  if (h.count[0] == n)
+    return 0;
+
+  int left = 1;
+  for (int len = 1; len < 16; len++) {
+    left <<= 1;
+    left -= h.count[len];
+    if (left < 0)
+      return left;
+  }
+
+  uint16_t offsets[16];
+  offsets[1] = 0;
+  for (int len = 1; len < 15; len++)
+    offsets[len + 1] = offsets[len] + h.count[len];
+  for (int symbol = 0; symbol < n; symbol++) {
+    if (length[symbol])
+      h.symbol[offsets[length[symbol]]++] = symbol;
+  }
+  return left;
+}
+
+UpdaterInflate::State UpdaterInflate::_nextHeader() {
+  if (_flags & 0x04)
+    return EXTRA_LEN;
+  if (_flags & 0x08)
+    return NAME;
+  if (_flags & 0x10)
+    return COMMENT;
+  if (_flags & 0x02)
+    return HCRC;
+  return BLOCK;
+}
+
+void UpdaterInflate::_fixedTables() {
+  uint8_t *length = _lengths;
+  int symbol = 0;
+  for (; symbol < 144; symbol++)
+    length[symbol] = 8;
+  for (; symbol < 256; symbol++)
+    length[symbol] = 9;
+  for (; symbol < 280; symbol++)
+    length[symbol] = 7;
+  for (; symbol < 288; symbol++)
+    length[symbol] = 8;
+  // 286 and 287 take part in the code, but are never valid
+  _construct(_lencode, length, 288);
+  memset(length, 5, 30);
+  _construct(_distcode, length, 30);
+}
+
+void UpdaterInflate::reset() {
+  _state = HEADER;
+  _paused = false;
+  _inLen = _inPos = 0;
+  _bitBuf = 0;
+  _bitCount = 0;
+}
+
+int UpdaterInflate::_step() {
+  uint32_t v;
+  if ((_state == STORED || _state == CODES) && room() < LONGEST_COPY)
+    return NO_ROOM;
+  switch (_state) {
+  case HEADER: {
+    uint8_t header[10];
+    for (uint8_t &b : header) {
+      if (!_bits(8, v))
+        return NEED_INPUT;
+      b = v;
+    }
+    // deflate only, no reserved flag
+    if (header[0] != 0x1f || header[1] != 0x8b || header[2] != 8 || (header[3] & 0xe0))
+      return INVALID;
+    _flags = header[3];
+    _state = _nextHeader();
+    return 1;
+  }
+
+  case EXTRA_LEN:
+    if (!_bits(16, v))
+      return NEED_INPUT;
+    _left = v;
+    _flags &= ~0x04;
+    _state = _left ? EXTRA : _nextHeader();
+    return 1;
+
+  case EXTRA:
+    if (!_bits(8, v))
+      return NEED_INPUT;
+    if (!--_left)
+      _state = _nextHeader();
+    return 1;
+
+  case NAME:
+  case COMMENT:
+    if (!_bits(8, v))
+      return NEED_INPUT;
+    if (!v) {
+      _flags &= (_state == NAME) ? ~0x08 : ~0x10;
+      _state = _nextHeader();
+    }
+    return 1;
+
+  case HCRC:
+    if (!_bits(16, v))
+      return NEED_INPUT;
+    _flags &= ~0x02;
+    _state = BLOCK;
+    return 1;
+
+  case BLOCK:
+    if (!_bits(3, v))
+      return NEED_INPUT;
+    _final = v & 1;
+    switch (v >> 1) {
+    case 0:
+      _state = STORED_LEN;
+      return 1;
+    case 1:
+      _fixedTables();
+      _state = CODES;
+      return 1;
+    case 2:
+      _state = TABLE_COUNTS;
+      return 1;
+    default:
+      return INVALID;
+    }
+
+  case STORED_LEN: {
+    _bitBuf >>= _bitCount & 7;
+    _bitCount -= _bitCount & 7;
+    uint32_t nlen;
+    if (!_bits(16, v) || !_bits(16, nlen))
+      return NEED_INPUT;
+    if (v != (~nlen & 0xffff))
+      return INVALID;
+    _left = v;
+    _state = _left ? STORED : _blockEnd();
+    return 1;
+  }
+
+  case STORED:
+    if (!_bits(8, v))
+      return NEED_INPUT;
+    if (!put(v))
+      return INVALID;
+    if (!--_left)
+      _state = _blockEnd();
+    return 1;
+
+  case TABLE_COUNTS:
+    if (!_bits(14, v))
+      return NEED_INPUT;
+    _nlen = (v & 31) + 257;
+    _ndist = ((v >> 5) & 31) + 1;
+    _ncode = (v >> 10) + 4;
+    if (_nlen > 286 || _ndist > 30)
+      return INVALID;
+    memset(_lengths, 0, 19);
+    _index = 0;
+    _state = TABLE_CL;
+    return 1;
+
+  case TABLE_CL:
+    if (!_bits(3, v))
+      return NEED_INPUT;
+    _lengths[pgm_read_byte(&codeLengthOrder[_index])] = v;
+    if (++_index == _ncode) {
+      // the code length code goes to _lencode until the lengths are read
+      if (_construct(_lencode, _lengths, 19))
+        return INVALID;
+      _index = 0;
+      _state = TABLE_LENS;
+    }
+    return 1;
+
+  case TABLE_LENS: {
+    int symbol = _decode(_lencode);
+    if (symbol < 0)
+      return symbol;
+    uint8_t length = symbol;
+    uint32_t repeat = 1;
+    if (symbol == 16) {
+      if (!_index)
+        return INVALID;
+      length = _lengths[_index - 1];
+      if (!_bits(2, repeat))
+        return NEED_INPUT;
+      repeat += 3;
+    } else if (symbol == 17) {
+      length = 0;
+      if (!_bits(3, repeat))
+        return NEED_INPUT;
+      repeat += 3;
+    } else if (symbol == 18) {
+      length = 0;
+      if (!_bits(7, repeat))
+        return NEED_INPUT;
+      repeat += 11;
+    }
+    if (_index + repeat > (uint32_t)_nlen + _ndist)
+      return INVALID;
+    while (repeat--)
+      _lengths[_index++] = length;
+    if (_index < _nlen + _ndist)
+      return 1;
+
+    // incomplete codes are only allowed for a single length
+    if (!_lengths[256])
+      return INVALID;
+    int err = _construct(_lencode, _lengths, _nlen);
+    if (err < 0 || (err > 0 && _nlen - _lencode.count[0] != 1))
+      return INVALID;
+    err = _construct(_distcode, _lengths + _nlen, _ndist);
+    if (err < 0 || (err > 0 && _ndist - _distcode.count[0] != 1))
+      return INVALID;
+    _state = CODES;
+    return 1;
+  }
+
+  case CODES: {
+    int symbol = _decode(_lencode);
+    if (symbol < 0)
+      return symbol;
+    if (symbol < 256)
+      return put(symbol) ? 1 : INVALID;
+    if (symbol == 256) {
+      _state = _blockEnd();
+      return 1;
+    }
+    symbol -= 257;
+    if (symbol >= 29)
+      return INVALID;
+    uint32_t length;
+    if (!_bits(pgm_read_byte(&lengthExtra[symbol]), length))
+      return NEED_INPUT;
+    length += pgm_read_word(&lengthBase[symbol]);
+    symbol = _decode(_distcode);
+    if (symbol < 0)
+      return symbol;
+    if (symbol >= 30)
+      return INVALID;
+    uint32_t distance;
+    if (!_bits(pgm_read_byte(&distanceExtra[symbol]), distance))
+      return NEED_INPUT;
+    distance += pgm_read_word(&distanceBase[symbol]);
+    return copy(distance, length) ? 1 : INVALID;
+  }
+
+  case TRAILER: {
+    _bitBuf >>= _bitCount & 7;
+    _bitCount -= _bitCount & 7;
+    uint32_t crc[2], size[2];
+    if (!_bits(16, crc[0]) || !_bits(16, crc[1]) || !_bits(16, size[0]) || !_bits(16, size[1]))
+      return NEED_INPUT;
+    _state = DONE;
+    return end(crc[0] | (crc[1] << 16), size[0] | (size[1] << 16)) ? 0 : INVALID;
+  }
+
+  default:
+    return 0;
+  }
+}
@@ -0,0 +1,87 @@
+#ifndef ESP8266UPDATER_INFLATE_H
+#define ESP8266UPDATER_INFLATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Streaming gzip decompression for the Updater. Input may be written in
+// pieces of any size. No window is kept: back-references are handed to
+// copy(), which finds the bytes in the output written so far (in flash).
+// A subclass with a bounded output (HTTPClient) reports its room(), the
+// decompression pauses when it runs short until write() is called again.
+class UpdaterInflate {
+  public:
+    UpdaterInflate() = default;
+    UpdaterInflate(const UpdaterInflate&) = delete; // the tables point into the object
+    UpdaterInflate& operator=(const UpdaterInflate&) = delete;
+    virtual ~UpdaterInflate() = default;
+
+    /*
+      Decompresses data, returns how many of its bytes are part of the gzip
+      stream: len until the end of the stream, less once it is reached, or
+      what it took before pausing
+    */
+    size_t write(const uint8_t *data, size_t len);
+    // for another stream
+    void reset();
+
+    bool done() const { return _state == DONE; }
+    bool failed() const { return _state == FAILED; }
+    bool paused() const { return _paused; } // for room()
+
+    // CRC-32 as gzip computes it, crc being that of the preceding data
+    static uint32_t crc32(const uint8_t *data, size_t len, uint32_t crc = 0);
+
+  protected:
+    // output of the decompression, returning false stops it (failed())
+    virtual bool put(uint8_t c) = 0;
+    virtual bool copy(uint16_t distance, uint16_t length) = 0;
+    // end of the stream, with the CRC-32 and size of the output it gives
+    virtual bool end(uint32_t crc, uint32_t size) = 0;
+    // output there is room for, it pauses short of a longest copy (258)
+    virtual size_t room() { return SIZE_MAX; }
+
+  private:
+    enum State : uint8_t {
+      HEADER, EXTRA_LEN, EXTRA, NAME, COMMENT, HCRC,
+      BLOCK, STORED_LEN, STORED, TABLE_COUNTS, TABLE_CL, TABLE_LENS, CODES,
+      TRAILER, DONE, FAILED
+    };
+
+    struct Huffman {
+      uint16_t count[16]; // codes of each length
+      uint16_t *symbol;   // in canonical order
+    };
+
+    void _run();
+    int _step();
+    bool _need(uint8_t n);
+    bool _bits(uint8_t n, uint32_t &value);
+    int _decode(const Huffman &h);
+    static int _construct(Huffman &h, const uint8_t *length, int n);
+    State _nextHeader();
+    State _blockEnd() const { return _final ? TRAILER : BLOCK; }
+    void _fixedTables();
+
+    State _state = HEADER;
+    uint8_t _flags = 0;
+    bool _final = false;
+    bool _paused = false;
+    uint16_t _left = 0;    // of the stored block or header extra field
+    uint16_t _nlen = 0, _ndist = 0, _ncode = 0, _index = 0;
+
+    // input of the step being decoded, it restarts when this runs out
+    uint8_t _in[64];
+    size_t _inLen = 0;
+    size_t _inPos = 0;
+    uint32_t _bitBuf = 0;
+    uint8_t _bitCount = 0;
+
+    uint16_t _lenSymbol[288];
+    uint16_t _distSymbol[30];
+    Huffman _lencode { { }, _lenSymbol };
+    Huffman _distcode { { }, _distSymbol };
+    uint8_t _lengths[288 + 30]; // of the codes being built
+};
+
+#endif
@@ -51,6 +51,12 @@ String::String(const __FlashStringHelper *pstr) {
     *this = pstr; // see operator =
 }
 
+String::String(const StringView &view) {
+    init();
+    if (!concat(view))
+        invalidate();
+}
+
 String::String(String &&rval) noexcept {
     init();
     move(rval);
@@ -58,17 +64,19 @@ String::String(String &&rval) noexcept {
 
 String::String(unsigned char value, unsigned char base) {
     init();
-    char buf[1 + 8 * sizeof(unsigned char)];
-    utoa(value, buf, base);
-    *this = buf;
+    if (base == 10) {
+        concat((unsigned long long)value);
+    } else {
+        char buf[1 + 8 * sizeof(unsigned char)];
+        utoa(value, buf, base);
+        *this = buf;
+    }
 }
 
 String::String(int value, unsigned char base) {
     init();
     if (base == 10) {
-        char buf[std::numeric_limits<decltype(value)>::digits10 + 2];
-        sprintf(buf, "%d", value);
-        *this = buf;
+        concat((long long)value);
     } else {
         char buf[2 + 8 * sizeof(value)];
         itoa(value, buf, base);
@@ -78,17 +86,19 @@ String::String(int value, unsigned char base) {
 
 String::String(unsigned int value, unsigned char base) {
     init();
-    char buf[1 + 8 * sizeof(unsigned int)];
-    utoa(value, buf, base);
-    *this = buf;
+    if (base == 10) {
+        concat((unsigned long long)value);
+    } else {
+        char buf[1 + 8 * sizeof(unsigned int)];
+        utoa(value, buf, base);
+        *this = buf;
+    }
 }
 
 String::String(long value, unsigned char base) {
     init();
     if (base == 10) {
-        char buf[std::numeric_limits<decltype(value)>::digits10 + 2];
-        sprintf(buf, "%ld", value);
-        *this = buf;
+        concat((long long)value);
     } else {
         char buf[2 + 8 * sizeof(value)];
         ltoa(value, buf, base);
@@ -98,28 +108,29 @@ String::String(long value, unsigned char base) {
 
 String::String(unsigned long value, unsigned char base) {
     init();
-    char buf[1 + 8 * sizeof(unsigned long)];
-    ultoa(value, buf, base);
-    *this = buf;
+    if (base == 10) {
+        concat((unsigned long long)value);
+    } else {
+        char buf[1 + 8 * sizeof(unsigned long)];
+        ultoa(value, buf, base);
+        *this = buf;
+    }
 }
 
+// base 10 goes through ulltoa_dec(), two digits at a time
 String::String(long long value) {
     init();
-    char buf[std::numeric_limits<decltype(value)>::digits10 + 2];
-    sprintf(buf, "%lld", value);
-    *this = buf;
+    concat(value);
 }
 
 String::String(unsigned long long value) {
     init();
-    char buf[std::numeric_limits<decltype(value)>::digits10 + 2];
-    sprintf(buf, "%llu", value);
-    *this = buf;
+    concat(value);
 }
 
 String::String(long long value, unsigned char base) {
     init();
-    char buf[1 + 8 * sizeof(value)];
+    char buf[2 + 8 * sizeof(value)];
     *this = lltoa(value, buf, sizeof(buf), base);
 }
 
@@ -326,40 +337,35 @@ bool String::concat(char c) {
 }
 
 bool String::concat(unsigned char num) {
-    char buf[1 + 3 * sizeof(unsigned char)];
-    return concat(buf, sprintf(buf, "%d", num));
+    return concat((unsigned long long)num);
 }
 
 bool String::concat(int num) {
-    char buf[2 + 3 * sizeof(int)];
-    return concat(buf, sprintf(buf, "%d", num));
+    return concat((long long)num);
 }
 
 bool String::concat(unsigned int num) {
-    char buf[1 + 3 * sizeof(unsigned int)];
-    utoa(num, buf, 10);
-    return concat(buf, strlen(buf));
+    return concat((unsigned long long)num);
 }
 
 bool String::concat(long num) {
-    char buf[2 + 3 * sizeof(long)];
-    return concat(buf, sprintf(buf, "%ld", num));
+    return concat((long long)num);
 }
 
 bool String::concat(unsigned long num) {
-    char buf[1 + 3 * sizeof(unsigned long)];
-    ultoa(num, buf, 10);
-    return concat(buf, strlen(buf));
+    return concat((unsigned long long)num);
 }
 
 bool String::concat(long long num) {
     char buf[2 + 3 * sizeof(long long)];
-    return concat(buf, sprintf(buf, "%lld", num));
+    const char *str = lltoa(num, buf, sizeof(buf), 10);
+    return concat(str, &buf[sizeof(buf) - 1] - str);
 }
 
 bool String::concat(unsigned long long num) {
     char buf[1 + 3 * sizeof(unsigned long long)];
-    return concat(buf, sprintf(buf, "%llu", num));
+    const char *str = ulltoa(num, buf, sizeof(buf), 10);
+    return concat(str, &buf[sizeof(buf) - 1] - str);
 }
 
 bool String::concat(float num) {
@@ -43,6 +43,8 @@
 #include "misc_wstring.h"
 #endif
 
+#include "StringView.h"
+
  // an abstract class used as a means to proide a unique pointer type
  // but really has no body
 class __FlashStringHelper;
@@ -72,6 +74,8 @@ class String {
         String(const String &str);
         String(const __FlashStringHelper *str);
         String(String &&rval) noexcept;
+        // copies the view, see StringView.h
+        explicit String(const StringView &view);
         explicit String(char c) {
             sso.buff[0] = c;
             sso.buff[1] = 0;
@@ -140,6 +144,9 @@ class String {
         bool concat(double num);
         bool concat(const __FlashStringHelper *str);
         bool concat(const char *cstr, unsigned int length);
+        bool concat(const StringView &view) {
+            return concat(view.data(), view.length());
+        }
 
         // if there's not enough memory for the concatenated value, the string
         // will be left unchanged (but this isn't signalled in any way)
@@ -1063,6 +1070,9 @@ inline String operator +(const __FlashStringHelper *lhs, String &&rhs) {
     return std::move(rhs.insert(0, lhs));
 }
 
+inline StringView::StringView(const String &str)
+    : _ptr(str.c_str() ? str.c_str() : ""), _len(str.length()), _progmem(false) { }
+
 extern const String emptyString;
 
 #endif  // __cplusplus
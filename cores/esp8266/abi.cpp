@@ -33,6 +33,13 @@ extern "C" void __cxa_deleted_virtual(void) __attribute__ ((__noreturn__));
 
 #if !defined(__cpp_exceptions)
 
+#if defined(UMM_HEAP_TRACE)
+// record the caller of operator new instead of operator new itself
+extern "C" void *umm_heap_trace_new(size_t size, const void *caller);
+#undef malloc
+#define malloc(s) umm_heap_trace_new(s, __builtin_return_address(0))
+#endif
+
 // overwrite weak operators new/new[] definitions
 
 void* operator new(size_t size)
@@ -77,6 +84,10 @@ void* operator new[] (size_t size, const std::nothrow_t&)
     return ret;
 }
 
+#if defined(UMM_HEAP_TRACE)
+#undef malloc
+#endif
+
 #endif // !defined(__cpp_exceptions)
 
 void __cxa_pure_virtual(void)
@@ -28,6 +28,183 @@ extern "C" {
 }
 #include "base64.h"
 
+namespace
+{
+
+const char encodeTable[] PROGMEM __attribute__((aligned(4))) =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// value of the characters from '+' to 'z', both alphabets; 0x40 is
+// invalid, 0x41 is '='
+constexpr uint8_t decodeFirst = '+';
+const uint8_t decodeTable[] PROGMEM __attribute__((aligned(4))) =
+{
+    62, 0x40, 62, 0x40, 63,                                     // + , - . /
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61,                     // 0-9
+    0x40, 0x40, 0x40, 0x41, 0x40, 0x40, 0x40,                   // : ; < = > ? @
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,                   // A-M
+    13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,         // N-Z
+    0x40, 0x40, 0x40, 0x40, 63, 0x40,                           // [ \ ] ^ _ `
+    26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38,         // a-m
+    39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51,         // n-z
+};
+constexpr uint8_t invalid = 0x40;
+constexpr uint8_t padding = 0x41;
+
+// a group of three bytes as one 24 bit word, four characters out;
+// the table is copied to the stack once, flash is only word readable
+inline void encodeGroup(const char* table, uint32_t word, char* out)
+{
+    out[0] = table[(word >> 18) & 0x3f];
+    out[1] = table[(word >> 12) & 0x3f];
+    out[2] = table[(word >> 6) & 0x3f];
+    out[3] = table[word & 0x3f];
+}
+
+size_t encodeBlock(const char* table, const uint8_t* data, size_t length, char* out)
+{
+    char* start = out;
+    for (; length >= 3; length -= 3, data += 3, out += 4)
+    {
+        encodeGroup(table, (data[0] << 16) | (data[1] << 8) | data[2], out);
+    }
+    if (length)
+    {
+        uint32_t word = (data[0] << 16) | (length > 1 ? data[1] << 8 : 0);
+        encodeGroup(table, word, out);
+        out[3] = '=';
+        if (length == 1)
+        {
+            out[2] = '=';
+        }
+        out += 4;
+    }
+    return out - start;
+}
+
+// Decodes text to out, each block of four characters being gathered into
+// one 24 bit word; flush(out, count, last) is called when out is full and
+// at the end with last set, and returns false to stop
+template <typename Flush>
+ssize_t decodeBlocks(const char* text, size_t length, uint8_t* out, size_t maxOut, Flush flush)
+{
+    size_t total = 0;
+    size_t used = 0;
+    uint32_t word = 0;
+    int sextets = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        uint8_t c = text[i];
+        if (c == ' ' || c == '\n' || c == '\r' || c == '\t')
+        {
+            continue;
+        }
+        uint8_t value = (c >= decodeFirst && c < decodeFirst + sizeof(decodeTable)) ?
+                        pgm_read_byte(decodeTable + c - decodeFirst) : invalid;
+        if (value == padding)
+        {
+            break;
+        }
+        if (value == invalid)
+        {
+            return -1;
+        }
+        word = (word << 6) | value;
+        if (++sextets == 4)
+        {
+            if (maxOut - used < 3)
+            {
+                if (!flush(out, used, false))
+                {
+                    return -1;
+                }
+                total += used;
+                used = 0;
+            }
+            out[used++] = word >> 16;
+            out[used++] = word >> 8;
+            out[used++] = word;
+            word = 0;
+            sextets = 0;
+        }
+    }
+    if (sextets == 1)
+    {
+        return -1;
+    }
+    if (sextets)
+    {
+        // 2 characters for 1 byte, 3 for 2 bytes
+        word <<= 6 * (4 - sextets);
+        uint8_t tail[2] = { (uint8_t)(word >> 16), (uint8_t)(word >> 8) };
+        for (int i = 0; i < sextets - 1; ++i)
+        {
+            if (used == maxOut)
+            {
+                if (!flush(out, used, false))
+                {
+                    return -1;
+                }
+                total += used;
+                used = 0;
+            }
+            out[used++] = tail[i];
+        }
+    }
+    if (used && !flush(out, used, true))
+    {
+        return -1;
+    }
+    return total + used;
+}
+
+} // namespace
+
+size_t base64::encodeTo(const uint8_t* data, size_t length, char* out)
+{
+    char table[64];
+    memcpy_P(table, encodeTable, sizeof(table));
+    return encodeBlock(table, data, length, out);
+}
+
+size_t base64::encodeTo(const uint8_t* data, size_t length, Print& out)
+{
+    char table[64];
+    memcpy_P(table, encodeTable, sizeof(table));
+    constexpr size_t block = 48;
+    char buf[encodedLength(block)];
+    size_t written = 0;
+    for (size_t pos = 0; pos < length; pos += block)
+    {
+        size_t len = encodeBlock(table, data + pos, std::min(block, length - pos), buf);
+        size_t ret = out.write(buf, len);
+        written += ret;
+        if (ret != len)
+        {
+            break;
+        }
+    }
+    return written;
+}
+
+ssize_t base64::decodeTo(const char* text, size_t length, uint8_t* out, size_t outSize)
+{
+    // a full out is only an error if there is more to decode
+    return decodeBlocks(text, length, out, outSize, [](uint8_t*, size_t, bool last)
+    {
+        return last;
+    });
+}
+
+ssize_t base64::decodeTo(const char* text, size_t length, Print& out)
+{
+    uint8_t buf[48];
+    return decodeBlocks(text, length, buf, sizeof(buf), [&out](uint8_t* data, size_t len, bool)
+    {
+        return out.write(data, len) == len;
+    });
+}
+
 /**
  * convert input data to base64
  * @param data const uint8_t *
@@ -44,28 +221,23 @@ String base64::encode(const uint8_t * data, size_t length, bool doNewLines)
 
     if (base64.reserve(size))
     {
+        char table[64];
+        memcpy_P(table, encodeTable, sizeof(table));
 
-        base64_encodestate _state;
-        if (doNewLines)
-        {
-            base64_init_encodestate(&_state);
-        }
-        else
-        {
-            base64_init_encodestate_nonewlines(&_state);
-        }
-
-        constexpr size_t BUFSIZE = 48;
-        char buf[BUFSIZE + 1 /* newline */ + 1 /* NUL */];
-        for (size_t len = 0; len < length; len += BUFSIZE * 3 / 4)
+        // libb64 puts a newline after each full line of 72 characters
+        constexpr size_t line = BASE64_CHARS_PER_LINE / 4 * 3;
+        constexpr size_t block = line;
+        char buf[encodedLength(block) + 1 /* newline */];
+        for (size_t len = 0; len < length; len += block)
         {
-            size_t blocklen = base64_encode_block((const char*) data + len,
-                                                  std::min( BUFSIZE * 3 / 4, length - len ), buf, &_state);
-            buf[blocklen] = '\0';
-            base64 += buf;
+            size_t blocklen = std::min(block, length - len);
+            size_t chars = encodeBlock(table, data + len, blocklen, buf);
+            if (doNewLines && blocklen == line)
+            {
+                buf[chars++] = '\n';
+            }
+            base64.concat(buf, chars);
         }
-        if (base64_encode_blockend(buf, &_state))
-            base64 += buf;
     }
     else
     {
@@ -25,8 +25,11 @@
 #ifndef CORE_BASE64_H_
 #define CORE_BASE64_H_
 
+#include <sys/types.h> // ssize_t
 #include <WString.h>
 
+class Print;
+
 class base64
 {
 public:
@@ -50,6 +53,36 @@ public:
     {
         return encode(text, false);
     }
+
+    // Buffer based codec, without newlines: three bytes at a time in a
+    // 24 bit word, through a table, and no String or heap
+
+    // characters written by encodeTo() for length bytes, without a nul
+    static constexpr size_t encodedLength(size_t length)
+    {
+        return (length + 2) / 3 * 4;
+    }
+    // the most bytes decodeTo() can write for length characters
+    static constexpr size_t decodedLength(size_t length)
+    {
+        return length / 4 * 3 + (length % 4) * 3 / 4;
+    }
+
+    // out must hold encodedLength(length) characters, the count written
+    // is returned and out is not nul terminated
+    static size_t encodeTo(const uint8_t* data, size_t length, char* out);
+    // encoded in small blocks on the stack, the count written is returned
+    static size_t encodeTo(const uint8_t* data, size_t length, Print& out);
+
+    // Whitespace is skipped, '=' ends the data and both the standard and
+    // the URL safe (-_) alphabets are accepted.  Returns the count of
+    // bytes written, or -1 on an invalid character or when out is full.
+    static ssize_t decodeTo(const char* text, size_t length, uint8_t* out, size_t outSize);
+    static ssize_t decodeTo(const char* text, size_t length, Print& out);
+    static inline ssize_t decodeTo(const String& text, uint8_t* out, size_t outSize)
+    {
+        return decodeTo(text.c_str(), text.length(), out, outSize);
+    }
 private:
 };
 
@@ -178,3 +178,55 @@ size_t cbuf::remove(size_t size) {
     _begin = wrap_if_bufend(_begin + size_to_remove);
     return available();
 }
+
+size_t cbuf::peekAvailable() const {
+    if(_end >= _begin) {
+        return _end - _begin;
+    }
+    return _bufend - _begin;
+}
+
+size_t cbuf::readSpans(span spans[2]) const {
+    spans[0].data = _begin;
+    spans[0].size = peekAvailable();
+    spans[1].data = _buf;
+    spans[1].size = (_end < _begin) ? _end - _buf : 0;
+    return spans[0].size + spans[1].size;
+}
+
+size_t cbuf::writeSpans(span spans[2]) {
+    // one byte is always kept free to tell full from empty
+    spans[0].data = _end;
+    spans[1].data = _buf;
+    if(_end >= _begin) {
+        if(_begin == _buf) {
+            spans[0].size = _bufend - _end - 1;
+            spans[1].size = 0;
+        } else {
+            spans[0].size = _bufend - _end;
+            spans[1].size = _begin - _buf - 1;
+        }
+    } else {
+        spans[0].size = _begin - _end - 1;
+        spans[1].size = 0;
+    }
+    return spans[0].size + spans[1].size;
+}
+
+void cbuf::consume(size_t size) {
+    size_t top_size = _bufend - _begin;
+    if(size >= top_size) {
+        _begin = _buf + (size - top_size);
+    } else {
+        _begin += size;
+    }
+}
+
+void cbuf::commit(size_t size) {
+    size_t top_size = _bufend - _end;
+    if(size >= top_size) {
+        _end = _buf + (size - top_size);
+    } else {
+        _end += size;
+    }
+}
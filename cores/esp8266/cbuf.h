@@ -57,6 +57,32 @@ class cbuf {
         void flush();
         size_t remove(size_t size);
 
+        // zero-copy access
+        // Data lies in at most two contiguous segments, the second one is
+        // only used when the data wraps around the end of the buffer.
+        struct span {
+            char* data;
+            size_t size;
+        };
+
+        // fill spans[0..1] with the readable data, returns available()
+        // bytes stay in the buffer until consume()
+        size_t readSpans(span spans[2]) const;
+        // fill spans[0..1] with the free space, returns room()
+        // bytes written there are only readable after commit()
+        size_t writeSpans(span spans[2]);
+
+        // drop `size` (<= available()) bytes, after readSpans() or peekBuffer()
+        void consume(size_t size);
+        // make `size` (<= room()) bytes written through writeSpans() readable
+        void commit(size_t size);
+
+        // first readable segment, the same as readSpans()'s spans[0]
+        inline const char* peekBuffer() const {
+            return _begin;
+        }
+        size_t peekAvailable() const;
+
         cbuf *next;
 
     private:
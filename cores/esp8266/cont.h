@@ -23,9 +23,15 @@
 
 #include <stdbool.h>
 
+// Selected with the IDE Tools menu "Sketch Stack Size".  Stacks above 4KB
+// are allocated in the heap, smaller stacks only save heap together with
+// disable_extra4k_at_link_time(), the default stack uses spare SYS stack.
 #ifndef CONT_STACKSIZE
 #define CONT_STACKSIZE 4096
 #endif
+#if (CONT_STACKSIZE % 16) || (CONT_STACKSIZE < 1024)
+#error CONT_STACKSIZE must be a multiple of 16, at least 1024
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -0,0 +1,93 @@
+/*
+ core_esp8266_flash_stats.cpp - flash operation counters and latencies
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <Arduino.h>
+#include "flash_hal.h"
+
+#if FLASH_STATS
+static flash_stats_t flash_stats[FLASH_STATS_OP_COUNT];
+#endif
+
+extern "C" void flash_stats_record(int op, uint32_t bytes, uint32_t us, bool ok) {
+#if FLASH_STATS
+    if (op < 0 || op >= FLASH_STATS_OP_COUNT) {
+        return;
+    }
+    flash_stats_t& stats = flash_stats[op];
+    stats.count++;
+    stats.errors += !ok;
+    stats.bytes += bytes;
+    stats.us += us;
+    stats.max_us = std::max(stats.max_us, us);
+    int bin = 0;
+    while ((bin < FLASH_STATS_BINS - 1) && (us >= (16U << bin))) {
+        bin++;
+    }
+    stats.histogram[bin]++;
+#else
+    (void)op;
+    (void)bytes;
+    (void)us;
+    (void)ok;
+#endif
+}
+
+extern "C" bool flash_stats_get(int op, flash_stats_t *stats) {
+#if FLASH_STATS
+    if (op < 0 || op >= FLASH_STATS_OP_COUNT || !stats) {
+        return false;
+    }
+    *stats = flash_stats[op];
+    return true;
+#else
+    (void)op;
+    (void)stats;
+    return false;
+#endif
+}
+
+extern "C" void flash_stats_reset(void) {
+#if FLASH_STATS
+    for (auto& stats : flash_stats) {
+        stats = { };
+    }
+#endif
+}
+
+void flash_stats_print(Print& out) {
+#if FLASH_STATS
+    static const char* const names[FLASH_STATS_OP_COUNT] = { "read", "write", "erase" };
+    for (int op = 0; op < FLASH_STATS_OP_COUNT; op++) {
+        const flash_stats_t& stats = flash_stats[op];
+        out.printf_P(PSTR("flash %s: count=%u errors=%u bytes=%llu us=%llu max=%u avg=%u\n"),
+            names[op], stats.count, stats.errors, (unsigned long long)stats.bytes, (unsigned long long)stats.us,
+            stats.max_us, stats.count ? (uint32_t)(stats.us / stats.count) : 0);
+        out.print(F("  <us:"));
+        for (int bin = 0; bin < FLASH_STATS_BINS; bin++) {
+            if (bin < FLASH_STATS_BINS - 1) {
+                out.printf_P(PSTR(" %u=%u"), 16U << bin, stats.histogram[bin]);
+            } else {
+                out.printf_P(PSTR(" more=%u\n"), stats.histogram[bin]);
+            }
+        }
+    }
+#else
+    (void)out;
+#endif
+}
@@ -28,8 +28,10 @@
 
 extern "C" {
 
-#define SLC_BUF_CNT (8)  // Number of buffers in the I2S circular buffer
-#define SLC_BUF_LEN (64) // Length of one buffer, in 32-bit words.
+#define SLC_BUF_CNT (8)  // Default number of buffers in the I2S circular buffer
+#define SLC_BUF_LEN (64) // Default length of one buffer, in 32-bit words.
+#define SLC_BUF_CNT_MAX (64)   // slc_queue_len is 8 bits
+#define SLC_BUF_LEN_MAX (1023) // blocksize is 12 bits, in bytes
 
 // We use a queue to keep track of the DMA buffers that are empty. The ISR
 // will push buffers to the back of the queue, the I2S transmitter will pull
@@ -54,12 +56,14 @@ typedef struct slc_queue_item {
 } slc_queue_item_t;
 
 typedef struct i2s_state {
-  uint32_t *       slc_queue[SLC_BUF_CNT];
+  uint32_t **      slc_queue; // _i2s_buf_cnt of each, allocated by _alloc_channel()
   volatile uint8_t slc_queue_len;
-  uint32_t *       slc_buf_pntr[SLC_BUF_CNT]; // Pointer to the I2S DMA buffer data
-  slc_queue_item_t slc_items[SLC_BUF_CNT]; // I2S DMA buffer descriptors
+  uint32_t **      slc_buf_pntr; // Pointer to the I2S DMA buffer data
+  slc_queue_item_t *slc_items; // I2S DMA buffer descriptors
   uint32_t *       curr_slc_buf; // Current buffer for writing
   uint32_t         curr_slc_buf_pos; // Position in the current buffer
+  uint32_t *       acquired_buf; // Block handed out by i2s_tx_acquire_block(), not committed yet
+  volatile uint32_t underruns; // Blocks played without fresh data
   void             (*callback) (void);
   // Callback function should be defined as 'void IRAM_ATTR function_name()',
   // and be placed in IRAM for faster execution. Avoid long computational tasks in this
@@ -75,6 +79,10 @@ static i2s_state_t *tx = NULL;
 static uint32_t _i2s_sample_rate;
 static int _i2s_bits = 16;
 
+// DMA buffers of the next begin
+static uint8_t _i2s_buf_cnt = SLC_BUF_CNT;
+static uint16_t _i2s_buf_len = SLC_BUF_LEN;
+
 // IOs used for I2S. Not defined in i2s.h, unfortunately.
 // Note these are internal GPIO numbers and not pins on an
 // Arduino board. Users need to verify their particular wiring.
@@ -93,11 +101,24 @@ bool i2s_set_bits(int bits) {
   return true;
 }
 
+bool i2s_set_buffers(uint8_t count, uint16_t len) {
+  if (tx || rx || count < 2 || count > SLC_BUF_CNT_MAX || len < 1 || len > SLC_BUF_LEN_MAX) {
+    return false;
+  }
+  _i2s_buf_cnt = count;
+  _i2s_buf_len = len;
+  return true;
+}
+
+uint16_t i2s_get_buffer_len() {
+  return _i2s_buf_len;
+}
+
 static bool _i2s_is_full(const i2s_state_t *ch) {
   if (!ch) {
     return false;
   }
-  return (ch->curr_slc_buf_pos==SLC_BUF_LEN || ch->curr_slc_buf==NULL) && (ch->slc_queue_len == 0);
+  return (ch->curr_slc_buf_pos==_i2s_buf_len || ch->curr_slc_buf==NULL) && (ch->slc_queue_len == 0);
 }
 
 bool i2s_is_full() {
@@ -112,7 +133,7 @@ static bool _i2s_is_empty(const i2s_state_t *ch) {
   if (!ch) {
     return false;
   }
-  return (ch->slc_queue_len >= SLC_BUF_CNT-1);
+  return (ch->slc_queue_len >= _i2s_buf_cnt-1);
 }
 
 bool i2s_is_empty() {
@@ -127,7 +148,7 @@ static uint16_t _i2s_available(const i2s_state_t *ch) {
   if (!ch) {
     return 0;
   }
-  return (SLC_BUF_CNT - ch->slc_queue_len) * SLC_BUF_LEN;
+  return (_i2s_buf_cnt - ch->slc_queue_len) * _i2s_buf_len;
 }
 
 uint16_t i2s_available(){
@@ -157,7 +178,7 @@ static void IRAM_ATTR i2s_slc_queue_append_item(i2s_state_t *ch, uint32_t *item)
       ch->slc_queue[dest++] = ch->slc_queue[i];
     }
   }
-  if (ch->slc_queue_len < SLC_BUF_CNT - 1) {
+  if (ch->slc_queue_len < _i2s_buf_cnt - 1) {
     ch->slc_queue[ch->slc_queue_len++] = item;
   } else {
     ch->slc_queue[ch->slc_queue_len] = item;
@@ -171,10 +192,15 @@ static void IRAM_ATTR i2s_slc_isr(void) {
   if (slc_intr_status & SLCIRXEOF) {
     slc_queue_item_t *finished_item = (slc_queue_item_t *)SLCRXEDA;
     // Zero the buffer so it is mute in case of underflow
-    ets_memset((void *)finished_item->buf_ptr, 0x00, SLC_BUF_LEN * 4);
-    if (tx->slc_queue_len >= SLC_BUF_CNT-1) {
+    ets_memset((void *)finished_item->buf_ptr, 0x00, _i2s_buf_len * 4);
+    if (tx->slc_queue_len >= _i2s_buf_cnt-1) {
       // All buffers are empty. This means we have an underflow
       i2s_slc_queue_next_item(tx); // Free space for finished_item
+      tx->underruns++;
+    } else if (finished_item->buf_ptr == tx->acquired_buf) {
+      // Played before being committed
+      tx->acquired_buf = NULL;
+      tx->underruns++;
     }
     tx->slc_queue[tx->slc_queue_len++] = finished_item->buf_ptr;
     if (tx->callback) {
@@ -203,22 +229,28 @@ void i2s_rx_set_callback(void (*callback) (void)) {
 
 static bool _alloc_channel(i2s_state_t *ch) {
   ch->slc_queue_len = 0;
-  for (int x=0; x<SLC_BUF_CNT; x++) {
-    ch->slc_buf_pntr[x] = (uint32_t *)malloc(SLC_BUF_LEN * sizeof(ch->slc_buf_pntr[0][0]));
+  ch->slc_queue = (uint32_t **)calloc(_i2s_buf_cnt, sizeof(ch->slc_queue[0]));
+  ch->slc_buf_pntr = (uint32_t **)calloc(_i2s_buf_cnt, sizeof(ch->slc_buf_pntr[0]));
+  ch->slc_items = (slc_queue_item_t *)calloc(_i2s_buf_cnt, sizeof(ch->slc_items[0]));
+  if (!ch->slc_queue || !ch->slc_buf_pntr || !ch->slc_items) {
+    return false;
+  }
+  for (int x=0; x<_i2s_buf_cnt; x++) {
+    ch->slc_buf_pntr[x] = (uint32_t *)malloc(_i2s_buf_len * sizeof(ch->slc_buf_pntr[0][0]));
     if (!ch->slc_buf_pntr[x]) {
       // OOM, the upper layer will free up any partially allocated channels.
       return false;
     }
-    memset(ch->slc_buf_pntr[x], 0, SLC_BUF_LEN * sizeof(ch->slc_buf_pntr[x][0]));
+    memset(ch->slc_buf_pntr[x], 0, _i2s_buf_len * sizeof(ch->slc_buf_pntr[x][0]));
 
     ch->slc_items[x].unused = 0;
     ch->slc_items[x].owner = 1;
     ch->slc_items[x].eof = 1;
     ch->slc_items[x].sub_sof = 0;
-    ch->slc_items[x].datalen = SLC_BUF_LEN * 4;
-    ch->slc_items[x].blocksize = SLC_BUF_LEN * 4;
+    ch->slc_items[x].datalen = _i2s_buf_len * 4;
+    ch->slc_items[x].blocksize = _i2s_buf_len * 4;
     ch->slc_items[x].buf_ptr = (uint32_t*)&ch->slc_buf_pntr[x][0];
-    ch->slc_items[x].next_link_ptr = (x<(SLC_BUF_CNT-1))?(&ch->slc_items[x+1]):(&ch->slc_items[0]);
+    ch->slc_items[x].next_link_ptr = (x<(_i2s_buf_cnt-1))?(&ch->slc_items[x+1]):(&ch->slc_items[0]);
   }
   return true;
 }
@@ -284,15 +316,20 @@ static void i2s_slc_end(){
   SLCTXL &= ~(SLCTXLAM << SLCTXLA); // clear TX descriptor address
   SLCRXL &= ~(SLCRXLAM << SLCRXLA); // clear RX descriptor address
 
-  for (int x = 0; x<SLC_BUF_CNT; x++) {
-    if (tx) {
-      free(tx->slc_buf_pntr[x]);
-      tx->slc_buf_pntr[x] = NULL;
+  i2s_state_t *channels[] = { tx, rx };
+  for (i2s_state_t *ch : channels) {
+    if (!ch) {
+      continue;
     }
-    if (rx) {
-      free(rx->slc_buf_pntr[x]);
-      rx->slc_buf_pntr[x] = NULL;
+    for (int x = 0; ch->slc_buf_pntr && x<_i2s_buf_cnt; x++) {
+      free(ch->slc_buf_pntr[x]);
     }
+    free(ch->slc_buf_pntr);
+    free(ch->slc_queue);
+    free(ch->slc_items);
+    ch->slc_buf_pntr = NULL;
+    ch->slc_queue = NULL;
+    ch->slc_items = NULL;
   }
 }
 
@@ -303,7 +340,7 @@ static bool _i2s_write_sample(uint32_t sample, bool nb) {
     return false;
   }
 
-  if (tx->curr_slc_buf_pos==SLC_BUF_LEN || tx->curr_slc_buf==NULL) {
+  if (tx->curr_slc_buf_pos==_i2s_buf_len || tx->curr_slc_buf==NULL) {
     if (tx->slc_queue_len == 0) {
       if (nb) {
         // Don't wait if nonblocking, just notify upper levels
@@ -349,7 +386,7 @@ static uint16_t _i2s_write_buffer(const int16_t *frames, uint16_t frame_count, b
     while(frame_count>0) {
    
         // make sure we have room in the current buffer
-        if (tx->curr_slc_buf_pos==SLC_BUF_LEN || tx->curr_slc_buf==NULL) {
+        if (tx->curr_slc_buf_pos==_i2s_buf_len || tx->curr_slc_buf==NULL) {
             // no room in the current buffer? if there are no buffers available then exit
             if (tx->slc_queue_len == 0)
             {
@@ -376,7 +413,7 @@ static uint16_t _i2s_write_buffer(const int16_t *frames, uint16_t frame_count, b
         }       
 
         //space available in the current buffer
-        uint16_t	available = SLC_BUF_LEN - tx->curr_slc_buf_pos;
+        uint16_t	available = _i2s_buf_len - tx->curr_slc_buf_pos;
 
         uint16_t fc = (available < frame_count) ? available : frame_count;
 
@@ -401,6 +438,46 @@ static uint16_t _i2s_write_buffer(const int16_t *frames, uint16_t frame_count, b
     return frames_written;
 }
 
+// Zero-copy transmit: the DMA buffers are handed out whole, to be filled in place.
+// The DMA plays all buffers in a ring, so a block acquired right after it was played
+// has (count - 1) block periods before being played again.
+uint32_t *i2s_tx_acquire_block(bool blocking) {
+  if (!tx) {
+    return NULL;
+  }
+  if (tx->slc_queue_len == 0) {
+    if (!blocking) {
+      return NULL;
+    }
+    while (tx->slc_queue_len == 0) {
+      optimistic_yield(10000);
+    }
+  }
+  ETS_SLC_INTR_DISABLE();
+  uint32_t *block = i2s_slc_queue_next_item(tx);
+  tx->acquired_buf = block;
+  ETS_SLC_INTR_ENABLE();
+  // The sample writers go on with the next block
+  tx->curr_slc_buf = block;
+  tx->curr_slc_buf_pos = _i2s_buf_len;
+  return block;
+}
+
+void i2s_tx_commit_block(uint32_t *block) {
+  if (!tx) {
+    return;
+  }
+  ETS_SLC_INTR_DISABLE();
+  if (tx->acquired_buf == block) {
+    tx->acquired_buf = NULL;
+  }
+  ETS_SLC_INTR_ENABLE();
+}
+
+uint32_t i2s_get_underruns() {
+  return tx ? tx->underruns : 0;
+}
+
 uint16_t i2s_write_buffer_mono_nb(const int16_t *frames, uint16_t frame_count) { return _i2s_write_buffer(frames, frame_count, true, true); }
 
 uint16_t i2s_write_buffer_mono(const int16_t *frames, uint16_t frame_count) { return _i2s_write_buffer(frames, frame_count, true, false); }
@@ -413,7 +490,7 @@ bool i2s_read_sample(int16_t *left, int16_t *right, bool blocking) {
   if (!rx) {
     return false;
   }
-  if (rx->curr_slc_buf_pos==SLC_BUF_LEN || rx->curr_slc_buf==NULL) {
+  if (rx->curr_slc_buf_pos==_i2s_buf_len || rx->curr_slc_buf==NULL) {
     if (rx->slc_queue_len == 0) {
       if (!blocking) {
         return false;
@@ -579,7 +656,7 @@ bool i2s_rxtxdrive_begin(bool enableRx, bool enableTx, bool driveRxClocks, bool
 
   if (rx) {
     // Need to prime the # of samples to receive in the engine
-    I2SRXEN = SLC_BUF_LEN;
+    I2SRXEN = _i2s_buf_len;
   }
 
   I2SC |= (rx?I2SRXS:0) | (tx?I2STXS:0); // Start transmission/reception
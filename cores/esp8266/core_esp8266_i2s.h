@@ -47,6 +47,11 @@ bool i2s_set_bits(int bits); // Set bits per sample, only 16 or 24 supported.  C
 // Note that in 24 bit mode each sample must be left-aligned (i.e. 0x00000000 .. 0xffffff00) as the
 // hardware shifts starting at bit 31, not bit 23.
 
+// Set the DMA ring, count buffers (2..64, default 8) of len 32-bit samples (1..1023, default 64).
+// Call before begin. A longer ring survives longer stalls of the loop, at the cost of latency and RAM.
+bool i2s_set_buffers(uint8_t count, uint16_t len);
+uint16_t i2s_get_buffer_len(); // Samples of one DMA buffer (block)
+
 void i2s_begin(); // Enable TX only, for compatibility
 bool i2s_rxtx_begin(bool enableRx, bool enableTx); // Allow TX and/or RX, returns false on OOM error
 bool i2s_rxtxdrive_begin(bool enableRx, bool enableTx, bool driveRxClocks, bool driveTxClocks);
@@ -74,6 +79,13 @@ uint16_t i2s_write_buffer_mono_nb(const int16_t *frames, uint16_t frame_count);
 uint16_t i2s_write_buffer(const int16_t *frames, uint16_t frame_count);
 uint16_t i2s_write_buffer_nb(const int16_t *frames, uint16_t frame_count);
 
+// Zero-copy transmit: acquire the next free DMA block (i2s_get_buffer_len() samples, NULL when
+// none is free and not blocking), fill it in place, then commit it. A block still not committed
+// when the DMA plays it, or no block at all, counts as an underrun.
+uint32_t *i2s_tx_acquire_block(bool blocking);
+void i2s_tx_commit_block(uint32_t *block);
+uint32_t i2s_get_underruns(); // Underruns since begin
+
 #ifdef __cplusplus
 }
 #endif
@@ -67,6 +67,26 @@ static os_event_t s_loop_queue[LOOP_QUEUE_SIZE];
 /* Used to implement optimistic_yield */
 static uint32_t s_cycles_at_resume;
 
+/* Free stack after the last loop() and least of all loop()s, while profiling */
+static bool s_stack_profiling;
+static uint32_t s_stack_free_last;
+static uint32_t s_stack_free_min;
+
+/* Yield gap statistics, see yield_gap_stats() */
+static uint32_t s_resume_pc;
+static uint32_t s_gap_max_cycles;
+static uint32_t s_gap_max_start_pc;
+static uint32_t s_gap_max_end_pc;
+static uint32_t s_gap_over_count;
+static uint32_t s_gap_warn_cycles;
+static yield_gap_warning_t s_gap_warning;
+static bool s_gap_warned;
+
+/* Boot timeline, see boot_timeline_cycles().  Placed into noinit section
+ * because the first stages are marked before .bss is zero-filled.
+ */
+static uint32_t s_boot_timeline[BOOT_STAGE_COUNT] __attribute__((section(".noinit")));
+
 /* For ets_intr_lock_nest / ets_intr_unlock_nest
  * Max nesting seen by SDK so far is 2.
  */
@@ -116,8 +136,35 @@ extern "C" bool can_yield() {
   return cont_can_suspend(g_pcont);
 }
 
-static inline void esp_suspend_within_cont() __attribute__((always_inline));
-static void esp_suspend_within_cont() {
+static inline uint32_t cycles_per_us() {
+#if defined(F_CPU)
+    return clockCyclesPerMicrosecond();
+#else
+    return ESP.getCpuFreqMHz();
+#endif
+}
+
+// The stretch of CONT started at s_cycles_at_resume ends at pc
+static void yield_gap_end(uint32_t pc) {
+    uint32_t gap = ESP.getCycleCount() - s_cycles_at_resume;
+    if (gap > s_gap_max_cycles) {
+        s_gap_max_cycles = gap;
+        s_gap_max_start_pc = s_resume_pc;
+        s_gap_max_end_pc = pc;
+    }
+    if (s_gap_warn_cycles && gap > s_gap_warn_cycles) {
+        s_gap_over_count++;
+        if (!s_gap_warned && s_gap_warning) {
+            s_gap_warning(gap / cycles_per_us(), pc);
+        }
+    }
+    s_gap_warned = false;
+    s_resume_pc = pc;
+}
+
+static inline void esp_suspend_within_cont(uint32_t pc) __attribute__((always_inline));
+static void esp_suspend_within_cont(uint32_t pc) {
+        yield_gap_end(pc);
         cont_suspend(g_pcont);
         s_cycles_at_resume = ESP.getCycleCount();
         run_scheduled_recurrent_functions();
@@ -125,7 +172,7 @@ static void esp_suspend_within_cont() {
 
 extern "C" void __esp_suspend() {
     if (cont_can_suspend(g_pcont)) {
-        esp_suspend_within_cont();
+        esp_suspend_within_cont((uint32_t)__builtin_return_address(0));
     }
 }
 
@@ -185,7 +232,7 @@ bool esp_try_delay(const uint32_t start_ms, const uint32_t timeout_ms, const uin
 extern "C" void __yield() {
     if (cont_can_suspend(g_pcont)) {
         esp_schedule();
-        esp_suspend_within_cont();
+        esp_suspend_within_cont((uint32_t)__builtin_return_address(0));
     }
     else {
         panic();
@@ -198,19 +245,68 @@ extern "C" void yield(void) __attribute__ ((weak, alias("__yield")));
 // has elapsed since the last time yield() occured. Whereas yield() panics
 // in SYS, optimistic_yield() additionally is safe to call and does nothing.
 extern "C" void optimistic_yield(uint32_t interval_us) {
-    const uint32_t intvl_cycles = interval_us *
-#if defined(F_CPU)
-        clockCyclesPerMicrosecond();
-#else
-        ESP.getCpuFreqMHz();
-#endif
-    if ((ESP.getCycleCount() - s_cycles_at_resume) > intvl_cycles &&
+    const uint32_t intvl_cycles = interval_us * cycles_per_us();
+    const uint32_t gap = ESP.getCycleCount() - s_cycles_at_resume;
+    if (s_gap_warn_cycles && gap > s_gap_warn_cycles && !s_gap_warned &&
+        s_gap_warning && can_yield())
+    {
+        s_gap_warned = true;
+        s_gap_warning(gap / cycles_per_us(), (uint32_t)__builtin_return_address(0));
+    }
+    if (gap > intvl_cycles &&
         can_yield())
     {
         yield();
     }
 }
 
+extern "C" void cont_stack_profiling(bool enable) {
+    if (enable && !s_stack_profiling) {
+        s_stack_free_last = 0;
+        s_stack_free_min = UINT32_MAX;
+        cont_repaint_stack(g_pcont);
+    }
+    s_stack_profiling = enable;
+}
+
+extern "C" uint32_t cont_stack_profile_last(void) {
+    return s_stack_free_last;
+}
+
+extern "C" uint32_t cont_stack_profile_min(void) {
+    return (s_stack_free_min == UINT32_MAX) ? 0 : s_stack_free_min;
+}
+
+extern "C" void yield_gap_stats(yield_gap_stats_t* stats, bool reset) {
+    stats->max_us = s_gap_max_cycles / cycles_per_us();
+    stats->max_start_pc = s_gap_max_start_pc;
+    stats->max_end_pc = s_gap_max_end_pc;
+    stats->over_count = s_gap_over_count;
+    if (reset) {
+        s_gap_max_cycles = 0;
+        s_gap_max_start_pc = 0;
+        s_gap_max_end_pc = 0;
+        s_gap_over_count = 0;
+    }
+}
+
+extern "C" void yield_gap_warning(uint32_t threshold_us, yield_gap_warning_t warning) {
+    s_gap_warning = nullptr;
+    s_gap_warn_cycles = threshold_us * cycles_per_us();
+    s_gap_warning = warning;
+}
+
+// In IRAM, called from app_entry() while the cache is not enabled yet
+extern "C" void IRAM_ATTR boot_timeline_mark(boot_stage_t stage) {
+    if (stage < BOOT_STAGE_COUNT && !s_boot_timeline[stage]) {
+        s_boot_timeline[stage] = esp_get_cycle_count();
+    }
+}
+
+extern "C" uint32_t boot_timeline_cycles(boot_stage_t stage) {
+    return (stage < BOOT_STAGE_COUNT) ? s_boot_timeline[stage] : 0;
+}
+
 // Replace ets_intr_(un)lock with nestable versions
 extern "C" void IRAM_ATTR ets_intr_lock() {
   if (ets_intr_lock_stack_ptr < ETS_INTR_LOCK_NEST_MAX)
@@ -250,12 +346,22 @@ extern "C" void loop_end (void) __attribute__ ((weak, alias("__loop_end")));
 static void loop_wrapper() {
     static bool setup_done = false;
     preloop_update_frequency();
+    s_resume_pc = (uint32_t)&loop;
     if(!setup_done) {
+        boot_timeline_mark(BOOT_STAGE_SETUP);
         setup();
         setup_done = true;
+        boot_timeline_mark(BOOT_STAGE_LOOP);
     }
     loop();
     loop_end();
+    boot_timeline_mark(BOOT_STAGE_LOOP_END);
+    yield_gap_end((uint32_t)&loop);
+    if (s_stack_profiling) {
+        s_stack_free_last = cont_get_free_stack(g_pcont);
+        s_stack_free_min = std::min(s_stack_free_min, s_stack_free_last);
+        cont_repaint_stack(g_pcont);
+    }
     cont_check(g_pcont);
     if (serialEventRun) {
         serialEventRun();
@@ -313,10 +419,13 @@ static void  __unhandled_exception_cpp()
 }
 
 void init_done() {
+    boot_timeline_mark(BOOT_STAGE_INIT_DONE);
     system_set_os_print(1);
     gdb_init();
     std::set_terminate(__unhandled_exception_cpp);
     do_global_ctors();
+    boot_timeline_mark(BOOT_STAGE_CTORS_DONE);
+    __wifiAssociateAtBootTime(); // default weak function does nothing
     esp_schedule();
     ESP.setDramHeap();
 }
@@ -369,9 +478,15 @@ void init_done() {
 extern "C" void app_entry_redefinable(void) __attribute__((weak));
 extern "C" void app_entry_redefinable(void)
 {
+#if CONT_STACKSIZE > 4096
+    /* Larger than the 4KB the SYS stack can spare, in the heap instead,
+       like with disable_extra4k_at_link_time(). */
+    static cont_t s_cont __attribute__((aligned(16)));
+#else
     /* Allocate continuation context on this SYS stack,
        and save pointer to it. */
     cont_t s_cont __attribute__((aligned(16)));
+#endif
     g_pcont = &s_cont;
 
     /* Doing umm_init just once before starting the SDK, allowed us to remove
@@ -389,6 +504,9 @@ static void app_entry_custom (void) __attribute__((weakref("app_entry_redefinabl
 
 extern "C" void app_entry (void)
 {
+    /* Not in the redefinable part, so that the timeline is always started */
+    ets_memset(s_boot_timeline, 0, sizeof(s_boot_timeline));
+    boot_timeline_mark(BOOT_STAGE_APP_ENTRY);
     return app_entry_custom();
 }
 
@@ -409,6 +527,13 @@ extern "C" void __disableWiFiAtBootTime (void)
     wifi_fpm_do_sleep(0xFFFFFFF);
 }
 
+extern "C" void __wifiAssociateAtBootTime (void) __attribute__((weak));
+extern "C" void __wifiAssociateAtBootTime (void)
+{
+    // overridden by enableWiFiFastConnectAtBootTime() (ESP8266WiFi library):
+    // starts the association with stored credentials, in parallel with setup()
+}
+
 #if FLASH_MAP_SUPPORT
 #include "flash_hal.h"
 extern "C" const char *flashinit (void);
@@ -627,6 +752,7 @@ extern "C" void ICACHE_FLASH_ATTR user_pre_init(void)
 #endif // #if (NONOSDK >= (0x30000))
 
 extern "C" void user_init(void) {
+    boot_timeline_mark(BOOT_STAGE_USER_INIT);
 
 #if (NONOSDK >= (0x30000))
     extern void user_rf_pre_init();
@@ -645,6 +771,8 @@ extern "C" void user_init(void) {
 
     init(); // in core_esp8266_wiring.c, inits hw regs and sdk timer
 
+    rf_cal_cache_check(); // VDD33 drift since the last full RF calibration
+
     initVariant();
 
     experimental::initFlashQuirks(); // Chip specific flash init.
@@ -666,6 +794,7 @@ extern "C" void user_init(void) {
 #if defined(MMU_IRAM_HEAP)
     umm_init_iram();
 #endif
+    boot_timeline_mark(BOOT_STAGE_PREINIT);
     preinit(); // Prior to C++ Dynamic Init (not related to above init() ). Meant to be user redefinable.
     __disableWiFiAtBootTime(); // default weak function disables WiFi
 
@@ -66,76 +66,106 @@ extern "C" {
 static fn_c_exception_handler_t old_c_handler = NULL;
 #endif
 
+// The decoded instructions of the call sites trapping lately, direct mapped
+// on their address.  A site trapping again, e.g. in a loop reading a
+// PROGMEM string byte-wise, skips fetching and decoding its instruction.
+// The counts tell which call sites would be worth fixing.
+#ifndef NON32XFER_SITES
+#define NON32XFER_SITES 16
+#endif
+static_assert((NON32XFER_SITES & (NON32XFER_SITES - 1)) == 0, "NON32XFER_SITES must be a power of two");
+
+enum non32xfer_op : uint8_t { OP_L8UI, OP_L16UI, OP_L16SI, OP_S8I, OP_S16I };
+
+typedef struct {
+  uint32_t epc;   // Address of the trapping instruction, 0 when unused
+  uint32_t count; // Traps since it was decoded
+  uint8_t op;
+  uint8_t regno;  // Index in ef->a_reg
+} non32xfer_decoded_t;
+
+static non32xfer_decoded_t non32xfer_sites[NON32XFER_SITES];
+static uint32_t non32xfer_total;
+
+static inline IRAM_ATTR non32xfer_decoded_t *non32xfer_site(uint32_t epc)
+{
+  return &non32xfer_sites[(epc ^ (epc >> 5)) & (NON32XFER_SITES - 1)];
+}
+
 #if defined(NON32XFER_HANDLER) || (defined(MMU_IRAM_HEAP) && (NONOSDK < (0x30000)))
 static
 IRAM_ATTR void non32xfer_exception_handler(struct __exception_frame *ef, [[maybe_unused]] int cause)
 {
   do {
-    uint32_t insn, excvaddr;
+    uint32_t excvaddr;
+
+    /* Read faulting address as early as possible */
+    __asm__ __volatile__ ("rsr.excvaddr %0;" : "=r"(excvaddr):: "memory");
 
-    /* Extract instruction and faulting data address */
-    __EXCEPTION_HANDLER_PREAMBLE(ef, excvaddr, insn);
+    non32xfer_decoded_t *site = non32xfer_site(ef->epc);
+    if (site->epc != ef->epc) {
+      uint32_t insn;
 
-    uint32_t what = insn & LOAD_MASK;
-    uint32_t valmask = 0;
+      /* Extract instruction and faulting data address */
+      __EXCEPTION_HANDLER_PREAMBLE(ef, excvaddr, insn);
 
-    uint32_t is_read = 1;
-    if (L8UI_MATCH == what || S8I_MATCH == what) {
-      valmask = 0xffu;
-      if (S8I_MATCH == what) {
-        is_read = 0;
+      uint8_t op;
+      switch (insn & LOAD_MASK) {
+        case L8UI_MATCH:  op = OP_L8UI;  break;
+        case L16UI_MATCH: op = OP_L16UI; break;
+        case L16SI_MATCH: op = OP_L16SI; break;
+        case S8I_MATCH:   op = OP_S8I;   break;
+        case S16I_MATCH:  op = OP_S16I;  break;
+        default: continue; /* fail */
       }
-    } else if (L16UI_MATCH == what || L16SI_MATCH == what || S16I_MATCH == what) {
-      valmask = 0xffffu;
-      if (S16I_MATCH == what) {
-        is_read = 0;
+
+      int regno = (insn & 0x0000f0u) >> 4;
+      if (regno == 1) {
+        continue;              /* we can't support storing into a1, just die */
+      } else if (regno != 0) {
+        --regno;               /* account for skipped a1 in exception_frame */
       }
-    } else {
-      continue; /* fail */
-    }
 
-    int regno = (insn & 0x0000f0u) >> 4;
-    if (regno == 1) {
-      continue;              /* we can't support storing into a1, just die */
-    } else if (regno != 0) {
-      --regno;               /* account for skipped a1 in exception_frame */
+      site->epc = ef->epc;
+      site->count = 0;
+      site->op = op;
+      site->regno = regno;
     }
 
 #ifdef DEBUG_ESP_MMU
     /* debug option to validate address so we don't hide memory access bugs in APP */
-    if (mmu_is_iram((void *)excvaddr) || (is_read && mmu_is_icache((void *)excvaddr))) {
+    if (mmu_is_iram((void *)excvaddr) || (site->op < OP_S8I && mmu_is_icache((void *)excvaddr))) {
       /* all is good  */
     } else {
       continue;  /* fail */
     }
 #endif
+    site->count++;
+    non32xfer_total++;
+
     {
       uint32_t *pWord = (uint32_t *)(excvaddr & ~0x3);
       uint32_t pos = (excvaddr & 0x3) * 8;
       uint32_t mem_val = *pWord;
+      uint32_t valmask;
 
-      if (is_read) {
-        /* shift and mask down to correct size */
-        mem_val >>= pos;
-        mem_val &= valmask;
-
-        /* Sign-extend for L16SI, if applicable */
-        if (what == L16SI_MATCH && (mem_val & 0x8000)) {
-          mem_val |= 0xffff0000;
-        }
-
-        ef->a_reg[regno] = mem_val;  /* carry out the load */
-
-      } else { /* is write */
-        uint32_t val = ef->a_reg[regno];  /* get value to store from register */
-        val <<= pos;
-        valmask <<= pos;
-        val &= valmask;
-
-        /* mask out field, and merge */
-        mem_val &= (~valmask);
-        mem_val |= val;
-        *pWord = mem_val; /* carry out the store */
+      switch (site->op) {
+        case OP_L8UI:
+          ef->a_reg[site->regno] = (mem_val >> pos) & 0xffu;  /* carry out the load */
+          break;
+        case OP_L16UI:
+          ef->a_reg[site->regno] = (mem_val >> pos) & 0xffffu;
+          break;
+        case OP_L16SI:
+          ef->a_reg[site->regno] = (int32_t)(int16_t)(mem_val >> pos);  /* sign-extend */
+          break;
+        default: /* is write */
+          valmask = ((site->op == OP_S8I) ? 0xffu : 0xffffu) << pos;
+          /* mask out field, and merge the value to store from register */
+          mem_val &= ~valmask;
+          mem_val |= (ef->a_reg[site->regno] << pos) & valmask;
+          *pWord = mem_val; /* carry out the store */
+          break;
       }
     }
 
@@ -196,6 +226,38 @@ void install_non32xfer_exception_handler(void) __attribute__((weak));
 void install_non32xfer_exception_handler(void) {}
 #endif
 
+uint32_t non32xfer_count(void) {
+  return non32xfer_total;
+}
+
+size_t non32xfer_hot_sites(non32xfer_site_t *sites, size_t max) {
+  size_t n = 0;
+  for (const auto& decoded : non32xfer_sites) {
+    if (!decoded.epc || !decoded.count) {
+      continue;
+    }
+    // Insert in decreasing count order, dropping the least busy beyond max
+    size_t i = (n < max) ? n++ : max;
+    for (; i > 0 && sites[i - 1].count < decoded.count; i--) {
+      if (i < max) {
+        sites[i] = sites[i - 1];
+      }
+    }
+    if (i < max) {
+      sites[i].pc = decoded.epc;
+      sites[i].count = decoded.count;
+    }
+  }
+  return n;
+}
+
+void non32xfer_reset_stats(void) {
+  uint32_t saved = xt_rsil(15);
+  memset(non32xfer_sites, 0, sizeof(non32xfer_sites));
+  non32xfer_total = 0;
+  xt_wsr_ps(saved);
+}
+
 #if defined(NON32XFER_HANDLER)
 // For SDKs 3.0.x, we made load_non_32_wide_handler in
 // libmain.c:user_exceptions.o a weak symbol allowing this override to work.
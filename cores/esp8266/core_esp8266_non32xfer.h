@@ -1,12 +1,33 @@
 #ifndef __CORE_ESP8266_NON32XFER_H
 #define __CORE_ESP8266_NON32XFER_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 extern void install_non32xfer_exception_handler();
 
+// Statistics of the byte and halfword accesses to IRAM and flash emulated
+// by the exception handler above, to find the code that would better use
+// 32-bit accesses or the xxx_P functions.  The call sites are tracked in a
+// small table, a site trapping rarely may be replaced by another one.
+typedef struct {
+  uint32_t pc;    // Address of the trapping load or store instruction
+  uint32_t count; // Times it trapped
+} non32xfer_site_t;
+
+// Accesses emulated since boot or non32xfer_reset_stats()
+extern uint32_t non32xfer_count(void);
+
+// Fill sites with the up to max call sites trapping most, busiest first,
+// and return how many were filled.  Find their code with addr2line.
+extern size_t non32xfer_hot_sites(non32xfer_site_t *sites, size_t max);
+
+extern void non32xfer_reset_stats(void);
+
 
     /*
        In adapting the public domain version, a crash would come or go away with
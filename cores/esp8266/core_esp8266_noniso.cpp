@@ -33,11 +33,66 @@
 extern "C" {
 
 char* ltoa(long value, char* result, int base) {
-    return itoa((int)value, result, base);
+    if (base == 10 && value < 0) {
+        *result = '-';
+        ultoa(-(unsigned long)value, result + 1, 10);
+        return result;
+    }
+    return ultoa(value, result, base);
 }
 
 char* ultoa(unsigned long value, char* result, int base) {
-    return utoa((unsigned int)value, result, base);
+    if (base != 10) {
+        return utoa((unsigned int)value, result, base);
+    }
+    char digits[10];
+    char* first = utoa_dec((unsigned int)value, digits + sizeof(digits));
+    size_t len = digits + sizeof(digits) - first;
+    memcpy(result, first, len);
+    result[len] = 0;
+    return result;
+}
+
+// dtostrf() when number * 10^prec fits 64 bits: one scaling and one
+// conversion to an integer, formatted by ulltoa_dec(), instead of a
+// floating point multiply, conversion and subtraction per digit
+static char* dtostrf_scaled(double number, bool negative, signed char width, unsigned char prec, char* s) {
+    uint64_t scale = 1;
+    for (uint8_t i = 0; i < prec; ++i) {
+        scale *= 10;
+    }
+    double scaled = number * (double)scale;
+    if (!(scaled < 1e19)) {
+        return nullptr;
+    }
+    // rounded as below (#7087)
+    uint64_t mantissa = (scaled + 0.5) * (1 + std::numeric_limits<double>::epsilon());
+
+    char digits[20];
+    char* end = digits + sizeof(digits);
+    char* first = ulltoa_dec(mantissa, end);
+    while (end - first < prec + 1) {
+        *--first = '0';
+    }
+    int intDigits = end - first - prec;
+
+    char* out = s;
+    int fillme = width - intDigits - (prec ? prec + 1 : 0) - negative;
+    while (fillme-- > 0) {
+        *out++ = ' ';
+    }
+    if (negative) {
+        *out++ = '-';
+    }
+    memcpy(out, first, intDigits);
+    out += intDigits;
+    if (prec) {
+        *out++ = '.';
+        memcpy(out, first + intDigits, prec);
+        out += prec;
+    }
+    *out = 0;
+    return s;
 }
 
 char * dtostrf(double number, signed char width, unsigned char prec, char *s) {
@@ -52,6 +107,10 @@ char * dtostrf(double number, signed char width, unsigned char prec, char *s) {
         return s;
     }
 
+    if (prec <= 18 && dtostrf_scaled(fabs(number), number < 0.0, width, prec, s)) {
+        return s;
+    }
+
     char* out = s;
 
     int fillme = width; // how many cells to fill for the integer part
@@ -27,6 +27,8 @@
 #include "ets_sys.h"
 #include "spi_flash.h"
 #include "user_interface.h"
+#include "coredecls.h"
+#include "esp8266_peri.h"
 
 extern "C" {
 
@@ -296,12 +298,82 @@ static const uint8_t ICACHE_FLASH_ATTR phy_init_data[128] =
 #define __get_adc_mode _Z14__get_adc_modev
 #define __get_rf_mode _Z13__get_rf_modev
 #define __run_user_rf_pre_init _Z22__run_user_rf_pre_initv
+#define __get_rf_cal_cache _Z18__get_rf_cal_cachev
 
 static bool spoof_init_data = false;
 
 extern int __real_spi_flash_read(uint32_t addr, uint32_t* dst, size_t size);
 extern int IRAM_ATTR __wrap_spi_flash_read(uint32_t addr, uint32_t* dst, size_t size);
 extern int __get_adc_mode();
+extern uint32_t __get_rf_cal_cache();
+
+/*
+  RF calibration cache, see RF_CAL_CACHE().  The full calibration the SDK
+  does at power up, about 200ms, saves its results in the RF_CAL sector.
+  At other boots, byte 114 of the init data is set to 0 so that they are
+  used as they are, unless the full calibration is due again.
+
+  Its state is in the last two RTC user memory blocks: kept over resets and
+  deep sleep, and found invalid after power up, the second block being the
+  complement of the first.
+    bits 31..20  magic
+    bits 19..12  boots since the last full calibration
+    bits 11..0   VDD33 measured after it (1/1024V), 0 until measured
+ */
+#define RF_CAL_MAGIC     0xca1u
+#define RF_CAL_STATE     (RTC_USER_MEM + RTC_USER_BLOCK_RF_CAL)
+#define RF_CAL_FULL      3
+#define RF_CAL_NONE      0
+
+static bool rf_cal_state_valid(uint32_t state)
+{
+    return (state >> 20) == RF_CAL_MAGIC && RF_CAL_STATE[1] == ~state;
+}
+
+static void rf_cal_state_write(uint32_t state)
+{
+    RF_CAL_STATE[0] = state;
+    RF_CAL_STATE[1] = ~state;
+}
+
+// byte 114 of the init data, for this boot
+static uint8_t rf_cal_powerup_mode(uint8_t mode)
+{
+    uint32_t boots = __get_rf_cal_cache() & 0xff;
+    if (!boots) {
+        return mode;
+    }
+    uint32_t state = RF_CAL_STATE[0];
+    if (!rf_cal_state_valid(state) || ((state >> 12) & 0xff) + 1 >= boots) {
+        rf_cal_state_write(RF_CAL_MAGIC << 20);
+        return RF_CAL_FULL;
+    }
+    rf_cal_state_write(state + (1 << 12));
+    return RF_CAL_NONE;
+}
+
+void rf_cal_cache_check(void)
+{
+    uint32_t cache = __get_rf_cal_cache();
+    uint32_t drift = cache >> 16;
+    uint32_t state = RF_CAL_STATE[0];
+    if (!(cache & 0xff) || !drift || __get_adc_mode() != 255 || !rf_cal_state_valid(state)) {
+        return;
+    }
+
+    uint32_t vdd = system_get_vdd33() & 0xfff;
+    uint32_t calibrated = state & 0xfff;
+    if (!calibrated) {
+        rf_cal_state_write(state | vdd);
+    } else if ((vdd > calibrated ? vdd - calibrated : calibrated - vdd) * 1000 / 1024 > drift) {
+        rf_cal_cache_invalidate();
+    }
+}
+
+void rf_cal_cache_invalidate(void)
+{
+    rf_cal_state_write(0);
+}
 
 /*
   Verified that the wide filtering of all 128 byte flash reads during
@@ -322,6 +394,7 @@ extern int IRAM_ATTR __wrap_spi_flash_read(uint32_t addr, uint32_t* dst, size_t
 
     memcpy(dst, phy_init_data, sizeof(phy_init_data));
     ((uint8_t*)dst)[107] = __get_adc_mode();
+    ((uint8_t*)dst)[114] = rf_cal_powerup_mode(((uint8_t*)dst)[114]);
     return 0;
 }
 
@@ -337,6 +410,12 @@ extern int __get_adc_mode(void)
     return 33; // default ADC mode
 }
 
+extern uint32_t __get_rf_cal_cache(void) __attribute__((weak));
+extern uint32_t __get_rf_cal_cache(void)
+{
+    return 0; // cache not used
+}
+
 extern void __run_user_rf_pre_init(void) __attribute__((weak));
 extern void __run_user_rf_pre_init(void)
 {
@@ -346,11 +425,13 @@ extern void __run_user_rf_pre_init(void)
 #if (NONOSDK >= (0x30000))
 void sdk3_begin_phy_data_spoof(void)
 {
+   boot_timeline_mark(BOOT_STAGE_PHY_INIT);
    spoof_init_data = true;
 }
 #else
 uint32_t user_rf_cal_sector_set(void)
 {
+    boot_timeline_mark(BOOT_STAGE_PHY_INIT);
     spoof_init_data = true;
     return flashchip->chip_size/SPI_FLASH_SEC_SIZE - 4;
 }
@@ -359,6 +440,7 @@ uint32_t user_rf_cal_sector_set(void)
 void user_rf_pre_init()
 {
     // *((volatile uint32_t*) 0x60000710) = 0;
+    boot_timeline_mark(BOOT_STAGE_RF_PRE_INIT);
     spoof_init_data = false;
 
     int rf_mode = __get_rf_mode();
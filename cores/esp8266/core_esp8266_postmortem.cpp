@@ -33,6 +33,10 @@
 #include "gdb_hooks.h"
 #include "StackThunk.h"
 #include "coredecls.h"
+#include "CrashDump.h"
+#if defined(UMM_HEAP_TRACE)
+#include "umm_malloc/umm_malloc.h"
+#endif
 
 extern "C" {
 
@@ -74,6 +78,11 @@ extern int umm_last_fail_alloc_line;
 
 static void raise_exception() __attribute__((noreturn));
 
+// Linked with the sketches using PROFILE_SCOPE()
+extern void profiler_print(void (*putc)(char)) __attribute__((weak));
+// Linked with the sketches using CrashDump
+extern bool crashdump_write(const crashdump_context_t* context) __attribute__((weak));
+
 extern void __custom_crash_callback( struct rst_info * rst_info, uint32_t stack, uint32_t stack_end ) {
     (void) rst_info;
     (void) stack;
@@ -147,6 +156,17 @@ static void postmortem_report(uint32_t sp_dump) {
 
     ets_install_putc1(&uart_write_char_d);
 
+    // The GCC divide routine in ROM jumps to the address below and executes ILL (00 00 00) on div-by-zero
+    // In that case, print the exception as (6) which is IntegerDivZero
+    uint32_t epc1 = rst_info.epc1;
+    uint32_t exccause = rst_info.exccause;
+    if (rst_info.reason == REASON_EXCEPTION_RST && exccause == 0 && epc1 == 0x4000dce5u) {
+        exccause = 6;
+        // In place of the detached 'ILL' instruction., redirect attention
+        // back to the code that called the ROM divide function.
+        __asm__ __volatile__("rsr.excsave1 %0\n\t" : "=r"(epc1) :: "memory");
+    }
+
     cut_here();
 
     if (s_panic_line) {
@@ -166,17 +186,6 @@ static void postmortem_report(uint32_t sp_dump) {
         ets_printf_P(PSTR("\nAbort called\n"));
     }
     else if (rst_info.reason == REASON_EXCEPTION_RST) {
-        // The GCC divide routine in ROM jumps to the address below and executes ILL (00 00 00) on div-by-zero
-        // In that case, print the exception as (6) which is IntegerDivZero
-        uint32_t epc1 = rst_info.epc1;
-        uint32_t exccause = rst_info.exccause;
-        bool div_zero = (exccause == 0) && (epc1 == 0x4000dce5u);
-        if (div_zero) {
-            exccause = 6;
-            // In place of the detached 'ILL' instruction., redirect attention
-            // back to the code that called the ROM divide function.
-            __asm__ __volatile__("rsr.excsave1 %0\n\t" : "=r"(epc1) :: "memory");
-        }
         ets_printf_P(PSTR("\nException (%d):\nepc1=0x%08x epc2=0x%08x epc3=0x%08x excvaddr=0x%08x depc=0x%08x\n"),
             exccause, epc1, rst_info.epc2, rst_info.epc3, rst_info.excvaddr, rst_info.depc);
     }
@@ -227,32 +236,67 @@ static void postmortem_report(uint32_t sp_dump) {
         offset = 16;
     }
 
-    ets_printf_P(PSTR("\n>>>stack>>>\n"));
+    bool in_bearssl = sp_dump > stack_thunk_get_stack_bot() && sp_dump <= stack_thunk_get_stack_top();
+    bool in_cont = sp_dump > cont_stack_start && sp_dump < cont_stack_end;
+
+    // When written to flash, the stack isn't printed (unless asked for)
+    bool dumped = false;
+    if (crashdump_write) {
+        struct rst_info printed = rst_info;
+        printed.exccause = exccause;
+        printed.epc1 = epc1;
+        if (rst_info.reason == REASON_SOFT_WDT_RST) {
+            printed.epc2 = printed.epc3 = printed.excvaddr = printed.depc = 0;
+        }
+        else if (rst_info.reason == REASON_USER_STACK_SMASH) {
+            printed.exccause = 5;
+            printed.epc1 = s_stacksmash_addr;
+            printed.epc2 = printed.epc3 = printed.excvaddr = printed.depc = 0;
+        }
+        crashdump_context_t context = {
+            &printed, sp_dump, offset,
+            in_bearssl ? stack_thunk_get_stack_top() : in_cont ? cont_stack_end : 0x3fffffb0,
+            in_bearssl ? CRASHDUMP_CTX_BEARSSL : in_cont ? CRASHDUMP_CTX_CONT : CRASHDUMP_CTX_SYS,
+            s_panic_file, s_panic_line, s_panic_func, s_panic_what,
+            s_unhandled_exception, s_abort_called,
+            umm_last_fail_alloc_addr, umm_last_fail_alloc_size,
+        };
+        dumped = crashdump_write(&context);
+    }
+
+    if (dumped) {
+        ets_printf_P(PSTR("\nstack in the crash dump\n"));
+    }
+    else {
+        ets_printf_P(PSTR("\n>>>stack>>>\n"));
+    }
 
-    if (sp_dump > stack_thunk_get_stack_bot() && sp_dump <= stack_thunk_get_stack_top()) {
+    if (in_bearssl) {
         // BearSSL we dump the BSSL second stack and then reset SP back to the main cont stack
-        ets_printf_P(PSTR("\nctx: bearssl\nsp: %08x end: %08x offset: %04x\n"), sp_dump, stack_thunk_get_stack_top(), offset);
-        print_stack(sp_dump + offset, stack_thunk_get_stack_top());
+        if (!dumped) {
+            ets_printf_P(PSTR("\nctx: bearssl\nsp: %08x end: %08x offset: %04x\n"), sp_dump, stack_thunk_get_stack_top(), offset);
+            print_stack(sp_dump + offset, stack_thunk_get_stack_top());
+        }
         offset = 0; // No offset needed anymore, the exception info was stored in the bssl stack
         sp_dump = stack_thunk_get_cont_sp();
+        in_cont = sp_dump > cont_stack_start && sp_dump < cont_stack_end;
     }
 
-    if (sp_dump > cont_stack_start && sp_dump < cont_stack_end) {
-        ets_printf_P(PSTR("\nctx: cont\n"));
+    if (in_cont) {
         stack_end = cont_stack_end;
     }
     else {
-        ets_printf_P(PSTR("\nctx: sys\n"));
         stack_end = 0x3fffffb0;
         // it's actually 0x3ffffff0, but the stuff below ets_run
         // is likely not really relevant to the crash
     }
 
-    ets_printf_P(PSTR("sp: %08x end: %08x offset: %04x\n"), sp_dump, stack_end, offset);
-
-    print_stack(sp_dump + offset, stack_end);
-
-    ets_printf_P(PSTR("<<<stack<<<\n"));
+    if (!dumped) {
+        ets_printf_P(in_cont ? PSTR("\nctx: cont\n") : PSTR("\nctx: sys\n"));
+        ets_printf_P(PSTR("sp: %08x end: %08x offset: %04x\n"), sp_dump, stack_end, offset);
+        print_stack(sp_dump + offset, stack_end);
+        ets_printf_P(PSTR("<<<stack<<<\n"));
+    }
 
     // Use cap-X formatting to ensure the standard EspExceptionDecoder doesn't match the address
     if (umm_last_fail_alloc_addr) {
@@ -265,6 +309,18 @@ static void postmortem_report(uint32_t sp_dump) {
 #endif
     }
 
+#if defined(UMM_HEAP_TRACE)
+    ets_printf_P(PSTR("\n>>>heap trace>>>\n"));
+    umm_heap_trace_print(uart_write_char_d);
+    ets_printf_P(PSTR("<<<heap trace<<<\n"));
+#endif
+
+    if (profiler_print && !dumped) {
+        ets_printf_P(PSTR("\n>>>profiler>>>\n"));
+        profiler_print(uart_write_char_d);
+        ets_printf_P(PSTR("<<<profiler<<<\n"));
+    }
+
     cut_here();
 
     if (s_unhandled_exception && umm_last_fail_alloc_addr) {
@@ -0,0 +1,153 @@
+/*
+ core_esp8266_profiler.cpp - cycle counting profiler of code regions
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <Arduino.h>
+#include <core_esp8266_profiler.h>
+
+typedef struct {
+    profiler_region_t* region;
+    uint32_t start_ccy;
+    uint32_t cycles;          // running while UINT32_MAX
+} profiler_trace_t;
+
+// Ends the list of regions, to tell the regions not linked yet by their
+// null next
+static profiler_region_t profiler_tail;
+static profiler_region_t* profiler_regions = &profiler_tail;
+
+static profiler_trace_t profiler_trace[PROFILER_TRACE_ENTRIES];
+static uint32_t profiler_trace_next = 0;
+static uint32_t profiler_trace_count = 0;
+
+uint32_t IRAM_ATTR profiler_enter(profiler_region_t* region)
+{
+    uint32_t saved_ps = xt_rsil(15);
+    if (!region->next) {
+        region->next = profiler_regions;
+        profiler_regions = region;
+    }
+    uint32_t slot = profiler_trace_next;
+    profiler_trace_t* entry = &profiler_trace[slot];
+    entry->region = region;
+    entry->start_ccy = esp_get_cycle_count();
+    entry->cycles = UINT32_MAX;
+    if (++profiler_trace_next >= PROFILER_TRACE_ENTRIES) {
+        profiler_trace_next = 0;
+    }
+    if (profiler_trace_count < PROFILER_TRACE_ENTRIES) {
+        ++profiler_trace_count;
+    }
+    xt_wsr_ps(saved_ps);
+    return slot;
+}
+
+void IRAM_ATTR profiler_exit(profiler_region_t* region, uint32_t slot, uint32_t start_ccy)
+{
+    uint32_t cycles = esp_get_cycle_count() - start_ccy;
+    // bucket n counts up to 64 << 2n cycles, the last one the longer ones
+    uint32_t bucket = 0;
+    for (uint32_t limit = 64; cycles >= limit && bucket < PROFILER_BUCKETS - 1; limit <<= 2) {
+        bucket++;
+    }
+    uint32_t saved_ps = xt_rsil(15);
+    region->count++;
+    region->total_cycles += cycles;
+    if (cycles > region->max_cycles) {
+        region->max_cycles = cycles;
+    }
+    region->buckets[bucket]++;
+    // unless overwritten meanwhile by the regions entered since
+    profiler_trace_t* entry = &profiler_trace[slot];
+    if (entry->region == region && entry->cycles == UINT32_MAX) {
+        entry->cycles = cycles;
+    }
+    xt_wsr_ps(saved_ps);
+}
+
+void profiler_reset(void)
+{
+    uint32_t saved_ps = xt_rsil(15);
+    for (profiler_region_t* region = profiler_regions; region != &profiler_tail; region = region->next) {
+        region->count = 0;
+        region->max_cycles = 0;
+        region->total_cycles = 0;
+        memset(region->buckets, 0, sizeof(region->buckets));
+    }
+    profiler_trace_next = 0;
+    profiler_trace_count = 0;
+    xt_wsr_ps(saved_ps);
+}
+
+// Also called from the postmortem report: no allocation, and the trace is
+// read in place
+static void profiler_lines(void (*emit)(const char* line, void* arg), void* arg)
+{
+    char line[96];
+    uint32_t mhz = esp_get_cpu_freq_mhz();
+    snprintf_P(line, sizeof(line), PSTR("region calls avg_us max_us | buckets <64 <256 <1k ... cycles\n"));
+    emit(line, arg);
+    for (profiler_region_t* region = profiler_regions; region != &profiler_tail; region = region->next) {
+        uint32_t avg = region->count ? (uint32_t)(region->total_cycles / region->count) : 0;
+        int len = snprintf_P(line, sizeof(line), PSTR("%S %u %u %u |"), region->name, region->count,
+            avg / mhz, region->max_cycles / mhz);
+        for (size_t i = 0; i < PROFILER_BUCKETS && len > 0 && (size_t)len < sizeof(line); i++) {
+            len += snprintf_P(line + len, sizeof(line) - len, PSTR(" %u"), region->buckets[i]);
+        }
+        if (len > 0 && (size_t)len < sizeof(line) - 1) {
+            line[len++] = '\n';
+            line[len] = 0;
+        }
+        emit(line, arg);
+    }
+
+    snprintf_P(line, sizeof(line), PSTR("trace, oldest first: start_ccy region us\n"));
+    emit(line, arg);
+    uint32_t count = profiler_trace_count;
+    uint32_t index = (profiler_trace_next + PROFILER_TRACE_ENTRIES - count) % PROFILER_TRACE_ENTRIES;
+    for (uint32_t i = 0; i < count; i++) {
+        const profiler_trace_t* entry = &profiler_trace[index];
+        if (entry->cycles == UINT32_MAX) {
+            snprintf_P(line, sizeof(line), PSTR("%08x %S running\n"), entry->start_ccy, entry->region->name);
+        } else {
+            snprintf_P(line, sizeof(line), PSTR("%08x %S %u\n"), entry->start_ccy, entry->region->name, entry->cycles / mhz);
+        }
+        emit(line, arg);
+        if (++index >= PROFILER_TRACE_ENTRIES) {
+            index = 0;
+        }
+    }
+}
+
+void profiler_print(void (*putc)(char))
+{
+    profiler_lines([](const char* line, void* arg) {
+        for (const char* c = line; *c; c++) {
+            ((void (*)(char))arg)(*c);
+        }
+    }, (void*)putc);
+}
+
+void profiler_print(Print& out)
+{
+    profiler_lines([](const char* line, void* arg) {
+        ((Print*)arg)->print(line);
+    }, &out);
+}
@@ -0,0 +1,122 @@
+/*
+ core_esp8266_profiler.h - cycle counting profiler of code regions
+
+ Copyright (c) 2020 esp8266/Arduino
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __CORE_ESP8266_PROFILER_H
+#define __CORE_ESP8266_PROFILER_H
+
+/*
+  Built with -DCORE_PROFILER, PROFILE_SCOPE("name") measures the CPU cycles
+  spent from there to the end of the enclosing block:
+
+  void IRAM_ATTR onPulse() {
+      PROFILE_SCOPE("onPulse");
+      ...
+  }
+
+  Each region counts its calls and their durations in a histogram of
+  PROFILER_BUCKETS buckets, each 4 times wider than the previous one (64,
+  256, 1024... cycles).  The last PROFILER_TRACE_ENTRIES regions entered are
+  kept in a ring, a region still running reads "running": after a WDT reset
+  or a crash, the postmortem report prints them with the regions between
+  >>>profiler>>> and <<<profiler<<<, when the sketch uses the profiler.
+  profiler_print() prints the same at any time.
+
+  Markers are IRAM safe and may be used in ISRs, each costs a few hundred
+  cycles.  Without CORE_PROFILER they compile to nothing.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <core_esp8266_features.h>
+
+#ifndef PROFILER_BUCKETS
+#define PROFILER_BUCKETS 8
+#endif
+
+#ifndef PROFILER_TRACE_ENTRIES
+#define PROFILER_TRACE_ENTRIES 32
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One per PROFILE_SCOPE(), statically initialized and linked in the list
+// of regions on first entry
+typedef struct profiler_region {
+    const char* name;               // PROGMEM
+    struct profiler_region* next;
+    uint32_t count;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+    uint32_t buckets[PROFILER_BUCKETS];
+} profiler_region_t;
+
+uint32_t profiler_enter(profiler_region_t* region);
+void profiler_exit(profiler_region_t* region, uint32_t slot, uint32_t start_ccy);
+
+// Print the regions and the trace, e.g. profiler_print(ets_putc)
+void profiler_print(void (*putc)(char));
+// Clear the counts and the trace
+void profiler_reset(void);
+
+#ifdef __cplusplus
+}
+
+class Print;
+// profiler_print() to Serial or any stream
+void profiler_print(Print& out);
+
+class ProfilerScope
+{
+public:
+    inline __attribute__((always_inline)) ProfilerScope(profiler_region_t* region)
+        : _region(region), _slot(profiler_enter(region)), _start(esp_get_cycle_count())
+    {
+    }
+
+    inline __attribute__((always_inline)) ~ProfilerScope()
+    {
+        profiler_exit(_region, _slot, _start);
+    }
+
+protected:
+    profiler_region_t* _region;
+    uint32_t _slot;
+    uint32_t _start;
+};
+
+#define __PROFILE_CONCAT2(a, b) a##b
+#define __PROFILE_CONCAT(a, b) __PROFILE_CONCAT2(a, b)
+
+#ifdef CORE_PROFILER
+#define PROFILE_SCOPE(name)                                                          \
+    static const char __PROFILE_CONCAT(__profile_name_, __LINE__)[] PROGMEM = name;  \
+    static profiler_region_t __PROFILE_CONCAT(__profile_region_, __LINE__) =         \
+        { __PROFILE_CONCAT(__profile_name_, __LINE__), nullptr, 0, 0, 0, { 0 } };    \
+    ProfilerScope __PROFILE_CONCAT(__profile_scope_, __LINE__)(&__PROFILE_CONCAT(__profile_region_, __LINE__))
+#else
+#define PROFILE_SCOPE(name) do { } while (0)
+#endif
+
+#endif // __cplusplus
+
+#endif // __CORE_ESP8266_PROFILER_H
@@ -23,6 +23,8 @@
 #include "pins_arduino.h"
 #include "wiring_private.h"
 #include "PolledTimeout.h"
+#include "Schedule.h"
+#include "core_esp8266_waveform.h"
 
 extern "C"
 {
@@ -172,22 +174,68 @@ private:
     // Generate a clock "valley" (at the end of a segment, just before a repeated start)
     void twi_scl_valley(void);
 
+    // Asynchronous master, one bus step per timer1 callback (see twi_queue())
+    enum AsyncStep
+    {
+        ASYNC_IDLE = 0,
+        ASYNC_START,
+        ASYNC_START_SDA,
+        ASYNC_START_SCL,
+        ASYNC_BIT_LOW,
+        ASYNC_BIT_HIGH,
+        ASYNC_STOP,
+        ASYNC_STOP_SCL,
+        ASYNC_STOP_SDA,
+        ASYNC_VALLEY,
+        ASYNC_SCL_HIGH,
+        ASYNC_SCL_WAIT,
+        ASYNC_DONE
+    };
+    volatile AsyncStep async_step    = ASYNC_IDLE;
+    AsyncStep          async_after   = ASYNC_IDLE;  // step following ASYNC_SCL_HIGH
+    twi_transaction_t* async_queue   = nullptr;
+    size_t             async_count   = 0;
+    size_t             async_index   = 0;
+    unsigned int       async_pos     = 0;
+    unsigned int       async_bit     = 0;  // 0..7: data, 8: ack
+    bool               async_address = false;
+    uint8_t            async_data    = 0;
+    uint32_t           async_half    = 0;  // half clock period, in cpu cycles
+    uint32_t           async_next    = 0;  // cycle count of the next step
+    uint32_t           async_stretch = 0;  // cycle count when SCL was released
+    void (*async_done)(void*)        = nullptr;
+    void* async_arg                  = nullptr;
+
+    static uint32_t IRAM_ATTR onAsyncTimer();
+    static bool               asyncComplete();
+    uint32_t IRAM_ATTR        asyncStep();
+    uint32_t IRAM_ATTR        asyncEnd(uint8_t status);
+    uint32_t IRAM_ATTR        asyncNext();
+    void                      asyncWait();
+
 public:
     void           setClock(unsigned int freq);
     void           setClockStretchLimit(uint32_t limit);
     void           init(unsigned char sda, unsigned char scl);
     void           setAddress(uint8_t address);
     unsigned char  writeTo(unsigned char address, unsigned char* buf, unsigned int len,
-                           unsigned char sendStop);
+                           unsigned char sendStop, int reg = -1);
     unsigned char  readFrom(unsigned char address, unsigned char* buf, unsigned int len,
                             unsigned char sendStop);
     uint8_t        status();
+    void           stop();
     uint8_t        transmit(const uint8_t* data, uint8_t length);
     void           attachSlaveRxEvent(void (*function)(uint8_t*, size_t));
     void           attachSlaveTxEvent(void (*function)(void));
     void IRAM_ATTR reply(uint8_t ack);
     void IRAM_ATTR releaseBus(void);
     void           enableSlave();
+    bool           queue(twi_transaction_t* transactions, size_t count, void (*done)(void*),
+                         void* arg);
+    bool           queueBusy() const
+    {
+        return async_step != ASYNC_IDLE;
+    }
 };
 
 static Twi twi;
@@ -361,10 +409,12 @@ unsigned char Twi::read_byte(bool nack)
     return byte;
 }
 
+// reg >= 0 is sent before buf (register address of a write)
 unsigned char Twi::writeTo(unsigned char address, unsigned char* buf, unsigned int len,
-                           unsigned char sendStop)
+                           unsigned char sendStop, int reg)
 {
     unsigned int i;
+    asyncWait();
     if (!write_start())
     {
         return 4;  // line busy
@@ -377,6 +427,14 @@ unsigned char Twi::writeTo(unsigned char address, unsigned char* buf, unsigned i
         }
         return 2;  // received NACK on transmit of address
     }
+    if (reg >= 0 && !write_byte(reg))
+    {
+        if (sendStop)
+        {
+            write_stop();
+        }
+        return 3;  // received NACK on transmit of data
+    }
     for (i = 0; i < len; i++)
     {
         if (!write_byte(buf[i]))
@@ -411,6 +469,7 @@ unsigned char Twi::readFrom(unsigned char address, unsigned char* buf, unsigned
                             unsigned char sendStop)
 {
     unsigned int i;
+    asyncWait();
     if (!write_start())
     {
         return 4;  // line busy
@@ -457,6 +516,7 @@ void Twi::twi_scl_valley(void)
 
 uint8_t Twi::status()
 {
+    asyncWait();
     WAIT_CLOCK_STRETCH();  // wait for a slow slave to finish
     if (!SCL_READ(twi_scl))
     {
@@ -484,6 +544,12 @@ uint8_t Twi::status()
     return I2C_OK;
 }
 
+void Twi::stop()
+{
+    asyncWait();
+    write_stop();
+}
+
 uint8_t Twi::transmit(const uint8_t* data, uint8_t length)
 {
     uint8_t i;
@@ -1004,6 +1070,284 @@ void IRAM_ATTR Twi::onSdaChange(void)
     }
 }
 
+// The NMI only moves the bus lines, the loop side (a recurrent scheduled function)
+// releases timer1 and calls the user once the queue completed.
+bool Twi::queue(twi_transaction_t* transactions, size_t count, void (*done)(void*), void* arg)
+{
+    if (queueBusy() || !transactions || !count)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        if (transactions[i].read && !transactions[i].len)
+        {
+            return false;
+        }
+    }
+    unsigned int freq = preferred_si2c_clock;
+    if (freq > TWI_ASYNC_MAX_CLOCK)
+    {
+        freq = TWI_ASYNC_MAX_CLOCK;
+    }
+    // two SCL edges per bit
+    if (!setTimer1CallbackLoad(2 * freq))
+    {
+        return false;
+    }
+    if (!schedule_recurrent_function_us([]() { return !asyncComplete(); }, 0))
+    {
+        setTimer1CallbackLoad(0);
+        return false;
+    }
+    async_half         = (esp_get_cpu_freq_mhz() * 1000000UL) / (2 * freq);
+    async_queue        = transactions;
+    async_count        = count;
+    async_index        = 0;
+    async_done         = done;
+    async_arg          = arg;
+    async_queue[0].status = 0;
+    async_next         = esp_get_cycle_count();
+    async_step         = ASYNC_START;
+    setTimer1Callback(onAsyncTimer);
+    return true;
+}
+
+void Twi::asyncWait()
+{
+    while (queueBusy())
+    {
+        optimistic_yield(1000);
+    }
+}
+
+bool Twi::asyncComplete()
+{
+    if (twi.async_step != ASYNC_DONE)
+    {
+        return false;
+    }
+
+    setTimer1Callback(nullptr);
+    void (*done)(void*) = twi.async_done;
+    twi.async_queue     = nullptr;
+    twi.async_step      = ASYNC_IDLE;
+    if (done)
+    {
+        done(twi.async_arg);  // may queue the next transactions
+    }
+    return true;
+}
+
+uint32_t IRAM_ATTR Twi::onAsyncTimer()
+{
+    uint32_t now  = esp_get_cycle_count();
+    int32_t  left = twi.async_next - now;
+    if (left > 0)
+    {
+        return left;  // called for another timer1 user
+    }
+    if (twi.async_step == ASYNC_DONE || twi.async_step == ASYNC_IDLE)
+    {
+        return esp_get_cpu_freq_mhz() * 1000;  // until asyncComplete() releases timer1
+    }
+
+    uint32_t wait   = twi.asyncStep();
+    twi.async_next = now + wait;
+    return wait;
+}
+
+// end of the current transaction
+uint32_t IRAM_ATTR Twi::asyncEnd(uint8_t status)
+{
+    twi_transaction_t& t = async_queue[async_index];
+    t.status             = status;
+    if (status == 4)
+    {
+        return asyncNext();  // line busy
+    }
+    async_step = t.sendStop ? ASYNC_STOP : ASYNC_VALLEY;
+    return async_half;
+}
+
+// start of the next transaction
+uint32_t IRAM_ATTR Twi::asyncNext()
+{
+    if (++async_index < async_count)
+    {
+        async_queue[async_index].status = 0;
+        async_step                      = ASYNC_START;
+        return async_half;
+    }
+    async_step = ASYNC_DONE;
+    return async_half;
+}
+
+// One step of the bus, the same sequences as writeTo() and readFrom(), and
+// the cycles to wait before the next step.
+uint32_t IRAM_ATTR Twi::asyncStep()
+{
+    twi_transaction_t& t = async_queue[async_index];
+    for (;;)
+    {
+        switch (async_step)
+        {
+        case ASYNC_START:
+            SCL_HIGH(twi_scl);
+            SDA_HIGH(twi_sda);
+            if (!SDA_READ(twi_sda))
+            {
+                return asyncEnd(4);  // line busy
+            }
+            async_step = ASYNC_START_SDA;
+            return async_half;
+
+        case ASYNC_START_SDA:
+            // A high-to-low transition on the SDA line while the SCL is high defines a START
+            // condition.
+            SDA_LOW(twi_sda);
+            async_step = ASYNC_START_SCL;
+            return async_half;
+
+        case ASYNC_START_SCL:
+            SCL_LOW(twi_scl);
+            async_address = true;
+            async_data    = ((t.address << 1) | (t.read ? 1 : 0)) & 0xFF;
+            async_pos     = 0;
+            async_bit     = 0;
+            async_step    = ASYNC_BIT_LOW;
+            return async_half;
+
+        case ASYNC_BIT_LOW:
+        {
+            bool writing = async_address || !t.read;
+            bool bit;
+            if (async_bit < 8)
+            {
+                bit = !writing || (async_data & (0x80 >> async_bit));
+            }
+            else
+            {
+                bit = writing || async_pos == t.len - 1U;  // release for ACK, or NACK the last
+            }
+            SCL_LOW(twi_scl);
+            if (bit)
+            {
+                SDA_HIGH(twi_sda);
+            }
+            else
+            {
+                SDA_LOW(twi_sda);
+            }
+            async_step  = ASYNC_SCL_HIGH;
+            async_after = ASYNC_BIT_HIGH;
+            return async_half;
+        }
+
+        case ASYNC_BIT_HIGH:
+        {
+            // SCL is high (or stretched beyond the limit)
+            bool writing = async_address || !t.read;
+            bool bit     = SDA_READ(twi_sda);
+            async_step   = ASYNC_BIT_LOW;
+            if (async_bit < 8)
+            {
+                if (!writing)
+                {
+                    async_data = (async_data << 1) | bit;
+                    if (async_bit == 7)
+                    {
+                        t.buf[async_pos] = async_data;
+                    }
+                }
+                async_bit++;
+                return async_half;
+            }
+
+            async_bit = 0;
+            if (async_address)
+            {
+                if (bit)
+                {
+                    return asyncEnd(2);  // received NACK on transmit of address
+                }
+                async_address = false;
+            }
+            else if (!t.read)
+            {
+                if (bit)
+                {
+                    return asyncEnd(3);  // received NACK on transmit of data
+                }
+                async_pos++;
+            }
+            else
+            {
+                async_pos++;
+            }
+
+            if (async_pos >= t.len)
+            {
+                return asyncEnd(0);
+            }
+            async_data = t.read ? 0 : t.buf[async_pos];
+            return async_half;
+        }
+
+        case ASYNC_STOP:
+            SCL_LOW(twi_scl);
+            SDA_LOW(twi_sda);
+            async_step = ASYNC_STOP_SCL;
+            return async_half;
+
+        case ASYNC_STOP_SCL:
+            async_step  = ASYNC_SCL_HIGH;
+            async_after = ASYNC_STOP_SDA;
+            continue;
+
+        case ASYNC_STOP_SDA:
+            // A low-to-high transition on the SDA line while the SCL is high defines a STOP
+            // condition.
+            SDA_HIGH(twi_sda);
+            return asyncNext();
+
+        case ASYNC_VALLEY:
+            SCL_LOW(twi_scl);
+            async_step  = ASYNC_SCL_HIGH;
+            async_after = ASYNC_IDLE;  // then the next transaction
+            return async_half;
+
+        case ASYNC_SCL_HIGH:
+            SCL_HIGH(twi_scl);
+            async_stretch = esp_get_cycle_count();
+            async_step    = ASYNC_SCL_WAIT;
+            continue;
+
+        case ASYNC_SCL_WAIT:
+            if (!SCL_READ(twi_scl)
+                && esp_get_cycle_count() - async_stretch
+                       < twi_clockStretchLimit * esp_get_cpu_freq_mhz())
+            {
+                return async_half / 4;  // clock stretched by the slave
+            }
+            if (async_after == ASYNC_IDLE)
+            {
+                return asyncNext();
+            }
+            async_step = async_after;
+            if (async_step == ASYNC_BIT_HIGH)
+            {
+                continue;
+            }
+            return async_half;
+
+        case ASYNC_IDLE:
+        case ASYNC_DONE:
+            return async_half;
+        }
+    }
+}
+
 // C wrappers for the object, since API is exposed only as C
 extern "C"
 {
@@ -1033,6 +1377,12 @@ extern "C"
         return twi.writeTo(address, buf, len, sendStop);
     }
 
+    uint8_t twi_writeRegister(unsigned char address, uint8_t reg, unsigned char* buf,
+                              unsigned int len, unsigned char sendStop)
+    {
+        return twi.writeTo(address, buf, len, sendStop, reg);
+    }
+
     uint8_t twi_readFrom(unsigned char address, unsigned char* buf, unsigned int len,
                          unsigned char sendStop)
     {
@@ -1044,6 +1394,11 @@ extern "C"
         return twi.status();
     }
 
+    void twi_stop(void)
+    {
+        twi.stop();
+    }
+
     uint8_t twi_transmit(const uint8_t* buf, uint8_t len)
     {
         return twi.transmit(buf, len);
@@ -1073,4 +1428,14 @@ extern "C"
     {
         twi.enableSlave();
     }
+
+    bool twi_queue(twi_transaction_t* transactions, size_t count, void (*done)(void*), void* arg)
+    {
+        return twi.queue(transactions, count, done, arg);
+    }
+
+    bool twi_queueBusy(void)
+    {
+        return twi.queueBusy();
+    }
 };
@@ -42,6 +42,17 @@
  to go out over the (slow) SPI bus.  The SPI is set up in a DIO mode which
  uses no more pins than normal SPI, but provides for ~2X faster transfers.
 
+ The cache is write-back and set associative: MMU_VM_CACHE_SETS sets of
+ MMU_VM_CACHE_WAYS lines of MMU_VM_CACHE_LINE bytes each, 2 x 2 x 64 bytes
+ by default, which may be changed with build flags.  Larger lines make
+ sequential accesses miss less often, and are filled with back-to-back
+ 64 byte SPI bursts.  vm_cache_stats() reports the hits, misses and
+ writebacks, to tune them for an application.
+
+ Copying a buffer in external RAM with memcpy() still takes an exception for
+ every load or store.  vm_memcpy(), vm_memmove() and vm_memset() move it in
+ SPI bursts instead, and umm_malloc uses them for the external heap.
+
  NOTE: This works fine for processor accesses, but cannot be used by any
  of the peripherals' DMA.  For that, we'd need a real MMU.
 
@@ -144,23 +155,46 @@ typedef enum { sio = 0, dio = 1 } iotype;
 
 constexpr int read_delay = (hspi_mode == dio) ? 4-1 : 0;
 
-constexpr int cache_ways = 4;   // N-way, fully associative cache
-constexpr int cache_words = 16; // Must be 16 words or smaller to fit in SPI buffer
+// Cache geometry, may be changed with build flags.  The line addresses are
+// hashed into the sets, each set holds cache_ways lines replaced in LRU
+// order.  The total cache size is sets * ways * line bytes of DRAM.
+#ifndef MMU_VM_CACHE_WAYS
+#define MMU_VM_CACHE_WAYS 2   // 1 (direct mapped), 2 or 4, 0 for no cache at all
+#endif
+#ifndef MMU_VM_CACHE_SETS
+#define MMU_VM_CACHE_SETS 2   // Power of two
+#endif
+#ifndef MMU_VM_CACHE_LINE
+#define MMU_VM_CACHE_LINE 64  // Bytes, 16, 32, 64 or 128
+#endif
+
+constexpr int cache_ways = MMU_VM_CACHE_WAYS;
+constexpr int cache_sets = MMU_VM_CACHE_SETS;
+constexpr int cache_words = MMU_VM_CACHE_LINE / 4;
+constexpr int spi_words = 16; // The SPI buffer, lines longer than that are filled in several bursts
+constexpr int burst_words = cache_words < spi_words ? cache_words : spi_words;
+constexpr int cache_line_shift = __builtin_ctz(MMU_VM_CACHE_LINE);
+constexpr int cache_set_shift = __builtin_ctz(MMU_VM_CACHE_SETS);
+
+static_assert(cache_ways == 0 || cache_ways == 1 || cache_ways == 2 || cache_ways == 4, "MMU_VM_CACHE_WAYS must be 0, 1, 2 or 4");
+static_assert(cache_sets > 0 && (cache_sets & (cache_sets - 1)) == 0, "MMU_VM_CACHE_SETS must be a power of two");
+static_assert(MMU_VM_CACHE_LINE >= 16 && MMU_VM_CACHE_LINE <= 128 && (MMU_VM_CACHE_LINE & (MMU_VM_CACHE_LINE - 1)) == 0, "MMU_VM_CACHE_LINE must be 16, 32, 64 or 128");
 
 static struct cache_line {
   int32_t addr;            // Address, lower bits masked off
   int dirty;               // Needs writeback
-  struct cache_line *next; // We'll keep linked list in MRU order
+  uint32_t used;           // Access stamp, the smallest one in a set is the LRU
   union {
     uint32_t w[cache_words];
     uint16_t s[cache_words * 2];
     uint8_t  b[cache_words * 4];
   };
-} __vm_cache_line[cache_ways];
+} __vm_cache_line[cache_sets][cache_ways ? cache_ways : 1];
 static struct cache_line *__vm_cache; // Always points to MRU (hence the line being read/written)
+static uint32_t __vm_cache_used;      // Stamp of the MRU
+static vm_cache_stats_t __vm_cache_stats;
 
-constexpr int addrmask = ~(sizeof(__vm_cache[0].w)-1); // Helper to mask off bits present in cache entry
-
+constexpr int addrmask = ~(sizeof(__vm_cache_line[0][0].w)-1); // Helper to mask off bits present in cache entry
 
 static void spi_init(spi_regs *spi1)
 {
@@ -216,53 +250,85 @@ inline IRAM_ATTR uint32_t spi_readtransaction(spi_regs *spi1, int addr, int addr
   return spi1->spi_w[0];
 }
 
+// Fold the upper address bits into the set index, so buffers a multiple
+// of the set span apart don't all compete for the same set
+static inline IRAM_ATTR struct cache_line *cache_set(int addr)
+{
+  uint32_t line = (uint32_t)addr >> cache_line_shift;
+  return __vm_cache_line[(line ^ (line >> cache_set_shift)) & (cache_sets - 1)];
+}
+
+// The cached line of a (masked) address, or NULL when it's not cached
+static inline IRAM_ATTR struct cache_line *cache_find(int addr)
+{
+  struct cache_line *set = cache_set(addr);
+  for (auto i = 0; i < cache_ways; i++) {
+    if (set[i].addr == addr) {
+      return &set[i];
+    }
+  }
+  return NULL;
+}
+
 static inline IRAM_ATTR void cache_flushrefill(spi_regs *spi1, int addr)
 {
   addr &= addrmask;
-  struct cache_line *way = __vm_cache;
 
-  if (__vm_cache->addr == addr) return; // Fast case, it already is the MRU
-  struct cache_line *last = way;
-  way = way->next;
+  if (__vm_cache->addr == addr) { // Fast case, it already is the MRU
+    __vm_cache_stats.hits++;
+    return;
+  }
 
-  for (auto i = 1; i < cache_ways; i++) {
-    if (way->addr == addr) {
-      last->next = way->next;
-      way->next = __vm_cache;
-      __vm_cache = way;
+  struct cache_line *set = cache_set(addr);
+  struct cache_line *lru = &set[0];
+  for (auto i = 0; i < cache_ways; i++) {
+    if (set[i].addr == addr) {
+      __vm_cache_stats.hits++;
+      set[i].used = ++__vm_cache_used;
+      __vm_cache = &set[i];
       return;
-    } else {
-      last = way;
-      way = way->next;
+    }
+    if (set[i].used < lru->used) {
+      lru = &set[i];
     }
   }
 
-  // At this point we know the line is not in the cache and way points to the LRU.
+  // At this point we know the line is not in the cache and lru is the line to replace.
+  __vm_cache_stats.misses++;
 
   // We allow reads to go before writes since the write can happen in the background.
   // We need to keep the data to be written back since it will be overwritten with read data
   uint32_t wb[cache_words];
-  if (last->dirty) {
-    memcpy(wb, last->w, sizeof(last->w));
+  int dirty = lru->dirty;
+  int32_t wbaddr = lru->addr;
+  if (dirty) {
+    memcpy(wb, lru->w, sizeof(lru->w));
   }
 
-  // Update MRU info, list
-  last->next = __vm_cache;
-  __vm_cache = last;
+  lru->used = ++__vm_cache_used;
+  __vm_cache = lru;
 
-  // Do the actual read
-  spi_readtransaction(spi1, (0x03 << 24) | addr, 32-1, read_delay, sizeof(last->w) * 8 - 1, hspi_mode);
-  memcpy(last->w, spi1->spi_w, sizeof(last->w));
+  // Do the actual read, in bursts of the SPI buffer size for long lines
+  for (auto i = 0; i < cache_words; i += burst_words) {
+    spi_readtransaction(spi1, (0x03 << 24) | (addr + i * 4), 32-1, read_delay, burst_words * 32 - 1, hspi_mode);
+    memcpy(&lru->w[i], spi1->spi_w, burst_words * 4);
+  }
 
-  // We fire a background writeback now, if needed
-  if (last->dirty) {
-    memcpy(spi1->spi_w, wb, sizeof(wb));
-    spi_writetransaction(spi1, (0x02 << 24) | last->addr, 32-1, 0, sizeof(last->w) * 8 - 1, hspi_mode);
-    last->dirty = 0;
+  // We fire a background writeback now, if needed.  Only the last burst
+  // continues in the background, the previous ones must be out of the
+  // SPI buffer before it is refilled.
+  if (dirty) {
+    __vm_cache_stats.writebacks++;
+    for (auto i = 0; i < cache_words; i += burst_words) {
+      while (spi1->spi_cmd & SPIBUSY) { /* busywait */ }
+      memcpy(spi1->spi_w, &wb[i], burst_words * 4);
+      spi_writetransaction(spi1, (0x02 << 24) | (wbaddr + i * 4), 32-1, 0, burst_words * 32 - 1, hspi_mode);
+    }
+    lru->dirty = 0;
   }
 
   // Update the addr at this point since we no longer need the old one
-  last->addr = addr;
+  lru->addr = addr;
 }
 
 static inline IRAM_ATTR void spi_ramwrite(spi_regs *spi1, int addr, int data_bits, uint32_t val)
@@ -298,6 +364,152 @@ static inline IRAM_ATTR uint32_t spi_ramread(spi_regs *spi1, int addr, int data_
   }
 }
 
+// Bulk transfers for vm_memcpy() and friends, without the exception
+// handler.  The external RAM is moved in chunks within one cache line and
+// one SPI buffer.  A cached line is copied in place (and is dirty when
+// written), an uncached one is transferred straight over SPI without
+// taking a cache line, so bulk data doesn't evict the working set.
+
+constexpr size_t chunk_bytes = (cache_ways ? cache_words : spi_words) * 4;
+constexpr size_t max_chunk = spi_words * 4;
+
+static inline IRAM_ATTR bool is_vm(const void *p)
+{
+  return ((uint32_t)p >> 28) == 1;
+}
+
+static IRAM_ATTR void vm_read(spi_regs *spi1, uint32_t offset, uint8_t *dst, size_t n)
+{
+  struct cache_line *line = cache_find(offset & addrmask);
+  if (line) {
+    memcpy(dst, &line->b[offset - line->addr], n);
+    return;
+  }
+  // The SPI buffer is only word-accessible
+  uint32_t buf[spi_words];
+  spi_readtransaction(spi1, (0x03 << 24) | offset, 32-1, read_delay, n * 8 - 1, hspi_mode);
+  for (size_t i = 0; i < (n + 3) / 4; i++) {
+    buf[i] = spi1->spi_w[i];
+  }
+  memcpy(dst, buf, n);
+}
+
+static IRAM_ATTR void vm_write(spi_regs *spi1, uint32_t offset, const uint8_t *src, size_t n)
+{
+  struct cache_line *line = cache_find(offset & addrmask);
+  if (line) {
+    memcpy(&line->b[offset - line->addr], src, n);
+    line->dirty = 1;
+    return;
+  }
+  uint32_t buf[spi_words];
+  memcpy(buf, src, n);
+  while (spi1->spi_cmd & SPIBUSY) { /* busywait */ }
+  for (size_t i = 0; i < (n + 3) / 4; i++) {
+    spi1->spi_w[i] = buf[i];
+  }
+  spi_writetransaction(spi1, (0x02 << 24) | offset, 32-1, 0, n * 8 - 1, hspi_mode);
+}
+
+// Largest chunk at addr, before the end of its cache line for external RAM
+static inline IRAM_ATTR size_t chunk_from(const void *addr, size_t n)
+{
+  if (is_vm(addr)) {
+    size_t left = chunk_bytes - ((uint32_t)addr & (chunk_bytes - 1));
+    return left < n ? left : n;
+  }
+  return n;
+}
+
+// Largest chunk ending at end, after the start of its cache line for external RAM
+static inline IRAM_ATTR size_t chunk_to(const void *end, size_t n)
+{
+  if (is_vm(end)) {
+    size_t left = (uint32_t)end & (chunk_bytes - 1);
+    if (!left) {
+      left = chunk_bytes;
+    }
+    return left < n ? left : n;
+  }
+  return n;
+}
+
+static IRAM_ATTR void vm_copy_chunk(uint8_t *dst, const uint8_t *src, size_t n)
+{
+  DECLARE_SPI1;
+  uint32_t buf[spi_words];
+  // Keep an interrupt's load or store to the external RAM off the SPI meanwhile
+  uint32_t saved = xt_rsil(15);
+  if (is_vm(src)) {
+    uint8_t *to = is_vm(dst) ? (uint8_t *)buf : dst;
+    vm_read(spi1, (uint32_t)src & VM_OFFSET_MASK, to, n);
+    src = to;
+  }
+  if (is_vm(dst)) {
+    vm_write(spi1, (uint32_t)dst & VM_OFFSET_MASK, src, n);
+  }
+  xt_wsr_ps(saved);
+}
+
+static IRAM_ATTR void vm_copy_forward(uint8_t *dst, const uint8_t *src, size_t n)
+{
+  while (n) {
+    size_t chunk = chunk_from(dst, chunk_from(src, n < max_chunk ? n : max_chunk));
+    vm_copy_chunk(dst, src, chunk);
+    dst += chunk;
+    src += chunk;
+    n -= chunk;
+  }
+}
+
+static IRAM_ATTR void vm_copy_backward(uint8_t *dst, const uint8_t *src, size_t n)
+{
+  while (n) {
+    size_t chunk = chunk_to(dst + n, chunk_to(src + n, n < max_chunk ? n : max_chunk));
+    n -= chunk;
+    vm_copy_chunk(dst + n, src + n, chunk);
+  }
+}
+
+IRAM_ATTR void *vm_memcpy(void *dst, const void *src, size_t n)
+{
+  if (!is_vm(dst) && !is_vm(src)) {
+    return memcpy(dst, src, n);
+  }
+  vm_copy_forward((uint8_t *)dst, (const uint8_t *)src, n);
+  return dst;
+}
+
+IRAM_ATTR void *vm_memmove(void *dst, const void *src, size_t n)
+{
+  if (!is_vm(dst) && !is_vm(src)) {
+    return memmove(dst, src, n);
+  }
+  if ((uintptr_t)dst > (uintptr_t)src && (uintptr_t)dst < (uintptr_t)src + n) {
+    vm_copy_backward((uint8_t *)dst, (const uint8_t *)src, n);
+  } else {
+    vm_copy_forward((uint8_t *)dst, (const uint8_t *)src, n);
+  }
+  return dst;
+}
+
+IRAM_ATTR void *vm_memset(void *dst, int c, size_t n)
+{
+  if (!is_vm(dst)) {
+    return memset(dst, c, n);
+  }
+  uint32_t pattern[spi_words];
+  memset(pattern, c, sizeof(pattern));
+  uint8_t *to = (uint8_t *)dst;
+  while (n) {
+    size_t chunk = chunk_from(to, n < max_chunk ? n : max_chunk);
+    vm_copy_chunk(to, (const uint8_t *)pattern, chunk);
+    to += chunk;
+    n -= chunk;
+  }
+  return dst;
+}
+
 static void (*__old_handler)(struct __exception_frame *ef, int cause);
 
 static IRAM_ATTR void loadstore_exception_handler(struct __exception_frame *ef, int cause)
@@ -345,6 +557,16 @@ static IRAM_ATTR void loadstore_exception_handler(struct __exception_frame *ef,
   }
 }
 
+void vm_cache_stats(vm_cache_stats_t *stats)
+{
+  *stats = __vm_cache_stats;
+}
+
+void vm_cache_stats_reset()
+{
+  memset(&__vm_cache_stats, 0, sizeof(__vm_cache_stats));
+}
+
 void install_vm_exception_handler()
 {
   __old_handler = _xtos_set_exception_handler(EXCCAUSE_LOAD_PROHIBITED, loadstore_exception_handler);
@@ -383,12 +605,15 @@ void install_vm_exception_handler()
 
   // Bring cache structures to baseline
   if (cache_ways > 0) {
-    for (auto i = 0; i < cache_ways; i++) {
-      __vm_cache_line[i].addr = -1; // Invalid, bits set in lower region so will never match
-      __vm_cache_line[i].next = &__vm_cache_line[i+1];
+    for (auto i = 0; i < cache_sets; i++) {
+      for (auto j = 0; j < cache_ways; j++) {
+        __vm_cache_line[i][j].addr = -1; // Invalid, bits set in lower region so will never match
+        __vm_cache_line[i][j].dirty = 0;
+        __vm_cache_line[i][j].used = 0;
+      }
     }
-    __vm_cache = &__vm_cache_line[0];
-    __vm_cache_line[cache_ways - 1].next = NULL;
+    __vm_cache = &__vm_cache_line[0][0];
+    __vm_cache_used = 0;
   }
 
   // Our umm_malloc configuration can only support a maximum of 256K RAM. A
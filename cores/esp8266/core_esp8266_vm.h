@@ -1,9 +1,36 @@
+#include <stdint.h>
+#include <string.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 extern void install_vm_exception_handler();
 
+// Accesses to the external heap found or not in the cache, and dirty
+// lines written back to the external RAM
+typedef struct {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t writebacks;
+} vm_cache_stats_t;
+
+extern void vm_cache_stats(vm_cache_stats_t *stats);
+extern void vm_cache_stats_reset();
+
+// memcpy(), memmove() and memset() moving external heap data with SPI
+// bursts, instead of an exception for each load or store.  Other memory
+// is handed to the plain functions.
+#ifdef MMU_EXTERNAL_HEAP
+extern void *vm_memcpy(void *dst, const void *src, size_t n);
+extern void *vm_memmove(void *dst, const void *src, size_t n);
+extern void *vm_memset(void *dst, int c, size_t n);
+#else
+static inline void *vm_memcpy(void *dst, const void *src, size_t n) { return memcpy(dst, src, n); }
+static inline void *vm_memmove(void *dst, const void *src, size_t n) { return memmove(dst, src, n); }
+static inline void *vm_memset(void *dst, int c, size_t n) { return memset(dst, c, n); }
+#endif
+
 
 #ifdef __cplusplus
 };
@@ -110,11 +110,68 @@ int stopWaveform(uint8_t pin);
 // Make sure the CB function has the IRAM_ATTR decorator.
 void setTimer1Callback(uint32_t (*fn)());
 
+// An edge generated later than this after its time is counted as late
+#ifndef WAVEFORM_LATE_US
+#define WAVEFORM_LATE_US 2
+#endif
+
+// Statistics of the timer1 NMI, which generates the waveforms and PWM and
+// calls the timer1 callback, to choose PWM frequencies and pin counts the
+// CPU can afford.  The share of CPU time spent in the NMI, in percent, is
+// (100 * cycles) / (elapsedUs * clockCyclesPerMicrosecond()).
+typedef struct {
+  uint32_t elapsedUs;     // Time since the statistics were enabled
+  uint32_t calls;         // Number of NMIs
+  uint64_t cycles;        // CPU clock cycles spent in them
+  uint32_t maxCycles;     // Longest NMI, in CPU clock cycles
+  uint32_t edges;         // Waveform and PWM edges generated
+  uint32_t lateEdges;     // Edges generated more than WAVEFORM_LATE_US after their time
+  uint32_t maxLateCycles; // Latest edge, in CPU clock cycles after its time
+} waveform_stats_t;
+
+// Start counting the NMI statistics from zero, or stop counting them.  They
+// are not counted by default, to save the NMI some cycles.
+void setWaveformStats(bool enable);
+
+// Copy the NMI statistics counted so far.
+void getWaveformStats(waveform_stats_t* stats);
+
+// CPU clock cycles the NMI is expected to spend per edge, before the
+// statistics measured it
+#ifndef WAVEFORM_EDGE_CYCLES
+#define WAVEFORM_EDGE_CYCLES 240
+#endif
+
+// Admission control of timer1, shared by startWaveform(), tone(),
+// analogWrite(), Servo and the timer1 callback users.  Each running output
+// is accounted its edges per second, and the projected NMI load is those
+// edges times the cycles of an edge: WAVEFORM_EDGE_CYCLES, or the average
+// measured once the statistics are enabled and counted 1000 edges.
+// With a budget set, starting or speeding up an output which would take
+// the projected load over it fails instead, e.g. startWaveform() returns
+// false.  0, the default, admits anything (but still accounts the load).
+void setWaveformBudget(uint8_t percent);
+
+// The projected share of CPU time in the NMI, in percent, for the outputs
+// running and another edgesPerSecond: 2 per period for a waveform, twice
+// the frequency of a tone.
+float getWaveformLoad(uint32_t edgesPerSecond = 0);
+
+// The timer1 callback users declare their edges per second before
+// setTimer1Callback(), false when over budget.  setTimer1Callback(NULL)
+// releases it.
+bool setTimer1CallbackLoad(uint32_t edgesPerSecond);
+
 
 // Internal-only calls, not for applications
 extern void _setPWMFreq(uint32_t freq);
 extern bool _stopPWM(uint8_t pin);
 extern bool _setPWM(int pin, uint32_t val, uint32_t range);
+extern bool _setPWMMulti(const uint8_t *pins, const uint32_t *vals, size_t count, uint32_t range);
+extern void _setPWMStagger(bool stagger);
+extern bool _waveformStatsEnabled;
+extern void _waveformStatsEdge(uint32_t lateCcys);
+extern void _waveformStatsIRQ(uint32_t startCcy);
 
 #ifdef __cplusplus
 }
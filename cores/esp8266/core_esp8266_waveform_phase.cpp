@@ -57,6 +57,8 @@ extern "C" void enablePhaseLockedWaveform (void)
 extern "C" void _setPWMFreq_weak(uint32_t freq) { (void) freq; }
 extern "C" IRAM_ATTR bool _stopPWM_weak(int pin) { (void) pin; return false; }
 extern "C" bool _setPWM_weak(int pin, uint32_t val, uint32_t range) { (void) pin; (void) val; (void) range; return false; }
+extern "C" bool _setPWMMulti_weak(const uint8_t* pins, const uint32_t* vals, size_t count, uint32_t range) { (void) pins; (void) vals; (void) count; (void) range; return false; }
+extern "C" void _setPWMStagger_weak(bool stagger) { (void) stagger; }
 
 
 // Timer is 80MHz fixed. 160MHz CPU frequency need scaling.
@@ -338,6 +340,9 @@ static IRAM_ATTR void timer1Interrupt() {
       else {
         const int32_t overshootCcys = now - waveNextEventCcy;
         if (overshootCcys >= 0) {
+          if (_waveformStatsEnabled) {
+            _waveformStatsEdge(overshootCcys);
+          }
           const int32_t periodCcys = scaleCcys(wave.periodCcys, isCPU2X);
           if (waveform.states & pinBit) {
             // active configuration and forward are 100% duty
@@ -441,4 +446,8 @@ static IRAM_ATTR void timer1Interrupt() {
 
   // Register access is fast and edge IRQ was configured before.
   T1L = nextEventCcys;
+
+  if (_waveformStatsEnabled) {
+    _waveformStatsIRQ(isrStartCcy);
+  }
 }
@@ -116,24 +116,35 @@ static IRAM_ATTR void forceTimerInterrupt() {
 
 // PWM implementation using special purpose state machine
 //
-// Keep an ordered list of pins with the delta in cycles between each
-// element, with a terminal entry making up the remainder of the PWM
+// Keep an ordered table of edges, each with the pins to raise and the
+// pins to drop at that time and the delta in cycles from the previous
+// edge, with a terminal entry making up the remainder of the PWM
 // period.  With this method sum(all deltas) == PWM period clock cycles.
+// Pins changing at the same time share one edge.
 //
-// At t=0 set all pins high and set the timeout for the 1st edge.
+// At t=0 set the starting pins high and set the timeout for the 1st edge.
 // On interrupt, if we're at the last element reset to t=0 state
-// Otherwise, clear that pin down and set delay for next element
+// Otherwise, apply that edge's pins and set delay for next element
 // and so forth.
+//
+// The whole table is rebuilt from the pins' duty cycles by the main code
+// and handed to the NMI at once, which switches to it at the next period.
+// Without staggering all pins start high at t=0 and only have a falling
+// edge.  With staggering the pins' pulses start spread over the period, so
+// they don't all draw current at once, and get a rising edge as well.
 
 constexpr int maxPWMs = 8;
+constexpr int maxPWMEdges = 2 * maxPWMs;
 
 // PWM machine state
 typedef struct PWMState {
-  uint32_t mask; // Bitmask of active pins
-  uint32_t cnt;  // How many entries
-  uint32_t idx;  // Where the state machine is along the list
-  uint8_t  pin[maxPWMs + 1];
-  uint32_t delta[maxPWMs + 1];
+  uint32_t mask;  // Bitmask of active pins
+  uint32_t cnt;   // How many edges
+  uint32_t idx;   // Where the state machine is along the table
+  uint32_t start; // Pins set high at t=0
+  uint32_t set[maxPWMEdges + 1];   // Pins raised at each edge
+  uint32_t clr[maxPWMEdges + 1];   // Pins dropped at each edge
+  uint32_t delta[maxPWMEdges + 1]; // Cycles since the previous edge
   uint32_t nextServiceCycle;  // Clock cycle for next step
   struct PWMState *pwmUpdate; // Set by main code, cleared by ISR
 } PWMState;
@@ -141,6 +152,49 @@ typedef struct PWMState {
 static PWMState pwmState;
 static uint32_t _pwmFreq = 1000;
 static uint32_t _pwmPeriod = microsecondsToClockCycles(1000000UL) / _pwmFreq;
+static bool _pwmStagger = false;
+
+// Edges per second the NMI generates for each user of timer1, for the
+// admission control: the waveforms of pins 0..16, the PWM table, the timer1
+// callback.  A waveform with a run time stops counting at untilUs.
+enum { LOAD_PWM = 17, LOAD_CALLBACK, LOAD_USERS };
+typedef struct {
+  uint32_t edges;
+  uint32_t untilUs;
+} WaveformLoad;
+
+static WaveformLoad _waveformLoad[LOAD_USERS];
+static uint8_t _waveformBudget = 0;
+
+static uint32_t _activeEdges(const WaveformLoad& load, uint32_t now) {
+  return (!load.untilUs || (int32_t)(load.untilUs - now) > 0) ? load.edges : 0;
+}
+
+static uint32_t _waveformLoadEdges() {
+  uint32_t edges = 0;
+  uint32_t now = micros();
+  for (const auto& load : _waveformLoad) {
+    edges += _activeEdges(load, now);
+  }
+  return edges;
+}
+
+// Account the new edges of a user, unless they take the load over budget
+static bool _admitLoad(uint8_t user, uint32_t edges, uint32_t runTimeUs = 0) {
+  WaveformLoad& load = _waveformLoad[user];
+  uint32_t current = _activeEdges(load, micros());
+  if (edges > current && _waveformBudget && getWaveformLoad(edges - current) > _waveformBudget) {
+    return false;
+  }
+  load.edges = edges;
+  load.untilUs = runTimeUs ? (micros() + runTimeUs) | 1 : 0;
+  return true;
+}
+
+static uint32_t _pwmLoadEdges(uint32_t mask) {
+  // the NMI sets all pins at once, then resets each
+  return mask ? (__builtin_popcount(mask) + 1) * _pwmFreq : 0;
+}
 
 
 // If there are no more scheduled activities, shut down Timer 1.
@@ -169,43 +223,52 @@ static IRAM_ATTR void _notifyPWM(PWMState *p, bool idle) {
   }
 }
 
-static void _addPWMtoList(PWMState &p, int pin, uint32_t val, uint32_t range);
-
-
-// Called when analogWriteFreq() changed to update the PWM total period
-extern void _setPWMFreq_weak(uint32_t freq) __attribute__((weak)); 
-void _setPWMFreq_weak(uint32_t freq) {
-  _pwmFreq = freq;
+static void _buildPWMTable(PWMState &p);
 
+// The PWM period for a frequency and number of running PWMs
+static uint32_t _calcPWMPeriod(uint32_t freq, uint32_t pwms) {
   // Convert frequency into clock cycles
   uint32_t cc = microsecondsToClockCycles(1000000UL) / freq;
 
   // Simple static adjustment to bring period closer to requested due to overhead
   // Empirically determined as a constant PWM delay and a function of the number of PWMs
 #if F_CPU == 80000000
-  cc -= ((microsecondsToClockCycles(pwmState.cnt) * 13) >> 4) + 110;
+  cc -= ((microsecondsToClockCycles(pwms) * 13) >> 4) + 110;
 #else
-  cc -= ((microsecondsToClockCycles(pwmState.cnt) * 10) >> 4) + 75;
+  cc -= ((microsecondsToClockCycles(pwms) * 10) >> 4) + 75;
 #endif
+  return cc;
+}
+
+// Rebuild the table of the running PWMs, e.g. for a new period, and wait for the NMI to use it
+static void _updatePWM() {
+  PWMState p;  // The working copy since we can't edit the one in use
+  p = pwmState;
+  _buildPWMTable(p);
+  // Update and wait for mailbox to be emptied
+  initTimer();
+  _notifyPWM(&p, true);
+  disableIdleTimer();
+}
+
+
+// Called when analogWriteFreq() changed to update the PWM total period
+extern void _setPWMFreq_weak(uint32_t freq) __attribute__((weak)); 
+void _setPWMFreq_weak(uint32_t freq) {
+  _pwmFreq = freq;
 
+  uint32_t cc = _calcPWMPeriod(freq, __builtin_popcount(pwmState.mask));
+  if (pwmState.mask) {
+    _waveformLoad[LOAD_PWM].edges = _pwmLoadEdges(pwmState.mask);
+  }
   if (cc == _pwmPeriod) {
     return; // No change
   }
 
   _pwmPeriod = cc;
 
-  if (pwmState.cnt) {
-    PWMState p;  // The working copy since we can't edit the one in use
-    p.mask = 0;
-    p.cnt = 0;
-    for (uint32_t i = 0; i < pwmState.cnt; i++) {
-      auto pin = pwmState.pin[i];
-      _addPWMtoList(p, pin, wvfState.waveform[pin].desiredHighCycles, wvfState.waveform[pin].desiredLowCycles);
-    }
-    // Update and wait for mailbox to be emptied
-    initTimer();
-    _notifyPWM(&p, true);
-    disableIdleTimer();
+  if (pwmState.mask) {
+    _updatePWM();
   }
 }
 static void _setPWMFreq_bound(uint32_t freq) __attribute__((weakref("_setPWMFreq_weak")));
@@ -214,25 +277,20 @@ void _setPWMFreq(uint32_t freq) {
 }
 
 
-// Helper routine to remove an entry from the state machine
-// and clean up any marked-off entries
-static void _cleanAndRemovePWM(PWMState *p, int pin) {
-  uint32_t leftover = 0;
-  uint32_t in, out;
-  for (in = 0, out = 0; in < p->cnt; in++) {
-    if ((p->pin[in] != pin) && (p->mask & (1<<p->pin[in]))) {
-        p->pin[out] = p->pin[in];
-        p->delta[out] = p->delta[in] + leftover;
-        leftover = 0;
-        out++;
-    } else {
-        leftover += p->delta[in];
-        p->mask &= ~(1<<p->pin[in]);
-    }
+// Called when analogWriteStagger() changed to spread the PWM pulses over the period, or not
+extern void _setPWMStagger_weak(bool stagger) __attribute__((weak));
+void _setPWMStagger_weak(bool stagger) {
+  if (stagger == _pwmStagger) {
+    return; // No change
+  }
+  _pwmStagger = stagger;
+  if (pwmState.mask) {
+    _updatePWM();
   }
-  p->cnt = out;
-  // Final pin is never used: p->pin[out] = 0xff;
-  p->delta[out] = p->delta[in] + leftover;
+}
+static void _setPWMStagger_bound(bool stagger) __attribute__((weakref("_setPWMStagger_weak")));
+void _setPWMStagger(bool stagger) {
+  _setPWMStagger_bound(stagger);
 }
 
 
@@ -247,7 +305,8 @@ IRAM_ATTR bool _stopPWM_weak(uint8_t pin) {
   p = pwmState;
 
   // In _stopPWM we just clear the mask but keep everything else
-  // untouched to save IRAM.  The main startPWM will handle cleanup.
+  // untouched to save IRAM.  The NMI ignores the edges of pins not in
+  // the mask, and the next rebuild will drop them.
   p.mask &= ~(1<<pin);
   if (!p.mask) {
     // If all have been stopped, then turn PWM off completely
@@ -262,91 +321,181 @@ IRAM_ATTR bool _stopPWM_weak(uint8_t pin) {
 }
 static bool _stopPWM_bound(uint8_t pin) __attribute__((weakref("_stopPWM_weak")));
 IRAM_ATTR bool _stopPWM(uint8_t pin) {
-  return _stopPWM_bound(pin);
-}
-
-static void _addPWMtoList(PWMState &p, int pin, uint32_t val, uint32_t range) {
-  // Stash the val and range so we can re-evaluate the fraction
-  // should the user change PWM frequency.  This allows us to
-  // give as great a precision as possible.  We know by construction
-  // that the waveform for this pin will be inactive so we can borrow
-  // memory from that structure.
-  wvfState.waveform[pin].desiredHighCycles = val;  // Numerator == high
-  wvfState.waveform[pin].desiredLowCycles = range; // Denominator == low
-
-  uint32_t cc = (_pwmPeriod * val) / range;
-
-  // Clip to sane values in the case we go from OK to not-OK when adjusting frequencies
-  if (cc == 0) {
-    cc = 1;
-  } else if (cc >= _pwmPeriod) {
-    cc = _pwmPeriod - 1;
-  }
-
-  if (p.cnt == 0) {
-    // Starting up from scratch, special case 1st element and PWM period
-    p.pin[0] = pin;
-    p.delta[0] = cc;
-   // Final pin is never used: p.pin[1] = 0xff;
-    p.delta[1] = _pwmPeriod - cc;
-  } else {
-    uint32_t ttl = 0;
-    uint32_t i;
-    // Skip along until we're at the spot to insert
-    for (i=0; (i <= p.cnt) && (ttl + p.delta[i] < cc); i++) {
-      ttl += p.delta[i];
+  if (!_stopPWM_bound(pin)) {
+    return false;
+  }
+  // May be in an ISR: one pin less, without the flash popcount
+  uint32_t& edges = _waveformLoad[LOAD_PWM].edges;
+  edges = (pwmState.mask && edges > _pwmFreq) ? edges - _pwmFreq : 0;
+  return true;
+}
+
+// Insert an edge in the table, or merge it with the one at the same time.
+// While building, delta[] holds the time of the edges since t=0.
+static void _addPWMEdge(PWMState &p, uint32_t when, uint32_t set, uint32_t clr) {
+  uint32_t i;
+  // Skip along until we're at the spot to insert
+  for (i = 0; (i < p.cnt) && (p.delta[i] < when); i++) {
+    /* no-op */
+  }
+  if ((i < p.cnt) && (p.delta[i] == when)) {
+    p.set[i] |= set;
+    p.clr[i] |= clr;
+    return;
+  }
+  // Shift everything out by one to make space for new edge
+  for (uint32_t j = p.cnt; j > i; j--) {
+    p.delta[j] = p.delta[j - 1];
+    p.set[j] = p.set[j - 1];
+    p.clr[j] = p.clr[j - 1];
+  }
+  p.delta[i] = when;
+  p.set[i] = set;
+  p.clr[i] = clr;
+  p.cnt++;
+}
+
+// Compute the edge table of all pins in p.mask for the current period
+static void _buildPWMTable(PWMState &p) {
+  uint32_t pwms = __builtin_popcount(p.mask);
+  uint32_t n = 0;
+  p.cnt = 0;
+  p.start = 0;
+  for (int pin = 0; pin <= 16; pin++) {
+    uint32_t mask = 1<<pin;
+    if (!(p.mask & mask)) {
+      continue;
+    }
+    // The val and range were stashed by _setPWMs, so we give as great a
+    // precision as possible whatever the period.
+    uint32_t cc = ((uint64_t)_pwmPeriod * wvfState.waveform[pin].desiredHighCycles) / wvfState.waveform[pin].desiredLowCycles;
+
+    // Clip to sane values in the case we go from OK to not-OK when adjusting frequencies
+    if (cc == 0) {
+      cc = 1;
+    } else if (cc >= _pwmPeriod) {
+      cc = _pwmPeriod - 1;
+    }
+
+    uint32_t phase = _pwmStagger ? (_pwmPeriod / pwms) * n++ : 0;
+    if (phase + cc == _pwmPeriod) {
+      phase--; // Keep the falling edge inside the period, not on t=0
     }
-    // Shift everything out by one to make space for new edge
-    for (int32_t j = p.cnt; j >= (int)i; j--) {
-      p.pin[j + 1] = p.pin[j];
-      p.delta[j + 1] = p.delta[j];
+    uint32_t end = phase + cc;
+    if (end > _pwmPeriod) {
+      // Pulse wraps around t=0
+      p.start |= mask;
+      _addPWMEdge(p, end - _pwmPeriod, 0, mask);
+      _addPWMEdge(p, phase, mask, 0);
+    } else {
+      if (phase) {
+        _addPWMEdge(p, phase, mask, 0);
+      } else {
+        p.start |= mask;
+      }
+      _addPWMEdge(p, end, 0, mask);
     }
-    int off = cc - ttl; // The delta from the last edge to the one we're inserting
-    p.pin[i] = pin;
-    p.delta[i] = off; // Add the delta to this new pin
-    p.delta[i + 1] -= off; // And subtract it from the follower to keep sum(deltas) constant
   }
-  p.cnt++;
-  p.mask |= 1<<pin;
+
+  // Turn the edge times into deltas, the final entry is the rest of the period
+  uint32_t ttl = 0;
+  for (uint32_t i = 0; i < p.cnt; i++) {
+    uint32_t when = p.delta[i];
+    p.delta[i] = when - ttl;
+    ttl = when;
+  }
+  p.set[p.cnt] = 0;
+  p.clr[p.cnt] = 0;
+  p.delta[p.cnt] = _pwmPeriod - ttl;
 }
 
-// Called by analogWrite(1...99%) to set the PWM duty in clock cycles
-extern bool _setPWM_weak(int pin, uint32_t val, uint32_t range) __attribute__((weak));
-bool _setPWM_weak(int pin, uint32_t val, uint32_t range) {
-  stopWaveform(pin);
-  PWMState p;  // Working copy
-  p = pwmState;
-  // Get rid of any entries for this pin
-  _cleanAndRemovePWM(&p, pin);
-  // And add it to the list, in order
-  if (p.cnt >= maxPWMs) {
+// Change the duty of several pins with a single new table, which the NMI
+// switches to at once so all pins change in the same PWM period
+static bool _setPWMs(const uint8_t *pins, const uint32_t *vals, size_t count, uint32_t range) {
+  uint32_t mask = pwmState.mask;
+  uint32_t fixed = 0; // Pins set all-on/off
+  uint32_t level = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint32_t bit = 1<<pins[i];
+    // Sanity check for all-on/off
+    uint32_t cc = ((uint64_t)_pwmPeriod * vals[i]) / range;
+    if ((cc == 0) || (cc >= _pwmPeriod)) {
+      mask &= ~bit;
+      fixed |= bit;
+      level = cc ? (level | bit) : (level & ~bit);
+    } else {
+      mask |= bit;
+      fixed &= ~bit;
+    }
+  }
+  if (__builtin_popcount(mask) > maxPWMs) {
     return false; // No space left
   }
+  if (!_admitLoad(LOAD_PWM, _pwmLoadEdges(mask))) {
+    return false; // Over the timer1 budget
+  }
 
-  // Sanity check for all-on/off
-  uint32_t cc = (_pwmPeriod * val) / range;
-  if ((cc == 0) || (cc >= _pwmPeriod)) {
-    digitalWrite(pin, cc ? HIGH : LOW);
-    return true;
+  uint32_t changed = fixed & pwmState.mask;
+  for (size_t i = 0; i < count; i++) {
+    uint8_t pin = pins[i];
+    stopWaveform(pin);
+    if (mask & (1<<pin)) {
+      // Stash the val and range so we can re-evaluate the fraction should
+      // the user change PWM frequency.  We know by construction that the
+      // waveform for this pin will be inactive so we can borrow memory
+      // from that structure.
+      wvfState.waveform[pin].desiredHighCycles = vals[i];  // Numerator == high
+      wvfState.waveform[pin].desiredLowCycles = range;     // Denominator == low
+      changed |= 1<<pin;
+    }
   }
 
-  _addPWMtoList(p, pin, val, range);
+  if (changed) {
+    // Recalculate the PWM period if the number of pins changed, in the same table
+    _pwmPeriod = _calcPWMPeriod(_pwmFreq, __builtin_popcount(mask));
 
-  // Set mailbox and wait for ISR to copy it over
-  initTimer();
-  _notifyPWM(&p, true);
-  disableIdleTimer();
+    PWMState p;  // Working copy
+    p = pwmState;
+    p.mask = mask;
+    _buildPWMTable(p);
+
+    // Set mailbox and wait for ISR to copy it over
+    initTimer();
+    _notifyPWM(&p, true);
+    disableIdleTimer();
+  }
 
-  // Potentially recalculate the PWM period if we've added another pin
-  _setPWMFreq(_pwmFreq);
+  // The all-on/off pins aren't PWMs any more and keep their level until now
+  for (int pin = 0; fixed; pin++, fixed >>= 1) {
+    if (fixed & 1) {
+      digitalWrite(pin, (level & (1<<pin)) ? HIGH : LOW);
+    }
+  }
 
   return true;
 }
+
+// Called by analogWrite(1...99%) to set the PWM duty in clock cycles
+extern bool _setPWM_weak(int pin, uint32_t val, uint32_t range) __attribute__((weak));
+bool _setPWM_weak(int pin, uint32_t val, uint32_t range) {
+  uint8_t p = pin;
+  return _setPWMs(&p, &val, 1, range);
+}
 static bool _setPWM_bound(int pin, uint32_t val, uint32_t range) __attribute__((weakref("_setPWM_weak")));
 bool _setPWM(int pin, uint32_t val, uint32_t range) {
   return _setPWM_bound(pin, val, range);
 }
 
+// Called by analogWriteMulti() to set the PWM duty of several pins at once
+extern bool _setPWMMulti_weak(const uint8_t *pins, const uint32_t *vals, size_t count, uint32_t range) __attribute__((weak));
+bool _setPWMMulti_weak(const uint8_t *pins, const uint32_t *vals, size_t count, uint32_t range) {
+  return _setPWMs(pins, vals, count, range);
+}
+static bool _setPWMMulti_bound(const uint8_t *pins, const uint32_t *vals, size_t count, uint32_t range) __attribute__((weakref("_setPWMMulti_weak")));
+bool _setPWMMulti(const uint8_t *pins, const uint32_t *vals, size_t count, uint32_t range) {
+  return _setPWMMulti_bound(pins, vals, count, range);
+}
+
 // Start up a waveform on a pin, or change the current one.  Will change to the new
 // waveform smoothly on next low->high transition.  For immediate change, stopWaveform()
 // first, then it will immediately begin.
@@ -402,14 +551,28 @@ int startWaveformClockCycles_weak(uint8_t pin, uint32_t timeHighCycles, uint32_t
 }
 static int startWaveformClockCycles_bound(uint8_t pin, uint32_t timeHighCycles, uint32_t timeLowCycles, uint32_t runTimeCycles, int8_t alignPhase, uint32_t phaseOffsetUS, bool autoPwm) __attribute__((weakref("startWaveformClockCycles_weak")));
 int startWaveformClockCycles(uint8_t pin, uint32_t timeHighCycles, uint32_t timeLowCycles, uint32_t runTimeCycles, int8_t alignPhase, uint32_t phaseOffsetUS, bool autoPwm) {
-  return startWaveformClockCycles_bound(pin, timeHighCycles, timeLowCycles, runTimeCycles, alignPhase, phaseOffsetUS, autoPwm);
+  if (pin > 16) {
+    return false;
+  }
+  // Constant levels don't take edges
+  uint32_t period = timeHighCycles + timeLowCycles;
+  uint32_t edges = (timeHighCycles && timeLowCycles) ? 2 * (microsecondsToClockCycles(1000000ULL) / period) : 0;
+  WaveformLoad previous = _waveformLoad[pin];
+  if (!_admitLoad(pin, edges, runTimeCycles / clockCyclesPerMicrosecond())) {
+    return false; // Over the timer1 budget
+  }
+  int started = startWaveformClockCycles_bound(pin, timeHighCycles, timeLowCycles, runTimeCycles, alignPhase, phaseOffsetUS, autoPwm);
+  if (!started) {
+    _waveformLoad[pin] = previous;
+  }
+  return started;
 }
 
 
 // This version falls-thru to the proper startWaveformClockCycles call and is invariant across waveform generators
 int startWaveform(uint8_t pin, uint32_t timeHighUS, uint32_t timeLowUS, uint32_t runTimeUS,
                   int8_t alignPhase, uint32_t phaseOffsetUS, bool autoPwm) {
-  return startWaveformClockCycles_bound(pin,
+  return startWaveformClockCycles(pin,
     microsecondsToClockCycles(timeHighUS), microsecondsToClockCycles(timeLowUS),
     microsecondsToClockCycles(runTimeUS), alignPhase, microsecondsToClockCycles(phaseOffsetUS), autoPwm);
 }
@@ -426,9 +589,77 @@ void setTimer1Callback_weak(uint32_t (*fn)()) {
 }
 static void setTimer1Callback_bound(uint32_t (*fn)()) __attribute__((weakref("setTimer1Callback_weak")));
 void setTimer1Callback(uint32_t (*fn)()) {
+  if (!fn) {
+    _waveformLoad[LOAD_CALLBACK].edges = 0;
+  }
   setTimer1Callback_bound(fn);
 }
 
+bool setTimer1CallbackLoad(uint32_t edgesPerSecond) {
+  return _admitLoad(LOAD_CALLBACK, edgesPerSecond);
+}
+
+// NMI statistics, counted by whichever waveform generator is linked in
+bool _waveformStatsEnabled = false;
+static waveform_stats_t _waveformStats;
+static uint32_t _waveformStatsStart;
+
+void setWaveformStats(bool enable) {
+  _waveformStatsEnabled = false;
+  MEMBARRIER();
+  if (enable) {
+    memset(&_waveformStats, 0, sizeof(_waveformStats));
+    _waveformStatsStart = micros();
+    MEMBARRIER();
+    _waveformStatsEnabled = true;
+  }
+}
+
+void getWaveformStats(waveform_stats_t* stats) {
+  // The NMI can't be masked, copy again if one came in meanwhile
+  uint32_t calls;
+  do {
+    calls = _waveformStats.calls;
+    MEMBARRIER();
+    *stats = _waveformStats;
+    MEMBARRIER();
+  } while (calls != _waveformStats.calls);
+  stats->elapsedUs = micros() - _waveformStatsStart;
+}
+
+void setWaveformBudget(uint8_t percent) {
+  _waveformBudget = percent;
+}
+
+float getWaveformLoad(uint32_t edgesPerSecond) {
+  uint64_t edges = (uint64_t)_waveformLoadEdges() + edgesPerSecond;
+  // What the NMI actually spent per edge, once it counted enough of them
+  float ccys = WAVEFORM_EDGE_CYCLES;
+  if (_waveformStatsEnabled && _waveformStats.edges >= 1000) {
+    ccys = (float)_waveformStats.cycles / _waveformStats.edges;
+  }
+  return 100.0f * edges * ccys / microsecondsToClockCycles(1000000UL);
+}
+
+IRAM_ATTR void _waveformStatsEdge(uint32_t lateCcys) {
+  _waveformStats.edges++;
+  if (lateCcys > microsecondsToClockCycles(WAVEFORM_LATE_US)) {
+    _waveformStats.lateEdges++;
+  }
+  if (lateCcys > _waveformStats.maxLateCycles) {
+    _waveformStats.maxLateCycles = lateCcys;
+  }
+}
+
+IRAM_ATTR void _waveformStatsIRQ(uint32_t startCcy) {
+  uint32_t ccys = ESP.getCycleCount() - startCcy;
+  _waveformStats.calls++;
+  _waveformStats.cycles += ccys;
+  if (ccys > _waveformStats.maxCycles) {
+    _waveformStats.maxCycles = ccys;
+  }
+}
+
 // Stops a waveform on a pin
 extern int stopWaveform_weak(uint8_t pin) __attribute__((weak));
 IRAM_ATTR int stopWaveform_weak(uint8_t pin) {
@@ -456,6 +687,9 @@ IRAM_ATTR int stopWaveform_weak(uint8_t pin) {
 }
 static int stopWaveform_bound(uint8_t pin) __attribute__((weakref("stopWaveform_weak")));
 IRAM_ATTR int stopWaveform(uint8_t pin) {
+  if (pin <= 16) {
+    _waveformLoad[pin].edges = 0;
+  }
   return stopWaveform_bound(pin);
 }
 
@@ -501,6 +735,7 @@ static IRAM_ATTR void timer1Interrupt() {
   // Flag if the core is at 160 MHz, for use by adjust()
   bool turbo = (*(uint32_t*)0x3FF00014) & 1 ? true : false;
 
+  uint32_t isrStartCycle = GetCycleCountIRQ();
   uint32_t nextEventCycle = GetCycleCountIRQ() + microsecondsToClockCycles(MAXIRQUS);
   uint32_t timeoutCycle = GetCycleCountIRQ() + microsecondsToClockCycles(14);
 
@@ -534,28 +769,30 @@ static IRAM_ATTR void timer1Interrupt() {
         do {
             cyclesToGo = pwmState.nextServiceCycle - GetCycleCountIRQ();
             if (cyclesToGo < 0) {
+                if (_waveformStatsEnabled) {
+                  _waveformStatsEdge(-cyclesToGo);
+                }
                 if (pwmState.idx == pwmState.cnt) { // Start of pulses, possibly copy new
                   if (pwmState.pwmUpdate) {
                     // Do the memory copy from temp to global and clear mailbox
                     pwmState = *(PWMState*)pwmState.pwmUpdate;
                   }
-                  GPOS = pwmState.mask; // Set all active pins high
-                  if (pwmState.mask & (1<<16)) {
+                  uint32_t high = pwmState.start & pwmState.mask;
+                  GPOS = high; // Set the starting pins high
+                  if (high & (1<<16)) {
                     GP16O = 1;
                   }
                   pwmState.idx = 0;
                 } else {
-                  do {
-                    // Drop the pin at this edge
-                    if (pwmState.mask & (1<<pwmState.pin[pwmState.idx])) {
-                      GPOC = 1<<pwmState.pin[pwmState.idx];
-                      if (pwmState.pin[pwmState.idx] == 16) {
-                        GP16O = 0;
-                      }
-                    }
-                    pwmState.idx++;
-                    // Any other pins at this same PWM value will have delta==0, drop them too.
-                  } while (pwmState.delta[pwmState.idx] == 0);
+                  // Drop and raise the active pins of this edge
+                  uint32_t low = pwmState.clr[pwmState.idx] & pwmState.mask;
+                  uint32_t high = pwmState.set[pwmState.idx] & pwmState.mask;
+                  GPOC = low;
+                  GPOS = high;
+                  if ((low | high) & (1<<16)) {
+                    GP16O = (high & (1<<16)) ? 1 : 0;
+                  }
+                  pwmState.idx++;
                 }
                 // Preserve duty cycle over PWM period by using now+xxx instead of += delta
                 cyclesToGo = adjust(pwmState.delta[pwmState.idx]);
@@ -593,6 +830,9 @@ static IRAM_ATTR void timer1Interrupt() {
         // Check for toggles
         int32_t cyclesToGo = wave->nextServiceCycle - now;
         if (cyclesToGo < 0) {
+          if (_waveformStatsEnabled) {
+            _waveformStatsEdge(-cyclesToGo);
+          }
           uint32_t nextEdgeCycles;
           uint32_t desired = 0;
           uint32_t *timeToUpdate;
@@ -662,6 +902,10 @@ static IRAM_ATTR void timer1Interrupt() {
 
   // Do it here instead of global function to save time and because we know it's edge-IRQ
   T1L = nextEventCycles >> (turbo ? 1 : 0);
+
+  if (_waveformStatsEnabled) {
+    _waveformStatsIRQ(isrStartCycle);
+  }
 }
 
 };
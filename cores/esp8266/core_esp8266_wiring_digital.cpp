@@ -130,21 +130,36 @@ typedef struct {
 
 static interrupt_handler_t interrupt_handlers[16] = { {0, 0, 0, 0}, };
 static uint32_t interrupt_reg = 0;
+// Pins attached with attachInterruptFast(), their handlers are called
+// first, directly from the GPIO interrupt
+static uint32_t interrupt_fast_reg = 0;
+static interruptLatencyHook_t interrupt_latency_hook = nullptr;
 
 void IRAM_ATTR interrupt_handler(void *arg, void *frame)
 {
   (void) arg;
   (void) frame;
+  uint32_t entryCcy = esp_get_cycle_count();
   uint32_t status = GPIE;
   GPIEC = status;//clear them interrupts
   uint32_t levels = GPI;
   if(status == 0 || interrupt_reg == 0) return;
   ETS_GPIO_INTR_DISABLE();
-  int i = 0;
   uint32_t changedbits = status & interrupt_reg;
+  uint32_t fastbits = changedbits & interrupt_fast_reg;
+  changedbits &= ~fastbits;
+  while(fastbits){
+    int i = __builtin_ctz(fastbits);
+    fastbits &= fastbits - 1;
+    interrupt_handler_t *handler = &interrupt_handlers[i];
+    if (interrupt_latency_hook) {
+      interrupt_latency_hook(i, esp_get_cycle_count() - entryCcy);
+    }
+    ((voidFuncPtrArg)handler->fn)(handler->arg);
+  }
   while(changedbits){
-    while(!(changedbits & (1 << i))) i++;
-    changedbits &= ~(1 << i);
+    int i = __builtin_ctz(changedbits);
+    changedbits &= changedbits - 1;
     interrupt_handler_t *handler = &interrupt_handlers[i];
     if (handler->fn && 
         (handler->mode == CHANGE || 
@@ -162,6 +177,10 @@ void IRAM_ATTR interrupt_handler(void *arg, void *frame)
                   localArg->interruptInfo->micro = micros();
               }
           }
+          if (interrupt_latency_hook)
+          {
+              interrupt_latency_hook(i, esp_get_cycle_count() - entryCcy);
+          }
           if (handler->arg)
           {
               ((voidFuncPtrArg)handler->fn)(handler->arg);
@@ -190,7 +209,7 @@ static void set_interrupt_handlers(uint8_t pin, voidFuncPtr userFunc, void* arg,
   handler->functional = functional;
 }
 
-extern void __attachInterruptFunctionalArg(uint8_t pin, voidFuncPtrArg userFunc, void* arg, int mode, bool functional)
+static void attach_interrupt(uint8_t pin, voidFuncPtrArg userFunc, void* arg, int mode, bool functional, bool fast)
 {
   // #5780
   // https://github.com/esp8266/esp8266-wiki/wiki/Memory-Map
@@ -205,6 +224,11 @@ extern void __attachInterruptFunctionalArg(uint8_t pin, voidFuncPtrArg userFunc,
     ETS_GPIO_INTR_DISABLE();
     set_interrupt_handlers(pin, (voidFuncPtr)userFunc, arg, mode, functional);
     interrupt_reg |= (1 << pin);
+    if (fast) {
+      interrupt_fast_reg |= (1 << pin);
+    } else {
+      interrupt_fast_reg &= ~(1 << pin);
+    }
     GPC(pin) &= ~(0xF << GPCI);//INT mode disabled
     GPIEC = (1 << pin); //Clear Interrupt for this pin
     GPC(pin) |= ((mode & 0xF) << GPCI);//INT mode "mode"
@@ -213,6 +237,21 @@ extern void __attachInterruptFunctionalArg(uint8_t pin, voidFuncPtrArg userFunc,
   }
 }
 
+extern void __attachInterruptFunctionalArg(uint8_t pin, voidFuncPtrArg userFunc, void* arg, int mode, bool functional)
+{
+    attach_interrupt(pin, userFunc, arg, mode, functional, false);
+}
+
+extern void attachInterruptFast(uint8_t pin, voidFuncPtrArg userFunc, void* arg, int mode)
+{
+    attach_interrupt(pin, userFunc, arg, mode, false, true);
+}
+
+extern void setInterruptLatencyHook(interruptLatencyHook_t hook)
+{
+    interrupt_latency_hook = hook;
+}
+
 extern void __attachInterruptArg(uint8_t pin, voidFuncPtrArg userFunc, void* arg, int mode)
 {
     __attachInterruptFunctionalArg(pin, userFunc, arg, mode, false);
@@ -225,6 +264,7 @@ extern void IRAM_ATTR __detachInterrupt(uint8_t pin) {
         GPC(pin) &= ~(0xF << GPCI);//INT mode disabled
         GPIEC = (1 << pin); //Clear Interrupt for this pin
         interrupt_reg &= ~(1 << pin);
+        interrupt_fast_reg &= ~(1 << pin);
 		set_interrupt_handlers(pin, nullptr, nullptr, 0, false);
         if (interrupt_reg)
         {
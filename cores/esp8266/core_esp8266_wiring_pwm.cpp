@@ -83,6 +83,53 @@ extern void __analogWriteMode(uint8_t pin, int val, bool openDrain) {
   }
 }
 
+extern void __analogWriteMulti(const uint8_t* pins, const int* vals, size_t count) {
+  // One entry per pin, the last value given for a pin wins
+  uint32_t duty[17];
+  uint32_t batch = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint8_t pin = pins[i];
+    if (pin > 16) {
+      continue;
+    }
+    int val = vals[i];
+    if (val < 0) {
+      val = 0;
+    } else if (val > analogScale) {
+      val = analogScale;
+    }
+    duty[pin] = val;
+    batch |= 1UL << pin;
+  }
+
+  uint8_t batchPins[17];
+  uint32_t batchVals[17];
+  size_t n = 0;
+  for (uint8_t pin = 0; pin <= 16; pin++) {
+    if (batch & 1UL << pin) {
+      if (!(analogMap & 1UL << pin)) {
+        pinMode(pin, OUTPUT);
+      }
+      batchPins[n] = pin;
+      batchVals[n] = duty[pin];
+      n++;
+    }
+  }
+
+  if (_setPWMMulti(batchPins, batchVals, n, analogScale)) {
+    analogMap |= batch;
+  } else {
+    // Not enough PWM slots, or the phase locked generator is used: one pin at a time
+    for (size_t i = 0; i < n; i++) {
+      analogWriteMode(batchPins[i], batchVals[i], false);
+    }
+  }
+}
+
+extern void __analogWriteStagger(bool stagger) {
+  _setPWMStagger(stagger);
+}
+
 extern void __analogWriteRange(uint32_t range) {
   if ((range >= 15) && (range <= 65535)) {
     analogScale = range;
@@ -97,7 +144,9 @@ extern void __analogWriteResolution(int res) {
 
 extern void analogWrite(uint8_t pin, int val) __attribute__((weak, alias("__analogWrite")));
 extern void analogWriteMode(uint8_t pin, int val, bool openDrain) __attribute__((weak, alias("__analogWriteMode")));
+extern void analogWriteMulti(const uint8_t* pins, const int* vals, size_t count) __attribute__((weak, alias("__analogWriteMulti")));
 extern void analogWriteFreq(uint32_t freq) __attribute__((weak, alias("__analogWriteFreq")));
+extern void analogWriteStagger(bool stagger) __attribute__((weak, alias("__analogWriteStagger")));
 extern void analogWriteRange(uint32_t range) __attribute__((weak, alias("__analogWriteRange")));
 extern void analogWriteResolution(int res) __attribute__((weak, alias("__analogWriteResolution")));
 
@@ -24,15 +24,104 @@ bool sntp_set_timezone_in_seconds(int32_t timezone);
 void disable_extra4k_at_link_time (void) __attribute__((noinline));
 void enable_wifi_enterprise_patch(void) __attribute__((noinline));
 void __disableWiFiAtBootTime (void) __attribute__((noinline));
+void __wifiAssociateAtBootTime (void) __attribute__((noinline));
 void __real_system_restart_local() __attribute__((noreturn));
 
 uint32_t sqrt32(uint32_t n);
 
+// RTC user memory blocks (4 bytes, the offsets of ESP.rtcUserMemoryRead()
+// and ESP.rtcUserMemoryWrite()) used by the core and the libraries, apart
+// so that they can all be used at once.  Sketches keep below
+// RTC_USER_BLOCKS_RESERVED when these features are used.
+//   122..125  last AP of the WiFi fast connect (WIFI_FAST_CONNECT_RTC_OFFSET)
+//   126..127  RF_CAL_CACHE() state
+#define RTC_USER_BLOCK_FAST_CONNECT 122
+#define RTC_USER_BLOCK_RF_CAL       126
+#define RTC_USER_BLOCKS_RESERVED    122
+
+// Stack profiling of each loop() iteration, see ESP.setContStackProfiling()
+void cont_stack_profiling(bool enable);
+uint32_t cont_stack_profile_last(void);
+uint32_t cont_stack_profile_min(void);
+
+// Stretches of CONT (setup(), loop() and the code they call) running
+// without yielding, which the soft WDT resets after about 3s.  A stretch
+// starts where CONT was resumed, or at loop() start, and ends where it
+// suspends (yield(), delay()...) or at loop() return.
+typedef struct {
+    uint32_t max_us;        // longest stretch
+    uint32_t max_start_pc;  // and the code addresses where it started and ended,
+    uint32_t max_end_pc;    // look them up with addr2line
+    uint32_t over_count;    // stretches over the yield_gap_warning() threshold
+} yield_gap_stats_t;
+
+// Fill stats, then clear them when reset
+void yield_gap_stats(yield_gap_stats_t* stats, bool reset);
+
+// warning(gap_us, pc) is called once per stretch longer than threshold_us,
+// from CONT: from optimistic_yield(), which the core calls in its busy
+// loops, while the stretch lasts, or else when it ends.  0 disables.
+typedef void (*yield_gap_warning_t)(uint32_t gap_us, uint32_t pc);
+void yield_gap_warning(uint32_t threshold_us, yield_gap_warning_t warning);
+
+// Boot timeline: the CPU cycle count, counted from reset, at which each
+// stage of the boot was reached.  See ESP.printBootTimeline().
+typedef enum {
+    BOOT_STAGE_APP_ENTRY,       // ROM boot loader and eboot are done
+    BOOT_STAGE_PHY_INIT,        // the SDK reads the PHY init data
+    BOOT_STAGE_RF_PRE_INIT,     // user_rf_pre_init()
+    BOOT_STAGE_USER_INIT,       // SDK started, user_init() called
+    BOOT_STAGE_PREINIT,         // hardware and core init done, preinit() called
+    BOOT_STAGE_INIT_DONE,       // system_init_done_cb() called
+    BOOT_STAGE_CTORS_DONE,      // C++ global constructors done
+    BOOT_STAGE_SETUP,           // setup() called
+    BOOT_STAGE_LOOP,            // setup() returned, first loop() called
+    BOOT_STAGE_LOOP_END,        // first loop() returned
+    BOOT_STAGE_COUNT
+} boot_stage_t;
+
+void boot_timeline_mark(boot_stage_t stage);
+uint32_t boot_timeline_cycles(boot_stage_t stage); // 0 if not reached yet
+
+// RF calibration cache, see RF_CAL_CACHE().  check() is called once the
+// SDK is started, invalidate() makes the next boot fully calibrate.
+void rf_cal_cache_check(void);
+void rf_cal_cache_invalidate(void);
+
 #ifdef __cplusplus
 }
 
 uint32_t crc32(const void* data, size_t length, uint32_t crc = 0xffffffff);
 
+// crc32() of data given in parts, as it is read or received:
+//    Crc32 crc;
+//    while (...) crc.add(buf, len);
+//    crc.value() == crc32(all, allLen)
+class Crc32
+{
+public:
+    explicit Crc32(uint32_t crc = 0xffffffff) : _crc(crc) { }
+
+    Crc32& add(const void* data, size_t length)
+    {
+        _crc = crc32(data, length, _crc);
+        return *this;
+    }
+
+    uint32_t value() const
+    {
+        return _crc;
+    }
+
+    void reset(uint32_t crc = 0xffffffff)
+    {
+        _crc = crc;
+    }
+
+private:
+    uint32_t _crc;
+};
+
 #include <functional>
 
 using BoolCB = std::function<void(bool)>;
@@ -22,22 +22,104 @@
 #include "coredecls.h"
 #include "pgmspace.h"
 
+// Footprint / speed trade-off, all giving the same CRC (polynomial
+// 0x04c11db7, most significant bit first, no final xor):
+//   0: bit by bit, no table
+//   1: a byte at a time, 1KB table in flash
+//   4: four bytes at a time ("slice-by-4"), 4KB table in flash
+#ifndef CRC32_SLICES
+#define CRC32_SLICES 4
+#endif
+
+#if CRC32_SLICES != 0 && CRC32_SLICES != 1 && CRC32_SLICES != 4
+#error CRC32_SLICES must be 0, 1 or 4
+#endif
+
+namespace
+{
+
+constexpr uint32_t polynomial = 0x04c11db7;
+
+#if CRC32_SLICES
+
+struct Crc32Table
+{
+    // slice[k][b] is the CRC of byte b followed by k zero bytes
+    uint32_t slice[CRC32_SLICES][256];
+
+    constexpr Crc32Table() : slice()
+    {
+        for (uint32_t b = 0; b < 256; ++b)
+        {
+            uint32_t crc = b << 24;
+            for (int i = 0; i < 8; ++i)
+            {
+                crc = (crc << 1) ^ ((crc & 0x80000000) ? polynomial : 0);
+            }
+            slice[0][b] = crc;
+        }
+        for (int k = 1; k < CRC32_SLICES; ++k)
+        {
+            for (uint32_t b = 0; b < 256; ++b)
+            {
+                uint32_t crc = slice[k - 1][b];
+                slice[k][b] = (crc << 8) ^ slice[0][crc >> 24];
+            }
+        }
+    }
+};
+
+constexpr Crc32Table table PROGMEM;
+
+inline uint32_t crc32_byte(uint32_t crc, uint8_t c)
+{
+    return (crc << 8) ^ pgm_read_dword(&table.slice[0][(crc >> 24) ^ c]);
+}
+
+#else
+
+inline uint32_t crc32_byte(uint32_t crc, uint8_t c)
+{
+    crc ^= (uint32_t)c << 24;
+    for (int i = 0; i < 8; ++i)
+    {
+        crc = (crc << 1) ^ ((crc & 0x80000000) ? polynomial : 0);
+    }
+    return crc;
+}
+
+#endif
+
+} // namespace
+
 // moved from core_esp8266_eboot_command.cpp
+// data may be in flash
 uint32_t crc32 (const void* data, size_t length, uint32_t crc)
 {
     const uint8_t* ldata = (const uint8_t*)data;
+
+#if CRC32_SLICES == 4
+    // bytes up to the first aligned word
+    while (length && ((uintptr_t)ldata & 3))
+    {
+        crc = crc32_byte(crc, pgm_read_byte(ldata++));
+        --length;
+    }
+    // then a word read, four table lookups and no shift per bit
+    for (; length >= 4; length -= 4, ldata += 4)
+    {
+        uint32_t word = pgm_read_dword(ldata);
+        crc ^= __builtin_bswap32(word);
+        crc = pgm_read_dword(&table.slice[3][crc >> 24])
+            ^ pgm_read_dword(&table.slice[2][(crc >> 16) & 0xff])
+            ^ pgm_read_dword(&table.slice[1][(crc >> 8) & 0xff])
+            ^ pgm_read_dword(&table.slice[0][crc & 0xff]);
+    }
+#endif
+
     while (length--)
     {
-        uint8_t c = pgm_read_byte(ldata++);
-        for (uint32_t i = 0x80; i > 0; i >>= 1)
-        {
-            bool bit = crc & 0x80000000;
-            if (c & i)
-                bit = !bit;
-            crc <<= 1;
-            if (bit)
-                crc ^= 0x04c11db7;
-        }
+        crc = crc32_byte(crc, pgm_read_byte(ldata++));
     }
     return crc;
 }
@@ -40,6 +40,13 @@ int32_t flash_hal_read(uint32_t addr, uint32_t size, uint8_t *dst) {
     }
 }
 
+const uint8_t *flash_hal_mapped(uint32_t addr, uint32_t size) {
+    if ((addr >= FLASH_HAL_MAPPED_SIZE) || (size > FLASH_HAL_MAPPED_SIZE - addr)) {
+        return nullptr;
+    }
+    return reinterpret_cast<const uint8_t *>(0x40200000 + addr);
+}
+
 int32_t flash_hal_write(uint32_t addr, uint32_t size, const uint8_t *src) {
     optimistic_yield(10000);
 
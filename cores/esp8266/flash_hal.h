@@ -25,6 +25,9 @@
  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -91,8 +94,53 @@ extern int32_t flash_hal_write(uint32_t addr, uint32_t size, const uint8_t *src)
 extern int32_t flash_hal_erase(uint32_t addr, uint32_t size);
 extern int32_t flash_hal_read(uint32_t addr, uint32_t size, uint8_t *dst);
 
+// The cache maps the first MB of flash at 0x40200000, beyond it flash can
+// only be accessed through the functions above
+#define FLASH_HAL_MAPPED_SIZE (0x100000)
+
+// Address where [addr, addr + size) can be read in place, like PROGMEM
+// (memcpy_P, pgm_read_*), or NULL when it is not mapped
+extern const uint8_t *flash_hal_mapped(uint32_t addr, uint32_t size);
+
+// Flash operation statistics, built with -DFLASH_STATS=1: count, bytes,
+// errors and time of the reads, writes and sector erases done through
+// ESP.flashRead/flashWrite/flashEraseSector, flash_hal included.  Erases
+// divided by the sectors of a region tell its wear.  Without FLASH_STATS the
+// functions below are empty and flash_stats_get() returns false.
+#ifndef FLASH_STATS
+#define FLASH_STATS 0
+#endif
+
+enum {
+  FLASH_STATS_READ,
+  FLASH_STATS_WRITE,
+  FLASH_STATS_ERASE,
+  FLASH_STATS_OP_COUNT
+};
+
+// Latency histogram: bin 0 counts operations under 16us, bin i those under
+// 16us << i, the last one all the longer ones (~40ms sector erases).
+#define FLASH_STATS_BINS (12)
+
+typedef struct {
+  uint32_t count;
+  uint32_t errors;
+  uint64_t bytes;
+  uint64_t us;      // total time
+  uint32_t max_us;
+  uint32_t histogram[FLASH_STATS_BINS];
+} flash_stats_t;
+
+extern void flash_stats_record(int op, uint32_t bytes, uint32_t us, bool ok);
+extern bool flash_stats_get(int op, flash_stats_t *stats);
+extern void flash_stats_reset(void);
+
 #ifdef __cplusplus
 } // extern "C"
+
+class Print;
+// One line per operation, then its histogram
+void flash_stats_print(Print& out);
 #endif
 
 #endif // !defined(flash_hal_h)
@@ -33,7 +33,7 @@ extern "C" {
 #undef realloc
 #undef free
 
-#elif defined(DEBUG_ESP_OOM) || defined(UMM_INTEGRITY_CHECK)
+#elif defined(DEBUG_ESP_OOM) || defined(UMM_INTEGRITY_CHECK) || defined(UMM_HEAP_TRACE)
 #define UMM_MALLOC(s)           umm_malloc(s)
 #define UMM_CALLOC(n,s)         umm_calloc(n,s)
 #define UMM_REALLOC_FL(p,s,f,l) umm_realloc(p,s)
@@ -220,7 +220,99 @@ void IRAM_ATTR print_oom_size(size_t size)
 #define OOM_CHECK__PRINT_LOC(p, s, f, l)
 #endif
 
-#if defined(DEBUG_ESP_OOM) || defined(UMM_POISON_CHECK) || defined(UMM_POISON_CHECK_LITE) || defined(UMM_INTEGRITY_CHECK)
+#if defined(UMM_HEAP_TRACE)
+/*
+  Allocation timeline, one entry per *alloc/free call. Entries are written
+  with interrupts disabled for a few instructions only, the buffer is a plain
+  ring overwriting the oldest entries.
+*/
+static UMM_HEAP_TRACE_ENTRY heap_trace[UMM_HEAP_TRACE_ENTRIES];
+static size_t heap_trace_next = 0;
+static size_t heap_trace_count = 0;
+static bool heap_trace_enabled = true;
+
+static void IRAM_ATTR heap_trace_record(uint8_t op, size_t size, const void *caller, const void *ptr)
+{
+    if (!heap_trace_enabled) {
+        return;
+    }
+    uint32_t now = system_get_time();
+    uint32_t saved_ps = xt_rsil(15);
+    UMM_HEAP_TRACE_ENTRY *entry = &heap_trace[heap_trace_next];
+    entry->time_us = now;
+    entry->caller = caller;
+    entry->ptr = ptr;
+    entry->size = (size > 0xFFFFFFu) ? 0xFFFFFFu : size;
+    entry->op = op;
+    if (++heap_trace_next >= UMM_HEAP_TRACE_ENTRIES) {
+        heap_trace_next = 0;
+    }
+    if (heap_trace_count < UMM_HEAP_TRACE_ENTRIES) {
+        ++heap_trace_count;
+    }
+    xt_wsr_ps(saved_ps);
+}
+
+void umm_heap_trace_enable(bool enable)
+{
+    heap_trace_enabled = enable;
+}
+
+size_t umm_heap_trace_get(UMM_HEAP_TRACE_ENTRY *dst, size_t count)
+{
+    uint32_t saved_ps = xt_rsil(15);
+    if (count > heap_trace_count) {
+        count = heap_trace_count;
+    }
+    // most recent <count> entries, oldest first
+    size_t index = (heap_trace_next + UMM_HEAP_TRACE_ENTRIES - count) % UMM_HEAP_TRACE_ENTRIES;
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = heap_trace[index];
+        if (++index >= UMM_HEAP_TRACE_ENTRIES) {
+            index = 0;
+        }
+    }
+    xt_wsr_ps(saved_ps);
+    return count;
+}
+
+void umm_heap_trace_print(void (*putc)(char))
+{
+    static const char op_names[] PROGMEM = "?MCRF";
+    bool enabled = heap_trace_enabled;
+    heap_trace_enabled = false;
+    // read in place, recording is paused and ISRs can't wrap the ring
+    size_t count = heap_trace_count;
+    size_t index = (heap_trace_next + UMM_HEAP_TRACE_ENTRIES - count) % UMM_HEAP_TRACE_ENTRIES;
+    for (size_t i = 0; i < count; i++) {
+        const UMM_HEAP_TRACE_ENTRY *entry = &heap_trace[index];
+        char line[48];
+        snprintf_P(line, sizeof(line), PSTR("%10u %c %5u %08x %08x\n"), entry->time_us,
+            (char)pgm_read_byte(&op_names[(entry->op < 5) ? entry->op : 0]),
+            (unsigned)entry->size, (uint32_t)entry->caller, (uint32_t)entry->ptr);
+        for (const char *c = line; *c; c++) {
+            putc(*c);
+        }
+        if (++index >= UMM_HEAP_TRACE_ENTRIES) {
+            index = 0;
+        }
+    }
+    heap_trace_enabled = enabled;
+}
+
+void* IRAM_ATTR umm_heap_trace_new(size_t size, const void *caller)
+{
+    void* ret = UMM_MALLOC(size);
+    heap_trace_record(UMM_HEAP_TRACE_MALLOC, size, caller, ret);
+    return ret;
+}
+
+#define HEAP_TRACE(op, s, p) heap_trace_record(op, s, __builtin_return_address(0), p)
+#else
+#define HEAP_TRACE(op, s, p) do {} while (0)
+#endif
+
+#if defined(DEBUG_ESP_OOM) || defined(UMM_POISON_CHECK) || defined(UMM_POISON_CHECK_LITE) || defined(UMM_INTEGRITY_CHECK) || defined(UMM_HEAP_TRACE)
 /*
   The thinking behind the ordering of Integrity Check, Full Poison Check, and
   the specific *alloc function.
@@ -244,6 +336,7 @@ void* IRAM_ATTR malloc(size_t size)
     INTEGRITY_CHECK__ABORT();
     POISON_CHECK__ABORT();
     void* ret = UMM_MALLOC(size);
+    HEAP_TRACE(UMM_HEAP_TRACE_MALLOC, size, ret);
     PTR_CHECK__LOG_LAST_FAIL(ret, size);
     OOM_CHECK__PRINT_OOM(ret, size);
     return ret;
@@ -254,9 +347,10 @@ void* IRAM_ATTR calloc(size_t count, size_t size)
     INTEGRITY_CHECK__ABORT();
     POISON_CHECK__ABORT();
     void* ret = UMM_CALLOC(count, size);
-    #if defined(DEBUG_ESP_OOM)
+    #if defined(DEBUG_ESP_OOM) || defined(UMM_HEAP_TRACE)
     size_t total_size = umm_umul_sat(count, size);// For logging purposes
     #endif
+    HEAP_TRACE(UMM_HEAP_TRACE_CALLOC, total_size, ret);
     PTR_CHECK__LOG_LAST_FAIL(ret, total_size);
     OOM_CHECK__PRINT_OOM(ret, total_size);
     return ret;
@@ -266,6 +360,7 @@ void* IRAM_ATTR realloc(void* ptr, size_t size)
 {
     INTEGRITY_CHECK__ABORT();
     void* ret = UMM_REALLOC_FL(ptr, size, NULL, 0);
+    HEAP_TRACE(UMM_HEAP_TRACE_REALLOC, size, ret);
     POISON_CHECK__ABORT();
     PTR_CHECK__LOG_LAST_FAIL(ret, size);
     OOM_CHECK__PRINT_OOM(ret, size);
@@ -276,6 +371,7 @@ void IRAM_ATTR free(void* p)
 {
     INTEGRITY_CHECK__ABORT();
     UMM_FREE_FL(p, NULL, 0);
+    HEAP_TRACE(UMM_HEAP_TRACE_FREE, 0, p);
     POISON_CHECK__ABORT();
 }
 #endif
@@ -286,6 +382,7 @@ void* IRAM_ATTR heap_pvPortMalloc(size_t size, const char* file, int line)
     INTEGRITY_CHECK__PANIC_FL(file, line);
     POISON_CHECK__PANIC_FL(file, line);
     void* ret = UMM_MALLOC(size);
+    HEAP_TRACE(UMM_HEAP_TRACE_MALLOC, size, ret);
     PTR_CHECK__LOG_LAST_FAIL_FL(ret, size, file, line);
     OOM_CHECK__PRINT_LOC(ret, size, file, line);
     return ret;
@@ -297,9 +394,10 @@ void* IRAM_ATTR heap_pvPortCalloc(size_t count, size_t size, const char* file, i
     INTEGRITY_CHECK__PANIC_FL(file, line);
     POISON_CHECK__PANIC_FL(file, line);
     void* ret = UMM_CALLOC(count, size);
-    #if defined(DEBUG_ESP_OOM)
+    #if defined(DEBUG_ESP_OOM) || defined(UMM_HEAP_TRACE)
     size_t total_size = umm_umul_sat(count, size);
     #endif
+    HEAP_TRACE(UMM_HEAP_TRACE_CALLOC, total_size, ret);
     PTR_CHECK__LOG_LAST_FAIL_FL(ret, total_size, file, line);
     OOM_CHECK__PRINT_LOC(ret, total_size, file, line);
     return ret;
@@ -310,6 +408,7 @@ void* IRAM_ATTR heap_pvPortRealloc(void *ptr, size_t size, const char* file, int
 {
     INTEGRITY_CHECK__PANIC_FL(file, line);
     void* ret = UMM_REALLOC_FL(ptr, size, file, line);
+    HEAP_TRACE(UMM_HEAP_TRACE_REALLOC, size, ret);
     POISON_CHECK__PANIC_FL(file, line);
     PTR_CHECK__LOG_LAST_FAIL_FL(ret, size, file, line);
     OOM_CHECK__PRINT_LOC(ret, size, file, line);
@@ -322,6 +421,7 @@ void* IRAM_ATTR heap_pvPortZalloc(size_t size, const char* file, int line)
     INTEGRITY_CHECK__PANIC_FL(file, line);
     POISON_CHECK__PANIC_FL(file, line);
     void* ret = UMM_CALLOC(1, size);
+    HEAP_TRACE(UMM_HEAP_TRACE_CALLOC, size, ret);
     PTR_CHECK__LOG_LAST_FAIL_FL(ret, size, file, line);
     OOM_CHECK__PRINT_LOC(ret, size, file, line);
     return ret;
@@ -332,6 +432,7 @@ void IRAM_ATTR heap_vPortFree(void *ptr, const char* file, int line)
 {
     INTEGRITY_CHECK__PANIC_FL(file, line);
     UMM_FREE_FL(ptr, file, line);
+    HEAP_TRACE(UMM_HEAP_TRACE_FREE, 0, ptr);
     POISON_CHECK__PANIC_FL(file, line);
 }
 
@@ -379,7 +480,7 @@ void* IRAM_ATTR pvPortZalloc(size_t size, const char* file, int line)
 
 void IRAM_ATTR vPortFree(void *ptr, const char* file, int line)
 {
-#if defined(DEBUG_ESP_OOM) || defined(UMM_POISON_CHECK) || defined(UMM_POISON_CHECK_LITE) || defined(UMM_INTEGRITY_CHECK)
+#if defined(DEBUG_ESP_OOM) || defined(UMM_POISON_CHECK) || defined(UMM_POISON_CHECK_LITE) || defined(UMM_INTEGRITY_CHECK) || defined(UMM_HEAP_TRACE)
     // This is only needed for debug checks to ensure they are performed in
     // correct context. umm_malloc free internally determines the correct heap.
     HeapSelectDram ephemeral;
@@ -413,6 +413,9 @@ static_assert(sizeof(hwdt_info_t) == sizeof(LOCAL_HWDT_INFO_T), "Local and inclu
 // Map out who will live where.
 #define ROM_STACK_A16_SZ   (MK_ALIGN16_SZ(DEBUG_ESP_HWDT_ROM_STACK_SIZE))
 #define CONT_STACK_A16_SZ  (MK_ALIGN16_SZ(sizeof(cont_t)))
+#if CONT_STACKSIZE > 4096
+#error "The SYS stack has no room for a CONT_STACKSIZE above 4096"
+#endif
 /*
  * For WPS support, cont stack comes out of the user's heap address space.
  * The NONOS-SDK stack address is initialized before the reserved ROM stack
@@ -19,14 +19,99 @@
   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
+#include <stdint.h>
+#include <string.h>
+#include <pgmspace.h>
 #include "stdlib_noniso.h"
 
+// "00" to "99", read a pair at a time (and the nul of the literal)
+static const char digitPairs[201] PROGMEM __attribute__((aligned(4))) =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static inline void putPair(char* p, uint32_t pair)
+{
+    uint16_t chars = pgm_read_word(&digitPairs[pair * 2]);
+    p[0] = chars;
+    p[1] = chars >> 8;
+}
+
+// x / 100 for x < 10000 without a division, the lx106 has none
+static inline uint32_t div100(uint32_t x)
+{
+    return (x * 5243) >> 19;
+}
+
+// exactly 4 digits of x < 10000
+static inline void putQuad(char* p, uint32_t x)
+{
+    uint32_t hi = div100(x);
+    putPair(p, hi);
+    putPair(p + 2, x - hi * 100);
+}
+
+char* utoa_dec(unsigned int val, char* end)
+{
+    char* p = end;
+    while (val >= 10000)
+    {
+        uint32_t q = val / 10000;
+        putQuad(p -= 4, val - q * 10000);
+        val = q;
+    }
+    while (val >= 100)
+    {
+        uint32_t q = div100(val);
+        putPair(p -= 2, val - q * 100);
+        val = q;
+    }
+    if (val >= 10)
+    {
+        putPair(p -= 2, val);
+    }
+    else
+    {
+        *--p = '0' + val;
+    }
+    return p;
+}
+
+char* ulltoa_dec(unsigned long long val, char* end)
+{
+    char* p = end;
+    while (val > UINT32_MAX)
+    {
+        // 8 digits per 64-bit division
+        unsigned long long q = val / 100000000;
+        uint32_t r = val - q * 100000000;
+        uint32_t hi = r / 10000;
+        putQuad(p -= 4, r - hi * 10000);
+        putQuad(p -= 4, hi);
+        val = q;
+    }
+    return utoa_dec((unsigned int)val, p);
+}
+
 // ulltoa() is slower than std::to_char() (1.6 times)
 // but is smaller by ~800B/flash and ~250B/rodata
+// (except in base 10, see ulltoa_dec())
 
 // ulltoa fills str backwards and can return a pointer different from str
 char* ulltoa(unsigned long long val, char* str, int slen, unsigned int radix)
 {
+    if (radix == 10)
+    {
+        char digits[20];
+        char* first = ulltoa_dec(val, digits + sizeof(digits));
+        int len = digits + sizeof(digits) - first;
+        if (len >= slen)
+            return nullptr;
+        str += slen - 1 - len;
+        memcpy(str, first, len);
+        str[len] = 0;
+        return str;
+    }
     str += --slen;
     *str = 0;
     do
@@ -41,17 +126,10 @@ char* ulltoa(unsigned long long val, char* str, int slen, unsigned int radix)
 // lltoa fills str backwards and can return a pointer different from str
 char* lltoa (long long val, char* str, int slen, unsigned int radix)
 {
-    bool neg;
-    if (val < 0)
-    {
-        val = -val;
-        neg = true;
-    }
-    else
-    {
-        neg = false;
-    }
-    char* ret = ulltoa(val, str, slen, radix);
+    bool neg = val < 0;
+    // negated unsigned, LLONG_MIN included
+    unsigned long long uval = neg ? -(unsigned long long)val : val;
+    char* ret = ulltoa(uval, str, slen, radix);
     if (neg)
     {
         if (ret == str || ret == nullptr)
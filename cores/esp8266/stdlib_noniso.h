@@ -44,6 +44,13 @@ char* ultoa (unsigned long val, char *s, int radix);
 
 char* ulltoa (unsigned long long val, char* str, int slen, unsigned int radix);
 
+// Base 10 only, two digits at a time: the digits are written backwards
+// ending just before end, not nul terminated, and the first one is
+// returned. At most 10 (utoa_dec) or 20 (ulltoa_dec) characters.
+char* utoa_dec (unsigned int val, char* end);
+
+char* ulltoa_dec (unsigned long long val, char* end);
+
 char* dtostrf (double val, signed char width, unsigned char prec, char *s);
 
 void reverse(char* begin, char* end);
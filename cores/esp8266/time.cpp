@@ -39,6 +39,16 @@ bool getLocalTime(struct tm * info, uint32_t ms)
     return false;
 }
 
+// the local day, or part of it between DST changes, of the last
+// localtime_cached() conversion: [from, until), emptied by a TZ change
+static struct
+{
+    time_t from;
+    time_t until;
+    time_t at;
+    struct tm tm;
+} localTimeCache;
+
 
 #if !defined(CORE_MOCK)
 
@@ -200,6 +210,8 @@ void configTime(int timezone_sec, int daylightOffset_sec, const char* server1, c
 
     /*** end of hack ***/
 
+    localTimeCache = { };
+
     // sntp servers
     setServer(0, server1);
     setServer(1, server2);
@@ -227,6 +239,7 @@ void setTZ(const char* tz){
     memcpy_P(tzram, tz, sizeof(tzram));
     setenv("TZ", tzram, 1/*overwrite*/);
     tzset();
+    localTimeCache = { };
 }
 
 void configTime(const char* tz, const char* server1, const char* server2, const char* server3)
@@ -307,3 +320,83 @@ int settimeofday(const struct timeval* tv, const struct timezone* tz)
 }; // extern "C"
 
 #endif // !defined(CORE_MOCK)
+
+// Shrink [from, until) to the part of the local day without DST change
+static void localTimeLimits(time_t t, const struct tm& tm, time_t& from, time_t& until)
+{
+#if !defined(CORE_MOCK)
+    auto tz = __gettzinfo();
+    if (!_daylight || tz->__tzyear != tm.tm_year + 1900)
+    {
+        return;
+    }
+    for (const auto& rule : tz->__tzrule)
+    {
+        if (rule.change <= t)
+        {
+            from = std::max(from, (time_t)rule.change);
+        }
+        else
+        {
+            until = std::min(until, (time_t)rule.change);
+        }
+    }
+#else
+    // the host's rules stay unknown, assume any hour may change
+    time_t hour = t - tm.tm_min * 60 - tm.tm_sec;
+    from = std::max(from, hour);
+    until = std::min(until, hour + 3600);
+#endif
+}
+
+struct tm* localtime_cached(const time_t* t, struct tm* result)
+{
+    auto& cache = localTimeCache;
+    if (*t < cache.from || *t >= cache.until)
+    {
+        if (!localtime_r(t, &cache.tm))
+        {
+            cache.until = cache.from;
+            return nullptr;
+        }
+        cache.at = *t;
+        cache.from = *t - (cache.tm.tm_hour * 3600 + cache.tm.tm_min * 60 + cache.tm.tm_sec);
+        cache.until = cache.from + 24 * 3600;
+        localTimeLimits(*t, cache.tm, cache.from, cache.until);
+    }
+
+    // the same offset from UTC all along, so the local time of day moves
+    // with t
+    int32_t second = cache.tm.tm_hour * 3600 + cache.tm.tm_min * 60 + cache.tm.tm_sec + (int32_t)(*t - cache.at);
+    *result = cache.tm;
+    result->tm_hour = second / 3600;
+    result->tm_min = second / 60 % 60;
+    result->tm_sec = second % 60;
+    return result;
+}
+
+static char* isoDigits(char* out, unsigned value, int count)
+{
+    for (int i = count; i--; value /= 10)
+    {
+        out[i] = '0' + value % 10;
+    }
+    return out + count;
+}
+
+char* isotime_r(const struct tm* tm, char* buf)
+{
+    char* out = isoDigits(buf, tm->tm_year + 1900, 4);
+    *out++ = '-';
+    out = isoDigits(out, tm->tm_mon + 1, 2);
+    *out++ = '-';
+    out = isoDigits(out, tm->tm_mday, 2);
+    *out++ = 'T';
+    out = isoDigits(out, tm->tm_hour, 2);
+    *out++ = ':';
+    out = isoDigits(out, tm->tm_min, 2);
+    *out++ = ':';
+    out = isoDigits(out, tm->tm_sec, 2);
+    *out = 0;
+    return buf;
+}
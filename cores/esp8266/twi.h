@@ -43,6 +43,8 @@ void twi_stop(void);
 void twi_setClock(unsigned int freq);
 void twi_setClockStretchLimit(uint32_t limit);
 uint8_t twi_writeTo(unsigned char address, unsigned char * buf, unsigned int len, unsigned char sendStop);
+// same as twi_writeTo() with reg sent before buf
+uint8_t twi_writeRegister(unsigned char address, uint8_t reg, unsigned char * buf, unsigned int len, unsigned char sendStop);
 uint8_t twi_readFrom(unsigned char address, unsigned char * buf, unsigned int len, unsigned char sendStop);
 uint8_t twi_status();
 
@@ -56,6 +58,28 @@ void twi_releaseBus(void);
 
 void twi_enableSlaveMode(void);
 
+// Asynchronous master: the transactions are bit-banged from the timer1 NMI (shared
+// with the waveform generator through setTimer1Callback()) at up to TWI_ASYNC_MAX_CLOCK,
+// the CPU is free between the bus edges. `done(arg)` is called from the loop once they
+// all completed. The transactions and their buffers must stay valid until then, and
+// the blocking calls above wait for them.
+#ifndef TWI_ASYNC_MAX_CLOCK
+#define TWI_ASYNC_MAX_CLOCK 100000
+#endif
+
+typedef struct
+{
+    uint8_t  address;
+    uint8_t  read;      // 0: write buf, 1: read into buf (len >= 1)
+    uint8_t  sendStop;
+    uint8_t  status;    // when done: the twi_writeTo() / twi_readFrom() result
+    uint8_t* buf;
+    uint16_t len;
+} twi_transaction_t;
+
+bool twi_queue(twi_transaction_t* transactions, size_t count, void (*done)(void*), void* arg);
+bool twi_queueBusy(void);
+
 #ifdef __cplusplus
 }
 #endif
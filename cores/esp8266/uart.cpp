@@ -48,6 +48,9 @@
 #include "esp8266_peri.h"
 #include "user_interface.h"
 #include "uart_register.h"
+#include "SpscRing.h"
+#include "Schedule.h"
+#include <algorithm>
 
 #define MODE2WIDTH(mode) (((mode%16)>>2)+5)
 #define MODE2STOP(mode) (((mode)>>5)+1)
@@ -80,13 +83,15 @@ extern "C" {
 
 static int s_uart_debug_nr = UART0;
 
-struct uart_rx_buffer_
-{
-    size_t size;
-    size_t rpos;
-    size_t wpos;
-    uint8_t * buffer;
-};
+// rx bytes are pushed by the isr and popped by the user without masking
+// interrupts, except when the hw fifo itself has to be read (see below)
+typedef esp8266::SpscRing<uint8_t> uart_rx_buffer_t;
+
+// rx frames whose end was seen by the isr and not yet handed to the callback,
+// more frames than this are merged with the following one
+#ifndef UART_RX_FRAME_QUEUE
+#define UART_RX_FRAME_QUEUE 4
+#endif
 
 struct uart_
 {
@@ -98,9 +103,33 @@ struct uart_
     bool rx_error;
     uint8_t rx_pin;
     uint8_t tx_pin;
-    struct uart_rx_buffer_ * rx_buffer;
+    uart_rx_buffer_t * rx_buffer;
+
+    // optional tx ring (uart_resize_tx_buffer()), the user side is its producer
+    // and the isr its consumer, refilling the hw fifo on the fifo empty interrupt
+    uint8_t * tx_buffer;
+    size_t tx_size;
+    volatile size_t tx_rpos;
+    volatile size_t tx_wpos;
+
+    // optional rx frame callback (uart_set_rx_frame_callback()), frames are
+    // delimited in received byte counts: the isr queues rx_count on each rx
+    // timeout, and the frame task hands out the bytes up to it
+    uint8_t rx_timeout;
+    uart_rx_frame_cb_t rx_frame_cb;
+    void * rx_frame_arg;
+    volatile uint32_t rx_count;
+    uint32_t rx_frame_start;
+    esp8266::SpscRing<uint32_t> rx_frames;
+    uint32_t rx_frame_ends[UART_RX_FRAME_QUEUE + 1];
 };
 
+// uarts handled by uart_isr(), both share the same interrupt
+static uart_t* s_isr_uart[2] = { NULL, NULL };
+
+// whether the frame task of an uart is scheduled
+static bool s_rx_frame_task[2] = { false, false };
+
 
 /*
    In the context of the naming conventions in this file, "_unsafe" means two things:
@@ -111,6 +140,15 @@ struct uart_
 
    The unsafe versions of the functions are private to this TU. There are "safe" versions that
    wrap the unsafe ones with disabling/enabling of the uart interrupt for safe public use.
+
+   The rx_buffer is a single producer / single consumer ring, the isr is its producer and
+   the user side is its consumer. Reading or peeking rx_buffer needs no interrupt masking.
+   The hw fifo however can only be read by one side at a time, so the user side disables the
+   uart interrupt while it reads the fifo, and becomes the producer for that duration.
+
+   The tx ring is the other way around: the user side is its producer and the isr its consumer.
+   The user side also becomes the consumer (with the uart interrupt disabled) to start a
+   transmission at once, and when the ring is full while the isr cannot run.
 */
 
 
@@ -126,87 +164,48 @@ uart_rx_fifo_available(const int uart_nr)
 /**********************************************************/
 /************ UNSAFE FUNCTIONS ****************************/
 /**********************************************************/
-inline size_t
-uart_rx_buffer_available_unsafe(const struct uart_rx_buffer_ * rx_buffer)
-{
-    if(rx_buffer->wpos < rx_buffer->rpos)
-      return (rx_buffer->wpos + rx_buffer->size) - rx_buffer->rpos;
-
-    return rx_buffer->wpos - rx_buffer->rpos;
-}
-
-inline size_t
-uart_rx_available_unsafe(uart_t* uart)
-{
-    return uart_rx_buffer_available_unsafe(uart->rx_buffer) + uart_rx_fifo_available(uart->uart_nr);
-}
-
-//#define UART_DISCARD_NEWEST
-
 // Copy all the rx fifo bytes that fit into the rx buffer
-// called by ISR
+// called by ISR, or by the user with the uart interrupt disabled
+//
+// The producer cannot move the read index, so when the rx buffer is full the
+// newest data is discarded (the oldest was, before the buffer was read
+// without masking interrupts, unless UART_DISCARD_NEWEST was defined).
+// The fifo is drained regardless, to acknowledge the fifo-full interrupt
+// (rx_overrun is set).
+//
+// `keep` bytes are left in the fifo: the rx timeout only triggers while the
+// fifo is not empty, so the fifo-full interrupt keeps one byte there when
+// frames are detected.
 inline void IRAM_ATTR
-uart_rx_copy_fifo_to_buffer_unsafe(uart_t* uart)
+uart_rx_copy_fifo_to_buffer_unsafe(uart_t* uart, const size_t keep = 0)
 {
-    struct uart_rx_buffer_ *rx_buffer = uart->rx_buffer;
+    uart_rx_buffer_t *rx_buffer = uart->rx_buffer;
 
-    while(uart_rx_fifo_available(uart->uart_nr))
+    while(uart_rx_fifo_available(uart->uart_nr) > keep)
     {
-        size_t nextPos = (rx_buffer->wpos + 1) % rx_buffer->size;
-        if(nextPos == rx_buffer->rpos)
+        uint8_t data = USF(uart->uart_nr);
+        if(rx_buffer->push(data))
         {
-            if (!uart->rx_overrun)
-            {
-                uart->rx_overrun = true;
-                //os_printf_plus(overrun_str);
-            }
-
-            // a choice has to be made here,
-            // do we discard newest or oldest data?
-#ifdef UART_DISCARD_NEWEST
-            // discard newest data
-            // Stop copying if rx buffer is full
-            USF(uart->uart_nr);
-            break;
-#else
-            // discard oldest data
-            if (++rx_buffer->rpos == rx_buffer->size)
-                rx_buffer->rpos = 0;
-#endif
+            uart->rx_count = uart->rx_count + 1;
+        }
+        else
+        {
+            uart->rx_overrun = true;
+            //os_printf_plus(overrun_str);
         }
-        uint8_t data = USF(uart->uart_nr);
-        rx_buffer->buffer[rx_buffer->wpos] = data;
-        rx_buffer->wpos = nextPos;
     }
 }
 
-inline int
-uart_peek_char_unsafe(uart_t* uart)
+// hw fifo can't be peeked, data need to be copied to sw
+inline void
+uart_rx_copy_fifo_to_buffer(uart_t* uart)
 {
-    if (!uart_rx_available_unsafe(uart))
-        return -1;
-
-    //without the following if statement and body, there is a good chance of a fifo overrun
-    if (uart_rx_buffer_available_unsafe(uart->rx_buffer) == 0)
-        // hw fifo can't be peeked, data need to be copied to sw
-        uart_rx_copy_fifo_to_buffer_unsafe(uart);
-
-    return uart->rx_buffer->buffer[uart->rx_buffer->rpos];
-}
-
-// taking data straight from hw fifo: loopback-test BW jumps by 19%
-inline int
-uart_read_char_unsafe(uart_t* uart)
-{
-    if (uart_rx_buffer_available_unsafe(uart->rx_buffer))
+    if(uart_rx_fifo_available(uart->uart_nr))
     {
-        // take oldest sw data
-        int ret = uart->rx_buffer->buffer[uart->rx_buffer->rpos];
-        uart->rx_buffer->rpos = (uart->rx_buffer->rpos + 1) % uart->rx_buffer->size;
-        return ret;
+        ETS_UART_INTR_DISABLE();
+        uart_rx_copy_fifo_to_buffer_unsafe(uart);
+        ETS_UART_INTR_ENABLE();
     }
-    // unavailable
-    return -1;
 }
 
 uint8_t
@@ -222,11 +221,7 @@ uart_rx_available(uart_t* uart)
     if(uart == NULL || !uart->rx_enabled)
         return 0;
 
-    ETS_UART_INTR_DISABLE();
-    int uartrxbufferavailable = uart_rx_buffer_available_unsafe(uart->rx_buffer);
-    ETS_UART_INTR_ENABLE();
-
-    return uartrxbufferavailable + uart_rx_fifo_available(uart->uart_nr);
+    return uart->rx_buffer->available() + uart_rx_fifo_available(uart->uart_nr);
 }
 
 int
@@ -235,10 +230,14 @@ uart_peek_char(uart_t* uart)
     if(uart == NULL || !uart->rx_enabled)
         return -1;
 
-    ETS_UART_INTR_DISABLE(); //access to rx_buffer can be interrupted by the isr (similar to a critical section), so disable interrupts here
-    int ret = uart_peek_char_unsafe(uart);
-    ETS_UART_INTR_ENABLE();
-    return ret;
+    //without the following if statement and body, there is a good chance of a fifo overrun
+    if (uart->rx_buffer->empty())
+        uart_rx_copy_fifo_to_buffer(uart);
+
+    if (uart->rx_buffer->empty())
+        return -1;
+
+    return uart->rx_buffer->peek();
 }
 
 // return number of byte accessible by uart_peek_buffer()
@@ -249,31 +248,21 @@ size_t uart_peek_available (uart_t* uart)
     // - or return fifo when buffer is empty but then any move from fifo to
     //   buffer should be blocked until peek_consume is called
 
-    ETS_UART_INTR_DISABLE();
-    uart_rx_copy_fifo_to_buffer_unsafe(uart);
-    auto rpos = uart->rx_buffer->rpos;
-    auto wpos = uart->rx_buffer->wpos;
-    ETS_UART_INTR_ENABLE();
-    if(wpos < rpos)
-        return uart->rx_buffer->size - rpos;
-    return wpos - rpos;
+    uart_rx_copy_fifo_to_buffer(uart);
+    return uart->rx_buffer->peekAvailable();
 }
 
 // return a pointer to available data buffer (size = available())
 // semantic forbids any kind of read() between peekBuffer() and peekConsume()
 const char* uart_peek_buffer (uart_t* uart)
 {
-    return (const char*)&uart->rx_buffer->buffer[uart->rx_buffer->rpos];
+    return (const char*)uart->rx_buffer->peekBuffer();
 }
 
 // consume bytes after use (see uart_peek_buffer)
 void uart_peek_consume (uart_t* uart, size_t consume)
 {
-    ETS_UART_INTR_DISABLE();
-    uart->rx_buffer->rpos += consume;
-    if (uart->rx_buffer->rpos >= uart->rx_buffer->size)
-        uart->rx_buffer->rpos -= uart->rx_buffer->size;
-    ETS_UART_INTR_ENABLE();
+    uart->rx_buffer->consume(consume);
 }
 
 int
@@ -290,34 +279,24 @@ uart_read(uart_t* uart, char* userbuffer, size_t usersize)
     if(uart == NULL || !uart->rx_enabled)
         return 0;
 
-    size_t ret = 0;
-    ETS_UART_INTR_DISABLE();
+    // pour sw buffer to user's buffer
+    size_t ret = uart->rx_buffer->read((uint8_t*)userbuffer, usersize);
 
-    while (ret < usersize && uart_rx_available_unsafe(uart))
+    if (ret < usersize && uart_rx_fifo_available(uart->uart_nr))
     {
-        if (!uart_rx_buffer_available_unsafe(uart->rx_buffer))
-        {
-            // no more data in sw buffer, take them from hw fifo
-            while (ret < usersize && uart_rx_fifo_available(uart->uart_nr))
-                userbuffer[ret++] = USF(uart->uart_nr);
+        ETS_UART_INTR_DISABLE();
 
-	    // no more sw/hw data available
-            break;
-        }
+        // the isr may have filled the sw buffer meanwhile, older data first
+        ret += uart->rx_buffer->read((uint8_t*)userbuffer + ret, usersize - ret);
+
+        // no more data in sw buffer, take them from hw fifo
+        // (taking data straight from hw fifo: loopback-test BW jumps by 19%)
+        while (ret < usersize && uart_rx_fifo_available(uart->uart_nr))
+            userbuffer[ret++] = USF(uart->uart_nr);
 
-        // pour sw buffer to user's buffer
-        // get largest linear length from sw buffer
-        size_t chunk = uart->rx_buffer->rpos < uart->rx_buffer->wpos?
-                           uart->rx_buffer->wpos - uart->rx_buffer->rpos:
-                           uart->rx_buffer->size - uart->rx_buffer->rpos;
-        if (ret + chunk > usersize)
-            chunk = usersize - ret;
-        memcpy(userbuffer + ret, uart->rx_buffer->buffer + uart->rx_buffer->rpos, chunk);
-        uart->rx_buffer->rpos = (uart->rx_buffer->rpos + chunk) % uart->rx_buffer->size;
-        ret += chunk;
+        ETS_UART_INTR_ENABLE();
     }
 
-    ETS_UART_INTR_ENABLE();
     return ret;
 }
 
@@ -332,30 +311,12 @@ static void IRAM_ATTR uart_isr_handle_data(void* arg, uint8_t data)
         return;
     }
 
-// Copy all the rx fifo bytes that fit into the rx buffer
-// called by ISR
-    struct uart_rx_buffer_ *rx_buffer = uart->rx_buffer;
-
-    size_t nextPos = (rx_buffer->wpos + 1) % rx_buffer->size;
-    if(nextPos == rx_buffer->rpos)
+// Copy the byte into the rx buffer, newest data is discarded when full
+    if(!uart->rx_buffer->push(data))
     {
         uart->rx_overrun = true;
         //os_printf_plus(overrun_str);
-
-        // a choice has to be made here,
-        // do we discard newest or oldest data?
-#ifdef UART_DISCARD_NEWEST
-        // discard newest data
-        // Stop copying if rx buffer is full
-        return;
-#else
-        // discard oldest data
-        if (++rx_buffer->rpos == rx_buffer->size)
-            rx_buffer->rpos = 0;
-#endif
     }
-    rx_buffer->buffer[rx_buffer->wpos] = data;
-    rx_buffer->wpos = nextPos;
 
     // Check the UART flags and note hardware overflow/etc.
     uint32_t usis = USIS(uart->uart_nr);
@@ -363,7 +324,7 @@ static void IRAM_ATTR uart_isr_handle_data(void* arg, uint8_t data)
     if(usis & (1 << UIOF))
         uart->rx_overrun = true;
 
-    if (usis & ((1 << UIFR) | (1 << UIPE) | (1 << UITO)))
+    if (usis & ((1 << UIFR) | (1 << UIPE)))
         uart->rx_error = true;
 
     USIC(uart->uart_nr) = usis;
@@ -375,74 +336,197 @@ uart_resize_rx_buffer(uart_t* uart, size_t new_size)
     if(uart == NULL || !uart->rx_enabled)
         return 0;
 
-    if(uart->rx_buffer->size == new_size)
-        return uart->rx_buffer->size;
+    if(uart->rx_buffer->size() == new_size)
+        return uart->rx_buffer->size();
 
     uint8_t * new_buf = (uint8_t*)malloc(new_size);
     if(!new_buf)
-        return uart->rx_buffer->size;
+        return uart->rx_buffer->size();
 
-    size_t new_wpos = 0;
+    // one byte of a ring is never used
     ETS_UART_INTR_DISABLE();
-    while(uart_rx_available_unsafe(uart) && new_wpos < new_size)
-        new_buf[new_wpos++] = uart_read_char_unsafe(uart); //if uart_rx_available_unsafe() returns non-0, uart_read_char_unsafe() can't return -1
-    if (new_wpos == new_size)
-        new_wpos = 0;
-
-    uint8_t * old_buf = uart->rx_buffer->buffer;
-    uart->rx_buffer->rpos = 0;
-    uart->rx_buffer->wpos = new_wpos;
-    uart->rx_buffer->size = new_size;
-    uart->rx_buffer->buffer = new_buf;
+    size_t new_wpos = uart->rx_buffer->read(new_buf, new_size - 1);
+    while(new_wpos < new_size - 1 && uart_rx_fifo_available(uart->uart_nr))
+    {
+        new_buf[new_wpos++] = USF(uart->uart_nr);
+        uart->rx_count = uart->rx_count + 1;
+    }
+
+    uint8_t * old_buf = uart->rx_buffer->buffer();
+    uart->rx_buffer->init(new_buf, new_size, new_wpos);
     ETS_UART_INTR_ENABLE();
     free(old_buf);
-    return uart->rx_buffer->size;
+    return uart->rx_buffer->size();
 }
 
 size_t
 uart_get_rx_buffer_size(uart_t* uart)
 {
-    return uart && uart->rx_enabled? uart->rx_buffer->size: 0;
+    return uart && uart->rx_enabled? uart->rx_buffer->size(): 0;
 }
 
+// move the rx buffer content to its start, so that a frame wrapping around
+// the end of the buffer can be handed out in one piece
+static void
+uart_rx_linearize(uart_t* uart)
+{
+    ETS_UART_INTR_DISABLE();
+    uint8_t * buf = uart->rx_buffer->buffer();
+    size_t size = uart->rx_buffer->size();
+    size_t used = uart->rx_buffer->available();
+    std::rotate(buf, buf + (uart->rx_buffer->peekBuffer() - buf), buf + size);
+    uart->rx_buffer->init(buf, size, used);
+    ETS_UART_INTR_ENABLE();
+}
+
+// loop side of the frame callback, runs while the callback is set
+static bool
+uart_rx_frame_task(const int uart_nr)
+{
+    uart_t* uart = s_isr_uart[uart_nr];
+    uint32_t end;
+
+    while(uart && uart->rx_frame_cb && uart->rx_frames.pop(end))
+    {
+        // bytes read by the user in the meantime are not part of the frame anymore
+        size_t size = std::min<size_t>(end - uart->rx_frame_start, uart->rx_buffer->available());
+        uart->rx_frame_start = end;
+        if(!size)
+            continue;
+
+        if(uart->rx_buffer->peekAvailable() < size)
+            uart_rx_linearize(uart);
+
+        uart->rx_frame_cb(uart->rx_frame_arg, (const char*)uart->rx_buffer->peekBuffer(), size);
+
+        // the callback may have closed or reconfigured the uart
+        if(s_isr_uart[uart_nr] != uart || !uart->rx_frame_cb)
+            break;
+        uart->rx_buffer->consume(std::min(size, uart->rx_buffer->available()));
+    }
+
+    uart = s_isr_uart[uart_nr];
+    if(uart && uart->rx_frame_cb)
+        return true;
+
+    s_rx_frame_task[uart_nr] = false;
+    return false;
+}
+
+bool
+uart_set_rx_frame_callback(uart_t* uart, uint8_t symbols, uart_rx_frame_cb_t cb, void* arg)
+{
+    if(uart == NULL || !uart->rx_enabled || gdbstub_has_uart_isr_control())
+        return false;
+
+    if(!cb)
+        symbols = 0;
+    else if(symbols > 0x7f)
+        symbols = 0x7f;
+    if(!symbols)
+        cb = NULL;
+
+    const int uart_nr = uart->uart_nr;
+    if(cb && !s_rx_frame_task[uart_nr])
+    {
+        s_rx_frame_task[uart_nr] = schedule_recurrent_function_us([uart_nr]()
+        {
+            return uart_rx_frame_task(uart_nr);
+        }, 0);
+        if(!s_rx_frame_task[uart_nr])
+            return false;
+    }
+
+    ETS_UART_INTR_DISABLE();
+    uart->rx_timeout = symbols;
+    uart->rx_frame_cb = cb;
+    uart->rx_frame_arg = arg;
+    // the next frame starts with the oldest unread byte
+    uart->rx_frames.reset();
+    uart->rx_frame_start = uart->rx_count - uart->rx_buffer->available();
+    USC1(uart_nr) = (USC1(uart_nr) & ~((0x7f << UCTOT) | (1 << UCTOE))) |
+        (symbols? (symbols << UCTOT) | (1 << UCTOE): 0);
+    ETS_UART_INTR_ENABLE();
+    return true;
+}
+
+static void uart_tx_copy_buffer_to_fifo_unsafe(uart_t* uart);
+
 // The default ISR handler called when GDB is not enabled
 void IRAM_ATTR
 uart_isr(void * arg, void * frame)
 {
+    (void) arg;
     (void) frame;
-    uart_t* uart = (uart_t*)arg;
-    uint32_t usis = USIS(uart->uart_nr);
 
-    if(uart == NULL || !uart->rx_enabled)
+    for(int uart_nr = UART0; uart_nr <= UART1; uart_nr++)
     {
-        USIC(uart->uart_nr) = usis;
-        ETS_UART_INTR_DISABLE();
-        return;
-    }
+        uint32_t usis = USIS(uart_nr);
+        if(!usis)
+            continue;
 
-    if(usis & (1 << UIFF))
-        uart_rx_copy_fifo_to_buffer_unsafe(uart);
+        uart_t* uart = s_isr_uart[uart_nr];
+        if(uart == NULL)
+        {
+            USIE(uart_nr) = 0;
+            USIC(uart_nr) = usis;
+            continue;
+        }
 
-    if(usis & (1 << UIOF))
-    {
-        uart->rx_overrun = true;
-        //os_printf_plus(overrun_str);
-    }
+        if(uart->rx_enabled)
+        {
+            if(usis & (1 << UITO))
+            {
+                // the line is idle: end of frame
+                uart_rx_copy_fifo_to_buffer_unsafe(uart);
+                if(uart->rx_frame_cb)
+                    uart->rx_frames.push((uint32_t)uart->rx_count);
+            }
+            else if(usis & (1 << UIFF))
+                uart_rx_copy_fifo_to_buffer_unsafe(uart, uart->rx_timeout? 1: 0);
 
-    if (usis & ((1 << UIFR) | (1 << UIPE) | (1 << UITO)))
-        uart->rx_error = true;
+            if(usis & (1 << UIOF))
+            {
+                uart->rx_overrun = true;
+                //os_printf_plus(overrun_str);
+            }
 
-    USIC(uart->uart_nr) = usis;
+            if (usis & ((1 << UIFR) | (1 << UIPE)))
+                uart->rx_error = true;
+        }
+
+        if(usis & (1 << UIFE))
+            uart_tx_copy_buffer_to_fifo_unsafe(uart);
+
+        USIC(uart_nr) = usis;
+    }
+}
+
+// attach uart_isr() while it has an uart to handle
+static void
+uart_isr_update()
+{
+    ETS_UART_INTR_DISABLE();
+    if(s_isr_uart[UART0] || s_isr_uart[UART1])
+    {
+        ETS_UART_INTR_ATTACH(uart_isr, NULL);
+        ETS_UART_INTR_ENABLE();
+    }
+    else
+    {
+        ETS_UART_INTR_ATTACH(NULL, NULL);
+    }
 }
 
 static void
 uart_start_isr(uart_t* uart)
 {
-    if(uart == NULL || !uart->rx_enabled)
+    if(uart == NULL)
         return;
 
     if(gdbstub_has_uart_isr_control()) {
-        gdbstub_set_uart_isr_callback(uart_isr_handle_data,  (void *)uart);
+        if(uart->rx_enabled)
+            gdbstub_set_uart_isr_callback(uart_isr_handle_data,  (void *)uart);
         return;
     }
 
@@ -456,36 +540,57 @@ uart_start_isr(uart_t* uart)
     // was 100, use 16 to stay away from overrun
     #define INTRIGG 16
 
-    //was:USC1(uart->uart_nr) = (INTRIGG << UCFFT) | (0x02 << UCTOT) | (1 <<UCTOE);
-    USC1(uart->uart_nr) = (INTRIGG << UCFFT);
+    // UCFET value is when the TX fifo empty interrupt triggers (only enabled
+    // while the tx ring has data): the isr refills the fifo with 96 bytes,
+    // sent while the next interrupt is pending.
+    #define TXTRIGG 32
+
+    ETS_UART_INTR_DISABLE();
     USIC(uart->uart_nr) = 0xffff;
-    //was: USIE(uart->uart_nr) = (1 << UIFF) | (1 << UIFR) | (1 << UITO);
-    // UIFF: rx fifo full
-    // UIOF: rx fifo overflow (=overrun)
-    // UIFR: frame error
-    // UIPE: parity error
-    // UITO: rx fifo timeout
-    USIE(uart->uart_nr) = (1 << UIFF) | (1 << UIOF) | (1 << UIFR) | (1 << UIPE) | (1 << UITO);
-    ETS_UART_INTR_ATTACH(uart_isr,  (void *)uart);
-    ETS_UART_INTR_ENABLE();
+    if(uart->rx_enabled)
+    {
+        //was:USC1(uart->uart_nr) = (INTRIGG << UCFFT) | (0x02 << UCTOT) | (1 <<UCTOE);
+        USC1(uart->uart_nr) = (INTRIGG << UCFFT) | (TXTRIGG << UCFET) |
+            (uart->rx_timeout? (uart->rx_timeout << UCTOT) | (1 << UCTOE): 0);
+        //was: USIE(uart->uart_nr) = (1 << UIFF) | (1 << UIFR) | (1 << UITO);
+        // UIFF: rx fifo full
+        // UIOF: rx fifo overflow (=overrun)
+        // UIFR: frame error
+        // UIPE: parity error
+        // UITO: rx fifo timeout (only enabled with UCTOE, see uart_set_rx_frame_callback())
+        USIE(uart->uart_nr) = (1 << UIFF) | (1 << UIOF) | (1 << UIFR) | (1 << UIPE) | (1 << UITO);
+    }
+    else
+    {
+        USC1(uart->uart_nr) = (TXTRIGG << UCFET);
+        USIE(uart->uart_nr) = 0;
+    }
+    // UIFE: tx fifo empty, enabled by the writes
+    s_isr_uart[uart->uart_nr] = uart;
+    uart_isr_update();
 }
 
 static void
 uart_stop_isr(uart_t* uart)
 {
-    if(uart == NULL || !uart->rx_enabled)
+    if(uart == NULL)
         return;
 
     if(gdbstub_has_uart_isr_control()) {
-        gdbstub_set_uart_isr_callback(NULL, NULL);
+        if(uart->rx_enabled)
+            gdbstub_set_uart_isr_callback(NULL, NULL);
         return;
     }
 
+    if(s_isr_uart[uart->uart_nr] != uart)
+        return;
+
     ETS_UART_INTR_DISABLE();
     USC1(uart->uart_nr) = 0;
     USIC(uart->uart_nr) = 0xffff;
     USIE(uart->uart_nr) = 0;
-    ETS_UART_INTR_ATTACH(NULL, NULL);
+    s_isr_uart[uart->uart_nr] = NULL;
+    uart_isr_update();
 }
 
 /*
@@ -506,6 +611,96 @@ uart_tx_fifo_full(const int uart_nr)
     return uart_tx_fifo_available(uart_nr) >= 0x7f;
 }
 
+// called by ISR, or with the uart interrupt disabled
+// moves the tx ring to the fifo, as much as it holds, and keeps
+// the fifo empty interrupt enabled while data is left
+static void IRAM_ATTR
+uart_tx_copy_buffer_to_fifo_unsafe(uart_t* uart)
+{
+    const int uart_nr = uart->uart_nr;
+    const size_t wpos = uart->tx_wpos;
+    size_t rpos = uart->tx_rpos;
+
+    // same limit as uart_tx_fifo_full()
+    const size_t used = uart_tx_fifo_available(uart_nr);
+    size_t room = used < 0x7f ? 0x7f - used : 0;
+    while(room-- && rpos != wpos)
+    {
+        USF(uart_nr) = uart->tx_buffer[rpos];
+        if(++rpos == uart->tx_size)
+            rpos = 0;
+    }
+    uart->tx_rpos = rpos;
+
+    if(rpos == wpos)
+        USIE(uart_nr) &= ~(1 << UIFE);
+    else
+        USIE(uart_nr) |= (1 << UIFE);
+}
+
+// the user side becomes the consumer of the tx ring
+static void
+uart_tx_kick(uart_t* uart)
+{
+    ETS_UART_INTR_DISABLE();
+    uart_tx_copy_buffer_to_fifo_unsafe(uart);
+    ETS_UART_INTR_ENABLE();
+}
+
+static inline size_t
+uart_tx_buffer_room(const uart_t* uart)
+{
+    const size_t wpos = uart->tx_wpos;
+    const size_t rpos = uart->tx_rpos;
+    // one byte of a ring is never used
+    return (rpos > wpos ? rpos - wpos : uart->tx_size - wpos + rpos) - 1;
+}
+
+// copies to the tx ring and returns, only waits when it is full
+static size_t
+uart_tx_buffer_write(uart_t* uart, const char* buf, size_t size)
+{
+    size_t done = 0;
+    while(done < size)
+    {
+        size_t room = uart_tx_buffer_room(uart);
+        if(!room)
+        {
+            // the fifo is refilled from here too, the isr does not run
+            // when called with interrupts disabled
+            uart_tx_kick(uart);
+            optimistic_yield(10000UL);
+            continue;
+        }
+
+        size_t wpos = uart->tx_wpos;
+        while(room-- && done < size)
+        {
+            uart->tx_buffer[wpos] = pgm_read_byte(buf + done++);
+            if(++wpos == uart->tx_size)
+                wpos = 0;
+        }
+        // data is written before the isr can see it
+        __asm__ __volatile__ ("" ::: "memory");
+        uart->tx_wpos = wpos;
+
+        // the transmission starts now if the fifo has room
+        uart_tx_kick(uart);
+    }
+    return size;
+}
+
+// waits until the isr has moved the tx ring to the fifo
+static void
+uart_tx_buffer_drain(uart_t* uart)
+{
+    while(uart->tx_rpos != uart->tx_wpos)
+    {
+        uart_tx_kick(uart);
+        optimistic_yield(10000UL);
+    }
+}
+
 
 static void
 uart_do_write_char(const int uart_nr, char c)
@@ -515,6 +710,60 @@ uart_do_write_char(const int uart_nr, char c)
     USF(uart_nr) = c;
 }
 
+size_t
+uart_resize_tx_buffer(uart_t* uart, size_t new_size)
+{
+    if(uart == NULL || !uart->tx_enabled)
+        return 0;
+
+    // GDB owns the uart interrupt
+    if(gdbstub_has_uart_isr_control())
+        return 0;
+
+    // a ring of one byte holds nothing
+    if(new_size < 2)
+        new_size = 0;
+
+    if(uart->tx_size == new_size)
+        return uart->tx_size;
+
+    uint8_t * new_buf = NULL;
+    if(new_size)
+    {
+        new_buf = (uint8_t*)malloc(new_size);
+        if(!new_buf)
+            return uart->tx_size;
+    }
+
+    // bytes already written are sent first
+    if(uart->tx_buffer)
+        uart_tx_buffer_drain(uart);
+
+    ETS_UART_INTR_DISABLE();
+    USIE(uart->uart_nr) &= ~(1 << UIFE);
+    uint8_t * old_buf = uart->tx_buffer;
+    uart->tx_buffer = new_buf;
+    uart->tx_size = new_size;
+    uart->tx_rpos = 0;
+    uart->tx_wpos = 0;
+    if(s_isr_uart[uart->uart_nr] == uart)
+        ETS_UART_INTR_ENABLE();
+    free(old_buf);
+
+    if(new_buf && s_isr_uart[uart->uart_nr] != uart)
+        uart_start_isr(uart);
+    else if(!new_buf && !uart->rx_enabled)
+        uart_stop_isr(uart);
+
+    return uart->tx_size;
+}
+
+size_t
+uart_get_tx_buffer_size(uart_t* uart)
+{
+    return uart && uart->tx_enabled? uart->tx_size: 0;
+}
+
 size_t
 uart_write_char(uart_t* uart, char c)
 {
@@ -525,6 +774,9 @@ uart_write_char(uart_t* uart, char c)
         gdbstub_write_char(c);
         return 1;
     }
+    if(uart->tx_buffer)
+        return uart_tx_buffer_write(uart, &c, 1);
+
     uart_do_write_char(uart->uart_nr, c);
     return 1;
 }
@@ -540,6 +792,9 @@ uart_write(uart_t* uart, const char* buf, size_t size)
         return 0;
     }
 
+    if(uart->tx_buffer)
+        return uart_tx_buffer_write(uart, buf, size);
+
     size_t ret = size;
     const int uart_nr = uart->uart_nr;
     while (size--) {
@@ -557,7 +812,10 @@ uart_tx_free(uart_t* uart)
     if(uart == NULL || !uart->tx_enabled)
         return 0;
 
-    return UART_TX_FIFO_SIZE - uart_tx_fifo_available(uart->uart_nr);
+    size_t fifo_free = UART_TX_FIFO_SIZE - uart_tx_fifo_available(uart->uart_nr);
+    if(uart->tx_buffer)
+        return uart_tx_buffer_room(uart) + fifo_free;
+    return fifo_free;
 }
 
 void
@@ -566,6 +824,9 @@ uart_wait_tx_empty(uart_t* uart)
     if(uart == NULL || !uart->tx_enabled)
         return;
 
+    if(uart->tx_buffer)
+        uart_tx_buffer_drain(uart);
+
     while(uart_tx_fifo_available(uart->uart_nr) > 0)
         esp_yield();
 
@@ -582,13 +843,21 @@ uart_flush(uart_t* uart)
     {
         tmp |= (1 << UCRXRST);
         ETS_UART_INTR_DISABLE();
-        uart->rx_buffer->rpos = 0;
-        uart->rx_buffer->wpos = 0;
+        uart->rx_buffer->reset();
         ETS_UART_INTR_ENABLE();
     }
 
     if(uart->tx_enabled)
+    {
         tmp |= (1 << UCTXRST);
+        if(uart->tx_buffer)
+        {
+            ETS_UART_INTR_DISABLE();
+            uart->tx_rpos = uart->tx_wpos;
+            USIE(uart->uart_nr) &= ~(1 << UIFE);
+            ETS_UART_INTR_ENABLE();
+        }
+    }
 
     if(!gdbstub_has_uart_isr_control() || uart->uart_nr != UART0) {
         USC0(uart->uart_nr) |= (tmp);
@@ -625,35 +894,46 @@ uart_init(int uart_nr, int baudrate, int config, int mode, int tx_pin, size_t rx
     uart->uart_nr = uart_nr;
     uart->rx_overrun = false;
     uart->rx_error = false;
+    uart->tx_buffer = NULL;
+    uart->tx_size = 0;
+    uart->tx_rpos = 0;
+    uart->tx_wpos = 0;
+    uart->rx_timeout = 0;
+    uart->rx_frame_cb = NULL;
+    uart->rx_frame_arg = NULL;
+    uart->rx_count = 0;
+    uart->rx_frame_start = 0;
+    uart->rx_frames.init(uart->rx_frame_ends, UART_RX_FRAME_QUEUE + 1);
 
     switch(uart->uart_nr)
     {
     case UART0:
         ETS_UART_INTR_DISABLE();
         if(!gdbstub_has_uart_isr_control()) {
-            ETS_UART_INTR_ATTACH(NULL, NULL);
+            // UART1 keeps its interrupt
+            USIE(UART0) = 0;
+            s_isr_uart[UART0] = NULL;
+            uart_isr_update();
         }
         uart->rx_enabled = (mode != UART_TX_ONLY);
         uart->tx_enabled = (mode != UART_RX_ONLY);
         uart->rx_pin = (uart->rx_enabled)?3:255;
         if(uart->rx_enabled)
         {
-            struct uart_rx_buffer_ * rx_buffer = (struct uart_rx_buffer_ *)malloc(sizeof(struct uart_rx_buffer_));
+            uart_rx_buffer_t * rx_buffer = (uart_rx_buffer_t *)malloc(sizeof(uart_rx_buffer_t));
             if(rx_buffer == NULL)
             {
               free(uart);
               return NULL;
             }
-            rx_buffer->size = rx_size;//var this
-            rx_buffer->rpos = 0;
-            rx_buffer->wpos = 0;
-            rx_buffer->buffer = (uint8_t *)malloc(rx_buffer->size);
-            if(rx_buffer->buffer == NULL)
+            uint8_t * buffer = (uint8_t *)malloc(rx_size);
+            if(buffer == NULL)
             {
               free(rx_buffer);
               free(uart);
               return NULL;
             }
+            rx_buffer->init(buffer, rx_size);//var this
             uart->rx_buffer = rx_buffer;
             pinMode(uart->rx_pin, SPECIAL);
         }
@@ -727,6 +1007,7 @@ uart_uninit(uart_t* uart)
         return;
 
     uart_stop_isr(uart);
+    free(uart->tx_buffer);
 
     if(uart->tx_enabled && (!gdbstub_has_uart_isr_control() || uart->uart_nr != UART0)) {
         switch(uart->tx_pin)
@@ -744,7 +1025,7 @@ uart_uninit(uart_t* uart)
     }
 
     if(uart->rx_enabled) {
-        free(uart->rx_buffer->buffer);
+        free(uart->rx_buffer->buffer());
         free(uart->rx_buffer);
         if(!gdbstub_has_uart_isr_control()) {
             switch(uart->rx_pin)
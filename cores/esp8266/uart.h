@@ -128,6 +128,18 @@ int uart_get_baudrate(uart_t* uart);
 size_t uart_resize_rx_buffer(uart_t* uart, size_t new_size);
 size_t uart_get_rx_buffer_size(uart_t* uart);
 
+// 0 (default): uart_write() waits for room in the hw fifo
+// otherwise: uart_write() copies to a ring of new_size bytes refilling the fifo from
+// the uart interrupt, and only waits when the ring is full (unavailable with GDB)
+size_t uart_resize_tx_buffer(uart_t* uart, size_t new_size);
+size_t uart_get_tx_buffer_size(uart_t* uart);
+
+// cb is called from the loop (as a recurrent scheduled function) with each frame, i.e. the
+// bytes received before the rx line stays idle for `symbols` character times (1..127), and
+// the frame is consumed when cb returns. cb==NULL or symbols==0 disables (unavailable with GDB)
+typedef void (*uart_rx_frame_cb_t)(void* arg, const char* frame, size_t size);
+bool uart_set_rx_frame_callback(uart_t* uart, uint8_t symbols, uart_rx_frame_cb_t cb, void* arg);
+
 size_t uart_write_char(uart_t* uart, char c);
 size_t uart_write(uart_t* uart, const char* buf, size_t size);
 int uart_read_char(uart_t* uart);
@@ -0,0 +1,106 @@
+/*
+ * Relocation support for movable allocations.
+ *
+ * umm_relocate_down() moves one allocation into the lowest addressed free
+ * block below it that is large enough. It is the building block used by
+ * esp8266::MovableBuffer::compact(), see MovableBuffer.h. Repeated for the
+ * long-lived allocations of a Heap, in ascending address order, this packs
+ * them toward the bottom of the Heap and lets the holes they leave
+ * assimilate with the free space above.
+ *
+ * The caller owns the allocation and must guarantee that no other pointer to
+ * it is held across the call.
+ */
+#if defined(BUILD_UMM_MALLOC_C)
+
+static void umm_free_core(umm_heap_context_t *_context, void *ptr);
+
+/*
+ * Must be called only from within critical sections guarded by
+ * UMM_CRITICAL_ENTRY() and UMM_CRITICAL_EXIT().
+ *
+ * Returns the block index of the destination, or 0 when there is no free
+ * block below `c` that can hold `blocks`.
+ */
+static uint16_t umm_relocate_find_core(umm_heap_context_t *_context, uint16_t c, uint16_t blocks) {
+    uint16_t best = 0;
+
+    for (uint16_t cf = UMM_NFREE(0); cf; cf = UMM_NFREE(cf)) {
+        uint16_t blockSize = (UMM_NBLOCK(cf) & UMM_BLOCKNO_MASK) - cf;
+        if (cf < c && blockSize >= blocks && (0 == best || cf < best)) {
+            best = cf;
+        }
+    }
+
+    return best;
+}
+
+void *ICACHE_FLASH_ATTR umm_relocate_down(void *ptr) {
+    UMM_CRITICAL_DECL(id_realloc);
+
+    if (NULL == ptr) {
+        return NULL;
+    }
+
+    #ifdef UMM_SIZE_CLASSES
+    // Pool slots are fixed size and live in a reserved region, nothing to gain
+    if (umm_size_class_owns(ptr)) {
+        return ptr;
+    }
+    #endif
+
+    umm_heap_context_t *_context = umm_get_ptr_context(ptr);
+
+    UMM_CRITICAL_ENTRY(id_realloc);
+
+    uintptr_t base = (uintptr_t)ptr;
+    #if defined(UMM_POISON_CHECK) || defined(UMM_POISON_CHECK_LITE)
+    base -= sizeof(UMM_POISONED_BLOCK_LEN_TYPE) + UMM_POISON_SIZE_BEFORE;
+    #endif
+
+    uint16_t c = (base - (uintptr_t)(&(_context->heap[0]))) / sizeof(umm_block);
+    uint16_t blocks = (UMM_NBLOCK(c) & UMM_BLOCKNO_MASK) - c;
+    uint16_t cf = umm_relocate_find_core(_context, c, blocks);
+
+    if (cf) {
+        uint16_t blockSize = (UMM_NBLOCK(cf) & UMM_BLOCKNO_MASK) - cf;
+
+        POISON_CHECK_NEIGHBORS(cf);
+
+        UMM_FRAGMENTATION_METRIC_REMOVE(cf);
+
+        if (blockSize == blocks) {
+            umm_disconnect_from_free_list(_context, cf);
+        } else {
+            // Same split as umm_malloc_core(), the tail stays on the free list
+            umm_split_block(_context, cf, blocks, UMM_FREELIST_MASK);
+
+            UMM_FRAGMENTATION_METRIC_ADD(UMM_NBLOCK(cf));
+
+            UMM_NFREE(UMM_PFREE(cf)) = cf + blocks;
+            UMM_PFREE(cf + blocks) = UMM_PFREE(cf);
+
+            UMM_PFREE(UMM_NFREE(cf)) = cf + blocks;
+            UMM_NFREE(cf + blocks) = UMM_NFREE(cf);
+        }
+
+        STATS__FREE_BLOCKS_UPDATE(-blocks);
+
+        /*
+         * The destination lies wholly below `c`, the copy cannot overlap. Copy
+         * the whole body, so when poison is in use the pointer we return keeps
+         * the same offset into the block and the poison travels along.
+         */
+        size_t offset = (uintptr_t)ptr - (uintptr_t)&UMM_DATA(c);
+        memcpy(&UMM_DATA(cf), &UMM_DATA(c), (size_t)blocks * sizeof(umm_block) - sizeof(((umm_block *)0)->header));
+        umm_free_core(_context, &UMM_DATA(c));
+
+        ptr = (void *)((uintptr_t)&UMM_DATA(cf) + offset);
+    }
+
+    UMM_CRITICAL_EXIT(id_realloc);
+
+    return ptr;
+}
+
+#endif // defined(BUILD_UMM_MALLOC_C)
@@ -106,4 +106,100 @@ size_t _heap_id;
 #endif
 };
 
+/*
+  Allocations can also select the heap by what the memory is used for,
+  leaving the choice to the build's heap configuration:
+
+  HeapIntent::Fast       Data accessed byte-wise or in hot paths.  Always
+                         DRAM, IRAM only supports 32-bit loads and stores
+                         and anything else goes through the slow non32xfer
+                         exception handler.
+  HeapIntent::Dma        Buffers handed to the SLC/I2S DMA engines, which
+                         can only reach DRAM.
+  HeapIntent::LargeCold  Buffers accessed as aligned 32-bit words, or only
+                         rarely.  IRAM heap when the build has one, leaving
+                         DRAM to the rest.
+
+  {
+      HeapSelectIntent lock(HeapIntent::LargeCold);
+      // allocate memory here
+  }
+
+  Or with the fallback to DRAM when the preferred heap is full:
+
+  uint32_t *words = (uint32_t *)malloc_intent(size, HeapIntent::LargeCold);
+  auto buf = heap_alloc_by_intent(HeapIntent::LargeCold, [=]() {
+      return new (std::nothrow) unsigned char[size];
+  });
+ */
+
+enum class HeapIntent {
+    Fast,
+    Dma,
+    LargeCold,
+};
+
+#if (UMM_NUM_HEAPS != 1)
+constexpr size_t heap_id_by_intent(HeapIntent intent) {
+#ifdef UMM_HEAP_IRAM
+    if (intent == HeapIntent::LargeCold) {
+        return UMM_HEAP_IRAM;
+    }
+#else
+    (void)intent;
+#endif
+    return UMM_HEAP_DRAM;
+}
+#endif
+
+class HeapSelectIntent {
+public:
+#if (UMM_NUM_HEAPS == 1)
+MAYBE_ALWAYS_INLINE
+HeapSelectIntent(HeapIntent intent) {
+    (void)intent;
+}
+MAYBE_ALWAYS_INLINE
+~HeapSelectIntent() {
+}
+#else
+MAYBE_ALWAYS_INLINE
+HeapSelectIntent(HeapIntent intent) : _heap_id(umm_get_current_heap_id()) {
+    umm_set_heap_by_id(heap_id_by_intent(intent));
+}
+
+MAYBE_ALWAYS_INLINE
+~HeapSelectIntent() {
+    umm_set_heap_by_id(_heap_id);
+}
+
+protected:
+size_t _heap_id;
+#endif
+};
+
+// Call alloc with the heap preferred for intent selected, and again with
+// DRAM selected when it returned nothing, for any allocator: malloc, new,
+// make_shared...
+template <typename Alloc>
+inline auto heap_alloc_by_intent(HeapIntent intent, Alloc alloc) -> decltype(alloc()) {
+    {
+        HeapSelectIntent preferred(intent);
+        auto ptr = alloc();
+#if (UMM_NUM_HEAPS == 1)
+        return ptr;
+#else
+        if (ptr || heap_id_by_intent(intent) == UMM_HEAP_DRAM) {
+            return ptr;
+        }
+#endif
+    }
+    HeapSelectDram alternate;
+    return alloc();
+}
+
+inline void *malloc_intent(size_t size, HeapIntent intent) {
+    return heap_alloc_by_intent(intent, [size]() { return malloc(size); });
+}
+
 #endif // UMM_MALLOC_SELECT_H
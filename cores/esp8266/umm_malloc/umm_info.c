@@ -130,6 +130,10 @@ void *umm_info(void *ptr, bool force) {
 
     DBGLOG_FORCE(force, "+----------+-------+--------+--------+-------+--------+--------+\n");
 
+    #ifdef UMM_SIZE_CLASSES
+    umm_size_class_info(_context);
+    #endif
+
     DBGLOG_FORCE(force, "Total Entries %5d    Used Entries %5d    Free Entries %5d\n",
         _context->info.totalEntries,
         _context->info.usedEntries,
@@ -10,9 +10,18 @@
 #undef memcpy
 #undef memmove
 #undef memset
+#ifdef UMM_HEAP_EXTERNAL
+// Moves blocks of the external heap with SPI bursts instead of an exception
+// per load or store, and blocks of the other heaps with the plain functions
+#include "core_esp8266_vm.h"
+#define memcpy vm_memcpy
+#define memmove vm_memmove
+#define memset vm_memset
+#else
 #define memcpy ets_memcpy
 #define memmove ets_memmove
 #define memset ets_memset
+#endif
 
 
 /*
@@ -34,7 +43,7 @@ static size_t umm_uadd_sat(const size_t a, const size_t b);
 // #define DBGLOG_FORCE(force, format, ...) {if(force) {::printf(PSTR(format), ## __VA_ARGS__);}}
 
 
-#if defined(DEBUG_ESP_OOM) || defined(UMM_POISON_CHECK) || defined(UMM_POISON_CHECK_LITE) || defined(UMM_INTEGRITY_CHECK)
+#if defined(DEBUG_ESP_OOM) || defined(UMM_POISON_CHECK) || defined(UMM_POISON_CHECK_LITE) || defined(UMM_INTEGRITY_CHECK) || defined(UMM_HEAP_TRACE)
 #else
 
 #define umm_malloc(s)    malloc(s)
@@ -55,6 +64,18 @@ void ICACHE_FLASH_ATTR umm_print_stats(int force);
 
 
 
+#ifdef UMM_SIZE_CLASSES
+static void umm_size_class_init(void);
+static void *umm_size_class_malloc(umm_heap_context_t *_context, size_t size);
+static bool umm_size_class_owns(const void *ptr);
+static void umm_size_class_free(void *ptr);
+static void *umm_size_class_realloc(void *ptr, size_t size);
+#ifdef UMM_INFO
+static void umm_size_class_info(umm_heap_context_t *_context);
+#endif
+#endif
+
+
 int ICACHE_FLASH_ATTR umm_info_safe_printf_P(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
 #define UMM_INFO_PRINTF(fmt, ...) umm_info_safe_printf_P(PSTR(fmt),##__VA_ARGS__)
 
@@ -467,6 +467,10 @@ static uint16_t umm_assimilate_down(umm_heap_context_t *_context, uint16_t c, ui
 // Freeup IRAM
 #define ICACHE_MAYBE ICACHE_FLASH_ATTR
 #endif
+
+#include "umm_size_class.c" // optional small allocation front-end
+#include "umm_compact.c"    // relocation for movable allocations
+
 /*
  * In this port, we split the upstream version of umm_init_heap() into two
  * parts: _umm_init_heap and umm_init_heap. Then add multiple heap support.
@@ -563,6 +567,10 @@ void ICACHE_MAYBE umm_init(void) {
     // Note, full_init must be true for the primary heap, DRAM.
     umm_init_heap(UMM_HEAP_DRAM, (void *)UMM_MALLOC_CFG_HEAP_ADDR, UMM_MALLOC_CFG_HEAP_SIZE, true);
 
+    #ifdef UMM_SIZE_CLASSES
+    umm_size_class_init();
+    #endif
+
     // upstream ref:
     //   Initialize the heap from linker supplied values */
     //   umm_init_heap(UMM_MALLOC_CFG_HEAP_ADDR, UMM_MALLOC_CFG_HEAP_SIZE);
@@ -678,6 +686,13 @@ void umm_free(void *ptr) {
         return;
     }
 
+    #ifdef UMM_SIZE_CLASSES
+    if (umm_size_class_owns(ptr)) {
+        umm_size_class_free(ptr);
+        return;
+    }
+    #endif
+
     /* Free the memory within a protected critical section */
 
     UMM_CRITICAL_ENTRY(id_free);
@@ -889,6 +904,13 @@ void *umm_malloc(size_t size) {
         return ptr;
     }
 
+    #ifdef UMM_SIZE_CLASSES
+    ptr = umm_size_class_malloc(_context, size);
+    if (ptr) {
+        return ptr;
+    }
+    #endif
+
     /* Allocate the memory within a protected critical section */
 
     UMM_CRITICAL_ENTRY(id_malloc);
@@ -944,6 +966,12 @@ void *umm_realloc(void *ptr, size_t size) {
         return umm_malloc(size);
     }
 
+    #ifdef UMM_SIZE_CLASSES
+    if (umm_size_class_owns(ptr)) {
+        return umm_size_class_realloc(ptr, size);
+    }
+    #endif
+
     /*
      * Now we're sure that we have a non_NULL ptr, but we're not sure what
      * we should do with it. If the size is 0, then the ANSI C standard says that
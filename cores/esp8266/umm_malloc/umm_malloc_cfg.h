@@ -355,6 +355,104 @@ size_t umm_get_free_null_count(void);
 #define STATS__FREE_REQUEST(tag)          (void)0
 #endif
 
+/*
+ * -D UMM_HEAP_TRACE :
+ *
+ * Build option to record an allocation timeline. Each malloc, calloc,
+ * realloc, zalloc and free call (including the SDK pvPort... variants and
+ * operator new) appends one 16 bytes entry to a RAM ring buffer of
+ * UMM_HEAP_TRACE_ENTRIES entries: time in microseconds, caller address,
+ * resulting (or freed) pointer, requested size. The oldest entries are
+ * overwritten.
+ *
+ * umm_heap_trace_get() copies the most recent entries, oldest first.
+ * umm_heap_trace_print() formats them for output through a character
+ * printer, ie. `umm_heap_trace_print([](char c) { Serial.write(c); });`.
+ * The timeline is also printed by the postmortem report after a crash.
+ * Caller addresses can be decoded like a stack dump.
+ */
+/*
+#define UMM_HEAP_TRACE
+ */
+#ifdef UMM_HEAP_TRACE
+#ifndef UMM_HEAP_TRACE_ENTRIES
+#define UMM_HEAP_TRACE_ENTRIES 128
+#endif
+
+#define UMM_HEAP_TRACE_MALLOC  1
+#define UMM_HEAP_TRACE_CALLOC  2
+#define UMM_HEAP_TRACE_REALLOC 3
+#define UMM_HEAP_TRACE_FREE    4
+
+typedef struct UMM_HEAP_TRACE_ENTRY_t {
+    uint32_t time_us;
+    const void *caller;
+    const void *ptr;
+    uint32_t size : 24;
+    uint32_t op : 8;
+}
+UMM_HEAP_TRACE_ENTRY;
+
+void umm_heap_trace_enable(bool enable);
+size_t umm_heap_trace_get(UMM_HEAP_TRACE_ENTRY *dst, size_t count);
+void umm_heap_trace_print(void (*putc)(char));
+void *umm_heap_trace_new(size_t size, const void *caller);
+#endif
+
+/*
+ * -D UMM_SIZE_CLASSES :
+ *
+ * Build option to add a segregated free list front-end for small DRAM
+ * allocations. At umm_init(), one region of UMM_SIZE_CLASSES_SLOTS slots is
+ * carved from the DRAM Heap for each size class (16, 32, 48 and 64 bytes).
+ * malloc() requests up to 64 bytes are served by popping a slot of the
+ * smallest fitting class, free() pushes it back. Both are O(1), no best-fit
+ * search is needed. Larger requests, requests for other Heaps, and requests
+ * made while a class is exhausted fall through to umm_malloc.
+ *
+ * Free slots are accounted as free Heap (one free entry per slot), so
+ * ESP.getFreeHeap(), umm_info() and ESP.getHeapFragmentation() remain
+ * consistent with the memory that can actually be allocated.
+ *
+ * Not available with UMM_POISON_CHECK or UMM_POISON_CHECK_LITE, slots do
+ * not carry poison.
+ */
+/*
+#define UMM_SIZE_CLASSES
+ */
+#if defined(UMM_SIZE_CLASSES) && (defined(UMM_POISON_CHECK) || defined(UMM_POISON_CHECK_LITE))
+#warning "UMM_SIZE_CLASSES is not supported with UMM_POISON_CHECK(_LITE), disabled."
+#undef UMM_SIZE_CLASSES
+#endif
+
+#ifdef UMM_SIZE_CLASSES
+#ifndef UMM_SIZE_CLASSES_SLOTS
+#define UMM_SIZE_CLASSES_SLOTS 16
+#endif
+#define UMM_SIZE_CLASSES_NUM 4
+#define UMM_SIZE_CLASSES_MAX_SIZE 64
+
+typedef struct UMM_SIZE_CLASS_STATS_t {
+    size_t size;        // slot size in bytes
+    size_t slots;       // number of slots
+    size_t used;        // slots currently allocated
+    size_t used_max;    // high-water mark
+    size_t hits;        // requests served by this class
+    size_t misses;      // requests forwarded to umm_malloc, class exhausted
+}
+UMM_SIZE_CLASS_STATS;
+
+extern bool umm_size_class_stats(size_t index, UMM_SIZE_CLASS_STATS *stats);
+#endif
+
+/*
+ * umm_relocate_down(ptr) moves the allocation `ptr` into the lowest addressed
+ * free block below it that can hold it and returns the new address, or `ptr`
+ * when it cannot be moved. Any other copy of `ptr` is invalid after the call.
+ * Intended for allocations with a single owner, see MovableBuffer.h.
+ */
+extern void *umm_relocate_down(void *ptr);
+
 /*
   Per Devyte, the core currently doesn't support masking a specific interrupt
   level. That doesn't mean it can't be implemented, only that at this time
@@ -52,9 +52,15 @@
  * Start addresses and the size of the heap
  */
 extern char _heap_start[];
+#if defined(HOST_MOCK)
+// The simulated heap of tests/host/umm/umm_sim.cpp
+#define UMM_MALLOC_CFG_HEAP_ADDR   ((uintptr_t)&_heap_start[0])
+#define UMM_MALLOC_CFG_HEAP_SIZE   ((size_t)UMM_HOST_HEAP_SIZE)
+#else
 #define UMM_HEAP_END_ADDR          0x3FFFC000UL
 #define UMM_MALLOC_CFG_HEAP_ADDR   ((uint32_t)&_heap_start[0])
 #define UMM_MALLOC_CFG_HEAP_SIZE   ((size_t)(UMM_HEAP_END_ADDR - UMM_MALLOC_CFG_HEAP_ADDR))
+#endif
 
 /*
  * Define active Heaps
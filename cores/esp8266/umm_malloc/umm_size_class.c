@@ -0,0 +1,223 @@
+/*
+ * Segregated free list front-end for small DRAM allocations.
+ *
+ * Build option -DUMM_SIZE_CLASSES, see umm_malloc_cfg.h for details.
+ *
+ * Each size class owns a contiguous region carved from the DRAM Heap at
+ * umm_init(). Free slots are chained through their first word. Ownership of
+ * a pointer is determined by its address, no header is needed per slot.
+ */
+#if defined(BUILD_UMM_MALLOC_C)
+
+#ifdef UMM_SIZE_CLASSES
+
+static void *umm_malloc_core(umm_heap_context_t *_context, size_t size);
+
+typedef struct umm_size_class_t {
+    void *free_list;
+    char *start;
+    char *end;
+    uint16_t size;
+    uint16_t used;
+    uint16_t used_max;
+    size_t hits;
+    size_t misses;
+} umm_size_class;
+
+static const uint16_t umm_size_class_sizes[UMM_SIZE_CLASSES_NUM] = { 16, 32, 48, 64 };
+
+// Like heap_context[], we may be used before the "C" runtime init has run.
+static umm_size_class umm_size_classes[UMM_SIZE_CLASSES_NUM] __attribute__((section(".noinit")));
+static char *umm_size_class_start __attribute__((section(".noinit")));
+static char *umm_size_class_end __attribute__((section(".noinit")));
+
+/*
+ * Free slots are reported as free Heap blocks. Keep UMM_FREE_BLOCKS and the
+ * inline fragmentation metric in step with each slot pop/push.
+ */
+static void umm_size_class_account(umm_heap_context_t *_context, const umm_size_class *sc, int sign) {
+    int blocks = sc->size / sizeof(umm_block);
+    STATS__FREE_BLOCKS_UPDATE(sign * blocks);
+    #ifdef UMM_INLINE_METRICS
+    _context->info.freeBlocks += sign * blocks;
+    _context->info.freeBlocksSquared += sign * blocks * blocks;
+    #endif
+    (void)_context;
+}
+
+static void ICACHE_MAYBE umm_size_class_init(void) {
+    umm_heap_context_t *_context = umm_get_heap_by_id(UMM_HEAP_DRAM);
+    size_t total = 0;
+
+    memset(umm_size_classes, 0, sizeof(umm_size_classes));
+    umm_size_class_start = NULL;
+    umm_size_class_end = NULL;
+
+    for (size_t i = 0; i < UMM_SIZE_CLASSES_NUM; i++) {
+        total += umm_size_class_sizes[i] * UMM_SIZE_CLASSES_SLOTS;
+    }
+
+    char *region = (char *)umm_malloc_core(_context, total);
+    if (NULL == region) {
+        return;
+    }
+
+    umm_size_class_start = region;
+    umm_size_class_end = region + total;
+
+    for (size_t i = 0; i < UMM_SIZE_CLASSES_NUM; i++) {
+        umm_size_class *sc = &umm_size_classes[i];
+        sc->size = umm_size_class_sizes[i];
+        sc->start = region;
+        region += sc->size * UMM_SIZE_CLASSES_SLOTS;
+        sc->end = region;
+
+        // Chain the slots, lowest address first
+        for (size_t n = UMM_SIZE_CLASSES_SLOTS; n > 0; n--) {
+            char *slot = sc->start + (n - 1) * sc->size;
+            *(void **)slot = sc->free_list;
+            sc->free_list = slot;
+            umm_size_class_account(_context, sc, 1);
+        }
+    }
+}
+
+static bool umm_size_class_owns(const void *ptr) {
+    return (const char *)ptr >= umm_size_class_start && (const char *)ptr < umm_size_class_end;
+}
+
+static umm_size_class *umm_size_class_of(const void *ptr) {
+    for (size_t i = 0; i < UMM_SIZE_CLASSES_NUM; i++) {
+        if ((const char *)ptr < umm_size_classes[i].end) {
+            return &umm_size_classes[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Returns NULL when the request has to be served by umm_malloc.
+ */
+static void *umm_size_class_malloc(umm_heap_context_t *_context, size_t size) {
+    UMM_CRITICAL_DECL(id_malloc);
+    void *ptr = NULL;
+
+    if (size > UMM_SIZE_CLASSES_MAX_SIZE || NULL == umm_size_class_start) {
+        return NULL;
+    }
+
+    UMM_CRITICAL_ENTRY(id_malloc);
+
+    // Not for IRAM or external Heap requests, ISR requests are always DRAM
+    if (UMM_HEAP_DRAM == _context->id || UMM_CRITICAL_WITHINISR(id_malloc)) {
+        _context = umm_get_heap_by_id(UMM_HEAP_DRAM);
+        for (size_t i = 0; i < UMM_SIZE_CLASSES_NUM; i++) {
+            umm_size_class *sc = &umm_size_classes[i];
+            if (size > sc->size) {
+                continue;
+            }
+            if (sc->free_list) {
+                ptr = sc->free_list;
+                sc->free_list = *(void **)ptr;
+                if (++sc->used > sc->used_max) {
+                    sc->used_max = sc->used;
+                }
+                ++sc->hits;
+                umm_size_class_account(_context, sc, -1);
+            } else {
+                ++sc->misses;
+            }
+            break;
+        }
+    }
+
+    UMM_CRITICAL_EXIT(id_malloc);
+
+    return ptr;
+}
+
+static void umm_size_class_free(void *ptr) {
+    UMM_CRITICAL_DECL(id_free);
+    umm_heap_context_t *_context = umm_get_heap_by_id(UMM_HEAP_DRAM);
+    umm_size_class *sc = umm_size_class_of(ptr);
+
+    UMM_CRITICAL_ENTRY(id_free);
+
+    *(void **)ptr = sc->free_list;
+    sc->free_list = ptr;
+    --sc->used;
+    umm_size_class_account(_context, sc, 1);
+
+    UMM_CRITICAL_EXIT(id_free);
+}
+
+static void *umm_size_class_realloc(void *ptr, size_t size) {
+    umm_size_class *sc = umm_size_class_of(ptr);
+
+    if (0 == size) {
+        umm_size_class_free(ptr);
+        return NULL;
+    }
+
+    if (size <= sc->size) {
+        return ptr;
+    }
+
+    void *ret = umm_malloc(size);
+    if (ret) {
+        memcpy(ret, ptr, sc->size);
+        umm_size_class_free(ptr);
+    }
+
+    return ret;
+}
+
+#ifdef UMM_INFO
+/*
+ * Called by umm_info() with the critical section held, after the heap walk.
+ * The pool region was seen as one used entry, move its free slots to the free
+ * figures.
+ */
+static void umm_size_class_info(umm_heap_context_t *_context) {
+    if (UMM_HEAP_DRAM != _context->id) {
+        return;
+    }
+
+    for (size_t i = 0; i < UMM_SIZE_CLASSES_NUM; i++) {
+        const umm_size_class *sc = &umm_size_classes[i];
+        unsigned int free_slots = UMM_SIZE_CLASSES_SLOTS - sc->used;
+        unsigned int blocks = sc->size / sizeof(umm_block);
+        if (NULL == sc->start) {
+            continue;
+        }
+        _context->info.freeEntries += free_slots;
+        _context->info.freeBlocks += free_slots * blocks;
+        _context->info.freeBlocksSquared += free_slots * blocks * blocks;
+        _context->info.usedBlocks -= free_slots * blocks;
+    }
+}
+#endif
+
+bool ICACHE_FLASH_ATTR umm_size_class_stats(size_t index, UMM_SIZE_CLASS_STATS *stats) {
+    UMM_CRITICAL_DECL(id_no_tag);
+
+    if (index >= UMM_SIZE_CLASSES_NUM || NULL == stats) {
+        return false;
+    }
+
+    UMM_CRITICAL_ENTRY(id_no_tag);
+    const umm_size_class *sc = &umm_size_classes[index];
+    stats->size = umm_size_class_sizes[index];
+    stats->slots = sc->start ? UMM_SIZE_CLASSES_SLOTS : 0;
+    stats->used = sc->used;
+    stats->used_max = sc->used_max;
+    stats->hits = sc->hits;
+    stats->misses = sc->misses;
+    UMM_CRITICAL_EXIT(id_no_tag);
+
+    return true;
+}
+
+#endif // UMM_SIZE_CLASSES
+
+#endif // defined(BUILD_UMM_MALLOC_C)
@@ -185,6 +185,8 @@ void ArduinoOTAClass::_onRx(){
     _md5.trim();
     if(_md5.length() != 32)
       return;
+    // newer espota.py add the protocol they speak on a line of its own
+    _protocol = std::max(1, std::min(2, parseInt()));
 
     ota_ip = _ota_ip;
 
@@ -260,7 +262,13 @@ void ArduinoOTAClass::_runUpdate() {
     _state = OTA_IDLE;
     return;
   }
-  _udp_ota->append("OK", 2);
+  if (_protocol >= 2) {
+    char ok[24];
+    int len = snprintf(ok, sizeof(ok), "OK 2 %u", ARDUINOOTA_WINDOW);
+    _udp_ota->append(ok, len);
+  } else {
+    _udp_ota->append("OK", 2);
+  }
   _udp_ota->send(ota_ip, _ota_udp_port);
   delay(100);
 
@@ -287,11 +295,16 @@ void ArduinoOTAClass::_runUpdate() {
   // OTA sends little packets
   client.setNoDelay(true);
 
-  uint32_t written, total = 0;
+  // protocol 2 acknowledges the total written, every half window: the
+  // sender keeps streaming while the flash is written
+  uint32_t written, total = 0, acked = 0;
+  uint32_t start = millis();
   while (!Update.isFinished() && (client.connected() || client.available())) {
     int waited = 1000;
-    while (!client.available() && waited--)
-      delay(1);
+    while (!client.available() && waited--) {
+      if (!Update.preErase())
+        delay(1);
+    }
     if (!waited){
 #ifdef OTA_DEBUG
       OTA_DEBUG.printf("Receive Failed\n");
@@ -304,13 +317,24 @@ void ArduinoOTAClass::_runUpdate() {
     }
     written = Update.write(client);
     if (written > 0) {
-      client.print(written, DEC);
       total += written;
+      if (_protocol < 2) {
+        client.print(written, DEC);
+      } else if (total - acked >= ARDUINOOTA_WINDOW / 2 || Update.isFinished()) {
+        client.printf("%u\n", total);
+        acked = total;
+      }
       if(_progress_callback) {
         _progress_callback(total, _size);
       }
     }
   }
+  _received = total;
+  _transferTime = millis() - start;
+#ifdef OTA_DEBUG
+  OTA_DEBUG.printf("Received %u bytes in %lu ms (%lu B/s)\n", total, _transferTime,
+                   _transferTime ? (unsigned long)((uint64_t)total * 1000 / _transferTime) : 0);
+#endif
 
   if (Update.end()) {
     // Ensure last count packet has been sent out and not combined with the final OK
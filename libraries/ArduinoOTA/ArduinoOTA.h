@@ -7,6 +7,10 @@
 
 class UdpContext;
 
+#ifndef ARDUINOOTA_WINDOW
+#define ARDUINOOTA_WINDOW 16384 // bytes espota.py may send ahead of the acknowledged ones (protocol 2)
+#endif
+
 typedef enum {
   OTA_IDLE,
   OTA_WAITAUTH,
@@ -70,6 +74,11 @@ class ArduinoOTAClass
     //Gets update command type after OTA has started. Either U_FLASH or U_FS
     int getCommand();
 
+    //Transfer statistics of the last update: bytes received, and the time
+    //from the connection to the last byte in ms
+    unsigned int getReceived() { return _received; }
+    unsigned long getTransferTime() { return _transferTime; }
+
   private:
     void _runUpdate(void);
     void _onRx(void);
@@ -91,6 +100,9 @@ class ArduinoOTAClass
     uint16_t _ota_udp_port = 0;
     IPAddress _ota_ip;
     String _md5;
+    int _protocol = 1; // 1: acknowledges each write, 2: cumulative acknowledgements over a window
+    unsigned int _received = 0;
+    unsigned long _transferTime = 0;
 
     THandlerFunction _start_callback = nullptr;
     THandlerFunction _end_callback = nullptr;
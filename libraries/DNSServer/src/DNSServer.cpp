@@ -50,6 +50,141 @@ extern struct rst_info resetInfo;
 
 #define DNS_HEADER_SIZE sizeof(DNSHeader)
 
+// Name, type and class of the question
+#define DNS_MAX_QUERY_LENGTH (MAX_DNSNAME_LENGTH + 2 + 4)
+// Name pointer, type, class, TTL, data length and IPv4 address
+#define DNS_ANSWER_A_LENGTH 16
+
+#define DNS_QTYPE_OPT 41
+
+// `name` in DNS wire format ("www.Example.com" -> "\3www\7example\3com\0"),
+// lower case, into `wire` of MAX_DNSNAME_LENGTH + 2 bytes.
+// Returns its length, 0 for a malformed name
+static size_t compileName(const char *name, uint8_t *wire)
+{
+  size_t length = 0;
+  while (*name) {
+    const char *dot = strchr(name, '.');
+    size_t labelLength = dot ? (size_t)(dot - name) : strlen(name);
+    if (labelLength == 0 || labelLength > 63
+        || length + 1 + labelLength + 1 > MAX_DNSNAME_LENGTH + 2) {
+      return 0;
+    }
+    wire[length++] = labelLength;
+    while (labelLength--) {
+      wire[length++] = tolower(*name++);
+    }
+    if (*name == '.') {
+      ++name;
+    }
+  }
+  wire[length++] = 0;
+  return length;
+}
+
+// Compares a compiled name with a name of the request, checked by the parser
+static bool sameName(const uint8_t *wire, size_t wireLength, const uint8_t *name)
+{
+  for (size_t i = 0; i < wireLength; ) {
+    uint8_t labelLength = wire[i];
+    if (name[i] != labelLength) {
+      return false;
+    }
+    if (labelLength == 0) {
+      return i + 1 == wireLength;
+    }
+    for (size_t end = i + 1 + labelLength; ++i < end; ) {
+      if (tolower(name[i]) != wire[i]) {
+        return false;
+      }
+    }
+  }
+  return false;
+}
+
+static uint8_t *putNBOShort(uint8_t *out, uint16_t value)
+{
+  out[0] = value >> 8;
+  out[1] = value;
+  return out + 2;
+}
+
+static uint16_t getNBOShort(const uint8_t *in)
+{
+  return (in[0] << 8) | in[1];
+}
+
+static uint32_t getNBOLong(const uint8_t *in)
+{
+  return ((uint32_t)getNBOShort(in) << 16) | getNBOShort(in + 2);
+}
+
+// Offset after the name at `offset` of a message, compressed or not, 0 if
+// it is malformed
+static size_t skipName(const uint8_t *buffer, size_t length, size_t offset)
+{
+  while (offset < length) {
+    uint8_t labelLength = buffer[offset];
+    if (labelLength == 0) {
+      return offset + 1;
+    }
+    if ((labelLength & 0xC0) == 0xC0) {
+      return (offset + 2 <= length) ? offset + 2 : 0;
+    }
+    if (labelLength > 63) {
+      return 0;
+    }
+    offset += 1 + labelLength;
+  }
+  return 0;
+}
+
+// Calls `fn` with the offset of the TTL of each of the `records` resource
+// records from `offset` of a response (but the EDNS one, whose TTL isn't).
+// Returns false when they are malformed
+template <typename Fn>
+static bool forEachTTL(const uint8_t *buffer, size_t length, size_t offset, size_t records, Fn fn)
+{
+  while (records--) {
+    offset = skipName(buffer, length, offset);
+    if (offset == 0 || offset + 10 > length) {
+      return false;
+    }
+    if (getNBOShort(buffer + offset) != DNS_QTYPE_OPT) {
+      fn(offset + 4);
+    }
+    offset += 10 + getNBOShort(buffer + offset + 8);
+    if (offset > length) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static size_t countRecords(const DNSHeader *dnsHeader)
+{
+  return lwip_ntohs(dnsHeader->ANCount) + lwip_ntohs(dnsHeader->NSCount)
+         + lwip_ntohs(dnsHeader->ARCount);
+}
+
+// Same, with "*" as first label of `wire` standing for one label or more
+static bool matchName(const uint8_t *wire, size_t wireLength, const uint8_t *name)
+{
+  if (wireLength < 3 || wire[0] != 1 || wire[1] != '*') {
+    return sameName(wire, wireLength, name);
+  }
+  if (wireLength == 3) {
+    return true;
+  }
+  while (*name != 0) {
+    name += 1 + *name;
+    if (sameName(wire + 2, wireLength - 2, name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 // Want to keep IDs unique across restarts and continquious
 static uint32_t _ids __attribute__((section(".noinit")));
 
@@ -67,6 +202,193 @@ DNSServer::DNSServer()
   _ids += kDNSSQueSize;   // for the case of restart, ignore any inflight responses
 
   _errorReplyCode = DNSReplyCode::NonExistentDomain;
+  _recordsLength = 0;
+  _domainLength = 0;
+  _cacheSize = DNSSERVER_CACHE_ENTRIES;
+  _cacheClock = 0;
+  _cacheHits = 0;
+  _cacheMisses = 0;
+}
+
+bool DNSServer::addRecord(const String &name, const IPAddress &ip)
+{
+  uint8_t wire[MAX_DNSNAME_LENGTH + 2];
+  size_t wireLength = compileName(name.c_str(), wire);
+  if (wireLength <= 1) {
+    return false;
+  }
+
+  size_t entryLength = 1 + 4 + wireLength;
+  std::unique_ptr<uint8_t[]> records(new (std::nothrow) uint8_t[_recordsLength + entryLength]);
+  if (!records) {
+    return false;
+  }
+  if (_recordsLength) {
+    memcpy(records.get(), _records.get(), _recordsLength);
+  }
+  uint8_t *entry = records.get() + _recordsLength;
+  entry[0] = wireLength;
+  for (int i = 0; i < 4; i++) {
+    entry[1 + i] = ip[i];
+  }
+  memcpy(entry + 5, wire, wireLength);
+  _records = std::move(records);
+  _recordsLength += entryLength;
+  return true;
+}
+
+void DNSServer::clearRecords()
+{
+  _records = nullptr;
+  _recordsLength = 0;
+}
+
+// Address of the first record matching the name of the request, or nullptr
+const uint8_t *DNSServer::findRecord(const uint8_t *name)
+{
+  for (size_t i = 0; i < _recordsLength; i += 1 + 4 + _records[i]) {
+    if (matchName(&_records[i + 5], _records[i], name)) {
+      return &_records[i + 1];
+    }
+  }
+  return nullptr;
+}
+
+void DNSServer::setCacheSize(size_t entries)
+{
+  _cacheSize = entries;
+  clearCache();
+}
+
+void DNSServer::clearCache()
+{
+  _cache = nullptr;
+}
+
+// The entry for the same question, case insensitive in the name, or nullptr
+DNSS_CACHE_ENTRY *DNSServer::findCached(const uint8_t *query, size_t queryLength)
+{
+  if (!_cache) {
+    return nullptr;
+  }
+  for (size_t i = 0; i < _cacheSize; i++) {
+    DNSS_CACHE_ENTRY &entry = _cache[i];
+    if (entry.response && entry.queryLength == queryLength
+        && sameName(&entry.response[DNS_HEADER_SIZE], queryLength - 4, query)
+        && memcmp(&entry.response[DNS_HEADER_SIZE + queryLength - 4], query + queryLength - 4, 4) == 0) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+// Keeps an answer of the forwarder's `dns` server, all of its TTLs set to
+// the lowest one
+void DNSServer::cacheResponse(const uint8_t *buffer, size_t length)
+{
+  DNSHeader dnsHeader;
+  size_t queryEnd;
+  uint32_t ttl = UINT32_MAX;
+
+  if (_cacheSize == 0) {
+    return;
+  }
+  memcpy(&dnsHeader, buffer, DNS_HEADER_SIZE);
+  if (dnsHeader.QR != DNS_QR_RESPONSE || dnsHeader.TC
+      || dnsHeader.RCode != (unsigned char)DNSReplyCode::NoError
+      || dnsHeader.QDCount != lwip_htons(1) || dnsHeader.ANCount == 0) {
+    return;
+  }
+  queryEnd = skipName(buffer, length, DNS_HEADER_SIZE);
+  if (queryEnd == 0 || queryEnd + 4 > length) {
+    return;
+  }
+  queryEnd += 4;
+  if (!forEachTTL(buffer, length, queryEnd, countRecords(&dnsHeader),
+                  [&](size_t at) { ttl = std::min(ttl, getNBOLong(buffer + at)); })
+      || ttl == 0 || ttl == UINT32_MAX) {
+    return;
+  }
+
+  if (!_cache) {
+    _cache.reset(new (std::nothrow) DNSS_CACHE_ENTRY[_cacheSize]);
+    if (!_cache) {
+      return;
+    }
+  }
+  // Replaces the entry of the same question, else an empty one, else the
+  // least recently used
+  DNSS_CACHE_ENTRY *entry = findCached(buffer + DNS_HEADER_SIZE, queryEnd - DNS_HEADER_SIZE);
+  for (size_t i = 0; !entry && i < _cacheSize; i++) {
+    if (!_cache[i].response) {
+      entry = &_cache[i];
+    }
+  }
+  if (!entry) {
+    entry = &_cache[0];
+    for (size_t i = 1; i < _cacheSize; i++) {
+      if (_cacheClock - _cache[i].used > _cacheClock - entry->used) {
+        entry = &_cache[i];
+      }
+    }
+  }
+  entry->response.reset(new (std::nothrow) uint8_t[length]);
+  if (!entry->response) {
+    return;
+  }
+  memcpy(entry->response.get(), buffer, length);
+  forEachTTL(buffer, length, queryEnd, countRecords(&dnsHeader), [&](size_t at) {
+    putNBOShort(putNBOShort(&entry->response[at], ttl >> 16), ttl);
+  });
+  entry->length = length;
+  entry->queryLength = queryEnd - DNS_HEADER_SIZE;
+  entry->stored = millis();
+  entry->ttl = ttl;
+  entry->used = ++_cacheClock;
+}
+
+// Answers a request to be forwarded with a cached response, TTLs aged
+bool DNSServer::replyFromCache(const uint8_t *buffer, size_t length)
+{
+  DNSS_CACHE_ENTRY *entry = findCached(buffer + DNS_HEADER_SIZE, length - DNS_HEADER_SIZE);
+  if (!entry) {
+    ++_cacheMisses;
+    return false;
+  }
+  uint32_t age = ((uint32_t)millis() - entry->stored) / 1000;
+  if (age >= entry->ttl) {
+    entry->response = nullptr;
+    ++_cacheMisses;
+    return false;
+  }
+
+  DNSHeader request, dnsHeader;
+  memcpy(&request, buffer, DNS_HEADER_SIZE);
+  memcpy(&dnsHeader, entry->response.get(), DNS_HEADER_SIZE);
+  dnsHeader.ID = request.ID;
+  dnsHeader.RD = request.RD;
+  memcpy(entry->response.get(), &dnsHeader, DNS_HEADER_SIZE);
+  uint32_t ttl = entry->ttl - age;
+  forEachTTL(entry->response.get(), entry->length, DNS_HEADER_SIZE + entry->queryLength,
+             countRecords(&dnsHeader), [&](size_t at) {
+    putNBOShort(putNBOShort(&entry->response[at], ttl >> 16), ttl);
+  });
+  entry->used = ++_cacheClock;
+  ++_cacheHits;
+  _udp.queuePacket(_udp.remoteIP(), _udp.remotePort(), entry->response.get(), entry->length);
+  return true;
+}
+
+void DNSServer::compileDomainName()
+{
+  uint8_t wire[MAX_DNSNAME_LENGTH + 2];
+  _domainLength = compileName(_domainName.c_str(), wire);
+  _domain.reset(_domainLength ? new (std::nothrow) uint8_t[_domainLength] : nullptr);
+  if (_domain) {
+    memcpy(_domain.get(), wire, _domainLength);
+  } else {
+    _domainLength = 0;
+  }
 }
 
 void DNSServer::disableForwarder(const String &domainName, bool freeResources)
@@ -75,9 +397,11 @@ void DNSServer::disableForwarder(const String &domainName, bool freeResources)
   if (!domainName.isEmpty()) {
     _domainName = domainName;
     downcaseAndRemoveWwwPrefix(_domainName);
+    compileDomainName();
   }
   if (freeResources) {
     _dns = (uint32_t)0;
+    clearCache();
     if (_que) {
       _que = nullptr;
       DEBUG_PRINTF("from stop, deleted _que\r\n");
@@ -165,13 +489,24 @@ void DNSServer::downcaseAndRemoveWwwPrefix(String &domainName)
       domainName.remove(0, 4);
 }
 
-void DNSServer::forwardReply(uint8_t *buffer, size_t length)
+void DNSServer::sendPacket(const IPAddress &ip, uint16_t port,
+			   const DNSHeader *dnsHeader,
+			   const uint8_t *data, size_t length)
+{
+  _udp.beginPacket(ip, port);
+  _udp.write((const uint8_t *)dnsHeader, DNS_HEADER_SIZE);
+  _udp.write(data, length);
+  _udp.endPacket();
+}
+
+void DNSServer::forwardReply(const uint8_t *buffer, size_t length)
 {
   if (!_forwarder || !_que) {
     return;
   }
-  DNSHeader *dnsHeader = (DNSHeader *)buffer;
-  uint16_t id = dnsHeader->ID;
+  DNSHeader dnsHeader;
+  memcpy(&dnsHeader, buffer, DNS_HEADER_SIZE);
+  uint16_t id = dnsHeader.ID;
   // if (kDNSSQueSize <= (uint16_t)((uint16_t)_ids - id)) {
   if ((uint16_t)kDNSSQueSize <= (uint16_t)_ids - id) {
     DEBUG_((++_que_drop));
@@ -185,20 +520,21 @@ void DNSServer::forwardReply(uint8_t *buffer, size_t length)
     DEBUG_PRINTLN2("Duplicate reply dropped ID: 0x", String(id, HEX));
     return;
   }
-  dnsHeader->ID = _que[i].id;
-  _udp.beginPacket(_que[i].ip, _que[i].port);
-  _udp.write(buffer, length);
-  _udp.endPacket();
+  dnsHeader.ID = _que[i].id;
+  sendPacket(_que[i].ip, _que[i].port, &dnsHeader,
+             buffer + DNS_HEADER_SIZE, length - DNS_HEADER_SIZE);
   DEBUG_PRINTLN2("Forward reply ID: 0x", (String(id, HEX) + F(" to ") + IPAddress(_que[i].ip).toString()));
   _que[i].ip = 0; // This gets used to detect duplicate packets and overflow
+  cacheResponse(buffer, length);
 }
 
-void DNSServer::forwardRequest(uint8_t *buffer, size_t length)
+void DNSServer::forwardRequest(const uint8_t *buffer, size_t length)
 {
   if (!_forwarder || !_dns.isSet() || !_que) {
     return;
   }
-  DNSHeader *dnsHeader = (DNSHeader *)buffer;
+  DNSHeader dnsHeader;
+  memcpy(&dnsHeader, buffer, DNS_HEADER_SIZE);
   ++_ids;
   size_t i = _ids & (kDNSSQueSize - 1);
   DEBUG_(({
@@ -208,23 +544,24 @@ void DNSServer::forwardRequest(uint8_t *buffer, size_t length)
   }));
   _que[i].ip = _udp.remoteIP();
   _que[i].port = _udp.remotePort();
-  _que[i].id = dnsHeader->ID;
-  dnsHeader->ID = (uint16_t)_ids;
-  _udp.beginPacket(_dns, IANA_DNS_PORT);
-  _udp.write(buffer, length);
-  _udp.endPacket();
-  DEBUG_PRINTLN2("Forward request ID: 0x", (String(dnsHeader->ID, HEX) + F(" to ") + _dns.toString()));
+  _que[i].id = dnsHeader.ID;
+  dnsHeader.ID = (uint16_t)_ids;
+  sendPacket(_dns, IANA_DNS_PORT, &dnsHeader,
+             buffer + DNS_HEADER_SIZE, length - DNS_HEADER_SIZE);
+  DEBUG_PRINTLN2("Forward request ID: 0x", (String(dnsHeader.ID, HEX) + F(" to ") + _dns.toString()));
 }
 
-bool DNSServer::respondToRequest(uint8_t *buffer, size_t length)
+// The request is parsed where it was received, `buffer` is read only:
+// replies are built from a copy of its header
+bool DNSServer::respondToRequest(const uint8_t *buffer, size_t length)
 {
-  DNSHeader *dnsHeader;
-  uint8_t *query, *start;
-  const char *matchString;
+  DNSHeader header;
+  DNSHeader *dnsHeader = &header;
+  const uint8_t *query, *start, *ip;
   size_t remaining, labelLength, queryLength;
   uint16_t qtype, qclass;
 
-  dnsHeader = (DNSHeader *)buffer;
+  memcpy(dnsHeader, buffer, DNS_HEADER_SIZE);
 
   // Must be a query for us to do anything with it
   if (dnsHeader->QR != DNS_QR_QUERY) {
@@ -259,7 +596,8 @@ bool DNSServer::respondToRequest(uint8_t *buffer, size_t length)
   remaining = length - DNS_HEADER_SIZE;
   while (remaining != 0 && *start != 0) {
     labelLength = *start;
-    if (labelLength + 1 > remaining) {
+    // No compression pointers (or extended labels) in the only question
+    if (labelLength > 63 || labelLength + 1 > remaining) {
       replyWithError(dnsHeader, DNSReplyCode::FormError);
       return false;
     }
@@ -268,7 +606,7 @@ bool DNSServer::respondToRequest(uint8_t *buffer, size_t length)
   }
 
   // 1 octet labelLength, 2 octet qtype, 2 octet qclass
-  if (remaining < 5)  {
+  if (remaining < 5 || (size_t)(start - query) > MAX_DNSNAME_LENGTH + 1)  {
     replyWithError(dnsHeader, DNSReplyCode::FormError);
     return false;
   }
@@ -294,6 +632,11 @@ bool DNSServer::respondToRequest(uint8_t *buffer, size_t length)
     return false;
   }
 
+  if ((ip = findRecord(query))) {
+    replyWithIP(dnsHeader, ip, query, queryLength);
+    return false;
+  }
+
   // If we have no domain name configured, just return an error
   if (_domainName.isEmpty()) {
     if (_forwarder) {
@@ -304,96 +647,79 @@ bool DNSServer::respondToRequest(uint8_t *buffer, size_t length)
     }
   }
 
-  // If we're running with a wildcard we can just return a result now
-  if (_domainName == "*") {
-    DEBUG_PRINTF("dnsServer - replyWithIP\r\n");
-    replyWithIP(dnsHeader, query, queryLength);
-    return false;
-  }
-
-  matchString = _domainName.c_str();
-
   start = query;
 
   // If there's a leading 'www', skip it
-  if (*start == 3 && strncasecmp("www", (char *) start + 1, 3) == 0)
+  if (*start == 3 && strncasecmp("www", (const char *) start + 1, 3) == 0)
       start += 4;
 
-  while (*start != 0) {
-    labelLength = *start;
-    start += 1;
-    while (labelLength > 0) {
-      if (tolower(*start) != *matchString) {
-        if (_forwarder) {
-          return true;
-        } else {
-          replyWithError(dnsHeader, _errorReplyCode, query, queryLength);
-          return false;
-        }
-      }
-      ++start;
-      ++matchString;
-      --labelLength;
-    }
-    if (*start == 0 && *matchString == '\0') {
-      replyWithIP(dnsHeader, query, queryLength);
-      return false;
-    }
-
-    if (*matchString != '.') {
-      replyWithError(dnsHeader, _errorReplyCode, query, queryLength);
-      return false;
-    }
-    ++matchString;
+  // A "*" domain name answers any name, see matchName()
+  if (matchName(_domain.get(), _domainLength, start)) {
+    DEBUG_PRINTF("dnsServer - replyWithIP\r\n");
+    replyWithIP(dnsHeader, _resolvedIP, query, queryLength);
+    return false;
   }
 
+  if (_forwarder) {
+    return true;
+  }
   replyWithError(dnsHeader, _errorReplyCode, query, queryLength);
   return false;
 }
 
 void DNSServer::processNextRequest()
 {
-  size_t currentPacketSize;
-
-  currentPacketSize = _udp.parsePacket();
-  if (currentPacketSize == 0)
-    return;
-
-  // The DNS RFC requires that DNS packets be less than 512 bytes in size,
-  // so just discard them if they are larger
-  if (currentPacketSize > MAX_DNS_PACKETSIZE)
-    return;
-
-  // If the packet size is smaller than the DNS header, then someone is
-  // messing with us
-  if (currentPacketSize < DNS_HEADER_SIZE)
-    return;
-
-  std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[currentPacketSize]);
-  if (buffer == nullptr)
-    return;
+  // Handle what was received since the last call, up to DNSSERVER_MAX_REQUESTS
+  // requests, replies are queued in pooled buffers and sent together
+  for (int i = 0; i < DNSSERVER_MAX_REQUESTS; i++) {
+    size_t currentPacketSize;
+
+    currentPacketSize = _udp.parsePacket();
+    if (currentPacketSize == 0)
+      break;
+
+    // The DNS RFC requires that DNS packets be less than 512 bytes in size,
+    // so just discard them if they are larger
+    if (currentPacketSize > MAX_DNS_PACKETSIZE)
+      continue;
+
+    // If the packet size is smaller than the DNS header, then someone is
+    // messing with us
+    if (currentPacketSize < DNS_HEADER_SIZE)
+      continue;
+
+    // In place in the received pbuf, copied only when that is a chain
+    const uint8_t *buffer = _udp.peekPacket();
+    std::unique_ptr<uint8_t[]> copy;
+    if (buffer == nullptr) {
+      copy.reset(new (std::nothrow) uint8_t[currentPacketSize]);
+      if (copy == nullptr)
+        continue;
+      buffer = _udp.peekPacket(copy.get(), currentPacketSize);
+      if (buffer == nullptr)
+        continue;
+    }
 
-  _udp.read(buffer.get(), currentPacketSize);
-  if (_dns.isSet() && _udp.remoteIP() == _dns) {
-    // _forwarder may have been set to false; however, for now allow inflight
-    // replys  to finish. //??
-    forwardReply(buffer.get(), currentPacketSize);
-  } else
-  if (respondToRequest(buffer.get(), currentPacketSize)) {
-    forwardRequest(buffer.get(), currentPacketSize);
+    if (_dns.isSet() && _udp.remoteIP() == _dns) {
+      // _forwarder may have been set to false; however, for now allow inflight
+      // replys  to finish. //??
+      forwardReply(buffer, currentPacketSize);
+    } else
+    if (respondToRequest(buffer, currentPacketSize)
+        && !replyFromCache(buffer, currentPacketSize)) {
+      forwardRequest(buffer, currentPacketSize);
+    }
   }
-}
-
-void DNSServer::writeNBOShort(uint16_t value)
-{
-   _udp.write((unsigned char *)&value, 2);
+  _udp.sendQueued();
 }
 
 void DNSServer::replyWithIP(DNSHeader *dnsHeader,
-			    unsigned char * query,
+			    const uint8_t *ip,
+			    const unsigned char *query,
 			    size_t queryLength)
 {
-  uint16_t value;
+  uint8_t reply[DNS_HEADER_SIZE + DNS_MAX_QUERY_LENGTH + DNS_ANSWER_A_LENGTH];
+  uint8_t *out;
 
   dnsHeader->QR = DNS_QR_RESPONSE;
   dnsHeader->QDCount = lwip_htons(1);
@@ -401,35 +727,39 @@ void DNSServer::replyWithIP(DNSHeader *dnsHeader,
   dnsHeader->NSCount = 0;
   dnsHeader->ARCount = 0;
 
-  _udp.beginPacket(_udp.remoteIP(), _udp.remotePort());
-  _udp.write((unsigned char *) dnsHeader, sizeof(DNSHeader));
-  _udp.write(query, queryLength);
+  memcpy(reply, dnsHeader, DNS_HEADER_SIZE);
+  memcpy(reply + DNS_HEADER_SIZE, query, queryLength);
+  out = reply + DNS_HEADER_SIZE + queryLength;
 
   // Rather than restate the name here, we use a pointer to the name contained
   // in the query section. Pointers have the top two bits set.
-  value = 0xC000 | DNS_HEADER_SIZE;
-  writeNBOShort(lwip_htons(value));
+  out = putNBOShort(out, 0xC000 | DNS_HEADER_SIZE);
 
   // Answer is type A (an IPv4 address)
-  writeNBOShort(lwip_htons(DNS_QTYPE_A));
+  out = putNBOShort(out, DNS_QTYPE_A);
 
   // Answer is in the Internet Class
-  writeNBOShort(lwip_htons(DNS_QCLASS_IN));
+  out = putNBOShort(out, DNS_QCLASS_IN);
 
   // Output TTL (already NBO)
-  _udp.write((unsigned char*)&_ttl, 4);
+  memcpy(out, &_ttl, 4);
+  out += 4;
 
   // Length of RData is 4 bytes (because, in this case, RData is IPv4)
-  writeNBOShort(lwip_htons(sizeof(_resolvedIP)));
-  _udp.write(_resolvedIP, sizeof(_resolvedIP));
-  _udp.endPacket();
+  out = putNBOShort(out, 4);
+  memcpy(out, ip, 4);
+  out += 4;
+
+  _udp.queuePacket(_udp.remoteIP(), _udp.remotePort(), reply, out - reply);
 }
 
 void DNSServer::replyWithError(DNSHeader *dnsHeader,
 			       DNSReplyCode rcode,
-			       unsigned char *query,
+			       const unsigned char *query,
 			       size_t queryLength)
 {
+  uint8_t reply[DNS_HEADER_SIZE + DNS_MAX_QUERY_LENGTH];
+
   dnsHeader->QR = DNS_QR_RESPONSE;
   dnsHeader->RCode = (unsigned char) rcode;
   if (query)
@@ -440,11 +770,12 @@ void DNSServer::replyWithError(DNSHeader *dnsHeader,
   dnsHeader->NSCount = 0;
   dnsHeader->ARCount = 0;
 
-  _udp.beginPacket(_udp.remoteIP(), _udp.remotePort());
-  _udp.write((unsigned char *)dnsHeader, sizeof(DNSHeader));
+  memcpy(reply, dnsHeader, DNS_HEADER_SIZE);
   if (query != NULL)
-     _udp.write(query, queryLength);
-  _udp.endPacket();
+     memcpy(reply + DNS_HEADER_SIZE, query, queryLength);
+  else
+     queryLength = 0;
+  _udp.queuePacket(_udp.remoteIP(), _udp.remotePort(), reply, DNS_HEADER_SIZE + queryLength);
 }
 
 void DNSServer::replyWithError(DNSHeader *dnsHeader,
@@ -25,6 +25,17 @@ constexpr inline uint16_t kIanaDnsPort = IANA_DNS_PORT;
 #define MAX_DNSNAME_LENGTH 253
 #define MAX_DNS_PACKETSIZE 512
 
+// Requests handled by one processNextRequest() call, their replies are sent
+// together
+#ifndef DNSSERVER_MAX_REQUESTS
+#define DNSSERVER_MAX_REQUESTS 4
+#endif
+
+// Forwarded answers kept by default, see setCacheSize()
+#ifndef DNSSERVER_CACHE_ENTRIES
+#define DNSSERVER_CACHE_ENTRIES 8
+#endif
+
 enum class DNSReplyCode
 {
   NoError = 0,
@@ -64,6 +75,15 @@ struct DNSS_REQUESTER {
   uint16_t id;
 };
 
+struct DNSS_CACHE_ENTRY {
+  std::unique_ptr<uint8_t[]> response; // TTLs all set to `ttl`
+  uint16_t length;
+  uint16_t queryLength;                // question, after the header
+  uint32_t stored;                     // millis()
+  uint32_t ttl;                        // seconds
+  uint32_t used;                       // for least recently used
+};
+
 class DNSServer
 {
   public:
@@ -74,7 +94,9 @@ class DNSServer
     /*
       If specified, `enableForwarder` will update the `domainName` that is used
       to match DNS request to this AP's IP Address. A non-matching request will
-      be forwarded to the DNS server specified by `dns`.
+      be forwarded to the DNS server specified by `dns`, for instance the one
+      of the station interface, `WiFi.dnsIP()`. Its answers are cached, see
+      `setCacheSize`.
 
       Returns `true` on success.
 
@@ -94,12 +116,38 @@ class DNSServer
     IPAddress getDNS() { return _dns; }
     bool isDNSSet() { return _dns.isSet(); }
 
+    /*
+      While forwarding, the answers of the `dns` server are kept for their
+      TTL in a cache of `entries` (each up to MAX_DNS_PACKETSIZE bytes), the
+      least recently used ones making room. Requests for the same name and
+      type are answered from it without being forwarded.
+      0 disables the cache. Setting the size empties it.
+    */
+    void setCacheSize(size_t entries);
+    void clearCache();
+    void getCacheStats(uint32_t &hits, uint32_t &misses) const {
+      hits = _cacheHits;
+      misses = _cacheMisses;
+    }
+
     void processNextRequest();
     void setErrorReplyCode(const DNSReplyCode &replyCode);
     void setTTL(const uint32_t &ttl);
     uint32_t getTTL();
     String getDomainName() { return _domainName; }
 
+    /*
+      `addRecord` adds a name answered with `ip`, looked up before the
+      `domainName` of `start`. A leading "*." makes it a wildcard: "*.lan"
+      answers for any name ending with ".lan" (but not for "lan"), "*" for any
+      name. Names are compiled here once, requests are matched and answered
+      without memory allocation.
+
+      Returns `false` for a malformed name or when out of memory.
+    */
+    bool addRecord(const String &name, const IPAddress &ip);
+    void clearRecords();
+
     // Returns true if successful, false if there are no sockets available
     bool start(const uint16_t &port,
               const String &domainName,
@@ -113,6 +161,17 @@ class DNSServer
     String _domainName;
     IPAddress _dns;
     std::unique_ptr<DNSS_REQUESTER[]> _que;
+    // Entries of name length, 4 address bytes and the name in DNS wire format
+    std::unique_ptr<uint8_t[]> _records;
+    size_t _recordsLength;
+    std::unique_ptr<DNSS_CACHE_ENTRY[]> _cache;
+    size_t _cacheSize;
+    uint32_t _cacheClock;
+    uint32_t _cacheHits;
+    uint32_t _cacheMisses;
+    // _domainName in DNS wire format
+    std::unique_ptr<uint8_t[]> _domain;
+    size_t _domainLength;
     uint32_t _ttl;
 #ifdef DEBUG_DNSSERVER
     // There are 2 possiblities for OverFlow:
@@ -127,18 +186,26 @@ class DNSServer
     uint16_t _port;
 
     void downcaseAndRemoveWwwPrefix(String &domainName);
+    void compileDomainName();
+    const uint8_t *findRecord(const uint8_t *name);
     void replyWithIP(DNSHeader *dnsHeader,
-		     unsigned char * query,
+		     const uint8_t *ip,
+		     const unsigned char *query,
 		     size_t queryLength);
     void replyWithError(DNSHeader *dnsHeader,
 			DNSReplyCode rcode,
-			unsigned char *query,
+			const unsigned char *query,
 			size_t queryLength);
     void replyWithError(DNSHeader *dnsHeader,
 			DNSReplyCode rcode);
-    bool respondToRequest(uint8_t *buffer, size_t length);
-    void forwardRequest(uint8_t *buffer, size_t length);
-    void forwardReply(uint8_t *buffer, size_t length);
-    void writeNBOShort(uint16_t value);
+    bool respondToRequest(const uint8_t *buffer, size_t length);
+    void forwardRequest(const uint8_t *buffer, size_t length);
+    void forwardReply(const uint8_t *buffer, size_t length);
+    DNSS_CACHE_ENTRY *findCached(const uint8_t *query, size_t queryLength);
+    void cacheResponse(const uint8_t *buffer, size_t length);
+    bool replyFromCache(const uint8_t *buffer, size_t length);
+    void sendPacket(const IPAddress &ip, uint16_t port,
+		    const DNSHeader *dnsHeader,
+		    const uint8_t *data, size_t length);
 };
 #endif
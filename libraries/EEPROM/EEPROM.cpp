@@ -32,6 +32,103 @@ extern "C" {
 }
 
 #include <flash_hal.h>
+#include <coredecls.h>
+
+// Log-structured mode, in each sector:
+//   LogHeader, written last when a sector is filled
+//   the content, LogHeader::size bytes
+//   records of what later commits changed, each one:
+//     magic and length of the body, crc32 of the body, written last
+//     the body: runs of changed bytes, a word of offset and length each,
+//     followed by the bytes, padded to a word
+//   erased flash
+// The sector with the greatest seq is the current one.
+
+struct LogHeader {
+  uint32_t magic;
+  uint32_t seq;
+  uint32_t size;
+  uint32_t crc;
+};
+
+static constexpr uint32_t logMagic = 0x4c504545;        // EEPL
+static constexpr uint32_t logRecordMagic = 0x5a5a0000;  // | body length
+static constexpr size_t logRunGap = 8;                  // equal bytes merged in a run
+
+// bytes staged in words, written to flash and added to the crc a chunk at a time
+class LogWriter {
+public:
+  LogWriter(uint32_t address) : _address(address) { }
+
+  void put(const void* data, size_t len) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (len--) {
+      reinterpret_cast<uint8_t*>(_buf)[_used++] = *bytes++;
+      if (_used == sizeof(_buf)) {
+        flush();
+      }
+    }
+  }
+
+  void pad() {
+    static const uint8_t erased[3] = { 0xff, 0xff, 0xff };
+    put(erased, (4 - (_used & 3)) & 3);
+  }
+
+  bool flush() {
+    if (_used) {
+      _ok = _ok && ESP.flashWrite(_address, _buf, _used);
+      _crc.add(_buf, _used);
+      _address += _used;
+      _used = 0;
+    }
+    return _ok;
+  }
+
+  uint32_t crc() const {
+    return _crc.value();
+  }
+
+private:
+  uint32_t _address;
+  uint32_t _buf[16];
+  size_t _used = 0;
+  Crc32 _crc;
+  bool _ok = true;
+};
+
+static uint32_t flashCrc(uint32_t address, size_t len) {
+  uint32_t buf[16];
+  Crc32 crc;
+  while (len) {
+    size_t chunk = std::min(len, sizeof(buf));
+    if (!ESP.flashRead(address, buf, chunk)) {
+      return ~crc.value();
+    }
+    crc.add(buf, chunk);
+    address += chunk;
+    len -= chunk;
+  }
+  return crc.value();
+}
+
+static bool flashErased(uint32_t address, size_t len) {
+  uint32_t buf[16];
+  while (len) {
+    size_t chunk = std::min(len, sizeof(buf));
+    if (!ESP.flashRead(address, buf, chunk)) {
+      return false;
+    }
+    for (size_t i = 0; i < chunk / 4; ++i) {
+      if (buf[i] != 0xffffffff) {
+        return false;
+      }
+    }
+    address += chunk;
+    len -= chunk;
+  }
+  return true;
+}
 
 EEPROMClass::EEPROMClass(uint32_t sector)
 : _sector(sector)
@@ -43,14 +140,21 @@ EEPROMClass::EEPROMClass(void)
 {
 }
 
+EEPROMClass::EEPROMClass(uint32_t sector, uint32_t sectorCount)
+: _sector(sector)
+, _sectorCount(std::min(std::max(sectorCount, (uint32_t)2), (uint32_t)32))
+{
+}
+
 void EEPROMClass::begin(size_t size) {
   if (size <= 0) {
     DEBUGV("EEPROMClass::begin error, size == 0\n");
     return;
   }
-  if (size > SPI_FLASH_SEC_SIZE) {
-    DEBUGV("EEPROMClass::begin error, %d > %d\n", size, SPI_FLASH_SEC_SIZE);
-    size = SPI_FLASH_SEC_SIZE;
+  size_t maxSize = _sectorCount > 1 ? SPI_FLASH_SEC_SIZE - sizeof(LogHeader) : SPI_FLASH_SEC_SIZE;
+  if (size > maxSize) {
+    DEBUGV("EEPROMClass::begin error, %d > %d\n", size, maxSize);
+    size = maxSize;
   }
 
   size = (size + 3) & (~3);
@@ -65,7 +169,13 @@ void EEPROMClass::begin(size_t size) {
 
   _size = size;
 
-  if (!ESP.flashRead(_sector * SPI_FLASH_SEC_SIZE, reinterpret_cast<uint32_t*>(_data), _size)) {
+  if (_sectorCount > 1) {
+    delete[] _shadow;
+    _shadow = new uint8_t[size];
+    if (!_logBegin()) {
+      DEBUGV("EEPROMClass::begin no log found\n");
+    }
+  } else if (!ESP.flashRead(_sector * SPI_FLASH_SEC_SIZE, reinterpret_cast<uint32_t*>(_data), _size)) {
     DEBUGV("EEPROMClass::begin flash read failed\n");
   }
 
@@ -84,6 +194,8 @@ bool EEPROMClass::end() {
     delete[] _data;
   }
   _data = 0;
+  delete[] _shadow;
+  _shadow = nullptr;
   _size = 0;
   _dirty = false;
 
@@ -119,7 +231,7 @@ void EEPROMClass::write(int const address, uint8_t const value) {
   if (*pData != value)
   {
     *pData = value;
-    _dirty = true;
+    _markDirty(address, address + 1);
   }
 }
 
@@ -131,7 +243,11 @@ bool EEPROMClass::commit() {
   if(!_data)
     return false;
 
-  if (ESP.flashEraseSector(_sector)) {
+  if (_sectorCount > 1 ? _logCommit() : _commitInPlace()) {
+    _dirty = false;
+    return true;
+  }
+  if (_sectorCount == 1 && ESP.flashEraseSector(_sector)) {
     if (ESP.flashWrite(_sector * SPI_FLASH_SEC_SIZE, reinterpret_cast<uint32_t*>(_data), _size)) {
       _dirty = false;
       return true;
@@ -142,8 +258,173 @@ bool EEPROMClass::commit() {
   return false;
 }
 
+bool EEPROMClass::_logBegin() {
+  memset(_data, 0xff, _size);
+  _active = -1;
+  _seq = 0;
+  _compact = true;
+
+  // the valid sector with the greatest seq, or the one before...
+  uint32_t tried = 0;
+  for (;;) {
+    int best = -1;
+    LogHeader header = { };
+    for (uint32_t i = 0; i < _sectorCount; ++i) {
+      LogHeader h;
+      if (!(tried & (1 << i))
+          && ESP.flashRead((_sector + i) * SPI_FLASH_SEC_SIZE, reinterpret_cast<uint32_t*>(&h), sizeof(h))
+          && h.magic == logMagic && h.size <= SPI_FLASH_SEC_SIZE - sizeof(h) && !(h.size & 3)
+          && (best < 0 || (int32_t)(h.seq - header.seq) > 0)) {
+        best = i;
+        header = h;
+      }
+    }
+    if (best < 0) {
+      memcpy(_shadow, _data, _size);
+      return false;
+    }
+    tried |= 1 << best;
+
+    uint32_t address = (_sector + best) * SPI_FLASH_SEC_SIZE;
+    if (flashCrc(address + sizeof(header), header.size) != header.crc
+        || !ESP.flashRead(address + sizeof(header), reinterpret_cast<uint32_t*>(_data), std::min(_size, (size_t)header.size))) {
+      continue;
+    }
+
+    // replayed up to the first record which is not whole
+    size_t pos = sizeof(header) + header.size;
+    bool torn = false;
+    while (pos + 8 <= SPI_FLASH_SEC_SIZE) {
+      uint32_t record[2];
+      if (!ESP.flashRead(address + pos, record, sizeof(record)) || record[0] == 0xffffffff) {
+        break;
+      }
+      size_t bodyLen = record[0] & 0xffff;
+      uint32_t* body = nullptr;
+      if ((record[0] & 0xffff0000) != logRecordMagic || (bodyLen & 3) || pos + 8 + bodyLen > SPI_FLASH_SEC_SIZE
+          || !(body = new (std::nothrow) uint32_t[bodyLen / 4])
+          || !ESP.flashRead(address + pos + 8, body, bodyLen) || crc32(body, bodyLen) != record[1]) {
+        delete[] body;
+        torn = true;
+        break;
+      }
+      const uint8_t* bytes = reinterpret_cast<const uint8_t*>(body);
+      for (size_t run = 0; run + 4 <= bodyLen; ) {
+        uint32_t word = body[run / 4];
+        size_t offset = word & 0xffff;
+        size_t len = word >> 16;
+        if (run + 4 + len > bodyLen) {
+          break;
+        }
+        if (offset < _size) {
+          memcpy(_data + offset, bytes + run + 4, std::min(len, _size - offset));
+        }
+        run += 4 + ((len + 3) & ~3);
+      }
+      delete[] body;
+      pos += 8 + bodyLen;
+    }
+
+    _active = best;
+    _seq = header.seq;
+    _logPos = pos;
+    _compact = torn || header.size != _size || !flashErased(address + pos, SPI_FLASH_SEC_SIZE - pos);
+    memcpy(_shadow, _data, _size);
+    return true;
+  }
+}
+
+// the next bytes from from on which differ from flash, and these closer
+// than logRunGap to them, up to the end of the dirty range
+size_t EEPROMClass::_logRun(size_t from, size_t& len) const {
+  while (from < _dirtyTo && _data[from] == _shadow[from]) {
+    ++from;
+  }
+  size_t end = from;
+  for (size_t i = from; i < _dirtyTo && i < end + logRunGap; ++i) {
+    if (_data[i] != _shadow[i]) {
+      end = i + 1;
+    }
+  }
+  len = end - from;
+  return from;
+}
+
+bool EEPROMClass::_logCommit() {
+  size_t bodyLen = 0;
+  size_t len;
+  for (size_t from = _logRun(_dirtyFrom, len); len; from = _logRun(from + len, len)) {
+    bodyLen += 4 + ((len + 3) & ~3);
+  }
+  if (!bodyLen) {
+    return true;
+  }
+  if (_active < 0 || _compact || _logPos + 8 + bodyLen > SPI_FLASH_SEC_SIZE || bodyLen > 0xffff) {
+    return _logCompact();
+  }
+
+  uint32_t address = (_sector + _active) * SPI_FLASH_SEC_SIZE + _logPos;
+  LogWriter writer(address + 8);
+  for (size_t from = _logRun(_dirtyFrom, len); len; from = _logRun(from + len, len)) {
+    uint32_t run = from | (len << 16);
+    writer.put(&run, sizeof(run));
+    writer.put(_data + from, len);
+    writer.pad();
+  }
+  bool written = writer.flush();
+  uint32_t record[2] = { logRecordMagic | (uint32_t)bodyLen, writer.crc() };
+  if (!written || !ESP.flashWrite(address, record, sizeof(record))) {
+    // whatever was written is left behind by the next compaction
+    _compact = true;
+    return false;
+  }
+  memcpy(_shadow, _data, _size);
+  _logPos += 8 + bodyLen;
+  return true;
+}
+
+bool EEPROMClass::_logCompact() {
+  uint32_t next = _active < 0 ? 0 : (_active + 1) % _sectorCount;
+  uint32_t address = (_sector + next) * SPI_FLASH_SEC_SIZE;
+  LogHeader header = { logMagic, _seq + 1, (uint32_t)_size, crc32(_data, _size) };
+  if (!ESP.flashEraseSector(_sector + next)
+      || !ESP.flashWrite(address + sizeof(header), reinterpret_cast<uint32_t*>(_data), _size)
+      || !ESP.flashWrite(address, reinterpret_cast<uint32_t*>(&header), sizeof(header))) {
+    // the current sector is kept
+    return false;
+  }
+  _active = next;
+  _seq = header.seq;
+  _logPos = sizeof(header) + _size;
+  _compact = false;
+  memcpy(_shadow, _data, _size);
+  return true;
+}
+
+// Flash bits can be cleared without an erase: when no changed word needs
+// a bit set, the changed words are written over what is there.
+bool EEPROMClass::_commitInPlace() {
+  size_t from = _dirtyFrom & ~3;
+  size_t to = (_dirtyTo + 3) & ~3;
+  const uint32_t* words = reinterpret_cast<const uint32_t*>(_data);
+  uint32_t buf[16];
+  for (size_t pos = from; pos < to; pos += sizeof(buf)) {
+    size_t chunk = std::min(to - pos, sizeof(buf));
+    if (!ESP.flashRead(_sector * SPI_FLASH_SEC_SIZE + pos, buf, chunk)) {
+      return false;
+    }
+    for (size_t i = 0; i < chunk / 4; ++i) {
+      uint32_t word = words[pos / 4 + i];
+      if ((buf[i] & word) != word) {
+        return false;
+      }
+    }
+  }
+  return ESP.flashWrite(_sector * SPI_FLASH_SEC_SIZE + from, words + from / 4, to - from);
+}
+
 uint8_t * EEPROMClass::getDataPtr() {
-  _dirty = true;
+  _markDirty(0, _size);
   return &_data[0];
 }
 
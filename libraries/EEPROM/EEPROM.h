@@ -30,6 +30,13 @@ class EEPROMClass {
 public:
   EEPROMClass(uint32_t sector);
   EEPROMClass(void);
+  // Log-structured, over sectorCount (2 to 32) sectors from sector on, which
+  // the flash layout must leave free (the end of an unused filesystem...).
+  // commit() appends the bytes changed since the previous commit to the
+  // current sector, and only when it is full is the whole content written
+  // to the next sector and the one before it forgotten.  Uses a second
+  // copy of the content in RAM.
+  EEPROMClass(uint32_t sector, uint32_t sectorCount);
 
   void begin(size_t size);
   uint8_t read(int const address);
@@ -54,7 +61,7 @@ public:
     if (address < 0 || address + sizeof(T) > _size)
       return t;
     if (memcmp(_data + address, (const uint8_t*)&t, sizeof(T)) != 0) {
-      _dirty = true;
+      _markDirty(address, address + sizeof(T));
       memcpy(_data + address, (const uint8_t*)&t, sizeof(T));
     }
 
@@ -67,10 +74,34 @@ public:
   uint8_t const & operator[](int const address) const {return getConstDataPtr()[address];}
 
 protected:
+  void _markDirty(size_t from, size_t to) {
+    if (!_dirty || from < _dirtyFrom)
+      _dirtyFrom = from;
+    if (!_dirty || to > _dirtyTo)
+      _dirtyTo = to;
+    _dirty = true;
+  }
+  bool _commitInPlace();
+
+  bool _logBegin();
+  bool _logCommit();
+  bool _logCompact();
+  size_t _logRun(size_t from, size_t& len) const;
+
   uint32_t _sector;
   uint8_t* _data = nullptr;
   size_t _size = 0;
   bool _dirty = false;
+  size_t _dirtyFrom = 0;        // [_dirtyFrom, _dirtyTo) holds what changed
+  size_t _dirtyTo = 0;
+
+  // log-structured mode
+  uint32_t _sectorCount = 1;
+  uint8_t* _shadow = nullptr;   // content as in flash
+  int _active = -1;             // sector of the log, -1 when none
+  uint32_t _seq = 0;
+  size_t _logPos = 0;           // in _active, where the next record goes
+  bool _compact = false;        // _active can't be appended to
 };
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EEPROM)
@@ -39,6 +39,7 @@ extern "C" {
 #define AVRISP_SWMAJ 1
 #define AVRISP_SWMIN 18
 #define AVRISP_PTIME 10
+#define AVRISP_EEPROM_PTIME 45
 
 #define EECHUNK (32)
 
@@ -133,16 +134,63 @@ uint8_t ESP8266AVRISP::getch() {
 
 void ESP8266AVRISP::fill(int n) {
     // AVRISP_DEBUG("fill(%u)", n);
-    for (int x = 0; x < n; x++) {
-        buff[x] = getch();
+    for (int x = 0; x < n; ) {
+        while (!_client.available()) yield();
+        int got = _client.read(buff + x, n - x);
+        if (got > 0) {
+            x += got;
+        }
     }
 }
 
 uint8_t ESP8266AVRISP::spi_transaction(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
-    SPI.transfer(a);
-    SPI.transfer(b);
-    SPI.transfer(c);
-    return SPI.transfer(d);
+    uint8_t cmd[4] = { a, b, c, d };
+    wait_ready();
+    SPI.transferBytes(cmd, cmd, sizeof(cmd));
+    return cmd[3];
+}
+
+void ESP8266AVRISP::spi_queue(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+    if (_spi_queued == sizeof(_spi_batch)) {
+        spi_flush();
+    }
+    uint8_t* cmd = _spi_batch + _spi_queued;
+    cmd[0] = a;
+    cmd[1] = b;
+    cmd[2] = c;
+    cmd[3] = d;
+    _spi_queued += 4;
+}
+
+void ESP8266AVRISP::spi_flush() {
+    if (_spi_queued) {
+        wait_ready();
+        SPI.writeBytes(_spi_batch, _spi_queued);
+        _spi_queued = 0;
+    }
+}
+
+void ESP8266AVRISP::set_busy(uint32_t timeout_ms) {
+    _busy = true;
+    _busy_since = millis();
+    _busy_timeout = timeout_ms;
+}
+
+void ESP8266AVRISP::wait_ready() {
+    if (!_busy) {
+        return;
+    }
+    _busy = false;
+    while (millis() - _busy_since < _busy_timeout) {
+#ifdef AVRISP_POLL_READY
+        uint8_t cmd[4] = { 0xF0, 0x00, 0x00, 0x00 };
+        SPI.transferBytes(cmd, cmd, sizeof(cmd));
+        if (!(cmd[3] & 1)) {
+            return;
+        }
+#endif
+        yield();
+    }
 }
 
 void ESP8266AVRISP::empty_reply() {
@@ -213,6 +261,8 @@ void ESP8266AVRISP::set_parameters() {
 }
 
 void ESP8266AVRISP::start_pmode() {
+    _busy = false;
+    _spi_queued = 0;
     SPI.begin();
     SPI.setFrequency(_spi_freq);
     SPI.setHwCs(false);
@@ -229,6 +279,7 @@ void ESP8266AVRISP::start_pmode() {
 }
 
 void ESP8266AVRISP::end_pmode() {
+    wait_ready();
     SPI.end();
     setReset(_reset_state);
     pmode = 0;
@@ -243,15 +294,18 @@ void ESP8266AVRISP::universal() {
 }
 
 void ESP8266AVRISP::flash(uint8_t hilo, int addr, uint8_t data) {
-    spi_transaction(0x40 + 8 * hilo,
-                    addr >> 8 & 0xFF,
-                    addr & 0xFF,
-                    data);
+    spi_queue(0x40 + 8 * hilo,
+              addr >> 8 & 0xFF,
+              addr & 0xFF,
+              data);
 }
 
+// the page is loaded in one transfer, and written while the reply goes
+// out and the next page comes in
 void ESP8266AVRISP::commit(int addr) {
+    spi_flush();
     spi_transaction(0x4C, (addr >> 8) & 0xFF, addr & 0xFF, 0);
-    delay(AVRISP_PTIME);
+    set_busy(AVRISP_PTIME);
 }
 
 //#define _addr_page(x) (here & 0xFFFFE0)
@@ -319,7 +373,7 @@ uint8_t ESP8266AVRISP::write_eeprom_chunk(int start, int length) {
     for (int x = 0; x < length; x++) {
         int addr = start + x;
         spi_transaction(0xC0, (addr >> 8) & 0xFF, addr & 0xFF, buff[x]);
-        delay(45);
+        set_busy(AVRISP_EEPROM_PTIME);
     }
     // prog_lamp(HIGH);
     return Resp_STK_OK;
@@ -359,17 +413,47 @@ uint8_t ESP8266AVRISP::flash_read(uint8_t hilo, int addr) {
                            0);
 }
 
+// (length) bytes from here, read with as many commands per SPI transfer
+// as _spi_batch holds
+void ESP8266AVRISP::read_memory(uint8_t* data, int length, bool eeprom) {
+    // here is a word address
+    int start = here * 2;
+    wait_ready();
+    for (int x = 0; x < length; ) {
+        int count = std::min(length - x, (int)sizeof(_spi_batch) / 4);
+        for (int i = 0; i < count; i++) {
+            int byte = x + i;
+            uint8_t* cmd = _spi_batch + 4 * i;
+            if (eeprom) {
+                int addr = start + byte;
+                cmd[0] = 0xA0;
+                cmd[1] = (addr >> 8) & 0xFF;
+                cmd[2] = addr & 0xFF;
+                cmd[3] = 0xFF;
+            } else {
+                int addr = here + byte / 2;
+                cmd[0] = 0x20 + (byte & 1) * 8;
+                cmd[1] = (addr >> 8) & 0xFF;
+                cmd[2] = addr & 0xFF;
+                cmd[3] = 0;
+            }
+        }
+        SPI.transferBytes(_spi_batch, _spi_batch, 4 * count);
+        for (int i = 0; i < count; i++) {
+            data[x + i] = _spi_batch[4 * i + 3];
+        }
+        x += count;
+    }
+}
+
 bool ESP8266AVRISP::flash_read_page(int length) {
     uint8_t *data = (uint8_t *) malloc(length + 1);
     if (!data)
     {
         return false;
     }
-    for (int x = 0; x < length; x += 2) {
-        *(data + x) = flash_read(LOW, here);
-        *(data + x + 1) = flash_read(HIGH, here);
-        here++;
-    }
+    read_memory(data, length, false);
+    here += length / 2;
     *(data + length) = Resp_STK_OK;
     _client.write((const uint8_t *)data, (size_t)(length + 1));
     free(data);
@@ -383,12 +467,7 @@ bool ESP8266AVRISP::eeprom_read_page(int length) {
     {
         return false;
     }
-    int start = here * 2;
-    for (int x = 0; x < length; x++) {
-        int addr = start + x;
-        uint8_t ee = spi_transaction(0xA0, (addr >> 8) & 0xFF, addr & 0xFF, 0xFF);
-        *(data + x) = ee;
-    }
+    read_memory(data, length, true);
     *(data + length) = Resp_STK_OK;
     _client.write((const uint8_t *)data, (size_t)(length + 1));
     free(data);
@@ -20,6 +20,10 @@ Original version:
 // SPI clock frequency in Hz
 #define AVRISP_SPI_FREQ   300e3
 
+// comment out for targets without the Poll RDY/BSY instruction, writes are
+// then given their worst case time
+#define AVRISP_POLL_READY
+
 // programmer states
 typedef enum {
     AVRISP_STATE_IDLE = 0,    // no active TCP session
@@ -75,6 +79,11 @@ protected:
 
     uint8_t getch(void);        // retrieve a character from the remote end
     uint8_t spi_transaction(uint8_t, uint8_t, uint8_t, uint8_t);
+    void spi_queue(uint8_t, uint8_t, uint8_t, uint8_t);  // sent by spi_flush()
+    void spi_flush(void);
+    void set_busy(uint32_t timeout_ms);  // target is writing
+    void wait_ready(void);
+    void read_memory(uint8_t* data, int length, bool eeprom);
     void empty_reply(void);
     void breply(uint8_t);
 
@@ -115,6 +124,16 @@ protected:
     // page buffer
     uint8_t buff[256];
 
+    // commands queued for one SPI transfer
+    uint8_t _spi_batch[64];
+    size_t _spi_queued = 0;
+
+    // a write was started at _busy_since and takes up to _busy_timeout,
+    // the next command waits for it: replies don't
+    bool _busy = false;
+    uint32_t _busy_since;
+    uint32_t _busy_timeout;
+
     int error = 0;
     bool pmode = 0;
 
@@ -46,6 +46,9 @@ void loop() {
     http.begin(client, "http://jigsaw.w3.org/HTTP/connection.html");
     // http.begin(client, "jigsaw.w3.org", 80, "/HTTP/connection.html");
 
+    // ask for a gzip compressed response, decompressed as it is read (32KB of RAM)
+    // http.setDecompression(true);
+
     Serial.print("[HTTP] GET...\n");
     // start connection and send HTTP header
     int httpCode = http.GET();
@@ -65,6 +68,19 @@ void loop() {
 #if 0
         // with API
         Serial.println(http.getString());
+#elif 0
+        // or with the body stream, which ends with the body and decodes
+        // chunked responses, JSON parsers can read from it too
+        HTTPBodyStream& body = http.getBodyStream();
+
+        while (!body.finished()) {
+          int c = body.readBytes(buff, sizeof(buff));
+          if (!c) {
+            Serial.println("read timeout");
+            break;
+          }
+          Serial.write(buff, c);
+        }
 #else
         // or "by hand"
 
@@ -27,6 +27,7 @@
 #include "ESP8266HTTPClient.h"
 #include <ESP8266WiFi.h>
 #include <StreamDev.h>
+#include <Schedule.h>
 #include <base64.h>
 
 // per https://github.com/esp8266/Arduino/issues/8231
@@ -58,6 +59,7 @@ void HTTPClient::clear()
     _size = -1;
     _headers.clear();
     _location.clear();
+    _body.reset();
     _payload.reset();
 }
 
@@ -197,6 +199,10 @@ bool HTTPClient::beginInternal(const String& __url, const char* expectedProtocol
  */
 void HTTPClient::end(void)
 {
+    _asyncState = ASYNC_IDLE;
+    _asyncToken.cancel();
+    _asyncResolved.reset();
+    _asyncPayload.reset();
     disconnect(false);
     clear();
 }
@@ -208,6 +214,15 @@ void HTTPClient::end(void)
 void HTTPClient::disconnect(bool preserveClient)
 {
     if(connected()) {
+        // what is left of the body may not have arrived yet, and the next
+        // response would be read from it
+        StreamNull devnull;
+        _body.sendAvailable(devnull);
+        if(!_body.finished()) {
+            _canReuse = false;
+        }
+        _body.reset();
+
         if(_client->available() > 0) {
             DEBUG_HTTPCLIENT("[HTTP-Client][end] still data in buffer (%d), clean up.\n", _client->available());
             while(_client->available() > 0) {
@@ -217,6 +232,9 @@ void HTTPClient::disconnect(bool preserveClient)
 
         if(_reuse && _canReuse) {
             DEBUG_HTTPCLIENT("[HTTP-Client][end] tcp keep open for reuse\n");
+            if (_pool && !preserveClient) {
+                _pool->put(std::move(_client), _poolIdentity, _protocol == "https", _host, _port);
+            }
         } else {
             DEBUG_HTTPCLIENT("[HTTP-Client][end] tcp stop\n");
             if(_client) {
@@ -257,6 +275,17 @@ void HTTPClient::setReuse(bool reuse)
     _reuse = reuse;
 }
 
+/**
+ * share keep-alive connections through a pool
+ * @param pool HTTPConnectionPool* (nullptr: no pool)
+ * @param identity String, connections are only reused with the same one
+ */
+void HTTPClient::setConnectionPool(HTTPConnectionPool* pool, const String& identity)
+{
+    _pool = pool;
+    _poolIdentity = identity;
+}
+
 /**
  * set User Agent
  * @param userAgent const char *
@@ -351,6 +380,19 @@ void HTTPClient::setRedirectLimit(uint16_t limit)
     _redirectLimit = limit;
 }
 
+/**
+ * ask for compressed responses and decompress them
+ * @param enable bool
+ * @param window size_t
+ */
+void HTTPClient::setDecompression(bool enable, size_t window)
+{
+    _gzipWindow = enable ? std::max(window, (size_t)1024) : 0;
+    if (_inflate && _inflate->window() != _gzipWindow) {
+        _inflate.reset();
+    }
+}
+
 /**
  * use HTTP1.0
  * @param useHTTP10 bool
@@ -447,11 +489,7 @@ int HTTPClient::sendRequest(const char * type, const uint8_t * payload, size_t s
     uint16_t redirectCount = 0;
     do {
         // wipe out any existing headers from previous request
-        for(size_t i = 0; i < _headerKeysCount; i++) {
-            if (_currentHeaders[i].value.length() > 0) {
-                _currentHeaders[i].value.clear();
-            }
-        }
+        _currentHeaders.clear();
 
         DEBUG_HTTPCLIENT("[HTTP-Client][sendRequest] type: '%s' redirCount: %d\n", type, redirectCount);
 
@@ -581,6 +619,219 @@ int HTTPClient::sendRequest(const char * type, Stream * stream, size_t size)
     return returnError(handleHeaderResponse());
 }
 
+/**
+ * sendRequestAsync
+ * @param type const char *     "GET", "POST", ....
+ * @param payload String        data for the message body
+ * @return 0 when the request is sent, or a negative error
+ */
+int HTTPClient::sendRequestAsync(const char * type, const String& payload)
+{
+    return sendRequestAsync(type, (const uint8_t *) payload.c_str(), payload.length());
+}
+
+/**
+ * sendRequestAsync
+ * @param type const char *           "GET", "POST", ....
+ * @param payload const uint8_t *     data for the message body if null not send
+ * @param size size_t                 size for the message body if 0 not send
+ * @return 0 when the request is sent, or a negative error
+ */
+int HTTPClient::sendRequestAsync(const char * type, const uint8_t * payload, size_t size)
+{
+    if(_asyncState != ASYNC_IDLE) {
+        return HTTPC_ERROR_IN_PROGRESS;
+    }
+
+    // wipe out any existing headers from previous request
+    _currentHeaders.clear();
+
+    DEBUG_HTTPCLIENT("[HTTP-Client][sendRequestAsync] type: '%s'\n", type);
+
+    // resolve the host name without blocking, connect() then finds its
+    // address in the lwIP DNS table
+    IPAddress ip;
+    if(_client && !(_reuse && _canReuse && connected()) && !ip.fromString(_host)) {
+        if(size && payload) {
+            _asyncPayload.reset(new (std::nothrow) uint8_t[size]);
+            if(!_asyncPayload) {
+                return returnError(HTTPC_ERROR_TOO_LESS_RAM);
+            }
+            memcpy(_asyncPayload.get(), payload, size);
+        }
+        std::shared_ptr<int8_t> resolved = std::make_shared<int8_t>(0);
+        if(WiFi.hostByNameAsync(_host.c_str(), [resolved](const IPAddress& addr) {
+            *resolved = addr.isSet() ? 1 : -1;
+        }, _tcpTimeout)) {
+            _asyncResolved = resolved;
+            _asyncType = type;
+            _asyncPayloadSize = _asyncPayload ? size : 0;
+            _asyncState = ASYNC_RESOLVE;
+            if(_asyncScheduled) {
+                scheduleAsyncPoll();
+            }
+            return 0;
+        }
+        // else connect() resolves it, blocking
+        _asyncPayload.reset();
+    }
+    return asyncSend(type, payload, size);
+}
+
+/**
+ * connects and sends an asynchronous request
+ * @return 0 when the request is sent, or a negative error
+ */
+int HTTPClient::asyncSend(const char * type, const uint8_t * payload, size_t size)
+{
+    // connect to server
+    if(!connect()) {
+        return returnError(HTTPC_ERROR_CONNECTION_FAILED);
+    }
+
+    addHeader(F("Content-Length"), String(payload && size > 0 ? size : 0));
+
+    // send Header
+    if(!sendHeader(type)) {
+        return returnError(HTTPC_ERROR_SEND_HEADER_FAILED);
+    }
+
+    // transfer all of it, with send-timeout
+    if (size && StreamConstPtr(payload, size).sendAll(_client.get()) != size)
+        return returnError(HTTPC_ERROR_SEND_PAYLOAD_FAILED);
+
+    beginHeaderResponse();
+    _asyncTimeout.reset(_tcpTimeout);
+    _asyncState = ASYNC_HEADER;
+
+    if(_asyncScheduled && !_asyncToken.alive) {
+        scheduleAsyncPoll();
+    }
+    return 0;
+}
+
+/**
+ * reads what has arrived of the response to sendRequestAsync()
+ * @return true while the request is not done
+ */
+bool HTTPClient::poll()
+{
+    if(_asyncState == ASYNC_RESOLVE) {
+        if(*_asyncResolved == 0) {
+            return true;
+        }
+        bool found = *_asyncResolved > 0;
+        _asyncResolved.reset();
+        std::unique_ptr<uint8_t[]> payload = std::move(_asyncPayload);
+        if(!found) {
+            DEBUG_HTTPCLIENT("[HTTP-Client] failed to resolve %s\n", _host.c_str());
+            return asyncDone(HTTPC_ERROR_CONNECTION_FAILED);
+        }
+        int code = asyncSend(_asyncType.c_str(), payload.get(), _asyncPayloadSize);
+        if(code < 0) {
+            return asyncDone(code);
+        }
+    }
+
+    if(_asyncState == ASYNC_HEADER) {
+        // the header is handled line by line as it arrives, never waiting
+        if(_client->available() > 0) {
+            _asyncTimeout.reset();
+        }
+        int code = handleHeaderResponse(false);
+        if(code < 0) {
+            return asyncDone(code);
+        }
+        if(code > 0) {
+            _asyncState = ASYNC_BODY;
+            if(_headersCallback) {
+                _headersCallback(code);
+            }
+        }
+    }
+
+    if(_asyncState == ASYNC_BODY) {
+        uint32_t received = _body.received();
+        if(_bodyCallback) {
+            if(_body.available() > 0) {
+                _bodyCallback(_body);
+            }
+        } else {
+            if(!_payload) {
+                _payload.reset(new StreamString());
+            }
+            _body.sendAvailable(_payload.get());
+        }
+        if(_body.received() != received) {
+            _asyncTimeout.reset();
+        }
+        if(_body.failed()) {
+            return asyncDone(HTTPC_ERROR_ENCODING);
+        }
+        if(_body.finished()) {
+            return asyncDone(_returnCode);
+        }
+    }
+
+    if(_asyncState == ASYNC_IDLE) {
+        return false;
+    }
+    if(!connected()) {
+        return asyncDone(HTTPC_ERROR_CONNECTION_LOST);
+    }
+    if(_asyncTimeout) {
+        return asyncDone(HTTPC_ERROR_READ_TIMEOUT);
+    }
+    return true;
+}
+
+/**
+ * ends an asynchronous request
+ * @param result int    http code or error
+ * @return false
+ */
+bool HTTPClient::asyncDone(int result)
+{
+    _asyncState = ASYNC_IDLE;
+    _asyncToken.cancel();
+    if(result < 0) {
+        returnError(result);
+    } else {
+        disconnect(true);
+    }
+    if(_doneCallback) {
+        _doneCallback(result);
+    }
+    return false;
+}
+
+/**
+ * poll() asynchronous requests from the scheduler
+ * @param scheduled bool
+ * @param intervalUs uint32_t
+ */
+void HTTPClient::setAsyncScheduled(bool scheduled, uint32_t intervalUs)
+{
+    _asyncScheduled = scheduled;
+    _asyncIntervalUs = intervalUs;
+    if(!scheduled) {
+        _asyncToken.cancel();
+    } else if(inProgress() && !_asyncToken.alive) {
+        scheduleAsyncPoll();
+    }
+}
+
+void HTTPClient::scheduleAsyncPoll()
+{
+    _asyncToken.cancel();
+    _asyncToken.alive = std::make_shared<bool>(true);
+    std::shared_ptr<bool> alive = _asyncToken.alive;
+    if(!schedule_recurrent_function_us([this, alive]() { return *alive && poll(); }, _asyncIntervalUs)) {
+        DEBUG_HTTPCLIENT("[HTTP-Client] cannot schedule poll(), it must be called from the sketch\n");
+        _asyncToken.cancel();
+    }
+}
+
 /**
  * size of message body / payload
  * @return -1 if no info or > 0 when Content-Length is set by server
@@ -627,6 +878,15 @@ WiFiClient* HTTPClient::getStreamPtr(void)
     return nullptr;
 }
 
+/**
+ * returns the body of the response
+ * @return HTTPBodyStream
+ */
+HTTPBodyStream& HTTPClient::getBodyStream(void)
+{
+    return _body;
+}
+
 /**
  * write all  message body / payload to Stream
  * @param stream Stream *
@@ -655,71 +915,23 @@ int HTTPClient::writeToPrint(Print * print)
         return returnError(HTTPC_ERROR_NOT_CONNECTED);
     }
 
-    // get length of document (is -1 when Server sends no Content-Length header)
-    int len = _size;
-    int ret = 0;
-
-    if(_transferEncoding == HTTPC_TE_IDENTITY) {
-        // len < 0: transfer all of it, with timeout
-        // len >= 0: max:len, with timeout
-        ret = _client->sendSize(print, len);
+    // a body of unknown length ends with the connection, or the timeout
+    int ret = _body.sendAll(print);
 
-        // do we have an error?
-        if(_client->getLastSendReport() != Stream::Report::Success) {
-            return returnError(StreamReportToHttpClientReport(_client->getLastSendReport()));
+    if(_body.failed()) {
+        return returnError(HTTPC_ERROR_ENCODING);
+    }
+    if(!_body.finished() && (_transferEncoding != HTTPC_TE_IDENTITY || _size >= 0)) {
+        Stream::Report report = _body.getLastSendReport();
+        if(report != Stream::Report::Success) {
+            return returnError(StreamReportToHttpClientReport(report));
         }
-    } else if(_transferEncoding == HTTPC_TE_CHUNKED) {
-        int size = 0;
-        while(1) {
-            if(!connected()) {
-                return returnError(HTTPC_ERROR_CONNECTION_LOST);
-            }
-            String chunkHeader = _client->readStringUntil('\n');
-
-            if(chunkHeader.length() <= 0) {
-                return returnError(HTTPC_ERROR_READ_TIMEOUT);
-            }
-
-            chunkHeader.trim(); // remove \r
-
-            // read size of chunk
-            len = (uint32_t) strtol((const char *) chunkHeader.c_str(), NULL, 16);
-            size += len;
-            DEBUG_HTTPCLIENT("[HTTP-Client] read chunk len: %d\n", len);
-
-            // data left?
-            if(len > 0) {
-                // read len bytes with timeout
-                int r = _client->sendSize(print, len);
-                if (_client->getLastSendReport() != Stream::Report::Success)
-                    // not all data transferred
-                    return returnError(StreamReportToHttpClientReport(_client->getLastSendReport()));
-                ret += r;
-            } else {
-
-                // if no length Header use global chunk size
-                if(_size <= 0) {
-                    _size = size;
-                }
-
-                // check if we have write all data out
-                if(ret != _size) {
-                    return returnError(HTTPC_ERROR_STREAM_WRITE);
-                }
-                break;
-            }
-
-            // read trailing \r\n at the end of the chunk
-            char buf[2];
-            auto trailing_seq_len = _client->readBytes((uint8_t*)buf, 2);
-            if (trailing_seq_len != 2 || buf[0] != '\r' || buf[1] != '\n') {
-                return returnError(HTTPC_ERROR_READ_TIMEOUT);
-            }
+        return returnError(connected() ? HTTPC_ERROR_READ_TIMEOUT : HTTPC_ERROR_CONNECTION_LOST);
+    }
 
-            esp_yield();
-        }
-    } else {
-        return returnError(HTTPC_ERROR_ENCODING);
+    // if no length Header use global chunk size (or decompressed size)
+    if(_size <= 0) {
+        _size = ret;
     }
 
     disconnect(true);
@@ -780,6 +992,8 @@ String HTTPClient::errorToString(int error)
         return F("Stream write error");
     case HTTPC_ERROR_READ_TIMEOUT:
         return F("read Timeout");
+    case HTTPC_ERROR_IN_PROGRESS:
+        return F("request in progress");
     default:
         return String();
     }
@@ -824,52 +1038,33 @@ void HTTPClient::addHeader(const String& name, const String& value, bool first,
 
 void HTTPClient::collectHeaders(const char* headerKeys[], const size_t headerKeysCount)
 {
-    _headerKeysCount = headerKeysCount;
-    _currentHeaders = std::make_unique<RequestArgument[]>(_headerKeysCount);
-    for(size_t i = 0; i < _headerKeysCount; i++) {
-        _currentHeaders[i].key = headerKeys[i];
-    }
+    _currentHeaders.collect(headerKeys, headerKeysCount);
 }
 
-String HTTPClient::header(const char* name)
+HTTPHeaderView HTTPClient::header(StringView name)
 {
-    for(size_t i = 0; i < _headerKeysCount; ++i) {
-        if(_currentHeaders[i].key == name) {
-            return _currentHeaders[i].value;
-        }
-    }
-    return String();
+    int i = _currentHeaders.find(name);
+    return i < 0 ? HTTPHeaderView() : _currentHeaders.value(i);
 }
 
-String HTTPClient::header(size_t i)
+HTTPHeaderView HTTPClient::header(size_t i)
 {
-    if(i < _headerKeysCount) {
-        return _currentHeaders[i].value;
-    }
-    return String();
+    return _currentHeaders.value(i);
 }
 
-String HTTPClient::headerName(size_t i)
+HTTPHeaderView HTTPClient::headerName(size_t i)
 {
-    if(i < _headerKeysCount) {
-        return _currentHeaders[i].key;
-    }
-    return String();
+    return _currentHeaders.name(i);
 }
 
 int HTTPClient::headers()
 {
-    return _headerKeysCount;
+    return _currentHeaders.count();
 }
 
-bool HTTPClient::hasHeader(const char* name)
+bool HTTPClient::hasHeader(StringView name)
 {
-    for(size_t i = 0; i < _headerKeysCount; ++i) {
-        if((_currentHeaders[i].key == name) && (_currentHeaders[i].value.length() > 0)) {
-            return true;
-        }
-    }
-    return false;
+    return !header(name).isEmpty();
 }
 
 /**
@@ -893,6 +1088,16 @@ bool HTTPClient::connect(void)
         return false;
     }
 
+    if(_reuse && _pool) {
+        auto pooled = _pool->take(_poolIdentity, _protocol == "https", _host, _port);
+        if (pooled) {
+            DEBUG_HTTPCLIENT("[HTTP-Client] connect: reusing pooled connection to %s:%u\n", _host.c_str(), _port);
+            _client = std::move(pooled);
+            _client->setTimeout(_tcpTimeout);
+            return true;
+        }
+    }
+
     _client->setTimeout(_tcpTimeout);
 
     if(!_client->connect(_host.c_str(), _port)) {
@@ -919,6 +1124,8 @@ bool HTTPClient::sendHeader(const char * type)
         return false;
     }
 
+    _headRequest = !strcmp(type, "HEAD");
+
     String header;
     // 128: Arbitrarily chosen to have enough buffer space for avoiding internal reallocations
     header.reserve(_headers.length() + _uri.length() +
@@ -950,7 +1157,17 @@ bool HTTPClient::sendHeader(const char * type)
         header += _userAgent;
     }
 
-    if (!_useHTTP10) {
+    // without the RAM to decompress, only ask for what can be read
+    if (_gzipWindow && !_inflate) {
+        _inflate.reset(new (std::nothrow) HTTPInflate(_gzipWindow));
+        if (_inflate && !_inflate->allocated()) {
+            DEBUG_HTTPCLIENT("[HTTP-Client] not enough memory for a %zu byte gzip window\n", _gzipWindow);
+            _inflate.reset();
+        }
+    }
+    if (_gzipWindow && _inflate) {
+        header += F("\r\nAccept-Encoding: gzip");
+    } else if (!_useHTTP10) {
         header += F("\r\nAccept-Encoding: identity;q=1,chunked;q=0.1,*;q=0");
     }
 
@@ -974,82 +1191,84 @@ bool HTTPClient::sendHeader(const char * type)
 
 /**
  * reads the response from the server
+ * @param wait bool, false: returns 0 once what has arrived is handled,
+ *        the header continues at the next call (see sendRequestAsync())
  * @return int http code
  */
-int HTTPClient::handleHeaderResponse()
+int HTTPClient::handleHeaderResponse(bool wait)
 {
 
     if(!connected()) {
         return HTTPC_ERROR_NOT_CONNECTED;
     }
 
-    clear();
-
-    _canReuse = _reuse;
-
-    String transferEncoding;
+    if(wait) {
+        beginHeaderResponse();
+    }
 
-    _transferEncoding = HTTPC_TE_IDENTITY;
     unsigned long lastDataTime = millis();
 
     while(connected()) {
         size_t len = _client->available();
         if(len > 0) {
-            int headerSeparator = -1;
-            String headerLine = _client->readStringUntil('\n');
+            if(!readHeaderLine()) {
+                continue;
+            }
+            String& headerLine = _headerLine;
+            headerLine.trim(); // remove \r
 
             lastDataTime = millis();
 
             DEBUG_HTTPCLIENT("[HTTP-Client][handleHeaderResponse] RX: '%s'\n", headerLine.c_str());
 
+            const char* line = headerLine.c_str();
+            const char* separator = strchr(line, ':');
+
             if (headerLine.startsWith(F("HTTP/1."))) {
 
                 constexpr auto httpVersionIdx = sizeof "HTTP/1." - 1;
                 _canReuse = _canReuse && (headerLine[httpVersionIdx] != '0');
-                _returnCode = headerLine.substring(httpVersionIdx + 2, headerLine.indexOf(' ', httpVersionIdx + 2)).toInt();
+                _returnCode = headerLine.length() > httpVersionIdx + 2 ? atoi(line + httpVersionIdx + 2) : 0;
                 _canReuse = _canReuse && (_returnCode > 0) && (_returnCode < 500);
 
-            } else if ((headerSeparator = headerLine.indexOf(':')) > 0) {
-                String headerName = headerLine.substring(0, headerSeparator);
-                String headerValue = headerLine.substring(headerSeparator + 1);
-                headerValue.trim();
-
-                if(headerName.equalsIgnoreCase(F("Content-Length"))) {
-                    _size = headerValue.toInt();
+            } else if (separator && separator != line) {
+                // name and value are parsed in place, only the collected values are copied
+                size_t nameLen = separator - line;
+                const char* value = separator + 1;
+                while (*value == ' ' || *value == '\t') {
+                    value++;
                 }
-
-                if(_canReuse && headerName.equalsIgnoreCase(F("Connection"))) {
-                    if (headerValue.indexOf(F("close")) >= 0 &&
-                            headerValue.indexOf(F("keep-alive")) < 0) {
+                size_t valueLen = line + headerLine.length() - value;
+                auto is = [line, nameLen](PGM_P name) {
+                    return strlen_P(name) == nameLen && !strncasecmp_P(line, name, nameLen);
+                };
+
+                if(is(PSTR("Content-Length"))) {
+                    _size = atoi(value);
+                } else if(is(PSTR("Connection"))) {
+                    if (strstr_P(value, PSTR("close")) &&
+                            !strstr_P(value, PSTR("keep-alive"))) {
                         _canReuse = false;
                     }
+                } else if(is(PSTR("Transfer-Encoding"))) {
+                    DEBUG_HTTPCLIENT("[HTTP-Client][handleHeaderResponse] Transfer-Encoding: %s\n", value);
+                    if(!strcasecmp_P(value, PSTR("chunked"))) {
+                        _transferEncoding = HTTPC_TE_CHUNKED;
+                    } else {
+                        _transferEncodingUnknown = true;
+                    }
+                } else if(is(PSTR("Content-Encoding"))) {
+                    _gzipEncoded = !strcasecmp_P(value, PSTR("gzip")) || !strcasecmp_P(value, PSTR("x-gzip"));
+                } else if(is(PSTR("Location"))) {
+                    _location = value;
                 }
 
-                if(headerName.equalsIgnoreCase(F("Transfer-Encoding"))) {
-                    transferEncoding = headerValue;
-                }
-
-                if(headerName.equalsIgnoreCase(F("Location"))) {
-                    _location = headerValue;
-                }
-
-                for (size_t i = 0; i < _headerKeysCount; i++) {
-                    if (_currentHeaders[i].key.equalsIgnoreCase(headerName)) {
-                        if (!_currentHeaders[i].value.isEmpty()) {
-                            // Existing value, append this one with a comma
-                            _currentHeaders[i].value += ',';
-                            _currentHeaders[i].value += headerValue;
-                        } else {
-                            _currentHeaders[i].value = headerValue;
-                        }
-                        break; // We found a match, stop looking
-                    }
+                if(!_currentHeaders.add(line, nameLen, value, valueLen)) {
+                    DEBUG_HTTPCLIENT("[HTTP-Client][handleHeaderResponse] no memory for header '%s'\n", line);
                 }
                 continue;
             }
 
-            headerLine.trim(); // remove \r
-
             if (headerLine.isEmpty()) {
                 DEBUG_HTTPCLIENT("[HTTP-Client][handleHeaderResponse] code: %d\n", _returnCode);
 
@@ -1057,26 +1276,35 @@ int HTTPClient::handleHeaderResponse()
                     DEBUG_HTTPCLIENT("[HTTP-Client][handleHeaderResponse] size: %d\n", _size);
                 }
 
-                if(transferEncoding.length() > 0) {
-                    DEBUG_HTTPCLIENT("[HTTP-Client][handleHeaderResponse] Transfer-Encoding: %s\n", transferEncoding.c_str());
-                    if(transferEncoding.equalsIgnoreCase(F("chunked"))) {
-                        _transferEncoding = HTTPC_TE_CHUNKED;
-                    } else {
-                        _returnCode = HTTPC_ERROR_ENCODING;
-                        return _returnCode;
-                    }
-                } else {
-                    _transferEncoding = HTTPC_TE_IDENTITY;
+                if(_transferEncodingUnknown) {
+                    _returnCode = HTTPC_ERROR_ENCODING;
+                    return _returnCode;
                 }
 
                 if(_returnCode <= 0) {
                     DEBUG_HTTPCLIENT("[HTTP-Client][handleHeaderResponse] Remote host is not an HTTP Server!");
                     _returnCode = HTTPC_ERROR_NO_HTTP_SERVER;
+                    return _returnCode;
+                }
+
+                // no body after HEAD, 1xx, 204 and 304 (RFC 7230 3.3.3)
+                if(_headRequest || _returnCode < 200 || _returnCode == HTTP_CODE_NO_CONTENT || _returnCode == HTTP_CODE_NOT_MODIFIED) {
+                    _body.begin(_client.get(), HTTPC_TE_IDENTITY, 0);
+                } else if(_gzipWindow && _inflate && _gzipEncoded) {
+                    // the size of the body is only known at its end
+                    _body.begin(_client.get(), _transferEncoding, _size, _inflate.get());
+                    _size = -1;
+                } else {
+                    _body.begin(_client.get(), _transferEncoding, _size);
                 }
+                _body.setTimeout(_tcpTimeout);
                 return _returnCode;
             }
 
         } else {
+            if(!wait) {
+                return 0;
+            }
             if((millis() - lastDataTime) > _tcpTimeout) {
                 return HTTPC_ERROR_READ_TIMEOUT;
             }
@@ -1087,6 +1315,60 @@ int HTTPClient::handleHeaderResponse()
     return HTTPC_ERROR_CONNECTION_LOST;
 }
 
+/**
+ * prepares for the header of a response
+ */
+void HTTPClient::beginHeaderResponse()
+{
+    clear();
+
+    _canReuse = _reuse;
+
+    _headerLine.clear();
+    _headerLineDone = false;
+    _transferEncodingUnknown = false;
+    _gzipEncoded = false;
+
+    _transferEncoding = HTTPC_TE_IDENTITY;
+}
+
+/**
+ * reads the available part of a line of the header into _headerLine,
+ * in bulk from the connection's buffer when possible
+ * @return true when the line is complete (its \n read, not stored)
+ */
+bool HTTPClient::readHeaderLine()
+{
+    if(_headerLineDone) {
+        _headerLine.clear();
+        _headerLineDone = false;
+    }
+    while(_client->available() > 0) {
+        size_t avail = _client->hasPeekBufferAPI() ? _client->peekAvailable() : 0;
+        if(!avail) {
+            int c = _client->read();
+            if(c == '\n') {
+                _headerLineDone = true;
+                return true;
+            }
+            if(c >= 0) {
+                _headerLine += (char) c;
+            }
+            continue;
+        }
+        const char* data = _client->peekBuffer();
+        const char* end = (const char*) memchr(data, '\n', avail);
+        size_t len = end ? end - data : avail;
+        _headerLine.concat(data, len);
+        _client->peekConsume(end ? len + 1 : len);
+        if(end) {
+            _headerLineDone = true;
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * called to handle error return, may disconnect the connection if still exists
  * @param error
@@ -1103,3 +1385,533 @@ int HTTPClient::returnError(int error)
     }
     return error;
 }
+
+std::unique_ptr<WiFiClient> HTTPConnectionPool::take(const String& identity, bool https, const String& host, uint16_t port)
+{
+    expire();
+    for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+        if (it->port != port || it->https != https || it->host != host || it->identity != identity) {
+            continue;
+        }
+        std::unique_ptr<WiFiClient> client = std::move(it->client);
+        _entries.erase(it);
+        // unsolicited data on an idle connection is a close or an error
+        if (client->connected() && !client->available()) {
+            return client;
+        }
+        DEBUG_HTTPCLIENT("[HTTP-Client][pool] dropping stale connection to %s:%u\n", host.c_str(), port);
+        client->stop();
+        break;
+    }
+    return nullptr;
+}
+
+void HTTPConnectionPool::put(std::unique_ptr<WiFiClient>&& client, const String& identity, bool https, const String& host, uint16_t port)
+{
+    if (!client || !_maxConnections) {
+        return;
+    }
+    if (_entries.size() >= _maxConnections) {
+        _entries.front().client->stop();
+        _entries.erase(_entries.begin());
+    }
+    _entries.push_back(Entry { std::move(client), identity, host, port, https, esp8266::polledTimeout::oneShotMs(_idleTimeoutMs) });
+}
+
+void HTTPConnectionPool::expire()
+{
+    for (auto it = _entries.begin(); it != _entries.end(); ) {
+        if (it->idle || !it->client->connected()) {
+            it->client->stop();
+            it = _entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void HTTPConnectionPool::clear()
+{
+    for (auto& entry: _entries) {
+        entry.client->stop();
+    }
+    _entries.clear();
+}
+
+void HTTPHeaderStore::collect(const char* names[], size_t count)
+{
+    _buffer.reset();
+    _capacity = _used = _namesSize = 0;
+    _entries = std::make_unique<Entry[]>(count);
+    _count = 0;
+
+    size_t size = 0;
+    for (size_t i = 0; i < count; i++) {
+        size += strlen(names[i]) + 1;
+    }
+    if (!_reserve(size)) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        size_t len = strlen(names[i]);
+        _entries[i] = Entry { _hash(StringView(names[i], len)), (uint16_t)len, (uint16_t)_used, 0, 0 };
+        memcpy(&_buffer[_used], names[i], len + 1);
+        _used += len + 1;
+    }
+    _namesSize = _used;
+    _count = count;
+}
+
+void HTTPHeaderStore::clear()
+{
+    for (size_t i = 0; i < _count; i++) {
+        _entries[i].value = _entries[i].valueLen = 0;
+    }
+    _used = _namesSize;
+}
+
+bool HTTPHeaderStore::add(const char* name, size_t nameLen, const char* value, size_t valueLen)
+{
+    int i = _find(StringView(name, nameLen));
+    if (i < 0) {
+        return true;
+    }
+    Entry& entry = _entries[i];
+    if (!entry.valueLen) {
+        if (!_reserve(valueLen + 1)) {
+            return false;
+        }
+        entry.value = _used;
+    } else if (entry.value + entry.valueLen + 1u == _used) {
+        // the last value stored, joined in place
+        if (!_reserve(valueLen + 1)) {
+            return false;
+        }
+        _buffer[_used - 1] = ',';
+        entry.valueLen++;
+    } else {
+        // moved to the end to be joined
+        if (!_reserve(entry.valueLen + 1 + valueLen + 1)) {
+            return false;
+        }
+        memcpy(&_buffer[_used], &_buffer[entry.value], entry.valueLen);
+        entry.value = _used;
+        _used += entry.valueLen;
+        _buffer[_used++] = ',';
+        entry.valueLen++;
+    }
+    memcpy(&_buffer[entry.value + entry.valueLen], value, valueLen);
+    entry.valueLen += valueLen;
+    _used = entry.value + entry.valueLen;
+    _buffer[_used++] = 0;
+    return true;
+}
+
+int HTTPHeaderStore::find(StringView name) const
+{
+    return _find(name);
+}
+
+HTTPHeaderView HTTPHeaderStore::name(size_t i) const
+{
+    if (i >= _count) {
+        return HTTPHeaderView();
+    }
+    return HTTPHeaderView(&_buffer[_entries[i].name], _entries[i].nameLen);
+}
+
+HTTPHeaderView HTTPHeaderStore::value(size_t i) const
+{
+    if (i >= _count || !_entries[i].valueLen) {
+        return HTTPHeaderView();
+    }
+    return HTTPHeaderView(&_buffer[_entries[i].value], _entries[i].valueLen);
+}
+
+uint16_t HTTPHeaderStore::_hash(StringView name)
+{
+    uint16_t hash = 0;
+    for (size_t i = 0; i < name.length(); i++) {
+        hash = hash * 31 + tolower((uint8_t)name[i]);
+    }
+    return hash;
+}
+
+int HTTPHeaderStore::_find(StringView name) const
+{
+    uint16_t hash = _hash(name);
+    for (size_t i = 0; i < _count; i++) {
+        const Entry& entry = _entries[i];
+        if (entry.hash == hash && name.equalsIgnoreCase(StringView(&_buffer[entry.name], entry.nameLen))) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool HTTPHeaderStore::_reserve(size_t len)
+{
+    if (_used + len <= _capacity) {
+        return true;
+    }
+    // offsets are 16 bits
+    if (_used + len > UINT16_MAX) {
+        return false;
+    }
+    size_t capacity = std::min<size_t>(std::max<size_t>(_capacity * 2, std::max<size_t>(_used + len, 128)), UINT16_MAX);
+    std::unique_ptr<char[]> buffer(new (std::nothrow) char[capacity]);
+    if (!buffer) {
+        return false;
+    }
+    if (_used) {
+        memcpy(buffer.get(), _buffer.get(), _used);
+    }
+    _buffer = std::move(buffer);
+    _capacity = capacity;
+    return true;
+}
+
+HTTPInflate::HTTPInflate(size_t window):
+    _window(new (std::nothrow) uint8_t[window]), _size(window)
+{
+}
+
+void HTTPInflate::reset()
+{
+    UpdaterInflate::reset();
+    _pos = _unread = 0;
+    _total = _crc = 0;
+}
+
+bool HTTPInflate::put(uint8_t c)
+{
+    _window[_pos] = c;
+    if (++_pos == _size) {
+        _pos = 0;
+    }
+    _unread++;
+    _total++;
+    _crc = crc32(&c, 1, _crc);
+    return true;
+}
+
+bool HTTPInflate::copy(uint16_t distance, uint16_t length)
+{
+    if (distance > _size || distance > _total) {
+        DEBUG_HTTPCLIENT("[HTTP-Client] gzip distance %u past the window\n", distance);
+        return false;
+    }
+    size_t from = _pos >= distance ? _pos - distance : _pos + _size - distance;
+    while (length--) {
+        put(_window[from]);
+        if (++from == _size) {
+            from = 0;
+        }
+    }
+    return true;
+}
+
+void HTTPBodyStream::begin(Stream* client, transferEncoding_t encoding, int size, HTTPInflate* inflate)
+{
+    _client = client;
+    _inflate = client ? inflate : nullptr;
+    if (_inflate) {
+        _inflate->reset();
+    }
+    _chunked = encoding == HTTPC_TE_CHUNKED;
+    _digits = false;
+    _received = 0;
+    _left = _chunked ? 0 : size;
+    _state = _chunked ? SIZE : size ? DATA : DONE;
+    if (!client) {
+        _state = DONE;
+    }
+}
+
+bool HTTPBodyStream::finished()
+{
+    _frame();
+    return _state == DONE && (!_inflate || (_inflate->done() && !_inflate->unread()));
+}
+
+bool HTTPBodyStream::failed()
+{
+    if (_state == FAILED) {
+        return true;
+    }
+    // a compressed body ends with the compressed stream
+    return _inflate && (_inflate->failed() || (!_inflate->done() && !_inflate->paused() && !_frame() && _state == DONE));
+}
+
+/**
+ * reads the chunk framing there is in the connection's buffer
+ * @return whether body bytes come next
+ */
+bool HTTPBodyStream::_frame()
+{
+    if (_state == DATA) {
+        if (_left < 0 && _client->available() <= 0 && !_client->inputCanTimeout()) {
+            _state = DONE; // the body ended with the connection
+        }
+        return _state == DATA;
+    }
+    if (_state >= DONE) {
+        return false;
+    }
+    if (_client->hasPeekBufferAPI()) {
+        size_t len;
+        while (_state != DATA && _state < DONE && (len = _client->peekAvailable())) {
+            const char* buf = _client->peekBuffer();
+            size_t i = 0;
+            while (i < len && _state != DATA && _state < DONE) {
+                _parse(buf[i++]);
+            }
+            _client->peekConsume(i);
+        }
+    } else {
+        while (_state != DATA && _state < DONE && _client->available() > 0) {
+            _parse(_client->read());
+        }
+    }
+    return _state == DATA;
+}
+
+void HTTPBodyStream::_parse(char c)
+{
+    switch (_state) {
+    case SIZE:
+        if (isxdigit(c)) {
+            if (_left >= 0x8000000) {
+                break;
+            }
+            _left = _left * 16 + (c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+            _digits = true;
+            return;
+        }
+        if (c == ';' || c == ' ' || c == '\t') {
+            _state = EXTENSION;
+            return;
+        }
+        if (c == '\r') {
+            return;
+        }
+        if (c != '\n') {
+            break;
+        }
+        // fall through
+    case EXTENSION:
+        if (c != '\n') {
+            return;
+        }
+        if (!_digits) {
+            break;
+        }
+        DEBUG_HTTPCLIENT("[HTTP-Client] read chunk len: %d\n", _left);
+        _state = _left ? DATA : TRAILER;
+        _lineEmpty = true;
+        return;
+    case DATA_END:
+        if (c == '\r') {
+            return;
+        }
+        if (c != '\n') {
+            break;
+        }
+        _state = SIZE;
+        _digits = false;
+        return;
+    case TRAILER:
+        if (c == '\n') {
+            if (_lineEmpty) {
+                _state = DONE;
+            }
+            _lineEmpty = true;
+        } else if (c != '\r') {
+            _lineEmpty = false;
+        }
+        return;
+    default:
+        return;
+    }
+    DEBUG_HTTPCLIENT("[HTTP-Client] bad chunk framing\n");
+    _state = FAILED;
+}
+
+void HTTPBodyStream::_consumed(size_t len)
+{
+    _received += len;
+    if (_left > 0) {
+        _left -= len;
+        if (!_left) {
+            _state = _chunked ? DATA_END : DONE;
+        }
+    }
+}
+
+int HTTPBodyStream::_rawAvailable()
+{
+    if (!_frame()) {
+        return 0;
+    }
+    int len = _client->available();
+    return len > 0 ? _limit(len) : 0;
+}
+
+size_t HTTPBodyStream::_rawPeekAvailable()
+{
+    return _frame() ? _limit(_client->peekAvailable()) : 0;
+}
+
+/**
+ * decompresses the body received
+ * @return bytes there are to read in place
+ */
+size_t HTTPBodyStream::_inflated()
+{
+    if (!_inflate->unread()) {
+        // goes on after a pause
+        _inflate->write(nullptr, 0);
+        // what may follow the compressed stream is dropped
+        while (!_inflate->paused() && !_inflate->failed()) {
+            size_t len;
+            if (_client->hasPeekBufferAPI()) {
+                if (!(len = _rawPeekAvailable())) {
+                    break;
+                }
+                if (!_inflate->done()) {
+                    len = _inflate->write((const uint8_t*)_client->peekBuffer(), len);
+                }
+                _client->peekConsume(len);
+            } else {
+                if (_rawAvailable() <= 0) {
+                    break;
+                }
+                uint8_t c = _client->peek();
+                if (!(len = _inflate->done() ? 1 : _inflate->write(&c, 1))) {
+                    break;
+                }
+                _client->read();
+            }
+            _consumed(len);
+        }
+    }
+    return _inflate->unreadInPlace();
+}
+
+int HTTPBodyStream::available()
+{
+    if (_inflate) {
+        _inflated();
+        return _inflate->unread();
+    }
+    return _rawAvailable();
+}
+
+int HTTPBodyStream::read()
+{
+    if (_inflate) {
+        if (!_inflated()) {
+            return -1;
+        }
+        int c = *_inflate->unreadData();
+        _inflate->consume(1);
+        return c;
+    }
+    if (_rawAvailable() <= 0) {
+        return -1;
+    }
+    int c = _client->read();
+    if (c >= 0) {
+        _consumed(1);
+    }
+    return c;
+}
+
+int HTTPBodyStream::peek()
+{
+    if (_inflate) {
+        return _inflated() ? *_inflate->unreadData() : -1;
+    }
+    return _rawAvailable() > 0 ? _client->peek() : -1;
+}
+
+int HTTPBodyStream::read(uint8_t* buffer, size_t len)
+{
+    if (_inflate) {
+        size_t got = 0;
+        size_t n;
+        while (got < len && (n = _inflated())) {
+            n = std::min(n, len - got);
+            memcpy(buffer + got, _inflate->unreadData(), n);
+            _inflate->consume(n);
+            got += n;
+        }
+        return got;
+    }
+    int avail = _rawAvailable();
+    if (avail <= 0) {
+        return 0;
+    }
+    int got = _client->read(buffer, std::min(len, (size_t)avail));
+    if (got > 0) {
+        _consumed(got);
+    }
+    return got;
+}
+
+size_t HTTPBodyStream::readBytes(char* buffer, size_t len)
+{
+    esp8266::polledTimeout::oneShotFastMs timedOut(getTimeout());
+    size_t got = 0;
+    while (got < len) {
+        int r = read((uint8_t*)buffer + got, len - got);
+        if (r > 0) {
+            got += r;
+            timedOut.reset();
+        } else if (!inputCanTimeout() || timedOut) {
+            break;
+        } else {
+            optimistic_yield(1000);
+        }
+    }
+    return got;
+}
+
+size_t HTTPBodyStream::peekAvailable()
+{
+    return _inflate ? _inflated() : _rawPeekAvailable();
+}
+
+const char* HTTPBodyStream::peekBuffer()
+{
+    if (_inflate) {
+        return (const char*)_inflate->unreadData();
+    }
+    return _client ? _client->peekBuffer() : nullptr;
+}
+
+void HTTPBodyStream::peekConsume(size_t consume)
+{
+    if (_inflate) {
+        _inflate->consume(consume);
+    } else if (_client) {
+        _client->peekConsume(consume);
+        _consumed(consume);
+    }
+}
+
+bool HTTPBodyStream::inputCanTimeout()
+{
+    if (finished() || failed()) {
+        return false;
+    }
+    return (_inflate && (_inflate->unread() || _inflate->paused())) || (_state < DONE && _client->inputCanTimeout());
+}
+
+ssize_t HTTPBodyStream::streamRemaining()
+{
+    if (!_frame() || _inflate) {
+        return finished() || failed() ? 0 : -1;
+    }
+    return _chunked ? -1 : _left;
+}
@@ -30,7 +30,11 @@
 #include <StreamString.h>
 #include <WiFiClient.h>
 
+#include <functional>
 #include <memory>
+#include <vector>
+#include <PolledTimeout.h>
+#include <Updater_Inflate.h>
 
 #ifdef DEBUG_ESP_HTTP_CLIENT
 #ifdef DEBUG_ESP_PORT
@@ -44,6 +48,10 @@
 
 #define HTTPCLIENT_DEFAULT_TCP_TIMEOUT (5000)
 
+#ifndef HTTPCLIENT_GZIP_WINDOW
+#define HTTPCLIENT_GZIP_WINDOW (32768) // RAM for decompression, see setDecompression()
+#endif
+
 /// HTTP client errors
 #define HTTPC_ERROR_CONNECTION_FAILED   (-1)
 #define HTTPC_ERROR_SEND_HEADER_FAILED  (-2)
@@ -56,6 +64,7 @@
 #define HTTPC_ERROR_ENCODING            (-9)
 #define HTTPC_ERROR_STREAM_WRITE        (-10)
 #define HTTPC_ERROR_READ_TIMEOUT        (-11)
+#define HTTPC_ERROR_IN_PROGRESS         (-12)
 
 constexpr int HTTPC_ERROR_CONNECTION_REFUSED __attribute__((deprecated)) = HTTPC_ERROR_CONNECTION_FAILED;
 
@@ -149,9 +158,204 @@ typedef enum {
 class TransportTraits;
 typedef std::unique_ptr<TransportTraits> TransportTraitsPtr;
 
+// gzip decompression of a response body. The output is kept in a window
+// as large as the longest distance the server's compressor refers back
+// to, the part of it not read yet gives the reader its peek buffer.
+class HTTPInflate: public UpdaterInflate
+{
+public:
+    explicit HTTPInflate(size_t window);
+
+    bool allocated() const { return !!_window; }
+    size_t window() const { return _size; }
+    void reset();
+
+    size_t unread() const { return _unread; }
+    // of the unread bytes, as many as follow each other in the window
+    const uint8_t* unreadData() const { return &_window[_start()]; }
+    size_t unreadInPlace() const { return std::min(_unread, _size - _start()); }
+    void consume(size_t len) { _unread -= std::min(len, _unread); }
+
+protected:
+    virtual bool put(uint8_t c) override;
+    virtual bool copy(uint16_t distance, uint16_t length) override;
+    virtual bool end(uint32_t crc, uint32_t size) override { return crc == _crc && size == _total; }
+    virtual size_t room() override { return _size - _unread; }
+
+    size_t _start() const { return _pos >= _unread ? _pos - _unread : _pos + _size - _unread; }
+
+    std::unique_ptr<uint8_t[]> _window;
+    size_t _size;
+    size_t _pos = 0;      // next output in the window
+    size_t _unread = 0;
+    uint32_t _total = 0;  // output of the stream
+    uint32_t _crc = 0;
+};
+
+// The body of a response, as a Stream ending with the body: the chunked
+// transfer encoding is decoded, reading the chunk framing in bulk from the
+// connection's buffer, and so is gzip when given an inflate. When the
+// connection has the peek API (WiFiClient), or when decompressing, so has
+// this stream, giving the body without any copy, and JSON or other
+// parsers reading from it never need the whole body in RAM.
+class HTTPBodyStream: public Stream
+{
+public:
+    // size: Content-Length, or -1 when the body ends with the connection
+    void begin(Stream* client, transferEncoding_t encoding, int size, HTTPInflate* inflate = nullptr);
+    void reset() { begin(nullptr, HTTPC_TE_IDENTITY, 0); }
+
+    bool finished(); // whole body read
+    bool failed(); // bad chunk framing or compressed data
+    uint32_t received() const { return _received; } // body bytes read, before decompression
+
+    // Stream
+    virtual int available() override;
+    virtual int read() override;
+    virtual int peek() override;
+    virtual int read(uint8_t* buffer, size_t len) override;
+    virtual size_t readBytes(char* buffer, size_t len) override;
+    using Stream::readBytes;
+
+    virtual bool hasPeekBufferAPI() const override { return _inflate || (_client && _client->hasPeekBufferAPI()); }
+    virtual size_t peekAvailable() override;
+    virtual const char* peekBuffer() override;
+    virtual void peekConsume(size_t consume) override;
+    virtual bool inputCanTimeout() override;
+    // bytes left, -1 when not known (chunked, compressed or no Content-Length)
+    virtual ssize_t streamRemaining() override;
+
+    // Print: read only
+    virtual size_t write(uint8_t) override { return 0; }
+    virtual size_t write(const uint8_t*, size_t) override { return 0; }
+    virtual bool outputCanTimeout() override { return false; }
+
+protected:
+    enum State: uint8_t {
+        SIZE, EXTENSION, DATA, DATA_END, TRAILER, DONE, FAILED
+    };
+
+    bool _frame();
+    void _parse(char c);
+    void _consumed(size_t len);
+    size_t _limit(size_t len) const { return _left >= 0 && (size_t)_left < len ? _left : len; }
+    // body as received
+    int _rawAvailable();
+    size_t _rawPeekAvailable();
+    // decompressed
+    size_t _inflated();
+
+    Stream* _client = nullptr;
+    HTTPInflate* _inflate = nullptr;
+    bool _chunked = false;
+    bool _digits = false;    // of the chunk size
+    bool _lineEmpty = false; // of the trailer
+    State _state = DONE;
+    int _left = 0;           // of the chunk or body, -1: until closed
+    uint32_t _received = 0;
+};
+
+// Keep-alive connections shared between requests and HTTPClient instances.
+// A connection is keyed by host, port, scheme and the identity given to
+// HTTPClient::setConnectionPool(), so requests to the same server skip the
+// TCP and TLS handshakes.  The pool can't tell the TLS settings (trust
+// anchors, fingerprint, insecure...) of the clients given to begin(): the
+// requests made with different settings use different identities, or pools.
+// Idle connections are closed after idleTimeoutMs, and are checked to be
+// still open and silent before reuse.
+class HTTPConnectionPool
+{
+public:
+    HTTPConnectionPool(size_t maxConnections = 2, uint32_t idleTimeoutMs = 30000):
+        _maxConnections(maxConnections), _idleTimeoutMs(idleTimeoutMs) { }
+
+    // a healthy connection for this key, or nullptr
+    std::unique_ptr<WiFiClient> take(const String& identity, bool https, const String& host, uint16_t port);
+    // keep a connection for later reuse, the oldest one is closed when full
+    void put(std::unique_ptr<WiFiClient>&& client, const String& identity, bool https, const String& host, uint16_t port);
+    // close idle connections past their timeout
+    void expire();
+    // close all connections
+    void clear();
+    size_t size() const { return _entries.size(); }
+
+protected:
+    struct Entry
+    {
+        std::unique_ptr<WiFiClient> client;
+        String identity;
+        String host;
+        uint16_t port;
+        bool https;
+        esp8266::polledTimeout::oneShotMs idle;
+    };
+
+    std::vector<Entry> _entries;
+    size_t _maxConnections;
+    uint32_t _idleTimeoutMs;
+};
+
+// A header of a response as stored by the HTTPClient, without a copy. It
+// is valid until the next request, make a String of it to keep it longer.
+class HTTPHeaderView: public StringView
+{
+public:
+    HTTPHeaderView() { }
+    HTTPHeaderView(const char* str, size_t len): StringView(str, len) { }
+
+    const char* c_str() const { return _ptr; } // nul terminated
+
+    operator String() const { return String(_ptr); }
+};
+
+// The headers collectHeaders() asked for, names and values in one buffer
+// (names first, then the values of the current response) kept from one
+// response to the next. The name of each arriving header is hashed
+// ignoring case, so only a matching hash is compared in full.
+class HTTPHeaderStore
+{
+public:
+    void collect(const char* names[], size_t count);
+    // drop the values, keeping the names and the buffer
+    void clear();
+    // store the value of a header when collected, a repeated header gets
+    // its values joined by a comma. false when out of memory
+    bool add(const char* name, size_t nameLen, const char* value, size_t valueLen);
+
+    int find(StringView name) const;
+    size_t count() const { return _count; }
+    HTTPHeaderView name(size_t i) const;
+    HTTPHeaderView value(size_t i) const;
+
+protected:
+    struct Entry
+    {
+        uint16_t hash;
+        uint16_t nameLen;
+        uint16_t name;  // offsets in the buffer
+        uint16_t value;
+        uint16_t valueLen;
+    };
+
+    static uint16_t _hash(StringView name);
+    int _find(StringView name) const;
+    bool _reserve(size_t len);
+
+    std::unique_ptr<char[]> _buffer;
+    size_t _capacity = 0;
+    size_t _used = 0;
+    size_t _namesSize = 0;
+    std::unique_ptr<Entry[]> _entries;
+    size_t _count = 0;
+};
+
 class HTTPClient
 {
 public:
+    typedef std::function<void(int code)> THandlerFunction_Headers;
+    typedef std::function<void(HTTPBodyStream& body)> THandlerFunction_Body;
+    typedef std::function<void(int result)> THandlerFunction_Done;
+
     HTTPClient() = default;
     ~HTTPClient() = default;
     HTTPClient(HTTPClient&&) = default;
@@ -173,11 +377,21 @@ public:
     bool connected(void);
 
     void setReuse(bool reuse); /// keep-alive
+    // share keep-alive connections with other requests through pool
+    // (nullptr: none, default), pool must outlive this HTTPClient; only
+    // the connections put with the same identity are reused, one identity
+    // per TLS configuration of the clients given to begin()
+    void setConnectionPool(HTTPConnectionPool* pool, const String& identity = String());
     void setUserAgent(const String& userAgent);
     void setAuthorization(const char * user, const char * password);
     void setAuthorization(const char * auth);
     void setAuthorization(String auth);
     void setTimeout(uint16_t timeout);
+    // ask for gzip compressed responses, and decompress them in the body
+    // stream, writeToStream() and getString(). window is the RAM kept for
+    // the data compressed bodies refer back to: the 32768 standard servers
+    // use, less only when the server is set to compress with a smaller one
+    void setDecompression(bool enable, size_t window = HTTPCLIENT_GZIP_WINDOW);
 
     // Redirections
     void setFollowRedirects(followRedirects_t follow);
@@ -201,13 +415,35 @@ public:
 
     void addHeader(const String& name, const String& value, bool first = false, bool replace = true);
 
+    /// asynchronous requests
+    // Connects (reusing a kept-alive connection when there is one) and sends
+    // the request, then returns: 0, or a negative error as sendRequest().
+    // A new connection to a host name first resolves it without blocking,
+    // the request is then sent by poll() once the address is known.
+    // The response is read by poll() as it arrives, which calls onHeaders()
+    // with the http code once the header is in, onBody() whenever body bytes
+    // are there to read, and onDone() with the http code or a negative error
+    // at the end. Without onBody(), the body is kept for getString().
+    // Redirections are not followed.
+    int sendRequestAsync(const char* type, const String& payload);
+    int sendRequestAsync(const char* type, const uint8_t* payload = nullptr, size_t size = 0);
+    // reads what has arrived of the response, true while it is not done
+    bool poll();
+    bool inProgress() const { return _asyncState != ASYNC_IDLE; }
+    // poll() from the scheduler (at most every intervalUs) rather than from
+    // the sketch, the HTTPClient must then stay in place until onDone()
+    void setAsyncScheduled(bool scheduled, uint32_t intervalUs = 1000);
+    void onHeaders(THandlerFunction_Headers fn) { _headersCallback = fn; }
+    void onBody(THandlerFunction_Body fn) { _bodyCallback = fn; }
+    void onDone(THandlerFunction_Done fn) { _doneCallback = fn; }
+
     /// Response handling
     void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
-    String header(const char* name);   // get request header value by name
-    String header(size_t i);              // get request header value by number
-    String headerName(size_t i);          // get request header name by number
+    HTTPHeaderView header(StringView name);    // get request header value by name
+    HTTPHeaderView header(size_t i);              // get request header value by number
+    HTTPHeaderView headerName(size_t i);          // get request header name by number
     int headers();                     // get header count
-    bool hasHeader(const char* name);  // check if header exists
+    bool hasHeader(StringView name);   // check if header exists
 
 
     int getSize(void);
@@ -215,24 +451,27 @@ public:
 
     WiFiClient& getStream(void);
     WiFiClient* getStreamPtr(void);
+    // the body of the response, read it instead of getStream() to stop at
+    // its end, with the chunked transfer encoding decoded
+    HTTPBodyStream& getBodyStream(void);
 	int writeToPrint(Print* print);
     int writeToStream(Stream* stream);
     const String& getString(void);
     static String errorToString(int error);
 
 protected:
-    struct RequestArgument {
-        String key;
-        String value;
-    };
-
     bool beginInternal(const String& url, const char* expectedProtocol);
     void disconnect(bool preserveClient = false);
     void clear();
     int returnError(int error);
     bool connect(void);
     bool sendHeader(const char * type);
-    int handleHeaderResponse();
+    int handleHeaderResponse(bool wait = true);
+    void beginHeaderResponse();
+    bool readHeaderLine();
+    int asyncSend(const char* type, const uint8_t* payload, size_t size);
+    bool asyncDone(int result);
+    void scheduleAsyncPoll();
     int writeToStreamDataBlock(Stream * stream, int len);
 
     // The common pattern to use the class is to
@@ -244,6 +483,8 @@ protected:
     // Make sure it's not possible to break things in an opposite direction
 
     std::unique_ptr<WiFiClient> _client;
+    HTTPConnectionPool* _pool = nullptr;
+    String _poolIdentity;
 
     /// request handling
     String _host;
@@ -261,8 +502,9 @@ protected:
     String _userAgent = defaultUserAgent;
 
     /// Response handling
-    std::unique_ptr<RequestArgument[]> _currentHeaders;
-    size_t _headerKeysCount = 0;
+    HTTPHeaderStore _currentHeaders;
+    String _headerLine; // being received
+    bool _headerLineDone = false; // _headerLine is complete, cleared at the next read
 
     int _returnCode = 0;
     int _size = -1;
@@ -271,7 +513,45 @@ protected:
     uint16_t _redirectLimit = 10;
     String _location;
     transferEncoding_t _transferEncoding = HTTPC_TE_IDENTITY;
+    bool _transferEncodingUnknown = false;
+    bool _gzipEncoded = false; // Content-Encoding
+    bool _headRequest = false;
+    size_t _gzipWindow = 0;
+    std::unique_ptr<HTTPInflate> _inflate;
+    HTTPBodyStream _body;
     std::unique_ptr<StreamString> _payload;
+
+    /// asynchronous requests
+    enum asyncState_t: uint8_t {
+        ASYNC_IDLE, ASYNC_RESOLVE, ASYNC_HEADER, ASYNC_BODY
+    };
+
+    // stops the scheduled poll() of a request when the HTTPClient is moved
+    // or destroyed
+    struct AsyncToken
+    {
+        std::shared_ptr<bool> alive;
+
+        AsyncToken() = default;
+        AsyncToken(AsyncToken&& other) { other.cancel(); }
+        AsyncToken& operator=(AsyncToken&& other) { cancel(); other.cancel(); return *this; }
+        ~AsyncToken() { cancel(); }
+        void cancel() { if (alive) { *alive = false; alive.reset(); } }
+    };
+
+    asyncState_t _asyncState = ASYNC_IDLE;
+    bool _asyncScheduled = false;
+    uint32_t _asyncIntervalUs = 1000;
+    esp8266::polledTimeout::oneShotMs _asyncTimeout { HTTPCLIENT_DEFAULT_TCP_TIMEOUT };
+    AsyncToken _asyncToken;
+    // request waiting for the host's address
+    std::shared_ptr<int8_t> _asyncResolved; // 0 pending, 1 found, -1 failed
+    String _asyncType;
+    std::unique_ptr<uint8_t[]> _asyncPayload;
+    size_t _asyncPayloadSize = 0;
+    THandlerFunction_Headers _headersCallback;
+    THandlerFunction_Body _bodyCallback;
+    THandlerFunction_Done _doneCallback;
 };
 
 #endif /* ESP8266HTTPClient_H_ */
@@ -43,6 +43,7 @@ ESP8266HTTPUpdateServerTemplate<ServerType>::ESP8266HTTPUpdateServerTemplate(boo
   _username = emptyString;
   _password = emptyString;
   _authenticated = false;
+  _uploadStart = 0;
 }
 
 template <typename ServerType>
@@ -95,6 +96,8 @@ void ESP8266HTTPUpdateServerTemplate<ServerType>::setup(ESP8266WebServerTemplate
 
       if(upload.status == UPLOAD_FILE_START){
         _updaterError.clear();
+        _stats = UploadStats();
+        _uploadStart = millis();
         if (_serial_output)
           Serial.setDebugOutput(true);
 
@@ -121,12 +124,15 @@ void ESP8266HTTPUpdateServerTemplate<ServerType>::setup(ESP8266WebServerTemplate
         }
       } else if(_authenticated && upload.status == UPLOAD_FILE_WRITE && !_updaterError.length()){
         if (_serial_output) Serial.printf(".");
-        if(Update.write(upload.buf, upload.currentSize) != upload.currentSize){
-          _setUpdaterError();
-        }
+        _write(upload);
       } else if(_authenticated && upload.status == UPLOAD_FILE_END && !_updaterError.length()){
-        if(Update.end(true)){ //true to set the size to the current progress
-          if (_serial_output) Serial.printf("Update Success: %zu\nRebooting...\n", upload.totalSize);
+        uint32_t start = millis();
+        bool ended = Update.end(true); //true to set the size to the current progress
+        _stats.flashMs += millis() - start;
+        _stats.totalMs = millis() - _uploadStart;
+        if(ended){
+          if (_serial_output) Serial.printf("Update Success: %zu in %ums, %u B/s (flash %ums, network %ums)\nRebooting...\n",
+                                            _stats.bytes, _stats.totalMs, _stats.bytesPerSecond(), _stats.flashMs, _stats.networkMs());
         } else {
           _setUpdaterError();
         }
@@ -139,6 +145,25 @@ void ESP8266HTTPUpdateServerTemplate<ServerType>::setup(ESP8266WebServerTemplate
     });
 }
 
+template <typename ServerType>
+void ESP8266HTTPUpdateServerTemplate<ServerType>::_write(HTTPUpload& upload)
+{
+  uint32_t start = millis();
+  if(Update.write(upload.buf, upload.currentSize) != upload.currentSize){
+    _setUpdaterError();
+  } else {
+    _stats.bytes += upload.currentSize;
+    // the flash is synchronous: erase the sectors ahead while the next
+    // chunk is still on its way, rather than when it is written
+    while (!_server->client().available() && Update.preErase())
+      _stats.erasedAhead++;
+  }
+  _stats.flashMs += millis() - start;
+  _stats.totalMs = millis() - _uploadStart;
+  if (_progress)
+    _progress(_stats.bytes, upload.contentLength);
+}
+
 template <typename ServerType>
 void ESP8266HTTPUpdateServerTemplate<ServerType>::_setUpdaterError()
 {
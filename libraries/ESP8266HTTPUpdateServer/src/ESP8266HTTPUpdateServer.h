@@ -2,6 +2,7 @@
 #define __HTTP_UPDATE_SERVER_H
 
 #include <ESP8266WebServer.h>
+#include <functional>
 
 namespace esp8266httpupdateserver {
 using namespace esp8266webserver;
@@ -10,6 +11,23 @@ template <typename ServerType>
 class ESP8266HTTPUpdateServerTemplate
 {
   public:
+    // Figures of the last upload, kept until the next one starts. Flash
+    // time is spent in the Updater, the rest of the upload receiving and
+    // parsing the request: the network wait.
+    struct UploadStats
+    {
+      size_t bytes = 0;          // written to the Updater
+      uint32_t totalMs = 0;      // from the first to the last file chunk
+      uint32_t flashMs = 0;      // in Update.write(), end() and preErase()
+      uint32_t erasedAhead = 0;  // sectors erased while no data was pending
+
+      uint32_t networkMs() const { return totalMs - flashMs; }
+      uint32_t bytesPerSecond() const { return totalMs ? (uint64_t)bytes * 1000 / totalMs : 0; }
+    };
+
+    // bytes written so far, upper bound of the total (the request size)
+    using THandlerFunction_Progress = std::function<void(size_t, size_t)>;
+
     ESP8266HTTPUpdateServerTemplate(bool serial_debug=false);
 
     void setup(ESP8266WebServerTemplate<ServerType> *server)
@@ -35,8 +53,20 @@ class ESP8266HTTPUpdateServerTemplate
       _password = password;
     }
 
+    // called after each chunk written
+    void onProgress(THandlerFunction_Progress fn)
+    {
+      _progress = fn;
+    }
+
+    const UploadStats& uploadStats() const
+    {
+      return _stats;
+    }
+
   protected:
     void _setUpdaterError();
+    void _write(HTTPUpload& upload);
 
   private:
     bool _serial_output;
@@ -45,6 +75,9 @@ class ESP8266HTTPUpdateServerTemplate
     String _password;
     bool _authenticated;
     String _updaterError;
+    UploadStats _stats;
+    uint32_t _uploadStart;
+    THandlerFunction_Progress _progress;
 };
 
 };
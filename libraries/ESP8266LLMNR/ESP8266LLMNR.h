@@ -36,27 +36,18 @@
 
 #include <ESP8266WiFi.h>
 
-class UdpContext;
-
 class LLMNRResponder {
 public:
     LLMNRResponder();
     ~LLMNRResponder();
 
-    /* Initialize and start responding to LLMNR requests on all interfaces */
+    /* Initialize and start responding to LLMNR requests on all interfaces.
+       The hostname is shared with the other responders (NetBIOS, mDNS) */
     bool begin(const char* hostname);
+    void end();
 
     /* Application should call this whenever AP is configured/disabled */
     void notify_ap_change();
-
-private:
-    String _hostname;
-    UdpContext *_conn;
-    WiFiEventHandler _sta_got_ip_handler;
-    WiFiEventHandler _sta_disconnected_handler;
-
-    bool _restart();
-    void _process_packet();
 };
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_LLMNR)
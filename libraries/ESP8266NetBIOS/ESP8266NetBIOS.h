@@ -2,9 +2,6 @@
 #ifndef __ESPNBNS_h__
 #define __ESPNBNS_h__
 
-extern "C" {
-#include <lwip/ip_addr.h>
-}
 #include <ESP8266WiFi.h>
 
 #define NBNS_PORT 137
@@ -16,20 +13,10 @@ extern "C" {
 */
 #define NBNS_MAX_HOSTNAME_LEN 16
 
-struct udp_pcb;
-struct pbuf;
-
+// Dotazy zpracovava NameService (knihovna ESP8266WiFi), jmeno je sdilene
+// s LLMNR a mDNS
 class ESP8266NetBIOS
 {
-protected:
-    udp_pcb* _pcb;
-    char _name[NBNS_MAX_HOSTNAME_LEN + 1];
-    void _getnbname(char *nbname, char *name, uint8_t maxlen);
-    void _makenbname(char *name, char *nbname, uint8_t outlen);
-   
-    void _recv(udp_pcb *upcb, pbuf *pb, const ip_addr_t *addr, uint16_t port);
-    static void _s_recv(void *arg, udp_pcb *upcb, pbuf *p, const ip_addr_t *addr, uint16_t port);
-
 public:
     ESP8266NetBIOS();
     ~ESP8266NetBIOS();
@@ -51,6 +51,7 @@ extern "C" {
 #define SSDP_METHOD_SIZE  10
 #define SSDP_URI_SIZE     2
 #define SSDP_BUFFER_SIZE  64
+#define SSDP_MAX_MX       5  // seconds, UPnP caps the response delay
 
 // ssdp ipv6 is FF05::C
 // lwip-v2's igmp_joingroup only supports IPv4
@@ -123,8 +124,28 @@ struct SSDPTimer {
   ETSTimer timer;
 };
 
+// Formats into a new buffer of the exact size, measured by a first pass
+static std::unique_ptr<char[]> _ssdp_render(size_t& length, PGM_P format, ...) {
+  va_list arg;
+  va_start(arg, format);
+  int len = vsnprintf_P(nullptr, 0, format, arg);
+  va_end(arg);
+
+  std::unique_ptr<char[]> buffer;
+  length = 0;
+  if (len > 0) {
+    buffer.reset(new (std::nothrow) char[len + 1]);
+    if (buffer) {
+      va_start(arg, format);
+      vsnprintf_P(buffer.get(), len + 1, format, arg);
+      va_end(arg);
+      length = len;
+    }
+  }
+  return buffer;
+}
+
 SSDPClass::SSDPClass()
-:  _respondToAddr(0,0,0,0)
 {
   _uuid[0] = '\0';
   _modelNumber[0] = '\0';
@@ -146,8 +167,10 @@ SSDPClass::~SSDPClass() {
 bool SSDPClass::begin() {
   end();
   
-  _pending = false;
-  _st_is_uuid = false;
+  _pendingCount = 0;
+  _tokens = _burst;
+  _tokenTime = millis();
+  _invalidate();
   if (strcmp(_uuid,"") == 0) {
 	uint32_t chipId = ESP.getChipId();
 	sprintf_P(_uuid, PSTR("uuid:38323636-4558-4dda-9188-cda0e6%02x%02x%02x"),
@@ -219,76 +242,152 @@ void SSDPClass::end() {
     DEBUG_SSDP.printf_P(PSTR("ok\n"));
 #endif
 }
-void SSDPClass::_send(ssdp_method_t method) {
-  char buffer[1460];
+void SSDPClass::_invalidate() const {
+  for (auto& packet : _packets) {
+    packet.reset();
+  }
+  _schema.reset();
+}
+
+const char* SSDPClass::_packet(ssdp_packet_t packet, size_t& length) {
   IPAddress ip = WiFi.localIP();
+  if (ip != _renderedIP) {
+    _invalidate();
+    _renderedIP = ip;
+  }
 
-  char valueBuffer[strlen_P(_ssdp_notify_template) + 1];
-  strcpy_P(valueBuffer, (method == NONE) ? _ssdp_response_template : _ssdp_notify_template);
-
-  int len = snprintf_P(buffer, sizeof(buffer),
-                       _ssdp_packet_template,
-                       valueBuffer,
-                       _interval,
-                       _modelName,
-                       _modelNumber,
-                       _uuid,
-                       (method == NONE) ? "ST" : "NT",
-                       (_st_is_uuid) ? _uuid : _deviceType,
-                       ip.toString().c_str(), _port, _schemaURL
-                      );
-
-  _server->append(buffer, len);
-
-  IPAddress remoteAddr;
-  uint16_t remotePort;
-  if (method == NONE) {
-    remoteAddr = _respondToAddr;
-    remotePort = _respondToPort;
-#ifdef DEBUG_SSDP
-    DEBUG_SSDP.print("Sending Response to ");
-#endif
-  } else {
-    remoteAddr = IPAddress(SSDP_MULTICAST_ADDR);
-    remotePort = SSDP_PORT;
-#ifdef DEBUG_SSDP
-    DEBUG_SSDP.println("Sending Notify to ");
-#endif
+  if (!_packets[packet]) {
+    char valueBuffer[strlen_P(_ssdp_notify_template) + 1];
+    strcpy_P(valueBuffer, (packet == NOTIFY_DEVICE_TYPE) ? _ssdp_notify_template : _ssdp_response_template);
+
+    _packets[packet] = _ssdp_render(_packetLengths[packet],
+                                    _ssdp_packet_template,
+                                    valueBuffer,
+                                    _interval,
+                                    _modelName,
+                                    _modelNumber,
+                                    _uuid,
+                                    (packet == NOTIFY_DEVICE_TYPE) ? "NT" : "ST",
+                                    (packet == RESPONSE_UUID) ? _uuid : _deviceType,
+                                    ip.toString().c_str(), _port, _schemaURL
+                                   );
   }
+
+  length = _packetLengths[packet];
+  return _packets[packet].get();
+}
+
+void SSDPClass::_send(ssdp_packet_t packet, const IPAddress& addr, uint16_t port) {
+  size_t len;
+  const char* data = _packet(packet, len);
+  if (!data) {
+    return;
+  }
+
 #ifdef DEBUG_SSDP
-  DEBUG_SSDP.print(IPAddress(remoteAddr));
+  DEBUG_SSDP.print((packet == NOTIFY_DEVICE_TYPE) ? "Sending Notify to " : "Sending Response to ");
+  DEBUG_SSDP.print(addr);
   DEBUG_SSDP.print(":");
-  DEBUG_SSDP.println(remotePort);
+  DEBUG_SSDP.println(port);
 #endif
 
-  _server->send(remoteAddr, remotePort);
+  // sent with the other packets due now by _update()
+  _server->queue(addr, port, data, len);
 }
 
 void SSDPClass::schema(Print &client) const {
   IPAddress ip = WiFi.localIP();
-  char buffer[strlen_P(_ssdp_schema_template) + 1];
-  strcpy_P(buffer, _ssdp_schema_template);
-  client.printf(buffer,
-                ip.toString().c_str(), _port,
-                _deviceType,
-                _friendlyName,
-                _presentationURL,
-                _serialNumber,
-                _modelName,
-                _modelNumber,
-                _modelURL,
-                _manufacturer,
-                _manufacturerURL,
-                _uuid
-               );
+  if (ip != _renderedIP) {
+    _invalidate();
+    _renderedIP = ip;
+  }
+
+  if (!_schema) {
+    _schema = _ssdp_render(_schemaLength,
+                           _ssdp_schema_template,
+                           ip.toString().c_str(), _port,
+                           _deviceType,
+                           _friendlyName,
+                           _presentationURL,
+                           _serialNumber,
+                           _modelName,
+                           _modelNumber,
+                           _modelURL,
+                           _manufacturer,
+                           _manufacturerURL,
+                           _uuid
+                          );
+  }
+
+  if (_schema) {
+    client.write(_schema.get(), _schemaLength);
+  }
+}
+
+void SSDPClass::_respondLater(bool stIsUuid, unsigned long wait) {
+  IPAddress addr = _server->getRemoteAddress();
+  uint16_t port = _server->getRemotePort();
+
+  // controllers repeat their M-SEARCH, one answer is enough
+  for (uint8_t i = 0; i < _pendingCount; i++) {
+    if (_pending[i].addr == addr && _pending[i].port == port && _pending[i].stIsUuid == stIsUuid) {
+      return;
+    }
+  }
+
+  if (_pendingCount == SSDP_MAX_PENDING) {
+#ifdef DEBUG_SSDP
+    DEBUG_SSDP.printf_P(PSTR("SSDP too many pending responses\n"));
+#endif
+    return;
+  }
+
+  SSDPPending& pending = _pending[_pendingCount++];
+  pending.addr = addr;
+  pending.port = port;
+  pending.stIsUuid = stIsUuid;
+  pending.time = millis() + wait;
+}
+
+void SSDPClass::_respond() {
+  unsigned long now = millis();
+
+  if (_rate) {
+    unsigned long refill = (now - _tokenTime) * _rate / 1000;
+    if (refill) {
+      _tokens = (_tokens + refill < _burst) ? _tokens + refill : _burst;
+      _tokenTime = now;
+    }
+  } else {
+    _tokens = _burst;
+  }
+
+  for (uint8_t i = 0; i < _pendingCount; ) {
+    SSDPPending& pending = _pending[i];
+    if ((long)(now - pending.time) < 0) {
+      i++;
+      continue;
+    }
+
+    if (_tokens) {
+      _tokens--;
+      _send(pending.stIsUuid ? RESPONSE_UUID : RESPONSE_DEVICE_TYPE, pending.addr, pending.port);
+    }
+#ifdef DEBUG_SSDP
+    else {
+      DEBUG_SSDP.printf_P(PSTR("SSDP response rate exceeded\n"));
+    }
+#endif
+    pending = _pending[--_pendingCount];
+  }
 }
 
 void SSDPClass::_update() {
-  if (!_pending && _server->next()) {
+  while (_server->next()) {
     ssdp_method_t method = NONE;
-
-    _respondToAddr = _server->getRemoteAddress();
-    _respondToPort = _server->getRemotePort();
+    bool respond = false;
+    bool stIsUuid = false;
+    unsigned long wait = 0;
 
     typedef enum {METHOD, URI, PROTO, KEY, VALUE, ABORT} states;
     states state = METHOD;
@@ -338,8 +437,7 @@ void SSDPClass::_update() {
           break;
         case KEY:
           if (cr == 4) {
-            _pending = true;
-            _process_time = millis();
+            respond = true;
           }
           else if (c == ' ') {
             cursor = 0;
@@ -367,24 +465,22 @@ void SSDPClass::_update() {
                   DEBUG_SSDP.printf("REJECT: %s\n", (char *)buffer);
 #endif
                 }else{
-                  _st_is_uuid = false;
+                  stIsUuid = false;
                 }
                 // if the search type matches our type, we should respond instead of ABORT
                 if (strcasecmp(buffer, _deviceType) == 0) {
-                  _pending = true;
-                  _st_is_uuid = false;
-                  _process_time = millis();
+                  respond = true;
+                  stIsUuid = false;
                   state = KEY;
                 }
                 if (strcasecmp(buffer, _uuid) == 0) {
-                  _pending = true;
-                  _st_is_uuid = true;
-                  _process_time = millis();
+                  respond = true;
+                  stIsUuid = true;
                   state = KEY;
                 }
                 break;
               case MX:
-                _delay = random(0, atoi(buffer)) * 1000L;
+                wait = random(0, constrain(atoi(buffer), 1, SSDP_MAX_MX) * 1000L);
                 break;
             }
 
@@ -407,78 +503,89 @@ void SSDPClass::_update() {
           }
           break;
         case ABORT:
-          _pending = false; _delay = 0;
+          respond = false;
           break;
       }
     }
-  }
 
-  if (_pending && (millis() - _process_time) > _delay) {
-    _pending = false; _delay = 0;
-    _send(NONE);
-  } else if(_notify_time == 0 || (millis() - _notify_time) > (_interval * 1000L)){
-    _notify_time = millis();
-    _st_is_uuid = false;
-    _send(NOTIFY);
+    if (respond && state != ABORT) {
+      _respondLater(stIsUuid, wait);
+    }
   }
 
-  if (_pending) {
-    while (_server->next())
-      _server->flush();
+  _respond();
+
+  if (_notify_time == 0 || (millis() - _notify_time) > (_interval * 1000L)) {
+    _notify_time = millis();
+    _send(NOTIFY_DEVICE_TYPE, IPAddress(SSDP_MULTICAST_ADDR), SSDP_PORT);
   }
 
+  _server->sendQueued();
 }
 
 void SSDPClass::setSchemaURL(const char *url) {
   strlcpy(_schemaURL, url, sizeof(_schemaURL));
+  _invalidate();
 }
 
 void SSDPClass::setHTTPPort(uint16_t port) {
   _port = port;
+  _invalidate();
 }
 
 void SSDPClass::setDeviceType(const char *deviceType) {
   strlcpy(_deviceType, deviceType, sizeof(_deviceType));
+  _invalidate();
 }
 
 void SSDPClass::setUUID(const char *uuid) {
   snprintf_P(_uuid, sizeof(_uuid), PSTR("uuid:%s"), uuid);  
+  _invalidate();
 }
 
 void SSDPClass::setName(const char *name) {
   strlcpy(_friendlyName, name, sizeof(_friendlyName));
+  _invalidate();
 }
 
 void SSDPClass::setURL(const char *url) {
   strlcpy(_presentationURL, url, sizeof(_presentationURL));
+  _invalidate();
 }
 
 void SSDPClass::setSerialNumber(const char *serialNumber) {
   strlcpy(_serialNumber, serialNumber, sizeof(_serialNumber));
+  _invalidate();
 }
 
 void SSDPClass::setSerialNumber(const uint32_t serialNumber) {
   snprintf(_serialNumber, sizeof(uint32_t) * 2 + 1, "%08X", serialNumber);
+  _invalidate();
 }
 
 void SSDPClass::setModelName(const char *name) {
   strlcpy(_modelName, name, sizeof(_modelName));
+  _invalidate();
 }
 
 void SSDPClass::setModelNumber(const char *num) {
   strlcpy(_modelNumber, num, sizeof(_modelNumber));
+  _invalidate();
 }
 
 void SSDPClass::setModelURL(const char *url) {
   strlcpy(_modelURL, url, sizeof(_modelURL));
+  _invalidate();
 }
 
 void SSDPClass::setManufacturer(const char *name) {
   strlcpy(_manufacturer, name, sizeof(_manufacturer));
+  _invalidate();
 }
 
 void SSDPClass::setManufacturerURL(const char *url) {
   strlcpy(_manufacturerURL, url, sizeof(_manufacturerURL));
+  _invalidate();
 }
 
 void SSDPClass::setTTL(const uint8_t ttl) {
@@ -487,6 +594,15 @@ void SSDPClass::setTTL(const uint8_t ttl) {
 
 void SSDPClass::setInterval(uint32_t interval) {
   _interval = interval;
+  _invalidate();
+}
+
+void SSDPClass::setResponseRate(uint8_t perSecond, uint8_t burst) {
+  _rate = perSecond;
+  _burst = burst;
+  if (_tokens > _burst) {
+    _tokens = _burst;
+  }
 }
 
 void SSDPClass::_onTimerStatic(SSDPClass* self) {
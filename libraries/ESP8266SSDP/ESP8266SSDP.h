@@ -32,6 +32,7 @@ License (MIT license):
 #include <Arduino.h>
 #include <ESP8266WiFi.h>
 #include <WiFiUdp.h>
+#include <memory>
 
 class UdpContext;
 
@@ -49,6 +50,9 @@ class UdpContext;
 #define SSDP_INTERVAL_SECONDS       1200
 #define SSDP_MULTICAST_TTL          2
 #define SSDP_HTTP_PORT              80
+#define SSDP_MAX_PENDING            4    // M-SEARCH answers waiting for their random delay
+#define SSDP_RESPONSE_RATE          4    // M-SEARCH answers per second, on average
+#define SSDP_RESPONSE_BURST         8    // M-SEARCH answers at once, after a quiet time
 
 typedef enum {
   NONE,
@@ -96,9 +100,31 @@ class SSDPClass{
     void setHTTPPort(uint16_t port);
     void setTTL(uint8_t ttl);
     void setInterval(uint32_t interval);
+    // Limits the answers to M-SEARCH requests, bursts of controllers asking
+    // at once are answered at most `perSecond` times a second (after the
+    // first `burst` ones), the others dropped
+    void setResponseRate(uint8_t perSecond, uint8_t burst = SSDP_RESPONSE_BURST);
 
   protected:
-    void _send(ssdp_method_t method);
+    typedef enum {
+      RESPONSE_DEVICE_TYPE,
+      RESPONSE_UUID,
+      NOTIFY_DEVICE_TYPE,
+      PACKET_COUNT
+    } ssdp_packet_t;
+
+    struct SSDPPending {
+      IPAddress addr;
+      uint16_t port;
+      bool stIsUuid;
+      unsigned long time; // millis() when due
+    };
+
+    void _send(ssdp_packet_t packet, const IPAddress& addr, uint16_t port);
+    const char* _packet(ssdp_packet_t packet, size_t& length);
+    void _invalidate() const;
+    void _respondLater(bool stIsUuid, unsigned long wait);
+    void _respond();
     void _update();
     void _startTimer();
     void _stopTimer();
@@ -110,15 +136,23 @@ class SSDPClass{
     uint8_t _ttl = SSDP_MULTICAST_TTL;
     uint32_t _interval = SSDP_INTERVAL_SECONDS;
 
-    IPAddress _respondToAddr;
-    uint16_t  _respondToPort = 0;
-
-    bool _pending = false;
-    bool _st_is_uuid = false;
-    unsigned short _delay = 0;
-    unsigned long _process_time = 0;
     unsigned long _notify_time = 0;
 
+    SSDPPending _pending[SSDP_MAX_PENDING];
+    uint8_t _pendingCount = 0;
+    uint8_t _rate = SSDP_RESPONSE_RATE;
+    uint8_t _burst = SSDP_RESPONSE_BURST;
+    uint8_t _tokens = SSDP_RESPONSE_BURST;
+    unsigned long _tokenTime = 0;
+
+    // packets and schema, rendered when first needed for the current
+    // settings and local address
+    mutable IPAddress _renderedIP;
+    mutable std::unique_ptr<char[]> _packets[PACKET_COUNT];
+    mutable size_t _packetLengths[PACKET_COUNT] = { };
+    mutable std::unique_ptr<char[]> _schema;
+    mutable size_t _schemaLength = 0;
+
     char _schemaURL[SSDP_SCHEMA_URL_SIZE];
     char _uuid[SSDP_UUID_SIZE];
     char _deviceType[SSDP_DEVICE_TYPE_SIZE];
@@ -29,12 +29,12 @@
 #include "base64.h"
 #include "detail/RequestHandlersImpl.h"
 #include <StreamDev.h>
+#include <MemoryPressure.h>
 
 static const char AUTHORIZATION_HEADER[] PROGMEM = "Authorization";
 static const char qop_auth[] PROGMEM = "qop=auth";
 static const char qop_auth_quoted[] PROGMEM = "qop=\"auth\"";
 static const char WWW_Authenticate[] PROGMEM = "WWW-Authenticate";
-static const char Content_Length[] PROGMEM = "Content-Length";
 static const char ETAG_HEADER[] PROGMEM = "If-None-Match";
 
 namespace esp8266webserver {
@@ -259,6 +259,46 @@ void ESP8266WebServerTemplate<ServerType>::_addRequestHandler(RequestHandlerType
       _lastHandler->next(handler);
       _lastHandler = handler;
     }
+    _routes.reset();
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::compileRoutes() {
+  _routesCompiled = true;
+  _routes.reset(new RouteTable<ServerType>);
+  _routes->build(_firstHandler);
+}
+
+template <typename ServerType>
+typename ESP8266WebServerTemplate<ServerType>::RequestHandlerType* ESP8266WebServerTemplate<ServerType>::_findHandler() {
+  if (_routesCompiled) {
+    if (!_routes)
+      compileRoutes();
+    return _routes->find(_currentMethod, _currentUri);
+  }
+
+  RequestHandlerType* handler;
+  for (handler = _firstHandler; handler; handler = handler->next()) {
+    if (handler->canHandle(_currentMethod, _currentUri))
+      break;
+  }
+  return handler;
+}
+
+template <typename ServerType>
+typename ESP8266WebServerTemplate<ServerType>::WebSocketHandlerType& ESP8266WebServerTemplate<ServerType>::onWebSocket(const String& uri, typename WebSocketHandlerType::EventFunction fn) {
+  WebSocketHandlerType* handler = new WebSocketHandlerType(uri, fn);
+  _addRequestHandler(handler);
+  _webSockets.push_back(handler);
+  return *handler;
+}
+
+template <typename ServerType>
+typename ESP8266WebServerTemplate<ServerType>::EventSourceHandlerType& ESP8266WebServerTemplate<ServerType>::onEventSource(const String& uri) {
+  EventSourceHandlerType* handler = new EventSourceHandlerType(uri);
+  _addRequestHandler(handler);
+  _eventSources.push_back(handler);
+  return *handler;
 }
 
 template <typename ServerType>
@@ -280,21 +320,88 @@ void ESP8266WebServerTemplate<ServerType>::serveStatic(const char* uri, FS& fs,
 
 template <typename ServerType>
 void ESP8266WebServerTemplate<ServerType>::handleClient() {
-  if (_currentStatus == HC_NONE) {
-    ClientType client = _server.accept();
-    if (!client) {
-      return;
+  if (!_connections) {
+    _connections.reset(new Connection[_maxClients]);
+  }
+
+  for (WebSocketHandlerType* webSocket : _webSockets) {
+    webSocket->loop();
+  }
+  for (EventSourceHandlerType* eventSource : _eventSources) {
+    eventSource->loop();
+  }
+
+  bool callYield = false;
+  // low on heap, new clients wait for fewer connections
+  uint8_t accepting = MemoryPressure.scale(_maxClients);
+  for (uint8_t i = 0; i < _maxClients; i++) {
+    Connection& conn = _connections[i];
+    if (conn.status == HC_NONE) {
+      if (i >= accepting) {
+        continue;
+      }
+      conn.client = _server.accept();
+      if (!conn.client) {
+        continue;
+      }
+
+      DBGWS("New client\n");
+
+      conn.status = HC_WAIT_READ;
+      conn.statusChange = millis();
+      _head = &conn.head;
+      _resetHead();
+      _head->served = 0;
+      _head->keepAlive = false;
+    }
+
+    // with no free connection, pending clients can only be served by dropping this one
+    bool contended = true;
+    for (uint8_t j = 0; contended && j < _maxClients; j++) {
+      contended = _connections[j].status != HC_NONE;
     }
 
-    DBGWS("New client\n");
+    _currentClient = conn.client;
+    _currentStatus = conn.status;
+    _statusChange = conn.statusChange;
+    _head = &conn.head;
+    _swapRequest(conn.head);
+    callYield |= _handleConnection(contended);
+    _swapRequest(conn.head);
+    conn.client = _currentClient;
+    conn.status = _currentStatus;
+    conn.statusChange = _statusChange;
+  }
+
+  if (callYield) {
+    yield();
+  }
+}
 
-    _currentClient = client;
-    _currentStatus = HC_WAIT_READ;
-    _statusChange = millis();
+// Exchanges the request state of the server with the one of a connection,
+// swapped in before serving it and back out after, so that the heads
+// parsed side by side don't overwrite each other.
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::_swapRequest(RequestHead& head) {
+  std::swap(_currentMethod, head.method);
+  std::swap(_currentVersion, head.version);
+  std::swap(_keepAlive, head.keepAlive);
+  std::swap(_currentUri, head.uri);
+  std::swap(_hostHeader, head.host);
+  std::swap(_webSocketKey, head.webSocketKey);
+  if (head.headerValues.size() != (size_t)_headerKeysCount) {
+    head.headerValues.resize(_headerKeysCount);
+  }
+  for (int i = 0; i < _headerKeysCount; ++i) {
+    std::swap(_currentHeaders[i].value, head.headerValues[i]);
   }
+}
 
+template <typename ServerType>
+bool ESP8266WebServerTemplate<ServerType>::_handleConnection(bool contended) {
   bool keepCurrentClient = false;
   bool callYield = false;
+  _contended = contended;
 
 #ifdef DEBUG_ESP_HTTP_SERVER
 
@@ -336,17 +443,58 @@ void ESP8266WebServerTemplate<ServerType>::handleClient() {
       // No-op to avoid C++ compiler warning
       break;
     case HC_WAIT_READ:
-      // Wait for data from client to become available
-      if (_currentClient.available()) {
-        switch (_parseRequest(_currentClient))
+      // Wait for data from client to become available,
+      // the request head is parsed as it arrives.
+      // Requests already received (pipelined) are served in a row.
+      for (uint8_t pipelined = 0; ; ) {
+        if (!_currentClient.available() || !_parseHead(_currentClient)) {
+          // waiting for more data
+          unsigned long timeSinceChange = millis() - _statusChange;
+          // Use faster connection drop timeout if any other client has data
+          // or the buffer of pending clients is full
+          if (contended && (_server.hasClientData() || _server.hasMaxPendingClients())
+            && timeSinceChange > HTTP_MAX_DATA_AVAILABLE_WAIT)
+              DBGWS("webserver: closing since there's another connection to read from\n");
+          else {
+            if (timeSinceChange > HTTP_MAX_DATA_WAIT)
+              DBGWS("webserver: closing after read timeout\n");
+            else
+              keepCurrentClient = true;
+          }
+          callYield = true;
+          break;
+        }
+
+        unsigned long parseStart = micros();
+        ClientFuture future = _parseRequest(_currentClient);
+        uint32_t parseTime = micros() - parseStart;
+        unsigned long handleStart;
+        _resetHead();
+        _head->served++;
+        switch (future)
         {
         case CLIENT_REQUEST_CAN_CONTINUE:
           _currentClient.setTimeout(HTTP_MAX_SEND_WAIT);
           _contentLength = CONTENT_LENGTH_NOT_SET;
+          _sendMicros = 0;
+          _sentBytes = 0;
+          handleStart = micros();
           _handleRequest();
+          if (_metrics)
+            _recordMetrics(parseTime, micros() - handleStart);
+          if (_clientGiven) {
+            // taken over by the handler (WebSocket, event stream)
+            _clientGiven = false;
+            DBGWS("Give client\n");
+            break;
+          }
           /* fallthrough */
         case CLIENT_REQUEST_IS_HANDLED:
-          if (_currentClient.connected() || _currentClient.available()) {
+          if (_keepAliveMaxRequests && _head->served >= _keepAliveMaxRequests) {
+            DBGWS("webserver: closing after %u requests\n", _head->served);
+            _currentClient.stop();
+          }
+          else if (_currentClient.connected() || _currentClient.available()) {
             _currentStatus = HC_WAIT_CLOSE;
             _statusChange = millis();
             keepCurrentClient = true;
@@ -364,26 +512,18 @@ void ESP8266WebServerTemplate<ServerType>::handleClient() {
           DBGWS("Give client\n");
           break;
         } // switch _parseRequest()
-      } else {
-        // !_currentClient.available(): waiting for more data
-        unsigned long timeSinceChange = millis() - _statusChange;
-        // Use faster connection drop timeout if any other client has data
-        // or the buffer of pending clients is full
-        if ((_server.hasClientData() || _server.hasMaxPendingClients())
-          && timeSinceChange > HTTP_MAX_DATA_AVAILABLE_WAIT)
-            DBGWS("webserver: closing since there's another connection to read from\n");
-        else {
-          if (timeSinceChange > HTTP_MAX_DATA_WAIT)
-            DBGWS("webserver: closing after read timeout\n");
-          else
-            keepCurrentClient = true;
-        }
-        callYield = true;
+
+        if (!keepCurrentClient || !_keepAlive || !_currentClient.available() || ++pipelined >= HTTP_MAX_PIPELINED)
+          break;
+        // next request head is (at least partly) there already
+        keepCurrentClient = false;
+        _currentStatus = HC_WAIT_READ;
+        _statusChange = millis();
       }
       break;
     case HC_WAIT_CLOSE:
       // Wait for client to close the connection
-      if (!_server.hasClient() && (millis() - _statusChange <= HTTP_MAX_CLOSE_WAIT)) {
+      if ((!contended || !_server.hasClient()) && (millis() - _statusChange <= _keepAliveTimeout)) {
         keepCurrentClient = true;
         callYield = true;
         if (_currentClient.available())
@@ -401,19 +541,33 @@ void ESP8266WebServerTemplate<ServerType>::handleClient() {
     _currentUpload.reset();
   }
 
-  if (callYield) {
-    yield();
-  }
+  return callYield;
 }
 
 template <typename ServerType>
 void ESP8266WebServerTemplate<ServerType>::close() {
   _server.close();
   _currentStatus = HC_NONE;
+  for (WebSocketHandlerType* webSocket : _webSockets) {
+    webSocket->closeAll();
+  }
+  for (EventSourceHandlerType* eventSource : _eventSources) {
+    eventSource->closeAll();
+  }
+  for (uint8_t i = 0; _connections && i < _maxClients; i++) {
+    _connections[i].client = ClientType();
+    _connections[i].status = HC_NONE;
+  }
   if(!_headerKeysCount)
     collectHeaders();
 }
 
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::setMaxClients(uint8_t maxClients) {
+  _connections.reset();
+  _maxClients = maxClients ? maxClients : 1;
+}
+
 template <typename ServerType>
 void ESP8266WebServerTemplate<ServerType>::stop() {
   close();
@@ -421,16 +575,18 @@ void ESP8266WebServerTemplate<ServerType>::stop() {
 
 template <typename ServerType>
 void ESP8266WebServerTemplate<ServerType>::sendHeader(const String& name, const String& value, bool first) {
-  String headerLine = name;
-  headerLine += F(": ");
-  headerLine += value;
-  headerLine += "\r\n";
-
   if (first) {
+    String headerLine = name;
+    headerLine += F(": ");
+    headerLine += value;
+    headerLine += "\r\n";
     _responseHeaders = headerLine + _responseHeaders;
   }
   else {
-    _responseHeaders += headerLine;
+    _responseHeaders += name;
+    _responseHeaders += F(": ");
+    _responseHeaders += value;
+    _responseHeaders += "\r\n";
   }
 }
 
@@ -440,44 +596,53 @@ void ESP8266WebServerTemplate<ServerType>::setContentLength(const size_t content
 }
 
 template <typename ServerType>
-void ESP8266WebServerTemplate<ServerType>::_prepareHeader(String& response, int code, const char* content_type, size_t contentLength) {
-    response = String(F("HTTP/1.")) + String(_currentVersion) + ' ';
-    response += String(code);
-    response += ' ';
-    response += responseCodeToString(code);
-    response += "\r\n";
+void ESP8266WebServerTemplate<ServerType>::_prepareHeader(HeaderWriter& header, int code, const char* content_type, size_t contentLength) {
+    header.statusLine(_currentVersion, code, _responseCodeText(code));
 
     using namespace mime;
     if (!content_type)
         content_type = mimeTable[html].mimeType;
 
-    sendHeader(String(F("Content-Type")), String(FPSTR(content_type)), true);
+    header.header(HEADER_CONTENT_TYPE, content_type);
+    header.append(_responseHeaders.c_str(), _responseHeaders.length());
     if (_contentLength == CONTENT_LENGTH_NOT_SET) {
-        sendHeader(String(FPSTR(Content_Length)), String(contentLength));
+        header.header(HEADER_CONTENT_LENGTH, contentLength);
     } else if (_contentLength != CONTENT_LENGTH_UNKNOWN) {
-        sendHeader(String(FPSTR(Content_Length)), String(_contentLength));
+        header.header(HEADER_CONTENT_LENGTH, _contentLength);
     } else if(_contentLength == CONTENT_LENGTH_UNKNOWN && _currentVersion){ //HTTP/1.1 or above client
       //let's do chunked
       _chunked = true;
-      sendHeader(String(F("Accept-Ranges")),String(F("none")));
-      sendHeader(String(F("Transfer-Encoding")),String(F("chunked")));
+      header.header(HEADER_ACCEPT_RANGES, PSTR("none"));
+      header.header(HEADER_TRANSFER_ENCODING, PSTR("chunked"));
     }
     if (_corsEnabled) {
-      sendHeader(String(F("Access-Control-Allow-Origin")), String("*"));
+      header.header(HEADER_ACCESS_CONTROL_ALLOW_ORIGIN, PSTR("*"));
     }
 
-    if (_keepAlive && _server.hasClient()) { // Disable keep alive if another client is waiting.
+    if (_keepAlive && _contended && _server.hasClient()) { // Disable keep alive if another client is waiting for a free connection.
       _keepAlive = false;
     }
-    sendHeader(String(F("Connection")), String(_keepAlive ? F("keep-alive") : F("close")));
+    if (_keepAlive && MemoryPressure.level() == HeapLevel::Critical) { // Or when the heap is about to run out.
+      _keepAlive = false;
+    }
+    uint16_t served = _head ? _head->served : 0;
+    if (_keepAliveMaxRequests && served >= _keepAliveMaxRequests) {
+      _keepAlive = false;
+    }
+    header.header(HEADER_CONNECTION, _keepAlive ? PSTR("keep-alive") : PSTR("close"));
     if (_keepAlive) {
-      sendHeader(String(F("Keep-Alive")), String(F("timeout=")) + HTTP_MAX_CLOSE_WAIT);
+      header.name(HEADER_KEEP_ALIVE);
+      header.append_P(PSTR("timeout="), 8);
+      header.number((_keepAliveTimeout + 999) / 1000); // seconds
+      if (_keepAliveMaxRequests) {
+        header.append_P(PSTR(", max="), 6);
+        header.number(_keepAliveMaxRequests - served);
+      }
+      header.crlf();
     }
 
-
-    response += _responseHeaders;
-    response += "\r\n";
-    _responseHeaders = "";
+    header.crlf();
+    _responseHeaders.clear();
 }
 
 template <typename ServerType>
@@ -487,7 +652,19 @@ void ESP8266WebServerTemplate<ServerType>::send(int code, char* content_type, co
 
 template <typename ServerType>
 void ESP8266WebServerTemplate<ServerType>::send(int code, const char* content_type, const String& content) {
-  return send(code, content_type, content.c_str(), content.length());
+  unsigned long start = micros();
+  HeaderWriter header(_currentClient);
+  _prepareHeader(header, code, content_type, content.length());
+  // header and body with one write, chunk framing goes through sendContent()
+  size_t body = (_chunked || _currentMethod == HTTP_HEAD)? 0: content.length();
+  header.write(content.c_str(), body);
+  if (header.sent() != header.total())
+      DBGWS("HTTPServer: error: sent %zd on %zu bytes\n", header.sent(), header.total());
+  _metricsSent(start, header.sent());
+  if (_chunked && content.length()) {
+    StreamConstPtr ref(content.c_str(), content.length());
+    sendContent(&ref, content.length());
+  }
 }
 
 template <typename ServerType>
@@ -503,13 +680,15 @@ void ESP8266WebServerTemplate<ServerType>::sendContent(const String& content) {
 
 template <typename ServerType>
 void ESP8266WebServerTemplate<ServerType>::send(int code, const char* content_type, Stream* stream, size_t content_length /*= 0*/) {
-  String header;
+  unsigned long start = micros();
+  HeaderWriter header(_currentClient);
   if (content_length == 0)
       content_length = std::max((ssize_t)0, stream->streamRemaining());
   _prepareHeader(header, code, content_type, content_length);
-  size_t sent = StreamConstPtr(header).sendAll(&_currentClient);
-  if (sent != header.length())
-      DBGWS("HTTPServer: error: sent %zd on %u bytes\n", sent, header.length());
+  header.flush();
+  if (header.sent() != header.total())
+      DBGWS("HTTPServer: error: sent %zd on %zu bytes\n", header.sent(), header.total());
+  _metricsSent(start, header.sent());
   if (content_length)
     return sendContent(stream, content_length);
 }
@@ -522,8 +701,32 @@ void ESP8266WebServerTemplate<ServerType>::send_P(int code, PGM_P content_type,
 
 template <typename ServerType>
 void ESP8266WebServerTemplate<ServerType>::send_P(int code, PGM_P content_type, PGM_P content, size_t contentLength) {
-  StreamConstPtr ref(content, contentLength);
-  return send(code, String(content_type).c_str(), &ref);
+  if (contentLength < HTTP_SEND_REFERENCE_MIN || !mmu_is_dram(content)) {
+    StreamConstPtr ref(content, contentLength);
+    return send(code, String(content_type).c_str(), &ref);
+  }
+  // large RAM content: lwIP sends it in place instead of copying it
+  unsigned long start = micros();
+  HeaderWriter header(_currentClient);
+  _prepareHeader(header, code, content_type, contentLength);
+  header.flush();
+  if (header.sent() != header.total())
+      DBGWS("HTTPServer: error: sent %zd on %zu bytes\n", header.sent(), header.total());
+  _metricsSent(start, header.sent());
+  if (_chunked) {
+    StreamConstPtr ref(content, contentLength);
+    return sendContent(&ref, contentLength);
+  }
+  if (_currentMethod == HTTP_HEAD)
+    return;
+  start = micros();
+  size_t sent = _currentClient.writeReference((const uint8_t*)content, contentLength);
+  if (sent != contentLength)
+      DBGWS("HTTPServer: error: sent %zd on %zu bytes\n", sent, contentLength);
+  // content belongs to the caller, lwIP must be done with it before returning
+  if (!_currentClient.acknowledged() && !(_currentClient.flush(HTTP_MAX_SEND_WAIT) && _currentClient.acknowledged()))
+    _currentClient.stop(0);
+  _metricsSent(start, sent);
 }
 
 template <typename ServerType>
@@ -532,6 +735,7 @@ void ESP8266WebServerTemplate<ServerType>::sendContent(Stream* content, ssize_t
     return;
   if (content_length <= 0)
     content_length = std::max((ssize_t)0, content->streamRemaining());
+  unsigned long start = micros();
   if(_chunked) {
     _currentClient.printf("%zx\r\n", content_length);
   }
@@ -546,6 +750,7 @@ void ESP8266WebServerTemplate<ServerType>::sendContent(Stream* content, ssize_t
       _chunked = false;
     }
   }
+  _metricsSent(start, sent);
 }
 
 template <typename ServerType>
@@ -590,7 +795,7 @@ const String& ESP8266WebServerTemplate<ServerType>::pathArg(unsigned int i) cons
 }
 
 template <typename ServerType>
-const String& ESP8266WebServerTemplate<ServerType>::arg(const String& name) const {
+const String& ESP8266WebServerTemplate<ServerType>::arg(StringView name) const {
   for (int j = 0; j < _postArgsLen; ++j) {
     if ( _postArgs[j].key == name )
       return _postArgs[j].value;
@@ -622,7 +827,7 @@ int ESP8266WebServerTemplate<ServerType>::args() const {
 }
 
 template <typename ServerType>
-bool ESP8266WebServerTemplate<ServerType>::hasArg(const String& name) const {
+bool ESP8266WebServerTemplate<ServerType>::hasArg(StringView name) const {
   for (int j = 0; j < _postArgsLen; ++j) {
     if (_postArgs[j].key == name)
       return true;
@@ -635,9 +840,9 @@ bool ESP8266WebServerTemplate<ServerType>::hasArg(const String& name) const {
 }
 
 template <typename ServerType>
-const String& ESP8266WebServerTemplate<ServerType>::header(const String& name) const {
+const String& ESP8266WebServerTemplate<ServerType>::header(StringView name) const {
   for (int i = 0; i < _headerKeysCount; ++i) {
-    if (_currentHeaders[i].key.equalsIgnoreCase(name))
+    if (name.equalsIgnoreCase(_currentHeaders[i].key))
       return _currentHeaders[i].value;
   }
   return emptyString;
@@ -687,9 +892,9 @@ int ESP8266WebServerTemplate<ServerType>::headers() const {
 }
 
 template <typename ServerType>
-bool ESP8266WebServerTemplate<ServerType>::hasHeader(const String& name) const {
+bool ESP8266WebServerTemplate<ServerType>::hasHeader(StringView name) const {
   for (int i = 0; i < _headerKeysCount; ++i) {
-    if ((_currentHeaders[i].key.equalsIgnoreCase(name)) &&  (_currentHeaders[i].value.length() > 0))
+    if ((name.equalsIgnoreCase(_currentHeaders[i].key)) &&  (_currentHeaders[i].value.length() > 0))
       return true;
   }
   return false;
@@ -738,6 +943,57 @@ void ESP8266WebServerTemplate<ServerType>::_handleRequest() {
 }
 
 
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::_recordMetrics(uint32_t parseTime, uint32_t handleTime) {
+  RouteMetrics& metrics = _metrics->of(_currentHandler);
+  metrics.requests++;
+  metrics.bytesSent += _sentBytes;
+  metrics.latency[METRICS_PARSE].add(parseTime);
+  metrics.latency[METRICS_HANDLER].add(handleTime - std::min(handleTime, _sendMicros));
+  metrics.latency[METRICS_SEND].add(_sendMicros);
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::enableMetrics(bool enable) {
+  if (!enable)
+    _metrics.reset();
+  else if (!_metrics)
+    _metrics.reset(new RequestMetrics<ServerType>);
+}
+
+template <typename ServerType>
+const RouteMetrics* ESP8266WebServerTemplate<ServerType>::metrics(const RequestHandlerType* handler) const {
+  return _metrics ? _metrics->find(handler) : nullptr;
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::resetMetrics() {
+  if (_metrics)
+    _metrics->reset();
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::writeMetrics(Print& out) {
+  if (_metrics)
+    _metrics->write(out, _firstHandler);
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::serveMetrics(const Uri& uri) {
+  enableMetrics(true);
+  on(uri, HTTP_GET, [this]() {
+    // chunked, or until the connection closes for HTTP/1.0 clients
+    setContentLength(CONTENT_LENGTH_UNKNOWN);
+    send_P(200, PSTR("text/plain; version=0.0.4"), "");
+    {
+      ContentPrint<WebServerType> body(*this);
+      writeMetrics(body);
+    }
+    if (!_currentVersion)
+      _currentClient.stop();
+  });
+}
+
 template <typename ServerType>
 void ESP8266WebServerTemplate<ServerType>::_finalizeResponse() {
   if (_chunked) {
@@ -747,6 +1003,11 @@ void ESP8266WebServerTemplate<ServerType>::_finalizeResponse() {
 
 template <typename ServerType>
 String ESP8266WebServerTemplate<ServerType>::responseCodeToString(const int code) {
+    return String(_responseCodeText(code));
+}
+
+template <typename ServerType>
+const __FlashStringHelper* ESP8266WebServerTemplate<ServerType>::_responseCodeText(const int code) {
     // By first determining the pointer to the flash stored string in the switch
     // statement and then doing String(FlashStringHelper) return reduces the total code
     // size of this function by over 50%.
@@ -877,7 +1138,7 @@ String ESP8266WebServerTemplate<ServerType>::responseCodeToString(const int code
         r = F("");
         break;
     }
-    return String(r);
+    return r;
 }
 
 } // namespace
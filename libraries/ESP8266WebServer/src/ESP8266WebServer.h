@@ -1,6 +1,6 @@
 /*
   ESP8266WebServer.h - Dead simple web-server.
-  Supports only one simultaneous client, knows how to handle GET and POST.
+  Supports one or a few simultaneous clients, knows how to handle GET and POST.
 
   Copyright (c) 2014 Ivan Grokhotkov. All rights reserved.
 
@@ -26,6 +26,7 @@
 
 #include <functional>
 #include <memory>
+#include <vector>
 #include <functional>
 #include <ESP8266WiFi.h>
 #include <FS.h>
@@ -58,11 +59,28 @@ enum HTTPAuthMethod { BASIC_AUTH, DIGEST_AUTH };
 #define HTTP_UPLOAD_BUFLEN 2048
 #endif
 
+#ifndef HTTP_REQUEST_LINE_LEN
+#define HTTP_REQUEST_LINE_LEN 256 //request and header lines are parsed in place up to this size, longer ones go to a String
+#endif
+
+#ifndef HTTP_MAX_CLIENTS
+#define HTTP_MAX_CLIENTS 1 //default number of clients served in parallel (see setMaxClients())
+#endif
+
 #define HTTP_MAX_DATA_WAIT 5000 //ms to wait for the client to send the request
 #define HTTP_MAX_DATA_AVAILABLE_WAIT 30 //ms to wait for the client to send the request when there is another client with data available
 #define HTTP_MAX_POST_WAIT 5000 //ms to wait for POST data to arrive
 #define HTTP_MAX_SEND_WAIT 5000 //ms to wait for data chunk to be ACKed
+#ifndef HTTP_SEND_REFERENCE_MIN
+#define HTTP_SEND_REFERENCE_MIN (2 * HTTP_DOWNLOAD_UNIT_SIZE) //send_P() RAM content from this size is not copied by lwIP
+#endif
 #define HTTP_MAX_CLOSE_WAIT 2000 //ms to wait for the client to close the connection
+#ifndef HTTP_MAX_KEEPALIVE_REQUESTS
+#define HTTP_MAX_KEEPALIVE_REQUESTS 100 //requests served on a connection before it is closed, 0 for no limit (see setKeepAliveLimits())
+#endif
+#ifndef HTTP_MAX_PIPELINED
+#define HTTP_MAX_PIPELINED 4 //requests already received on a connection served in a row by one handleClient() call
+#endif
 
 #define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
 #define CONTENT_LENGTH_NOT_SET ((size_t) -2)
@@ -86,6 +104,11 @@ class ESP8266WebServerTemplate;
 }
 
 #include "detail/RequestHandler.h"
+#include "detail/RouteTable.h"
+#include "detail/HeaderWriter.h"
+#include "detail/WebSocket.h"
+#include "detail/EventSource.h"
+#include "detail/RequestMetrics.h"
 
 namespace esp8266webserver {
 
@@ -100,6 +123,9 @@ public:
   using ClientType = typename ServerType::ClientType;
   using RequestHandlerType = RequestHandler<ServerType>;
   using WebServerType = ESP8266WebServerTemplate<ServerType>;
+  using WebSocketHandlerType = WebSocketHandler<ServerType>;
+  using WebSocketType = WebSocket<ServerType>;
+  using EventSourceHandlerType = EventSourceHandler<ServerType>;
   enum ClientFuture { CLIENT_REQUEST_CAN_CONTINUE, CLIENT_REQUEST_IS_HANDLED, CLIENT_MUST_STOP, CLIENT_IS_GIVEN };
   typedef String (*ContentTypeFunction) (const String&);
   using HookFunction = std::function<ClientFuture(const String& method, const String& url, WiFiClient* client, ContentTypeFunction contentType)>;
@@ -108,6 +134,12 @@ public:
   void begin(uint16_t port);
   void handleClient();
   void close();
+  // Number of connections handleClient() serves in parallel: their request
+  // heads are read side by side, idle keep-alive clients no longer hold the
+  // server. Handlers still run one at a time. Each connection costs about
+  // HTTP_REQUEST_LINE_LEN + 100 bytes. Call before begin(). Fewer are
+  // accepted under MemoryPressure.
+  void setMaxClients(uint8_t maxClients);
   void stop();
 
   bool authenticate(const char * username, const char * password);
@@ -123,32 +155,58 @@ public:
   void addHandler(RequestHandlerType* handler);
   void serveStatic(const char* uri, fs::FS& fs, const char* path, const char* cache_header = NULL );
   void onNotFound(THandlerFunction fn);  //called when handler is not assigned
+  // Accept WebSocket connections on uri. They are polled by handleClient(),
+  // fn is called on connect, disconnect, messages and pongs. The returned
+  // handler broadcasts to its connections.
+  WebSocketHandlerType& onWebSocket(const String& uri, typename WebSocketHandlerType::EventFunction fn);
+  // Serve text/event-stream subscriptions on uri, kept open and fed by
+  // handleClient(). Events are given to the returned handler's send().
+  EventSourceHandlerType& onEventSource(const String& uri);
   void onFileUpload(THandlerFunction fn); //handle file uploads
   void enableCORS(bool enable);
+  // Index the handlers in a trie of path segments instead of asking each
+  // one in turn, for servers with many routes. Literal uris and '{}'
+  // UriBraces segments are indexed, other handlers are still asked in
+  // order. The table is rebuilt when handlers are added.
+  void compileRoutes();
   void enableETag(bool enable, ETagFunction fn = nullptr);
+  // Record, per request handler, the number of requests, the bytes sent
+  // by send*() and streamFile(), and latency histograms of the parse,
+  // handler and send phases (no allocation per request).
+  void enableMetrics(bool enable);
+  const RouteMetrics* metrics(const RequestHandlerType* handler) const; // nullptr: requests no handler accepted
+  void resetMetrics();
+  void writeMetrics(Print& out); // Prometheus text format
+  // GET uri returns writeMetrics(), enables metrics
+  void serveMetrics(const Uri& uri = Uri("/metrics"));
 
   const String& uri() const { return _currentUri; }
   HTTPMethod method() const { return _currentMethod; }
   ClientType& client() { return _currentClient; }
+  // The connection is left open and no longer served once the request
+  // handler returns, it belongs to whoever kept a copy of client(). A
+  // chunked response is not terminated either.
+  void detachClient() { _clientGiven = true; _chunked = false; }
+  const String& webSocketKey() const { return _webSocketKey; } // Sec-WebSocket-Key of the request
   HTTPUpload& upload() { return *_currentUpload; }
 
   // Allows setting server options (i.e. SSL keys) by the instantiator
   ServerType &getServer() { return _server; }
 
   const String& pathArg(unsigned int i) const; // get request path argument by number
-  const String& arg(const String& name) const;    // get request argument value by name
+  const String& arg(StringView name) const;       // get request argument value by name
   const String& arg(int i) const;          // get request argument value by number
   const String& argName(int i) const;      // get request argument name by number
   int args() const;                        // get arguments count
-  bool hasArg(const String& name) const;   // check if argument exists
+  bool hasArg(StringView name) const;      // check if argument exists
   void collectHeaders(const char* headerKeys[], const size_t headerKeysCount); // set the request headers to collect
   template<typename... Args>
   void collectHeaders(const Args&... args); // set the request headers to collect (variadic template version)
-  const String& header(const String& name) const; // get request header value by name
+  const String& header(StringView name) const;    // get request header value by name
   const String& header(int i) const;       // get request header value by number
   const String& headerName(int i) const;   // get request header name by number
   int headers() const;                     // get header count
-  bool hasHeader(const String& name) const;       // check if header exists
+  bool hasHeader(StringView name) const;          // check if header exists
   const String& hostHeader() const;        // get request host header if available or empty String if not
 
   // send response to the client
@@ -214,6 +272,13 @@ public:
   // If the client sends the "Connection" header, the value given by the header is used.
   void keepAlive(bool keepAlive) { _keepAlive = keepAlive; }
   bool keepAlive() { return _keepAlive; }
+  // Persistent connections are closed after maxRequests requests (0: no
+  // limit) or when idle for idleTimeout ms. Defaults are
+  // HTTP_MAX_KEEPALIVE_REQUESTS and HTTP_MAX_CLOSE_WAIT.
+  void setKeepAliveLimits(uint16_t maxRequests, unsigned long idleTimeout) {
+    _keepAliveMaxRequests = maxRequests;
+    _keepAliveTimeout = idleTimeout;
+  }
 
   static String credentialHash(const String& username, const String& realm, const String& password);
 
@@ -232,7 +297,9 @@ public:
     size_t contentLength = 0;
     _streamFileCore(file.size(), file.name(), contentType);
     if (requestMethod == HTTP_GET) {
-      contentLength = file.sendAll(_currentClient);
+      unsigned long start = micros();
+      contentLength = _sendFileContent(file);
+      _metricsSent(start, contentLength);
     }
     return contentLength;
   }
@@ -243,8 +310,11 @@ public:
   size_t stream(T &aStream, const String& contentType, HTTPMethod requestMethod, ssize_t size) {
     setContentLength(size);
     send(200, contentType, emptyString);
-    if (requestMethod == HTTP_GET)
+    if (requestMethod == HTTP_GET) {
+        unsigned long start = micros();
         size = aStream.sendSize(_currentClient, size);
+        _metricsSent(start, size);
+    }
     return size;
   }
 
@@ -283,18 +353,56 @@ public:
 protected:
   void _addRequestHandler(RequestHandlerType* handler);
   void _handleRequest();
+  bool _handleConnection(bool contended);
+  RequestHandlerType* _findHandler();
   void _finalizeResponse();
   ClientFuture _parseRequest(ClientType& client);
+  bool _parseHead(ClientType& client);
+  void _parseHeadAppend(const char* data, size_t len);
+  void _parseHeadLine(ClientType& client);
+  void _parseRequestLine(ClientType& client, char* line, size_t len);
+  void _parseHeaderLine(char* line, size_t len);
+  bool _isHeaderWanted(const char* name, size_t len) const;
+  void _resetHead();
   void _parseArguments(const String& data);
   int _parseArgumentsPrivate(const String& data, std::function<void(String&,String&,const String&,int,int,int,int)> handler);
   bool _parseForm(ClientType& client, const String& boundary, uint32_t len);
   bool _parseFormUploadAborted();
-  void _uploadWriteByte(uint8_t b);
-  int _uploadReadByte(ClientType& client);
-  void _prepareHeader(String& response, int code, const char* content_type, size_t contentLength);
+  bool _uploadStream(ClientType& client, const String& boundary);
+  void _prepareHeader(HeaderWriter& header, int code, const char* content_type, size_t contentLength);
+  static const __FlashStringHelper* _responseCodeText(const int code);
   bool _collectHeader(const char* headerName, const char* headerValue);
 
   void _streamFileCore(const size_t fileSize, const String & fileName, const String & contentType);
+  void _recordMetrics(uint32_t parseTime, uint32_t handleTime);
+  // account for bytes written to the client since start (micros())
+  void _metricsSent(unsigned long start, size_t bytes) {
+    if (_metrics) {
+      _sendMicros += micros() - start;
+      _sentBytes += bytes;
+    }
+  }
+
+  // Without a peek buffer API, Stream::send*() moves data through a small
+  // stack buffer, one TCP write every few dozen bytes: files are rather
+  // read in segment sized chunks, each one given to the TCP stack at once
+  template<typename T>
+  size_t _sendFileContent(T& file) {
+    if (file.hasPeekBufferAPI())
+      return file.sendAll(_currentClient);
+    std::unique_ptr<uint8_t[]> chunk(new (std::nothrow) uint8_t[HTTP_DOWNLOAD_UNIT_SIZE]);
+    if (!chunk)
+      return file.sendAll(_currentClient);
+    size_t sent = 0;
+    int r;
+    while ((r = file.read(chunk.get(), HTTP_DOWNLOAD_UNIT_SIZE)) > 0) {
+      size_t w = _currentClient.write(chunk.get(), r);
+      sent += w;
+      if (w != (size_t)r)
+        break;
+    }
+    return sent;
+  }
 
   static String _getRandomHexString();
   // for extracting Auth parameters
@@ -305,6 +413,43 @@ protected:
     String value;
   };
 
+  enum HeadState { HEAD_REQUEST_LINE, HEAD_HEADERS, HEAD_SKIP_LINE, HEAD_DONE };
+
+  // request line and headers, parsed as they arrive by _parseHead()
+  struct RequestHead {
+    HeadState    state = HEAD_REQUEST_LINE;
+    ClientFuture future = CLIENT_REQUEST_CAN_CONTINUE;
+    bool         spilled = false; // current line did not fit in buf and is in spill
+    bool         isForm = false;
+    bool         isEncoded = false;
+    uint16_t     len = 0;         // bytes of the current line in buf
+    uint32_t     contentLength = 0;
+    uint16_t     served = 0;      // requests on this connection, not reset between requests
+    String       search;
+    String       boundary;
+    String       spill;
+    char         buf[HTTP_REQUEST_LINE_LEN];
+    // request parsed so far, in the server's _current* & co while this
+    // connection is served (see _swapRequest())
+    HTTPMethod   method = HTTP_ANY;
+    uint8_t      version = 0;
+    bool         keepAlive = false;
+    String       uri;
+    String       host;
+    String       webSocketKey;
+    std::vector<String> headerValues;
+  };
+
+  // one per client being served, swapped in _currentClient & co by handleClient()
+  struct Connection {
+    ClientType       client;
+    HTTPClientStatus status = HC_NONE;
+    unsigned long    statusChange = 0;
+    RequestHead      head;
+  };
+
+  void _swapRequest(RequestHead& head);
+
   ServerType  _server;
   ClientType  _currentClient;
   HTTPMethod  _currentMethod = HTTP_ANY;
@@ -312,10 +457,17 @@ protected:
   uint8_t     _currentVersion = 0;
   HTTPClientStatus _currentStatus = HC_NONE;
   unsigned long _statusChange = 0;
+  RequestHead*  _head = nullptr;
+  std::unique_ptr<Connection[]> _connections;
+  uint8_t       _maxClients = HTTP_MAX_CLIENTS;
 
   RequestHandlerType*  _currentHandler = nullptr;
   RequestHandlerType*  _firstHandler = nullptr;
   RequestHandlerType*  _lastHandler = nullptr;
+  std::unique_ptr<RouteTable<ServerType>> _routes;
+  bool                 _routesCompiled = false;
+  std::vector<WebSocketHandlerType*> _webSockets; // owned by the handler list
+  std::vector<EventSourceHandlerType*> _eventSources;
   THandlerFunction _notFoundHandler;
   THandlerFunction _fileUploadHandler;
 
@@ -333,9 +485,18 @@ protected:
   String           _responseHeaders;
 
   String           _hostHeader;
+  String           _webSocketKey;
+  bool             _clientGiven = false;
   bool             _chunked = false;
   bool             _corsEnabled = false;
   bool             _keepAlive = false;
+  bool             _contended = false;
+  uint16_t         _keepAliveMaxRequests = HTTP_MAX_KEEPALIVE_REQUESTS;
+  unsigned long    _keepAliveTimeout = HTTP_MAX_CLOSE_WAIT;
+
+  std::unique_ptr<RequestMetrics<ServerType>> _metrics;
+  uint32_t         _sendMicros = 0; // of the current request
+  size_t           _sentBytes = 0;
 
   String           _snonce;  // Store noance and opaque for future comparison
   String           _sopaque;
@@ -24,6 +24,7 @@
 #include "WiFiClient.h"
 #include "ESP8266WebServer.h"
 #include "detail/mimetable.h"
+#include <PgmHash.h>
 
 #ifndef WEBSERVER_MAX_POST_ARGS
 #define WEBSERVER_MAX_POST_ARGS 32
@@ -32,6 +33,13 @@
 static const char Content_Type[] PROGMEM = "Content-Type";
 static const char filename[] PROGMEM = "filename";
 
+// in the order of HTTPMethod, from HTTP_GET
+static constexpr auto requestMethods PROGMEM = makePgmKeywords(false, "GET", "HEAD", "POST", "PUT", "PATCH", "DELETE", "OPTIONS");
+
+// the request headers the server itself looks at
+enum { HEADER_CONTENT_TYPE, HEADER_CONTENT_LENGTH, HEADER_HOST, HEADER_WEBSOCKET_KEY, HEADER_CONNECTION };
+static constexpr auto requestHeaders PROGMEM = makePgmKeywords(true, "Content-Type", "Content-Length", "Host", "Sec-WebSocket-Key", "Connection");
+
 namespace esp8266webserver {
 
 template <typename ServerType>
@@ -42,123 +50,236 @@ static bool readBytesWithTimeout(typename ServerType::ClientType& client, size_t
 }
 
 template <typename ServerType>
-typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemplate<ServerType>::_parseRequest(ClientType& client) {
-  // Read the first line of HTTP request
-  String req = client.readStringUntil('\r');
-  DBGWS("request: %s\n", req.c_str());
-  client.readStringUntil('\n');
+bool ESP8266WebServerTemplate<ServerType>::_parseHead(ClientType& client) {
+  // consume what has arrived without waiting for more, one line at a time,
+  // handleClient() calls again when more data is available
+  while (_head->state != HEAD_DONE) {
+    bool peek = client.hasPeekBufferAPI();
+    const char* data;
+    size_t avail;
+    char c;
+    if (peek) {
+      avail = client.peekAvailable();
+      data = client.peekBuffer();
+    } else {
+      int r = client.available() ? client.read() : -1;
+      avail = r < 0 ? 0 : 1;
+      c = r;
+      data = &c;
+    }
+    if (!avail)
+      return false;
+
+    const char* eol = (const char*)memchr(data, '\n', avail);
+    size_t taken = eol ? eol - data + 1 : avail;
+    _parseHeadAppend(data, eol ? taken - 1 : taken);
+    // the line is consumed before being parsed: a hook may take the client over
+    if (peek)
+      client.peekConsume(taken);
+    if (eol)
+      _parseHeadLine(client);
+  }
+  return true;
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::_parseHeadAppend(const char* data, size_t len) {
+  if (_head->state == HEAD_SKIP_LINE || !len)
+    return;
+  if (!_head->spilled) {
+    if (_head->len + len < sizeof(_head->buf)) {
+      memcpy(_head->buf + _head->len, data, len);
+      _head->len += len;
+      return;
+    }
+    // too long for buf: skip headers nobody reads, move anything else to a String
+    if (_head->state == HEAD_HEADERS) {
+      const char* div = (const char*)memchr(_head->buf, ':', _head->len);
+      if (!div || !_isHeaderWanted(_head->buf, div - _head->buf)) {
+        DBGWS("skipping long header line\n");
+        _head->state = HEAD_SKIP_LINE;
+        return;
+      }
+    }
+    _head->spill.clear();
+    _head->spill.concat(_head->buf, _head->len);
+    _head->spilled = true;
+  }
+  _head->spill.concat(data, len);
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::_parseHeadLine(ClientType& client) {
+  if (_head->state == HEAD_SKIP_LINE) {
+    _head->state = HEAD_HEADERS;
+    _head->len = 0;
+    return;
+  }
+
+  char* line = _head->spilled ? _head->spill.begin() : _head->buf;
+  size_t len = _head->spilled ? _head->spill.length() : _head->len;
+  if (len && line[len - 1] == '\r')
+    len--;
+  line[len] = 0;
+
+  if (_head->state == HEAD_REQUEST_LINE)
+    _parseRequestLine(client, line, len);
+  else
+    _parseHeaderLine(line, len);
+  _head->len = 0;
+  _head->spilled = false;
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::_parseRequestLine(ClientType& client, char* line, size_t len) {
+  if (!len)
+    return; // empty lines before a request are ignored
+  DBGWS("request: %s\n", line);
+
   //reset header value
   for (int i = 0; i < _headerKeysCount; ++i) {
     _currentHeaders[i].value.clear();
-   }
+  }
+  _hostHeader.clear();
+  _webSocketKey.clear();
 
   // First line of HTTP request looks like "GET /path HTTP/1.1"
   // Retrieve the "/path" part by finding the spaces
-  int addr_start = req.indexOf(' ');
-  int addr_end = req.indexOf(' ', addr_start + 1);
-  if (addr_start == -1 || addr_end == -1) {
+  char* addr_start = strchr(line, ' ');
+  char* addr_end = addr_start ? strchr(addr_start + 1, ' ') : nullptr;
+  if (!addr_end) {
     DBGWS("Invalid request\n");
-    return CLIENT_MUST_STOP;
+    _head->future = CLIENT_MUST_STOP;
+    _head->state = HEAD_DONE;
+    return;
   }
-
-  String methodStr = req.substring(0, addr_start);
-  String url = req.substring(addr_start + 1, addr_end);
-  String versionEnd = req.substring(addr_end + 8);
-  _currentVersion = atoi(versionEnd.c_str());
-  String searchStr;
-  int hasSearch = url.indexOf('?');
-  if (hasSearch != -1){
-    searchStr = url.substring(hasSearch + 1);
-    url = url.substring(0, hasSearch);
+  *addr_start = 0;
+  *addr_end = 0;
+
+  _currentVersion = (size_t)(addr_end + 8 - line) <= len ? atoi(addr_end + 8) : 0;
+  char* search = strchr(addr_start + 1, '?');
+  if (search) {
+    *search = 0;
+    _head->search = search + 1;
   }
-  _currentUri = url;
+  _currentUri = addr_start + 1;
   _chunked = false;
 
   if (_hook)
   {
-    auto whatNow = _hook(methodStr, url, &client, mime::getContentType);
-    if (whatNow != CLIENT_REQUEST_CAN_CONTINUE)
-        return whatNow;
+    auto whatNow = _hook(String(line), _currentUri, &client, mime::getContentType);
+    if (whatNow != CLIENT_REQUEST_CAN_CONTINUE) {
+      _head->future = whatNow;
+      _head->state = HEAD_DONE;
+      return;
+    }
   }
 
-  HTTPMethod method = HTTP_GET;
-  if (methodStr == F("HEAD")) {
-    method = HTTP_HEAD;
-  } else if (methodStr == F("POST")) {
-    method = HTTP_POST;
-  } else if (methodStr == F("DELETE")) {
-    method = HTTP_DELETE;
-  } else if (methodStr == F("OPTIONS")) {
-    method = HTTP_OPTIONS;
-  } else if (methodStr == F("PUT")) {
-    method = HTTP_PUT;
-  } else if (methodStr == F("PATCH")) {
-    method = HTTP_PATCH;
-  }
-  _currentMethod = method;
+  // unknown methods are taken as GET
+  int method = requestMethods.find(line, addr_start - line);
+  _currentMethod = method < 0 ? HTTP_GET : (HTTPMethod)(HTTP_GET + method);
 
   _keepAlive = _currentVersion > 0; // Keep the connection alive by default
                                     // if the protocol version is greater than HTTP 1.0
 
   DBGWS("method: %s url: %s search: %s keepAlive=: %d\n",
-      methodStr.c_str(), url.c_str(), searchStr.c_str(), _keepAlive);
+      line, _currentUri.c_str(), _head->search.c_str(), _keepAlive);
 
-  //attach handler
-  RequestHandlerType* handler;
-  for (handler = _firstHandler; handler; handler = handler->next()) {
-    if (handler->canHandle(_currentMethod, _currentUri))
-      break;
-  }
-  _currentHandler = handler;
+  _head->state = HEAD_HEADERS;
+}
 
-  String formData;
-  // below is needed only when POST type request
-  if (method == HTTP_POST || method == HTTP_PUT || method == HTTP_PATCH || method == HTTP_DELETE){
-    String boundaryStr;
-    String headerName;
-    String headerValue;
-    bool isForm = false;
-    bool isEncoded = false;
-    uint32_t contentLength = 0;
-    //parse headers
-    while(1){
-      req = client.readStringUntil('\r');
-      client.readStringUntil('\n');
-      if (req.isEmpty()) break; //no more headers
-      int headerDiv = req.indexOf(':');
-      if (headerDiv == -1){
-        break;
-      }
-      headerName = req.substring(0, headerDiv);
-      headerValue = req.substring(headerDiv + 1);
-      headerValue.trim();
-       _collectHeader(headerName.c_str(),headerValue.c_str());
-
-      DBGWS("headerName: %s\nheaderValue: %s\n", headerName.c_str(), headerValue.c_str());
-
-      if (headerName.equalsIgnoreCase(FPSTR(Content_Type))){
-        using namespace mime;
-        if (headerValue.startsWith(FPSTR(mimeTable[txt].mimeType))){
-          isForm = false;
-        } else if (headerValue.startsWith(F("application/x-www-form-urlencoded"))){
-          isForm = false;
-          isEncoded = true;
-        } else if (headerValue.startsWith(F("multipart/"))){
-          boundaryStr = headerValue.substring(headerValue.indexOf('=') + 1);
-          boundaryStr.replace("\"","");
-          isForm = true;
-        }
-      } else if (headerName.equalsIgnoreCase(F("Content-Length"))){
-        contentLength = headerValue.toInt();
-      } else if (headerName.equalsIgnoreCase(F("Host"))){
-        _hostHeader = headerValue;
-      } else if (headerName.equalsIgnoreCase(F("Connection"))){
-        _keepAlive = headerValue.equalsIgnoreCase(F("keep-alive"));
-      }
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::_parseHeaderLine(char* line, size_t len) {
+  char* div = len ? strchr(line, ':') : nullptr;
+  if (!div) {
+    // no more headers
+    _head->state = HEAD_DONE;
+    return;
+  }
+  *div = 0;
+  char* value = div + 1;
+  while (*value == ' ' || *value == '\t')
+    value++;
+  for (char* end = line + len; end > value && (end[-1] == ' ' || end[-1] == '\t'); )
+    *--end = 0;
+
+  _collectHeader(line, value);
+
+  DBGWS("headerName: %s\nheaderValue: %s\n", line, value);
+
+  switch (requestHeaders.find(line, div - line)) {
+  case HEADER_CONTENT_TYPE: {
+    using namespace mime;
+    if (!strncmp_P(value, mimeTable[txt].mimeType, strlen_P(mimeTable[txt].mimeType))) {
+      _head->isForm = false;
+    } else if (!strncmp_P(value, PSTR("application/x-www-form-urlencoded"), 33)) {
+      _head->isForm = false;
+      _head->isEncoded = true;
+    } else if (!strncmp_P(value, PSTR("multipart/"), 10)) {
+      const char* eq = strchr(value, '=');
+      _head->boundary = eq ? eq + 1 : value;
+      _head->boundary.replace("\"", "");
+      _head->isForm = true;
     }
+    break;
+  }
+  case HEADER_CONTENT_LENGTH:
+    _head->contentLength = strtoul(value, nullptr, 10);
+    break;
+  case HEADER_HOST:
+    _hostHeader = value;
+    break;
+  case HEADER_WEBSOCKET_KEY:
+    _webSocketKey = value;
+    break;
+  case HEADER_CONNECTION:
+    _keepAlive = !strcasecmp_P(value, PSTR("keep-alive"));
+    break;
+  }
+}
+
+template <typename ServerType>
+bool ESP8266WebServerTemplate<ServerType>::_isHeaderWanted(const char* name, size_t len) const {
+  int header = requestHeaders.find(name, len);
+  if (header == HEADER_CONTENT_TYPE || header == HEADER_HOST)
+    return true;
+  for (int i = 0; i < _headerKeysCount; i++) {
+    if (_currentHeaders[i].key.length() == len && !strncasecmp(_currentHeaders[i].key.c_str(), name, len))
+      return true;
+  }
+  return false;
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::_resetHead() {
+  _head->state = HEAD_REQUEST_LINE;
+  _head->future = CLIENT_REQUEST_CAN_CONTINUE;
+  _head->spilled = false;
+  _head->isForm = false;
+  _head->isEncoded = false;
+  _head->len = 0;
+  _head->contentLength = 0;
+  // cleared, not released: their buffers are reused by the next request
+  _head->search.clear();
+  _head->boundary.clear();
+  _head->spill.clear();
+}
 
+template <typename ServerType>
+typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemplate<ServerType>::_parseRequest(ClientType& client) {
+  // request line and headers are already parsed by _parseHead()
+  if (_head->future != CLIENT_REQUEST_CAN_CONTINUE)
+    return _head->future;
+
+  //attach handler
+  _currentHandler = _findHandler();
+
+  String& searchStr = _head->search;
+  // below is needed only when POST type request
+  if (_currentMethod == HTTP_POST || _currentMethod == HTTP_PUT || _currentMethod == HTTP_PATCH || _currentMethod == HTTP_DELETE){
+    uint32_t contentLength = _head->contentLength;
     String plainBuf;
-    if (   !isForm
+    if (   !_head->isForm
         && // read content into plainBuf
            (   !readBytesWithTimeout<ServerType>(client, contentLength, plainBuf, HTTP_MAX_POST_WAIT)
             || (plainBuf.length() < contentLength)
@@ -168,7 +289,7 @@ typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemp
         return CLIENT_MUST_STOP;
     }
 
-    if (isEncoded) {
+    if (_head->isEncoded) {
         // isEncoded => !isForm => plainBuf is not empty
         // add plainBuf in search str
         if (searchStr.length())
@@ -179,7 +300,7 @@ typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemp
     // parse searchStr for key/value pairs
     _parseArguments(searchStr);
 
-    if (!isForm) {
+    if (!_head->isForm) {
       if (contentLength) {
         // add key=value: plain={body} (post json or other data)
         RequestArgument& arg = _currentArgs[_currentArgCount];
@@ -189,41 +310,18 @@ typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemp
       }
     } else { // isForm is true
       // here: content is not yet read (plainBuf is still empty)
-      if (!_parseForm(client, boundaryStr, contentLength)) {
+      if (!_parseForm(client, _head->boundary, contentLength)) {
         return CLIENT_MUST_STOP;
       }
     }
   } else {
-    String headerName;
-    String headerValue;
-    //parse headers
-    while(1){
-      req = client.readStringUntil('\r');
-      client.readStringUntil('\n');
-      if (req.isEmpty()) break;//no moar headers
-      int headerDiv = req.indexOf(':');
-      if (headerDiv == -1){
-        break;
-      }
-      headerName = req.substring(0, headerDiv);
-      headerValue = req.substring(headerDiv + 2);
-      _collectHeader(headerName.c_str(),headerValue.c_str());
-
-      DBGWS("headerName: %s\nheaderValue: %s\n", headerName.c_str(), headerValue.c_str());
-
-      if (headerName.equalsIgnoreCase(F("Host"))){
-        _hostHeader = headerValue;
-      } else if (headerName.equalsIgnoreCase(F("Connection"))){
-        _keepAlive = headerValue.equalsIgnoreCase(F("keep-alive"));
-      }
-    }
     _parseArguments(searchStr);
   }
   client.flush();
 
 #ifdef DEBUG_ESP_HTTP_SERVER
   DBGWS("Request: %s\nArguments: %s\nfinal list of key/value pairs:\n",
-    url.c_str(), searchStr.c_str());
+    _currentUri.c_str(), searchStr.c_str());
   for (int i = 0; i < _currentArgCount; i++)
     DBGWS("  key:'%s' value:'%s'\r\n",
       _currentArgs[i].key.c_str(),
@@ -322,28 +420,82 @@ int ESP8266WebServerTemplate<ServerType>::_parseArgumentsPrivate(const String& d
 }
 
 template <typename ServerType>
-void ESP8266WebServerTemplate<ServerType>::_uploadWriteByte(uint8_t b){
-  if (_currentUpload->currentSize == HTTP_UPLOAD_BUFLEN){
-    if(_currentHandler && _currentHandler->canUpload(_currentUri))
-      _currentHandler->upload(*this, _currentUri, *_currentUpload);
-    _currentUpload->totalSize += _currentUpload->currentSize;
-    _currentUpload->currentSize = 0;
-  }
-  _currentUpload->buf[_currentUpload->currentSize++] = b;
-}
-
-template <typename ServerType>
-int ESP8266WebServerTemplate<ServerType>::_uploadReadByte(ClientType& client){
-  int res = client.read();
-  if(res == -1){
-    while(!client.available() && client.connected())
+bool ESP8266WebServerTemplate<ServerType>::_uploadStream(ClientType& client, const String& boundary){
+  // File content ends with "\r\n--boundary". Blocks are gathered in the upload
+  // buffer and searched for '\r' with memchr(), then the rest with memcmp().
+  // With a peek buffer, only what precedes the boundary end is consumed.
+  const size_t delimiterLen = 4 /* \r\n-- */ + boundary.length();
+  char delimiter[delimiterLen + 1];
+  snprintf(delimiter, delimiterLen + 1, "\r\n--%s", boundary.c_str());
+
+  HTTPUpload& upload = *_currentUpload;
+  size_t scanned = 0; // no boundary starts before
+  while (true) {
+    if (!client.available()) {
+      if (!client.connected())
+        return false;
       yield();
-    res = client.read();
+      continue;
+    }
+
+    bool peek = client.hasPeekBufferAPI();
+    size_t before = upload.currentSize;
+    size_t got;
+    if (peek) {
+      got = std::min(HTTP_UPLOAD_BUFLEN - before, client.peekAvailable());
+      if (!got) {
+        yield();
+        continue;
+      }
+      memcpy(upload.buf + before, client.peekBuffer(), got);
+    } else {
+      int c = client.read();
+      if (c < 0)
+        continue;
+      upload.buf[before] = c;
+      got = 1;
+    }
+    upload.currentSize += got;
+
+    const uint8_t* end = upload.buf + upload.currentSize;
+    const uint8_t* found = nullptr;
+    const uint8_t* partial = nullptr; // boundary start, to be confirmed by next bytes
+    for (const uint8_t* p = upload.buf + scanned; !partial && (p = (const uint8_t*)memchr(p, '\r', end - p)); p++) {
+      size_t left = end - p;
+      if (left >= delimiterLen) {
+        if (!memcmp(p, delimiter, delimiterLen)) {
+          found = p;
+          break;
+        }
+      } else if (!memcmp(p, delimiter, left)) {
+        partial = p;
+      }
+    }
+
+    if (found) {
+      if (peek)
+        client.peekConsume(found + delimiterLen - upload.buf - before);
+      upload.currentSize = found - upload.buf;
+      return true;
+    }
+    if (peek)
+      client.peekConsume(got);
+    scanned = (partial ? partial : end) - upload.buf;
+
+    if (upload.currentSize == HTTP_UPLOAD_BUFLEN) {
+      // hand the full buffer over, but a boundary start
+      size_t hold = partial ? end - partial : 0;
+      upload.currentSize -= hold;
+      if(_currentHandler && _currentHandler->canUpload(_currentUri))
+        _currentHandler->upload(*this, _currentUri, upload);
+      upload.totalSize += upload.currentSize;
+      memmove(upload.buf, upload.buf + upload.currentSize, hold);
+      upload.currentSize = hold;
+      scanned = 0;
+    }
   }
-  return res;
 }
 
-
 template <typename ServerType>
 bool ESP8266WebServerTemplate<ServerType>::_parseForm(ClientType& client, const String& boundary, uint32_t len){
   (void) len;
@@ -430,38 +582,8 @@ bool ESP8266WebServerTemplate<ServerType>::_parseForm(ClientType& client, const
               _currentHandler->upload(*this, _currentUri, *_currentUpload);
             _currentUpload->status = UPLOAD_FILE_WRITE;
 
-            int fastBoundaryLen = 4 /* \r\n-- */ + boundary.length() + 1 /* \0 */;
-            char fastBoundary[ fastBoundaryLen ];
-            snprintf(fastBoundary, fastBoundaryLen, "\r\n--%s", boundary.c_str());
-            int boundaryPtr = 0;
-            while ( true ) {
-                int ret = _uploadReadByte(client);
-                if (ret < 0) {
-                    // Unexpected, we should have had data available per above
-                    return _parseFormUploadAborted();
-                }
-                char in = (char) ret;
-                if (in == fastBoundary[ boundaryPtr ]) {
-                    // The input matched the current expected character, advance and possibly exit this file
-                    boundaryPtr++;
-                    if (boundaryPtr == fastBoundaryLen - 1) {
-                        // We read the whole boundary line, we're done here!
-                        break;
-                    }
-                } else {
-                    // The char doesn't match what we want, so dump whatever matches we had, the read in char, and reset ptr to start
-                    for (int i = 0; i < boundaryPtr; i++) {
-                        _uploadWriteByte( fastBoundary[ i ] );
-                    }
-                    if (in == fastBoundary[ 0 ]) {
-                       // This could be the start of the real end, mark it so and don't emit/skip it
-                       boundaryPtr = 1;
-                    } else {
-                      // Not the 1st char of our pattern, so emit and ignore
-                      _uploadWriteByte( in );
-                      boundaryPtr = 0;
-                    }
-                }
+            if (!_uploadStream(client, boundary)) {
+                return _parseFormUploadAborted();
             }
             // Found the boundary string, finish processing this file upload
             if (_currentHandler && _currentHandler->canUpload(_currentUri))
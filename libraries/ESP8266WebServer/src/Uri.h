@@ -15,13 +15,45 @@ class Uri {
         Uri(const __FlashStringHelper *uri) : _uri(String(uri)) {} 
         virtual ~Uri() {}
 
-        virtual Uri* clone() const {
-            return new Uri(_uri);
-        };
+        virtual Uri* clone() const;
 
         virtual bool canHandle(const String &requestUri, __attribute__((unused)) std::vector<String> &pathArgs) {
             return _uri == requestUri;
         }
+
+        // Pattern indexed by the server route table (see compileRoutes()), with
+        // braces=true when '{}' path segments stand for any segment.  Only the
+        // subclasses knowing they match that way return true, the others are
+        // asked canHandle() for every request.
+        virtual bool routePattern(__attribute__((unused)) String &pattern, __attribute__((unused)) bool &braces) const {
+            return false;
+        }
+};
+
+// What plain uri strings become once given to the server: exact match,
+// indexed by the route table.
+class UriExact : public Uri {
+
+    public:
+        explicit UriExact(const String &uri) : Uri(uri) {}
+
+        Uri* clone() const override final {
+            return new UriExact(_uri);
+        };
+
+        bool routePattern(String &pattern, bool &braces) const override final {
+            pattern = _uri;
+            braces = false;
+            return true;
+        }
+
+        bool canHandle(const String &requestUri, std::vector<String> &pathArgs) override final {
+            return Uri::canHandle(requestUri, pathArgs);
+        }
 };
 
+inline Uri* Uri::clone() const {
+    return new UriExact(_uri);
+}
+
 #endif
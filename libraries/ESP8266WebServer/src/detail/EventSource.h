@@ -0,0 +1,228 @@
+#ifndef EVENTSOURCE_H
+#define EVENTSOURCE_H
+
+#include <memory>
+#include <vector>
+#include "RequestHandler.h"
+
+#ifndef EVENTSOURCE_MAX_CLIENTS
+#define EVENTSOURCE_MAX_CLIENTS 4 // per event source
+#endif
+
+#ifndef EVENTSOURCE_MAX_STALL
+#define EVENTSOURCE_MAX_STALL 10000 // ms a subscriber may not accept any event before being dropped
+#endif
+
+#ifndef EVENTSOURCE_KEEPALIVE
+#define EVENTSOURCE_KEEPALIVE 15000 // ms of silence before a comment line is sent
+#endif
+
+namespace esp8266webserver {
+
+// A server-sent event formatted once, chunk framing included: every
+// subscriber is written the same bytes.
+class EventSourceMessage {
+public:
+    EventSourceMessage(const char* data, const char* event = nullptr, uint32_t id = 0) {
+        String body;
+        if (event) {
+            body += F("event: ");
+            body += event;
+            body += '\n';
+        }
+        if (id) {
+            body += F("id: ");
+            body += id;
+            body += '\n';
+        }
+        // one data field per line
+        for (const char* line = data; ; ) {
+            const char* eol = strchr(line, '\n');
+            size_t len = eol ? (size_t)(eol - line) : strlen(line);
+            body += F("data: ");
+            body.concat(line, len);
+            body += '\n';
+            if (!eol)
+                break;
+            line = eol + 1;
+        }
+        body += '\n';
+        _chunk(body);
+    }
+
+    // a comment line, ignored by browsers
+    static EventSourceMessage comment(const char* text) {
+        EventSourceMessage message;
+        String body = F(":");
+        body += text;
+        body += F("\n\n");
+        message._chunk(body);
+        return message;
+    }
+
+    const char* data() const { return _frame.c_str(); }
+    size_t length() const { return _frame.length(); }
+
+protected:
+    EventSourceMessage() = default;
+
+    void _chunk(const String& body) {
+        char size[12];
+        int sizeLen = snprintf(size, sizeof(size), "%x\r\n", body.length());
+        _frame.reserve(sizeLen + body.length() + 2);
+        _frame.concat(size, sizeLen);
+        _frame += body;
+        _frame += F("\r\n");
+    }
+
+    String _frame;
+};
+
+// Streams text/event-stream responses to subscribers on a uri, on top of the
+// chunked response mode. Writes never wait: each subscriber is written what
+// its send buffer can take, the rest follows from handleClient(). While an
+// event is being written, only the most recent of the events sent meanwhile
+// is kept for that subscriber, the others are dropped. A subscriber which
+// takes nothing for EVENTSOURCE_MAX_STALL ms is disconnected.
+// See ESP8266WebServerTemplate::onEventSource().
+template<typename ServerType>
+class EventSourceHandler : public RequestHandler<ServerType> {
+    using WebServerType = ESP8266WebServerTemplate<ServerType>;
+    using ClientType = typename ServerType::ClientType;
+    using MessagePtr = std::shared_ptr<const EventSourceMessage>;
+public:
+    EventSourceHandler(const String& uri): _uri(uri) { }
+
+    bool canHandle(HTTPMethod method, const String& uri) override {
+        return method == HTTP_GET && uri == _uri;
+    }
+
+    bool routeKey(HTTPMethod& method, String& pattern, bool& braces) const override {
+        method = HTTP_GET;
+        pattern = _uri;
+        braces = false;
+        return true;
+    }
+
+    bool handle(WebServerType& server, HTTPMethod requestMethod, const String& requestUri) override {
+        if (!canHandle(requestMethod, requestUri))
+            return false;
+        if (_subscribers.size() >= EVENTSOURCE_MAX_CLIENTS) {
+            server.send(503, F("text/plain"), F("Too many subscribers"));
+            return true;
+        }
+        server.sendHeader(F("Cache-Control"), F("no-cache"));
+        if (!server.chunkedResponseModeStart_P(200, PSTR("text/event-stream"))) {
+            server.send(505, F("text/plain"), F("HTTP/1.1 required"));
+            return true;
+        }
+        _subscribers.emplace_back();
+        Subscriber& subscriber = _subscribers.back();
+        subscriber.client = server.client();
+        subscriber.lastWrite = millis();
+        server.detachClient();
+        return true;
+    }
+
+    // returns the number of subscribers the event was entirely written to
+    size_t send(const char* data, const char* event = nullptr, uint32_t id = 0) {
+        if (_subscribers.empty())
+            return 0;
+        MessagePtr message = std::make_shared<const EventSourceMessage>(data, event, id);
+        size_t sent = 0;
+        for (Subscriber& subscriber : _subscribers) {
+            if (!subscriber.current) {
+                subscriber.current = message;
+                subscriber.progress = millis();
+            } else {
+                if (subscriber.next)
+                    _dropped++;
+                subscriber.next = message;
+            }
+            _flush(subscriber);
+            sent += subscriber.current != message && subscriber.next != message;
+        }
+        return sent;
+    }
+
+    size_t send(const String& data, const String& event = emptyString, uint32_t id = 0) {
+        return send(data.c_str(), event.length() ? event.c_str() : nullptr, id);
+    }
+
+    // continue writes, send heartbeats, drop gone or stalled subscribers;
+    // called by handleClient()
+    void loop() {
+        for (size_t i = 0; i < _subscribers.size(); ) {
+            Subscriber& subscriber = _subscribers[i];
+            // the request is answered, anything else the client sends is ignored
+            while (subscriber.client.available() && subscriber.client.read() >= 0)
+                ;
+            if (!subscriber.current && millis() - subscriber.lastWrite > EVENTSOURCE_KEEPALIVE) {
+                subscriber.current = _heartbeat();
+                subscriber.progress = millis();
+            }
+            _flush(subscriber);
+            if (   !subscriber.client.connected()
+                || (subscriber.current && millis() - subscriber.progress > EVENTSOURCE_MAX_STALL)) {
+                subscriber.client.stop();
+                _subscribers.erase(_subscribers.begin() + i);
+                continue;
+            }
+            i++;
+        }
+    }
+
+    size_t count() const { return _subscribers.size(); }
+    uint32_t dropped() const { return _dropped; } // events replaced by a newer one before being written
+
+    void closeAll() {
+        for (Subscriber& subscriber : _subscribers)
+            subscriber.client.stop();
+        _subscribers.clear();
+    }
+
+protected:
+    struct Subscriber {
+        ClientType client;
+        MessagePtr current;   // being written
+        size_t     offset = 0;
+        MessagePtr next;      // latest event sent meanwhile
+        unsigned long lastWrite = 0;
+        unsigned long progress = 0;  // current assigned or partly written
+    };
+
+    void _flush(Subscriber& subscriber) {
+        while (subscriber.current) {
+            size_t room = std::max(0, subscriber.client.availableForWrite());
+            size_t len = std::min(room, subscriber.current->length() - subscriber.offset);
+            if (!len)
+                return;
+            size_t written = subscriber.client.write(subscriber.current->data() + subscriber.offset, len);
+            if (!written)
+                return;
+            subscriber.lastWrite = millis();
+            subscriber.progress = subscriber.lastWrite;
+            subscriber.offset += written;
+            if (subscriber.offset == subscriber.current->length()) {
+                subscriber.current = std::move(subscriber.next);
+                subscriber.next.reset();
+                subscriber.offset = 0;
+            }
+        }
+    }
+
+    MessagePtr _heartbeat() {
+        if (!_keepAlive)
+            _keepAlive = std::make_shared<const EventSourceMessage>(EventSourceMessage::comment(""));
+        return _keepAlive;
+    }
+
+    String _uri;
+    std::vector<Subscriber> _subscribers;
+    MessagePtr _keepAlive;
+    uint32_t _dropped = 0;
+};
+
+} // namespace
+
+#endif //EVENTSOURCE_H
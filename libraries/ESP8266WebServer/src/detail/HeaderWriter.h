@@ -0,0 +1,150 @@
+#ifndef HEADERWRITER_H
+#define HEADERWRITER_H
+
+#include <Arduino.h>
+
+#ifndef HTTP_HEADER_BUFFER_SIZE
+#define HTTP_HEADER_BUFFER_SIZE 256 // on the stack of send()
+#endif
+
+namespace esp8266webserver {
+
+// names of the headers the server writes itself, see HeaderWriter::header()
+enum HeaderName : uint8_t {
+    HEADER_CONTENT_TYPE,
+    HEADER_CONTENT_LENGTH,
+    HEADER_ACCEPT_RANGES,
+    HEADER_TRANSFER_ENCODING,
+    HEADER_ACCESS_CONTROL_ALLOW_ORIGIN,
+    HEADER_CONNECTION,
+    HEADER_KEEP_ALIVE,
+    HEADER_COUNT
+};
+
+static const char HeaderNames[HEADER_COUNT][32] PROGMEM = {
+    "Content-Type: ",
+    "Content-Length: ",
+    "Accept-Ranges: ",
+    "Transfer-Encoding: ",
+    "Access-Control-Allow-Origin: ",
+    "Connection: ",
+    "Keep-Alive: ",
+};
+
+// Formats a response head in a fixed buffer, no String is built on the way.
+// A head that fits the buffer reaches the client with a single write, along
+// with the start of the body when one is given to write(). A longer one
+// (large sendHeader() values) is flushed each time the buffer fills up.
+class HeaderWriter {
+public:
+    HeaderWriter(Print& out): _out(out) { }
+
+    void statusLine(uint8_t version, int code, const __FlashStringHelper* reason) {
+        append_P(PSTR("HTTP/1."), 7);
+        append(version ? '1' : '0');
+        append(' ');
+        number(code);
+        append(' ');
+        append_P((PGM_P)reason, strlen_P((PGM_P)reason));
+        crlf();
+    }
+
+    void header(HeaderName name, PGM_P value) {
+        this->name(name);
+        append_P(value, strlen_P(value));
+        crlf();
+    }
+
+    void header(HeaderName name, size_t value) {
+        this->name(name);
+        number(value);
+        crlf();
+    }
+
+    // "Name: ", the value is to be appended
+    void name(HeaderName name) {
+        PGM_P s = HeaderNames[name];
+        append_P(s, strlen_P(s));
+    }
+
+    void append(char c) {
+        if (_len == sizeof(_buf))
+            flush();
+        _buf[_len++] = c;
+    }
+
+    void append(const char* data, size_t len) {
+        while (len) {
+            if (_len == sizeof(_buf))
+                flush();
+            if (!_len && len >= sizeof(_buf)) {
+                _sent += _out.write(data, len);
+                _total += len;
+                return;
+            }
+            size_t chunk = std::min(len, sizeof(_buf) - _len);
+            memcpy(_buf + _len, data, chunk);
+            _len += chunk;
+            data += chunk;
+            len -= chunk;
+        }
+    }
+
+    void append_P(PGM_P data, size_t len) {
+        while (len) {
+            if (_len == sizeof(_buf))
+                flush();
+            size_t chunk = std::min(len, sizeof(_buf) - _len);
+            memcpy_P(_buf + _len, data, chunk);
+            _len += chunk;
+            data += chunk;
+            len -= chunk;
+        }
+    }
+
+    void number(size_t value) {
+        char digits[20];
+        size_t n = 0;
+        do {
+            digits[sizeof(digits) - ++n] = '0' + value % 10;
+            value /= 10;
+        } while (value);
+        append(digits + sizeof(digits) - n, n);
+    }
+
+    void crlf() {
+        append('\r');
+        append('\n');
+    }
+
+    // send what is buffered
+    void flush() {
+        if (_len)
+            _sent += _out.write(_buf, _len);
+        _total += _len;
+        _len = 0;
+    }
+
+    // send what is buffered followed by body, with one write
+    void write(const char* body, size_t len) {
+        Print::iovec iov[2] = { { _buf, _len }, { body, len } };
+        _sent += _out.write(iov, len ? 2 : 1);
+        _total += _len + len;
+        _len = 0;
+    }
+
+    // bytes handed to write() / flush() and how many of them were accepted
+    size_t total() const { return _total; }
+    size_t sent() const { return _sent; }
+
+protected:
+    Print& _out;
+    size_t _len = 0;
+    size_t _total = 0;
+    size_t _sent = 0;
+    char   _buf[HTTP_HEADER_BUFFER_SIZE];
+};
+
+} // namespace
+
+#endif //HEADERWRITER_H
@@ -16,6 +16,8 @@ public:
     virtual bool canUpload(const String& uri) { (void) uri; return false; }
     virtual bool handle(WebServerType& server, HTTPMethod requestMethod, const String& requestUri) { (void) server; (void) requestMethod; (void) requestUri; return false; }
     virtual void upload(WebServerType& server, const String& requestUri, HTTPUpload& upload) { (void) server; (void) requestUri; (void) upload; }
+    // method and uri pattern for the route table, false when only canHandle() can tell
+    virtual bool routeKey(HTTPMethod& method, String& pattern, bool& braces) const { (void) method; (void) pattern; (void) braces; return false; }
 
     RequestHandler<ServerType>* next() { return _next; }
     void next(RequestHandler<ServerType>* r) { _next = r; }
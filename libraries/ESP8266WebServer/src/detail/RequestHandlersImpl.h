@@ -4,6 +4,7 @@
 #include <ESP8266WebServer.h>
 #include "RequestHandler.h"
 #include "mimetable.h"
+#include "StaticAssetCache.h"
 #include "WString.h"
 #include "Uri.h"
 
@@ -52,6 +53,11 @@ public:
         return _uri->canHandle(requestUri, RequestHandler<ServerType>::pathArgs);
     }
 
+    bool routeKey(HTTPMethod& method, String& pattern, bool& braces) const override {
+        method = _method;
+        return _uri->routePattern(pattern, braces);
+    }
+
     bool canUpload(const String& requestUri) override  {
         if (!_ufn || !canHandle(HTTP_POST, requestUri))
             return false;
@@ -105,10 +111,54 @@ public:
     }
 
 protected:
+    // Sends a resolved asset: 304 when the client has its ETag, the file otherwise.
+    // False when there is no such file.
+    bool _serve(WebServerType& server, HTTPMethod requestMethod, StaticAssetCache::Entry& asset) {
+        if (!asset.path.length())
+            return false;
+
+        File f = _fs.open(asset.path, "r");
+        if (!f || !f.isFile()) {
+            asset.path.clear();
+            return false;
+        }
+        if (f.size() != asset.size) {
+            // written while open, generation() did not change
+            asset.size = f.size();
+            asset.eTag.clear();
+        }
+
+        if (server._eTagEnabled) {
+            if (asset.eTag.isEmpty()) {
+                if (server._eTagFunction) {
+                    asset.eTag = (server._eTagFunction)(_fs, asset.path);
+                } else {
+                    asset.eTag = esp8266webserver::calcETag(_fs, asset.path);
+                }
+            }
+
+            if (server.header("If-None-Match") == asset.eTag) {
+                server.send(304);
+                return true;
+            }
+        }
+
+        if (_cache_header.length() != 0)
+            server.sendHeader("Cache-Control", _cache_header);
+
+        if ((server._eTagEnabled) && (asset.eTag.length() > 0)) {
+            server.sendHeader("ETag", asset.eTag);
+        }
+
+        server.streamFile(f, asset.contentType, requestMethod);
+        return true;
+    }
+
     FS _fs;
     String _uri;
     String _path;
     String _cache_header;
+    StaticAssetCache _cache;
 };
 
 
@@ -137,8 +187,18 @@ public:
 
         DEBUGV("DirectoryRequestHandler::handle: request=%s _uri=%s\r\n", requestUri.c_str(), SRH::_uri.c_str());
 
+        StaticAssetCache::Entry* asset = SRH::_cache.find(SRH::_fs, requestUri);
+        if (!asset) {
+            asset = &SRH::_cache.insert(requestUri);
+            _resolve(requestUri, *asset);
+        }
+        return SRH::_serve(server, requestMethod, *asset);
+    }
+
+protected:
+    // file probes for a request, done once per uri until the filesystem changes
+    void _resolve(const String& requestUri, StaticAssetCache::Entry& asset) {
         String path;
-        String eTagCode;
         path.reserve(SRH::_path.length() + requestUri.length() + 32);
         path = SRH::_path;
 
@@ -158,7 +218,7 @@ public:
 
         DEBUGV("DirectoryRequestHandler::handle: path=%s\r\n", path.c_str());
 
-        String contentType = mime::getContentType(path);
+        asset.contentType = mime::getContentType(path);
 
         using namespace mime;
         // look for gz file, only if the original specified path is not a gz.  So part only works to send gzip via content encoding when a non compressed is asked for
@@ -169,41 +229,9 @@ public:
                 path += FPSTR(mimeTable[gz].endsWith);
         }
 
-        File f = SRH::_fs.open(path, "r");
-        if (!f)
-            return false;
-
-        if (!f.isFile()) {
-            f.close();
-            return false;
-        }
-
-        if (server._eTagEnabled) {
-            if (server._eTagFunction) {
-                eTagCode = (server._eTagFunction)(SRH::_fs, path);
-            } else {
-                eTagCode = esp8266webserver::calcETag(SRH::_fs, path);
-            }
-
-            if (server.header("If-None-Match") == eTagCode) {
-                server.send(304);
-                return true;
-            }
-        }
-
-        if (SRH::_cache_header.length() != 0)
-            server.sendHeader("Cache-Control", SRH::_cache_header);
-
-        if ((server._eTagEnabled) && (eTagCode.length() > 0)) {
-            server.sendHeader("ETag", eTagCode);
-        }
-
-        server.streamFile(f, contentType, requestMethod);
-
-        return true;
+        asset.path = path;
     }
 
-protected:
     size_t _baseUriLength;
 };
 
@@ -232,42 +260,14 @@ public:
         if (!canHandle(requestMethod, requestUri))
             return false;
 
-        if (server._eTagEnabled) {
-            if (server._eTagFunction) {
-                _eTagCode = (server._eTagFunction)(SRH::_fs, SRH::_path);
-            } else  if (_eTagCode.isEmpty()) {
-                _eTagCode = esp8266webserver::calcETag(SRH::_fs, SRH::_path);
-            }
-
-            if (server.header("If-None-Match") == _eTagCode) {
-                server.send(304);
-                return true;
-            }
-        }
-
-        File f = SRH::_fs.open(SRH::_path, "r");
-
-        if (!f)
-            return false;
-
-        if (!f.isFile()) {
-            f.close();
-            return false;
-        }
-
-        if (SRH::_cache_header.length() != 0)
-            server.sendHeader("Cache-Control", SRH::_cache_header);
-
-        if ((server._eTagEnabled) && (_eTagCode.length() > 0)) {
-            server.sendHeader("ETag", _eTagCode);
+        StaticAssetCache::Entry* asset = SRH::_cache.find(SRH::_fs, requestUri);
+        if (!asset) {
+            asset = &SRH::_cache.insert(requestUri);
+            asset->path = SRH::_path;
+            asset->contentType = mime::getContentType(SRH::_path);
         }
-
-        server.streamFile(f, mime::getContentType(SRH::_path), requestMethod);
-        return true;
+        return SRH::_serve(server, requestMethod, *asset);
     }
-
-protected:
-    String _eTagCode; // ETag code calculated for this file as used in http header include quotes.
 };
 
 } // namespace
@@ -0,0 +1,233 @@
+#ifndef REQUESTMETRICS_H
+#define REQUESTMETRICS_H
+
+#include <vector>
+#include <StreamDev.h>
+#include "RequestHandler.h"
+#include "HeaderWriter.h"
+
+#ifndef HTTP_METRICS_BUCKETS
+#define HTTP_METRICS_BUCKETS 24 // power of two latency buckets from 1 us, the last one is open ended (> 8 s)
+#endif
+
+namespace esp8266webserver {
+
+enum MetricsPhase : uint8_t { METRICS_PARSE, METRICS_HANDLER, METRICS_SEND, METRICS_PHASES };
+
+// Latencies counted in power of two buckets of microseconds. Percentiles
+// are bucket upper bounds, so no more than twice the actual value.
+class LatencyHistogram {
+public:
+    void add(uint32_t us) {
+        uint8_t bucket = us ? 32 - __builtin_clz(us) : 0;
+        _counts[std::min(bucket, (uint8_t)(HTTP_METRICS_BUCKETS - 1))]++;
+        _count++;
+        _sum += us;
+    }
+
+    uint32_t count() const { return _count; }
+    uint64_t sum() const { return _sum; } // us
+
+    // us, percent in 1..100
+    uint32_t percentile(uint8_t percent) const {
+        if (!_count)
+            return 0;
+        uint32_t rank = ((uint64_t)_count * percent + 99) / 100;
+        uint32_t seen = 0;
+        for (uint8_t i = 0; i < HTTP_METRICS_BUCKETS; i++) {
+            seen += _counts[i];
+            if (seen >= rank)
+                return i ? (1u << i) - 1 : 0;
+        }
+        return (1u << (HTTP_METRICS_BUCKETS - 1)) - 1;
+    }
+
+protected:
+    uint32_t _counts[HTTP_METRICS_BUCKETS] = { };
+    uint32_t _count = 0;
+    uint64_t _sum = 0;
+};
+
+struct RouteMetrics {
+    uint32_t requests = 0;
+    uint64_t bytesSent = 0;
+    LatencyHistogram latency[METRICS_PHASES];
+};
+
+// Metrics of the request handlers of a server, see enableMetrics().
+// A handler gets its entry at its first request, requests no handler
+// accepted are counted apart.
+template<typename ServerType>
+class RequestMetrics {
+    using RequestHandlerType = RequestHandler<ServerType>;
+public:
+    RouteMetrics& of(RequestHandlerType* handler) {
+        if (!handler)
+            return _notFound;
+        for (Entry& entry : _entries) {
+            if (entry.handler == handler)
+                return entry.metrics;
+        }
+        _entries.push_back({ handler, RouteMetrics() });
+        return _entries.back().metrics;
+    }
+
+    const RouteMetrics* find(const RequestHandlerType* handler) const {
+        if (!handler)
+            return &_notFound;
+        for (const Entry& entry : _entries) {
+            if (entry.handler == handler)
+                return &entry.metrics;
+        }
+        return nullptr;
+    }
+
+    void reset() {
+        _entries.clear();
+        _notFound = RouteMetrics();
+    }
+
+    // Prometheus text exposition format, one label set per handler:
+    // route is the uri of the handler, or its rank for custom handlers
+    void write(Print& out, RequestHandlerType* first) const {
+        out.print(F("# TYPE http_requests_total counter\n"));
+        _forEach(first, [&](const String& labels, const RouteMetrics& metrics) {
+            _sample(out, F("http_requests_total"), labels, nullptr);
+            _value(out, metrics.requests);
+        });
+        out.print(F("# TYPE http_response_bytes_total counter\n"));
+        _forEach(first, [&](const String& labels, const RouteMetrics& metrics) {
+            _sample(out, F("http_response_bytes_total"), labels, nullptr);
+            _value(out, metrics.bytesSent);
+        });
+        out.print(F("# TYPE http_request_duration_seconds summary\n"));
+        static const char* const phases[METRICS_PHASES] = { "parse", "handler", "send" };
+        _forEach(first, [&](const String& labels, const RouteMetrics& metrics) {
+            for (uint8_t phase = 0; phase < METRICS_PHASES; phase++) {
+                const LatencyHistogram& latency = metrics.latency[phase];
+                String phaseLabels = labels;
+                phaseLabels += F(",phase=\"");
+                phaseLabels += phases[phase];
+                phaseLabels += '"';
+                _sample(out, F("http_request_duration_seconds"), phaseLabels, PSTR("0.5"));
+                _seconds(out, latency.percentile(50));
+                _sample(out, F("http_request_duration_seconds"), phaseLabels, PSTR("0.99"));
+                _seconds(out, latency.percentile(99));
+                _sample(out, F("http_request_duration_seconds_sum"), phaseLabels, nullptr);
+                _seconds(out, latency.sum());
+                _sample(out, F("http_request_duration_seconds_count"), phaseLabels, nullptr);
+                _value(out, latency.count());
+            }
+        });
+    }
+
+protected:
+    struct Entry {
+        RequestHandlerType* handler;
+        RouteMetrics metrics;
+    };
+
+    template<typename Fn>
+    void _forEach(RequestHandlerType* first, Fn fn) const {
+        unsigned rank = 0;
+        for (RequestHandlerType* handler = first; handler; handler = handler->next(), rank++) {
+            const RouteMetrics* metrics = find(handler);
+            if (!metrics)
+                continue;
+            HTTPMethod method = HTTP_ANY;
+            String pattern;
+            bool braces;
+            String labels = F("route=\"");
+            if (handler->routeKey(method, pattern, braces)) {
+                for (char c : pattern) {
+                    if (c == '"' || c == '\\')
+                        labels += '\\';
+                    labels += c;
+                }
+            } else {
+                labels += '#';
+                labels += rank;
+            }
+            labels += '"';
+            fn(labels, *metrics);
+        }
+        if (_notFound.requests)
+            fn(String(F("route=\"\"")), _notFound);
+    }
+
+    static void _sample(Print& out, const __FlashStringHelper* name, const String& labels, PGM_P quantile) {
+        out.print(name);
+        out.print('{');
+        out.print(labels);
+        if (quantile) {
+            out.print(F(",quantile=\""));
+            out.print(FPSTR(quantile));
+            out.print('"');
+        }
+        out.print(F("} "));
+    }
+
+    static void _seconds(Print& out, uint64_t us) {
+        out.print((unsigned long)(us / 1000000));
+        out.print('.');
+        char frac[7];
+        snprintf(frac, sizeof(frac), "%06u", (unsigned)(us % 1000000));
+        out.print(frac);
+        out.print('\n');
+    }
+
+    // Print::println() ends lines with \r\n
+    static void _value(Print& out, uint64_t value) {
+        out.print((unsigned long long)value);
+        out.print('\n');
+    }
+
+    std::vector<Entry> _entries;
+    RouteMetrics _notFound;
+};
+
+// Print to the body of the current response, in HTTP_HEADER_BUFFER_SIZE
+// pieces (chunks in chunked mode).
+template<typename WebServerType>
+class ContentPrint : public Print {
+public:
+    ContentPrint(WebServerType& server): _server(server) { }
+    ~ContentPrint() { flush(); }
+
+    size_t write(uint8_t c) override {
+        if (_len == sizeof(_buf))
+            flush();
+        _buf[_len++] = c;
+        return 1;
+    }
+
+    size_t write(const uint8_t* data, size_t len) override {
+        for (size_t left = len; left; ) {
+            if (_len == sizeof(_buf))
+                flush();
+            size_t chunk = std::min(left, sizeof(_buf) - _len);
+            memcpy(_buf + _len, data, chunk);
+            _len += chunk;
+            data += chunk;
+            left -= chunk;
+        }
+        return len;
+    }
+
+    void flush() override {
+        if (!_len)
+            return;
+        StreamConstPtr ref(_buf, _len);
+        _server.sendContent(&ref, _len);
+        _len = 0;
+    }
+
+protected:
+    WebServerType& _server;
+    size_t _len = 0;
+    char _buf[HTTP_HEADER_BUFFER_SIZE];
+};
+
+} // namespace
+
+#endif //REQUESTMETRICS_H
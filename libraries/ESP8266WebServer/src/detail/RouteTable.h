@@ -0,0 +1,165 @@
+#ifndef ROUTETABLE_H
+#define ROUTETABLE_H
+
+#include <algorithm>
+#include <vector>
+#include "RequestHandler.h"
+
+namespace esp8266webserver {
+
+// Index over the request handlers of a server (see compileRoutes()).
+// Handlers with a literal uri or a UriBraces pattern made of '{}' segments
+// are stored in a trie of path segments, children sorted for a binary search.
+// The trie only narrows the candidates down, canHandle() still decides.
+// Other handlers are tried along with the candidates in registration order,
+// so the first registered handler able to handle the request wins, as it
+// does without the table.
+template<typename ServerType>
+class RouteTable {
+    using RequestHandlerType = RequestHandler<ServerType>;
+public:
+    void build(RequestHandlerType* first) {
+        _nodes.clear();
+        _linear.clear();
+        _nodes.emplace_back();
+        uint16_t order = 0;
+        for (RequestHandlerType* handler = first; handler; handler = handler->next(), order++) {
+            Route route { order, HTTP_ANY, handler };
+            String pattern;
+            bool braces;
+            if (!handler->routeKey(route.method, pattern, braces) || !_insert(pattern, braces, route)) {
+                _linear.push_back(route);
+            }
+        }
+        DBGWS("route table: %u nodes, %u linear handlers\n", (unsigned)_nodes.size(), (unsigned)_linear.size());
+    }
+
+    RequestHandlerType* find(HTTPMethod method, const String& uri) {
+        _candidates.clear();
+        if (uri.length() && uri[0] == '/') {
+            _match(0, method, uri.c_str(), uri.c_str() + uri.length());
+            std::sort(_candidates.begin(), _candidates.end(), [](const Route& a, const Route& b) { return a.order < b.order; });
+        }
+
+        // merge both lists by registration order
+        size_t c = 0, l = 0;
+        while (c < _candidates.size() || l < _linear.size()) {
+            bool fromTrie = l == _linear.size() || (c < _candidates.size() && _candidates[c].order < _linear[l].order);
+            RequestHandlerType* handler = fromTrie ? _candidates[c++].handler : _linear[l++].handler;
+            if (handler->canHandle(method, uri))
+                return handler;
+        }
+        return nullptr;
+    }
+
+protected:
+    struct Route {
+        uint16_t order;
+        HTTPMethod method;
+        RequestHandlerType* handler;
+    };
+
+    struct Node {
+        String segment;
+        std::vector<uint16_t> children; // literal segments, sorted
+        int16_t param = -1;             // '{}' segment
+        std::vector<Route> routes;      // handlers whose pattern ends here
+    };
+
+    static int _compare(const String& segment, const char* s, size_t len) {
+        int c = memcmp(segment.c_str(), s, std::min((size_t)segment.length(), len));
+        return c ? c : (int)segment.length() - (int)len;
+    }
+
+    // '{}' must be whole segments, other braces are left to canHandle()
+    static bool _bracesAreSegments(const String& pattern) {
+        for (int i = pattern.indexOf('{'); i >= 0; i = pattern.indexOf('{', i + 1)) {
+            if (   pattern[i - 1] != '/'
+                || pattern[i + 1] != '}'
+                || (i + 2 < (int)pattern.length() && pattern[i + 2] != '/')) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool _insert(const String& pattern, bool braces, const Route& route) {
+        if (!pattern.length() || pattern[0] != '/' || (braces && !_bracesAreSegments(pattern)))
+            return false;
+
+        uint16_t node = 0;
+        const char* end = pattern.c_str() + pattern.length();
+        for (const char* p = pattern.c_str(); p < end; ) {
+            const char* seg = p + 1;
+            const char* slash = (const char*)memchr(seg, '/', end - seg);
+            if (!slash)
+                slash = end;
+            size_t len = slash - seg;
+            if (braces && len == 2 && seg[0] == '{') {
+                if (_nodes[node].param < 0) {
+                    _nodes.emplace_back();
+                    _nodes[node].param = _nodes.size() - 1;
+                }
+                node = _nodes[node].param;
+            } else {
+                node = _literal(node, seg, len);
+            }
+            p = slash;
+        }
+        _nodes[node].routes.push_back(route);
+        return true;
+    }
+
+    uint16_t _literal(uint16_t node, const char* seg, size_t len) {
+        std::vector<uint16_t>& children = _nodes[node].children;
+        auto it = std::lower_bound(children.begin(), children.end(), len, [&](uint16_t child, size_t) {
+            return _compare(_nodes[child].segment, seg, len) < 0;
+        });
+        if (it != children.end() && !_compare(_nodes[*it].segment, seg, len))
+            return *it;
+
+        uint16_t child = _nodes.size();
+        children.insert(it, child); // before emplace_back(), which invalidates the reference
+        _nodes.emplace_back();
+        _nodes.back().segment.concat(seg, len);
+        return child;
+    }
+
+    // p points to the '/' before the next segment
+    void _match(uint16_t node, HTTPMethod method, const char* p, const char* end) {
+        const char* seg = p + 1;
+        const char* slash = (const char*)memchr(seg, '/', end - seg);
+        if (!slash)
+            slash = end;
+        size_t len = slash - seg;
+
+        const Node& n = _nodes[node];
+        auto it = std::lower_bound(n.children.begin(), n.children.end(), len, [&](uint16_t child, size_t) {
+            return _compare(_nodes[child].segment, seg, len) < 0;
+        });
+        if (it != n.children.end() && !_compare(_nodes[*it].segment, seg, len))
+            _matchNext(*it, method, slash, end);
+        // a path argument may not contain a '/' but may be empty
+        if (n.param >= 0)
+            _matchNext(n.param, method, slash, end);
+    }
+
+    void _matchNext(uint16_t node, HTTPMethod method, const char* p, const char* end) {
+        if (p < end) {
+            _match(node, method, p, end);
+            return;
+        }
+        for (const Route& route : _nodes[node].routes) {
+            if (route.method == HTTP_ANY || route.method == method)
+                _candidates.push_back(route);
+        }
+    }
+
+    std::vector<Node> _nodes;
+    std::vector<Route> _linear;     // handlers the trie cannot index
+    std::vector<Route> _candidates; // find() scratch, kept to avoid reallocations
+};
+
+} // namespace
+
+#endif //ROUTETABLE_H
@@ -0,0 +1,68 @@
+#ifndef STATICASSETCACHE_H
+#define STATICASSETCACHE_H
+
+#include <vector>
+#include <FS.h>
+
+#ifndef HTTP_ASSET_CACHE_ENTRIES
+#define HTTP_ASSET_CACHE_ENTRIES 8 // per static handler
+#endif
+
+namespace esp8266webserver {
+
+// Memoized lookups of a static handler: requested path -> file to open (maybe
+// its .gz variant), size, content type and ETag. All entries are dropped when
+// the filesystem generation changes, the least recently used one makes room.
+class StaticAssetCache {
+public:
+    struct Entry {
+        String   key;         // request uri
+        String   path;        // file to send, empty when there is none
+        String   contentType;
+        String   eTag;        // computed on first use, when ETags are enabled
+        size_t   size = 0;    // checked against the opened file
+        uint32_t used = 0;
+    };
+
+    Entry* find(const fs::FS& fs, const String& key) {
+        if (fs.generation() != _generation) {
+            _entries.clear();
+            _generation = fs.generation();
+            return nullptr;
+        }
+        for (Entry& entry : _entries) {
+            if (entry.key == key) {
+                entry.used = ++_clock;
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    Entry& insert(const String& key) {
+        Entry* entry;
+        if (_entries.size() < HTTP_ASSET_CACHE_ENTRIES) {
+            _entries.emplace_back();
+            entry = &_entries.back();
+        } else {
+            entry = &_entries[0];
+            for (Entry& e : _entries) {
+                if (e.used < entry->used)
+                    entry = &e;
+            }
+            *entry = Entry();
+        }
+        entry->key = key;
+        entry->used = ++_clock;
+        return *entry;
+    }
+
+protected:
+    std::vector<Entry> _entries;
+    uint32_t _generation = 0;
+    uint32_t _clock = 0;
+};
+
+} // namespace
+
+#endif //STATICASSETCACHE_H
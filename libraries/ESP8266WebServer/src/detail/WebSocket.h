@@ -0,0 +1,413 @@
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <bearssl/bearssl_hash.h>
+#include <base64.h>
+#include "RequestHandler.h"
+#include "HeaderWriter.h"
+
+#ifndef WEBSOCKET_MAX_CLIENTS
+#define WEBSOCKET_MAX_CLIENTS 4 // per WebSocket handler
+#endif
+
+#ifndef WEBSOCKET_MAX_MESSAGE
+#define WEBSOCKET_MAX_MESSAGE 4096 // larger messages close the connection
+#endif
+
+namespace esp8266webserver {
+
+enum WebSocketOpcode : uint8_t {
+    WS_CONTINUATION = 0x0,
+    WS_TEXT         = 0x1,
+    WS_BINARY       = 0x2,
+    WS_CLOSE        = 0x8,
+    WS_PING         = 0x9,
+    WS_PONG         = 0xa,
+};
+
+enum WebSocketEvent { WS_EVENT_CONNECT, WS_EVENT_DISCONNECT, WS_EVENT_TEXT, WS_EVENT_BINARY, WS_EVENT_PONG };
+
+enum WebSocketCloseCode : uint16_t {
+    WS_CLOSE_NORMAL         = 1000,
+    WS_CLOSE_GOING_AWAY     = 1001,
+    WS_CLOSE_PROTOCOL_ERROR = 1002,
+    WS_CLOSE_TOO_BIG        = 1009,
+};
+
+// A server frame (not masked), encoded once: WebSocketHandler::broadcast()
+// writes the same bytes to every connection.
+class WebSocketFrame {
+public:
+    WebSocketFrame(WebSocketOpcode opcode, const void* payload, size_t len) {
+        uint8_t header[10];
+        size_t headerLen = encodeHeader(header, opcode, len);
+        _len = headerLen + len;
+        _data.reset(new uint8_t[_len]);
+        memcpy(_data.get(), header, headerLen);
+        memcpy(_data.get() + headerLen, payload, len);
+    }
+    WebSocketFrame(const String& text): WebSocketFrame(WS_TEXT, text.c_str(), text.length()) { }
+
+    const uint8_t* data() const { return _data.get(); }
+    size_t length() const { return _len; }
+
+    // header of a final frame, returns its length (2 to 10 bytes)
+    static size_t encodeHeader(uint8_t* header, uint8_t opcode, size_t len) {
+        header[0] = 0x80 | opcode;
+        if (len < 126) {
+            header[1] = len;
+            return 2;
+        }
+        if (len < 65536) {
+            header[1] = 126;
+            header[2] = len >> 8;
+            header[3] = len;
+            return 4;
+        }
+        header[1] = 127;
+        uint64_t len64 = len;
+        for (int i = 0; i < 8; i++)
+            header[2 + i] = len64 >> (56 - 8 * i);
+        return 10;
+    }
+
+protected:
+    std::unique_ptr<uint8_t[]> _data;
+    size_t _len = 0;
+};
+
+// One upgraded connection. Frames are parsed from the client's peek buffer
+// when it has one: the payload is unmasked in place and, when a message is a
+// single frame received in one piece, handed to the event function from there
+// without a copy. Fragmented messages and frames split across segments are
+// reassembled in a buffer, up to WEBSOCKET_MAX_MESSAGE bytes.
+// Message data given to the event function is not NUL terminated.
+template<typename ServerType>
+class WebSocket {
+public:
+    using ClientType = typename ServerType::ClientType;
+    using EventFunction = std::function<void(WebSocket& ws, WebSocketEvent event, const uint8_t* data, size_t len)>;
+
+    WebSocket(const ClientType& client, uint32_t id): _client(client), _id(id) { }
+
+    uint32_t id() const { return _id; } // unique among the connections of a handler
+    ClientType& client() { return _client; }
+    bool connected() { return !_closed && _client.connected(); }
+
+    bool sendText(const char* text, size_t len) { return _send(WS_TEXT, text, len); }
+    bool sendText(const String& text) { return _send(WS_TEXT, text.c_str(), text.length()); }
+    bool sendBinary(const uint8_t* data, size_t len) { return _send(WS_BINARY, data, len); }
+    bool ping(const uint8_t* data = nullptr, size_t len = 0) { return _send(WS_PING, data, std::min(len, (size_t)125)); }
+
+    bool send(const WebSocketFrame& frame) {
+        return !_closed && frame.length() && _client.write(frame.data(), frame.length()) == frame.length();
+    }
+
+    // the TCP connection is closed right after the close frame is sent
+    void close(uint16_t code = WS_CLOSE_NORMAL) {
+        if (_closed)
+            return;
+        uint8_t payload[2] = { (uint8_t)(code >> 8), (uint8_t)code };
+        _send(WS_CLOSE, payload, sizeof(payload));
+        _closed = true;
+        _client.stop();
+    }
+
+    // parse what has arrived, called by WebSocketHandler::loop()
+    void poll(const EventFunction& fn) {
+        while (!_closed && _client.available()) {
+            if (_client.hasPeekBufferAPI()) {
+                size_t avail = _client.peekAvailable();
+                if (!avail)
+                    break;
+                // receive buffer memory is writable, and not read again once consumed
+                _parse((uint8_t*)_client.peekBuffer(), avail, fn);
+                if (!_closed)
+                    _client.peekConsume(avail);
+            } else {
+                uint8_t buf[128];
+                size_t got = _client.read(buf, sizeof(buf));
+                if (!got)
+                    break;
+                _parse(buf, got, fn);
+            }
+        }
+    }
+
+protected:
+    bool _send(uint8_t opcode, const void* data, size_t len) {
+        if (_closed)
+            return false;
+        uint8_t header[10];
+        Print::iovec iov[2] = { { header, WebSocketFrame::encodeHeader(header, opcode, len) }, { data, len } };
+        return _client.write(iov, len ? 2 : 1) == iov[0].iov_len + len;
+    }
+
+    size_t _headerNeeded() const {
+        if (_headerLen < 2)
+            return 2;
+        uint8_t len = _header[1] & 0x7f;
+        return 2 + (len == 126 ? 2 : len == 127 ? 8 : 0) + ((_header[1] & 0x80) ? 4 : 0);
+    }
+
+    // all of data is consumed, unless the connection gets closed
+    void _parse(uint8_t* data, size_t len, const EventFunction& fn) {
+        size_t pos = 0;
+        while (pos < len && !_closed) {
+            if (!_inFrame) {
+                while (_headerLen < _headerNeeded() && pos < len)
+                    _header[_headerLen++] = data[pos++];
+                if (_headerLen == _headerNeeded())
+                    _startFrame(fn);
+                continue;
+            }
+            size_t n = std::min((uint64_t)(len - pos), _remaining);
+            _unmask(data + pos, n);
+            _remaining -= n;
+            _payload(data + pos, n, fn);
+            pos += n;
+        }
+    }
+
+    void _startFrame(const EventFunction& fn) {
+        _fin = _header[0] & 0x80;
+        _opcode = _header[0] & 0x0f;
+        bool masked = _header[1] & 0x80;
+        uint64_t len = _header[1] & 0x7f;
+        size_t off = 2;
+        if (len == 126) {
+            len = (_header[2] << 8) | _header[3];
+            off = 4;
+        } else if (len == 127) {
+            len = 0;
+            for (int i = 0; i < 8; i++)
+                len = (len << 8) | _header[2 + i];
+            off = 10;
+        }
+        memcpy(_mask, _header + off, sizeof(_mask));
+        _headerLen = 0;
+        _maskPos = 0;
+
+        // client frames are masked, no extension is negotiated
+        if (!masked || (_header[0] & 0x70))
+            return close(WS_CLOSE_PROTOCOL_ERROR);
+        if (_opcode & 0x08) {
+            if (!_fin || len > sizeof(_control) || (_opcode != WS_CLOSE && _opcode != WS_PING && _opcode != WS_PONG))
+                return close(WS_CLOSE_PROTOCOL_ERROR);
+        } else {
+            // a continuation needs a message to continue, a new message needs none
+            if (   (_opcode == WS_CONTINUATION) != (_messageOpcode != 0)
+                || (_opcode != WS_CONTINUATION && _opcode != WS_TEXT && _opcode != WS_BINARY))
+                return close(WS_CLOSE_PROTOCOL_ERROR);
+            if (_message.size() + len > WEBSOCKET_MAX_MESSAGE)
+                return close(WS_CLOSE_TOO_BIG);
+            if (_opcode != WS_CONTINUATION)
+                _messageOpcode = _opcode;
+        }
+
+        _frameLen = _remaining = len;
+        _inFrame = true;
+        if (!len)
+            _payload(_header, 0, fn);
+    }
+
+    void _unmask(uint8_t* data, size_t len) {
+        size_t i = 0;
+        for (; i < len && ((uintptr_t)(data + i) & 3); i++)
+            data[i] ^= _mask[_maskPos++ & 3];
+        if (len - i >= 4) {
+            uint8_t rotated[4];
+            for (int j = 0; j < 4; j++)
+                rotated[j] = _mask[(_maskPos + j) & 3];
+            uint32_t mask;
+            memcpy(&mask, rotated, sizeof(mask));
+            for (; len - i >= 4; i += 4)
+                *(uint32_t*)(data + i) ^= mask;
+        }
+        for (; i < len; i++)
+            data[i] ^= _mask[_maskPos++ & 3];
+    }
+
+    void _payload(uint8_t* data, size_t len, const EventFunction& fn) {
+        if (_opcode & 0x08) {
+            memcpy(_control + _controlLen, data, len);
+            _controlLen += len;
+            if (!_remaining)
+                _onControl(fn);
+        } else {
+            WebSocketEvent event = _messageOpcode == WS_TEXT ? WS_EVENT_TEXT : WS_EVENT_BINARY;
+            if (_fin && _message.empty() && len == _frameLen) {
+                // whole message in the receive buffer
+                _messageOpcode = 0;
+                fn(*this, event, data, len);
+            } else {
+                _message.insert(_message.end(), data, data + len);
+                if (!_remaining && _fin) {
+                    _messageOpcode = 0;
+                    fn(*this, event, _message.data(), _message.size());
+                    _message.clear();
+                }
+            }
+        }
+        if (!_remaining)
+            _inFrame = false;
+    }
+
+    void _onControl(const EventFunction& fn) {
+        size_t len = _controlLen;
+        _controlLen = 0;
+        switch (_opcode) {
+        case WS_PING:
+            _send(WS_PONG, _control, len);
+            break;
+        case WS_PONG:
+            fn(*this, WS_EVENT_PONG, _control, len);
+            break;
+        case WS_CLOSE:
+            // echo the status code, then close
+            _send(WS_CLOSE, _control, std::min(len, (size_t)2));
+            _closed = true;
+            _client.stop();
+            break;
+        }
+    }
+
+    ClientType _client;
+    uint32_t _id;
+    std::vector<uint8_t> _message;  // current message, when it is reassembled
+    uint64_t _frameLen = 0;
+    uint64_t _remaining = 0;        // payload bytes still to come in the current frame
+    uint8_t  _header[14];
+    uint8_t  _headerLen = 0;
+    uint8_t  _mask[4];
+    uint8_t  _maskPos = 0;
+    uint8_t  _opcode = 0;           // of the current frame
+    uint8_t  _messageOpcode = 0;    // of the current message, 0 between messages
+    bool     _fin = false;
+    bool     _inFrame = false;
+    bool     _closed = false;
+    uint8_t  _control[125];
+    uint8_t  _controlLen = 0;
+};
+
+// Upgrades GET requests on a uri to WebSocket connections and polls them.
+// See ESP8266WebServerTemplate::onWebSocket().
+template<typename ServerType>
+class WebSocketHandler : public RequestHandler<ServerType> {
+    using WebServerType = ESP8266WebServerTemplate<ServerType>;
+public:
+    using WebSocketType = WebSocket<ServerType>;
+    using EventFunction = typename WebSocketType::EventFunction;
+
+    WebSocketHandler(const String& uri, EventFunction fn): _uri(uri), _fn(fn) { }
+
+    bool canHandle(HTTPMethod method, const String& uri) override {
+        return method == HTTP_GET && uri == _uri;
+    }
+
+    bool routeKey(HTTPMethod& method, String& pattern, bool& braces) const override {
+        method = HTTP_GET;
+        pattern = _uri;
+        braces = false;
+        return true;
+    }
+
+    bool handle(WebServerType& server, HTTPMethod requestMethod, const String& requestUri) override {
+        if (!canHandle(requestMethod, requestUri))
+            return false;
+
+        const String& key = server.webSocketKey();
+        if (key.length() != 24) {
+            server.sendHeader(F("Sec-WebSocket-Version"), F("13"));
+            server.send(426, F("text/plain"), F("WebSocket upgrade required"));
+            return true;
+        }
+        if (_sockets.size() >= WEBSOCKET_MAX_CLIENTS) {
+            server.send(503, F("text/plain"), F("Too many WebSocket connections"));
+            return true;
+        }
+
+        static const char guid[] PROGMEM = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+        char magic[sizeof(guid)];
+        memcpy_P(magic, guid, sizeof(guid));
+        uint8_t hash[20];
+        br_sha1_context ctx;
+        br_sha1_init(&ctx);
+        br_sha1_update(&ctx, key.c_str(), key.length());
+        br_sha1_update(&ctx, magic, sizeof(magic) - 1);
+        br_sha1_out(&ctx, hash);
+        String accept = base64::encode(hash, sizeof(hash), false);
+
+        static const char head[] PROGMEM = "HTTP/1.1 101 Switching Protocols\r\n"
+                                           "Upgrade: websocket\r\n"
+                                           "Connection: Upgrade\r\n"
+                                           "Sec-WebSocket-Accept: ";
+        HeaderWriter header(server.client());
+        header.append_P(head, sizeof(head) - 1);
+        header.append(accept.c_str(), accept.length());
+        header.crlf();
+        header.crlf();
+        header.flush();
+        if (header.sent() != header.total())
+            return true;
+
+        _sockets.emplace_back(new WebSocketType(server.client(), _nextId++));
+        server.detachClient();
+        _fn(*_sockets.back(), WS_EVENT_CONNECT, nullptr, 0);
+        return true;
+    }
+
+    // poll the connections, called by handleClient()
+    void loop() {
+        for (size_t i = 0; i < _sockets.size(); ) {
+            WebSocketType& ws = *_sockets[i];
+            ws.poll(_fn);
+            if (ws.connected()) {
+                i++;
+                continue;
+            }
+            _fn(ws, WS_EVENT_DISCONNECT, nullptr, 0);
+            _sockets.erase(_sockets.begin() + i);
+        }
+    }
+
+    // returns the number of connections the frame was written to
+    size_t broadcast(const WebSocketFrame& frame) {
+        size_t sent = 0;
+        for (auto& ws : _sockets)
+            sent += ws->send(frame);
+        return sent;
+    }
+
+    size_t broadcastText(const String& text) {
+        return _sockets.empty() ? 0 : broadcast(WebSocketFrame(text));
+    }
+
+    WebSocketType* find(uint32_t id) {
+        for (auto& ws : _sockets) {
+            if (ws->id() == id)
+                return ws.get();
+        }
+        return nullptr;
+    }
+
+    size_t count() const { return _sockets.size(); }
+
+    void closeAll(uint16_t code = WS_CLOSE_GOING_AWAY) {
+        for (auto& ws : _sockets)
+            ws->close(code);
+    }
+
+protected:
+    String _uri;
+    EventFunction _fn;
+    std::vector<std::unique_ptr<WebSocketType>> _sockets;
+    uint32_t _nextId = 0;
+};
+
+} // namespace
+
+#endif //WEBSOCKET_H
@@ -1,5 +1,7 @@
+#include <vector>
 #include "mimetable.h"
 #include "pgmspace.h"
+#include "PgmHash.h"
 #include "WString.h"
 
 namespace mime
@@ -88,14 +90,73 @@ const Entry mimeTable[maxType] PROGMEM =
     { kDefaultSuffix, kDefault }
 };
 
+// the extensions of mimeTable, in the same order, in a table built at
+// compile time so that a path is looked up with a single hash probe
+static constexpr auto extensions PROGMEM = makePgmKeywords(false,
+    "html", "htm", "txt",
+#ifndef MIMETYPE_MINIMAL
+    "css", "js", "json", "png", "gif", "jpg", "jpeg", "ico", "svg", "ttf", "otf",
+    "woff", "woff2", "eot", "sfnt", "xml", "pdf", "zip", "appcache",
+#endif // MIMETYPE_MINIMAL
+    "gz");
+static_assert(extensions.size() == none, "one extension per mime type");
+
+struct UserType
+{
+    String extension;
+    String mimeType;
+};
+
+// what addContentType() registered, looked at before the table and only
+// when not empty
+static std::vector<UserType>& userTypes()
+{
+    static std::vector<UserType> types;
+    return types;
+}
+
+static const char* extensionOf(const String& path, size_t& len)
+{
+    int dot = path.lastIndexOf('.');
+    if (dot < 0) {
+        len = 0;
+        return nullptr;
+    }
+    len = path.length() - dot - 1;
+    return path.c_str() + dot + 1;
+}
+
     String getContentType(const String& path) {
-        for (size_t i = 0; i < maxType; i++) {
-            if (path.endsWith(FPSTR(mimeTable[i].endsWith))) {
-                return String(FPSTR(mimeTable[i].mimeType));
+        size_t len;
+        const char* extension = extensionOf(path, len);
+        if (extension) {
+            for (const auto& type : userTypes()) {
+                if (type.extension.length() == len && !memcmp(type.extension.c_str(), extension, len)) {
+                    return type.mimeType;
+                }
+            }
+            int index = extensions.find(extension, len);
+            if (index >= 0) {
+                return String(FPSTR(mimeTable[index].mimeType));
             }
         }
         // Fall-through and just return default type
         return String(FPSTR(kDefault));
     }
 
+    bool addContentType(const String& extension, const String& mimeType) {
+        String ext = extension.startsWith(".") ? extension.substring(1) : extension;
+        if (!ext.length() || ext.indexOf('.') >= 0 || !mimeType.length()) {
+            return false;
+        }
+        for (auto& type : userTypes()) {
+            if (type.extension == ext) {
+                type.mimeType = mimeType;
+                return true;
+            }
+        }
+        userTypes().push_back({ std::move(ext), mimeType });
+        return true;
+    }
+
 }
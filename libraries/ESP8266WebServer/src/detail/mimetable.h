@@ -46,7 +46,13 @@ struct Entry
 
 extern const Entry mimeTable[maxType];
 
+// the type for the extension of path, looked up with one hash probe
 String getContentType(const String& path);
+
+// register a type for an extension ("webmanifest" or ".webmanifest"), also
+// replacing a built in one; the registered types are compared one by one
+// before the built in ones, false for an invalid extension or type
+bool addContentType(const String& extension, const String& mimeType);
 }
 
 #endif
@@ -13,6 +13,12 @@ class UriBraces : public Uri {
             return new UriBraces(_uri);
         };
 
+        bool routePattern(String &pattern, bool &braces) const override final {
+            pattern = _uri;
+            braces = true;
+            return true;
+        }
+
         bool canHandle(const String &requestUri, std::vector<String> &pathArgs) override final {
             if (Uri::canHandle(requestUri, pathArgs))
                 return true;
@@ -81,7 +81,10 @@ void fetchURL(BearSSL::WiFiClientSecure *client, const char *host, const uint16_
   client->stop();
   uint32_t freeStackEnd = ESP.getFreeContStack();
   Serial.printf("\nCONT stack used: %d\n", freeStackStart - freeStackEnd);
-  Serial.printf("BSSL stack used: %d\n-------\n\n", stack_thunk_get_max_usage());
+  Serial.printf("BSSL stack used: %d (handshake %d, encrypt %d, decrypt %d)\n-------\n\n", stack_thunk_get_max_usage(),
+                stack_thunk_get_op_max_usage(STACK_THUNK_OP_HANDSHAKE), stack_thunk_get_op_max_usage(STACK_THUNK_OP_ENCRYPT),
+                stack_thunk_get_op_max_usage(STACK_THUNK_OP_DECRYPT));
+  stack_thunk_profile(true);  // start over for the next fetch
 }
 
 void fetchNoConfig() {
@@ -216,6 +219,9 @@ void setup() {
   Serial.println("IP address: ");
   Serial.println(WiFi.localIP());
 
+  // Record the BearSSL stack used by each kind of operation
+  stack_thunk_profile(true);
+
   fetchNoConfig();
   fetchInsecure();
   fetchFingerprint();
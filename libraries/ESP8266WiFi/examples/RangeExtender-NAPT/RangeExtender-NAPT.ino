@@ -11,7 +11,7 @@
 #endif
 
 #include <ESP8266WiFi.h>
-#include <lwip/napt.h>
+#include <LwipNapt.h>
 #include <lwip/dns.h>
 
 #define NAPT 1000
@@ -66,15 +66,20 @@ void setup() {
   Serial.printf("AP: %s\n", WiFi.softAPIP().toString().c_str());
 
   Serial.printf("Heap before: %d\n", ESP.getFreeHeap());
-  err_t ret = ip_napt_init(NAPT, NAPT_PORT);
-  Serial.printf("ip_napt_init(%d,%d): ret=%d (OK=%d)\n", NAPT, NAPT_PORT, (int)ret, (int)ERR_OK);
-  if (ret == ERR_OK) {
-    ret = ip_napt_enable_no(SOFTAP_IF, 1);
-    Serial.printf("ip_napt_enable_no(SOFTAP_IF): ret=%d (OK=%d)\n", (int)ret, (int)ERR_OK);
-    if (ret == ERR_OK) { Serial.printf("WiFi Network '%s' with same password is now NATed behind '%s'\n", STASSID "extender", STASSID); }
-  }
+  bool ret = LwipNapt::begin(NAPT, NAPT_PORT, SOFTAP_IF);
+  Serial.printf("LwipNapt::begin(%d,%d): %s\n", NAPT, NAPT_PORT, ret ? "ok" : "failed");
+  if (ret) { Serial.printf("WiFi Network '%s' with same password is now NATed behind '%s'\n", STASSID "extender", STASSID); }
   Serial.printf("Heap after napt init: %d\n", ESP.getFreeHeap());
-  if (ret != ERR_OK) { Serial.printf("NAPT initialization failed\n"); }
+  if (!ret) { Serial.printf("NAPT initialization failed\n"); }
+}
+
+void loop() {
+  static uint32_t last = 0;
+  if (millis() - last > 10000) {
+    last = millis();
+    LwipNapt::Stats stats = LwipNapt::stats();
+    Serial.printf("NAPT: %u/%u flows, fwd %u ret %u, hits %u misses %u evictions %u\n", stats.activeFlows, stats.tableSize, stats.forwarded, stats.returned, stats.hits, stats.misses, stats.evictions);
+  }
 }
 
 #else
@@ -84,6 +89,6 @@ void setup() {
   Serial.printf("\n\nNAPT not supported in this configuration\n");
 }
 
-#endif
-
 void loop() {}
+
+#endif
@@ -30,6 +30,9 @@
 #include <Arduino.h>
 #include <StackThunk.h>
 #include <Updater_Signing.h>
+#include <umm_malloc/umm_heap_select.h>
+#include <coredecls.h>
+#include <Crypto.h>
 #ifndef ARDUINO_SIGNING
   #define ARDUINO_SIGNING 0
 #endif
@@ -893,18 +896,237 @@ const br_ssl_session_cache_class **ServerSessions::getCache() {
   return _size > 0 ? &_cache.vtable : nullptr;
 }
 
+static constexpr uint32_t SESSION_CACHE_MAGIC = 0x31435342; // "BSC1"
+
+SessionCache::SessionCache(size_t size) :
+  _entries(new (std::nothrow) Entry[size]), _size(_entries ? size : 0) {
+  clear();
+}
+
+void SessionCache::clear() {
+  for (size_t i = 0; i < _size; i++) {
+    _entries[i].key = 0;
+    _entries[i].used = 0;
+  }
+}
+
+uint32_t SessionCache::_key(const char *host, uint16_t port) {
+  // FNV-1a, hostnames are case insensitive
+  uint32_t key = 2166136261u;
+  for (; *host; host++) {
+    key = (key ^ (uint8_t)tolower(*host)) * 16777619u;
+  }
+  key = (key ^ (port & 0xff)) * 16777619u;
+  key = (key ^ (port >> 8)) * 16777619u;
+  return key ? key : 1;
+}
+
+bool SessionCache::_get(uint32_t key, br_ssl_session_parameters *params) {
+  for (size_t i = 0; i < _size; i++) {
+    if (_entries[i].key == key) {
+      _entries[i].used = ++_clock;
+      memcpy(params, &_entries[i].params, sizeof(*params));
+      return true;
+    }
+  }
+  return false;
+}
+
+void SessionCache::_put(uint32_t key, const br_ssl_session_parameters *params) {
+  if (!_size || !params->session_id_len) {
+    return;
+  }
+  Entry *entry = &_entries[0];
+  for (size_t i = 0; i < _size; i++) {
+    if (_entries[i].key == key) {
+      entry = &_entries[i];
+      break;
+    }
+    if (_entries[i].used < entry->used) {
+      entry = &_entries[i];
+    }
+  }
+  entry->key = key;
+  entry->used = ++_clock;
+  memcpy(&entry->params, params, sizeof(*params));
+}
+
+void SessionCache::_remove(uint32_t key) {
+  for (size_t i = 0; i < _size; i++) {
+    if (_entries[i].key == key) {
+      _entries[i].key = 0;
+      _entries[i].used = 0;
+    }
+  }
+}
+
+size_t SessionCache::_serialize(uint8_t *buf, size_t len) const {
+  if (len < sizeof(Header)) {
+    return 0;
+  }
+  Header *header = (Header *)buf;
+  Stored *stored = (Stored *)(buf + sizeof(Header));
+  size_t count = 0;
+  uint32_t below = UINT32_MAX;
+  // Most recently used first, so a smaller store keeps the most useful
+  while (sizeof(Header) + (count + 1) * sizeof(Stored) <= len) {
+    const Entry *next = nullptr;
+    for (size_t i = 0; i < _size; i++) {
+      if (_entries[i].key && _entries[i].used < below && (!next || _entries[i].used > next->used)) {
+        next = &_entries[i];
+      }
+    }
+    if (!next) {
+      break;
+    }
+    memset(&stored[count], 0, sizeof(Stored));
+    stored[count].key = next->key;
+    memcpy(&stored[count].params, &next->params, sizeof(next->params));
+    below = next->used;
+    count++;
+  }
+  header->magic = SESSION_CACHE_MAGIC;
+  header->count = count;
+  header->storedSize = sizeof(Stored);
+  header->crc = crc32(stored, count * sizeof(Stored));
+  return sizeof(Header) + count * sizeof(Stored);
+}
+
+bool SessionCache::_deserialize(const Header &header, const Stored *stored) {
+  if (crc32(stored, header.count * sizeof(Stored)) != header.crc) {
+    return false;
+  }
+  clear();
+  size_t count = std::min<size_t>(header.count, _size);
+  for (size_t i = 0; i < count; i++) {
+    _entries[i].key = stored[i].key;
+    _entries[i].used = count - i;
+    memcpy(&_entries[i].params, &stored[i].params, sizeof(stored[i].params));
+  }
+  _clock = count;
+  return true;
+}
+
+bool SessionCache::save(Print &out) const {
+  size_t len = sizeof(Header) + _size * sizeof(Stored);
+  std::unique_ptr<uint8_t[]> buf(new (std::nothrow) uint8_t[len]);
+  if (!buf) {
+    return false;
+  }
+  len = _serialize(buf.get(), len);
+  return out.write(buf.get(), len) == len;
+}
+
+bool SessionCache::load(Stream &in) {
+  Header header;
+  if (in.readBytes((uint8_t *)&header, sizeof(header)) != sizeof(header) ||
+      header.magic != SESSION_CACHE_MAGIC || header.storedSize != sizeof(Stored)) {
+    return false;
+  }
+  size_t len = header.count * sizeof(Stored);
+  std::unique_ptr<Stored[]> stored(new (std::nothrow) Stored[header.count]);
+  if (!stored || in.readBytes((uint8_t *)stored.get(), len) != len) {
+    return false;
+  }
+  return _deserialize(header, stored.get());
+}
+
+bool SessionCache::saveToRTC(uint32_t offset) const {
+  if (offset * 4 >= 512) {
+    return false;
+  }
+  uint32_t buf[128];
+  size_t len = _serialize((uint8_t *)buf, 512 - offset * 4);
+  return len && ESP.rtcUserMemoryWrite(offset, buf, len);
+}
+
+bool SessionCache::loadFromRTC(uint32_t offset) {
+  uint32_t buf[128];
+  Header *header = (Header *)buf;
+  if (offset * 4 + sizeof(Header) > 512 || !ESP.rtcUserMemoryRead(offset, buf, sizeof(Header)) ||
+      header->magic != SESSION_CACHE_MAGIC || header->storedSize != sizeof(Stored) ||
+      offset * 4 + sizeof(Header) + header->count * sizeof(Stored) > 512) {
+    return false;
+  }
+  size_t len = sizeof(Header) + header->count * sizeof(Stored);
+  if (!ESP.rtcUserMemoryRead(offset, buf, len)) {
+    return false;
+  }
+  return _deserialize(*header, (const Stored *)(header + 1));
+}
+
+TLSBufferPool::TLSBufferPool(size_t maxIdle) : _idle(std::make_shared<Idle>()) {
+  _idle->max = maxIdle;
+}
+
+TLSBufferPool::~TLSBufferPool() {
+  clear();
+}
+
+unsigned char *TLSBufferPool::_alloc(size_t size) {
+  // TLS records are bulk copied, IRAM heap when there is one
+  return heap_alloc_by_intent(HeapIntent::LargeCold, [size]() {
+    return new (std::nothrow) unsigned char[size];
+  });
+}
+
+std::shared_ptr<unsigned char> TLSBufferPool::get(size_t size) {
+  auto &buffers = _idle->buffers;
+  auto best = buffers.end();
+  for (auto it = buffers.begin(); it != buffers.end(); ++it) {
+    if (it->size >= size && (best == buffers.end() || it->size < best->size)) {
+      best = it;
+    }
+  }
+  Buffer buffer;
+  if (best != buffers.end()) {
+    buffer = *best;
+    buffers.erase(best);
+  } else {
+    buffer = { _alloc(size), size };
+    if (!buffer.data && !buffers.empty()) {
+      // The idle buffers are too small, they may be in the way
+      clear();
+      buffer.data = _alloc(size);
+    }
+    if (!buffer.data) {
+      return nullptr;
+    }
+  }
+  std::weak_ptr<Idle> pool = _idle;
+  return std::shared_ptr<unsigned char>(buffer.data, [pool, buffer](unsigned char *data) {
+    auto idle = pool.lock();
+    if (idle && idle->buffers.size() < idle->max) {
+      idle->buffers.push_back(buffer);
+    } else {
+      delete[] data;
+    }
+  });
+}
+
+void TLSBufferPool::clear() {
+  for (auto &buffer : _idle->buffers) {
+    delete[] buffer.data;
+  }
+  _idle->buffers.clear();
+}
+
 // SHA256 hash for updater
 void HashSHA256::begin() {
+#if CRYPTO_OPTIMIZED_KERNELS
+  experimental::crypto::sha256Init( &_cc );
+#else
   br_sha256_init( &_cc );
+#endif
   memset( _sha256, 0, sizeof(_sha256) );
 }
 
 void HashSHA256::add(const void *data, uint32_t len) {
-  br_sha256_update( &_cc, data, len );
+  _cc.vtable->update( &_cc.vtable, data, len );
 }
 
 void HashSHA256::end() {
-  br_sha256_out( &_cc, _sha256 );
+  _cc.vtable->out( &_cc.vtable, _sha256 );
 }
 
 int HashSHA256::len() {
@@ -965,7 +1187,10 @@ extern "C" bool thunk_SigningVerifier_verify(PublicKey *_pubKey, UpdaterHashClas
 bool SigningVerifier::verify(UpdaterHashClass *hash, const void *signature, uint32_t signatureLen) {
   if (!_pubKey || !hash || !signature || signatureLen != length()) return false;
 #if !CORE_MOCK
-    return thunk_SigningVerifier_verify(_pubKey, hash, signature, signatureLen);
+    stack_thunk_profile_begin();
+    bool ok = thunk_SigningVerifier_verify(_pubKey, hash, signature, signatureLen);
+    stack_thunk_profile_end(STACK_THUNK_OP_VERIFY);
+    return ok;
 #else
     return SigningVerifier_verify(_pubKey, hash, signature, signatureLen);
 #endif
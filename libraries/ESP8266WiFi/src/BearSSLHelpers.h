@@ -26,6 +26,8 @@
 #include <bearssl/bearssl.h>
 #include <StackThunk.h>
 #include <Updater.h>
+#include <memory>
+#include <vector>
 
 // Internal opaque structures, not needed by user applications
 namespace brssl {
@@ -150,6 +152,67 @@ class Session {
     br_ssl_session_parameters _session;
 };
 
+// Cache for the TLS sessions of the connections to many servers, keyed by
+// host (or IP) and port, so that reconnecting to any of them is fast.
+// Use with BearSSL::WiFiClientSecure::setSessionCache, or for all the
+// clients not given a session with WiFiClientSecure::setDefaultSessionCache,
+// which HTTPClient and MQTT libraries then use without any change.
+// The sessions can be saved and restored to survive a reboot or deep sleep.
+// They hold the secrets of the connections, so keep them private.
+class SessionCache {
+  friend class WiFiClientSecureCtx;
+
+  public:
+    // Holds up to size sessions, the least recently used one is replaced
+    SessionCache(size_t size = 4);
+
+    // Returns the number of sessions the cache can hold.
+    size_t size() const { return _size; }
+
+    // Forgets all sessions
+    void clear();
+
+    // Writes or reads back the sessions, e.g. in a LittleFS file
+    bool save(Print &out) const;
+    bool load(Stream &in);
+
+    // Same in the RTC user memory (512 bytes, see ESP.rtcUserMemoryWrite),
+    // which keeps the most recently used sessions, 5 at most, through deep sleep
+    bool saveToRTC(uint32_t offset = 0) const;
+    bool loadFromRTC(uint32_t offset = 0);
+
+  private:
+    struct Entry {
+      uint32_t key; // 0 when empty
+      uint32_t used;
+      br_ssl_session_parameters params;
+    };
+    // As saved
+    struct Stored {
+      uint32_t key;
+      br_ssl_session_parameters params;
+    };
+    struct Header {
+      uint32_t magic;
+      uint16_t count;
+      uint16_t storedSize;
+      uint32_t crc;
+    };
+
+    static uint32_t _key(const char *host, uint16_t port);
+    bool _get(uint32_t key, br_ssl_session_parameters *params);
+    void _put(uint32_t key, const br_ssl_session_parameters *params);
+    void _remove(uint32_t key);
+
+    // Header then sessions as many as fit in len, most recently used first
+    size_t _serialize(uint8_t *buf, size_t len) const;
+    bool _deserialize(const Header &header, const Stored *stored);
+
+    std::unique_ptr<Entry[]> _entries;
+    size_t _size;
+    uint32_t _clock = 0;
+};
+
 // Represents a single server session.
 // Use with BearSSL::ServerSessions.
 typedef uint8_t ServerSession[100];
@@ -166,7 +229,7 @@ class ServerSessions {
     // Dynamically allocates a cache for the given number of sessions and initializes it.
     // If the allocation of the buffer wasn't successful, the value
     // returned by size() will be 0.
-    ServerSessions(uint32_t size) : ServerSessions(size > 0 ? new ServerSession[size] : nullptr, size, true) {}
+    ServerSessions(uint32_t size) : ServerSessions(size > 0 ? new (std::nothrow) ServerSession[size] : nullptr, size, true) {}
 
     ~ServerSessions();
 
@@ -191,6 +254,47 @@ class ServerSessions {
     br_ssl_session_cache_lru _cache;
 };
 
+// Keeps the I/O buffers of stopped TLS connections for the next ones, so
+// connecting again does not need the heap to find ~17KB of contiguous RAM
+// once more, and the connections of many clients take turns using the same
+// buffers.  Use with BearSSL::WiFiClientSecure::setBufferPool
+// A buffer comes back when the connection using it stops, or is freed if
+// the pool is already full or gone.
+class TLSBufferPool {
+  public:
+    // Keeps at most maxIdle buffers while they are not used
+    TLSBufferPool(size_t maxIdle = 2);
+    ~TLSBufferPool();
+
+    TLSBufferPool(const TLSBufferPool&) = delete;
+    TLSBufferPool& operator=(const TLSBufferPool&) = delete;
+
+    // Returns the smallest idle buffer of at least size bytes, or a new one,
+    // given back to the pool when the last reference to it is dropped
+    std::shared_ptr<unsigned char> get(size_t size);
+
+    // Frees the idle buffers
+    void clear();
+
+    // Returns the number of idle buffers
+    size_t idle() const { return _idle->buffers.size(); }
+
+  private:
+    struct Buffer {
+      unsigned char *data;
+      size_t size;
+    };
+    struct Idle {
+      std::vector<Buffer> buffers;
+      size_t max;
+    };
+
+    static unsigned char *_alloc(size_t size);
+
+    // Shared with the buffers lent out, which may outlive the pool
+    std::shared_ptr<Idle> _idle;
+};
+
 // Updater SHA256 hash and signature verification
 class HashSHA256 : public UpdaterHashClass {
   public:
@@ -18,6 +18,7 @@
 */
 
 #include "CertStoreBearSSL.h"
+#include <algorithm>
 #include <memory>
 
 
@@ -101,6 +102,10 @@ int CertStore::initCertStore(fs::FS &fs, const char *indexFileName, const char *
   memcpy_P(_indexName, indexFileName, strlen_P(indexFileName) + 1);
   memcpy_P(_dataName, dataFileName, strlen_P(dataFileName) + 1);
 
+  // Trust anchors from the previous store
+  _count = 0;
+  _cache.clear();
+
   fs::File index = _fs->open(_indexName, "w");
   if (!index) {
     return 0;
@@ -119,6 +124,10 @@ int CertStore::initCertStore(fs::FS &fs, const char *indexFileName, const char *
     index.close();
     return 0;
   }
+
+  // Collected to be sorted, so that findHashedTA can do a binary search
+  CertStore::CertInfo *infos = nullptr;
+  int capacity = 0;
   offset += sizeof(magic);
 
   while (true) {
@@ -146,12 +155,18 @@ int CertStore::initCertStore(fs::FS &fs, const char *indexFileName, const char *
 
     // If the filename starts with "//" then this is a rename file, skip it
     if (fileHeader[0] != '/' || fileHeader[1] != '/') {
-      CertStore::CertInfo ci = _preprocessCert(length, offset, raw);
-      if (index.write((uint8_t *)&ci, sizeof(ci)) != (ssize_t)sizeof(ci)) {
-        free(raw);
-        break;
+      if (count == capacity) {
+        int more = capacity ? capacity * 2 : 32;
+        CertStore::CertInfo *grown = (CertStore::CertInfo *)realloc(infos, more * sizeof(*infos));
+        if (!grown) {
+          DEBUG_BSSL("CertStore::initCertStore: OOM\n");
+          free(raw);
+          break;
+        }
+        infos = grown;
+        capacity = more;
       }
-      count++;
+      infos[count++] = _preprocessCert(length, offset, raw);
     }
 
     offset += length;
@@ -163,7 +178,16 @@ int CertStore::initCertStore(fs::FS &fs, const char *indexFileName, const char *
     }
   }
   data.close();
+
+  std::sort(infos, infos + count, [](const CertStore::CertInfo &a, const CertStore::CertInfo &b) {
+    return memcmp(a.sha256, b.sha256, sizeof(a.sha256)) < 0;
+  });
+  if (count && index.write((uint8_t *)infos, count * sizeof(*infos)) != count * sizeof(*infos)) {
+    count = 0;
+  }
+  free(infos);
   index.close();
+  _count = count;
   return count;
 }
 
@@ -171,64 +195,126 @@ void CertStore::installCertStore(br_x509_minimal_context *ctx) {
   br_x509_minimal_set_dynamic(ctx, (void*)this, findHashedTA, freeHashedTA);
 }
 
-const br_x509_trust_anchor *CertStore::findHashedTA(void *ctx, void *hashed_dn, size_t len) {
-  CertStore *cs = static_cast<CertStore*>(ctx);
+void CertStore::_pruneCache(size_t keep) {
+  // Least recently used first, unless BearSSL is using it
+  while (_cache.size() + keep > _cacheSize) {
+    auto lru = _cache.end();
+    for (auto it = _cache.begin(); it != _cache.end(); ++it) {
+      if (!it->refs && (lru == _cache.end() || it->used < lru->used)) {
+        lru = it;
+      }
+    }
+    if (lru == _cache.end()) {
+      break;
+    }
+    _cache.erase(lru);
+  }
+}
+
+X509List *CertStore::_loadTA(const uint8_t *sha256) {
   CertStore::CertInfo ci;
 
-  if (!cs || len != sizeof(ci.sha256) || !cs->_indexName || !cs->_dataName || !cs->_fs) {
+  fs::File index = _fs->open(_indexName, "r");
+  if (!index) {
     return nullptr;
   }
 
-  fs::File index = cs->_fs->open(cs->_indexName, "r");
-  if (!index) {
+  // Binary search in the sorted index
+  bool found = false;
+  uint32_t lo = 0;
+  uint32_t hi = _count;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (!index.seek(mid * sizeof(ci), fs::SeekSet) || index.read((uint8_t *)&ci, sizeof(ci)) != sizeof(ci)) {
+      break;
+    }
+    int cmp = memcmp(ci.sha256, sha256, sizeof(ci.sha256));
+    if (!cmp) {
+      found = true;
+      break;
+    }
+    if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  index.close();
+  if (!found) {
     return nullptr;
   }
 
-  while (index.read((uint8_t *)&ci, sizeof(ci)) == sizeof(ci)) {
-    if (!memcmp(ci.sha256, hashed_dn, sizeof(ci.sha256))) {
-      index.close();
-      uint8_t *der = (uint8_t*)malloc(ci.length);
-      if (!der) {
-        return nullptr;
-      }
-      fs::File data = cs->_fs->open(cs->_dataName, "r");
-      if (!data) {
-        free(der);
-        return nullptr;
-      }
-      if (!data.seek(ci.offset, fs::SeekSet)) {
-        data.close();
-        free(der);
-        return nullptr;
-      }
-      if (data.read(der, ci.length) != (int)ci.length) {
-        free(der);
-        return nullptr;
-      }
-      data.close();
-      cs->_x509 = new (std::nothrow) X509List(der, ci.length);
-      free(der);
-      if (!cs->_x509) {
-        DEBUG_BSSL("CertStore::findHashedTA: OOM\n");
-        return nullptr;
-      }
+  uint8_t *der = (uint8_t*)malloc(ci.length);
+  if (!der) {
+    return nullptr;
+  }
+  fs::File data = _fs->open(_dataName, "r");
+  if (!data) {
+    free(der);
+    return nullptr;
+  }
+  if (!data.seek(ci.offset, fs::SeekSet)) {
+    data.close();
+    free(der);
+    return nullptr;
+  }
+  if (data.read(der, ci.length) != (int)ci.length) {
+    free(der);
+    return nullptr;
+  }
+  data.close();
+  X509List *x509 = new (std::nothrow) X509List(der, ci.length);
+  free(der);
+  if (!x509) {
+    DEBUG_BSSL("CertStore::findHashedTA: OOM\n");
+    return nullptr;
+  }
+
+  br_x509_trust_anchor *ta = (br_x509_trust_anchor*)x509->getTrustAnchors();
+  memcpy(ta->dn.data, ci.sha256, sizeof(ci.sha256));
+  ta->dn.len = sizeof(ci.sha256);
 
-      br_x509_trust_anchor *ta = (br_x509_trust_anchor*)cs->_x509->getTrustAnchors();
-      memcpy(ta->dn.data, ci.sha256, sizeof(ci.sha256));
-      ta->dn.len = sizeof(ci.sha256);
+  return x509;
+}
+
+const br_x509_trust_anchor *CertStore::findHashedTA(void *ctx, void *hashed_dn, size_t len) {
+  CertStore *cs = static_cast<CertStore*>(ctx);
+
+  if (!cs || len != sizeof(CertStore::CertInfo::sha256) || !cs->_indexName || !cs->_dataName || !cs->_fs) {
+    return nullptr;
+  }
 
-      return ta;
+  for (auto &cached : cs->_cache) {
+    if (!memcmp(cached.sha256, hashed_dn, sizeof(cached.sha256))) {
+      cached.used = ++cs->_clock;
+      cached.refs++;
+      return cached.x509->getTrustAnchors();
     }
   }
-  index.close();
-  return nullptr;
+
+  X509List *x509 = cs->_loadTA((const uint8_t *)hashed_dn);
+  if (!x509) {
+    return nullptr;
+  }
+  cs->_pruneCache(1);
+  CachedTA cached;
+  memcpy(cached.sha256, hashed_dn, sizeof(cached.sha256));
+  cached.x509.reset(x509);
+  cached.used = ++cs->_clock;
+  cached.refs = 1;
+  cs->_cache.push_back(std::move(cached));
+  return x509->getTrustAnchors();
 }
 
 void CertStore::freeHashedTA(void *ctx, const br_x509_trust_anchor *ta) {
   CertStore *cs = static_cast<CertStore*>(ctx);
-  (void) ta; // Unused
-  delete cs->_x509;
-  cs->_x509 = nullptr;
+  for (auto &cached : cs->_cache) {
+    if (cached.x509->getTrustAnchors() == ta && cached.refs) {
+      cached.refs--;
+      break;
+    }
+  }
+  cs->_pruneCache();
 }
 
 }
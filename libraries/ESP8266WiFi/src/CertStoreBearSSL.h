@@ -24,6 +24,8 @@
 #include <BearSSLHelpers.h>
 #include <bearssl/bearssl.h>
 #include <FS.h>
+#include <memory>
+#include <vector>
 
 // Base class for the certificate stores, which allow use
 // of a large set of certificates stored on FS or SD card to
@@ -50,17 +52,34 @@ class CertStore: public CertStoreBase {
     // Installs the cert store into the X509 decoder (normally via static function callbacks)
     void installCertStore(br_x509_minimal_context *ctx);
 
+    // Number of trust anchors kept decoded after use, so that connecting
+    // again through the same CA needs no file access
+    void setCacheSize(size_t count) { _cacheSize = count; _pruneCache(); }
+
   protected:
     fs::FS *_fs = nullptr;
     char *_indexName = nullptr;
     char *_dataName = nullptr;
-    X509List *_x509 = nullptr;
+    uint32_t _count = 0; // in the index
+
+    // Recently used trust anchors, the ones in use by BearSSL are never dropped
+    struct CachedTA {
+      uint8_t sha256[32];
+      std::unique_ptr<X509List> x509;
+      uint32_t used;
+      uint8_t refs;
+    };
+    std::vector<CachedTA> _cache;
+    size_t _cacheSize = 1;
+    uint32_t _clock = 0;
+    void _pruneCache(size_t keep = 0);
+    X509List *_loadTA(const uint8_t *sha256);
 
     // These need to be static as they are callbacks from BearSSL C code
     static const br_x509_trust_anchor *findHashedTA(void *ctx, void *hashed_dn, size_t len);
     static void freeHashedTA(void *ctx, const br_x509_trust_anchor *ta);
 
-    // The binary format of the index file
+    // The binary format of the index file, sorted by sha256 of the subject
     class CertInfo {
     public:
       uint8_t sha256[32];
@@ -54,6 +54,7 @@ extern "C" {
 #endif
 
 extern "C" void enableWiFiAtBootTime (void) __attribute__((noinline));
+extern "C" void enableWiFiFastConnectAtBootTime (void) __attribute__((noinline));
 
 class ESP8266WiFiClass : public ESP8266WiFiGenericClass, public ESP8266WiFiSTAClass, public ESP8266WiFiScanClass, public ESP8266WiFiAPClass {
     public:
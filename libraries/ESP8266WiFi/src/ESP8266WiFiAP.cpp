@@ -38,6 +38,8 @@ extern "C" {
 #include <lwip/init.h> // LWIP_VERSION_*
 }
 
+#include <lwip/prot/ethernet.h>
+
 #include "debug.h"
 
 // -----------------------------------------------------------------------------------------------------------------------
@@ -313,6 +315,192 @@ uint8_t ESP8266WiFiAPClass::softAPgetStationNum() {
     return wifi_softap_get_station_num();
 }
 
+// -----------------------------------------------------------------------------------------------------------------------
+// ---------------------------------------------------- Station table ----------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+struct StationEntry
+{
+    bool used;
+    WiFiSoftAPStation station;
+    uint32_t seenIP;            // source address of the last IPv4 packet
+};
+
+constexpr size_t stationTableSize = 8; // maximum max_connection of softAP()
+
+struct StationTable
+{
+    bool enabled = false;
+    bool chained = false;       // _station_capture() is in the phy_capture chain
+    uint8_t last = 0;           // entry of the last frame, looked up first
+    void (*capture)(int netif_idx, const char* data, size_t len, int out, int success) = nullptr;
+    StationEntry entries[stationTableSize] { };
+};
+
+StationTable stationTable;
+
+} // anonymous namespace
+
+static StationEntry* _station_find(const uint8_t* mac, bool create) {
+    StationEntry& last = stationTable.entries[stationTable.last];
+    if (last.used && memcmp(last.station.mac, mac, 6) == 0) {
+        return &last;
+    }
+
+    StationEntry* empty = nullptr;
+    for (size_t i = 0; i < stationTableSize; i++) {
+        StationEntry& entry = stationTable.entries[i];
+        if (entry.used && memcmp(entry.station.mac, mac, 6) == 0) {
+            stationTable.last = i;
+            return &entry;
+        }
+        if (!entry.used && !empty) {
+            empty = &entry;
+        }
+    }
+
+    if (!create || !empty) {
+        return nullptr;
+    }
+    *empty = { };
+    empty->used = true;
+    memcpy(empty->station.mac, mac, 6);
+    empty->station.lastSeenMs = millis();
+    return empty;
+}
+
+// every frame of the WiFi interfaces goes through phy_capture, which we chain
+static void _station_capture(int netif_idx, const char* data, size_t len, int out, int success) {
+    if (stationTable.enabled && netif_idx == SOFTAP_IF && len >= SIZEOF_ETH_HDR) {
+        auto* eth = reinterpret_cast<const eth_hdr*>(data);
+        if (!out) {
+            // frames from unknown stations also create their entry, they may have connected before the table was enabled
+            if (!(eth->src.addr[0] & 1)) {
+                if (StationEntry* entry = _station_find(eth->src.addr, true)) {
+                    entry->station.rxBytes += len;
+                    entry->station.rxPackets++;
+                    entry->station.lastSeenMs = millis();
+                    if (eth->type == PP_HTONS(ETHTYPE_IP) && len >= SIZEOF_ETH_HDR + 16) {
+                        memcpy(&entry->seenIP, data + SIZEOF_ETH_HDR + 12, 4);
+                    }
+                }
+            }
+        } else if (success) {
+            if (StationEntry* entry = _station_find(eth->dest.addr, false)) {
+                entry->station.txBytes += len;
+                entry->station.txPackets++;
+            }
+        }
+    }
+    if (stationTable.capture) {
+        stationTable.capture(netif_idx, data, len, out, success);
+    }
+}
+
+static void _station_hook() {
+    if (!stationTable.chained) {
+        stationTable.capture = phy_capture;
+        phy_capture = _station_capture;
+        stationTable.chained = true;
+    }
+}
+
+// when another capture was chained after ours, ours stays in the chain, disabled
+static void _station_unhook() {
+    if (phy_capture == _station_capture) {
+        phy_capture = stationTable.capture;
+        stationTable.chained = false;
+    }
+}
+
+static void _station_connected(const WiFiEventSoftAPModeStationConnected& event, void*) {
+    if (StationEntry* entry = _station_find(event.mac, true)) {
+        // counters start again on each association
+        *entry = { };
+        entry->used = true;
+        memcpy(entry->station.mac, event.mac, 6);
+        entry->station.lastSeenMs = millis();
+    }
+}
+
+static void _station_disconnected(const WiFiEventSoftAPModeStationDisconnected& event, void*) {
+    if (StationEntry* entry = _station_find(event.mac, false)) {
+        entry->used = false;
+    }
+}
+
+static void _station_probe(const WiFiEventSoftAPModeProbeRequestReceived& event, void*) {
+    if (StationEntry* entry = _station_find(event.mac, false)) {
+        entry->station.rssi = event.rssi;
+    }
+}
+
+/**
+ * Keep traffic counters for the stations connected to the soft-AP.
+ * @param enable bool
+ * @return false when the event handlers cannot be added
+ */
+bool ESP8266WiFiAPClass::softAPStationTable(bool enable) {
+    if (enable == stationTable.enabled) {
+        return true;
+    }
+
+    if (!enable) {
+        stationTable.enabled = false;
+        _station_unhook();
+        WiFi.removeEventHandler(_station_connected);
+        WiFi.removeEventHandler(_station_disconnected);
+        WiFi.removeEventHandler(_station_probe);
+        return true;
+    }
+
+    if (!WiFi.addEventHandler(_station_connected)
+        || !WiFi.addEventHandler(_station_disconnected)
+        || !WiFi.addEventHandler(_station_probe)) {
+        WiFi.removeEventHandler(_station_connected);
+        WiFi.removeEventHandler(_station_disconnected);
+        DEBUG_WIFI("[AP] station table: no room for the event handlers\n");
+        return false;
+    }
+
+    for (auto& entry: stationTable.entries) {
+        entry.used = false;
+    }
+    stationTable.enabled = true;
+    _station_hook();
+    return true;
+}
+
+/**
+ * Copy the station table.
+ * @param stations WiFiSoftAPStation*
+ * @param capacity size_t
+ * @return number of stations copied
+ */
+size_t ESP8266WiFiAPClass::softAPgetStations(WiFiSoftAPStation* stations, size_t capacity) {
+    size_t count = 0;
+    if (!stationTable.enabled) {
+        return 0;
+    }
+
+    for (auto& entry: stationTable.entries) {
+        if (!entry.used || count == capacity) {
+            continue;
+        }
+        stations[count] = entry.station;
+        ip4_addr_t ip;
+        if (softAPDhcpServer().get_dhcps_lease_ip(entry.station.mac, &ip)) {
+            stations[count].ip = ip.addr;
+        } else {
+            stations[count].ip = entry.seenIP;
+        }
+        count++;
+    }
+    return count;
+}
+
 /**
  * Get the softAP interface IP address.
  * @return IPAddress softAP IP
@@ -29,6 +29,18 @@
 
 #include <LwipDhcpServer.h>
 
+struct WiFiSoftAPStation
+{
+    uint8_t mac[6];
+    IPAddress ip;           // leased by the DHCP server, or else the last IPv4 source address seen
+    int8_t rssi;            // of the last probe request, 0 when none was received
+    uint32_t rxBytes;       // frames received from the station
+    uint32_t rxPackets;
+    uint32_t txBytes;       // unicast frames sent to the station
+    uint32_t txPackets;
+    uint32_t lastSeenMs;    // millis() of the last frame received from the station
+};
+
 class ESP8266WiFiAPClass {
 
         // ----------------------------------------------------------------------------------------------
@@ -44,6 +56,12 @@ class ESP8266WiFiAPClass {
 
         uint8_t softAPgetStationNum();
 
+        // Station table: counters of the traffic with each station connected
+        // to the soft-AP, kept from the soft-AP interface while enabled
+        static bool softAPStationTable(bool enable);
+        // copies up to `capacity` stations, returns the number copied
+        static size_t softAPgetStations(WiFiSoftAPStation* stations, size_t capacity);
+
         IPAddress softAPIP();
 
         uint8_t* softAPmacAddress(uint8_t* mac);
@@ -29,6 +29,7 @@
 
 #include <coredecls.h>
 #include <PolledTimeout.h>
+#include <Schedule.h>
 #include "ESP8266WiFi.h"
 #include "ESP8266WiFiGeneric.h"
 
@@ -51,6 +52,7 @@ extern "C" {
 #include "WiFiUdp.h"
 #include "debug.h"
 #include "include/WiFiState.h"
+#include "include/NetworkActivity.h"
 
 // see comments on wifi_station_hostname in LwipIntf.cpp
 extern "C" char* wifi_station_hostname; // sdk's hostname location
@@ -85,6 +87,136 @@ struct WiFiEventHandlerOpaque
 
 static std::list<WiFiEventHandler> sCbEventList;
 
+namespace {
+
+// slot of the static handler table, fn has the type the handler was added with
+struct WiFiEventTableEntry
+{
+    void (*fn)();
+    void* context;
+    WiFiEvent_t event;
+    bool raw; // fn is void (*)(WiFiEvent_t, void*)
+};
+
+WiFiEventTableEntry sEventTable[WIFI_EVENT_HANDLERS_MAX];
+
+// stands for the events without information (DHCP timeout)
+struct WiFiEventNoInfo { };
+
+} // anonymous namespace
+
+// SDK event to Arduino event, shared by the handler table and the on*() handlers
+
+static void _decode_event(const System_Event_t& e, WiFiEventStationModeConnected& dst)
+{
+    auto& src = e.event_info.connected;
+    dst.ssid.concat(reinterpret_cast<const char*>(src.ssid), src.ssid_len);
+    memcpy(dst.bssid, src.bssid, 6);
+    dst.channel = src.channel;
+}
+
+static void _decode_event(const System_Event_t& e, WiFiEventStationModeDisconnected& dst)
+{
+    auto& src = e.event_info.disconnected;
+    dst.ssid.concat(reinterpret_cast<const char*>(src.ssid), src.ssid_len);
+    memcpy(dst.bssid, src.bssid, 6);
+    dst.reason = static_cast<WiFiDisconnectReason>(src.reason);
+}
+
+static void _decode_event(const System_Event_t& e, WiFiEventStationModeAuthModeChanged& dst)
+{
+    auto& src = e.event_info.auth_change;
+    dst.oldMode = src.old_mode;
+    dst.newMode = src.new_mode;
+}
+
+static void _decode_event(const System_Event_t& e, WiFiEventStationModeGotIP& dst)
+{
+    auto& src = e.event_info.got_ip;
+    dst.ip = src.ip.addr;
+    dst.mask = src.mask.addr;
+    dst.gw = src.gw.addr;
+}
+
+static void _decode_event(const System_Event_t& e, WiFiEventSoftAPModeStationConnected& dst)
+{
+    auto& src = e.event_info.sta_connected;
+    memcpy(dst.mac, src.mac, 6);
+    dst.aid = src.aid;
+}
+
+static void _decode_event(const System_Event_t& e, WiFiEventSoftAPModeStationDisconnected& dst)
+{
+    auto& src = e.event_info.sta_disconnected;
+    memcpy(dst.mac, src.mac, 6);
+    dst.aid = src.aid;
+}
+
+static void _decode_event(const System_Event_t& e, WiFiEventSoftAPModeProbeRequestReceived& dst)
+{
+    auto& src = e.event_info.ap_probereqrecved;
+    memcpy(dst.mac, src.mac, 6);
+    dst.rssi = src.rssi;
+}
+
+static void _decode_event(const System_Event_t& e, WiFiEventModeChange& dst)
+{
+    auto& src = e.event_info.opmode_changed;
+    dst.oldMode = (WiFiMode_t)src.old_opmode;
+    dst.newMode = (WiFiMode_t)src.new_opmode;
+}
+
+static void _decode_event(const System_Event_t&, WiFiEventNoInfo&)
+{
+}
+
+template <typename Event>
+static void _call_event_handler(const WiFiEventTableEntry& entry, const Event& event)
+{
+    reinterpret_cast<ESP8266WiFiGenericClass::WiFiEventFn<Event>>(entry.fn)(event, entry.context);
+}
+
+static void _call_event_handler(const WiFiEventTableEntry& entry, const WiFiEventNoInfo&)
+{
+    reinterpret_cast<void (*)(void*)>(entry.fn)(entry.context);
+}
+
+// single pass over the table, the event is converted once when a typed handler wants it
+template <typename Event>
+static void _dispatch_event_table(const System_Event_t& e)
+{
+    WiFiEvent_t id = static_cast<WiFiEvent_t>(e.event);
+    Event event;
+    bool decoded = false;
+
+    for (const auto& entry: sEventTable) {
+        if (!entry.fn || (entry.event != id && entry.event != WIFI_EVENT_ANY)) {
+            continue;
+        }
+        if (entry.raw) {
+            reinterpret_cast<void (*)(WiFiEvent_t, void*)>(entry.fn)(id, entry.context);
+            continue;
+        }
+        if (!decoded) {
+            _decode_event(e, event);
+            decoded = true;
+        }
+        _call_event_handler(entry, event);
+    }
+}
+
+static bool _add_event_handler(WiFiEvent_t event, void (*fn)(), void* context, bool raw)
+{
+    for (auto& entry: sEventTable) {
+        if (!entry.fn) {
+            entry = { fn, context, event, raw };
+            return true;
+        }
+    }
+    DEBUG_WIFI_GENERIC("event handler table full, see WIFI_EVENT_HANDLERS_MAX\n");
+    return false;
+}
+
 bool ESP8266WiFiGenericClass::_persistent = false;
 WiFiMode_t ESP8266WiFiGenericClass::_forceSleepLastMode = WIFI_OFF;
 
@@ -102,59 +234,36 @@ void ESP8266WiFiGenericClass::onEvent(WiFiEventCb f, WiFiEvent_t event)
     sCbEventList.push_back(handler);
 }
 
-WiFiEventHandler ESP8266WiFiGenericClass::onStationModeConnected(std::function<void(const WiFiEventStationModeConnected&)> f)
+template <typename Event>
+static WiFiEventHandler _make_event_handler(WiFiEvent_t event, std::function<void(const Event&)>&& f)
 {
-    WiFiEventHandler handler = std::make_shared<WiFiEventHandlerOpaque>(WIFI_EVENT_STAMODE_CONNECTED, [f](System_Event_t* e) {
-        auto& src = e->event_info.connected;
-        WiFiEventStationModeConnected dst;
-        dst.ssid.concat(reinterpret_cast<char*>(src.ssid), src.ssid_len);
-        memcpy(dst.bssid, src.bssid, 6);
-        dst.channel = src.channel;
+    WiFiEventHandler handler = std::make_shared<WiFiEventHandlerOpaque>(event, [f = std::move(f)](System_Event_t* e) {
+        Event dst;
+        _decode_event(*e, dst);
         f(dst);
     });
     sCbEventList.push_back(handler);
     return handler;
 }
 
+WiFiEventHandler ESP8266WiFiGenericClass::onStationModeConnected(std::function<void(const WiFiEventStationModeConnected&)> f)
+{
+    return _make_event_handler(WIFI_EVENT_STAMODE_CONNECTED, std::move(f));
+}
+
 WiFiEventHandler ESP8266WiFiGenericClass::onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected&)> f)
 {
-    WiFiEventHandler handler = std::make_shared<WiFiEventHandlerOpaque>(WIFI_EVENT_STAMODE_DISCONNECTED, [f](System_Event_t* e){
-        auto& src = e->event_info.disconnected;
-        WiFiEventStationModeDisconnected dst;
-        dst.ssid.concat(reinterpret_cast<char*>(src.ssid), src.ssid_len);
-        memcpy(dst.bssid, src.bssid, 6);
-        dst.reason = static_cast<WiFiDisconnectReason>(src.reason);
-        f(dst);
-    });
-    sCbEventList.push_back(handler);
-    return handler;
+    return _make_event_handler(WIFI_EVENT_STAMODE_DISCONNECTED, std::move(f));
 }
 
 WiFiEventHandler ESP8266WiFiGenericClass::onStationModeAuthModeChanged(std::function<void(const WiFiEventStationModeAuthModeChanged&)> f)
 {
-    WiFiEventHandler handler = std::make_shared<WiFiEventHandlerOpaque>(WIFI_EVENT_STAMODE_AUTHMODE_CHANGE, [f](System_Event_t* e){
-        auto& src = e->event_info.auth_change;
-        WiFiEventStationModeAuthModeChanged dst;
-        dst.oldMode = src.old_mode;
-        dst.newMode = src.new_mode;
-        f(dst);
-    });
-    sCbEventList.push_back(handler);
-    return handler;
+    return _make_event_handler(WIFI_EVENT_STAMODE_AUTHMODE_CHANGE, std::move(f));
 }
 
 WiFiEventHandler ESP8266WiFiGenericClass::onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)> f)
 {
-    WiFiEventHandler handler = std::make_shared<WiFiEventHandlerOpaque>(WIFI_EVENT_STAMODE_GOT_IP, [f](System_Event_t* e){
-        auto& src = e->event_info.got_ip;
-        WiFiEventStationModeGotIP dst;
-        dst.ip = src.ip.addr;
-        dst.mask = src.mask.addr;
-        dst.gw = src.gw.addr;
-        f(dst);
-    });
-    sCbEventList.push_back(handler);
-    return handler;
+    return _make_event_handler(WIFI_EVENT_STAMODE_GOT_IP, std::move(f));
 }
 
 WiFiEventHandler ESP8266WiFiGenericClass::onStationModeDHCPTimeout(std::function<void(void)> f)
@@ -169,54 +278,81 @@ WiFiEventHandler ESP8266WiFiGenericClass::onStationModeDHCPTimeout(std::function
 
 WiFiEventHandler ESP8266WiFiGenericClass::onSoftAPModeStationConnected(std::function<void(const WiFiEventSoftAPModeStationConnected&)> f)
 {
-    WiFiEventHandler handler = std::make_shared<WiFiEventHandlerOpaque>(WIFI_EVENT_SOFTAPMODE_STACONNECTED, [f](System_Event_t* e){
-        auto& src = e->event_info.sta_connected;
-        WiFiEventSoftAPModeStationConnected dst;
-        memcpy(dst.mac, src.mac, 6);
-        dst.aid = src.aid;
-        f(dst);
-    });
-    sCbEventList.push_back(handler);
-    return handler;
+    return _make_event_handler(WIFI_EVENT_SOFTAPMODE_STACONNECTED, std::move(f));
 }
 
 WiFiEventHandler ESP8266WiFiGenericClass::onSoftAPModeStationDisconnected(std::function<void(const WiFiEventSoftAPModeStationDisconnected&)> f)
 {
-    WiFiEventHandler handler = std::make_shared<WiFiEventHandlerOpaque>(WIFI_EVENT_SOFTAPMODE_STADISCONNECTED, [f](System_Event_t* e){
-        auto& src = e->event_info.sta_disconnected;
-        WiFiEventSoftAPModeStationDisconnected dst;
-        memcpy(dst.mac, src.mac, 6);
-        dst.aid = src.aid;
-        f(dst);
-    });
-    sCbEventList.push_back(handler);
-    return handler;
+    return _make_event_handler(WIFI_EVENT_SOFTAPMODE_STADISCONNECTED, std::move(f));
 }
 
 WiFiEventHandler ESP8266WiFiGenericClass::onSoftAPModeProbeRequestReceived(std::function<void(const WiFiEventSoftAPModeProbeRequestReceived&)> f)
 {
-    WiFiEventHandler handler = std::make_shared<WiFiEventHandlerOpaque>(WIFI_EVENT_SOFTAPMODE_PROBEREQRECVED, [f](System_Event_t* e){
-        auto& src = e->event_info.ap_probereqrecved;
-        WiFiEventSoftAPModeProbeRequestReceived dst;
-        memcpy(dst.mac, src.mac, 6);
-        dst.rssi = src.rssi;
-        f(dst);
-    });
-    sCbEventList.push_back(handler);
-    return handler;
+    return _make_event_handler(WIFI_EVENT_SOFTAPMODE_PROBEREQRECVED, std::move(f));
 }
 
 WiFiEventHandler ESP8266WiFiGenericClass::onWiFiModeChange(std::function<void(const WiFiEventModeChange&)> f)
 {
-    WiFiEventHandler handler = std::make_shared<WiFiEventHandlerOpaque>(WIFI_EVENT_MODE_CHANGE, [f](System_Event_t* e){
-        auto& src = e->event_info.opmode_changed;
-        WiFiEventModeChange dst;
-        dst.oldMode = (WiFiMode_t)src.old_opmode;
-        dst.newMode = (WiFiMode_t)src.new_opmode;
-        f(dst);
-    });
-    sCbEventList.push_back(handler);
-    return handler;
+    return _make_event_handler(WIFI_EVENT_MODE_CHANGE, std::move(f));
+}
+
+bool ESP8266WiFiGenericClass::addEventHandler(WiFiEventFn<WiFiEventStationModeConnected> f, void* context)
+{
+    return _add_event_handler(WIFI_EVENT_STAMODE_CONNECTED, reinterpret_cast<void (*)()>(f), context, false);
+}
+
+bool ESP8266WiFiGenericClass::addEventHandler(WiFiEventFn<WiFiEventStationModeDisconnected> f, void* context)
+{
+    return _add_event_handler(WIFI_EVENT_STAMODE_DISCONNECTED, reinterpret_cast<void (*)()>(f), context, false);
+}
+
+bool ESP8266WiFiGenericClass::addEventHandler(WiFiEventFn<WiFiEventStationModeAuthModeChanged> f, void* context)
+{
+    return _add_event_handler(WIFI_EVENT_STAMODE_AUTHMODE_CHANGE, reinterpret_cast<void (*)()>(f), context, false);
+}
+
+bool ESP8266WiFiGenericClass::addEventHandler(WiFiEventFn<WiFiEventStationModeGotIP> f, void* context)
+{
+    return _add_event_handler(WIFI_EVENT_STAMODE_GOT_IP, reinterpret_cast<void (*)()>(f), context, false);
+}
+
+bool ESP8266WiFiGenericClass::addEventHandler(void (*f)(void* context), void* context)
+{
+    return _add_event_handler(WIFI_EVENT_STAMODE_DHCP_TIMEOUT, reinterpret_cast<void (*)()>(f), context, false);
+}
+
+bool ESP8266WiFiGenericClass::addEventHandler(WiFiEventFn<WiFiEventSoftAPModeStationConnected> f, void* context)
+{
+    return _add_event_handler(WIFI_EVENT_SOFTAPMODE_STACONNECTED, reinterpret_cast<void (*)()>(f), context, false);
+}
+
+bool ESP8266WiFiGenericClass::addEventHandler(WiFiEventFn<WiFiEventSoftAPModeStationDisconnected> f, void* context)
+{
+    return _add_event_handler(WIFI_EVENT_SOFTAPMODE_STADISCONNECTED, reinterpret_cast<void (*)()>(f), context, false);
+}
+
+bool ESP8266WiFiGenericClass::addEventHandler(WiFiEventFn<WiFiEventSoftAPModeProbeRequestReceived> f, void* context)
+{
+    return _add_event_handler(WIFI_EVENT_SOFTAPMODE_PROBEREQRECVED, reinterpret_cast<void (*)()>(f), context, false);
+}
+
+bool ESP8266WiFiGenericClass::addEventHandler(WiFiEventFn<WiFiEventModeChange> f, void* context)
+{
+    return _add_event_handler(WIFI_EVENT_MODE_CHANGE, reinterpret_cast<void (*)()>(f), context, false);
+}
+
+bool ESP8266WiFiGenericClass::addEventHandler(void (*f)(WiFiEvent_t event, void* context), void* context, WiFiEvent_t event)
+{
+    return _add_event_handler(event, reinterpret_cast<void (*)()>(f), context, true);
+}
+
+void ESP8266WiFiGenericClass::_removeEventHandler(void (*f)(), void* context)
+{
+    for (auto& entry: sEventTable) {
+        if (entry.fn == f && entry.context == context) {
+            entry.fn = nullptr;
+        }
+    }
 }
 
 /**
@@ -248,6 +384,37 @@ void ESP8266WiFiGenericClass::_eventCallback(void* arg)
         }
     }
 
+    switch (static_cast<WiFiEvent_t>(event->event)) {
+    case WIFI_EVENT_STAMODE_CONNECTED:
+        _dispatch_event_table<WiFiEventStationModeConnected>(*event);
+        break;
+    case WIFI_EVENT_STAMODE_DISCONNECTED:
+        _dispatch_event_table<WiFiEventStationModeDisconnected>(*event);
+        break;
+    case WIFI_EVENT_STAMODE_AUTHMODE_CHANGE:
+        _dispatch_event_table<WiFiEventStationModeAuthModeChanged>(*event);
+        break;
+    case WIFI_EVENT_STAMODE_GOT_IP:
+        _dispatch_event_table<WiFiEventStationModeGotIP>(*event);
+        break;
+    case WIFI_EVENT_SOFTAPMODE_STACONNECTED:
+        _dispatch_event_table<WiFiEventSoftAPModeStationConnected>(*event);
+        break;
+    case WIFI_EVENT_SOFTAPMODE_STADISCONNECTED:
+        _dispatch_event_table<WiFiEventSoftAPModeStationDisconnected>(*event);
+        break;
+    case WIFI_EVENT_SOFTAPMODE_PROBEREQRECVED:
+        _dispatch_event_table<WiFiEventSoftAPModeProbeRequestReceived>(*event);
+        break;
+    case WIFI_EVENT_MODE_CHANGE:
+        _dispatch_event_table<WiFiEventModeChange>(*event);
+        break;
+    default:
+        // DHCP timeout, and events only the raw handlers get
+        _dispatch_event_table<WiFiEventNoInfo>(*event);
+        break;
+    }
+
     for(auto it = std::begin(sCbEventList); it != std::end(sCbEventList); ) {
         WiFiEventHandler &handler = *it;
         if (handler->canExpire() && handler.unique()) {
@@ -275,6 +442,8 @@ uint8_t ESP8266WiFiGenericClass::channel(void) {
  */
 bool ESP8266WiFiGenericClass::setSleepMode(WiFiSleepType_t type, uint8_t listenInterval) {
 
+    setSleepPolicy(false);
+
    /**
     * datasheet:
     *
@@ -356,6 +525,124 @@ WiFiSleepType_t ESP8266WiFiGenericClass::getSleepMode() {
     return (WiFiSleepType_t) wifi_get_sleep_type();
 }
 
+uint32_t esp8266::network::lastActivityMs = 0;
+
+namespace {
+
+struct SleepPolicy
+{
+    bool enabled = false;
+    bool scheduled = false;
+    uint32_t idleMs = 0;
+    uint32_t lightIdleMs = 0;
+    uint32_t lastMs = 0;            // last time the stats were updated
+    WiFiSleepPolicyStats stats { };
+};
+
+SleepPolicy sleepPolicy;
+
+constexpr uint32_t sleepPolicyPeriodUs = 100000;
+
+} // anonymous namespace
+
+static void _sleep_policy_account() {
+    uint32_t now = millis();
+    uint32_t elapsed = now - sleepPolicy.lastMs;
+    sleepPolicy.lastMs = now;
+
+    switch (wifi_get_sleep_type()) {
+    case NONE_SLEEP_T:
+        sleepPolicy.stats.noneMs += elapsed;
+        break;
+    case MODEM_SLEEP_T:
+        sleepPolicy.stats.modemMs += elapsed;
+        break;
+    case LIGHT_SLEEP_T:
+        sleepPolicy.stats.lightMs += elapsed;
+        break;
+    }
+}
+
+static bool _sleep_policy_evaluate() {
+    if (!sleepPolicy.enabled) {
+        sleepPolicy.scheduled = false;
+        return false;
+    }
+
+    _sleep_policy_account();
+
+    uint32_t idle = millis() - esp8266::network::lastActivityMs;
+    sleep_type_t type = NONE_SLEEP_T;
+    if (idle >= sleepPolicy.idleMs) {
+        type = MODEM_SLEEP_T;
+        // light sleep would delay the recurrent functions needing a finer timing than ours
+        if (sleepPolicy.lightIdleMs && idle >= sleepPolicy.lightIdleMs
+            && compute_scheduled_recurrent_grain() >= sleepPolicyPeriodUs / 1000) {
+            type = LIGHT_SLEEP_T;
+        }
+    }
+
+    if (type != wifi_get_sleep_type()) {
+        // wifi_set_sleep_type() keeps the sleep level and listen interval set by setSleepMode()
+        if (wifi_set_sleep_type(type)) {
+            ++sleepPolicy.stats.switches;
+        } else {
+            DEBUG_WIFI_GENERIC("wifi_set_sleep_type(%d): error\n", (int)type);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Let the sleep mode follow the network traffic
+ * @param enable bool
+ * @param idleMs no sleep until TCP/UDP data has not been seen for this time
+ * @param lightIdleMs light sleep after this time without TCP/UDP data, 0 for modem sleep only
+ * @return bool
+ */
+bool ESP8266WiFiGenericClass::setSleepPolicy(bool enable, uint32_t idleMs, uint32_t lightIdleMs) {
+    if (!enable) {
+        if (sleepPolicy.enabled) {
+            _sleep_policy_account();
+        }
+        sleepPolicy.enabled = false;
+        return true;
+    }
+
+    if (lightIdleMs && lightIdleMs < idleMs) {
+        DEBUG_WIFI_GENERIC("setSleepPolicy: lightIdleMs must not be below idleMs\n");
+        return false;
+    }
+
+    if (!sleepPolicy.scheduled) {
+        if (!schedule_recurrent_function_us(_sleep_policy_evaluate, sleepPolicyPeriodUs)) {
+            return false;
+        }
+        sleepPolicy.scheduled = true;
+    }
+
+    if (!sleepPolicy.enabled) {
+        sleepPolicy.lastMs = millis();
+    }
+    sleepPolicy.enabled = true;
+    sleepPolicy.idleMs = idleMs;
+    sleepPolicy.lightIdleMs = lightIdleMs;
+    return true;
+}
+
+const WiFiSleepPolicyStats& ESP8266WiFiGenericClass::getSleepPolicyStats() {
+    if (sleepPolicy.enabled) {
+        _sleep_policy_account();
+    }
+    return sleepPolicy.stats;
+}
+
+void ESP8266WiFiGenericClass::resetSleepPolicyStats() {
+    sleepPolicy.stats = { };
+    sleepPolicy.lastMs = millis();
+}
+
 /**
  * set phy Mode
  * @param mode phy_mode_t
@@ -608,12 +895,204 @@ struct _dns_found_result {
 
 static void _dns_found_callback(const char *, const ip_addr_t *, void *);
 
+#ifndef DNS_CACHE_ENTRIES
+#define DNS_CACHE_ENTRIES 0 // hostByName() results cached by default
+#endif
+
+namespace {
+
+struct _dns_cache_entry {
+    std::unique_ptr<char[]> name;
+    IPAddress addr;
+    uint32_t stored;    // millis()
+    uint32_t used;      // for least recently used
+    uint8_t type;
+    bool refreshing;
+};
+
+struct _dns_cache {
+    std::unique_ptr<_dns_cache_entry[]> entries;
+    size_t size;
+    uint32_t ttl_ms;
+    uint32_t clock;
+    uint32_t generation; // refreshes started before a clear are ignored
+};
+
+_dns_cache dnsCache = {
+    .entries = nullptr,
+    .size = DNS_CACHE_ENTRIES,
+    .ttl_ms = DNSCacheDefaultTTLMs,
+    .clock = 0,
+    .generation = 0,
+};
+
+}
+
+static _dns_cache_entry* _dns_cache_find(const char* name, uint8_t type) {
+    for (size_t i = 0; dnsCache.entries && i < dnsCache.size; i++) {
+        _dns_cache_entry& entry = dnsCache.entries[i];
+        if (entry.name && entry.type == type && strcasecmp(entry.name.get(), name) == 0) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+static void _dns_cache_store(const char* name, uint8_t type, const IPAddress& addr) {
+    if (!dnsCache.size) {
+        return;
+    }
+    if (!dnsCache.entries) {
+        dnsCache.entries.reset(new (std::nothrow) _dns_cache_entry[dnsCache.size]);
+        if (!dnsCache.entries) {
+            return;
+        }
+    }
+
+    // the entry of the name, else an empty one, else the least recently used
+    _dns_cache_entry* entry = _dns_cache_find(name, type);
+    for (size_t i = 0; !entry && i < dnsCache.size; i++) {
+        if (!dnsCache.entries[i].name) {
+            entry = &dnsCache.entries[i];
+        }
+    }
+    if (!entry) {
+        entry = &dnsCache.entries[0];
+        for (size_t i = 1; i < dnsCache.size; i++) {
+            if (dnsCache.clock - dnsCache.entries[i].used > dnsCache.clock - entry->used) {
+                entry = &dnsCache.entries[i];
+            }
+        }
+    }
+    if (!entry->name || strcmp(entry->name.get(), name) != 0) {
+        size_t length = strlen(name) + 1;
+        entry->name.reset(new (std::nothrow) char[length]);
+        if (!entry->name) {
+            return;
+        }
+        memcpy(entry->name.get(), name, length);
+        entry->refreshing = false;
+    }
+    entry->addr = addr;
+    entry->type = type;
+    entry->stored = millis();
+    entry->used = ++dnsCache.clock;
+}
+
+// The arg of a refresh tells the cache generation and the address type
+static void _dns_cache_refresh_callback(const char* name, const ip_addr_t* ipaddr, void* arg) {
+    uint32_t tag = reinterpret_cast<uintptr_t>(arg);
+    if ((tag >> 8) != (dnsCache.generation & 0xffffff)) {
+        return;
+    }
+    _dns_cache_entry* entry = _dns_cache_find(name, tag & 0xff);
+    if (entry) {
+        entry->refreshing = false;
+        if (ipaddr) {
+            entry->addr = IPAddress(ipaddr);
+            entry->stored = millis();
+        }
+    }
+}
+
+// A cached address, refreshed in the background when close to expiring
+static _dns_cache_entry* _dns_cache_lookup(const char* name, uint8_t type) {
+    _dns_cache_entry* entry = _dns_cache_find(name, type);
+    if (!entry) {
+        return nullptr;
+    }
+    uint32_t age = (uint32_t)millis() - entry->stored;
+    if (age >= dnsCache.ttl_ms) {
+        return nullptr;
+    }
+    if (!entry->refreshing && age >= dnsCache.ttl_ms - dnsCache.ttl_ms / 4) {
+        ip_addr_t addr;
+        uintptr_t tag = ((dnsCache.generation & 0xffffff) << 8) | type;
+        err_t err = dns_gethostbyname_addrtype(entry->name.get(), &addr,
+            &_dns_cache_refresh_callback, reinterpret_cast<void*>(tag), type);
+        if (err == ERR_OK) {
+            entry->addr = addr;
+            entry->stored = millis();
+        } else if (err == ERR_INPROGRESS) {
+            entry->refreshing = true;
+        }
+    }
+    entry->used = ++dnsCache.clock;
+    return entry;
+}
+
+// The most recently used IPv4 entries are kept over a shutdown
+static void _dns_cache_save(WiFiState& state) {
+    for (auto& saved: state.state.dnsCache) {
+        saved.name[0] = 0;
+        saved.addr = 0;
+        saved.ageMs = 0;
+
+        _dns_cache_entry* best = nullptr;
+        for (size_t i = 0; dnsCache.entries && i < dnsCache.size; i++) {
+            _dns_cache_entry& entry = dnsCache.entries[i];
+            bool taken = false;
+            for (const auto& other: state.state.dnsCache) {
+                taken |= entry.name && other.addr && strcmp(other.name, entry.name.get()) == 0;
+            }
+            if (!taken && entry.name && entry.addr.isV4() && entry.type == LWIP_DNS_ADDRTYPE_IPV4
+                && strlen(entry.name.get()) < sizeof(saved.name)
+                && (uint32_t)millis() - entry.stored < dnsCache.ttl_ms
+                && (!best || dnsCache.clock - entry.used < dnsCache.clock - best->used)) {
+                best = &entry;
+            }
+        }
+        if (best) {
+            strcpy(saved.name, best->name.get());
+            saved.addr = best->addr.v4();
+            saved.ageMs = (uint32_t)millis() - best->stored;
+        }
+    }
+}
+
+static void _dns_cache_restore(const WiFiState& state, uint32_t sleptMs) {
+    for (const auto& saved: state.state.dnsCache) {
+        if (saved.addr && saved.ageMs + sleptMs < dnsCache.ttl_ms) {
+            _dns_cache_store(saved.name, LWIP_DNS_ADDRTYPE_IPV4, IPAddress(saved.addr));
+            _dns_cache_entry* entry = _dns_cache_find(saved.name, LWIP_DNS_ADDRTYPE_IPV4);
+            if (entry) {
+                entry->stored = millis() - saved.ageMs - sleptMs;
+            }
+        }
+    }
+}
+
+bool ESP8266WiFiGenericClass::setDNSCache(size_t entries, uint32_t ttl_ms) {
+    clearDNSCache();
+    dnsCache.size = ttl_ms ? entries : 0;
+    dnsCache.ttl_ms = ttl_ms;
+    if (dnsCache.size) {
+        dnsCache.entries.reset(new (std::nothrow) _dns_cache_entry[dnsCache.size]);
+        if (!dnsCache.entries) {
+            dnsCache.size = 0;
+            return false;
+        }
+    }
+    return true;
+}
+
+void ESP8266WiFiGenericClass::clearDNSCache() {
+    dnsCache.entries = nullptr;
+    ++dnsCache.generation;
+}
+
 static int hostByNameImpl(const char* aHostname, IPAddress& aResult, uint32_t timeout_ms, DNSResolveType resolveType) {
     if (aResult.fromString(aHostname)) {
         DEBUG_WIFI_GENERIC("[hostByName] Host: %s is IP!\n", aHostname);
         return 1;
     }
 
+    if (auto cached = _dns_cache_lookup(aHostname, static_cast<uint8_t>(resolveType))) {
+        aResult = cached->addr;
+        DEBUG_WIFI_GENERIC("[hostByName] Host: %s IP: %s (cached)\n", aHostname, aResult.toString().c_str());
+        return 1;
+    }
+
     static_assert(std::is_same_v<uint8_t, std::underlying_type_t<decltype(resolveType)>>, "");
     DEBUG_WIFI_GENERIC("[hostByName] request IP for: %s\n", aHostname);
 
@@ -659,6 +1138,7 @@ static int hostByNameImpl(const char* aHostname, IPAddress& aResult, uint32_t ti
     }
 
     if (err == ERR_OK) {
+        _dns_cache_store(aHostname, static_cast<uint8_t>(resolveType), aResult);
         DEBUG_WIFI_GENERIC("[hostByName] Host: %s IP: %s\n", aHostname, aResult.toString().c_str());
         return 1;
     }
@@ -696,6 +1176,107 @@ int ESP8266WiFiGenericClass::hostByName(const char* aHostname, IPAddress& aResul
 }
 #endif
 
+namespace {
+
+struct _dns_async_lookup {
+    ESP8266WiFiGenericClass::HostByNameCallback callback;
+    esp8266::polledTimeout::oneShotMs timeout;
+    IPAddress addr;
+    uint8_t type;
+    bool pending;   // the lwIP callback is still to come
+    bool abandoned; // timed out, for the lwIP callback to delete
+};
+
+}
+
+static void _dns_async_callback(const char* name, const ip_addr_t* ipaddr, void* arg)
+{
+    auto lookup = reinterpret_cast<_dns_async_lookup*>(arg);
+    if (lookup->abandoned) {
+        delete lookup;
+        return;
+    }
+    if (ipaddr) {
+        lookup->addr = IPAddress(ipaddr);
+        _dns_cache_store(name, lookup->type, lookup->addr);
+    }
+    lookup->pending = false;
+}
+
+// Scheduled until the lookup is done or timed out, then calls back
+static bool _dns_async_poll(_dns_async_lookup* lookup)
+{
+    if (lookup->pending && !lookup->timeout) {
+        return true;
+    }
+    IPAddress addr = lookup->pending ? IPAddress() : lookup->addr;
+    auto callback = std::move(lookup->callback);
+    if (lookup->pending) {
+        lookup->abandoned = true;
+    } else {
+        delete lookup;
+    }
+    callback(addr);
+    return false;
+}
+
+/**
+ * Resolve the given hostname to an IP address without waiting.
+ * @param aHostname     Name to be resolved
+ * @param callback      called from the scheduler with the address, not set on failure
+ * @param timeout_ms    after which the callback is called with a failure
+ * @param resolveType   IPv4 and/or IPv6 addresses
+ * @return true if the lookup is started, else the callback is not called
+ */
+bool ESP8266WiFiGenericClass::hostByNameAsync(const char* aHostname, HostByNameCallback callback,
+        uint32_t timeout_ms, DNSResolveType resolveType)
+{
+    if (!callback) {
+        return false;
+    }
+
+    uint8_t type = static_cast<uint8_t>(resolveType);
+    auto lookup = std::make_unique<_dns_async_lookup>(
+        _dns_async_lookup{
+            .callback = std::move(callback),
+            .timeout = esp8266::polledTimeout::oneShotMs(timeout_ms),
+            .addr = IPAddress(),
+            .type = type,
+            .pending = false,
+            .abandoned = false,
+        });
+
+    if (lookup->addr.fromString(aHostname)) {
+        DEBUG_WIFI_GENERIC("[hostByNameAsync] Host: %s is IP!\n", aHostname);
+    } else if (auto cached = _dns_cache_lookup(aHostname, type)) {
+        lookup->addr = cached->addr;
+    } else {
+        ip_addr_t addr;
+        err_t err = dns_gethostbyname_addrtype(aHostname, &addr, &_dns_async_callback, lookup.get(), type);
+        if (err == ERR_OK) {
+            lookup->addr = addr;
+            _dns_cache_store(aHostname, type, lookup->addr);
+        } else if (err == ERR_INPROGRESS) {
+            lookup->pending = true;
+        } else {
+            DEBUG_WIFI_GENERIC("[hostByNameAsync] Host: %s lookup error: %d!\n", aHostname, static_cast<int>(err));
+            return false;
+        }
+    }
+
+    _dns_async_lookup* pending = lookup.release();
+    if (!schedule_recurrent_function_us([pending]() { return _dns_async_poll(pending); }, 1000)) {
+        DEBUG_WIFI_GENERIC("[hostByNameAsync] cannot schedule the callback\n");
+        if (pending->pending) {
+            pending->abandoned = true;
+        } else {
+            delete pending;
+        }
+        return false;
+    }
+    return true;
+}
+
 /**
  * DNS callback
  * @param name
@@ -749,6 +1330,21 @@ bool ESP8266WiFiGenericClass::shutdown (WiFiState& state, uint32 sleepUs)
             return false;
         }
         state.state.channel = wifi_get_channel();
+
+        // keep the time left until the DHCP lease has to be renewed, so that
+        // the address can be used again on resume without waiting for DHCP
+        extern netif netif_git[2];
+        netif* sta = &netif_git[STATION_IF];
+        const dhcp* lease = netif_dhcp_data(sta);
+        state.state.dhcp = wifi_station_dhcpc_status() == DHCP_STARTED;
+        state.state.dhcpRenewMs = 0;
+        if (state.state.dhcp && lease && dhcp_supplied_address(sta) && lease->t1_renew_time > 1)
+        {
+            // counted in DHCP_COARSE_TIMER_SECS, of which the current one may be almost over
+            state.state.dhcpRenewMs = (lease->t1_renew_time - 1) * DHCP_COARSE_TIMER_MSECS;
+        }
+        state.state.rtcTime = system_get_rtc_time();
+        state.state.rtcCalibration = system_rtc_clock_cali_proc();
     }
 
     // disable persistence in FW so in case of power failure
@@ -782,6 +1378,8 @@ bool ESP8266WiFiGenericClass::shutdown (WiFiState& state, uint32 sleepUs)
         dns = WiFi.dnsIP(i++);
     }
 
+    _dns_cache_save(state);
+
     state.crc = shutdownCRC(state);
     DEBUG_WIFI("core: state is saved\n");
 
@@ -815,8 +1413,28 @@ bool ESP8266WiFiGenericClass::resumeFromShutdown (WiFiState& state)
 
     if (state.state.mode & WIFI_STA)
     {
+        // the RTC keeps counting in deep sleep, its period is in us, Q12 fixed point
+        uint64_t sleptUs = ((uint64_t)(system_get_rtc_time() - state.state.rtcTime) * state.state.rtcCalibration) >> 12;
+        _dns_cache_restore(state, sleptUs / 1000);
+
         IPAddress local(state.state.ip.ip);
-        if (local)
+        bool reuseAddress = local.isSet();
+        uint32_t renewMs = 0;
+        if (reuseAddress && state.state.dhcp)
+        {
+            reuseAddress = sleptUs / 1000 < state.state.dhcpRenewMs;
+            if (reuseAddress)
+            {
+                renewMs = state.state.dhcpRenewMs - sleptUs / 1000;
+            }
+            else
+            {
+                DEBUG_WIFI("core: resume: DHCP lease to renew\n");
+                WiFi.config(0u, 0u, 0u);
+            }
+        }
+
+        if (reuseAddress)
         {
             DEBUG_WIFI("core: resume: static address '%s'\n", local.toString().c_str());
             WiFi.config(state.state.ip.ip, state.state.ip.gw, state.state.ip.netmask, state.state.dns[0], state.state.dns[1]);
@@ -830,6 +1448,26 @@ bool ESP8266WiFiGenericClass::resumeFromShutdown (WiFiState& state)
                     sntp_setserver(i++, &ntp);
                 }
             }
+
+            if (renewMs)
+            {
+                // the lease is used as a static address until it has to be
+                // renewed, then DHCP takes over again (unless the address
+                // was changed in the meantime)
+                DEBUG_WIFI("core: resume: DHCP lease renewed in %us\n", renewMs / 1000);
+                schedule_recurrent_function_us([local, renew = esp8266::polledTimeout::oneShotMs(renewMs)]() mutable
+                {
+                    if (!renew)
+                    {
+                        return true;
+                    }
+                    if (WiFi.localIP() == local)
+                    {
+                        WiFi.config(0u, 0u, 0u);
+                    }
+                    return false;
+                }, 1000000);
+            }
         }
 
         String ssid;
@@ -46,6 +46,10 @@ typedef std::shared_ptr<WiFiEventHandlerOpaque> WiFiEventHandler;
 
 typedef void (*WiFiEventCb)(WiFiEvent_t);
 
+#ifndef WIFI_EVENT_HANDLERS_MAX
+#define WIFI_EVENT_HANDLERS_MAX 8
+#endif
+
 enum class DNSResolveType: uint8_t
 {
     DNS_AddrType_IPv4 = LWIP_DNS_ADDRTYPE_IPV4,
@@ -55,10 +59,20 @@ enum class DNSResolveType: uint8_t
 };
 
 inline constexpr auto DNSDefaultTimeoutMs = 10000;
+inline constexpr auto DNSCacheDefaultTTLMs = 60000;
 inline constexpr auto DNSResolveTypeDefault = static_cast<DNSResolveType>(LWIP_DNS_ADDRTYPE_DEFAULT);
 
 struct WiFiState;
 
+// Time spent in each sleep mode while the sleep policy is enabled
+struct WiFiSleepPolicyStats
+{
+    uint32_t noneMs;
+    uint32_t modemMs;
+    uint32_t lightMs;
+    uint32_t switches;  // sleep mode changes made by the policy
+};
+
 class ESP8266WiFiGenericClass {
         // ----------------------------------------------------------------------------------------------
         // -------------------------------------- Generic WiFi function ---------------------------------
@@ -81,6 +95,31 @@ class ESP8266WiFiGenericClass {
         WiFiEventHandler onSoftAPModeProbeRequestReceived(std::function<void(const WiFiEventSoftAPModeProbeRequestReceived&)>);
         WiFiEventHandler onWiFiModeChange(std::function<void(const WiFiEventModeChange&)>);
 
+        // Allocation-free alternative to the handlers above: a static table
+        // of up to WIFI_EVENT_HANDLERS_MAX function pointers, called with the
+        // context they were added with.  Each event is converted once for all
+        // its handlers.  The event is known from the type of the handler, the
+        // raw one (WiFiEvent_t, void*) gets `event`, or every event.  Returns
+        // false when the table is full
+        template <typename Event>
+        using WiFiEventFn = void (*)(const Event& event, void* context);
+        static bool addEventHandler(WiFiEventFn<WiFiEventStationModeConnected> f, void* context = nullptr);
+        static bool addEventHandler(WiFiEventFn<WiFiEventStationModeDisconnected> f, void* context = nullptr);
+        static bool addEventHandler(WiFiEventFn<WiFiEventStationModeAuthModeChanged> f, void* context = nullptr);
+        static bool addEventHandler(WiFiEventFn<WiFiEventStationModeGotIP> f, void* context = nullptr);
+        static bool addEventHandler(void (*dhcpTimeout)(void* context), void* context = nullptr);
+        static bool addEventHandler(WiFiEventFn<WiFiEventSoftAPModeStationConnected> f, void* context = nullptr);
+        static bool addEventHandler(WiFiEventFn<WiFiEventSoftAPModeStationDisconnected> f, void* context = nullptr);
+        static bool addEventHandler(WiFiEventFn<WiFiEventSoftAPModeProbeRequestReceived> f, void* context = nullptr);
+        static bool addEventHandler(WiFiEventFn<WiFiEventModeChange> f, void* context = nullptr);
+        static bool addEventHandler(void (*f)(WiFiEvent_t event, void* context), void* context = nullptr, WiFiEvent_t event = WIFI_EVENT_ANY);
+        // removes the handlers added with f and context, can be called from a handler
+        template <typename F>
+        static void removeEventHandler(F* f, void* context = nullptr)
+        {
+            _removeEventHandler(reinterpret_cast<void (*)()>(f), context);
+        }
+
         uint8_t channel(void);
 
         bool setSleepMode(WiFiSleepType_t type, uint8_t listenInterval = 0);
@@ -122,6 +161,16 @@ class ESP8266WiFiGenericClass {
         uint8_t getListenInterval ();
         bool isSleepLevelMax ();
 
+        // Sleep policy: the sleep mode follows the TCP/UDP traffic, no
+        // sleep while data was sent or received less than idleMs ago, modem
+        // sleep after that, light sleep after lightIdleMs (0: never) when
+        // no recurrent scheduled function needs to run more often than every
+        // 100ms.  The sleep level and listen interval set by setSleepMode()
+        // are kept.  setSleepMode() disables the policy
+        static bool setSleepPolicy(bool enable, uint32_t idleMs = 1000, uint32_t lightIdleMs = 30000);
+        static const WiFiSleepPolicyStats& getSleepPolicyStats();
+        static void resetSleepPolicyStats();
+
         bool setPhyMode(WiFiPhyMode_t mode);
         WiFiPhyMode_t getPhyMode();
 
@@ -155,6 +204,7 @@ class ESP8266WiFiGenericClass {
         static uint32_t shutdownCRC (const WiFiState& state);
 
         static void _eventCallback(void *event);
+        static void _removeEventHandler(void (*f)(), void* context);
 
         // ----------------------------------------------------------------------------------------------
         // ------------------------------------ Generic Network function --------------------------------
@@ -166,6 +216,22 @@ class ESP8266WiFiGenericClass {
 #if LWIP_IPV4 && LWIP_IPV6
         int hostByName(const char* aHostname, IPAddress& aResult, uint32_t timeout_ms, DNSResolveType resolveType);
 #endif
+        // Non-blocking hostByName(): returns at once, the callback is called
+        // later from the scheduler with the address, not set (!isSet()) when
+        // the name could not be resolved within timeout_ms.  Lookups can
+        // overlap, lwIP runs up to DNS_TABLE_SIZE (3) of them at a time.
+        // Returns false when the lookup cannot be started, then the callback
+        // is not called
+        using HostByNameCallback = std::function<void(const IPAddress& aResult)>;
+        static bool hostByNameAsync(const char* aHostname, HostByNameCallback callback,
+                uint32_t timeout_ms = DNSDefaultTimeoutMs, DNSResolveType resolveType = DNSResolveTypeDefault);
+        // Cache of the hostByName() results, shared by all the users: a name
+        // resolved less than ttl_ms ago is answered without a DNS request, and
+        // is resolved again in the background when asked for in the last
+        // quarter of that time.  lwIP does not tell the TTLs of the answers,
+        // ttl_ms should be below them.  0 entries, the default, disables it
+        static bool setDNSCache(size_t entries, uint32_t ttl_ms = DNSCacheDefaultTTLMs);
+        static void clearDNSCache();
         bool getPersistent();
 
     protected:
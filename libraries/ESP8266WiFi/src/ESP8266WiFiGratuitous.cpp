@@ -29,7 +29,7 @@ extern "C"
 namespace experimental
 {
 
-ETSTimer* ESP8266WiFiGratuitous::_timer = nullptr;
+uint32_t ESP8266WiFiGratuitous::_periodic = 0;
 
 void ESP8266WiFiGratuitous::stationKeepAliveNow ()
 {
@@ -45,22 +45,12 @@ void ESP8266WiFiGratuitous::stationKeepAliveNow ()
         }
 }
 
-void ESP8266WiFiGratuitous::scheduleItForNextYieldOnce (void*)
-{
-    schedule_recurrent_function_us([]()
-    {
-        ESP8266WiFiGratuitous::stationKeepAliveNow();
-        return false;
-    }, 0);
-}
-
 bool ESP8266WiFiGratuitous::stationKeepAliveSetIntervalMs (uint32_t ms)
 {
-    if (_timer)
+    if (_periodic)
     {
-        os_timer_disarm(_timer);
-        free(_timer);
-        _timer = nullptr;
+        cancel_periodic_function(_periodic);
+        _periodic = 0;
     }
 
     if (ms)
@@ -68,12 +58,13 @@ bool ESP8266WiFiGratuitous::stationKeepAliveSetIntervalMs (uint32_t ms)
         // send one now
         stationKeepAliveNow();
 
-        _timer = (ETSTimer*)malloc(sizeof(ETSTimer));
-        if (_timer == nullptr)
+        _periodic = schedule_periodic_function_ms([]()
+        {
+            ESP8266WiFiGratuitous::stationKeepAliveNow();
+            return true;
+        }, ms);
+        if (_periodic == 0)
             return false;
-
-        os_timer_setfn(_timer, ESP8266WiFiGratuitous::scheduleItForNextYieldOnce, nullptr);
-        os_timer_arm(_timer, ms, true);
     }
 
     return true;
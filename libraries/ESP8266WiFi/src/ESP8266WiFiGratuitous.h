@@ -21,7 +21,6 @@
 #define ESP8266WIFIGRATUITOUS_H_
 
 #include <stdint.h>  // uint32_t
-#include <ets_sys.h> // ETSTimer
 
 namespace experimental
 {
@@ -33,6 +32,7 @@ public:
     // disable(0) or enable/update automatic sending of Gratuitous ARP packets.
     // A gratuitous ARP packet is immediately sent when calling this function, then
     // based on a time interval in milliseconds, default = 1s
+    // (run as a periodic function, in the same wakeups as other network housekeeping)
     // return value: true when started, false otherwise
     static bool stationKeepAliveSetIntervalMs (uint32_t ms = 1000);
 
@@ -44,9 +44,7 @@ public:
 
 protected:
 
-    static void scheduleItForNextYieldOnce (void*);
-
-    static ETSTimer* _timer;
+    static uint32_t _periodic; // schedule_periodic_function_ms() id
 };
 
 }; // experimental::
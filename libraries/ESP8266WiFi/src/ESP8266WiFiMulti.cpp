@@ -78,18 +78,21 @@ static void printWiFiStatus(wl_status_t status)
  * @brief Wait for WiFi connect status change, protected with timeout
  * @param connectTimeoutMs
  *      WiFi connection timeout in ms
+ * @param stopWhenNotFound
+ *      Also stop waiting when the AP is not found
  * @return
  *      WiFi connection status
  */
-static wl_status_t waitWiFiConnect(uint32_t connectTimeoutMs)
+static wl_status_t waitWiFiConnect(uint32_t connectTimeoutMs, bool stopWhenNotFound = false)
 {
     wl_status_t status = WL_CONNECT_FAILED;
     // Wait for WiFi to connect
     // stop waiting upon status checked every 100ms or when timeout is reached
     esp_delay(connectTimeoutMs,
-        [&status]() {
+        [&status, stopWhenNotFound]() {
             status = WiFi.status();
-            return status != WL_CONNECTED && status != WL_CONNECT_FAILED;
+            return status != WL_CONNECTED && status != WL_CONNECT_FAILED &&
+                   !(stopWhenNotFound && status == WL_NO_SSID_AVAIL);
         }, 100);
 
     // Check status
@@ -165,6 +168,48 @@ bool ESP8266WiFiMulti::existsAP(const char *ssid, const char *passphrase)
     return APlistExists(ssid, passphrase);
 }
 
+/**
+ * @brief Enable or disable the fast reconnect to the AP of the last connection
+ * @param enable
+ *      Try the last connection before scanning
+ * @param reuseIPConfig
+ *      Apply the IP configuration of the last connection instead of using DHCP
+ */
+void ESP8266WiFiMulti::setFastReconnect(bool enable, bool reuseIPConfig)
+{
+    _fastReconnect = enable;
+    _reuseIPConfig = reuseIPConfig;
+}
+
+/**
+ * @brief Keep the last connection in RTC user memory
+ * @param offset
+ *      RTC user memory offset in 4 byte blocks
+ * @retval true
+ *      Success
+ * @retval false
+ *      The last connection does not fit at offset
+ */
+bool ESP8266WiFiMulti::setFastReconnectRTCOffset(uint32_t offset)
+{
+    LastConnection stored;
+
+    if (!ESP.rtcUserMemoryRead(offset, (uint32_t*)&stored, sizeof(stored))) {
+        DEBUG_WIFI_MULTI("[WIFIM] RTC offset %u out of range\n", offset);
+        return false;
+    }
+    _rtcOffset = offset;
+
+    // Use a connection stored before deep sleep, unless there is a newer one
+    if (!_lastConnection.channel && stored.channel &&
+        stored.crc == crc32(&stored.apCrc, sizeof(stored) - sizeof(stored.crc))) {
+        DEBUG_WIFI_MULTI("[WIFIM] Last connection loaded from RTC memory\n");
+        _lastConnection = stored;
+    }
+
+    return true;
+}
+
 /**
  * @brief Keep WiFi connected to Access Point with strongest WiFi signal (RSSI)
  * @param connectTimeoutMs
@@ -197,9 +242,16 @@ wl_status_t ESP8266WiFiMulti::run(uint32_t connectTimeoutMs)
     status = WiFi.status();
     if (status == WL_CONNECTED) {
         // Already connected
+        rememberConnection();
         return status;
     }
 
+    // Try the AP of the last connection, without a full scan
+    if (connectLastAP(connectTimeoutMs) == WL_CONNECTED) {
+        rememberConnection();
+        return WL_CONNECTED;
+    }
+
     // Start WiFi scan
     scanResult = startScan();
     if (scanResult < 0) {
@@ -208,11 +260,123 @@ wl_status_t ESP8266WiFiMulti::run(uint32_t connectTimeoutMs)
     }
 
     // Try to connect to multiple WiFi's with strongest signal (RSSI)
-    return connectWiFiMulti(connectTimeoutMs);
+    status = connectWiFiMulti(connectTimeoutMs);
+    if (status == WL_CONNECTED) {
+        rememberConnection();
+    }
+
+    return status;
+}
+
+/**
+ * @brief Connect to the AP of the last connection
+ * @details
+ *      First directly, with the BSSID and channel of the last connection,
+ *      then to the known AP's found by a scan of that channel only
+ * @param connectTimeoutMs
+ *      WiFi connect timeout in ms
+ * @return
+ *      WiFi connection status
+ */
+wl_status_t ESP8266WiFiMulti::connectLastAP(uint32_t connectTimeoutMs)
+{
+    if (!_fastReconnect || !_lastConnection.channel) {
+        return WL_CONNECT_FAILED;
+    }
+
+    const WifiAPEntry *entry = findAP(_lastConnection.apCrc);
+    if (!entry) {
+        // Removed from the AP list
+        return WL_CONNECT_FAILED;
+    }
+
+    DEBUG_WIFI_MULTI("[WIFIM] Fast connect %s on CH %d\n", entry->ssid, _lastConnection.channel);
+
+    if (_reuseIPConfig && _lastConnection.ip) {
+        WiFi.config(_lastConnection.ip, _lastConnection.gateway, _lastConnection.subnet, _lastConnection.dns);
+    }
+
+    WiFi.begin(entry->ssid, entry->passphrase, _lastConnection.channel, _lastConnection.bssid);
+
+    // Do not wait for the timeout when the AP is gone
+    if (waitWiFiConnect(connectTimeoutMs, true) == WL_CONNECTED) {
+        return WL_CONNECTED;
+    }
+
+    if (_reuseIPConfig) {
+        // Back to DHCP, the AP may be part of another network now
+        WiFi.config(0u, 0u, 0u);
+    }
+
+    // The AP may have a new BSSID, or another known AP may be on the same channel
+    if (startScan(_lastConnection.channel) <= 0) {
+        return WL_CONNECT_FAILED;
+    }
+
+    // Hidden AP's are tried after the full scan
+    return connectWiFiMulti(connectTimeoutMs, false);
+}
+
+/**
+ * @brief Remember the current connection for the next reconnect
+ */
+void ESP8266WiFiMulti::rememberConnection()
+{
+    LastConnection connection = { };
+    String ssid = WiFi.SSID();
+
+    for (auto entry : _APlist) {
+        if (ssid == entry.ssid) {
+            connection.apCrc = crc32(entry.passphrase, strlen(entry.passphrase), crc32(entry.ssid, strlen(entry.ssid)));
+            break;
+        }
+    }
+    if (!connection.apCrc) {
+        // Not connected through the AP list
+        return;
+    }
+
+    memcpy(connection.bssid, WiFi.BSSID(), sizeof(connection.bssid));
+    connection.channel = WiFi.channel();
+    connection.ip = WiFi.localIP();
+    connection.gateway = WiFi.gatewayIP();
+    connection.subnet = WiFi.subnetMask();
+    connection.dns = WiFi.dnsIP();
+    connection.crc = crc32(&connection.apCrc, sizeof(connection) - sizeof(connection.crc));
+
+    // run() is typically called from every loop(), only store changes
+    if (connection.crc == _lastConnection.crc && !memcmp(&connection, &_lastConnection, sizeof(connection))) {
+        return;
+    }
+
+    _lastConnection = connection;
+    if (_rtcOffset >= 0) {
+        ESP.rtcUserMemoryWrite(_rtcOffset, (uint32_t*)&_lastConnection, sizeof(_lastConnection));
+    }
+}
+
+/**
+ * @brief Find the AP list entry of a connection
+ * @param apCrc
+ *      CRC of the SSID and passphrase of the entry
+ * @return
+ *      The entry, or nullptr when it is not in the list
+ */
+const WifiAPEntry* ESP8266WiFiMulti::findAP(uint32_t apCrc) const
+{
+    for (auto &entry : _APlist) {
+        if (crc32(entry.passphrase, strlen(entry.passphrase), crc32(entry.ssid, strlen(entry.ssid))) == apCrc) {
+            return &entry;
+        }
+    }
+
+    return nullptr;
 }
 
 /**
  * @brief Start WiFi scan
+ * @param channel
+ *      The only channel to scan, 0 for all channels
  * @retval >0
  *      Number of detected WiFi SSID's
  * @retval 0
@@ -220,11 +384,11 @@ wl_status_t ESP8266WiFiMulti::run(uint32_t connectTimeoutMs)
  * @retval -2
  *      WiFi scan failed
  */
-int8_t ESP8266WiFiMulti::startScan()
+int8_t ESP8266WiFiMulti::startScan(uint8_t channel)
 {
     int8_t scanResult;
 
-    DEBUG_WIFI_MULTI("[WIFIM] Start scan\n");
+    DEBUG_WIFI_MULTI("[WIFIM] Start scan (CH %d)\n", channel);
 
     // Clean previous scan
     WiFi.scanDelete();
@@ -233,7 +397,7 @@ int8_t ESP8266WiFiMulti::startScan()
     WiFi.disconnect();
 
     // Start wifi scan in async mode
-    WiFi.scanNetworks(true);
+    WiFi.scanNetworks(true, false, channel);
 
     // Wait for WiFi scan change or timeout
     // stop waiting upon status checked every 100ms or when timeout is reached
@@ -259,10 +423,12 @@ int8_t ESP8266WiFiMulti::startScan()
  * @brief Connect to multiple WiFi's
  * @param connectTimeoutMs
  *      WiFi connect timeout in ms
+ * @param connectHidden
+ *      Also try the AP's which are not in the scan results
  * @return
  *      WiFi connection status
  */
-wl_status_t ESP8266WiFiMulti::connectWiFiMulti(uint32_t connectTimeoutMs)
+wl_status_t ESP8266WiFiMulti::connectWiFiMulti(uint32_t connectTimeoutMs, bool connectHidden)
 {
     int8_t scanResult;
     String ssid;
@@ -344,7 +510,7 @@ wl_status_t ESP8266WiFiMulti::connectWiFiMulti(uint32_t connectTimeoutMs)
     }
 
     // Try to connect to hidden AP's which are not reported by WiFi scan
-    for (uint8_t i = 0; i < _APlist.size(); i++) {
+    for (uint8_t i = 0; connectHidden && i < _APlist.size(); i++) {
         auto &entry = _APlist[i];
 
         if (!connectSkipIndex[i]) {
@@ -70,16 +70,47 @@ public:
 
     void cleanAPlist();
 
+    // Reconnect to the AP of the last successful connection directly, with its
+    // BSSID and channel, then after a scan of that channel only, and only then
+    // after a full scan. Enabled by default. reuseIPConfig also applies the IP
+    // configuration of the last connection, skipping DHCP (it stays a static
+    // configuration until the AP can not be reached this way).
+    void setFastReconnect(bool enable, bool reuseIPConfig = false);
+
+    // Keep the last successful connection in RTC user memory from the given
+    // offset (in 4 byte blocks, it takes 9), so it survives deep sleep.
+    // Loads a connection stored there before, false when it does not fit.
+    bool setFastReconnectRTCOffset(uint32_t offset);
+
 private:
+    struct LastConnection {
+        uint32_t crc;     // of the fields below, stored in RTC memory
+        uint32_t apCrc;   // of the SSID and passphrase of the AP entry
+        uint8_t bssid[6];
+        uint8_t channel;  // 0 when there is no last connection
+        uint8_t reserved;
+        uint32_t ip;
+        uint32_t gateway;
+        uint32_t subnet;
+        uint32_t dns;
+    };
+
     WifiAPlist _APlist;
     bool _firstRun;
+    bool _fastReconnect = true;
+    bool _reuseIPConfig = false;
+    int32_t _rtcOffset = -1;
+    LastConnection _lastConnection = { };
 
     bool APlistAdd(const char *ssid, const char *passphrase = NULL);
     bool APlistExists(const char *ssid, const char *passphrase = NULL);
     void APlistClean();
 
-    wl_status_t connectWiFiMulti(uint32_t connectTimeoutMs);
-    int8_t startScan();
+    wl_status_t connectWiFiMulti(uint32_t connectTimeoutMs, bool connectHidden = true);
+    wl_status_t connectLastAP(uint32_t connectTimeoutMs);
+    void rememberConnection();
+    const WifiAPEntry* findAP(uint32_t apCrc) const;
+    int8_t startScan(uint8_t channel = 0);
     void printWiFiScan();
 };
 
@@ -0,0 +1,391 @@
+/*
+ ESP8266WiFiNameService.cpp - esp8266 Wifi support
+ copyright esp8266/arduino
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+ Reference:
+ https://tools.ietf.org/html/rfc4795 (LLMNR)
+ https://tools.ietf.org/html/rfc1002 (NetBIOS over TCP/UDP)
+ https://tools.ietf.org/html/rfc1035 (DNS)
+*/
+
+#include <functional>
+#include <ctype.h>
+#include <string.h>
+
+#include "ESP8266WiFi.h"
+#include "WiFiUdp.h"
+#include "ESP8266WiFiNameService.h"
+
+extern "C"
+{
+#include "lwip/udp.h"
+#include "lwip/igmp.h"
+} // extern "C"
+
+#include "include/UdpContext.h"
+
+// llmnr ipv6 is FF02:0:0:0:0:0:1:3
+// lwip-v2's igmp_joingroup only supports IPv4
+#define LLMNR_MULTICAST_ADDR 224, 0, 0, 252
+#define LLMNR_MULTICAST_TTL  1
+#define LLMNR_PORT           5355
+#define LLMNR_TTL            30     // seconds
+#define NBNS_PORT            137
+#define NBNS_TTL             300000 // seconds
+#define NBNS_NAME_LENGTH     15     // and a type suffix
+#define NBNS_ENCODED_LENGTH  32
+
+#define DNS_HEADER_LENGTH    12
+#define DNS_FLAGS_QR         0x8000
+#define DNS_FLAGS_OPCODE     0x7800
+#define DNS_FLAGS_C          0x0400 // LLMNR conflict
+#define DNS_TYPE_A           1
+#define DNS_TYPE_NB          0x20
+#define DNS_TYPE_NBSTAT      0x21
+#define DNS_CLASS_IN         1
+
+namespace
+{
+
+// a question longer than this can't be for our name
+constexpr size_t maxQuestionLength = DNS_HEADER_LENGTH + NameService::MaxHostnameLength + 2 + 4;
+// LLMNR answer with the question echoed, NetBIOS ones are shorter
+constexpr size_t maxReplyLength = maxQuestionLength + 2 + 10 + 4;
+
+struct Question
+{
+    uint16_t id;
+    uint16_t flags;
+    uint16_t otherCount;  // AN + NS + AR
+    const uint8_t* name;  // length of the first label
+    size_t nameLength;    // up to the root label included
+    uint8_t labels;
+    uint16_t type;
+    uint16_t klass;
+};
+
+struct NameServiceState
+{
+    char hostname[NameService::MaxHostnameLength + 1] = { };
+    UdpContext* conn[NameService::ProtocolCount] = { };
+    WiFiEventHandler gotIPHandler;
+    WiFiEventHandler disconnectedHandler;
+};
+
+NameServiceState* state = nullptr;
+
+uint16_t get16 (const uint8_t* p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+uint8_t* put16 (uint8_t* p, uint16_t value)
+{
+    *p++ = value >> 8;
+    *p++ = value;
+    return p;
+}
+
+uint8_t* put32 (uint8_t* p, uint32_t value)
+{
+    return put16(put16(p, value >> 16), value);
+}
+
+// DNS header and the only question, read in place (LLMNR and NBNS alike)
+bool parseQuestion (const uint8_t* data, size_t size, Question& q)
+{
+    if (size < DNS_HEADER_LENGTH || get16(data + 4) != 1)
+        return false;
+
+    q.id = get16(data);
+    q.flags = get16(data + 2);
+    q.otherCount = get16(data + 6) + get16(data + 8) + get16(data + 10);
+    q.name = data + DNS_HEADER_LENGTH;
+    q.labels = 0;
+
+    // no compression in the question
+    size_t pos = DNS_HEADER_LENGTH;
+    for (;;)
+    {
+        if (pos >= size)
+            return false;
+        uint8_t length = data[pos++];
+        if (!length)
+            break;
+        if (length > 63 || pos + length > size)
+            return false;
+        pos += length;
+        q.labels++;
+    }
+    if (pos + 4 > size)
+        return false;
+
+    q.nameLength = data + pos - q.name;
+    q.type = get16(data + pos);
+    q.klass = get16(data + pos + 2);
+    return true;
+}
+
+bool matchLLMNR (const Question& q, const char* hostname)
+{
+    size_t length = strlen(hostname);
+    return q.labels == 1 && q.name[0] == length && strncasecmp((const char*)q.name + 1, hostname, length) == 0;
+}
+
+enum NBNSMatch { NBNSNone, NBNSName, NBNSWildcard };
+
+NBNSMatch matchNetBIOS (const Question& q, const char* hostname)
+{
+    if (q.labels != 1 || q.name[0] != NBNS_ENCODED_LENGTH)
+        return NBNSNone;
+
+    // first level encoding: two letters 'A' + nibble per character,
+    // padded with spaces, last character is the name type
+    char name[NBNS_NAME_LENGTH + 1];
+    const uint8_t* encoded = q.name + 1;
+    for (size_t i = 0; i < NBNS_NAME_LENGTH; i++, encoded += 2)
+        name[i] = ((encoded[0] - 'A') << 4) | ((encoded[1] - 'A') & 0xf);
+    name[NBNS_NAME_LENGTH] = '\0';
+    char* end = strchr(name, ' ');
+    if (end)
+        *end = '\0';
+
+    if (strcmp(name, "*") == 0)
+        return NBNSWildcard;
+    size_t length = strlen(hostname);
+    if (length > NBNS_NAME_LENGTH)
+        length = NBNS_NAME_LENGTH;
+    if (name[0] && strlen(name) == length && strncasecmp(name, hostname, length) == 0)
+        return NBNSName;
+    return NBNSNone;
+}
+
+// padded with spaces, upper case
+void netBIOSName (char* name, const char* hostname)
+{
+    for (size_t i = 0; i < NBNS_NAME_LENGTH; i++)
+        name[i] = *hostname? toupper(*hostname++): ' ';
+}
+
+// the address of the interface the question came from
+uint32_t localAddress (const UdpContext& conn)
+{
+    const netif* input = conn.getInputNetif();
+    if (input)
+        return ip4_addr_get_u32(netif_ip4_addr(input));
+    return WiFi.localIP().v4();
+}
+
+size_t replyLLMNR (uint8_t* reply, const Question& q, uint32_t ip)
+{
+    bool haveRR = q.type == DNS_TYPE_A && q.klass == DNS_CLASS_IN;
+
+    uint8_t* p = put16(reply, q.id);
+    p = put16(p, DNS_FLAGS_QR);
+    p = put16(p, 1);      // QDCOUNT
+    p = put16(p, haveRR); // ANCOUNT
+    p = put32(p, 0);      // NSCOUNT, ARCOUNT
+    memcpy(p, q.name, q.nameLength);
+    p += q.nameLength;
+    p = put16(p, q.type);
+    p = put16(p, q.klass);
+    if (haveRR)
+    {
+        p = put16(p, 0xc000 | DNS_HEADER_LENGTH); // points to the question's name
+        p = put16(p, DNS_TYPE_A);
+        p = put16(p, DNS_CLASS_IN);
+        p = put32(p, LLMNR_TTL);
+        p = put16(p, 4);
+        memcpy(p, &ip, 4);
+        p += 4;
+    }
+    return p - reply;
+}
+
+size_t replyNetBIOS (uint8_t* reply, const Question& q, NBNSMatch match, uint32_t ip, const char* hostname)
+{
+    char name[NBNS_NAME_LENGTH];
+    netBIOSName(name, hostname);
+
+    uint8_t* p = put16(reply, q.id);
+    p = put16(p, match == NBNSName? 0x8500: 0x8400); // response, authoritative (, recursion desired)
+    p = put16(p, 0); // QDCOUNT
+    p = put16(p, 1); // ANCOUNT
+    p = put32(p, 0); // NSCOUNT, ARCOUNT
+
+    if (match == NBNSName)
+    {
+        *p++ = NBNS_ENCODED_LENGTH;
+        for (size_t i = 0; i < NBNS_NAME_LENGTH; i++)
+        {
+            *p++ = ((uint8_t)name[i] >> 4) + 'A';
+            *p++ = (name[i] & 0xf) + 'A';
+        }
+        *p++ = 'A'; // workstation type
+        *p++ = 'A';
+        *p++ = 0;
+        p = put16(p, DNS_TYPE_NB);
+        p = put16(p, DNS_CLASS_IN);
+        p = put32(p, NBNS_TTL);
+        p = put16(p, 6);
+        p = put16(p, 0); // b-node, unique
+        memcpy(p, &ip, 4);
+        p += 4;
+    }
+    else
+    {
+        // node status of the questioned '*'
+        memcpy(p, q.name, q.nameLength);
+        p += q.nameLength;
+        p = put16(p, DNS_TYPE_NBSTAT);
+        p = put16(p, DNS_CLASS_IN);
+        p = put32(p, 0);
+        p = put16(p, 4 + NBNS_NAME_LENGTH);
+        *p++ = 1; // number of names
+        memcpy(p, name, NBNS_NAME_LENGTH);
+        p += NBNS_NAME_LENGTH;
+        *p++ = 0; // workstation/redirector
+        p = put16(p, 0x0400); // b-node, unique, active
+    }
+    return p - reply;
+}
+
+void process (NameService::Protocol protocol)
+{
+    UdpContext* conn = state? state->conn[protocol]: nullptr;
+    if (!conn)
+        return;
+
+    while (conn->next())
+    {
+        char copy[maxQuestionLength];
+        const uint8_t* data = (const uint8_t*)conn->peekDatagram(copy, sizeof(copy));
+        Question q;
+        if (!data || !parseQuestion(data, conn->getSize(), q) || (q.flags & (DNS_FLAGS_QR | DNS_FLAGS_OPCODE)))
+            continue;
+
+        uint8_t reply[maxReplyLength];
+        size_t length = 0;
+        if (protocol == NameService::LLMNR)
+        {
+            if (!(q.flags & DNS_FLAGS_C) && !q.otherCount && matchLLMNR(q, state->hostname))
+                length = replyLLMNR(reply, q, localAddress(*conn));
+            if (length)
+                conn->queue(conn->getRemoteAddress(), conn->getRemotePort(), (const char*)reply, length);
+        }
+        else
+        {
+            NBNSMatch match = matchNetBIOS(q, state->hostname);
+            if (match != NBNSNone)
+                length = replyNetBIOS(reply, q, match, localAddress(*conn), state->hostname);
+            if (length)
+                conn->queue(conn->getRemoteAddress(), NBNS_PORT, (const char*)reply, length);
+        }
+    }
+
+    conn->sendQueued();
+}
+
+NameServiceState* getState ()
+{
+    if (!state)
+        state = new (std::nothrow) NameServiceState;
+    return state;
+}
+
+} // namespace
+
+bool NameService::setHostname (const char* hostname)
+{
+    if (!hostname || strlen(hostname) > MaxHostnameLength || !getState())
+        return false;
+    strcpy(state->hostname, hostname);
+    return true;
+}
+
+const char* NameService::getHostname ()
+{
+    return state? state->hostname: "";
+}
+
+bool NameService::active (Protocol protocol)
+{
+    return state && state->conn[protocol];
+}
+
+bool NameService::begin (Protocol protocol)
+{
+    if (protocol >= ProtocolCount || !getState())
+        return false;
+
+    end(protocol);
+
+    IPAddress llmnr(LLMNR_MULTICAST_ADDR);
+    if (protocol == LLMNR && igmp_joingroup(IP4_ADDR_ANY4, llmnr) != ERR_OK)
+        return false;
+
+    UdpContext* conn = new UdpContext;
+    conn->ref();
+    state->conn[protocol] = conn;
+
+    if (!conn->listen(IP_ADDR_ANY, protocol == LLMNR? LLMNR_PORT: NBNS_PORT))
+    {
+        end(protocol);
+        return false;
+    }
+    conn->onRx([protocol]() { process(protocol); });
+
+    if (protocol == LLMNR)
+    {
+        conn->setMulticastTTL(LLMNR_MULTICAST_TTL);
+        conn->connect(llmnr, LLMNR_PORT);
+
+        // the group is joined again on the station's new address
+        if (!state->gotIPHandler)
+        {
+            state->gotIPHandler = WiFi.onStationModeGotIP([](const WiFiEventStationModeGotIP&)
+            {
+                if (active(LLMNR))
+                    begin(LLMNR);
+            });
+            state->disconnectedHandler = WiFi.onStationModeDisconnected([](const WiFiEventStationModeDisconnected&)
+            {
+                if (active(LLMNR))
+                    begin(LLMNR);
+            });
+        }
+    }
+
+    return true;
+}
+
+void NameService::end (Protocol protocol)
+{
+    if (!active(protocol))
+        return;
+
+    state->conn[protocol]->unref();
+    state->conn[protocol] = nullptr;
+
+    if (protocol == LLMNR)
+    {
+        IPAddress llmnr(LLMNR_MULTICAST_ADDR);
+        igmp_leavegroup(IP4_ADDR_ANY4, llmnr);
+        // the event handlers stay, doing nothing while not active:
+        // begin() is called by them
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ ESP8266WiFiNameService.h - esp8266 Wifi support
+ copyright esp8266/arduino
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef ESP8266WIFINAMESERVICE_H_
+#define ESP8266WIFINAMESERVICE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Engine shared by the local name responders (ESP8266LLMNR, ESP8266NetBIOS,
+// and the hostname of ESP8266mDNS): one hostname, one parser of the DNS wire
+// format both LLMNR and NBNS questions use, one name matcher and one reply
+// serializer, whatever number of protocols are answered.
+// Each protocol still has its own port and so its own UDP context, only
+// created while the protocol is answered.
+
+class NameService
+{
+public:
+
+    enum Protocol : uint8_t
+    {
+        LLMNR,   // RFC 4795, multicast on 224.0.0.252:5355
+        NetBIOS, // RFC 1002 name service, broadcast on port 137
+        ProtocolCount
+    };
+
+    static constexpr size_t MaxHostnameLength = 63; // a single DNS label
+
+    // The name all responders answer for, compared case insensitively
+    // (NetBIOS uses its first 15 characters), false when it is too long
+    static bool setHostname (const char* hostname);
+    static const char* getHostname ();
+
+    // start (or restart) answering questions of a protocol
+    static bool begin (Protocol protocol);
+    static void end (Protocol protocol);
+    static bool active (Protocol protocol);
+};
+
+#endif // ESP8266WIFINAMESERVICE_H_
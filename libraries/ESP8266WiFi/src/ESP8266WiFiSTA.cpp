@@ -29,6 +29,7 @@
 #include "LwipIntf.h"
 
 #include <coredecls.h>
+#include <Schedule.h>
 
 #include "c_types.h"
 #include "ets_sys.h"
@@ -119,6 +120,7 @@ static bool sta_config_equal(const station_config& lhs, const station_config& rh
 
 bool ESP8266WiFiSTAClass::_useStaticIp = false;
 bool ESP8266WiFiSTAClass::_useInsecureWEP = false;
+bool ESP8266WiFiSTAClass::_bootAssociation = false;
 
 /**
  * Start Wifi connection
@@ -181,6 +183,21 @@ wl_status_t ESP8266WiFiSTAClass::begin(const char* ssid, const char *passphrase,
         conf.bssid_set = 0;
     }
 
+    if(_bootAssociation) {
+        _bootAssociation = false;
+        // keep the association started at boot time when it uses the same credentials
+        struct station_config current;
+        wifi_station_get_config(&current);
+        station_status_t boot_status = wifi_station_get_connect_status();
+        if(!bssid && channel <= 0
+            && strncmp(reinterpret_cast<const char*>(current.ssid), reinterpret_cast<const char*>(conf.ssid), sizeof(conf.ssid)) == 0
+            && strncmp(reinterpret_cast<const char*>(current.password), reinterpret_cast<const char*>(conf.password), sizeof(conf.password)) == 0
+            && (boot_status == STATION_CONNECTING || boot_status == STATION_GOT_IP)) {
+            DEBUG_WIFI("[WIFI] boot time association kept\n");
+            return status();
+        }
+    }
+
     struct station_config conf_compare;
     if(WiFi._persistent){
         wifi_station_get_config_default(&conf_compare);
@@ -240,6 +257,12 @@ wl_status_t ESP8266WiFiSTAClass::begin() {
         return WL_CONNECT_FAILED;
     }
 
+    if(_bootAssociation) {
+        // already connecting to the SDK config
+        _bootAssociation = false;
+        return status();
+    }
+
     ETS_UART_INTR_DISABLE();
     wifi_station_connect();
     ETS_UART_INTR_ENABLE();
@@ -629,6 +652,111 @@ int8_t ESP8266WiFiSTAClass::RSSI(void) {
 
 
 
+// -----------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------- Association at boot time ------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+// AP of the last connection, kept over resets and deep sleep so that the
+// association at boot time does not need to scan all channels
+#ifndef WIFI_FAST_CONNECT_RTC_OFFSET
+#define WIFI_FAST_CONNECT_RTC_OFFSET RTC_USER_BLOCK_FAST_CONNECT // in 4 bytes blocks, 16 bytes before RF_CAL_CACHE()'s (see coredecls.h)
+#endif
+
+namespace {
+
+struct BootAP
+{
+    uint32_t crc;      // of the fields below
+    uint32_t ssidCrc;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t reserved;
+};
+
+static_assert(WIFI_FAST_CONNECT_RTC_OFFSET != RTC_USER_BLOCK_FAST_CONNECT
+              || RTC_USER_BLOCK_FAST_CONNECT + sizeof(BootAP) / 4 <= RTC_USER_BLOCK_RF_CAL, "overlaps RF_CAL_CACHE()");
+
+bool bootBSSIDTried = false; // the association at boot time uses the stored AP
+
+} // anonymous namespace
+
+static uint32_t _boot_ap_crc(const BootAP& ap) {
+    return crc32(&ap.ssidCrc, sizeof(ap) - sizeof(ap.crc));
+}
+
+static void _boot_ap_connected(const WiFiEventStationModeConnected& event, void*) {
+    bootBSSIDTried = false;
+
+    BootAP ap { };
+    ap.ssidCrc = crc32(event.ssid.c_str(), event.ssid.length());
+    memcpy(ap.bssid, event.bssid, sizeof(ap.bssid));
+    ap.channel = event.channel;
+    ap.crc = _boot_ap_crc(ap);
+
+    BootAP stored;
+    if(!ESP.rtcUserMemoryRead(WIFI_FAST_CONNECT_RTC_OFFSET, reinterpret_cast<uint32_t*>(&stored), sizeof(stored))
+        || memcmp(&stored, &ap, sizeof(ap)) != 0) {
+        ESP.rtcUserMemoryWrite(WIFI_FAST_CONNECT_RTC_OFFSET, reinterpret_cast<uint32_t*>(&ap), sizeof(ap));
+    }
+}
+
+static void _boot_ap_disconnected(const WiFiEventStationModeDisconnected&, void*) {
+    if(!bootBSSIDTried) {
+        return;
+    }
+    bootBSSIDTried = false;
+
+    // the stored AP is gone or has moved, try again on all channels
+    // (not from the SDK event callback)
+    schedule_recurrent_function_us([]() {
+        struct station_config conf;
+        wifi_station_get_config(&conf);
+        conf.bssid_set = 0;
+#if (NONOSDK >= (0x30200))
+        conf.channel = 0;
+#endif
+        DEBUG_WIFI("[WIFI] boot time association: stored AP not found\n");
+        ETS_UART_INTR_DISABLE();
+        wifi_station_set_config_current(&conf);
+        wifi_station_connect();
+        ETS_UART_INTR_ENABLE();
+        return false;
+    }, 0);
+}
+
+/**
+ * Called from init_done(), after C++ global constructors and before setup(),
+ * when enableWiFiFastConnectAtBootTime() is linked in.
+ * Starts the association with the credentials stored in flash, to the AP of
+ * the last connection when it is known.
+ */
+void ESP8266WiFiSTAClass::_beginAtBootTime() {
+    struct station_config stored;
+    if(!wifi_station_get_config_default(&stored) || !stored.ssid[0]) {
+        return;
+    }
+
+    // null terminated copies, begin() checks the lengths
+    char ssid[sizeof(stored.ssid) + 1] { };
+    char passphrase[sizeof(stored.password) + 1] { };
+    memcpy(ssid, stored.ssid, sizeof(stored.ssid));
+    memcpy(passphrase, stored.password, sizeof(stored.password));
+
+    BootAP ap;
+    bool known = ESP.rtcUserMemoryRead(WIFI_FAST_CONNECT_RTC_OFFSET, reinterpret_cast<uint32_t*>(&ap), sizeof(ap))
+        && ap.crc == _boot_ap_crc(ap)
+        && ap.ssidCrc == crc32(ssid, strlen(ssid))
+        && ap.channel > 0 && ap.channel <= 13;
+
+    WiFi.addEventHandler(_boot_ap_connected);
+    WiFi.addEventHandler(_boot_ap_disconnected);
+
+    bootBSSIDTried = known;
+    wl_status_t ret = WiFi.begin(ssid, passphrase, known ? ap.channel : 0, known ? ap.bssid : nullptr);
+    _bootAssociation = ret != WL_CONNECT_FAILED && ret != WL_WRONG_PASSWORD;
+    DEBUG_WIFI("[WIFI] boot time association to '%s' (%s AP)\n", ssid, known ? "stored" : "any");
+}
+
 // -----------------------------------------------------------------------------------------------------------------------
 // -------------------------------------------------- STA remote configure -----------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
@@ -29,6 +29,8 @@
 #include "user_interface.h"
 #include "LwipIntf.h"
 
+extern "C" void __wifiAssociateAtBootTime (void);
+
 
 class ESP8266WiFiSTAClass: public LwipIntf {
         // ----------------------------------------------------------------------------------------------
@@ -90,6 +92,11 @@ class ESP8266WiFiSTAClass: public LwipIntf {
         static bool _useStaticIp;
         static bool _useInsecureWEP;
 
+        // enableWiFiFastConnectAtBootTime()
+        friend void ::__wifiAssociateAtBootTime (void);
+        static void _beginAtBootTime();
+        static bool _bootAssociation; // cleared by the first begin()
+
     // ----------------------------------------------------------------------------------------------
     // ------------------------------------ STA remote configure  -----------------------------------
     // ----------------------------------------------------------------------------------------------
@@ -37,12 +37,28 @@ extern "C" {
 
 #include "debug.h"
 #include <coredecls.h>
+#include <Schedule.h>
 
 // -----------------------------------------------------------------------------------------------------------------------
 // ---------------------------------------------------- Private functions ------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
 
-
+static uint8_t authModeToEncryptionType(AUTH_MODE authmode) {
+    switch(authmode) {
+        case AUTH_OPEN:
+            return ENC_TYPE_NONE;
+        case AUTH_WEP:
+            return ENC_TYPE_WEP;
+        case AUTH_WPA_PSK:
+            return ENC_TYPE_TKIP;
+        case AUTH_WPA2_PSK:
+            return ENC_TYPE_CCMP;
+        case AUTH_WPA_WPA2_PSK:
+            return ENC_TYPE_AUTO;
+        default:
+            return -1;
+    }
+}
 
 
 // -----------------------------------------------------------------------------------------------------------------------
@@ -58,6 +74,8 @@ void* ESP8266WiFiScanClass::_scanResult = 0;
 
 std::function<void(int)> ESP8266WiFiScanClass::_onComplete;
 
+ESP8266WiFiScanClass::ChannelScan ESP8266WiFiScanClass::_channelScan = { };
+
 /**
  * Start scan WiFi networks available
  * @param async         run in async mode
@@ -116,6 +134,135 @@ void ESP8266WiFiScanClass::scanNetworksAsync(std::function<void(int)> onComplete
     scanNetworks(true, show_hidden);
 }
 
+/**
+ * Starts scanning WiFi networks one channel at a time, in async mode
+ * @param results       array receiving the networks found
+ * @param capacity      size of the results array
+ * @param onChannel     the event handler executed when each channel is scanned
+ * @param channels      the channels to scan, in this order (NULL for 1 to 13)
+ * @param channelCount  number of channels, at most 14
+ * @param dwellMs       active scan time per channel (0 for the SDK default)
+ * @param show_hidden   show hidden networks
+ * @return true if the scan was started
+ */
+bool ESP8266WiFiScanClass::scanChannelsAsync(WiFiScanEntry* results, size_t capacity, ScanChannelHandler onChannel,
+                                             const uint8_t* channels, size_t channelCount,
+                                             uint32_t dwellMs, bool show_hidden) {
+    if(ESP8266WiFiScanClass::_scanStarted || !results || (channels && (channelCount == 0 || channelCount > sizeof(_channelScan.channels)))) {
+        return false;
+    }
+
+    ChannelScan& scan = ESP8266WiFiScanClass::_channelScan;
+    scan.results = results;
+    scan.capacity = capacity;
+    scan.count = 0;
+    if(channels) {
+        memcpy(scan.channels, channels, channelCount);
+        scan.channelCount = channelCount;
+    } else {
+        for(uint8_t i = 0; i < 13; ++i) {
+            scan.channels[i] = i + 1;
+        }
+        scan.channelCount = 13;
+    }
+    scan.next = 0;
+    scan.dwellMs = dwellMs;
+    scan.showHidden = show_hidden;
+    scan.failed = false;
+    scan.onChannel = std::move(onChannel);
+
+    WiFi.enableSTA(true);
+
+    int status = wifi_station_get_connect_status();
+    if(status != STATION_GOT_IP && status != STATION_IDLE) {
+        wifi_station_disconnect();
+    }
+
+    ESP8266WiFiScanClass::_scanStarted = true;
+    _scanNextChannel();
+
+    return !scan.failed;
+}
+
+/**
+ * called to get the state of the incremental scan
+ * @return number of networks stored or status
+ *          -1 if scan not fin
+ *          -2 if scan failed or not triggered
+ */
+int ESP8266WiFiScanClass::scanChannelsComplete() {
+    const ChannelScan& scan = ESP8266WiFiScanClass::_channelScan;
+
+    if(!scan.results || scan.failed) {
+        return WIFI_SCAN_FAILED;
+    }
+
+    if(scan.next < scan.channelCount) {
+        return WIFI_SCAN_RUNNING;
+    }
+
+    return scan.count;
+}
+
+/**
+ * start the scan of the next channel of the incremental scan
+ */
+void ESP8266WiFiScanClass::_scanNextChannel() {
+    ChannelScan& scan = ESP8266WiFiScanClass::_channelScan;
+
+    struct scan_config config;
+    memset(&config, 0, sizeof(config));
+    config.channel = scan.channels[scan.next];
+    config.show_hidden = scan.showHidden;
+    if(scan.dwellMs) {
+        config.scan_type = WIFI_SCAN_TYPE_ACTIVE;
+        config.scan_time.active.min = scan.dwellMs;
+        config.scan_time.active.max = scan.dwellMs;
+    }
+
+    if(!wifi_station_scan(&config, reinterpret_cast<scan_done_cb_t>(&ESP8266WiFiScanClass::_scanChannelDone))) {
+        scan.failed = true;
+        ESP8266WiFiScanClass::_scanStarted = false;
+    }
+}
+
+/**
+ * store the networks of a channel of the incremental scan and go on with the next one
+ */
+void ESP8266WiFiScanClass::_scanChannelDone(void* result, int status) {
+    ChannelScan& scan = ESP8266WiFiScanClass::_channelScan;
+    size_t first = scan.count;
+
+    if(status == OK) {
+        for(bss_info* it = reinterpret_cast<bss_info*>(result); it && scan.count < scan.capacity; it = STAILQ_NEXT(it, next)) {
+            WiFiScanEntry& entry = scan.results[scan.count++];
+            memcpy(entry.bssid, it->bssid, sizeof(entry.bssid));
+            memcpy(entry.ssid, it->ssid, sizeof(it->ssid));
+            entry.ssid[32] = 0;
+            entry.rssi = it->rssi;
+            entry.channel = it->channel;
+            entry.encryptionType = authModeToEncryptionType(it->authmode);
+            entry.isHidden = (it->is_hidden != 0);
+        }
+    }
+
+    uint8_t channel = scan.channels[scan.next++];
+    bool more = scan.next < scan.channelCount;
+
+    if(scan.onChannel) {
+        scan.onChannel(channel, scan.results + first, scan.count - first);
+    }
+
+    // the SDK does not expect a new scan from within its scan callback
+    if(more && schedule_function(&ESP8266WiFiScanClass::_scanNextChannel)) {
+        return;
+    }
+
+    scan.failed = more;
+    scan.onChannel = nullptr;
+    ESP8266WiFiScanClass::_scanStarted = false;
+}
+
 /**
  * called to get the scan state in Async mode
  * @return scan result or status
@@ -216,20 +363,7 @@ uint8_t ESP8266WiFiScanClass::encryptionType(uint8_t i) {
         return -1;
     }
 
-    switch(it->authmode) {
-        case AUTH_OPEN:
-            return ENC_TYPE_NONE;
-        case AUTH_WEP:
-            return ENC_TYPE_WEP;
-        case AUTH_WPA_PSK:
-            return ENC_TYPE_TKIP;
-        case AUTH_WPA2_PSK:
-            return ENC_TYPE_CCMP;
-        case AUTH_WPA_WPA2_PSK:
-            return ENC_TYPE_AUTO;
-        default:
-            return -1;
-    }
+    return authModeToEncryptionType(it->authmode);
 }
 
 /**
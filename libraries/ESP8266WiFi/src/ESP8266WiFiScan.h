@@ -26,6 +26,16 @@
 #include "ESP8266WiFiType.h"
 #include "ESP8266WiFiGeneric.h"
 
+// Compact scan result of scanChannelsAsync(), about a third of a bss_info
+struct WiFiScanEntry {
+    uint8_t bssid[6];
+    char ssid[33];          // 0-terminated
+    int8_t rssi;
+    uint8_t channel;
+    uint8_t encryptionType; // enum wl_enc_type
+    bool isHidden;
+};
+
 class ESP8266WiFiScanClass {
 
         // ----------------------------------------------------------------------------------------------
@@ -40,6 +50,18 @@ class ESP8266WiFiScanClass {
         int8_t scanComplete();
         void scanDelete();
 
+        // incremental scan, one channel at a time: onChannel is called as soon as each channel
+        // is scanned, with the networks found on it, which are stored in the caller's results
+        // array (networks beyond its capacity are dropped) instead of a copy of the SDK list.
+        // channels: the channels to scan in this order (NULL for 1 to 13)
+        // dwellMs: active scan time per channel (0 for the SDK default)
+        using ScanChannelHandler = std::function<void(uint8_t channel, const WiFiScanEntry* entries, size_t count)>;
+        bool scanChannelsAsync(WiFiScanEntry* results, size_t capacity, ScanChannelHandler onChannel,
+                               const uint8_t* channels = nullptr, size_t channelCount = 0,
+                               uint32_t dwellMs = 0, bool show_hidden = false);
+        // number of networks stored by the incremental scan, or WIFI_SCAN_RUNNING / WIFI_SCAN_FAILED
+        int scanChannelsComplete();
+
         // scan result
         const bss_info *getScanInfoByIndex(int i);
         bool getNetworkInfo(uint8_t networkItem, String &ssid, uint8_t &encryptionType, int32_t &RSSI, uint8_t* &BSSID, int32_t &channel, bool &isHidden);
@@ -66,6 +88,23 @@ class ESP8266WiFiScanClass {
         static void _scanDone(void* result, int status);
         static void * _getScanInfoByIndex(int i);
 
+        struct ChannelScan {
+            WiFiScanEntry* results;
+            size_t capacity;
+            size_t count;
+            uint8_t channels[14];
+            uint8_t channelCount;
+            uint8_t next;
+            uint32_t dwellMs;
+            bool showHidden;
+            bool failed;
+            ScanChannelHandler onChannel;
+        };
+        static ChannelScan _channelScan;
+
+        static void _scanNextChannel();
+        static void _scanChannelDone(void* result, int status);
+
 };
 
 
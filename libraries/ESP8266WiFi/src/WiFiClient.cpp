@@ -186,6 +186,51 @@ bool WiFiClient::getNoDelay() const {
     return _client->getNoDelay();
 }
 
+void WiFiClient::setCork(bool cork)
+{
+    if (_client)
+        _client->setCork(cork);
+}
+
+bool WiFiClient::getCork() const
+{
+    return _client? _client->getCork(): false;
+}
+
+void WiFiClient::setBatchDelayUs(uint32_t batchUs)
+{
+    if (_client)
+        _client->setBatchDelayUs(batchUs);
+}
+
+uint32_t WiFiClient::getBatchDelayUs() const
+{
+    return _client? _client->getBatchDelayUs(): 0;
+}
+
+void WiFiClient::getWriteStats(uint32_t& writes, uint32_t& segments) const
+{
+    writes = segments = 0;
+    if (_client)
+        _client->getWriteStats(writes, segments);
+}
+
+void WiFiClient::resetWriteStats()
+{
+    if (_client)
+        _client->resetWriteStats();
+}
+
+bool WiFiClient::getTcpStats(WiFiClientTcpStats& stats) const
+{
+    if (!_client)
+    {
+        stats = WiFiClientTcpStats();
+        return false;
+    }
+    return _client->getTcpStats(stats);
+}
+
 void WiFiClient::setSync(bool sync)
 {
     if (!_client)
@@ -220,6 +265,16 @@ size_t WiFiClient::write(const uint8_t *buf, size_t size)
     return _client->write((const char*)buf, size);
 }
 
+size_t WiFiClient::write(const iovec *iov, size_t iovcnt)
+{
+    if (!_client || !iovcnt)
+    {
+        return 0;
+    }
+    _client->setTimeout(_timeout);
+    return _client->write(iov, iovcnt);
+}
+
 size_t WiFiClient::write(Stream& stream)
 {
     // (this method is deprecated)
@@ -243,6 +298,21 @@ size_t WiFiClient::write_P(PGM_P buf, size_t size)
     return nopeek.sendAll(this);
 }
 
+size_t WiFiClient::writeReference(const uint8_t *buf, size_t size)
+{
+    if (!_client || !size)
+    {
+        return 0;
+    }
+    _client->setTimeout(_timeout);
+    return _client->writeReference((const char*)buf, size);
+}
+
+bool WiFiClient::acknowledged()
+{
+    return _client? _client->acknowledged(): true;
+}
+
 int WiFiClient::available()
 {
     if (!_client)
@@ -457,6 +527,11 @@ size_t WiFiClient::peekAvailable ()
     return _client? _client->peekAvailable(): 0;
 }
 
+size_t WiFiClient::peekSegments (iovec* iov, size_t iovcnt)
+{
+    return _client? _client->peekSegments(iov, iovcnt): 0;
+}
+
 // consume bytes after use (see peekBuffer)
 void WiFiClient::peekConsume (size_t consume)
 {
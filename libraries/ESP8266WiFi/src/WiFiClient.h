@@ -42,6 +42,24 @@
 class ClientContext;
 class WiFiServer;
 
+// TCP connection figures, see WiFiClient::getTcpStats()
+struct WiFiClientTcpStats
+{
+  uint32_t rttMs = 0;       // smoothed round trip time (500ms resolution)
+  uint32_t rtoMs = 0;       // retransmission timeout
+  uint32_t retransmits = 0; // retransmissions of the oldest unacked segment
+  uint32_t cwnd = 0;        // congestion window (bytes)
+  uint32_t ssthresh = 0;    // slow start threshold (bytes)
+  uint32_t sndWnd = 0;      // peer's receive window (bytes)
+  uint32_t sndBufUsed = 0;  // bytes queued or unacknowledged in send buffer
+  uint32_t sndQueueLen = 0; // pbufs queued in send buffer
+  uint32_t mss = 0;         // maximum segment size
+  uint32_t bytesIn = 0;     // bytes received
+  uint32_t bytesOut = 0;    // bytes acknowledged by peer
+  uint32_t connectMs = 0;   // connect() duration (0: not measured)
+  uint32_t firstByteMs = 0; // first write to first received data (0: not yet)
+};
+
 class WiFiClient : public Client, public SList<WiFiClient> {
 protected:
   WiFiClient(ClientContext* client);
@@ -70,7 +88,13 @@ public:
   virtual int connect(const String& host, uint16_t port);
   virtual size_t write(uint8_t) override;
   virtual size_t write(const uint8_t *buf, size_t size) override;
+  virtual size_t write(const iovec *iov, size_t iovcnt) override;
   virtual size_t write_P(PGM_P buf, size_t size);
+  // zero-copy write: buf is sent in place and must stay valid and unchanged
+  // until acknowledged() is true, data out of RAM (flash) are still copied
+  virtual size_t writeReference(const uint8_t *buf, size_t size);
+  // whether all data given to writeReference() are acknowledged by peer
+  virtual bool acknowledged();
   [[ deprecated("use stream.sendHow(client...)") ]]
   size_t write(Stream& stream);
 
@@ -123,6 +147,27 @@ public:
   bool getNoDelay() const;
   void setNoDelay(bool nodelay);
 
+  // Cork holds writes smaller than a segment until uncorked (larger ones
+  // are sent), to build one response from many small writes.
+  // BatchDelayUs (0=disabled=default) holds them until following writes
+  // fill a segment or until the delay elapses, which bounds the latency of
+  // small request/response traffic where Nagle would wait for an ack (up
+  // to 200ms with delayed acks) and NoDelay sends tiny segments.
+  // Held bytes are kept out of lwIP, in a segment-sized buffer allocated
+  // at first use. Neither applies with setSync(true).
+  void setCork(bool cork);
+  bool getCork() const;
+  void setBatchDelayUs(uint32_t batchUs);
+  uint32_t getBatchDelayUs() const;
+  // writes with data and TCP segments created for them since connection
+  // or last reset (segments/writes measures the batching)
+  void getWriteStats(uint32_t& writes, uint32_t& segments) const;
+  void resetWriteStats();
+
+  // connection diagnostics, returns false when not connected
+  // (counters and timings are still filled in)
+  bool getTcpStats(WiFiClientTcpStats& stats) const;
+
   // default Sync=false
   // When sync is true, all writes are automatically flushed.
   // This is slower but also does not allocate
@@ -142,9 +187,15 @@ public:
   // semantic forbids any kind of read() before calling peekConsume()
   virtual const char* peekBuffer () override;
 
-  // consume bytes after use (see peekBuffer)
+  // consume bytes after use (see peekBuffer, peekSegments)
   virtual void peekConsume (size_t consume) override;
 
+  // zero-copy receive beyond peekBuffer(): fill iov[] with up to iovcnt
+  // segments of received data, in place in the network buffers
+  // return the number of segments, data stays valid until peekConsume()
+  // same semantic as peekBuffer(): no read() before peekConsume()
+  virtual size_t peekSegments (iovec* iov, size_t iovcnt);
+
   virtual bool outputCanTimeout () override { return connected(); }
   virtual bool inputCanTimeout () override { return connected(); }
 
@@ -35,6 +35,8 @@ extern "C" {
 #include "WiFiClient.h"
 #include "WiFiClientSecureBearSSL.h"
 #include "StackThunk.h"
+#include "Schedule.h"
+#include "MemoryPressure.h"
 #include "lwip/opt.h"
 #include "lwip/ip.h"
 #include "lwip/tcp.h"
@@ -66,8 +68,38 @@ extern "C" {
 #define DEBUG_BSSL(...)
 #endif
 
+// Engine calls whose thunk stack usage is recorded when stack_thunk_profile()
+// is enabled, as handshake until it is done
+static void profiled_recvrec_ack(br_ssl_engine_context *eng, size_t len, bool handshake_done) {
+  stack_thunk_profile_begin();
+  br_ssl_engine_recvrec_ack(eng, len);
+  stack_thunk_profile_end(handshake_done ? STACK_THUNK_OP_DECRYPT : STACK_THUNK_OP_HANDSHAKE);
+}
+
+static void profiled_sendrec_ack(br_ssl_engine_context *eng, size_t len, bool handshake_done) {
+  stack_thunk_profile_begin();
+  br_ssl_engine_sendrec_ack(eng, len);
+  stack_thunk_profile_end(handshake_done ? STACK_THUNK_OP_ENCRYPT : STACK_THUNK_OP_HANDSHAKE);
+}
+
+static void profiled_sendapp_ack(br_ssl_engine_context *eng, size_t len) {
+  stack_thunk_profile_begin();
+  br_ssl_engine_sendapp_ack(eng, len);
+  stack_thunk_profile_end(STACK_THUNK_OP_ENCRYPT);
+}
+
 namespace BearSSL {
 
+// Following constants taken from bearssl/src/ssl/ssl_engine.c (not exported unfortunately)
+static constexpr int MAX_OUT_OVERHEAD = 85;
+static constexpr int MAX_IN_OVERHEAD = 325;
+
+// Record bytes fed to the engine per handshakePoll(), certificate decoding and
+// hashing run as the bytes arrive so this bounds the time spent per call
+static constexpr size_t HANDSHAKE_POLL_CHUNK = 512;
+
+SessionCache *WiFiClientSecureCtx::_default_session_cache = nullptr;
+
 void WiFiClientSecureCtx::_clear() {
   // TLS handshake may take more than the 5 second default timeout
   _timeout = 15000;
@@ -83,11 +115,22 @@ void WiFiClientSecureCtx::_clear() {
   _now = 0; // You can override or ensure time() is correct w/configTime
   _ta = nullptr;
   setBufferSizes(16384, 512); // Minimum safe
+  _buffer_pool = nullptr;
+  _shrink_recv = false;
   _handshake_done = false;
+  _handshaking = false;
+  _handshake_start = 0;
+  _handshake_cache = nullptr;
+  _handshake_cache_key = 0;
+  _coalesce_ms = 0;
+  _write_pending = false;
+  _write_pending_since = 0;
+  _pending_next = nullptr;
   _recvapp_buf = nullptr;
   _recvapp_len = 0;
   _oom_err = false;
   _session = nullptr;
+  _session_cache = nullptr;
   _cipher_list = nullptr;
   _cipher_cnt = 0;
   _tls_min = BR_TLS10;
@@ -99,6 +142,7 @@ void WiFiClientSecureCtx::_clearAuthenticationSettings() {
   _use_fingerprint = false;
   _use_self_signed = false;
   _knownkey = nullptr;
+  _knownkey_pin_curve = false;
   _ta = nullptr;
 }
 
@@ -176,10 +220,6 @@ void WiFiClientSecureCtx::setClientECCert(const X509List *chain,
 }
 
 void WiFiClientSecureCtx::setBufferSizes(int recv, int xmit) {
-  // Following constants taken from bearssl/src/ssl/ssl_engine.c (not exported unfortunately)
-  const int MAX_OUT_OVERHEAD = 85;
-  const int MAX_IN_OVERHEAD = 325;
-
   // The data buffers must be between 512B and 16KB
   recv = std::max(512, std::min(16384, recv));
   xmit = std::max(512, std::min(16384, xmit));
@@ -204,6 +244,13 @@ bool WiFiClientSecureCtx::stop(unsigned int maxWaitMs) {
 }
 
 bool WiFiClientSecureCtx::flush(unsigned int maxWaitMs) {
+  if (_write_pending) {
+    // Close the record left open by coalesced writes
+    _unlistPending();
+    if (ctx_present()) {
+      br_ssl_engine_flush(_eng, 0);
+    }
+  }
   (void) _run_until(BR_SSL_SENDAPP);
   return WiFiClient::flush(maxWaitMs);
 }
@@ -232,6 +279,97 @@ int WiFiClientSecureCtx::connect(const String& host, uint16_t port) {
   return connect(host.c_str(), port);
 }
 
+int WiFiClientSecureCtx::connectAsync(IPAddress ip, uint16_t port) {
+  if (!WiFiClient::connect(ip, port)) {
+    return 0;
+  }
+  return _startSSL(nullptr);
+}
+
+int WiFiClientSecureCtx::connectAsync(const char* name, uint16_t port) {
+  IPAddress remote_addr;
+  if (!WiFi.hostByName(name, remote_addr)) {
+    DEBUG_BSSL("connectAsync: Name lookup failure\n");
+    return 0;
+  }
+  if (!WiFiClient::connect(remote_addr, port)) {
+    DEBUG_BSSL("connectAsync: Unable to connect TCP socket\n");
+    return 0;
+  }
+  return _startSSL(name);
+}
+
+int WiFiClientSecureCtx::connectAsync(const String& host, uint16_t port) {
+  return connectAsync(host.c_str(), port);
+}
+
+// One step of the handshake: send one pending record, or feed at most
+// HANDSHAKE_POLL_CHUNK received bytes to the engine, then return to the caller
+int WiFiClientSecureCtx::handshakePoll() {
+  if (_handshake_done) {
+    return 1;
+  }
+  if (!_handshaking) {
+    return -1;
+  }
+  if (millis() - _handshake_start > _timeout) {
+    DEBUG_BSSL("handshakePoll: Timeout\n");
+    _finishSSL(false);
+    return -1;
+  }
+
+  unsigned state = br_ssl_engine_current_state(_eng);
+  if (state & BR_SSL_CLOSED) {
+    _finishSSL(false);
+    return -1;
+  }
+
+  if (state & BR_SSL_SENDREC) {
+    if (!_clientConnected()) {
+      _finishSSL(false);
+      return -1;
+    }
+    size_t len;
+    unsigned char *buf = br_ssl_engine_sendrec_buf(_eng, &len);
+    len = std::min(len, (size_t)WiFiClient::availableForWrite());
+    if (len) {
+      int wlen = WiFiClient::write(buf, len);
+      if (wlen <= 0) {
+        _finishSSL(false);
+        return -1;
+      }
+      profiled_sendrec_ack(_eng, wlen, _handshake_done);
+    }
+    return 0;
+  }
+
+  if (state & BR_SSL_SENDAPP) {
+    _finishSSL(true);
+    return 1;
+  }
+
+  if (state & BR_SSL_RECVREC) {
+    size_t avail = WiFiClient::available();
+    if (avail) {
+      size_t len;
+      unsigned char *buf = br_ssl_engine_recvrec_buf(_eng, &len);
+      int rlen = WiFiClient::read(buf, std::min(std::min(len, avail), HANDSHAKE_POLL_CHUNK));
+      if (rlen < 0) {
+        _finishSSL(false);
+        return -1;
+      }
+      if (rlen > 0) {
+        profiled_recvrec_ack(_eng, rlen, _handshake_done);
+      }
+    } else if (!_clientConnected()) {
+      _finishSSL(false);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
 void WiFiClientSecureCtx::_freeSSL() {
   // These are smart pointers and will free if refcnt==0
   _sc = nullptr;
@@ -245,7 +383,9 @@ void WiFiClientSecureCtx::_freeSSL() {
   _recvapp_buf = nullptr;
   _recvapp_len = 0;
   // This connection is toast
+  _unlistPending();
   _handshake_done = false;
+  _handshaking = false;
   _timeout = 15000;
 }
 
@@ -321,9 +461,14 @@ size_t WiFiClientSecureCtx::_write(const uint8_t *buf, size_t size, bool pmem) {
       } else {
         memcpy(sendapp_buf, buf, to_send);
       }
-      br_ssl_engine_sendapp_ack(_eng, to_send);
-      br_ssl_engine_flush(_eng, 0);
-      flush();
+      profiled_sendapp_ack(_eng, to_send);
+      if (_coalesce_ms && (size_t)to_send < sendapp_len) {
+        // Room is left in the record, keep it open for the next write
+        _listPending();
+      } else {
+        br_ssl_engine_flush(_eng, 0);
+        flush();
+      }
       buf += to_send;
       sent_bytes += to_send;
       size -= to_send;
@@ -332,9 +477,67 @@ size_t WiFiClientSecureCtx::_write(const uint8_t *buf, size_t size, bool pmem) {
     }
   } while (size);
 
+  if (_write_pending && (millis() - _write_pending_since >= _coalesce_ms)) {
+    flush();
+  }
+
   return sent_bytes;
 }
 
+void WiFiClientSecureCtx::setWriteCoalescing(uint32_t flushDelayMs) {
+  _coalesce_ms = flushDelayMs;
+  if (!flushDelayMs && _write_pending) {
+    flush();
+  }
+}
+
+// Contexts with an open record, checked after each loop() by _flushExpired()
+WiFiClientSecureCtx *WiFiClientSecureCtx::_pending_head = nullptr;
+bool WiFiClientSecureCtx::_pending_scheduled = false;
+
+void WiFiClientSecureCtx::_listPending() {
+  if (_write_pending) {
+    return;
+  }
+  _write_pending = true;
+  _write_pending_since = millis();
+  _pending_next = _pending_head;
+  _pending_head = this;
+  if (!_pending_scheduled) {
+    _pending_scheduled = schedule_function(_flushExpired);
+  }
+}
+
+void WiFiClientSecureCtx::_unlistPending() {
+  if (!_write_pending) {
+    return;
+  }
+  _write_pending = false;
+  for (WiFiClientSecureCtx **p = &_pending_head; *p; p = &(*p)->_pending_next) {
+    if (*p == this) {
+      *p = _pending_next;
+      break;
+    }
+  }
+  _pending_next = nullptr;
+}
+
+void WiFiClientSecureCtx::_flushExpired() {
+  _pending_scheduled = false;
+  WiFiClientSecureCtx *ctx = _pending_head;
+  while (ctx) {
+    // flush() unlists ctx, so step ahead first
+    WiFiClientSecureCtx *next = ctx->_pending_next;
+    if (millis() - ctx->_write_pending_since >= ctx->_coalesce_ms) {
+      ctx->flush();
+    }
+    ctx = next;
+  }
+  if (_pending_head) {
+    _pending_scheduled = schedule_function(_flushExpired);
+  }
+}
+
 size_t WiFiClientSecureCtx::write(const uint8_t *buf, size_t size) {
   return _write(buf, size, false);
 }
@@ -400,6 +603,16 @@ const char* WiFiClientSecureCtx::peekBuffer ()
     return (const char*)_recvapp_buf;
 }
 
+size_t WiFiClientSecureCtx::peekSegments (iovec* iov, size_t iovcnt)
+{
+    size_t len = iovcnt? peekAvailable(): 0;
+    if (!len)
+        return 0;
+    iov[0].iov_base = peekBuffer();
+    iov[0].iov_len = len;
+    return 1;
+}
+
 // consume bytes after use (see peekBuffer)
 void WiFiClientSecureCtx::peekConsume (size_t consume)
 {
@@ -424,7 +637,12 @@ int WiFiClientSecureCtx::_pollRecvBuffer() {
   }
   _recvapp_buf = nullptr;
   _recvapp_len = 0;
-  if (!ctx_present() || _run_until(BR_SSL_RECVAPP, false) < 0) {
+  // The peer can only answer what it has received
+  if (_write_pending) {
+    flush();
+  }
+  // The engine belongs to handshakePoll() until the handshake ends
+  if (!ctx_present() || _handshaking || _run_until(BR_SSL_RECVAPP, false) < 0) {
     return 0;
   }
   int st = br_ssl_engine_current_state(_eng);
@@ -537,7 +755,7 @@ int WiFiClientSecureCtx::_run_until(unsigned target, bool blocking) {
         return -1;
       }
       if (wlen > 0) {
-        br_ssl_engine_sendrec_ack(_eng, wlen);
+        profiled_sendrec_ack(_eng, wlen, _handshake_done);
       }
       no_work = 0;
       continue;
@@ -580,7 +798,7 @@ int WiFiClientSecureCtx::_run_until(unsigned target, bool blocking) {
           return -1;
         }
         if (rlen > 0) {
-          br_ssl_engine_recvrec_ack(_eng, rlen);
+          profiled_recvrec_ack(_eng, rlen, _handshake_done);
         }
         no_work = 0;
         continue;
@@ -1108,19 +1326,60 @@ bool WiFiClientSecureCtx::_installClientX509Validator() {
 }
 
 std::shared_ptr<unsigned char> WiFiClientSecureCtx::_alloc_iobuf(size_t sz)
-{ // Allocate buffer with preference to IRAM
-  HeapSelectIram primary;
-  auto sptr = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[sz], std::default_delete<unsigned char[]>());
-  if (!sptr) {
-    HeapSelectDram alternate;
-    sptr = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[sz], std::default_delete<unsigned char[]>());
+{
+  if (_buffer_pool) {
+    return _buffer_pool->get(sz);
+  }
+  // TLS records are bulk copied, IRAM heap when there is one
+  return heap_alloc_by_intent(HeapIntent::LargeCold, [sz]() {
+    return std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[sz], std::default_delete<unsigned char[]>());
+  });
+}
+
+// Low on heap, records are sent from the smallest buffer, in more pieces.
+int WiFiClientSecureCtx::_iobufOutSize() const {
+  if (MemoryPressure.level() == HeapLevel::Nominal) {
+    return _iobuf_out_size;
   }
-  return sptr;
+  return std::min(_iobuf_out_size, 512 + MAX_OUT_OVERHEAD);
+}
+
+// Once MFLN is negotiated the server sends no larger fragments, so the
+// receive buffer only needs to hold one of them.  Only done while what the
+// engine has buffered fits, which is the case right after the handshake.
+void WiFiClientSecureCtx::_shrinkRecvBuffer() {
+  if (!br_ssl_engine_get_mfln_negotiated(_eng)) {
+    return;
+  }
+  size_t size = ((size_t)1 << _eng->log_max_frag_len) + MAX_IN_OVERHEAD;
+  if (size >= _eng->ibuf_len || std::max({ _eng->ixa, _eng->ixb, _eng->ixc }) > size) {
+    return;
+  }
+  auto iobuf_in = _alloc_iobuf(size);
+  if (!iobuf_in) {
+    return;
+  }
+  memcpy(iobuf_in.get(), _eng->ibuf, size);
+  if (_recvapp_buf) {
+    _recvapp_buf = iobuf_in.get() + (_recvapp_buf - _eng->ibuf);
+  }
+  DEBUG_BSSL("_shrinkRecvBuffer: %u to %u bytes\n", (unsigned)_eng->ibuf_len, (unsigned)size);
+  _eng->ibuf = iobuf_in.get();
+  _eng->ibuf_len = size;
+  _iobuf_in = iobuf_in; // the larger one is freed, or back in the pool
 }
 
 // Called by connect() to do the actual SSL setup and handshake.
 // Returns if the SSL handshake succeeded.
 bool WiFiClientSecureCtx::_connectSSL(const char* hostName) {
+  if (!_startSSL(hostName)) {
+    return false;
+  }
+  return _finishSSL(_wait_for_handshake());
+}
+
+// Sets up the engine and starts the handshake, without running it.
+bool WiFiClientSecureCtx::_startSSL(const char* hostName) {
   DEBUG_BSSL("_connectSSL: start connection\n");
   _freeSSL();
   _oom_err = false;
@@ -1135,11 +1394,12 @@ bool WiFiClientSecureCtx::_connectSSL(const char* hostName) {
   _sc = std::make_shared<br_ssl_client_context>();
   _eng = &_sc->eng; // Allocation/deallocation taken care of by the _sc shared_ptr
   _iobuf_in = _alloc_iobuf(_iobuf_in_size);
-  _iobuf_out = _alloc_iobuf(_iobuf_out_size);
+  int iobuf_out_size = _iobufOutSize();
+  _iobuf_out = _alloc_iobuf(iobuf_out_size);
   DBG_MMU_PRINTF("\n_iobuf_in:       %p\n", _iobuf_in.get());
   DBG_MMU_PRINTF(  "_iobuf_out:      %p\n", _iobuf_out.get());
   DBG_MMU_PRINTF(  "_iobuf_in_size:  %u\n", _iobuf_in_size);
-  DBG_MMU_PRINTF(  "_iobuf_out_size: %u\n", _iobuf_out_size);
+  DBG_MMU_PRINTF(  "_iobuf_out_size: %u\n", iobuf_out_size);
 
   if (!_sc || !_iobuf_in || !_iobuf_out) {
     _freeSSL(); // Frees _sc, _iobuf*
@@ -1161,9 +1421,21 @@ bool WiFiClientSecureCtx::_connectSSL(const char* hostName) {
     DEBUG_BSSL("_connectSSL: Can't install x509 validator\n");
     return false;
   }
-  br_ssl_engine_set_buffers_bidi(_eng, _iobuf_in.get(), _iobuf_in_size, _iobuf_out.get(), _iobuf_out_size);
+  br_ssl_engine_set_buffers_bidi(_eng, _iobuf_in.get(), _iobuf_in_size, _iobuf_out.get(), iobuf_out_size);
   br_ssl_engine_set_versions(_eng, _tls_min, _tls_max);
 
+#ifndef BEARSSL_SSL_BASIC
+  // The supported curves advertised in the ClientHello come from the EC
+  // implementation, so only the pinned key's curve can be picked for ECDHE
+  if (_knownkey && _knownkey_pin_curve && _knownkey->isEC()) {
+    _pinned_ec = *br_ec_get_default();
+    _pinned_ec.supported_curves &= (uint32_t)1 << _knownkey->getEC()->curve;
+    if (_pinned_ec.supported_curves) {
+      br_ssl_engine_set_ec(_eng, &_pinned_ec);
+    }
+  }
+#endif
+
   // Apply any client certificates, if supplied.
   if (_sk && _sk->isRSA()) {
     br_ssl_client_set_single_rsa(_sc.get(), _chain ? _chain->getX509Certs() : nullptr, _chain ? _chain->getCount() : 0,
@@ -1180,18 +1452,47 @@ bool WiFiClientSecureCtx::_connectSSL(const char* hostName) {
 #endif
   }
 
-  // Restore session from the storage spot, if present
+  // Restore session from the storage spot, if present, or from the cache
+  bool resume = false;
+  _handshake_cache = _session ? nullptr : _session_cache ? _session_cache : _default_session_cache;
+  _handshake_cache_key = 0;
   if (_session) {
     br_ssl_engine_set_session_parameters(_eng, _session->getSession());
+    resume = true;
+  } else if (_handshake_cache) {
+    _handshake_cache_key = SessionCache::_key(hostName ? hostName : remoteIP().toString().c_str(), remotePort());
+    br_ssl_session_parameters params;
+    if (_handshake_cache->_get(_handshake_cache_key, &params)) {
+      br_ssl_engine_set_session_parameters(_eng, &params);
+      resume = true;
+    }
   }
 
-  if (!br_ssl_client_reset(_sc.get(), hostName, _session?1:0)) {
+  if (!br_ssl_client_reset(_sc.get(), hostName, resume?1:0)) {
     _freeSSL();
     DEBUG_BSSL("_connectSSL: Can't reset client\n");
     return false;
   }
 
-  auto ret = _wait_for_handshake();
+  _handshaking = true;
+  _handshake_start = millis();
+  return true;
+}
+
+// Called once the handshake of _startSSL() ended, successfully or not.
+// Returns ret.
+bool WiFiClientSecureCtx::_finishSSL(bool ret) {
+  _handshaking = false;
+  _handshake_done = ret;
+  if (_handshake_cache) {
+    if (ret) {
+      br_ssl_session_parameters params;
+      br_ssl_engine_get_session_parameters(_eng, &params);
+      _handshake_cache->_put(_handshake_cache_key, &params);
+    } else {
+      _handshake_cache->_remove(_handshake_cache_key);
+    }
+  }
 #ifdef DEBUG_ESP_SSL
   if (!ret) {
     char err[256];
@@ -1210,6 +1511,10 @@ bool WiFiClientSecureCtx::_connectSSL(const char* hostName) {
   // reduce timeout after successful handshake to fail fast if server stop accepting our data for whathever reason
   if (ret) _timeout = 5000;
 
+  if (ret && (_shrink_recv || MemoryPressure.level() != HeapLevel::Nominal)) {
+    _shrinkRecvBuffer();
+  }
+
   return ret;
 }
 
@@ -1256,11 +1561,12 @@ bool WiFiClientSecureCtx::_connectSSLServerRSA(const X509List *chain,
   _sc_svr = std::make_shared<br_ssl_server_context>();
   _eng = &_sc_svr->eng; // Allocation/deallocation taken care of by the _sc shared_ptr
   _iobuf_in = _alloc_iobuf(_iobuf_in_size);
-  _iobuf_out = _alloc_iobuf(_iobuf_out_size);
+  int iobuf_out_size = _iobufOutSize();
+  _iobuf_out = _alloc_iobuf(iobuf_out_size);
   DBG_MMU_PRINTF("\n_iobuf_in:       %p\n", _iobuf_in.get());
   DBG_MMU_PRINTF(  "_iobuf_out:      %p\n", _iobuf_out.get());
   DBG_MMU_PRINTF(  "_iobuf_in_size:  %u\n", _iobuf_in_size);
-  DBG_MMU_PRINTF(  "_iobuf_out_size: %u\n", _iobuf_out_size);
+  DBG_MMU_PRINTF(  "_iobuf_out_size: %u\n", iobuf_out_size);
 
   if (!_sc_svr || !_iobuf_in || !_iobuf_out) {
     _freeSSL();
@@ -1273,7 +1579,7 @@ bool WiFiClientSecureCtx::_connectSSLServerRSA(const X509List *chain,
   br_ssl_server_set_single_rsa(_sc_svr.get(), chain ? chain->getX509Certs() : nullptr, chain ? chain->getCount() : 0,
                                sk ? sk->getRSA() : nullptr, BR_KEYTYPE_KEYX | BR_KEYTYPE_SIGN,
                                br_rsa_private_get_default(), br_rsa_pkcs1_sign_get_default());
-  br_ssl_engine_set_buffers_bidi(_eng, _iobuf_in.get(), _iobuf_in_size, _iobuf_out.get(), _iobuf_out_size);
+  br_ssl_engine_set_buffers_bidi(_eng, _iobuf_in.get(), _iobuf_in_size, _iobuf_out.get(), iobuf_out_size);
   br_ssl_engine_set_versions(_eng, _tls_min, _tls_max);
   if (cache != nullptr)
     br_ssl_server_set_cache(_sc_svr.get(), cache->getCache());
@@ -1300,11 +1606,12 @@ bool WiFiClientSecureCtx::_connectSSLServerEC(const X509List *chain,
   _sc_svr = std::make_shared<br_ssl_server_context>();
   _eng = &_sc_svr->eng; // Allocation/deallocation taken care of by the _sc shared_ptr
   _iobuf_in = _alloc_iobuf(_iobuf_in_size);
-  _iobuf_out = _alloc_iobuf(_iobuf_out_size);
+  int iobuf_out_size = _iobufOutSize();
+  _iobuf_out = _alloc_iobuf(iobuf_out_size);
   DBG_MMU_PRINTF("\n_iobuf_in:       %p\n", _iobuf_in.get());
   DBG_MMU_PRINTF(  "_iobuf_out:      %p\n", _iobuf_out.get());
   DBG_MMU_PRINTF(  "_iobuf_in_size:  %u\n", _iobuf_in_size);
-  DBG_MMU_PRINTF(  "_iobuf_out_size: %u\n", _iobuf_out_size);
+  DBG_MMU_PRINTF(  "_iobuf_out_size: %u\n", iobuf_out_size);
 
   if (!_sc_svr || !_iobuf_in || !_iobuf_out) {
     _freeSSL();
@@ -1317,7 +1624,7 @@ bool WiFiClientSecureCtx::_connectSSLServerEC(const X509List *chain,
   br_ssl_server_set_single_ec(_sc_svr.get(), chain ? chain->getX509Certs() : nullptr, chain ? chain->getCount() : 0,
                                sk ? sk->getEC() : nullptr, BR_KEYTYPE_KEYX | BR_KEYTYPE_SIGN,
                                cert_issuer_key_type, br_ssl_engine_get_ec(_eng), br_ecdsa_i15_sign_asn1);
-  br_ssl_engine_set_buffers_bidi(_eng, _iobuf_in.get(), _iobuf_in_size, _iobuf_out.get(), _iobuf_out_size);
+  br_ssl_engine_set_buffers_bidi(_eng, _iobuf_in.get(), _iobuf_in_size, _iobuf_out.get(), iobuf_out_size);
   br_ssl_engine_set_versions(_eng, _tls_min, _tls_max);
   if (cache != nullptr)
     br_ssl_server_set_cache(_sc_svr.get(), cache->getCache());
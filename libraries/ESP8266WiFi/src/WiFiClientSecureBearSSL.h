@@ -50,9 +50,24 @@ class WiFiClientSecureCtx : public WiFiClient {
     int connect(const String& host, uint16_t port) override;
     int connect(const char* name, uint16_t port) override;
 
+    // Connect the socket and start the TLS handshake without waiting for it,
+    // then call handshakePoll() (e.g. from loop()) until it returns non-zero
+    int connectAsync(IPAddress ip, uint16_t port);
+    int connectAsync(const String& host, uint16_t port);
+    int connectAsync(const char* name, uint16_t port);
+    // Advance the handshake by one record or chunk: 1 when done, 0 while
+    // in progress, -1 on failure (getLastSSLError() tells why)
+    int handshakePoll();
+    bool handshaking() const { return _handshaking; }
+
     uint8_t connected() override;
     size_t write(const uint8_t *buf, size_t size) override;
+    // TLS: each buffer goes through write(buf, size), not WiFiClient's TCP path
+    size_t write(const iovec *iov, size_t iovcnt) override { return Print::write(iov, iovcnt); }
     size_t write_P(PGM_P buf, size_t size) override;
+    // TLS records are encrypted into our own buffer, nothing is referenced
+    size_t writeReference(const uint8_t *buf, size_t size) override { return write(buf, size); }
+    bool acknowledged() override { return true; }
     size_t write(Stream& stream); // Note this is not virtual
     int read(uint8_t *buf, size_t size) override;
     int read(char *buf, size_t size) { return read((uint8_t*)buf, size); }
@@ -67,9 +82,18 @@ class WiFiClientSecureCtx : public WiFiClient {
 
     int availableForWrite() override;
 
+    // Gather small writes into one TLS record: a record is sent when full, on
+    // flush(), before reading, or once flushDelayMs have passed (0 disables)
+    void setWriteCoalescing(uint32_t flushDelayMs);
+
     // Allow sessions to be saved/restored automatically to a memory area
     void setSession(Session *session) { _session = session; }
 
+    // Or take the session from, and keep it in, a cache of sessions keyed by
+    // host and port.  The default cache is used by all clients without one
+    void setSessionCache(SessionCache *cache) { _session_cache = cache; }
+    static void setDefaultSessionCache(SessionCache *cache) { _default_session_cache = cache; }
+
     // Don't validate the chain, just accept whatever is given.  VERY INSECURE!
     void setInsecure() {
       _clearAuthenticationSettings();
@@ -81,6 +105,12 @@ class WiFiClientSecureCtx : public WiFiClient {
       _knownkey = pk;
       _knownkey_usages = usages;
     }
+    // Same as setKnownKey(), and for an EC key, only offer the key's curve
+    // for the key exchange so the whole handshake runs the curve-specific code
+    void setPinnedKey(const PublicKey *pk, unsigned usages = BR_KEYTYPE_KEYX | BR_KEYTYPE_SIGN) {
+      setKnownKey(pk, usages);
+      _knownkey_pin_curve = true;
+    }
     // Only check SHA1 fingerprint of certificate
     bool setFingerprint(const uint8_t fingerprint[20]) {
       _clearAuthenticationSettings();
@@ -116,6 +146,17 @@ class WiFiClientSecureCtx : public WiFiClient {
       return connected() && br_ssl_engine_get_mfln_negotiated(_eng);
     }
 
+    // Take the buffers from a pool on connect, giving them back on stop
+    void setBufferPool(TLSBufferPool *pool) {
+      _buffer_pool = pool;
+    }
+
+    // After the handshake, if MFLN was negotiated, reduce the receive buffer
+    // to the negotiated fragment length
+    void setRecvBufferShrink(bool shrink) {
+      _shrink_recv = shrink;
+    }
+
     // Return an error code and possibly a text string in a passed-in buffer with last SSL failure
     int getLastSSLError(char *dest = NULL, size_t len = 0);
 
@@ -147,8 +188,13 @@ class WiFiClientSecureCtx : public WiFiClient {
     // consume bytes after use (see peekBuffer)
     virtual void peekConsume (size_t consume) override;
 
+    // decrypted data is a single segment
+    virtual size_t peekSegments (iovec* iov, size_t iovcnt) override;
+
   protected:
     bool _connectSSL(const char *hostName); // Do initial SSL handshake
+    bool _startSSL(const char *hostName); // Set up the engine for _connectSSL or connectAsync
+    bool _finishSSL(bool ret); // After the handshake, successful or not
 
   private:
     void _clear();
@@ -170,12 +216,32 @@ class WiFiClientSecureCtx : public WiFiClient {
     CertStoreBase *_certStore;
     int _iobuf_in_size;
     int _iobuf_out_size;
+    TLSBufferPool *_buffer_pool;
+    bool _shrink_recv;
     bool _handshake_done;
+    bool _handshaking; // connectAsync() handshake in progress
+    unsigned long _handshake_start;
+    SessionCache *_handshake_cache;
+    uint32_t _handshake_cache_key;
     bool _oom_err;
 
+    // Write coalescing, see setWriteCoalescing()
+    uint32_t _coalesce_ms;
+    bool _write_pending; // the sendapp buffer holds plaintext not yet in a record
+    unsigned long _write_pending_since;
+    WiFiClientSecureCtx *_pending_next;
+    static WiFiClientSecureCtx *_pending_head;
+    static bool _pending_scheduled;
+    void _listPending();
+    void _unlistPending();
+    static void _flushExpired();
+
     // Optional storage space pointer for session parameters
     // Will be used on connect and updated on close
     Session *_session;
+    // Otherwise the optional cache, updated after the handshake
+    SessionCache *_session_cache;
+    static SessionCache *_default_session_cache;
 
     bool _use_insecure;
     bool _use_fingerprint;
@@ -183,6 +249,10 @@ class WiFiClientSecureCtx : public WiFiClient {
     bool _use_self_signed;
     const PublicKey *_knownkey;
     unsigned _knownkey_usages;
+    bool _knownkey_pin_curve;
+#ifndef BEARSSL_SSL_BASIC
+    br_ec_impl _pinned_ec; // the default implementation limited to the pinned key's curve
+#endif
 
     // Custom cipher list pointer or NULL if default
     std::shared_ptr<uint16_t> _cipher_list;
@@ -203,6 +273,8 @@ class WiFiClientSecureCtx : public WiFiClient {
     bool _engineConnected(); // Are both socket and the bearssl engine alive?
 
     std::shared_ptr<unsigned char> _alloc_iobuf(size_t sz);
+    int _iobufOutSize() const;
+    void _shrinkRecvBuffer();
     void _freeSSL();
     int _run_until(unsigned target, bool blocking = true);
     size_t _write(const uint8_t *buf, size_t size, bool pmem);
@@ -267,20 +339,33 @@ class WiFiClientSecure : public WiFiClient {
     int connect(const String& host, uint16_t port) override { return _ctx->connect(host, port); }
     int connect(const char* name, uint16_t port) override { return _ctx->connect(name, port); }
 
+    // Connect the socket and start the TLS handshake without waiting for it,
+    // then call handshakePoll() (e.g. from loop()) until it returns non-zero
+    int connectAsync(IPAddress ip, uint16_t port) { return _ctx->connectAsync(ip, port); }
+    int connectAsync(const String& host, uint16_t port) { return _ctx->connectAsync(host, port); }
+    int connectAsync(const char* name, uint16_t port) { return _ctx->connectAsync(name, port); }
+    int handshakePoll() { return _ctx->handshakePoll(); }
+    bool handshaking() const { return _ctx->handshaking(); }
+
     uint8_t connected() override { return _ctx->connected(); }
     size_t write(const uint8_t *buf, size_t size) override { return _ctx->write(buf, size); }
+    size_t write(const iovec *iov, size_t iovcnt) override { return _ctx->write(iov, iovcnt); }
     size_t write_P(PGM_P buf, size_t size) override { return _ctx->write_P(buf, size); }
+    size_t writeReference(const uint8_t *buf, size_t size) override { return _ctx->writeReference(buf, size); }
+    bool acknowledged() override { return _ctx->acknowledged(); }
     size_t write(const char *buf) { return write((const uint8_t*)buf, strlen(buf)); }
     size_t write_P(const char *buf) { return write_P((PGM_P)buf, strlen_P(buf)); }
     size_t write(Stream& stream) /* Note this is not virtual */ { return _ctx->write(stream); }
     int read(uint8_t *buf, size_t size) override { return _ctx->read(buf, size); }
     int available() override { return _ctx->available(); }
     int availableForWrite() override { return _ctx->availableForWrite(); }
+    void setWriteCoalescing(uint32_t flushDelayMs) { _ctx->setWriteCoalescing(flushDelayMs); }
     int read() override { return _ctx->read(); }
     int peek() override { return _ctx->peek(); }
     size_t peekBytes(uint8_t *buffer, size_t length) override { return _ctx->peekBytes(buffer, length); }
     bool flush(unsigned int maxWaitMs) { return _ctx->flush(maxWaitMs); }
     bool stop(unsigned int maxWaitMs) { return _ctx->stop(maxWaitMs); }
+    bool getTcpStats(WiFiClientTcpStats& stats) const /* Note this is not virtual */ { return _ctx->getTcpStats(stats); }
     void flush() override { (void)flush(0); }
     void stop() override { (void)stop(0); }
 
@@ -292,6 +377,11 @@ class WiFiClientSecure : public WiFiClient {
     // Allow sessions to be saved/restored automatically to a memory area
     void setSession(Session *session) { _ctx->setSession(session); }
 
+    // Or take the session from, and keep it in, a cache of sessions keyed by
+    // host and port.  The default cache is used by all clients without one
+    void setSessionCache(SessionCache *cache) { _ctx->setSessionCache(cache); }
+    static void setDefaultSessionCache(SessionCache *cache) { WiFiClientSecureCtx::setDefaultSessionCache(cache); }
+
     // Don't validate the chain, just accept whatever is given.  VERY INSECURE!
     void setInsecure() { _ctx->setInsecure(); }
 
@@ -299,6 +389,9 @@ class WiFiClientSecure : public WiFiClient {
     void setKnownKey(const PublicKey *pk, unsigned usages = BR_KEYTYPE_KEYX | BR_KEYTYPE_SIGN) {
       _ctx->setKnownKey(pk, usages);
     }
+    void setPinnedKey(const PublicKey *pk, unsigned usages = BR_KEYTYPE_KEYX | BR_KEYTYPE_SIGN) {
+      _ctx->setPinnedKey(pk, usages);
+    }
     // Only check SHA1 fingerprint of certificate
     bool setFingerprint(const uint8_t fingerprint[20]) {
       return _ctx->setFingerprint(fingerprint);
@@ -324,6 +417,13 @@ class WiFiClientSecure : public WiFiClient {
     // Returns whether MFLN negotiation for the above buffer sizes succeeded (after connection)
     int getMFLNStatus() { return _ctx->getMFLNStatus(); }
 
+    // Take the buffers from a pool on connect, giving them back on stop
+    void setBufferPool(TLSBufferPool *pool) { _ctx->setBufferPool(pool); }
+
+    // After the handshake, if MFLN was negotiated, reduce the receive buffer
+    // to the negotiated fragment length, as done anyway under MemoryPressure
+    void setRecvBufferShrink(bool shrink) { _ctx->setRecvBufferShrink(shrink); }
+
     // Return an error code and possibly a text string in a passed-in buffer with last SSL failure
     int getLastSSLError(char *dest = NULL, size_t len = 0) { return _ctx->getLastSSLError(dest, len); }
 
@@ -358,6 +458,8 @@ class WiFiClientSecure : public WiFiClient {
     // consume bytes after use (see peekBuffer)
     virtual void peekConsume (size_t consume) override { return _ctx->peekConsume(consume); }
 
+    virtual size_t peekSegments (iovec* iov, size_t iovcnt) override { return _ctx->peekSegments(iov, iovcnt); }
+
   private:
     std::shared_ptr<WiFiClientSecureCtx> _ctx;
 
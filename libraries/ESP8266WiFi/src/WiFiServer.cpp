@@ -34,11 +34,86 @@ extern "C" {
 #include "lwip/tcp.h"
 #include "lwip/inet.h"
 #include <include/ClientContext.h>
+#include <include/NetworkActivity.h>
+#include <Schedule.h>
 
 #ifndef MAX_PENDING_CLIENTS_PER_PORT
 #define MAX_PENDING_CLIENTS_PER_PORT 5
 #endif
 
+// fixed storage for ClientContexts built in place by _accept()
+// slots are taken from lwIP context and given back from user context,
+// which do not preempt each other
+class ClientContextPool
+{
+public:
+    static ClientContextPool* create(size_t count)
+    {
+        ClientContextPool* pool = new (std::nothrow) ClientContextPool;
+        if (!pool)
+            return nullptr;
+        pool->_slots = new (std::nothrow) Slot[count];
+        if (!pool->_slots) {
+            delete pool;
+            return nullptr;
+        }
+        for (size_t i = 0; i < count; i++) {
+            pool->_slots[i].next = pool->_free;
+            pool->_free = &pool->_slots[i];
+        }
+        return pool;
+    }
+
+    void* take()
+    {
+        Slot* slot = _free;
+        if (slot) {
+            _free = slot->next;
+            ++_used;
+        }
+        return slot;
+    }
+
+    // the owner is gone, delete when last slot is back
+    void orphan()
+    {
+        _orphaned = true;
+        if (!_used)
+            delete this;
+    }
+
+    static void s_give(void* pool, ClientContext* ctx)
+    {
+        reinterpret_cast<ClientContextPool*>(pool)->_give(ctx);
+    }
+
+protected:
+    union Slot
+    {
+        alignas(ClientContext) uint8_t storage[sizeof(ClientContext)];
+        Slot* next;
+    };
+
+    ~ClientContextPool()
+    {
+        delete [] _slots;
+    }
+
+    void _give(void* storage)
+    {
+        Slot* slot = reinterpret_cast<Slot*>(storage);
+        slot->next = _free;
+        _free = slot;
+        if (!--_used && _orphaned)
+            delete this;
+    }
+
+    Slot* _slots = nullptr;
+    Slot* _free = nullptr;
+    size_t _used = 0;
+    bool _orphaned = false;
+};
+
 WiFiServer::WiFiServer(const IPAddress& addr, uint16_t port)
 : _port(port)
 , _addr(addr)
@@ -51,6 +126,12 @@ WiFiServer::WiFiServer(uint16_t port)
 {
 }
 
+WiFiServer::~WiFiServer() {
+    close();
+    if (_pool)
+        _pool->orphan();
+}
+
 void WiFiServer::begin() {
 	begin(_port);
 }
@@ -59,6 +140,20 @@ void WiFiServer::begin(uint16_t port) {
     return begin(port, MAX_PENDING_CLIENTS_PER_PORT);
 }
 
+void WiFiServer::begin(uint16_t port, uint8_t backlog, uint16_t clientPool) {
+    if (_pool) {
+        // contexts still in use keep their storage
+        _pool->orphan();
+        _pool = nullptr;
+    }
+    if (clientPool) {
+        _pool = ClientContextPool::create(clientPool);
+        if (!_pool)
+            return;
+    }
+    begin(port, backlog);
+}
+
 void WiFiServer::begin(uint16_t port, uint8_t backlog) {
     close();
     if (!backlog)
@@ -84,6 +179,7 @@ void WiFiServer::begin(uint16_t port, uint8_t backlog) {
     }
     _listen_pcb = listen_pcb;
     _port = _listen_pcb->local_port;
+    _alive = std::make_shared<bool>(true);
     tcp_accept(listen_pcb, &WiFiServer::_s_accept);
     tcp_arg(listen_pcb, (void*) this);
 }
@@ -162,6 +258,13 @@ uint16_t WiFiServer::port() const {
 }
 
 void WiFiServer::close() {
+    // accepted clients may outlive this server: their notifications and
+    // the calls already scheduled are disarmed by the token
+    _alive.reset();
+    _acceptPending = false;
+    _dataPending = false;
+    for (ClientContext* c = _unclaimed; c; c = c->next())
+        c->setRxNotify(nullptr);
     if (!_listen_pcb) {
       return;
     }
@@ -187,10 +290,24 @@ T* slist_append_tail(T* head, T* item) {
 err_t WiFiServer::_accept(tcp_pcb* apcb, err_t err) {
     (void) err;
     DEBUGV("WS:ac\r\n");
+    esp8266::network::noteActivity();
 
     // always accept new PCB so incoming data can be stored in our buffers even before
     // user calls ::available()
-    ClientContext* client = new ClientContext(apcb, &WiFiServer::_s_discard, this);
+    ClientContext* client;
+    if (_pool) {
+        void* storage = _pool->take();
+        if (!storage) {
+            // pool exhausted, refuse instead of allocating
+            DEBUGV("WS:full\r\n");
+            tcp_abort(apcb);
+            return ERR_ABRT;
+        }
+        client = new (storage) ClientContext(apcb, &WiFiServer::_s_discard, this);
+        client->setRelease(&ClientContextPool::s_give, _pool);
+    } else {
+        client = new ClientContext(apcb, &WiFiServer::_s_discard, this);
+    }
 
     // backlog doc:
     // http://lwip.100.n7.nabble.com/Problem-re-opening-listening-pbc-tt32484.html#a32494
@@ -201,9 +318,39 @@ err_t WiFiServer::_accept(tcp_pcb* apcb, err_t err) {
 
     _unclaimed = slist_append_tail(_unclaimed, client);
 
+    std::weak_ptr<bool> alive = _alive;
+    if (_onData) {
+        client->setRxNotify([this, alive]() {
+            if (!alive.expired())
+                _rx();
+        });
+    }
+    if (_onAccept && !_acceptPending) {
+        _acceptPending = schedule_function([this, alive]() {
+            if (alive.expired())
+                return;
+            _acceptPending = false;
+            if (_onAccept)
+                _onAccept();
+        });
+    }
+
     return ERR_OK;
 }
 
+void WiFiServer::_rx() {
+    if (_onData && !_dataPending) {
+        std::weak_ptr<bool> alive = _alive;
+        _dataPending = schedule_function([this, alive]() {
+            if (alive.expired())
+                return;
+            _dataPending = false;
+            if (_onData)
+                _onData();
+        });
+    }
+}
+
 void WiFiServer::_discard(ClientContext* client) {
     (void) client;
     // _discarded = slist_append_tail(_discarded, client);
@@ -31,6 +31,8 @@ extern "C" {
 #include <Server.h>
 #include <IPAddress.h>
 #include <lwip/err.h>
+#include <functional>
+#include <memory>
 
 // lwIP-v2 backlog facility allows to keep memory safe by limiting the
 // maximum number of incoming *pending clients*.  Default number of possibly
@@ -64,6 +66,7 @@ extern "C" {
 // answers to newcomers (until the "backlog" pending list is full again).
 
 class ClientContext;
+class ClientContextPool;
 class WiFiClient;
 
 class WiFiServer {
@@ -75,12 +78,21 @@ protected:
 
   ClientContext* _unclaimed = nullptr;
   ClientContext* _discarded = nullptr;
+  ClientContextPool* _pool = nullptr;
   enum { _ndDefault, _ndFalse, _ndTrue } _noDelay = _ndDefault;
 
+  std::function<void(void)> _onAccept;
+  std::function<void(void)> _onData;
+  bool _acceptPending = false;
+  bool _dataPending = false;
+  // weak token for the deferred calls and client notifications,
+  // they do nothing once it is reset by close() or the destructor
+  std::shared_ptr<bool> _alive;
+
 public:
   WiFiServer(const IPAddress& addr, uint16_t port);
   WiFiServer(uint16_t port);
-  virtual ~WiFiServer() {}
+  virtual ~WiFiServer();
   WiFiClient accept(); // https://www.arduino.cc/en/Reference/EthernetServerAccept
   WiFiClient available(uint8_t* status = NULL) __attribute__((deprecated("Renamed to accept().")));
   bool hasClient();
@@ -94,10 +106,23 @@ public:
   void begin();
   void begin(uint16_t port);
   void begin(uint16_t port, uint8_t backlog);
+  // clientPool: number of client contexts allocated here at once, accepting
+  // is then allocation-free and connections beyond are refused (0: no pool)
+  void begin(uint16_t port, uint8_t backlog, uint16_t clientPool);
   void setNoDelay(bool nodelay);
   bool getNoDelay();
   uint8_t status();
   uint16_t port() const;
+
+  // Event callbacks, instead of polling hasClient()/accept() from loop():
+  // onAccept() is called after lwIP accepted a new client,
+  // onData() is called after data or a close were received by a client of
+  // this server (pending or already accepted).
+  // They are deferred from lwIP context through schedule_function() (run
+  // after loop() returns), several events before that make a single call.
+  // None is made after close() or the server's destruction.
+  void onAccept(std::function<void(void)> cb) { _onAccept = cb; }
+  void onData(std::function<void(void)> cb) { _onData = cb; }
   void close();
   void stop();
 
@@ -106,6 +131,7 @@ public:
 protected:
   err_t  _accept(tcp_pcb* newpcb, err_t err);
   void   _discard(ClientContext* client);
+  void   _rx();
 
   static err_t _s_accept(void *arg, tcp_pcb* newpcb, err_t err);
   static void _s_discard(void* server, ClientContext* ctx);
@@ -71,6 +71,21 @@ void WiFiServerSecure::setECCert(const X509List *chain, unsigned cert_issuer_key
   _sk = sk;
 }
 
+bool WiFiServerSecure::setCache(uint32_t sessions) {
+  _cache = nullptr;
+  _ownCache = nullptr;
+  if (!sessions) {
+    return true;
+  }
+  _ownCache = std::make_shared<ServerSessions>(sessions);
+  if (!_ownCache || !_ownCache->size()) {
+    _ownCache = nullptr;
+    return false;
+  }
+  _cache = _ownCache.get();
+  return true;
+}
+
 // Return a client if there's an available connection waiting.  If one is returned,
 // then any validation (i.e. client cert checking) will have succeeded.
 WiFiClientSecure WiFiServerSecure::available(uint8_t* status) {
@@ -45,8 +45,13 @@ class WiFiServerSecure : public WiFiServer {
     // Sets the server's cache to the given one.
     void setCache(ServerSessions *cache) {
       _cache = cache;
+      _ownCache = nullptr;
     }
 
+    // Allocates a cache for the given number of sessions, owned by the
+    // server (and shared with its copies).  0 removes the cache.
+    bool setCache(uint32_t sessions);
+
     // Set the server's RSA key and x509 certificate (required, pick one).
     // Caller needs to preserve the chain and key throughout the life of the server.
     void setRSACert(const X509List *chain, const PrivateKey *sk);
@@ -80,6 +85,7 @@ class WiFiServerSecure : public WiFiServer {
     int _iobuf_out_size = 837;
     const X509List *_client_CA_ta = nullptr;
     ServerSessions *_cache = nullptr;
+    std::shared_ptr<ServerSessions> _ownCache;
 
     // TLS ciphers allowed
     uint32_t _tls_min = BR_TLS10;
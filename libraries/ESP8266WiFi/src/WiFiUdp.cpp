@@ -175,6 +175,23 @@ int WiFiUDP::endPacket()
     return (_ctx->send()) ? 1 : 0;
 }
 
+int WiFiUDP::queuePacket(IPAddress ip, uint16_t port, const uint8_t *buffer, size_t size)
+{
+    if (!_ctx) {
+        _ctx = new UdpContext;
+        _ctx->ref();
+    }
+    return _ctx->queue(ip, port, reinterpret_cast<const char*>(buffer), size) ? 1 : 0;
+}
+
+size_t WiFiUDP::sendQueued()
+{
+    if (!_ctx)
+        return 0;
+
+    return _ctx->sendQueued();
+}
+
 size_t WiFiUDP::write(uint8_t byte)
 {
     return write(&byte, 1);
@@ -188,6 +205,25 @@ size_t WiFiUDP::write(const uint8_t *buffer, size_t size)
     return _ctx->append(reinterpret_cast<const char*>(buffer), size);
 }
 
+void WiFiUDP::setRxQueue(size_t maxPackets, size_t maxBytes, bool dropOldest)
+{
+    if (_ctx)
+        _ctx->setRxQueue(maxPackets, maxBytes, dropOldest);
+}
+
+void WiFiUDP::getRxStats(uint32_t& received, uint32_t& dropped, uint32_t& maxDepth) const
+{
+    received = dropped = maxDepth = 0;
+    if (_ctx)
+        _ctx->getRxStats(received, dropped, maxDepth);
+}
+
+void WiFiUDP::resetRxStats()
+{
+    if (_ctx)
+        _ctx->resetRxStats();
+}
+
 int WiFiUDP::parsePacket()
 {
     if (!_ctx)
@@ -225,6 +261,14 @@ int WiFiUDP::peek()
     return _ctx->peek();
 }
 
+const uint8_t* WiFiUDP::peekPacket(uint8_t* buffer, size_t size) const
+{
+    if (!_ctx)
+        return nullptr;
+
+    return reinterpret_cast<const uint8_t*>(_ctx->peekDatagram(reinterpret_cast<char*>(buffer), size));
+}
+
 void WiFiUDP::flush()
 {
     endPacket();
@@ -77,6 +77,14 @@ public:
   
   using Print::write;
 
+  // Batch sending, for many small datagrams:
+  // queuePacket() copies a whole datagram into a pooled buffer,
+  // sendQueued() sends all queued datagrams and recycles their buffers.
+  // Returns 1 if the datagram was queued, 0 on memory error
+  int queuePacket(IPAddress ip, uint16_t port, const uint8_t *buffer, size_t size);
+  // Returns the number of datagrams sent
+  size_t sendQueued();
+
   // Start processing the next available incoming packet
   // Returns the size of the packet in bytes, or 0 if no packets are available
   int parsePacket() override;
@@ -92,8 +100,19 @@ public:
   int read(char* buffer, size_t len) override { return read((unsigned char*)buffer, len); };
   // Return the next byte from the current packet without moving on to the next byte
   int peek() override;
+  // The whole current packet, in place when it is in one piece or copied to
+  // buffer.  Returns nullptr when there is no packet or buffer is too small
+  const uint8_t* peekPacket(uint8_t* buffer = nullptr, size_t size = 0) const;
   void flush() override;	// wait for all outgoing characters to be sent, output buffer is empty after this call
 
+  // Bound the incoming packet queue (after begin()), default is 4 packets:
+  // a packet arriving when maxPackets (or, when not 0, maxBytes) are queued
+  // is dropped, or the oldest unread ones are dropped when dropOldest is set
+  void setRxQueue(size_t maxPackets, size_t maxBytes = 0, bool dropOldest = false);
+  // received and dropped packets, and highest queue depth, since begin()
+  void getRxStats(uint32_t& received, uint32_t& dropped, uint32_t& maxDepth) const;
+  void resetRxStats();
+
   // Return the IP address of the host who sent the current incoming packet
   IPAddress remoteIP() override;
   // Return the port of the host who sent the current incoming packet
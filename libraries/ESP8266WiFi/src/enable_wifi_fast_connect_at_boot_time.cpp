@@ -0,0 +1,24 @@
+/*
+ *  empty wrappers to play with linker and start the WiFi association at boot time
+ */
+
+#include "coredecls.h"
+
+#include <ESP8266WiFi.h>
+
+extern "C" void enableWiFiFastConnectAtBootTime()
+{
+    /*
+     * Called by user from anywhere, does nothing and allows overriding
+     * the core_esp8266_main.cpp's default __wifiAssociateAtBootTime() by the
+     * one below, at link time.
+     */
+}
+
+extern "C" void __wifiAssociateAtBootTime()
+{
+    // overrides the default __wifiAssociateAtBootTime:
+    // called from init_done(), c++ ctors are called at this point but
+    // setup() is not: the association goes on while setup() runs
+    ESP8266WiFiSTAClass::_beginAtBootTime();
+}
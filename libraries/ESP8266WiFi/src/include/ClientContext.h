@@ -27,8 +27,13 @@ class WiFiClient;
 typedef void (*discard_cb_t)(void*, ClientContext*);
 
 #include <assert.h>
+#include <memory>
 #include <esp_priv.h>
 #include <coredecls.h>
+#include <Schedule.h>
+#include <PolledTimeout.h>
+#include <lwip/priv/tcp_priv.h> // tcp_seg
+#include "NetworkActivity.h"
 
 bool getDefaultPrivateGlobalSyncValue ();
 
@@ -55,6 +60,13 @@ public:
         return _pcb;
     }
 
+    // rx_cb() is called from lwIP context
+    // when data or the peer's close are received (nullptr: none)
+    void setRxNotify (std::function<void(void)> rx_cb)
+    {
+        _rx_cb = std::move(rx_cb);
+    }
+
     err_t abort()
     {
         if(_pcb) {
@@ -73,7 +85,15 @@ public:
     err_t close()
     {
         err_t err = ERR_OK;
+        if(!_flush_held()) {
+            wait_until_acked();
+        }
         if(_pcb) {
+            if(!acknowledged() && !(wait_until_acked() && acknowledged())) {
+                // lwIP would keep reading referenced data after tcp_close()
+                DEBUGV(":close ref\r\n");
+                return abort();
+            }
             DEBUGV(":close\r\n");
             tcp_arg(_pcb, NULL);
             tcp_sent(_pcb, NULL);
@@ -122,10 +142,26 @@ public:
                 _discard_cb(_discard_cb_arg, this);
             }
             DEBUGV(":del\r\n");
-            delete this;
+            if(_release_cb) {
+                // storage was not allocated with new
+                auto release_cb = _release_cb;
+                auto release_arg = _release_arg;
+                this->~ClientContext();
+                release_cb(release_arg, this);
+            } else {
+                delete this;
+            }
         }
     }
 
+    // when constructed in place (placement new), release_cb(release_arg, this)
+    // gets back the storage after destruction, instead of delete
+    void setRelease(discard_cb_t release_cb, void* release_arg)
+    {
+        _release_cb = release_cb;
+        _release_arg = release_arg;
+    }
+
     int connect(ip_addr_t* addr, uint16_t port)
     {
         // note: not using `const ip_addr_t* addr` because
@@ -143,6 +179,7 @@ public:
         }
         _connect_pending = true;
         _op_start_time = millis();
+        _connect_ms = 0;
         // will resume on timeout or when _connected or _notify_error fires
         esp_delay(_timeout_ms, [this]() { return this->_connect_pending; });
         _connect_pending = false;
@@ -160,7 +197,7 @@ public:
 
     size_t availableForWrite() const
     {
-        return _pcb? tcp_sndbuf(_pcb): 0;
+        return _pcb? std::max<int>(0, (int)tcp_sndbuf(_pcb) - (int)_hold_len): 0;
     }
 
     void setNoDelay(bool nodelay)
@@ -183,6 +220,70 @@ public:
         return tcp_nagle_disabled(_pcb);
     }
 
+    // while corked, writes smaller than a segment are held until uncorked,
+    // larger ones are sent
+    void setCork(bool cork)
+    {
+        _cork = cork;
+        if(!cork && !_flush_held()) {
+            // no room in lwIP yet
+            _arm_batch(_batch_us);
+        }
+    }
+
+    bool getCork() const
+    {
+        return _cork;
+    }
+
+    // adaptive batching: writes are held until following ones fill a
+    // segment, or until batch_us microseconds after the first (0: off)
+    void setBatchDelayUs(uint32_t batch_us)
+    {
+        _batch_us = batch_us;
+    }
+
+    uint32_t getBatchDelayUs() const
+    {
+        return _batch_us;
+    }
+
+    // number of write() calls with data, and of TCP segments created for them
+    void getWriteStats(uint32_t& writes, uint32_t& segments) const
+    {
+        writes = _stat_writes;
+        segments = _stat_segments;
+    }
+
+    void resetWriteStats()
+    {
+        _stat_writes = 0;
+        _stat_segments = 0;
+    }
+
+    bool getTcpStats(WiFiClientTcpStats& stats) const
+    {
+        stats = WiFiClientTcpStats();
+        stats.bytesIn = _rcv_total;
+        stats.bytesOut = _snd_acked;
+        stats.connectMs = _connect_ms;
+        stats.firstByteMs = _ttfb_ms;
+        if (!_pcb) {
+            return false;
+        }
+        // estimators are kept in slow timer ticks, sa scaled by 8
+        stats.rttMs = (_pcb->sa >> 3) * TCP_SLOW_INTERVAL;
+        stats.rtoMs = _pcb->rto * TCP_SLOW_INTERVAL;
+        stats.retransmits = _pcb->nrtx;
+        stats.cwnd = _pcb->cwnd;
+        stats.ssthresh = _pcb->ssthresh;
+        stats.sndWnd = _pcb->snd_wnd;
+        stats.sndBufUsed = TCP_SND_BUF - tcp_sndbuf(_pcb);
+        stats.sndQueueLen = tcp_sndqueuelen(_pcb);
+        stats.mss = tcp_mss(_pcb);
+        return true;
+    }
+
     void setTimeout(int timeout_ms)
     {
         _timeout_ms = timeout_ms;
@@ -336,8 +437,9 @@ public:
                 return false;
             }
 
-            // force lwIP to send what can be sent
-            tcp_output(_pcb);
+            // force lwIP to send what can be sent, held bytes included
+            if (!_hold_len || !_flush_held())
+                tcp_output(_pcb);
 
             int sndbuf = tcp_sndbuf(_pcb);
             if (sndbuf != prevsndbuf) {
@@ -349,7 +451,7 @@ public:
 
             esp_yield(); // from sys or os context
 
-            if ((state() != ESTABLISHED) || (sndbuf == TCP_SND_BUF)) {
+            if ((state() != ESTABLISHED) || (sndbuf == TCP_SND_BUF && !_hold_len)) {
                 // peer has closed or all bytes are sent and acked
                 // ((TCP_SND_BUF-sndbuf) is the amount of un-acked bytes)
                 break;
@@ -375,7 +477,36 @@ public:
         if (!_pcb) {
             return 0;
         }
-        return _write_from_source(ds, dl);
+        Print::iovec iov = { ds, dl };
+        return _write_from_source(&iov, 1);
+    }
+
+    // all buffers are queued to lwIP before tcp_output(),
+    // so small fragments share segments instead of being pushed one by one
+    size_t write(const Print::iovec* iov, size_t iovcnt)
+    {
+        if (!_pcb) {
+            return 0;
+        }
+        return _write_from_source(iov, iovcnt);
+    }
+
+    // zero-copy write, lwIP sends and retransmits ds in place
+    // ds must stay valid and unchanged until acknowledged()
+    // data out of DRAM (flash) is copied, lwIP reads it byte-wise
+    size_t writeReference(const char* ds, const size_t dl)
+    {
+        if (!_pcb) {
+            return 0;
+        }
+        Print::iovec iov = { ds, dl };
+        return _write_from_source(&iov, 1, true);
+    }
+
+    // true when all data given to writeReference() are acknowledged by peer
+    bool acknowledged() const
+    {
+        return !_pcb || (int32_t)(_snd_acked - _ref_end) >= 0;
     }
 
     void keepAlive (uint16_t idle_sec = TCP_DEFAULT_KEEPALIVE_IDLE_SEC, uint16_t intv_sec = TCP_DEFAULT_KEEPALIVE_INTERVAL_SEC, uint8_t count = TCP_DEFAULT_KEEPALIVE_COUNT)
@@ -437,12 +568,29 @@ public:
         return _rx_buf->len - _rx_buf_offset;
     }
 
-    // consume bytes after use (see peekBuffer)
+    // consume bytes after use (see peekBuffer, peekSegments)
     void peekConsume (size_t consume)
     {
         _consume(consume);
     }
 
+    // fill iov[] with the received data in place, one entry per pbuf
+    // return the number of entries used
+    // valid until peekConsume(), which may span several entries
+    size_t peekSegments (Print::iovec* iov, size_t iovcnt) const
+    {
+        size_t n = 0;
+        size_t offset = _rx_buf_offset;
+        for (const pbuf* p = _rx_buf; p && n < iovcnt; p = p->next, offset = 0) {
+            if (p->len > offset) {
+                iov[n].iov_base = (const char*)p->payload + offset;
+                iov[n].iov_len = p->len - offset;
+                ++n;
+            }
+        }
+        return n;
+    }
+
 protected:
 
     bool _is_timeout()
@@ -460,13 +608,29 @@ protected:
         }
     }
 
-    size_t _write_from_source(const char* ds, const size_t dl)
+    size_t _write_from_source(const Print::iovec* iov, size_t iovcnt, bool reference = false)
     {
         assert(_datasource == nullptr);
         assert(!_send_waiting);
-        _datasource = ds;
-        _datalen = dl;
+        _datalen = 0;
+        for (size_t i = 0; i < iovcnt; i++)
+            _datalen += iov[i].iov_len;
+        if (!_datalen)
+            return 0;
+        esp8266::network::noteActivity();
+        _datasource = iov;
+        _dataoffset = 0;
+        _dataref = reference;
         _written = 0;
+        ++_stat_writes;
+        if (!_first_write_time) {
+            _first_write_time = std::max<uint32_t>(millis(), 1);
+        }
+        if (_hold(iov, iovcnt)) {
+            size_t held = _datalen;
+            _datalen = 0;
+            return held;
+        }
         _op_start_time = millis();
         do {
             if (_write_some()) {
@@ -503,15 +667,27 @@ protected:
         DEBUGV(":wr %d %d\r\n", _datalen - _written, _written);
 
         bool has_written = false;
+        if (_hold_len) {
+            // held bytes go first, the new data follows them
+            if (!_queue_held())
+                return false;
+            has_written = true;
+        }
+        size_t segs = _unsent_segments();
 
         while (_written < _datalen) {
             if (state() == CLOSED)
                 return false;
+            // skip exhausted or empty buffers, one with data is ahead
+            while (_dataoffset == _datasource->iov_len) {
+                ++_datasource;
+                _dataoffset = 0;
+            }
             const auto remaining = _datalen - _written;
-            size_t next_chunk_size = std::min((size_t)tcp_sndbuf(_pcb), remaining);
+            size_t next_chunk_size = std::min((size_t)tcp_sndbuf(_pcb), _datasource->iov_len - _dataoffset);
             if (!next_chunk_size)
                 break;
-            const char* buf = _datasource + _written;
+            const char* buf = (const char*)_datasource->iov_base + _dataoffset;
 
             uint8_t flags = 0;
             if (next_chunk_size < remaining)
@@ -521,9 +697,10 @@ protected:
                 //   #5173: windows needs this flag
                 //   more info: https://lists.gnu.org/archive/html/lwip-users/2009-11/msg00018.html
                 flags |= TCP_WRITE_FLAG_MORE; // do not tcp-PuSH (yet)
-            if (!_sync)
+            if (!_sync && !(_dataref && mmu_is_dram(buf)))
                 // user data must be copied when data are sent but not yet acknowledged
                 // (with sync, we wait for acknowledgment before returning to user)
+                // (with reference, user keeps data until acknowledged())
                 flags |= TCP_WRITE_FLAG_COPY;
 
             err_t err = tcp_write(_pcb, buf, next_chunk_size, flags);
@@ -532,6 +709,10 @@ protected:
 
             if (err == ERR_OK) {
                 _written += next_chunk_size;
+                _dataoffset += next_chunk_size;
+                _snd_queued += next_chunk_size;
+                if (!(flags & TCP_WRITE_FLAG_COPY))
+                    _ref_end = _snd_queued;
                 has_written = true;
             } else {
                 // ERR_MEM(-1) is a valid error meaning
@@ -542,6 +723,9 @@ protected:
 
         if (has_written)
         {
+            // tcp_write() appends to or creates segments, none is sent yet
+            _stat_segments += _unsent_segments() - segs;
+
             // lwIP's tcp_output doc: "Find out what we can send and send it"
             // *with respect to Nagle*
             // more info: https://lists.gnu.org/archive/html/lwip-users/2017-11/msg00134.html
@@ -551,6 +735,89 @@ protected:
         return has_written;
     }
 
+    size_t _unsent_segments() const
+    {
+        size_t count = 0;
+        for (const tcp_seg* seg = _pcb->unsent; seg; seg = seg->next)
+            ++count;
+        return count;
+    }
+
+    // While corked or batching, a write which still leaves room in a segment
+    // is copied here instead of to lwIP, whose ack and poll paths would
+    // otherwise send it right away.  true when held.
+    bool _hold(const Print::iovec* iov, size_t iovcnt)
+    {
+        if ((!_cork && !_batch_us) || _sync || !_pcb || _hold_len + _datalen >= std::min<size_t>(tcp_mss(_pcb), TCP_MSS))
+            return false;
+        if (!_hold_buf) {
+            _hold_buf.reset(new (std::nothrow) char[TCP_MSS]);
+            if (!_hold_buf)
+                return false;
+        }
+        for (size_t i = 0; i < iovcnt; i++) {
+            memcpy_P(_hold_buf.get() + _hold_len, iov[i].iov_base, iov[i].iov_len);
+            _hold_len += iov[i].iov_len;
+        }
+        if (!_cork)
+            _arm_batch(_batch_us);
+        return true;
+    }
+
+    // give the held bytes to lwIP, false when there is no room yet
+    bool _queue_held()
+    {
+        if (!_pcb)
+            _hold_len = 0;
+        if (!_hold_len)
+            return true;
+        size_t segs = _unsent_segments();
+        if (tcp_sndbuf(_pcb) < _hold_len || tcp_write(_pcb, _hold_buf.get(), _hold_len, TCP_WRITE_FLAG_COPY) != ERR_OK)
+            return false;
+        _stat_segments += _unsent_segments() - segs;
+        _snd_queued += _hold_len;
+        _hold_len = 0;
+        return true;
+    }
+
+    bool _flush_held()
+    {
+        if (!_hold_len)
+            return true;
+        if (!_queue_held())
+            return false;
+        if (_pcb)
+            tcp_output(_pcb);
+        return true;
+    }
+
+    void _arm_batch(uint32_t us)
+    {
+        if (_batch_scheduled)
+            return;
+        us = std::max<uint32_t>(us, 1000);
+        _batch_deadline.reset(us);
+        // keep this context alive until the deadline
+        ref();
+        _batch_scheduled = schedule_recurrent_function_us([this]() { return this->_batch_poll(); }, us);
+        if (!_batch_scheduled)
+            unref();
+    }
+
+    bool _batch_poll()
+    {
+        if (!_batch_deadline)
+            return true;
+        // corked: held until uncorked
+        if (!_cork && !_flush_held()) {
+            // retried at the next poll
+            return true;
+        }
+        _batch_scheduled = false;
+        unref();
+        return false;
+    }
+
     void _write_some_from_cb()
     {
         if (_send_waiting) {
@@ -563,32 +830,39 @@ protected:
     err_t _acked(tcp_pcb* pcb, uint16_t len)
     {
         (void) pcb;
-        (void) len;
         DEBUGV(":ack %d\r\n", len);
+        _snd_acked += len;
         _write_some_from_cb();
         return ERR_OK;
     }
 
     void _consume(size_t size)
     {
-        ptrdiff_t left = _rx_buf->len - _rx_buf_offset - size;
-        if(left > 0) {
-            _rx_buf_offset += size;
-        } else if(!_rx_buf->next) {
-            DEBUGV(":c0 %d, %d\r\n", size, _rx_buf->tot_len);
-            pbuf_free(_rx_buf);
-            _rx_buf = 0;
-            _rx_buf_offset = 0;
-        } else {
-            DEBUGV(":c %d, %d, %d\r\n", size, _rx_buf->len, _rx_buf->tot_len);
-            auto head = _rx_buf;
-            _rx_buf = _rx_buf->next;
-            _rx_buf_offset = 0;
-            pbuf_ref(_rx_buf);
-            pbuf_free(head);
+        // size may span several pbufs of the chain
+        size_t consumed = 0;
+        while(_rx_buf && consumed < size) {
+            size_t left = _rx_buf->len - _rx_buf_offset;
+            if(size - consumed < left) {
+                _rx_buf_offset += size - consumed;
+                consumed = size;
+            } else if(!_rx_buf->next) {
+                DEBUGV(":c0 %d, %d\r\n", size, _rx_buf->tot_len);
+                consumed += left;
+                pbuf_free(_rx_buf);
+                _rx_buf = 0;
+                _rx_buf_offset = 0;
+            } else {
+                DEBUGV(":c %d, %d, %d\r\n", size, _rx_buf->len, _rx_buf->tot_len);
+                consumed += left;
+                auto head = _rx_buf;
+                _rx_buf = _rx_buf->next;
+                _rx_buf_offset = 0;
+                pbuf_ref(_rx_buf);
+                pbuf_free(head);
+            }
         }
         if(_pcb)
-            tcp_recved(_pcb, size);
+            tcp_recved(_pcb, consumed);
     }
 
     err_t _recv(tcp_pcb* pcb, pbuf* pb, err_t err)
@@ -599,6 +873,7 @@ protected:
             // connection closed by peer
             DEBUGV(":rcl pb=%p sz=%d\r\n", _rx_buf, _rx_buf? _rx_buf->tot_len: -1);
             _notify_error();
+            _notify_rx();
             if (_rx_buf && _rx_buf->tot_len)
             {
                 // there is still something to read
@@ -622,9 +897,22 @@ protected:
             _rx_buf = pb;
             _rx_buf_offset = 0;
         }
+        _rcv_total += pb->tot_len;
+        esp8266::network::noteActivity();
+        if (_first_write_time && !_ttfb_ms) {
+            _ttfb_ms = std::max<uint32_t>(millis() - _first_write_time, 1);
+        }
+        _notify_rx();
         return ERR_OK;
     }
 
+    void _notify_rx()
+    {
+        if (_rx_cb) {
+            _rx_cb();
+        }
+    }
+
     void _error(err_t err)
     {
         (void) err;
@@ -643,6 +931,7 @@ protected:
         (void) pcb;
         assert(pcb == _pcb);
         if (_connect_pending) {
+            _connect_ms = std::max<uint32_t>(millis() - _op_start_time, 1);
             // resume connect
             _connect_pending = false;
             esp_schedule();
@@ -689,10 +978,30 @@ private:
 
     discard_cb_t _discard_cb;
     void* _discard_cb_arg;
+    std::function<void(void)> _rx_cb;
+    discard_cb_t _release_cb = nullptr;
+    void* _release_arg = nullptr;
 
-    const char* _datasource = nullptr;
-    size_t _datalen = 0;
+    const Print::iovec* _datasource = nullptr; // current buffer
+    size_t _dataoffset = 0;                    // written from current buffer
+    size_t _datalen = 0;                       // total of all buffers
     size_t _written = 0;
+    bool _dataref = false;                     // current source is not copied
+    uint32_t _snd_queued = 0;                  // total given to tcp_write()
+    uint32_t _snd_acked = 0;                   // total acknowledged by peer
+    uint32_t _ref_end = 0;                     // _snd_queued after last uncopied data
+    uint32_t _stat_writes = 0;
+    uint32_t _stat_segments = 0;
+    uint32_t _rcv_total = 0;
+    uint32_t _connect_ms = 0;
+    uint32_t _first_write_time = 0;            // 0: no write yet
+    uint32_t _ttfb_ms = 0;
+    uint32_t _batch_us = 0;
+    esp8266::polledTimeout::oneShotFastUs _batch_deadline { 0 };
+    bool _batch_scheduled = false;
+    bool _cork = false;
+    std::unique_ptr<char[]> _hold_buf;         // TCP_MSS bytes, see _hold()
+    uint16_t _hold_len = 0;
     uint32_t _timeout_ms = 5000;
     uint32_t _op_start_time = 0;
     bool _send_waiting = false;
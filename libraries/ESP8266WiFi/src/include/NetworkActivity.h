@@ -0,0 +1,43 @@
+/*
+  NetworkActivity.h - last time TCP/UDP traffic was seen
+
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef NETWORKACTIVITY_H
+#define NETWORKACTIVITY_H
+
+#include <Arduino.h>
+
+// Noted by ClientContext, UdpContext and WiFiServer when data is sent or
+// received, read by the sleep policy of ESP8266WiFiGenericClass.
+
+namespace esp8266
+{
+namespace network
+{
+
+extern uint32_t lastActivityMs;
+
+inline void noteActivity()
+{
+    lastActivityMs = millis();
+}
+
+} // namespace network
+} // namespace esp8266
+
+#endif // NETWORKACTIVITY_H
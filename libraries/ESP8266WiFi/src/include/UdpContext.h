@@ -29,13 +29,29 @@ void esp_schedule();
 #include <assert.h>
 }
 
+#include <new>
 #include <AddrList.h>
+#include <MemoryPressure.h>
 #include <PolledTimeout.h>
+#include "NetworkActivity.h"
 
 #define PBUF_ALIGNER_ADJUST 4
 #define PBUF_ALIGNER(x) ((void*)((((intptr_t)(x))+3)&~3))
 #define PBUF_HELPER_FLAG 0xff // lwIP pbuf flag: u8_t
 
+#ifndef UDP_RX_MAX_DATAGRAMS
+#define UDP_RX_MAX_DATAGRAMS 4 // default receive queue depth
+#endif
+#ifndef UDP_RX_MAX_BYTES
+#define UDP_RX_MAX_BYTES 0 // default receive queue bytes (0: unbounded)
+#endif
+#ifndef UDP_BATCH_MAX
+#define UDP_BATCH_MAX 16 // datagrams queued by queue() before send is forced
+#endif
+#ifndef UDP_BATCH_PBUF_SIZE
+#define UDP_BATCH_PBUF_SIZE 128 // payload size of pooled batch pbufs
+#endif
+
 class UdpContext
 {
 public:
@@ -63,6 +79,15 @@ public:
     {
         udp_remove(_pcb);
         _pcb = 0;
+        if (_batch)
+        {
+            for (size_t i = 0; i < _batch->queued; i++)
+                pbuf_free(_batch->queue[i].buf.pb);
+            for (size_t i = 0; i < _batch->pooled; i++)
+                pbuf_free(_batch->pool[i].pb);
+            delete _batch;
+            _batch = nullptr;
+        }
         if (_tx_buf_head)
         {
             pbuf_free(_tx_buf_head);
@@ -176,6 +201,34 @@ public:
 #endif
     }
 
+    // bound the receive queue to max_datagrams datagrams and,
+    // when not 0, to max_bytes bytes (payloads and address records)
+    // a datagram exceeding the bounds is dropped, or the oldest unread
+    // ones are dropped to make room for it when drop_oldest is set
+    // the datagram bound is scaled down under MemoryPressure
+    void setRxQueue(size_t max_datagrams, size_t max_bytes = 0, bool drop_oldest = false)
+    {
+        _rx_max_datagrams = max_datagrams;
+        _rx_max_bytes = max_bytes;
+        _rx_drop_oldest = drop_oldest;
+    }
+
+    // received: datagrams arrived, dropped: datagrams discarded on arrival
+    // or dropped as oldest, max_depth: highest number of queued datagrams
+    void getRxStats(uint32_t& received, uint32_t& dropped, uint32_t& max_depth) const
+    {
+        received = _rx_stat_received;
+        dropped = _rx_stat_dropped;
+        max_depth = _rx_stat_max_depth;
+    }
+
+    void resetRxStats()
+    {
+        _rx_stat_received = 0;
+        _rx_stat_dropped = 0;
+        _rx_stat_max_depth = _rx_queued;
+    }
+
     // warning: handler is called from tcp stack context
     // esp_suspend and non-reentrant functions which depend on it will fail
     void onRx(rxhandler_t handler) {
@@ -229,6 +282,23 @@ public:
         return (pos <= _rx_buf_size);
     }
 
+    // The whole current datagram, getSize() + tell() bytes whatever was read
+    // already: the pbuf payload when it is in one piece, or copied to buf
+    // (nullptr when buf is too small for it)
+    const char* peekDatagram(char* buf, size_t size) const
+    {
+        if (!_rx_buf || !_rx_buf_size)
+            return nullptr;
+
+        if (_rx_buf->len >= _rx_buf_size)
+            return (const char*)_rx_buf->payload;
+
+        if (!buf || size < _rx_buf_size)
+            return nullptr;
+
+        return (const char*)pbuf_get_contiguous(_rx_buf, buf, size, _rx_buf_size, 0);
+    }
+
     netif* getInputNetif() const
     {
         return _currentAddr.input_netif;
@@ -274,6 +344,7 @@ public:
         // in this function it is going to be discarded.
 
         auto deleteme = _rx_buf;
+        --_rx_queued;
 
         // forward in the chain until next address-info pbuf or end of chain
         while(_rx_buf && _rx_buf->flags != PBUF_HELPER_FLAG)
@@ -417,11 +488,85 @@ public:
         return err == ERR_OK;
     }
 
+    // batch send: datagrams are copied into pooled pbufs by queue()
+    // and all sent in one pass by sendQueued(), pbufs are then reused
+    // queue() sends the batch first when UDP_BATCH_MAX datagrams are queued
+    bool queue(const ip_addr_t* addr, uint16_t port, const char* data, size_t size)
+    {
+        if (!_batch)
+        {
+            _batch = new (std::nothrow) Batch;
+            if (!_batch)
+                return false;
+        }
+        if (size > 0xffff)
+            return false;
+        if (_batch->queued == UDP_BATCH_MAX)
+            sendQueued();
+
+        BatchPbuf buf = { nullptr, nullptr, 0 };
+        if (size <= UDP_BATCH_PBUF_SIZE && _batch->pooled)
+            buf = _batch->pool[--_batch->pooled];
+        else
+        {
+            size_t alloc = size <= UDP_BATCH_PBUF_SIZE? UDP_BATCH_PBUF_SIZE: size;
+            buf.pb = pbuf_alloc(PBUF_TRANSPORT, alloc, PBUF_RAM);
+            if (!buf.pb)
+            {
+                DEBUGV("failed pbuf_alloc");
+                return false;
+            }
+            buf.payload = buf.pb->payload;
+            buf.capacity = alloc;
+        }
+        // only the first size bytes are sent
+        buf.pb->len = buf.pb->tot_len = size;
+        memcpy(buf.pb->payload, data, size);
+
+        Batch::Datagram& dgram = _batch->queue[_batch->queued++];
+        dgram.buf = buf;
+        ip_addr_copy(dgram.addr, addr? *addr: _pcb->remote_ip);
+        dgram.port = addr? port: _pcb->remote_port;
+        return true;
+    }
+
+    // return the number of datagrams accepted by lwIP
+    size_t sendQueued()
+    {
+        if (!_batch)
+            return 0;
+        size_t sent = 0;
+        for (size_t i = 0; i < _batch->queued; i++)
+        {
+            BatchPbuf& buf = _batch->queue[i].buf;
+            err_t err = udp_sendto(_pcb, buf.pb, &_batch->queue[i].addr, _batch->queue[i].port);
+            if (err == ERR_OK)
+                ++sent;
+            else
+                DEBUGV(":ust rc=%d\r\n", (int) err);
+
+            // lwIP keeps a reference when the datagram waits for ARP,
+            // such pbufs and the ones larger than the pool size are released
+            if (buf.pb->ref == 1 && buf.capacity == UDP_BATCH_PBUF_SIZE)
+            {
+                // udp_sendto() has moved payload over the headers
+                buf.pb->payload = buf.payload;
+                buf.pb->len = buf.pb->tot_len = buf.capacity;
+                _batch->pool[_batch->pooled++] = buf;
+            }
+            else
+                pbuf_free(buf.pb);
+        }
+        _batch->queued = 0;
+        return sent;
+    }
+
 private:
 
     err_t trySend(const ip_addr_t* addr, uint16_t port, bool keepBufferOnError)
     {
         size_t data_size = _tx_buf_offset;
+        esp8266::network::noteActivity();
         pbuf* tx_copy = pbuf_alloc(PBUF_TRANSPORT, data_size, PBUF_RAM);
         if (tx_copy) {
             uint8_t* dst = reinterpret_cast<uint8_t*>(tx_copy->payload);
@@ -513,19 +658,22 @@ private:
             const ip_addr_t *srcaddr, u16_t srcport)
     {
         (void) upcb;
-        // check receive pbuf chain depth
-        // optimization path: cache the pbuf chain length
+        ++_rx_stat_received;
+        esp8266::network::noteActivity();
+        // check receive queue bounds
+        size_t max_datagrams = MemoryPressure.scale(_rx_max_datagrams);
+        while (_rx_queued >= max_datagrams
+               || (_rx_max_bytes && (size_t)(_rx_buf? _rx_buf->tot_len: 0) + pb->tot_len > _rx_max_bytes))
         {
-            pbuf* p;
-            int count = 0;
-            for (p = _rx_buf; p && ++count < rxBufMaxDepth*2; p = p->next);
-            if (p)
+            ++_rx_stat_dropped;
+            if (!_rx_drop_oldest || !_dropOldest())
             {
-                // pbuf chain too deep, dropping
+                // queue full, dropping
                 pbuf_free(pb);
                 DEBUGV(":udr\r\n");
                 return;
             }
+            DEBUGV(":udro\r\n");
         }
 
         // chain this helper pbuf first
@@ -549,6 +697,7 @@ private:
             if (!pb_helper)
             {
                 // memory issue - discard received data
+                ++_rx_stat_dropped;
                 pbuf_free(pb);
                 return;
             }
@@ -576,12 +725,55 @@ private:
             _rx_buf_size = pb->tot_len;
         }
 
+        if (++_rx_queued > _rx_stat_max_depth)
+            _rx_stat_max_depth = _rx_queued;
+
         if (_on_rx) {
             _on_rx();
         }
 
     }
 
+    // drop the oldest datagram not yet reached by next()
+    bool _dropOldest()
+    {
+        if (!_rx_buf)
+            return false;
+
+        if (!_first_buf_taken)
+        {
+            // the current one is not read yet
+            _first_buf_taken = true;
+            next();
+            _first_buf_taken = false;
+            return true;
+        }
+
+        // unlink the first address-info pbuf after current data
+        // up to the next address-info pbuf or end of chain
+        pbuf* prev = _rx_buf;
+        while (prev->next && prev->next->flags != PBUF_HELPER_FLAG)
+            prev = prev->next;
+        pbuf* helper = prev->next;
+        if (!helper)
+            return false;
+        pbuf* last = helper;
+        while (last->next && last->next->flags != PBUF_HELPER_FLAG)
+            last = last->next;
+        size_t removed = helper->tot_len - (last->next? last->next->tot_len: 0);
+
+        // chain lengths before it are cumulative
+        for (pbuf* p = _rx_buf; p != helper; p = p->next)
+            p->tot_len -= removed;
+        prev->next = last->next;
+        last->next = nullptr;
+
+        ((AddrHelper*)PBUF_ALIGNER(helper->payload))->~AddrHelper();
+        pbuf_free(helper);
+        --_rx_queued;
+        return true;
+    }
+
     static void _s_recv(void *arg,
             udp_pcb *upcb, pbuf *p,
             const ip_addr_t *srcaddr, u16_t srcport)
@@ -615,9 +807,35 @@ private:
     };
     AddrHelper _currentAddr;
 
-    // rx pbuf depth barrier (counter of buffered UDP received packets)
+    struct BatchPbuf
+    {
+        pbuf* pb;
+        void* payload;     // payload before udp_sendto()
+        uint16_t capacity; // allocated payload size
+    };
+    struct Batch
+    {
+        struct Datagram
+        {
+            BatchPbuf buf;
+            ip_addr_t addr;
+            uint16_t port;
+        } queue[UDP_BATCH_MAX];
+        BatchPbuf pool[UDP_BATCH_MAX];
+        size_t queued = 0;
+        size_t pooled = 0;
+    };
+    Batch* _batch = nullptr; // allocated on first queue()
+
+    // rx queue bounds (number of buffered UDP received packets)
     // keep it small
-    static constexpr int rxBufMaxDepth = 4;
+    size_t _rx_queued = 0;
+    size_t _rx_max_datagrams = UDP_RX_MAX_DATAGRAMS;
+    size_t _rx_max_bytes = UDP_RX_MAX_BYTES;
+    bool _rx_drop_oldest = false;
+    uint32_t _rx_stat_received = 0;
+    uint32_t _rx_stat_dropped = 0;
+    uint32_t _rx_stat_max_depth = 0;
 };
 
 
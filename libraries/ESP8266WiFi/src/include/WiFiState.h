@@ -17,6 +17,16 @@ struct WiFiState
         WiFiMode_t mode;
         uint8_t channel;
         bool persistent;
+        bool dhcp;               // the station address was obtained by DHCP
+        uint32_t dhcpRenewMs;    // time left until the DHCP lease is renewed, 0 when unknown
+        uint32_t rtcTime;        // system_get_rtc_time() at shutdown
+        uint32_t rtcCalibration; // system_rtc_clock_cali_proc() at shutdown
+        struct
+        {
+            char name[32];       // 0-terminated, longer names are not kept
+            uint32_t addr;       // IPv4, 0 when unused
+            uint32_t ageMs;      // at shutdown
+        } dnsCache[2];           // most recently used entries of the hostByName() cache
     } state;
 };
 
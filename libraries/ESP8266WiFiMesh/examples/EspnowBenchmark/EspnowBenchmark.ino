@@ -0,0 +1,246 @@
+#define ESP8266WIFIMESH_DISABLE_COMPATIBILITY  // Excludes redundant compatibility code. TODO: Should be used for new code until the compatibility code is removed with release 3.0.0 of the Arduino core.
+
+#include <ESP8266WiFi.h>
+#include <EspnowMeshBackend.h>
+#include <TypeConversionFunctions.h>
+#include <algorithm>
+
+/**
+   Measures the ESP-NOW performance between two nodes running this sketch.
+
+   The node with the higher chip ID finds the other node in a WiFi scan and sends it requests of various sizes,
+   first over an unencrypted connection and then over an encrypted connection. The other node answers each request with a short response.
+   For every message size the sender prints the round-trip latency percentiles (from sending a request until its response is received),
+   the number of requests which got no response, the goodput and the EspnowStatistics of the run.
+
+   Requests are sent one at a time, so the latency is not affected by queueing in the nodes.
+   Set useAeadEncryption to true on both nodes to also measure the cost of encrypting the message content (AEAD) of every transmission.
+*/
+
+namespace TypeCast = MeshTypeConversionFunctions;
+
+constexpr char exampleMeshName[] PROGMEM = "BenchmarkNode_";
+constexpr char exampleWiFiPassword[] PROGMEM = "ChangeThisWiFiPassword_TODO";  // Note: " is an illegal character. The password has to be min 8 and max 64 characters long, otherwise an AP which uses it will not be found during scans.
+
+// All ESP-NOW keys below must match on both nodes for the encrypted connection to be possible.
+uint8_t espnowEncryptedConnectionKey[16] = { 0x33, 0x44, 0x33, 0x44, 0x33, 0x44, 0x33, 0x44,  // This is the key for encrypting transmissions of encrypted connections.
+                                             0x33, 0x44, 0x33, 0x44, 0x33, 0x44, 0x32, 0x11 };
+uint8_t espnowHashKey[16] = { 0xEF, 0x44, 0x33, 0x0C, 0x33, 0x44, 0xFE, 0x44,  // This is the secret key used for HMAC during encrypted connection requests.
+                              0x33, 0x44, 0x33, 0xB0, 0x33, 0x44, 0x32, 0xAD };
+
+constexpr bool useAeadEncryption = false;
+constexpr uint16_t requestsPerRun = 100;
+constexpr uint32_t responseTimeoutMs = 200;
+
+uint16_t runNumber = 0;
+uint32_t requestSentTimes[requestsPerRun] = { 0 };  // In microseconds
+uint32_t roundTripTimes[requestsPerRun] = { 0 };    // In microseconds, 0 while no response is received
+
+String manageRequest(const String &request, MeshBackendBase &meshInstance);
+TransmissionStatusType manageResponse(const String &response, MeshBackendBase &meshInstance);
+void networkFilter(int numberOfNetworks, MeshBackendBase &meshInstance);
+bool broadcastFilter(String &firstTransmission, EspnowMeshBackend &meshInstance);
+
+/* Create the mesh node object */
+EspnowMeshBackend espnowNode = EspnowMeshBackend(manageRequest, manageResponse, networkFilter, broadcastFilter, FPSTR(exampleWiFiPassword), espnowEncryptedConnectionKey, espnowHashKey, FPSTR(exampleMeshName), TypeCast::uint64ToString(ESP.getChipId()), false);
+
+/**
+   Callback for when other nodes send you a request
+
+   @param request The request string received from another node in the mesh, structured as runNumber:requestNumber:padding
+   @param meshInstance The MeshBackendBase instance that called the function.
+   @return The string to send back to the other node, runNumber:requestNumber. For ESP-NOW, return an empty string ("") if no response should be sent.
+*/
+String manageRequest(const String &request, MeshBackendBase &meshInstance) {
+  (void)meshInstance;  // This is useful to remove a "unused parameter" compiler warning. Does nothing else.
+
+  int32_t requestNumberEndIndex = request.indexOf(':', request.indexOf(':') + 1);
+
+  if (requestNumberEndIndex == -1) {
+    return emptyString;  // Not a benchmark request, e.g. the message used for finding the other node.
+  }
+
+  // Printing takes a lot of time, so the request is not printed here.
+  return request.substring(0, requestNumberEndIndex);
+}
+
+/**
+   Callback for when you get a response from other nodes
+
+   @param response The response string received from another node in the mesh
+   @param meshInstance The MeshBackendBase instance that called the function.
+   @return The status code resulting from the response, as an int
+*/
+TransmissionStatusType manageResponse(const String &response, MeshBackendBase &meshInstance) {
+  (void)meshInstance;  // This is useful to remove a "unused parameter" compiler warning. Does nothing else.
+
+  uint32_t responseTime = micros();
+  int32_t runNumberEndIndex = response.indexOf(':');
+
+  if (runNumberEndIndex != -1 && response.substring(0, runNumberEndIndex).toInt() == runNumber) {
+    uint32_t requestNumber = response.substring(runNumberEndIndex + 1).toInt();
+
+    if (requestNumber < requestsPerRun && roundTripTimes[requestNumber] == 0) {
+      roundTripTimes[requestNumber] = std::max<uint32_t>(responseTime - requestSentTimes[requestNumber], 1);
+    }
+  }
+
+  return TransmissionStatusType::TRANSMISSION_COMPLETE;
+}
+
+/**
+   Callback used to decide which networks to connect to once a WiFi scan has been completed.
+
+   @param numberOfNetworks The number of networks found in the WiFi scan.
+   @param meshInstance The MeshBackendBase instance that called the function.
+*/
+void networkFilter(int numberOfNetworks, MeshBackendBase &meshInstance) {
+  for (int networkIndex = 0; networkIndex < numberOfNetworks; ++networkIndex) {
+    String currentSSID = WiFi.SSID(networkIndex);
+    int meshNameIndex = currentSSID.indexOf(meshInstance.getMeshName());
+
+    /* Only the node with the higher node ID sends requests, so it is the only one connecting to the other node. */
+    if (meshNameIndex >= 0) {
+      uint64_t targetNodeID = TypeCast::stringToUint64(currentSSID.substring(meshNameIndex + meshInstance.getMeshName().length()));
+
+      if (targetNodeID < TypeCast::stringToUint64(meshInstance.getNodeID())) {
+        if (EspnowMeshBackend *espnowInstance = TypeCast::meshBackendCast<EspnowMeshBackend *>(&meshInstance)) {
+          espnowInstance->connectionQueue().emplace_back(networkIndex);
+        }
+      }
+    }
+  }
+}
+
+/**
+   Callback used to decide which broadcast messages to accept. The benchmark does not use broadcasts.
+
+   @return False, since no broadcast should be accepted.
+*/
+bool broadcastFilter(String &firstTransmission, EspnowMeshBackend &meshInstance) {
+  (void)firstTransmission;  // This is useful to remove a "unused parameter" compiler warning. Does nothing else.
+  (void)meshInstance;
+
+  return false;
+}
+
+/**
+   Send requestsPerRun requests of messageLength bytes to targetBSSID, one at a time, and print the results.
+*/
+void runBenchmark(const uint8_t *targetBSSID, const uint32_t messageLength, const String &connectionDescription) {
+  ++runNumber;
+  std::fill_n(roundTripTimes, requestsPerRun, 0);
+  EspnowMeshBackend::resetEspnowStatistics();
+
+  String padding;
+  padding.reserve(messageLength);
+
+  uint32_t runStartTime = millis();
+
+  for (uint16_t requestNumber = 0; requestNumber < requestsPerRun; ++requestNumber) {
+    String message = String(runNumber) + ':' + String(requestNumber) + ':';
+
+    while (padding.length() + message.length() < messageLength) {
+      padding += 'x';
+    }
+    message += padding.substring(0, messageLength - message.length());
+
+    requestSentTimes[requestNumber] = micros();
+    if (espnowNode.attemptTransmission(message, EspnowNetworkInfo(targetBSSID)) != TransmissionStatusType::TRANSMISSION_COMPLETE) {
+      continue;
+    }
+
+    // espnowDelay continuously calls performEspnowMaintenance() while waiting, which keeps the node responsive.
+    uint32_t waitStart = millis();
+    while (roundTripTimes[requestNumber] == 0 && millis() - waitStart < responseTimeoutMs) {
+      espnowDelay(1);
+    }
+  }
+
+  uint32_t runDuration = millis() - runStartTime;
+
+  uint32_t sortedRoundTripTimes[requestsPerRun] = { 0 };
+  uint16_t responses = 0;
+  for (uint32_t roundTripTime : roundTripTimes) {
+    if (roundTripTime > 0) {
+      sortedRoundTripTimes[responses++] = roundTripTime;
+    }
+  }
+  std::sort(sortedRoundTripTimes, sortedRoundTripTimes + responses);
+
+  auto percentile = [&](const uint8_t percent) {
+    return responses == 0 ? String('-') : String(sortedRoundTripTimes[(responses - 1) * percent / 100] / 1000.0, 1);
+  };
+
+  const EspnowStatistics &statistics = EspnowMeshBackend::getEspnowStatistics();
+  Serial.println(connectionDescription + F(", ") + String(messageLength) + F(" bytes:"));
+  Serial.println(String(F("  Round trip ms: p50 ")) + percentile(50) + F(", p90 ") + percentile(90) + F(", p99 ") + percentile(99) + F(", max ") + percentile(100));
+  Serial.println(String(F("  No response: ")) + String(requestsPerRun - responses) + '/' + String(requestsPerRun)
+                 + F(", goodput: ") + String(runDuration == 0 ? 0 : responses * messageLength / (double)runDuration, 2) + F(" kB/s"));
+  Serial.println(String(F("  Transmissions sent: ")) + String(statistics.transmissionsSent) + F(" (") + String(statistics.transmissionsResent) + F(" resent), messages failed: ")
+                 + String(statistics.messagesFailed) + F(", min free heap: ") + String(statistics.minFreeHeap));
+}
+
+void setup() {
+  // Prevents the flash memory from being worn out, see: https://github.com/esp8266/Arduino/issues/1054 .
+  // This will however delay node WiFi start-up by about 700 ms. The delay is 900 ms if we otherwise would have stored the WiFi network we want to connect to.
+  WiFi.persistent(false);
+
+  Serial.begin(115200);
+
+  Serial.println();
+  Serial.println();
+
+  Serial.println(F("Setting up benchmark node..."));
+
+  /* Initialise the mesh node */
+  espnowNode.begin();
+
+  // Makes it possible to find the node through scans.
+  espnowNode.activateAP();
+
+  if (useAeadEncryption) {
+    espnowNode.setEspnowMessageEncryptionKey(F("ChangeThisKeySeed_TODO"));  // The message encryption key should always be set manually. Otherwise a default key (all zeroes) is used.
+    espnowNode.setUseEncryptedMessages(true);
+  }
+}
+
+int32_t timeOfLastBenchmark = -10000;
+void loop() {
+  // The performEspnowMaintenance() method performs all the background operations for the EspnowMeshBackend, such as sending the responses to requests.
+  EspnowMeshBackend::performEspnowMaintenance();
+
+  if (millis() - timeOfLastBenchmark > 10000) {
+    timeOfLastBenchmark = millis();
+
+    // Scan for the other node. Only the node with the higher node ID finds it, due to the networkFilter.
+    espnowNode.attemptTransmission(String(F("Benchmark node search")));
+
+    uint8_t targetBSSID[6]{ 0 };
+    if (espnowNode.constConnectionQueue().empty() || !espnowNode.constConnectionQueue()[0].getBSSID(targetBSSID)) {
+      return;  // No node found, or this node answers the requests of the other node.
+    }
+
+    Serial.println(String(F("\nBenchmarking against node ")) + TypeCast::macToString(targetBSSID) + (useAeadEncryption ? F(" with AEAD encrypted messages.") : F(".")));
+
+    const uint32_t messageLengths[] = { 16, EspnowMeshBackend::getMaxMessageBytesPerTransmission(), 2 * EspnowMeshBackend::getMaxMessageBytesPerTransmission(),
+                                        EspnowMeshBackend::getMaxMessageLength() };
+
+    for (uint32_t messageLength : messageLengths) {
+      runBenchmark(targetBSSID, std::min(messageLength, EspnowMeshBackend::getMaxMessageLength()), F("Unencrypted connection"));
+    }
+
+    if (espnowNode.requestEncryptedConnection(targetBSSID) == EncryptedConnectionStatus::CONNECTION_ESTABLISHED) {
+      // The WiFi scan will detect the AP MAC, but this will automatically be converted to the encrypted STA MAC by the framework.
+      for (uint32_t messageLength : messageLengths) {
+        runBenchmark(targetBSSID, std::min(messageLength, EspnowMeshBackend::getMaxMessageLength()), F("Encrypted connection"));
+      }
+
+      espnowNode.requestEncryptedConnectionRemoval(targetBSSID);
+    } else {
+      Serial.println(F("Could not establish an encrypted connection."));
+    }
+
+    timeOfLastBenchmark = millis();
+  }
+}
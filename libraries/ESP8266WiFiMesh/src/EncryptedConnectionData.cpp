@@ -33,6 +33,25 @@ namespace
 {
   using EspnowProtocolInterpreter::hashKeyLength;
   namespace TypeCast = MeshTypeConversionFunctions;
+
+  uint64_t incrementSessionKey(const uint64_t sessionKey, const MeshCryptoInterface::hmacKey_td &hmacKey)
+  {
+    uint8_t inputArray[8] {0};
+    uint8_t hmacArray[experimental::crypto::SHA256::NATURAL_LENGTH] {0};
+    MeshCryptoInterface::createMeshHmac(TypeCast::uint64ToUint8Array(sessionKey, inputArray), 8, hmacKey, hmacArray, experimental::crypto::SHA256::NATURAL_LENGTH);
+
+    /* HMAC truncation should be OK since hmac sha256 is a PRF and we are truncating to the leftmost (MSB) bits.
+    PRF: https://crypto.stackexchange.com/questions/26410/whats-the-gcm-sha-256-of-a-tls-protocol/26434#26434
+    Truncate to leftmost bits: https://tools.ietf.org/html/rfc2104#section-5 */
+    uint64_t newLeftmostBits = TypeCast::uint8ArrayToUint64(hmacArray) & EspnowProtocolInterpreter::uint64LeftmostBits;
+    
+    if(newLeftmostBits == 0)
+      newLeftmostBits = ((uint64_t)ESP.random() | (1 << 31)) << 32; // We never want newLeftmostBits == 0 since that would indicate an unencrypted transmission.
+    
+    uint64_t newRightmostBits = (uint32_t)(sessionKey + 1);
+
+    return newLeftmostBits | newRightmostBits;
+  }
 }
 
 EncryptedConnectionData::EncryptedConnectionData(const uint8_t peerStaMac[6], const uint8_t peerApMac[6], const uint64_t peerSessionKey, const uint64_t ownSessionKey, const uint8_t hashKey[hashKeyLength]) 
@@ -40,7 +59,7 @@ EncryptedConnectionData::EncryptedConnectionData(const uint8_t peerStaMac[6], co
 { 
   std::copy_n(peerStaMac, 6, _peerStaMac);
   std::copy_n(peerApMac, 6, _peerApMac);
-  std::copy_n(hashKey, hashKeyLength, _hashKey);
+  setHashKey(hashKey);
 }
 
 EncryptedConnectionData::EncryptedConnectionData(const uint8_t peerStaMac[6], const uint8_t peerApMac[6], const uint64_t peerSessionKey, const uint64_t ownSessionKey, const uint32_t duration, const uint8_t hashKey[hashKeyLength]) 
@@ -52,7 +71,7 @@ EncryptedConnectionData::EncryptedConnectionData(const uint8_t peerStaMac[6], co
 EncryptedConnectionData::EncryptedConnectionData(const EncryptedConnectionData &other)
   : _peerSessionKey(other.getPeerSessionKey()), _ownSessionKey(other.getOwnSessionKey()),
     _timeTracker(other.temporary() ? new ExpiringTimeTracker(*other.temporary()) : nullptr),
-    _desync(other.desync())
+    _hmacKey(other._hmacKey), _desync(other.desync())
 {
   other.getPeerStaMac(_peerStaMac);
   other.getPeerApMac(_peerApMac);
@@ -68,6 +87,7 @@ EncryptedConnectionData & EncryptedConnectionData::operator=(const EncryptedConn
     _peerSessionKey = other.getPeerSessionKey();
     _ownSessionKey = other.getOwnSessionKey();
     other.getHashKey(_hashKey);
+    _hmacKey = other._hmacKey;
     _desync = other.desync();
     _timeTracker = std::unique_ptr<ExpiringTimeTracker>(other.temporary() ? new ExpiringTimeTracker(*other.temporary()) : nullptr);
   }
@@ -116,6 +136,7 @@ void EncryptedConnectionData::setHashKey(const uint8_t hashKey[hashKeyLength])
   assert(hashKey != nullptr);
 
   std::copy_n(hashKey, hashKeyLength, _hashKey);
+  MeshCryptoInterface::initializeHmacKey(_hmacKey, _hashKey, hashKeyLength);
 }
 
 uint8_t *EncryptedConnectionData::getHashKey(uint8_t *resultArray) const
@@ -132,26 +153,19 @@ uint64_t EncryptedConnectionData::getOwnSessionKey() const { return _ownSessionK
 
 uint64_t EncryptedConnectionData::incrementSessionKey(const uint64_t sessionKey, const uint8_t *hashKey, const uint8_t hashKeyLength)
 {
-  uint8_t inputArray[8] {0};
-  uint8_t hmacArray[experimental::crypto::SHA256::NATURAL_LENGTH] {0};
-  experimental::crypto::SHA256::hmac(TypeCast::uint64ToUint8Array(sessionKey, inputArray), 8, hashKey, hashKeyLength, hmacArray, experimental::crypto::SHA256::NATURAL_LENGTH);
-
-  /* HMAC truncation should be OK since hmac sha256 is a PRF and we are truncating to the leftmost (MSB) bits.
-  PRF: https://crypto.stackexchange.com/questions/26410/whats-the-gcm-sha-256-of-a-tls-protocol/26434#26434
-  Truncate to leftmost bits: https://tools.ietf.org/html/rfc2104#section-5 */
-  uint64_t newLeftmostBits = TypeCast::uint8ArrayToUint64(hmacArray) & EspnowProtocolInterpreter::uint64LeftmostBits;
-  
-  if(newLeftmostBits == 0)
-    newLeftmostBits = ((uint64_t)ESP.random() | (1 << 31)) << 32; // We never want newLeftmostBits == 0 since that would indicate an unencrypted transmission.
-  
-  uint64_t newRightmostBits = (uint32_t)(sessionKey + 1);
-
-  return newLeftmostBits | newRightmostBits;
+  MeshCryptoInterface::hmacKey_td hmacKey;
+  MeshCryptoInterface::initializeHmacKey(hmacKey, hashKey, hashKeyLength);
+  return ::incrementSessionKey(sessionKey, hmacKey);
 }
 
 void EncryptedConnectionData::incrementOwnSessionKey()
 {
-  setOwnSessionKey(incrementSessionKey(getOwnSessionKey(), _hashKey, EspnowProtocolInterpreter::hashKeyLength));
+  setOwnSessionKey(::incrementSessionKey(getOwnSessionKey(), _hmacKey));
+}
+
+void EncryptedConnectionData::incrementPeerSessionKey()
+{
+  setPeerSessionKey(::incrementSessionKey(getPeerSessionKey(), _hmacKey));
 }
 
 void EncryptedConnectionData::setDesync(const bool desync) { _desync = desync; }
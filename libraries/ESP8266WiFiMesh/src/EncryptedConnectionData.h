@@ -29,6 +29,7 @@
 #include "EspnowProtocolInterpreter.h"
 #include <WString.h>
 #include <memory>
+#include "MeshCryptoInterface.h"
 
 class EncryptedConnectionData {
   
@@ -72,6 +73,7 @@ public:
 
   static uint64_t incrementSessionKey(const uint64_t sessionKey, const uint8_t *hashKey, const uint8_t hashKeyLength);
   void incrementOwnSessionKey();
+  void incrementPeerSessionKey();
 
   void setDesync(const bool desync);
   bool desync() const;
@@ -92,6 +94,7 @@ private:
   uint64_t _ownSessionKey;
   std::unique_ptr<ExpiringTimeTracker> _timeTracker = nullptr;
   uint8_t _hashKey[EspnowProtocolInterpreter::hashKeyLength] {0};
+  MeshCryptoInterface::hmacKey_td _hmacKey; // The HMAC key setup of _hashKey, done when the hash key is set since the session keys are incremented for every message.
   bool _desync = false;
 };
 
@@ -17,6 +17,8 @@
 #include "EspnowDatabase.h"
 #include "EspnowMeshBackend.h"
 #include "UtilityFunctions.h"
+#include <LazyInit.h>
+#include <MemoryPressure.h>
 
 namespace
 {
@@ -38,15 +40,19 @@ namespace
   using EspnowProtocolInterpreter::messageID_td;
   using EspnowProtocolInterpreter::peerMac_td;
 
-  std::list<ResponseData> _responsesToSend = {};
-  std::list<PeerRequestLog> _peerRequestConfirmationsToSend = {};
+  // Constructed when the mesh is first used, rather than before setup() in every sketch linking the library.
+  esp8266::Lazy<std::list<ResponseData>> _responsesToSend;
+  esp8266::Lazy<std::list<PeerRequestLog>> _peerRequestConfirmationsToSend;
 
-  std::map<std::pair<macAndType_td, messageID_td>, MessageData> _receivedEspnowTransmissions = {};
-  std::map<std::pair<peerMac_td, messageID_td>, RequestData> _sentRequests = {};
-  std::map<std::pair<peerMac_td, messageID_td>, TimeTracker> _receivedRequests = {};
+  esp8266::Lazy<EspnowDatabase::receivedEspnowTransmissions_td> _receivedEspnowTransmissions;
+  esp8266::Lazy<EspnowDatabase::sentRequests_td> _sentRequests;
+  esp8266::Lazy<EspnowDatabase::receivedRequests_td> _receivedRequests;
 
-  std::shared_ptr<bool> _espnowConnectionQueueMutex = std::make_shared<bool>(false);
-  std::shared_ptr<bool> _responsesToSendMutex = std::make_shared<bool>(false);
+  std::shared_ptr<bool> makeMutex() { return std::make_shared<bool>(false); }
+  esp8266::Lazy<std::shared_ptr<bool>> _espnowConnectionQueueMutex(makeMutex);
+  esp8266::Lazy<std::shared_ptr<bool>> _responsesToSendMutex(makeMutex);
+
+  EspnowStatistics _statistics;
 }
 
 std::vector<EspnowNetworkInfo> EspnowDatabase::_connectionQueue = {};
@@ -58,7 +64,7 @@ EspnowDatabase::EspnowDatabase(ConditionalPrinter &conditionalPrinterInstance, c
 
 std::vector<EspnowNetworkInfo> & EspnowDatabase::connectionQueue()
 {
-  MutexTracker connectionQueueMutexTracker(_espnowConnectionQueueMutex);
+  MutexTracker connectionQueueMutexTracker(*_espnowConnectionQueueMutex);
   if(!connectionQueueMutexTracker.mutexCaptured())
   {
     assert(false && String(F("ERROR! connectionQueue locked. Don't call connectionQueue() from callbacks other than NetworkFilter as this may corrupt program state!"))); 
@@ -92,10 +98,24 @@ uint32_t EspnowDatabase::criticalHeapLevel()
   return _criticalHeapLevel;
 }
 
-template <typename T, typename U>
-void EspnowDatabase::deleteExpiredLogEntries(std::map<std::pair<U, uint64_t>, T> &logEntries, const uint32_t maxEntryLifetimeMs)
+// The core MemoryPressure level can become critical first, with a fragmented heap or other libraries holding on to it.
+bool EspnowDatabase::heapCritical()
+{
+  return ESP.getFreeHeap() <= criticalHeapLevel() || MemoryPressure.level() == HeapLevel::Critical;
+}
+
+bool EspnowDatabase::heapLimited()
+{
+  // We preferably want to start clearing the logs a bit before things get critical.
+  return ESP.getFreeHeap() <= criticalHeapLevel() + criticalHeapLevelBuffer() || MemoryPressure.level() == HeapLevel::Critical;
+}
+
+// The log tables iterate from their oldest entry, so the expired entries are all found before the first live one.
+
+template <typename U, typename T, uint16_t capacity>
+void EspnowDatabase::deleteExpiredLogEntries(EspnowLogTable<U, T, capacity> &logEntries, const uint32_t maxEntryLifetimeMs)
 {
-  for(typename std::map<std::pair<U, uint64_t>, T>::iterator entryIterator = logEntries.begin(); 
+  for(typename EspnowLogTable<U, T, capacity>::iterator entryIterator = logEntries.begin(); 
       entryIterator != logEntries.end(); )
   {
     if(entryIterator->second.getTimeTracker().timeSinceCreation() > maxEntryLifetimeMs)
@@ -103,14 +123,14 @@ void EspnowDatabase::deleteExpiredLogEntries(std::map<std::pair<U, uint64_t>, T>
       entryIterator = logEntries.erase(entryIterator);
     }
     else
-      ++entryIterator;
+      return;
   }
 }
 
-template <typename U>
-void EspnowDatabase::deleteExpiredLogEntries(std::map<std::pair<U, uint64_t>, TimeTracker> &logEntries, const uint32_t maxEntryLifetimeMs)
+template <typename U, uint16_t capacity>
+void EspnowDatabase::deleteExpiredLogEntries(EspnowLogTable<U, TimeTracker, capacity> &logEntries, const uint32_t maxEntryLifetimeMs)
 {
-  for(typename std::map<std::pair<U, uint64_t>, TimeTracker>::iterator entryIterator = logEntries.begin(); 
+  for(typename EspnowLogTable<U, TimeTracker, capacity>::iterator entryIterator = logEntries.begin(); 
       entryIterator != logEntries.end(); )
   {
     if(entryIterator->second.timeSinceCreation() > maxEntryLifetimeMs)
@@ -118,13 +138,15 @@ void EspnowDatabase::deleteExpiredLogEntries(std::map<std::pair<U, uint64_t>, Ti
       entryIterator = logEntries.erase(entryIterator);
     }
     else
-      ++entryIterator;
+      return;
   }
 }
 
-void EspnowDatabase::deleteExpiredLogEntries(std::map<std::pair<peerMac_td, messageID_td>, RequestData> &logEntries, const uint32_t requestLifetimeMs, const uint32_t broadcastLifetimeMs)
+void EspnowDatabase::deleteExpiredLogEntries(sentRequests_td &logEntries, const uint32_t requestLifetimeMs, const uint32_t broadcastLifetimeMs)
 {
-  for(typename std::map<std::pair<peerMac_td, messageID_td>, RequestData>::iterator entryIterator = logEntries.begin(); 
+  uint32_t shortestLifetimeMs = std::min(requestLifetimeMs, broadcastLifetimeMs);
+  
+  for(sentRequests_td::iterator entryIterator = logEntries.begin(); 
       entryIterator != logEntries.end(); )
   {
     bool broadcast = entryIterator->first.first == EspnowProtocolInterpreter::uint64BroadcastMac;
@@ -135,6 +157,8 @@ void EspnowDatabase::deleteExpiredLogEntries(std::map<std::pair<peerMac_td, mess
     {
       entryIterator = logEntries.erase(entryIterator);
     }
+    else if(timeSinceCreation <= shortestLifetimeMs)
+      return; // All newer entries are live.
     else
       ++entryIterator;
   }
@@ -197,7 +221,7 @@ uint32_t EspnowDatabase::numberOfScheduledResponses() {return responsesToSend().
 
 void EspnowDatabase::clearAllScheduledResponses()
 {
-  MutexTracker responsesToSendMutexTracker(_responsesToSendMutex);
+  MutexTracker responsesToSendMutexTracker(*_responsesToSendMutex);
   if(!responsesToSendMutexTracker.mutexCaptured())
   {
     assert(false && String(F("ERROR! responsesToSend locked. Don't call clearAllScheduledResponses from callbacks as this may corrupt program state! Aborting."))); 
@@ -208,7 +232,7 @@ void EspnowDatabase::clearAllScheduledResponses()
 
 void EspnowDatabase::deleteScheduledResponsesByRecipient(const uint8_t *recipientMac, const bool encryptedOnly)
 {
-  MutexTracker responsesToSendMutexTracker(_responsesToSendMutex);
+  MutexTracker responsesToSendMutexTracker(*_responsesToSendMutex);
   if(!responsesToSendMutexTracker.mutexCaptured())
   {
     assert(false && String(F("ERROR! responsesToSend locked. Don't call deleteScheduledResponsesByRecipient from callbacks as this may corrupt program state! Aborting."))); 
@@ -265,7 +289,9 @@ void EspnowDatabase::clearOldLogEntries(bool forced)
   
   _logClearingCooldown.reset();
   
+  size_t partialMessages = receivedEspnowTransmissions().size();
   deleteExpiredLogEntries(receivedEspnowTransmissions(), logEntryLifetimeMs());
+  statistics().messagesExpired += partialMessages - receivedEspnowTransmissions().size();
   deleteExpiredLogEntries(receivedRequests(), logEntryLifetimeMs()); // Just needs to be long enough to not accept repeated transmissions by mistake.
   deleteExpiredLogEntries(sentRequests(), logEntryLifetimeMs(), broadcastResponseTimeoutMs());
   deleteExpiredLogEntries(responsesToSend(), logEntryLifetimeMs());
@@ -321,14 +347,14 @@ bool EspnowDatabase::requestReceived(const uint64_t requestMac, const uint64_t r
 MutexTracker EspnowDatabase::captureEspnowConnectionQueueMutex() 
 {   
   // Syntax like this will move the resulting value into its new position (similar to NRVO): https://stackoverflow.com/a/11540204
-  return MutexTracker(_espnowConnectionQueueMutex); 
+  return MutexTracker(*_espnowConnectionQueueMutex); 
 }
 
-MutexTracker EspnowDatabase::captureEspnowConnectionQueueMutex(const std::function<void()> destructorHook) { return MutexTracker(_espnowConnectionQueueMutex, destructorHook); }
+MutexTracker EspnowDatabase::captureEspnowConnectionQueueMutex(const std::function<void()> destructorHook) { return MutexTracker(*_espnowConnectionQueueMutex, destructorHook); }
 
-MutexTracker EspnowDatabase::captureResponsesToSendMutex(){ return MutexTracker(_responsesToSendMutex); }
+MutexTracker EspnowDatabase::captureResponsesToSendMutex(){ return MutexTracker(*_responsesToSendMutex); }
 
-MutexTracker EspnowDatabase::captureResponsesToSendMutex(const std::function<void()> destructorHook) { return MutexTracker(_responsesToSendMutex, destructorHook); }
+MutexTracker EspnowDatabase::captureResponsesToSendMutex(const std::function<void()> destructorHook) { return MutexTracker(*_responsesToSendMutex, destructorHook); }
 
 void EspnowDatabase::storeSentRequest(const uint64_t targetBSSID, const uint64_t messageID, const RequestData &requestData)
 {
@@ -342,7 +368,7 @@ void EspnowDatabase::storeReceivedRequest(const uint64_t senderBSSID, const uint
 
 EspnowMeshBackend *EspnowDatabase::getOwnerOfSentRequest(const uint64_t requestMac, const uint64_t requestID)
 {
-  std::map<std::pair<peerMac_td, messageID_td>, RequestData>::iterator sentRequest = sentRequests().find(std::make_pair(requestMac, requestID));
+  sentRequests_td::iterator sentRequest = sentRequests().find(std::make_pair(requestMac, requestID));
   
   if(sentRequest != sentRequests().end())
   {
@@ -361,7 +387,7 @@ size_t EspnowDatabase::deleteSentRequestsByOwner(const EspnowMeshBackend *instan
 {
   size_t numberDeleted = 0;
   
-  for(std::map<std::pair<peerMac_td, messageID_td>, RequestData>::iterator requestIterator = sentRequests().begin(); 
+  for(sentRequests_td::iterator requestIterator = sentRequests().begin(); 
       requestIterator != sentRequests().end(); )
   {
     if(&requestIterator->second.getMeshInstance() == instancePointer) // If instance at instancePointer made the request
@@ -376,8 +402,14 @@ size_t EspnowDatabase::deleteSentRequestsByOwner(const EspnowMeshBackend *instan
   return numberDeleted;
 }
 
-std::list<ResponseData> & EspnowDatabase::responsesToSend() { return _responsesToSend; }
-std::list<PeerRequestLog> & EspnowDatabase::peerRequestConfirmationsToSend() { return _peerRequestConfirmationsToSend; }
-std::map<std::pair<macAndType_td, messageID_td>, MessageData> & EspnowDatabase::receivedEspnowTransmissions() { return _receivedEspnowTransmissions; }
-std::map<std::pair<peerMac_td, messageID_td>, RequestData> & EspnowDatabase::sentRequests() { return _sentRequests; }
-std::map<std::pair<peerMac_td, messageID_td>, TimeTracker> & EspnowDatabase::receivedRequests() { return _receivedRequests; }
+std::list<ResponseData> & EspnowDatabase::responsesToSend() { return *_responsesToSend; }
+EspnowStatistics & EspnowDatabase::statistics() { return _statistics; }
+
+void EspnowDatabase::updateFreeHeapStatistics()
+{
+  statistics().minFreeHeap = std::min(statistics().minFreeHeap, ESP.getFreeHeap());
+}
+std::list<PeerRequestLog> & EspnowDatabase::peerRequestConfirmationsToSend() { return *_peerRequestConfirmationsToSend; }
+EspnowDatabase::receivedEspnowTransmissions_td & EspnowDatabase::receivedEspnowTransmissions() { return *_receivedEspnowTransmissions; }
+EspnowDatabase::sentRequests_td & EspnowDatabase::sentRequests() { return *_sentRequests; }
+EspnowDatabase::receivedRequests_td & EspnowDatabase::receivedRequests() { return *_receivedRequests; }
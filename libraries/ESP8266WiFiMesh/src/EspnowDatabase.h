@@ -24,7 +24,7 @@
 #include "RequestData.h"
 #include "EspnowProtocolInterpreter.h"
 #include <list>
-#include <map>
+#include "EspnowLogTable.h"
 #include "MessageData.h"
 #include "MutexTracker.h"
 #include "PeerRequestLog.h"
@@ -33,6 +33,28 @@
 
 class EspnowMeshBackend;
 
+/**
+ * Counters of the ESP-NOW activity of the node, shared by all EspnowMeshBackend instances. Useful for measuring throughput, transmission loss and latency.
+ * The message counters include requests, responses, broadcasts and the messages used for encrypted connections.
+ */
+struct EspnowStatistics
+{
+  uint32_t messagesSent = 0; // Messages whose transmissions were all acknowledged. Broadcasts with redundancy count once.
+  uint32_t messagesFailed = 0;
+  uint32_t messageBytesSent = 0; // The message bytes of the messages sent, so messageBytesSent / totalSendTimeMs is the goodput in bytes per ms.
+  uint32_t totalSendTimeMs = 0; // The time spent sending the messages sent.
+  uint32_t transmissionsSent = 0; // Every transmission (message part) given to the ESP-NOW API, including resent ones.
+  uint32_t transmissionsResent = 0; // Transmissions sent again since their ack did not arrive in time. Redundant broadcast transmissions are not counted.
+  uint32_t transmissionsReceived = 0; // Transmissions of requests, responses and broadcasts received, including duplicates.
+  uint32_t duplicateTransmissions = 0; // Transmissions received again, which happens when an ack is lost.
+  uint32_t messagesReceived = 0; // Complete requests, responses and broadcasts given to the callbacks.
+  uint32_t messagesExpired = 0; // Partially received messages removed from the log since their remaining transmissions did not arrive in time.
+  uint32_t totalReassemblyTimeMs = 0; // The time from the first to the last transmission received, summed over the messages received.
+  uint32_t maxReassemblyTimeMs = 0;
+  uint32_t maxResponsesQueued = 0; // The largest number of responses waiting to be sent at once.
+  uint32_t minFreeHeap = UINT32_MAX; // The smallest free heap in bytes when ESP-NOW transmissions were sent or received.
+};
+
 class EspnowDatabase
 {
 
@@ -46,6 +68,8 @@ public:
   static uint32_t criticalHeapLevel();
   static void setCriticalHeapLevelBuffer(const uint32_t bufferInBytes);
   static uint32_t criticalHeapLevelBuffer();
+  static bool heapCritical();
+  static bool heapLimited();
   static void setLogEntryLifetimeMs(const uint32_t logEntryLifetimeMs);
   static uint32_t logEntryLifetimeMs();
   static void setBroadcastResponseTimeoutMs(const uint32_t broadcastResponseTimeoutMs);
@@ -69,12 +93,21 @@ public:
   using messageID_td = EspnowProtocolInterpreter::messageID_td;
   using peerMac_td = EspnowProtocolInterpreter::peerMac_td;
 
+  // The capacities of the logs below. When a log is full, storing a new entry deletes its oldest entry.
+  static constexpr uint16_t receivedEspnowTransmissionsCapacity = 32;
+  static constexpr uint16_t sentRequestsCapacity = 32;
+  static constexpr uint16_t receivedRequestsCapacity = 64;
+
+  using receivedEspnowTransmissions_td = EspnowLogTable<macAndType_td, MessageData, receivedEspnowTransmissionsCapacity>;
+  using sentRequests_td = EspnowLogTable<peerMac_td, RequestData, sentRequestsCapacity>;
+  using receivedRequests_td = EspnowLogTable<peerMac_td, TimeTracker, receivedRequestsCapacity>;
+
   static size_t deleteSentRequestsByOwner(const EspnowMeshBackend *instancePointer);
   static std::list<ResponseData> & responsesToSend();
   static std::list<PeerRequestLog> & peerRequestConfirmationsToSend();
-  static std::map<std::pair<macAndType_td, messageID_td>, MessageData> & receivedEspnowTransmissions();
-  static std::map<std::pair<peerMac_td, messageID_td>, RequestData> & sentRequests();
-  static std::map<std::pair<peerMac_td, messageID_td>, TimeTracker> & receivedRequests();
+  static receivedEspnowTransmissions_td & receivedEspnowTransmissions();
+  static sentRequests_td & sentRequests();
+  static receivedRequests_td & receivedRequests();
   
   static bool requestReceived(const uint64_t requestMac, const uint64_t requestID);
 
@@ -92,6 +125,9 @@ public:
   
   static void clearOldLogEntries(bool forced);
 
+  static EspnowStatistics & statistics();
+  static void updateFreeHeapStatistics();
+
   static void storeSentRequest(const uint64_t targetBSSID, const uint64_t messageID, const RequestData &requestData);
   static void storeReceivedRequest(const uint64_t senderBSSID, const uint64_t messageID, const TimeTracker &timeTracker);
   
@@ -127,66 +163,28 @@ public:
   uint8 getWiFiChannel() const;
   
   /**
-   * Remove all entries which target peerMac in the logEntries map.
+   * Remove all entries which target peerMac in the logEntries table.
    * Optionally deletes only entries sent/received by encrypted transmissions.
    * 
-   * @param logEntries The map to process.
+   * @param logEntries The table to process.
    * @param peerMac The MAC address of the peer node.
    * @param encryptedOnly If true, only entries sent/received by encrypted transmissions will be deleted.
    */
-  template <typename T>
-  static void deleteEntriesByMac(std::map<std::pair<macAndType_td, uint64_t>, T> &logEntries, const uint8_t *peerMac, const bool encryptedOnly)
-  {    
-    bool macFound = false;
-    
-    for(typename std::map<std::pair<macAndType_td, uint64_t>, T>::iterator entryIterator = logEntries.begin(); 
-        entryIterator != logEntries.end(); )
-    {
-      if(macAndTypeToUint64Mac(entryIterator->first.first) == MeshTypeConversionFunctions::macToUint64(peerMac))
-      {
-        macFound = true;
-           
-        if(!encryptedOnly || EspnowProtocolInterpreter::usesEncryption(entryIterator->first.second))
-        {
-          entryIterator = logEntries.erase(entryIterator);
-          continue;
-        }
-      }
-      else if(macFound)
-      {
-        // Since the map is sorted by MAC, we know here that no more matching MAC will be found.
-        return;
-      }
-  
-      ++entryIterator;
-    }
-  }
-  
-  template <typename T>
-  static void deleteEntriesByMac(std::map<std::pair<uint64_t, uint64_t>, T> &logEntries, const uint8_t *peerMac, const bool encryptedOnly)
+  template <typename U, typename T, uint16_t capacity>
+  static void deleteEntriesByMac(EspnowLogTable<U, T, capacity> &logEntries, const uint8_t *peerMac, const bool encryptedOnly)
   {    
-    bool macFound = false;
+    uint64_t uint64PeerMac = MeshTypeConversionFunctions::macToUint64(peerMac);
     
-    for(typename std::map<std::pair<uint64_t, uint64_t>, T>::iterator entryIterator = logEntries.begin(); 
+    for(typename EspnowLogTable<U, T, capacity>::iterator entryIterator = logEntries.begin(); 
         entryIterator != logEntries.end(); )
     {
-      if(entryIterator->first.first == MeshTypeConversionFunctions::macToUint64(peerMac))
-      {
-        macFound = true;
-           
-        if(!encryptedOnly || EspnowProtocolInterpreter::usesEncryption(entryIterator->first.second))
-        {
-          entryIterator = logEntries.erase(entryIterator);
-          continue;
-        }
-      }
-      else if(macFound)
+      if(getEntryMac(entryIterator->first.first) == uint64PeerMac 
+         && (!encryptedOnly || EspnowProtocolInterpreter::usesEncryption(entryIterator->first.second)))
       {
-        // Since the map is sorted by MAC, we know here that no more matching MAC will be found.
-        return;
+        entryIterator = logEntries.erase(entryIterator);
       }
-  
-      ++entryIterator;
+      else
+        ++entryIterator;
     }
   }
 
@@ -203,13 +201,16 @@ private:
 
   uint32_t _autoEncryptionDuration = 50;
   
-  template <typename T, typename U>
-  static void deleteExpiredLogEntries(std::map<std::pair<U, uint64_t>, T> &logEntries, const uint32_t maxEntryLifetimeMs);
+  static uint64_t getEntryMac(const macAndType_td macAndType) { return macAndTypeToUint64Mac(macAndType); }
+  static uint64_t getEntryMac(const peerMac_td peerMac) { return peerMac; }
+
+  template <typename U, typename T, uint16_t capacity>
+  static void deleteExpiredLogEntries(EspnowLogTable<U, T, capacity> &logEntries, const uint32_t maxEntryLifetimeMs);
 
-  template <typename U>
-  static void deleteExpiredLogEntries(std::map<std::pair<U, uint64_t>, TimeTracker> &logEntries, const uint32_t maxEntryLifetimeMs);
+  template <typename U, uint16_t capacity>
+  static void deleteExpiredLogEntries(EspnowLogTable<U, TimeTracker, capacity> &logEntries, const uint32_t maxEntryLifetimeMs);
 
-  static void deleteExpiredLogEntries(std::map<std::pair<peerMac_td, messageID_td>, RequestData> &logEntries, const uint32_t requestLifetimeMs, const uint32_t broadcastLifetimeMs);
+  static void deleteExpiredLogEntries(sentRequests_td &logEntries, const uint32_t requestLifetimeMs, const uint32_t broadcastLifetimeMs);
 
   template <typename T>
   static void deleteExpiredLogEntries(std::list<T> &logEntries, const uint32_t maxEntryLifetimeMs);
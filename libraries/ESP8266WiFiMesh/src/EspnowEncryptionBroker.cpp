@@ -22,6 +22,7 @@ extern "C" {
 #include "EspnowEncryptionBroker.h"
 #include "EspnowMeshBackend.h"
 #include "JsonTranslator.h"
+#include "TlvTranslator.h"
 #include "UtilityFunctions.h"
 #include "Serializer.h"
 #include "MeshCryptoInterface.h"
@@ -133,7 +134,7 @@ void EspnowEncryptionBroker::handlePeerRequest(const uint8_t *macaddr, uint8_t *
           uint8_t apMacArray[6] = { 0 };
           if(correctDestination && verifyEncryptionRequestHmac(message, macaddr, getTransmissionMac(dataArray, apMacArray), currentEspnowRequestManager->getEspnowHashKey(), hashKeyLength))
             EspnowDatabase::peerRequestConfirmationsToSend().emplace_back(receivedMessageID, encryptedCorrectly, currentEspnowRequestManager->getMeshPassword(), currentEspnowRequestManager->encryptedConnectionsSoftLimit(), 
-                                                        requestNonce, macaddr, apMacArray, currentEspnowRequestManager->getEspnowHashKey());
+                                                        requestNonce, macaddr, apMacArray, currentEspnowRequestManager->getEspnowHashKey(), JsonTranslator::getTlvSupport(message));
         }
       }
     }
@@ -168,7 +169,8 @@ void EspnowEncryptionBroker::handlePeerRequestConfirmation(uint8_t *macaddr, uin
     {      
       int32_t messageHeaderEndIndex = message.indexOf(':');
       String messageHeader = message.substring(0, messageHeaderEndIndex + 1);
-      String messageBody = message.substring(messageHeaderEndIndex + 1);
+      // substring() stops at the first null character, which TLV values can contain. TLV getters skip the header by themselves.
+      String messageBody = TlvTranslator::isTlv(message) ? message : message.substring(messageHeaderEndIndex + 1);
       uint8_t apMacArray[6] = { 0 };
       getTransmissionMac(dataArray, apMacArray);
 
@@ -258,7 +260,6 @@ void EspnowEncryptionBroker::handlePeerRequestConfirmation(uint8_t *macaddr, uin
 
 void EspnowEncryptionBroker::sendPeerRequestConfirmations(const ExpiringTimeTracker *estimatedMaxDurationTracker)
 {
-  uint32_t bufferedCriticalHeapLevel = EspnowDatabase::criticalHeapLevel() + EspnowDatabase::criticalHeapLevelBuffer(); // We preferably want to start clearing the logs a bit before things get critical.
   // _ongoingPeerRequestNonce can change during every delay(), but we need to remember the initial value to know from where sendPeerRequestConfirmations was called.
   String initialOngoingPeerRequestNonce = _ongoingPeerRequestNonce;
   
@@ -286,6 +287,7 @@ void EspnowEncryptionBroker::sendPeerRequestConfirmations(const ExpiringTimeTrac
     confirmationsIterator->getUnencryptedPeerMac(unencryptedBSSID);
     uint8_t hashKey[hashKeyLength] {0};
     confirmationsIterator->getHashKey(hashKey);
+    bool tlv = confirmationsIterator->peerSupportsTlv();
 
     EncryptedConnectionLog *existingEncryptedConnection = EspnowConnectionManager::getEncryptedConnection(defaultBSSID);
     
@@ -301,13 +303,13 @@ void EspnowEncryptionBroker::sendPeerRequestConfirmations(const ExpiringTimeTrac
        ((reciprocalPeerRequest && EspnowConnectionManager::encryptedConnections().size() >= maxEncryptedConnections) || (!reciprocalPeerRequest && reservedEncryptedConnections() >= maxEncryptedConnections)))
     {
       EspnowTransmitter::espnowSendPeerRequestConfirmationsUnsynchronized(Serializer::createEncryptionRequestHmacMessage(FPSTR(maxConnectionsReachedHeader), 
-                                                                     confirmationsIterator->getPeerRequestNonce(), hashKey, hashKeyLength),
+                                                                     confirmationsIterator->getPeerRequestNonce(), hashKey, hashKeyLength, 0, tlv),
                                                                      defaultBSSID, 'C'); // Generates a new message ID to avoid sending encrypted sessionKeys over unencrypted connections.
                                                         
       confirmationsIterator = EspnowDatabase::peerRequestConfirmationsToSend().erase(confirmationsIterator);
     }
     else if(EspnowTransmitter::espnowSendPeerRequestConfirmationsUnsynchronized(Serializer::createEncryptionRequestHmacMessage(FPSTR(basicConnectionInfoHeader),
-                                                                            confirmationsIterator->getPeerRequestNonce(), hashKey, hashKeyLength),
+                                                                            confirmationsIterator->getPeerRequestNonce(), hashKey, hashKeyLength, 0, tlv),
                                                                             sendToDefaultBSSID ? defaultBSSID : unencryptedBSSID, 'C') // Generates a new message ID to avoid sending encrypted sessionKeys over unencrypted connections.
                                                               == TransmissionStatusType::TRANSMISSION_COMPLETE)
     {            
@@ -339,7 +341,7 @@ void EspnowEncryptionBroker::sendPeerRequestConfirmations(const ExpiringTimeTrac
       {
         // Send "node full" message
         EspnowTransmitter::espnowSendPeerRequestConfirmationsUnsynchronized(Serializer::createEncryptionRequestHmacMessage(FPSTR(maxConnectionsReachedHeader), 
-                                                                        confirmationsIterator->getPeerRequestNonce(), hashKey, hashKeyLength), 
+                                                                        confirmationsIterator->getPeerRequestNonce(), hashKey, hashKeyLength, 0, tlv), 
                                                                         defaultBSSID, 'C'); // Generates a new message ID to avoid sending encrypted sessionKeys over unencrypted connections.
       }
       else
@@ -368,7 +370,7 @@ void EspnowEncryptionBroker::sendPeerRequestConfirmations(const ExpiringTimeTrac
         // Probably no need to know which connection type to use, that is stored in request node and will be sent over for finalization.
         EspnowTransmitter::espnowSendPeerRequestConfirmationsUnsynchronized(Serializer::createEncryptedConnectionInfo(messageHeader,
                                                                         confirmationsIterator->getPeerRequestNonce(), confirmationsIterator->getAuthenticationPassword(), 
-                                                                        existingEncryptedConnection->getOwnSessionKey(), existingEncryptedConnection->getPeerSessionKey()),
+                                                                        existingEncryptedConnection->getOwnSessionKey(), existingEncryptedConnection->getPeerSessionKey(), tlv),
                                                                         defaultBSSID, 'C');  // Generates a new message ID to avoid sending encrypted sessionKeys over unencrypted connections.
       }
     
@@ -379,7 +381,7 @@ void EspnowEncryptionBroker::sendPeerRequestConfirmations(const ExpiringTimeTrac
       ++confirmationsIterator;
     }
 
-    if(ESP.getFreeHeap() <= bufferedCriticalHeapLevel)
+    if(EspnowDatabase::heapLimited())
     {
       // Heap is getting very low, which probably means we are receiving a lot of transmissions while trying to transmit responses.
       // Clear all old data to try to avoid running out of memory.
@@ -461,12 +463,16 @@ bool EspnowEncryptionBroker::verifyEncryptionRequestHmac(const String &encryptio
   String hmac;
   if(getHmac(encryptionRequestHmacMessage, hmac))
   {
-    int32_t hmacStartIndex = encryptionRequestHmacMessage.indexOf(String('"') + FPSTR(jsonHmac) + F("\":"));
+    int32_t hmacStartIndex = TlvTranslator::isTlv(encryptionRequestHmacMessage) ? TlvTranslator::getFieldIndex(encryptionRequestHmacMessage, TlvTranslator::Tag::HMAC)
+                                                                             : encryptionRequestHmacMessage.indexOf(String('"') + FPSTR(jsonHmac) + F("\":"));
     if(hmacStartIndex < 0)
       return false;
    
+    String hmacMessage = TypeCast::macToString(requesterStaMac) + TypeCast::macToString(requesterApMac);
+    hmacMessage.concat(encryptionRequestHmacMessage.c_str(), hmacStartIndex); // Unlike substring(), keeps any null characters of TLV values.
+    
     if(hmac.length() == 2*experimental::crypto::SHA256::NATURAL_LENGTH // We know that each HMAC byte should become 2 String characters due to uint8ArrayToHexString.
-       && verifyMeshHmac(TypeCast::macToString(requesterStaMac) + TypeCast::macToString(requesterApMac) + encryptionRequestHmacMessage.substring(0, hmacStartIndex), hmac, hashKey, hashKeyLength))
+       && verifyMeshHmac(hmacMessage, hmac, hashKey, hashKeyLength))
     {
       return true;
     }
@@ -519,8 +525,7 @@ bool EspnowEncryptionBroker::synchronizePeerSessionKey(const uint64_t sessionKey
   {
     if(sessionKey == encryptedConnection.getPeerSessionKey())
     {
-      uint8_t hashKey[hashKeyLength] {0};
-      encryptedConnection.setPeerSessionKey(EncryptedConnectionLog::incrementSessionKey(sessionKey, encryptedConnection.getHashKey(hashKey), hashKeyLength));
+      encryptedConnection.incrementPeerSessionKey();
       return true;
     }
   }
@@ -0,0 +1,252 @@
+/*
+  Copyright (C) 2020 Anders Löfgren
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __ESPNOWLOGTABLE_H__
+#define __ESPNOWLOGTABLE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <utility>
+#include <memory>
+#include <new>
+#include <algorithm>
+#include <assert.h>
+
+/**
+ * A fixed capacity hash table for the log entries of EspnowDatabase, keyed by a (MAC, message ID) pair.
+ *
+ * The entries are kept in a pool allocated once, on the first insert, so storing and erasing entries never allocates heap.
+ * They are found through an open addressing index (linear probing, erased positions are filled by shifting back the following ones)
+ * and linked in insertion order, which is the order of iteration. Since entries are inserted when created, the oldest entries come first
+ * and expired entries can be erased from begin() until a live entry is found, without looking at the others.
+ *
+ * When the table is full, inserting a new entry erases the oldest one.
+ *
+ * The interface is a subset of the std::map interface. Erasing an entry only invalidates the iterators to that entry.
+ */
+template <typename U, typename T, uint16_t capacity>
+class EspnowLogTable
+{
+  static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "The capacity must be a power of two.");
+
+public:
+
+  using key_type = std::pair<U, uint64_t>;
+  using mapped_type = T;
+  using value_type = std::pair<key_type, T>;
+
+  class iterator
+  {
+  public:
+    iterator() = default;
+    value_type &operator*() const { return _table->entryValue(_slot); }
+    value_type *operator->() const { return &_table->entryValue(_slot); }
+    iterator &operator++() { _slot = _table->_entries[_slot].newer; return *this; }
+    bool operator==(const iterator &other) const { return _slot == other._slot; }
+    bool operator!=(const iterator &other) const { return _slot != other._slot; }
+
+  private:
+    friend class EspnowLogTable;
+    iterator(EspnowLogTable *table, const uint16_t slot) : _table(table), _slot(slot) {}
+
+    EspnowLogTable *_table = nullptr;
+    uint16_t _slot = noSlot;
+  };
+
+  EspnowLogTable() = default;
+  EspnowLogTable(const EspnowLogTable &) = delete;
+  EspnowLogTable &operator=(const EspnowLogTable &) = delete;
+  ~EspnowLogTable() { clear(); }
+
+  iterator begin() { return iterator(this, _oldest); }
+  iterator end() { return iterator(this, noSlot); }
+
+  size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+  static constexpr size_t max_size() { return capacity; }
+
+  iterator find(const key_type &key)
+  {
+    uint16_t position = indexPosition(key);
+    return iterator(this, position == noSlot ? noSlot : _index[position]);
+  }
+
+  size_t count(const key_type &key) { return find(key) != end(); }
+
+  /**
+   * Does nothing if the key is already in the table.
+   *
+   * @return An iterator to the entry with the key of value, and true if value was inserted.
+   */
+  std::pair<iterator, bool> insert(value_type &&value)
+  {
+    iterator existing = find(value.first);
+    if(existing != end())
+      return std::make_pair(existing, false);
+
+    if(!_entries)
+    {
+      _entries.reset(new (std::nothrow) Entry[capacity]);
+      if(!_entries)
+        return std::make_pair(end(), false);
+
+      for(uint16_t slot = 0; slot < capacity; ++slot)
+        _entries[slot].newer = slot + 1 < capacity ? slot + 1 : noSlot;
+
+      _free = 0;
+      std::fill_n(_index, indexSize, noSlot);
+    }
+
+    if(_free == noSlot)
+      erase(begin());
+
+    uint16_t slot = _free;
+    _free = _entries[slot].newer;
+    new (_entries[slot].storage) value_type(std::move(value));
+
+    // Link as the newest entry
+    _entries[slot].older = _newest;
+    _entries[slot].newer = noSlot;
+    if(_newest != noSlot)
+      _entries[_newest].newer = slot;
+    else
+      _oldest = slot;
+    _newest = slot;
+
+    uint16_t position = hashPosition(entryValue(slot).first);
+    while(_index[position] != noSlot)
+      position = (position + 1) & indexMask;
+    _index[position] = slot;
+
+    ++_size;
+    return std::make_pair(iterator(this, slot), true);
+  }
+
+  std::pair<iterator, bool> insert(const value_type &value) { return insert(value_type(value)); }
+
+  /**
+   * @return An iterator to the entry inserted after the erased one.
+   */
+  iterator erase(iterator entryIterator)
+  {
+    uint16_t slot = entryIterator._slot;
+    assert(slot != noSlot);
+
+    uint16_t nextSlot = _entries[slot].newer;
+
+    unindex(slot);
+
+    // Unlink
+    if(_entries[slot].older != noSlot)
+      _entries[_entries[slot].older].newer = _entries[slot].newer;
+    else
+      _oldest = _entries[slot].newer;
+    if(_entries[slot].newer != noSlot)
+      _entries[_entries[slot].newer].older = _entries[slot].older;
+    else
+      _newest = _entries[slot].older;
+
+    entryValue(slot).~value_type();
+    _entries[slot].newer = _free;
+    _free = slot;
+    --_size;
+
+    return iterator(this, nextSlot);
+  }
+
+  size_t erase(const key_type &key)
+  {
+    iterator entryIterator = find(key);
+    if(entryIterator == end())
+      return 0;
+
+    erase(entryIterator);
+    return 1;
+  }
+
+  void clear()
+  {
+    while(!empty())
+      erase(begin());
+  }
+
+private:
+
+  static constexpr uint16_t noSlot = 0xFFFF;
+  static constexpr uint16_t indexSize = 2 * capacity; // Keeps the probe sequences short.
+  static constexpr uint16_t indexMask = indexSize - 1;
+
+  struct Entry
+  {
+    alignas(value_type) uint8_t storage[sizeof(value_type)];
+    uint16_t older;
+    uint16_t newer; // Also links the free entries
+  };
+
+  value_type &entryValue(const uint16_t slot) { return *reinterpret_cast<value_type *>(_entries[slot].storage); }
+
+  static uint16_t hashPosition(const key_type &key)
+  {
+    uint64_t hash = (static_cast<uint64_t>(key.first) ^ (key.second * 0x9E3779B97F4A7C15ULL)) * 0xFF51AFD7ED558CCDULL;
+    return static_cast<uint16_t>(hash >> 40) & indexMask;
+  }
+
+  uint16_t indexPosition(const key_type &key)
+  {
+    if(!_entries)
+      return noSlot;
+
+    for(uint16_t position = hashPosition(key); _index[position] != noSlot; position = (position + 1) & indexMask)
+    {
+      if(entryValue(_index[position]).first == key)
+        return position;
+    }
+
+    return noSlot;
+  }
+
+  void unindex(const uint16_t slot)
+  {
+    uint16_t position = hashPosition(entryValue(slot).first);
+    while(_index[position] != slot)
+      position = (position + 1) & indexMask;
+
+    // Shift back the following entries of the probe sequence which may not be found after an empty position.
+    uint16_t emptyPosition = position;
+    for(position = (position + 1) & indexMask; _index[position] != noSlot; position = (position + 1) & indexMask)
+    {
+      uint16_t home = hashPosition(entryValue(_index[position]).first);
+
+      // The entry may move to emptyPosition if home is not cyclically in (emptyPosition, position].
+      if(((position - home) & indexMask) >= ((position - emptyPosition) & indexMask))
+      {
+        _index[emptyPosition] = _index[position];
+        emptyPosition = position;
+      }
+    }
+
+    _index[emptyPosition] = noSlot;
+  }
+
+  std::unique_ptr<Entry[]> _entries;
+  uint16_t _index[indexSize];
+  uint16_t _oldest = noSlot;
+  uint16_t _newest = noSlot;
+  uint16_t _free = noSlot;
+  uint16_t _size = 0;
+};
+
+#endif
@@ -96,6 +96,7 @@ EspnowMeshBackend::~EspnowMeshBackend()
   }
 
   _database.deleteSentRequestsByOwner(this);
+  EspnowTransmitter::cancelScheduledBroadcasts(this);
 }
 
 std::vector<EspnowNetworkInfo> & EspnowMeshBackend::connectionQueue()
@@ -257,7 +258,7 @@ void EspnowMeshBackend::espnowReceiveCallbackWrapper(uint8_t *macaddr, uint8_t *
 
     if(messageType == 'Q' || messageType == 'B') // Question (request) or Broadcast
     {
-      if(ESP.getFreeHeap() <= criticalHeapLevel())
+      if(EspnowDatabase::heapCritical())
       {
         warningPrint("WARNING! Free heap below critical level. Suspending ESP-NOW request processing until the situation improves.");
         return;
@@ -354,19 +355,21 @@ void EspnowMeshBackend::espnowReceiveCallback(const uint8_t *macaddr, uint8_t *d
   
   ////// <Method overview> //////
   /*
-  if(messageStart)
+  if(broadcast messageStart)
   {
-    storeTransmission
+    filter and storeTransmission
   }
   else
   {
     if(messageFound)
-      storeTransmission or (erase and return)
+      storeTransmission or return
+    else if(not broadcast)
+      storeTransmission
     else
       return
   }
   
-  if(transmissionsRemaining != 0)
+  if(!messageComplete)
     return
     
   processMessage
@@ -374,7 +377,6 @@ void EspnowMeshBackend::espnowReceiveCallback(const uint8_t *macaddr, uint8_t *d
   ////// </Method overview> //////
 
   char messageType = getMessageType(dataArray);
-  uint8_t transmissionsRemaining = getTransmissionsRemaining(dataArray);
   uint64_t uint64Mac = TypeCast::macToUint64(macaddr);
   
   // The MAC is 6 bytes so two bytes of uint64Mac are free. We must include the messageType there since it is possible that we will
@@ -385,74 +387,71 @@ void EspnowMeshBackend::espnowReceiveCallback(const uint8_t *macaddr, uint8_t *d
   
   //uint32_t methodStart = millis();
 
-  if(isMessageStart(dataArray))
+  EspnowStatistics &statistics = EspnowDatabase::statistics();
+  ++statistics.transmissionsReceived;
+  EspnowDatabase::updateFreeHeapStatistics();
+
+  auto key = std::make_pair(macAndType, messageID);
+  EspnowDatabase::receivedEspnowTransmissions_td::iterator storedMessageIterator = EspnowDatabase::receivedEspnowTransmissions().find(key);
+
+  if(isMessageStart(dataArray) && messageType == 'B')
   {
-    if(messageType == 'B')
+    if(storedMessageIterator != EspnowDatabase::receivedEspnowTransmissions().end())
     {
-      auto key = std::make_pair(macAndType, messageID);
-      if(EspnowDatabase::receivedEspnowTransmissions().find(key) != EspnowDatabase::receivedEspnowTransmissions().end())
-        return; // Should not call BroadcastFilter more than once for an accepted message
-      
-      String message = getHashKeyLength(dataArray, len);
-      _database.setSenderMac(macaddr);
-      uint8_t senderAPMac[6] {0};
-      _database.setSenderAPMac(getTransmissionMac(dataArray, senderAPMac));
-      _encryptionBroker.setReceivedEncryptedTransmission(usesEncryption(messageID));
-      bool acceptBroadcast = getBroadcastFilter()(message, *this);
-      if(acceptBroadcast)
-      {
-        // Does nothing if key already in receivedEspnowTransmissions
-        EspnowDatabase::receivedEspnowTransmissions().insert(std::make_pair(key, MessageData(message, getTransmissionsRemaining(dataArray))));
-      }
-      else
-      {
-        return;
-      }
+      ++statistics.duplicateTransmissions;
+      return; // Should not call BroadcastFilter more than once for an accepted message
     }
-    else
-    {  
-      // Does nothing if key already in receivedEspnowTransmissions
-      EspnowDatabase::receivedEspnowTransmissions().insert(std::make_pair(std::make_pair(macAndType, messageID), MessageData(dataArray, len)));
+    
+    String message = getHashKeyLength(dataArray, len);
+    _database.setSenderMac(macaddr);
+    uint8_t senderAPMac[6] {0};
+    _database.setSenderAPMac(getTransmissionMac(dataArray, senderAPMac));
+    _encryptionBroker.setReceivedEncryptedTransmission(usesEncryption(messageID));
+    bool acceptBroadcast = getBroadcastFilter()(message, *this);
+    if(acceptBroadcast)
+    {
+      storedMessageIterator = EspnowDatabase::receivedEspnowTransmissions().insert(std::make_pair(key, MessageData(message, getTransmissionsRemaining(dataArray)))).first;
     }
-  }
-  else
-  {
-    std::map<std::pair<macAndType_td, messageID_td>, MessageData>::iterator storedMessageIterator = EspnowDatabase::receivedEspnowTransmissions().find(std::make_pair(macAndType, messageID));
-
-    if(storedMessageIterator == EspnowDatabase::receivedEspnowTransmissions().end()) // If we have not stored the key already, we missed the first message part.
+    else
     {
       return;
     }
-    
+  }
+  else if(storedMessageIterator != EspnowDatabase::receivedEspnowTransmissions().end())
+  {
     if(!storedMessageIterator->second.addToMessage(dataArray, len))
     {
-      // If we received the wrong message part, remove the whole message if we have missed a part.
-      // Otherwise just ignore the received part since it has already been stored.
-      
-      uint8_t transmissionsRemainingExpected = storedMessageIterator->second.getTransmissionsRemaining() - 1;
-      
-      if(transmissionsRemaining < transmissionsRemainingExpected)
-      {
-        EspnowDatabase::receivedEspnowTransmissions().erase(storedMessageIterator);
-        return;
-      }
+      ++statistics.duplicateTransmissions;
+      return; // The received part has already been stored.
     }
   }
+  else if(messageType != 'B')
+  {
+    // Parts of a multi-part transmission may arrive in any order, since the sender only retransmits the parts that were lost.
+    storedMessageIterator = EspnowDatabase::receivedEspnowTransmissions().insert(std::make_pair(key, MessageData(dataArray, len))).first;
+  }
+  else
+  {
+    return; // The broadcast filter has not accepted the message, since we missed the first message part.
+  }
   
   //Serial.println("methodStart storage done " + String(millis() - methodStart));
   
-  if(transmissionsRemaining != 0)
+  if(storedMessageIterator == EspnowDatabase::receivedEspnowTransmissions().end() || !storedMessageIterator->second.isComplete())
   {
     return;
   }
 
-  std::map<std::pair<macAndType_td, messageID_td>, MessageData>::iterator storedMessageIterator = EspnowDatabase::receivedEspnowTransmissions().find(std::make_pair(macAndType, messageID));
-  assert(storedMessageIterator != EspnowDatabase::receivedEspnowTransmissions().end());
+  // Take totalMessage out of the list in case user callbacks (request/responseHandler) do something odd with receivedEspnowTransmissions list.
+  // It is moved rather than copied, since the stored MessageData is erased right away.
+  String totalMessage = storedMessageIterator->second.takeTotalMessage();
 
-  // Copy totalMessage in case user callbacks (request/responseHandler) do something odd with receivedEspnowTransmissions list.
-  String totalMessage = storedMessageIterator->second.getTotalMessage(); // https://stackoverflow.com/questions/134731/returning-a-const-reference-to-an-object-instead-of-a-copy It is likely that most compilers will perform Named Value Return Value Optimisation in this case
+  uint32_t reassemblyTimeMs = storedMessageIterator->second.getTimeTracker().timeSinceCreation();
+  ++statistics.messagesReceived;
+  statistics.totalReassemblyTimeMs += reassemblyTimeMs;
+  statistics.maxReassemblyTimeMs = std::max(statistics.maxReassemblyTimeMs, reassemblyTimeMs);
 
-  EspnowDatabase::receivedEspnowTransmissions().erase(storedMessageIterator); // Erase the extra copy of the totalMessage, to save RAM. 
+  EspnowDatabase::receivedEspnowTransmissions().erase(storedMessageIterator);
    
   //Serial.println("methodStart erase done " + String(millis() - methodStart));
   
@@ -470,7 +469,8 @@ void EspnowMeshBackend::espnowReceiveCallback(const uint8_t *macaddr, uint8_t *d
      
     if(response.length() > 0)
     {
-      EspnowDatabase::responsesToSend().emplace_back(response, macaddr, messageID);
+      EspnowDatabase::responsesToSend().emplace_back(std::move(response), macaddr, messageID);
+      statistics.maxResponsesQueued = std::max<uint32_t>(statistics.maxResponsesQueued, EspnowDatabase::responsesToSend().size());
       
       //Serial.println("methodStart Q done " + String(millis() - methodStart));
     }
@@ -555,6 +555,12 @@ void EspnowMeshBackend::setEspnowRetransmissionInterval(const uint32_t intervalM
 }
 uint32_t EspnowMeshBackend::getEspnowRetransmissionInterval() {return EspnowTransmitter::getEspnowRetransmissionInterval();}
 
+void EspnowMeshBackend::setEspnowTransmissionWindow(const uint8_t transmissionWindow)
+{
+  EspnowTransmitter::setEspnowTransmissionWindow(transmissionWindow);
+}
+uint8_t EspnowMeshBackend::getEspnowTransmissionWindow() {return EspnowTransmitter::getEspnowTransmissionWindow();}
+
 void EspnowMeshBackend::setEncryptionRequestTimeout(const uint32_t timeoutMs)
 {
   EspnowDatabase::setEncryptionRequestTimeout(timeoutMs);
@@ -941,6 +947,22 @@ void EspnowMeshBackend::broadcast(const String &message)
   EspnowTransmitter::espnowSendToNode(message, EspnowProtocolInterpreter::broadcastMac, 'B', this);
 }
 
+bool EspnowMeshBackend::scheduleBroadcast(const String &message, const BroadcastLane lane, const uint8_t *sourceMac)
+{
+  return EspnowTransmitter::scheduleBroadcast(message, lane, sourceMac, this);
+}
+
+void EspnowMeshBackend::clearScheduledBroadcasts() { EspnowTransmitter::cancelScheduledBroadcasts(this); }
+
+void EspnowMeshBackend::setBroadcastBackoff(const uint32_t maxBackoffMs) { EspnowTransmitter::setBroadcastBackoff(maxBackoffMs); }
+uint32_t EspnowMeshBackend::getBroadcastBackoff() { return EspnowTransmitter::getBroadcastBackoff(); }
+void EspnowMeshBackend::setBroadcastRateLimit(const uint8_t broadcastsPerSecond) { EspnowTransmitter::setBroadcastRateLimit(broadcastsPerSecond); }
+uint8_t EspnowMeshBackend::getBroadcastRateLimit() { return EspnowTransmitter::getBroadcastRateLimit(); }
+void EspnowMeshBackend::setMaxScheduledBroadcasts(const uint8_t maxScheduledBroadcasts) { EspnowTransmitter::setMaxScheduledBroadcasts(maxScheduledBroadcasts); }
+uint8_t EspnowMeshBackend::getMaxScheduledBroadcasts() { return EspnowTransmitter::getMaxScheduledBroadcasts(); }
+const ScheduledBroadcastStats &EspnowMeshBackend::getScheduledBroadcastStats(const BroadcastLane lane) { return EspnowTransmitter::getScheduledBroadcastStats(lane); }
+void EspnowMeshBackend::resetScheduledBroadcastStats() { EspnowTransmitter::resetScheduledBroadcastStats(); }
+
 void EspnowMeshBackend::setBroadcastTransmissionRedundancy(const uint8_t redundancy) { _transmitter.setBroadcastTransmissionRedundancy(redundancy); }
 uint8_t EspnowMeshBackend::getBroadcastTransmissionRedundancy() const { return _transmitter.getBroadcastTransmissionRedundancy(); }
 
@@ -964,6 +986,11 @@ void EspnowMeshBackend::sendStoredEspnowMessages(const ExpiringTimeTracker *esti
     return;
 
   EspnowTransmitter::sendEspnowResponses(estimatedMaxDurationTracker);
+
+  if(estimatedMaxDurationTracker && estimatedMaxDurationTracker->expired())
+    return;
+
+  EspnowTransmitter::sendScheduledBroadcasts(estimatedMaxDurationTracker);
 }
 
 uint32_t EspnowMeshBackend::getMaxMessageBytesPerTransmission()
@@ -1022,6 +1049,17 @@ void EspnowMeshBackend::resetTransmissionFailRate()
   EspnowTransmitter::resetTransmissionFailRate();
 }
 
+const EspnowStatistics &EspnowMeshBackend::getEspnowStatistics()
+{
+  return EspnowDatabase::statistics();
+}
+
+void EspnowMeshBackend::resetEspnowStatistics()
+{
+  EspnowDatabase::statistics() = EspnowStatistics();
+  EspnowDatabase::updateFreeHeapStatistics();
+}
+
 String EspnowMeshBackend::serializeUnencryptedConnection()
 {
   return EspnowConnectionManager::serializeUnencryptedConnection();
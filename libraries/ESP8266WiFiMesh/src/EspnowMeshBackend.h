@@ -220,6 +220,7 @@ public:
 
   /**
    * At critical heap level no more incoming requests are accepted.
+   * This is also the case while the core MemoryPressure level is critical, when MemoryPressure.begin() has been called.
    */
   static uint32_t criticalHeapLevel();
 
@@ -303,6 +304,63 @@ public:
    */
   void broadcast(const String &message);
 
+  /**
+   * Queue a broadcast to be sent during a later performEspnowMaintenance() call, after a random backoff of at most getBroadcastBackoff() ms.
+   * Unlike broadcast(), this can be called from within callbacks.
+   * 
+   * Use it for broadcasts which repeat a message already broadcasted by a neighbour (such as forwarded mesh messages), 
+   * since neighbours that received the same broadcast would otherwise all send it at once and collide.
+   * 
+   * The CONTROL lane is always sent before the BULK lane. BULK broadcasts caused by a neighbour are dropped if the neighbour exceeds getBroadcastRateLimit(),
+   * and broadcasts of both lanes are dropped if their lane already holds getMaxScheduledBroadcasts() broadcasts.
+   * 
+   * @param message The message to send to the other nodes.
+   * @param lane The BroadcastLane to queue the broadcast in.
+   * @param sourceMac The AP MAC of the neighbour which caused the broadcast, e.g. by sending the message which is forwarded. nullptr if the broadcast is made by this node.
+   * @return True if the broadcast was queued. False if it was dropped.
+   */
+  bool scheduleBroadcast(const String &message, const BroadcastLane lane = BroadcastLane::BULK, const uint8_t *sourceMac = nullptr);
+
+  /**
+   * Remove the broadcasts scheduled by this EspnowMeshBackend instance which have not been sent yet.
+   */
+  void clearScheduledBroadcasts();
+
+  /**
+   * Set the longest random backoff of scheduled broadcasts.
+   * 
+   * @param maxBackoffMs The maximum backoff in milliseconds. Defaults to 10 ms.
+   */
+  static void setBroadcastBackoff(const uint32_t maxBackoffMs);
+  static uint32_t getBroadcastBackoff();
+
+  /**
+   * Set how many BULK broadcasts per second each neighbour may cause through scheduleBroadcast(). Short bursts of up to the same number of broadcasts are allowed.
+   * Limits the airtime a single chatty neighbour can take from the rest of the mesh.
+   * 
+   * @param broadcastsPerSecond The rate limit. Set to 0 for no limit. Defaults to 20.
+   */
+  static void setBroadcastRateLimit(const uint8_t broadcastsPerSecond);
+  static uint8_t getBroadcastRateLimit();
+
+  /**
+   * Set the maximum number of broadcasts waiting in each lane of the broadcast scheduler. 
+   * 
+   * @param maxScheduledBroadcasts The maximum number of scheduled broadcasts per lane. Defaults to 16.
+   */
+  static void setMaxScheduledBroadcasts(const uint8_t maxScheduledBroadcasts);
+  static uint8_t getMaxScheduledBroadcasts();
+
+  /**
+   * @return The number of sent and dropped broadcasts of a lane of the broadcast scheduler, and the time the sent broadcasts waited. Since power on or latest reset.
+   */
+  static const ScheduledBroadcastStats &getScheduledBroadcastStats(const BroadcastLane lane);
+
+  /**
+   * Reset the ScheduledBroadcastStats of all lanes.
+   */
+  static void resetScheduledBroadcastStats();
+
   /**
    * Set the number of redundant transmissions that will be made for every broadcast. 
    * A greater number increases the likelihood that the broadcast is received, but also means it takes longer time to send.
@@ -610,7 +668,7 @@ public:
 
   /**
    * Set the timeout to use for each ESP-NOW transmission when transmitting. 
-   * Note that for multi-part transmissions (where message length is greater than getMaxMessageBytesPerTransmission()), the timeout is reset for each transmission part.
+   * Note that for multi-part transmissions (where message length is greater than getMaxMessageBytesPerTransmission()), the timeout is reset each time a transmission part is acknowledged.
    * The default timeouts should fit most use cases, but in case you do a lot of time consuming processing when the node receives a message, you may need to relax them a bit.
    * 
    * @param timeoutMs The timeout that should be used for each ESP-NOW transmission, in milliseconds. Defaults to 40 ms.
@@ -628,6 +686,17 @@ public:
   static void setEspnowRetransmissionInterval(const uint32_t intervalMs);
   static uint32_t getEspnowRetransmissionInterval();
 
+  /**
+   * Set the number of transmission parts of a multi-part message that may be sent before the ESP-NOW API has reported the outcome of the earlier ones.
+   * A larger window reduces the time spent waiting during each message. Only the transmission parts that have not been acknowledged are sent again, 
+   * so a lost transmission part does not cause the whole message to be resent.
+   * Set to 1 to send each transmission part only after the previous one has been acknowledged.
+   * 
+   * @param transmissionWindow The maximum number of transmission parts awaiting an ack. Valid values are 1 to EspnowTransmitter::maxEspnowTransmissionWindow (8). Defaults to 4.
+   */
+  static void setEspnowTransmissionWindow(const uint8_t transmissionWindow);
+  static uint8_t getEspnowTransmissionWindow();
+
   // The maximum amount of time each of the two stages in an encrypted connection request may take.
   static void setEncryptionRequestTimeout(const uint32_t timeoutMs);
   static uint32_t getEncryptionRequestTimeout();
@@ -944,6 +1013,18 @@ public:
    */
   static void resetTransmissionFailRate();
 
+  /**
+   * Get counters of the ESP-NOW transmissions sent and received by this node, the time they took and the resources they used. Since power on or latest reset.
+   * 
+   * @return The EspnowStatistics shared by all EspnowMeshBackend instances.
+   */
+  static const EspnowStatistics &getEspnowStatistics();
+
+  /**
+   * Reset all EspnowStatistics counters. The minFreeHeap watermark starts again from the current free heap.
+   */
+  static void resetEspnowStatistics();
+
   void setWiFiChannel(const uint8 newWiFiChannel) override;
   
 protected:
@@ -967,6 +1048,8 @@ protected:
    * Note that although responses will generally be sent in the order they were created, this is not guaranteed to be the case.
    * For example, response order will be mixed up if some responses fail to transmit while others transmit successfully.
    * 
+   * Scheduled broadcasts are sent after the responses, once their backoff has passed.
+   * 
    * @param estimatedMaxDurationTracker A pointer to an ExpiringTimeTracker initialized with the desired max duration for the method. If set to nullptr there is no duration limit. 
    *                                    Note that setting the estimatedMaxDuration too low may result in missed ESP-NOW transmissions because of too little time for maintenance.
    *                                    Also note that although the method will try to respect the max duration limit, there is no guarantee. Overshoots by tens of milliseconds are possible.
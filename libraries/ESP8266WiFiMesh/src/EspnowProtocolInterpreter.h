@@ -36,6 +36,7 @@
 //            This distinction based on encryption is required since the ESP-NOW API does not provide information about whether a received transmission is encrypted or not.
 // Byte 16-249: The message.
 // Each message can be split in up to EspnowMeshBackend::getMaxTransmissionsPerMessage() transmissions, based on message size. (max three transmissions per message is the default)
+// The transmissions of a message may arrive in any order, since only the transmissions that were not acknowledged are sent again.
 
 namespace EspnowProtocolInterpreter
 { 
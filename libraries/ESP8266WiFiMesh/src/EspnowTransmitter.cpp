@@ -25,6 +25,8 @@ extern "C" {
 #include "UtilityFunctions.h"
 #include "MeshCryptoInterface.h"
 #include "JsonTranslator.h"
+#include <bitset>
+#include <list>
 
 namespace
 {
@@ -43,10 +45,157 @@ namespace
   bool _useEncryptedMessages = false;
   
   uint8_t _transmissionTargetBSSID[6] = {0};
-  
-  bool _espnowSendConfirmed = false;
+
+  // The transmissions of the ongoing message which have been sent successfully, indexed from the message start.
+  std::bitset<128> _transmissionsConfirmed;
+
+  // The send callbacks of the ESP-NOW API come in the order of the esp_now_send calls, so we keep a queue of the transmission indices awaiting a callback.
+  uint8_t _inFlightTransmissions[EspnowTransmitter::maxEspnowTransmissionWindow] = {0};
+  uint8_t _inFlightStart = 0;
+  uint8_t _transmissionsInFlight = 0;
+  uint8_t _ignoredCallbacks = 0;
 
   uint8_t _maxTransmissionsPerMessage = 3;
+  uint8_t _espnowTransmissionWindow = 4;
+
+  struct ScheduledBroadcast
+  {
+    String message;
+    EspnowMeshBackend *espnowInstance;
+    TimeTracker queueTime;
+    uint32_t backoffMs;
+  };
+
+  constexpr uint8_t laneCount = 2;
+  
+  // Entries are only added to the back and taken from the front of the lanes, so callbacks can schedule broadcasts while the lanes are being sent.
+  std::list<ScheduledBroadcast> _broadcastLanes[laneCount];
+  ScheduledBroadcastStats _broadcastLaneStats[laneCount];
+  
+  uint32_t _maxBroadcastBackoffMs = 10;
+  uint8_t _maxScheduledBroadcasts = 16; // Per lane
+  uint8_t _broadcastRateLimit = 20; // Per neighbour and second, 0 means no limit.
+
+  // Token buckets for the rate limit, for the most recently seen neighbours.
+  struct BroadcastRateBucket
+  {
+    uint64_t sourceMac = 0;
+    uint32_t tokens = 0; // In thousandths of a broadcast
+    uint32_t refillTimeMs = 0;
+  };
+
+  constexpr uint8_t rateBucketCount = 8;
+  BroadcastRateBucket _broadcastRateBuckets[rateBucketCount];
+  
+  bool takeBroadcastToken(const uint64_t sourceMac)
+  {
+    uint32_t currentTimeMs = millis();
+    uint32_t maxTokens = _broadcastRateLimit * 1000;
+    
+    BroadcastRateBucket *bucket = &_broadcastRateBuckets[0];
+    for(BroadcastRateBucket &candidate : _broadcastRateBuckets)
+    {
+      if(candidate.sourceMac == sourceMac)
+      {
+        bucket = &candidate;
+        break;
+      }
+      
+      if(currentTimeMs - candidate.refillTimeMs > currentTimeMs - bucket->refillTimeMs)
+        bucket = &candidate; // The least recently refilled bucket is replaced if the neighbour has none.
+    }
+
+    if(bucket->sourceMac != sourceMac)
+    {
+      bucket->sourceMac = sourceMac;
+      bucket->tokens = maxTokens;
+    }
+    else
+    {
+      // Each ms gives _broadcastRateLimit thousandths of a broadcast. The elapsed time is capped to avoid overflow.
+      bucket->tokens = std::min<uint32_t>(bucket->tokens + std::min<uint32_t>(currentTimeMs - bucket->refillTimeMs, 1000) * _broadcastRateLimit, maxTokens);
+    }
+    
+    bucket->refillTimeMs = currentTimeMs;
+    
+    if(bucket->tokens < 1000)
+      return false;
+
+    bucket->tokens -= 1000;
+    return true;
+  }
+
+  void forgetInFlightTransmissions()
+  {
+    // Callbacks arriving later belong to an earlier round of transmissions and must not confirm the current ones.
+    _ignoredCallbacks = std::min<uint32_t>(_ignoredCallbacks + _transmissionsInFlight, EspnowTransmitter::maxEspnowTransmissionWindow);
+    _transmissionsInFlight = 0;
+  }
+
+  /**
+   * Fill transmission with the protocol bytes and the message bytes for the transmission having transmissionsRemaining
+   * transmissions after it in a message of transmissionCount transmissions.
+   *
+   * @param transmission An array of at least getMaxBytesPerTransmission() bytes.
+   * @return The size of the transmission in bytes.
+   */
+  uint8_t createTransmission(uint8_t *transmission, const String &message, const char messageType, const uint64_t messageID, const uint8_t transmissionsRemaining, const uint8_t transmissionCount)
+  {
+    using namespace EspnowProtocolInterpreter;
+
+    uint8_t espnowMetadataSize = metadataSize();
+    uint8_t transmissionSize = 0;
+
+    if(transmissionsRemaining > 0)
+    {
+      transmissionSize = getMaxBytesPerTransmission();
+    }
+    else
+    {
+      transmissionSize = espnowMetadataSize;
+      
+      if(message.length() > 0)
+      {
+        uint32_t remainingLength = message.length() % getMaxMessageBytesPerTransmission();
+        transmissionSize += (remainingLength == 0 ? getMaxMessageBytesPerTransmission() : remainingLength);
+      }
+    }
+
+    ////// Fill protocol bytes //////
+    
+    transmission[messageTypeIndex] = messageType;
+    
+    if(transmissionsRemaining == transmissionCount - 1)
+    {
+      transmission[transmissionsRemainingIndex] = (char)(transmissionsRemaining | 0x80);
+    }
+    else
+    {
+      transmission[transmissionsRemainingIndex] = (char)transmissionsRemaining;
+    }
+
+    // Fills indices in range [transmissionMacIndex, transmissionMacIndex + 5] (6 bytes) with the MAC address of the WiFi AP interface.
+    // We always transmit from the station interface (due to using ESP_NOW_ROLE_CONTROLLER), so this makes it possible to always know both interface MAC addresses of a node that sends a transmission.
+    WiFi.softAPmacAddress(transmission + transmissionMacIndex);
+
+    setMessageID(transmission, messageID);
+
+    ////// Fill message bytes //////
+    
+    int32_t transmissionStartIndex = (transmissionCount - transmissionsRemaining - 1) * getMaxMessageBytesPerTransmission();
+    
+    std::copy_n(message.begin() + transmissionStartIndex, transmissionSize - espnowMetadataSize, transmission + espnowMetadataSize);
+
+    if(EspnowTransmitter::useEncryptedMessages())
+    {      
+      // chacha20Poly1305Encrypt encrypts transmission in place.
+      // We are using the protocol bytes as a key salt.
+      experimental::crypto::ChaCha20Poly1305::encrypt(transmission + espnowMetadataSize, transmissionSize - espnowMetadataSize, EspnowTransmitter::getEspnowMessageEncryptionKey(), transmission, 
+                                               protocolBytesSize, transmission + protocolBytesSize, transmission + protocolBytesSize + 12);
+    }
+
+    return transmissionSize;
+  }
 }
 
 EspnowTransmitter::EspnowTransmitter(ConditionalPrinter &conditionalPrinterInstance, EspnowDatabase &databaseInstance, EspnowConnectionManager &connectionManagerInstance) 
@@ -56,10 +205,21 @@ EspnowTransmitter::EspnowTransmitter(ConditionalPrinter &conditionalPrinterInsta
 
 void EspnowTransmitter::espnowSendCallback(uint8_t* mac, uint8_t sendStatus)
 {
-  if(_espnowSendConfirmed)
+  if(_ignoredCallbacks > 0)
+  {
+    --_ignoredCallbacks;
+    return;
+  }
+  
+  if(_transmissionsInFlight == 0)
     return;
-  else if(!sendStatus && MeshUtilityFunctions::macEqual(mac, _transmissionTargetBSSID)) // sendStatus == 0 when send was OK.
-    _espnowSendConfirmed = true; // We do not want to reset this to false. That only happens before transmissions. Otherwise subsequent failed send attempts may obscure an initial successful one.
+
+  uint8_t transmissionIndex = _inFlightTransmissions[_inFlightStart];
+  _inFlightStart = (_inFlightStart + 1) % maxEspnowTransmissionWindow;
+  --_transmissionsInFlight;
+  
+  if(!sendStatus && MeshUtilityFunctions::macEqual(mac, _transmissionTargetBSSID)) // sendStatus == 0 when send was OK.
+    _transmissionsConfirmed[transmissionIndex] = true; // We do not want to reset this to false. That only happens before transmissions. Otherwise subsequent failed send attempts may obscure an initial successful one.
 }
 
 void EspnowTransmitter::setUseEncryptedMessages(const bool useEncryptedMessages) 
@@ -109,6 +269,15 @@ void EspnowTransmitter::setMaxTransmissionsPerMessage(const uint8_t maxTransmiss
 
 uint8_t EspnowTransmitter::getMaxTransmissionsPerMessage() {return _maxTransmissionsPerMessage;}
 
+void EspnowTransmitter::setEspnowTransmissionWindow(const uint8_t transmissionWindow)
+{
+  assert(1 <= transmissionWindow && transmissionWindow <= maxEspnowTransmissionWindow);
+  
+  _espnowTransmissionWindow = transmissionWindow;
+}
+
+uint8_t EspnowTransmitter::getEspnowTransmissionWindow() {return _espnowTransmissionWindow;}
+
 uint32_t EspnowTransmitter::getMaxMessageLength()
 {
   return getMaxTransmissionsPerMessage() * EspnowProtocolInterpreter::getMaxMessageBytesPerTransmission();
@@ -140,9 +309,79 @@ void EspnowTransmitter::resetTransmissionFailRate()
   _transmissionsTotal = 0;
 }
 
+bool EspnowTransmitter::scheduleBroadcast(const String &message, const BroadcastLane lane, const uint8_t *sourceMac, EspnowMeshBackend *espnowInstance)
+{
+  assert(espnowInstance); // espnowInstance required when transmitting 'B' type messages.
+  
+  uint8_t laneIndex = static_cast<uint8_t>(lane);
+  
+  if(_broadcastLanes[laneIndex].size() >= getMaxScheduledBroadcasts() 
+     || (lane == BroadcastLane::BULK && sourceMac && getBroadcastRateLimit() > 0 && !takeBroadcastToken(TypeCast::macToUint64(sourceMac))))
+  {
+    ++_broadcastLaneStats[laneIndex].dropped;
+    return false;
+  }
+
+  // The random backoff makes neighbours which received the same broadcast unlikely to forward it at the same time.
+  _broadcastLanes[laneIndex].push_back({message, espnowInstance, TimeTracker(millis()), ESP.random() % (getBroadcastBackoff() + 1)});
+  return true;
+}
+
+void EspnowTransmitter::sendScheduledBroadcasts(const ExpiringTimeTracker *estimatedMaxDurationTracker)
+{
+  while(true)
+  {
+    uint8_t laneIndex = 0;
+    while(laneIndex < laneCount && (_broadcastLanes[laneIndex].empty() 
+                                    || _broadcastLanes[laneIndex].front().queueTime.timeSinceCreation() < _broadcastLanes[laneIndex].front().backoffMs))
+    {
+      ++laneIndex;
+    }
+
+    if(laneIndex == laneCount)
+      return; // No broadcast is due
+    
+    ScheduledBroadcast broadcast = std::move(_broadcastLanes[laneIndex].front());
+    _broadcastLanes[laneIndex].pop_front();
+
+    ScheduledBroadcastStats &stats = _broadcastLaneStats[laneIndex];
+    uint32_t queueDelayMs = broadcast.queueTime.timeSinceCreation();
+    ++stats.sent;
+    stats.totalQueueDelayMs += queueDelayMs;
+    stats.maxQueueDelayMs = std::max(stats.maxQueueDelayMs, queueDelayMs);
+
+    espnowSendToNode(broadcast.message, EspnowProtocolInterpreter::broadcastMac, 'B', broadcast.espnowInstance);
+
+    if(estimatedMaxDurationTracker && estimatedMaxDurationTracker->expired())
+      return;
+  }
+}
+
+void EspnowTransmitter::cancelScheduledBroadcasts(const EspnowMeshBackend *espnowInstance)
+{
+  for(std::list<ScheduledBroadcast> &broadcastLane : _broadcastLanes)
+    broadcastLane.remove_if([espnowInstance](const ScheduledBroadcast &broadcast){ return broadcast.espnowInstance == espnowInstance; });
+}
+
+void EspnowTransmitter::setBroadcastBackoff(const uint32_t maxBackoffMs) { _maxBroadcastBackoffMs = maxBackoffMs; }
+uint32_t EspnowTransmitter::getBroadcastBackoff() { return _maxBroadcastBackoffMs; }
+
+void EspnowTransmitter::setBroadcastRateLimit(const uint8_t broadcastsPerSecond) { _broadcastRateLimit = broadcastsPerSecond; }
+uint8_t EspnowTransmitter::getBroadcastRateLimit() { return _broadcastRateLimit; }
+
+void EspnowTransmitter::setMaxScheduledBroadcasts(const uint8_t maxScheduledBroadcasts) { _maxScheduledBroadcasts = maxScheduledBroadcasts; }
+uint8_t EspnowTransmitter::getMaxScheduledBroadcasts() { return _maxScheduledBroadcasts; }
+
+const ScheduledBroadcastStats &EspnowTransmitter::getScheduledBroadcastStats(const BroadcastLane lane) { return _broadcastLaneStats[static_cast<uint8_t>(lane)]; }
+
+void EspnowTransmitter::resetScheduledBroadcastStats()
+{
+  for(ScheduledBroadcastStats &stats : _broadcastLaneStats)
+    stats = ScheduledBroadcastStats();
+}
+
 void EspnowTransmitter::sendEspnowResponses(const ExpiringTimeTracker *estimatedMaxDurationTracker)
 {
-  uint32_t bufferedCriticalHeapLevel = EspnowDatabase::criticalHeapLevel() + EspnowDatabase::criticalHeapLevelBuffer(); // We preferably want to start clearing the logs a bit before things get critical.
 
   MutexTracker responsesToSendMutexTracker(EspnowDatabase::captureResponsesToSendMutex());
   if(!responsesToSendMutexTracker.mutexCaptured())
@@ -181,7 +420,7 @@ void EspnowTransmitter::sendEspnowResponses(const ExpiringTimeTracker *estimated
       ++responseIterator;
     }
 
-    if(ESP.getFreeHeap() <= bufferedCriticalHeapLevel)
+    if(EspnowDatabase::heapLimited())
     {
       // Heap is getting very low, which probably means we are receiving a lot of transmissions while trying to transmit responses.
       // Clear all old data to try to avoid running out of memory.
@@ -257,6 +496,10 @@ TransmissionStatusType EspnowTransmitter::espnowSendToNodeUnsynchronized(const S
 
   _transmissionsTotal++;
 
+  EspnowStatistics &statistics = EspnowDatabase::statistics();
+  EspnowDatabase::updateFreeHeapStatistics();
+  uint32_t sendStartTimeMs = millis();
+
   // Though it is possible to handle messages requiring more than 3 transmissions with the current design, transmission fail rates would increase dramatically. 
   // Messages composed of up to 128 transmissions can be handled without modification, but RAM limitations on the ESP8266 would make this hard in practice. 
   // We thus prefer to keep the code simple and performant instead.
@@ -268,132 +511,120 @@ TransmissionStatusType EspnowTransmitter::espnowSendToNodeUnsynchronized(const S
     assert(transmissionsRequired == 1); // These messages are assumed to be contained in one message by the receive callbacks.
   }
   
-  uint8_t transmissionSize = 0;
+  uint8_t transmissionCount = transmissionsRemaining + 1;
   bool messageStart = true;
-  uint8_t espnowMetadataSize = metadataSize();
+  bool requestStored = false;
+
+  uint32_t passes = 1;
+  if(messageType == 'B')
+    passes += espnowInstance->getBroadcastTransmissionRedundancy();
 
-  do
+  // Broadcasts are sent passes times, each transmission being confirmed once per pass.
+  for(uint32_t pass = 0; pass < passes; ++pass)
   {
-    ////// Manage logs //////
-    
-    if(transmissionsRemaining == 0 && (messageType == 'Q' || messageType == 'B'))
-    {
-      assert(espnowInstance); // espnowInstance required when transmitting 'Q' and 'B' type messages.
-      // If we are sending the last transmission of a request we should store the sent request in the log no matter if we receive an ack for the final transmission or not.
-      // That way we will always be ready to receive the response to the request when there is a chance the request message was transmitted successfully, 
-      // even if the final ack for the request message was lost.
-      EspnowDatabase::storeSentRequest(TypeCast::macToUint64(_transmissionTargetBSSID), messageID, RequestData(*espnowInstance));
-    }
-    
-    ////// Create transmission array //////
-    
-    if(transmissionsRemaining > 0)
-    {
-      transmissionSize = getMaxBytesPerTransmission();
-    }
-    else
+    _transmissionsConfirmed.reset();
+    std::bitset<128> transmissionsSent; // In this pass
+    uint8_t transmissionsConfirmed = 0;
+    ExpiringTimeTracker transmissionTimeout([](){ return getEspnowTransmissionTimeout(); });
+
+    // Each round sends every transmission of the message not yet confirmed, up to getEspnowTransmissionWindow() of them awaiting their send callback at once,
+    // and then waits for the callbacks. So only the transmissions that were lost are sent again.
+    while(transmissionsConfirmed < transmissionCount && !transmissionTimeout)
     {
-      transmissionSize = espnowMetadataSize;
-      
-      if(message.length() > 0)
+      ExpiringTimeTracker retransmissionTime([](){ return getEspnowRetransmissionInterval(); });
+
+      for(uint8_t transmissionIndex = 0; transmissionIndex < transmissionCount && !transmissionTimeout; ++transmissionIndex)
       {
-        uint32_t remainingLength = message.length() % getMaxMessageBytesPerTransmission();
-        transmissionSize += (remainingLength == 0 ? getMaxMessageBytesPerTransmission() : remainingLength);
-      }
-    }
-    
-    uint8_t transmission[transmissionSize];
+        if(_transmissionsConfirmed[transmissionIndex])
+          continue;
 
-    ////// Fill protocol bytes //////
-    
-    transmission[messageTypeIndex] = messageType;
-    
-    if(messageStart)
-    {
-      transmission[transmissionsRemainingIndex] = (char)(transmissionsRemaining | 0x80);
-    }
-    else
-    {
-      transmission[transmissionsRemainingIndex] = (char)transmissionsRemaining;
-    }
+        ////// Manage logs //////
 
-    // Fills indices in range [transmissionMacIndex, transmissionMacIndex + 5] (6 bytes) with the MAC address of the WiFi AP interface.
-    // We always transmit from the station interface (due to using ESP_NOW_ROLE_CONTROLLER), so this makes it possible to always know both interface MAC addresses of a node that sends a transmission.
-    WiFi.softAPmacAddress(transmission + transmissionMacIndex);
+        if(!requestStored && transmissionIndex == transmissionCount - 1 && (messageType == 'Q' || messageType == 'B'))
+        {
+          assert(espnowInstance); // espnowInstance required when transmitting 'Q' and 'B' type messages.
+          // If we are sending the last transmission of a request we should store the sent request in the log no matter if we receive an ack for the final transmission or not.
+          // That way we will always be ready to receive the response to the request when there is a chance the request message was transmitted successfully, 
+          // even if the final ack for the request message was lost.
+          EspnowDatabase::storeSentRequest(TypeCast::macToUint64(_transmissionTargetBSSID), messageID, RequestData(*espnowInstance));
+          requestStored = true;
+        }
 
-    setMessageID(transmission, messageID);
+        while(_transmissionsInFlight >= getEspnowTransmissionWindow() && !retransmissionTime && !transmissionTimeout)
+        {
+          delay(1); // Note that callbacks can be called during delay time, so it is possible to receive a transmission during this delay.
+        }
 
-    ////// Fill message bytes //////
-    
-    int32_t transmissionStartIndex = (transmissionsRequired - transmissionsRemaining - 1) * getMaxMessageBytesPerTransmission();
-    
-    std::copy_n(message.begin() + transmissionStartIndex, transmissionSize - espnowMetadataSize, transmission + espnowMetadataSize);
+        if(_transmissionsInFlight >= getEspnowTransmissionWindow())
+          break; // Send callbacks are late, wait for them below before sending more.
 
-    if(useEncryptedMessages())
-    {      
-      // chacha20Poly1305Encrypt encrypts transmission in place.
-      // We are using the protocol bytes as a key salt.
-      experimental::crypto::ChaCha20Poly1305::encrypt(transmission + espnowMetadataSize, transmissionSize - espnowMetadataSize, getEspnowMessageEncryptionKey(), transmission, 
-                                               protocolBytesSize, transmission + protocolBytesSize, transmission + protocolBytesSize + 12);
-    }
-    
-    ////// Transmit //////
+        uint8_t transmission[getMaxBytesPerTransmission()];
+        uint8_t transmissionSize = createTransmission(transmission, message, messageType, messageID, transmissionCount - 1 - transmissionIndex, transmissionCount);
 
-    uint32_t retransmissions = 0;
-    if(messageType == 'B')
-      retransmissions = espnowInstance->getBroadcastTransmissionRedundancy();
-      
-    for(uint32_t i = 0; i <= retransmissions; ++i)
-    {
-      _espnowSendConfirmed = false;
-      ExpiringTimeTracker transmissionTimeout([](){ return getEspnowTransmissionTimeout(); });
-      
-      while(!_espnowSendConfirmed && !transmissionTimeout)
-      {
-        if(esp_now_send(_transmissionTargetBSSID, transmission, transmissionSize) == 0) // == 0 => Success
+        // Register the transmission before sending, since the send callback may be called before esp_now_send returns.
+        _inFlightTransmissions[(_inFlightStart + _transmissionsInFlight) % maxEspnowTransmissionWindow] = transmissionIndex;
+        ++_transmissionsInFlight;
+
+        if(esp_now_send(_transmissionTargetBSSID, transmission, transmissionSize) != 0) // != 0 => Fail
         {
-          ExpiringTimeTracker retransmissionTime([](){ return getEspnowRetransmissionInterval(); });
-          while(!_espnowSendConfirmed && !retransmissionTime && !transmissionTimeout)
-          {        
-            delay(1); // Note that callbacks can be called during delay time, so it is possible to receive a transmission during this delay.
-          }
+          --_transmissionsInFlight;
+          break; // Probably the send queue of the SDK is full.
         }
-  
-        if(_espnowSendConfirmed)
+
+        ++statistics.transmissionsSent;
+        if(transmissionsSent[transmissionIndex])
+          ++statistics.transmissionsResent;
+        transmissionsSent[transmissionIndex] = true;
+      }
+
+      while(_transmissionsInFlight > 0 && !retransmissionTime && !transmissionTimeout)
+      {
+        delay(1); // Note that callbacks can be called during delay time, so it is possible to receive a transmission during this delay.
+      }
+
+      if(_transmissionsInFlight > 0 && retransmissionTime)
+        forgetInFlightTransmissions(); // The callbacks will probably never come, ignore them if they do.
+
+      uint8_t transmissionsConfirmedNow = _transmissionsConfirmed.count();
+      if(transmissionsConfirmedNow > transmissionsConfirmed)
+      {
+        transmissionsConfirmed = transmissionsConfirmedNow;
+        transmissionTimeout.reset(); // The timeout applies to each transmission part.
+      }
+
+      if(messageStart && _transmissionsConfirmed[0])
+      {
+        if(encryptedConnection && !usesConstantSessionKey(messageType) && encryptedConnection->getOwnSessionKey() == messageID)
         {
-          if(messageStart)
-          {        
-            if(encryptedConnection && !usesConstantSessionKey(messageType) && encryptedConnection->getOwnSessionKey() == messageID)
-            {
-              encryptedConnection->setDesync(false);
-              encryptedConnection->incrementOwnSessionKey();
-            }
-            
-            messageStart = false;
-          }  
-          
-          break;
+          encryptedConnection->setDesync(false);
+          encryptedConnection->incrementOwnSessionKey();
         }
+
+        messageStart = false;
       }
     }
-    
-    if(!_espnowSendConfirmed)
+
+    if(transmissionsConfirmed < transmissionCount)
     {
       ++_transmissionsFailed;
+      ++statistics.messagesFailed;
 
       ConditionalPrinter::staticVerboseModePrint(String(F("espnowSendToNode failed!")));
-      ConditionalPrinter::staticVerboseModePrint(String(F("Transmission #: ")) + String(transmissionsRequired - transmissionsRemaining) + String('/') + String(transmissionsRequired));
+      ConditionalPrinter::staticVerboseModePrint(String(F("Transmissions confirmed: ")) + String(transmissionsConfirmed) + String('/') + String(transmissionCount));
       ConditionalPrinter::staticVerboseModePrint(String(F("Transmission fail rate (up) ")) + String(getTransmissionFailRate()));
 
+      forgetInFlightTransmissions();
+
       if(messageStart && encryptedConnection && !usesConstantSessionKey(messageType) && encryptedConnection->getOwnSessionKey() == messageID)
         encryptedConnection->setDesync(true);
       
       return TransmissionStatusType::TRANSMISSION_FAILED;
     }
+  }
 
-    --transmissionsRemaining; // This is used when transferring multi-transmission messages.
-    
-  } while(transmissionsRemaining >= 0);
+  ++statistics.messagesSent;
+  statistics.messageBytesSent += message.length();
+  statistics.totalSendTimeMs += millis() - sendStartTimeMs;
 
   // Useful when debugging the protocol
   //_conditionalPrinter.staticVerboseModePrint("Sent to Mac: " + TypeCast::macToString(_transmissionTargetBSSID) + " ID: " + TypeCast::uint64ToString(messageID)); 
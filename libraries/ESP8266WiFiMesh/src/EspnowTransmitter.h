@@ -26,6 +26,20 @@
 
 class EspnowMeshBackend;
 
+enum class BroadcastLane : uint8_t
+{
+  CONTROL = 0, // Small, latency sensitive broadcasts. Always sent before BULK broadcasts and never rate limited.
+  BULK = 1
+};
+
+struct ScheduledBroadcastStats
+{
+  uint32_t sent = 0;
+  uint32_t dropped = 0; // Because the lane was full or the source exceeded the rate limit.
+  uint32_t totalQueueDelayMs = 0; // The summed time the sent broadcasts waited in the lane. Divide by sent for the average delay.
+  uint32_t maxQueueDelayMs = 0;
+};
+
 class EspnowTransmitter
 {
 
@@ -33,6 +47,8 @@ public:
 
   using responseTransmittedHookType = std::function<bool(bool, const String &, const uint8_t *, uint32_t, EspnowMeshBackend &)>;
 
+  static constexpr uint8_t maxEspnowTransmissionWindow = 8;
+
   EspnowTransmitter(ConditionalPrinter &conditionalPrinterInstance, EspnowDatabase &databaseInstance, EspnowConnectionManager &connectionManagerInstance);
 
   static void espnowSendCallback(uint8_t* mac, uint8_t sendStatus);
@@ -68,6 +84,8 @@ public:
   static void setMaxTransmissionsPerMessage(const uint8_t maxTransmissionsPerMessage);
   static uint8_t getMaxTransmissionsPerMessage();
   static uint32_t getMaxMessageLength();
+  static void setEspnowTransmissionWindow(const uint8_t transmissionWindow);
+  static uint8_t getEspnowTransmissionWindow();
   static void setEspnowTransmissionTimeout(const uint32_t timeoutMs);
   static uint32_t getEspnowTransmissionTimeout();
   static void setEspnowRetransmissionInterval(const uint32_t intervalMs);
@@ -82,6 +100,29 @@ public:
    */
   static void sendEspnowResponses(const ExpiringTimeTracker *estimatedMaxDurationTracker = nullptr);
 
+  /**
+   * Queue a broadcast in a lane of the broadcast scheduler. It is sent by sendScheduledBroadcasts() after a random backoff.
+   * 
+   * @param sourceMac The AP MAC of the neighbour which caused the broadcast (e.g. by sending a message which is forwarded), used for the rate limit of the BULK lane. 
+   *                  nullptr if the broadcast is made by this node.
+   * @return True if the broadcast was queued. False if it was dropped.
+   */
+  static bool scheduleBroadcast(const String &message, const BroadcastLane lane, const uint8_t *sourceMac, EspnowMeshBackend *espnowInstance);
+  
+  /*
+   * @param estimatedMaxDurationTracker A pointer to an ExpiringTimeTracker initialized with the desired max duration for the method. If set to nullptr there is no duration limit. 
+   */
+  static void sendScheduledBroadcasts(const ExpiringTimeTracker *estimatedMaxDurationTracker = nullptr);
+  static void cancelScheduledBroadcasts(const EspnowMeshBackend *espnowInstance);
+  static void setBroadcastBackoff(const uint32_t maxBackoffMs);
+  static uint32_t getBroadcastBackoff();
+  static void setBroadcastRateLimit(const uint8_t broadcastsPerSecond);
+  static uint8_t getBroadcastRateLimit();
+  static void setMaxScheduledBroadcasts(const uint8_t maxScheduledBroadcasts);
+  static uint8_t getMaxScheduledBroadcasts();
+  static const ScheduledBroadcastStats &getScheduledBroadcastStats(const BroadcastLane lane);
+  static void resetScheduledBroadcastStats();
+
   /** 
    * Will be captured if a transmission initiated by a public method is in progress.
    */
@@ -32,6 +32,7 @@ namespace
   namespace TypeCast = MeshTypeConversionFunctions;
   
   constexpr uint8_t MESSAGE_ID_LENGTH = 17; // 16 characters and one delimiter
+  constexpr uint8_t UNICAST_TARGET_LENGTH = 14; // One delimiter, 12 characters and one delimiter
   constexpr uint8_t MESSAGE_COMPLETE = 255;
 
   char _metadataDelimiter = 23; // Defaults to 23 = End-of-Transmission-Block (ETB) control character in ASCII
@@ -150,6 +151,14 @@ void FloodingMesh::performMeshInstanceMaintenance()
     
     EspnowMeshBackend::performEspnowMaintenance(); // It is best to performEspnowMaintenance frequently to keep the Espnow backend responsive. Especially if each encryptedBroadcast takes a lot of time.
   }
+
+  while(!_unicastBacklog.empty())
+  {
+    unicastKernel(_unicastBacklog.front().first, _unicastBacklog.front().second);
+    _unicastBacklog.pop_front();
+    
+    EspnowMeshBackend::performEspnowMaintenance();
+  }
 }
 
 String FloodingMesh::serializeMeshState() const
@@ -221,15 +230,122 @@ void FloodingMesh::encryptedBroadcastKernel(const String &message)
   getEspnowMeshBackend().attemptAutoEncryptingTransmission(message, true);
 }
 
+void FloodingMesh::unicast(const String &message, const uint8_t *targetAPMac)
+{
+  assert(message.length() <= maxUnicastMessageLength());
+
+  String messageID = generateMessageID();
+  
+  unicastKernel(messageID + String(metadataDelimiter()) + String(metadataDelimiter()) + TypeCast::macToString(targetAPMac) + String(metadataDelimiter()) + message, 
+                TypeCast::macToUint64(targetAPMac));
+}
+
+void FloodingMesh::unicastKernel(const String &message, const uint64_t targetAPMac)
+{
+  if(useRouting())
+  {
+    uint8_t targetMacArray[6] = { 0 };
+    uint8_t nextHopMacArray[6] = { 0 };
+    
+    if(getNextHop(TypeCast::uint64ToMac(targetAPMac, targetMacArray), nextHopMacArray))
+    {
+      uint64_t nextHopAPMac = TypeCast::macToUint64(nextHopMacArray);
+      
+      if(getEspnowMeshBackend().attemptTransmission(message, EspnowNetworkInfo(nextHopMacArray)) == TransmissionStatusType::TRANSMISSION_COMPLETE)
+      {
+        learnRoute(nextHopAPMac, nextHopAPMac);
+        learnRoute(targetAPMac, nextHopAPMac);
+        return;
+      }
+
+      forgetRoutesThrough(nextHopAPMac);
+    }
+  }
+
+  // No usable route, so flood the message. Only the target will give it to its messageHandler.
+  getEspnowMeshBackend().scheduleBroadcast(getEspnowMeshBackend().getMeshName() + String(metadataDelimiter()) + message);
+}
+
+void FloodingMesh::setUseRouting(const bool useRouting) 
+{ 
+  _useRouting = useRouting; 
+
+  if(!useRouting)
+    clearRoutingTable();
+}
+bool FloodingMesh::useRouting() const { return _useRouting; }
+
+void FloodingMesh::setRouteLifetime(const uint32_t routeLifetimeMs) { _routeLifetimeMs = routeLifetimeMs; }
+uint32_t FloodingMesh::getRouteLifetime() const { return _routeLifetimeMs; }
+
+uint8_t *FloodingMesh::getNextHop(const uint8_t *targetAPMac, uint8_t *nextHopMacArray)
+{
+  auto routeIterator = _routingTable.find(TypeCast::macToUint64(targetAPMac));
+
+  if(routeIterator == _routingTable.end())
+    return nullptr;
+
+  if(routeIterator->second.second.timeSinceCreation() > getRouteLifetime())
+  {
+    _routingTable.erase(routeIterator);
+    return nullptr;
+  }
+  
+  return TypeCast::uint64ToMac(routeIterator->second.first, nextHopMacArray);
+}
+
+void FloodingMesh::clearRoutingTable()
+{
+  _routingTable.clear();
+}
+
+void FloodingMesh::learnRoute(const uint64_t targetAPMac, const uint64_t nextHopAPMac)
+{
+  auto routeIterator = _routingTable.find(targetAPMac);
+  
+  if(routeIterator != _routingTable.end())
+  {
+    routeIterator->second = std::make_pair(nextHopAPMac, TimeTracker(millis()));
+    return;
+  }
+  
+  if(_routingTable.size() >= _maxRoutes)
+  {
+    // Make room by forgetting the least recently confirmed route.
+    auto oldestRouteIterator = _routingTable.begin();
+    for(auto candidateIterator = _routingTable.begin(); candidateIterator != _routingTable.end(); ++candidateIterator)
+    {
+      if(candidateIterator->second.second.timeSinceCreation() > oldestRouteIterator->second.second.timeSinceCreation())
+        oldestRouteIterator = candidateIterator;
+    }
+    
+    _routingTable.erase(oldestRouteIterator);
+  }
+  
+  _routingTable.emplace(targetAPMac, std::make_pair(nextHopAPMac, TimeTracker(millis())));
+}
+
+void FloodingMesh::forgetRoutesThrough(const uint64_t nextHopAPMac)
+{
+  for(auto routeIterator = _routingTable.begin(); routeIterator != _routingTable.end(); )
+  {
+    if(routeIterator->second.first == nextHopAPMac)
+      routeIterator = _routingTable.erase(routeIterator);
+    else
+      ++routeIterator;
+  }
+}
+
 void FloodingMesh::clearMessageLogs()
 {
   _messageIDs.clear();
-  std::queue<messageQueueElementType>().swap(_messageIdOrder);
 }
 
 void FloodingMesh::clearForwardingBacklog()
 {
   getForwardingBacklog().clear();
+  _unicastBacklog.clear();
+  getEspnowMeshBackend().clearScheduledBroadcasts();
 }
  
 void FloodingMesh::setMessageHandler(const messageHandlerType messageHandler) { _messageHandler = messageHandler; }
@@ -256,6 +372,11 @@ uint32_t FloodingMesh::maxUnencryptedMessageLength() const
   return getEspnowMeshBackendConst().getMaxMessageLength() - MESSAGE_ID_LENGTH - (getEspnowMeshBackendConst().getMeshName().length() + 1); // Need room for mesh name + delimiter
 }
 
+uint32_t FloodingMesh::maxUnicastMessageLength() const
+{
+  return maxUnencryptedMessageLength() - UNICAST_TARGET_LENGTH; // Need room for the target AP MAC, which is surrounded by delimiters
+}
+
 uint32_t FloodingMesh::maxEncryptedMessageLength() const
 {
   // Need 1 extra delimiter character for maximum metadata efficiency (makes it possible to store exactly 18 MACs in metadata by adding an extra transmission)
@@ -265,9 +386,11 @@ uint32_t FloodingMesh::maxEncryptedMessageLength() const
 void FloodingMesh::setMessageLogSize(const uint16_t messageLogSize) 
 { 
   assert(messageLogSize >= 1);
-  _messageLogSize = messageLogSize; 
+  
+  if(!_messageIDs.setCapacity(messageLogSize))
+    getEspnowMeshBackend().warningPrint(String(F("WARNING! Not enough heap for the message log.")));
 }
-uint16_t FloodingMesh::messageLogSize() const { return _messageLogSize; }
+uint16_t FloodingMesh::messageLogSize() const { return _messageIDs.capacity(); }
 
 void FloodingMesh::setMetadataDelimiter(const char metadataDelimiter) 
 { 
@@ -300,12 +423,14 @@ bool FloodingMesh::insertPreliminaryMessageID(const uint64_t messageID)
   if(messageID >> 16 == TypeCast::macToUint64(WiFi.softAPmacAddress(apMacArray)))
     return false; // The node should not receive its own messages.
   
-  auto insertionResult = _messageIDs.emplace(messageID, 0); // Returns std::pair<iterator,bool>
+  auto insertionResult = _messageIDs.emplace(messageID, 0); // Returns std::pair<uint8_t *,bool>
 
-  if(insertionResult.second) // Insertion succeeded.
-    updateMessageQueue(insertionResult.first);
-  else if(insertionResult.first->second < getBroadcastReceptionRedundancy()) // messageID exists but not with desired redundancy
-    insertionResult.first->second++;
+  if(!insertionResult.first)
+    return false; // No memory for the log, so we can't know if messageID was already received.
+  else if(insertionResult.second) // Insertion succeeded.
+    return true;
+  else if(*insertionResult.first < getBroadcastReceptionRedundancy()) // messageID exists but not with desired redundancy
+    ++*insertionResult.first;
   else
     return false; // messageID already existed in _messageIDs with desired redundancy
 
@@ -318,31 +443,20 @@ bool FloodingMesh::insertCompletedMessageID(const uint64_t messageID)
   if(messageID >> 16 == TypeCast::macToUint64(WiFi.softAPmacAddress(apMacArray)))
     return false; // The node should not receive its own messages.
   
-  auto insertionResult = _messageIDs.emplace(messageID, MESSAGE_COMPLETE); // Returns std::pair<iterator,bool>
+  auto insertionResult = _messageIDs.emplace(messageID, MESSAGE_COMPLETE); // Returns std::pair<uint8_t *,bool>
 
-  if(insertionResult.second) // Insertion succeeded.
-    updateMessageQueue(insertionResult.first);
-  else if(insertionResult.first->second < MESSAGE_COMPLETE) // messageID exists but is not complete
-    insertionResult.first->second = MESSAGE_COMPLETE;
+  if(!insertionResult.first)
+    return false; // No memory for the log, so we can't know if messageID was already received.
+  else if(insertionResult.second) // Insertion succeeded.
+    return true;
+  else if(*insertionResult.first < MESSAGE_COMPLETE) // messageID exists but is not complete
+    *insertionResult.first = MESSAGE_COMPLETE;
   else
     return false; // messageID already existed in _messageIDs and is complete
 
   return true;
 }
 
-void FloodingMesh::updateMessageQueue(const messageQueueElementType messageIterator)
-{
-  _messageIdOrder.emplace(messageIterator);
-  
-  if(_messageIDs.size() > messageLogSize())
-  {
-    _messageIDs.erase(_messageIdOrder.front());
-    _messageIdOrder.pop();
-    assert(_messageIDs.size() == messageLogSize()); // If this is false we either have too many elements in messageIDs or we deleted too many elements.
-    assert(_messageIDs.size() == _messageIdOrder.size()); // The containers should always be in sync
-  }
-}
-
 void FloodingMesh::restoreDefaultRequestHandler()
 {
   getEspnowMeshBackend().setRequestHandler([this](const String &request, MeshBackendBase &meshInstance){ return _defaultRequestHandler(request, meshInstance); });
@@ -415,17 +529,60 @@ String FloodingMesh::_defaultRequestHandler(const String &request, MeshBackendBa
 
   if(insertCompletedMessageID(messageID))
   {
+    uint64_t originAPMac = messageID >> 16; // messageID consists of MAC + 16 bit counter
     uint8_t originMacArray[6] = { 0 };
-    setOriginMac(TypeCast::uint64ToMac(messageID >> 16, originMacArray)); // messageID consists of MAC + 16 bit counter
+    setOriginMac(TypeCast::uint64ToMac(originAPMac, originMacArray));
+
+    if(useRouting())
+    {
+      // This is the first copy of the message, so it probably came the fastest way from its origin.
+      uint8_t senderAPMacArray[6] = { 0 };
+      uint64_t senderAPMac = TypeCast::macToUint64(getEspnowMeshBackend().getSenderAPMac(senderAPMacArray));
+      learnRoute(senderAPMac, senderAPMac);
+      learnRoute(originAPMac, senderAPMac);
+    }
   
     String message = remainingRequest;
     message.remove(0, messageIDEndIndex + 1); // This approach avoids the null value removal of substring()
+
+    if(message.charAt(0) == metadataDelimiter())
+    {
+      // Unicast message String structure: delimiter + targetAPMac + delimiter + message.
+      
+      if(message.length() < UNICAST_TARGET_LENGTH || message.charAt(UNICAST_TARGET_LENGTH - 1) != metadataDelimiter())
+        return emptyString; // Target AP MAC not found
+      
+      uint64_t targetAPMac = TypeCast::stringToUint64(message.substring(1, UNICAST_TARGET_LENGTH - 1));
+      uint8_t apMacArray[6] = { 0 };
+      
+      if(targetAPMac == TypeCast::macToUint64(WiFi.softAPmacAddress(apMacArray)))
+      {
+        message.remove(0, UNICAST_TARGET_LENGTH);
+        getMessageHandler()(message, *this); // Unicast messages are never forwarded by their target.
+      }
+      else
+      {
+        _unicastBacklog.emplace_back(remainingRequest, targetAPMac);
+      }
+
+      return emptyString;
+    }
     
     if(getMessageHandler()(message, *this))
     {
       message = broadcastTarget + remainingRequest.substring(0, messageIDEndIndex + 1) + message;
       assert(message.length() <= _espnowBackend.getMaxMessageLength());
-      getForwardingBacklog().emplace_back(message, getEspnowMeshBackend().receivedEncryptedTransmission());
+
+      if(getEspnowMeshBackend().receivedEncryptedTransmission())
+      {
+        getForwardingBacklog().emplace_back(message, true);
+      }
+      else
+      {
+        // Scheduled with a random backoff, so the neighbours which received the same message do not all forward it at once.
+        uint8_t senderAPMacArray[6] = { 0 };
+        getEspnowMeshBackend().scheduleBroadcast(message, BroadcastLane::BULK, getEspnowMeshBackend().getSenderAPMac(senderAPMacArray));
+      }
     }
   }
   
@@ -545,6 +702,16 @@ bool FloodingMesh::_defaultTransmissionOutcomesUpdateHook(MeshBackendBase &meshI
 {
   (void)meshInstance; // This is useful to remove a "unused parameter" compiler warning. Does nothing else.
 
+  if(useRouting() && !EspnowMeshBackend::latestTransmissionOutcomes().empty())
+  {
+    const TransmissionOutcome &latestOutcome = EspnowMeshBackend::latestTransmissionOutcomes().back();
+    uint8_t recipientMacArray[6] = { 0 };
+    
+    // A neighbour which could not be reached should not be the next hop of any route.
+    if(latestOutcome.transmissionStatus() != TransmissionStatusType::TRANSMISSION_COMPLETE && latestOutcome.getBSSID(recipientMacArray))
+      forgetRoutesThrough(TypeCast::macToUint64(recipientMacArray));
+  }
+
   return true;
 }
 
@@ -26,8 +26,10 @@
 #define __FLOODINGMESH_H__
 
 #include "EspnowMeshBackend.h"
+#include "MessageIDLog.h"
+#include "TimeTracker.h"
 #include <set>
-#include <queue>
+#include <map>
 
 /**
  * An alternative to standard delay(). Will continuously call performMeshMaintenance() during the waiting time, so that the FloodingMesh node remains responsive.
@@ -163,6 +165,7 @@ public:
    * where n is (roughly, depending on mesh name length) 1/4, 3/5 and 1 respectively. If transmissions are more frequent than this, message loss will increase.
    * 
    * @param message The message to broadcast. Maximum message length is given by maxUnencryptedMessageLength(). The longer the message, the longer the transmission time. 
+   *                Should not begin with metadataDelimiter(), since such messages are reserved for unicast().
    */
   void broadcast(const String &message);
 
@@ -191,6 +194,56 @@ public:
    */
   void encryptedBroadcast(const String &message);
 
+  /**
+   * Send an unencrypted message to a single node of the mesh network. Only the target node will give the message to its messageHandler.
+   * 
+   * If routing is enabled and a route to the target node is known, the message is sent along that route, one hop at a time. 
+   * Otherwise, or if sending to the next hop of the route fails, the message is flooded through the mesh like a broadcast (but is still only handled by the target node).
+   * 
+   * All nodes of the mesh must use a FloodingMesh version which supports unicast, since older nodes will treat the message as a broadcast.
+   * 
+   * @param message The message to send. Maximum message length is given by maxUnicastMessageLength(). 
+   * @param targetAPMac The AP MAC address of the target node, e.g. as given by getOriginMac() for messages received from that node. Must be at least 6 bytes.
+   */
+  void unicast(const String &message, const uint8_t *targetAPMac);
+
+  /**
+   * Set whether this node should learn routes from the messages it receives, and use them to send unicast messages hop by hop instead of flooding them through the mesh.
+   * 
+   * The route to a node goes through the neighbour that delivered the first received copy of the latest message from that node, 
+   * which is usually the neighbour on the fastest path. Routes are forgotten when they have not been confirmed for getRouteLifetime() ms, 
+   * or immediately when a transmission to their next hop fails.
+   * 
+   * Every node that may be on a route should enable routing, since nodes without routes will flood the unicast messages they forward.
+   * 
+   * @param useRouting True if routes should be learned and used. Defaults to false.
+   */
+  void setUseRouting(const bool useRouting);
+  bool useRouting() const;
+
+  /**
+   * Set the time a learned route stays valid without being confirmed by a new message from its destination or a successful transmission to its next hop.
+   * A shorter lifetime makes the mesh adapt faster to nodes that move or disappear, but also means more unicast messages will be flooded.
+   * 
+   * @param routeLifetimeMs The route lifetime in milliseconds. Defaults to 60 000 ms.
+   */
+  void setRouteLifetime(const uint32_t routeLifetimeMs);
+  uint32_t getRouteLifetime() const;
+
+  /**
+   * Get the next hop of the current route to a node.
+   * 
+   * @param targetAPMac The AP MAC address of the target node. Must be at least 6 bytes.
+   * @param nextHopMacArray The array that should store the AP MAC address of the next hop, if there is a route. Must be at least 6 bytes.
+   * @return nextHopMacArray filled with the next hop MAC if a valid route exists. nullptr otherwise.
+   */
+  uint8_t *getNextHop(const uint8_t *targetAPMac, uint8_t *nextHopMacArray);
+
+  /**
+   * Forget all learned routes.
+   */
+  void clearRoutingTable();
+
   /**
    * Clear the logs used for remembering which messages this node has received from the mesh network.
    */
@@ -230,7 +283,8 @@ public:
  * The number of received messageID:s that will be stored by the node. Used to remember which messages have been received. 
  * Setting this too low will cause the same message to be received many times.
  * Setting this too high will cause the node to run out of RAM.
- * In practice, setting this value to more than 1337 is probably a bad idea since the node will run out of RAM quickly and crash as a result.
+ * The log uses 13 to 17 bytes per messageID in one block of heap, so values of a few thousand are possible if there is enough free heap.
+ * The most recent messageID:s are kept when the size is changed.
  * 
  * Defaults to 100.
  * 
@@ -258,6 +312,15 @@ public:
    */
   uint32_t maxEncryptedMessageLength() const;
 
+  /**
+   * Hint: Use String.length() to get the ASCII length of a String.
+   * 
+   * @return The maximum length in bytes an ASCII message is allowed to be when sent with unicast() by this node. 
+   *         Note that non-ASCII characters usually require at least two bytes each.
+   *         Also note that the maximum size will depend on getEspnowMeshBackend().getMeshName().length()
+   */
+  uint32_t maxUnicastMessageLength() const;
+
   /**
    * Set the delimiter character used for metadata by every FloodingMesh instance. 
    * Using characters found in the mesh name or in HEX numbers is unwise, as is using ','.
@@ -286,8 +349,6 @@ public:
 
 protected:
 
-  using messageQueueElementType = std::map<uint64_t, uint8_t>::iterator;
-
   static std::set<FloodingMesh *> availableFloodingMeshes;
   
   String generateMessageID();
@@ -296,9 +357,17 @@ protected:
 
   void encryptedBroadcastKernel(const String &message);
 
+  /**
+   * Send a unicast message formatted as messageID + delimiter + delimiter + targetAPMac + delimiter + message toward its target,
+   * along the learned route if there is one and by flooding otherwise.
+   */
+  void unicastKernel(const String &message, const uint64_t targetAPMac);
+
+  void learnRoute(const uint64_t targetAPMac, const uint64_t nextHopAPMac);
+  void forgetRoutesThrough(const uint64_t nextHopAPMac);
+
   bool insertPreliminaryMessageID(const uint64_t messageID);
   bool insertCompletedMessageID(const uint64_t messageID);
-  void updateMessageQueue(const messageQueueElementType messageIterator);
   
   void loadMeshState(const String &serializedMeshState);
 
@@ -319,9 +388,14 @@ private:
 
   messageHandlerType _messageHandler;
 
-  std::map<uint64_t, uint8_t> _messageIDs = {};
-  std::queue<messageQueueElementType> _messageIdOrder = {};
+  MessageIDLog _messageIDs = MessageIDLog(100);
   std::list<std::pair<String, bool>> _forwardingBacklog = {};
+  std::list<std::pair<String, uint64_t>> _unicastBacklog = {}; // Unicast messages to forward and the AP MAC of their target
+
+  static constexpr uint8_t _maxRoutes = 64;
+  std::map<uint64_t, std::pair<uint64_t, TimeTracker>> _routingTable = {}; // Target AP MAC -> (next hop AP MAC, time of latest confirmation)
+  bool _useRouting = false;
+  uint32_t _routeLifetimeMs = 60000;
 
   String _macIgnoreList;
   
@@ -335,7 +409,6 @@ private:
   uint8_t _originMac[6] = {0};
   
   uint16_t _messageCount = 0;
-  uint16_t _messageLogSize = 100;
 
   uint8_t _broadcastReceptionRedundancy = 2;
 };
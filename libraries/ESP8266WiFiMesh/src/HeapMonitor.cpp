@@ -23,6 +23,7 @@
  */
 
 #include "HeapMonitor.h"
+#include <MemoryPressure.h>
 
 HeapMonitor::HeapMonitor(const uint32_t criticalHeapLevel, const uint32_t criticalHeapLevelBuffer) : 
   _criticalHeapLevel(criticalHeapLevel), _criticalHeapLevelBuffer(criticalHeapLevelBuffer)
@@ -54,9 +55,11 @@ HeapMonitor::HeapStatus HeapMonitor::getHeapStatus() const
   
   uint32_t freeHeap = ESP.getFreeHeap();
   
-  if(freeHeap <= getCriticalHeapLevel())
+  HeapLevel level = MemoryPressure.level();
+  
+  if(freeHeap <= getCriticalHeapLevel() || level == HeapLevel::Critical)
     heapStatus = HeapStatus::CRITICAL;
-  else if(freeHeap <= getCriticalHeapLevel() + getCriticalHeapLevelBuffer())
+  else if(freeHeap <= getCriticalHeapLevel() + getCriticalHeapLevelBuffer() || level == HeapLevel::Limited)
     heapStatus = HeapStatus::LIMITED;
 
   return heapStatus;
@@ -54,6 +54,9 @@ public:
   void setCriticalHeapLevelBuffer(const uint32_t bufferInBytes);
   uint32_t getCriticalHeapLevelBuffer() const;
 
+  /**
+   * The worst of the status given by the levels above and of the core MemoryPressure level.
+   */
   HeapStatus getHeapStatus() const;
 
 private:
@@ -25,6 +25,7 @@
 #include "JsonTranslator.h"
 #include "EspnowProtocolInterpreter.h"
 #include "TypeConversionFunctions.h"
+#include "TlvTranslator.h"
 
 namespace
 {
@@ -193,16 +194,25 @@ namespace JsonTranslator
   
   bool getPassword(const String &jsonString, String &result)
   {
+    if(TlvTranslator::isTlv(jsonString))
+      return TlvTranslator::getPassword(jsonString, result);
+    
     return decode(jsonString, FPSTR(jsonPassword), result);
   }
   
   bool getOwnSessionKey(const String &jsonString, uint64_t &result)
   {
+    if(TlvTranslator::isTlv(jsonString))
+      return TlvTranslator::getOwnSessionKey(jsonString, result);
+    
     return decodeRadix(jsonString, FPSTR(jsonOwnSessionKey), result);
   }
   
   bool getPeerSessionKey(const String &jsonString, uint64_t &result)
   {
+    if(TlvTranslator::isTlv(jsonString))
+      return TlvTranslator::getPeerSessionKey(jsonString, result);
+    
     return decodeRadix(jsonString, FPSTR(jsonPeerSessionKey), result);
   }
   
@@ -218,16 +228,25 @@ namespace JsonTranslator
   
   bool getDuration(const String &jsonString, uint32_t &result)
   {  
+    if(TlvTranslator::isTlv(jsonString))
+      return TlvTranslator::getDuration(jsonString, result);
+    
     return decode(jsonString, FPSTR(jsonDuration), result);
   }
   
   bool getNonce(const String &jsonString, String &result)
   {
+    if(TlvTranslator::isTlv(jsonString))
+      return TlvTranslator::getNonce(jsonString, result);
+    
     return decode(jsonString, FPSTR(jsonNonce), result);
   }
 
   bool getHmac(const String &jsonString, String &result)
   {
+    if(TlvTranslator::isTlv(jsonString))
+      return TlvTranslator::getHmac(jsonString, result);
+    
     return decode(jsonString, FPSTR(jsonHmac), result);
   }
 
@@ -260,4 +279,10 @@ namespace JsonTranslator
       
     return decoded;
   }
+
+  bool getTlvSupport(const String &jsonString)
+  {
+    uint32_t tlv = 0;
+    return decode(jsonString, FPSTR(jsonTlv), tlv) && tlv;
+  }
 }
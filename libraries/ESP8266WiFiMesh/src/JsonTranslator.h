@@ -44,6 +44,7 @@ namespace JsonTranslator
   constexpr char jsonUnsynchronizedMessageID[] PROGMEM = "unsyncMsgID";
   constexpr char jsonMeshMessageCount[] PROGMEM = "meshMsgCount";
   constexpr char jsonArguments[] PROGMEM = "arguments";
+  constexpr char jsonTlv[] PROGMEM = "tlv";
 
   
   /**
@@ -138,6 +139,10 @@ namespace JsonTranslator
    */
   bool decodeRadix(const String &jsonString, const String &valueIdentifier, uint64_t &value, const uint8_t radix = 16);
   
+  /*
+   * The getters below also read the messages with a TLV body (see TlvTranslator), for the fields TLV bodies can have.
+   */
+
   bool getConnectionState(const String &jsonString, String &result);
   /**
    * Stores the value of the password field within jsonString into the result variable. 
@@ -169,6 +174,11 @@ namespace JsonTranslator
   bool getDesync(const String &jsonString, bool &result);
   bool getUnsynchronizedMessageID(const String &jsonString, uint32_t &result);
   bool getMeshMessageCount(const String &jsonString, uint16_t &result);
+
+  /**
+   * Tells if the sender of jsonString announced that it reads TLV bodies, so replies to it can use TlvTranslator.
+   */
+  bool getTlvSupport(const String &jsonString);
 }
 
 #endif
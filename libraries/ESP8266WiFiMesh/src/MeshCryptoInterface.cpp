@@ -41,6 +41,24 @@ namespace MeshCryptoInterface
       return false;
   }
 
+  void initializeHmacKey(hmacKey_td &hmacKey, const void *hashKey, const size_t hashKeyLength)
+  {
+#if CRYPTO_OPTIMIZED_KERNELS
+    br_hmac_key_init(&hmacKey, &experimental::crypto::sha256Vtable, hashKey, hashKeyLength);
+#else
+    br_hmac_key_init(&hmacKey, &br_sha256_vtable, hashKey, hashKeyLength);
+#endif
+  }
+
+  void *createMeshHmac(const void *data, const size_t dataLength, const hmacKey_td &hmacKey, void *resultArray, const size_t outputLength)
+  {
+    br_hmac_context hmacContext;
+    br_hmac_init(&hmacContext, &hmacKey, outputLength);
+    br_hmac_update(&hmacContext, data, dataLength);
+    br_hmac_out(&hmacContext, resultArray);
+    return resultArray;
+  }
+
   uint8_t *initializeKey(uint8_t *key, const uint8_t keyLength, const String &keySeed)
   {
     assert(keyLength <= experimental::crypto::SHA256::NATURAL_LENGTH);
@@ -38,22 +38,61 @@ MessageData::MessageData(const String &message, const uint8_t transmissionsRemai
 MessageData::MessageData(uint8_t *initialTransmission, const uint8_t transmissionLength, const uint32_t creationTimeMs) :
   _timeTracker(creationTimeMs)
 {
-  _transmissionsExpected = EspnowProtocolInterpreter::getTransmissionsRemaining(initialTransmission) + 1;
   addToMessage(initialTransmission, transmissionLength);
 }
 
 bool MessageData::addToMessage(uint8_t *transmission, const uint8_t transmissionLength)
 {
-  if(EspnowProtocolInterpreter::getTransmissionsRemaining(transmission) == getTransmissionsRemaining() - 1)
+  uint8_t transmissionsRemaining = EspnowProtocolInterpreter::getTransmissionsRemaining(transmission);
+  bool messageStart = EspnowProtocolInterpreter::isMessageStart(transmission);
+
+  if(getTransmissionsExpected() != 0 && (messageStart || transmissionsRemaining >= getTransmissionsRemaining()))
+    return false;
+
+  // The message bytes are copied straight from the transmission into the total message, without an intermediate String.
+  uint8_t metadataSize = EspnowProtocolInterpreter::metadataSize();
+  const char *messageBytes = (const char *)transmission + metadataSize;
+  uint32_t messageLength = transmissionLength > metadataSize ? transmissionLength - metadataSize : 0;
+  assert(messageLength <= EspnowMeshBackend::getMaxMessageBytesPerTransmission());
+  
+  if(messageStart)
   {
-    String message = EspnowProtocolInterpreter::getHashKeyLength(transmission, transmissionLength);
-    assert(message.length() <= EspnowMeshBackend::getMaxMessageBytesPerTransmission()); // Should catch some cases where transmission is not null terminated.
-    _totalMessage += message;
+    _transmissionsExpected = transmissionsRemaining + 1;
+    
+    if(_transmissionsExpected > 1)
+      _totalMessage.reserve(_transmissionsExpected * EspnowMeshBackend::getMaxMessageBytesPerTransmission()); // Avoids reallocations as the parts arrive.
+  }
+  else if(getTransmissionsExpected() == 0 || transmissionsRemaining != getTransmissionsRemaining() - 1)
+  {
+    // Sent again after the parts following it, or the message start was lost. Keep it until the parts before it arrive.
+    if(_waitingTransmissions.count(transmissionsRemaining))
+      return false;
+    
+    String message;
+    message.concat(messageBytes, messageLength);
+    return _waitingTransmissions.emplace(transmissionsRemaining, std::move(message)).second;
+  }
+  
+  _totalMessage.concat(messageBytes, messageLength);
+  ++_transmissionsReceived;
+  addWaitingTransmissions();
+  return true;
+}
+
+void MessageData::addWaitingTransmissions()
+{
+  while(!_waitingTransmissions.empty() && getTransmissionsRemaining() > 0)
+  {
+    std::map<uint8_t, String>::iterator waitingIterator = _waitingTransmissions.find(getTransmissionsRemaining() - 1);
+    if(waitingIterator == _waitingTransmissions.end())
+      return;
+
+    _totalMessage += waitingIterator->second;
     ++_transmissionsReceived;
-    return true;
+    _waitingTransmissions.erase(waitingIterator);
   }
 
-  return false;
+  _waitingTransmissions.clear(); // Any parts left are not part of the message.
 }
 
 uint8_t MessageData::getTransmissionsReceived() const
@@ -71,9 +110,19 @@ uint8_t MessageData::getTransmissionsRemaining() const
   return getTransmissionsExpected() - getTransmissionsReceived();
 }
 
+bool MessageData::isComplete() const
+{
+  return getTransmissionsExpected() != 0 && getTransmissionsRemaining() == 0;
+}
+
 String MessageData::getTotalMessage() const
 {
   return _totalMessage;
 }
 
+String MessageData::takeTotalMessage()
+{
+  return std::move(_totalMessage);
+}
+
 const TimeTracker &MessageData::getTimeTracker() const { return _timeTracker; }
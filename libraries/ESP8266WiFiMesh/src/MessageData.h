@@ -27,6 +27,7 @@
 
 #include "TimeTracker.h"
 #include <Arduino.h>
+#include <map>
 
 class MessageData {
 
@@ -35,22 +36,32 @@ public:
   MessageData(const String &message, const uint8_t transmissionsRemaining, const uint32_t creationTimeMs = millis());
   MessageData(uint8_t *initialTransmission, const uint8_t transmissionLength, const uint32_t creationTimeMs = millis());
   /**
+   * Transmission parts may be added in any order, those arriving ahead of their turn are kept aside until the missing parts before them have been added.
+   * 
    * @transmission A string of characters, including initial protocol bytes. Not const since that would increase heap consumption during processing.
    * @transmissionLength Length of transmission.
+   * @return True if the transmission part was added. False if it was already part of the message.
    */
   bool addToMessage(uint8_t *transmission, const uint8_t transmissionLength);
   uint8_t getTransmissionsReceived() const;
+  // Returns 0 until the transmission part starting the message has been received.
   uint8_t getTransmissionsExpected() const;
   uint8_t getTransmissionsRemaining() const;
+  bool isComplete() const;
   String getTotalMessage() const;
+  // Moves the total message out of the MessageData, which is left with an empty message. Avoids copying the message when the MessageData is about to be deleted.
+  String takeTotalMessage();
   const TimeTracker &getTimeTracker() const;
 
 private:
 
+  void addWaitingTransmissions();
+
   TimeTracker _timeTracker;
   String _totalMessage;
+  std::map<uint8_t, String> _waitingTransmissions; // Keyed by transmissions remaining
   uint8_t _transmissionsReceived = 0;
-  uint8_t _transmissionsExpected;
+  uint8_t _transmissionsExpected = 0;
 };
 
 #endif
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2019 Anders Löfgren
+ *
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "MessageIDLog.h"
+#include <new>
+#include <algorithm>
+
+MessageIDLog::MessageIDLog(const uint16_t capacity) : _capacity(capacity)
+{ }
+
+bool MessageIDLog::setCapacity(const uint16_t capacity)
+{
+  if(capacity == _capacity)
+    return true;
+
+  // Keep the most recent message IDs, oldest first, so they are still forgotten in order.
+  uint16_t keptCount = std::min(_size, capacity);
+  std::unique_ptr<uint64_t[]> keptMessageIDs(new (std::nothrow) uint64_t[keptCount]);
+  std::unique_ptr<uint8_t[]> keptStatuses(new (std::nothrow) uint8_t[keptCount]);
+  if(!keptMessageIDs || !keptStatuses)
+    keptCount = 0;
+  
+  for(uint16_t i = 0; i < keptCount; ++i)
+  {
+    uint16_t entry = (_oldest + _size - keptCount + i) % _capacity;
+    keptMessageIDs[i] = _messageIDs[entry];
+    keptStatuses[i] = _statuses[entry];
+  }
+
+  _messageIDs.reset();
+  _statuses.reset();
+  _index.reset();
+  _capacity = capacity;
+  _oldest = 0;
+  _size = 0;
+
+  if(!allocate())
+    return false;
+
+  for(uint16_t i = 0; i < keptCount; ++i)
+    emplace(keptMessageIDs[i], keptStatuses[i]);
+
+  return true;
+}
+
+uint16_t MessageIDLog::capacity() const { return _capacity; }
+size_t MessageIDLog::size() const { return _size; }
+
+void MessageIDLog::clear()
+{
+  if(_index)
+    std::fill_n(_index.get(), _indexMask + 1, noEntry);
+  
+  _oldest = 0;
+  _size = 0;
+}
+
+bool MessageIDLog::allocate()
+{
+  // At least twice as many index positions as entries keeps the probe sequences short.
+  uint32_t indexSize = 1;
+  while(indexSize < 2 * (uint32_t)_capacity)
+    indexSize <<= 1;
+
+  _messageIDs.reset(new (std::nothrow) uint64_t[_capacity]);
+  _statuses.reset(new (std::nothrow) uint8_t[_capacity]);
+  _index.reset(new (std::nothrow) uint16_t[indexSize]);
+
+  if(!_messageIDs || !_statuses || !_index)
+  {
+    _messageIDs.reset();
+    _statuses.reset();
+    _index.reset();
+    return false;
+  }
+
+  _indexMask = indexSize - 1;
+  clear();
+  return true;
+}
+
+uint32_t MessageIDLog::homePosition(const uint64_t messageID) const
+{
+  // The message ID is the origin MAC followed by a 16 bit counter, so all its bits need to be mixed.
+  return (uint32_t)((messageID * 0x9E3779B97F4A7C15ULL) >> 32) & _indexMask;
+}
+
+uint32_t MessageIDLog::indexPosition(const uint64_t messageID) const
+{
+  for(uint32_t position = homePosition(messageID); _index[position] != noEntry; position = (position + 1) & _indexMask)
+  {
+    if(_messageIDs[_index[position]] == messageID)
+      return position;
+  }
+
+  return _indexMask + 1;
+}
+
+void MessageIDLog::unindex(const uint16_t entry)
+{
+  uint32_t position = indexPosition(_messageIDs[entry]);
+
+  // Shift back the following entries of the probe sequence, which could not be found after an empty position otherwise.
+  uint32_t emptyPosition = position;
+  for(position = (position + 1) & _indexMask; _index[position] != noEntry; position = (position + 1) & _indexMask)
+  {
+    uint32_t home = homePosition(_messageIDs[_index[position]]);
+    
+    if(((position - home) & _indexMask) >= ((position - emptyPosition) & _indexMask))
+    {
+      _index[emptyPosition] = _index[position];
+      emptyPosition = position;
+    }
+  }
+
+  _index[emptyPosition] = noEntry;
+}
+
+uint8_t *MessageIDLog::find(const uint64_t messageID)
+{
+  if(!_index)
+    return nullptr;
+
+  uint32_t position = indexPosition(messageID);
+  return position > _indexMask ? nullptr : &_statuses[_index[position]];
+}
+
+std::pair<uint8_t *, bool> MessageIDLog::emplace(const uint64_t messageID, const uint8_t status)
+{
+  if(!_index && !allocate())
+    return std::make_pair(nullptr, false);
+
+  if(uint8_t *existingStatus = find(messageID))
+    return std::make_pair(existingStatus, false);
+
+  if(_size == _capacity)
+  {
+    unindex(_oldest);
+    _oldest = (_oldest + 1) % _capacity;
+    --_size;
+  }
+
+  uint16_t entry = (_oldest + _size) % _capacity;
+  _messageIDs[entry] = messageID;
+  _statuses[entry] = status;
+  ++_size;
+
+  uint32_t position = homePosition(messageID);
+  while(_index[position] != noEntry)
+    position = (position + 1) & _indexMask;
+  _index[position] = entry;
+
+  return std::make_pair(&_statuses[entry], true);
+}
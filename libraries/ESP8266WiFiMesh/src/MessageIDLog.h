@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2019 Anders Löfgren
+ *
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MESSAGEIDLOG_H__
+#define __MESSAGEIDLOG_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <utility>
+#include <memory>
+
+/**
+ * A log of the most recent message IDs, with a status byte for each. 
+ * 
+ * The log is a ring of capacity() entries (9 bytes each) with an open addressing index of two bytes per position, allocated in one go,
+ * so lookups and insertions take constant time and the memory used does not depend on the traffic. 
+ * When the log is full, storing a new message ID forgets the oldest one.
+ */
+class MessageIDLog
+{
+
+public:
+
+  MessageIDLog(const uint16_t capacity);
+
+  /**
+   * Set the number of message IDs stored. The most recent message IDs are kept.
+   * 
+   * @return False if the memory for the new capacity could not be allocated, in which case the log is empty.
+   */
+  bool setCapacity(const uint16_t capacity);
+  uint16_t capacity() const;
+  size_t size() const;
+  void clear();
+
+  /**
+   * @return A pointer to the status of messageID, or nullptr if messageID is not in the log.
+   */
+  uint8_t *find(const uint64_t messageID);
+
+  /**
+   * Store messageID with the given status, unless messageID is already in the log.
+   * 
+   * @return A pointer to the status of messageID (nullptr if the memory for the log could not be allocated), 
+   *         and true if the messageID was stored by this call.
+   */
+  std::pair<uint8_t *, bool> emplace(const uint64_t messageID, const uint8_t status);
+
+private:
+
+  static constexpr uint16_t noEntry = 0xFFFF;
+
+  bool allocate();
+  uint32_t homePosition(const uint64_t messageID) const;
+  uint32_t indexPosition(const uint64_t messageID) const;
+  void unindex(const uint16_t entry);
+
+  std::unique_ptr<uint64_t[]> _messageIDs;
+  std::unique_ptr<uint8_t[]> _statuses;
+  std::unique_ptr<uint16_t[]> _index;
+  uint32_t _indexMask = 0;
+  uint16_t _capacity;
+  uint16_t _oldest = 0;
+  uint16_t _size = 0;
+};
+
+#endif
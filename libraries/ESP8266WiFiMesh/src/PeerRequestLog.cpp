@@ -31,17 +31,19 @@ namespace
 }
 
 PeerRequestLog::PeerRequestLog(const uint64_t requestID, const bool requestEncrypted, const String &authenticationPassword, const uint8_t encryptedConnectionsSoftLimit, 
-                               const String &peerRequestNonce, const uint8_t peerStaMac[6], const uint8_t peerApMac[6], const uint8_t hashKey[hashKeyLength])
+                               const String &peerRequestNonce, const uint8_t peerStaMac[6], const uint8_t peerApMac[6], const uint8_t hashKey[hashKeyLength], 
+                               const bool peerSupportsTlv)
  : EncryptedConnectionData(peerStaMac, peerApMac, 0, 0, EspnowMeshBackend::getEncryptionRequestTimeout(), hashKey), 
    _requestID(requestID),  _authenticationPassword(authenticationPassword), _peerRequestNonce(peerRequestNonce)
-   , _requestEncrypted(requestEncrypted), _encryptedConnectionsSoftLimit(encryptedConnectionsSoftLimit)
+   , _requestEncrypted(requestEncrypted), _encryptedConnectionsSoftLimit(encryptedConnectionsSoftLimit), _peerSupportsTlv(peerSupportsTlv)
 { }
 
 PeerRequestLog::PeerRequestLog(const uint64_t requestID, const bool requestEncrypted, const String &authenticationPassword, const uint8_t encryptedConnectionsSoftLimit, const String &peerRequestNonce, 
-                               const uint8_t peerStaMac[6], const uint8_t peerApMac[6], const uint64_t peerSessionKey, const uint64_t ownSessionKey, const uint8_t hashKey[hashKeyLength])
+                               const uint8_t peerStaMac[6], const uint8_t peerApMac[6], const uint64_t peerSessionKey, const uint64_t ownSessionKey, const uint8_t hashKey[hashKeyLength], 
+                               const bool peerSupportsTlv)
  : EncryptedConnectionData(peerStaMac, peerApMac, peerSessionKey, ownSessionKey, EspnowMeshBackend::getEncryptionRequestTimeout(), hashKey), 
    _requestID(requestID), _authenticationPassword(authenticationPassword), _peerRequestNonce(peerRequestNonce)
-   , _requestEncrypted(requestEncrypted), _encryptedConnectionsSoftLimit(encryptedConnectionsSoftLimit)
+   , _requestEncrypted(requestEncrypted), _encryptedConnectionsSoftLimit(encryptedConnectionsSoftLimit), _peerSupportsTlv(peerSupportsTlv)
 { }
 
 void PeerRequestLog::setRequestID(const uint64_t requestID) { _requestID = requestID; }
@@ -58,3 +60,6 @@ uint8_t PeerRequestLog::getEncryptedConnectionsSoftLimit() const { return _encry
 
 void PeerRequestLog::setPeerRequestNonce(const String &nonce) { _peerRequestNonce = nonce; }
 String PeerRequestLog::getPeerRequestNonce() const { return _peerRequestNonce; }
+
+void PeerRequestLog::setPeerSupportsTlv(const bool peerSupportsTlv) { _peerSupportsTlv = peerSupportsTlv; }
+bool PeerRequestLog::peerSupportsTlv() const { return _peerSupportsTlv; }
@@ -33,10 +33,10 @@ class PeerRequestLog : public EncryptedConnectionData {
 public:
 
   PeerRequestLog(const uint64_t requestID, const bool requestEncrypted, const String &authenticationPassword, const uint8_t encryptedConnectionsSoftLimit, const String &peerRequestNonce, 
-                 const uint8_t peerStaMac[6], const uint8_t peerApMac[6], const uint8_t hashKey[EspnowProtocolInterpreter::hashKeyLength]);
+                 const uint8_t peerStaMac[6], const uint8_t peerApMac[6], const uint8_t hashKey[EspnowProtocolInterpreter::hashKeyLength], const bool peerSupportsTlv = false);
   PeerRequestLog(const uint64_t requestID, const bool requestEncrypted, const String &authenticationPassword, const uint8_t encryptedConnectionsSoftLimit, const String &peerRequestNonce,
                  const uint8_t peerStaMac[6], const uint8_t peerApMac[6], const uint64_t peerSessionKey, const uint64_t ownSessionKey, 
-                 const uint8_t hashKey[EspnowProtocolInterpreter::hashKeyLength]);
+                 const uint8_t hashKey[EspnowProtocolInterpreter::hashKeyLength], const bool peerSupportsTlv = false);
 
   void setRequestID(const uint64_t requestID);
   uint64_t getRequestID() const;
@@ -53,6 +53,10 @@ public:
   void setPeerRequestNonce(const String &nonce);
   String getPeerRequestNonce() const;
 
+  // True if the peer request announced TLV support, so the confirmations can use TlvTranslator.
+  void setPeerSupportsTlv(const bool peerSupportsTlv);
+  bool peerSupportsTlv() const;
+
 private:
 
   uint64_t _requestID;
@@ -60,6 +64,7 @@ private:
   String _peerRequestNonce;
   bool _requestEncrypted;
   uint8_t _encryptedConnectionsSoftLimit;
+  bool _peerSupportsTlv;
 };
 
 #endif
@@ -30,6 +30,12 @@ ResponseData::ResponseData(const String &message, const uint8_t recipientMac[6],
   storeRecipientMac(recipientMac);
 }
 
+ResponseData::ResponseData(String &&message, const uint8_t recipientMac[6], const uint64_t requestID, const uint32_t creationTimeMs) : 
+  _timeTracker(creationTimeMs), _message(std::move(message)), _requestID(requestID)
+{      
+  storeRecipientMac(recipientMac);
+}
+
 ResponseData::ResponseData(const ResponseData &other) 
   : _timeTracker(other.getTimeTracker()), _message(other.getMessage()), _requestID(other.getRequestID())
 {
@@ -72,7 +78,7 @@ void ResponseData::setRecipientMac(const uint8_t recipientMac[6]) { storeRecipie
 const uint8_t *ResponseData::getRecipientMac() const { return _recipientMac; }
 
 void ResponseData::setMessage(const String &message) { _message = message; }
-String ResponseData::getMessage() const { return _message; }
+const String &ResponseData::getMessage() const { return _message; }
 
 void ResponseData::setRequestID(const uint64_t requestID) { _requestID = requestID; }
 uint64_t ResponseData::getRequestID() const { return _requestID; }
@@ -33,6 +33,7 @@ class ResponseData {
 public:
 
   ResponseData(const String &message, const uint8_t recipientMac[6], const uint64_t requestID, const uint32_t creationTimeMs = millis());
+  ResponseData(String &&message, const uint8_t recipientMac[6], const uint64_t requestID, const uint32_t creationTimeMs = millis());
   ResponseData(const ResponseData &other);
   ResponseData & operator=(const ResponseData &other);
   // No need for explicit destructor with current class design
@@ -41,7 +42,7 @@ public:
   const uint8_t *getRecipientMac() const;
 
   void setMessage(const String &message);
-  String getMessage() const;
+  const String &getMessage() const;
 
   void setRequestID(const uint64_t requestID);
   uint64_t getRequestID() const;
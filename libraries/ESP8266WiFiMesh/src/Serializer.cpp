@@ -24,6 +24,7 @@
  
 #include "Serializer.h"
 #include "JsonTranslator.h"
+#include "TlvTranslator.h"
 #include "TypeConversionFunctions.h"
 #include "MeshCryptoInterface.h"
 #include "EspnowProtocolInterpreter.h" 
@@ -38,6 +39,13 @@ namespace
     const String q = String('"');
     return q + valueIdentifier + q + ':' + q + value + F("\"}}");
   }
+
+  String createRequesterStaApMac()
+  {
+    uint8_t staMac[6] {0};
+    uint8_t apMac[6] {0};
+    return TypeCast::macToString(WiFi.macAddress(staMac)) + TypeCast::macToString(WiFi.softAPmacAddress(apMac));
+  }
 }
 
 namespace Serializer
@@ -78,10 +86,23 @@ namespace Serializer
                    FPSTR(jsonPeerStaMac), peerStaMac, FPSTR(jsonPeerApMac), peerApMac})});
   }
     
-  String createEncryptedConnectionInfo(const String &infoHeader, const String &requestNonce, const String &authenticationPassword, const uint64_t ownSessionKey, const uint64_t peerSessionKey)
+  String createEncryptedConnectionInfo(const String &infoHeader, const String &requestNonce, const String &authenticationPassword, const uint64_t ownSessionKey, const uint64_t peerSessionKey, 
+                                       const bool tlv)
   {
     using namespace JsonTranslator;
 
+    if(tlv)
+    {
+      using TlvTranslator::Tag;
+      
+      String message = infoHeader + TlvTranslator::tlvMarker;
+      TlvTranslator::append(message, Tag::NONCE, requestNonce);
+      TlvTranslator::append(message, Tag::PASSWORD, authenticationPassword);
+      TlvTranslator::append(message, Tag::OWN_SESSION_KEY, peerSessionKey, 8); // Exchanges session keys since it should be valid for the receiver.
+      TlvTranslator::append(message, Tag::PEER_SESSION_KEY, ownSessionKey, 8);
+      return message;
+    }
+
     const String q = String('"');
 
     // Returns: infoHeader{"arguments":{"nonce":"1F2","password":"abc","ownSK":"3B4","peerSK":"1A2"}}
@@ -94,15 +115,41 @@ namespace Serializer
                      FPSTR(jsonPeerSessionKey), q + TypeCast::uint64ToString(ownSessionKey) + q})});
   }
   
-  String createEncryptionRequestHmacMessage(const String &requestHeader, const String &requestNonce, const uint8_t *hashKey, const uint8_t hashKeyLength, const uint32_t duration)
+  String createEncryptionRequestHmacMessage(const String &requestHeader, const String &requestNonce, const uint8_t *hashKey, const uint8_t hashKeyLength, const uint32_t duration, 
+                                            const bool tlv)
   {
     using namespace JsonTranslator;
+    using namespace EspnowProtocolInterpreter;
 
     String mainMessage = requestHeader;
 
-    if(requestHeader == FPSTR(EspnowProtocolInterpreter::temporaryEncryptionRequestHeader))
+    if(tlv)
+    {
+      using TlvTranslator::Tag;
+
+      mainMessage += TlvTranslator::tlvMarker;
+      if(requestHeader == FPSTR(temporaryEncryptionRequestHeader))
+        TlvTranslator::append(mainMessage, Tag::DURATION, duration, 4);
+      TlvTranslator::append(mainMessage, Tag::NONCE, requestNonce);
+
+      uint8_t hmac[experimental::crypto::SHA256::NATURAL_LENGTH] {0};
+      TypeCast::hexStringToUint8Array(MeshCryptoInterface::createMeshHmac(createRequesterStaApMac() + mainMessage, hashKey, hashKeyLength), hmac, sizeof hmac);
+      
+      // Returns: requestHeader<tlvMarker><duration><nonce><hmac>
+      TlvTranslator::append(mainMessage, Tag::HMAC, hmac, sizeof hmac);
+      return mainMessage;
+    }
+
+    // Requests announce that we read TLV bodies, so replies can use them. Other peers ignore the extra field.
+    bool request = requestHeader == FPSTR(encryptionRequestHeader) || requestHeader == FPSTR(temporaryEncryptionRequestHeader);
+    
+    if(requestHeader == FPSTR(temporaryEncryptionRequestHeader))
     {
-      mainMessage += encode({FPSTR(jsonArguments), encode({FPSTR(jsonDuration), String(duration), FPSTR(jsonNonce), requestNonce})});
+      mainMessage += encode({FPSTR(jsonArguments), encode({FPSTR(jsonDuration), String(duration), FPSTR(jsonNonce), requestNonce, FPSTR(jsonTlv), String(1)})});
+    }
+    else if(request)
+    {
+      mainMessage += encode({FPSTR(jsonArguments), encode({FPSTR(jsonNonce), requestNonce, FPSTR(jsonTlv), String(1)})});
     }
     else
     {
@@ -113,12 +160,9 @@ namespace Serializer
     mainMessage.remove(mainMessage.length() - 2);
     mainMessage += ',';
 
-    uint8_t staMac[6] {0};
-    uint8_t apMac[6] {0};
-    String requesterStaApMac = TypeCast::macToString(WiFi.macAddress(staMac)) + TypeCast::macToString(WiFi.softAPmacAddress(apMac));
-    String hmac = MeshCryptoInterface::createMeshHmac(requesterStaApMac + mainMessage, hashKey, hashKeyLength);
+    String hmac = MeshCryptoInterface::createMeshHmac(createRequesterStaApMac() + mainMessage, hashKey, hashKeyLength);
 
-    // Returns: requestHeader{"arguments":{"duration":"123","nonce":"1F2","hmac":"3B4"}}
+    // Returns: requestHeader{"arguments":{"duration":"123","nonce":"1F2","tlv":"1","hmac":"3B4"}}
     return mainMessage + createJsonEndPair(FPSTR(jsonHmac), hmac);
   }
 }
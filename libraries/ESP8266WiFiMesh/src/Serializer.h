@@ -37,8 +37,14 @@ namespace Serializer
   String serializeUnencryptedConnection(const String &unsyncMsgID);
   String serializeEncryptedConnection(const String &duration, const String &desync, const String &ownSK, const String &peerSK, const String &peerStaMac, const String &peerApMac);
   
-  String createEncryptedConnectionInfo(const String &infoHeader, const String &requestNonce, const String &authenticationPassword, const uint64_t ownSessionKey, const uint64_t peerSessionKey);
-  String createEncryptionRequestHmacMessage(const String &requestHeader, const String &requestNonce, const uint8_t *hashKey, const uint8_t hashKeyLength, const uint32_t duration = 0);
+  /*
+   * With tlv true the body is encoded with TlvTranslator instead of JSON, which only peers that announced TLV support can read.
+   * Encryption requests in JSON announce TLV support themselves.
+   */
+  String createEncryptedConnectionInfo(const String &infoHeader, const String &requestNonce, const String &authenticationPassword, const uint64_t ownSessionKey, const uint64_t peerSessionKey, 
+                                       const bool tlv = false);
+  String createEncryptionRequestHmacMessage(const String &requestHeader, const String &requestNonce, const uint8_t *hashKey, const uint8_t hashKeyLength, const uint32_t duration = 0, 
+                                            const bool tlv = false);
 }
 
 #endif
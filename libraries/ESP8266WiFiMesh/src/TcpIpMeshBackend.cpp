@@ -19,6 +19,7 @@
 #include <WiFiClient.h> 
 #include <WiFiServer.h>
 #include <assert.h>
+#include <memory>
 #include <Schedule.h>
 
 #include "TcpIpMeshBackend.h"
@@ -38,6 +39,26 @@ namespace
   IPAddress staticIP;
   IPAddress gateway(192,168,4,1);
   IPAddress subnetMask(255,255,255,0);
+
+  enum class AsyncTransmissionState : uint8_t
+  {
+    SCANNING,
+    CONNECTING,
+    EXCHANGING
+  };
+
+  // There is only one WiFi station, so only one asynchronous transmission can be in progress at a time.
+  TcpIpMeshBackend *asyncTransmissionInstance = nullptr;
+  AsyncTransmissionState asyncTransmissionState = AsyncTransmissionState::SCANNING;
+  size_t asyncConnectionQueueIndex = 0;
+  bool asyncConcludingDisconnect = true;
+  WiFiMode_t asyncStoredWiFiMode = WIFI_OFF;
+  ExpiringTimeTracker asyncStepTimeout(0U);
+  WiFiClient asyncClient;
+
+  // The mutexes are kept captured between the steps of an asynchronous transmission, like during a blocking transmission.
+  std::unique_ptr<MutexTracker> asyncScanMutexTracker;
+  std::unique_ptr<MutexTracker> asyncConnectionQueueMutexTracker;
 }
 
 const IPAddress TcpIpMeshBackend::emptyIP;
@@ -60,6 +81,11 @@ TcpIpMeshBackend::TcpIpMeshBackend(const requestHandlerType requestHandler, cons
   setServerPort(serverPort);
 }
 
+TcpIpMeshBackend::~TcpIpMeshBackend()
+{
+  abortAsyncTransmission();
+}
+
 std::vector<TcpIpNetworkInfo> & TcpIpMeshBackend::connectionQueue()
 {
   MutexTracker connectionQueueMutexTracker(_tcpIpConnectionQueueMutex);
@@ -111,7 +137,7 @@ void TcpIpMeshBackend::deactivateAPHook()
   _server.stop();
 }
 
-bool TcpIpMeshBackend::transmissionInProgress(){return *_tcpIpTransmissionMutex;}
+bool TcpIpMeshBackend::transmissionInProgress(){return *_tcpIpTransmissionMutex || asyncTransmissionInProgress();}
 
 void TcpIpMeshBackend::setTemporaryMessage(const String &newTemporaryMessage) {_temporaryMessage = newTemporaryMessage;}
 String TcpIpMeshBackend::getTemporaryMessage() const {return _temporaryMessage;}
@@ -227,7 +253,14 @@ bool TcpIpMeshBackend::waitForClientTransmission(WiFiClient &currClient, const u
     delay(1);
   }
 
-  /* Return false if the client isn't ready to communicate */
+  return clientReadyToCommunicate(currClient);
+}
+
+/**
+ * @return False if the client isn't ready to communicate, true otherwise.
+ */
+bool TcpIpMeshBackend::clientReadyToCommunicate(WiFiClient &currClient)
+{
   if (WiFi.status() == WL_DISCONNECTED && !currClient.available())
   {
     verboseModePrint(F("Disconnected!")); 
@@ -258,6 +291,17 @@ TransmissionStatusType TcpIpMeshBackend::exchangeInfo(WiFiClient &currClient)
     return TransmissionStatusType::CONNECTION_FAILED;
   }
 
+  return readResponse(currClient);
+}
+
+/**
+ * Read the response of the other node and pass it to the user-supplied responseHandler.
+ *
+ * @param currClient The client from which the response should be read.
+ * @return A status code based on the outcome of the exchange.
+ */
+TransmissionStatusType TcpIpMeshBackend::readResponse(WiFiClient &currClient)
+{
   if (!currClient.available()) 
   {
     verboseModePrint(F("No response!"));
@@ -334,15 +378,9 @@ void TcpIpMeshBackend::initiateConnectionToAP(const String &targetSSID, const in
 }
 
 /**
- * Connect to the AP at SSID and transmit the mesh instance's current message.
- *
- * @param targetSSID The name of the AP the other node has set up.
- * @param targetChannel The WiFI channel of the AP the other node has set up.
- * @param targetBSSID The MAC address of the AP the other node has set up.
- * @return A status code based on the outcome of the connection and data transfer process.
- * 
+ * Start connecting to the AP at SSID, without waiting for the connection to be established.
  */
-TransmissionStatusType TcpIpMeshBackend::connectToNode(const String &targetSSID, const int targetChannel, const uint8_t *targetBSSID)
+void TcpIpMeshBackend::beginConnectionToNode(const String &targetSSID, const int targetChannel, const uint8_t *targetBSSID)
 {  
   if(staticIPActivated && !lastSSID.isEmpty() && lastSSID != targetSSID) // So we only do this once per connection, in case there is a performance impact.
   {
@@ -364,6 +402,20 @@ TransmissionStatusType TcpIpMeshBackend::connectToNode(const String &targetSSID,
   
   verboseModePrint(F("Connecting... "), false);
   initiateConnectionToAP(targetSSID, targetChannel, targetBSSID);
+}
+
+/**
+ * Connect to the AP at SSID and transmit the mesh instance's current message.
+ *
+ * @param targetSSID The name of the AP the other node has set up.
+ * @param targetChannel The WiFI channel of the AP the other node has set up.
+ * @param targetBSSID The MAC address of the AP the other node has set up.
+ * @return A status code based on the outcome of the connection and data transfer process.
+ * 
+ */
+TransmissionStatusType TcpIpMeshBackend::connectToNode(const String &targetSSID, const int targetChannel, const uint8_t *targetBSSID)
+{  
+  beginConnectionToNode(targetSSID, targetChannel, targetBSSID);
 
   int attemptNumber = 1;
   ExpiringTimeTracker connectionAttemptTimeout([this](){ return _connectionAttemptTimeoutMs; });
@@ -394,23 +446,26 @@ TransmissionStatusType TcpIpMeshBackend::connectToNode(const String &targetSSID,
   return attemptDataTransfer();
 }
 
-TransmissionStatusType TcpIpMeshBackend::initiateTransmission(const TcpIpNetworkInfo &recipientInfo)
+void TcpIpMeshBackend::prepareTransmission(const TcpIpNetworkInfo &recipientInfo, uint8_t targetBSSID[6])
 {
   WiFi.disconnect();
   yield();
 
   assert(!recipientInfo.SSID().isEmpty()); // We need at least SSID to connect
-  String targetSSID = recipientInfo.SSID();
-  int32_t targetWiFiChannel = recipientInfo.wifiChannel();
-  uint8_t targetBSSID[6] {0};
   recipientInfo.getBSSID(targetBSSID);
 
   if(verboseMode()) // Avoid string generation if not required
   {
     printAPInfo(recipientInfo);
   }
+}
 
-  return connectToNode(targetSSID, targetWiFiChannel, targetBSSID);
+TransmissionStatusType TcpIpMeshBackend::initiateTransmission(const TcpIpNetworkInfo &recipientInfo)
+{
+  uint8_t targetBSSID[6] {0};
+  prepareTransmission(recipientInfo, targetBSSID);
+
+  return connectToNode(recipientInfo.SSID(), recipientInfo.wifiChannel(), targetBSSID);
 }
 
 void TcpIpMeshBackend::enterPostTransmissionState(const bool concludingDisconnect)
@@ -437,6 +492,13 @@ void TcpIpMeshBackend::attemptTransmission(const String &message, const bool sca
     assert(false && String(F("ERROR! TCP/IP transmission in progress. Don't call attemptTransmission from callbacks as this may corrupt program state! Aborting."))); 
     return;
   }
+
+  
+  if(asyncTransmissionInProgress())
+  {
+    assert(false && String(F("ERROR! Asynchronous TCP/IP transmission in progress. Wait for it to finish or abort it before calling attemptTransmission! Aborting."))); 
+    return;
+  }
   
   if(initialDisconnect)
   {
@@ -499,6 +561,12 @@ TransmissionStatusType TcpIpMeshBackend::attemptTransmission(const String &messa
     return TransmissionStatusType::CONNECTION_FAILED;
   }
 
+  if(asyncTransmissionInProgress())
+  {
+    assert(false && String(F("ERROR! Asynchronous TCP/IP transmission in progress. Wait for it to finish or abort it before calling attemptTransmission! Aborting."))); 
+    return TransmissionStatusType::CONNECTION_FAILED;
+  }
+
   TransmissionStatusType transmissionResult = TransmissionStatusType::CONNECTION_FAILED;
   setTemporaryMessage(message);
   
@@ -523,6 +591,208 @@ TransmissionStatusType TcpIpMeshBackend::attemptTransmission(const String &messa
   return transmissionResult;
 }
 
+bool TcpIpMeshBackend::startAsyncTransmission(const String &message, const bool scan, const bool scanAllWiFiChannels, const bool concludingDisconnect)
+{
+  if(transmissionInProgress() || *_tcpIpConnectionQueueMutex || (scan && *_scanMutex))
+    return false;
+
+  setMessage(message);
+  latestTransmissionOutcomes().clear();
+  
+  asyncTransmissionInstance = this;
+  asyncConcludingDisconnect = concludingDisconnect;
+
+  if(scan)
+  {
+    connectionQueue().clear();
+    asyncScanMutexTracker.reset(new MutexTracker(_scanMutex));
+    
+    verboseModePrint(F("Scanning... "), false);
+
+    // Scan function argument overview: scanNetworks(bool async = false, bool show_hidden = false, uint8 channel = 0, uint8* ssid = NULL)
+    // Channel 0 scans all WiFi channels.
+    WiFi.scanNetworks(true, getScanHidden(), scanAllWiFiChannels ? 0 : getWiFiChannel());
+    asyncTransmissionState = AsyncTransmissionState::SCANNING;
+  }
+  else
+  {
+    asyncConnectionQueueMutexTracker.reset(new MutexTracker(_tcpIpConnectionQueueMutex));
+    asyncConnectionQueueIndex = 0;
+    startNextAsyncConnection();
+  }
+
+  return true;
+}
+
+bool TcpIpMeshBackend::continueAsyncTransmission()
+{
+  if(asyncTransmissionInstance != this)
+    return false;
+  
+  MutexTracker mutexTracker(_tcpIpTransmissionMutex);
+  if(!mutexTracker.mutexCaptured())
+  {
+    assert(false && String(F("ERROR! TCP/IP transmission in progress. Don't call continueAsyncTransmission from callbacks as this may corrupt program state! Aborting."))); 
+    return true;
+  }
+
+  switch(asyncTransmissionState)
+  {
+    case AsyncTransmissionState::SCANNING:
+    {
+      int8_t scanResult = WiFi.scanComplete();
+      if(scanResult == WIFI_SCAN_RUNNING)
+        break;
+
+      getNetworkFilter()(scanResult < 0 ? 0 : scanResult, *this); // Update the connectionQueue. A failed scan has found no networks.
+      asyncScanMutexTracker.reset();
+      
+      asyncConnectionQueueMutexTracker.reset(new MutexTracker(_tcpIpConnectionQueueMutex));
+      asyncConnectionQueueIndex = 0;
+      startNextAsyncConnection();
+      break;
+    }
+    case AsyncTransmissionState::CONNECTING:
+      if(WiFi.status() == WL_DISCONNECTED && !asyncStepTimeout)
+        break;
+      
+      verboseModePrint(String(asyncStepTimeout.elapsedTime()));
+
+      if(WiFi.status() != WL_CONNECTED)
+      {
+        verboseModePrint(F("Timeout"));
+        storeAsyncTransmissionOutcome(TransmissionStatusType::CONNECTION_FAILED);
+      }
+      else
+      {
+        startAsyncDataExchange();
+      }
+      break;
+    case AsyncTransmissionState::EXCHANGING:
+      if(asyncClient.connected() && !asyncClient.available() && !asyncStepTimeout)
+        break;
+      
+      concludeAsyncDataExchange();
+      break;
+  }
+
+  return asyncTransmissionInstance == this;
+}
+
+void TcpIpMeshBackend::abortAsyncTransmission()
+{
+  if(asyncTransmissionInstance != this)
+    return;
+  
+  if(*_tcpIpTransmissionMutex)
+  {
+    assert(false && String(F("ERROR! TCP/IP transmission in progress. Don't call abortAsyncTransmission from callbacks as this may corrupt program state! Aborting."))); 
+    return;
+  }
+
+  if(asyncTransmissionState == AsyncTransmissionState::EXCHANGING)
+  {
+    asyncClient.stop();
+    WiFi.mode(asyncStoredWiFiMode);
+    delay(1);
+  }
+
+  finishAsyncTransmission();
+}
+
+bool TcpIpMeshBackend::asyncTransmissionInProgress() {return asyncTransmissionInstance;}
+
+void TcpIpMeshBackend::startNextAsyncConnection()
+{
+  if(asyncConnectionQueueIndex >= constConnectionQueue().size())
+  {
+    finishAsyncTransmission();
+    return;
+  }
+
+  const TcpIpNetworkInfo &currentNetwork = constConnectionQueue()[asyncConnectionQueueIndex];
+  uint8_t targetBSSID[6] {0};
+  prepareTransmission(currentNetwork, targetBSSID);
+  beginConnectionToNode(currentNetwork.SSID(), currentNetwork.wifiChannel(), targetBSSID);
+  
+  asyncStepTimeout.reset(_connectionAttemptTimeoutMs);
+  asyncTransmissionState = AsyncTransmissionState::CONNECTING;
+}
+
+/**
+ * Same as attemptDataTransfer, except that the response is awaited via continueAsyncTransmission.
+ */
+void TcpIpMeshBackend::startAsyncDataExchange()
+{
+  asyncStoredWiFiMode = WiFi.getMode();
+  WiFi.mode(WIFI_STA);
+  delay(1);
+
+  asyncClient = WiFiClient();
+  asyncClient.setTimeout(_stationModeTimeoutMs);
+
+  /* Connect to the node's server */
+  if (!asyncClient.connect(FPSTR(SERVER_IP_ADDR), getServerPort())) 
+  {
+    fullStop(asyncClient);
+    verboseModePrint(F("Server unavailable"));
+    WiFi.mode(asyncStoredWiFiMode);
+    delay(1);
+    storeAsyncTransmissionOutcome(TransmissionStatusType::CONNECTION_FAILED);
+    return;
+  }
+
+  verboseModePrint(String(F("Transmitting")));
+    
+  asyncClient.print(getCurrentMessage() + '\r');
+  yield();
+
+  asyncStepTimeout.reset(_stationModeTimeoutMs);
+  asyncTransmissionState = AsyncTransmissionState::EXCHANGING;
+}
+
+void TcpIpMeshBackend::concludeAsyncDataExchange()
+{
+  TransmissionStatusType transmissionResult = TransmissionStatusType::CONNECTION_FAILED;
+  
+  if (!clientReadyToCommunicate(asyncClient))
+  {
+    fullStop(asyncClient);
+  }
+  else
+  {
+    transmissionResult = readResponse(asyncClient);
+    asyncClient.stop();
+    yield();
+  }
+
+  WiFi.mode(asyncStoredWiFiMode);
+  delay(1);
+  
+  storeAsyncTransmissionOutcome(transmissionResult);
+}
+
+void TcpIpMeshBackend::storeAsyncTransmissionOutcome(const TransmissionStatusType transmissionResult)
+{
+  latestTransmissionOutcomes().push_back(TransmissionOutcome(constConnectionQueue()[asyncConnectionQueueIndex], transmissionResult));
+  ++asyncConnectionQueueIndex;
+
+  if(!getTransmissionOutcomesUpdateHook()(*this))
+    finishAsyncTransmission();
+  else
+    startNextAsyncConnection();
+}
+
+void TcpIpMeshBackend::finishAsyncTransmission()
+{
+  asyncScanMutexTracker.reset();
+  asyncConnectionQueueMutexTracker.reset();
+  
+  enterPostTransmissionState(asyncConcludingDisconnect);
+  
+  asyncTransmissionInstance = nullptr;
+}
+
 void TcpIpMeshBackend::acceptRequests()
 {
   MutexTracker mutexTracker(_tcpIpTransmissionMutex);
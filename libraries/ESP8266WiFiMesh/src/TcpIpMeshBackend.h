@@ -65,6 +65,8 @@ public:
                   const String &meshPassword, const String &ssidPrefix, const String &ssidSuffix, const bool verboseMode = false, 
                   const uint8 meshWiFiChannel = 1, const uint16_t serverPort = 4011);
 
+  ~TcpIpMeshBackend() override;
+
   /** 
   * Returns a vector that contains the NetworkInfo for each WiFi network to connect to.
   * This vector is unique for each mesh backend, but NetworkInfo elements can be directly transferred between the vectors as long as both SSID and BSSID are present.
@@ -125,6 +127,41 @@ public:
    * Note that if wifiChannel and BSSID are missing from recipientInfo, connection time will be longer.
    */
   TransmissionStatusType attemptTransmission(const String &message, const TcpIpNetworkInfo &recipientInfo, const bool concludingDisconnect = true, const bool initialDisconnect = false);
+
+  /**
+   * Start a transmission which does not block. Works like attemptTransmission, but each step of the transmission (the scan, each connection to an AP 
+   * and each data exchange) is only started here or in continueAsyncTransmission, which must then be called repeatedly (e.g. once per loop()) until it returns false.
+   * This keeps the node responsive during the seconds a TCP/IP transmission can take, so acceptRequests() and other work can be done between the steps.
+   * 
+   * The transmission connects anew to each AP in the connectionQueue. The latestTransmissionOutcomes vector is updated (and the transmissionOutcomesUpdateHook called)
+   * as each data exchange is concluded. The connectionQueue must not be modified while the transmission is in progress, apart from via the networkFilter.
+   * Only one asynchronous transmission can be in progress at a time, and the blocking attemptTransmission methods cannot be used until it has finished.
+   *
+   * @param message The message to send to other nodes. It will be stored in the class instance until replaced via attemptTransmission or setMessage.
+   * @param scan Scan for new networks and call the networkFilter function with the scan results. When set to false, only the data already in connectionQueue will be used for the transmission.
+   * @param scanAllWiFiChannels Scan all WiFi channels during a WiFi scan, instead of just the channel the MeshBackendBase instance is using.
+   * @param concludingDisconnect Disconnect from AP once transmission is complete. Defaults to true.
+   * 
+   * @return True if the transmission was started. False if another transmission or scan is in progress.
+   */
+  bool startAsyncTransmission(const String &message, const bool scan = true, const bool scanAllWiFiChannels = false, const bool concludingDisconnect = true);
+
+  /**
+   * Check the progress of the asynchronous transmission of this TcpIpMeshBackend instance and start its next step when the current one is done. Never blocks for long.
+   * 
+   * @return True if the asynchronous transmission is still in progress. False once it has finished, or if no asynchronous transmission was started by this instance.
+   */
+  bool continueAsyncTransmission();
+
+  /**
+   * Stop the asynchronous transmission of this TcpIpMeshBackend instance, if any. The steps which have been concluded remain in latestTransmissionOutcomes.
+   */
+  void abortAsyncTransmission();
+
+  /**
+   * @return True if an asynchronous transmission has been started by any TcpIpMeshBackend instance and has not yet finished.
+   */
+  static bool asyncTransmissionInProgress();
   
   /**
    * If any clients are connected, accept their requests and call the requestHandler function for each one.
@@ -238,7 +275,7 @@ protected:
   /**
    * Check if there is an ongoing TCP/IP transmission in the library. Used to avoid interrupting transmissions.
    * 
-   * @return True if a transmission initiated by a public method is in progress.
+   * @return True if a transmission initiated by a public method is in progress, including asynchronous transmissions.
    */
   static bool transmissionInProgress();
 
@@ -256,13 +293,22 @@ private:
 
   void fullStop(WiFiClient &currClient);
   void initiateConnectionToAP(const String &targetSSID, const int targetChannel = NETWORK_INFO_DEFAULT_INT, const uint8_t *targetBSSID = NULL);
+  void beginConnectionToNode(const String &targetSSID, const int targetChannel = NETWORK_INFO_DEFAULT_INT, const uint8_t *targetBSSID = NULL);
   TransmissionStatusType connectToNode(const String &targetSSID, const int targetChannel = NETWORK_INFO_DEFAULT_INT, const uint8_t *targetBSSID = NULL);
   TransmissionStatusType exchangeInfo(WiFiClient &currClient);
+  TransmissionStatusType readResponse(WiFiClient &currClient);
   bool waitForClientTransmission(WiFiClient &currClient, const uint32_t maxWait);
+  bool clientReadyToCommunicate(WiFiClient &currClient);
   TransmissionStatusType attemptDataTransfer();
   TransmissionStatusType attemptDataTransferKernel();
+  void prepareTransmission(const TcpIpNetworkInfo &recipientInfo, uint8_t targetBSSID[6]);
   TransmissionStatusType initiateTransmission(const TcpIpNetworkInfo &recipientInfo);
   void enterPostTransmissionState(const bool concludingDisconnect);
+  void startNextAsyncConnection();
+  void startAsyncDataExchange();
+  void concludeAsyncDataExchange();
+  void storeAsyncTransmissionOutcome(const TransmissionStatusType transmissionResult);
+  void finishAsyncTransmission();
    
   uint32_t _connectionAttemptTimeoutMs = 10000;
   int _stationModeTimeoutMs = 5000; // int is the type used in the Arduino core for this particular API, not uint32_t, which is why we use int here.
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2019 Anders Löfgren
+ *
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "TlvTranslator.h"
+#include "TypeConversionFunctions.h"
+#include <assert.h>
+
+namespace
+{
+  namespace TypeCast = MeshTypeConversionFunctions;
+
+  // Finds the value of the field with the given tag. Returns the index of the tag, or a negative value.
+  int32_t findField(const String &message, const TlvTranslator::Tag tag, const uint8_t *&value, uint8_t &length)
+  {
+    int32_t startIndex = TlvTranslator::getStartIndex(message);
+    if(startIndex < 0)
+      return startIndex;
+
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(message.c_str());
+    const uint32_t messageLength = message.length();
+    
+    for(uint32_t index = startIndex + 1; index + 2 <= messageLength; )
+    {
+      uint8_t fieldLength = data[index + 1];
+      if(index + 2 + fieldLength > messageLength)
+        return -1; // Malformed field
+        
+      if(data[index] == static_cast<uint8_t>(tag))
+      {
+        value = data + index + 2;
+        length = fieldLength;
+        return index;
+      }
+
+      index += 2 + fieldLength;
+    }
+
+    return -1;
+  }
+}
+
+namespace TlvTranslator
+{
+  int32_t getStartIndex(const String &message)
+  {
+    const char *data = message.c_str();
+    
+    for(uint32_t index = 0; index < message.length(); ++index)
+    {
+      if(data[index] == tlvMarker)
+        return index;
+      else if(data[index] == '{')
+        return -1; // JSON body
+    }
+
+    return -1;
+  }
+
+  bool isTlv(const String &message)
+  {
+    return getStartIndex(message) >= 0;
+  }
+
+  int32_t getFieldIndex(const String &message, const Tag tag)
+  {
+    const uint8_t *value = nullptr;
+    uint8_t length = 0;
+    return findField(message, tag, value, length);
+  }
+  
+  void append(String &tlvBody, const Tag tag, const uint8_t *value, const uint8_t length)
+  {
+    const char field[2] = { static_cast<char>(tag), static_cast<char>(length) };
+    tlvBody.concat(field, sizeof field);
+    tlvBody.concat(reinterpret_cast<const char *>(value), length);
+  }
+
+  void append(String &tlvBody, const Tag tag, const String &value)
+  {
+    assert(value.length() <= 255);
+    append(tlvBody, tag, reinterpret_cast<const uint8_t *>(value.c_str()), value.length());
+  }
+
+  void append(String &tlvBody, const Tag tag, const uint64_t value, const uint8_t byteCount)
+  {
+    assert(byteCount <= 8);
+    uint8_t bytes[8];
+    for(uint8_t i = 0; i < byteCount; ++i)
+      bytes[i] = value >> (8*i);
+    append(tlvBody, tag, bytes, byteCount);
+  }
+
+  bool decode(const String &message, const Tag tag, String &value)
+  {
+    const uint8_t *fieldValue = nullptr;
+    uint8_t length = 0;
+    if(findField(message, tag, fieldValue, length) < 0)
+      return false;
+
+    String result;
+    if(!result.concat(reinterpret_cast<const char *>(fieldValue), length))
+      return false;
+      
+    value = result;
+    return true;
+  }
+
+  bool decode(const String &message, const Tag tag, uint64_t &value)
+  {
+    const uint8_t *fieldValue = nullptr;
+    uint8_t length = 0;
+    if(findField(message, tag, fieldValue, length) < 0 || length > 8)
+      return false;
+
+    uint64_t result = 0;
+    for(uint8_t i = 0; i < length; ++i)
+      result |= uint64_t(fieldValue[i]) << (8*i);
+      
+    value = result;
+    return true;
+  }
+
+  bool getPassword(const String &message, String &result)
+  {
+    return decode(message, Tag::PASSWORD, result);
+  }
+  
+  bool getOwnSessionKey(const String &message, uint64_t &result)
+  {
+    return decode(message, Tag::OWN_SESSION_KEY, result);
+  }
+  
+  bool getPeerSessionKey(const String &message, uint64_t &result)
+  {
+    return decode(message, Tag::PEER_SESSION_KEY, result);
+  }
+  
+  bool getDuration(const String &message, uint32_t &result)
+  {
+    uint64_t longResult = 0;
+    bool decoded = decode(message, Tag::DURATION, longResult);
+
+    if(longResult > UINT32_MAX) // Must fit within uint32_t
+      decoded = false;
+      
+    if(decoded)
+      result = longResult;
+
+    return decoded;
+  }
+  
+  bool getNonce(const String &message, String &result)
+  {
+    return decode(message, Tag::NONCE, result);
+  }
+
+  bool getHmac(const String &message, String &result)
+  {
+    const uint8_t *fieldValue = nullptr;
+    uint8_t length = 0;
+    if(findField(message, Tag::HMAC, fieldValue, length) < 0)
+      return false;
+
+    result = TypeCast::uint8ArrayToHexString(fieldValue, length);
+    return true;
+  }
+}
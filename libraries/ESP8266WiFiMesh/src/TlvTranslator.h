@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2019 Anders Löfgren
+ *
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef __ESPNOWTLVTRANSLATOR_H__
+#define __ESPNOWTLVTRANSLATOR_H__
+
+#include <WString.h>
+
+/*
+ * Compact binary alternative to the JSON bodies of JsonTranslator, only sent to peers which announced support for it.
+ * A TLV body starts with tlvMarker. Each field then is a one byte tag, a one byte value length and the value: 
+ * Strings as their characters, integers as little-endian bytes, HMACs as raw bytes.
+ * 
+ * The JsonTranslator getters recognize TLV bodies and read them with this namespace, so received messages can use either format.
+ */
+namespace TlvTranslator 
+{
+  constexpr char tlvMarker = '\x1e'; // ASCII record separator, can never start a JSON body.
+
+  enum class Tag : uint8_t
+  {
+    PASSWORD = 1,
+    OWN_SESSION_KEY = 2,
+    PEER_SESSION_KEY = 3,
+    DURATION = 4,
+    NONCE = 5,
+    HMAC = 6
+  };
+
+  /**
+   * Provides the index within message where the TLV body starts (the index of tlvMarker).
+   * A TLV body can be preceded by a message header but never by a JSON object, so messages with a JSON body are not mistaken for TLV.
+   *
+   * @param message The String to search within.
+   *          
+   * @return An int32_t containing the index within message where the TLV body starts, or a negative value if message has no TLV body.
+   */
+  int32_t getStartIndex(const String &message);
+  bool isTlv(const String &message);
+
+  /**
+   * Provides the index within message where the field with the given tag starts (the index of the tag).
+   *
+   * @return An int32_t containing the index, or a negative value if message has no such field or is malformed.
+   */
+  int32_t getFieldIndex(const String &message, const Tag tag);
+
+  /*
+   * Append a field to a TLV body. The body must be started with tlvMarker. 
+   * 
+   * @param length The value length, at most 255 bytes.
+   */
+  void append(String &tlvBody, const Tag tag, const uint8_t *value, const uint8_t length);
+  void append(String &tlvBody, const Tag tag, const String &value);
+  void append(String &tlvBody, const Tag tag, const uint64_t value, const uint8_t byteCount);
+
+  /*
+   * Get a field value from a TLV body.
+   * 
+   * @return True if a well-formed value was found. False otherwise. The value argument is not modified if false is returned.
+   */
+  bool decode(const String &message, const Tag tag, String &value);
+  bool decode(const String &message, const Tag tag, uint64_t &value);
+
+  bool getPassword(const String &message, String &result);
+  bool getOwnSessionKey(const String &message, uint64_t &result);
+  bool getPeerSessionKey(const String &message, uint64_t &result);
+  bool getDuration(const String &message, uint32_t &result);
+  bool getNonce(const String &message, String &result);
+  
+  /**
+   * Stores the HMAC of message into result, in HEX format like the HMACs of JSON bodies.
+   */
+  bool getHmac(const String &message, String &result);
+}
+
+#endif
@@ -26,6 +26,7 @@
 #include "ESP8266httpUpdate.h"
 #include <StreamString.h>
 #include <flash_hal.h>
+#include <PolledTimeout.h>
 
 ESP8266HTTPUpdate::ESP8266HTTPUpdate(void)
         : _httpClientTimeout(8000)
@@ -180,6 +181,9 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
         http.addHeader(F("x-ESP8266-mode"), F("spiffs"));
     } else {
         http.addHeader(F("x-ESP8266-mode"), F("sketch"));
+        if (_delta) {
+            http.addHeader(F("x-ESP8266-delta"), F("1"));
+        }
     }
 
     if(currentVersion && currentVersion[0] != 0x00) {
@@ -196,7 +200,7 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
         http.setAuthorization(_auth.c_str());
     }
 
-    const char * headerkeys[] = { "x-MD5" };
+    const char * headerkeys[] = { "x-MD5", "x-ESP8266-delta-size", "ETag", "Last-Modified", "Content-Range" };
     size_t headerkeyssize = sizeof(headerkeys) / sizeof(char*);
 
     // track these headers
@@ -232,6 +236,13 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
         DEBUG_HTTP_UPDATE("[httpUpdate]  - MD5: %s\n", md5.c_str());
     }
 
+    // a delta patch, the header gives the size of the image it builds
+    int deltaSize = 0;
+    if(!spiffs && _delta && http.hasHeader("x-ESP8266-delta-size")) {
+        deltaSize = http.header("x-ESP8266-delta-size").toInt();
+        DEBUG_HTTP_UPDATE("[httpUpdate]  - delta for image size: %d\n", deltaSize);
+    }
+
     DEBUG_HTTP_UPDATE("[httpUpdate] ESP8266 info:\n");
     DEBUG_HTTP_UPDATE("[httpUpdate]  - free Space: %d\n", ESP.getFreeSketchSpace());
     DEBUG_HTTP_UPDATE("[httpUpdate]  - current Sketch Size: %d\n", ESP.getSketchSize());
@@ -251,8 +262,9 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
                     startUpdate = false;
                 }
             } else {
-                if(len > (int) ESP.getFreeSketchSpace()) {
-                    DEBUG_HTTP_UPDATE("[httpUpdate] FreeSketchSpace to low (%d) needed: %d\n", ESP.getFreeSketchSpace(), len);
+                int imageSize = deltaSize ? deltaSize : len;
+                if(imageSize > (int) ESP.getFreeSketchSpace()) {
+                    DEBUG_HTTP_UPDATE("[httpUpdate] FreeSketchSpace to low (%d) needed: %d\n", ESP.getFreeSketchSpace(), imageSize);
                     startUpdate = false;
                 }
             }
@@ -291,7 +303,8 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
                     DEBUG_HTTP_UPDATE("[httpUpdate] runUpdate flash...\n");
                 }
 
-                if(!spiffs) {
+                // a patch starts with its own header, the image is checked by Update.end()
+                if(!spiffs && !deltaSize) {
                     uint8_t buf[4];
                     if(tcp->peekBytes(&buf[0], 4) != 4) {
                         DEBUG_HTTP_UPDATE("[httpUpdate] peekBytes magic header failed\n");
@@ -325,7 +338,7 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
                     }
 #endif
                 }
-                if(runUpdate(*tcp, len, md5, command)) {
+                if(runUpdate(*tcp, len, md5, command, deltaSize, &http)) {
                     ret = HTTP_UPDATE_OK;
                     DEBUG_HTTP_UPDATE("[httpUpdate] Update ok\n");
                     http.end();
@@ -386,10 +399,13 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
  * @param in Stream&
  * @param size uint32_t
  * @param md5 String
+ * @param deltaSize uint32_t size of the image when in is a delta patch, or 0
+ * @param http HTTPClient* the request in comes from, to resume it (see setResume())
  * @return true if Update ok
  */
-bool ESP8266HTTPUpdate::runUpdate(Stream& in, uint32_t size, const String& md5, int command)
+bool ESP8266HTTPUpdate::runUpdate(Stream& in, uint32_t size, const String& md5, int command, uint32_t deltaSize, HTTPClient* http)
 {
+    uint32_t imageSize = deltaSize ? deltaSize : size;
 
     StreamString error;
 
@@ -397,7 +413,7 @@ bool ESP8266HTTPUpdate::runUpdate(Stream& in, uint32_t size, const String& md5,
         Update.onProgress(_cbProgress);
     }
 
-    if(!Update.begin(size, command, _ledPin, _ledOn)) {
+    if(!Update.begin(imageSize, command, _ledPin, _ledOn)) {
         _setLastError(Update.getError());
         Update.printError(error);
         error.trim(); // remove line ending
@@ -405,8 +421,20 @@ bool ESP8266HTTPUpdate::runUpdate(Stream& in, uint32_t size, const String& md5,
         return false;
     }
 
+    if(deltaSize && !Update.applyDelta()) {
+        _setLastError(Update.getError());
+        DEBUG_HTTP_UPDATE("[httpUpdate] Update.applyDelta failed!\n");
+        return false;
+    }
+
+    if(_inflate && !deltaSize && in.peek() == 0x1f && !Update.inflate()) {
+        _setLastError(Update.getError());
+        DEBUG_HTTP_UPDATE("[httpUpdate] Update.inflate failed!\n");
+        return false;
+    }
+
     if (_cbProgress) {
-        _cbProgress(0, size);
+        _cbProgress(0, imageSize);
     }
 
     if(md5.length()) {
@@ -417,7 +445,16 @@ bool ESP8266HTTPUpdate::runUpdate(Stream& in, uint32_t size, const String& md5,
         }
     }
 
-    if(Update.writeStream(in) != size) {
+    if(http && _resumeAttempts) {
+        if(writeResumable(*http, in, size) != size) {
+            if(Update.hasError()) {
+                _setLastError(Update.getError());
+            }
+            Update.end(); // drop the partial update
+            DEBUG_HTTP_UPDATE("[httpUpdate] download failed! (%d)\n", _lastError);
+            return false;
+        }
+    } else if(Update.writeStream(in) != size) {
         _setLastError(Update.getError());
         Update.printError(error);
         error.trim(); // remove line ending
@@ -426,7 +463,7 @@ bool ESP8266HTTPUpdate::runUpdate(Stream& in, uint32_t size, const String& md5,
     }
 
     if (_cbProgress) {
-        _cbProgress(size, size);
+        _cbProgress(imageSize, imageSize);
     }
 
     if(!Update.end()) {
@@ -440,6 +477,110 @@ bool ESP8266HTTPUpdate::runUpdate(Stream& in, uint32_t size, const String& md5,
     return true;
 }
 
+/**
+ * write the body of the response to Update, requesting what is missing
+ * again when the connection drops
+ * @param http HTTPClient&
+ * @param in Stream& the body
+ * @param size uint32_t of the body
+ * @return the bytes of the body written
+ */
+size_t ESP8266HTTPUpdate::writeResumable(HTTPClient& http, Stream& in, uint32_t size)
+{
+    // ranges are only taken from the same version of the file
+    String validator = http.header("ETag");
+    if(!validator.length() || validator.startsWith(F("W/"))) {
+        validator = http.header("Last-Modified");
+    }
+
+    Stream* stream = &in;
+    size_t received = 0;
+    uint8_t attempts = 0;
+    esp8266::polledTimeout::oneShotMs timeout(_httpClientTimeout);
+    while(received < size) {
+        size_t written = Update.write(*stream);
+        received += written;
+        if(Update.hasError()) {
+            return received;
+        }
+        if(written) {
+            attempts = 0;
+            timeout.reset();
+            if(_cbProgress) {
+                _cbProgress(Update.progress(), Update.size());
+            }
+            continue;
+        }
+
+        WiFiClient* tcp = http.getStreamPtr();
+        if(tcp && (tcp->connected() || tcp->available()) && !timeout) {
+            if(!Update.preErase()) {
+                delay(1);
+            }
+            continue;
+        }
+
+        // the connection is gone or stalled
+        if(attempts++ == _resumeAttempts) {
+            DEBUG_HTTP_UPDATE("[httpUpdate] connection lost at %zu, no more attempts\n", received);
+            _setLastError(HTTPC_ERROR_CONNECTION_LOST);
+            return received;
+        }
+        DEBUG_HTTP_UPDATE("[httpUpdate] connection lost at %zu, resuming (%u)\n", received, attempts);
+        delay(attempts * 500);
+        stream = resumeRequest(http, received, size, validator);
+        if(!stream) {
+            if(_lastError != HTTPC_ERROR_CONNECTION_FAILED) {
+                return received;
+            }
+            stream = &in; // not connected, try again
+        }
+        timeout.reset();
+    }
+    return received;
+}
+
+/**
+ * request the rest of the file, from offset on
+ * @return the body, or nullptr (_lastError tells why)
+ */
+Stream* ESP8266HTTPUpdate::resumeRequest(HTTPClient& http, uint32_t offset, uint32_t size, const String& validator)
+{
+    // a stalled connection is dropped, the headers of the request are kept
+    WiFiClient* tcp = http.getStreamPtr();
+    if(tcp) {
+        tcp->stop();
+    }
+    String range = F("bytes=");
+    range += offset;
+    range += '-';
+    http.addHeader(F("Range"), range);
+    if(validator.length()) {
+        http.addHeader(F("If-Range"), validator);
+    }
+
+    int code = http.GET();
+    if(code <= 0) {
+        DEBUG_HTTP_UPDATE("[httpUpdate] resume failed: %s\n", http.errorToString(code).c_str());
+        _setLastError(HTTPC_ERROR_CONNECTION_FAILED);
+        return nullptr;
+    }
+
+    // the server must send the very range asked for, of the same file
+    String expected = F("bytes ");
+    expected += offset;
+    expected += '-';
+    expected += size - 1;
+    expected += '/';
+    expected += size;
+    if(code != HTTP_CODE_PARTIAL_CONTENT || http.header("Content-Range") != expected) {
+        DEBUG_HTTP_UPDATE("[httpUpdate] cannot resume, HTTP code %d, range %s\n", code, http.header("Content-Range").c_str());
+        _setLastError(HTTP_UE_SERVER_WRONG_HTTP_CODE);
+        return nullptr;
+    }
+    return http.getStreamPtr();
+}
+
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_HTTPUPDATE)
 ESP8266HTTPUpdate ESPhttpUpdate;
 #endif
@@ -113,6 +113,37 @@ public:
         _md5Sum = md5Sum;
     }
 
+    /**
+      * let the server answer with a delta patch against the running sketch
+      * (x-ESP8266-sketch-md5) instead of the new image, see Updater::applyDelta()
+      * @param delta
+      */
+    void setDelta(bool delta)
+    {
+        _delta = delta;
+    }
+
+    /**
+      * decompress gzip images while they are downloaded rather than
+      * leaving it to eboot at reboot, see Updater::inflate()
+      * @param inflate
+      */
+    void setInflate(bool inflate)
+    {
+        _inflate = inflate;
+    }
+
+    /**
+      * when the connection drops during the download, request the rest
+      * of the file again (Range: header) up to attempts times in a row,
+      * the update goes on from where it was
+      * @param attempts 0 to disable
+      */
+    void setResume(uint8_t attempts)
+    {
+        _resumeAttempts = attempts;
+    }
+
     void setAuthorization(const String& user, const String& password);
     void setAuthorization(const String& auth);
 
@@ -137,7 +168,9 @@ public:
     }
 protected:
     t_httpUpdate_return handleUpdate(HTTPClient& http, const String& currentVersion, bool spiffs = false);
-    bool runUpdate(Stream& in, uint32_t size, const String& md5, int command = U_FLASH);
+    bool runUpdate(Stream& in, uint32_t size, const String& md5, int command = U_FLASH, uint32_t deltaSize = 0, HTTPClient* http = nullptr);
+    size_t writeResumable(HTTPClient& http, Stream& in, uint32_t size);
+    Stream* resumeRequest(HTTPClient& http, uint32_t offset, uint32_t size, const String& validator);
 
     // Set the error and potentially use a CB to notify the application
     void _setLastError(int err) {
@@ -153,6 +186,9 @@ protected:
     String _password;
     String _auth;
     String _md5Sum;
+    bool _delta = false;
+    bool _inflate = false;
+    uint8_t _resumeAttempts = 0;
 private:
     int _httpClientTimeout;
     followRedirects_t _followRedirects = HTTPC_DISABLE_FOLLOW_REDIRECTS;
@@ -54,7 +54,9 @@ namespace MDNSImplementation
     */
     MDNSResponder::MDNSResponder(void) :
         m_pServices(0), m_pUDPContext(0), m_pcHostname(0), m_pServiceQueries(0),
-        m_fnServiceTxtCallback(0), m_bLwipCb(false), m_bRestarting(false)
+        m_fnServiceTxtCallback(0), m_bLwipCb(false), m_bRestarting(false), m_pu8RxData(0),
+        m_u16RxLength(0), m_u16RxOffset(0), m_u32QueriesAnswered(0), m_u32QueriesSuppressed(0),
+        m_u32QueriesIgnored(0)
     {
     }
 
@@ -195,6 +197,7 @@ namespace MDNSImplementation
                     pService->m_ProbeInformation.m_ProbingStatus = ProbingStatus_ReadyToStart;
                 }
             }
+            _recordsChanged();
         }
         DEBUG_EX_ERR(if (!bResult) {
             DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] setHostname: FAILED for '%s'!\n"),
@@ -307,7 +310,8 @@ namespace MDNSImplementation
         bool            bResult
             = (((!p_pcInstanceName) || (MDNS_DOMAIN_LABEL_MAXLENGTH >= os_strlen(p_pcInstanceName)))
                && ((pService = _findService(p_hService))) && (pService->setName(p_pcInstanceName))
-               && ((pService->m_ProbeInformation.m_ProbingStatus = ProbingStatus_ReadyToStart)));
+               && ((pService->m_ProbeInformation.m_ProbingStatus = ProbingStatus_ReadyToStart))
+               && (_recordsChanged()));
         DEBUG_EX_ERR(if (!bResult) {
             DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] setServiceName: FAILED for '%s'!\n"),
                                   (p_pcInstanceName ?: "-"));
@@ -1255,9 +1259,30 @@ namespace MDNSImplementation
     */
     bool MDNSResponder::announce(void)
     {
+        _recordsChanged();
         return (_announce(true, true));
     }
 
+    /*
+        MDNSResponder::getResponseCacheStats
+    */
+    void MDNSResponder::getResponseCacheStats(uint32_t& p_ru32Hits, uint32_t& p_ru32Misses) const
+    {
+        p_ru32Hits   = m_ResponseCache.m_u32Hits;
+        p_ru32Misses = m_ResponseCache.m_u32Misses;
+    }
+
+    /*
+        MDNSResponder::getQueryStats
+    */
+    void MDNSResponder::getQueryStats(uint32_t& p_ru32Answered, uint32_t& p_ru32Suppressed,
+                                      uint32_t& p_ru32Ignored) const
+    {
+        p_ru32Answered   = m_u32QueriesAnswered;
+        p_ru32Suppressed = m_u32QueriesSuppressed;
+        p_ru32Ignored    = m_u32QueriesIgnored;
+    }
+
     /*
         MDNSResponder::enableArduino
 
@@ -173,6 +173,51 @@ namespace MDNSImplementation
 */
 #define MDNS_UDPCONTEXT_TIMEOUT 50
 
+/*
+    Serialized responses kept for the next identical ones (0 disables the cache),
+    at most MDNS_RESPONSE_CACHE_MAXLENGTH bytes each, for up to
+    MDNS_RESPONSE_CACHE_SERVICES services
+*/
+#ifndef MDNS_RESPONSE_CACHE_SIZE
+#define MDNS_RESPONSE_CACHE_SIZE 4
+#endif
+#ifndef MDNS_RESPONSE_CACHE_MAXLENGTH
+#define MDNS_RESPONSE_CACHE_MAXLENGTH 1024
+#endif
+#ifndef MDNS_RESPONSE_CACHE_SERVICES
+#define MDNS_RESPONSE_CACHE_SERVICES 8
+#endif
+
+/*
+    Service query answers are kept in one block, allocated with the first service query:
+    up to MDNS_QUERY_CACHE_ANSWERS answers (found service instances) with together
+    MDNS_QUERY_CACHE_IP4ADDRESSES IP4 addresses, and the labels of their domains, each
+    stored once, up to MDNS_QUERY_CACHE_LABELS labels of MDNS_QUERY_CACHE_LABELCHARS bytes
+*/
+#ifndef MDNS_QUERY_CACHE_ANSWERS
+#define MDNS_QUERY_CACHE_ANSWERS 32
+#endif
+#ifndef MDNS_QUERY_CACHE_IP4ADDRESSES
+#define MDNS_QUERY_CACHE_IP4ADDRESSES 32
+#endif
+#ifndef MDNS_QUERY_CACHE_LABELS
+#define MDNS_QUERY_CACHE_LABELS 128
+#endif
+#ifndef MDNS_QUERY_CACHE_LABELCHARS
+#define MDNS_QUERY_CACHE_LABELCHARS 1536
+#endif
+// Labels of a domain in the query cache, eg. 4 for MyESP._http._tcp.local
+#define MDNS_QUERY_CACHE_DOMAIN_LABELS 8
+
+/*
+    Hashes of the names of our records (host, reverse IP4, DNS-SD and two per service
+    domains), to sort out questions and known answers for other hosts without parsing them.
+    With more names than that, every question and known answer is parsed
+*/
+#ifndef MDNS_RECORD_HASHES
+#define MDNS_RECORD_HASHES 16
+#endif
+
     /**
         MDNSResponder
     */
@@ -475,6 +520,13 @@ namespace MDNSImplementation
         // changes. Mainly, this would be changed content of TXT items.
         bool announce(void);
 
+        // Responses copied from the response cache, and those built field by field
+        void getResponseCacheStats(uint32_t& p_ru32Hits, uint32_t& p_ru32Misses) const;
+        // Queries answered, those whose answers were all in their known answers, and those
+        // not for us
+        void getQueryStats(uint32_t& p_ru32Answered, uint32_t& p_ru32Suppressed,
+                           uint32_t& p_ru32Ignored) const;
+
         // Enable OTA update
         hMDNSService enableArduino(uint16_t p_u16Port, bool p_bAuthUpload = false);
 
@@ -963,6 +1015,38 @@ namespace MDNSImplementation
             bool releaseProtocol(void);
         };
 
+        /**
+            stcMDNSCachedDomain
+
+            A domain of a service query answer, as indexes of its labels in the query cache
+        */
+        struct stcMDNSCachedDomain
+        {
+            uint8_t  m_au8Labels[MDNS_QUERY_CACHE_DOMAIN_LABELS];
+            uint8_t  m_u8LabelCount;
+            uint16_t m_u16NameLength;  // As stcMDNS_RRDomain: encoded length (incl. '\0')
+
+            stcMDNSCachedDomain(void);
+            stcMDNSCachedDomain(const stcMDNSCachedDomain& p_Other) = delete;
+            ~stcMDNSCachedDomain(void);
+
+            stcMDNSCachedDomain& operator=(const stcMDNSCachedDomain& p_Other) = delete;
+            stcMDNSCachedDomain& operator=(const stcMDNS_RRDomain& p_Domain);
+
+            bool set(const stcMDNS_RRDomain& p_Domain);
+            bool clear(void);
+
+            bool compare(const stcMDNS_RRDomain& p_Other) const;
+            bool operator==(const stcMDNS_RRDomain& p_Other) const;
+            bool operator!=(const stcMDNS_RRDomain& p_Other) const;
+
+            bool get(stcMDNS_RRDomain& p_rDomain) const;
+                 operator stcMDNS_RRDomain(void) const;
+
+            size_t c_strLength(void) const;
+            bool   c_str(char* p_pcBuffer) const;
+        };
+
         /**
             stcMDNSServiceQuery
         */
@@ -1018,6 +1102,10 @@ namespace MDNSImplementation
                     stcTTL         m_TTL;
 
                     stcIP4Address(IPAddress p_IPAddress, uint32_t p_u32TTL = 0);
+
+                    // From the query cache, 0 when it is full
+                    static void* operator new(size_t p_stSize) noexcept;
+                    static void  operator delete(void* p_pIP4Address);
                 };
 #endif
 #ifdef MDNS_IP6_SUPPORT
@@ -1037,11 +1125,11 @@ namespace MDNSImplementation
                 stcAnswer* m_pNext;
                 // The service domain is the first 'answer' (from PTR answer, using service and
                 // protocol) to be set Defines the key for additional answer, like host domain, etc.
-                stcMDNS_RRDomain
+                stcMDNSCachedDomain
                        m_ServiceDomain;  // 1. level answer (PTR), eg. MyESP._http._tcp.local
                 char*  m_pcServiceDomain;
                 stcTTL m_TTLServiceDomain;
-                stcMDNS_RRDomain
+                stcMDNSCachedDomain
                     m_HostDomain;  // 2. level answer (SRV, using service domain), eg. esp8266.local
                 char*    m_pcHostDomain;
                 uint16_t m_u16Port;  // 2. level answer (SRV, using service domain), eg. 5000
@@ -1062,6 +1150,10 @@ namespace MDNSImplementation
                 stcAnswer(void);
                 ~stcAnswer(void);
 
+                // From the query cache, 0 when it is full
+                static void* operator new(size_t p_stSize) noexcept;
+                static void  operator delete(void* p_pAnswer);
+
                 bool clear(void);
 
                 char* allocServiceDomain(size_t p_stLength);
@@ -1121,6 +1213,64 @@ namespace MDNSImplementation
             stcAnswer* findAnswerForHostDomain(const stcMDNS_RRDomain& p_HostDomain);
         };
 
+        /**
+            stcMDNSQueryCache
+
+            Flat storage of the service query answers, shared by all service queries
+        */
+        struct stcMDNSQueryCache
+        {
+            /**
+                stcLabel
+            */
+            struct stcLabel
+            {
+                uint16_t m_u16Offset;  // In m_acChars
+                uint8_t  m_u8Length;
+                uint8_t  m_u8References;  // 0: unused
+            };
+
+            stcLabel m_aLabels[MDNS_QUERY_CACHE_LABELS];
+            char     m_acChars[MDNS_QUERY_CACHE_LABELCHARS];
+            uint16_t m_u16CharsEnd;  // Labels are appended here, compacted when full
+            bool     m_abAnswerUsed[MDNS_QUERY_CACHE_ANSWERS];
+            alignas(stcMDNSServiceQuery::stcAnswer) uint8_t
+                m_au8Answers[MDNS_QUERY_CACHE_ANSWERS][sizeof(stcMDNSServiceQuery::stcAnswer)];
+#ifdef MDNS_IP4_SUPPORT
+            bool m_abIP4AddressUsed[MDNS_QUERY_CACHE_IP4ADDRESSES];
+            alignas(stcMDNSServiceQuery::stcAnswer::stcIP4Address) uint8_t
+                m_au8IP4Addresses[MDNS_QUERY_CACHE_IP4ADDRESSES]
+                                 [sizeof(stcMDNSServiceQuery::stcAnswer::stcIP4Address)];
+#endif
+
+            // One cache for all responders, allocated by the first service query
+            static stcMDNSQueryCache* s_pCache;
+            static uint16_t           s_u16Users;
+
+            static bool acquire(void);
+            static bool release(void);
+
+            static void* allocAnswer(void);
+            static bool  releaseAnswer(void* p_pAnswer);
+#ifdef MDNS_IP4_SUPPORT
+            static void* allocIP4Address(void);
+            static bool  releaseIP4Address(void* p_pIP4Address);
+#endif
+
+            static int  internLabel(const char* p_pcLabel, uint8_t p_u8Length);
+            static bool releaseLabel(uint8_t p_u8Label);
+            static const char* label(uint8_t p_u8Label, uint8_t& p_ru8Length);
+
+            stcMDNSQueryCache(void);
+
+        protected:
+            static void* _allocSlot(bool* p_pbUsed, uint8_t* p_pu8Slots, size_t p_stSlotSize,
+                                    size_t p_stCount);
+            static bool  _releaseSlot(void* p_pSlot, bool* p_pbUsed, uint8_t* p_pu8Slots,
+                                      size_t p_stSlotSize, size_t p_stCount);
+            bool         _compact(void);
+        };
+
         /**
             stcMDNSSendParameter
         */
@@ -1168,6 +1318,75 @@ namespace MDNSImplementation
                                             bool        p_bAdditionalData) const;
         };
 
+        /**
+            stcMDNSResponseCache
+
+            Responses without questions (all but the legacy ones) only depend on the
+            reply masks, the send flags and the interface address. Their serialized
+            message is kept and copied to the UDP output buffer the next times.
+            Changed host names, services or TXTs drop all entries.
+        */
+        struct stcMDNSResponseCache
+        {
+            struct stcEntry
+            {
+                IPAddress m_IPAddress;
+                uint16_t  m_u16ID;
+                uint8_t   m_u8HostReplyMask;
+                uint8_t   m_u8Flags;
+                uint8_t   m_u8ServiceCount;
+                uint8_t   m_au8ServiceReplyMasks[MDNS_RESPONSE_CACHE_SERVICES];
+                uint16_t  m_u16Length;  // 0: unused entry
+                uint16_t  m_u16Capacity;
+                uint8_t*  m_pu8Data;
+            };
+
+            stcEntry  m_aEntries[MDNS_RESPONSE_CACHE_SIZE ?: 1];
+            uint8_t   m_u8Next;    // Entry to replace next
+            stcEntry* m_pCapture;  // Entry being filled by _udpAppendBuffer
+            uint32_t  m_u32Hits;
+            uint32_t  m_u32Misses;
+
+            stcMDNSResponseCache(void);
+            ~stcMDNSResponseCache(void);
+
+            bool clear(void);
+
+            // Whether responses to this send parameter can be cached, fills p_rKey
+            bool cacheable(const stcMDNSSendParameter& p_SendParameter,
+                           const IPAddress& p_IPAddress, const stcMDNSService* p_pServices,
+                           bool p_bDynamicTxts, stcEntry& p_rKey) const;
+            const stcEntry* find(const stcEntry& p_Key) const;
+
+            bool startCapture(const stcEntry& p_Key);
+            bool capture(const unsigned char* p_pcBuffer, size_t p_stLength);
+            bool endCapture(bool p_bSuccess);
+        };
+
+        /**
+            stcMDNSRecordHashes
+        */
+        struct stcMDNSRecordHashes
+        {
+            uint32_t m_au32Hashes[MDNS_RECORD_HASHES];
+            uint8_t  m_u8Count;
+            bool     m_bValid;     // Built for the current names and interface addresses
+            bool     m_bOverflow;  // More names than MDNS_RECORD_HASHES: contains() is true
+            uint32_t m_u32NetIfHash;  // The interface addresses they were built for
+
+            stcMDNSRecordHashes(void);
+
+            bool clear(void);
+            bool add(uint32_t p_u32Hash);
+            bool contains(uint32_t p_u32Hash) const;
+
+            // FNV-1a of the length bytes and lower case labels
+            static const uint32_t cu32HashStart = 2166136261UL;
+            static uint32_t hashLabel(uint32_t p_u32Hash, const uint8_t* p_pu8Label,
+                                      uint8_t p_u8Length);
+            static uint32_t hashDomain(const stcMDNS_RRDomain& p_Domain);
+        };
+
         // Instance variables
         stcMDNSService*                   m_pServices;
         UdpContext*                       m_pUDPContext;
@@ -1177,6 +1396,15 @@ namespace MDNSImplementation
         stcProbeInformation               m_HostProbeInformation;
         bool                              m_bLwipCb;
         bool                              m_bRestarting;
+        stcMDNSResponseCache              m_ResponseCache;
+        // Datagram being parsed, in one piece (0: read through m_pUDPContext)
+        const uint8_t*                    m_pu8RxData;
+        uint16_t                          m_u16RxLength;
+        uint16_t                          m_u16RxOffset;
+        stcMDNSRecordHashes               m_RecordHashes;
+        uint32_t                          m_u32QueriesAnswered;
+        uint32_t                          m_u32QueriesSuppressed;
+        uint32_t                          m_u32QueriesIgnored;
 
         /** CONTROL **/
         /* MAINTENANCE */
@@ -1186,6 +1414,9 @@ namespace MDNSImplementation
         /* RECEIVING */
         bool _parseMessage(void);
         bool _parseQuery(const stcMDNS_MsgHeader& p_Header);
+        bool _hasQuestionsForUs(const stcMDNS_MsgHeader& p_Header) const;
+        bool _skipForeignQuestion(stcMDNS_RRQuestion& p_rRRQuestion);
+        bool _skipForeignKnownAnswer(void);
 
         bool _parseResponse(const stcMDNS_MsgHeader& p_Header);
         bool _processAnswers(const stcMDNS_RRAnswer* p_pPTRAnswers);
@@ -1274,6 +1505,11 @@ namespace MDNSImplementation
         bool _udpRead8(uint8_t& p_ru8Value);
         bool _udpRead16(uint16_t& p_ru16Value);
         bool _udpRead32(uint32_t& p_ru32Value);
+        size_t _udpTell(void) const;
+        bool   _udpSeek(size_t p_stOffset);
+        bool   _udpIsValidOffset(size_t p_stOffset) const;
+        bool   _udpHashDomain(uint16_t p_u16Offset, uint32_t& p_ru32Hash,
+                              uint16_t& p_ru16End) const;
 
         bool _udpAppendBuffer(const unsigned char* p_pcBuffer, size_t p_stLength);
         bool _udpAppend8(uint8_t p_u8Value);
@@ -1347,6 +1583,10 @@ namespace MDNSImplementation
         bool _setHostname(const char* p_pcHostname);
         bool _releaseHostname(void);
 
+        /* RECORD NAMES */
+        bool _recordsChanged(void);
+        bool _updateRecordHashes(void);
+
         /* SERVICE */
         stcMDNSService* _allocService(const char* p_pcName, const char* p_pcService,
                                       const char* p_pcProtocol, uint16_t p_u16Port);
@@ -121,6 +121,19 @@ namespace MDNSImplementation
 
         bool bResult = false;
 
+        // Parse from one contiguous view of the datagram, copied only when lwIP chained
+        // several pbufs for it (byte-wise reads through m_pUDPContext if that fails)
+        size_t   stLength = m_pUDPContext->getSize();
+        uint8_t* pu8Copy  = 0;
+        m_pu8RxData       = (const uint8_t*)m_pUDPContext->peekDatagram(0, 0);
+        if ((!m_pu8RxData) && (stLength) && (0xFFFF >= stLength)
+            && (0 != (pu8Copy = new uint8_t[stLength])))
+        {
+            m_pu8RxData = (const uint8_t*)m_pUDPContext->peekDatagram((char*)pu8Copy, stLength);
+        }
+        m_u16RxLength = (m_pu8RxData ? stLength : 0);
+        m_u16RxOffset = 0;
+
         stcMDNS_MsgHeader header;
         if (_readMDNSMsgHeader(header))
         {
@@ -140,7 +153,18 @@ namespace MDNSImplementation
                     // Reading query: ID:%u, Q:%u, A:%u, NS:%u, AR:%u\n"), header.m_u16ID,
                     // header.m_u16QDCount, header.m_u16ANCount, header.m_u16NSCount,
                     // header.m_u16ARCount););
-                    bResult = _parseQuery(header);
+                    _updateRecordHashes();
+                    if (_hasQuestionsForUs(header))
+                    {
+                        bResult = _parseQuery(header);
+                    }
+                    else
+                    {
+                        // Not for us: no need to read the questions and known answers
+                        ++m_u32QueriesIgnored;
+                        m_pUDPContext->flush();
+                        bResult = true;
+                    }
                 }
             }
             else
@@ -158,6 +182,17 @@ namespace MDNSImplementation
                 PSTR("[MDNSResponder] _parseMessage: FAILED to read header\n")););
             m_pUDPContext->flush();
         }
+        if (m_pu8RxData)
+        {
+            m_pUDPContext->flush();  // The view was read, not the UDP context
+            m_pu8RxData   = 0;
+            m_u16RxLength = 0;
+            m_u16RxOffset = 0;
+        }
+        if (pu8Copy)
+        {
+            delete[] pu8Copy;
+        }
         DEBUG_EX_INFO(unsigned uFreeHeap = ESP.getFreeHeap(); DEBUG_OUTPUT.printf_P(
             PSTR("[MDNSResponder] _parseMessage: Done (%s after %lu ms, ate %i bytes, remaining "
                  "%u)\n\n"),
@@ -166,6 +201,102 @@ namespace MDNSImplementation
         return bResult;
     }
 
+    /*
+        MDNSResponder::_hasQuestionsForUs
+
+        Quick look at the questions of a query, straight from the received datagram: most
+       queries on a busy network ask for other hosts and services and needn't be parsed.
+        A question may be for us when the hash of its name is one of our record names' hashes.
+        Anything unexpected (parse error, no contiguous view, probing in progress, which needs
+       the tiebreaking in _parseQuery) is left to the full parser.
+    */
+    bool MDNSResponder::_hasQuestionsForUs(const MDNSResponder::stcMDNS_MsgHeader& p_MsgHeader) const
+    {
+        if ((!m_pu8RxData) || (ProbingStatus_InProgress == m_HostProbeInformation.m_ProbingStatus))
+        {
+            return true;
+        }
+        for (stcMDNSService* pService = m_pServices; pService; pService = pService->m_pNext)
+        {
+            if (ProbingStatus_InProgress == pService->m_ProbeInformation.m_ProbingStatus)
+            {
+                return true;
+            }
+        }
+
+        uint16_t u16Offset = m_u16RxOffset;  // Right after the header
+        for (uint16_t qd = 0; qd < p_MsgHeader.m_u16QDCount; ++qd)
+        {
+            uint32_t u32Hash = 0;
+            if ((!_udpHashDomain(u16Offset, u32Hash, u16Offset))
+                || (m_RecordHashes.contains(u32Hash)))
+            {
+                return true;
+            }
+            u16Offset += 4;  // Type and class
+        }
+        DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(
+            PSTR("[MDNSResponder] _hasQuestionsForUs: No questions for us, ignoring query\n")););
+        return false;
+    }
+
+    /*
+        MDNSResponder::_skipForeignQuestion
+
+        Skips the next question if its name isn't one of ours (by hash), reading only its type
+       and class (for the unicast flag).
+    */
+    bool MDNSResponder::_skipForeignQuestion(MDNSResponder::stcMDNS_RRQuestion& p_rRRQuestion)
+    {
+        uint32_t u32Hash = 0;
+        uint16_t u16End  = 0;
+        bool     bResult = ((_udpHashDomain(m_u16RxOffset, u32Hash, u16End))
+                        && (!m_RecordHashes.contains(u32Hash)) && ((u16End + 4) <= m_u16RxLength));
+        if (bResult)
+        {
+            m_u16RxOffset = u16End;
+            p_rRRQuestion.m_Header.m_Domain.clear();
+            uint16_t u16Class = 0;
+            _udpRead16(p_rRRQuestion.m_Header.m_Attributes.m_u16Type);
+            _udpRead16(u16Class);
+            p_rRRQuestion.m_bUnicast = (0x8000 & u16Class);
+            p_rRRQuestion.m_Header.m_Attributes.m_u16Class = (u16Class & (~0x8000));
+        }
+        return bResult;
+    }
+
+    /*
+        MDNSResponder::_skipForeignKnownAnswer
+
+        Skips the next known answer if it can't be about our records: its name isn't one of
+       ours or, for PTR answers like the instances of a service type we have too, its target
+       isn't (by hash).
+    */
+    bool MDNSResponder::_skipForeignKnownAnswer(void)
+    {
+        uint32_t u32Hash = 0;
+        uint16_t u16End  = 0;
+        bool     bResult = ((_udpHashDomain(m_u16RxOffset, u32Hash, u16End))
+                        && ((u16End + 10) <= m_u16RxLength));
+        if (bResult)
+        {
+            uint16_t u16Type     = ((m_pu8RxData[u16End] << 8) | m_pu8RxData[u16End + 1]);
+            uint16_t u16RDLength = ((m_pu8RxData[u16End + 8] << 8) | m_pu8RxData[u16End + 9]);
+            uint16_t u16RData    = (u16End + 10);
+            uint16_t u16Target   = 0;
+            bResult = (((u16RData + u16RDLength) <= m_u16RxLength)
+                       && ((!m_RecordHashes.contains(u32Hash))
+                           || ((DNS_RRTYPE_PTR == u16Type)
+                               && (_udpHashDomain(u16RData, u32Hash, u16Target))
+                               && (!m_RecordHashes.contains(u32Hash)))));
+            if (bResult)
+            {
+                m_u16RxOffset = (u16RData + u16RDLength);
+            }
+        }
+        return bResult;
+    }
+
     /*
         MDNSResponder::_parseQuery
 
@@ -193,11 +324,13 @@ namespace MDNSImplementation
         for (uint16_t qd = 0; ((bResult) && (qd < p_MsgHeader.m_u16QDCount)); ++qd)
         {
             stcMDNS_RRQuestion questionRR;
-            if ((bResult = _readRRQuestion(questionRR)))
+            bool               bForeign = ((m_pu8RxData) && (_skipForeignQuestion(questionRR)));
+            if ((bForeign) || ((bResult = _readRRQuestion(questionRR))))
             {
                 // Define host replies, BUT only answer queries after probing is done
                 u8HostOrServiceReplies = sendParameter.m_u8HostReplyMask
-                    |= (((ProbingStatus_Done == m_HostProbeInformation.m_ProbingStatus))
+                    |= (((!bForeign)
+                         && (ProbingStatus_Done == m_HostProbeInformation.m_ProbingStatus))
                             ? _replyMaskForHost(questionRR.m_Header, 0)
                             : 0);
                 DEBUG_EX_INFO(if (u8HostOrServiceReplies) {
@@ -207,7 +340,8 @@ namespace MDNSImplementation
                 });
 
                 // Check tiebreak need for host domain
-                if (ProbingStatus_InProgress == m_HostProbeInformation.m_ProbingStatus)
+                if ((!bForeign)
+                    && (ProbingStatus_InProgress == m_HostProbeInformation.m_ProbingStatus))
                 {
                     bool bFullNameMatch = false;
                     if ((_replyMaskForHost(questionRR.m_Header, &bFullNameMatch))
@@ -226,8 +360,9 @@ namespace MDNSImplementation
                     }
                 }
 
-                // Define service replies
-                for (stcMDNSService* pService = m_pServices; pService; pService = pService->m_pNext)
+                // Define service replies (none for questions not for us)
+                for (stcMDNSService* pService = (bForeign ? 0 : m_pServices); pService;
+                     pService                 = pService->m_pNext)
                 {
                     // Define service replies, BUT only answer queries after probing is done
                     uint8_t u8ReplyMaskForQuestion
@@ -358,8 +493,17 @@ namespace MDNSImplementation
                                   u32Answers);
         });
 
+        uint8_t u8PlannedReplies = sendParameter.m_u8HostReplyMask;
+        for (stcMDNSService* pService = m_pServices; pService; pService = pService->m_pNext)
+        {
+            u8PlannedReplies |= pService->m_u8ReplyMask;
+        }
         for (uint32_t an = 0; ((bResult) && (an < u32Answers)); ++an)
         {
+            if ((m_pu8RxData) && (_skipForeignKnownAnswer()))
+            {
+                continue;  // Not about our records, eg. the PTR of another _http._tcp instance
+            }
             stcMDNS_RRAnswer* pKnownRRAnswer = 0;
             if (((bResult = _readRRAnswer(pKnownRRAnswer))) && (pKnownRRAnswer))
             {
@@ -666,6 +810,13 @@ namespace MDNSImplementation
                 sendParameter.m_bAuthorative = true;
 
                 bResult = _sendMDNSMessage(sendParameter);
+                m_u32QueriesAnswered += (bResult ? 1 : 0);
+            }
+            else if (u8PlannedReplies)
+            {
+                DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(
+                    PSTR("[MDNSResponder] _parseQuery: All answers known, no reply needed\n")););
+                ++m_u32QueriesSuppressed;
             }
             DEBUG_EX_INFO(else {
                 DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _parseQuery: No reply needed\n"));
@@ -1016,21 +1167,29 @@ namespace MDNSImplementation
                                = new stcMDNSServiceQuery::stcAnswer)))  // Not yet included -> add
                                                                         // answer
                     {
-                        pSQAnswer->m_ServiceDomain = p_pPTRAnswer->m_PTRDomain;
-                        pSQAnswer->m_u32ContentFlags |= ServiceQueryAnswerType_ServiceDomain;
-                        pSQAnswer->m_TTLServiceDomain.set(p_pPTRAnswer->m_u32TTL);
-                        pSQAnswer->releaseServiceDomain();
-
-                        bResult               = pServiceQuery->addAnswer(pSQAnswer);
-                        p_rbFoundNewKeyAnswer = true;
-                        if (pServiceQuery->m_fnCallback)
+                        if (!pSQAnswer->m_ServiceDomain.set(p_pPTRAnswer->m_PTRDomain))
+                        {
+                            delete pSQAnswer;  // No room left for its labels in the query cache
+                            pSQAnswer = 0;
+                        }
+                        else
                         {
-                            MDNSServiceInfo serviceInfo(*this, (hMDNSServiceQuery)pServiceQuery,
-                                                        pServiceQuery->indexOfAnswer(pSQAnswer));
-                            pServiceQuery->m_fnCallback(
-                                serviceInfo,
-                                static_cast<AnswerType>(ServiceQueryAnswerType_ServiceDomain),
-                                true);
+                            pSQAnswer->m_u32ContentFlags |= ServiceQueryAnswerType_ServiceDomain;
+                            pSQAnswer->m_TTLServiceDomain.set(p_pPTRAnswer->m_u32TTL);
+                            pSQAnswer->releaseServiceDomain();
+
+                            bResult               = pServiceQuery->addAnswer(pSQAnswer);
+                            p_rbFoundNewKeyAnswer = true;
+                            if (pServiceQuery->m_fnCallback)
+                            {
+                                MDNSServiceInfo serviceInfo(
+                                    *this, (hMDNSServiceQuery)pServiceQuery,
+                                    pServiceQuery->indexOfAnswer(pSQAnswer));
+                                pServiceQuery->m_fnCallback(
+                                    serviceInfo,
+                                    static_cast<AnswerType>(ServiceQueryAnswerType_ServiceDomain),
+                                    true);
+                            }
                         }
                     }
                 }
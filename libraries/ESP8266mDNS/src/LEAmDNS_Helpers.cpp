@@ -24,6 +24,7 @@
 
 #include <lwip/igmp.h>
 #include <stdlib_noniso.h>  // strrstr()
+#include <ESP8266WiFiNameService.h>
 
 #include "ESP8266mDNS.h"
 #include "LEAmDNS_lwIPdefs.h"
@@ -216,14 +217,21 @@ namespace MDNSImplementation
     */
     MDNSResponder::stcMDNSServiceQuery* MDNSResponder::_allocServiceQuery(void)
     {
-        stcMDNSServiceQuery* pServiceQuery = new stcMDNSServiceQuery;
-        if (pServiceQuery)
+        stcMDNSServiceQuery* pServiceQuery = 0;
+        if (stcMDNSQueryCache::acquire())  // The answers' storage
         {
-            // Link to query list
-            pServiceQuery->m_pNext = m_pServiceQueries;
-            m_pServiceQueries      = pServiceQuery;
+            if ((pServiceQuery = new stcMDNSServiceQuery))
+            {
+                // Link to query list
+                pServiceQuery->m_pNext = m_pServiceQueries;
+                m_pServiceQueries      = pServiceQuery;
+            }
+            else
+            {
+                stcMDNSQueryCache::release();
+            }
         }
-        return m_pServiceQueries;
+        return pServiceQuery;
     }
 
     /*
@@ -244,6 +252,7 @@ namespace MDNSImplementation
             {
                 pPred->m_pNext = p_pServiceQuery->m_pNext;
                 delete p_pServiceQuery;
+                stcMDNSQueryCache::release();
                 bResult = true;
             }
             else  // No predecessor
@@ -252,6 +261,7 @@ namespace MDNSImplementation
                 {
                     m_pServiceQueries = p_pServiceQuery->m_pNext;
                     delete p_pServiceQuery;
+                    stcMDNSQueryCache::release();
                     bResult = true;
                 }
                 else
@@ -320,6 +330,7 @@ namespace MDNSImplementation
         {
             stcMDNSServiceQuery* pNext = m_pServiceQueries->m_pNext;
             delete m_pServiceQueries;
+            stcMDNSQueryCache::release();
             m_pServiceQueries = pNext;
         }
         return true;
@@ -362,6 +373,7 @@ namespace MDNSImplementation
         bool bResult = false;
 
         _releaseHostname();
+        _recordsChanged();
 
         size_t stLength = 0;
         if ((p_pcHostname)
@@ -382,6 +394,8 @@ namespace MDNSImplementation
 #else
                 strncpy(m_pcHostname, p_pcHostname, (stLength + 1));
 #endif
+                // LLMNR and NetBIOS answer for the same name (probing may have changed it)
+                NameService::setHostname(m_pcHostname);
             }
         }
         return bResult;
@@ -404,6 +418,87 @@ namespace MDNSImplementation
         SERVICE
     */
 
+    /*
+        RECORD NAMES
+    */
+
+    /*
+        MDNSResponder::_recordsChanged
+
+        The host, a service or its TXTs changed: the cached responses and the record name
+        hashes are to be built again.
+    */
+    bool MDNSResponder::_recordsChanged(void)
+    {
+        m_RecordHashes.clear();
+        return m_ResponseCache.clear();
+    }
+
+    /*
+        MDNSResponder::_updateRecordHashes
+
+        (Re)builds the hashes of the names of our records, when they, or the interface
+        addresses (for the reverse IP4 domains), changed.
+    */
+    bool MDNSResponder::_updateRecordHashes(void)
+    {
+        uint32_t u32NetIfHash = stcMDNSRecordHashes::cu32HashStart;
+#ifdef MDNS_IP4_SUPPORT
+        for (netif* pNetIf = netif_list; pNetIf; pNetIf = pNetIf->next)
+        {
+            if (netif_is_up(pNetIf) && IPAddress(pNetIf->ip_addr).isSet())
+            {
+                uint32_t u32IP4Address = ip_2_ip4(&pNetIf->ip_addr)->addr;
+                u32NetIfHash           = stcMDNSRecordHashes::hashLabel(
+                    u32NetIfHash, (const uint8_t*)&u32IP4Address, sizeof(u32IP4Address));
+            }
+        }
+#endif
+        if ((m_RecordHashes.m_bValid) && (m_RecordHashes.m_u32NetIfHash == u32NetIfHash))
+        {
+            return true;
+        }
+
+        m_RecordHashes.clear();
+        m_RecordHashes.m_u32NetIfHash = u32NetIfHash;
+
+        stcMDNS_RRDomain domain;
+        if (_buildDomainForHost(m_pcHostname, domain))
+        {
+            m_RecordHashes.add(stcMDNSRecordHashes::hashDomain(domain));
+        }
+#ifdef MDNS_IP4_SUPPORT
+        for (netif* pNetIf = netif_list; pNetIf; pNetIf = pNetIf->next)
+        {
+            if ((netif_is_up(pNetIf)) && (IPAddress(pNetIf->ip_addr).isSet())
+                && (_buildDomainForReverseIP4(pNetIf->ip_addr, domain)))
+            {
+                m_RecordHashes.add(stcMDNSRecordHashes::hashDomain(domain));
+            }
+        }
+#endif
+        if ((m_pServices) && (_buildDomainForDNSSD(domain)))
+        {
+            m_RecordHashes.add(stcMDNSRecordHashes::hashDomain(domain));
+        }
+        for (stcMDNSService* pService = m_pServices; pService; pService = pService->m_pNext)
+        {
+            if (_buildDomainForService(*pService, false, domain))  // eg. _http._tcp.local
+            {
+                m_RecordHashes.add(stcMDNSRecordHashes::hashDomain(domain));
+            }
+            if (_buildDomainForService(*pService, true, domain))  // eg. MyESP._http._tcp.local
+            {
+                m_RecordHashes.add(stcMDNSRecordHashes::hashDomain(domain));
+            }
+        }
+        m_RecordHashes.m_bValid = true;
+        DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(
+            PSTR("[MDNSResponder] _updateRecordHashes: %u names%s\n"), m_RecordHashes.m_u8Count,
+            (m_RecordHashes.m_bOverflow ? " (overflow, no filtering)" : "")););
+        return true;
+    }
+
     /*
         MDNSResponder::_allocService
     */
@@ -426,6 +521,7 @@ namespace MDNSImplementation
             // Add to list (or start list)
             pService->m_pNext = m_pServices;
             m_pServices       = pService;
+            _recordsChanged();
         }
         return pService;
     }
@@ -437,6 +533,7 @@ namespace MDNSImplementation
     {
         bool bResult = false;
 
+        _recordsChanged();
         if (p_pService)
         {
             stcMDNSService* pPred = m_pServices;
@@ -564,6 +661,7 @@ namespace MDNSImplementation
 
                 // Add to list (or start list)
                 p_pService->m_Txts.add(pTxt);
+                _recordsChanged();
             }
         }
         return pTxt;
@@ -575,7 +673,8 @@ namespace MDNSImplementation
     bool MDNSResponder::_releaseServiceTxt(MDNSResponder::stcMDNSService*    p_pService,
                                            MDNSResponder::stcMDNSServiceTxt* p_pTxt)
     {
-        return ((p_pService) && (p_pTxt) && (p_pService->m_Txts.remove(p_pTxt)));
+        return ((p_pService) && (p_pTxt) && (_recordsChanged())
+                && (p_pService->m_Txts.remove(p_pTxt)));
     }
 
     /*
@@ -593,6 +692,7 @@ namespace MDNSImplementation
         {
             p_pTxt->update(p_pcValue);
             p_pTxt->m_bTemp = p_bTemp;
+            _recordsChanged();
         }
         return p_pTxt;
     }
@@ -1544,6 +1544,24 @@ namespace MDNSImplementation
     {
         m_TTL.set(p_u32TTL);
     }
+
+    /*
+        MDNSResponder::stcMDNSServiceQuery::stcAnswer::stcIP4Address::operator new
+    */
+    void* MDNSResponder::stcMDNSServiceQuery::stcAnswer::stcIP4Address::operator new(
+        size_t p_stSize) noexcept
+    {
+        return ((sizeof(stcIP4Address) == p_stSize) ? stcMDNSQueryCache::allocIP4Address() : 0);
+    }
+
+    /*
+        MDNSResponder::stcMDNSServiceQuery::stcAnswer::stcIP4Address::operator delete
+    */
+    void MDNSResponder::stcMDNSServiceQuery::stcAnswer::stcIP4Address::operator delete(
+        void* p_pIP4Address)
+    {
+        stcMDNSQueryCache::releaseIP4Address(p_pIP4Address);
+    }
 #endif
 
     /**
@@ -1573,6 +1591,22 @@ namespace MDNSImplementation
         clear();
     }
 
+    /*
+        MDNSResponder::stcMDNSServiceQuery::stcAnswer::operator new
+    */
+    void* MDNSResponder::stcMDNSServiceQuery::stcAnswer::operator new(size_t p_stSize) noexcept
+    {
+        return ((sizeof(stcAnswer) == p_stSize) ? stcMDNSQueryCache::allocAnswer() : 0);
+    }
+
+    /*
+        MDNSResponder::stcMDNSServiceQuery::stcAnswer::operator delete
+    */
+    void MDNSResponder::stcMDNSServiceQuery::stcAnswer::operator delete(void* p_pAnswer)
+    {
+        stcMDNSQueryCache::releaseAnswer(p_pAnswer);
+    }
+
     /*
         MDNSResponder::stcMDNSServiceQuery::stcAnswer::clear
     */
@@ -2150,6 +2184,463 @@ namespace MDNSImplementation
         return pAnswer;
     }
 
+    /**
+        MDNSResponder::stcMDNSCachedDomain
+
+        A domain of a service query answer: the indexes of its labels in the query cache.
+        Labels shared by many answers (eg. _http, _tcp and local) are stored only once.
+
+    */
+
+    /*
+        MDNSResponder::stcMDNSCachedDomain::stcMDNSCachedDomain constructor
+    */
+    MDNSResponder::stcMDNSCachedDomain::stcMDNSCachedDomain(void) :
+        m_u8LabelCount(0), m_u16NameLength(0)
+    {
+    }
+
+    /*
+        MDNSResponder::stcMDNSCachedDomain::~stcMDNSCachedDomain destructor
+    */
+    MDNSResponder::stcMDNSCachedDomain::~stcMDNSCachedDomain(void)
+    {
+        clear();
+    }
+
+    /*
+        MDNSResponder::stcMDNSCachedDomain::operator =
+    */
+    MDNSResponder::stcMDNSCachedDomain&
+    MDNSResponder::stcMDNSCachedDomain::operator=(const MDNSResponder::stcMDNS_RRDomain& p_Domain)
+    {
+        set(p_Domain);
+        return *this;
+    }
+
+    /*
+        MDNSResponder::stcMDNSCachedDomain::set
+
+        Interns the labels of the given domain. Leaves the domain empty if the query cache
+        has no room left for them.
+    */
+    bool MDNSResponder::stcMDNSCachedDomain::set(const MDNSResponder::stcMDNS_RRDomain& p_Domain)
+    {
+        bool bResult = clear();
+
+        const unsigned char* pucLabelLength = (const unsigned char*)p_Domain.m_acName;
+        while ((bResult) && (p_Domain.m_u16NameLength) && (*pucLabelLength))
+        {
+            int iLabel = -1;
+            if ((bResult = ((MDNS_QUERY_CACHE_DOMAIN_LABELS > m_u8LabelCount)
+                            && (0 <= (iLabel = stcMDNSQueryCache::internLabel(
+                                          (const char*)(pucLabelLength + 1), *pucLabelLength))))))
+            {
+                m_au8Labels[m_u8LabelCount++] = (uint8_t)iLabel;
+                pucLabelLength += (*pucLabelLength + 1);
+            }
+        }
+        if (bResult)
+        {
+            m_u16NameLength = p_Domain.m_u16NameLength;
+        }
+        else
+        {
+            DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(
+                PSTR("[MDNSResponder] stcMDNSCachedDomain::set: FAILED to intern labels!\n")););
+            clear();
+        }
+        return bResult;
+    }
+
+    /*
+        MDNSResponder::stcMDNSCachedDomain::clear
+    */
+    bool MDNSResponder::stcMDNSCachedDomain::clear(void)
+    {
+        while (m_u8LabelCount)
+        {
+            stcMDNSQueryCache::releaseLabel(m_au8Labels[--m_u8LabelCount]);
+        }
+        m_u16NameLength = 0;
+        return true;
+    }
+
+    /*
+        MDNSResponder::stcMDNSCachedDomain::compare
+    */
+    bool MDNSResponder::stcMDNSCachedDomain::compare(const stcMDNS_RRDomain& p_Other) const
+    {
+        bool bResult = (m_u16NameLength == p_Other.m_u16NameLength);
+
+        const unsigned char* pucLabelLength = (const unsigned char*)p_Other.m_acName;
+        for (uint8_t u = 0; ((bResult) && (u < m_u8LabelCount)); ++u)
+        {
+            uint8_t     u8Length = 0;
+            const char* pcLabel  = stcMDNSQueryCache::label(m_au8Labels[u], u8Length);
+            bResult              = ((pcLabel) && (*pucLabelLength == u8Length)
+                       && (0 == strncasecmp(pcLabel, (const char*)(pucLabelLength + 1), u8Length)));
+            pucLabelLength += (*pucLabelLength + 1);
+        }
+        return ((bResult) && ((!m_u16NameLength) || (0 == *pucLabelLength)));
+    }
+
+    /*
+        MDNSResponder::stcMDNSCachedDomain::operator ==
+    */
+    bool MDNSResponder::stcMDNSCachedDomain::operator==(const stcMDNS_RRDomain& p_Other) const
+    {
+        return compare(p_Other);
+    }
+
+    /*
+        MDNSResponder::stcMDNSCachedDomain::operator !=
+    */
+    bool MDNSResponder::stcMDNSCachedDomain::operator!=(const stcMDNS_RRDomain& p_Other) const
+    {
+        return !compare(p_Other);
+    }
+
+    /*
+        MDNSResponder::stcMDNSCachedDomain::get
+    */
+    bool MDNSResponder::stcMDNSCachedDomain::get(MDNSResponder::stcMDNS_RRDomain& p_rDomain) const
+    {
+        bool bResult = p_rDomain.clear();
+
+        for (uint8_t u = 0; ((bResult) && (u < m_u8LabelCount)); ++u)
+        {
+            uint8_t     u8Length = 0;
+            const char* pcLabel  = stcMDNSQueryCache::label(m_au8Labels[u], u8Length);
+            if ((bResult = ((pcLabel)
+                            && (MDNS_DOMAIN_MAXLENGTH
+                                >= (p_rDomain.m_u16NameLength + 2 + u8Length)))))
+            {
+                p_rDomain.m_acName[p_rDomain.m_u16NameLength++] = (char)u8Length;
+                memcpy(&p_rDomain.m_acName[p_rDomain.m_u16NameLength], pcLabel, u8Length);
+                p_rDomain.m_u16NameLength += u8Length;
+            }
+        }
+        if ((bResult) && (m_u16NameLength))
+        {
+            p_rDomain.m_acName[p_rDomain.m_u16NameLength++] = 0;  // Root label
+        }
+        return bResult;
+    }
+
+    /*
+        MDNSResponder::stcMDNSCachedDomain::operator stcMDNS_RRDomain
+    */
+    MDNSResponder::stcMDNSCachedDomain::operator MDNSResponder::stcMDNS_RRDomain(void) const
+    {
+        stcMDNS_RRDomain domain;
+        get(domain);
+        return domain;
+    }
+
+    /*
+        MDNSResponder::stcMDNSCachedDomain::c_strLength
+    */
+    size_t MDNSResponder::stcMDNSCachedDomain::c_strLength(void) const
+    {
+        size_t stLength = 0;
+
+        for (uint8_t u = 0; u < m_u8LabelCount; ++u)
+        {
+            uint8_t u8Length = 0;
+            stcMDNSQueryCache::label(m_au8Labels[u], u8Length);
+            stLength += (u8Length + 1 /* +1 for '.' or '\0'*/);
+        }
+        return stLength;
+    }
+
+    /*
+        MDNSResponder::stcMDNSCachedDomain::c_str
+    */
+    bool MDNSResponder::stcMDNSCachedDomain::c_str(char* p_pcBuffer) const
+    {
+        bool bResult = false;
+
+        if (p_pcBuffer)
+        {
+            *p_pcBuffer = 0;
+            for (uint8_t u = 0; u < m_u8LabelCount; ++u)
+            {
+                uint8_t     u8Length = 0;
+                const char* pcLabel  = stcMDNSQueryCache::label(m_au8Labels[u], u8Length);
+                memcpy(p_pcBuffer, pcLabel, u8Length);
+                p_pcBuffer += u8Length;
+                *p_pcBuffer++ = (((u + 1) < m_u8LabelCount) ? '.' : '\0');
+            }
+            bResult = true;
+        }
+        return bResult;
+    }
+
+    /**
+        MDNSResponder::stcMDNSQueryCache
+
+        Flat storage of the service query answers, shared by all service queries (of all
+        responders): fixed arrays of answer and IP4 address slots, and a label table.
+        The labels are stored once in a char array, referenced by index and counted.
+        Allocated in one block with the first service query and released with the last one,
+        so that finding, updating and expiring (see _checkServiceQueryCache) answers doesn't
+        allocate anything.
+        When the cache is full, new answers are ignored until old ones expire.
+
+    */
+
+    static_assert(MDNS_QUERY_CACHE_LABELS <= 256, "Labels are referenced by uint8_t index");
+    static_assert(MDNS_QUERY_CACHE_LABELCHARS <= 0xFFFF, "Label offsets are uint16_t");
+
+    MDNSResponder::stcMDNSQueryCache* MDNSResponder::stcMDNSQueryCache::s_pCache   = 0;
+    uint16_t                          MDNSResponder::stcMDNSQueryCache::s_u16Users = 0;
+
+    /*
+        MDNSResponder::stcMDNSQueryCache::stcMDNSQueryCache constructor
+    */
+    MDNSResponder::stcMDNSQueryCache::stcMDNSQueryCache(void) : m_u16CharsEnd(0)
+    {
+        memset(m_aLabels, 0, sizeof(m_aLabels));
+        memset(m_abAnswerUsed, 0, sizeof(m_abAnswerUsed));
+#ifdef MDNS_IP4_SUPPORT
+        memset(m_abIP4AddressUsed, 0, sizeof(m_abIP4AddressUsed));
+#endif
+    }
+
+    /*
+        MDNSResponder::stcMDNSQueryCache::acquire
+    */
+    bool MDNSResponder::stcMDNSQueryCache::acquire(void)
+    {
+        if ((!s_pCache) && (0 == (s_pCache = new stcMDNSQueryCache)))
+        {
+            DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(
+                PSTR("[MDNSResponder] stcMDNSQueryCache::acquire: FAILED to alloc %u bytes!\n"),
+                (unsigned)sizeof(stcMDNSQueryCache)););
+            return false;
+        }
+        ++s_u16Users;
+        return true;
+    }
+
+    /*
+        MDNSResponder::stcMDNSQueryCache::release
+    */
+    bool MDNSResponder::stcMDNSQueryCache::release(void)
+    {
+        if ((s_u16Users) && (0 == --s_u16Users))
+        {
+            delete s_pCache;
+            s_pCache = 0;
+        }
+        return true;
+    }
+
+    /*
+        MDNSResponder::stcMDNSQueryCache::allocAnswer
+    */
+    void* MDNSResponder::stcMDNSQueryCache::allocAnswer(void)
+    {
+        void* pAnswer = (s_pCache ? _allocSlot(s_pCache->m_abAnswerUsed, s_pCache->m_au8Answers[0],
+                                               sizeof(s_pCache->m_au8Answers[0]),
+                                               MDNS_QUERY_CACHE_ANSWERS)
+                                  : 0);
+        DEBUG_EX_ERR(if (!pAnswer) {
+            DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] stcMDNSQueryCache: No answer left!\n"));
+        });
+        return pAnswer;
+    }
+
+    /*
+        MDNSResponder::stcMDNSQueryCache::releaseAnswer
+    */
+    bool MDNSResponder::stcMDNSQueryCache::releaseAnswer(void* p_pAnswer)
+    {
+        return ((s_pCache)
+                && (_releaseSlot(p_pAnswer, s_pCache->m_abAnswerUsed, s_pCache->m_au8Answers[0],
+                                 sizeof(s_pCache->m_au8Answers[0]), MDNS_QUERY_CACHE_ANSWERS)));
+    }
+
+#ifdef MDNS_IP4_SUPPORT
+    /*
+        MDNSResponder::stcMDNSQueryCache::allocIP4Address
+    */
+    void* MDNSResponder::stcMDNSQueryCache::allocIP4Address(void)
+    {
+        void* pIP4Address
+            = (s_pCache ? _allocSlot(s_pCache->m_abIP4AddressUsed, s_pCache->m_au8IP4Addresses[0],
+                                     sizeof(s_pCache->m_au8IP4Addresses[0]),
+                                     MDNS_QUERY_CACHE_IP4ADDRESSES)
+                        : 0);
+        DEBUG_EX_ERR(if (!pIP4Address) {
+            DEBUG_OUTPUT.printf_P(
+                PSTR("[MDNSResponder] stcMDNSQueryCache: No IP4 address left!\n"));
+        });
+        return pIP4Address;
+    }
+
+    /*
+        MDNSResponder::stcMDNSQueryCache::releaseIP4Address
+    */
+    bool MDNSResponder::stcMDNSQueryCache::releaseIP4Address(void* p_pIP4Address)
+    {
+        return ((s_pCache)
+                && (_releaseSlot(p_pIP4Address, s_pCache->m_abIP4AddressUsed,
+                                 s_pCache->m_au8IP4Addresses[0],
+                                 sizeof(s_pCache->m_au8IP4Addresses[0]),
+                                 MDNS_QUERY_CACHE_IP4ADDRESSES)));
+    }
+#endif
+
+    /*
+        MDNSResponder::stcMDNSQueryCache::internLabel
+
+        Index of the (case sensitive) same label, or of a new one. -1 if the label table or
+        the label chars are full.
+    */
+    int MDNSResponder::stcMDNSQueryCache::internLabel(const char* p_pcLabel, uint8_t p_u8Length)
+    {
+        if ((!s_pCache) || (!p_pcLabel) || (!p_u8Length))
+        {
+            return -1;
+        }
+        int iFree = -1;
+        for (int i = 0; i < MDNS_QUERY_CACHE_LABELS; ++i)
+        {
+            stcLabel& label = s_pCache->m_aLabels[i];
+            if (label.m_u8References)
+            {
+                if ((label.m_u8Length == p_u8Length) && (0xFF > label.m_u8References)
+                    && (0 == memcmp(&s_pCache->m_acChars[label.m_u16Offset], p_pcLabel, p_u8Length)))
+                {
+                    ++label.m_u8References;
+                    return i;
+                }
+            }
+            else if (-1 == iFree)
+            {
+                iFree = i;
+            }
+        }
+        if ((-1 == iFree)
+            || (((MDNS_QUERY_CACHE_LABELCHARS - s_pCache->m_u16CharsEnd) < p_u8Length)
+                && ((!s_pCache->_compact())
+                    || ((MDNS_QUERY_CACHE_LABELCHARS - s_pCache->m_u16CharsEnd) < p_u8Length))))
+        {
+            DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(
+                PSTR("[MDNSResponder] stcMDNSQueryCache::internLabel: No room left!\n")););
+            return -1;
+        }
+        stcLabel& label = s_pCache->m_aLabels[iFree];
+        memcpy(&s_pCache->m_acChars[s_pCache->m_u16CharsEnd], p_pcLabel, p_u8Length);
+        label.m_u16Offset    = s_pCache->m_u16CharsEnd;
+        label.m_u8Length     = p_u8Length;
+        label.m_u8References = 1;
+        s_pCache->m_u16CharsEnd += p_u8Length;
+        return iFree;
+    }
+
+    /*
+        MDNSResponder::stcMDNSQueryCache::releaseLabel
+    */
+    bool MDNSResponder::stcMDNSQueryCache::releaseLabel(uint8_t p_u8Label)
+    {
+        bool bResult = ((s_pCache) && (MDNS_QUERY_CACHE_LABELS > p_u8Label)
+                        && (s_pCache->m_aLabels[p_u8Label].m_u8References));
+        if (bResult)
+        {
+            stcLabel& label = s_pCache->m_aLabels[p_u8Label];
+            if ((0 == --label.m_u8References)
+                && ((label.m_u16Offset + label.m_u8Length) == s_pCache->m_u16CharsEnd))
+            {
+                s_pCache->m_u16CharsEnd = label.m_u16Offset;  // Was the last one stored
+            }
+        }
+        return bResult;
+    }
+
+    /*
+        MDNSResponder::stcMDNSQueryCache::label
+    */
+    const char* MDNSResponder::stcMDNSQueryCache::label(uint8_t p_u8Label, uint8_t& p_ru8Length)
+    {
+        if ((s_pCache) && (MDNS_QUERY_CACHE_LABELS > p_u8Label)
+            && (s_pCache->m_aLabels[p_u8Label].m_u8References))
+        {
+            p_ru8Length = s_pCache->m_aLabels[p_u8Label].m_u8Length;
+            return &s_pCache->m_acChars[s_pCache->m_aLabels[p_u8Label].m_u16Offset];
+        }
+        p_ru8Length = 0;
+        return 0;
+    }
+
+    /*
+        MDNSResponder::stcMDNSQueryCache::_allocSlot
+    */
+    void* MDNSResponder::stcMDNSQueryCache::_allocSlot(bool* p_pbUsed, uint8_t* p_pu8Slots,
+                                                        size_t p_stSlotSize, size_t p_stCount)
+    {
+        for (size_t u = 0; u < p_stCount; ++u)
+        {
+            if (!p_pbUsed[u])
+            {
+                p_pbUsed[u] = true;
+                return (p_pu8Slots + (u * p_stSlotSize));
+            }
+        }
+        return 0;
+    }
+
+    /*
+        MDNSResponder::stcMDNSQueryCache::_releaseSlot
+    */
+    bool MDNSResponder::stcMDNSQueryCache::_releaseSlot(void* p_pSlot, bool* p_pbUsed,
+                                                         uint8_t* p_pu8Slots, size_t p_stSlotSize,
+                                                         size_t p_stCount)
+    {
+        bool bResult = ((p_pSlot) && (p_pu8Slots <= (uint8_t*)p_pSlot)
+                        && (((uint8_t*)p_pSlot - p_pu8Slots) < (ptrdiff_t)(p_stSlotSize * p_stCount)));
+        if (bResult)
+        {
+            p_pbUsed[((uint8_t*)p_pSlot - p_pu8Slots) / p_stSlotSize] = false;
+        }
+        return bResult;
+    }
+
+    /*
+        MDNSResponder::stcMDNSQueryCache::_compact
+
+        Moves the used label chars together, in the order they are stored. The label indexes
+        don't change.
+    */
+    bool MDNSResponder::stcMDNSQueryCache::_compact(void)
+    {
+        uint16_t u16End = 0;
+        while (true)
+        {
+            int iNext = -1;
+            for (int i = 0; i < MDNS_QUERY_CACHE_LABELS; ++i)
+            {
+                if ((m_aLabels[i].m_u8References) && (u16End <= m_aLabels[i].m_u16Offset)
+                    && ((-1 == iNext) || (m_aLabels[i].m_u16Offset < m_aLabels[iNext].m_u16Offset)))
+                {
+                    iNext = i;
+                }
+            }
+            if (-1 == iNext)
+            {
+                break;
+            }
+            stcLabel& label = m_aLabels[iNext];
+            memmove(&m_acChars[u16End], &m_acChars[label.m_u16Offset], label.m_u8Length);
+            label.m_u16Offset = u16End;
+            u16End += label.m_u8Length;
+        }
+        m_u16CharsEnd = u16End;
+        return true;
+    }
+
     /**
         MDNSResponder::stcMDNSSendParameter
 
@@ -2293,6 +2784,284 @@ namespace MDNSImplementation
         return (pCacheItem ? pCacheItem->m_u16Offset : 0);
     }
 
+    /**
+        MDNSResponder::stcMDNSResponseCache
+
+        Serialized responses, keyed by everything the message depends on but the host,
+        service and TXT contents (which drop the whole cache when changed).
+        The entries are replaced round-robin.
+
+    */
+
+    /*
+        MDNSResponder::stcMDNSResponseCache::stcMDNSResponseCache constructor
+    */
+    MDNSResponder::stcMDNSResponseCache::stcMDNSResponseCache(void) :
+        m_u8Next(0), m_pCapture(0), m_u32Hits(0), m_u32Misses(0)
+    {
+        for (stcEntry& entry : m_aEntries)
+        {
+            entry.m_u16Length   = 0;
+            entry.m_u16Capacity = 0;
+            entry.m_pu8Data     = 0;
+        }
+    }
+
+    /*
+        MDNSResponder::stcMDNSResponseCache::~stcMDNSResponseCache destructor
+    */
+    MDNSResponder::stcMDNSResponseCache::~stcMDNSResponseCache(void)
+    {
+        clear();
+    }
+
+    /*
+        MDNSResponder::stcMDNSResponseCache::clear
+    */
+    bool MDNSResponder::stcMDNSResponseCache::clear(void)
+    {
+        for (stcEntry& entry : m_aEntries)
+        {
+            free(entry.m_pu8Data);
+            entry.m_pu8Data     = 0;
+            entry.m_u16Length   = 0;
+            entry.m_u16Capacity = 0;
+        }
+        m_pCapture = 0;
+        return true;
+    }
+
+    /*
+        MDNSResponder::stcMDNSResponseCache::cacheable
+    */
+    bool MDNSResponder::stcMDNSResponseCache::cacheable(
+        const MDNSResponder::stcMDNSSendParameter& p_SendParameter, const IPAddress& p_IPAddress,
+        const MDNSResponder::stcMDNSService* p_pServices, bool p_bDynamicTxts,
+        MDNSResponder::stcMDNSResponseCache::stcEntry& p_rKey) const
+    {
+        if ((!MDNS_RESPONSE_CACHE_SIZE) || (!p_SendParameter.m_bResponse)
+            || (p_SendParameter.m_pQuestions) || (p_bDynamicTxts))
+        {
+            return false;
+        }
+        p_rKey.m_IPAddress       = p_IPAddress;
+        p_rKey.m_u16ID           = p_SendParameter.m_u16ID;
+        p_rKey.m_u8HostReplyMask = p_SendParameter.m_u8HostReplyMask;
+        p_rKey.m_u8Flags         = ((p_SendParameter.m_bAuthorative ? 0x01 : 0)
+                            | (p_SendParameter.m_bCacheFlush ? 0x02 : 0)
+                            | (p_SendParameter.m_bUnannounce ? 0x04 : 0));
+        p_rKey.m_u8ServiceCount  = 0;
+        for (const stcMDNSService* pService = p_pServices; pService; pService = pService->m_pNext)
+        {
+            if (MDNS_RESPONSE_CACHE_SERVICES == p_rKey.m_u8ServiceCount)
+            {
+                return false;
+            }
+            p_rKey.m_au8ServiceReplyMasks[p_rKey.m_u8ServiceCount++] = pService->m_u8ReplyMask;
+        }
+        return true;
+    }
+
+    /*
+        MDNSResponder::stcMDNSResponseCache::find
+    */
+    const MDNSResponder::stcMDNSResponseCache::stcEntry* MDNSResponder::stcMDNSResponseCache::find(
+        const MDNSResponder::stcMDNSResponseCache::stcEntry& p_Key) const
+    {
+        for (const stcEntry& entry : m_aEntries)
+        {
+            if ((entry.m_u16Length) && (&entry != m_pCapture)
+                && (entry.m_IPAddress == p_Key.m_IPAddress) && (entry.m_u16ID == p_Key.m_u16ID)
+                && (entry.m_u8HostReplyMask == p_Key.m_u8HostReplyMask)
+                && (entry.m_u8Flags == p_Key.m_u8Flags)
+                && (entry.m_u8ServiceCount == p_Key.m_u8ServiceCount)
+                && (0
+                    == memcmp(entry.m_au8ServiceReplyMasks, p_Key.m_au8ServiceReplyMasks,
+                              p_Key.m_u8ServiceCount)))
+            {
+                return &entry;
+            }
+        }
+        return 0;
+    }
+
+    /*
+        MDNSResponder::stcMDNSResponseCache::startCapture
+
+        Reuses the next entry for the message about to be written.
+    */
+    bool MDNSResponder::stcMDNSResponseCache::startCapture(
+        const MDNSResponder::stcMDNSResponseCache::stcEntry& p_Key)
+    {
+        stcEntry& entry = m_aEntries[m_u8Next];
+        m_u8Next        = (m_u8Next + 1) % (sizeof(m_aEntries) / sizeof(m_aEntries[0]));
+
+        entry.m_IPAddress       = p_Key.m_IPAddress;
+        entry.m_u16ID           = p_Key.m_u16ID;
+        entry.m_u8HostReplyMask = p_Key.m_u8HostReplyMask;
+        entry.m_u8Flags         = p_Key.m_u8Flags;
+        entry.m_u8ServiceCount  = p_Key.m_u8ServiceCount;
+        memcpy(entry.m_au8ServiceReplyMasks, p_Key.m_au8ServiceReplyMasks, p_Key.m_u8ServiceCount);
+        entry.m_u16Length = 0;
+        m_pCapture        = &entry;
+        return true;
+    }
+
+    /*
+        MDNSResponder::stcMDNSResponseCache::capture
+
+        Appends to the entry being filled, gives up on it when it grows too long.
+    */
+    bool MDNSResponder::stcMDNSResponseCache::capture(const unsigned char* p_pcBuffer,
+                                                      size_t               p_stLength)
+    {
+        if (!m_pCapture)
+        {
+            return false;
+        }
+        size_t stLength = m_pCapture->m_u16Length + p_stLength;
+        if (stLength > MDNS_RESPONSE_CACHE_MAXLENGTH)
+        {
+            endCapture(false);
+            return false;
+        }
+        if (stLength > m_pCapture->m_u16Capacity)
+        {
+            size_t stCapacity = std::min((size_t)MDNS_RESPONSE_CACHE_MAXLENGTH,
+                                         std::max((size_t)128, 2 * (size_t)m_pCapture->m_u16Capacity));
+            stCapacity        = std::max(stCapacity, stLength);
+            uint8_t* pu8Data  = (uint8_t*)realloc(m_pCapture->m_pu8Data, stCapacity);
+            if (!pu8Data)
+            {
+                endCapture(false);
+                return false;
+            }
+            m_pCapture->m_pu8Data     = pu8Data;
+            m_pCapture->m_u16Capacity = stCapacity;
+        }
+        memcpy(m_pCapture->m_pu8Data + m_pCapture->m_u16Length, p_pcBuffer, p_stLength);
+        m_pCapture->m_u16Length = stLength;
+        return true;
+    }
+
+    /*
+        MDNSResponder::stcMDNSResponseCache::endCapture
+
+        A failed message leaves an unused entry.
+    */
+    bool MDNSResponder::stcMDNSResponseCache::endCapture(bool p_bSuccess)
+    {
+        if ((m_pCapture) && (!p_bSuccess))
+        {
+            m_pCapture->m_u16Length = 0;
+        }
+        m_pCapture = 0;
+        return p_bSuccess;
+    }
+
+    /**
+        MDNSResponder::stcMDNSRecordHashes
+
+        Hashes of the names our records are known by. A name not in there doesn't need to be
+        compared to them, a name in there may (hash collisions) be one of them.
+
+    */
+
+    /*
+        MDNSResponder::stcMDNSRecordHashes::stcMDNSRecordHashes constructor
+    */
+    MDNSResponder::stcMDNSRecordHashes::stcMDNSRecordHashes(void)
+    {
+        clear();
+    }
+
+    /*
+        MDNSResponder::stcMDNSRecordHashes::clear
+    */
+    bool MDNSResponder::stcMDNSRecordHashes::clear(void)
+    {
+        m_u8Count      = 0;
+        m_bValid       = false;
+        m_bOverflow    = false;
+        m_u32NetIfHash = 0;
+        return true;
+    }
+
+    /*
+        MDNSResponder::stcMDNSRecordHashes::add
+    */
+    bool MDNSResponder::stcMDNSRecordHashes::add(uint32_t p_u32Hash)
+    {
+        for (uint8_t u = 0; u < m_u8Count; ++u)
+        {
+            if (p_u32Hash == m_au32Hashes[u])
+            {
+                return true;
+            }
+        }
+        if (MDNS_RECORD_HASHES <= m_u8Count)
+        {
+            m_bOverflow = true;
+            return false;
+        }
+        m_au32Hashes[m_u8Count++] = p_u32Hash;
+        return true;
+    }
+
+    /*
+        MDNSResponder::stcMDNSRecordHashes::contains
+    */
+    bool MDNSResponder::stcMDNSRecordHashes::contains(uint32_t p_u32Hash) const
+    {
+        if ((!m_bValid) || (m_bOverflow))
+        {
+            return true;
+        }
+        for (uint8_t u = 0; u < m_u8Count; ++u)
+        {
+            if (p_u32Hash == m_au32Hashes[u])
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+        MDNSResponder::stcMDNSRecordHashes::hashLabel
+    */
+    uint32_t MDNSResponder::stcMDNSRecordHashes::hashLabel(uint32_t       p_u32Hash,
+                                                          const uint8_t* p_pu8Label,
+                                                          uint8_t        p_u8Length)
+    {
+        p_u32Hash = ((p_u32Hash ^ p_u8Length) * 16777619UL);
+        for (uint8_t u = 0; u < p_u8Length; ++u)
+        {
+            p_u32Hash = ((p_u32Hash ^ (uint8_t)tolower(p_pu8Label[u])) * 16777619UL);
+        }
+        return p_u32Hash;
+    }
+
+    /*
+        MDNSResponder::stcMDNSRecordHashes::hashDomain
+    */
+    uint32_t MDNSResponder::stcMDNSRecordHashes::hashDomain(const stcMDNS_RRDomain& p_Domain)
+    {
+        uint32_t       u32Hash        = cu32HashStart;
+        const uint8_t* pu8LabelLength = (const uint8_t*)p_Domain.m_acName;
+        const uint8_t* pu8End         = pu8LabelLength + p_Domain.m_u16NameLength;
+        while (pu8LabelLength < pu8End)
+        {
+            u32Hash = hashLabel(u32Hash, pu8LabelLength + 1, *pu8LabelLength);
+            if (!*pu8LabelLength)
+            {
+                break;
+            }
+            pu8LabelLength += (1 + *pu8LabelLength);
+        }
+        return u32Hash;
+    }
+
 }  // namespace MDNSImplementation
 
 }  // namespace esp8266
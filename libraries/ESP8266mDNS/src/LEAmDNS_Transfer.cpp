@@ -160,11 +160,37 @@ namespace MDNSImplementation
         while in the seconds loop, the header and all queries and answers are written to the UDP
         output buffer.
 
+        Responses are copied from the response cache when an identical one was sent before,
+        else they are added to the cache while written.
+
     */
     bool MDNSResponder::_prepareMDNSMessage(MDNSResponder::stcMDNSSendParameter& p_rSendParameter,
                                             IPAddress                            p_IPAddress)
     {
         DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _prepareMDNSMessage\n")););
+
+        // TXTs from callbacks may change with every response
+        bool bDynamicTxts = (0 != m_fnServiceTxtCallback);
+        for (stcMDNSService* pService = m_pServices; ((!bDynamicTxts) && (pService));
+             pService                 = pService->m_pNext)
+        {
+            bDynamicTxts = (0 != pService->m_fnTxtCallback);
+        }
+        stcMDNSResponseCache::stcEntry cacheKey;
+        bool                           bCacheable = m_ResponseCache.cacheable(
+            p_rSendParameter, p_IPAddress, m_pServices, bDynamicTxts, cacheKey);
+        if (bCacheable)
+        {
+            const stcMDNSResponseCache::stcEntry* pCached = m_ResponseCache.find(cacheKey);
+            if (pCached)
+            {
+                ++m_ResponseCache.m_u32Hits;
+                return _udpAppendBuffer(pCached->m_pu8Data, pCached->m_u16Length);
+            }
+            ++m_ResponseCache.m_u32Misses;
+            m_ResponseCache.startCapture(cacheKey);
+        }
+
         bool bResult = true;
         p_rSendParameter.clearCachedNames();  // Need to remove cached names, p_SendParameter might
                                               // have been used before on other interface
@@ -381,6 +407,10 @@ namespace MDNSImplementation
             DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(
                 PSTR("[MDNSResponder] _prepareMDNSMessage: Loop %i FAILED!\n"), sequence););
         }  // for sequence
+        if (bCacheable)
+        {
+            m_ResponseCache.endCapture(bResult);
+        }
         DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(
             PSTR("[MDNSResponder] _prepareMDNSMessage: FAILED!\n")););
         return bResult;
@@ -710,7 +740,7 @@ namespace MDNSImplementation
                                     DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRAnswerTXT: "
                                                                "FAILED to read TXT item!\n"));
                                     DEBUG_OUTPUT.printf_P(PSTR("RData dump:\n")); _udpDump(
-                                        (m_pUDPContext->tell() - p_u16RDLength), p_u16RDLength);
+                                        (_udpTell() - p_u16RDLength), p_u16RDLength);
                                     DEBUG_OUTPUT.printf_P(PSTR("\n")););
                             }
                             if (pTxt)
@@ -725,7 +755,7 @@ namespace MDNSImplementation
                     DEBUG_EX_ERR(if (!bResult)  // Some failure
                                  {
                                      DEBUG_OUTPUT.printf_P(PSTR("RData dump:\n"));
-                                     _udpDump((m_pUDPContext->tell() - p_u16RDLength),
+                                     _udpDump((_udpTell() - p_u16RDLength),
                                               p_u16RDLength);
                                      DEBUG_OUTPUT.printf_P(PSTR("\n"));
                                  });
@@ -856,7 +886,7 @@ namespace MDNSImplementation
             do
             {
                 // DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain_Loop(%u):
-                // Offset:%u p0:%02x\n"), p_u8Depth, m_pUDPContext->tell(),
+                // Offset:%u p0:%02x\n"), p_u8Depth, _udpTell(),
                 // m_pUDPContext->peek()););
                 _udpRead8(u8Len);
 
@@ -868,21 +898,21 @@ namespace MDNSImplementation
                     _udpRead8(u8Len);
                     u16Offset |= u8Len;
 
-                    if (m_pUDPContext->isValidOffset(u16Offset))
+                    if (_udpIsValidOffset(u16Offset))
                     {
                         size_t stCurrentPosition
-                            = m_pUDPContext->tell();  // Prepare return from recursion
+                            = _udpTell();  // Prepare return from recursion
 
                         // DEBUG_EX_RX(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder]
                         // _readRRDomain_Loop(%u): Redirecting from %u to %u!\n"), p_u8Depth,
                         // stCurrentPosition, u16Offset););
-                        m_pUDPContext->seek(u16Offset);
+                        _udpSeek(u16Offset);
                         if (_readRRDomain_Loop(p_rRRDomain, p_u8Depth + 1))  // Do recursion
                         {
                             // DEBUG_EX_RX(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder]
                             // _readRRDomain_Loop(%u): Succeeded to read redirected label! Returning
                             // to %u\n"), p_u8Depth, stCurrentPosition););
-                            m_pUDPContext->seek(stCurrentPosition);  // Restore after recursion
+                            _udpSeek(stCurrentPosition);  // Restore after recursion
                         }
                         else
                         {
@@ -931,7 +961,7 @@ namespace MDNSImplementation
                             }
                         }
                         // DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder]
-                        // _readRRDomain_Loop(2) offset:%u p0:%x\n"), m_pUDPContext->tell(),
+                        // _readRRDomain_Loop(2) offset:%u p0:%x\n"), _udpTell(),
                         // m_pUDPContext->peek()););
                     }
                     else
@@ -1108,9 +1138,23 @@ namespace MDNSImplementation
     */
     bool MDNSResponder::_udpReadBuffer(unsigned char* p_pBuffer, size_t p_stLength)
     {
-        bool bResult = ((m_pUDPContext) && (true /*m_pUDPContext->getSize() > p_stLength*/)
-                        && (p_pBuffer) && (p_stLength)
-                        && ((p_stLength == m_pUDPContext->read((char*)p_pBuffer, p_stLength))));
+        bool bResult = false;
+
+        if (m_pu8RxData)  // Datagram in one piece: copy from it
+        {
+            if ((p_pBuffer) && (p_stLength) && (m_u16RxLength >= m_u16RxOffset)
+                && (p_stLength <= (size_t)(m_u16RxLength - m_u16RxOffset)))
+            {
+                memcpy(p_pBuffer, &m_pu8RxData[m_u16RxOffset], p_stLength);
+                m_u16RxOffset += p_stLength;
+                bResult = true;
+            }
+        }
+        else
+        {
+            bResult = ((m_pUDPContext) && (p_pBuffer) && (p_stLength)
+                       && ((p_stLength == m_pUDPContext->read((char*)p_pBuffer, p_stLength))));
+        }
         DEBUG_EX_ERR(if (!bResult) {
             DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _udpReadBuffer: FAILED!\n"));
         });
@@ -1155,6 +1199,99 @@ namespace MDNSImplementation
         return bResult;
     }
 
+    /*
+        MDNSResponder::_udpTell
+    */
+    size_t MDNSResponder::_udpTell(void) const
+    {
+        return (m_pu8RxData ? m_u16RxOffset : (m_pUDPContext ? m_pUDPContext->tell() : 0));
+    }
+
+    /*
+        MDNSResponder::_udpSeek
+    */
+    bool MDNSResponder::_udpSeek(size_t p_stOffset)
+    {
+        bool bResult = _udpIsValidOffset(p_stOffset);
+
+        if (bResult)
+        {
+            if (m_pu8RxData)
+            {
+                m_u16RxOffset = p_stOffset;
+            }
+            else
+            {
+                m_pUDPContext->seek(p_stOffset);
+            }
+        }
+        return bResult;
+    }
+
+    /*
+        MDNSResponder::_udpIsValidOffset
+    */
+    bool MDNSResponder::_udpIsValidOffset(size_t p_stOffset) const
+    {
+        return (m_pu8RxData ? (p_stOffset <= m_u16RxLength)
+                            : ((m_pUDPContext) && (m_pUDPContext->isValidOffset(p_stOffset))));
+    }
+
+    /*
+        MDNSResponder::_udpHashDomain
+
+        Hashes (like stcMDNSRecordHashes::hashDomain) the domain at the given offset of the
+        received datagram, following the compression pointers, without moving the read
+        position. p_ru16End is set to the offset right behind the domain.
+        Needs the contiguous receive view.
+    */
+    bool MDNSResponder::_udpHashDomain(uint16_t p_u16Offset, uint32_t& p_ru32Hash,
+                                       uint16_t& p_ru16End) const
+    {
+        bool     bResult   = (0 != m_pu8RxData);
+        bool     bRedirect = false;
+        uint8_t  u8Depth   = 0;
+        uint16_t u16Length = 0;
+        uint32_t u32Offset = p_u16Offset;
+
+        p_ru32Hash = stcMDNSRecordHashes::cu32HashStart;
+        while ((bResult) && ((bResult = (u32Offset < m_u16RxLength))))
+        {
+            uint8_t u8Len = m_pu8RxData[u32Offset];
+            if (MDNS_DOMAIN_COMPRESS_MARK == (u8Len & MDNS_DOMAIN_COMPRESS_MARK))
+            {
+                if ((bResult = (((u32Offset + 1) < m_u16RxLength)
+                                && (MDNS_DOMAIN_MAX_REDIRCTION >= ++u8Depth))))
+                {
+                    if (!bRedirect)
+                    {
+                        p_ru16End = (u32Offset + 2);
+                        bRedirect = true;
+                    }
+                    u32Offset = (((u8Len & ~MDNS_DOMAIN_COMPRESS_MARK) << 8)
+                                 | m_pu8RxData[u32Offset + 1]);
+                }
+            }
+            else if ((bResult = ((!(u8Len & MDNS_DOMAIN_COMPRESS_MARK))
+                                 && ((u32Offset + 1 + u8Len) <= m_u16RxLength)
+                                 && (MDNS_DOMAIN_MAXLENGTH >= (u16Length += (1 + u8Len))))))
+            {
+                p_ru32Hash = stcMDNSRecordHashes::hashLabel(p_ru32Hash, &m_pu8RxData[u32Offset + 1],
+                                                            u8Len);
+                u32Offset += (1 + u8Len);
+                if (!u8Len)  // Root label: done
+                {
+                    if (!bRedirect)
+                    {
+                        p_ru16End = u32Offset;
+                    }
+                    break;
+                }
+            }
+        }
+        return bResult;
+    }
+
     /*
         MDNSResponder::_udpAppendBuffer
     */
@@ -1163,6 +1300,10 @@ namespace MDNSImplementation
         bool bResult
             = ((m_pUDPContext) && (p_pcBuffer) && (p_stLength)
                && (p_stLength == m_pUDPContext->append((const char*)p_pcBuffer, p_stLength)));
+        if ((bResult) && (m_ResponseCache.m_pCapture))
+        {
+            m_ResponseCache.capture(p_pcBuffer, p_stLength);
+        }
         DEBUG_EX_ERR(if (!bResult) {
             DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _udpAppendBuffer: FAILED!\n"));
         });
@@ -1203,7 +1344,7 @@ namespace MDNSImplementation
     {
         const uint8_t cu8BytesPerLine = 16;
 
-        uint32_t u32StartPosition = m_pUDPContext->tell();
+        uint32_t u32StartPosition = _udpTell();
         DEBUG_OUTPUT.println("UDP Context Dump:");
         uint32_t u32Counter = 0;
         uint8_t  u8Byte     = 0;
@@ -1219,7 +1360,7 @@ namespace MDNSImplementation
 
         if (!p_bMovePointer)  // Restore
         {
-            m_pUDPContext->seek(u32StartPosition);
+            _udpSeek(u32StartPosition);
         }
         return true;
     }
@@ -1229,18 +1370,18 @@ namespace MDNSImplementation
     */
     bool MDNSResponder::_udpDump(unsigned p_uOffset, unsigned p_uLength)
     {
-        if ((m_pUDPContext) && (m_pUDPContext->isValidOffset(p_uOffset)))
+        if (_udpIsValidOffset(p_uOffset))
         {
-            unsigned uCurrentPosition = m_pUDPContext->tell();  // Remember start position
+            unsigned uCurrentPosition = _udpTell();  // Remember start position
 
-            m_pUDPContext->seek(p_uOffset);
+            _udpSeek(p_uOffset);
             uint8_t u8Byte;
             for (unsigned u = 0; ((u < p_uLength) && (_udpRead8(u8Byte))); ++u)
             {
                 DEBUG_OUTPUT.printf_P(PSTR("%02x "), u8Byte);
             }
             // Return to start position
-            m_pUDPContext->seek(uCurrentPosition);
+            _udpSeek(uCurrentPosition);
         }
         return true;
     }
@@ -1717,16 +1858,15 @@ namespace MDNSImplementation
                 bResult = ((_udpAppendBuffer((unsigned char*)&ucLengthByte, sizeof(ucLengthByte)))
                            &&  // Length
                            (p_rSendParameter.shiftOffset(sizeof(ucLengthByte)))
-                           && ((size_t)os_strlen(pTxt->m_pcKey)
-                               == m_pUDPContext->append(pTxt->m_pcKey, os_strlen(pTxt->m_pcKey)))
+                           && (_udpAppendBuffer((const unsigned char*)pTxt->m_pcKey,
+                                                os_strlen(pTxt->m_pcKey)))
                            &&  // Key
                            (p_rSendParameter.shiftOffset((size_t)os_strlen(pTxt->m_pcKey)))
-                           && (1 == m_pUDPContext->append("=", 1)) &&  // =
+                           && (_udpAppendBuffer((const unsigned char*)"=", 1)) &&  // =
                            (p_rSendParameter.shiftOffset(1))
-                           && ((!pTxt->m_pcValue)
-                               || (((size_t)os_strlen(pTxt->m_pcValue)
-                                    == m_pUDPContext->append(pTxt->m_pcValue,
-                                                             os_strlen(pTxt->m_pcValue)))
+                           && ((!pTxt->m_pcValue) || (!*pTxt->m_pcValue)
+                               || ((_udpAppendBuffer((const unsigned char*)pTxt->m_pcValue,
+                                                     os_strlen(pTxt->m_pcValue)))
                                    &&  // Value
                                    (p_rSendParameter.shiftOffset(
                                        (size_t)os_strlen(pTxt->m_pcValue))))));
@@ -97,7 +97,6 @@ bool FSTools::moveFS(fs::FS & destinationFS)
         return false;
     }
 
-    uint32_t startSector = (ESP.getSketchSize() + FLASH_SECTOR_SIZE - 1) & (~(FLASH_SECTOR_SIZE - 1));
     uint32_t lowestFSStart = 0x40300000;
 
     if (_layout)
@@ -106,11 +105,6 @@ bool FSTools::moveFS(fs::FS & destinationFS)
         FSTOOLSDEBUG("_layout->startADDR = 0x%08x\n", _layout->startAddr);
     }
 
-    uint32_t endSector = lowestFSStart - 0x40200000;
-    uint32_t tempFSsize = endSector - startSector;
-
-    FSTOOLSDEBUG("TempFS:  start: %u, end: %u, size: %u, sketchSize = %u, _FS_start = %u\n", startSector, endSector, tempFSsize, ESP.getSketchSize(), (uint32_t)&_FS_start);
-
     fileListIterator(*_pFS, "/", [&sourceFileCount, &sourceByteTotal, this](File & f)
     {
         if (f)
@@ -126,34 +120,43 @@ bool FSTools::moveFS(fs::FS & destinationFS)
     });
 
     FSTOOLSDEBUG("%u Files Found Total Size = %u\n", sourceFileCount, sourceByteTotal);
-    FSTOOLSDEBUG("Size of dummy FS = %u\n", tempFSsize);
+    _done = 0;
+
+    if (_layout && (_layout->endAddr <= (uint32_t)FS_start || _layout->startAddr >= (uint32_t)FS_end))
+    {
+        //  The source survives formatting the destination, no need for a temporary FS
+        FSTOOLSDEBUG("Source outside of the sketch FS, copying directly\n");
+        _total = sourceByteTotal;
+        if (destinationFS.format() && destinationFS.begin())
+        {
+            result = _copyFS(*_pFS, destinationFS);
+        }
+        else
+        {
+            FSTOOLSDEBUG("Error Mounting\n");
+        }
+        reset();
+        return result;
+    }
 
-    FS tempFS = FS(FSImplPtr(new littlefs_impl::LittleFSImpl(startSector, tempFSsize, FS_PHYS_PAGE, FS_PHYS_BLOCK, 5)));
+    _total = 2 * sourceByteTotal;
+    std::unique_ptr<fs::FS> tempFS = _tempFS(lowestFSStart);
 
-    if (tempFS.format() && tempFS.begin())
+    if (tempFS && tempFS->format() && tempFS->begin())
     {
-        if (_copyFS(*_pFS, tempFS))
+        if (_copyFS(*_pFS, *tempFS))
         {
             FSTOOLSDEBUG("Files copied to temp File System\n");
+            File marker = tempFS->open(FST::moveMarker, "w");
+            marker.close();
             reset();
-            if (destinationFS.format() && destinationFS.begin()) //  must format then mount the new FS
-            {
-                if (_copyFS(tempFS, destinationFS))
-                {
-                    FSTOOLSDEBUG("Files copied back to new FS\n");
-                    result = true;
-                }
-            }
-            else
-            {
-                FSTOOLSDEBUG("Error Mounting\n");
-            }
+            result = _copyBack(*tempFS, destinationFS);
         }
         else
         {
             FSTOOLSDEBUG("Copy Failed\n");
         }
-        tempFS.end();
+        tempFS->end();
     }
     else
     {
@@ -162,6 +165,70 @@ bool FSTools::moveFS(fs::FS & destinationFS)
     return result;
 };
 
+bool FSTools::resumeMoveFS(fs::FS & destinationFS, const FST::layout & layout)
+{
+    std::unique_ptr<fs::FS> tempFS = _tempFS(layout.startAddr);
+    if (!tempFS || !attemptToMountFS(*tempFS))
+    {
+        return false;
+    }
+    bool result = false;
+    if (tempFS->exists(FST::moveMarker))
+    {
+        FSTOOLSDEBUG("Resuming the copy from the temp File System\n");
+        _done = 0;
+        _total = 0;
+        fileListIterator(*tempFS, "/", [this](File & f)
+        {
+            if (f)
+            {
+                _total += f.size();
+            }
+        });
+        result = _copyBack(*tempFS, destinationFS);
+    }
+    tempFS->end();
+    return result;
+}
+
+void FSTools::setProgressCallback(FST::ProgressCb cb)
+{
+    _progress = cb;
+}
+
+std::unique_ptr<fs::FS> FSTools::_tempFS(uint32_t lowestFSStart)
+{
+    uint32_t startSector = (ESP.getSketchSize() + FLASH_SECTOR_SIZE - 1) & (~(FLASH_SECTOR_SIZE - 1));
+    uint32_t endSector = lowestFSStart - 0x40200000;
+    if (endSector <= startSector)
+    {
+        return nullptr;
+    }
+    uint32_t tempFSsize = endSector - startSector;
+
+    FSTOOLSDEBUG("TempFS:  start: %u, end: %u, size: %u, sketchSize = %u, _FS_start = %u\n", startSector, endSector, tempFSsize, ESP.getSketchSize(), (uint32_t)&_FS_start);
+
+    return std::unique_ptr<fs::FS>(new FS(FSImplPtr(new littlefs_impl::LittleFSImpl(startSector, tempFSsize, FS_PHYS_PAGE, FS_PHYS_BLOCK, 5))));
+}
+
+bool FSTools::_copyBack(FS & tempFS, FS & destFS)
+{
+    if (!destFS.format() || !destFS.begin()) //  must format then mount the new FS
+    {
+        FSTOOLSDEBUG("Error Mounting\n");
+        return false;
+    }
+    if (!_copyFS(tempFS, destFS))
+    {
+        FSTOOLSDEBUG("Copy back Failed\n");
+        return false;
+    }
+    FSTOOLSDEBUG("Files copied back to new FS\n");
+    //  Nothing left to resume
+    tempFS.remove(FST::moveMarker);
+    return true;
+}
+
 void FSTools::reset()
 {
     _mounted = false;
@@ -217,31 +284,37 @@ void FSTools::_dumpFileInfo(File & f)
 bool FSTools::_copyFS(FS & sourceFS, FS & destFS)
 {
     uint32_t sourceFileCount = 0;
-    uint32_t sourceByteTotal = 0;
 
-    fileListIterator(sourceFS, "/", [&sourceFileCount, &sourceByteTotal](File & f)
+    fileListIterator(sourceFS, "/", [&sourceFileCount](File & f)
     {
-        if (f)
+        if (f && !_isMoveMarker(f))
         {
             sourceFileCount++;
-            sourceByteTotal += f.size();
         }
     });
 
+    //  One large buffer for all files, a small one if there is no room for it
+    size_t bufSize = FST::copyBufferSize;
+    std::unique_ptr<uint32_t[]> buf(new (std::nothrow) uint32_t[bufSize / 4]);
+    if (!buf)
+    {
+        bufSize = 256;
+        buf.reset(new (std::nothrow) uint32_t[bufSize / 4]);
+        if (!buf)
+        {
+            return false;
+        }
+    }
+
     size_t count = 0;
-    fileListIterator(sourceFS, "/", [&count, &destFS](File & sourceFile)
+    fileListIterator(sourceFS, "/", [&count, &destFS, &buf, bufSize, this](File & sourceFile)
     {
-        if (sourceFile)
+        if (sourceFile && !_isMoveMarker(sourceFile))
         {
             File destFile = destFS.open(sourceFile.fullName(), "w");
-            if (destFile)
+            if (destFile && _copyFile(sourceFile, destFile, reinterpret_cast<uint8_t *>(buf.get()), bufSize))
             {
-                destFile.setTimeout(5000); //  this value was chosen empirically as it failed with default timeout. 
-                size_t written = destFile.write(sourceFile);
-                if (written == sourceFile.size())
-                {
-                    count++;
-                }
+                count++;
             }
             destFile.close();
             sourceFile.close();
@@ -252,3 +325,25 @@ bool FSTools::_copyFS(FS & sourceFS, FS & destFS)
     return (count == sourceFileCount);
 
 }
+
+bool FSTools::_copyFile(File & sourceFile, File & destFile, uint8_t * buf, size_t bufSize)
+{
+    size_t remaining = sourceFile.size();
+    while (remaining)
+    {
+        int got = sourceFile.read(buf, std::min(bufSize, remaining));
+        if (got <= 0 || destFile.write(buf, got) != (size_t)got)
+        {
+            FSTOOLSDEBUG("Copy of %s failed\n", sourceFile.fullName());
+            return false;
+        }
+        remaining -= got;
+        _done += got;
+        if (_progress)
+        {
+            _progress(sourceFile.fullName(), _done, _total);
+        }
+        yield();
+    }
+    return true;
+}
@@ -8,6 +8,13 @@
     A temporary FS is made between the END of the sketch...  and the start of the partition you try to mount, to maximise the available space for copying the FS.
     The WORST case this is at 0x40300000 which is for a 3m FS on 4m flash..  leaving 460Kb for copying.
 
+    When the partition you copy from does not overlap the one of the sketch (FS_start to FS_end), which is
+    where the destination FS must be, the files are copied straight across and no temporary FS is made.
+
+    Otherwise the destination is formatted once all files are in the temporary FS, which gets a marker file
+    then.  If the ESP resets while the files are copied back, the source is gone but resumeMoveFS() copies them
+    from the temporary FS again - call it at boot with the same source layout, before trying to mount.
+
 */
 
 
@@ -59,6 +66,13 @@ namespace FST
     static constexpr layout layout_16m15m  = { 0x40300000, 0x411FA000, 0x100, 0x2000 };
 
     typedef std::function<void(File & f)> FileCb;
+    //  Called as the files are copied, with the bytes copied so far of all files
+    typedef std::function<void(const char * path, uint32_t done, uint32_t total)> ProgressCb;
+
+    //  Written to the temporary FS when all files are in it
+    static constexpr const char * moveMarker = "/.fstools-move";
+    //  Files are copied through a buffer up to this size
+    static constexpr size_t copyBufferSize = 4096;
 
 };
 
@@ -73,6 +87,8 @@ public:
     bool mountAlternativeFS(FST::FS_t type, const FST::layout & layout, bool keepMounted = false);
     bool mounted();
     bool moveFS(fs::FS & destinationFS);
+    bool resumeMoveFS(fs::FS & destinationFS, const FST::layout & layout);
+    void setProgressCallback(FST::ProgressCb cb);
     void reset();
     void fileListIterator(FS & fs, const char * dirName, FST::FileCb Cb);
 
@@ -83,9 +99,20 @@ private:
     void _dumpFileInfo(File & f);
 #endif
     bool _copyFS(FS & sourceFS, FS & destFS);
+    bool _copyFile(File & sourceFile, File & destFile, uint8_t * buf, size_t bufSize);
+    std::unique_ptr<fs::FS> _tempFS(uint32_t lowestFSStart);
+    bool _copyBack(FS & tempFS, FS & destFS);
+    static bool _isMoveMarker(File & f)
+    {
+        const char * name = f.fullName();
+        return name && !strcmp(name + (name[0] == '/'), FST::moveMarker + 1);
+    }
 
     std::unique_ptr<fs::FS> _pFS;
     bool _mounted{false};
     const FST::layout * _layout{nullptr};
+    FST::ProgressCb _progress{nullptr};
+    uint32_t _done{0};
+    uint32_t _total{0};
 
 };
\ No newline at end of file
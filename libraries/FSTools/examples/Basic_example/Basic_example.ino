@@ -12,7 +12,8 @@
         start of whatever filesystem you set as target.  This has IMPORTANT implications for the
         amount of data you can move!!!  eg a 4Mb flash module with a 3Mb SPIFFS partition only leaves
         about 450k for the temp file system, so if you have more data than that on your 3Mb SPIFFS it
-        will fail.
+        will fail.  When the target partition does not overlap the one of the sketch, files are copied
+        straight across instead.
 
 */
 
@@ -40,6 +41,14 @@ const char* password = STAPSK;
 
 
 bool migrateFS() {
+  fstools.setProgressCallback([](const char* path, uint32_t done, uint32_t total) {
+    Serial.printf_P(PSTR("%3u%% %s\n"), total ? (unsigned)(100ULL * done / total) : 100, path);
+  });
+  //  Finishes a move cut by a reset, while the files were copied back from the temporary FS
+  if (fstools.resumeMoveFS(LittleFS, TARGET_FS_LAYOUT)) {
+    Serial.println(F("FileSystem move resumed"));
+    return true;
+  }
   if (!fstools.attemptToMountFS(LittleFS)) {  //  Attempts to mount LittleFS without autoformat...
     Serial.println(F("Default FS not found"));
     if (fstools.mountAlternativeFS(FST::SPIFFS /* FST::LITTLEFS */, TARGET_FS_LAYOUT, true)) {
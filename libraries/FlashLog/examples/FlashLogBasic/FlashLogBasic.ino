@@ -0,0 +1,39 @@
+/*
+  Logs a line every second into the filesystem region of the flash, which
+  this sketch does not use as a filesystem, and prints the log on boot.
+
+  Select a "Flash Size" with an FS of a few sectors or more.  Anything in
+  that region (a LittleFS or SPIFFS image) is erased on the first run.
+
+  Released to the public domain
+*/
+
+#include <FlashLog.h>
+
+FlashLog flashLog(FS_PHYS_ADDR, FS_PHYS_SIZE);
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  if (!flashLog.begin()) {
+    Serial.println("No room for a log, select a flash size with an FS");
+    return;
+  }
+  Serial.printf("Log of %u sectors:\n", (unsigned)flashLog.sectors());
+  char line[FLASHLOG_RECORD_MAX + 1];
+  int len;
+  while ((len = flashLog.next(line, sizeof(line) - 1)) >= 0) {
+    line[len] = 0;
+    Serial.println(line);
+  }
+  flashLog.append(String("boot, reason: ") + ESP.getResetReason());
+}
+
+void loop() {
+  static uint32_t last = 0;
+  if (millis() - last >= 1000) {
+    last = millis();
+    flashLog.append(String("up ") + last / 1000 + "s, heap " + ESP.getFreeHeap());
+  }
+}
@@ -0,0 +1,216 @@
+/*
+ FlashLog.cpp - Crash-safe circular log of records on a raw flash partition
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <Arduino.h>
+#include <coredecls.h>
+#include "FlashLog.h"
+#include "debug.h"
+
+FlashLog::FlashLog(uint32_t start, uint32_t size)
+    : _start(start), _count(size / FLASH_SECTOR_SIZE), _ready(false), _head(0), _headSeq(0),
+      _offset(0), _oldest(0), _readSector(0), _readOffset(0) {
+    if (start % FLASH_SECTOR_SIZE) {
+        DEBUGV("FlashLog: start 0x%08x is not on a sector\n", start);
+        _count = 0;
+    }
+}
+
+bool FlashLog::_header(uint32_t sector, uint32_t& seq) const {
+    uint32_t header[3];
+    if (flash_hal_read(_addr(sector, 0), sizeof(header), reinterpret_cast<uint8_t *>(header)) != FLASH_HAL_OK) {
+        return false;
+    }
+    seq = header[1];
+    return (header[0] == Magic) && (header[2] == ~header[1]);
+}
+
+bool FlashLog::begin() {
+    _ready = false;
+    if (_count < 2) {
+        return false;
+    }
+    bool found = false;
+    for (uint32_t i = 0; i < _count; i++) {
+        uint32_t seq;
+        if (_header(i, seq) && (!found || ((int32_t)(seq - _headSeq) > 0))) {
+            _head = i;
+            _headSeq = seq;
+            found = true;
+        }
+    }
+    if (!found) {
+        DEBUGV("FlashLog: no log, formatting\n");
+        return format();
+    }
+
+    // The sectors before the newest one in turn, as long as they follow it
+    _oldest = _head;
+    for (uint32_t n = 1; n < _count; n++) {
+        uint32_t prev = (_head + _count - n) % _count;
+        uint32_t seq;
+        if (!_header(prev, seq) || (seq != _headSeq - n)) {
+            break;
+        }
+        _oldest = prev;
+    }
+
+    // Only the record lengths of the newest sector are read
+    _offset = HeaderSize;
+    while (_offset + 8 <= FLASH_SECTOR_SIZE) {
+        uint32_t word;
+        if (!_readWord(_head, _offset, word)) {
+            return false;
+        }
+        if (word == Erased) {
+            break;
+        }
+        if (!_lengthValid(word, _offset)) {
+            // Cut by a reset, nothing after it can be trusted to be erased
+            _offset = FLASH_SECTOR_SIZE;
+            break;
+        }
+        _offset += _recordSize(word & 0xffff);
+    }
+    _ready = true;
+    rewind();
+    return true;
+}
+
+bool FlashLog::format() {
+    _ready = false;
+    if (_count < 2) {
+        return false;
+    }
+    for (uint32_t i = 0; i < _count; i++) {
+        if (flash_hal_erase(_addr(i, 0), FLASH_SECTOR_SIZE) != FLASH_HAL_OK) {
+            return false;
+        }
+    }
+    if (!_startSector(0, 1)) {
+        return false;
+    }
+    _head = 0;
+    _headSeq = 1;
+    _offset = HeaderSize;
+    _oldest = 0;
+    _ready = true;
+    rewind();
+    return true;
+}
+
+bool FlashLog::_startSector(uint32_t sector, uint32_t seq) {
+    if (flash_hal_erase(_addr(sector, 0), FLASH_SECTOR_SIZE) != FLASH_HAL_OK) {
+        return false;
+    }
+    uint32_t header[4] = { Magic, seq, ~seq, Erased };
+    return flash_hal_write(_addr(sector, 0), sizeof(header), reinterpret_cast<const uint8_t *>(header)) == FLASH_HAL_OK;
+}
+
+bool FlashLog::_nextSector() {
+    uint32_t next = (_head + 1) % _count;
+    if (!_startSector(next, _headSeq + 1)) {
+        return false;
+    }
+    _head = next;
+    _headSeq++;
+    _offset = HeaderSize;
+    if (next == _oldest) {
+        _oldest = (next + 1) % _count;
+        if (_readSector == next) {
+            _readSector = _oldest;
+            _readOffset = HeaderSize;
+        }
+    }
+    return true;
+}
+
+bool FlashLog::append(const void *data, size_t len) {
+    if (!_ready || (len > FLASHLOG_RECORD_MAX) || (len && !data)) {
+        return false;
+    }
+    uint32_t size = _recordSize(len);
+    if ((_offset + size > FLASH_SECTOR_SIZE) && !_nextSector()) {
+        return false;
+    }
+    uint32_t at = _offset;
+    // Whatever happens next, this space is not erased any more
+    _offset += size;
+
+    // The length first: a record cut after it only fails its CRC, without
+    // it begin() would take the data written for the next length
+    uint32_t header[2] = { (uint32_t)(len | ((~len & 0xffff) << 16)), crc32(data, len) };
+    if (flash_hal_write(_addr(_head, at), sizeof(header), reinterpret_cast<const uint8_t *>(header)) != FLASH_HAL_OK) {
+        _offset = FLASH_SECTOR_SIZE;
+        return false;
+    }
+    return !len || (flash_hal_write(_addr(_head, at + 8), len, static_cast<const uint8_t *>(data)) == FLASH_HAL_OK);
+}
+
+void FlashLog::rewind() {
+    _readSector = _oldest;
+    _readOffset = HeaderSize;
+}
+
+int FlashLog::next(void *buf, size_t size) {
+    if (!_ready || (size && !buf)) {
+        return -1;
+    }
+    while (true) {
+        if ((_readSector == _head) && (_readOffset >= _offset)) {
+            return -1;
+        }
+        uint32_t word;
+        if ((_readOffset + 8 > FLASH_SECTOR_SIZE) || !_readWord(_readSector, _readOffset, word)
+                || (word == Erased) || !_lengthValid(word, _readOffset)) {
+            if (_readSector == _head) {
+                return -1;
+            }
+            _readSector = (_readSector + 1) % _count;
+            _readOffset = HeaderSize;
+            continue;
+        }
+        uint32_t len = word & 0xffff;
+        uint32_t at = _readOffset;
+        _readOffset += _recordSize(len);
+
+        uint32_t stored;
+        if (!_readWord(_readSector, at + 4, stored)) {
+            return -1;
+        }
+        // The part of the record beyond size is checked all the same
+        uint32_t copied = std::min((uint32_t)size, len);
+        if (copied && (flash_hal_read(_addr(_readSector, at + 8), copied, static_cast<uint8_t *>(buf)) != FLASH_HAL_OK)) {
+            return -1;
+        }
+        uint32_t crc = crc32(buf, copied);
+        for (uint32_t done = copied; done < len; ) {
+            uint8_t chunk[32];
+            uint32_t n = std::min((uint32_t)sizeof(chunk), len - done);
+            if (flash_hal_read(_addr(_readSector, at + 8 + done), n, chunk) != FLASH_HAL_OK) {
+                return -1;
+            }
+            crc = crc32(chunk, n, crc);
+            done += n;
+        }
+        if (crc == stored) {
+            return len;
+        }
+        DEBUGV("FlashLog: bad record at 0x%08x\n", _addr(_readSector, at));
+    }
+}
@@ -0,0 +1,119 @@
+/*
+ FlashLog.h - Crash-safe circular log of records on a raw flash partition
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __FLASHLOG_H
+#define __FLASHLOG_H
+
+#include <Arduino.h>
+#include <flash_hal.h>
+#include <spi_flash_geometry.h>
+
+/*
+  Flash layout, all words little endian:
+
+    sector   header: magic "FLG1", sequence number, its complement, 0xffffffff
+             records, each one word aligned
+             0xff up to the end of the sector
+    record   length in the low half word, its complement in the high one,
+             CRC32 of the data, the data padded to a word
+
+  Sectors are filled in turn, the next after the last being the first, and
+  numbered as they are started so that begin() finds the newest one by
+  reading the headers only.  When all are used, starting the next sector
+  erases the oldest records.
+
+  A record cut by a reset, half written, is either left alone by the readers
+  (bad CRC) or, when its length word is damaged, ends its sector.  Appends go
+  on after it, nothing is ever written twice between two erases.
+*/
+
+// Longest record, one per sector
+#define FLASHLOG_RECORD_MAX (FLASH_SECTOR_SIZE - 16 - 8)
+
+class FlashLog
+{
+public:
+    // start and size in bytes from the start of the flash, whole sectors, at
+    // least 2 of them, for instance FS_PHYS_ADDR and FS_PHYS_SIZE in a sketch
+    // that has no filesystem
+    FlashLog(uint32_t start, uint32_t size);
+
+    // Finds the end of the log, formats the partition when it holds none.
+    // Rewinds the reader
+    bool begin();
+    // Erases every sector of the partition
+    bool format();
+
+    // Adds a record of len bytes, up to FLASHLOG_RECORD_MAX.  Takes two flash
+    // writes, plus a sector erase (~40ms) once per sector
+    bool append(const void *data, size_t len);
+    bool append(const String& s) {
+        return append(s.c_str(), s.length());
+    }
+
+    // Reader, from the oldest record to the newest.  When appends erase the
+    // sector being read, reading goes on with the oldest record left
+    void rewind();
+    // Copies the next intact record to buf, cut to size bytes, and returns its
+    // length.  -1 when there are no more records
+    int next(void *buf, size_t size);
+
+    size_t sectors() const {
+        return _count;
+    }
+
+protected:
+    static constexpr uint32_t Magic = 0x31474c46; // "FLG1"
+    static constexpr uint32_t HeaderSize = 16;
+    static constexpr uint32_t Erased = 0xffffffff;
+
+    static uint32_t _recordSize(uint32_t len) {
+        return 8 + ((len + 3) & ~3);
+    }
+    static bool _lengthValid(uint32_t word, uint32_t offset) {
+        uint32_t len = word & 0xffff;
+        return ((word >> 16) == (~len & 0xffff)) && (offset + _recordSize(len) <= FLASH_SECTOR_SIZE);
+    }
+
+    uint32_t _addr(uint32_t sector, uint32_t offset) const {
+        return _start + sector * FLASH_SECTOR_SIZE + offset;
+    }
+    bool _readWord(uint32_t sector, uint32_t offset, uint32_t& word) const {
+        return flash_hal_read(_addr(sector, offset), 4, reinterpret_cast<uint8_t *>(&word)) == FLASH_HAL_OK;
+    }
+    // Sequence number of a sector whose header is intact
+    bool _header(uint32_t sector, uint32_t& seq) const;
+    bool _startSector(uint32_t sector, uint32_t seq);
+    // Erases the sector after the head and makes it the new head
+    bool _nextSector();
+
+    uint32_t _start;
+    uint32_t _count;        // sectors
+    bool     _ready;
+
+    uint32_t _head;         // sector being appended to
+    uint32_t _headSeq;
+    uint32_t _offset;       // where the next record goes in the head
+    uint32_t _oldest;       // first sector holding records
+
+    uint32_t _readSector;
+    uint32_t _readOffset;
+};
+
+#endif // !defined(__FLASHLOG_H)
@@ -8,6 +8,7 @@ void setup() {
 
 void loop() {
   static uint32_t cnt = 0;
+  GDBSTUB_TRACE(1, cnt);  // read with gdbstub-trace, see gdbcmds
   Serial.printf("%d\n", cnt++);
   delay(100);
 }
@@ -34,6 +34,25 @@ void gdbstub_hook_enable_tx_pin_uart0(uint8_t pin);
 void gdbstub_hook_enable_rx_pin_uart0(uint8_t pin);
 #endif
 
+#if GDBSTUB_TRACE_ENTRIES
+//Tracepoints: each call records the caller's pc and sp, the cycle count, an id and a value in a ring
+//buffer, without stopping. Callable from interrupts and with the flash disabled. Ids 0 to 31 can be
+//muted with gdbstub_trace_enable(), the others are always recorded. The last GDBSTUB_TRACE_ENTRIES
+//are read from gdb with the gdbstub-trace command of gdbcmds, once stopped.
+void gdbstub_trace(uint8_t id, uint32_t value);
+//The same, also copying GDBSTUB_TRACE_MEM bytes of RAM from mem (word aligned)
+void gdbstub_trace_mem(uint8_t id, uint32_t value, const void* mem);
+//Bit n of mask enables id n, all by default
+void gdbstub_trace_enable(uint32_t mask);
+void gdbstub_trace_clear();
+//Number of entries recorded since the start or gdbstub_trace_clear(), lost ones included
+uint32_t gdbstub_trace_count();
+
+#define GDBSTUB_TRACE(id, value) gdbstub_trace((id), (uint32_t)(value))
+#else
+#define GDBSTUB_TRACE(id, value) do { (void)(value); } while (0)
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -54,6 +54,23 @@ breaking in the init routine; use the gdb 'c' command (continue) to start the pr
 #define GDBSTUB_BREAK_ON_INIT 0
 #endif
 
+/*
+Number of entries kept by the tracepoints (see gdbstub_trace()), in a ring buffer of 20 bytes per entry
+plus GDBSTUB_TRACE_MEM. Tracepoints record and let the program run, so they are usable where stopping
+the CPU isn't, eg with WiFi traffic going on. Set to 0 to leave them out.
+*/
+#ifndef GDBSTUB_TRACE_ENTRIES
+#define GDBSTUB_TRACE_ENTRIES 64
+#endif
+
+/*
+Bytes of memory copied into each trace entry, from the address given to gdbstub_trace_mem(). A multiple
+of 4.
+*/
+#ifndef GDBSTUB_TRACE_MEM
+#define GDBSTUB_TRACE_MEM 8
+#endif
+
 /*
 Function attributes for function types.
 Gdbstub functions are placed in flash or IRAM using attributes, as defined here. The gdbinit function
@@ -115,6 +115,77 @@ bool gdbstub_has_uart_isr_control() {
 #endif
 }
 
+#if GDBSTUB_TRACE_ENTRIES
+//Tracepoints ring buffer, read by the gdbstub-trace command of gdbcmds. gdbstub_trace_next is the
+//entry written next, the oldest one once gdbstub_trace_hits reaches GDBSTUB_TRACE_ENTRIES.
+struct gdbstub_trace_entry {
+	uint32_t ccount;
+	uint32_t pc;	//return address of the gdbstub_trace call
+	uint32_t sp;
+	uint32_t id;
+	uint32_t value;
+#if GDBSTUB_TRACE_MEM
+	uint32_t mem[GDBSTUB_TRACE_MEM / 4];
+#endif
+};
+
+struct gdbstub_trace_entry gdbstub_trace_buf[GDBSTUB_TRACE_ENTRIES];
+uint32_t gdbstub_trace_next = 0;
+uint32_t gdbstub_trace_hits = 0;
+uint32_t gdbstub_trace_mask = 0xffffffff;
+
+static inline __attribute__((always_inline)) void traceRecord(uint8_t id, uint32_t value, const void* mem, void* pc) {
+	if (id < 32 && (gdbstub_trace_mask & (1u << id)) == 0) {
+		return;
+	}
+	uint32_t sp;
+	__asm__ __volatile__ ("mov %0, a1" : "=a" (sp));
+	uint32_t ps = xt_rsil(15);
+	struct gdbstub_trace_entry *e = &gdbstub_trace_buf[gdbstub_trace_next];
+	//No modulo: __umodsi3 is in flash
+	if (++gdbstub_trace_next == GDBSTUB_TRACE_ENTRIES) {
+		gdbstub_trace_next = 0;
+	}
+	gdbstub_trace_hits++;
+	e->ccount = esp_get_cycle_count();
+	e->pc = (uint32_t)pc;
+	e->sp = sp;
+	e->id = id;
+	e->value = value;
+#if GDBSTUB_TRACE_MEM
+	for (int i = 0; i < GDBSTUB_TRACE_MEM / 4; i++) {
+		e->mem[i] = mem ? ((const uint32_t*)mem)[i] : 0;
+	}
+#else
+	(void) mem;
+#endif
+	xt_wsr_ps(ps);
+}
+
+void ATTR_GDBFN gdbstub_trace(uint8_t id, uint32_t value) {
+	traceRecord(id, value, NULL, __builtin_return_address(0));
+}
+
+void ATTR_GDBFN gdbstub_trace_mem(uint8_t id, uint32_t value, const void* mem) {
+	traceRecord(id, value, mem, __builtin_return_address(0));
+}
+
+void ATTR_GDBEXTERNFN gdbstub_trace_enable(uint32_t mask) {
+	gdbstub_trace_mask = mask;
+}
+
+void ATTR_GDBEXTERNFN gdbstub_trace_clear() {
+	uint32_t ps = xt_rsil(15);
+	gdbstub_trace_next = 0;
+	gdbstub_trace_hits = 0;
+	xt_wsr_ps(ps);
+}
+
+uint32_t ATTR_GDBEXTERNFN gdbstub_trace_count() {
+	return gdbstub_trace_hits;
+}
+#endif
+
 //Small function to feed the hardware watchdog. Needed to stop the ESP from resetting
 //due to a watchdog timeout while reading a command.
 static void ATTR_GDBFN keepWDTalive() {
@@ -0,0 +1,147 @@
+/*
+  MultiDigest.cpp - MD5, SHA-1 and SHA-256 of the same data in one pass
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <Arduino.h>
+#include <Crypto.h>
+#include <memory>
+
+#include "MultiDigest.h"
+
+void MultiDigest::begin() {
+    if (_digests & MD5) {
+        MD5Init(&_md5);
+    }
+    if (_digests & SHA1) {
+        br_sha1_init(&_sha1);
+    }
+    if (_digests & SHA256) {
+#if CRYPTO_OPTIMIZED_KERNELS
+        experimental::crypto::sha256Init(&_sha256);
+#else
+        br_sha256_init(&_sha256);
+#endif
+    }
+}
+
+void MultiDigest::add(const void *data, size_t len) {
+    if (_digests & MD5) {
+        // MD5Update() takes at most 64KB at once
+        const uint8_t *bytes = (const uint8_t *)data;
+        for (size_t left = len; left; ) {
+            uint16_t piece = std::min(left, (size_t)0x8000);
+            MD5Update(&_md5, bytes, piece);
+            bytes += piece;
+            left -= piece;
+        }
+    }
+    if (_digests & SHA1) {
+        br_sha1_update(&_sha1, data, len);
+    }
+    if (_digests & SHA256) {
+        _sha256.vtable->update(&_sha256.vtable, data, len);
+    }
+}
+
+bool MultiDigest::addStream(Stream &stream, size_t maxLen) {
+    if (stream.hasPeekBufferAPI()) {
+        size_t avail;
+        while (maxLen && (avail = stream.peekAvailable())) {
+            size_t len = std::min(avail, maxLen);
+            add(stream.peekBuffer(), len);
+            stream.peekConsume(len);
+            maxLen -= len;
+            yield();      // time for network streams
+        }
+        return true;
+    }
+
+    const size_t buf_size = 512;
+    auto buf = std::unique_ptr<uint8_t[]>{new(std::nothrow) uint8_t[buf_size]};
+    if (!buf) {
+        return false;
+    }
+
+    int bytesAvailable;
+    while (maxLen && (bytesAvailable = stream.available()) > 0) {
+        size_t readBytes = std::min({(size_t)bytesAvailable, maxLen, buf_size});
+        int numBytesRead = stream.readBytes(buf.get(), readBytes);
+        if (numBytesRead < 1) {
+            return false;
+        }
+        add(buf.get(), numBytesRead);
+        maxLen -= numBytesRead;
+        yield();      // time for network streams
+    }
+    return true;
+}
+
+void MultiDigest::calculate() {
+    if (_digests & MD5) {
+        MD5Final(_md5Bytes, &_md5);
+    }
+    if (_digests & SHA1) {
+        br_sha1_out(&_sha1, _sha1Bytes);
+    }
+    if (_digests & SHA256) {
+        _sha256.vtable->out(&_sha256.vtable, _sha256Bytes);
+    }
+}
+
+size_t MultiDigest::length(uint8_t digest) {
+    switch (digest) {
+    case MD5:
+        return 16;
+    case SHA1:
+        return 20;
+    case SHA256:
+        return 32;
+    }
+    return 0;
+}
+
+const uint8_t *MultiDigest::getBytes(uint8_t digest) const {
+    if (!(_digests & digest)) {
+        return nullptr;
+    }
+    switch (digest) {
+    case MD5:
+        return _md5Bytes;
+    case SHA1:
+        return _sha1Bytes;
+    case SHA256:
+        return _sha256Bytes;
+    }
+    return nullptr;
+}
+
+String MultiDigest::toString(uint8_t digest) const {
+    const uint8_t *bytes = getBytes(digest);
+    String hex;
+    if (!bytes) {
+        return hex;
+    }
+    const size_t len = length(digest);
+    hex.reserve(len * 2);
+    for (size_t i = 0; i < len; i++) {
+        char byte[3];
+        sprintf(byte, "%02x", bytes[i]);
+        hex += byte;
+    }
+    return hex;
+}
@@ -0,0 +1,73 @@
+/*
+  MultiDigest.h - MD5, SHA-1 and SHA-256 of the same data in one pass
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef MULTIDIGEST_H_
+#define MULTIDIGEST_H_
+
+#include <WString.h>
+#include <Stream.h>
+#include <md5.h>
+#include <bearssl/bearssl_hash.h>
+
+// Computes the selected digests over the same data, updating all of them
+// from each buffer so that a stream (e.g. a firmware image needing an MD5
+// and a SHA-256) is read only once.
+//
+//   MultiDigest digest(MultiDigest::MD5 | MultiDigest::SHA256);
+//   digest.begin();
+//   digest.addStream(file, file.size());
+//   digest.calculate();
+//   Serial.println(digest.toString(MultiDigest::SHA256));
+class MultiDigest {
+  public:
+    enum : uint8_t {
+      MD5 = 1,
+      SHA1 = 2,
+      SHA256 = 4,
+    };
+
+    explicit MultiDigest(uint8_t digests = MD5 | SHA256) : _digests(digests) {}
+
+    void begin();
+    void add(const void *data, size_t len);
+    void add(const char *data) { add(data, strlen(data)); }
+    void add(const String &data) { add(data.c_str(), data.length()); }
+    // Hashes up to maxLen bytes, as long as the stream has some available.
+    // Streams with the peek buffer API are hashed in place, without a copy.
+    bool addStream(Stream &stream, size_t maxLen);
+    void calculate();
+
+    // Length in bytes of one of the digests
+    static size_t length(uint8_t digest);
+    // After calculate(), the bytes of one of the selected digests, nullptr otherwise
+    const uint8_t *getBytes(uint8_t digest) const;
+    // Lowercase hex, empty when the digest was not selected
+    String toString(uint8_t digest) const;
+
+  private:
+    uint8_t _digests;
+    md5_context_t _md5;
+    br_sha1_context _sha1;
+    br_sha256_context _sha256;
+    uint8_t _md5Bytes[16];
+    uint8_t _sha1Bytes[20];
+    uint8_t _sha256Bytes[32];
+};
+
+#endif /* MULTIDIGEST_H_ */
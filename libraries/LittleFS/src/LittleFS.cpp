@@ -27,6 +27,7 @@
 #include "LittleFS.h"
 #include "debug.h"
 #include "flash_hal.h"
+#include "Schedule.h"
 
 extern "C" {
 #include "c_types.h"
@@ -174,6 +175,7 @@ int LittleFSImpl::lfs_flash_read(const struct lfs_config *c,
 int LittleFSImpl::lfs_flash_prog(const struct lfs_config *c,
     lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size) {
     LittleFSImpl *me = reinterpret_cast<LittleFSImpl*>(c->context);
+    me->_setErased(block, false);
     uint32_t addr = me->_start + (block * me->_blockSize) + off;
     const uint8_t *src = reinterpret_cast<const uint8_t *>(buffer);
     return flash_hal_write(addr, size, static_cast<const uint8_t*>(src)) == FLASH_HAL_OK ? 0 : -1;
@@ -183,7 +185,16 @@ int LittleFSImpl::lfs_flash_erase(const struct lfs_config *c, lfs_block_t block)
     LittleFSImpl *me = reinterpret_cast<LittleFSImpl*>(c->context);
     uint32_t addr = me->_start + (block * me->_blockSize);
     uint32_t size = me->_blockSize;
-    return flash_hal_erase(addr, size) == FLASH_HAL_OK ? 0 : -1;
+    me->_lastErase = block;
+    if (me->_isErased(block)) {
+        // Erased in the background, and not written since
+        me->_setErased(block, false);
+        me->_eraseAheadSchedule();
+        return 0;
+    }
+    int rc = flash_hal_erase(addr, size) == FLASH_HAL_OK ? 0 : -1;
+    me->_eraseAheadSchedule();
+    return rc;
 }
 
 int LittleFSImpl::lfs_flash_sync(const struct lfs_config *c) {
@@ -192,6 +203,82 @@ int LittleFSImpl::lfs_flash_sync(const struct lfs_config *c) {
     return 0;
 }
 
+void LittleFSImpl::_setErased(lfs_block_t block, bool erased) {
+    if (!_erased || (_isErased(block) == erased)) {
+        return;
+    }
+    _erased[block / 8] ^= 1 << (block % 8);
+    if (erased) {
+        _erasedCount++;
+    } else {
+        _erasedCount--;
+    }
+}
+
+void LittleFSImpl::_eraseAheadReset() {
+    // What was erased may have been written since, by format() or another image
+    _erased.reset();
+    _erasedCount = 0;
+    if (_mounted && _cfg._eraseAhead) {
+        size_t bytes = (_lfs_cfg.block_count + 7) / 8;
+        _erased.reset(new (std::nothrow) uint8_t[bytes]);
+        if (_erased) {
+            memset(_erased.get(), 0, bytes);
+        }
+    }
+}
+
+void LittleFSImpl::_eraseAheadSchedule() {
+    if (_eraseScheduled || !_mounted || !_erased || !_self || (_erasedCount >= _cfg._eraseAhead)) {
+        return;
+    }
+    std::weak_ptr<LittleFSImpl*> weak = _self;
+    _eraseScheduled = schedule_function([weak]() {
+        std::shared_ptr<LittleFSImpl*> self = weak.lock();
+        if (!self) {
+            return;
+        }
+        LittleFSImpl *me = *self;
+        me->_eraseScheduled = false;
+        if (me->_eraseAheadStep()) {
+            me->_eraseAheadSchedule();
+        }
+    });
+}
+
+bool LittleFSImpl::_eraseAheadStep() {
+    if (!_mounted || !_erased || (_erasedCount >= _cfg._eraseAhead)) {
+        return false;
+    }
+    const lfs_block_t count = _lfs_cfg.block_count;
+    // Blocks in use, including those of the files open for writing
+    std::unique_ptr<uint8_t[]> used(new (std::nothrow) uint8_t[(count + 7) / 8]);
+    if (!used) {
+        return false;
+    }
+    memset(used.get(), 0, (count + 7) / 8);
+    int rc = lfs_fs_traverse(&_lfs, [](void *data, lfs_block_t block) -> int {
+        static_cast<uint8_t*>(data)[block / 8] |= 1 << (block % 8);
+        return 0;
+    }, used.get());
+    if (rc < 0) {
+        DEBUGV("lfs_fs_traverse: rc=%d\n", rc);
+        return false;
+    }
+    for (lfs_block_t i = 1; i <= count; i++) {
+        lfs_block_t block = (_lastErase + i) % count;
+        if ((used[block / 8] & (1 << (block % 8))) || _isErased(block)) {
+            continue;
+        }
+        if (flash_hal_erase(_start + block * _blockSize, _blockSize) != FLASH_HAL_OK) {
+            return false;
+        }
+        _setErased(block, true);
+        return _erasedCount < _cfg._eraseAhead;
+    }
+    return false; // No free blocks left to erase
+}
+
 
 }; // namespace
 
@@ -27,12 +27,15 @@
 #ifndef __LITTLEFS_H
 #define __LITTLEFS_H
 
+#include <algorithm>
 #include <limits>
+#include <new>
 #include <FS.h>
 #include <FSImpl.h>
 #include <debug.h>
 #include <flash_utils.h>
 #include <flash_hal.h>
+#include <umm_malloc/umm_heap_select.h>
 
 #define LFS_NAME_MAX 32
 #include "../lib/littlefs/lfs.h"
@@ -48,7 +51,89 @@ class LittleFSConfig : public FSConfig
 {
 public:
     static constexpr uint32_t FSId = 0x4c495454;
-    LittleFSConfig(bool autoFormat = true) : FSConfig(FSId, autoFormat) { }
+    LittleFSConfig(bool autoFormat = true) : FSConfig(FSId, autoFormat), _readSize(64), _progSize(64),
+        _cacheSize(64), _lookaheadSize(64), _writeBufferSize(0), _eraseAhead(0) { }
+
+    enum Preset {
+        PRESET_DEFAULT,   // 64 byte caches, the smallest RAM footprint
+        PRESET_LOGGING,   // 256 byte caches and 512 byte file buffers for appends
+        PRESET_STREAMING  // 256 byte reads into 512 byte caches for large sequential reads
+    };
+
+    LittleFSConfig setAutoFormat(bool val = true) {
+        _autoFormat = val;
+        return *this;
+    }
+    // Smallest flash read, the cache size must be a multiple of it
+    LittleFSConfig setReadSize(uint16_t size) {
+        _readSize = size;
+        return *this;
+    }
+    // Smallest flash program, which also aligns the metadata commits on flash,
+    // so only change it together with a format()
+    LittleFSConfig setProgSize(uint16_t size) {
+        _progSize = size;
+        return *this;
+    }
+    // Size of the read cache, the program cache and of the cache of each open
+    // file.  A multiple of the read and program sizes dividing the block size
+    LittleFSConfig setCacheSize(uint16_t size) {
+        _cacheSize = size;
+        return *this;
+    }
+    // Bytes of the free block bitmap scanned at once, a multiple of 8
+    LittleFSConfig setLookaheadSize(uint16_t size) {
+        _lookaheadSize = size;
+        return *this;
+    }
+    // RAM buffer gathering the small writes of each file opened for writing
+    // before they are handed to LittleFS in one piece, 0 writes through
+    LittleFSConfig setWriteBufferSize(uint16_t size) {
+        _writeBufferSize = size;
+        return *this;
+    }
+    // Free blocks to keep erased in the background (from the scheduler, one
+    // block per loop()) so that writes needing a fresh block do not wait the
+    // ~40ms of its erase.  Only the blocks LittleFS would allocate next are
+    // erased, 0 disables it
+    LittleFSConfig setEraseAhead(uint16_t blocks) {
+        _eraseAhead = blocks;
+        return *this;
+    }
+    LittleFSConfig setPreset(Preset preset) {
+        switch (preset) {
+        case PRESET_LOGGING:
+            _readSize = 64;
+            _progSize = 64;
+            _cacheSize = 256;
+            _lookaheadSize = 64;
+            _writeBufferSize = 512;
+            break;
+        case PRESET_STREAMING:
+            _readSize = 256;
+            _progSize = 64;
+            _cacheSize = 512;
+            _lookaheadSize = 64;
+            _writeBufferSize = 0;
+            break;
+        default:
+            _readSize = 64;
+            _progSize = 64;
+            _cacheSize = 64;
+            _lookaheadSize = 64;
+            _writeBufferSize = 0;
+            break;
+        }
+        return *this;
+    }
+
+    // Inherit _type and _autoFormat
+    uint16_t _readSize;
+    uint16_t _progSize;
+    uint16_t _cacheSize;
+    uint16_t _lookaheadSize;
+    uint16_t _writeBufferSize;
+    uint16_t _eraseAhead;
 };
 
 class LittleFSImpl : public FSImpl
@@ -56,7 +141,7 @@ class LittleFSImpl : public FSImpl
 public:
     LittleFSImpl(uint32_t start, uint32_t size, uint32_t pageSize, uint32_t blockSize, uint32_t maxOpenFds)
         : _start(start) , _size(size) , _pageSize(pageSize) , _blockSize(blockSize) , _maxOpenFds(maxOpenFds),
-          _mounted(false) {
+          _mounted(false), _erasedCount(0), _lastErase(0), _eraseScheduled(false) {
         memset(&_lfs, 0, sizeof(_lfs));
         memset(&_lfs_cfg, 0, sizeof(_lfs_cfg));
         if (_size && _blockSize) {
@@ -65,13 +150,13 @@ public:
             _lfs_cfg.prog = lfs_flash_prog;
             _lfs_cfg.erase = lfs_flash_erase;
             _lfs_cfg.sync = lfs_flash_sync;
-            _lfs_cfg.read_size = 64;
-            _lfs_cfg.prog_size = 64;
+            _lfs_cfg.read_size = _cfg._readSize;
+            _lfs_cfg.prog_size = _cfg._progSize;
             _lfs_cfg.block_size =  _blockSize;
             _lfs_cfg.block_count = _size / _blockSize;
             _lfs_cfg.block_cycles = 16; // TODO - need better explanation
-            _lfs_cfg.cache_size = 64;
-            _lfs_cfg.lookahead_size = 64;
+            _lfs_cfg.cache_size = _cfg._cacheSize;
+            _lfs_cfg.lookahead_size = _cfg._lookaheadSize;
             _lfs_cfg.read_buffer = nullptr;
             _lfs_cfg.prog_buffer = nullptr;
             _lfs_cfg.lookahead_buffer = nullptr;
@@ -85,6 +170,7 @@ public:
         if (_mounted) {
             lfs_unmount(&_lfs);
         }
+        free(_lfs_cfg.lookahead_buffer);
     }
 
     FileImplPtr open(const char* path, OpenMode openMode, AccessMode accessMode) override;
@@ -178,8 +264,28 @@ public:
         if ((cfg._type != LittleFSConfig::FSId) || _mounted) {
             return false;
         }
-        _cfg = *static_cast<const LittleFSConfig *>(&cfg);
-       return true;
+        const LittleFSConfig *lfsCfg = static_cast<const LittleFSConfig *>(&cfg);
+        // The geometry rules of lfs_init(), which would only assert them
+        if (!lfsCfg->_readSize || !lfsCfg->_progSize || !lfsCfg->_cacheSize
+                || (lfsCfg->_cacheSize % lfsCfg->_readSize) || (lfsCfg->_cacheSize % lfsCfg->_progSize)
+                || (_blockSize && (_blockSize % lfsCfg->_cacheSize))
+                || !lfsCfg->_lookaheadSize || (lfsCfg->_lookaheadSize % 8)) {
+            DEBUGV("LittleFS invalid cache geometry\n");
+            return false;
+        }
+        _cfg = *lfsCfg;
+        _lfs_cfg.read_size = _cfg._readSize;
+        _lfs_cfg.prog_size = _cfg._progSize;
+        _lfs_cfg.cache_size = _cfg._cacheSize;
+        if (_lfs_cfg.lookahead_size != _cfg._lookaheadSize) {
+            free(_lfs_cfg.lookahead_buffer);
+            _lfs_cfg.lookahead_buffer = nullptr;
+        }
+        _lfs_cfg.lookahead_size = _cfg._lookaheadSize;
+        if (_cfg._eraseAhead && !_self) {
+            _self = std::make_shared<LittleFSImpl*>(this);
+        }
+        return true;
     }
 
     bool begin() override {
@@ -205,6 +311,7 @@ public:
         }
         lfs_unmount(&_lfs);
         _mounted = false;
+        _eraseAheadReset();
     }
 
     bool format() override {
@@ -220,6 +327,7 @@ public:
         }
 
         memset(&_lfs, 0, sizeof(_lfs));
+        _allocLookahead();
         int rc = lfs_format(&_lfs, &_lfs_cfg);
         if (rc != 0) {
             DEBUGV("lfs_format: rc=%d\n", rc);
@@ -281,13 +389,25 @@ protected:
             _mounted = false;
         }
         memset(&_lfs, 0, sizeof(_lfs));
+        _allocLookahead();
         int rc = lfs_mount(&_lfs, &_lfs_cfg);
         if (rc==0) {
             _mounted = true;
+            _eraseAheadReset();
+            _eraseAheadSchedule();
         }
         return _mounted;
     }
 
+    // The lookahead bitmap is only accessed as 32-bit words, it can live in
+    // the IRAM heap and leave DRAM to the byte-wise read and prog caches.
+    // When this fails, LittleFS allocates it from the current heap.
+    void _allocLookahead() {
+        if (!_lfs_cfg.lookahead_buffer) {
+            _lfs_cfg.lookahead_buffer = malloc_intent(_lfs_cfg.lookahead_size, HeapIntent::LargeCold);
+        }
+    }
+
     int _getUsedBlocks() {
         if (!_mounted) {
             return 0;
@@ -343,6 +463,16 @@ protected:
     static int lfs_flash_erase(const struct lfs_config *c, lfs_block_t block);
     static int lfs_flash_sync(const struct lfs_config *c);
 
+    // Pool of erased free blocks, see LittleFSConfig::setEraseAhead()
+    bool _isErased(lfs_block_t block) const {
+        return _erased && (_erased[block / 8] & (1 << (block % 8)));
+    }
+    void _setErased(lfs_block_t block, bool erased);
+    void _eraseAheadReset();
+    void _eraseAheadSchedule();
+    // Erases the next free block, false when there is no need for more
+    bool _eraseAheadStep();
+
     lfs_t       _lfs;
     lfs_config  _lfs_cfg;
 
@@ -355,13 +485,20 @@ protected:
     uint32_t _maxOpenFds;
 
     bool     _mounted;
+
+    std::unique_ptr<uint8_t[]>     _erased;      // bitmap of the blocks known to be erased
+    uint32_t                       _erasedCount;
+    lfs_block_t                    _lastErase;   // LittleFS allocates the blocks after it next
+    bool                           _eraseScheduled;
+    std::shared_ptr<LittleFSImpl*> _self;        // tells the scheduled erase whether this still exists
 };
 
 
 class LittleFSFileImpl : public FileImpl
 {
 public:
-    LittleFSFileImpl(LittleFSImpl* fs, const char *name, std::shared_ptr<lfs_file_t> fd, int flags, time_t creation) : _fs(fs), _fd(fd), _opened(true), _flags(flags), _creation(creation) {
+    LittleFSFileImpl(LittleFSImpl* fs, const char *name, std::shared_ptr<lfs_file_t> fd, int flags, time_t creation) : _fs(fs), _fd(fd), _opened(true), _flags(flags), _creation(creation),
+        _wbufSize((flags & LFS_O_WRONLY) ? fs->_cfg._writeBufferSize : 0), _wbufLen(0) {
         _name = std::shared_ptr<char>(new char[strlen(name) + 1], std::default_delete<char[]>());
         strcpy(_name.get(), name);
     }
@@ -400,6 +537,22 @@ public:
         if (!_opened || !_fd || !buf) {
             return 0;
         }
+        if (size < _wbufSize) {
+            if (!_wbuf) {
+                _wbuf.reset(new (std::nothrow) uint8_t[_wbufSize]);
+                if (!_wbuf) {
+                    _wbufSize = 0; // Write through from now on
+                }
+            }
+            if (_wbuf && ((_wbufLen + size <= _wbufSize) || _drain())) {
+                memcpy(_wbuf.get() + _wbufLen, buf, size);
+                _wbufLen += size;
+                return size;
+            }
+        }
+        if (!_drain()) {
+            return 0;
+        }
         int result = lfs_file_write(_fs->getFS(), _getFD(), (void*) buf, size);
         if (result < 0) {
             DEBUGV("lfs_write rc=%d\n", result);
@@ -412,6 +565,7 @@ public:
         if (!_opened || !_fd | !buf) {
             return 0;
         }
+        _drain();
         int result = lfs_file_read(_fs->getFS(), _getFD(), (void*) buf, size);
         if (result < 0) {
             DEBUGV("lfs_read rc=%d\n", result);
@@ -425,6 +579,7 @@ public:
         if (!_opened || !_fd) {
             return;
         }
+        _drain();
         int rc = lfs_file_sync(_fs->getFS(), _getFD());
         if (rc < 0) {
             DEBUGV("lfs_file_sync rc=%d\n", rc);
@@ -435,6 +590,7 @@ public:
         if (!_opened || !_fd) {
             return false;
         }
+        _drain();
         int32_t offset = static_cast<int32_t>(pos);
         if (mode == SeekEnd) {
             offset = -offset; // TODO - this seems like its plain wrong vs. POSIX
@@ -456,6 +612,7 @@ public:
         if (!_opened || !_fd) {
             return 0;
         }
+        _drain();
         int result = lfs_file_tell(_fs->getFS(), _getFD());
         if (result < 0) {
             DEBUGV("lfs_file_tell rc=%d\n", result);
@@ -466,13 +623,18 @@ public:
     }
 
     size_t size() const override {
-        return (_opened && _fd)? lfs_file_size(_fs->getFS(), _getFD()) : 0;
+        if (!_opened || !_fd) {
+            return 0;
+        }
+        _drain();
+        return lfs_file_size(_fs->getFS(), _getFD());
     }
 
     bool truncate(uint32_t size) override {
         if (!_opened || !_fd) {
             return false;
         }
+        _drain();
         int rc = lfs_file_truncate(_fs->getFS(), _getFD(), size);
         if (rc < 0) {
             DEBUGV("lfs_file_truncate rc=%d\n", rc);
@@ -483,6 +645,8 @@ public:
 
     void close() override {
         if (_opened && _fd) {
+            _drain();
+            _wbuf.reset();
             lfs_file_close(_fs->getFS(), _getFD());
             _opened = false;
             DEBUGV("lfs_file_close: fd=%p\n", _getFD());
@@ -547,6 +711,36 @@ public:
         return (rc == 0) && (info.type == LFS_TYPE_REG);
     }
 
+    const uint8_t* mappedData(size_t& len) override {
+        len = 0;
+        // Small files are inlined in their directory's metadata
+        if (!_opened || !_fd || (_flags & LFS_O_WRONLY) || (_getFD()->flags & LFS_F_INLINE)) {
+            return nullptr;
+        }
+        const auto f = _getFD();
+        const auto fs = _fs->getFS();
+        size_t pos = position();
+        size_t sz = size();
+        if (pos >= sz) {
+            return nullptr;
+        }
+        // Reading a byte makes LittleFS find the block holding pos, past the skip-list
+        // pointers at its start the rest of the block is file data
+        uint8_t b;
+        if (lfs_file_read(fs, f, &b, 1) != 1) {
+            return nullptr;
+        }
+        lfs_block_t block = f->block;
+        lfs_off_t off = f->off - 1;
+        lfs_file_seek(fs, f, pos, LFS_SEEK_SET);
+        size_t span = std::min((size_t)(fs->cfg->block_size - off), sz - pos);
+        const uint8_t *data = flash_hal_mapped(_fs->_start + block * _fs->_blockSize + off, span);
+        if (data) {
+            len = span;
+        }
+        return data;
+    }
+
     bool isDirectory() const override {
         if (!_opened) {
             return false;
@@ -563,12 +757,30 @@ protected:
         return _fd.get();
     }
 
+    // Hand the buffered writes to LittleFS, false if they could not all be written
+    bool _drain() const {
+        if (!_wbufLen) {
+            return true;
+        }
+        int result = lfs_file_write(_fs->getFS(), _getFD(), _wbuf.get(), _wbufLen);
+        bool ok = (result == (int)_wbufLen);
+        if (!ok) {
+            DEBUGV("lfs_write (buffered) rc=%d\n", result);
+        }
+        _wbufLen = 0;
+        return ok;
+    }
+
     LittleFSImpl                *_fs;
     std::shared_ptr<lfs_file_t>  _fd;
     std::shared_ptr<char>        _name;
     bool                         _opened;
     int                          _flags;
     time_t                       _creation;
+    // Write-back buffer, invisible to readers hence drained by const calls
+    std::unique_ptr<uint8_t[]>   _wbuf;
+    size_t                       _wbufSize;
+    mutable size_t               _wbufLen;
 };
 
 class LittleFSDirImpl : public DirImpl
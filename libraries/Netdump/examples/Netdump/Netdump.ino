@@ -63,6 +63,11 @@ void startTcpDump() {
   // To tcpserver, all traffic.
   tcpServer.begin();
   nd.tcpDump(tcpServer);
+  // or only HTTP, the first 128 bytes of each packet:
+  // nd.setCaptureSize(8192, 128);
+  // nd.tcpDump(tcpServer, CaptureFilter().ipProtocol(CaptureFilter::TCP).port(80));
+  // or with a tcpdump-like expression:
+  // nd.tcpDump(tcpServer, FilterProgram("tcp port 80 and not host 192.168.4.2"));
 }
 
 void setup(void) {
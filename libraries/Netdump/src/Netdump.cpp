@@ -26,22 +26,19 @@
 namespace NetCapture
 {
 
-CallBackList<Netdump::LwipCallback> Netdump::lwipCallback;
+FixedCallBackList<Netdump::maxInstances, int, const char*, size_t, int, int> Netdump::lwipCallback;
 
 Netdump::Netdump()
 {
-    using namespace std::placeholders;
     phy_capture = capture;
-    lwipHandler = lwipCallback.add(std::bind(&Netdump::netdumpCapture, this, _1, _2, _3, _4, _5));
+    lwipCallback.add(netdumpCapture, this);
 };
 
 Netdump::~Netdump()
 {
+    lwipCallback.remove(netdumpCapture, this);
     reset();
-    if (packetBuffer)
-    {
-        delete[] packetBuffer;
-    }
+    delete[] ring;
 };
 
 void Netdump::setCallback(const Callback nc)
@@ -60,9 +57,21 @@ void Netdump::setFilter(const Filter nf)
     netDumpFilter = nf;
 }
 
+bool Netdump::setFilter(const FilterProgram& program)
+{
+    if (!program)
+    {
+        return false;
+    }
+    netDumpProgram = program;
+    return true;
+}
+
 void Netdump::reset()
 {
     setCallback(nullptr, nullptr);
+    netDumpProgram = FilterProgram();
+    tcpDumping = false;
 }
 
 void Netdump::printDump(Print& out, Packet::PacketDetail ndd, const Filter nf)
@@ -88,21 +97,55 @@ void Netdump::fileDump(File& outfile, const Filter nf)
 }
 bool Netdump::tcpDump(WiFiServer& tcpDumpServer, const Filter nf)
 {
-    if (!packetBuffer)
+    netDumpFilter    = nf;
+    tcpDumpRawFilter = false;
+    return tcpDumpStart(tcpDumpServer);
+}
+
+bool Netdump::tcpDump(WiFiServer& tcpDumpServer, const CaptureFilter& filter)
+{
+    netDumpFilter    = nullptr;
+    tcpDumpFilter    = filter;
+    tcpDumpRawFilter = true;
+    return tcpDumpStart(tcpDumpServer);
+}
+
+bool Netdump::tcpDump(WiFiServer& tcpDumpServer, const FilterProgram& program)
+{
+    return setFilter(program) && tcpDump(tcpDumpServer);
+}
+
+void Netdump::setCaptureSize(size_t newRingSize, uint16_t newSnapLen)
+{
+    if (!tcpDumping && newRingSize != ringSize)
+    {
+        delete[] ring;
+        ring     = nullptr;
+        ringSize = newRingSize;
+    }
+    snapLen = newSnapLen;
+}
+
+bool Netdump::tcpDumpStart(WiFiServer& tcpDumpServer)
+{
+    if (!ring)
     {
-        packetBuffer = new (std::nothrow) char[tcpBufferSize];
+        ring = new (std::nothrow) char[ringSize];
 
-        if (!packetBuffer)
+        if (!ring)
         {
             return false;
         }
     }
-    bufferIndex = 0;
+    netDumpCallback = nullptr;
+    tcpDumping      = false;
+    ringHead = ringTail = 0;
+    captureCounters     = { };
 
     schedule_function(
-        [&tcpDumpServer, this, nf]()
+        [&tcpDumpServer, this]()
         {
-            tcpDumpLoop(tcpDumpServer, nf);
+            tcpDumpLoop(tcpDumpServer);
         });
     return true;
 }
@@ -116,9 +159,22 @@ void Netdump::capture(int netif_idx, const char* data, size_t len, int out, int
     }
 }
 
+void Netdump::netdumpCapture(void* self, int netif_idx, const char* data, size_t len, int out, int success)
+{
+    static_cast<Netdump*>(self)->netdumpCapture(netif_idx, data, len, out, success);
+}
+
 void Netdump::netdumpCapture(int netif_idx, const char* data, size_t len, int out, int success)
 {
-    if (netDumpCallback)
+    if (!netDumpProgram.matches(netif_idx, data, len, out))
+    {
+        return;
+    }
+    if (tcpDumping)
+    {
+        tcpDumpCapture(netif_idx, data, len, out, success);
+    }
+    else if (netDumpCallback)
     {
         Packet np(millis(), netif_idx, data, len, out, success);
         if (netDumpFilter && !netDumpFilter(np))
@@ -129,14 +185,14 @@ void Netdump::netdumpCapture(int netif_idx, const char* data, size_t len, int ou
     }
 }
 
-void Netdump::writePcapHeader(Stream& s) const
+void Netdump::writePcapHeader(Stream& s, uint32_t snapLen) const
 {
     uint32_t pcapHeader[6];
     pcapHeader[0] = 0xa1b2c3d4;     // pcap magic number
     pcapHeader[1] = 0x00040002;     // pcap major/minor version
     pcapHeader[2] = 0;              // pcap UTC correction in seconds
     pcapHeader[3] = 0;              // pcap time stamp accuracy
-    pcapHeader[4] = maxPcapLength;  // pcap max packet length per record
+    pcapHeader[4] = snapLen;        // pcap max packet length per record
     pcapHeader[5] = 1;              // pacp data linkt type = ethernet
     s.write(reinterpret_cast<char*>(pcapHeader), 24);
 }
@@ -162,69 +218,94 @@ void Netdump::fileDumpProcess(File& outfile, const Packet& np) const
     outfile.write(np.rawData(), incl_len);
 }
 
-void Netdump::tcpDumpProcess(const Packet& np)
+size_t Netdump::ringPut(size_t at, const void* data, size_t len)
 {
-    if (np.isTCP() && np.hasPort(tcpDumpClient.localPort()))
+    size_t first = std::min(len, ringSize - at);
+    memcpy(ring + at, data, first);
+    memcpy(ring, static_cast<const char*>(data) + first, len - first);
+    return (at + len) % ringSize;
+}
+
+void Netdump::tcpDumpCapture(int netif_idx, const char* data, size_t len, int out, int success)
+{
+    if (tcpDumpRawFilter ? !tcpDumpFilter.matches(netif_idx, data, len, out)
+                         : netDumpFilter && !netDumpFilter(Packet(millis(), netif_idx, data, len, out, success)))
+    {
+        return;
+    }
+    // skip myself
+    if (CaptureFilter().ipProtocol(CaptureFilter::TCP).port(tcpDumpPort).matches(netif_idx, data, len, out))
     {
-        // skip myself
         return;
     }
-    size_t incl_len = np.getPacketSize() > maxPcapLength ? maxPcapLength : np.getPacketSize();
 
-    if (bufferIndex + 16 + incl_len < tcpBufferSize)  // only add if enough space available
+    size_t incl_len = std::min(len, (size_t)snapLen);
+    size_t used     = (ringHead + ringSize - ringTail) % ringSize;
+    if (used + 16 + incl_len >= ringSize)
     {
-        struct timeval tv;
-        gettimeofday(&tv, nullptr);
-        uint32_t* pcapHeader = reinterpret_cast<uint32_t*>(&packetBuffer[bufferIndex]);
-        pcapHeader[0]        = tv.tv_sec;  // add pcap record header
-        pcapHeader[1]        = tv.tv_usec;
-        pcapHeader[2]        = incl_len;
-        pcapHeader[3]        = np.getPacketSize();
-        bufferIndex += 16;  // pcap header size
-        memcpy(&packetBuffer[bufferIndex], np.rawData(), incl_len);
-        bufferIndex += incl_len;
+        captureCounters.dropped++;
+        return;
     }
 
-    if (bufferIndex && tcpDumpClient && tcpDumpClient.availableForWrite() >= (int)bufferIndex)
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    uint32_t pcapHeader[4];
+    pcapHeader[0] = tv.tv_sec;  // pcap record header
+    pcapHeader[1] = tv.tv_usec;
+    pcapHeader[2] = incl_len;
+    pcapHeader[3] = len;
+    // the head moves past a record once it is whole
+    ringHead = ringPut(ringPut(ringHead, pcapHeader, 16), data, incl_len);
+
+    captureCounters.captured++;
+    if (incl_len < len)
     {
-        tcpDumpClient.write(packetBuffer, bufferIndex);
-        bufferIndex = 0;
+        captureCounters.truncated++;
     }
 }
 
-void Netdump::tcpDumpLoop(WiFiServer& tcpDumpServer, const Filter nf)
+void Netdump::tcpDumpLoop(WiFiServer& tcpDumpServer)
 {
     if (tcpDumpServer.hasClient())
     {
+        tcpDumping    = false;
         tcpDumpClient = tcpDumpServer.accept();
         tcpDumpClient.setNoDelay(true);
+        tcpDumpPort = tcpDumpClient.localPort();
 
-        bufferIndex = 0;
-        writePcapHeader(tcpDumpClient);
-
-        setCallback(
-            [this](const Packet& ndp)
-            {
-                tcpDumpProcess(ndp);
-            },
-            nf);
+        ringHead = ringTail = 0;
+        writePcapHeader(tcpDumpClient, snapLen);
+        tcpDumping = true;
     }
     if (!tcpDumpClient || !tcpDumpClient.connected())
     {
-        setCallback(nullptr);
+        tcpDumping = false;
     }
-    if (bufferIndex && tcpDumpClient && tcpDumpClient.availableForWrite() >= (int)bufferIndex)
+
+    // as much of the ring as can be sent without waiting
+    while (tcpDumping && ringTail != ringHead)
     {
-        tcpDumpClient.write(packetBuffer, bufferIndex);
-        bufferIndex = 0;
+        size_t head = ringHead;
+        size_t len  = (head > ringTail ? head : ringSize) - ringTail;
+        len         = std::min(len, (size_t)tcpDumpClient.availableForWrite());
+        if (!len)
+        {
+            break;
+        }
+        len      = tcpDumpClient.write(ring + ringTail, len);
+        ringTail = (ringTail + len) % ringSize;
+        if (!len)
+        {
+            break;
+        }
     }
 
     if (tcpDumpServer.status() != CLOSED)
     {
         schedule_function(
-            [&tcpDumpServer, this, nf]()
+            [&tcpDumpServer, this]()
             {
-                tcpDumpLoop(tcpDumpServer, nf);
+                tcpDumpLoop(tcpDumpServer);
             });
     }
 }
@@ -27,6 +27,7 @@
 #include <lwipopts.h>
 #include <FS.h>
 #include "NetdumpPacket.h"
+#include "NetdumpFilter.h"
 #include <ESP8266WiFi.h>
 #include "CallBackList.h"
 
@@ -42,38 +43,81 @@ public:
     using Callback     = std::function<void(const Packet&)>;
     using LwipCallback = std::function<void(int, const char*, int, int, int)>;
 
+    // at most maxInstances dumps at once, the ones after capture nothing
+    static constexpr size_t maxInstances = 4;
+
     Netdump();
     ~Netdump();
 
     void setCallback(const Callback nc);
     void setCallback(const Callback nc, const Filter nf);
     void setFilter(const Filter nf);
+    // checked first, on the raw frame, by every dump until reset();
+    // false, and not set, when the program did not compile
+    bool setFilter(const FilterProgram& program);
     void reset();
 
     void printDump(Print& out, Packet::PacketDetail ndd, const Filter nf = nullptr);
     void fileDump(File& outfile, const Filter nf = nullptr);
+
+    // pcap stream to a client of tcpDumpServer: captured packets are put
+    // in a ring, at most snapLen bytes of each (see setCaptureSize()), and
+    // sent from loop(), so that capturing doesn't hold up lwIP.
+    // A CaptureFilter or a FilterProgram costs a few comparisons per
+    // packet, a Filter the building of a Packet.
     bool tcpDump(WiFiServer& tcpDumpServer, const Filter nf = nullptr);
+    bool tcpDump(WiFiServer& tcpDumpServer, const CaptureFilter& filter);
+    bool tcpDump(WiFiServer& tcpDumpServer, const FilterProgram& program);
+
+    // for the next tcpDump()
+    void setCaptureSize(size_t ringSize, uint16_t snapLen);
+
+    struct CaptureStats
+    {
+        uint32_t captured;   // put in the ring
+        uint32_t truncated;  // of them, to snapLen
+        uint32_t dropped;    // ring full
+    };
+    const CaptureStats& captureStats() const
+    {
+        return captureCounters;
+    }
 
 private:
     Callback netDumpCallback = nullptr;
     Filter   netDumpFilter   = nullptr;
 
+    FilterProgram netDumpProgram;
+
     static void capture(int netif_idx, const char* data, size_t len, int out, int success);
-    static CallBackList<LwipCallback>           lwipCallback;
-    CallBackList<LwipCallback>::CallBackHandler lwipHandler;
+    static FixedCallBackList<maxInstances, int, const char*, size_t, int, int> lwipCallback;
 
+    static void netdumpCapture(void* self, int netif_idx, const char* data, size_t len, int out, int success);
     void netdumpCapture(int netif_idx, const char* data, size_t len, int out, int success);
 
     void printDumpProcess(Print& out, Packet::PacketDetail ndd, const Packet& np) const;
     void fileDumpProcess(File& outfile, const Packet& np) const;
-    void tcpDumpProcess(const Packet& np);
-    void tcpDumpLoop(WiFiServer& tcpDumpServer, const Filter nf);
+    bool tcpDumpStart(WiFiServer& tcpDumpServer);
+    void tcpDumpCapture(int netif_idx, const char* data, size_t len, int out, int success);
+    void tcpDumpLoop(WiFiServer& tcpDumpServer);
+    size_t ringPut(size_t at, const void* data, size_t len);
 
-    void writePcapHeader(Stream& s) const;
+    void writePcapHeader(Stream& s, uint32_t snapLen = maxPcapLength) const;
 
     WiFiClient tcpDumpClient;
-    char*      packetBuffer = nullptr;
-    int        bufferIndex  = 0;
+    bool       tcpDumping = false;
+    uint16_t   tcpDumpPort = 0;  // of tcpDumpClient, its packets are not captured
+
+    CaptureFilter tcpDumpFilter;
+    bool          tcpDumpRawFilter = false;
+
+    // written from capture, read from loop(), [ringTail, ringHead) is used
+    char*           ring     = nullptr;
+    size_t          ringSize = tcpBufferSize;
+    volatile size_t ringHead = 0;
+    volatile size_t ringTail = 0;
+    uint16_t        snapLen  = maxPcapLength;
+    CaptureStats    captureCounters = { };
 
     static constexpr int      tcpBufferSize = 2048;
     static constexpr int      maxPcapLength = 1024;
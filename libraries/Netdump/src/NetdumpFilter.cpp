@@ -0,0 +1,533 @@
+/*
+    NetDump library - tcpdump-like packet logger facility
+
+    Copyright (c) 2020 esp8266/Arduino
+    This file is part of the esp8266 core for Arduino environment.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "NetdumpFilter.h"
+#include <string.h>
+
+namespace NetCapture
+{
+
+static constexpr size_t ethHeader = 14;
+
+static uint16_t ntoh16(const char* data, size_t idx)
+{
+    return ((uint8_t)data[idx] << 8) | (uint8_t)data[idx + 1];
+}
+
+static uint32_t ntoh32(const char* data, size_t idx)
+{
+    return ((uint32_t)ntoh16(data, idx) << 16) | ntoh16(data, idx + 2);
+}
+
+CaptureFilter& CaptureFilter::ethType(uint16_t type)
+{
+    _ethType = type;
+    _by |= ByEthType;
+    return *this;
+}
+
+CaptureFilter& CaptureFilter::ipProtocol(uint8_t protocol)
+{
+    _protocol = protocol;
+    _by |= ByProtocol;
+    return *this;
+}
+
+CaptureFilter& CaptureFilter::port(uint16_t port)
+{
+    _port = port;
+    _by |= ByPort;
+    return *this;
+}
+
+CaptureFilter& CaptureFilter::host(const IPAddress& ip)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        _host[i] = ip[i];
+    }
+    _by |= ByHost;
+    return *this;
+}
+
+CaptureFilter& CaptureFilter::netif(int netifIdx)
+{
+    _netif = netifIdx;
+    _by |= ByNetif;
+    return *this;
+}
+
+CaptureFilter& CaptureFilter::direction(bool out)
+{
+    _out = out;
+    _by |= ByDirection;
+    return *this;
+}
+
+bool CaptureFilter::matches(int netifIdx, const char* data, size_t len, int out) const
+{
+    if (((_by & ByNetif) && netifIdx != _netif) || ((_by & ByDirection) && !out != !_out))
+    {
+        return false;
+    }
+    if (!(_by & (ByEthType | ByProtocol | ByPort | ByHost)))
+    {
+        return true;
+    }
+    if (len < ethHeader)
+    {
+        return false;
+    }
+    uint16_t type = ntoh16(data, 12);
+    if ((_by & ByEthType) && type != _ethType)
+    {
+        return false;
+    }
+    if (!(_by & (ByProtocol | ByPort | ByHost)))
+    {
+        return true;
+    }
+
+    // IPv4 with its header length, or IPv6 without extension header
+    uint8_t protocol;
+    size_t  transport;
+    if (type == IPV4 && len >= ethHeader + 20)
+    {
+        protocol  = data[ethHeader + 9];
+        transport = ethHeader + ((data[ethHeader] & 0x0f) << 2);
+        if ((_by & ByHost) && memcmp(data + ethHeader + 12, _host, 4)
+            && memcmp(data + ethHeader + 16, _host, 4))
+        {
+            return false;
+        }
+    }
+    else if (type == IPV6 && len >= ethHeader + 40 && !(_by & ByHost))
+    {
+        protocol  = data[ethHeader + 6];
+        transport = ethHeader + 40;
+    }
+    else
+    {
+        return false;
+    }
+    if ((_by & ByProtocol) && protocol != _protocol)
+    {
+        return false;
+    }
+    if (_by & ByPort)
+    {
+        return (protocol == TCP || protocol == UDP) && len >= transport + 4
+               && (ntoh16(data, transport) == _port || ntoh16(data, transport + 2) == _port);
+    }
+    return true;
+}
+
+// recursive descent, emitting the program in postfix order
+struct FilterProgram::Compiler
+{
+    FilterProgram& program;
+    const char*    expression;
+    const char*    pos;
+    const char*    token    = nullptr;
+    size_t         tokenLen = 0;
+    size_t         depth    = 0;
+    bool           ok       = true;
+
+    static bool isWordChar(char c)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '.'
+               || c == '/';
+    }
+
+    void next()
+    {
+        while (*pos == ' ' || *pos == '\t')
+        {
+            pos++;
+        }
+        token = pos;
+        if (!*pos)
+        {
+            tokenLen = 0;
+            return;
+        }
+        if ((pos[0] == '&' && pos[1] == '&') || (pos[0] == '|' && pos[1] == '|'))
+        {
+            tokenLen = 2;
+        }
+        else if (isWordChar(*pos))
+        {
+            tokenLen = 0;
+            while (isWordChar(pos[tokenLen]))
+            {
+                tokenLen++;
+            }
+        }
+        else
+        {
+            // '(', ')', '!', or not understood
+            tokenLen = 1;
+        }
+        pos += tokenLen;
+    }
+
+    bool is(const char* word) const
+    {
+        return tokenLen == strlen(word) && !memcmp(token, word, tokenLen);
+    }
+
+    void fail()
+    {
+        if (ok)
+        {
+            ok                    = false;
+            program._errorOffset = token - expression;
+        }
+    }
+
+    void emit(Op op, uint16_t value = 0, uint8_t dir = Src | Dst, uint32_t addr = 0, uint32_t mask = 0)
+    {
+        if (op < OpNot && ++depth > 32)
+        {
+            fail();
+        }
+        else if (op > OpNot)
+        {
+            depth--;
+        }
+        if (program._count == maxInsns)
+        {
+            fail();
+        }
+        if (ok)
+        {
+            program._insns[program._count++] = { op, dir, value, addr, mask };
+        }
+    }
+
+    // the current token as a decimal number up to max
+    bool number(uint32_t max, uint32_t& value)
+    {
+        value = 0;
+        for (size_t i = 0; i < tokenLen; i++)
+        {
+            if (token[i] < '0' || token[i] > '9' || (value = value * 10 + token[i] - '0') > max)
+            {
+                return false;
+            }
+        }
+        return tokenLen > 0;
+    }
+
+    // a.b.c.d, and /bits when allowed
+    bool address(bool withBits, uint32_t& addr, uint32_t& mask)
+    {
+        const char* p    = token;
+        const char* end  = token + tokenLen;
+        uint32_t    bits = 32;
+        addr             = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            uint32_t byte   = 0;
+            const char* digits = p;
+            while (p < end && *p >= '0' && *p <= '9' && (byte = byte * 10 + *p - '0') <= 255)
+            {
+                p++;
+            }
+            if (p == digits || byte > 255 || (i < 3 && (p == end || *p++ != '.')))
+            {
+                return false;
+            }
+            addr = (addr << 8) | byte;
+        }
+        if (withBits && p < end && *p == '/')
+        {
+            bits = 0;
+            const char* digits = ++p;
+            while (p < end && *p >= '0' && *p <= '9' && (bits = bits * 10 + *p - '0') <= 32)
+            {
+                p++;
+            }
+            if (p == digits || bits > 32)
+            {
+                return false;
+            }
+        }
+        mask = bits ? ~(uint32_t)0 << (32 - bits) : 0;
+        addr &= mask;
+        return p == end;
+    }
+
+    void expr()
+    {
+        term();
+        while (ok && (is("or") || is("||")))
+        {
+            next();
+            term();
+            emit(OpOr);
+        }
+    }
+
+    void term()
+    {
+        factor();
+        while (ok && tokenLen && !is("or") && !is("||") && !is(")"))
+        {
+            if (is("and") || is("&&"))
+            {
+                next();
+            }
+            factor();
+            emit(OpAnd);
+        }
+    }
+
+    void factor()
+    {
+        if (!ok)
+        {
+            return;
+        }
+        if (is("not") || is("!"))
+        {
+            next();
+            factor();
+            emit(OpNot);
+        }
+        else if (is("("))
+        {
+            next();
+            expr();
+            if (!is(")"))
+            {
+                fail();
+            }
+            next();
+        }
+        else
+        {
+            primitive();
+        }
+    }
+
+    void primitive()
+    {
+        uint8_t dir = Src | Dst;
+        if (is("src") || is("dst"))
+        {
+            dir = is("src") ? Src : Dst;
+            next();
+            if (!is("port") && !is("host") && !is("net"))
+            {
+                fail();
+                return;
+            }
+        }
+
+        uint32_t value, addr, mask;
+        if (is("ip"))
+        {
+            emit(OpEthType, CaptureFilter::IPV4);
+        }
+        else if (is("ip6"))
+        {
+            emit(OpEthType, CaptureFilter::IPV6);
+        }
+        else if (is("arp"))
+        {
+            emit(OpEthType, CaptureFilter::ARP);
+        }
+        else if (is("icmp"))
+        {
+            emit(OpProtocol, CaptureFilter::ICMP);
+        }
+        else if (is("tcp"))
+        {
+            emit(OpProtocol, CaptureFilter::TCP);
+        }
+        else if (is("udp"))
+        {
+            emit(OpProtocol, CaptureFilter::UDP);
+        }
+        else if (is("inbound") || is("outbound"))
+        {
+            emit(OpOut, is("outbound"));
+        }
+        else if (is("host") || is("net"))
+        {
+            bool net = is("net");
+            next();
+            if (!address(net, addr, mask))
+            {
+                fail();
+                return;
+            }
+            emit(OpNet, 0, dir, addr, mask);
+        }
+        else
+        {
+            Op       op;
+            uint32_t max = 0xffff;
+            if (is("proto"))
+            {
+                op  = OpProtocol;
+                max = 0xff;
+            }
+            else if (is("port"))
+            {
+                op = OpPort;
+            }
+            else if (is("less"))
+            {
+                op = OpLess;
+            }
+            else if (is("greater"))
+            {
+                op = OpGreater;
+            }
+            else if (is("netif"))
+            {
+                op  = OpNetif;
+                max = 0xff;
+            }
+            else
+            {
+                fail();
+                return;
+            }
+            next();
+            if (!number(max, value))
+            {
+                fail();
+                return;
+            }
+            emit(op, value, dir);
+        }
+        next();
+    }
+};
+
+bool FilterProgram::compile(const char* expression)
+{
+    *this = FilterProgram();
+
+    Compiler compiler { *this, expression, expression };
+    compiler.next();
+    if (compiler.tokenLen)
+    {
+        compiler.expr();
+        if (compiler.tokenLen)
+        {
+            // such as an unmatched ')'
+            compiler.fail();
+        }
+    }
+    if (!compiler.ok)
+    {
+        _count = 0;
+        _valid = false;
+    }
+    return _valid;
+}
+
+bool FilterProgram::matches(int netifIdx, const char* data, size_t len, int out) const
+{
+    if (!_count)
+    {
+        return _valid;
+    }
+
+    // the fields instructions look at, IPv4 or IPv6 as in CaptureFilter
+    uint16_t type      = len >= ethHeader ? ntoh16(data, 12) : 0;
+    int      protocol  = -1;
+    size_t   transport = 0;
+    bool     ipv4      = false;
+    uint32_t src = 0, dst = 0;
+    if (type == CaptureFilter::IPV4 && len >= ethHeader + 20)
+    {
+        ipv4      = true;
+        protocol  = (uint8_t)data[ethHeader + 9];
+        transport = ethHeader + ((data[ethHeader] & 0x0f) << 2);
+        src       = ntoh32(data, ethHeader + 12);
+        dst       = ntoh32(data, ethHeader + 16);
+    }
+    else if (type == CaptureFilter::IPV6 && len >= ethHeader + 40)
+    {
+        protocol  = (uint8_t)data[ethHeader + 6];
+        transport = ethHeader + 40;
+    }
+    bool ports = (protocol == CaptureFilter::TCP || protocol == CaptureFilter::UDP) && len >= transport + 4;
+
+    // results, the last one in bit 0
+    uint32_t stack = 0;
+    for (size_t i = 0; i < _count; i++)
+    {
+        const Insn& insn = _insns[i];
+        bool        result;
+        switch (insn.op)
+        {
+        case OpEthType:
+            result = type == insn.value;
+            break;
+        case OpProtocol:
+            result = protocol == insn.value;
+            break;
+        case OpPort:
+            result = ports
+                     && (((insn.dir & Src) && ntoh16(data, transport) == insn.value)
+                         || ((insn.dir & Dst) && ntoh16(data, transport + 2) == insn.value));
+            break;
+        case OpNet:
+            result = ipv4
+                     && (((insn.dir & Src) && (src & insn.mask) == insn.addr)
+                         || ((insn.dir & Dst) && (dst & insn.mask) == insn.addr));
+            break;
+        case OpLess:
+            result = len <= insn.value;
+            break;
+        case OpGreater:
+            result = len >= insn.value;
+            break;
+        case OpNetif:
+            result = netifIdx == insn.value;
+            break;
+        case OpOut:
+            result = !out == !insn.value;
+            break;
+        case OpNot:
+            stack ^= 1;
+            continue;
+        case OpAnd:
+            result = (stack & 3) == 3;
+            stack >>= 2;
+            break;
+        default:  // OpOr
+            result = (stack & 3) != 0;
+            stack >>= 2;
+            break;
+        }
+        stack = (stack << 1) | result;
+    }
+    return stack & 1;
+}
+
+}  // namespace NetCapture
@@ -0,0 +1,164 @@
+/*
+    NetDump library - tcpdump-like packet logger facility
+
+    Copyright (c) 2020 esp8266/Arduino
+    This file is part of the esp8266 core for Arduino environment.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __NETDUMP_FILTER_H
+#define __NETDUMP_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <IPAddress.h>
+
+namespace NetCapture
+{
+
+// Packet selection set up once, then checked on the raw frame with a few
+// byte comparisons: no Packet is built, nothing is allocated.  Every
+// condition set must hold:
+//
+//    CaptureFilter().ipProtocol(CaptureFilter::TCP).port(80)
+//
+class CaptureFilter
+{
+public:
+    static constexpr uint16_t IPV4 = 0x0800;
+    static constexpr uint16_t ARP  = 0x0806;
+    static constexpr uint16_t IPV6 = 0x86dd;
+
+    static constexpr uint8_t ICMP = 1;
+    static constexpr uint8_t TCP  = 6;
+    static constexpr uint8_t UDP  = 17;
+
+    // Ethernet type
+    CaptureFilter& ethType(uint16_t type);
+    // IPv4 protocol, or IPv6 next header
+    CaptureFilter& ipProtocol(uint8_t protocol);
+    // TCP or UDP source or destination port
+    CaptureFilter& port(uint16_t port);
+    // IPv4 source or destination address
+    CaptureFilter& host(const IPAddress& ip);
+    // lwIP netif number
+    CaptureFilter& netif(int netifIdx);
+    // outgoing or incoming packets
+    CaptureFilter& direction(bool out);
+
+    bool matches(int netifIdx, const char* data, size_t len, int out) const;
+
+private:
+    enum : uint8_t
+    {
+        ByEthType   = 1 << 0,
+        ByProtocol  = 1 << 1,
+        ByPort      = 1 << 2,
+        ByHost      = 1 << 3,
+        ByNetif     = 1 << 4,
+        ByDirection = 1 << 5,
+    };
+
+    uint8_t  _by = 0;
+    uint8_t  _protocol;
+    int8_t   _netif;
+    bool     _out;
+    uint16_t _ethType;
+    uint16_t _port;
+    uint8_t  _host[4];
+};
+
+// A tcpdump-like expression, compiled once into a short program which is
+// run on the raw frame, before any Packet is built:
+//
+//    FilterProgram("tcp port 80 and not host 192.168.4.2")
+//
+// Primitives are ip, ip6, arp, icmp, tcp, udp, proto <n>, [src|dst] port <n>,
+// [src|dst] host <a.b.c.d>, [src|dst] net <a.b.c.d>/<bits>, less <n>,
+// greater <n>, inbound, outbound and netif <n>, combined by not (!), and (&&),
+// or (||) and parentheses.  Adjacent primitives are and-ed, as in
+// "tcp port 80".  Hosts and nets are IPv4, ports are TCP or UDP ones, and
+// the protocol of IPv6 packets is found when there is no extension header.
+class FilterProgram
+{
+public:
+    // matches everything
+    FilterProgram() = default;
+    explicit FilterProgram(const char* expression)
+    {
+        compile(expression);
+    }
+
+    // on error, false and a program matching nothing, see errorOffset()
+    bool compile(const char* expression);
+
+    explicit operator bool() const
+    {
+        return _valid;
+    }
+    // where compile() stopped understanding the expression
+    size_t errorOffset() const
+    {
+        return _errorOffset;
+    }
+
+    bool matches(int netifIdx, const char* data, size_t len, int out) const;
+
+private:
+    struct Compiler;
+
+    enum Op : uint8_t
+    {
+        OpEthType,
+        OpProtocol,
+        OpPort,
+        OpNet,
+        OpLess,
+        OpGreater,
+        OpNetif,
+        OpOut,
+        OpNot,
+        OpAnd,
+        OpOr,
+    };
+
+    enum : uint8_t
+    {
+        Src = 1 << 0,
+        Dst = 1 << 1,
+    };
+
+    struct Insn
+    {
+        Op       op;
+        uint8_t  dir;    // Src, Dst or both
+        uint16_t value;
+        uint32_t addr;   // host order
+        uint32_t mask;
+    };
+
+    // postfix, on a stack of at most 32 results
+    static constexpr size_t maxInsns = 32;
+
+    Insn    _insns[maxInsns] = { };
+    uint8_t _count       = 0;
+    bool    _valid       = true;
+    size_t  _errorOffset = 0;
+};
+
+}  // namespace NetCapture
+
+#endif /* __NETDUMP_FILTER_H */
@@ -0,0 +1,63 @@
+/*
+  Serves a web UI from a PackedFS image.
+
+  Pack the data directory of the sketch with
+    python3 tools/mkpackedfs.py --gzip -o packed.bin data
+  and upload packed.bin to the filesystem region of the flash with esptool
+  (at the address printed by "Tools > Flash Size"), or embed the image in the
+  sketch instead:
+    python3 tools/mkpackedfs.py --gzip --header webImage -o webImage.h data
+  and define USE_EMBEDDED_IMAGE below.
+
+  Released to the public domain
+*/
+
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+#include <PackedFS.h>
+
+//#define USE_EMBEDDED_IMAGE
+#ifdef USE_EMBEDDED_IMAGE
+#include "webImage.h"
+#endif
+
+#ifndef STASSID
+#define STASSID "your-ssid"
+#define STAPSK "your-password"
+#endif
+
+ESP8266WebServer server(80);
+
+void setup() {
+  Serial.begin(115200);
+
+#ifdef USE_EMBEDDED_IMAGE
+  PackedFS.setConfig(PackedFSConfig().setImage(webImage));
+#endif
+  if (!PackedFS.begin()) {
+    Serial.println("No PackedFS image");
+    return;
+  }
+
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(STASSID, STAPSK);
+  while (WiFi.status() != WL_CONNECTED) {
+    delay(500);
+    Serial.print(".");
+  }
+  Serial.println();
+  Serial.print("http://");
+  Serial.println(WiFi.localIP());
+
+  // The ETags were computed when packing, no file is read to answer If-None-Match
+  server.enableETag(true, [](FS&, const String& path) {
+    return PackedFS.eTag(path);
+  });
+  // index.html.gz and friends are sent with Content-Encoding: gzip
+  server.serveStatic("/", PackedFS, "/", "max-age=86400");
+  server.begin();
+}
+
+void loop() {
+  server.handleClient();
+}
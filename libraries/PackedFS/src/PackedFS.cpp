@@ -0,0 +1,226 @@
+/*
+ PackedFS.cpp - Read-only filesystem of files packed at build time
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <Arduino.h>
+#include <base64.h>
+#include "PackedFS.h"
+
+namespace packedfs_impl {
+
+bool PackedFSImpl::begin() {
+    if (_mounted) {
+        return true;
+    }
+    uint32_t limit;
+    if (_cfg._image) {
+        _image = _cfg._image;
+        limit = UINT32_MAX;
+    } else {
+        // Mapped when the region is in the first MB, read via SPI otherwise
+        _image = flash_hal_mapped(_start, _size);
+        limit = _size;
+    }
+    uint32_t header[4];
+    if ((limit < HeaderSize) || !_read(0, header, sizeof(header))) {
+        return false;
+    }
+    if ((header[0] != Magic) || (header[2] > limit) || (header[1] > (header[2] - HeaderSize) / EntrySize)) {
+        DEBUGV("PackedFS: no image\n");
+        return false;
+    }
+    _count = header[1];
+    _imageSize = header[2];
+    _buildTime = header[3];
+    _mounted = true;
+    return true;
+}
+
+bool PackedFSImpl::info(FSInfo& info) {
+    if (!_mounted) {
+        return false;
+    }
+    info.blockSize = 4;
+    info.pageSize = 4;
+    info.maxOpenFiles = 255; // Nothing is allocated per file but its name
+    info.maxPathLength = PACKEDFS_NAME_MAX;
+    info.totalBytes = _cfg._image ? _imageSize : _size;
+    info.usedBytes = _imageSize;
+    return true;
+}
+
+bool PackedFSImpl::_read(uint32_t offset, void *dst, size_t size) const {
+    if (_image) {
+        memcpy_P(dst, _image + offset, size);
+        return true;
+    }
+    return flash_hal_read(_start + offset, size, static_cast<uint8_t*>(dst)) == FLASH_HAL_OK;
+}
+
+const uint8_t *PackedFSImpl::_mapped(uint32_t offset, size_t size) const {
+    (void) size;
+    return _image ? _image + offset : nullptr;
+}
+
+bool PackedFSImpl::_entry(uint32_t index, Entry& entry) const {
+    if (index >= _count) {
+        return false;
+    }
+    if (!_read(HeaderSize + index * EntrySize, &entry, EntrySize)) {
+        return false;
+    }
+    return (entry.name < _imageSize) && (entry.data <= _imageSize) && (entry.size <= _imageSize - entry.data);
+}
+
+bool PackedFSImpl::_name(const Entry& entry, char (&name)[PACKEDFS_NAME_MAX + 1]) const {
+    size_t len = std::min((size_t)PACKEDFS_NAME_MAX + 1, (size_t)(_imageSize - entry.name));
+    if (!_read(entry.name, name, len)) {
+        return false;
+    }
+    name[len - 1] = 0;
+    return true;
+}
+
+uint32_t PackedFSImpl::_lowerBound(const char *name) const {
+    uint32_t lo = 0;
+    uint32_t hi = _count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        Entry entry;
+        char entryName[PACKEDFS_NAME_MAX + 1];
+        if (!_entry(mid, entry) || !_name(entry, entryName)) {
+            return _count;
+        }
+        if (strcmp(entryName, name) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+int PackedFSImpl::_find(const char *path, Entry& entry) const {
+    path = _strip(path);
+    if (!_mounted || !path[0] || (strlen(path) > PACKEDFS_NAME_MAX)) {
+        return -1;
+    }
+    uint32_t index = _lowerBound(path);
+    char name[PACKEDFS_NAME_MAX + 1];
+    if (!_entry(index, entry) || !_name(entry, name) || strcmp(name, path)) {
+        return -1;
+    }
+    return index;
+}
+
+bool PackedFSImpl::_isDir(const char *path) const {
+    path = _strip(path);
+    if (!_mounted) {
+        return false;
+    }
+    if (!path[0]) {
+        return true;
+    }
+    String prefix(path);
+    if (!prefix.endsWith("/")) {
+        prefix += '/';
+    }
+    if (prefix.length() > PACKEDFS_NAME_MAX) {
+        return false;
+    }
+    Entry entry;
+    char name[PACKEDFS_NAME_MAX + 1];
+    return _entry(_lowerBound(prefix.c_str()), entry) && _name(entry, name) && !strncmp(name, prefix.c_str(), prefix.length());
+}
+
+FileImplPtr PackedFSImpl::open(const char* path, OpenMode openMode, AccessMode accessMode) {
+    if ((openMode != OM_DEFAULT) || (accessMode != AM_READ)) {
+        DEBUGV("PackedFSImpl::open() is read-only\n");
+        return FileImplPtr();
+    }
+    Entry entry;
+    if (_find(path, entry) < 0) {
+        return FileImplPtr();
+    }
+    return std::make_shared<PackedFSFileImpl>(this, _strip(path), entry.data, entry.size);
+}
+
+bool PackedFSImpl::exists(const char* path) {
+    Entry entry;
+    return path && ((_find(path, entry) >= 0) || _isDir(path));
+}
+
+DirImplPtr PackedFSImpl::openDir(const char* path) {
+    if (!path || !_isDir(path)) {
+        return DirImplPtr();
+    }
+    String prefix(_strip(path));
+    if (prefix.length() && !prefix.endsWith("/")) {
+        prefix += '/';
+    }
+    return std::make_shared<PackedFSDirImpl>(this, prefix);
+}
+
+String PackedFSImpl::eTag(const char* path) {
+    Entry entry;
+    if (!path || (_find(path, entry) < 0)) {
+        return String();
+    }
+    return "\"" + base64::encode(entry.md5, sizeof(entry.md5), false) + "\"";
+}
+
+bool PackedFSDirImpl::next() {
+    String previous = _dir ? _current : String();
+    _valid = false;
+    PackedFSImpl::Entry entry;
+    char name[PACKEDFS_NAME_MAX + 1];
+    while (_fs->_entry(_index, entry) && _fs->_name(entry, name)) {
+        if (strncmp(name, _prefix.c_str(), _prefix.length())) {
+            break; // Past the directory
+        }
+        _index++;
+        const char *child = name + _prefix.length();
+        const char *slash = strchr(child, '/');
+        if (!slash) {
+            _current = child;
+            _dir = false;
+            _size = entry.size;
+            _valid = true;
+            break;
+        }
+        // A subdirectory, reported once for its first entry
+        String dir;
+        dir.concat(child, slash - child);
+        if (dir != previous) {
+            _current = dir;
+            _dir = true;
+            _size = 0;
+            _valid = true;
+            break;
+        }
+    }
+    return _valid;
+}
+
+}; // namespace packedfs_impl
+
+#ifndef CORE_MOCK
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_PACKEDFS)
+PackedFileSystem PackedFS = PackedFileSystem(std::make_shared<packedfs_impl::PackedFSImpl>(FS_PHYS_ADDR, FS_PHYS_SIZE));
+#endif
+#endif // !CORE_MOCK
@@ -0,0 +1,383 @@
+/*
+ PackedFS.h - Read-only filesystem of files packed at build time
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __PACKEDFS_H
+#define __PACKEDFS_H
+
+#include <algorithm>
+#include <memory>
+#include <FS.h>
+#include <FSImpl.h>
+#include <debug.h>
+#include <flash_hal.h>
+
+// Longest path in an image, tools/mkpackedfs.py refuses longer ones
+#define PACKEDFS_NAME_MAX 63
+
+/*
+  Image layout, made by tools/mkpackedfs.py, all words little endian and
+  offsets from the start of the image:
+
+    header   magic "PKF1", file count, image size, build time
+    entries  name offset, data offset, size, MD5 of the data,
+             sorted by name (bytewise) for a binary search in open()
+    names    NUL terminated paths without the leading '/'
+    data     each file in one piece, starting on a 4 byte boundary
+
+  A precompressed variant is a file of its own named <path>.gz, which is
+  what ESP8266WebServer::serveStatic() looks for.
+*/
+
+using namespace fs;
+
+namespace packedfs_impl {
+
+class PackedFSFileImpl;
+class PackedFSDirImpl;
+
+class PackedFSConfig : public FSConfig
+{
+public:
+    static constexpr uint32_t FSId = 0x504b4653;
+    PackedFSConfig() : FSConfig(FSId, false), _image(nullptr) { }
+
+    // Use an image linked into the sketch (mkpackedfs.py --header) instead
+    // of the one uploaded to the filesystem region of the flash
+    PackedFSConfig setImage(const uint8_t *image) {
+        _image = image;
+        return *this;
+    }
+
+    // Inherit _type and _autoFormat (which has no use here)
+    const uint8_t *_image;
+};
+
+class PackedFSImpl : public FSImpl
+{
+public:
+    static constexpr uint32_t Magic = 0x31464b50; // "PKF1"
+
+    PackedFSImpl(uint32_t start, uint32_t size)
+        : _start(start), _size(size), _image(nullptr), _count(0), _imageSize(0), _buildTime(0), _mounted(false) { }
+
+    FileImplPtr open(const char* path, OpenMode openMode, AccessMode accessMode) override;
+    DirImplPtr openDir(const char* path) override;
+    bool exists(const char* path) override;
+
+    // The image is written by uploading a new one only
+    bool rename(const char* pathFrom, const char* pathTo) override {
+        (void) pathFrom;
+        (void) pathTo;
+        return false;
+    }
+    bool remove(const char* path) override {
+        (void) path;
+        return false;
+    }
+    bool mkdir(const char* path) override {
+        (void) path;
+        return false;
+    }
+    bool rmdir(const char* path) override {
+        (void) path;
+        return false;
+    }
+    bool format() override {
+        return false;
+    }
+
+    bool setConfig(const FSConfig &cfg) override {
+        if ((cfg._type != PackedFSConfig::FSId) || _mounted) {
+            return false;
+        }
+        _cfg = *static_cast<const PackedFSConfig *>(&cfg);
+        return true;
+    }
+
+    bool begin() override;
+
+    void end() override {
+        _mounted = false;
+    }
+
+    bool info(FSInfo& info) override;
+
+    bool info64(FSInfo64& info64) override {
+        FSInfo i;
+        if (!info(i)) {
+            return false;
+        }
+        info64.blockSize     = i.blockSize;
+        info64.pageSize      = i.pageSize;
+        info64.maxOpenFiles  = i.maxOpenFiles;
+        info64.maxPathLength = i.maxPathLength;
+        info64.totalBytes    = i.totalBytes;
+        info64.usedBytes     = i.usedBytes;
+        return true;
+    }
+
+    time_t getCreationTime() override {
+        return _mounted ? (time_t)_buildTime : 0;
+    }
+
+    // ETag of a file, the quoted base64 MD5 ESP8266WebServer would compute,
+    // or an empty string when there is no such file
+    String eTag(const char* path);
+
+protected:
+    friend class PackedFSFileImpl;
+    friend class PackedFSDirImpl;
+
+    struct Entry {
+        uint32_t name;
+        uint32_t data;
+        uint32_t size;
+        uint8_t  md5[16];
+    };
+
+    static constexpr uint32_t HeaderSize = 16;
+    static constexpr uint32_t EntrySize = sizeof(Entry);
+    static_assert(sizeof(Entry) == 28, "image entries are 7 words");
+
+    bool _read(uint32_t offset, void *dst, size_t size) const;
+    const uint8_t *_mapped(uint32_t offset, size_t size) const;
+    bool _entry(uint32_t index, Entry& entry) const;
+    bool _name(const Entry& entry, char (&name)[PACKEDFS_NAME_MAX + 1]) const;
+    // Index of the first entry whose name is not below name, _count if none
+    uint32_t _lowerBound(const char *name) const;
+    // Index of the file named path (with or without leading '/'), -1 if none
+    int _find(const char *path, Entry& entry) const;
+    bool _isDir(const char *path) const;
+
+    static const char *_strip(const char *path) {
+        while (*path == '/') {
+            path++;
+        }
+        return path;
+    }
+
+    PackedFSConfig _cfg;
+
+    uint32_t       _start;
+    uint32_t       _size;
+    const uint8_t *_image;  // where the image is mapped, nullptr to read through flash_hal_read()
+    uint32_t       _count;
+    uint32_t       _imageSize;
+    uint32_t       _buildTime;
+    bool           _mounted;
+};
+
+class PackedFSFileImpl : public FileImpl
+{
+public:
+    PackedFSFileImpl(PackedFSImpl* fs, const char *name, uint32_t data, uint32_t size)
+        : _fs(fs), _name(name), _data(data), _size(size), _pos(0), _opened(true) { }
+
+    size_t write(const uint8_t *buf, size_t size) override {
+        (void) buf;
+        (void) size;
+        return 0;
+    }
+
+    int read(uint8_t* buf, size_t size) override {
+        if (!_opened || !buf) {
+            return 0;
+        }
+        size = std::min(size, (size_t)(_size - _pos));
+        if (!size || !_fs->_read(_data + _pos, buf, size)) {
+            return 0;
+        }
+        _pos += size;
+        return size;
+    }
+
+    void flush() override { }
+
+    bool seek(uint32_t pos, SeekMode mode) override {
+        if (!_opened) {
+            return false;
+        }
+        uint32_t newPos;
+        switch (mode) {
+        case SeekCur:
+            newPos = _pos + pos;
+            break;
+        case SeekEnd:
+            newPos = _size - pos; // Same as LittleFS
+            break;
+        default:
+            newPos = pos;
+            break;
+        }
+        if (newPos > _size) {
+            return false;
+        }
+        _pos = newPos;
+        return true;
+    }
+
+    size_t position() const override {
+        return _opened ? _pos : 0;
+    }
+
+    size_t size() const override {
+        return _opened ? _size : 0;
+    }
+
+    bool truncate(uint32_t size) override {
+        (void) size;
+        return false;
+    }
+
+    void close() override {
+        _opened = false;
+    }
+
+    const char* name() const override {
+        if (!_opened) {
+            return nullptr;
+        }
+        const char *p = _name.c_str();
+        const char *slash = strrchr(p, '/');
+        return slash ? slash + 1 : p;
+    }
+
+    const char* fullName() const override {
+        return _opened ? _name.c_str() : nullptr;
+    }
+
+    bool isFile() const override {
+        return _opened;
+    }
+
+    bool isDirectory() const override {
+        return false;
+    }
+
+    // The whole rest of the file, packed files are in one piece
+    const uint8_t* mappedData(size_t& len) override {
+        len = 0;
+        if (!_opened || (_pos >= _size)) {
+            return nullptr;
+        }
+        const uint8_t *data = _fs->_mapped(_data + _pos, _size - _pos);
+        if (data) {
+            len = _size - _pos;
+        }
+        return data;
+    }
+
+    time_t getLastWrite() override {
+        return _fs->getCreationTime();
+    }
+
+    time_t getCreationTime() override {
+        return _fs->getCreationTime();
+    }
+
+protected:
+    PackedFSImpl *_fs;
+    String        _name;
+    uint32_t      _data;
+    uint32_t      _size;
+    uint32_t      _pos;
+    bool          _opened;
+};
+
+class PackedFSDirImpl : public DirImpl
+{
+public:
+    PackedFSDirImpl(PackedFSImpl* fs, const String& prefix)
+        : _fs(fs), _prefix(prefix), _index(0), _valid(false), _dir(false), _size(0) {
+        rewind();
+    }
+
+    FileImplPtr openFile(OpenMode openMode, AccessMode accessMode) override {
+        if (!_valid || _dir) {
+            return FileImplPtr();
+        }
+        return _fs->open((_prefix + _current).c_str(), openMode, accessMode);
+    }
+
+    const char* fileName() override {
+        return _valid ? _current.c_str() : nullptr;
+    }
+
+    size_t fileSize() override {
+        return _valid ? _size : 0;
+    }
+
+    time_t fileTime() override {
+        return _valid ? _fs->getCreationTime() : 0;
+    }
+
+    time_t fileCreationTime() override {
+        return fileTime();
+    }
+
+    bool isFile() const override {
+        return _valid && !_dir;
+    }
+
+    bool isDirectory() const override {
+        return _valid && _dir;
+    }
+
+    // Entries are sorted, those below the directory follow each other
+    bool rewind() override {
+        _valid = false;
+        _current.clear();
+        _index = _fs->_lowerBound(_prefix.c_str());
+        return true;
+    }
+
+    bool next() override;
+
+protected:
+    PackedFSImpl *_fs;
+    String        _prefix;  // path of the directory with a trailing '/', empty for the root
+    uint32_t      _index;   // next entry to look at
+    String        _current; // name of the file or subdirectory below the directory
+    bool          _valid;
+    bool          _dir;
+    uint32_t      _size;
+};
+
+}; // namespace packedfs_impl
+
+// A PackedFS is an FS telling the ETags computed at build time
+class PackedFileSystem : public fs::FS
+{
+public:
+    PackedFileSystem(const std::shared_ptr<packedfs_impl::PackedFSImpl>& impl) : FS(impl), _packed(impl.get()) { }
+
+    String eTag(const String& path) {
+        return _packed->eTag(path.c_str());
+    }
+
+protected:
+    packedfs_impl::PackedFSImpl *_packed;
+};
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_PACKEDFS)
+extern PackedFileSystem PackedFS;
+using packedfs_impl::PackedFSConfig;
+#endif
+
+#endif // !defined(__PACKEDFS_H)
@@ -66,10 +66,30 @@ static inline constexpr const char* SDClassFileMode(uint8_t mode) {
 class SDClass {
 public:
     bool begin(uint8_t csPin, uint32_t cfg = SPI_HALF_SPEED) {
-        SDFS.setConfig(SDFSConfig(csPin, cfg));
+        SDFS.setConfig(SDFSConfig(csPin, cfg).setFileBufferSize(_bufferSize).setWriteBehind(_writeBehind));
         return (boolean)SDFS.begin();
     }
 
+    // Before begin(): a read-ahead / write buffer of size bytes for files
+    // opened only for reading or only for writing, the writes possibly
+    // done after loop() returns.  See SDFSConfig::setFileBufferSize() and
+    // SDFSConfig::setWriteBehind()
+    void setFileBuffer(uint16_t size, bool writeBehind = false) {
+        _bufferSize = size;
+        _writeBehind = writeBehind;
+    }
+
+    // Card latencies seen by the files, see SDFS_SLOW_US
+    const sdfs::SDFSImpl::CardStats& cardStats() {
+        sdfs::SDFSImpl* sd = static_cast<sdfs::SDFSImpl*>(SDFS.getImpl().get());
+        return sd->cardStats();
+    }
+
+    void resetCardStats() {
+        sdfs::SDFSImpl* sd = static_cast<sdfs::SDFSImpl*>(SDFS.getImpl().get());
+        sd->resetCardStats();
+    }
+
     void end(bool endSPI = true) {
         SDFS.end();
         if (endSPI) {
@@ -201,6 +221,8 @@ private:
         return time(nullptr);
     }
 
+    uint16_t _bufferSize = 0;
+    bool     _writeBehind = false;
 };
 
 
@@ -71,7 +71,7 @@ FileImplPtr SDFSImpl::open(const char* path, OpenMode openMode, AccessMode acces
         return FileImplPtr();
     }
     auto sharedFd = std::make_shared<File32>(fd);
-    return std::make_shared<SDFSFileImpl>(this, sharedFd, path);
+    return std::make_shared<SDFSFileImpl>(this, sharedFd, path, flags);
 }
 
 DirImplPtr SDFSImpl::openDir(const char* path)
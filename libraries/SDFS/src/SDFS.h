@@ -27,14 +27,21 @@
  License along with this library; if not, write to the Free Software
  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
+#include <algorithm>
 #include <limits>
+#include <new>
 #include <assert.h>
 #include <FSImpl.h>
+#include <Schedule.h>
 #include "debug.h"
 #include <SPI.h>
 #include <SdFat.h>
 #include <FS.h>
 
+#ifndef SDFS_SLOW_US
+#define SDFS_SLOW_US 10000 // card operations counted as slow in SDFSImpl::cardStats()
+#endif
+
 namespace sdfs {
 
 class SDFSFileImpl;
@@ -44,7 +51,7 @@ class SDFSConfig : public fs::FSConfig
 public:
     static constexpr uint32_t FSId = 0x53444653;
 
-    SDFSConfig(uint8_t csPin = 4, uint32_t spi = SD_SCK_MHZ(10)) : FSConfig(FSId, false), _csPin(csPin), _part(0), _spiSettings(spi)  { }
+    SDFSConfig(uint8_t csPin = 4, uint32_t spi = SD_SCK_MHZ(10)) : FSConfig(FSId, false), _csPin(csPin), _part(0), _spiSettings(spi), _bufferSize(0), _writeBehind(false)  { }
 
     SDFSConfig setAutoFormat(bool val = true) {
         _autoFormat = val;
@@ -62,16 +69,53 @@ public:
         _part = part;
         return *this;
     }
+    // RAM buffer of each file opened for reading only or for writing only,
+    // in whole 512 byte sectors.  Small reads and writes then reach SdFat as
+    // runs of sectors, which it transfers with one multi-block command
+    // (CMD18/CMD25) instead of one command per sector.  0 disables it
+    SDFSConfig setFileBufferSize(uint16_t size) {
+        _bufferSize = size & ~511;
+        return *this;
+    }
+    // Sectors gathered by the write buffer are written after loop() returns,
+    // from the scheduled functions, rather than by the write() filling the
+    // buffer.  write() then waits for the card only when the buffer is full
+    SDFSConfig setWriteBehind(bool val = true) {
+        _writeBehind = val;
+        return *this;
+    }
 
     // Inherit _type and _autoFormat
     uint8_t   _csPin;
     uint8_t   _part;
     uint32_t  _spiSettings;
+    uint16_t  _bufferSize;
+    bool      _writeBehind;
 };
 
 class SDFSImpl : public fs::FSImpl
 {
 public:
+    // Time the files spent waiting for the card in SdFat, per operation
+    struct CardLatency
+    {
+        uint32_t count = 0;
+        uint32_t slow = 0;     // over SDFS_SLOW_US
+        uint32_t maxUs = 0;
+        uint64_t totalUs = 0;
+
+        uint32_t avgUs() const {
+            return count ? totalUs / count : 0;
+        }
+    };
+    struct CardStats
+    {
+        CardLatency read;
+        CardLatency write;
+        CardLatency sync;      // flush() and close()
+        uint64_t    writtenBehind = 0; // bytes, see SDFSConfig::setWriteBehind()
+    };
+
     SDFSImpl() : _mounted(false)
     {
     }
@@ -188,6 +232,13 @@ public:
         return (clusterSize() * totalClusters());
     }
 
+    const CardStats& cardStats() const {
+        return _stats;
+    }
+    void resetCardStats() {
+        _stats = CardStats();
+    }
+
     // Helper function, takes FAT and makes standard time_t
     static time_t FatToTimeT(uint16_t d, uint16_t t) {
         struct tm tiempo;
@@ -224,6 +275,7 @@ public:
 
 protected:
     friend class SDFileImpl;
+    friend class SDFSFileImpl;
     friend class SDFSDirImpl;
 
     SdFat* getFs() {
@@ -252,18 +304,35 @@ protected:
         return mode;
     }
 
+    static void _record(CardLatency& latency, uint32_t start) {
+        uint32_t us = micros() - start;
+        latency.count++;
+        latency.totalUs += us;
+        latency.maxUs = std::max(latency.maxUs, us);
+        if (us > SDFS_SLOW_US) {
+            latency.slow++;
+        }
+    }
+
     SdFat        _fs;
     SDFSConfig   _cfg;
     bool         _mounted;
+    CardStats    _stats;
 };
 
 
-class SDFSFileImpl : public fs::FileImpl
+class SDFSFileImpl : public fs::FileImpl, public std::enable_shared_from_this<SDFSFileImpl>
 {
 public:
-    SDFSFileImpl(SDFSImpl *fs, std::shared_ptr<File32> fd, const char *name)
-        : _fs(fs), _fd(fd), _opened(true)
+    SDFSFileImpl(SDFSImpl *fs, std::shared_ptr<File32> fd, const char *name, uint8_t flags = O_RDWR)
+        : _fs(fs), _fd(fd), _opened(true), _bufSize(0), _bufMode(BufNone), _bufPos(0), _bufLen(0), _behindScheduled(false)
     {
+        // Read-write files see their data through SdFat only
+        uint8_t access = flags & O_ACCMODE;
+        if (fs->_cfg._bufferSize && ((access == O_RDONLY) || (access == O_WRONLY))) {
+            _bufSize = fs->_cfg._bufferSize;
+            _bufMode = (access == O_RDONLY) ? BufRead : BufWrite;
+        }
         _name = std::shared_ptr<char>(new char[strlen(name) + 1], std::default_delete<char[]>());
         strcpy(_name.get(), name);
     }
@@ -281,24 +350,97 @@ public:
 
     size_t write(const uint8_t *buf, size_t size) override
     {
-        return _opened ? _fd->write(buf, size) : -1;
+        if (!_opened) {
+            return -1;
+        }
+        if (_bufMode != BufWrite) {
+            return _cardWrite(buf, size);
+        }
+        size_t done = 0;
+        while (size) {
+            if (!_bufLen && !(_fd->curPosition() % 512) && (size >= _bufSize)) {
+                // Whole sectors straight from the caller
+                size_t n = size & ~511;
+                size_t w = _cardWrite(buf, n);
+                done += w;
+                if (w != n) {
+                    return done;
+                }
+                buf += n;
+                size -= n;
+                continue;
+            }
+            if (!_allocBuf()) {
+                return done + _cardWrite(buf, size);
+            }
+            if (!_bufLen) {
+                // Fill up to a sector boundary, so that the next ones are whole
+                _bufPos = _bufSize - (_fd->curPosition() % 512);
+            }
+            size_t n = std::min(size, _bufPos - _bufLen);
+            memcpy(_buf.get() + _bufLen, buf, n);
+            _bufLen += n;
+            done += n;
+            buf += n;
+            size -= n;
+            if ((_bufLen == _bufPos) && !_drain()) {
+                return done - n;
+            }
+        }
+        if (_fs->_cfg._writeBehind) {
+            _scheduleBehind();
+        }
+        return done;
     }
 
     int read(uint8_t* buf, size_t size) override
     {
-        return _opened ? _fd->read(buf, size) : -1;
+        if (!_opened) {
+            return -1;
+        }
+        if (_bufMode != BufRead) {
+            return _cardRead(buf, size);
+        }
+        size_t done = 0;
+        while (size) {
+            if (_bufPos < _bufLen) {
+                size_t n = std::min(size, _bufLen - _bufPos);
+                memcpy(buf, _buf.get() + _bufPos, n);
+                _bufPos += n;
+                done += n;
+                buf += n;
+                size -= n;
+                continue;
+            }
+            if ((size >= _bufSize) || !_allocBuf()) {
+                // Large reads of whole sectors are multi-block ones already
+                int n = _cardRead(buf, size);
+                return (n < 0) ? (done ? (int)done : n) : (int)(done + n);
+            }
+            // Read ahead up to a sector boundary
+            int n = _cardRead(_buf.get(), _bufSize - (_fd->curPosition() % 512));
+            _bufPos = 0;
+            _bufLen = (n > 0) ? n : 0;
+            if (!_bufLen) {
+                break;
+            }
+        }
+        return done;
     }
 
     void flush() override
     {
         if (_opened) {
+            _drain();
+            uint32_t start = micros();
             _fd->sync();
+            SDFSImpl::_record(_fs->_stats.sync, start);
         }
     }
 
     bool seek(uint32_t pos, fs::SeekMode mode) override
     {
-        if (!_opened) {
+        if (!_opened || !_drain()) {
             return false;
         }
         switch (mode) {
@@ -318,12 +460,24 @@ public:
 
     size_t position() const override
     {
-        return _opened ? _fd->curPosition() : 0;
+        if (!_opened) {
+            return 0;
+        }
+        if (_bufMode == BufWrite) {
+            return _fd->curPosition() + _bufLen;
+        }
+        return _fd->curPosition() - (_bufLen - _bufPos);
     }
 
     size_t size() const override
     {
-        return _opened ? _fd->fileSize() : 0;
+        if (!_opened) {
+            return 0;
+        }
+        if (_bufMode == BufWrite) {
+            return std::max((size_t)_fd->fileSize(), position());
+        }
+        return _fd->fileSize();
     }
 
     bool truncate(uint32_t size) override
@@ -332,13 +486,17 @@ public:
             DEBUGV("SDFSFileImpl::truncate: file not opened\n");
             return false;
         }
-        return _fd->truncate(size);
+        return _drain() && _fd->truncate(size);
     }
 
     void close() override
     {
         if (_opened) {
+            _drain();
+            _buf.reset();
+            uint32_t start = micros();
             _fd->close();
+            SDFSImpl::_record(_fs->_stats.sync, start);
             _opened = false;
         }
     }
@@ -397,10 +555,112 @@ public:
     }
 
 protected:
+    bool _allocBuf()
+    {
+        if (!_buf) {
+            _buf.reset(new (std::nothrow) uint8_t[_bufSize]);
+            if (!_buf) {
+                _bufMode = BufNone; // Straight to SdFat from now on
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int _cardRead(uint8_t* buf, size_t size)
+    {
+        uint32_t start = micros();
+        int n = _fd->read(buf, size);
+        SDFSImpl::_record(_fs->_stats.read, start);
+        return n;
+    }
+
+    size_t _cardWrite(const uint8_t* buf, size_t size)
+    {
+        uint32_t start = micros();
+        size_t n = _fd->write(buf, size);
+        SDFSImpl::_record(_fs->_stats.write, start);
+        return n;
+    }
+
+    // The whole sectors at the start of the write buffer
+    size_t _sectorRun() const
+    {
+        size_t pos = _fd->curPosition();
+        size_t end = (pos + _bufLen) & ~511;
+        return (end > pos) ? end - pos : 0;
+    }
+
+    void _scheduleBehind()
+    {
+        if (_behindScheduled || !_sectorRun()) {
+            return;
+        }
+        // the file may be closed and gone by then
+        std::weak_ptr<SDFSFileImpl> file = shared_from_this();
+        _behindScheduled = schedule_function([file]() {
+            if (auto f = file.lock()) {
+                f->_writeBehind();
+            }
+        });
+    }
+
+    // From the scheduled functions: writes the whole sectors gathered, the
+    // rest of the last one stays in the buffer
+    void _writeBehind()
+    {
+        _behindScheduled = false;
+        if (!_opened || (_bufMode != BufWrite)) {
+            return;
+        }
+        size_t n = _sectorRun();
+        if (!n) {
+            return;
+        }
+        size_t w = _cardWrite(_buf.get(), n);
+        if (w != n) {
+            // write() or flush() will try the rest again and report it
+            DEBUGV("SDFSFileImpl: write behind failed\n");
+        }
+        _fs->_stats.writtenBehind += w;
+        _bufLen -= w;
+        memmove(_buf.get(), _buf.get() + w, _bufLen);
+        // the run now ends on the sector boundary following SdFat's position
+        _bufPos = std::max(_bufLen, _bufSize - (_fd->curPosition() % 512));
+    }
+
+    // Writes what is buffered, or forgets what was read ahead by moving SdFat
+    // back to where the reader is
+    bool _drain()
+    {
+        bool ok = true;
+        if (_bufMode == BufWrite) {
+            if (_bufLen) {
+                ok = (_cardWrite(_buf.get(), _bufLen) == _bufLen);
+                if (!ok) {
+                    DEBUGV("SDFSFileImpl: buffered write failed\n");
+                }
+            }
+        } else if ((_bufMode == BufRead) && (_bufPos < _bufLen)) {
+            ok = _fd->seekSet(position());
+        }
+        _bufPos = 0;
+        _bufLen = 0;
+        return ok;
+    }
+
     SDFSImpl*                _fs;
     std::shared_ptr<File32>  _fd;
     std::shared_ptr<char>    _name;
     bool                     _opened;
+    // Sector buffer, see SDFSConfig::setFileBufferSize()
+    std::unique_ptr<uint8_t[]> _buf;
+    size_t                   _bufSize;
+    enum : uint8_t { BufNone, BufRead, BufWrite };
+    uint8_t                  _bufMode; // read ahead, gather writes or neither
+    size_t                   _bufPos;  // next byte to read, or where a write run ends
+    size_t                   _bufLen;
+    bool                     _behindScheduled;
 };
 
 class SDFSDirImpl : public fs::DirImpl
@@ -21,6 +21,8 @@
 
 #include "SPI.h"
 #include "HardwareSerial.h"
+#include <Schedule.h>
+#include <new>
 
 #define SPI_PINS_HSPI			0 // Normal HSPI mode (MISO = GPIO12, MOSI = GPIO13, SCLK = GPIO14);
 #define SPI_PINS_HSPI_OVERLAP	1 // HSPI Overllaped in spi0 pins (MISO = SD0, MOSI = SDD1, SCLK = CLK);
@@ -140,6 +142,9 @@ void SPIClass::setHwCs(bool use) {
 }
 
 void SPIClass::beginTransaction(SPISettings settings) {
+    while(queueBusy()) {
+        optimistic_yield(1000);
+    }
     while(SPI1CMD & SPIBUSY) {}
     setFrequency(settings._clock);
     setBitOrder(settings._bitOrder);
@@ -524,6 +529,103 @@ void SPIClass::writePattern(const uint8_t * data, uint8_t size, uint32_t repeat)
     SPI1U = SPIUMOSI | SPIUDUPLEX | SPIUSSE;
 }
 
+/**
+ * @param data uint16_t
+ * @param count uint32_t number of values
+ */
+void SPIClass::fill16(uint16_t data, uint32_t count) {
+    if(!(SPI1C & (SPICWBO | SPICRBO))) {
+        // MSBFIRST Byte first
+        data = (data >> 8) | (data << 8);
+    }
+    repeatFifo_(data | ((uint32_t)data << 16), count * 2);
+}
+
+/**
+ * @param data uint32_t
+ * @param count uint32_t number of values
+ */
+void SPIClass::fill32(uint32_t data, uint32_t count) {
+    if(!(SPI1C & (SPICWBO | SPICRBO))) {
+        // MSBFIRST Byte first
+        data = __builtin_bswap32(data);
+    }
+    repeatFifo_(data, count * 4);
+}
+
+/**
+ * Send `size` bytes of a 4 bytes pattern: the fifo is loaded once, and as
+ * MOSI only transfers do not overwrite it, each 64 bytes chunk only costs
+ * a command.
+ * @param word uint32_t the pattern, first byte sent in its low byte
+ * @param size uint32_t a multiple of the pattern period
+ */
+void SPIClass::repeatFifo_(uint32_t word, uint32_t size) {
+    if(!size) return;
+
+    while(SPI1CMD & SPIBUSY) {}
+
+    volatile uint32_t * fifoPtr = &SPI1W0;
+    for(uint8_t i = 0; i < 16; i++) {
+        fifoPtr[i] = word;
+    }
+
+    SPI1U = SPIUMOSI | SPIUSSE;
+    if(size >= 64) {
+        setDataBits(64 * 8);
+        while(size >= 64) {
+            SPI1CMD |= SPIBUSY;
+            size -= 64;
+            while(SPI1CMD & SPIBUSY) {}
+        }
+    }
+    if(size) {
+        setDataBits(size * 8);
+        SPI1CMD |= SPIBUSY;
+        while(SPI1CMD & SPIBUSY) {}
+    }
+    SPI1U = SPIUMOSI | SPIUDUPLEX | SPIUSSE;
+}
+
+/**
+ * The next chunk is swapped into a stack buffer while the current one is
+ * sent, so the fifo is reloaded with a plain copy.
+ * @param data uint16_t * (16 bits aligned)
+ * @param count uint32_t number of values
+ */
+void SPIClass::writePixels(const uint16_t * data, uint32_t count) {
+    const bool msb = !(SPI1C & (SPICWBO | SPICRBO));
+    uint32_t buffer[16];
+
+    while(count) {
+        uint8_t pixels = count > 32 ? 32 : count;
+        uint8_t words = (pixels + 1) / 2;
+        for(uint8_t i = 0; i < words; i++) {
+            uint32_t pair = data[0];
+            if(2 * i + 1 < pixels) {
+                pair |= (uint32_t)data[1] << 16;
+            }
+            data += 2;
+            if(msb) {
+                // MSBFIRST Byte first, in both halves
+                pair = ((pair >> 8) & 0x00FF00FF) | ((pair << 8) & 0xFF00FF00);
+            }
+            buffer[i] = pair;
+        }
+        count -= pixels;
+
+        while(SPI1CMD & SPIBUSY) {}
+        setDataBits(pixels * 16);
+        volatile uint32_t * fifoPtr = &SPI1W0;
+        for(uint8_t i = 0; i < words; i++) {
+            fifoPtr[i] = buffer[i];
+        }
+        __sync_synchronize();
+        SPI1CMD |= SPIBUSY;
+    }
+    while(SPI1CMD & SPIBUSY) {}
+}
+
 /**
  * @param out uint8_t *
  * @param in  uint8_t *
@@ -618,6 +720,176 @@ void SPIClass::transferBytes_(const uint8_t * out, uint8_t * in, uint8_t size) {
 }
 
 
+/**
+ * Queued transactions
+ *
+ * The settings of every transaction are turned into register values by
+ * queue(), using the usual setters, so the interrupt only copies them.
+ * The trans-done interrupt (SPISTRIE, also raised in master mode) then
+ * saves the received chunk and loads the next one, or the next transaction.
+ * Once done, the loop side (a recurrent scheduled function) frees the
+ * registers and calls the user.
+ */
+bool SPIClass::queue(SPITransaction * transactions, size_t count, std::function<void(void)> done) {
+    if(queueBusy() || !transactions || !count) {
+        return false;
+    }
+    for(size_t i = 0; i < count; i++) {
+        if(!transactions[i].size) {
+            return false;
+        }
+    }
+
+    QueueRegs * regs = new (std::nothrow) QueueRegs[count];
+    if(!regs) {
+        return false;
+    }
+
+    while(SPI1CMD & SPIBUSY) {}
+    for(size_t i = 0; i < count; i++) {
+        setFrequency(transactions[i].settings._clock);
+        setBitOrder(transactions[i].settings._bitOrder);
+        setDataMode(transactions[i].settings._dataMode);
+        regs[i].clk = SPI1CLK;
+        regs[i].c = SPI1C;
+        regs[i].u = SPI1U;
+        regs[i].p = SPI1P;
+        regs[i].sysClk = GPMUX & (1 << 9);
+        if(transactions[i].cs >= 0) {
+            pinMode(transactions[i].cs, OUTPUT);
+            digitalWrite(transactions[i].cs, HIGH);
+        }
+    }
+
+    if(!schedule_recurrent_function_us([this]() { return !_queueComplete(); }, 0)) {
+        delete[] regs;
+        return false;
+    }
+
+    _queue = transactions;
+    _queueRegs = regs;
+    _queueCount = count;
+    _queueIndex = 0;
+    _queueDone = std::move(done);
+    _queueState = QUEUE_RUNNING;
+
+    ETS_SPI_INTR_DISABLE();
+    ETS_SPI_INTR_ATTACH(_queueIsr, this);
+    SPI1S = SPISTRIE;
+    _queueStart();
+    ETS_SPI_INTR_ENABLE();
+    return true;
+}
+
+// true when the queue has completed and `done` was called
+bool SPIClass::_queueComplete() {
+    if(_queueState != QUEUE_DONE) {
+        return false;
+    }
+
+    delete[] _queueRegs;
+    _queueRegs = nullptr;
+    _queue = nullptr;
+    std::function<void(void)> done = std::move(_queueDone);
+    _queueDone = nullptr;
+    _queueState = QUEUE_IDLE;
+    if(done) {
+        done(); // may queue the next transactions
+    }
+    return true;
+}
+
+void IRAM_ATTR SPIClass::_queueStart() {
+    const QueueRegs & regs = _queueRegs[_queueIndex];
+    if(regs.sysClk) {
+        GPMUX |= (1 << 9);
+    } else {
+        GPMUX &= ~(1 << 9);
+    }
+    SPI1CLK = regs.clk;
+    SPI1C = regs.c;
+    SPI1U = regs.u;
+    SPI1P = regs.p;
+
+    if(_queue[_queueIndex].cs >= 0) {
+        digitalWrite(_queue[_queueIndex].cs, LOW);
+    }
+    _queueOffset = 0;
+    _queueLoad();
+}
+
+// load the next chunk of the current transaction and start it
+void IRAM_ATTR SPIClass::_queueLoad() {
+    const SPITransaction & t = _queue[_queueIndex];
+    uint32_t left = t.size - _queueOffset;
+    _queueChunk = left > 64 ? 64 : left;
+
+    const uint32_t mask = ~((SPIMMOSI << SPILMOSI) | (SPIMMISO << SPILMISO));
+    const uint32_t bits = _queueChunk * 8 - 1;
+    SPI1U1 = ((SPI1U1 & mask) | ((bits << SPILMOSI) | (bits << SPILMISO)));
+
+    volatile uint32_t * fifoPtr = &SPI1W0;
+    const uint8_t words = (_queueChunk + 3) / 4;
+    if(!t.tx) {
+        for(uint8_t i = 0; i < words; i++) {
+            fifoPtr[i] = 0xFFFFFFFF;
+        }
+    } else if(!((uint32_t)t.tx & 3)) {
+        const uint32_t * dataPtr = (const uint32_t*)(t.tx + _queueOffset);
+        for(uint8_t i = 0; i < words; i++) {
+            fifoPtr[i] = dataPtr[i];
+        }
+    } else {
+        const uint8_t * dataPtr = t.tx + _queueOffset;
+        for(uint8_t i = 0; i < words; i++, dataPtr += 4) {
+            fifoPtr[i] = dataPtr[0] | (dataPtr[1] << 8) | (dataPtr[2] << 16) | (dataPtr[3] << 24);
+        }
+    }
+
+    __sync_synchronize();
+    SPI1CMD |= SPIBUSY;
+}
+
+void IRAM_ATTR SPIClass::_queueIsr(void * arg, void * frame) {
+    (void) frame;
+    SPIClass * self = static_cast<SPIClass*>(arg);
+
+    if(!(SPIIR & (1 << SPII1)) || !(SPI1S & SPISTRIS)) {
+        return;
+    }
+    SPI1S &= ~(0x1F); // clear interrupts
+
+    if(self->_queueState != QUEUE_RUNNING) {
+        return;
+    }
+
+    const SPITransaction & t = self->_queue[self->_queueIndex];
+    if(t.rx) {
+        volatile uint8_t * fifoPtrB = (volatile uint8_t *)&SPI1W0;
+        uint8_t * dataPtr = t.rx + self->_queueOffset;
+        for(uint8_t i = 0; i < self->_queueChunk; i++) {
+            dataPtr[i] = fifoPtrB[i];
+        }
+    }
+    self->_queueOffset += self->_queueChunk;
+
+    if(self->_queueOffset < t.size) {
+        self->_queueLoad();
+        return;
+    }
+
+    if(t.cs >= 0) {
+        digitalWrite(t.cs, HIGH);
+    }
+    if(++self->_queueIndex < self->_queueCount) {
+        self->_queueStart();
+        return;
+    }
+
+    SPI1S = 0;
+    self->_queueState = QUEUE_DONE;
+}
+
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_SPI)
 SPIClass SPI;
 #endif
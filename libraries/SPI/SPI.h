@@ -22,6 +22,7 @@
 #define _SPI_H_INCLUDED
 
 #include <Arduino.h>
+#include <functional>
 
 #define SPI_HAS_TRANSACTION 1
 
@@ -49,6 +50,16 @@ public:
   uint8_t  _dataMode;
 };
 
+// One transfer of a queue (SPIClass::queue()), all of its memory must be
+// in RAM and stay valid until the queue completes.
+struct SPITransaction {
+  SPISettings settings;
+  const uint8_t * tx = nullptr; ///< nullptr: 0xFF are sent
+  uint8_t * rx = nullptr;       ///< nullptr: received data are dropped
+  uint32_t size = 0;
+  int8_t cs = -1;               ///< pin driven low during the transfer, -1: none (or hardware CS)
+};
+
 class SPIClass {
 public:
   SPIClass();
@@ -71,12 +82,49 @@ public:
   void write32(uint32_t data, bool msb);
   void writeBytes(const uint8_t * data, uint32_t size);
   void writePattern(const uint8_t * data, uint8_t size, uint32_t repeat);
+  // send `data` `count` times (e.g. a display fill), each value in the byte order of write16()/write32()
+  void fill16(uint16_t data, uint32_t count);
+  void fill32(uint32_t data, uint32_t count);
+  // send `count` 16 bits values (e.g. RGB565 pixels), swapped on the fly like write16()
+  void writePixels(const uint16_t * data, uint32_t count);
   void transferBytes(const uint8_t * out, uint8_t * in, uint32_t size);
   void endTransaction(void);
+
+  // Runs `count` transactions in the background: the SPI interrupt reloads the
+  // 64 bytes hardware buffer after each chunk, the CPU is free meanwhile.
+  // `done` is called from the loop (scheduled function) once they all completed.
+  // False when a queue is already running. Other calls wait for the queue
+  // in beginTransaction(), so use transactions while queues are used.
+  bool queue(SPITransaction * transactions, size_t count, std::function<void(void)> done = nullptr);
+  bool queueBusy() const { return _queueState != QUEUE_IDLE; }
 private:
   bool useHwCs;
   uint8_t pinSet;
+
+  // register values of a transaction, computed by queue()
+  struct QueueRegs {
+    uint32_t clk;
+    uint32_t c;
+    uint32_t u;
+    uint32_t p;
+    bool sysClk;
+  };
+  enum : uint8_t { QUEUE_IDLE, QUEUE_RUNNING, QUEUE_DONE };
+  volatile uint8_t _queueState = QUEUE_IDLE;
+  SPITransaction * _queue = nullptr;
+  QueueRegs * _queueRegs = nullptr;
+  size_t _queueCount = 0;
+  size_t _queueIndex = 0;
+  uint32_t _queueOffset = 0;
+  uint8_t _queueChunk = 0;
+  std::function<void(void)> _queueDone;
+
+  static void _queueIsr(void * arg, void * frame);
+  void _queueStart();
+  void _queueLoad();
+  bool _queueComplete();
   void writeBytes_(const uint8_t * data, uint8_t size);
+  void repeatFifo_(uint32_t word, uint32_t size);
   void transferBytes_(const uint8_t * out, uint8_t * in, uint8_t size);
   void transferBytesAligned_(const uint8_t * out, uint8_t * in, uint8_t size);
   inline void setDataBits(uint16_t bits);
@@ -0,0 +1,66 @@
+/*
+    SPI Slave Queued Demo Sketch
+    Connect the SPI Master device to the following pins on the esp8266:
+
+    GPIO    NodeMCU   Name  |   Uno
+  ===================================
+     15       D8       SS   |   D10
+     13       D7      MOSI  |   D11
+     12       D6      MISO  |   D12
+     14       D5      SCK   |   D13
+
+    In queued mode, no callback is called from the interrupt: the transactions
+    the master writes are kept in a ring and read from loop(), and what the
+    master reads is queued beforehand, so that it can stream many transactions
+    without waiting for the sketch between each.
+
+    This sketch sends an increasing counter and checksums what it receives.
+
+    Note: If the ESP is booting at a moment when the SPI Master has the Select line HIGH (deselected)
+    the ESP8266 WILL FAIL to boot!
+    See SPISlave_SafeMaster example for possible workaround
+
+*/
+
+#include "SPISlave.h"
+
+uint32_t counter = 0;
+uint32_t received = 0;
+uint32_t checksum = 0;
+
+void setup() {
+  Serial.begin(115200);
+
+  // 32 transactions of 32 bytes received, 16 to send
+  if (!SPISlave.beginQueued(32, 16)) {
+    Serial.println("out of memory");
+  }
+}
+
+void loop() {
+  uint8_t data[32];
+  while (SPISlave.read(data)) {
+    for (auto c : data) {
+      checksum += c;
+    }
+    received++;
+  }
+
+  uint32_t status;
+  while (SPISlave.readStatus(status)) {
+    Serial.printf("Status: %u\n", status);
+  }
+
+  // keep the queue full
+  while (SPISlave.queueSpace()) {
+    uint32_t words[8] = { counter++ };
+    SPISlave.queueData((const uint8_t*)words, sizeof(words));
+  }
+
+  static uint32_t last = 0;
+  if (millis() - last > 1000) {
+    last = millis();
+    auto stats = SPISlave.queueStats();
+    Serial.printf("received %u checksum %u, overruns %u underruns %u\n", received, checksum, stats.rxOverruns, stats.txUnderruns);
+  }
+}
@@ -19,6 +19,7 @@
   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 #include "SPISlave.h"
+#include <interrupts.h>
 extern "C" {
 #include "hspi_slave.h"
 }
@@ -69,6 +70,7 @@ void SPISlaveClass::begin() //backwards compatibility
 }
 void SPISlaveClass::begin(uint8_t statusLength)
 {
+    hspi_slave_onDataWords(nullptr);
     hspi_slave_onData(&_s_data_rx);
     hspi_slave_onDataSent(&_s_data_tx);
     hspi_slave_onStatus(&_s_status_rx);
@@ -77,11 +79,142 @@ void SPISlaveClass::begin(uint8_t statusLength)
 }
 void SPISlaveClass::end()
 {
+    hspi_slave_onDataWords(nullptr);
     hspi_slave_onData(nullptr);
     hspi_slave_onDataSent(nullptr);
     hspi_slave_onStatus(nullptr);
     hspi_slave_onStatusSent(nullptr);
     hspi_slave_end();
+    _freeQueues();
+}
+
+void IRAM_ATTR SPISlaveClass::_s_queued_data_rx(void *arg, volatile uint32_t * words)
+{
+    SPISlaveClass* self = reinterpret_cast<SPISlaveClass*>(arg);
+    Transaction transaction;
+    for (int i = 0; i < 8; i++) {
+        transaction.words[i] = words[i];
+    }
+    if (!self->_rxQueue.push(transaction)) {
+        self->_rxOverruns = self->_rxOverruns + 1;
+    }
+}
+
+void IRAM_ATTR SPISlaveClass::_s_queued_data_tx(void *arg)
+{
+    SPISlaveClass* self = reinterpret_cast<SPISlaveClass*>(arg);
+    if (!self->_txLoaded) {
+        self->_txUnderruns = self->_txUnderruns + 1;
+    }
+    self->_txLoaded = false;
+    self->_loadTx();
+}
+
+void IRAM_ATTR SPISlaveClass::_s_queued_status_rx(void *arg, uint32_t data)
+{
+    SPISlaveClass* self = reinterpret_cast<SPISlaveClass*>(arg);
+    if (!self->_statusQueue.push(data)) {
+        self->_rxOverruns = self->_rxOverruns + 1;
+    }
+}
+
+// from the interrupt, or with it masked
+void IRAM_ATTR SPISlaveClass::_loadTx()
+{
+    size_t tail = _txTail;
+    if (_txLoaded || tail == _txHead) {
+        return;
+    }
+    hspi_slave_setDataWords(_txQueue[tail].words);
+    _txTail = (tail + 1 == _txSize) ? 0 : tail + 1;
+    _txLoaded = true;
+}
+
+void SPISlaveClass::_freeQueues()
+{
+    delete[] _rxQueue.buffer();
+    delete[] _statusQueue.buffer();
+    delete[] _txQueue;
+    _rxQueue.init(nullptr, 0);
+    _statusQueue.init(nullptr, 0);
+    _txQueue = nullptr;
+    _txSize = 0;
+}
+
+bool SPISlaveClass::beginQueued(size_t rxQueue, size_t txQueue, uint8_t statusLength)
+{
+    end();
+    // one element of each ring is kept unused
+    Transaction* rx = new (std::nothrow) Transaction[rxQueue + 1];
+    uint32_t* status = new (std::nothrow) uint32_t[rxQueue + 1];
+    _txQueue = new (std::nothrow) Transaction[txQueue + 1];
+    _rxQueue.init(rx, rxQueue + 1);
+    _statusQueue.init(status, rxQueue + 1);
+    if (!rx || !status || !_txQueue) {
+        _freeQueues();
+        return false;
+    }
+    _txSize = txQueue + 1;
+    _txHead = _txTail = 0;
+    _txLoaded = false;
+    _rxOverruns = _txUnderruns = 0;
+
+    hspi_slave_onDataWords(&_s_queued_data_rx);
+    hspi_slave_onDataSent(&_s_queued_data_tx);
+    hspi_slave_onStatus(&_s_queued_status_rx);
+    hspi_slave_onStatusSent(nullptr);
+    hspi_slave_begin(statusLength, this);
+    return true;
+}
+
+size_t SPISlaveClass::available() const
+{
+    return _rxQueue.buffer() ? _rxQueue.available() : 0;
+}
+
+bool SPISlaveClass::read(uint8_t* data)
+{
+    Transaction transaction;
+    if (!_rxQueue.buffer() || !_rxQueue.pop(transaction)) {
+        return false;
+    }
+    memcpy(data, transaction.words, sizeof(transaction.words));
+    return true;
+}
+
+bool SPISlaveClass::readStatus(uint32_t& status)
+{
+    return _statusQueue.buffer() && _statusQueue.pop(status);
+}
+
+size_t SPISlaveClass::queueSpace() const
+{
+    if (!_txSize) {
+        return 0;
+    }
+    size_t head = _txHead;
+    size_t tail = _txTail;
+    return _txSize - 1 - (head >= tail ? head - tail : _txSize - tail + head);
+}
+
+size_t SPISlaveClass::queueData(const uint8_t* data, size_t len)
+{
+    size_t done = 0;
+    while (done < len && queueSpace()) {
+        size_t head = _txHead;
+        Transaction& transaction = _txQueue[head];
+        size_t chunk = std::min(len - done, sizeof(transaction.words));
+        memset(transaction.words, 0, sizeof(transaction.words));
+        memcpy(transaction.words, data + done, chunk);
+        _txHead = (head + 1 == _txSize) ? 0 : head + 1;
+        done += chunk;
+    }
+    if (done && !_txLoaded) {
+        // the master has read all there was, preload this
+        esp8266::InterruptLock lock;
+        _loadTx();
+    }
+    return done;
 }
 void SPISlaveClass::setData(uint8_t * data, size_t len)
 {
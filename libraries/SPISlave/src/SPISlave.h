@@ -23,6 +23,7 @@
 
 #include "Arduino.h"
 #include <functional>
+#include <SpscRing.h>
 
 typedef std::function<void(uint8_t *data, size_t len)> SpiSlaveDataHandler;
 typedef std::function<void(uint32_t status)> SpiSlaveStatusHandler;
@@ -43,6 +44,29 @@ protected:
     static void _s_status_rx(void *arg, uint32_t data);
     static void _s_data_tx(void *arg);
     static void _s_status_tx(void *arg);
+
+    struct Transaction
+    {
+        uint32_t words[8];
+    };
+    static void _s_queued_data_rx(void *arg, volatile uint32_t * words);
+    static void _s_queued_data_tx(void *arg);
+    static void _s_queued_status_rx(void *arg, uint32_t data);
+    void _loadTx();
+    void _freeQueues();
+
+    // written by the interrupt, read from loop()
+    esp8266::SpscRing<Transaction> _rxQueue = { };
+    esp8266::SpscRing<uint32_t> _statusQueue = { };
+    // written from loop(), loaded into the data registers by the interrupt,
+    // [_txTail, _txHead) is queued
+    Transaction* _txQueue = nullptr;
+    size_t _txSize = 0;
+    volatile size_t _txHead = 0;
+    volatile size_t _txTail = 0;
+    volatile bool _txLoaded = false;  // the data registers hold unread queued data
+    volatile uint32_t _rxOverruns = 0;
+    volatile uint32_t _txUnderruns = 0;
 public:
     SPISlaveClass()
         : _data_cb(NULL)
@@ -64,6 +88,31 @@ public:
     void onDataSent(SpiSlaveSentHandler cb);
     void onStatus(SpiSlaveStatusHandler cb);
     void onStatusSent(SpiSlaveSentHandler cb);
+
+    // Queued mode, instead of the callbacks above: the 32 byte transactions
+    // the master writes are put in a ring of rxQueue of them, as well as the
+    // statuses it writes, and read from loop().  The data for the master to
+    // read is queued beforehand, txQueue transactions at most, and the next
+    // one loaded by the interrupt as soon as the master has read one.
+    // false when out of memory.
+    bool beginQueued(size_t rxQueue = 16, size_t txQueue = 8, uint8_t statusLength = 4);
+    size_t available() const;                       // transactions received
+    bool read(uint8_t* data);                       // the next 32 bytes received
+    bool readStatus(uint32_t& status);              // the next status received
+    // queued as 32 byte transactions, the last one zero padded, returns the
+    // bytes queued
+    size_t queueData(const uint8_t* data, size_t len);
+    size_t queueSpace() const;                      // in transactions
+
+    struct QueueStats
+    {
+        uint32_t rxOverruns;    // received with the ring full, lost
+        uint32_t txUnderruns;   // read by the master with nothing queued
+    };
+    QueueStats queueStats() const
+    {
+        return { _rxOverruns, _txUnderruns };
+    }
 };
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_SPISLAVE)
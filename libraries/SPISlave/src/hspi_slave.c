@@ -26,6 +26,7 @@ static void (*_hspi_slave_rx_data_cb)(void * arg, uint8_t * data, uint8_t len) =
 static void (*_hspi_slave_tx_data_cb)(void * arg) = NULL;
 static void (*_hspi_slave_rx_status_cb)(void * arg, uint32_t data) = NULL;
 static void (*_hspi_slave_tx_status_cb)(void * arg) = NULL;
+static void (*_hspi_slave_rx_words_cb)(void * arg, volatile uint32_t * words) = NULL;
 static uint8_t _hspi_slave_buffer[33];
 
 void IRAM_ATTR _hspi_slave_isr_handler(void *arg, void *frame)
@@ -53,7 +54,9 @@ void IRAM_ATTR _hspi_slave_isr_handler(void *arg, void *frame)
             uint32_t s = SPI1WS;
             _hspi_slave_rx_status_cb(arg, s);
         }
-        if((status & SPISWBIS) != 0 && (_hspi_slave_rx_data_cb)) {
+        if((status & SPISWBIS) != 0 && (_hspi_slave_rx_words_cb)) {
+            _hspi_slave_rx_words_cb(arg, &SPI1W(0));
+        } else if((status & SPISWBIS) != 0 && (_hspi_slave_rx_data_cb)) {
             uint8_t i;
             uint32_t data;
             _hspi_slave_buffer[32] = 0;
@@ -148,6 +151,19 @@ void hspi_slave_setData(uint8_t *data, uint8_t len)
     }
 }
 
+void IRAM_ATTR hspi_slave_setDataWords(const uint32_t *words)
+{
+    uint8_t i;
+    for(i=0; i<8; i++) {
+        SPI1W(8 + i) = words[i];
+    }
+}
+
+void hspi_slave_onDataWords(void (*rxw_cb)(void *, volatile uint32_t *))
+{
+    _hspi_slave_rx_words_cb = rxw_cb;
+}
+
 void hspi_slave_onData(void (*rxd_cb)(void *, uint8_t *, uint8_t))
 {
     _hspi_slave_rx_data_cb = rxd_cb;
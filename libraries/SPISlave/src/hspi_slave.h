@@ -35,10 +35,16 @@ void hspi_slave_setStatus(uint32_t status);
 //set the data registers (max 32 bytes at a time)
 void hspi_slave_setData(uint8_t *data, uint8_t len);
 
+//same, from 8 words, callable from the interrupt
+void hspi_slave_setDataWords(const uint32_t *words);
+
 //set the callbacks
 void hspi_slave_onData(void (*rxd_cb)(void *, uint8_t *, uint8_t));
 void hspi_slave_onDataSent(void (*txd_cb)(void *));
 void hspi_slave_onStatus(void (*rxs_cb)(void *, uint32_t));
 void hspi_slave_onStatusSent(void (*txs_cb)(void *));
 
+//called instead of the data callback with the 8 data registers, from the interrupt
+void hspi_slave_onDataWords(void (*rxw_cb)(void *, volatile uint32_t *));
+
 #endif
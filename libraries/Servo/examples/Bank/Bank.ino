@@ -0,0 +1,39 @@
+/* Bank
+  Four servos on one ServoBank, moved together: each frame pulses all of
+  them from the same schedule, and the positions written between
+  beginUpdate() and endUpdate() are taken by the same frame.
+*/
+
+#include <ServoBank.h>
+
+const int pins[] = { 12, 13, 14, 4 };
+const int count = sizeof(pins) / sizeof(pins[0]);
+
+ServoBank bank;
+int channels[count];
+
+void setup() {
+  for (int i = 0; i < count; i++) {
+    channels[i] = bank.attach(pins[i]);
+  }
+}
+
+void loop() {
+  for (int pos = 0; pos <= 180; pos++) {
+    bank.beginUpdate();
+    for (int i = 0; i < count; i++) {
+      // every other servo the opposite way
+      bank.write(channels[i], i & 1 ? 180 - pos : pos);
+    }
+    bank.endUpdate();
+    delay(15);
+  }
+  for (int pos = 180; pos >= 0; pos--) {
+    bank.beginUpdate();
+    for (int i = 0; i < count; i++) {
+      bank.write(channels[i], i & 1 ? 180 - pos : pos);
+    }
+    bank.endUpdate();
+    delay(15);
+  }
+}
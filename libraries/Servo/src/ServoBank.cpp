@@ -0,0 +1,259 @@
+/*
+ServoBank - servos pulsed together from one schedule per frame
+
+Copyright (c) 2020 esp8266/Arduino
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#if defined(ESP8266)
+
+#include <Arduino.h>
+#include <ServoBank.h>
+#include "core_esp8266_waveform.h"
+
+// in Servo.cpp
+int improved_map(int value, int minIn, int maxIn, int minOut, int maxOut);
+
+// the interrupt is asked for this early, and waits the rest
+static constexpr uint32_t leadUs = 2;
+
+ServoBank::Schedule ServoBank::_schedule[2];
+volatile uint8_t ServoBank::_active = 0;
+volatile bool ServoBank::_pending = false;
+uint32_t ServoBank::_frameStart;
+uint32_t ServoBank::_pulseStart;
+uint32_t ServoBank::_frameCycles;
+uint8_t ServoBank::_edge = 0;
+
+ServoBank::ServoBank()
+{
+  for (auto& channel : _channels) {
+    channel.attached = false;
+  }
+}
+
+ServoBank::~ServoBank()
+{
+  end();
+}
+
+int ServoBank::attach(int pin, uint16_t minUs, uint16_t maxUs, int value)
+{
+  if (pin < 0 || pin > 15) {
+    return -1;
+  }
+  int index = -1;
+  for (int i = 0; i < MAX_BANK_SERVOS; i++) {
+    if (_channels[i].attached && _channels[i].pin == pin) {
+      return -1;
+    }
+    if (index < 0 && !_channels[i].attached) {
+      index = i;
+    }
+  }
+  if (index < 0) {
+    return -1;
+  }
+  // one edge per servo and the common one, every frame
+  int servos = 1;
+  for (const auto& channel : _channels) {
+    servos += channel.attached;
+  }
+  if (!setTimer1CallbackLoad((servos + 1) * (1000000UL / REFRESH_INTERVAL))) {
+    return -1;
+  }
+
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, LOW);
+  Channel& channel = _channels[index];
+  channel.attached = true;
+  channel.pin = pin;
+  // same limits as Servo
+  channel.maxUs = max((uint16_t)250, min((uint16_t)3000, maxUs));
+  channel.minUs = max((uint16_t)200, min(channel.maxUs, minUs));
+  channel.valueUs = DEFAULT_NEUTRAL_PULSE_WIDTH;
+
+  if (!_running) {
+    _schedule[_active].setMask = 0;
+    _schedule[_active].count = 0;
+    _pending = false;
+    _edge = 0;
+    _frameCycles = REFRESH_INTERVAL * esp_get_cpu_freq_mhz();
+    _frameStart = esp_get_cycle_count();
+    setTimer1Callback(onTimer);
+    _running = true;
+  }
+  write(index, value);
+  return index;
+}
+
+void ServoBank::detach(int channel)
+{
+  if (attached(channel)) {
+    // its pulse in the current frame ends as scheduled
+    _channels[channel].attached = false;
+    publish();
+  }
+}
+
+void ServoBank::end()
+{
+  if (!_running) {
+    return;
+  }
+  for (auto& channel : _channels) {
+    channel.attached = false;
+  }
+  _holding = 0;
+  publish();
+  delay(2 * REFRESH_INTERVAL / 1000);  // adopted, and the last pulses ended
+  setTimer1Callback(nullptr);
+  _running = false;
+}
+
+void ServoBank::write(int channel, int value)
+{
+  if (!attached(channel)) {
+    return;
+  }
+  // treat any value less than 200 as angle in degrees, as Servo
+  if (value < 200) {
+    value = constrain(value, 0, 180);
+    value = improved_map(value, 0, 180, _channels[channel].minUs, _channels[channel].maxUs);
+  }
+  writeMicroseconds(channel, value);
+}
+
+void ServoBank::writeMicroseconds(int channel, int value)
+{
+  if (!attached(channel)) {
+    return;
+  }
+  Channel& c = _channels[channel];
+  c.valueUs = constrain(value, c.minUs, c.maxUs);
+  if (!_holding) {
+    publish();
+  }
+}
+
+int ServoBank::read(int channel)
+{
+  if (!attached(channel)) {
+    return 0;
+  }
+  return improved_map(readMicroseconds(channel), _channels[channel].minUs, _channels[channel].maxUs, 0, 180);
+}
+
+int ServoBank::readMicroseconds(int channel)
+{
+  return attached(channel) ? _channels[channel].valueUs : 0;
+}
+
+bool ServoBank::attached(int channel)
+{
+  return channel >= 0 && channel < MAX_BANK_SERVOS && _channels[channel].attached;
+}
+
+void ServoBank::beginUpdate()
+{
+  _holding++;
+}
+
+void ServoBank::endUpdate()
+{
+  if (_holding && !--_holding) {
+    publish();
+  }
+}
+
+// The schedule the interrupt doesn't use is rebuilt, and taken at the next
+// frame start.  Until _pending is set again, the interrupt can't switch to it.
+void ServoBank::publish()
+{
+  _pending = false;
+  Schedule& schedule = _schedule[_active ^ 1];
+  uint32_t mhz = esp_get_cpu_freq_mhz();
+
+  schedule.setMask = 0;
+  schedule.count = 0;
+  for (const auto& channel : _channels) {
+    if (!channel.attached) {
+      continue;
+    }
+    uint32_t mask = 1UL << channel.pin;
+    uint32_t at = channel.valueUs * mhz;
+    schedule.setMask |= mask;
+
+    // sorted by time, one edge per pulse width
+    int i = 0;
+    while (i < schedule.count && schedule.edge[i].at < at) {
+      i++;
+    }
+    if (i < schedule.count && schedule.edge[i].at == at) {
+      schedule.edge[i].clearMask |= mask;
+      continue;
+    }
+    for (int j = schedule.count; j > i; j--) {
+      schedule.edge[j] = schedule.edge[j - 1];
+    }
+    schedule.edge[i].at = at;
+    schedule.edge[i].clearMask = mask;
+    schedule.count++;
+  }
+  _frameCycles = REFRESH_INTERVAL * mhz;
+  _pending = true;
+}
+
+uint32_t IRAM_ATTR ServoBank::onTimer()
+{
+  const uint32_t lead = leadUs * esp_get_cpu_freq_mhz();
+  for (;;) {
+    // pulse widths are kept exact, the frame start may be late
+    uint32_t target = _edge ? _pulseStart + _schedule[_active].edge[_edge - 1].at : _frameStart;
+    int32_t left = target - esp_get_cycle_count();
+    if (left > (int32_t)lead) {
+      return left - lead;  // or called for another timer1 user
+    }
+    if (left < -(int32_t)_frameCycles) {
+      // far behind, start a new frame now
+      _frameStart = esp_get_cycle_count();
+      _edge = 0;
+      continue;
+    }
+    while ((int32_t)(target - esp_get_cycle_count()) > 0) {
+    }
+
+    if (!_edge) {
+      // a frame is pulsed from a single schedule
+      if (_pending) {
+        _active ^= 1;
+        _pending = false;
+      }
+      GPOS = _schedule[_active].setMask;
+      _pulseStart = esp_get_cycle_count();
+      _edge = 1;
+    } else {
+      GPOC = _schedule[_active].edge[_edge - 1].clearMask;
+      _edge++;
+    }
+    if (_edge > _schedule[_active].count) {
+      _frameStart += _frameCycles;
+      _edge = 0;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,113 @@
+/*
+  ServoBank.h - servos pulsed together from one schedule per frame
+  Copyright (c) 2020 esp8266/Arduino
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+  */
+
+
+//   Each Servo is a waveform of its own, with two edges per frame to
+//   schedule in the timer1 interrupt.  A ServoBank instead raises all its
+//   pins together at the start of each REFRESH_INTERVAL frame and lowers
+//   them at the end of their pulses, from a schedule sorted beforehand:
+//   one interrupt per frame and one per distinct pulse width, each a
+//   single GPIO register write at its CPU cycle.
+//
+//   Channels are numbered from 0, on GPIO 0 to 15:
+//
+//   ServoBank arm;
+//   int shoulder = arm.attach(12);
+//   int elbow = arm.attach(13);
+//   arm.beginUpdate();                // taken together by the next frame
+//   arm.write(shoulder, 45);
+//   arm.write(elbow, 90);
+//   arm.endUpdate();
+//
+//   There is one bank, which uses the timer1 callback of the waveform
+//   generator (setTimer1Callback()): not together with Wire.queue().  Its
+//   pins can't be used by Servo, analogWrite() or tone().
+
+#ifndef ServoBank_h
+#define ServoBank_h
+
+#include <Arduino.h>
+#include <Servo.h>
+
+#define MAX_BANK_SERVOS 16
+
+class ServoBank
+{
+public:
+    ServoBank();
+    ~ServoBank();
+    // attach the given pin to the next free channel, sets pinMode, min, and max values for write(),
+    // and sets the initial value, the same as write().
+    // returns channel number or -1 if failure.
+    int attach(int pin, uint16_t min = DEFAULT_MIN_PULSE_WIDTH, uint16_t max = DEFAULT_MAX_PULSE_WIDTH,
+               int value = DEFAULT_NEUTRAL_PULSE_WIDTH);
+    void detach(int channel);
+    // the pulses stop at the end of the current frame
+    void end();
+
+    void write(int channel, int value);              // as Servo::write()
+    void writeMicroseconds(int channel, int value);
+    int read(int channel);
+    int readMicroseconds(int channel);
+    bool attached(int channel);
+
+    // writes until endUpdate() take effect together, at the same frame
+    void beginUpdate();
+    void endUpdate();
+
+private:
+    struct Channel
+    {
+        bool     attached;
+        uint8_t  pin;
+        uint16_t minUs;
+        uint16_t maxUs;
+        uint16_t valueUs;
+    };
+
+    struct Schedule
+    {
+        uint32_t setMask;        // raised at frame start
+        uint8_t  count;
+        struct
+        {
+            uint32_t at;         // CPU cycles after frame start
+            uint32_t clearMask;
+        } edge[MAX_BANK_SERVOS];
+    };
+
+    void publish();
+    static uint32_t IRAM_ATTR onTimer();
+
+    Channel  _channels[MAX_BANK_SERVOS];
+    uint8_t  _holding = 0;
+    bool     _running = false;
+
+    // the interrupt uses _schedule[_active], and at a frame start the
+    // other one instead when _pending
+    static Schedule          _schedule[2];
+    static volatile uint8_t  _active;
+    static volatile bool     _pending;
+    static uint32_t          _frameStart;
+    static uint32_t          _pulseStart;    // when the pins were raised
+    static uint32_t          _frameCycles;
+    static uint8_t           _edge;          // next edge, 0 for the frame start
+};
+
+#endif
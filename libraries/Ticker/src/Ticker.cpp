@@ -23,10 +23,230 @@
 #include "eagle_soc.h"
 #include "osapi.h"
 
+#include <algorithm>
+
 #include <Arduino.h>
 #include "Ticker.h"
 
-// ETSTimer is part of the instance, and we don't have any state besides
+// The wheel time is in milliseconds.  Level L has 16 slots, each spanning
+// 16^L ms, and a ticker is kept at the level of the highest hex digit in
+// which its expiry differs from the wheel time, in the slot of that digit
+// of its expiry.  When the wheel time reaches the first ms of a slot of
+// level L > 0, the tickers of that slot are moved down to the lower levels.
+// The expiries of the slots of level 7 wrapping past 2^32 are next round.
+class TickerWheel
+{
+public:
+    static constexpr int LevelBits = 4;
+    static constexpr int Slots = 1 << LevelBits;
+    static constexpr int Levels = 8;
+    // os_timer_arm() limit
+    static constexpr uint32_t ArmMax = 6870947;
+
+    static uint64_t now()
+    {
+        return micros64() / 1000;
+    }
+
+    static void add(Ticker* ticker)
+    {
+        if (!_count) {
+            _now = now();
+        }
+        _count++;
+        _place(ticker);
+        _arm();
+    }
+
+    static void remove(Ticker* ticker)
+    {
+        if (!ticker->_pprev) {
+            return;
+        }
+        *ticker->_pprev = ticker->_next;
+        if (ticker->_next) {
+            ticker->_next->_pprev = ticker->_pprev;
+        }
+        ticker->_next = nullptr;
+        ticker->_pprev = nullptr;
+        int level = ticker->_slot / Slots;
+        int slot = ticker->_slot % Slots;
+        if (!_slots[level][slot]) {
+            _occupied[level] &= ~(1u << slot);
+        }
+        // the timer may fire for nothing, rather than being rearmed each time
+        _count--;
+    }
+
+    static void unschedule(Ticker* ticker)
+    {
+        if (!ticker->_pendingPprev) {
+            return;
+        }
+        *ticker->_pendingPprev = ticker->_pendingNext;
+        if (ticker->_pendingNext) {
+            ticker->_pendingNext->_pendingPprev = ticker->_pendingPprev;
+        }
+        ticker->_pendingNext = nullptr;
+        ticker->_pendingPprev = nullptr;
+    }
+
+    // The callback of ticker is called from loop(), with the ones of the
+    // other tickers due meanwhile
+    static void schedule(Ticker* ticker)
+    {
+        if (!ticker->_pendingPprev) {
+            ticker->_pendingNext = _pending;
+            ticker->_pendingPprev = &_pending;
+            if (_pending) {
+                _pending->_pendingPprev = &ticker->_pendingNext;
+            }
+            _pending = ticker;
+        }
+        if (!_posted) {
+            _posted = schedule_function(_run_pending);
+        }
+    }
+
+private:
+    static void _place(Ticker* ticker)
+    {
+        uint64_t diff = ticker->_expires ^ _now;
+        int level = 0;
+        if (diff >> (Levels * LevelBits)) {
+            level = Levels - 1;
+        } else if (diff) {
+            level = (31 - __builtin_clz((uint32_t)diff)) / LevelBits;
+        }
+        int slot = (ticker->_expires >> (level * LevelBits)) & (Slots - 1);
+        Ticker*& head = _slots[level][slot];
+        ticker->_next = head;
+        ticker->_pprev = &head;
+        if (head) {
+            head->_pprev = &ticker->_next;
+        }
+        head = ticker;
+        ticker->_slot = level * Slots + slot;
+        _occupied[level] |= 1u << slot;
+    }
+
+    // The first time a slot must be fired or moved down
+    static uint64_t _next_event()
+    {
+        uint64_t next = UINT64_MAX;
+        for (int level = 0; level < Levels; level++) {
+            uint32_t occupied = _occupied[level];
+            if (!occupied) {
+                continue;
+            }
+            int shift = level * LevelBits;
+            uint64_t span = 1ull << (shift + LevelBits);
+            uint64_t base = _now & ~(span - 1);
+            uint32_t current = (_now >> shift) & (Slots - 1);
+            uint32_t later = occupied & ~((2u << current) - 1);
+            uint64_t event;
+            if (later) {
+                event = base | ((uint64_t)__builtin_ctz(later) << shift);
+            } else {
+                event = (base + span) | ((uint64_t)__builtin_ctz(occupied) << shift);
+            }
+            next = std::min(next, event);
+        }
+        return next;
+    }
+
+    static void _advance(uint64_t target)
+    {
+        while (_count) {
+            uint64_t next = _next_event();
+            if (next > target) {
+                break;
+            }
+            _now = next;
+            for (int level = Levels - 1; level > 0; level--) {
+                int shift = level * LevelBits;
+                if (_now & ((1ull << shift) - 1)) {
+                    continue;
+                }
+                int slot = (_now >> shift) & (Slots - 1);
+                Ticker* ticker = _slots[level][slot];
+                _slots[level][slot] = nullptr;
+                _occupied[level] &= ~(1u << slot);
+                while (ticker) {
+                    Ticker* next = ticker->_next;
+                    _place(ticker);
+                    ticker = next;
+                }
+            }
+            // callbacks may attach or detach any ticker, pick them one by one
+            Ticker** head = &_slots[0][_now & (Slots - 1)];
+            while (*head) {
+                Ticker* ticker = *head;
+                remove(ticker);
+                ticker->_static_callback();
+            }
+        }
+        _now = std::max(_now, target);
+    }
+
+    static void _arm()
+    {
+        if (!_count) {
+            if (_armed) {
+                os_timer_disarm(&_timer);
+                _armed = false;
+            }
+            return;
+        }
+        uint64_t next = _next_event();
+        if (_armed && next >= _armedAt) {
+            return;
+        }
+        uint64_t current = now();
+        uint32_t delay = (next > current) ? std::min<uint64_t>(next - current, ArmMax) : 1;
+        os_timer_disarm(&_timer);
+        os_timer_setfn(&_timer, [](void*) {
+            _armed = false;
+            _advance(now());
+            _arm();
+        }, nullptr);
+        os_timer_arm(&_timer, delay, false);
+        _armed = true;
+        _armedAt = current + delay;
+    }
+
+    static void _run_pending()
+    {
+        _posted = false;
+        while (_pending) {
+            Ticker* ticker = _pending;
+            unschedule(ticker);
+            ticker->_scheduled_callback();
+        }
+    }
+
+    static Ticker* _slots[Levels][Slots];
+    static uint16_t _occupied[Levels];
+    static size_t _count;
+    static uint64_t _now;
+    static ETSTimer _timer;
+    static bool _armed;
+    static uint64_t _armedAt;
+    static Ticker* _pending;
+    static bool _posted;
+};
+
+Ticker* TickerWheel::_slots[Levels][Slots];
+uint16_t TickerWheel::_occupied[Levels];
+size_t TickerWheel::_count;
+uint64_t TickerWheel::_now;
+ETSTimer TickerWheel::_timer;
+bool TickerWheel::_armed;
+uint64_t TickerWheel::_armedAt;
+Ticker* TickerWheel::_pending;
+bool TickerWheel::_posted;
+
+// The wheel links are part of the instance, and we don't have any state besides
 // the things required for the callback. Allow copies and moves, but
 // disable any member copies and default-init + detach() instead.
 
@@ -59,22 +279,16 @@ Ticker& Ticker::operator=(Ticker&& other) noexcept
 
 void Ticker::_attach(Ticker::Milliseconds milliseconds, bool repeat)
 {
-    if (_timer) {
-        os_timer_disarm(_timer);
-    } else {
-        _timer = &_timer_internal;
-    }
-
-    os_timer_setfn(_timer,
-        [](void* ptr) {
-            reinterpret_cast<Ticker*>(ptr)->_static_callback();
-        }, this);
+    TickerWheel::remove(this);
+    TickerWheel::unschedule(this);
 
     _repeat = repeat;
+    _active = true;
 
     // whenever duration excedes this limit, make timer repeatable N times
     // in case it is really repeatable, it will reset itself and continue as usual
     size_t total = 0;
+    _tick.reset(nullptr);
     if (milliseconds > DurationMax) {
         total = 1;
         while (milliseconds > DurationMax) {
@@ -85,36 +299,59 @@ void Ticker::_attach(Ticker::Milliseconds milliseconds, bool repeat)
             .total = total,
             .count = 0,
         });
-        repeat = true;
     }
 
-    os_timer_arm(_timer, milliseconds.count(), repeat);
+    _interval = std::max<uint32_t>(milliseconds.count(), 1);
+    _expires = TickerWheel::now() + _interval;
+    TickerWheel::add(this);
 }
 
 void Ticker::detach()
 {
-    if (_timer) {
-        os_timer_disarm(_timer);
-        _timer = nullptr;
+    TickerWheel::remove(this);
+    TickerWheel::unschedule(this);
+    if (_active) {
+        _active = false;
         _tick.reset(nullptr);
-        _callback = std::monostate{};
     }
+    _callback = std::monostate{};
 }
 
 bool Ticker::active() const
 {
-    return _timer != nullptr;
+    return _active;
 }
 
+// Called by the wheel, in SYS ctx, once the ticker was taken out of it
 void Ticker::_static_callback()
 {
+    // Repeat from the expiry rather than from now, unless late by more
+    // than the interval
+    _expires = std::max(_expires + _interval, TickerWheel::now() + 1);
+
     if (_tick) {
         ++_tick->count;
         if (_tick->count < _tick->total) {
+            TickerWheel::add(this);
             return;
         }
     }
 
+    if (_scheduled) {
+        TickerWheel::schedule(this);
+        if (_repeat) {
+            if (_tick) {
+                _tick->count = 0;
+            }
+            TickerWheel::add(this);
+        } else {
+            // keep the callback for the scheduled call
+            _active = false;
+            _tick.reset(nullptr);
+        }
+        return;
+    }
+
     // it is technically allowed to call either schedule or detach
     // *during* callback execution. allow both to happen
     decltype(_callback) tmp;
@@ -130,9 +367,9 @@ void Ticker::_static_callback()
     }, tmp);
 
     // ...and move ourselves back only when object is in a valid state
-    // * ticker was not detached, zeroing timer pointer
+    // * ticker was not detached
     // * nothing else replaced callback variant
-    if ((_timer == nullptr) || !std::holds_alternative<std::monostate>(_callback)) {
+    if (!_active || !std::holds_alternative<std::monostate>(_callback)) {
         return;
     }
 
@@ -142,8 +379,25 @@ void Ticker::_static_callback()
         if (_tick) {
             _tick->count = 0;
         }
+        TickerWheel::add(this);
         return;
     }
 
     detach();
 }
+
+// Called from loop() for the *_scheduled() tickers
+void Ticker::_scheduled_callback()
+{
+    decltype(_callback) tmp;
+    std::swap(tmp, _callback);
+
+    if (auto* callback = std::get_if<callback_function_t>(&tmp)) {
+        (*callback)();
+    }
+
+    // keep the callback while attached, unless it was replaced or detached
+    if (_active && std::holds_alternative<std::monostate>(_callback)) {
+        std::swap(tmp, _callback);
+    }
+}
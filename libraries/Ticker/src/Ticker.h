@@ -30,6 +30,16 @@
 #include <Schedule.h>
 #include <ets_sys.h>
 
+class TickerWheel;
+
+// All the tickers share one SDK timer: they are kept in a hierarchical
+// timer wheel, which arms the timer for the first one due and runs all the
+// tickers due at once.  Attaching and detaching take constant time, however
+// many tickers are attached.
+// The callbacks of the *_scheduled() tickers due at once are called from a
+// single scheduled function, a ticker firing again before its callback ran
+// calls it only once.
+
 class Ticker
 {
 public:
@@ -62,9 +72,8 @@ public:
     // callback will be called at following loop() after ticker fires
     void attach_scheduled(float seconds, callback_function_t callback)
     {
-        _callback = [callback]() {
-            schedule_function(callback);
-        };
+        _callback = std::move(callback);
+        _scheduled = true;
         _attach(Seconds(seconds), true);
     }
 
@@ -72,21 +81,22 @@ public:
     void attach(float seconds, callback_function_t callback)
     {
         _callback = std::move(callback);
+        _scheduled = false;
         _attach(Seconds(seconds), true);
     }
 
     // callback will be called at following loop() after ticker fires
     void attach_ms_scheduled(uint32_t milliseconds, callback_function_t callback)
     {
-        _callback = [callback]() {
-            schedule_function(callback);
-        };
+        _callback = std::move(callback);
+        _scheduled = true;
         _attach(Milliseconds(milliseconds), true);
     }
 
     // callback will be called at following yield() after ticker fires
     void attach_ms_scheduled_accurate(uint32_t milliseconds, callback_function_t callback)
     {
+        _scheduled = false;
         _callback = [callback]() {
             schedule_recurrent_function_us([callback]() {
                 callback();
@@ -100,6 +110,7 @@ public:
     void attach_ms(uint32_t milliseconds, callback_function_t callback)
     {
         _callback = std::move(callback);
+        _scheduled = false;
         _attach(Milliseconds(milliseconds), true);
     }
 
@@ -108,6 +119,7 @@ public:
     void attach(float seconds, Func func, Arg arg)
     {
         _callback = make_callback_ptr(func, arg);
+        _scheduled = false;
         _attach(Seconds(seconds), true);
     }
 
@@ -116,13 +128,15 @@ public:
     void attach_ms(uint32_t milliseconds, Func func, Arg arg)
     {
         _callback = make_callback_ptr(func, arg);
+        _scheduled = false;
         _attach(Milliseconds(milliseconds), true);
     }
 
     // callback will be called at following loop() after ticker fires
     void once_scheduled(float seconds, callback_function_t callback)
     {
-        _callback = [callback]() { schedule_function(callback); };
+        _callback = std::move(callback);
+        _scheduled = true;
         _attach(Seconds(seconds), false);
     }
 
@@ -130,13 +144,15 @@ public:
     void once(float seconds, callback_function_t callback)
     {
         _callback = std::move(callback);
+        _scheduled = false;
         _attach(Seconds(seconds), false);
     }
 
     // callback will be called at following loop() after ticker fires
     void once_ms_scheduled(uint32_t milliseconds, callback_function_t callback)
     {
-        _callback = [callback]() { schedule_function(callback); };
+        _callback = std::move(callback);
+        _scheduled = true;
         _attach(Milliseconds(milliseconds), false);
     }
 
@@ -144,6 +160,7 @@ public:
     void once_ms(uint32_t milliseconds, callback_function_t callback)
     {
         _callback = std::move(callback);
+        _scheduled = false;
         _attach(Milliseconds(milliseconds), false);
     }
 
@@ -152,6 +169,7 @@ public:
     void once(float seconds, Func func, Arg arg)
     {
         _callback = make_callback_ptr(func, arg);
+        _scheduled = false;
         _attach(Seconds(seconds), false);
     }
 
@@ -160,6 +178,7 @@ public:
     void once_ms(uint32_t milliseconds, Func func, Arg arg)
     {
         _callback = make_callback_ptr(func, arg);
+        _scheduled = false;
         _attach(Milliseconds(milliseconds), false);
     }
 
@@ -180,9 +199,9 @@ protected:
     // float -> u32 has some precision issues, though
     using Seconds = std::chrono::duration<float, std::ratio<1>>;
 
-    // NONOS SDK timer object duration cannot be longer than 6870947 (0x68D7A3)
-    // when that's the case, we split execution into multiple 'ticks'
-    static constexpr auto DurationMax = Milliseconds(6870947);
+    // The timer wheel spans 2^32 ms, longer durations are split into
+    // multiple 'ticks'
+    static constexpr auto DurationMax = Milliseconds(1u << 30);
 
     struct callback_tick_t
     {
@@ -191,6 +210,7 @@ protected:
     };
 
     void _static_callback();
+    void _scheduled_callback();
 
     void _attach(Milliseconds milliseconds, bool repeat);
     void _attach(Seconds seconds, bool repeat)
@@ -200,10 +220,23 @@ protected:
 
     std::unique_ptr<callback_tick_t> _tick;
     bool _repeat = false;
-
-    ETSTimer* _timer = nullptr;
+    bool _active = false;
+    // callback is called from loop(), _static_callback() only queues it
+    bool _scheduled = false;
 
 private:
+    friend class TickerWheel;
+
+    // Links of the wheel slot, and of the list of the scheduled callbacks
+    // waiting for loop()
+    Ticker* _next = nullptr;
+    Ticker** _pprev = nullptr;
+    Ticker* _pendingNext = nullptr;
+    Ticker** _pendingPprev = nullptr;
+    uint64_t _expires = 0;
+    uint32_t _interval = 0;
+    uint8_t _slot = 0;
+
     struct callback_ptr_t
     {
         callback_with_arg_t func;
@@ -231,5 +264,4 @@ private:
         callback_function_t>;
 
     callback_data_t _callback;
-    ETSTimer _timer_internal{};
 };
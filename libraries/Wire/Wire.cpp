@@ -52,6 +52,7 @@ size_t  TwoWire::txBufferLength = 0;
 uint8_t TwoWire::transmitting = 0;
 void (*TwoWire::user_onRequest)(void);
 void (*TwoWire::user_onReceive)(size_t);
+std::function<void(void)> TwoWire::user_onQueueDone;
 
 static int default_sda_pin = SDA;
 static int default_scl_pin = SCL;
@@ -328,6 +329,61 @@ void TwoWire::onRequest(void (*function)(void))
     twi_enableSlaveMode();
 }
 
+bool TwoWire::queue(twi_transaction_t* transactions, size_t count,
+                    std::function<void(void)> done)
+{
+    if (twi_queueBusy())
+    {
+        return false;
+    }
+    user_onQueueDone = std::move(done);
+    return twi_queue(transactions, count, onQueueDoneService, nullptr);
+}
+
+bool TwoWire::queueBusy()
+{
+    return twi_queueBusy();
+}
+
+size_t TwoWire::transferRegisters(TwoWireRegister* accesses, size_t count)
+{
+    size_t done = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        TwoWireRegister& access = accesses[i];
+        bool             last   = i == count - 1;
+        if (access.read && access.len)
+        {
+            access.status = twi_writeTo(access.address, &access.reg, 1, false);
+            if (!access.status)
+            {
+                access.status = twi_readFrom(access.address, access.buf, access.len, last);
+            }
+            else if (last)
+            {
+                twi_stop();
+            }
+        }
+        else
+        {
+            access.status
+                = twi_writeRegister(access.address, access.reg, access.buf, access.len, last);
+        }
+        done += !access.status;
+    }
+    return done;
+}
+
+void TwoWire::onQueueDoneService(void*)
+{
+    std::function<void(void)> done = std::move(user_onQueueDone);
+    user_onQueueDone               = nullptr;
+    if (done)
+    {
+        done();
+    }
+}
+
 // Preinstantiate Objects //////////////////////////////////////////////////////
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_TWOWIRE)
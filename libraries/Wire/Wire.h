@@ -25,7 +25,9 @@
 #define TwoWire_h
 
 #include <inttypes.h>
+#include <functional>
 #include "Stream.h"
+#include "twi.h"
 
 #ifndef I2C_BUFFER_LENGTH
 // DEPRECATED: Do not use BUFFER_LENGTH, prefer I2C_BUFFER_LENGTH
@@ -33,6 +35,17 @@
 #define I2C_BUFFER_LENGTH BUFFER_LENGTH
 #endif
 
+// One register access of TwoWire::transferRegisters()
+struct TwoWireRegister
+{
+    uint8_t  address;      // device
+    uint8_t  reg;          // first register
+    bool     read;         // true: read len bytes into buf, false: write them from buf
+    uint8_t* buf;          // caller owned, any length
+    size_t   len;
+    uint8_t  status = 0;   // when done: the endTransmission() codes
+};
+
 class TwoWire: public Stream
 {
 private:
@@ -50,6 +63,8 @@ private:
     static void (*user_onReceive)(size_t);
     static void onRequestService(void);
     static void onReceiveService(uint8_t*, size_t);
+    static std::function<void(void)> user_onQueueDone;
+    static void onQueueDoneService(void*);
 
 public:
     TwoWire();
@@ -83,6 +98,17 @@ public:
     void           onReceive(void (*)(size_t));  // legacy esp8266 backward compatibility
     void           onRequest(void (*)(void));
 
+    // Runs the transactions in the background (see twi_queue()), `done` is
+    // called from the loop once they completed, with their status filled
+    bool queue(twi_transaction_t* transactions, size_t count,
+               std::function<void(void)> done = nullptr);
+    bool queueBusy();
+
+    // Runs all the accesses in one go, linked by repeated starts (a single
+    // stop at the end), straight from and to their buffers.
+    // Returns the number of accesses whose status is 0.
+    size_t transferRegisters(TwoWireRegister* accesses, size_t count);
+
     using Print::write;
 };
 
@@ -0,0 +1,92 @@
+/**
+   This example compares the speed of libb64, which base64::encode() used to wrap, with the table driven
+   base64::encodeTo() and base64::decodeTo(), and reports cycles per byte.
+   Both implementations must produce the same output, a mismatch is reported as an error.
+*/
+
+#include <Arduino.h>
+#include <base64.h>
+#include <libb64/cencode.h>
+#include <libb64/cdecode.h>
+
+constexpr size_t dataLength = 768;
+constexpr unsigned rounds = 16;
+
+uint8_t data[dataLength];
+char libb64Text[base64_encode_expected_len_nonewlines(dataLength) + 1];
+char text[base64::encodedLength(dataLength)];
+uint8_t decoded[dataLength];
+
+void report(const __FlashStringHelper *name, uint32_t cycles) {
+  unsigned centiCycles = (uint64_t)cycles * 100 / ((uint64_t)dataLength * rounds);
+  Serial.printf_P(PSTR("%-24s %4u.%02u cycles/byte\n"), String(name).c_str(), centiCycles / 100, centiCycles % 100);
+}
+
+void benchmarkEncode() {
+  size_t libb64Length = 0;
+  uint32_t start = ESP.getCycleCount();
+  for (unsigned i = 0; i < rounds; ++i) {
+    base64_encodestate state;
+    base64_init_encodestate_nonewlines(&state);
+    libb64Length = base64_encode_block((const char*)data, dataLength, libb64Text, &state);
+    libb64Length += base64_encode_blockend(libb64Text + libb64Length, &state);
+  }
+  report(F("encode libb64"), ESP.getCycleCount() - start);
+
+  size_t length = 0;
+  start = ESP.getCycleCount();
+  for (unsigned i = 0; i < rounds; ++i) {
+    length = base64::encodeTo(data, dataLength, text);
+  }
+  report(F("encode base64::encodeTo"), ESP.getCycleCount() - start);
+
+  start = ESP.getCycleCount();
+  for (unsigned i = 0; i < rounds; ++i) {
+    base64::encode(data, dataLength, false);
+  }
+  report(F("encode base64::encode"), ESP.getCycleCount() - start);
+
+  if (length != libb64Length || memcmp(text, libb64Text, length) != 0) {
+    Serial.println(F("ERROR: encoded results differ"));
+  }
+}
+
+void benchmarkDecode() {
+  int libb64Length = 0;
+  uint32_t start = ESP.getCycleCount();
+  for (unsigned i = 0; i < rounds; ++i) {
+    base64_decodestate state;
+    base64_init_decodestate(&state);
+    libb64Length = base64_decode_block(text, sizeof(text), (char*)decoded, &state);
+  }
+  report(F("decode libb64"), ESP.getCycleCount() - start);
+  if (libb64Length != (int)dataLength || memcmp(decoded, data, dataLength) != 0) {
+    Serial.println(F("ERROR: libb64 result differs"));
+  }
+
+  memset(decoded, 0, sizeof(decoded));
+  ssize_t length = 0;
+  start = ESP.getCycleCount();
+  for (unsigned i = 0; i < rounds; ++i) {
+    length = base64::decodeTo(text, sizeof(text), decoded, sizeof(decoded));
+  }
+  report(F("decode base64::decodeTo"), ESP.getCycleCount() - start);
+  if (length != (ssize_t)dataLength || memcmp(decoded, data, dataLength) != 0) {
+    Serial.println(F("ERROR: base64::decodeTo result differs"));
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  for (size_t i = 0; i < dataLength; ++i) {
+    data[i] = RANDOM_REG32;
+  }
+
+  benchmarkEncode();
+  benchmarkDecode();
+}
+
+void loop() {
+}
@@ -0,0 +1,109 @@
+/**
+   This example compares the speed of the generic BearSSL SHA-256 and ChaCha20 code with the optimized kernels
+   used by the ESP8266 Crypto implementation (see CRYPTO_OPTIMIZED_KERNELS in Crypto.h), and reports cycles per byte.
+   Both implementations must produce the same output, a mismatch is reported as an error.
+
+   Rebuild with -DCRYPTO_KERNELS_IN_IRAM=1 (e.g. in a build.opt file) to measure the kernels running from IRAM.
+*/
+
+#include <Arduino.h>
+#include <Crypto.h>
+#include <bearssl/bearssl.h>
+
+using namespace experimental::crypto;
+
+constexpr size_t dataLength = 1024;
+constexpr unsigned rounds = 16;
+
+uint8_t data[dataLength];
+
+const uint8_t key[ENCRYPTION_KEY_LENGTH] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+const uint8_t iv[12] = { 9, 10, 11, 12 };
+
+void report(const __FlashStringHelper *name, uint32_t cycles) {
+  unsigned centiCycles = (uint64_t)cycles * 100 / ((uint64_t)dataLength * rounds);
+  Serial.printf_P(PSTR("%-24s %4u.%02u cycles/byte\n"), String(name).c_str(), centiCycles / 100, centiCycles % 100);
+}
+
+void benchmarkSHA256() {
+  uint8_t bearsslHash[32];
+  uint8_t kernelHash[32];
+  br_sha256_context context;
+
+  uint32_t start = ESP.getCycleCount();
+  for (unsigned i = 0; i < rounds; ++i) {
+    br_sha256_init(&context);
+    br_sha256_update(&context, data, dataLength);
+    br_sha256_out(&context, bearsslHash);
+  }
+  report(F("SHA-256 BearSSL"), ESP.getCycleCount() - start);
+
+  start = ESP.getCycleCount();
+  for (unsigned i = 0; i < rounds; ++i) {
+    sha256Init(&context);
+    sha256Update(&context, data, dataLength);
+    sha256Out(&context, kernelHash);
+  }
+  report(F("SHA-256 kernel"), ESP.getCycleCount() - start);
+
+  if (memcmp(bearsslHash, kernelHash, sizeof kernelHash) != 0) {
+    Serial.println(F("ERROR: SHA-256 results differ"));
+  }
+}
+
+void benchmarkChaCha20() {
+  static uint8_t copy[dataLength];
+  memcpy(copy, data, dataLength);
+
+  uint32_t start = ESP.getCycleCount();
+  for (unsigned i = 0; i < rounds; ++i) {
+    br_chacha20_ct_run(key, iv, i, data, dataLength);
+  }
+  report(F("ChaCha20 BearSSL"), ESP.getCycleCount() - start);
+
+  start = ESP.getCycleCount();
+  for (unsigned i = 0; i < rounds; ++i) {
+    chacha20Run(key, iv, i, data, dataLength);
+  }
+  report(F("ChaCha20 kernel"), ESP.getCycleCount() - start);
+
+  // Every block was XORed with the same key stream twice, once by each implementation
+  if (memcmp(data, copy, dataLength) != 0) {
+    Serial.println(F("ERROR: ChaCha20 results differ"));
+  }
+}
+
+void benchmarkHMAC() {
+  uint8_t hmac[SHA256::NATURAL_LENGTH];
+
+  uint32_t start = ESP.getCycleCount();
+  for (unsigned i = 0; i < rounds; ++i) {
+    SHA256::hmac(data, dataLength, key, sizeof key, hmac, sizeof hmac);
+  }
+  report(F("HMAC-SHA-256 Crypto"), ESP.getCycleCount() - start);
+
+  uint8_t tag[16];
+  uint8_t nonce[12];
+  start = ESP.getCycleCount();
+  for (unsigned i = 0; i < rounds; ++i) {
+    ChaCha20Poly1305::encrypt(data, dataLength, key, nullptr, 0, nonce, tag);
+  }
+  report(F("ChaCha20Poly1305 Crypto"), ESP.getCycleCount() - start);
+}
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  for (size_t i = 0; i < dataLength; ++i) {
+    data[i] = i * 7;
+  }
+
+  Serial.printf_P(PSTR("%u bytes, %u rounds, CPU at %u MHz\n"), (unsigned)dataLength, rounds, ESP.getCpuFreqMHz());
+  benchmarkSHA256();
+  benchmarkChaCha20();
+  benchmarkHMAC();
+}
+
+void loop() {
+}
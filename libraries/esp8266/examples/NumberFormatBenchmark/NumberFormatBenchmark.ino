@@ -0,0 +1,137 @@
+/**
+   This example measures the decimal formatting used by Print, String and dtostrf() against newlib's snprintf(),
+   and reports cycles per conversion.  The values are spread over the whole range so that short and long numbers
+   are both counted, and every conversion is checked against snprintf(), a mismatch is reported as an error.
+*/
+
+#include <Arduino.h>
+
+constexpr unsigned count = 64;
+
+uint32_t values32[count];
+uint64_t values64[count];
+float valuesFloat[count];
+
+// counts what is printed, so that print() is measured without any output
+class NullPrint: public Print {
+  public:
+    size_t written = 0;
+    size_t write(uint8_t) override {
+      ++written;
+      return 1;
+    }
+    size_t write(const uint8_t*, size_t size) override {
+      written += size;
+      return size;
+    }
+};
+
+NullPrint sink;
+
+void report(const __FlashStringHelper *name, uint32_t cycles) {
+  Serial.printf_P(PSTR("%-24s %6u cycles/conversion\n"), String(name).c_str(), cycles / count);
+}
+
+void check(const __FlashStringHelper *name, const char* got, const char* expected) {
+  if (strcmp(got, expected) != 0) {
+    Serial.printf_P(PSTR("ERROR: %s gives %s instead of %s\n"), String(name).c_str(), got, expected);
+  }
+}
+
+void benchmarkIntegers() {
+  char buf[24];
+
+  uint32_t start = ESP.getCycleCount();
+  for (unsigned i = 0; i < count; ++i) {
+    snprintf(buf, sizeof(buf), "%u", values32[i]);
+  }
+  report(F("snprintf(uint32)"), ESP.getCycleCount() - start);
+
+  start = ESP.getCycleCount();
+  for (unsigned i = 0; i < count; ++i) {
+    ultoa(values32[i], buf, 10);
+  }
+  report(F("ultoa(uint32)"), ESP.getCycleCount() - start);
+
+  start = ESP.getCycleCount();
+  for (unsigned i = 0; i < count; ++i) {
+    sink.print(values32[i]);
+  }
+  report(F("print(uint32)"), ESP.getCycleCount() - start);
+
+  start = ESP.getCycleCount();
+  for (unsigned i = 0; i < count; ++i) {
+    snprintf(buf, sizeof(buf), "%llu", values64[i]);
+  }
+  report(F("snprintf(uint64)"), ESP.getCycleCount() - start);
+
+  start = ESP.getCycleCount();
+  for (unsigned i = 0; i < count; ++i) {
+    sink.print(values64[i]);
+  }
+  report(F("print(uint64)"), ESP.getCycleCount() - start);
+
+  for (unsigned i = 0; i < count; ++i) {
+    char expected[24];
+    snprintf(expected, sizeof(expected), "%u", values32[i]);
+    check(F("ultoa"), ultoa(values32[i], buf, 10), expected);
+    snprintf(expected, sizeof(expected), "%llu", values64[i]);
+    check(F("String(uint64)"), String(values64[i]).c_str(), expected);
+  }
+}
+
+void benchmarkFloats() {
+  char buf[32];
+
+  uint32_t start = ESP.getCycleCount();
+  for (unsigned i = 0; i < count; ++i) {
+    snprintf(buf, sizeof(buf), "%.2f", valuesFloat[i]);
+  }
+  report(F("snprintf(float, 2)"), ESP.getCycleCount() - start);
+
+  start = ESP.getCycleCount();
+  for (unsigned i = 0; i < count; ++i) {
+    dtostrf(valuesFloat[i], 0, 2, buf);
+  }
+  report(F("dtostrf(float, 2)"), ESP.getCycleCount() - start);
+
+  start = ESP.getCycleCount();
+  for (unsigned i = 0; i < count; ++i) {
+    sink.print(valuesFloat[i]);
+  }
+  report(F("print(float)"), ESP.getCycleCount() - start);
+
+  start = ESP.getCycleCount();
+  for (unsigned i = 0; i < count; ++i) {
+    String str(valuesFloat[i]);
+  }
+  report(F("String(float)"), ESP.getCycleCount() - start);
+
+  for (unsigned i = 0; i < count; ++i) {
+    char expected[32];
+    // dtostrf() rounds halves up, the values are picked to stay away from them
+    snprintf(expected, sizeof(expected), "%.2f", valuesFloat[i]);
+    check(F("dtostrf"), dtostrf(valuesFloat[i], 0, 2, buf), expected);
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  uint64_t big = 1;
+  for (unsigned i = 0; i < count; ++i) {
+    values32[i] = RANDOM_REG32 >> (i % 32);
+    values64[i] = (((uint64_t)RANDOM_REG32 << 32) | RANDOM_REG32) >> (i % 64);
+    // up to 5 integer digits and .251, exact enough in a float to never fall on a rounding half
+    big = (i % 8) ? big * 7 : 1;
+    valuesFloat[i] = (float)(big % 100000) + 0.251f;
+  }
+
+  benchmarkIntegers();
+  benchmarkFloats();
+  Serial.printf_P(PSTR("%u characters printed\n"), sink.written);
+}
+
+void loop() {
+}
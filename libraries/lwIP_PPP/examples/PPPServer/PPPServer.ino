@@ -36,6 +36,10 @@
 #define RX 13  // d1mini D7
 #define TX 15  // d1mini D8
 
+// For higher rates (up to 921600 baud), use the UART: its receive buffer is
+// given to lwIP with no copy.  Before begin(), size it for a few ms of data:
+//   HardwareSerial& ppplink = Serial; ... ppplink.setRxBufferSize(2048);
+// and move the logger to Serial1.
 SoftwareSerial ppplink(RX, TX);
 HardwareSerial& logger = Serial;
 PPPServer ppp(&ppplink);
@@ -18,18 +18,40 @@
 
 PPPServer::PPPServer(Stream* sio) : _sio(sio), _cb(netif_status_cb_s), _enabled(false) { }
 
+void PPPServer::input(const void* data, size_t len)
+{
+    _stats.rxBytes += len;
+    _stats.rxBlocks++;
+    if (len > _stats.rxMaxBlock)
+    {
+        _stats.rxMaxBlock = len;
+    }
+    pppos_input(_ppp, (u8_t*)data, len);
+}
+
 bool PPPServer::handlePackets()
 {
     size_t avail;
-    if ((avail = _sio->available()) > 0)
+    if (_sio->hasPeekBufferAPI())
+    {
+        // what is there, up to the buffer wrapping around, then what was
+        // behind it - but no more, lwIP has other things to do
+        for (int block = 0; block < 2 && (avail = _sio->peekAvailable()) > 0; block++)
+        {
+            _stats.polls += !block;
+            input(_sio->peekBuffer(), avail);
+            _sio->peekConsume(avail);
+        }
+    }
+    else if ((avail = _sio->available()) > 0)
     {
-        // XXX block peeking would be useful here
-        if (avail > _bufsize)
+        if (avail > _bufalloc)
         {
-            avail = _bufsize;
+            avail = _bufalloc;
         }
-        avail = _sio->readBytes(_buf, avail);
-        pppos_input(_ppp, _buf, avail);
+        _stats.polls++;
+        avail = _sio->readBytes(_buf.get(), avail);
+        input(_buf.get(), avail);
     }
     return _enabled;
 }
@@ -131,8 +153,11 @@ void PPPServer::link_status_cb_s(ppp_pcb* pcb, int err_code, void* ctx)
 u32_t PPPServer::output_cb_s(ppp_pcb* pcb, u8_t* data, u32_t len, void* ctx)
 {
     (void)pcb;
-    (void)ctx;
-    return static_cast<PPPServer*>(ctx)->_sio->write(data, len);
+    PPPServer* ppp     = static_cast<PPPServer*>(ctx);
+    size_t     written = ppp->_sio->write(data, len);
+    ppp->_stats.txBytes += written;
+    ppp->_stats.txDropped += len - written;
+    return written;
 }
 
 void PPPServer::netif_status_cb_s(netif* nif)
@@ -154,6 +179,16 @@ bool PPPServer::begin(const IPAddress& ourAddress, const IPAddress& peer)
 {
     // lwip2-src/doc/ppp.txt
 
+    if (!_sio->hasPeekBufferAPI() && _bufalloc != _bufsize)
+    {
+        _buf.reset(new (std::nothrow) uint8_t[_bufsize]);
+        _bufalloc = _buf ? _bufsize : 0;
+        if (!_buf)
+        {
+            return false;
+        }
+    }
+
     _ppp = pppos_create(&_netif, PPPServer::output_cb_s, PPPServer::link_status_cb_s, this);
     if (!_ppp)
     {
@@ -32,6 +32,7 @@
 
 #include <Arduino.h>
 #include <IPAddress.h>
+#include <memory>
 #include <lwip/netif.h>
 #include <netif/ppp/ppp.h>
 #include <netif/ppp/pppos.h>
@@ -44,6 +45,34 @@ public:
     bool begin(const IPAddress& ourAddress, const IPAddress& peer = IPAddress(172, 31, 255, 254));
     void stop();
 
+    // Streams with the peekBuffer API (HardwareSerial) are given to lwIP
+    // straight from their receive buffer, in blocks as large as it holds:
+    // size it for the baud rate with setRxBufferSize() before begin().
+    // Other streams are copied through a buffer of this size (default 128),
+    // applied by the next begin().
+    void setBufferSize(size_t size)
+    {
+        _bufsize = size;
+    }
+
+    struct Stats
+    {
+        uint32_t rxBytes;
+        uint32_t rxBlocks;     // pppos_input() calls
+        uint32_t rxMaxBlock;   // largest of them
+        uint32_t txBytes;
+        uint32_t txDropped;    // bytes the stream didn't take
+        uint32_t polls;        // with received data
+    };
+    const Stats& stats() const
+    {
+        return _stats;
+    }
+    void resetStats()
+    {
+        _stats = { };
+    }
+
     void ifUpCb(void (*cb)(netif*))
     {
         _cb = cb;
@@ -54,16 +83,19 @@ public:
     }
 
 protected:
-    static constexpr size_t _bufsize = 128;
-    Stream*                 _sio;
-    ppp_pcb*                _ppp;
-    netif                   _netif;
+    Stream*  _sio;
+    ppp_pcb* _ppp;
+    netif    _netif;
     void (*_cb)(netif*);
-    uint8_t _buf[_bufsize];
-    bool    _enabled;
+    std::unique_ptr<uint8_t[]> _buf;
+    size_t                     _bufsize = 128;  // requested
+    size_t                     _bufalloc = 0;   // size of _buf
+    bool                       _enabled;
+    Stats                      _stats = { };
 
     // feed ppp from stream - to call on a regular basis or on interrupt
     bool handlePackets();
+    void input(const void* data, size_t len);
 
     static u32_t output_cb_s(ppp_pcb* pcb, u8_t* data, u32_t len, void* ctx);
     static void  link_status_cb_s(ppp_pcb* pcb, int err_code, void* ctx);
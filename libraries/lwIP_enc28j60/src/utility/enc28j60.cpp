@@ -69,6 +69,9 @@ void serial_printf(const char* fmt, ...)
 #define ECON2 0x1e
 #define ECON1 0x1f
 
+#define EIE_PKTIE 0x40
+#define EIE_INTIE 0x80
+
 #define ESTAT_CLKRDY 0x01
 #define ESTAT_TXABRT 0x02
 
@@ -257,14 +260,11 @@ void ENC28J60::setregbank(uint8_t new_bank)
 /*---------------------------------------------------------------------------*/
 void ENC28J60::writedata(const uint8_t* data, int datalen)
 {
-    int i;
     enc28j60_arch_spi_select();
     /* The Write Buffer Memory (WBM) command is 0 1 1 1 1 0 1 0  */
     SPI.transfer(0x7a);
-    for (i = 0; i < datalen; i++)
-    {
-        SPI.transfer(data[i]);
-    }
+    /* In bursts of the 64 bytes FIFO */
+    SPI.writeBytes(data, datalen);
     enc28j60_arch_spi_deselect();
 }
 /*---------------------------------------------------------------------------*/
@@ -275,16 +275,13 @@ void ENC28J60::writedatabyte(uint8_t byte)
 /*---------------------------------------------------------------------------*/
 int ENC28J60::readdata(uint8_t* buf, int len)
 {
-    int i;
     enc28j60_arch_spi_select();
     /* THe Read Buffer Memory (RBM) command is 0 0 1 1 1 0 1 0 */
     SPI.transfer(0x3a);
-    for (i = 0; i < len; i++)
-    {
-        buf[i] = SPI.transfer(0);
-    }
+    /* In bursts of the 64 bytes FIFO, a null buf skips the data */
+    SPI.transferBytes(nullptr, buf, len);
     enc28j60_arch_spi_deselect();
-    return i;
+    return len;
 }
 /*---------------------------------------------------------------------------*/
 uint8_t ENC28J60::readdatabyte(void)
@@ -544,10 +541,26 @@ boolean ENC28J60::begin(const uint8_t* address)
 
 /*---------------------------------------------------------------------------*/
 
+void ENC28J60::interruptEnable()
+{
+    // EIR.PKTIF is set as long as EPKTCNT is not 0
+    setregbitfield(EIE, EIE_INTIE | EIE_PKTIE);
+}
+
+/*---------------------------------------------------------------------------*/
+
 uint16_t ENC28J60::sendFrame(const uint8_t* data, uint16_t datalen)
 {
-    uint16_t dataend;
+    if (!sendFrameBegin(datalen))
+    {
+        return 0;
+    }
+    sendFrameData(data, datalen);
+    return sendFrameEnd();
+}
 
+bool ENC28J60::sendFrameBegin(uint16_t datalen)
+{
     /*
         1. Appropriately program the ETXST pointer to point to an unused
          location in memory. It will point to the per packet control
@@ -581,7 +594,20 @@ uint16_t ENC28J60::sendFrame(const uint8_t* data, uint16_t datalen)
         configuration (the values in MACON3) will be used.  */
     writedatabyte(0x00); /* MACON3 */
 
+    _txLen = datalen;
+    return true;
+}
+
+void ENC28J60::sendFrameData(const uint8_t* data, uint16_t datalen)
+{
+    /* EWRPT goes on from the previous part */
     writedata(data, datalen);
+}
+
+uint16_t ENC28J60::sendFrameEnd()
+{
+    uint16_t dataend;
+    uint16_t datalen = _txLen;
 
     /* Write a pointer to the last data byte. */
     dataend = TX_BUF_START + datalen;
@@ -609,16 +635,13 @@ uint16_t ENC28J60::sendFrame(const uint8_t* data, uint16_t datalen)
         readdata(tsv, sizeof(tsv));
         writereg(ERDPTL, erdpt & 0xff);
         writereg(ERDPTH, erdpt >> 8);
-        PRINTF("enc28j60: tx err: %d: %02x:%02x:%02x:%02x:%02x:%02x\n"
+        PRINTF("enc28j60: tx err: %d\n"
                "                  tsv: %02x%02x%02x%02x%02x%02x%02x\n",
-               datalen, 0xff & data[0], 0xff & data[1], 0xff & data[2], 0xff & data[3],
-               0xff & data[4], 0xff & data[5], tsv[6], tsv[5], tsv[4], tsv[3], tsv[2], tsv[1],
-               tsv[0]);
+               datalen, tsv[6], tsv[5], tsv[4], tsv[3], tsv[2], tsv[1], tsv[0]);
     }
     else
     {
-        PRINTF("enc28j60: tx: %d: %02x:%02x:%02x:%02x:%02x:%02x\n", datalen, 0xff & data[0],
-               0xff & data[1], 0xff & data[2], 0xff & data[3], 0xff & data[4], 0xff & data[5]);
+        PRINTF("enc28j60: tx: %d\n", datalen);
     }
 #endif
 
@@ -690,10 +713,7 @@ uint16_t ENC28J60::readFrameData(uint8_t* buffer, uint16_t framesize)
         buffer = nullptr;
 
         /* flush rx fifo */
-        for (uint16_t i = 0; i < _len; i++)
-        {
-            readdatabyte();
-        }
+        readdata(nullptr, _len);
     }
     else
     {
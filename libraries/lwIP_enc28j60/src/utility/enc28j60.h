@@ -70,6 +70,27 @@ public:
     */
     virtual uint16_t sendFrame(const uint8_t* data, uint16_t datalen);
 
+    /**
+        Send an Ethernet frame given in parts, like a pbuf chain:
+        sendFrameBegin(), then sendFrameData() for each part, then sendFrameEnd()
+        @param datalen the length of the whole frame
+        @return false if the frame can not be sent
+    */
+    bool sendFrameBegin(uint16_t datalen);
+
+    /**
+        Write the next part of the frame
+        @param data a pointer to the part
+        @param datalen its length
+    */
+    void sendFrameData(const uint8_t* data, uint16_t datalen);
+
+    /**
+        Send the frame written by sendFrameBegin() and sendFrameData()
+        @return the number of bytes transmitted
+    */
+    uint16_t sendFrameEnd();
+
     /**
         Read an Ethernet frame
         @param buffer a pointer to a buffer to write the packet to
@@ -97,9 +118,19 @@ public:
 protected:
     static constexpr bool interruptIsPossible()
     {
-        return false;
+        return true;
     }
 
+    /**
+        Pull INT low while received frames are pending
+    */
+    void interruptEnable();
+
+    /**
+        INT is released by reading all the pending frames
+    */
+    void interruptAcknowledge() { }
+
     /**
         Read an Ethernet frame size
         @return the length of data do receive
@@ -158,6 +189,9 @@ private:
 
     /* readFrame*() state */
     uint16_t _next, _len;
+
+    /* sendFrame*() state */
+    uint16_t _txLen;
 };
 
 #endif /* ENC28J60_H */
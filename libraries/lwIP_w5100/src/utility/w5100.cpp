@@ -326,6 +326,16 @@ uint16_t Wiznet5100::readFrameData(uint8_t* buffer, uint16_t framesize)
 }
 
 uint16_t Wiznet5100::sendFrame(const uint8_t* buf, uint16_t len)
+{
+    if (!sendFrameBegin(len))
+    {
+        return -1;
+    }
+    sendFrameData(buf, len);
+    return sendFrameEnd();
+}
+
+bool Wiznet5100::sendFrameBegin(uint16_t len)
 {
     // Wait for space in the transmit buffer
     while (1)
@@ -333,7 +343,7 @@ uint16_t Wiznet5100::sendFrame(const uint8_t* buf, uint16_t len)
         uint16_t freesize = getSn_TX_FSR();
         if (getSn_SR() == SOCK_CLOSED)
         {
-            return -1;
+            return false;
         }
         if (len <= freesize)
         {
@@ -341,7 +351,17 @@ uint16_t Wiznet5100::sendFrame(const uint8_t* buf, uint16_t len)
         }
     };
 
+    _txLen = len;
+    return true;
+}
+
+void Wiznet5100::sendFrameData(const uint8_t* buf, uint16_t len)
+{
     wizchip_send_data(buf, len);
+}
+
+uint16_t Wiznet5100::sendFrameEnd()
+{
     setSn_CR(Sn_CR_SEND);
 
     while (1)
@@ -361,5 +381,5 @@ uint16_t Wiznet5100::sendFrame(const uint8_t* buf, uint16_t len)
         }
     }
 
-    return len;
+    return _txLen;
 }
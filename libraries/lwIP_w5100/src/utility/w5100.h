@@ -70,6 +70,27 @@ public:
     */
     uint16_t sendFrame(const uint8_t* data, uint16_t datalen);
 
+    /**
+        Send an Ethernet frame given in parts, like a pbuf chain:
+        sendFrameBegin(), then sendFrameData() for each part, then sendFrameEnd()
+        @param datalen the length of the whole frame
+        @return false if the frame can not be sent
+    */
+    bool sendFrameBegin(uint16_t datalen);
+
+    /**
+        Write the next part of the frame
+        @param data a pointer to the part
+        @param datalen its length
+    */
+    void sendFrameData(const uint8_t* data, uint16_t datalen);
+
+    /**
+        Send the frame written by sendFrameBegin() and sendFrameData()
+        @return the number of bytes transmitted
+    */
+    uint16_t sendFrameEnd();
+
     /**
         Read an Ethernet frame
         @param buffer a pointer to a buffer to write the packet to
@@ -145,6 +166,9 @@ private:
     int8_t    _cs;
     uint8_t   _mac_address[6];
 
+    // sendFrame*() state
+    uint16_t _txLen;
+
     /**
         Default function to select chip.
         @note This function help not to access wrong address. If you do not describe this function
@@ -0,0 +1,159 @@
+/*
+    Throughput of an SPI ethernet chip, and what reading and writing its
+    frames costs, to compare chips and SPI clocks.
+
+    Receive, from a host on the same network:
+      TCP: iperf -c <esp ip> -t 10                 (port 5001)
+      UDP: iperf -c <esp ip> -u -b 5M -t 10
+    Send, start a sink on the host, then type 't' (TCP) or 'u' (UDP):
+      TCP: nc -l 5002 > /dev/null
+      UDP: nc -lu 5002 > /dev/null
+    The rate and the interface counters are printed after each transfer.
+*/
+
+#include <SPI.h>
+#include <W5500lwIP.h>
+//or #include <W5100lwIP.h>
+//or #include <ENC28J60lwIP.h>
+
+#include <WiFiClient.h>
+#include <WiFiServer.h>
+#include <WiFiUdp.h>
+
+#define CSPIN 16 // wemos/lolin/nodemcu D0
+#define INTPIN -1 // or the chip's INT pin, to receive on interrupt
+#define SPI_HZ 20000000
+
+const IPAddress sink(192, 168, 1, 10); // host running nc
+const uint16_t rxPort = 5001;
+const uint16_t txPort = 5002;
+const size_t txBytes = 4 * 1024 * 1024;
+
+Wiznet5500lwIP eth(CSPIN, SPI, INTPIN);
+WiFiServer server(rxPort);
+WiFiUDP udp;
+
+uint8_t buf[1460];
+
+void printStats(const char* what, uint64_t count, uint32_t ms) {
+  const EthernetStats& stats = eth.stats();
+  Serial.printf("%s: %u KB in %u ms, %u KB/s\n", what, (unsigned)(count / 1024), ms,
+                ms ? (unsigned)(count / ms * 1000 / 1024) : 0);
+  Serial.printf("  rx: %u frames, %u dropped, %u errors, %u cycles per frame\n",
+                stats.rxFrames, stats.rxDropped, stats.rxErrors,
+                stats.rxFrames ? (unsigned)(stats.rxCycles / stats.rxFrames) : 0);
+  Serial.printf("  tx: %u frames, %u errors, %u cycles per frame\n",
+                stats.txFrames, stats.txErrors,
+                stats.txFrames ? (unsigned)(stats.txCycles / stats.txFrames) : 0);
+  Serial.printf("  %u polls, %u idle, %u cycles per idle poll, %u interrupts\n",
+                stats.polls, stats.idlePolls,
+                stats.idlePolls ? (unsigned)(stats.idleCycles / stats.idlePolls) : 0,
+                stats.interrupts);
+  eth.resetStats();
+}
+
+void sendTcp() {
+  WiFiClient client;
+  if (!client.connect(sink, txPort)) {
+    Serial.println("TCP connection to sink failed");
+    return;
+  }
+  client.setNoDelay(true);
+  eth.resetStats();
+  uint32_t start = millis();
+  size_t sent = 0;
+  while (sent < txBytes && client.connected()) {
+    sent += client.write(buf, sizeof(buf));
+  }
+  client.stop();
+  printStats("TCP tx", sent, millis() - start);
+}
+
+void sendUdp() {
+  eth.resetStats();
+  uint32_t start = millis();
+  size_t sent = 0;
+  while (sent < txBytes) {
+    udp.beginPacket(sink, txPort);
+    udp.write(buf, sizeof(buf));
+    if (udp.endPacket()) {
+      sent += sizeof(buf);
+    } else {
+      yield(); // out of memory, let lwIP send
+    }
+  }
+  printStats("UDP tx", sent, millis() - start);
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  SPI.begin();
+  SPI.setFrequency(SPI_HZ);
+  SPI.setBitOrder(MSBFIRST);
+  SPI.setDataMode(SPI_MODE0);
+  eth.setDefault(); // use ethernet for default route
+  if (!eth.begin()) {
+    Serial.println("ethernet hardware not found ... sleeping");
+    while (1) {
+      delay(1000);
+    }
+  }
+  Serial.print("connecting ethernet");
+  while (!eth.connected()) {
+    Serial.print(".");
+    delay(1000);
+  }
+  Serial.println();
+  Serial.print("ethernet IP address: ");
+  Serial.println(eth.localIP());
+
+  memset(buf, 'x', sizeof(buf));
+  server.begin();
+  udp.begin(rxPort);
+  Serial.println("'t' or 'u' to send to the sink, iperf -c to receive");
+}
+
+void loop() {
+  WiFiClient client = server.accept();
+  if (client) {
+    eth.resetStats();
+    uint64_t received = 0;
+    uint32_t start = millis();
+    while (client.connected() || client.available()) {
+      int len = client.read(buf, sizeof(buf));
+      if (len > 0) {
+        received += len;
+      } else {
+        yield();
+      }
+    }
+    printStats("TCP rx", received, millis() - start);
+  }
+
+  // a UDP stream ends with 2 seconds without datagram
+  static uint64_t udpReceived;
+  static uint32_t udpStart, udpLast;
+  int len = udp.parsePacket();
+  if (len > 0) {
+    if (!udpReceived) {
+      eth.resetStats();
+      udpStart = millis();
+    }
+    udpReceived += len;
+    udpLast = millis();
+    udp.flush();
+  } else if (udpReceived && millis() - udpLast > 2000) {
+    printStats("UDP rx", udpReceived, udpLast - udpStart);
+    udpReceived = 0;
+  }
+
+  switch (Serial.read()) {
+    case 't':
+      sendTcp();
+      break;
+    case 'u':
+      sendUdp();
+      break;
+  }
+}
@@ -60,8 +60,6 @@ uint16_t Wiznet5500::wizchip_read_word(uint8_t block, uint16_t address)
 
 void Wiznet5500::wizchip_read_buf(uint8_t block, uint16_t address, uint8_t* pBuf, uint16_t len)
 {
-    uint16_t i;
-
     wizchip_cs_select();
 
     block |= AccessModeRead;
@@ -69,10 +67,8 @@ void Wiznet5500::wizchip_read_buf(uint8_t block, uint16_t address, uint8_t* pBuf
     wizchip_spi_write_byte((address & 0xFF00) >> 8);
     wizchip_spi_write_byte((address & 0x00FF) >> 0);
     wizchip_spi_write_byte(block);
-    for (i = 0; i < len; i++)
-    {
-        pBuf[i] = wizchip_spi_read_byte();
-    }
+    // in bursts of the 64 bytes FIFO, instead of a transfer per byte
+    _spi.transferBytes(nullptr, pBuf, len);
 
     wizchip_cs_deselect();
 }
@@ -100,8 +96,6 @@ void Wiznet5500::wizchip_write_word(uint8_t block, uint16_t address, uint16_t wo
 void Wiznet5500::wizchip_write_buf(uint8_t block, uint16_t address, const uint8_t* pBuf,
                                    uint16_t len)
 {
-    uint16_t i;
-
     wizchip_cs_select();
 
     block |= AccessModeWrite;
@@ -109,10 +103,7 @@ void Wiznet5500::wizchip_write_buf(uint8_t block, uint16_t address, const uint8_
     wizchip_spi_write_byte((address & 0xFF00) >> 8);
     wizchip_spi_write_byte((address & 0x00FF) >> 0);
     wizchip_spi_write_byte(block);
-    for (i = 0; i < len; i++)
-    {
-        wizchip_spi_write_byte(pBuf[i]);
-    }
+    _spi.writeBytes(pBuf, len);
 
     wizchip_cs_deselect();
 }
@@ -362,8 +353,10 @@ uint16_t Wiznet5500::readFrameSize()
     uint8_t  head[2];
     uint16_t data_len = 0;
 
-    wizchip_recv_data(head, 2);
-    setSn_CR(Sn_CR_RECV);
+    // RX_RD is moved past the header along with the frame
+    _rxPtr = getSn_RX_RD();
+    wizchip_read_buf(BlockSelectRxBuf, _rxPtr, head, 2);
+    _rxPtr += 2;
 
     data_len = head[0];
     data_len = (data_len << 8) + head[1];
@@ -374,13 +367,16 @@ uint16_t Wiznet5500::readFrameSize()
 
 void Wiznet5500::discardFrame(uint16_t framesize)
 {
-    wizchip_recv_ignore(framesize);
+    _rxPtr += framesize;
+    setSn_RX_RD(_rxPtr);
     setSn_CR(Sn_CR_RECV);
 }
 
 uint16_t Wiznet5500::readFrameData(uint8_t* buffer, uint16_t framesize)
 {
-    wizchip_recv_data(buffer, framesize);
+    wizchip_read_buf(BlockSelectRxBuf, _rxPtr, buffer, framesize);
+    _rxPtr += framesize;
+    setSn_RX_RD(_rxPtr);
     setSn_CR(Sn_CR_RECV);
 
 #if 1
@@ -402,6 +398,16 @@ uint16_t Wiznet5500::readFrameData(uint8_t* buffer, uint16_t framesize)
 }
 
 uint16_t Wiznet5500::sendFrame(const uint8_t* buf, uint16_t len)
+{
+    if (!sendFrameBegin(len))
+    {
+        return -1;
+    }
+    sendFrameData(buf, len);
+    return sendFrameEnd();
+}
+
+bool Wiznet5500::sendFrameBegin(uint16_t len)
 {
     // Wait for space in the transmit buffer
     while (1)
@@ -409,7 +415,7 @@ uint16_t Wiznet5500::sendFrame(const uint8_t* buf, uint16_t len)
         uint16_t freesize = getSn_TX_FSR();
         if (getSn_SR() == SOCK_CLOSED)
         {
-            return -1;
+            return false;
         }
         if (len <= freesize)
         {
@@ -417,7 +423,20 @@ uint16_t Wiznet5500::sendFrame(const uint8_t* buf, uint16_t len)
         }
     };
 
-    wizchip_send_data(buf, len);
+    _txPtr = getSn_TX_WR();
+    _txLen = len;
+    return true;
+}
+
+void Wiznet5500::sendFrameData(const uint8_t* buf, uint16_t len)
+{
+    wizchip_write_buf(BlockSelectTxBuf, _txPtr, buf, len);
+    _txPtr += len;
+}
+
+uint16_t Wiznet5500::sendFrameEnd()
+{
+    setSn_TX_WR(_txPtr);
     setSn_CR(Sn_CR_SEND);
 
     while (1)
@@ -437,5 +456,5 @@ uint16_t Wiznet5500::sendFrame(const uint8_t* buf, uint16_t len)
         }
     }
 
-    return len;
+    return _txLen;
 }
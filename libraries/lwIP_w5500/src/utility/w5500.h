@@ -70,6 +70,27 @@ public:
     */
     uint16_t sendFrame(const uint8_t* data, uint16_t datalen);
 
+    /**
+        Send an Ethernet frame given in parts, like a pbuf chain:
+        sendFrameBegin(), then sendFrameData() for each part, then sendFrameEnd()
+        @param datalen the length of the whole frame
+        @return false if the frame can not be sent
+    */
+    bool sendFrameBegin(uint16_t datalen);
+
+    /**
+        Write the next part of the frame
+        @param data a pointer to the part
+        @param datalen its length
+    */
+    void sendFrameData(const uint8_t* data, uint16_t datalen);
+
+    /**
+        Send the frame written by sendFrameBegin() and sendFrameData()
+        @return the number of bytes transmitted
+    */
+    uint16_t sendFrameEnd();
+
     /**
         Read an Ethernet frame
         @param buffer a pointer to a buffer to write the packet to
@@ -100,7 +121,24 @@ public:
 protected:
     static constexpr bool interruptIsPossible()
     {
-        return false;
+        return true;
+    }
+
+    /**
+        Pull INTn low on frame reception, until interruptAcknowledge()
+    */
+    void interruptEnable()
+    {
+        setSn_IMR(Sn_IR_RECV);
+        setSIMR(0x01);  // socket 0
+    }
+
+    /**
+        Release INTn, to be called before reading the received frames
+    */
+    void interruptAcknowledge()
+    {
+        setSn_IR(Sn_IR_RECV);
     }
 
     /**
@@ -150,6 +188,12 @@ private:
     int8_t    _cs;
     uint8_t   _mac_address[6];
 
+    // buffer pointers of the frame being read or written,
+    // written back to the chip once per frame
+    uint16_t _rxPtr;
+    uint16_t _txPtr;
+    uint16_t _txLen;
+
     /**
         Default function to select chip.
         @note This function help not to access wrong address. If you do not describe this function
@@ -557,6 +601,15 @@ private:
         return wizchip_read(BlockSelectCReg, _IMR_);
     }
 
+    /**
+        Set @ref SIMR register
+        @param (uint8_t)simr Value to set @ref SIMR register.
+    */
+    inline void setSIMR(uint8_t simr)
+    {
+        wizchip_write(BlockSelectCReg, SIMR, simr);
+    }
+
     /**
         Set @ref PHYCFGR register
         @param (uint8_t)phycfgr Value to set @ref PHYCFGR register.
@@ -8,6 +8,7 @@ import time
 import argparse
 import serial
 import subprocess
+import json
 
 from importlib.machinery import SourceFileLoader
 
@@ -55,6 +56,7 @@ class BSTestRunner(object):
         self.name = name
         self.mocks = mocks
         self.env_vars = env_vars
+        self.benchmarks = []
 
     def get_test_list(self):
         self.sp.sendline('-1')
@@ -119,7 +121,7 @@ class BSTestRunner(object):
                     if extra_env is not None:
                         self.update_env(extra_env)
                 t_start = time.time()
-                result = self.run_test(index)
+                result = self.run_test(index, name)
                 if name in self.mocks:
                     debug_print('tearing down mocks')
                     try:
@@ -143,7 +145,7 @@ class BSTestRunner(object):
             test_cases += [test_case];
         return TestSuite(self.name, test_cases)
 
-    def run_test(self, index):
+    def run_test(self, index, name):
         self.sp.sendline('{}'.format(index))
         timeout = 20 # 10
         while timeout > 0:
@@ -156,6 +158,7 @@ class BSTestRunner(object):
             return BSTestRunner.BEGINTIMEOUT
         while timeout > 0:
             res = self.sp.expect([r'>>>>>bs_test_check_failure line=(\d+)',
+                            r'>>>>>bs_test_bench name="([^"]*?)" runs=(\d+) min=(\d+) median=(\d+) max=(\d+) heap_delta=(-?\d+)',
                             r'>>>>>bs_test_end line=(\d+) result=(\d+) checks=(\d+) failed_checks=(\d+)',
                             TIMEOUT,
                             EOF,
@@ -165,6 +168,14 @@ class BSTestRunner(object):
             if res == 0:
                 continue
             elif res == 1:
+                m = self.sp.match
+                self.benchmarks.append({'test': name, 'name': m.group(1),
+                                        'runs': int(m.group(2)), 'min': int(m.group(3)),
+                                        'median': int(m.group(4)), 'max': int(m.group(5)),
+                                        'heap_delta': int(m.group(6))})
+                debug_print('benchmark', self.benchmarks[-1])
+                continue
+            elif res == 2:
                 test_result = self.sp.match.group(2)
                 if test_result == '1':
                     return BSTestRunner.SUCCESS
@@ -179,11 +190,11 @@ class BSTestRunner(object):
                                         'Soft WDT',
                                         EOF], timeout=self.reset_timeout)
                     return BSTestRunner.FAIL
-            elif res == 2 or res == 3:
+            elif res == 3 or res == 4:
                 time.sleep(0.1)
                 timeout -= 0.1
                 continue
-            elif res > 3:
+            elif res > 4:
                 return BSTestRunner.CRASH
         if timeout <= 0:
             return BSTestRunner.TIMEOUT
@@ -246,7 +257,7 @@ def spawn_exec(name):
 def run_tests(spawn, name, mocks, env_vars):
     tw = BSTestRunner(spawn, name, mocks, env_vars)
     tw.get_test_list()
-    return tw.run_tests()
+    return tw.run_tests(), tw.benchmarks
 
 def parse_args():
     parser = argparse.ArgumentParser(description='BS test runner')
@@ -256,6 +267,7 @@ def parse_args():
     parser.add_argument('-n', '--name', help='Test run name')
     parser.add_argument('-o', '--output', help='Output JUnit format test report')
     parser.add_argument('-m', '--mock', help='Set python script to use for mocking purposes')
+    parser.add_argument('-b', '--bench-output', help='Output the benchmark results as JSON')
     parser.add_argument('--env-file', help='File containing a list of environment variables to set', type=argparse.FileType('r'))
     return parser.parse_args()
 
@@ -288,10 +300,14 @@ def main():
         mocks_mod = SourceFileLoader('mocks', args.mock).load_module()
         mocks = mock_decorators.env
     with spawn_func(spawn_arg) as sp:
-        ts = run_tests(sp, name, mocks, env_vars)
+        ts, benchmarks = run_tests(sp, name, mocks, env_vars)
         if args.output:
             with open(args.output, "w") as f:
                 TestSuite.to_file(f, [ts], encoding='raw_unicode_escape')
+        if args.bench_output and benchmarks:
+            # cycles are CPU clock cycles on target, nanoseconds on host
+            with open(args.bench_output, "w") as f:
+                json.dump({'name': name, 'benchmarks': benchmarks}, f, indent=2)
         return 0
 
 if __name__ == '__main__':
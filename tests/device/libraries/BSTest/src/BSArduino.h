@@ -74,6 +74,16 @@ inline void fatal()
     ESP.restart();
 }
 
+inline uint32_t bench_cycles()
+{
+    return ESP.getCycleCount();
+}
+
+inline int bench_free_heap()
+{
+    return ESP.getFreeHeap();
+}
+
 }  // namespace bs
 
 #endif  // BS_ARDUINO_H
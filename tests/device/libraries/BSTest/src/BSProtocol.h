@@ -32,6 +32,15 @@ namespace protocol
                   success, checks, failed_checks);
     }
 
+    template<typename IO>
+    void output_bench(IO& io, const char* name, size_t runs, uint32_t min, uint32_t median,
+                      uint32_t max, int heap_delta)
+    {
+        io.printf(BS_LINE_PREFIX
+                  "bench name=\"%s\" runs=%d min=%u median=%u max=%u heap_delta=%d\n",
+                  name, (int)runs, min, median, max, heap_delta);
+    }
+
     template<typename IO>
     void output_menu_begin(IO& io)
     {
@@ -1,7 +1,9 @@
 #ifndef BS_STDIO_H
 #define BS_STDIO_H
 
+#include <stdarg.h>
 #include <stdio.h>
+#include <chrono>
 #include <exception>
 
 namespace bs
@@ -44,6 +46,19 @@ inline void fatal()
     throw std::runtime_error("fatal error");
 }
 
+// nanoseconds stand in for the cycles, the heap isn't tracked
+inline uint32_t bench_cycles()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+inline int bench_free_heap()
+{
+    return 0;
+}
+
 }  // namespace bs
 
 #endif  // BS_STDIO_H
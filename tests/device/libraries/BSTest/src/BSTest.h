@@ -4,6 +4,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <functional>
 #include <stdexcept>
 #include "BSProtocol.h"
@@ -96,7 +97,8 @@ struct Env
     std::function<void(void)>   m_check_pass;
     std::function<void(size_t)> m_check_fail;
     std::function<void(size_t)> m_fail;
-    Registry                    m_registry;
+    std::function<void(const char*, size_t, uint32_t, uint32_t, uint32_t, int)> m_bench;
+    Registry                                                                    m_registry;
 };
 
 extern Env g_env;
@@ -112,6 +114,10 @@ public:
         g_env.m_check_pass = std::bind(&Tself::check_pass, this);
         g_env.m_check_fail = std::bind(&Tself::check_fail, this, std::placeholders::_1);
         g_env.m_fail       = std::bind(&Tself::fail, this, std::placeholders::_1);
+        g_env.m_bench      = std::bind(&Tself::bench, this, std::placeholders::_1,
+                                       std::placeholders::_2, std::placeholders::_3,
+                                       std::placeholders::_4, std::placeholders::_5,
+                                       std::placeholders::_6);
     }
 
     ~Runner()
@@ -119,6 +125,7 @@ public:
         g_env.m_check_pass = 0;
         g_env.m_check_fail = 0;
         g_env.m_fail       = 0;
+        g_env.m_bench      = 0;
     }
 
     void run()
@@ -146,6 +153,12 @@ public:
         bs::fatal();
     }
 
+    void bench(const char* name, size_t runs, uint32_t min, uint32_t median, uint32_t max,
+               int heap_delta)
+    {
+        protocol::output_bench(m_io, name, runs, min, median, max, heap_delta);
+    }
+
 protected:
     bool do_menu()
     {
@@ -226,6 +239,31 @@ inline void require(bool condition, size_t line)
     }
 }
 
+// Run func() runs times, and report the min, median and max of the cycles
+// each run took, and the free heap lost over all of them (positive when
+// func() leaks).  One run before them warms caches and lazy allocations up.
+template<typename Func>
+void benchmark(const char* name, size_t runs, Func&& func)
+{
+    if (!runs)
+    {
+        return;
+    }
+    uint32_t* cycles = new uint32_t[runs];
+    func();
+    int heap = bench_free_heap();
+    for (size_t i = 0; i < runs; ++i)
+    {
+        uint32_t start = bench_cycles();
+        func();
+        cycles[i] = bench_cycles() - start;
+    }
+    int heap_delta = heap - bench_free_heap();
+    std::sort(cycles, cycles + runs);
+    g_env.m_bench(name, runs, cycles[0], cycles[runs / 2], cycles[runs - 1], heap_delta);
+    delete[] cycles;
+}
+
 }  // namespace bs
 
 #define BS_NAME_LINE2(name, line) name##line
@@ -244,6 +282,7 @@ inline void require(bool condition, size_t line)
 #define CHECK(condition) bs::check((condition), __LINE__)
 #define REQUIRE(condition) bs::require((condition), __LINE__)
 #define FAIL() bs::g_env.m_fail(__LINE__)
+#define BENCHMARK(name, runs, func) bs::benchmark((name), (runs), (func))
 
 #define BS_ENV_DECLARE()                                                                           \
     namespace bs                                                                                   \
@@ -3,6 +3,11 @@
 
 BS_ENV_DECLARE();
 
+bool pretest()
+{
+    return true;
+}
+
 int main()
 {
     while (true)
@@ -47,6 +52,18 @@ TEST_CASE("third test which should be skipped", "[.]")
 
 TEST_CASE("this test also runs successfully", "[bluesmoke]") { }
 
+TEST_CASE("benchmarks report their results", "[bluesmoke]")
+{
+    volatile int sum = 0;
+    BENCHMARK("sum", 5, [&]() {
+        for (int i = 0; i < 1000; ++i)
+        {
+            sum += i;
+        }
+    });
+    CHECK(sum == 6 * 499500);
+}
+
 TEST_CASE("environment variables can be set and read from python", "[bluesmoke]")
 {
     const char* res = getenv("VAR_FROM_PYTHON");
@@ -93,6 +93,63 @@ TEST_CASE("WiFi release ClientContext", "[clientcontext]")
     REQUIRE(success >= SUCCESS_GOAL);
 }
 
+TEST_CASE("WiFiClient cork and batching send fewer segments", "[clientcontext]")
+{
+    WiFiClient client;
+    int port;
+    for (port = 8266; port <= 8285; port++)
+        if (client.connect(srv, port))
+            break;
+    REQUIRE(port <= 8285);
+
+    static const char chunk[] = "0123456789";
+    uint32_t writes, segments;
+    client.setNoDelay(true);
+
+    // one segment per small write
+    client.resetWriteStats();
+    for (int i = 0; i < 10; i++)
+    {
+        client.write(chunk, 10);
+        delay(20);
+    }
+    client.getWriteStats(writes, segments);
+    Serial.printf("nodelay: %u writes %u segments\r\n", writes, segments);
+    REQUIRE(writes == 10);
+    REQUIRE(segments == 10);
+
+    // nothing is given to lwIP while corked, acks coming meanwhile
+    client.resetWriteStats();
+    client.setCork(true);
+    for (int i = 0; i < 10; i++)
+    {
+        client.write(chunk, 10);
+        delay(20);
+    }
+    client.getWriteStats(writes, segments);
+    REQUIRE(segments == 0);
+    client.setCork(false);
+    client.getWriteStats(writes, segments);
+    Serial.printf("cork: %u writes %u segments\r\n", writes, segments);
+    REQUIRE(writes == 10);
+    REQUIRE(segments == 1);
+
+    // held until the batch delay elapsed
+    client.resetWriteStats();
+    client.setBatchDelayUs(100000);
+    for (int i = 0; i < 10; i++)
+        client.write(chunk, 10);
+    client.getWriteStats(writes, segments);
+    REQUIRE(segments == 0);
+    delay(200);
+    client.getWriteStats(writes, segments);
+    Serial.printf("batch: %u writes %u segments\r\n", writes, segments);
+    REQUIRE(writes == 10);
+    REQUIRE(segments == 1);
+
+    client.stop();
+}
+
 void loop()
 {
 }
@@ -60,3 +60,53 @@ def teardown_tcpsrv(e):
     running = False
     thread.join()
     return 0
+
+@setup('WiFiClient cork and batching send fewer segments')
+def setup_tcpsink(e):
+
+    global thread
+
+    def run():
+
+        global running
+
+        running = False
+        sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        for port in range(8266, 8285 + 1):
+            try:
+                sock.bind(("0.0.0.0", port))
+                sock.listen(1)
+                running = True
+                break
+            except Exception:
+                print ('port %d busy' % port, file=sys.stderr)
+        if not running:
+            return
+        connection = None
+        while running:
+            readable, writable, errored = select.select([sock] + ([connection] if connection else []), [], [], 1.0)
+            if sock in readable:
+                connection, client_address = sock.accept()
+                print('client connected: %s' % str(client_address), file=sys.stderr)
+            elif connection in readable:
+                # drain what is received until the client closes
+                if not connection.recv(1024):
+                    connection.close()
+                    connection = None
+        if connection:
+            connection.close()
+        sock.close()
+
+    thread = Thread(target=run)
+    thread.start()
+
+@teardown('WiFiClient cork and batching send fewer segments')
+def teardown_tcpsink(e):
+
+    global thread
+    global running
+
+    running = False
+    thread.join()
+    return 0
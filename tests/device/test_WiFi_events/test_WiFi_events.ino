@@ -143,4 +143,63 @@ TEST_CASE("Events are not called if handler is deleted", "[wifi][events]")
     REQUIRE(events == "");
 }
 
+static void onTableConnected(const WiFiEventStationModeConnected& evt, void* context)
+{
+    (void) evt;
+    *static_cast<String*>(context) += "connected,";
+}
+
+static void onTableGotIP(const WiFiEventStationModeGotIP& evt, void* context)
+{
+    *static_cast<String*>(context) += evt.ip.isSet() ? "got_ip," : "no_ip,";
+}
+
+static void onTableAnyEvent(WiFiEvent_t event, void* context)
+{
+    ++static_cast<int*>(context)[event];
+}
+
+TEST_CASE("Table event handlers are called until removed", "[wifi][events]")
+{
+    String events;
+    int counts[WIFI_EVENT_MAX + 1] = { 0 };
+
+    REQUIRE(WiFi.addEventHandler(onTableConnected, &events));
+    REQUIRE(WiFi.addEventHandler(onTableGotIP, &events));
+    REQUIRE(WiFi.addEventHandler(onTableAnyEvent, counts));
+
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(getenv("STA_SSID"), getenv("STA_PASS"));
+    unsigned long start = millis();
+    while (WiFi.status() != WL_CONNECTED) {
+        delay(500);
+        REQUIRE(millis() - start < 5000);
+    }
+    WiFi.disconnect();
+    delay(100);
+
+    REQUIRE(events == "connected,got_ip,");
+    REQUIRE(counts[WIFI_EVENT_STAMODE_CONNECTED] == 1);
+    REQUIRE(counts[WIFI_EVENT_STAMODE_GOT_IP] == 1);
+    REQUIRE(counts[WIFI_EVENT_STAMODE_DISCONNECTED] >= 1);
+
+    WiFi.removeEventHandler(onTableConnected, &events);
+    WiFi.removeEventHandler(onTableGotIP, &events);
+    WiFi.removeEventHandler(onTableAnyEvent, counts);
+    events.clear();
+
+    WiFi.begin(getenv("STA_SSID"), getenv("STA_PASS"));
+    start = millis();
+    while (WiFi.status() != WL_CONNECTED) {
+        delay(500);
+        REQUIRE(millis() - start < 5000);
+    }
+    WiFi.disconnect();
+    delay(100);
+    WiFi.mode(WIFI_OFF);
+
+    REQUIRE(events == "");
+    REQUIRE(counts[WIFI_EVENT_STAMODE_CONNECTED] == 1);
+}
+
 void loop() {}
@@ -0,0 +1,159 @@
+// Core micro-benchmarks on target, each reported by BENCHMARK() as the
+// min/median/max CPU cycles of one run and the heap lost over the runs.
+// `make bench_report` collects them in a JSON file, to compare the
+// results of two core releases on the same board.
+
+#include <Arduino.h>
+#include <BSTest.h>
+#include <ESP8266WiFi.h>
+#include <LittleFS.h>
+#include <StreamDev.h>
+#include <StreamString.h>
+
+BS_ENV_DECLARE();
+
+// the TLS server of test_core_bench.py
+static constexpr uint16_t tlsPort = 8443;
+static constexpr size_t dataSize = 4096;
+static const char flashData[] PROGMEM = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ.-";
+
+void setup()
+{
+    Serial.begin(115200);
+    BS_RUN(Serial);
+}
+
+bool pretest()
+{
+    WiFi.persistent(false);
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(getenv("STA_SSID"), getenv("STA_PASS"));
+    while (WiFi.status() != WL_CONNECTED) {
+        delay(500);
+    }
+    return LittleFS.begin() || (LittleFS.format() && LittleFS.begin());
+}
+
+static String ramData()
+{
+    String s;
+    s.reserve(dataSize);
+    while (s.length() < dataSize) {
+        s += FPSTR(flashData);
+    }
+    return s;
+}
+
+TEST_CASE("String operations", "[bench]")
+{
+    BENCHMARK("String += char x64", 100, []() {
+        String s;
+        for (int i = 0; i < 64; i++) {
+            s += 'x';
+        }
+    });
+    BENCHMARK("String(int) + String(float)", 100, []() {
+        String s = String(123456) + String(3.14159f, 3);
+    });
+    const String text = F("the quick brown fox jumps over the lazy dog");
+    size_t found = 0;
+    BENCHMARK("String replace, indexOf", 100, [&]() {
+        String s = text;
+        s.replace("o", "0");
+        found = s.indexOf("lazy");
+    });
+    CHECK(found == 35);
+}
+
+TEST_CASE("umm_malloc", "[bench]")
+{
+    BENCHMARK("malloc/free 32", 200, []() {
+        void* volatile p = malloc(32);
+        free(p);
+    });
+    BENCHMARK("malloc/free 1024", 200, []() {
+        void* volatile p = malloc(1024);
+        free(p);
+    });
+    static void* blocks[32];
+    BENCHMARK("32 mixed sizes, freed interleaved", 20, []() {
+        for (size_t i = 0; i < 32; i++) {
+            blocks[i] = malloc(16 + (i * 37) % 512);
+        }
+        for (size_t i = 0; i < 32; i += 2) {
+            free(blocks[i]);
+        }
+        for (size_t i = 1; i < 32; i += 2) {
+            free(blocks[i]);
+        }
+    });
+    BENCHMARK("realloc 16 to 2048", 50, []() {
+        void* p = nullptr;
+        for (size_t size = 16; size <= 2048; size *= 2) {
+            p = realloc(p, size);
+        }
+        free(p);
+    });
+}
+
+TEST_CASE("Stream::sendGeneric", "[bench]")
+{
+    String data = ramData();
+    size_t sent = 0;
+    BENCHMARK("StreamConstPtr(ram)->null 4KB", 50, [&]() {
+        StreamConstPtr in(data);
+        sent = in.sendAll(devnull);
+    });
+    CHECK(sent == dataSize);
+    BENCHMARK("StreamConstPtr(flash)->null 64B", 50, [&]() {
+        StreamConstPtr in(FPSTR(flashData), sizeof(flashData) - 1);
+        sent = in.sendAll(devnull);
+    });
+    CHECK(sent == sizeof(flashData) - 1);
+    BENCHMARK("StreamConstPtr->StreamString 4KB", 50, [&]() {
+        StreamConstPtr in(data);
+        StreamString out;
+        sent = in.sendAll(out);
+    });
+    CHECK(sent == dataSize);
+}
+
+TEST_CASE("LittleFS I/O", "[bench]")
+{
+    String data = ramData();
+    size_t done = 0;
+    BENCHMARK("LittleFS write 4KB", 20, [&]() {
+        File f = LittleFS.open("/bench", "w");
+        done = f.write((const uint8_t*)data.c_str(), dataSize);
+    });
+    CHECK(done == dataSize);
+    static uint8_t buf[256];
+    BENCHMARK("LittleFS read 4KB", 20, [&]() {
+        File f = LittleFS.open("/bench", "r");
+        done = 0;
+        while (f.read(buf, sizeof(buf)) == (int)sizeof(buf)) {
+            done += sizeof(buf);
+        }
+    });
+    CHECK(done == dataSize);
+    BENCHMARK("LittleFS open/close", 50, []() {
+        File f = LittleFS.open("/bench", "r");
+    });
+    LittleFS.remove("/bench");
+}
+
+TEST_CASE("TLS handshake", "[bench]")
+{
+    BearSSL::WiFiClientSecure client;
+    client.setInsecure();
+    int connected = 0;
+    BENCHMARK("TLS handshake RSA-2048", 3, [&]() {
+        connected += client.connect(getenv("SERVER_IP"), tlsPort);
+        client.stop();
+    });
+    CHECK(connected == 4);
+}
+
+void loop()
+{
+}
@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include <ESP8266WiFi.h>
 #include <ESP8266WebServer.h>
+#include <StreamString.h>
 #include <ESP8266mDNS.h>
 #include <BSTest.h>
 #include <pgmspace.h>
@@ -95,6 +96,119 @@ TEST_CASE("HTTP GET+POST Parameters", "[HTTPServer]")
     }
 }
 
+TEST_CASE("HTTP request head split across segments", "[HTTPServer]")
+{
+    {
+        siteHits = 0;
+        siteData = "";
+        const char* keys[] = { "X-Long" };
+        server.collectHeaders(keys, 1);
+        server.on("/split", HTTP_GET, [](){
+            siteData = server.header("X-Long") + " " + server.arg("a");
+            siteHits++;
+            server.send(200, "text/plain", String(siteData.length()));
+        });
+        uint32_t startTime = millis();
+        while(siteHits == 0 && (millis() - startTime) < 10000)
+        {
+            MDNS.update();
+            server.handleClient();
+        }
+        // X-Long is longer than HTTP_REQUEST_LINE_LEN
+        REQUIRE(siteHits > 0 && siteData.length() == 602 && siteData.endsWith(" 1"));
+    }
+}
+
+TEST_CASE("HTTP pipelined requests", "[HTTPServer]")
+{
+    {
+        siteHits = 0;
+        siteData = "";
+        server.on("/pipe", HTTP_GET, [](){
+            siteHits++;
+            server.send(200, "text/plain", String(siteHits));
+        });
+        uint32_t startTime = millis();
+        while(siteHits < 3 && (millis() - startTime) < 10000)
+        {
+            MDNS.update();
+            server.handleClient();
+        }
+        REQUIRE(siteHits == 3);
+    }
+}
+
+TEST_CASE("WebSocket echo", "[HTTPServer]")
+{
+    {
+        siteHits = 0;
+        siteData = "";
+        server.onWebSocket("/ws", [](ESP8266WebServer::WebSocketType& client, esp8266webserver::WebSocketEvent event, const uint8_t* data, size_t len) {
+            if (event == esp8266webserver::WS_EVENT_TEXT) {
+                siteData.concat((const char*)data, len);
+                client.sendText(siteData);
+            } else if (event == esp8266webserver::WS_EVENT_DISCONNECT) {
+                siteHits++;
+            }
+        });
+        uint32_t startTime = millis();
+        while(siteHits == 0 && (millis() - startTime) < 10000)
+        {
+            MDNS.update();
+            server.handleClient();
+        }
+        // sent as two fragments, with a ping in between
+        REQUIRE(siteHits > 0 && siteData.equals("hello websocket"));
+    }
+}
+
+TEST_CASE("Server-sent events", "[HTTPServer]")
+{
+    {
+        auto& events = server.onEventSource("/events");
+        uint32_t sent = 0;
+        bool subscribed = false;
+        uint32_t startTime = millis();
+        while((!subscribed || events.count()) && (millis() - startTime) < 10000)
+        {
+            MDNS.update();
+            server.handleClient();
+            if (events.count()) {
+                subscribed = true;
+                if (sent < 3)
+                    sent += events.send(String(sent) + "\nline", "tick", sent + 1);
+            }
+        }
+        // the client disconnects after the third event
+        REQUIRE(subscribed && sent == 3 && events.count() == 0);
+    }
+}
+
+TEST_CASE("HTTP metrics", "[HTTPServer]")
+{
+    {
+        siteHits = 0;
+        server.serveMetrics();
+        server.on("/counted", HTTP_GET, [](){
+            siteHits++;
+            server.send(200, "text/plain", "counted");
+        });
+        uint32_t startTime = millis();
+        // /counted then an unknown uri
+        while((!server.metrics(nullptr) || !server.metrics(nullptr)->requests) && (millis() - startTime) < 10000)
+        {
+            MDNS.update();
+            server.handleClient();
+        }
+        StreamString text;
+        server.writeMetrics(text);
+        REQUIRE(siteHits == 1 && server.metrics(nullptr)->requests == 1);
+        REQUIRE(text.indexOf("http_requests_total{route=\"/counted\"} 1\n") >= 0);
+        REQUIRE(text.indexOf("http_requests_total{route=\"\"} 1\n") >= 0);
+        REQUIRE(text.indexOf("http_response_bytes_total{route=\"/counted\"} ") >= 0);
+    }
+}
+
 #if 0
 TEST_CASE("HTTP Upload", "[HTTPServer]")
 {
@@ -4,7 +4,9 @@ from threading import Thread
 from poster3.encode import MultipartParam
 from poster3.encode import multipart_encode
 from poster3.streaminghttp import register_openers
+import socket
 import sys
+import time
 import urllib
 
 def http_test(res, url, get=None, post=None):
@@ -53,6 +55,133 @@ def setup_http_getpost_params(e):
 def teardown_http_getpost_params(e):
     return 0
 
+@setup('HTTP request head split across segments')
+def setup_http_split_head(e):
+    def testRun():
+        parts = [b'GET /spl', b'it?a=1 HTTP/1.1\r\nHo', b'st: etd.local\r\nX-Long: ' + b'x' * 600 + b'\r\n', b'\r\n']
+        try:
+            s = socket.create_connection(('etd.local', 80), 2)
+            for part in parts:
+                s.sendall(part)
+                time.sleep(0.2)
+            response = s.recv(1024)
+            s.close()
+        except Exception as e:
+            print('testRun: Exception: ', e, file=sys.stderr)
+            return 1
+        return 0 if response.startswith(b'HTTP/1.1 200') else 1
+    Thread(target=testRun).start()
+
+@teardown('HTTP request head split across segments')
+def teardown_http_split_head(e):
+    return 0
+
+@setup('HTTP pipelined requests')
+def setup_http_pipelined(e):
+    def testRun():
+        request = b'GET /pipe HTTP/1.1\r\nHost: etd.local\r\n\r\n'
+        try:
+            s = socket.create_connection(('etd.local', 80), 5)
+            # three requests in one segment, answered in order on the same connection
+            s.sendall(request * 3)
+            response = b''
+            while response.count(b'HTTP/1.1 200') < 3 or not response.endswith(b'3'):
+                data = s.recv(1024)
+                if not data:
+                    break
+                response += data
+            s.close()
+        except Exception as e:
+            print('testRun: Exception: ', e, file=sys.stderr)
+            return 1
+        return 0 if response.count(b'HTTP/1.1 200') == 3 and response.endswith(b'3') else 1
+    Thread(target=testRun).start()
+
+@teardown('HTTP pipelined requests')
+def teardown_http_pipelined(e):
+    return 0
+
+def ws_frame(opcode, payload, fin=True):
+    mask = b'\x12\x34\x56\x78'
+    frame = bytes([(0x80 if fin else 0) | opcode, 0x80 | len(payload)]) + mask
+    return frame + bytes(c ^ mask[i % 4] for i, c in enumerate(payload))
+
+@setup('WebSocket echo')
+def setup_websocket_echo(e):
+    def testRun():
+        try:
+            s = socket.create_connection(('etd.local', 80), 2)
+            s.sendall(b'GET /ws HTTP/1.1\r\nHost: etd.local\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n'
+                      b'Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n')
+            response = b''
+            while b'\r\n\r\n' not in response:
+                response += s.recv(1024)
+            head, rest = response.split(b'\r\n\r\n', 1)
+            # RFC 6455 sample key
+            if not head.startswith(b'HTTP/1.1 101') or b's3pPLMBiTxaQ9kYGzzhZRbK+xOo=' not in head:
+                return 1
+            s.sendall(ws_frame(0x1, b'hello ', False) + ws_frame(0x9, b'p') + ws_frame(0x0, b'websocket'))
+            while len(rest) < 3 + 17:
+                rest += s.recv(1024)
+            s.sendall(ws_frame(0x8, b'\x03\xe8'))
+            s.close()
+        except Exception as e:
+            print('testRun: Exception: ', e, file=sys.stderr)
+            return 1
+        # pong, then the echo
+        return 0 if rest.startswith(b'\x8a\x01p\x81\x0fhello websocket') else 1
+    Thread(target=testRun).start()
+
+@teardown('WebSocket echo')
+def teardown_websocket_echo(e):
+    return 0
+
+@setup('Server-sent events')
+def setup_server_sent_events(e):
+    def testRun():
+        try:
+            s = socket.create_connection(('etd.local', 80), 5)
+            s.sendall(b'GET /events HTTP/1.1\r\nHost: etd.local\r\nAccept: text/event-stream\r\n\r\n')
+            response = b''
+            while response.count(b'event: tick') < 3:
+                data = s.recv(1024)
+                if not data:
+                    break
+                response += data
+            s.close()
+        except Exception as e:
+            print('testRun: Exception: ', e, file=sys.stderr)
+            return 1
+        # chunked stream, one chunk per event
+        ok = (response.startswith(b'HTTP/1.1 200') and b'text/event-stream' in response
+              and b'\r\n\r\n26\r\nevent: tick\nid: 1\ndata: 0\ndata: line\n\n\r\n' in response)
+        return 0 if ok else 1
+    Thread(target=testRun).start()
+
+@teardown('Server-sent events')
+def teardown_server_sent_events(e):
+    return 0
+
+@setup('HTTP metrics')
+def setup_http_metrics(e):
+    def testRun():
+        try:
+            for uri in ['/counted', '/missing']:
+                s = socket.create_connection(('etd.local', 80), 5)
+                s.sendall(b'GET ' + uri.encode() + b' HTTP/1.0\r\nHost: etd.local\r\n\r\n')
+                while s.recv(1024):
+                    pass
+                s.close()
+        except Exception as e:
+            print('testRun: Exception: ', e, file=sys.stderr)
+            return 1
+        return 0
+    Thread(target=testRun).start()
+
+@teardown('HTTP metrics')
+def teardown_http_metrics(e):
+    return 0
+
 #@setup('HTTP Upload')
 #def setup_http_upload(e):
 #    def testRun():
@@ -0,0 +1,124 @@
+// Filesystem workloads on target, one line per case:
+//   <fs> <case> <ops/s> ops/s <us/op> us/op
+// Same workloads as tests/host/fs/bench_fs.cpp, run on the filesystem
+// region of the board (both filesystems format it in turn).  Built with
+// -DFLASH_STATS=1, the flash operations of each filesystem follow.
+
+#include <Arduino.h>
+#include <BSTest.h>
+#include <LittleFS.h>
+
+BS_ENV_DECLARE();
+
+static constexpr size_t fileSize = 64 * 1024;
+static constexpr size_t chunk = 256;
+static constexpr int smallOps = 100;
+static constexpr int dirFiles = 32;
+static constexpr int dirRounds = 10;
+
+void setup()
+{
+    Serial.begin(115200);
+    BS_RUN(Serial);
+}
+
+bool pretest()
+{
+    return true;
+}
+
+template <typename Fn>
+static int bench(const char* fsName, const char* name, int ops, Fn&& run)
+{
+    uint32_t us = micros();
+    int done = run();
+    us = micros() - us;
+    Serial.printf("%-8s %-14s %8u ops/s %8u us/op\n", fsName, name,
+                  us ? (uint32_t)(ops * 1000000ULL / us) : 0, ops ? us / ops : 0);
+    return done;
+}
+
+static void benchFS(FS& fs, const char* fsName)
+{
+    REQUIRE(fs.format());
+    REQUIRE(fs.begin());
+    uint8_t buf[chunk];
+    memset(buf, 'x', sizeof(buf));
+    uint32_t seed = 1;
+    auto rnd = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return seed >> 8;
+    };
+
+    CHECK(bench(fsName, "seq write", fileSize / chunk, [&]() {
+        File f = fs.open("/seq.bin", "w");
+        int n = 0;
+        for (size_t i = 0; i < fileSize; i += chunk) {
+            n += f.write(buf, chunk) == chunk;
+        }
+        return n;
+    }) == fileSize / chunk);
+
+    CHECK(bench(fsName, "seq read", fileSize / chunk, [&]() {
+        File f = fs.open("/seq.bin", "r");
+        int n = 0;
+        while (f.read(buf, chunk) == (int)chunk) {
+            n++;
+        }
+        return n;
+    }) == fileSize / chunk);
+
+    CHECK(bench(fsName, "random write", smallOps, [&]() {
+        int n = 0;
+        for (int i = 0; i < smallOps; i++) {
+            File f = fs.open("/seq.bin", "r+");
+            n += f.seek(rnd() % (fileSize - 16)) && (f.write(buf, 16) == 16);
+        }
+        return n;
+    }) == smallOps);
+
+    CHECK(bench(fsName, "open/close", smallOps, [&]() {
+        int n = 0;
+        for (int i = 0; i < smallOps; i++) {
+            File f = fs.open("/seq.bin", "r");
+            n += !!f;
+            f.close();
+        }
+        return n;
+    }) == smallOps);
+
+    for (int i = 0; i < dirFiles; i++) {
+        File f = fs.open(String("/dir/file") + i, "w");
+        f.write(buf, 16);
+    }
+    CHECK(bench(fsName, "dir list", dirRounds * dirFiles, [&]() {
+        int n = 0;
+        for (int i = 0; i < dirRounds; i++) {
+            Dir dir = fs.openDir("/dir");
+            while (dir.next()) {
+                n++;
+            }
+        }
+        return n;
+    }) == dirRounds * dirFiles);
+    fs.end();
+    flash_stats_print(Serial);
+    flash_stats_reset();
+}
+
+TEST_CASE("LittleFS workloads", "[FS]")
+{
+    benchFS(LittleFS, "LittleFS");
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+TEST_CASE("SPIFFS workloads", "[FS]")
+{
+    benchFS(SPIFFS, "SPIFFS");
+}
+#pragma GCC diagnostic pop
+
+void loop()
+{
+}
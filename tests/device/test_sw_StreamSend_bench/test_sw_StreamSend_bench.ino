@@ -0,0 +1,132 @@
+// Stream::sendGeneric() throughput on target, one line per case:
+//   <case> <bytes> bytes <bytes/s> B/s <cycles/byte> cycles/byte
+// Compare against a previous core to catch send path regressions.
+
+#include <Arduino.h>
+#include <BSTest.h>
+#include <ESP8266WiFi.h>
+#include <LittleFS.h>
+#include <StreamDev.h>
+#include <StreamString.h>
+
+BS_ENV_DECLARE();
+
+static constexpr size_t benchSize = 32 * 1024;
+static const char flashData[] PROGMEM = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ.-";
+
+void setup()
+{
+    Serial.begin(115200);
+    // Serial carries the test protocol, Serial1 (gpio2) receives the Serial case
+    Serial1.begin(921600);
+    BS_RUN(Serial);
+}
+
+bool pretest()
+{
+    WiFi.persistent(false);
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(getenv("STA_SSID"), getenv("STA_PASS"));
+    while (WiFi.status() != WL_CONNECTED) {
+        delay(500);
+    }
+    return LittleFS.begin() || (LittleFS.format() && LittleFS.begin());
+}
+
+template <typename Fn>
+static size_t bench(const char* name, Fn&& sendOnce)
+{
+    uint32_t us = micros();
+    uint32_t cycles = ESP.getCycleCount();
+    size_t sent = sendOnce();
+    cycles = ESP.getCycleCount() - cycles;
+    us = micros() - us;
+    Serial.printf("%-28s %6u bytes %8u B/s %6u.%02u cycles/byte\n",
+                  name, sent, us ? (uint32_t)(sent * 1000000ULL / us) : 0,
+                  sent ? cycles / sent : 0, sent ? (cycles % sent) * 100 / sent : 0);
+    return sent;
+}
+
+static String ramData()
+{
+    String s;
+    s.reserve(benchSize);
+    while (s.length() < benchSize) {
+        s += FPSTR(flashData);
+    }
+    return s;
+}
+
+TEST_CASE("RAM and flash sources", "[StreamSend]")
+{
+    String data = ramData();
+
+    CHECK(bench("StreamConstPtr(ram)->null", [&]() {
+        StreamConstPtr in(data);
+        return in.sendAll(devnull);
+    }) == benchSize);
+
+    CHECK(bench("StreamConstPtr(flash)->null", [&]() {
+        size_t sent = 0;
+        while (sent < benchSize) {
+            StreamConstPtr in(FPSTR(flashData), sizeof(flashData) - 1);
+            sent += in.sendAll(devnull);
+        }
+        return sent;
+    }) == benchSize);
+
+    CHECK(bench("StreamString->Serial1", [&]() {
+        StreamString in;
+        in.reserve(4096);
+        in.concat(data.c_str(), 4096);
+        size_t sent = in.sendAll(Serial1);
+        Serial1.flush();
+        return sent;
+    }) == 4096);
+}
+
+TEST_CASE("File sources and sinks", "[StreamSend]")
+{
+    String data = ramData();
+
+    CHECK(bench("StreamConstPtr->File", [&]() {
+        StreamConstPtr in(data);
+        File f = LittleFS.open("/bench", "w");
+        return in.sendAll(f);
+    }) == benchSize);
+
+    CHECK(bench("File->null", [&]() {
+        File f = LittleFS.open("/bench", "r");
+        return f.sendAll(devnull);
+    }) == benchSize);
+}
+
+TEST_CASE("File to WiFiClient", "[StreamSend]")
+{
+    {
+        String data = ramData();
+        StreamConstPtr in(data);
+        File f = LittleFS.open("/bench", "w");
+        REQUIRE(in.sendAll(f) == benchSize);
+    }
+
+    WiFiClient client;
+    int port;
+    for (port = 8266; port <= 8285; port++) {
+        if (client.connect(getenv("SERVER_IP"), port)) {
+            break;
+        }
+    }
+    REQUIRE(port <= 8285);
+
+    CHECK(bench("File->WiFiClient", [&]() {
+        File f = LittleFS.open("/bench", "r");
+        return f.sendAll(client);
+    }) == benchSize);
+
+    client.stop();
+}
+
+void loop()
+{
+}
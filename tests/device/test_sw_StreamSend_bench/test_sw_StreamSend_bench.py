@@ -0,0 +1,52 @@
+from mock_decorators import setup, teardown
+from threading import Thread
+import socket
+import select
+import sys
+
+running = False
+thread = None
+
+# discard server, the File->WiFiClient case connects to SERVER_IP:8266..8285
+@setup('File to WiFiClient')
+def setup_sink(e):
+    global running
+    global thread
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    for port in range(8266, 8285 + 1):
+        try:
+            sock.bind(("0.0.0.0", port))
+            sock.listen(1)
+            running = True
+            break
+        except Exception:
+            print('port %d busy' % port, file=sys.stderr)
+    if not running:
+        return
+
+    def run():
+        clients = []
+        while running:
+            readable, _, _ = select.select([sock] + clients, [], [], 0.5)
+            for s in readable:
+                if s is sock:
+                    clients.append(sock.accept()[0])
+                elif not s.recv(4096):
+                    clients.remove(s)
+                    s.close()
+        for s in clients:
+            s.close()
+        sock.close()
+
+    thread = Thread(target=run)
+    thread.start()
+
+@teardown('File to WiFiClient')
+def teardown_sink(e):
+    global running
+    running = False
+    if thread:
+        thread.join()
+    return 0
@@ -174,6 +174,23 @@ TEST_CASE("HTTP GET & POST requests", "[HTTPClient]")
         auto httpCode = http.GET();
         REQUIRE(httpCode == 302);
     }
+    {
+        // requests from two HTTPClient objects sharing a connection pool
+        WiFiClient client;
+        HTTPConnectionPool pool;
+        for (int i = 0; i < 2; i++) {
+            HTTPClient http;
+            http.setConnectionPool(&pool);
+            http.begin(client, getenv("SERVER_IP"), 8088, "/");
+            auto httpCode = http.GET();
+            REQUIRE(httpCode == HTTP_CODE_OK);
+            REQUIRE(http.getString() == "hello!!!");
+            http.end();
+        }
+        REQUIRE(pool.size() <= 1);
+        pool.clear();
+        REQUIRE(pool.size() == 0);
+    }
 }
 
 TEST_CASE("HTTPS GET request", "[HTTPClient]")
@@ -77,4 +77,59 @@ TEST_CASE("can schedule SCHEDULED_FN_MAX_COUNT functions", "[schedule]")
     CHECK(counter == SCHEDULED_FN_MAX_COUNT);
 }
 
+TEST_CASE("queue counters track high-water mark and overflow", "[schedule]")
+{
+    scheduled_fn_stats_t before;
+    get_scheduled_functions_stats(before);
+    CHECK(before.count == 0);
+
+    auto fn = [](){};
+    for (int i = 0; i < SCHEDULED_FN_MAX_COUNT; ++i) {
+        CHECK(schedule_function(fn));
+    }
+    CHECK(!schedule_function(fn));
+
+    scheduled_fn_stats_t after;
+    get_scheduled_functions_stats(after);
+    CHECK(after.count == SCHEDULED_FN_MAX_COUNT);
+    CHECK(after.overflow == before.overflow + 1);
+
+    run_scheduled_functions();
+    get_scheduled_functions_stats(after);
+    CHECK(after.count == 0);
+    CHECK(after.max_count == SCHEDULED_FN_MAX_COUNT);
+}
+
+TEST_CASE("higher priority classes are drained first", "[schedule]")
+{
+    int counter = 0;
+    auto fn = [&](int id) {
+        CHECK(id == counter);
+        ++counter;
+    };
+    schedule_function(std::bind(fn, 2), SCHEDULE_PRIORITY_LOW);
+    schedule_function(std::bind(fn, 1), SCHEDULE_PRIORITY_NORMAL);
+    schedule_function(std::bind(fn, 0), SCHEDULE_PRIORITY_HIGH);
+    run_scheduled_functions();
+    CHECK(counter == 3);
+}
+
+TEST_CASE("time budget defers remaining functions", "[schedule]")
+{
+    int counter = 0;
+    auto fn = [&](){
+        delayMicroseconds(2000);
+        ++counter;
+    };
+    set_scheduled_functions_budget_us(1000);
+    for (int i = 0; i < 4; ++i) {
+        CHECK(schedule_function(fn));
+    }
+    run_scheduled_functions();
+    CHECK(counter == 1);
+    set_scheduled_functions_budget_us(0);
+    run_scheduled_functions();
+    CHECK(counter == 4);
+}
+
 void loop(){}
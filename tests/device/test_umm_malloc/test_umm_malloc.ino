@@ -2,6 +2,7 @@
 #include <umm_malloc/umm_malloc.h>
 
 #include <BSTest.h>
+#include <MovableBuffer.h>
 
 BS_ENV_DECLARE();
 
@@ -21,6 +22,39 @@ TEST_CASE("umm_info can be called", "[umm_malloc]")
     umm_info(NULL, 1);
 }
 
+TEST_CASE("MovableBuffer compact moves down and keeps content", "[umm_malloc]")
+{
+    using esp8266::MovableBuffer;
+
+    // low hole, then a movable and a pinned buffer above it
+    void* hole = malloc(256);
+    void* guard = malloc(16);
+    MovableBuffer moving(200);
+    MovableBuffer pinned(200);
+    REQUIRE(hole && guard && moving && pinned);
+    memset(moving.data(), 0x5a, moving.size());
+    uint8_t* before = moving.data();
+    uint8_t* fixed = pinned.data();
+    bool below = (uint8_t*)hole < before;
+    free(hole);
+
+    pinned.pin();
+    size_t moved = MovableBuffer::compact();
+    pinned.unpin();
+
+    // never moves up, and must use the hole when it is below
+    CHECK(moving.data() <= before);
+    CHECK(!below || (moved >= 1 && moving.data() < before));
+    CHECK(pinned.data() == fixed);
+    CHECK(MovableBuffer::count() == 2);
+    bool same = true;
+    for (size_t i = 0; i < moving.size(); i++) {
+        same &= moving.data()[i] == 0x5a;
+    }
+    CHECK(same);
+    free(guard);
+}
+
 void loop()
 {
 }
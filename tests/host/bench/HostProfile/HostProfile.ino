@@ -0,0 +1,195 @@
+/*
+ HostProfile.ino - library workloads to profile on host
+
+ Built and run by "make profile" (emulation, see ../../README.txt), with
+ P=1: -O2 -g, frame pointers, no stack protector.  Each workload repeats
+ what a sketch does all day, to find where the library code spends its
+ time without hardware:
+
+    make profile PROFILER="perf record -g"
+    make profile PROFILER="valgrind --tool=callgrind"
+
+ Cycles are those of ESP.getCycleCount(), host time at F_CPU: the shares
+ of each function in a profile are what matters, not the totals.
+ */
+
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+#include <ESP8266mDNS.h>
+#include <JsonTranslator.h>
+#include <TlvTranslator.h>
+#include <TypeConversionFunctions.h>
+
+#ifndef HOSTPROFILE_PORT
+#define HOSTPROFILE_PORT 18280  // above 1024: not shifted
+#endif
+
+static constexpr uint32_t httpCount = 20000;
+static constexpr uint32_t mdnsCount = 2000;
+static constexpr uint32_t meshCount = 20000;
+static constexpr uint32_t maxWaitMs = 5000;
+
+static void report(const char* name, uint32_t count, uint32_t us, uint32_t cycles)
+{
+    printf("%-24s %8u ops %10.2f us/op %10.0f cycles/op\n", name, count, (double)us / count,
+           (double)cycles / count);
+}
+
+// a form post answered from its arguments and headers, as web UIs do
+static bool profileWebServer()
+{
+    ESP8266WebServer server(HOSTPROFILE_PORT);
+    server.collectHeaders(F("User-Agent"), F("Cookie"));
+    server.on(F("/settings"), HTTP_POST,
+              [&]()
+              {
+                  String page(F("<html><body><p>"));
+                  for (int i = 0; i < server.args(); i++)
+                  {
+                      page += server.argName(i);
+                      page += '=';
+                      page += server.arg(i);
+                      page += F("<br>");
+                  }
+                  page += server.header(F("User-Agent"));
+                  page += F("</p></body></html>");
+                  server.sendHeader(F("Cache-Control"), F("no-cache"));
+                  server.send(200, F("text/html"), page);
+              });
+    server.begin();
+
+    WiFiClient client;
+    if (!client.connect(IPAddress(127, 0, 0, 1), HOSTPROFILE_PORT))
+        return false;
+
+    static const char request[] = "POST /settings?page=wifi HTTP/1.1\r\n"
+                                  "Host: 127.0.0.1\r\n"
+                                  "User-Agent: HostProfile/1.0\r\n"
+                                  "Cookie: session=0123456789abcdef\r\n"
+                                  "Connection: keep-alive\r\n"
+                                  "Content-Type: application/x-www-form-urlencoded\r\n"
+                                  "Content-Length: 51\r\n"
+                                  "\r\n"
+                                  "ssid=home%20network&password=secret&dhcp=1&mode=sta";
+    uint8_t  buf[512];
+    String   response;
+    uint32_t start  = micros();
+    uint32_t cycles = ESP.getCycleCount();
+    for (uint32_t i = 0; i < httpCount; i++)
+    {
+        if (client.write(request, sizeof(request) - 1) != sizeof(request) - 1)
+            return false;
+        // the response ends with the page
+        response.clear();
+        uint32_t wait = millis();
+        while (!response.endsWith(F("</html>")))
+        {
+            server.handleClient();
+            int avail = client.available();
+            if (avail <= 0)
+            {
+                if (millis() - wait > maxWaitMs || !client.connected())
+                    return false;
+                continue;
+            }
+            int len = client.read(buf, std::min((size_t)avail, sizeof(buf)));
+            response.concat((const char*)buf, len);
+        }
+    }
+    cycles = ESP.getCycleCount() - cycles;
+    report("ESP8266WebServer POST", httpCount, micros() - start, cycles);
+
+    client.stop();
+    server.stop();
+    return true;
+}
+
+// a responder with a few services, announcing after each TXT change
+static bool profileMDNS()
+{
+    if (!MDNS.begin("hostprofile"))
+        return false;
+    MDNSResponder::hMDNSService http = MDNS.addService(0, "http", "tcp", 80);
+    MDNSResponder::hMDNSService ota  = MDNS.addService(0, "arduino", "tcp", 8266);
+    MDNS.addServiceTxt(http, "path", "/");
+    MDNS.addServiceTxt(ota, "board", "ESP8266_GENERIC");
+    MDNS.addServiceTxt(ota, "auth_upload", "no");
+
+    uint32_t start  = micros();
+    uint32_t cycles = ESP.getCycleCount();
+    for (uint32_t i = 0; i < mdnsCount; i++)
+    {
+        MDNS.addServiceTxt(http, "count", i);
+        MDNS.announce();
+        MDNS.update();
+    }
+    cycles = ESP.getCycleCount() - cycles;
+    report("MDNSResponder announce", mdnsCount, micros() - start, cycles);
+
+    MDNS.end();
+    return true;
+}
+
+// mesh connection messages, encoded and read back, in JSON then TLV
+static bool profileMesh()
+{
+    namespace TypeCast = MeshTypeConversionFunctions;
+    using namespace JsonTranslator;
+    using TlvTranslator::Tag;
+
+    const uint8_t mac[6] = { 0x2c, 0xf4, 0x32, 0x12, 0x34, 0x56 };
+    const String  nonce  = F("1F2E3D4C5B6A7980");
+    const String  staMac = TypeCast::macToString(mac);
+    uint64_t      ownSK  = 0x0123456789abcdef;
+    uint64_t      peerSK = 0xfedcba9876543210;
+    bool          ok     = true;
+
+    uint32_t start  = micros();
+    uint32_t cycles = ESP.getCycleCount();
+    for (uint32_t i = 0; i < meshCount; i++)
+    {
+        // as Serializer::serializeEncryptedConnection()
+        String json = encode({ FPSTR(jsonConnectionState),
+                               encode({ FPSTR(jsonDuration), String(i), FPSTR(jsonDesync), String(i & 1),
+                                        FPSTR(jsonOwnSessionKey), TypeCast::uint64ToString(ownSK + i),
+                                        FPSTR(jsonPeerSessionKey), TypeCast::uint64ToString(peerSK),
+                                        FPSTR(jsonPeerStaMac), staMac, FPSTR(jsonPeerApMac), staMac }) });
+        uint64_t sk;
+        uint32_t duration;
+        uint8_t  peer[6];
+        ok = getOwnSessionKey(json, sk) && sk == ownSK + i && getDuration(json, duration)
+             && duration == i && getPeerStaMac(json, peer) && ok;
+    }
+    cycles = ESP.getCycleCount() - cycles;
+    report("JsonTranslator", meshCount, micros() - start, cycles);
+
+    start  = micros();
+    cycles = ESP.getCycleCount();
+    for (uint32_t i = 0; i < meshCount; i++)
+    {
+        // as Serializer::createEncryptedConnectionInfo(), tlv
+        String tlv = String(F("ECI:")) + TlvTranslator::tlvMarker;
+        TlvTranslator::append(tlv, Tag::NONCE, nonce);
+        TlvTranslator::append(tlv, Tag::PASSWORD, F("mesh password"));
+        TlvTranslator::append(tlv, Tag::OWN_SESSION_KEY, peerSK, 8);
+        TlvTranslator::append(tlv, Tag::PEER_SESSION_KEY, ownSK + i, 8);
+        uint64_t sk;
+        String   read;
+        ok = getPeerSessionKey(tlv, sk) && sk == ownSK + i && getNonce(tlv, read) && read == nonce && ok;
+    }
+    cycles = ESP.getCycleCount() - cycles;
+    report("TlvTranslator", meshCount, micros() - start, cycles);
+    return ok;
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    bool ok = profileWebServer();
+    ok      = profileMDNS() && ok;
+    ok      = profileMesh() && ok;
+    if (!ok)
+        printf("HostProfile: a workload failed (port %d in use?)\n", HOSTPROFILE_PORT);
+}
+
+void loop() { }
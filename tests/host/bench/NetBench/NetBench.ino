@@ -0,0 +1,191 @@
+/*
+ NetBench.ino - library-level network overhead on host, over loopback
+
+ Built and run by "make netbench" (emulation, see ../../README.txt).
+ Client and server run in the same process through the socket mocks, so the
+ figures measure WiFiClient / WiFiUDP / ESP8266WebServer overhead on top of
+ the host kernel, not the esp8266 throughput. Meant to be compared against a
+ previous build, or run under perf:
+
+    make netbench
+    perf record -g bin/NetBench/NetBench -f -1
+ */
+
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+#include <WiFiUdp.h>
+
+#ifndef NETBENCH_PORT
+#define NETBENCH_PORT 18266  // tcp, tcp+1 (http) and udp (above 1024: not shifted)
+#endif
+
+static constexpr size_t   tcpSize    = 64 * 1024 * 1024;
+static constexpr size_t   tcpChunk   = 4096;
+static constexpr size_t   udpSize    = 512;
+static constexpr uint32_t udpCount   = 100000;
+static constexpr uint32_t httpCount  = 20000;
+static constexpr uint32_t maxWaitMs  = 5000;
+static const IPAddress    loopback(127, 0, 0, 1);
+
+static uint8_t buf[tcpChunk];
+
+static void report(const char* name, uint32_t count, size_t bytes, uint32_t us)
+{
+    double s = us ? us / 1e6 : 1e-6;
+    printf("%-24s %8u ops %10.1f ops/s %8.1f MB/s\n", name, count, count / s, bytes / s / 1e6);
+}
+
+static bool benchTcp()
+{
+    WiFiServer server(NETBENCH_PORT);
+    server.begin();
+
+    WiFiClient client;
+    if (!client.connect(loopback, NETBENCH_PORT))
+        return false;
+
+    WiFiClient peer;
+    for (uint32_t start = millis(); !peer && millis() - start < maxWaitMs;)
+        peer = server.accept();
+    if (!peer)
+        return false;
+
+    memset(buf, 'x', sizeof(buf));
+    size_t   total  = 0;
+    uint32_t writes = 0;
+    uint32_t start  = micros();
+    while (total < tcpSize)
+    {
+        size_t sent = client.write(buf, tcpChunk);
+        if (!sent)
+            return false;
+        writes++;
+        // drain the other side before the next write, the loopback socket
+        // buffers are the only buffers the mocks have
+        for (size_t received = 0; received < sent;)
+        {
+            int avail = peer.available();
+            if (avail > 0)
+                received += peer.read(buf, std::min((size_t)avail, sizeof(buf)));
+            else if (!peer.connected())
+                return false;
+        }
+        total += sent;
+    }
+    report("WiFiClient write/read", writes, total, micros() - start);
+
+    client.stop();
+    peer.stop();
+    server.stop();
+    return true;
+}
+
+static bool benchUdp()
+{
+    WiFiUDP rx, tx;
+    if (!rx.begin(NETBENCH_PORT))
+        return false;
+
+    memset(buf, 'u', udpSize);
+    size_t   total = 0;
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < udpCount; i++)
+    {
+        if (!tx.beginPacket(loopback, NETBENCH_PORT) || tx.write(buf, udpSize) != udpSize || !tx.endPacket())
+            return false;
+        int size;
+        for (uint32_t wait = millis(); !(size = rx.parsePacket());)
+            if (millis() - wait > maxWaitMs)
+                return false;
+        total += rx.read(buf, size);
+    }
+    report("WiFiUDP send/recv", udpCount, total, micros() - start);
+
+    rx.stop();
+    tx.stop();
+    return true;
+}
+
+// sends one keep-alive request and reads the response back, serving it meanwhile
+static size_t httpRequest(ESP8266WebServer& server, WiFiClient& client)
+{
+    static const char request[] = "GET /bench HTTP/1.1\r\n"
+                                  "Host: 127.0.0.1\r\n"
+                                  "Connection: keep-alive\r\n"
+                                  "\r\n";
+    if (client.write(request, sizeof(request) - 1) != sizeof(request) - 1)
+        return 0;
+
+    // headers end with an empty line, Content-Length is the only one we need
+    String   line;
+    size_t   contentLength = 0;
+    size_t   received      = 0;
+    bool     body          = false;
+    uint32_t wait          = millis();
+    while (!body || received < contentLength)
+    {
+        if (!client.available())
+        {
+            if (millis() - wait > maxWaitMs || !client.connected())
+                return 0;
+            server.handleClient();
+            continue;
+        }
+        if (body)
+        {
+            received += client.read(buf, std::min((size_t)client.available(), contentLength - received));
+            continue;
+        }
+        int c = client.read();
+        if (c != '\n')
+        {
+            if (c != '\r')
+                line += (char)c;
+            continue;
+        }
+        if (line.startsWith(F("Content-Length: ")))
+            contentLength = line.substring(16).toInt();
+        body = !line.length();
+        line.clear();
+    }
+    return received;
+}
+
+static bool benchHttp()
+{
+    ESP8266WebServer server(NETBENCH_PORT + 1);
+    String           payload(F("0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"));
+    server.on(F("/bench"), [&]() { server.send(200, F("text/plain"), payload); });
+    server.begin();
+
+    WiFiClient client;
+    if (!client.connect(loopback, NETBENCH_PORT + 1))
+        return false;
+
+    size_t   total = 0;
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < httpCount; i++)
+    {
+        size_t received = httpRequest(server, client);
+        if (received != payload.length())
+            return false;
+        total += received;
+    }
+    report("ESP8266WebServer GET", httpCount, total, micros() - start);
+
+    client.stop();
+    server.stop();
+    return true;
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    bool ok = benchTcp();
+    ok      = benchUdp() && ok;
+    ok      = benchHttp() && ok;
+    if (!ok)
+        printf("NetBench: a benchmark failed (port %d in use?)\n", NETBENCH_PORT);
+}
+
+void loop() { }
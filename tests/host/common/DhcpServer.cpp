@@ -13,6 +13,13 @@ bool DhcpServer::set_dhcps_lease(struct dhcps_lease* please)
     return false;
 }
 
+bool DhcpServer::get_dhcps_lease_ip(const uint8_t* mac, ip4_addr_t* ip) const
+{
+    (void)mac;
+    (void)ip;
+    return false;
+}
+
 void DhcpServer::end() { }
 
 bool DhcpServer::begin()
@@ -33,6 +33,7 @@
 #include <eboot_command.h>
 
 #include <sys/time.h>
+#include <time.h>
 
 #include <stdlib.h>
 
@@ -115,6 +116,11 @@ uint32_t EspClass::getSketchSize()
     return 400000;
 }
 
+String EspClass::getSketchMD5()
+{
+    return "0123456789abcdef0123456789abcdef";
+}
+
 uint32_t EspClass::getFreeHeap()
 {
     return 30000;
@@ -270,11 +276,12 @@ uint32_t EspClass::getCycleCount()
     return esp_get_cycle_count();
 }
 
+// host time at F_CPU, to the nanosecond so short sections still measure
 uint32_t esp_get_cycle_count()
 {
-    timeval t;
-    gettimeofday(&t, NULL);
-    return (((uint64_t)t.tv_sec) * 1000000 + t.tv_usec) * (F_CPU / 1000000);
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return ((uint64_t)t.tv_sec) * F_CPU + ((uint64_t)t.tv_nsec) * (F_CPU / 1000000) / 1000;
 }
 
 void EspClass::setDramHeap() { }
@@ -289,3 +296,23 @@ void EspClass::reset()
 {
     abort();
 }
+
+static uint32_t s_rtc_user_mem[128];
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size)
+{
+    if (offset * 4 + size > sizeof(s_rtc_user_mem) || size == 0) {
+        return false;
+    }
+    memcpy(data, (uint8_t*)s_rtc_user_mem + offset * 4, size);
+    return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size)
+{
+    if (offset * 4 + size > sizeof(s_rtc_user_mem) || size == 0) {
+        return false;
+    }
+    memcpy((uint8_t*)s_rtc_user_mem + offset * 4, data, size);
+    return true;
+}
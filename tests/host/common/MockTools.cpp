@@ -98,6 +98,29 @@ extern "C"
         return 0;
     }
     void stack_thunk_dump_stack() { }
+    bool stack_thunk_set_size(uint32_t bytes)
+    {
+        (void)bytes;
+        return false;
+    }
+    uint32_t stack_thunk_get_size()
+    {
+        return 0;
+    }
+    void stack_thunk_profile(bool enable)
+    {
+        (void)enable;
+    }
+    void stack_thunk_profile_begin() { }
+    void stack_thunk_profile_end(int op)
+    {
+        (void)op;
+    }
+    uint32_t stack_thunk_get_op_max_usage(int op)
+    {
+        (void)op;
+        return 0;
+    }
 
 // Thunking macro
 #define make_stack_thunk(fcnToThunk)
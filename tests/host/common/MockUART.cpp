@@ -245,6 +245,28 @@ extern "C"
         return uart && uart->rx_enabled ? uart->rx_buffer->size : 0;
     }
 
+    // the host writes straight to stdout, there is no tx buffer
+    size_t uart_resize_tx_buffer(uart_t* uart, size_t new_size)
+    {
+        (void)uart;
+        (void)new_size;
+        return 0;
+    }
+
+    size_t uart_get_tx_buffer_size(uart_t* uart)
+    {
+        (void)uart;
+        return 0;
+    }
+
+    // the host reads stdin without rx timeout
+    bool uart_set_rx_frame_callback(uart_t* uart, uint8_t symbols, uart_rx_frame_cb_t cb, void* arg)
+    {
+        (void)uart;
+        (void)arg;
+        return !cb || !symbols;
+    }
+
     size_t uart_write_char(uart_t* uart, char c)
     {
         if (uart == NULL || !uart->tx_enabled)
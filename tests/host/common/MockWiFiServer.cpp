@@ -37,8 +37,6 @@
 
 #include <include/ClientContext.h>
 
-extern "C" const ip_addr_t ip_addr_any = IPADDR4_INIT(IPADDR_ANY);
-
 #define int2pcb(x) ((tcp_pcb*)(intptr_t)(x))
 #define pcb2int(x) ((int)(intptr_t)(x))
 
@@ -55,6 +53,8 @@ WiFiServer::WiFiServer(uint16_t port)
     _port = port;
 }
 
+WiFiServer::~WiFiServer() { }
+
 WiFiClient WiFiServer::available(uint8_t* status)
 {
     (void)status;
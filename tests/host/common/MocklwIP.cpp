@@ -13,6 +13,8 @@ extern "C"
 
     netif* netif_list = &netif0;
 
+    const ip_addr_t ip_addr_any = IPADDR4_INIT(IPADDR_ANY);
+
     err_t dhcp_renew(struct netif* netif)
     {
         (void)netif;
@@ -2,6 +2,7 @@
 
 #include <stdint.h>
 #include <string.h>
+#include <Arduino.h>
 
 #include "flash_hal.h"
 
@@ -16,13 +17,26 @@ extern "C"
 
 int32_t flash_hal_read(uint32_t addr, uint32_t size, uint8_t* dst)
 {
+    uint32_t start = micros();
     memcpy(dst, s_phys_data + addr, size);
+    flash_stats_record(FLASH_STATS_READ, size, micros() - start, true);
     return 0;
 }
 
+const uint8_t* flash_hal_mapped(uint32_t addr, uint32_t size)
+{
+    if (addr >= s_phys_size || size > s_phys_size - addr)
+    {
+        return nullptr;
+    }
+    return s_phys_data + addr;
+}
+
 int32_t flash_hal_write(uint32_t addr, uint32_t size, const uint8_t* src)
 {
+    uint32_t start = micros();
     memcpy(s_phys_data + addr, src, size);
+    flash_stats_record(FLASH_STATS_WRITE, size, micros() - start, true);
     return 0;
 }
 
@@ -36,7 +50,9 @@ int32_t flash_hal_erase(uint32_t addr, uint32_t size)
     const uint32_t sectorCount = size / FLASH_SECTOR_SIZE;
     for (uint32_t i = 0; i < sectorCount; ++i)
     {
+        uint32_t start = micros();
         memset(s_phys_data + (sector + i) * FLASH_SECTOR_SIZE, 0xff, FLASH_SECTOR_SIZE);
+        flash_stats_record(FLASH_STATS_ERASE, FLASH_SECTOR_SIZE, micros() - start, true);
     }
     return 0;
 }
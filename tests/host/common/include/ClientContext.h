@@ -121,6 +121,40 @@ public:
         return false;
     }
 
+    void setCork(bool cork)
+    {
+        mockverbose("TODO setCork(%d)\n", (int)cork);
+    }
+
+    bool getCork() const
+    {
+        return false;
+    }
+
+    void setBatchDelayUs(uint32_t batch_us)
+    {
+        mockverbose("TODO setBatchDelayUs(%u)\n", batch_us);
+    }
+
+    uint32_t getBatchDelayUs() const
+    {
+        return 0;
+    }
+
+    void getWriteStats(uint32_t& writes, uint32_t& segments) const
+    {
+        writes   = 0;
+        segments = 0;
+    }
+
+    void resetWriteStats() { }
+
+    bool getTcpStats(WiFiClientTcpStats& stats) const
+    {
+        stats = WiFiClientTcpStats();
+        return _sock >= 0;
+    }
+
     void setTimeout(int timeout_ms)
     {
         _timeout_ms = timeout_ms;
@@ -232,6 +266,30 @@ public:
         return ret;
     }
 
+    size_t write(const Print::iovec* iov, size_t iovcnt)
+    {
+        size_t sent = 0;
+        for (size_t i = 0; i < iovcnt; i++)
+        {
+            size_t ret = write((const char*)iov[i].iov_base, iov[i].iov_len);
+            sent += ret;
+            if (ret != iov[i].iov_len)
+                break;
+        }
+        return sent;
+    }
+
+    // mock sockets copy, nothing is referenced
+    size_t writeReference(const char* data, size_t size)
+    {
+        return write(data, size);
+    }
+
+    bool acknowledged() const
+    {
+        return true;
+    }
+
     void keepAlive(uint16_t idle_sec = TCP_DEFAULT_KEEPALIVE_IDLE_SEC,
                    uint16_t intv_sec = TCP_DEFAULT_KEEPALIVE_INTERVAL_SEC,
                    uint8_t  count    = TCP_DEFAULT_KEEPALIVE_COUNT)
@@ -305,6 +363,17 @@ public:
         _inbufsize -= consume;
     }
 
+    // mock input buffer is a single segment
+    size_t peekSegments(Print::iovec* iov, size_t iovcnt)
+    {
+        size_t len = iovcnt ? peekAvailable() : 0;
+        if (!len)
+            return 0;
+        iov[0].iov_base = _inbuf;
+        iov[0].iov_len  = len;
+        return 1;
+    }
+
 private:
     discard_cb_t _discard_cb     = nullptr;
     void*        _discard_cb_arg = nullptr;
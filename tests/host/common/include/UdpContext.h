@@ -140,6 +140,13 @@ public:
         return pos <= _inbufsize;
     }
 
+    const char* peekDatagram(char* buf, size_t size) const
+    {
+        (void)buf;
+        (void)size;
+        return _inbufsize ? _inbuf : nullptr;
+    }
+
     IPAddress getRemoteAddress()
     {
         return _dst.addr;
@@ -251,6 +258,42 @@ public:
         return err == ERR_OK;
     }
 
+    // mock sockets queue in the host kernel
+    void setRxQueue(size_t max_datagrams, size_t max_bytes = 0, bool drop_oldest = false)
+    {
+        (void)max_datagrams;
+        (void)max_bytes;
+        (void)drop_oldest;
+        mockverbose("TODO UdpContext::setRxQueue()\n");
+    }
+
+    void getRxStats(uint32_t& received, uint32_t& dropped, uint32_t& max_depth) const
+    {
+        received  = 0;
+        dropped   = 0;
+        max_depth = 0;
+    }
+
+    void resetRxStats() { }
+
+    // mock sockets have no pbufs to pool, datagrams are sent when queued
+    bool queue(const ip_addr_t* addr, uint16_t port, const char* data, size_t size)
+    {
+        uint32_t dst = addr ? addr->addr : _dst.addr;
+        uint16_t dstport = addr ? port : _dstport;
+        if (mockUDPWrite(_sock, (const uint8_t*)data, size, _timeout_ms, dst, dstport) != size)
+            return false;
+        ++_queued;
+        return true;
+    }
+
+    size_t sendQueued()
+    {
+        size_t sent = _queued;
+        _queued = 0;
+        return sent;
+    }
+
     void mock_cb(void)
     {
         if (_on_rx)
@@ -280,6 +323,7 @@ private:
     int         _refcnt = 0;
 
     ip_addr_t _dst;
+    size_t    _queued = 0;
     uint16_t  _dstport;
 
     char   _inbuf[CCBUFSIZE];
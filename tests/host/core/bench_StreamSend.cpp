@@ -0,0 +1,159 @@
+/*
+ bench_StreamSend.cpp - Stream::sendGeneric() throughput on host
+
+ Hidden from the default run, use "make bench" (or TEST_ARGS="[bench]").
+ Figures are host figures, meant to compare the send paths with each other
+ and against a previous build, not to predict the esp8266 throughput
+ (see tests/device/test_sw_StreamSend_bench for that).
+
+ Paths:
+ - peek: source implements the peekBuffer API
+ - read: source only implements read(buffer, len)
+ - char: source has no peekBuffer API and a terminator is requested
+ */
+
+#include <catch.hpp>
+#include <chrono>
+#include <string>
+#include <StreamDev.h>
+#include <StreamString.h>
+#include <cbuf.h>
+#include <FS.h>
+#include <LittleFS.h>
+#include "../common/littlefs_mock.h"
+
+static constexpr size_t benchSize = 1024 * 1024;
+static constexpr int benchRounds = 8;
+
+// hides the peekBuffer API of another stream, forcing the read() paths
+class StreamNoPeek: public Stream
+{
+public:
+    StreamNoPeek(Stream& in): _in(in) { }
+
+    virtual size_t write(uint8_t) override
+    {
+        return 0;
+    }
+    virtual int available() override
+    {
+        return _in.available();
+    }
+    virtual int read() override
+    {
+        return _in.read();
+    }
+    virtual int peek() override
+    {
+        return _in.peek();
+    }
+    virtual int read(uint8_t* buffer, size_t len) override
+    {
+        return _in.read(buffer, len);
+    }
+    virtual bool inputCanTimeout() override
+    {
+        return false;
+    }
+    virtual ssize_t streamRemaining() override
+    {
+        return _in.streamRemaining();
+    }
+
+protected:
+    Stream& _in;
+};
+
+template <typename Fn>
+static void bench(const char* name, size_t size, Fn&& sendOnce)
+{
+    using clock = std::chrono::steady_clock;
+    double best = 0;
+    for (int round = 0; round < benchRounds; round++)
+    {
+        auto start = clock::now();
+        size_t sent = sendOnce();
+        std::chrono::duration<double> elapsed = clock::now() - start;
+        REQUIRE(sent == size);
+        if (round == 0 || elapsed.count() < best)
+        {
+            best = elapsed.count();
+        }
+    }
+    printf("%-32s %8.1f MB/s %8.2f ns/byte\n", name, size / best / 1e6, best * 1e9 / size);
+}
+
+TEST_CASE("Stream::sendGeneric paths from RAM", "[.][bench][StreamSend]")
+{
+    std::string data(benchSize, 'x');
+
+    bench("StreamConstPtr->null peek", benchSize, [&]()
+    {
+        StreamConstPtr in(data.c_str(), data.size());
+        return in.sendAll(devnull);
+    });
+
+    bench("StreamConstPtr->null read", benchSize, [&]()
+    {
+        StreamConstPtr in(data.c_str(), data.size());
+        StreamNoPeek nopeek(in);
+        return nopeek.sendAll(devnull);
+    });
+
+    bench("StreamConstPtr->null char", benchSize, [&]()
+    {
+        StreamConstPtr in(data.c_str(), data.size());
+        StreamNoPeek nopeek(in);
+        return nopeek.sendUntil(devnull, '\n');
+    });
+
+    bench("StreamString->StreamString peek", benchSize, [&]()
+    {
+        StreamString in;
+        StreamString out;
+        in.concat(data.c_str(), data.size());
+        out.reserve(data.size());
+        return in.sendAll(out);
+    });
+
+    bench("StreamCbuf->null peek", benchSize, [&]()
+    {
+        cbuf buf(4096);
+        StreamCbuf in(buf);
+        size_t sent = 0;
+        while (sent < benchSize)
+        {
+            in.write((const uint8_t*)data.c_str() + sent, std::min(benchSize - sent, buf.room()));
+            sent += in.sendAll(devnull);
+        }
+        return sent;
+    });
+}
+
+TEST_CASE("Stream::sendGeneric paths with File", "[.][bench][StreamSend]")
+{
+    LITTLEFS_MOCK_DECLARE(4096, 8, 512, "");
+    REQUIRE(LittleFS.begin());
+    std::string data(benchSize, 'x');
+
+    bench("StreamConstPtr->File peek", benchSize, [&]()
+    {
+        StreamConstPtr in(data.c_str(), data.size());
+        File f = LittleFS.open("/bench", "w");
+        return in.sendAll(f);
+    });
+
+    bench("File->null read", benchSize, [&]()
+    {
+        File f = LittleFS.open("/bench", "r");
+        return f.sendAll(devnull);
+    });
+
+    bench("File->StreamString read", benchSize, [&]()
+    {
+        File f = LittleFS.open("/bench", "r");
+        StreamString out;
+        out.reserve(data.size());
+        return f.sendAll(out);
+    });
+}
@@ -0,0 +1,90 @@
+/*
+ test_IPAccessList.cpp - IPAccessList tests
+ Copyright (c) 2020 esp8266/Arduino
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <Arduino.h>
+#include <IPAccessList.h>
+
+static IPAddress ip(const char* text)
+{
+    IPAddress address;
+    REQUIRE(address.fromString(text));
+    return address;
+}
+
+TEST_CASE("IPAccessList longest prefix decides", "[IPAccessList]")
+{
+    IPAccessList acl;
+    REQUIRE(acl.allow("192.168.0.0/16"));
+    REQUIRE(acl.deny("192.168.1.0/24"));
+    REQUIRE(acl.allow("192.168.1.13"));
+    REQUIRE(acl.allow("10.0.0.0/8"));
+    REQUIRE(acl.size() == 4);
+
+    CHECK(acl.allowed(ip("192.168.2.1")));
+    CHECK(!acl.allowed(ip("192.168.1.12")));
+    CHECK(acl.allowed(ip("192.168.1.13")));
+    CHECK(acl.allowed(ip("10.255.0.1")));
+    CHECK(!acl.allowed(ip("11.0.0.1")));
+    CHECK(!acl.allowed(ip("192.169.0.1")));
+
+    bool allowed = true;
+    CHECK(!acl.match(ip("172.16.0.1"), allowed));
+    acl.setDefault(true);
+    CHECK(acl.allowed(ip("172.16.0.1")));
+}
+
+TEST_CASE("IPAccessList prefixes inserted in any order", "[IPAccessList]")
+{
+    // a shorter prefix added after longer ones splits the tree above them
+    IPAccessList acl(true);
+    REQUIRE(acl.deny("10.1.2.0/24"));
+    REQUIRE(acl.deny("10.1.3.0/24"));
+    REQUIRE(acl.allow("10.1.2.128/25"));
+    REQUIRE(acl.deny("10.0.0.0/8"));
+    REQUIRE(acl.allow("10.1.0.0/16"));
+    // set again
+    REQUIRE(acl.allow("10.1.3.0/24"));
+    REQUIRE(acl.size() == 5);
+
+    CHECK(!acl.allowed(ip("10.2.0.1")));
+    CHECK(acl.allowed(ip("10.1.4.1")));
+    CHECK(!acl.allowed(ip("10.1.2.1")));
+    CHECK(acl.allowed(ip("10.1.2.200")));
+    CHECK(acl.allowed(ip("10.1.3.1")));
+    CHECK(acl.allowed(ip("11.1.2.1")));
+
+    // bits after the prefix length don't count
+    REQUIRE(acl.deny("172.16.99.99/12"));
+    CHECK(!acl.allowed(ip("172.31.0.1")));
+    CHECK(acl.allowed(ip("172.32.0.1")));
+
+    REQUIRE(acl.deny("0.0.0.0/0"));
+    CHECK(!acl.allowed(ip("11.1.2.1")));
+    acl.clear();
+    CHECK(acl.size() == 0);
+    CHECK(acl.allowed(ip("10.2.0.1")));
+}
+
+TEST_CASE("IPAccessList rejects bad prefixes", "[IPAccessList]")
+{
+    IPAccessList acl;
+    CHECK(!acl.allow("192.168.1.0/33"));
+    CHECK(!acl.allow("192.168.1.0/"));
+    CHECK(!acl.allow("192.168.1.0/24x"));
+    CHECK(!acl.allow("192.168.1/24"));
+    CHECK(!acl.allow(""));
+    CHECK(acl.size() == 0);
+}
@@ -238,3 +238,27 @@ TEST_CASE("OneShot Timeout 3000ms reset to 1000ms custom yield", "[polledTimeout
 
     REQUIRE(fuzzycomp(delta, (timeType)1000));
 }
+
+TEST_CASE("OneShot Timeout 1000ms remaining time", "[polledTimeout]")
+{
+    using esp8266::polledTimeout::oneShotMs;
+    using timeType = oneShotMs::timeType;
+
+    Serial.println("OneShot Timeout 1000ms remaining time");
+
+    oneShotMs timeout(1000);
+    REQUIRE(fuzzycomp(timeout.remaining(), (timeType)1000));
+
+    delay(400);
+    REQUIRE(fuzzycomp(timeout.remaining(), (timeType)600));
+
+    while (!timeout.expired())
+        yield();
+    REQUIRE(timeout.remaining() == 0);
+
+    timeout.resetToNeverExpires();
+    REQUIRE(timeout.remaining() == oneShotMs::neverExpires);
+
+    timeout.reset(oneShotMs::alwaysExpired);
+    REQUIRE(timeout.remaining() == 0);
+}
@@ -19,6 +19,7 @@
 #include <LittleFS.h>
 #include "../common/littlefs_mock.h"
 #include <spiffs/spiffs.h>
+#include <StreamString.h>
 
 // Use a LittleFS file because we can't instantiate a virtual class like Print
 TEST_CASE("Print::write overrides all compile properly", "[core][Print]")
@@ -79,3 +80,44 @@ TEST_CASE("Print::write overrides all compile properly", "[core][Print]")
     REQUIRE(buff[13] == 0);
     REQUIRE(buff[14] == 1);
 }
+
+TEST_CASE("Print::write(iovec) writes buffers in order", "[core][Print]")
+{
+    StreamString s;
+    Print::iovec iov[3] = { { "head", 4 }, { "", 0 }, { "+body", 5 } };
+    REQUIRE(s.write(iov, 3) == 9);
+    REQUIRE(s == "head+body");
+}
+
+TEST_CASE("Print::printf matches snprintf", "[core][Print]")
+{
+    char expected[512];
+    auto check = [&](const char* format, auto... args) {
+        StreamString s;
+        int len = snprintf(expected, sizeof(expected), format, args...);
+        REQUIRE(s.printf(format, args...) == (size_t)len);
+        REQUIRE(s == expected);
+    };
+    check("plain text");
+    check("%d %i %u", -12, INT_MIN, UINT_MAX);
+    check("%ld %lu %lld %llu", LONG_MIN, ULONG_MAX, LLONG_MIN, ULLONG_MAX);
+    check("%hd %hhu %zu %zd", 70000, 300, (size_t)12345, (ssize_t)-5);
+    check("[%5d] [%-5d] [%05d] [%+d] [% d]", 42, 42, -42, 42, 42);
+    check("%x %X %#x %o %08lx", 0xbeefu, 0xbeefu, 255u, 8u, 0x1234ul);
+    check("%*d|%-*d|%.*f", 6, 1, 6, 2, 3, 3.14159);
+    check("%f %.2f %10.3e %g %G", 1.5, -2.125, 12345.678, 0.0001, 1e20);
+    check("%s|%10s|%-10s|%.3s|%c%c", "abc", "right", "left", "truncated", 'o', 'k');
+    check("%%|%s", "(after)");
+    check("%.80f", 1.0);
+
+    // longer than the sink's buffer, with a conversion across its end
+    std::string line(150, 'x');
+    check("%s %d %s", line.c_str(), 123456, line.c_str());
+
+    StreamString s;
+    REQUIRE(s.printf_P(PSTR("%s=%d"), "key", 7) == 5);
+    REQUIRE(s == "key=7");
+    int n = 0;
+    s.printf("abc%n", &n);
+    REQUIRE(n == 3);
+}
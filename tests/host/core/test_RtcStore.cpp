@@ -0,0 +1,148 @@
+/*
+ test_RtcStore.cpp - RtcStore tests
+ Copyright (c) 2020 esp8266/Arduino
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <Arduino.h>
+#include <RtcStore.h>
+
+struct Reading
+{
+    uint16_t value;
+    uint8_t flags;
+};
+
+static void garbage(uint32_t offset, uint32_t blocks)
+{
+    for (uint32_t i = 0; i < blocks; ++i)
+    {
+        uint32_t word = 0x12345678 * (i + 1);
+        ESP.rtcUserMemoryWrite(offset + i, &word, 4);
+    }
+}
+
+TEST_CASE("RtcStore starts empty over invalid memory", "[RtcStore]")
+{
+    garbage(32, 32);
+    RtcStore rtc(32, 32);
+    REQUIRE(!rtc.begin());
+    REQUIRE(rtc.used() == 8);
+    uint32_t value = 5;
+    REQUIRE(!rtc.get(1, value));
+    REQUIRE(value == 5);
+    // and is valid from then on
+    RtcStore again(32, 32);
+    REQUIRE(again.begin());
+}
+
+TEST_CASE("RtcStore records are kept over a new begin()", "[RtcStore]")
+{
+    garbage(32, 32);
+    {
+        RtcStore rtc(32, 32);
+        rtc.begin();
+        REQUIRE(rtc.put(1, (uint32_t)41));
+        REQUIRE(rtc.put(2, Reading { 1234, 5 }, 3));
+        REQUIRE(rtc.put(1, (uint32_t)42));
+    }
+    RtcStore rtc(32, 32);
+    REQUIRE(rtc.begin());
+    uint32_t wakes = 0;
+    REQUIRE(rtc.get(1, wakes));
+    REQUIRE(wakes == 42);
+    Reading reading { };
+    REQUIRE(rtc.get(2, reading, 3));
+    REQUIRE(reading.value == 1234);
+    REQUIRE(reading.flags == 5);
+    // another version or size reads as missing
+    REQUIRE(!rtc.get(2, reading, 2));
+    uint64_t wide;
+    REQUIRE(!rtc.get(1, wide));
+    REQUIRE(rtc.used() == (2 + 2 + 2) * 4);
+}
+
+TEST_CASE("RtcStore resizing, removing and filling records", "[RtcStore]")
+{
+    garbage(40, 9);
+    RtcStore rtc(40, 9);
+    rtc.begin();
+    REQUIRE(rtc.put(1, (uint32_t)1));
+    REQUIRE(rtc.put(2, (uint32_t)2));
+    REQUIRE(rtc.put(1, (uint64_t)0x100000001));   // moved after 2
+    uint32_t two = 0;
+    uint64_t one = 0;
+    REQUIRE(rtc.get(2, two));
+    REQUIRE(rtc.get(1, one));
+    REQUIRE(two == 2);
+    REQUIRE(one == 0x100000001);
+    REQUIRE(rtc.used() == (2 + 2 + 3) * 4);
+
+    uint32_t big[2] = { 7, 8 };
+    REQUIRE(!rtc.put(3, big));    // 3 blocks, 2 left
+    REQUIRE(!rtc.contains(3));
+    uint32_t huge[4] = { };
+    REQUIRE(!rtc.put(2, huge));   // 5 blocks, 2 + 2 once resized
+    REQUIRE(rtc.get(2, two));     // the old record is kept
+    REQUIRE(two == 2);
+    REQUIRE(rtc.remove(2));
+    REQUIRE(!rtc.contains(2));
+    REQUIRE(rtc.put(3, big));
+
+    RtcStore again(40, 9);
+    REQUIRE(again.begin());
+    REQUIRE(again.get(1, one));
+    REQUIRE(one == 0x100000001);
+    uint32_t read[2];
+    REQUIRE(again.get(3, read));
+    REQUIRE(read[1] == 8);
+}
+
+TEST_CASE("RtcStore CRC is written once per update", "[RtcStore]")
+{
+    garbage(64, 16);
+    RtcStore rtc(64, 16);
+    rtc.begin();
+    REQUIRE(rtc.put(1, (uint32_t)1));
+    rtc.beginUpdate();
+    REQUIRE(rtc.put(1, (uint32_t)2));
+    REQUIRE(rtc.put(2, (uint32_t)3));
+    {
+        // a reset before endUpdate() finds an invalid store
+        RtcStore reset(64, 16);
+        REQUIRE(!reset.begin());
+    }
+
+    RtcStore batch(64, 16);
+    REQUIRE(batch.begin());
+    batch.beginUpdate();
+    REQUIRE(batch.put(1, (uint32_t)2));
+    REQUIRE(batch.put(2, (uint32_t)3));
+    REQUIRE(batch.endUpdate());
+    {
+        RtcStore again(64, 16);
+        REQUIRE(again.begin());
+        uint32_t value = 0;
+        REQUIRE(again.get(2, value));
+        REQUIRE(value == 3);
+    }
+
+    // a changed value is found
+    uint32_t word;
+    ESP.rtcUserMemoryRead(64 + 3, &word, 4);
+    word ^= 1;
+    ESP.rtcUserMemoryWrite(64 + 3, &word, 4);
+    RtcStore corrupt(64, 16);
+    REQUIRE(!corrupt.begin());
+    REQUIRE(!corrupt.contains(1));
+}
@@ -0,0 +1,101 @@
+/*
+ test_StringBuilder.cpp - StringBuilder tests
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <StreamString.h>
+#include <StringBuilder.h>
+
+// Counts the Print::write(iovec) calls, writes at most limit bytes
+class IovecSink: public StreamString
+{
+public:
+    using StreamString::write;
+
+    size_t write(const iovec* iov, size_t iovcnt) override
+    {
+        calls++;
+        size_t n = 0;
+        for (size_t i = 0; i < iovcnt && n < limit; i++)
+        {
+            size_t len = std::min(iov[i].iov_len, limit - n);
+            n += StreamString::write((const uint8_t*)iov[i].iov_base, len);
+        }
+        limit -= n;
+        return n;
+    }
+
+    size_t calls = 0;
+    size_t limit = (size_t)-1;
+};
+
+TEST_CASE("StringBuilder appends across chunks", "[core][StringBuilder]")
+{
+    StringBuilder sb(8);
+    sb += F("{\"a\":");
+    sb += 1234;
+    sb += ',';
+    sb += String("\"b\":\"0123456789abcdef\"");
+    sb.printf("}");
+    REQUIRE(sb);
+    REQUIRE(sb.length() == 33);
+    REQUIRE(sb.toString() == "{\"a\":1234,\"b\":\"0123456789abcdef\"}");
+
+    // the peek buffer API walks the chunks
+    REQUIRE(sb.peekAvailable() == 8);
+    REQUIRE(sb.read() == '{');
+    sb.peekConsume(7);
+    REQUIRE(sb.peek() == '4');
+    char buf[8];
+    REQUIRE(sb.read((uint8_t*)buf, 4) == 4);
+    REQUIRE(memcmp(buf, "4,\"b", 4) == 0);
+    REQUIRE(sb.streamRemaining() == 21);
+
+    StreamString out;
+    REQUIRE(sb.sendAll(out) == 21);
+    REQUIRE(out == "\":\"0123456789abcdef\"}");
+    REQUIRE(sb.length() == 0);
+    REQUIRE(sb.read() == -1);
+
+    sb.clear();
+    sb += "x";
+    REQUIRE(sb.toString() == "x");
+}
+
+TEST_CASE("StringBuilder::writeTo uses iovecs", "[core][StringBuilder]")
+{
+    StringBuilder sb(4);
+    for (int i = 0; i < 10; i++)
+    {
+        sb.print(i % 10);
+        sb.print("abc");
+    }
+    REQUIRE(sb.length() == 40);
+
+    IovecSink sink;
+    REQUIRE(sb.writeTo(sink) == 40);
+    REQUIRE(sink.calls == 2);
+    REQUIRE(sink.length() == 40);
+    REQUIRE(sink.startsWith("0abc1abc"));
+
+    // short writes stop and consume only what was sent
+    for (int i = 0; i < 5; i++)
+    {
+        sb.print("wxyz");
+    }
+    IovecSink partial;
+    partial.limit = 6;
+    REQUIRE(sb.writeTo(partial) == 6);
+    REQUIRE(sb.length() == 14);
+    REQUIRE(sb.peek() == 'y');
+}
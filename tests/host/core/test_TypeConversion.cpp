@@ -0,0 +1,79 @@
+/*
+ test_TypeConversion.cpp - TypeConversion tests
+ Copyright (c) 2020 esp8266/Arduino
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <string.h>
+#include <TypeConversion.h>
+
+using namespace experimental::TypeConversion;
+
+TEST_CASE("TypeConversion HEX buffers", "[core][TypeConversion]")
+{
+    uint8_t data[256];
+    for (size_t i = 0; i < sizeof(data); ++i)
+    {
+        data[i] = i;
+    }
+    char hex[2 * sizeof(data) + 1];
+    char expected[2 * sizeof(data) + 1];
+    for (size_t length = 0; length <= sizeof(data); length += (length < 8 ? 1 : 61))
+    {
+        for (size_t i = 0; i < length; ++i)
+        {
+            snprintf(expected + 2 * i, 3, "%02X", data[i]);
+        }
+        expected[2 * length] = 0;
+
+        *uint8ArrayToHexBuffer(data, length, hex) = 0;
+        REQUIRE(strcmp(hex, expected) == 0);
+        REQUIRE(uint8ArrayToHexString(data, length) == expected);
+
+        uint8_t decoded[sizeof(data)];
+        REQUIRE(hexBufferToUint8Array(hex, 2 * length, decoded) == (int32_t)length);
+        REQUIRE(memcmp(decoded, data, length) == 0);
+
+        *uint8ArrayToHexBuffer(data, length, hex, true) = 0;
+        for (char* p = expected; *p; ++p)
+        {
+            *p = tolower(*p);
+        }
+        REQUIRE(strcmp(hex, expected) == 0);
+        memset(decoded, 0, sizeof(decoded));
+        REQUIRE(hexBufferToUint8Array(hex, 2 * length, decoded) == (int32_t)length);
+        REQUIRE(memcmp(decoded, data, length) == 0);
+    }
+
+    // every character, in each position of a four character word and of
+    // an odd pair at the end
+    for (int c = 1; c < 256; ++c)
+    {
+        bool isHex = isxdigit(c);
+        uint8_t out[2];
+        for (int pos = 0; pos < 4; ++pos)
+        {
+            char text[] = "a0F9";
+            text[pos] = c;
+            REQUIRE((hexBufferToUint8Array(text, 4, out) == 2) == isHex);
+            REQUIRE((hexBufferToUint8Array(text + (pos & 2), 2, out) == 1) == isHex);
+        }
+    }
+
+    uint8_t out[4];
+    REQUIRE(hexBufferToUint8Array("aBcD1", 5, out) == 2);
+    REQUIRE(out[0] == 0xab);
+    REQUIRE(out[1] == 0xcd);
+    REQUIRE(hexStringToUint8Array(String("00fFa5"), out, 3) == out);
+    REQUIRE(out[2] == 0xa5);
+}
@@ -53,3 +53,141 @@ TEST_CASE("Updater fails when writes overflow requested size", "[core][Updater]"
     REQUIRE(!u->write(buff, 2048));
     delete u;
 }
+
+TEST_CASE("Updater erases ahead only within the update", "[core][Updater]")
+{
+    UpdaterClass* u;
+    uint8_t       buff[4096];
+    memset(buff, 0, sizeof(buff));
+    u = new UpdaterClass();
+    u->eraseAhead(2);
+    REQUIRE(u->begin(3 * 4096 + 100));
+    REQUIRE(u->preErase());
+    REQUIRE(u->preErase());
+    // two sectors beyond the one being filled
+    REQUIRE(!u->preErase());
+    REQUIRE(u->write(buff, 100));
+    REQUIRE(!u->preErase());
+    REQUIRE(u->write(buff, 4096));
+    REQUIRE(u->progress() == 4096);
+    REQUIRE(u->preErase());
+    REQUIRE(!u->preErase());
+    REQUIRE(u->write(buff, 4096));
+    REQUIRE(u->preErase());
+    // last sector of the update
+    REQUIRE(!u->preErase());
+    REQUIRE(u->write(buff, 4096));
+    REQUIRE(u->remaining() == 0);
+    REQUIRE(!u->preErase());
+    delete u;
+}
+
+TEST_CASE("Updater applies delta patches to the running sketch only", "[core][Updater]")
+{
+    // header for a 100 bytes image from the mocked 400000 bytes sketch
+    const uint8_t header[28] = { 'E', 'S', 'P', 'D', 100, 0, 0, 0, 0x80, 0x1a, 0x06, 0,
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef, 0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef };
+    uint8_t patch[28 + 16 + 100];
+    memcpy(patch, header, sizeof(header));
+    memset(patch + 28, 0, sizeof(patch) - 28);
+    patch[28 + 8] = 100; // 100 extra bytes
+    UpdaterClass* u;
+
+    u = new UpdaterClass();
+    REQUIRE(u->begin(100));
+    REQUIRE(u->applyDelta());
+    // the patch is more than the image, split anywhere
+    REQUIRE(u->write(patch, 30) == 30);
+    REQUIRE(u->write(patch + 30, 20) == 20);
+    REQUIRE(u->write(patch + 50, sizeof(patch) - 50) == sizeof(patch) - 50);
+    REQUIRE(u->remaining() == 0);
+    REQUIRE(!u->hasError());
+    delete u;
+
+    patch[8] = 0x81; // source size
+    u = new UpdaterClass();
+    REQUIRE(u->begin(100));
+    REQUIRE(u->applyDelta());
+    REQUIRE(u->write(patch, sizeof(patch)) == 28);
+    REQUIRE(u->getError() == UPDATE_ERROR_DELTA_SOURCE);
+    delete u;
+
+    patch[8] = 0x80;
+    patch[28 + 8] = 101; // past the end of the image
+    u = new UpdaterClass();
+    REQUIRE(u->begin(100));
+    REQUIRE(u->applyDelta());
+    REQUIRE(u->write(patch, sizeof(patch)) == 28 + 16);
+    REQUIRE(u->getError() == UPDATE_ERROR_DELTA);
+    delete u;
+}
+
+TEST_CASE("Updater decompresses gzip updates as they are written", "[core][Updater]")
+{
+    // gzip -9 of "0123456789" repeated 10 times
+    uint8_t gz[33] = { 0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x33, 0x30,
+        0x34, 0x32, 0x36, 0x31, 0x35, 0x33, 0xb7, 0xb0, 0x34, 0xa0, 0x19, 0x0b, 0x00, 0xbc,
+        0x4b, 0xfc, 0xb1, 0x64, 0x00, 0x00, 0x00 };
+    UpdaterClass* u;
+
+    u = new UpdaterClass();
+    REQUIRE(u->begin(sizeof(gz)));
+    REQUIRE(u->inflate());
+    // sizes are those of the compressed data
+    REQUIRE(u->write(gz, 5) == 5);
+    REQUIRE(u->progress() == 5);
+    REQUIRE(u->write(gz + 5, sizeof(gz) - 5) == sizeof(gz) - 5);
+    REQUIRE(u->remaining() == 0);
+    REQUIRE(!u->hasError());
+    delete u;
+
+    gz[26] ^= 1; // CRC-32
+    u = new UpdaterClass();
+    REQUIRE(u->begin(sizeof(gz)));
+    REQUIRE(u->inflate());
+    REQUIRE(u->write(gz, sizeof(gz)) == 0);
+    REQUIRE(u->getError() == UPDATE_ERROR_INFLATE);
+    delete u;
+
+    gz[26] ^= 1;
+    gz[0] = 0xe9; // not gzip
+    u = new UpdaterClass();
+    REQUIRE(u->begin(sizeof(gz)));
+    REQUIRE(u->inflate());
+    REQUIRE(u->write(gz, sizeof(gz)) == 0);
+    REQUIRE(u->getError() == UPDATE_ERROR_INFLATE);
+    delete u;
+}
+
+TEST_CASE("Updater hashes signed updates as they are written", "[core][Updater]")
+{
+    struct CountingHash : UpdaterHashClass {
+        uint32_t hashed = 0;
+        void begin() override { hashed = 0; }
+        void add(const void*, uint32_t len) override { hashed += len; }
+        void end() override { }
+        int len() override { return 0; }
+        const void* hash() override { return nullptr; }
+        const unsigned char* oid() override { return nullptr; }
+    } hash;
+    struct Verifier : UpdaterVerifyClass {
+        uint32_t length() override { return 256; }
+        bool verify(UpdaterHashClass*, const void*, uint32_t) override { return false; }
+    } verifier;
+    uint8_t buff[4096];
+    memset(buff, 0, sizeof(buff));
+    UpdaterClass* u;
+
+    // 6000 bytes of payload, then the signature and its length
+    u = new UpdaterClass();
+    u->installSignature(&hash, &verifier);
+    REQUIRE(u->begin(6000 + 256 + 4));
+    REQUIRE(u->write(buff, 4000));
+    REQUIRE(hash.hashed == 0);
+    REQUIRE(u->write(buff, 1000));
+    REQUIRE(hash.hashed == 4096);
+    REQUIRE(u->write(buff, 6000 + 256 + 4 - 5000));
+    REQUIRE(u->remaining() == 0);
+    REQUIRE(hash.hashed == 6000);
+    delete u;
+}
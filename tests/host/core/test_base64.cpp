@@ -0,0 +1,105 @@
+/*
+ test_base64.cpp - base64 tests
+ Copyright (c) 2020 esp8266/Arduino
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <string.h>
+#include <base64.h>
+#include <StreamString.h>
+#include <libb64/cencode.h>
+#include <libb64/cdecode.h>
+
+static String toString(const char* data, size_t length)
+{
+    String str;
+    str.concat(data, length);
+    return str;
+}
+
+// what base64::encode() gave when it was a libb64 wrapper
+static String libb64Encode(const uint8_t* data, size_t length, bool doNewLines)
+{
+    std::unique_ptr<char[]> buf(new char[base64_encode_expected_len(length) + 1]);
+    base64_encodestate state;
+    if (doNewLines)
+    {
+        base64_init_encodestate(&state);
+    }
+    else
+    {
+        base64_init_encodestate_nonewlines(&state);
+    }
+    int len = base64_encode_block((const char*)data, length, buf.get(), &state);
+    len += base64_encode_blockend(buf.get() + len, &state);
+    return toString(buf.get(), len);
+}
+
+TEST_CASE("base64 encodes like libb64", "[core][base64]")
+{
+    uint8_t data[300];
+    for (size_t i = 0; i < sizeof(data); ++i)
+    {
+        data[i] = i * 37 + (i >> 3);
+    }
+    for (size_t length = 0; length <= sizeof(data); ++length)
+    {
+        String expected = libb64Encode(data, length, false);
+        REQUIRE(base64::encode(data, length, false) == expected);
+        REQUIRE(base64::encode(data, length, true) == libb64Encode(data, length, true));
+
+        char out[base64::encodedLength(sizeof(data))];
+        REQUIRE(base64::encodedLength(length) == expected.length());
+        REQUIRE(base64::encodeTo(data, length, out) == expected.length());
+        REQUIRE(toString(out, expected.length()) == expected);
+
+        StreamString printed;
+        REQUIRE(base64::encodeTo(data, length, printed) == expected.length());
+        REQUIRE(printed == expected);
+
+        uint8_t decoded[sizeof(data)];
+        REQUIRE(base64::decodeTo(expected, decoded, length) == (ssize_t)length);
+        REQUIRE(memcmp(decoded, data, length) == 0);
+        REQUIRE(base64::decodedLength(expected.length()) == length + (3 - length % 3) % 3);
+        // with newlines
+        String lines = libb64Encode(data, length, true);
+        REQUIRE(base64::decodeTo(lines, decoded, sizeof(decoded)) == (ssize_t)length);
+        REQUIRE(memcmp(decoded, data, length) == 0);
+        // to a Print, across several of its blocks
+        StreamString bytes;
+        REQUIRE(base64::decodeTo(expected.c_str(), expected.length(), bytes) == (ssize_t)length);
+        REQUIRE(bytes.length() == length);
+        REQUIRE(memcmp(bytes.c_str(), data, length) == 0);
+    }
+}
+
+TEST_CASE("base64 decodes", "[core][base64]")
+{
+    uint8_t out[16];
+    REQUIRE(base64::decodeTo("TWFu", 4, out, sizeof(out)) == 3);
+    REQUIRE(memcmp(out, "Man", 3) == 0);
+    // without padding, and the URL safe alphabet
+    REQUIRE(base64::decodeTo("TWE", 3, out, sizeof(out)) == 2);
+    REQUIRE(memcmp(out, "Ma", 2) == 0);
+    REQUIRE(base64::decodeTo("-_-_", 4, out, sizeof(out)) == 3);
+    REQUIRE(base64::decodeTo("+/+/", 4, out + 3, sizeof(out) - 3) == 3);
+    REQUIRE(memcmp(out, out + 3, 3) == 0);
+    REQUIRE(base64::decodeTo(" TW\r\nFu ", 8, out, sizeof(out)) == 3);
+
+    REQUIRE(base64::decodeTo("TW*u", 4, out, sizeof(out)) == -1);
+    REQUIRE(base64::decodeTo("TWFuT", 5, out, sizeof(out)) == -1);
+    // out too small
+    REQUIRE(base64::decodeTo("TWFuTWFu", 8, out, 5) == -1);
+    REQUIRE(base64::decodeTo("TWFuTWE=", 8, out, 5) == 5);
+    REQUIRE(base64::decodeTo("TWFuTWE=", 8, out, 4) == -1);
+}
@@ -0,0 +1,115 @@
+#include <catch.hpp>
+#include <string.h>
+#include <cbuf.h>
+#include <StreamDev.h>
+#include <StreamString.h>
+
+// leave the content wrapped around the end of a 16 bytes buffer
+static void fillWrapped(cbuf& buf, const char* text)
+{
+    char skip[10];
+    REQUIRE(buf.write("0123456789", 10) == 10);
+    REQUIRE(buf.read(skip, sizeof(skip)) == 10);
+    REQUIRE(buf.write(text, strlen(text)) == strlen(text));
+}
+
+TEST_CASE("cbuf spans describe wrapped content", "[core][cbuf]")
+{
+    cbuf buf(16);
+    fillWrapped(buf, "abcdefghij");
+
+    cbuf::span spans[2];
+    REQUIRE(buf.readSpans(spans) == 10);
+    REQUIRE(spans[0].size == 6);
+    REQUIRE(spans[1].size == 4);
+    REQUIRE(memcmp(spans[0].data, "abcdef", 6) == 0);
+    REQUIRE(memcmp(spans[1].data, "ghij", 4) == 0);
+    REQUIRE(buf.peekAvailable() == 6);
+
+    buf.consume(8);
+    REQUIRE(buf.available() == 2);
+    REQUIRE(buf.read() == 'i');
+
+    REQUIRE(buf.writeSpans(spans) == buf.room());
+    size_t n = 0;
+    for (auto& s : spans)
+    {
+        memset(s.data, 'z', s.size);
+        n += s.size;
+    }
+    buf.commit(n);
+    REQUIRE(buf.room() == 0);
+    REQUIRE(buf.available() == 15);
+    REQUIRE(buf.read() == 'j');
+    REQUIRE(buf.read() == 'z');
+}
+
+TEST_CASE("cbuf write spans keep one byte free", "[core][cbuf]")
+{
+    cbuf buf(8);
+    cbuf::span spans[2];
+
+    REQUIRE(buf.writeSpans(spans) == 7);
+    REQUIRE(spans[0].size == 7);
+    REQUIRE(spans[1].size == 0);
+
+    memcpy(spans[0].data, "1234567", 7);
+    buf.commit(7);
+    REQUIRE(buf.full());
+    REQUIRE(buf.writeSpans(spans) == 0);
+}
+
+TEST_CASE("StreamCbuf sends wrapped content without copy", "[core][cbuf]")
+{
+    cbuf buf(16);
+    fillWrapped(buf, "abcdefghij");
+
+    StreamCbuf in(buf);
+    REQUIRE(in.hasPeekBufferAPI());
+
+    StreamString out;
+    REQUIRE(in.sendAll(out) == 10);
+    REQUIRE(out == "abcdefghij");
+    REQUIRE(buf.empty());
+}
+
+TEST_CASE("StreamPipe streams through a bounded buffer", "[core][cbuf]")
+{
+    const char     text[] = "a body longer than the pipe";
+    StreamConstPtr in(text, sizeof(text) - 1);
+    StreamPipe     pipe(8);
+    StreamString   out;
+
+    while (in.available())
+    {
+        in.sendAvailable(pipe);
+        REQUIRE(pipe.available() <= 8);
+        pipe.sendAvailable(out);
+    }
+    REQUIRE(pipe.streamRemaining() == -1);
+    pipe.close();
+    REQUIRE(pipe.write('x') == 0);
+    REQUIRE(pipe.sendAll(out) == 0);
+    REQUIRE(pipe.getLastSendReport() == Stream::Report::Success);
+    REQUIRE(out == text);
+}
+
+TEST_CASE("StreamPipe is written in place", "[core][cbuf]")
+{
+    StreamPipe pipe(8);
+    REQUIRE(pipe.write((const uint8_t*)"123456", 6) == 6);
+    REQUIRE(pipe.read() == '1');
+    REQUIRE(pipe.read() == '2');
+
+    // three bytes to the end of the buffer, one more at its start
+    REQUIRE(pipe.writeBufferAvailable() == 3);
+    memcpy(pipe.writeBuffer(), "789", 3);
+    pipe.writeCommit(3);
+    REQUIRE(pipe.availableForWrite() == 1);
+
+    pipe.close();
+    REQUIRE(pipe.streamRemaining() == 7);
+    StreamString out;
+    REQUIRE(pipe.sendAll(out) == 7);
+    REQUIRE(out == "3456789");
+}
@@ -0,0 +1,82 @@
+/*
+ test_crc32.cpp - crc32() tests
+ Copyright (c) 2020 esp8266/Arduino
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <string.h>
+#include <coredecls.h>
+
+// the bit by bit implementation crc32() had, whose values are stored in
+// RTC memory and flash and must not change
+static uint32_t crc32_bitwise(const void* data, size_t length, uint32_t crc = 0xffffffff)
+{
+    const uint8_t* ldata = (const uint8_t*)data;
+    while (length--)
+    {
+        uint8_t c = *ldata++;
+        for (uint32_t i = 0x80; i > 0; i >>= 1)
+        {
+            bool bit = crc & 0x80000000;
+            if (c & i)
+                bit = !bit;
+            crc <<= 1;
+            if (bit)
+                crc ^= 0x04c11db7;
+        }
+    }
+    return crc;
+}
+
+TEST_CASE("crc32 check value", "[crc32]")
+{
+    // CRC-32/MPEG-2
+    REQUIRE(crc32("123456789", 9) == 0x0376e6e7);
+    REQUIRE(crc32("", 0) == 0xffffffff);
+    REQUIRE(crc32("", 0, 1234) == 1234);
+}
+
+TEST_CASE("crc32 matches the bitwise crc at any alignment and length", "[crc32]")
+{
+    alignas(4) uint8_t data[300];
+    uint32_t x = 1;
+    for (auto& c : data)
+    {
+        x = x * 1103515245 + 12345;
+        c = x >> 24;
+    }
+    for (size_t offset = 0; offset < 4; ++offset)
+    {
+        for (size_t len = 0; len + offset <= sizeof(data); len += (len < 20 ? 1 : 37))
+        {
+            REQUIRE(crc32(data + offset, len) == crc32_bitwise(data + offset, len));
+            REQUIRE(crc32(data + offset, len, 0) == crc32_bitwise(data + offset, len, 0));
+        }
+    }
+}
+
+TEST_CASE("Crc32 in parts equals crc32 at once", "[crc32]")
+{
+    const char text[] = "The quick brown fox jumps over the lazy dog";
+    const size_t len = sizeof(text) - 1;
+    for (size_t cut = 0; cut <= len; ++cut)
+    {
+        Crc32 crc;
+        crc.add(text, cut).add(text + cut, len - cut);
+        REQUIRE(crc.value() == crc32(text, len));
+    }
+    Crc32 crc;
+    crc.add(text, len);
+    crc.reset();
+    REQUIRE(crc.value() == 0xffffffff);
+}
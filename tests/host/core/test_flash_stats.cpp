@@ -0,0 +1,77 @@
+/*
+ test_flash_stats.cpp - flash operation statistics
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <Arduino.h>
+#include <StreamString.h>
+#include <flash_hal.h>
+
+TEST_CASE("flash_stats counts operations, bytes and latencies", "[core][flash_stats]")
+{
+    flash_stats_reset();
+    flash_stats_record(FLASH_STATS_WRITE, 256, 3, true);
+    flash_stats_record(FLASH_STATS_WRITE, 4, 16, true);
+    flash_stats_record(FLASH_STATS_WRITE, 100, 200, false);
+    flash_stats_record(FLASH_STATS_ERASE, 4096, 1000000, true);
+    flash_stats_record(FLASH_STATS_OP_COUNT, 1, 1, true);
+
+    flash_stats_t stats;
+    REQUIRE(flash_stats_get(FLASH_STATS_WRITE, &stats));
+    REQUIRE(stats.count == 3);
+    REQUIRE(stats.errors == 1);
+    REQUIRE(stats.bytes == 360);
+    REQUIRE(stats.us == 219);
+    REQUIRE(stats.max_us == 200);
+    REQUIRE(stats.histogram[0] == 1);  // < 16us
+    REQUIRE(stats.histogram[1] == 1);  // < 32us
+    REQUIRE(stats.histogram[4] == 1);  // < 256us
+
+    REQUIRE(flash_stats_get(FLASH_STATS_ERASE, &stats));
+    REQUIRE(stats.count == 1);
+    REQUIRE(stats.histogram[FLASH_STATS_BINS - 1] == 1);
+    REQUIRE_FALSE(flash_stats_get(FLASH_STATS_OP_COUNT, &stats));
+
+    StreamString out;
+    flash_stats_print(out);
+    REQUIRE(out.indexOf("flash write: count=3 errors=1 bytes=360") >= 0);
+
+    flash_stats_reset();
+    REQUIRE(flash_stats_get(FLASH_STATS_WRITE, &stats));
+    REQUIRE(stats.count == 0);
+    REQUIRE(stats.histogram[0] == 0);
+}
+
+TEST_CASE("flash_hal calls are accounted", "[core][flash_stats]")
+{
+    std::vector<uint8_t> flash(2 * FLASH_SECTOR_SIZE);
+    s_phys_data = flash.data();
+    s_phys_size = flash.size();
+    flash_stats_reset();
+
+    uint8_t buf[10] = { 1, 2, 3 };
+    REQUIRE(flash_hal_erase(0, 2 * FLASH_SECTOR_SIZE) == FLASH_HAL_OK);
+    REQUIRE(flash_hal_write(8, sizeof(buf), buf) == FLASH_HAL_OK);
+    REQUIRE(flash_hal_read(8, 3, buf) == FLASH_HAL_OK);
+
+    flash_stats_t stats;
+    REQUIRE(flash_stats_get(FLASH_STATS_ERASE, &stats));
+    REQUIRE(stats.count == 2);
+    REQUIRE(stats.bytes == 2 * FLASH_SECTOR_SIZE);
+    REQUIRE(flash_stats_get(FLASH_STATS_WRITE, &stats));
+    REQUIRE(stats.count == 1);
+    REQUIRE(stats.bytes == sizeof(buf));
+    REQUIRE(flash_stats_get(FLASH_STATS_READ, &stats));
+    REQUIRE(stats.count == 1);
+    REQUIRE(stats.bytes == 3);
+
+    s_phys_data = nullptr;
+    s_phys_size = 0;
+}
@@ -15,7 +15,9 @@
 
 #include <catch.hpp>
 #include <string.h>
+#include <strings.h>
 #include <pgmspace.h>
+#include <PgmHash.h>
 
 TEST_CASE("strstr_P works as strstr", "[core][pgmspace]")
 {
@@ -54,3 +56,63 @@ TEST_CASE("strstr_P works as strstr", "[core][pgmspace]")
     t("_foo_foo", "foo");
     t("A", "a");
 }
+
+TEST_CASE("memcmp_PA works as memcmp and strncasecmp", "[core][pgmspace]")
+{
+    static const char flash[] PROGMEM = "..Content-Type: text/HTML; charset=utf-8";
+    char ram[sizeof(flash) + 4];
+    for (size_t ramOffset = 0; ramOffset < 4; ++ramOffset)
+    {
+        for (int upper = 0; upper < 2; ++upper)
+        {
+            for (size_t i = 0; i < sizeof(flash); ++i)
+            {
+                ram[ramOffset + i] = upper ? toupper(flash[i]) : flash[i];
+            }
+            for (size_t offset = 0; offset < 4; ++offset)
+            {
+                for (size_t len = 0; len < sizeof(flash) - offset; ++len)
+                {
+                    const char* r = ram + ramOffset + offset;
+                    int cmp = memcmp_PA(r, flash + offset, len);
+                    int expected = memcmp(r, flash + offset, len);
+                    REQUIRE((cmp < 0) == (expected < 0));
+                    REQUIRE((cmp > 0) == (expected > 0));
+                    REQUIRE(memcmp_PA(r, flash + offset, len, true) == 0);
+                    REQUIRE(pgm_hash_P(flash + offset, len, 7, true) == pgm_hash(r, len, 7, true));
+                    if (!expected)
+                    {
+                        REQUIRE(pgm_hash_P(flash + offset, len) == pgm_hash(r, len));
+                    }
+                }
+            }
+        }
+    }
+    REQUIRE(memcmp_PA("abcd", PSTR("abce"), 4) < 0);
+    REQUIRE(memcmp_PA("abcf", PSTR("abce"), 4) > 0);
+    REQUIRE(memcmp_PA("[", PSTR("a"), 1, true) == strncasecmp("[", "a", 1));
+    REQUIRE(equals_PA("Host", 4, PSTR("host"), 4, true));
+    REQUIRE_FALSE(equals_PA("Hos", 3, PSTR("host"), 4, true));
+}
+
+TEST_CASE("PgmKeywords finds each keyword", "[core][pgmspace]")
+{
+    static constexpr auto methods PROGMEM = makePgmKeywords(false, "GET", "HEAD", "POST", "DELETE", "OPTIONS", "PUT", "PATCH");
+    static constexpr auto headers PROGMEM = makePgmKeywords(true, "Content-Type", "Content-Length", "Host", "Connection");
+
+    REQUIRE(methods.size() == 7);
+    for (size_t i = 0; i < methods.size(); ++i)
+    {
+        REQUIRE(methods.find(methods.keyword(i)) == (int)i);
+    }
+    REQUIRE(strcmp_P("OPTIONS", methods.keyword(4)) == 0);
+    REQUIRE(methods.find("get") == -1);
+    REQUIRE(methods.find("GETS") == -1);
+    REQUIRE(methods.find("") == -1);
+    REQUIRE(methods.find("POST /", 4) == 2);
+
+    REQUIRE(headers.find("content-length") == 1);
+    REQUIRE(headers.find("HOST") == 2);
+    REQUIRE(headers.find("Hos") == -1);
+    REQUIRE(headers.find("X-Forwarded-For") == -1);
+}
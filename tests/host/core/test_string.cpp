@@ -926,3 +926,125 @@ TEST_CASE("String::lastIndexOf", "[core][String]")
         REQUIRE(str.lastIndexOf('z', 5) == -1);
     }
 }
+
+TEST_CASE("StringView", "[core][String]")
+{
+    String str = "Content-Length: 1234 ";
+    StringView view(str);
+    REQUIRE(view.length() == str.length());
+
+    int colon = view.indexOf(':');
+    REQUIRE(colon == 14);
+    StringView name = view.substring(0, colon);
+    StringView value = view.substring(colon + 1).trim();
+    REQUIRE(name == "Content-Length");
+    REQUIRE(name.equalsIgnoreCase(F("content-length")));
+    REQUIRE(!name.equals(F("content-length")));
+    REQUIRE(value == "1234");
+    REQUIRE(value.toInt() == 1234);
+    REQUIRE(view.substring(30, 40).isEmpty());
+    REQUIRE(view.indexOf(StringView("Length")) == 8);
+    REQUIRE(view.indexOf(StringView("length")) == -1);
+    REQUIRE(view.lastIndexOf('4') == 19);
+    REQUIRE(view.startsWith(F("Content")));
+    REQUIRE(view.endsWith("4 "));
+    REQUIRE(StringView("abc").compareTo("abd") < 0);
+    REQUIRE(StringView("abc").compareTo("ab") > 0);
+    REQUIRE(StringView("ab").compareTo("abc") < 0);
+    REQUIRE(StringView().compareTo("") == 0);
+
+    REQUIRE(String(name) == "Content-Length");
+    String copy;
+    copy += value;
+    copy.concat(StringView(F("!")));
+    REQUIRE(copy == "1234!");
+
+    char buf[5];
+    REQUIRE(name.copyTo(buf, sizeof(buf)) == 4);
+    REQUIRE(strcmp(buf, "Cont") == 0);
+}
+
+TEST_CASE("StringView::parse", "[core][String]")
+{
+    long l = 7;
+    unsigned long ul = 7;
+    REQUIRE(StringView("-42").parseLong(l));
+    REQUIRE(l == -42);
+    REQUIRE(StringView("1aF").parseULong(ul, 16));
+    REQUIRE(ul == 0x1af);
+    char max[24], min[24];
+    snprintf(max, sizeof(max), "%ld", LONG_MAX);
+    snprintf(min, sizeof(min), "%ld", LONG_MIN);
+    REQUIRE(StringView(max).parseLong(l));
+    REQUIRE(l == LONG_MAX);
+    REQUIRE(StringView(min).parseLong(l));
+    REQUIRE(l == LONG_MIN);
+
+    l = ul = 7;
+    REQUIRE(!StringView("").parseLong(l));
+    REQUIRE(!StringView("-").parseLong(l));
+    REQUIRE(!StringView("12 ").parseLong(l));
+    REQUIRE(!StringView("1g").parseULong(ul, 16));
+    REQUIRE(!StringView("99999999999999999999").parseULong(ul));
+    REQUIRE(l == 7);
+    REQUIRE(ul == 7);
+
+    REQUIRE(StringView("  -12abc").toInt() == -12);
+    REQUIRE(StringView("abc").toInt() == 0);
+    REQUIRE(StringView("3.25 ").toFloat() == 3.25f);
+}
+
+TEST_CASE("Decimal formatting", "[core][String]")
+{
+    char expected[32];
+    char digits[40];
+    char* end = digits + sizeof(digits);
+
+    // below 10000 utoa_dec() divides by 100 with a multiply, every value
+    // there and around the powers of 10 is checked
+    for (unsigned int v = 0; v < 100000; ++v) {
+        snprintf(expected, sizeof(expected), "%u", v);
+        REQUIRE(String(v) == expected);
+    }
+    for (unsigned long long p = 10; p && p <= ULLONG_MAX / 10; p *= 10) {
+        for (unsigned long long v : { p - 1, p, p + 1, 3 * p - 7 }) {
+            snprintf(expected, sizeof(expected), "%llu", v);
+            char* first = ulltoa_dec(v, end);
+            REQUIRE(std::string(first, end) == expected);
+            if (v <= UINT_MAX) {
+                first = utoa_dec(v, end);
+                REQUIRE(std::string(first, end) == expected);
+            }
+        }
+    }
+    REQUIRE(std::string(utoa_dec(UINT_MAX, end), end) == "4294967295");
+    REQUIRE(std::string(ulltoa_dec(ULLONG_MAX, end), end) == "18446744073709551615");
+
+    snprintf(expected, sizeof(expected), "%ld", LONG_MIN);
+    REQUIRE(String(LONG_MIN) == expected);
+    REQUIRE(String(LONG_MIN, 10) == expected);
+    snprintf(expected, sizeof(expected), "%lu", ULONG_MAX);
+    REQUIRE(String(ULONG_MAX) == expected);
+    REQUIRE(String(INT_MIN) == "-2147483648");
+    REQUIRE(String(LLONG_MIN) == "-9223372036854775808");
+
+    // too small a buffer is refused, not overrun
+    REQUIRE(ulltoa(12345, digits, 6, 10) == digits);
+    REQUIRE(strcmp(digits, "12345") == 0);
+    REQUIRE(ulltoa(12345, digits, 5, 10) == nullptr);
+
+    REQUIRE(strcmp(dtostrf(3.14159, 0, 5, digits), "3.14159") == 0);
+    REQUIRE(strcmp(dtostrf(-2.123, 0, 3, digits), "-2.123") == 0);
+    REQUIRE(strcmp(dtostrf(1.999, 0, 2, digits), "2.00") == 0);
+    REQUIRE(strcmp(dtostrf(0.285, 0, 2, digits), "0.29") == 0);
+    REQUIRE(strcmp(dtostrf(-0.001, 0, 2, digits), "-0.00") == 0);
+    REQUIRE(strcmp(dtostrf(2.5, 0, 0, digits), "3") == 0);
+    REQUIRE(strcmp(dtostrf(0.5, 6, 1, digits), "   0.5") == 0);
+    REQUIRE(strcmp(dtostrf(-12.5, 7, 2, digits), " -12.50") == 0);
+    REQUIRE(strcmp(dtostrf(123456789.0, 0, 0, digits), "123456789") == 0);
+    // beyond 64 bits once scaled, the digit loop is used
+    REQUIRE(strlen(dtostrf(1e30, 0, 0, digits)) == 31);
+    REQUIRE(strncmp(digits, "100000000000000", 15) == 0);
+    REQUIRE(String(123.45, 2) == "123.45");
+    REQUIRE(String(-0.125f, 3) == "-0.125");
+}
@@ -0,0 +1,67 @@
+/*
+ test_time.cpp - localtime_cached() and isotime_r() tests
+ Copyright (c) 2020 esp8266/Arduino
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <Arduino.h>
+
+static bool sameTime(const struct tm& a, const struct tm& b)
+{
+    return a.tm_year == b.tm_year && a.tm_mon == b.tm_mon && a.tm_mday == b.tm_mday
+        && a.tm_hour == b.tm_hour && a.tm_min == b.tm_min && a.tm_sec == b.tm_sec
+        && a.tm_wday == b.tm_wday && a.tm_yday == b.tm_yday && a.tm_isdst == b.tm_isdst;
+}
+
+TEST_CASE("localtime_cached matches localtime_r", "[time]")
+{
+    setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+    tzset();
+
+    // around the 2020 DST changes and new year, forward and backward
+    const time_t starts[] = { 1585443600 - 7200, 1603587600 - 7200, 1609455600 - 7200 };
+    for (time_t start : starts)
+    {
+        for (time_t t = start; t < start + 4 * 3600; t += 7)
+        {
+            struct tm expected, cached;
+            localtime_r(&t, &expected);
+            REQUIRE(localtime_cached(&t, &cached) == &cached);
+            REQUIRE(sameTime(cached, expected));
+        }
+        for (time_t t = start + 4 * 3600; t > start; t -= 13)
+        {
+            struct tm expected, cached;
+            localtime_r(&t, &expected);
+            localtime_cached(&t, &cached);
+            REQUIRE(sameTime(cached, expected));
+        }
+    }
+}
+
+TEST_CASE("isotime_r", "[time]")
+{
+    struct tm tm = { };
+    tm.tm_year = 2020 - 1900;
+    tm.tm_mon = 8;
+    tm.tm_mday = 30;
+    tm.tm_hour = 7;
+    tm.tm_min = 4;
+    tm.tm_sec = 5;
+    char buf[20];
+    REQUIRE(isotime_r(&tm, buf) == buf);
+    REQUIRE(strcmp(buf, "2020-09-30T07:04:05") == 0);
+}
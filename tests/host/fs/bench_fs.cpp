@@ -0,0 +1,159 @@
+/*
+ bench_fs.cpp - LittleFS, SPIFFS and SDFS workloads on host
+
+ Hidden from the default run, use "make bench" (or TEST_ARGS="[bench]").
+ Times are host times, only good to compare filesystems and builds with
+ each other (see tests/device/test_sw_FS_bench for the esp8266 figures).
+ The flash_hal calls, from flash_stats_get(), are what the same workload
+ costs on the device in flash operations and wear, whatever the host speed.
+ SDFS does not go through flash_hal and shows none.
+
+ Workloads:
+ - seq write: one 128KB file in 256 byte writes
+ - seq read: the same file in 256 byte reads
+ - random write: 16 bytes at random places of that file, reopened each time
+ - open/close: opening that file for reading and closing it
+ - dir list: listing a directory of 32 files
+ */
+
+#include <catch.hpp>
+#include <chrono>
+#include <FS.h>
+#include "../common/spiffs_mock.h"
+#include "../common/littlefs_mock.h"
+#include "../common/sdfs_mock.h"
+#include <spiffs/spiffs.h>
+#include <LittleFS.h>
+#include "../../../libraries/SDFS/src/SDFS.h"
+
+namespace
+{
+constexpr size_t fileSize  = 128 * 1024;
+constexpr size_t chunk     = 256;
+constexpr int    smallOps  = 200;
+constexpr int    dirFiles  = 32;
+constexpr int    dirRounds = 20;
+
+uint32_t flashCount(int op)
+{
+    flash_stats_t stats;
+    REQUIRE(flash_stats_get(op, &stats));
+    return stats.count;
+}
+
+template <typename Fn>
+void bench(const char* fsName, const char* name, int ops, Fn&& run)
+{
+    using clock      = std::chrono::steady_clock;
+    uint32_t reads   = flashCount(FLASH_STATS_READ);
+    uint32_t writes  = flashCount(FLASH_STATS_WRITE);
+    uint32_t erases  = flashCount(FLASH_STATS_ERASE);
+    auto     start   = clock::now();
+    int      done    = run();
+    std::chrono::duration<double> elapsed = clock::now() - start;
+    REQUIRE(done == ops);
+    printf("%-8s %-14s %10.0f ops/s  flash reads %7u writes %6u erases %5u\n", fsName, name,
+           ops / elapsed.count(), flashCount(FLASH_STATS_READ) - reads,
+           flashCount(FLASH_STATS_WRITE) - writes, flashCount(FLASH_STATS_ERASE) - erases);
+}
+
+void benchFS(FS& fs, const char* fsName)
+{
+    REQUIRE(fs.format());
+    REQUIRE(fs.begin());
+    uint8_t buf[chunk];
+    memset(buf, 'x', sizeof(buf));
+    uint32_t seed = 1;
+    auto     rnd  = [&seed]()
+    {
+        seed = seed * 1103515245 + 12345;
+        return seed >> 8;
+    };
+
+    bench(fsName, "seq write", fileSize / chunk, [&]()
+    {
+        File f = fs.open("/seq.bin", "w");
+        int  n = 0;
+        for (size_t i = 0; i < fileSize; i += chunk)
+        {
+            n += f.write(buf, chunk) == chunk;
+        }
+        return n;
+    });
+
+    bench(fsName, "seq read", fileSize / chunk, [&]()
+    {
+        File f = fs.open("/seq.bin", "r");
+        int  n = 0;
+        while (f.read(buf, chunk) == (int)chunk)
+        {
+            n++;
+        }
+        return n;
+    });
+
+    bench(fsName, "random write", smallOps, [&]()
+    {
+        int n = 0;
+        for (int i = 0; i < smallOps; i++)
+        {
+            File f = fs.open("/seq.bin", "r+");
+            n += f.seek(rnd() % (fileSize - 16)) && (f.write(buf, 16) == 16);
+        }
+        return n;
+    });
+
+    bench(fsName, "open/close", smallOps, [&]()
+    {
+        int n = 0;
+        for (int i = 0; i < smallOps; i++)
+        {
+            File f = fs.open("/seq.bin", "r");
+            n += !!f;
+            f.close();
+        }
+        return n;
+    });
+
+    for (int i = 0; i < dirFiles; i++)
+    {
+        File f = fs.open(String("/dir/file") + i, "w");
+        f.write(buf, 16);
+    }
+    bench(fsName, "dir list", dirRounds * dirFiles, [&]()
+    {
+        int n = 0;
+        for (int i = 0; i < dirRounds; i++)
+        {
+            Dir dir = fs.openDir("/dir");
+            while (dir.next())
+            {
+                n++;
+            }
+        }
+        return n;
+    });
+    fs.end();
+}
+}  // namespace
+
+TEST_CASE("LittleFS workloads", "[.][bench][fs]")
+{
+    LITTLEFS_MOCK_DECLARE(1024, 4, 256, "");
+    benchFS(LittleFS, "LittleFS");
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+TEST_CASE("SPIFFS workloads", "[.][bench][fs]")
+{
+    SPIFFS_MOCK_DECLARE(1024, 8, 256, "");
+    benchFS(SPIFFS, "SPIFFS");
+}
+#pragma GCC diagnostic pop
+
+TEST_CASE("SDFS workloads", "[.][bench][fs]")
+{
+    SDFS_MOCK_DECLARE(64, 8, 512, "");
+    benchFS(SDFS, "SDFS");
+}
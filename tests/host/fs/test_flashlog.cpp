@@ -0,0 +1,154 @@
+/*
+ test_flashlog.cpp - host side FlashLog tests
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <FlashLog.h>
+
+extern "C"
+{
+    extern uint32_t s_phys_size;
+    extern uint8_t* s_phys_data;
+}
+
+namespace
+{
+struct FlashImage
+{
+    std::vector<uint8_t> data;
+    FlashImage(size_t sectors) : data(sectors * FLASH_SECTOR_SIZE, 0xff)
+    {
+        s_phys_data = data.data();
+        s_phys_size = data.size();
+    }
+    ~FlashImage()
+    {
+        s_phys_data = nullptr;
+        s_phys_size = 0;
+    }
+};
+
+String record(int i)
+{
+    return String("record ") + i + String(' ', i % 37);
+}
+
+std::vector<String> readAll(FlashLog& log)
+{
+    std::vector<String> records;
+    char                buf[128];
+    int                 len;
+    log.rewind();
+    while ((len = log.next(buf, sizeof(buf))) >= 0)
+    {
+        String s;
+        s.concat(buf, std::min(len, (int)sizeof(buf)));
+        records.push_back(s);
+    }
+    return records;
+}
+}  // namespace
+
+TEST_CASE("FlashLog appends and reads records back after begin()", "[flashlog]")
+{
+    FlashImage flash(4);
+    FlashLog   log(0, flash.data.size());
+    REQUIRE(log.begin());
+    REQUIRE(log.sectors() == 4);
+    REQUIRE(readAll(log).empty());
+
+    for (int i = 0; i < 100; i++)
+    {
+        REQUIRE(log.append(record(i)));
+    }
+    REQUIRE_FALSE(log.append(nullptr, 1));
+    REQUIRE_FALSE(log.append(std::vector<uint8_t>(FLASHLOG_RECORD_MAX + 1).data(), FLASHLOG_RECORD_MAX + 1));
+
+    FlashLog again(0, flash.data.size());
+    REQUIRE(again.begin());
+    auto records = readAll(again);
+    REQUIRE(records.size() == 100);
+    REQUIRE(records[0] == record(0));
+    REQUIRE(records[99] == record(99));
+
+    // Appends go on where the first log stopped
+    REQUIRE(again.append(record(100)));
+    REQUIRE(readAll(again).back() == record(100));
+}
+
+TEST_CASE("FlashLog wraps around, dropping the oldest sector", "[flashlog]")
+{
+    FlashImage flash(3);
+    FlashLog   log(0, flash.data.size());
+    REQUIRE(log.begin());
+    int n = 2000;  // ~60 bytes each, several times the partition
+    for (int i = 0; i < n; i++)
+    {
+        REQUIRE(log.append(record(i)));
+    }
+    auto records = readAll(log);
+    REQUIRE(records.size() > 100);
+    REQUIRE(records.back() == record(n - 1));
+    int first = n - records.size();
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        REQUIRE(records[i] == record(first + i));
+    }
+
+    FlashLog again(0, flash.data.size());
+    REQUIRE(again.begin());
+    REQUIRE(readAll(again) == records);
+
+    // A reader in the sector which gets erased moves on to the oldest left
+    again.rewind();
+    char buf[128];
+    REQUIRE(again.next(buf, sizeof(buf)) > 0);
+    for (int i = n; i < n + 200; i++)
+    {
+        REQUIRE(again.append(record(i)));
+    }
+    int len = again.next(buf, sizeof(buf));
+    REQUIRE(len > 0);
+    REQUIRE(String(buf).substring(0, len) != record(first + 1));
+}
+
+TEST_CASE("FlashLog skips records cut by a reset", "[flashlog]")
+{
+    FlashImage flash(2);
+    FlashLog   log(0, flash.data.size());
+    REQUIRE(log.begin());
+    REQUIRE(log.append(String("first")));
+    REQUIRE(log.append(String("second")));
+    REQUIRE(log.append(String("third")));
+
+    // Data of the second record half written
+    flash.data[16 + 8 + 5 + 8 + 7] = 0xff;
+    {
+        FlashLog again(0, flash.data.size());
+        REQUIRE(again.begin());
+        REQUIRE((readAll(again) == std::vector<String> { "first", "third" }));
+        REQUIRE(again.append(String("fourth")));
+        REQUIRE((readAll(again) == std::vector<String> { "first", "third", "fourth" }));
+    }
+
+    // Length of the last record half written: the sector is closed
+    size_t last = 16 + 3 * (8 + 8);
+    flash.data[last + 2] = 0xff;
+    flash.data[last + 3] = 0xff;
+    FlashLog again(0, flash.data.size());
+    REQUIRE(again.begin());
+    REQUIRE((readAll(again) == std::vector<String> { "first", "third" }));
+    REQUIRE(again.append(String("fifth")));
+    REQUIRE((readAll(again) == std::vector<String> { "first", "third", "fifth" }));
+
+    // Records of a previous log do not come back after format()
+    REQUIRE(again.format());
+    REQUIRE(readAll(again).empty());
+}
@@ -16,6 +16,7 @@
 #include <catch.hpp>
 #include <map>
 #include <FS.h>
+#include <Schedule.h>
 #include "../common/spiffs_mock.h"
 #include "../common/littlefs_mock.h"
 #include "../common/sdfs_mock.h"
@@ -57,6 +58,53 @@ TEST_CASE("SPIFFS checks the config object passed in", "[fs]")
     REQUIRE_FALSE(SPIFFS.setConfig(d));
     REQUIRE_FALSE(LittleFS.setConfig(l));
 }
+
+TEST_CASE("SPIFFS stat cache follows writes, removes and renames", "[fs]")
+{
+    SPIFFS_MOCK_DECLARE(64, 8, 512, "");
+    REQUIRE(SPIFFS.begin());
+    REQUIRE(SPIFFS.setStatCache(4));
+
+    FSStat st;
+    REQUIRE_FALSE(SPIFFS.stat("/log.txt", st));
+    REQUIRE_FALSE(SPIFFS.exists("/log.txt"));
+    REQUIRE_FALSE(SPIFFS.open("/log.txt", "r"));
+
+    File f = SPIFFS.open("/log.txt", "a");
+    REQUIRE(f);
+    REQUIRE(f.print("hello") == 5);
+    f.flush();
+    REQUIRE(SPIFFS.stat("/log.txt", st));
+    REQUIRE(st.size == 5);
+    REQUIRE_FALSE(st.isDir);
+    REQUIRE(f.print(" world") == 6);
+    f.close();
+    REQUIRE(SPIFFS.stat("/log.txt", st));
+    REQUIRE(st.size == 11);
+
+    // Names differ, the cache must not mix them up
+    for (int i = 0; i < 8; i++)
+    {
+        REQUIRE_FALSE(SPIFFS.exists(String("/none") + i));
+    }
+    REQUIRE(SPIFFS.exists("/log.txt"));
+
+    REQUIRE(SPIFFS.rename("/log.txt", "/old.txt"));
+    REQUIRE_FALSE(SPIFFS.exists("/log.txt"));
+    REQUIRE(SPIFFS.stat("/old.txt", st));
+    REQUIRE(st.size == 11);
+    REQUIRE(SPIFFS.remove("/old.txt"));
+    REQUIRE_FALSE(SPIFFS.stat("/old.txt", st));
+
+    // Shared by copies of the FS object
+    FS copy = SPIFFS;
+    REQUIRE_FALSE(copy.exists("/new.txt"));
+    f = SPIFFS.open("/new.txt", "w");
+    f.close();
+    REQUIRE(copy.exists("/new.txt"));
+    REQUIRE(SPIFFS.setStatCache(0));
+    REQUIRE(copy.exists("/new.txt"));
+}
 #pragma GCC diagnostic pop
 
 };  // namespace spiffs_test
@@ -94,6 +142,92 @@ TEST_CASE("LittleFS checks the config object passed in", "[fs]")
     REQUIRE(LittleFS.setConfig(l));
 }
 
+TEST_CASE("LittleFS checks the cache geometry and buffers writes", "[fs]")
+{
+    LITTLEFS_MOCK_DECLARE(64, 8, 512, "");
+    REQUIRE_FALSE(LittleFS.setConfig(LittleFSConfig().setCacheSize(96)));
+    REQUIRE_FALSE(LittleFS.setConfig(LittleFSConfig().setLookaheadSize(12)));
+    REQUIRE(LittleFS.setConfig(LittleFSConfig().setPreset(LittleFSConfig::PRESET_LOGGING)));
+    REQUIRE(LittleFS.begin());
+
+    File f = LittleFS.open("/log.txt", "a");
+    REQUIRE(f);
+    for (int i = 0; i < 100; i++) {
+        f.printf("line %03d\n", i);
+    }
+    REQUIRE(f.size() == 900);
+    REQUIRE(f.position() == 900);
+    f.close();
+
+    f = LittleFS.open("/log.txt", "r");
+    REQUIRE(f.size() == 900);
+    String s = f.readString();
+    REQUIRE(s.startsWith("line 000\n"));
+    REQUIRE(s.endsWith("line 099\n"));
+}
+
+TEST_CASE("LittleFS writes into blocks erased in the background", "[fs]")
+{
+    LITTLEFS_MOCK_DECLARE(64, 8, 512, "");
+    REQUIRE(LittleFS.setConfig(LittleFSConfig().setEraseAhead(4)));
+    REQUIRE(LittleFS.begin());
+
+    String line(' ', 100);
+    for (int n = 0; n < 8; n++) {
+        // Let the scheduler refill the pool between files
+        for (int i = 0; i < 8; i++) {
+            run_scheduled_functions();
+        }
+        File f = LittleFS.open(String("/f") + n, "w");
+        REQUIRE(f);
+        for (int i = 0; i < 50; i++) {
+            line.setCharAt(0, 'a' + n);
+            REQUIRE(f.print(line) == 100);
+        }
+        f.close();
+    }
+    for (int n = 0; n < 8; n++) {
+        File f = LittleFS.open(String("/f") + n, "r");
+        REQUIRE(f.size() == 5000);
+        String s = f.readString();
+        REQUIRE(s[0] == 'a' + n);
+        REQUIRE(s[4900] == 'a' + n);
+    }
+    LittleFS.end();
+    REQUIRE(LittleFS.begin());
+    REQUIRE(LittleFS.exists("/f7"));
+}
+
+TEST_CASE("LittleFS maps the data of files opened for reading", "[fs]")
+{
+    LITTLEFS_MOCK_DECLARE(64, 8, 512, "");
+    REQUIRE(LittleFS.begin());
+
+    File f = LittleFS.open("/data.bin", "w");
+    REQUIRE(f);
+    for (int i = 0; i < 10000; i++) {
+        f.write((uint8_t)(i * 7));
+    }
+    size_t len;
+    REQUIRE(f.mappedData(len) == nullptr);
+    REQUIRE(len == 0);
+    f.close();
+
+    f = LittleFS.open("/data.bin", "r");
+    size_t pos = 0;
+    const uint8_t* data;
+    while ((data = f.mappedData(len))) {
+        REQUIRE(len > 0);
+        REQUIRE(f.position() == pos);
+        for (size_t i = 0; i < len; i++) {
+            REQUIRE(data[i] == (uint8_t)((pos + i) * 7));
+        }
+        pos += len;
+        REQUIRE(f.seek(pos));
+    }
+    REQUIRE(pos == 10000);
+}
+
 };  // namespace littlefs_test
 
 namespace sdfs_test
@@ -0,0 +1,192 @@
+/*
+ test_packedfs.cpp - host side PackedFS tests
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include <catch.hpp>
+#include <map>
+#include <set>
+#include <vector>
+#include <FS.h>
+#include <MD5Builder.h>
+#include <base64.h>
+#include <PackedFS.h>
+
+using packedfs_impl::PackedFSConfig;
+using packedfs_impl::PackedFSImpl;
+
+extern "C"
+{
+    extern uint32_t s_phys_size;
+    extern uint8_t* s_phys_data;
+}
+
+namespace
+{
+// Same layout as tools/mkpackedfs.py writes
+std::vector<uint8_t> packImage(const std::map<std::string, std::string>& files)
+{
+    auto put32 = [](std::vector<uint8_t>& v, size_t at, uint32_t x)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            v[at + i] = (uint8_t)(x >> (8 * i));
+        }
+    };
+    size_t namesAt = 16 + 28 * files.size();
+    std::vector<uint8_t> image(namesAt);
+    std::vector<size_t>  nameOffsets;
+    for (const auto& f : files)
+    {
+        nameOffsets.push_back(image.size());
+        image.insert(image.end(), f.first.begin(), f.first.end());
+        image.push_back(0);
+    }
+    size_t i = 0;
+    for (const auto& f : files)
+    {
+        image.resize((image.size() + 3) & ~3);
+        size_t entry = 16 + 28 * i;
+        put32(image, entry, nameOffsets[i]);
+        put32(image, entry + 4, image.size());
+        put32(image, entry + 8, f.second.size());
+        MD5Builder md5;
+        md5.begin();
+        md5.add((const uint8_t*)f.second.data(), f.second.size());
+        md5.calculate();
+        md5.getBytes(&image[entry + 12]);
+        image.insert(image.end(), f.second.begin(), f.second.end());
+        i++;
+    }
+    memcpy(&image[0], "PKF1", 4);
+    put32(image, 4, files.size());
+    put32(image, 8, image.size());
+    put32(image, 12, 1234567890);
+    return image;
+}
+
+const std::map<std::string, std::string> assets = {
+    { "index.html.gz", "not really gzip" },
+    { "css/site.css", "body { color: red; }" },
+    { "css/theme/dark.css", "body { color: white; }" },
+    { "js/app.js", std::string(5000, 'x') },
+    { "favicon.ico", "ico" },
+};
+
+String readAll(File& f)
+{
+    String s;
+    char   buf[64];
+    int    n;
+    while ((n = f.read((uint8_t*)buf, sizeof(buf))) > 0)
+    {
+        s.concat(buf, n);
+    }
+    return s;
+}
+}  // namespace
+
+TEST_CASE("PackedFS opens, reads and maps files of an image", "[packedfs]")
+{
+    auto             image = packImage(assets);
+    PackedFileSystem fs(std::make_shared<PackedFSImpl>(0, 0));
+    REQUIRE_FALSE(fs.begin());  // nothing in the (empty) flash region
+    REQUIRE(fs.setConfig(PackedFSConfig().setImage(image.data())));
+    REQUIRE(fs.begin());
+
+    File f = fs.open("/css/site.css", "r");
+    REQUIRE(f);
+    REQUIRE(f.isFile());
+    REQUIRE(f.size() == 20);
+    REQUIRE(String(f.name()) == "site.css");
+    REQUIRE(readAll(f) == "body { color: red; }");
+    REQUIRE(f.seek(5));
+    REQUIRE(f.read() == '{');
+    REQUIRE_FALSE(f.seek(21));
+    REQUIRE(f.getLastWrite() == 1234567890);
+
+    f = fs.open("js/app.js", "r");
+    size_t len;
+    const uint8_t* data = f.mappedData(len);
+    REQUIRE(data);
+    REQUIRE(len == 5000);
+    REQUIRE(data[4999] == 'x');
+
+    REQUIRE_FALSE(fs.open("/css/site.css", "w"));
+    REQUIRE_FALSE(fs.open("/css/missing.css", "r"));
+    REQUIRE_FALSE(fs.open("/css", "r"));
+    REQUIRE_FALSE(fs.remove("/favicon.ico"));
+    REQUIRE(fs.exists("/favicon.ico"));
+    REQUIRE(fs.exists("/index.html.gz"));
+    REQUIRE_FALSE(fs.exists("/index.html"));
+    REQUIRE(fs.exists("/css/theme"));
+    REQUIRE_FALSE(fs.exists("/cs"));
+}
+
+TEST_CASE("PackedFS lists directories and subdirectories once", "[packedfs]")
+{
+    auto             image = packImage(assets);
+    PackedFileSystem fs(std::make_shared<PackedFSImpl>(0, 0));
+    REQUIRE(fs.setConfig(PackedFSConfig().setImage(image.data())));
+    REQUIRE(fs.begin());
+
+    std::set<String> root;
+    Dir              dir = fs.openDir("/");
+    while (dir.next())
+    {
+        REQUIRE(root.insert(String(dir.fileName()) + (dir.isDirectory() ? "/" : "")).second);
+    }
+    REQUIRE((root == std::set<String> { "css/", "favicon.ico", "index.html.gz", "js/" }));
+
+    std::set<String> css;
+    dir = fs.openDir("/css/");
+    while (dir.next())
+    {
+        css.insert(String(dir.fileName()) + (dir.isDirectory() ? "/" : ""));
+        if (dir.isFile())
+        {
+            REQUIRE(dir.fileSize() == 20);
+            File f = dir.openFile("r");
+            REQUIRE(readAll(f) == "body { color: red; }");
+        }
+    }
+    REQUIRE((css == std::set<String> { "site.css", "theme/" }));
+}
+
+TEST_CASE("PackedFS tells the ETags ESP8266WebServer would compute", "[packedfs]")
+{
+    auto             image = packImage(assets);
+    PackedFileSystem fs(std::make_shared<PackedFSImpl>(0, 0));
+    REQUIRE(fs.setConfig(PackedFSConfig().setImage(image.data())));
+    REQUIRE(fs.begin());
+
+    File       f = fs.open("/js/app.js", "r");
+    MD5Builder md5;
+    md5.begin();
+    md5.addStream(f, f.size());
+    md5.calculate();
+    uint8_t digest[16];
+    md5.getBytes(digest);
+    REQUIRE(fs.eTag("/js/app.js") == "\"" + base64::encode(digest, 16, false) + "\"");
+    REQUIRE(fs.eTag("/js/none.js") == "");
+}
+
+TEST_CASE("PackedFS reads an image from the filesystem region", "[packedfs]")
+{
+    auto image  = packImage(assets);
+    s_phys_data = image.data();
+    s_phys_size = image.size();
+
+    PackedFileSystem fs(std::make_shared<PackedFSImpl>(0, image.size()));
+    REQUIRE(fs.begin());
+    File f = fs.open("/css/theme/dark.css", "r");
+    REQUIRE(readAll(f) == "body { color: white; }");
+
+    s_phys_data = nullptr;
+    s_phys_size = 0;
+}
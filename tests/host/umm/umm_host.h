@@ -0,0 +1,44 @@
+/*
+ umm_host.h - preinclude to build cores/esp8266/umm_malloc on the host
+
+ The allocator runs on the simulated heap of umm_sim.cpp, _heap_start[] of
+ UMM_HOST_HEAP_SIZE bytes, with the ROM functions mapped to libc.
+*/
+
+#ifndef __UMM_HOST_H
+#define __UMM_HOST_H
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// as common/mock.h, without Arduino.h
+#define CORE_MOCK 1
+typedef uint8_t uint8;
+typedef uint32_t uint32;
+#include "c_types.h"
+
+#ifndef UMM_HOST_HEAP_SIZE
+#define UMM_HOST_HEAP_SIZE (80 * 1024)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline void* ets_memcpy(void* dst, const void* src, size_t n) { return memcpy(dst, src, n); }
+static inline void* ets_memmove(void* dst, const void* src, size_t n) { return memmove(dst, src, n); }
+static inline void* ets_memset(void* dst, int c, size_t n) { return memset(dst, c, n); }
+static inline void ets_uart_putc1(char c) { putchar(c); }
+static inline int ets_vprintf(void (*putc)(char), const char* fmt, va_list ap)
+{
+    (void)putc;
+    return vprintf(fmt, ap);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UMM_HOST_H
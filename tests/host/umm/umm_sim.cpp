@@ -0,0 +1,284 @@
+/*
+ umm_sim.cpp - umm_malloc on a simulated heap, replaying allocation traces
+
+ Built by "make umm-sim", once per allocator policy (best fit, first fit,
+ size classes front-end), each binary running umm_malloc.cpp unchanged on
+ _heap_start[] of UMM_HOST_HEAP_SIZE bytes (80KB by default).
+
+ With no argument, the synthetic workloads below are run.  Otherwise each
+ argument is a trace printed by umm_heap_trace_print() (-DUMM_HEAP_TRACE),
+ one "time op size caller ptr" line per call; the other lines of a serial
+ log are skipped.  The trace doesn't tell which block a realloc() moved:
+ one of a traced block is replayed on it, any other as a new allocation,
+ and frees of blocks allocated before the trace started are ignored.
+
+ One line per workload: operations, failed allocations, host time per
+ operation, then free bytes, largest free block and fragmentation at the
+ end, and the worst fragmentation and smallest largest block seen.  The
+ times only compare policies with each other, the heap figures are what
+ the device gets for the same sequence of calls.
+ */
+
+#include <chrono>
+#include <map>
+#include <stdio.h>
+#include <string.h>
+#include "umm_malloc/umm_malloc.h"
+
+#ifndef UMM_SIM_POLICY
+#define UMM_SIM_POLICY "default"
+#endif
+
+extern "C"
+{
+    alignas(8) char _heap_start[UMM_HOST_HEAP_SIZE];
+    uint32_t sqrt32(uint32_t n);
+}
+
+namespace
+{
+
+struct Stats
+{
+    size_t   ops         = 0;
+    size_t   failed      = 0;
+    uint64_t ns          = 0;
+    int      worstFrag   = 0;
+    size_t   minMaxBlock = UMM_HOST_HEAP_SIZE;
+};
+
+class Heap
+{
+public:
+    Heap()
+    {
+        umm_init();
+    }
+
+    void* malloc(size_t size)
+    {
+        return timed([&]() { return umm_malloc(size); }, size);
+    }
+
+    void* realloc(void* ptr, size_t size)
+    {
+        return timed([&]() { return umm_realloc(ptr, size); }, size);
+    }
+
+    void free(void* ptr)
+    {
+        auto start = std::chrono::steady_clock::now();
+        umm_free(ptr);
+        account(start);
+    }
+
+    void report(const char* workload)
+    {
+        sample();
+        printf("%-10s %-16s %7zu ops %5zu failed %6.1f ns/op %6zu free %6zu maxblock %3d%% frag"
+               " %3d%% worst %6zu minblock\n",
+               UMM_SIM_POLICY, workload, _stats.ops, _stats.failed,
+               _stats.ops ? (double)_stats.ns / _stats.ops : 0.0, umm_free_heap_size(),
+               umm_max_block_size(), umm_fragmentation_metric(), _stats.worstFrag,
+               _stats.minMaxBlock);
+    }
+
+protected:
+    template<typename Fn>
+    void* timed(Fn&& alloc, size_t size)
+    {
+        auto  start = std::chrono::steady_clock::now();
+        void* ptr   = alloc();
+        account(start);
+        if (!ptr && size)
+        {
+            _stats.failed++;
+        }
+        return ptr;
+    }
+
+    void account(std::chrono::steady_clock::time_point start)
+    {
+        _stats.ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+        // sampled, umm_info() walks the whole heap
+        if (++_stats.ops % 16 == 0)
+        {
+            sample();
+        }
+    }
+
+    void sample()
+    {
+        int frag = umm_fragmentation_metric();
+        if (frag > _stats.worstFrag)
+        {
+            _stats.worstFrag = frag;
+        }
+        size_t block = umm_max_block_size();
+        if (block < _stats.minMaxBlock)
+        {
+            _stats.minMaxBlock = block;
+        }
+    }
+
+    Stats _stats;
+};
+
+// deterministic, the same sequence for each policy
+uint32_t lcg(uint32_t& seed)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+// Random sizes from [minSize, maxSize), kept below live blocks at once,
+// freed in random order, with a few long lived blocks of longSize.
+void churn(const char* name, size_t minSize, size_t maxSize, size_t live, size_t longSize,
+           size_t rounds)
+{
+    Heap     heap;
+    uint32_t seed = 1;
+    void*    blocks[256] = {};
+    void*    longLived[4] = {};
+    for (size_t round = 0; round < rounds; round++)
+    {
+        size_t i = lcg(seed) % live;
+        if (blocks[i])
+        {
+            heap.free(blocks[i]);
+            blocks[i] = nullptr;
+        }
+        else
+        {
+            blocks[i] = heap.malloc(minSize + lcg(seed) % (maxSize - minSize));
+        }
+        if (longSize && round % (rounds / 8) == 0)
+        {
+            size_t j = (round / (rounds / 8)) % 4;
+            if (longLived[j])
+            {
+                heap.free(longLived[j]);
+            }
+            longLived[j] = heap.malloc(longSize);
+        }
+    }
+    heap.report(name);
+}
+
+// Strings growing by appends, as String += does, then kept or dropped.
+void growing(const char* name, size_t rounds)
+{
+    Heap     heap;
+    uint32_t seed = 7;
+    void*    kept[64] = {};
+    for (size_t round = 0; round < rounds; round++)
+    {
+        void*  s    = nullptr;
+        size_t size = 0;
+        size_t end  = 16 + lcg(seed) % 600;
+        while (size < end)
+        {
+            size += 16;
+            void* grown = heap.realloc(s, size);
+            if (!grown)
+            {
+                break;
+            }
+            s = grown;
+        }
+        size_t k = lcg(seed) % 64;
+        if (kept[k])
+        {
+            heap.free(kept[k]);
+        }
+        kept[k] = s;
+    }
+    heap.report(name);
+}
+
+bool replay(const char* path)
+{
+    FILE* f = fopen(path, "r");
+    if (!f)
+    {
+        perror(path);
+        return false;
+    }
+    Heap                       heap;
+    std::map<uintptr_t, void*> blocks;  // traced pointer, simulated one
+    char                       line[128];
+    while (fgets(line, sizeof(line), f))
+    {
+        unsigned  time, size;
+        char      op;
+        uintptr_t caller, ptr;
+        if (sscanf(line, "%u %c %u %lx %lx", &time, &op, &size, &caller, &ptr) != 5)
+        {
+            continue;
+        }
+        auto known = blocks.find(ptr);
+        switch (op)
+        {
+        case 'M':
+        case 'C':
+        {
+            void* block = heap.malloc(size);
+            if (ptr && block)
+            {
+                blocks[ptr] = block;
+            }
+            break;
+        }
+        case 'R':
+            if (known != blocks.end())
+            {
+                void* block = heap.realloc(known->second, size);
+                if (block)
+                {
+                    known->second = block;
+                }
+            }
+            else if (ptr)
+            {
+                if (void* block = heap.malloc(size))
+                {
+                    blocks[ptr] = block;
+                }
+            }
+            break;
+        case 'F':
+            if (known != blocks.end())
+            {
+                heap.free(known->second);
+                blocks.erase(known);
+            }
+            break;
+        }
+    }
+    fclose(f);
+    const char* name = strrchr(path, '/');
+    heap.report(name ? name + 1 : path);
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        churn("small", 8, 128, 200, 0, 100000);
+        churn("mixed", 8, 2048, 48, 0, 100000);
+        churn("long-lived", 16, 512, 96, 6 * 1024, 100000);
+        growing("growing", 20000);
+        return 0;
+    }
+    int rc = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        rc |= !replay(argv[i]);
+    }
+    return rc;
+}
@@ -1301,6 +1301,21 @@ macros = {
         ('.menu.non32xfer.fast.build.non32xferflags', ''),
         ('.menu.non32xfer.safe', 'Byte/Word access to IRAM/PROGMEM (very slow)' ),
         ('.menu.non32xfer.safe.build.non32xferflags', '-DNON32XFER_HANDLER'),
+        ]),
+
+    ######################## Sketch (cont) stack size
+
+    'contstack_menu': collections.OrderedDict([
+        ('.menu.contstack.4k', '4KB (default)' ),
+        ('.menu.contstack.4k.build.contstackflags', ''),
+        ('.menu.contstack.2k', '2KB (with disable_extra4k_at_link_time())' ),
+        ('.menu.contstack.2k.build.contstackflags', '-DCONT_STACKSIZE=2048'),
+        ('.menu.contstack.3k', '3KB (with disable_extra4k_at_link_time())' ),
+        ('.menu.contstack.3k.build.contstackflags', '-DCONT_STACKSIZE=3072'),
+        ('.menu.contstack.6k', '6KB (in heap)' ),
+        ('.menu.contstack.6k.build.contstackflags', '-DCONT_STACKSIZE=6144'),
+        ('.menu.contstack.8k', '8KB (in heap)' ),
+        ('.menu.contstack.8k.build.contstackflags', '-DCONT_STACKSIZE=8192'),
         ])
     }
 
@@ -1749,6 +1764,7 @@ def all_boards ():
     print('menu.ssl=SSL Support')
     print('menu.mmu=MMU')
     print('menu.non32xfer=Non-32-Bit Access')
+    print('menu.contstack=Sketch Stack Size')
     print('')
 
     missingboards = []
@@ -1769,7 +1785,7 @@ def all_boards ():
                 print(id + optname + '=' + board['opts'][optname])
 
         # macros
-        macrolist = [ 'defaults', 'cpufreq_menu', 'vtable_menu', 'exception_menu', 'stacksmash_menu', 'ssl_cipher_menu', 'mmu_menu', 'non32xfer_menu' ]
+        macrolist = [ 'defaults', 'cpufreq_menu', 'vtable_menu', 'exception_menu', 'stacksmash_menu', 'ssl_cipher_menu', 'mmu_menu', 'non32xfer_menu', 'contstack_menu' ]
         if 'macro' in board:
             macrolist += board['macro']
         macrolist += [ 'lwip', 'debug_menu', 'flash_erase_menu' ]
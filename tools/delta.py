@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Makes the delta patches Updater::applyDelta() applies, from the sketch
+# running on the device (the .bin it was updated with) to a new one.
+# The new image is matched against the old one with bsdiff, either the
+# bsdiff4 python module or a BSDIFF40 patch made by the bsdiff command.
+#
+import argparse
+import bz2
+import hashlib
+import re
+import struct
+import sys
+
+MAGIC = b'ESPD'
+MIN_COPY = 16 # unchanged bytes worth a record of their own
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='Delta update patch tool')
+    parser.add_argument('-m', '--mode', default='diff', help='Mode (diff, apply)')
+    parser.add_argument('-s', '--old', required=True, help='Binary running on the device')
+    parser.add_argument('-n', '--new', help='New binary (diff)')
+    parser.add_argument('-b', '--bsdiff', help='BSDIFF40 patch from old to new, instead of the bsdiff4 module (diff)')
+    parser.add_argument('-p', '--patch', help='Patch to apply (apply)')
+    parser.add_argument('-o', '--out', required=True, help='Output file')
+    return parser.parse_args()
+
+def offtin(b):
+    """bsdiff sign-magnitude 64 bit integer"""
+    y = struct.unpack('<Q', b)[0]
+    return -(y & ~(1 << 63)) if y & (1 << 63) else y
+
+def read_bsdiff(patch):
+    """Returns the control triples and the diff and extra blocks of a BSDIFF40 patch"""
+    if patch[:8] != b'BSDIFF40':
+        raise ValueError('not a BSDIFF40 patch')
+    ctrl_len = offtin(patch[8:16])
+    diff_len = offtin(patch[16:24])
+    ctrl = bz2.decompress(patch[32:32 + ctrl_len])
+    diff = bz2.decompress(patch[32 + ctrl_len:32 + ctrl_len + diff_len])
+    extra = bz2.decompress(patch[32 + ctrl_len + diff_len:])
+    triples = [tuple(offtin(ctrl[i + 8 * j:i + 8 * j + 8]) for j in range(3)) for i in range(0, len(ctrl), 24)]
+    return triples, diff, extra
+
+def make_patch(old, new, bsdiff_patch):
+    triples, diff, extra = read_bsdiff(bsdiff_patch)
+    out = bytearray(MAGIC + struct.pack('<LL', len(new), len(old)) + hashlib.md5(old).digest())
+    def record(copy, diffbytes, extrabytes, seek):
+        out.extend(struct.pack('<LLLl', copy, len(diffbytes), len(extrabytes), seek))
+        out.extend(diffbytes)
+        out.extend(extrabytes)
+    dpos = epos = 0
+    for x, y, z in triples:
+        block = diff[dpos:dpos + x]
+        dpos += x
+        # long runs of unchanged bytes become copies
+        copy, pos, pending = 0, 0, bytearray()
+        for run in re.finditer(b'\x00{%d,}' % MIN_COPY, block):
+            pending.extend(block[pos:run.start()])
+            if pending:
+                record(copy, pending, b'', 0)
+                copy, pending = 0, bytearray()
+            copy += run.end() - run.start()
+            pos = run.end()
+        pending.extend(block[pos:])
+        record(copy, pending, extra[epos:epos + y], z)
+        epos += y
+    return bytes(out)
+
+def apply_patch(old, patch):
+    if patch[:4] != MAGIC:
+        raise ValueError('not a delta patch')
+    size, old_size = struct.unpack('<LL', patch[4:12])
+    if old_size != len(old) or patch[12:28] != hashlib.md5(old).digest():
+        raise ValueError('patch is for another binary')
+    new = bytearray()
+    pos, opos = 28, 0
+    while len(new) < size:
+        copy, d, e, seek = struct.unpack('<LLLl', patch[pos:pos + 16])
+        pos += 16
+        new.extend(old[opos:opos + copy])
+        opos += copy
+        new.extend((old[opos + i] + patch[pos + i]) & 0xff for i in range(d))
+        opos += d
+        pos += d
+        new.extend(patch[pos:pos + e])
+        pos += e
+        opos += seek
+    return bytes(new)
+
+def main():
+    args = parse_args()
+    with open(args.old, 'rb') as f:
+        old = f.read()
+    if args.mode == 'diff':
+        with open(args.new, 'rb') as f:
+            new = f.read()
+        if args.bsdiff:
+            with open(args.bsdiff, 'rb') as f:
+                bsdiff_patch = f.read()
+        else:
+            try:
+                import bsdiff4
+            except ImportError:
+                sys.stderr.write('Needs the bsdiff4 module (pip install bsdiff4) or a --bsdiff patch\n')
+                return 1
+            bsdiff_patch = bsdiff4.diff(old, new)
+        patch = make_patch(old, new, bsdiff_patch)
+        if apply_patch(old, patch) != new:
+            sys.stderr.write('Patch does not rebuild the new binary\n')
+            return 1
+        sys.stderr.write('Patch: %d bytes for %d (%.1f%%)\n' % (len(patch), len(new), 100.0 * len(patch) / len(new)))
+        result = patch
+    elif args.mode == 'apply':
+        with open(args.patch, 'rb') as f:
+            result = apply_patch(old, f.read())
+    else:
+        sys.stderr.write('Unknown mode %s\n' % args.mode)
+        return 1
+    with open(args.out, 'wb') as f:
+        f.write(result)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
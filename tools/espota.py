@@ -27,6 +27,12 @@
 # 2016-01-03:
 # - Added more options to parser.
 #
+# Changes
+# 2026-10-14:
+# - Protocol 2: data is streamed over a window of cumulative acknowledgements
+#   when the device offers it, instead of waiting for each chunk to be acknowledged.
+# - Transfer statistics.
+#
 
 from __future__ import print_function
 import socket
@@ -36,11 +42,14 @@ import optparse
 import logging
 import hashlib
 import random
+import select
+import time
 
 # Commands
 FLASH = 0
 SPIFFS = 100
 AUTH = 200
+PROTOCOL = 2 # newest transfer protocol spoken, devices answer with the one they use
 PROGRESS = False
 # update_progress() : Displays or updates a console progress bar
 ## Accepts a float between 0 and 1. Any int will be converted to a float.
@@ -69,6 +78,56 @@ def update_progress(progress):
     sys.stderr.write('.')
     sys.stderr.flush()
 
+def parse_ok(data):
+  """Returns the window the device offers when data is its OK answer: 0 for protocol 1, None if not OK"""
+  words = data.split()
+  if not words or words[0] != 'OK':
+    return None
+  if len(words) >= 3 and words[1] == '2':
+    return int(words[2])
+  return 0
+
+def upload_acked(connection, f, content_size):
+  """Protocol 1: each chunk waits for its acknowledgement"""
+  offset = 0
+  while True:
+    chunk = f.read(1460)
+    if not chunk: break
+    offset += len(chunk)
+    update_progress(offset/float(content_size))
+    connection.settimeout(10)
+    connection.sendall(chunk)
+    connection.recv(32) # digits, the 'O' of OK is only sent once all is written
+  return ''
+
+def upload_windowed(connection, f, content_size, window):
+  """Protocol 2: data is sent up to window bytes ahead of the total the device
+  acknowledged, one number per line. Returns what the device sent past them."""
+  offset = 0
+  acked = 0
+  replies = ''
+  connection.settimeout(10)
+  while acked < content_size:
+    if offset < content_size and offset - acked < window:
+      chunk = f.read(min(8192, window - (offset - acked)))
+      connection.sendall(chunk)
+      offset += len(chunk)
+      # take the acknowledgements there are, without waiting
+      if not select.select([connection], [], [], 0)[0]:
+        continue
+    data = connection.recv(256).decode()
+    if not data:
+      raise IOError('connection closed')
+    lines = (replies + data).split('\n')
+    replies = lines.pop()
+    for i, line in enumerate(lines):
+      if not line.isdigit():
+        # an error ended the update
+        return '\n'.join(lines[i:] + [replies])
+      acked = int(line)
+    update_progress(acked/float(content_size))
+  return replies
+
 def serve(remoteAddr, localAddr, remotePort, localPort, password, filename, command = FLASH):
   # Create a TCP/IP socket
   sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
@@ -94,7 +153,7 @@ def serve(remoteAddr, localAddr, remotePort, localPort, password, filename, comm
   file_md5 = hashlib.md5(f.read()).hexdigest()
   f.close()
   logging.info('Upload size: %d', content_size)
-  message = '%d %d %d %s\n' % (command, localPort, content_size, file_md5)
+  message = '%d %d %d %s\n%d\n' % (command, localPort, content_size, file_md5, PROTOCOL)
 
   # Wait for a connection
   logging.info('Sending invitation to: %s', remoteAddr)
@@ -108,7 +167,8 @@ def serve(remoteAddr, localAddr, remotePort, localPort, password, filename, comm
     logging.error('No Answer')
     sock2.close()
     return 1
-  if (data != "OK"):
+  window = parse_ok(data)
+  if (window is None):
     if(data.startswith('AUTH')):
       nonce = data.split()[1]
       cnonce_text = '%s%u%s%s' % (filename, content_size, file_md5, remoteAddr)
@@ -128,7 +188,8 @@ def serve(remoteAddr, localAddr, remotePort, localPort, password, filename, comm
         logging.error('No Answer to our Authentication')
         sock2.close()
         return 1
-      if (data != "OK"):
+      window = parse_ok(data)
+      if (window is None):
         sys.stderr.write('FAIL\n')
         logging.error('%s', data)
         sock2.close()
@@ -152,8 +213,6 @@ def serve(remoteAddr, localAddr, remotePort, localPort, password, filename, comm
     sock.close()
     return 1
 
-  received_ok = False
-
   try:
     f = open(filename, "rb")
     if (PROGRESS):
@@ -161,37 +220,37 @@ def serve(remoteAddr, localAddr, remotePort, localPort, password, filename, comm
     else:
       sys.stderr.write('Uploading')
       sys.stderr.flush()
-    offset = 0
-    while True:
-      chunk = f.read(1460)
-      if not chunk: break
-      offset += len(chunk)
-      update_progress(offset/float(content_size))
-      connection.settimeout(10)
-      try:
-        connection.sendall(chunk)
-        if connection.recv(32).decode().find('O') >= 0:
-          # connection will receive only digits or 'OK'
-          received_ok = True
-      except Exception:
-        sys.stderr.write('\n')
-        logging.error('Error Uploading')
-        connection.close()
-        f.close()
-        sock.close()
-        return 1
+    logging.info('Protocol %d%s', 2 if window else 1, ', window %d' % window if window else '')
+    started = time.time()
+    try:
+      if window:
+        reply = upload_windowed(connection, f, content_size, window)
+      else:
+        reply = upload_acked(connection, f, content_size)
+    except Exception:
+      sys.stderr.write('\n')
+      logging.error('Error Uploading')
+      connection.close()
+      f.close()
+      sock.close()
+      return 1
+    elapsed = max(time.time() - started, 0.001)
 
     sys.stderr.write('\n')
+    logging.info('Sent %d bytes in %.1f s (%.1f kB/s)', content_size, elapsed, content_size / elapsed / 1024)
     logging.info('Waiting for result...')
-    # libraries/ArduinoOTA/ArduinoOTA.cpp L311 L320
-    # only sends digits or 'OK'. We must not not close
+    # libraries/ArduinoOTA/ArduinoOTA.cpp only sends
+    # acknowledgements (digits) or 'OK'. We must not not close
     # the connection before receiving the 'O' of 'OK'
     try:
       connection.settimeout(60)
       received_ok = False
       received_error = False
       while not (received_ok or received_error):
-        reply = connection.recv(64).decode()
+        if not reply:
+          reply = connection.recv(64).decode()
+          if not reply:
+            raise IOError('connection closed')
         # Look for either the "E" in ERROR or the "O" in OK response
         # Check for "E" first, since both strings contain "O"
         if reply.find('E') >= 0:
@@ -201,6 +260,7 @@ def serve(remoteAddr, localAddr, remotePort, localPort, password, filename, comm
         elif reply.find('O') >= 0:
           logging.info('Result: OK')
           received_ok = True
+        reply = ''
       connection.close()
       f.close()
       sock.close()
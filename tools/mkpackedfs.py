@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Pack a directory into a PackedFS image (see libraries/PackedFS/src/PackedFS.h),
+# either a binary to upload to the filesystem region of the flash or a header
+# with a PROGMEM array to include in the sketch.
+#
+import argparse
+import gzip
+import hashlib
+import os
+import struct
+import sys
+import time
+
+MAGIC = b'PKF1'
+NAME_MAX = 63
+HEADER_SIZE = 16
+ENTRY_SIZE = 28
+
+# Served with Content-Encoding: gzip by ESP8266WebServer when <path> itself is absent
+COMPRESSIBLE = ('.htm', '.html', '.css', '.js', '.json', '.svg', '.txt', '.xml', '.csv', '.ico')
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='PackedFS image builder')
+    parser.add_argument('dir', help='Directory to pack')
+    parser.add_argument('-o', '--out', required=True, help='Output file')
+    parser.add_argument('--header', metavar='NAME', help='Write a C header defining the PROGMEM array NAME instead of a binary')
+    parser.add_argument('-z', '--gzip', action='store_true', help='Store text files as <path>.gz when that is smaller')
+    parser.add_argument('-s', '--size', type=lambda x: int(x, 0), help='Fail when the image is larger, e.g. the filesystem size')
+    return parser.parse_args()
+
+def collect(root, compress):
+    files = {}
+    for dirpath, dirnames, filenames in os.walk(root):
+        dirnames.sort()
+        for filename in sorted(filenames):
+            full = os.path.join(dirpath, filename)
+            name = os.path.relpath(full, root).replace(os.sep, '/')
+            with open(full, 'rb') as f:
+                data = f.read()
+            if compress and name.lower().endswith(COMPRESSIBLE):
+                packed = gzip.compress(data, 9, mtime=0)
+                if len(packed) < len(data):
+                    name, data = name + '.gz', packed
+            if name in files:
+                sys.stderr.write("Both " + name[:-3] + " and " + name + " exist, keeping " + name + "\n")
+            files[name] = data
+    return files
+
+def build(files):
+    names = sorted(files, key=lambda n: n.encode('utf-8'))
+    for name in names:
+        if len(name.encode('utf-8')) > NAME_MAX:
+            raise ValueError("Path longer than %d bytes: %s" % (NAME_MAX, name))
+
+    name_offset = HEADER_SIZE + ENTRY_SIZE * len(names)
+    name_table = b''
+    name_offsets = []
+    for name in names:
+        name_offsets.append(name_offset + len(name_table))
+        name_table += name.encode('utf-8') + b'\0'
+
+    data_offset = name_offset + len(name_table)
+    data_table = b''
+    entries = b''
+    pad = (-data_offset) % 4
+    data_table += b'\0' * pad
+    for name, offset in zip(names, name_offsets):
+        data = files[name]
+        entries += struct.pack('<III', offset, data_offset + len(data_table), len(data)) + hashlib.md5(data).digest()
+        data_table += data + b'\0' * ((-len(data)) % 4)
+
+    size = data_offset + len(data_table)
+    header = MAGIC + struct.pack('<III', len(names), size, int(time.time()))
+    return header + entries + name_table + data_table
+
+def write_header(image, name, out):
+    out.write('// Generated by mkpackedfs.py, PackedFS.setConfig(PackedFSConfig().setImage(%s))\n' % name)
+    out.write('#include <pgmspace.h>\n\n')
+    out.write('static const uint8_t %s[%d] PROGMEM __attribute__((aligned(4))) = {\n' % (name, len(image)))
+    for i in range(0, len(image), 16):
+        out.write('  ' + ', '.join('0x%02x' % b for b in image[i:i + 16]) + ',\n')
+    out.write('};\n')
+
+def main():
+    args = parse_args()
+    image = build(collect(args.dir, args.gzip))
+    if args.size and len(image) > args.size:
+        sys.stderr.write("Image of %d bytes does not fit in %d\n" % (len(image), args.size))
+        return 1
+    if args.header:
+        with open(args.out, 'w') as out:
+            write_header(image, args.header, out)
+    else:
+        with open(args.out, 'wb') as out:
+            out.write(image)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())